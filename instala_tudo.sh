@@ -17,7 +17,7 @@ chmod 777 -R /usr/local/bin/cpdf
 cd /Share/ocr-server/pre-requisitos/pdftk-2.02-dist/pdftk && make all -f Makefile.Debian && make install -f Makefile.Debian
 
 #Instacao do poppler-utils 0.42.0
-cd ../../poppler-0.42.0 && ./configure && make && make install
+cd ../../poppler-0.42.0 && ./configure --enable-zlib-uncompress && make && make install
 
 #Instalacao do Leptonica 1.74.4
 cd ../tesseract/leptonica/pre-requisitos/plotlib-1.2/src
@@ -494,6 +494,20 @@ gdev_prn_allocate(gx_device *pdev, gdev_prn_space_params *new_space_params,
             ppdev->bg_print.ocfname = ppdev->bg_print.obfname =
                 ppdev->bg_print.obfile = ppdev->bg_print.ocfile = NULL;
 
+            /* Give each rendering thread several bands (see gdevprn.h). */
+            if (ppdev->num_render_threads_requested > 0 &&
+                space_params.band.BandHeight == 0 && buf_space.raster > 0) {
+                int band_height = PRN_THREAD_BAND_SPACE / buf_space.raster;
+                int max_height = pdev->height /
+                    (ppdev->num_render_threads_requested * PRN_THREAD_BANDS);
+
+                if (band_height > max_height)
+                    band_height = max_height;
+                if (band_height < PRN_THREAD_MIN_BAND_HEIGHT)
+                    band_height = PRN_THREAD_MIN_BAND_HEIGHT;
+                space_params.band.BandHeight = band_height;
+            }
+
             code = gdev_prn_setup_as_command_list(pdev, buffer_memory,
                                                   &the_memory, &space_params,
                                                   !bufferSpace_is_default);
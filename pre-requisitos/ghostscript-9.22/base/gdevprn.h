@@ -46,6 +46,17 @@
 #define PRN_MIN_MEMORY_LEFT MIN_MEMORY_LEFT	/* see gxdevice.h */
 #define PRN_MIN_BUFFER_SPACE MIN_BUFFER_SPACE	/* see gxdevice.h */
 
+/*
+ * With NumRenderingThreads, and no BandHeight given, the bands are made
+ * small enough for each rendering thread to get PRN_THREAD_BANDS bands of
+ * the page, and for a band buffer to fit in PRN_THREAD_BAND_SPACE (about
+ * the size of a processor's L2 cache), but no lower than
+ * PRN_THREAD_MIN_BAND_HEIGHT lines.
+ */
+#define PRN_THREAD_BANDS 4
+#define PRN_THREAD_BAND_SPACE (1024 * 1024)
+#define PRN_THREAD_MIN_BAND_HEIGHT 32
+
 /* Define the abstract type for a printer device. */
 #ifndef gx_device_printer_DEFINED
 #  define gx_device_printer_DEFINED
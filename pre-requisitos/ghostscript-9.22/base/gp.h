@@ -475,6 +475,21 @@ FILE *gp_open_scratch_file_64(const gs_memory_t *mem,
                               const char        *prefix,
                                     char         fname[gp_file_name_sizeof],
                               const char        *mode);
+/*
+ * Open a scratch file held in memory rather than on disk, or return NULL
+ * where the platform cannot, and the caller should fall back to
+ * gp_open_scratch_file_64.  gp_spill_scratch_file moves the contents of
+ * such a file to a new scratch file on disk, returning its name in fname;
+ * the FILE stays valid, at the same position.
+ */
+FILE *gp_open_memory_scratch_file(const gs_memory_t *mem,
+                                  const char        *prefix,
+                                  const char        *mode);
+int gp_spill_scratch_file(const gs_memory_t *mem,
+                          FILE              *file,
+                          const char        *prefix,
+                                char         fname[gp_file_name_sizeof]);
+
 FILE *gp_open_printer_64(const gs_memory_t *mem,
                                char         fname[gp_file_name_sizeof],
                                int          binary_mode);
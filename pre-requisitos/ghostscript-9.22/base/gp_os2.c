@@ -580,6 +580,22 @@ FILE *gp_open_scratch_file_64(const gs_memory_t *mem,
     return gp_open_scratch_file(mem, prefix, fname, mode);
 }
 
+/* Scratch files are always on disk here. */
+FILE *gp_open_memory_scratch_file(const gs_memory_t *mem,
+                                  const char        *prefix,
+                                  const char        *mode)
+{
+    return NULL;
+}
+
+int gp_spill_scratch_file(const gs_memory_t *mem,
+                          FILE              *file,
+                          const char        *prefix,
+                                char         fname[gp_file_name_sizeof])
+{
+    return -1;
+}
+
 FILE *gp_open_printer_64(const gs_memory_t *mem,
                                char         fname[gp_file_name_sizeof],
                                int          binary_mode)
@@ -32,6 +32,10 @@
 #include "dirent_.h"
 #include "unistd_.h"
 #include <stdlib.h>             /* for mkstemp/mktemp */
+#if defined(__linux__)
+#include <sys/syscall.h>        /* for memfd_create */
+#include <sys/sendfile.h>
+#endif
 
 #if !defined(HAVE_FSEEKO)
 #define ftello ftell
@@ -639,6 +643,72 @@ FILE *gp_open_scratch_file_64(const gs_memory_t *mem,
     return gp_open_scratch_file_generic(mem, prefix, fname, mode, true);
 }
 
+/* Scratch files in memory are anonymous files of tmpfs, where the kernel
+   has them (Linux 3.17 and later), so that they work with every FILE
+   operation, and a spill to disk only needs to swap the descriptor. */
+FILE *gp_open_memory_scratch_file(const gs_memory_t *mem,
+                                  const char        *prefix,
+                                  const char        *mode)
+{
+#if defined(__linux__) && defined(SYS_memfd_create)
+    int fd = syscall(SYS_memfd_create, prefix, 0);
+    FILE *f;
+
+    if (fd < 0)
+        return NULL;
+    f = fdopen(fd, mode);
+    if (f == NULL)
+        close(fd);
+    return f;
+#else
+    return NULL;
+#endif
+}
+
+int gp_spill_scratch_file(const gs_memory_t *mem,
+                          FILE              *file,
+                          const char        *prefix,
+                                char         fname[gp_file_name_sizeof])
+{
+#if defined(__linux__) && defined(SYS_memfd_create)
+    int64_t pos, size;
+    off_t offset = 0;
+    FILE *disk;
+    int code = 0;
+
+    if (fflush(file) != 0 || (pos = gp_ftell_64(file)) < 0 ||
+        gp_fseek_64(file, 0, SEEK_END) != 0 ||
+        (size = gp_ftell_64(file)) < 0)
+        return -1;
+    disk = gp_open_scratch_file_64(mem, prefix, fname, "w+");
+    if (disk == NULL)
+        return -1;
+    while (offset < size) {
+        ssize_t n = sendfile(fileno(disk), fileno(file), &offset,
+                             size - offset);
+
+        if (n <= 0) {
+            code = -1;
+            break;
+        }
+    }
+    /* The descriptor of file now refers to the disk file, freeing the
+       memory; its FILE buffer is empty since the flush above. */
+    if (code == 0 && dup2(fileno(disk), fileno(file)) < 0)
+        code = -1;
+    fclose(disk);
+    if (code < 0) {
+        unlink(fname);
+        fname[0] = 0;
+        gp_fseek_64(file, pos, SEEK_SET);
+        return code;
+    }
+    return gp_fseek_64(file, pos, SEEK_SET);
+#else
+    return -1;
+#endif
+}
+
 /* gp_open_printer_64 is defined in gp_unix.h */
 
 int64_t gp_ftell_64(FILE *strm)
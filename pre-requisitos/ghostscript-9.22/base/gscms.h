@@ -440,6 +440,10 @@ typedef struct gsicc_hashlink_s {
     int64_t rend_hash;
 } gsicc_hashlink_t;
 
+/* A link from one channel, with at most this many output channels, maps
+   8 bit data through a table of its 256 output colors */
+#define GSICC_TABLE_MAX_OUTPUT 4
+
 struct gsicc_link_s {
     void *link_handle;
     gscms_procs_t procs;
@@ -458,6 +462,8 @@ struct gsicc_link_s {
     gsicc_colorbuffer_t data_cs; /* needed for begin_monitor after end_monitor */
     int num_input;  /* Need so we can monitor properly */
     int num_output; /* Need so we can monitor properly */
+    bool is_tabulated;  /* 8 bit buffers are mapped through table */
+    byte table[256 * GSICC_TABLE_MAX_OUTPUT];	/* see gsicc_tabulate_link */
 };
 
 /* ICC Cache. The size of the cache is limited by max_memory_size.
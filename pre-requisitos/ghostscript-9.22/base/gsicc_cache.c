@@ -44,7 +44,9 @@
          *  This will be done later.  For now, just limit the number
          *  of links.
          */
+#ifndef ICC_CACHE_MAXLINKS
 #define ICC_CACHE_MAXLINKS 50
+#endif
 
 /* Static prototypes */
 
@@ -203,6 +205,7 @@ gsicc_alloc_link_dev(gs_memory_t *memory, cmm_profile_t *src_profile,
     result->includes_devlink = 0;
     result->num_waiting = 0;
     result->is_identity = false;
+    result->is_tabulated = false;
     result->valid = true;
 
     if (src_profile->profile_handle == NULL) {
@@ -288,6 +291,7 @@ gsicc_alloc_link(gs_memory_t *memory, gsicc_hashlink_t hashcode)
     result->includes_softproof = 0;
     result->includes_devlink = 0;
     result->is_identity = false;
+    result->is_tabulated = false;
     result->valid = false;		/* not yet complete */
     result->num_waiting = 0;
     return(result);
@@ -335,6 +339,85 @@ gsicc_set_link_data(gsicc_link_t *icc_link, void *link_handle,
 #endif
 }
 
+/* Map 8 bit data through the table of a tabulated link.  Anything else
+   goes to the CMM. */
+static int
+gsicc_transform_tabulated_buffer(gx_device *dev, gsicc_link_t *icclink,
+                                 gsicc_bufferdesc_t *input_buff_desc,
+                                 gsicc_bufferdesc_t *output_buff_desc,
+                                 void *inputbuffer, void *outputbuffer)
+{
+    const byte *table = icclink->table;
+    int num_out = icclink->num_output;
+    const byte *inputpos = (const byte *)inputbuffer;
+    byte *outputpos = (byte *)outputbuffer;
+    int x, y, k;
+
+    if (input_buff_desc->bytes_per_chan != 1 ||
+        output_buff_desc->bytes_per_chan != 1 ||
+        input_buff_desc->has_alpha || input_buff_desc->num_chan != 1 ||
+        output_buff_desc->num_chan != num_out)
+        return gscms_transform_color_buffer(dev, icclink, input_buff_desc,
+                                            output_buff_desc, inputbuffer,
+                                            outputbuffer);
+    for (y = 0; y < input_buff_desc->num_rows; y++) {
+        if (output_buff_desc->is_planar) {
+            for (k = 0; k < num_out; k++) {
+                byte *des = outputpos + k * output_buff_desc->plane_stride;
+
+                for (x = 0; x < input_buff_desc->pixels_per_row; x++)
+                    des[x] = table[inputpos[x] * num_out + k];
+            }
+        } else {
+            byte *des = outputpos;
+
+            for (x = 0; x < input_buff_desc->pixels_per_row; x++) {
+                const byte *src = &table[inputpos[x] * num_out];
+
+                for (k = 0; k < num_out; k++)
+                    *des++ = src[k];
+            }
+        }
+        inputpos += input_buff_desc->row_stride;
+        outputpos += output_buff_desc->row_stride;
+    }
+    return 0;
+}
+
+/*
+ * A link from one channel has only 256 different colors to give for 8 bit
+ * data, which is the common case of gray images going to an RGB or CMYK
+ * device.  Get them from the CMM once, and map the buffers with a lookup
+ * instead: this gives the same colors without going through the CMM for
+ * every pixel.  Single colors still go to the CMM.
+ */
+static void
+gsicc_tabulate_link(gx_device *dev, gsicc_link_t *icc_link, void *link_handle)
+{
+    gsicc_bufferdesc_t input_buff_desc, output_buff_desc;
+    byte input[256];
+    int num_input, num_output, k;
+
+    gscms_get_link_dim(link_handle, &num_input, &num_output);
+    if (num_input != 1 || num_output > GSICC_TABLE_MAX_OUTPUT)
+        return;
+    for (k = 0; k < 256; k++)
+        input[k] = k;
+    gsicc_init_buffer(&input_buff_desc, 1, 1, false, false, false, 0, 256,
+                      1, 256);
+    gsicc_init_buffer(&output_buff_desc, num_output, 1, false, false, false,
+                      0, 256 * num_output, 1, 256);
+    /* The link isn't valid yet, so no one else is using it */
+    icc_link->link_handle = link_handle;
+    if (gscms_transform_color_buffer(dev, icc_link, &input_buff_desc,
+                                     &output_buff_desc, input,
+                                     icc_link->table) < 0)
+        return;
+    icc_link->num_output = num_output;
+    icc_link->is_tabulated = true;
+    icc_link->procs.map_buffer = gsicc_transform_tabulated_buffer;
+}
+
 static void
 gsicc_link_free_contents(gsicc_link_t *icc_link)
 {
@@ -1210,6 +1293,8 @@ gsicc_get_link_profile(const gs_gstate *pgs, gx_device *dev,
     if (link_handle != NULL) {
         if (gs_input_profile->data_cs == gsGRAY)
             pageneutralcolor = false;
+        if (!pageneutralcolor)
+            gsicc_tabulate_link(dev, link, link_handle);
         gsicc_set_link_data(link, link_handle, hash, icc_link_cache->lock,
                             include_softproof, include_devicelink, pageneutralcolor,
                             gs_input_profile->data_cs);
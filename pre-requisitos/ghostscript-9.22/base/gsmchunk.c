@@ -161,12 +161,25 @@ typedef struct chunk_slab_s {
     struct chunk_slab_s *next;
 } chunk_slab_t;
 
+/*
+ * Freed blocks of up to CHUNK_QUICK_MAX bytes are kept on lists by size,
+ * and given to the next allocation of the same size without going through
+ * the free trees. Each thread has its own chunk allocator, so this is a
+ * per thread cache of small objects. The lists are emptied into the free
+ * trees, where the blocks are merged with their free neighbours, before
+ * a new slab is allocated, so they don't make the heap grow.
+ */
+#define CHUNK_QUICK_MAX 512
+#define CHUNK_QUICK_LISTS (CHUNK_QUICK_MAX / obj_align_mod + 1)
+
 typedef struct gs_memory_chunk_s {
     gs_memory_common;           /* interface outside world sees */
     gs_memory_t *target;        /* base allocator */
     chunk_slab_t *slabs;         /* list of slabs for freeing */
     chunk_free_node_t *free_size;/* free tree */
     chunk_free_node_t *free_loc; /* free tree */
+    chunk_obj_node_t *quick[CHUNK_QUICK_LISTS]; /* freed small blocks, by size */
+    unsigned long quick_free;   /* total size of the blocks on quick */
     chunk_obj_node_t *defer_finalize_list;
     chunk_obj_node_t *defer_free_list;
     unsigned long used;
@@ -208,6 +221,8 @@ gs_memory_chunk_wrap(gs_memory_t **wrapped,      /* chunk allocator init */
     cmem->slabs = NULL;
     cmem->free_size = NULL;
     cmem->free_loc = NULL;
+    memset(cmem->quick, 0, sizeof(cmem->quick));
+    cmem->quick_free = 0;
     cmem->used = 0;
     cmem->max_used = 0;
     cmem->total_free = 0;
@@ -284,6 +299,8 @@ chunk_mem_node_free_all_slabs(gs_memory_chunk_t *cmem)
     cmem->slabs = NULL;
     cmem->free_size = NULL;
     cmem->free_loc = NULL;
+    memset(cmem->quick, 0, sizeof(cmem->quick));
+    cmem->quick_free = 0;
     cmem->total_free = 0;
     cmem->used = 0;
 }
@@ -753,13 +770,130 @@ static void remove_free(gs_memory_chunk_t *cmem, chunk_free_node_t *node)
 #define SINGLE_OBJECT_CHUNK(size) ((size) > (CHUNK_SIZE>>1))
 #endif
 
+/* Find the smallest free block that's large enough, NULL if none */
+/* Returns the parent pointer to the block we pick */
+static chunk_free_node_t **
+chunk_find_free_size(gs_memory_chunk_t *cmem, uint newsize)
+{
+    chunk_free_node_t **ap, **okp;
+    chunk_free_node_t  *a, *b, *c;
+
+    ap = &cmem->free_size;
+    okp = NULL;
+    while ((a = *ap) != NULL) {
+        if (a->size >= newsize) {
+            b = a->left_size;
+            if (b == NULL) {
+                okp = ap; /* a will do */
+                break; /* Stop searching */
+            }
+            if (b->size >= newsize) {
+                c = b->left_size;
+                if (c == NULL) {
+                    okp = &a->left_size; /* b is as good as we're going to get */
+                    break;
+                }
+                /* Splay:        a             c
+                 *            b     Z   =>  W     b
+                 *          c   Y               X   a
+                 *         W X                     Y Z
+                 */
+                *ap = c;
+                a->left_size  = b->right_size;
+                b->left_size  = c->right_size;
+                b->right_size = a;
+                c->right_size = b;
+                if (c->size >= newsize) {
+                    okp = ap; /* c is the best so far */
+                    ap = &c->left_size;
+                } else {
+                    okp = &c->right_size; /* b is the best so far */
+                    ap = &b->left_size;
+                }
+            } else {
+                c = b->right_size;
+                if (c == NULL) {
+                    okp = ap; /* a is as good as we are going to get */
+                    break;
+                }
+                /* Splay:         a             c
+                 *            b       Z  =>   b   a
+                 *          W   c            W X Y Z
+                 *             X Y
+                 */
+                *ap = c;
+                a->left_size  = c->right_size;
+                b->right_size = c->left_size;
+                c->left_size  = b;
+                c->right_size = a;
+                if (c->size >= newsize) {
+                    okp = ap; /* c is the best so far */
+                    ap = &b->right_size;
+                } else {
+                    okp = &c->right_size; /* a is the best so far */
+                    ap = &a->left_size;
+                }
+            }
+        } else {
+            b = a->right_size;
+            if (b == NULL)
+                break; /* No better match to be found */
+            if (b->size >= newsize) {
+                c = b->left_size;
+                if (c == NULL) {
+                    okp = &a->right_size; /* b is as good as we're going to get */
+                    break;
+                }
+                /* Splay:      a                c
+                 *         W       b    =>    a   b
+                 *               c   Z       W X Y Z
+                 *              X Y
+                 */
+                *ap = c;
+                a->right_size = c->left_size;
+                b->left_size  = c->right_size;
+                c->left_size  = a;
+                c->right_size = b;
+                if (c->size >= newsize) {
+                    okp = ap; /* c is the best so far */
+                    ap = &a->right_size;
+                } else {
+                    okp = &c->right_size; /* b is the best so far */
+                    ap = &b->left_size;
+                }
+            } else {
+                c = b->right_size;
+                if (c == NULL)
+                    break; /* No better match to be found */
+                /* Splay:    a                   c
+                 *        W     b      =>     b     Z
+                 *            X   c         a   Y
+                 *               Y Z       W X
+                 */
+                *ap = c;
+                a->right_size = b->left_size;
+                b->right_size = c->left_size;
+                b->left_size  = a;
+                c->left_size  = b;
+                if (c->size >= newsize) {
+                    okp = ap; /* c is the best so far */
+                    ap = &b->right_size;
+                } else
+                    ap = &c->right_size;
+            }
+        }
+    }
+    return okp;
+}
+
+static void chunk_flush_quick(gs_memory_chunk_t *cmem);
+
 /* All of the allocation routines reduce to this function */
 static byte *
 chunk_obj_alloc(gs_memory_t *mem, uint size, gs_memory_type_ptr_t type, client_name_t cname)
 {
     gs_memory_chunk_t  *cmem = (gs_memory_chunk_t *)mem;
-    chunk_free_node_t **ap, **okp;
-    chunk_free_node_t  *a, *b, *c;
+    chunk_free_node_t **okp;
     uint newsize;
     chunk_obj_node_t *obj = NULL;
 
@@ -789,118 +923,30 @@ chunk_obj_alloc(gs_memory_t *mem, uint size, gs_memory_type_ptr_t type, client_n
         obj = (chunk_obj_node_t *)gs_alloc_bytes_immovable(cmem->target, newsize, cname);
         if (obj == NULL)
             return NULL;
+        cmem->used += newsize;
     } else {
-        /* Find the smallest free block that's large enough */
-        /* okp points to the parent pointer to the block we pick */
-        ap = &cmem->free_size;
         okp = NULL;
-        while ((a = *ap) != NULL) {
-            if (a->size >= newsize) {
-                b = a->left_size;
-                if (b == NULL) {
-                    okp = ap; /* a will do */
-                    break; /* Stop searching */
-                }
-                if (b->size >= newsize) {
-                    c = b->left_size;
-                    if (c == NULL) {
-                        okp = &a->left_size; /* b is as good as we're going to get */
-                        break;
-                    }
-                    /* Splay:        a             c
-                     *            b     Z   =>  W     b
-                     *          c   Y               X   a
-                     *         W X                     Y Z
-                     */
-                    *ap = c;
-                    a->left_size  = b->right_size;
-                    b->left_size  = c->right_size;
-                    b->right_size = a;
-                    c->right_size = b;
-                    if (c->size >= newsize) {
-                        okp = ap; /* c is the best so far */
-                        ap = &c->left_size;
-                    } else {
-                        okp = &c->right_size; /* b is the best so far */
-                        ap = &b->left_size;
-                    }
-                } else {
-                    c = b->right_size;
-                    if (c == NULL) {
-                        okp = ap; /* a is as good as we are going to get */
-                        break;
-                    }
-                    /* Splay:         a             c
-                     *            b       Z  =>   b   a
-                     *          W   c            W X Y Z
-                     *             X Y
-                     */
-                    *ap = c;
-                    a->left_size  = c->right_size;
-                    b->right_size = c->left_size;
-                    c->left_size  = b;
-                    c->right_size = a;
-                    if (c->size >= newsize) {
-                        okp = ap; /* c is the best so far */
-                        ap = &b->right_size;
-                    } else {
-                        okp = &c->right_size; /* a is the best so far */
-                        ap = &a->left_size;
-                    }
-                }
-            } else {
-                b = a->right_size;
-                if (b == NULL)
-                    break; /* No better match to be found */
-                if (b->size >= newsize) {
-                    c = b->left_size;
-                    if (c == NULL) {
-                        okp = &a->right_size; /* b is as good as we're going to get */
-                        break;
-                    }
-                    /* Splay:      a                c
-                     *         W       b    =>    a   b
-                     *               c   Z       W X Y Z
-                     *              X Y
-                     */
-                    *ap = c;
-                    a->right_size = c->left_size;
-                    b->left_size  = c->right_size;
-                    c->left_size  = a;
-                    c->right_size = b;
-                    if (c->size >= newsize) {
-                        okp = ap; /* c is the best so far */
-                        ap = &a->right_size;
-                    } else {
-                        okp = &c->right_size; /* b is the best so far */
-                        ap = &b->left_size;
-                    }
-                } else {
-                    c = b->right_size;
-                    if (c == NULL)
-                        break; /* No better match to be found */
-                    /* Splay:    a                   c
-                     *        W     b      =>     b     Z
-                     *            X   c         a   Y
-                     *               Y Z       W X
-                     */
-                    *ap = c;
-                    a->right_size = b->left_size;
-                    b->right_size = c->left_size;
-                    b->left_size  = a;
-                    c->left_size  = b;
-                    if (c->size >= newsize) {
-                        okp = ap; /* c is the best so far */
-                        ap = &b->right_size;
-                    } else
-                        ap = &c->right_size;
-                }
+        if (newsize <= CHUNK_QUICK_MAX) {
+            obj = cmem->quick[newsize / obj_align_mod];
+            if (obj != NULL) {
+                cmem->quick[newsize / obj_align_mod] = obj->defer_next;
+                cmem->quick_free -= newsize;
+            }
+        }
+        if (obj == NULL) {
+            okp = chunk_find_free_size(cmem, newsize);
+            if (okp == NULL && cmem->quick_free != 0) {
+                /* The free small blocks may merge into a large enough one */
+                chunk_flush_quick(cmem);
+                okp = chunk_find_free_size(cmem, newsize);
             }
         }
 
         /* So *okp points to the most appropriate free tree entry. */
 
-        if (okp == NULL) {
+        if (obj != NULL) {
+            /* Taken from a quick list */
+        } else if (okp == NULL) {
             /* No appropriate free space slot. We need to allocate a new slab. */
             chunk_slab_t *slab;
             uint slab_size = newsize + SIZEOF_ROUND_ALIGN(chunk_slab_t);
@@ -911,6 +957,7 @@ chunk_obj_alloc(gs_memory_t *mem, uint size, gs_memory_type_ptr_t type, client_n
                 return NULL;
             slab->next = cmem->slabs;
             cmem->slabs = slab;
+            cmem->used += slab_size;
 
             obj = (chunk_obj_node_t *)(((byte *)slab) + SIZEOF_ROUND_ALIGN(chunk_slab_t));
             if (slab_size != newsize + SIZEOF_ROUND_ALIGN(chunk_slab_t)) {
@@ -934,6 +981,8 @@ chunk_obj_alloc(gs_memory_t *mem, uint size, gs_memory_type_ptr_t type, client_n
             cmem->total_free -= newsize;
         }
     }
+    if (cmem->used > cmem->max_used)
+        cmem->max_used = cmem->used;
 
     if (gs_alloc_debug) {
         memset((byte *)(obj) + SIZEOF_ROUND_ALIGN(chunk_obj_node_t), 0xa1, newsize - SIZEOF_ROUND_ALIGN(chunk_obj_node_t));
@@ -1044,58 +1093,13 @@ chunk_resize_object(gs_memory_t * mem, void *ptr, uint new_num_elements, client_
     return new_ptr;
 }
 
+/* Return a block to the free trees, merging it with its free neighbours */
 static void
-chunk_free_object(gs_memory_t *mem, void *ptr, client_name_t cname)
+chunk_free_node(gs_memory_chunk_t *cmem, chunk_obj_node_t *obj)
 {
-    gs_memory_chunk_t * const cmem = (gs_memory_chunk_t *)mem;
-    int obj_node_size;
-    chunk_obj_node_t *obj;
-    struct_proc_finalize((*finalize));
     chunk_free_node_t **ap, **gtp, **ltp;
     chunk_free_node_t *a, *b, *c;
 
-    if (ptr == NULL)
-        return;
-
-    /* back up to obj header */
-    obj_node_size = SIZEOF_ROUND_ALIGN(chunk_obj_node_t);
-    obj = (chunk_obj_node_t *)(((byte *)ptr) - obj_node_size);
-
-    if (cmem->deferring) {
-        if (obj->defer_next == NULL) {
-            obj->defer_next = cmem->defer_finalize_list;
-            cmem->defer_finalize_list = obj;
-        }
-        return;
-    }
-
-#ifdef DEBUG_CHUNK_PRINT
-#ifdef DEBUG_SEQ
-    cmem->sequence++;
-    dmlprintf6(cmem->target, "Event %x: free(chunk=%p, addr=%p, size=%x, num=%x, cname=%s)\n", cmem->sequence, cmem, obj, obj->size, obj->sequence, cname);
-#else
-    dmlprintf4(cmem->target, "free(chunk=%p, addr=%p, size=%x, cname=%s)\n", cmem, obj, obj->size, cname);
-#endif
-#endif
-
-    if (obj->type) {
-        finalize = obj->type->finalize;
-        if (finalize != NULL)
-            finalize(mem, ptr);
-    }
-    /* finalize may change the head_**_chunk doing free of stuff */
-
-    if_debug3m('A', cmem->target, "[a-]chunk_free_object(%s) 0x%lx(%u)\n",
-               client_name_string(cname), (ulong) ptr, obj->size);
-
-    if (SINGLE_OBJECT_CHUNK(obj->size - obj->padding)) {
-        gs_free_object(cmem->target, obj, "chunk_free_object(single object)");
-#ifdef DEBUG_CHUNK
-        gs_memory_chunk_dump_memory(cmem);
-#endif
-        return;
-    }
-
     /* We want to find where to insert this free entry into our free tree. We need to know
      * both the point to the left of it, and the point to the right of it, in order to see
      * if we can merge the free entries. Accordingly, we search from the top of the tree
@@ -1289,6 +1293,88 @@ chunk_free_object(gs_memory_t *mem, void *ptr, client_name_t cname)
         if (gs_alloc_debug)
             memset(((byte *)objfree) + SIZEOF_ROUND_ALIGN(chunk_free_node_t), 0x9b, objfree->size - SIZEOF_ROUND_ALIGN(chunk_free_node_t));
     }
+}
+
+/* Give the blocks on the quick lists back to the free trees */
+static void
+chunk_flush_quick(gs_memory_chunk_t *cmem)
+{
+    chunk_obj_node_t *obj;
+    int i;
+
+    for (i = 0; i < CHUNK_QUICK_LISTS; i++) {
+        while ((obj = cmem->quick[i]) != NULL) {
+            cmem->quick[i] = obj->defer_next;
+            chunk_free_node(cmem, obj);
+        }
+    }
+    cmem->quick_free = 0;
+}
+
+static void
+chunk_free_object(gs_memory_t *mem, void *ptr, client_name_t cname)
+{
+    gs_memory_chunk_t * const cmem = (gs_memory_chunk_t *)mem;
+    int obj_node_size;
+    chunk_obj_node_t *obj;
+    struct_proc_finalize((*finalize));
+
+    if (ptr == NULL)
+        return;
+
+    /* back up to obj header */
+    obj_node_size = SIZEOF_ROUND_ALIGN(chunk_obj_node_t);
+    obj = (chunk_obj_node_t *)(((byte *)ptr) - obj_node_size);
+
+    if (cmem->deferring) {
+        if (obj->defer_next == NULL) {
+            obj->defer_next = cmem->defer_finalize_list;
+            cmem->defer_finalize_list = obj;
+        }
+        return;
+    }
+
+#ifdef DEBUG_CHUNK_PRINT
+#ifdef DEBUG_SEQ
+    cmem->sequence++;
+    dmlprintf6(cmem->target, "Event %x: free(chunk=%p, addr=%p, size=%x, num=%x, cname=%s)\n", cmem->sequence, cmem, obj, obj->size, obj->sequence, cname);
+#else
+    dmlprintf4(cmem->target, "free(chunk=%p, addr=%p, size=%x, cname=%s)\n", cmem, obj, obj->size, cname);
+#endif
+#endif
+
+    if (obj->type) {
+        finalize = obj->type->finalize;
+        if (finalize != NULL)
+            finalize(mem, ptr);
+    }
+    /* finalize may change the head_**_chunk doing free of stuff */
+
+    if_debug3m('A', cmem->target, "[a-]chunk_free_object(%s) 0x%lx(%u)\n",
+               client_name_string(cname), (ulong) ptr, obj->size);
+
+    if (SINGLE_OBJECT_CHUNK(obj->size)) {
+        cmem->used -= obj->size;
+        gs_free_object(cmem->target, obj, "chunk_free_object(single object)");
+#ifdef DEBUG_CHUNK
+        gs_memory_chunk_dump_memory(cmem);
+#endif
+        return;
+    }
+
+    if (obj->size <= CHUNK_QUICK_MAX) {
+        uint i = obj->size / obj_align_mod;
+
+        if (gs_alloc_debug)
+            memset(((byte *)obj) + obj_node_size, 0x9b, obj->size - obj_node_size);
+        obj->type = NULL;
+        obj->defer_next = cmem->quick[i];
+        cmem->quick[i] = obj;
+        cmem->quick_free += obj->size;
+        return;
+    }
+
+    chunk_free_node(cmem, obj);
 
 #ifdef DEBUG_CHUNK
     gs_memory_chunk_dump_memory(cmem);
@@ -1330,7 +1416,7 @@ chunk_status(gs_memory_t * mem, gs_memory_status_t * pstat)
     gs_memory_chunk_t *cmem = (gs_memory_chunk_t *)mem;
 
     pstat->allocated = cmem->used;
-    pstat->used = cmem->used - cmem->total_free;
+    pstat->used = cmem->used - cmem->total_free - cmem->quick_free;
     pstat->max_used = cmem->max_used;
     pstat->is_thread_safe = false;	/* this allocator does not have an internal mutex */
 }
@@ -1390,6 +1476,7 @@ static void chunk_defer_frees(gs_memory_t *mem, int defer)
 static void
 chunk_consolidate_free(gs_memory_t *mem)
 {
+    chunk_flush_quick((gs_memory_chunk_t *)mem);
 }
 
 /* accessors to get size and type given the pointer returned to the client */
@@ -555,6 +555,13 @@ teardown_device_and_mem_for_thread(gx_device *dev, gp_thread_id thread_id, bool
        will be freed with this call and the icc_struct ref count will be decremented. */
     gs_free_object(thread_memory, thread_cdev, "clist_teardown_render_threads");
 #ifdef DEBUG
+    if (gs_debug_c('A')) {
+        gs_memory_status_t status;
+
+        gs_memory_status(thread_memory, &status);
+        dmlprintf3(thread_memory, "[A]rendering thread memory: allocated %ld, in use %ld, max %ld\n",
+                   (long)status.allocated, (long)status.used, (long)status.max_used);
+    }
     dmprintf(thread_memory, "rendering thread ending memory state...\n");
     gs_memory_chunk_dump_memory(thread_memory);
     dmprintf(thread_memory, "                                    memory dump done.\n");
@@ -319,6 +319,30 @@ enum {
     /* Restrict the supplied bbox to that actually used by the underlying device.
      * Used to restrict alphabits drawing to the area defined by compositors etc.*/
     gxdso_restrict_bbox,
+    /* JPEG pass-through, for high level devices that can write the
+     * compressed data of a DCTDecode image unchanged instead of
+     * re-encoding the decoded samples:
+     * gxdso_JPEG_passthrough_query:
+     *     data = NULL
+     *     size = 0
+     * Sent when a DCTDecode filter is created. Returns +ve value if the
+     * device wants the compressed data of the filter, which is then
+     * sent, as the decoder consumes it, by:
+     * gxdso_JPEG_passthrough_begin:
+     *     data = identifies the filter, only to be compared
+     *     size = 0
+     * gxdso_JPEG_passthrough_data:
+     *     data = pointer to the compressed bytes
+     *     size = number of bytes
+     * gxdso_JPEG_passthrough_end:
+     *     data = identifies the filter, as for begin
+     *     size = 0
+     * The decoded samples still go through the image as usual.
+     */
+    gxdso_JPEG_passthrough_query,
+    gxdso_JPEG_passthrough_begin,
+    gxdso_JPEG_passthrough_data,
+    gxdso_JPEG_passthrough_end,
     /* Add new gxdso_ keys above this. */
     gxdso_pattern__LAST
 };
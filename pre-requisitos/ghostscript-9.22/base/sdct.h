@@ -93,12 +93,20 @@ typedef struct jpeg_decompress_data_s {
     bool faked_eoi;		/* true when fill_input_buffer inserted EOI */
     byte *scanline_buffer;	/* buffer for oversize scanline, or NULL */
     uint bytes_in_scanline;	/* # of bytes remaining to output from same */
+    /* Pass-through of the compressed data (see gxdso_JPEG_passthrough_*): */
+    /* PassThroughfn is called with this structure and (NULL, 1) before */
+    /* the first data, (data, size) as the decoder consumes it, and */
+    /* (NULL, 0) at the end. */
+    bool PassThrough;
+    bool StartedPassThrough;
+    int (*PassThroughfn)(void *, byte *, uint);
+    void *device;
 } jpeg_decompress_data;
 
 #define private_st_jpeg_decompress_data()	/* in zfdctd.c */\
-  gs_private_st_ptrs2(st_jpeg_decompress_data, jpeg_decompress_data,\
+  gs_private_st_ptrs3(st_jpeg_decompress_data, jpeg_decompress_data,\
     "JPEG decompress data", jpeg_decompress_data_enum_ptrs,\
-    jpeg_decompress_data_reloc_ptrs, dummy, scanline_buffer)
+    jpeg_decompress_data_reloc_ptrs, dummy, scanline_buffer, device)
 
 /* The stream state itself.  This is kept in garbage-collectable memory. */
 typedef struct stream_DCT_state_s {
@@ -103,6 +103,35 @@ s_DCTD_init(stream_state * st)
     return 0;
 }
 
+/* Release the DCTDecode filter, ending the pass-through if any. */
+static void
+s_DCTD_release(stream_state * st)
+{
+    jpeg_decompress_data *jddp = ((stream_DCT_state *) st)->data.decompress;
+
+    if (jddp != NULL && jddp->PassThrough && jddp->PassThroughfn != NULL)
+        (jddp->PassThroughfn)(jddp, NULL, 0);
+    if (jddp != NULL)
+        jddp->PassThrough = false;
+}
+
+/*
+ * Pass the compressed bytes consumed by the decoder, (from, to], to the
+ * device that asked for them.
+ */
+static void
+dctd_pass_through(jpeg_decompress_data *jddp, const byte *from,
+                  const byte *to)
+{
+    if (to <= from)
+        return;
+    if (!jddp->StartedPassThrough) {
+        jddp->StartedPassThrough = true;
+        (jddp->PassThroughfn)(jddp, NULL, 1);
+    }
+    (jddp->PassThroughfn)(jddp, (byte *)from + 1, to - from);
+}
+
 static int
 compact_jpeg_buffer(stream_cursor_read *pr)
 {
@@ -164,10 +193,13 @@ update_jpeg_header_height(JOCTET *d, size_t len, int height)
     }
 }
 
-/* Process a buffer */
+/*
+ * Process a buffer.  *ppass is the end of the input already passed
+ * through, or not to be (leading garbage).
+ */
 static int
-s_DCTD_process(stream_state * st, stream_cursor_read * pr,
-               stream_cursor_write * pw, bool last)
+dctd_process(stream_state * st, stream_cursor_read * pr,
+             stream_cursor_write * pw, bool last, const byte **ppass)
 {
     stream_DCT_state *const ss = (stream_DCT_state *) st;
     jpeg_decompress_data *jddp = ss->data.decompress;
@@ -201,6 +233,7 @@ s_DCTD_process(stream_state * st, stream_cursor_read * pr,
              */
             while (pr->ptr < pr->limit && pr->ptr[1] != 0xff)
                 pr->ptr++;
+            *ppass = pr->ptr;
             if (pr->ptr == pr->limit)
                 return 0;
             src->next_input_byte = pr->ptr + 1;
@@ -342,9 +375,14 @@ s_DCTD_process(stream_state * st, stream_cursor_read * pr,
                      * a local buffer and copy the data into it. The local
                      * buffer can be grown as required. */
                     if ((src->next_input_byte-1 == pr->ptr) &&
-                        (pr->limit - pr->ptr >= ss->templat->min_in_size) &&
-                        (compact_jpeg_buffer(pr) == 0))
-                        return ERRC;
+                        (pr->limit - pr->ptr >= ss->templat->min_in_size)) {
+                        /* Compacting moves the unconsumed bytes. */
+                        if (jddp->PassThrough)
+                            dctd_pass_through(jddp, *ppass, pr->ptr);
+                        if (compact_jpeg_buffer(pr) == 0)
+                            return ERRC;
+                        *ppass = pr->ptr;
+                    }
                     return 0;	/* need more data */
                 }
                 if (jddp->scanline_buffer != NULL) {
@@ -371,8 +409,21 @@ s_DCTD_process(stream_state * st, stream_cursor_read * pr,
     return ERRC;
 }
 
+static int
+s_DCTD_process(stream_state * st, stream_cursor_read * pr,
+               stream_cursor_write * pw, bool last)
+{
+    jpeg_decompress_data *jddp = ((stream_DCT_state *) st)->data.decompress;
+    const byte *pass = pr->ptr;
+    int status = dctd_process(st, pr, pw, last, &pass);
+
+    if (jddp->PassThrough)
+        dctd_pass_through(jddp, pass, pr->ptr);
+    return status;
+}
+
 /* Stream template */
 const stream_template s_DCTD_template =
-{&st_DCT_state, s_DCTD_init, s_DCTD_process, 2000, 4000, NULL,
+{&st_DCT_state, s_DCTD_init, s_DCTD_process, 2000, 4000, s_DCTD_release,
  s_DCTD_set_defaults
 };
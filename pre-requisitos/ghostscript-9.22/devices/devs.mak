@@ -645,8 +645,8 @@ $(DEVOBJ)gdevpsds.$(OBJ) : $(DEVVECSRC)gdevpsds.c $(GX) $(memory__h)\
 
 $(DEVOBJ)gdevpsdu.$(OBJ) : $(DEVVECSRC)gdevpsdu.c $(GXERR)\
  $(jpeglib__h) $(memory__h) $(stdio__h)\
- $(sa85x_h) $(scfx_h) $(sdct_h) $(sjpeg_h) $(strimpl_h)\
- $(gdevpsdf_h) $(spprint_h) $(gsovrc_h) $(DEVS_MAK) $(MAKEDIRS)
+ $(sa85x_h) $(scfx_h) $(sdct_h) $(sjpeg_h) $(strimpl_h) $(szlibx_h)\
+ $(gdevpsdf_h) $(spprint_h) $(gsovrc_h) $(gsmchunk_h) $(gsmd5_h) $(DEVS_MAK) $(MAKEDIRS)
 	$(DEVJCC) $(DEVO_)gdevpsdu.$(OBJ) $(C_) $(DEVVECSRC)gdevpsdu.c
 
 # Plain text writer
@@ -679,7 +679,7 @@ pdfwrite3_=$(DEVOBJ)gdevpdfg.$(OBJ)
 pdfwrite4_=$(DEVOBJ)gdevpdfi.$(OBJ) $(DEVOBJ)gdevpdfj.$(OBJ) $(DEVOBJ)gdevpdfk.$(OBJ)
 pdfwrite5_=$(DEVOBJ)gdevpdfm.$(OBJ)
 pdfwrite6_=$(DEVOBJ)gdevpdfo.$(OBJ) $(DEVOBJ)gdevpdfp.$(OBJ) $(DEVOBJ)gdevpdft.$(OBJ)
-pdfwrite7_=$(DEVOBJ)gdevpdfr.$(OBJ)
+pdfwrite7_=$(DEVOBJ)gdevpdfq.$(OBJ) $(DEVOBJ)gdevpdfr.$(OBJ)
 pdfwrite8_=$(DEVOBJ)gdevpdfu.$(OBJ) $(DEVOBJ)gdevpdfv.$(OBJ) $(DEVOBJ)gdevagl.$(OBJ)
 pdfwrite9_=$(DEVOBJ)gsflip.$(OBJ)
 pdfwrite10_=$(DEVOBJ)scantab.$(OBJ) $(DEVOBJ)sfilter2.$(OBJ)
@@ -802,6 +802,10 @@ $(DEVOBJ)gdevpdfk.$(OBJ) : $(DEVVECSRC)gdevpdfk.c $(GXERR) $(math__h) $(memory__
  $(stream_h) $(strimpl_h) $(DEVS_MAK) $(MAKEDIRS)
 	$(DEVCC) $(DEVO_)gdevpdfk.$(OBJ) $(C_) $(DEVVECSRC)gdevpdfk.c
 
+$(DEVOBJ)gdevpdfq.$(OBJ) : $(DEVVECSRC)gdevpdfq.c $(GXERR) $(memory__h)\
+ $(gdevpdfo_h) $(gdevpdfx_h) $(gdevpsdf_h) $(gxsync_h) $(DEVS_MAK) $(MAKEDIRS)
+	$(DEVCC) $(DEVO_)gdevpdfq.$(OBJ) $(C_) $(DEVVECSRC)gdevpdfq.c
+
 $(DEVOBJ)gdevpdfm.$(OBJ) : $(DEVVECSRC)gdevpdfm.c\
  $(math__h) $(memory__h) $(string__h) $(gx_h)\
  $(gdevpdfo_h) $(gdevpdfx_h) $(gserrors_h) $(gsutil_h)\
@@ -1522,6 +1526,10 @@ $(DD)fpng.dev : $(fpng_) $(GLD)page.dev $(GDEV) $(DEVS_MAK) $(MAKEDIRS)
 	$(SETPDEV2) $(DD)fpng $(fpng_)
 	$(ADDMOD) $(DD)fpng $(fpng_i_)
 
+$(DD)fpnggray.dev : $(fpng_) $(GLD)page.dev $(GDEV) $(DEVS_MAK) $(MAKEDIRS)
+	$(SETPDEV2) $(DD)fpnggray $(fpng_)
+	$(ADDMOD) $(DD)fpnggray $(fpng_i_)
+
 ### ---------------------- PostScript image format ---------------------- ###
 ### These devices make it possible to print monochrome Level 2 files on a ###
 ###   Level 1 printer, by converting them to a bitmap in PostScript       ###
@@ -104,81 +104,84 @@ fpng_dev_spec_op(gx_device *pdev, int dev_spec_op, void *data, int size)
     return gdev_prn_dev_spec_op(pdev, dev_spec_op, data, size);
 }
 
+/* Since the print_page doesn't alter the device, this device can print in the background */
+#define fpng_device_procs(map_rgb_color, map_color_rgb)\
+{\
+        gdev_prn_open,\
+        NULL,	/* get_initial_matrix */\
+        NULL,	/* sync_output */\
+        gdev_prn_bg_output_page,\
+        gdev_prn_close,\
+        map_rgb_color,\
+        map_color_rgb,\
+        NULL,	/* fill_rectangle */\
+        NULL,	/* tile_rectangle */\
+        NULL,	/* copy_mono */\
+        NULL,	/* copy_color */\
+        NULL,	/* draw_line */\
+        NULL,	/* get_bits */\
+        fpng_get_params,\
+        fpng_put_params,\
+        NULL,	/* map_cmyk_color */\
+        NULL,	/* get_xfont_procs */\
+        NULL,	/* get_xfont_device */\
+        NULL,	/* map_rgb_alpha_color */\
+        gx_page_device_get_page_device,\
+        NULL,	/* get_alpha_bits */\
+        NULL,	/* copy_alpha */\
+        NULL,	/* get_band */\
+        NULL,	/* copy_rop */\
+        NULL,	/* fill_path */\
+        NULL,	/* stroke_path */\
+        NULL,	/* fill_mask */\
+        NULL,	/* fill_trapezoid */\
+        NULL,	/* fill_parallelogram */\
+        NULL,	/* fill_triangle */\
+        NULL,	/* draw_thin_line */\
+        NULL,	/* begin_image */\
+        NULL,	/* image_data */\
+        NULL,	/* end_image */\
+        NULL,	/* strip_tile_rectangle */\
+        NULL,	/* strip_copy_rop, */\
+        NULL,	/* get_clipping_box */\
+        NULL,	/* begin_typed_image */\
+        NULL,	/* get_bits_rectangle */\
+        NULL,	/* map_color_rgb_alpha */\
+        NULL,	/* create_compositor */\
+        NULL,	/* get_hardware_params */\
+        NULL,	/* text_begin */\
+        NULL,	/* finish_copydevice */\
+        NULL,	/* begin_transparency_group */\
+        NULL,	/* end_transparency_group */\
+        NULL,	/* begin_transparency_mask */\
+        NULL,	/* end_transparency_mask */\
+        NULL,  /* discard_transparency_layer */\
+        NULL,  /* get_color_mapping_procs */\
+        NULL,  /* get_color_comp_index */\
+        NULL,  /* encode_color */\
+        NULL,  /* decode_color */\
+        NULL,  /* pattern_manage */\
+        NULL,  /* fill_rectangle_hl_color */\
+        NULL,  /* include_color_space */\
+        NULL,  /* fill_linear_color_scanline */\
+        NULL,  /* fill_linear_color_trapezoid */\
+        NULL,  /* fill_linear_color_triangle */\
+        NULL,  /* update_spot_equivalent_colors */\
+        NULL,  /* ret_devn_params */\
+        NULL,  /* fillpage */\
+        NULL,  /* push_transparency_state */\
+        NULL,  /* pop_transparency_state */\
+        NULL,  /* put_image */\
+        fpng_dev_spec_op,  /* dev_spec_op */\
+        NULL,  /* copy plane */\
+        gx_default_get_profile, /* get_profile */\
+        gx_default_set_graphics_type_tag /* set_graphics_type_tag */\
+}
+
 /* 24-bit color. */
 
-/* Since the print_page doesn't alter the device, this device can print in the background */
 static const gx_device_procs fpng_procs =
-{
-        gdev_prn_open,
-        NULL,	/* get_initial_matrix */
-        NULL,	/* sync_output */
-        gdev_prn_bg_output_page,
-        gdev_prn_close,
-        gx_default_rgb_map_rgb_color,
-        gx_default_rgb_map_color_rgb,
-        NULL,	/* fill_rectangle */
-        NULL,	/* tile_rectangle */
-        NULL,	/* copy_mono */
-        NULL,	/* copy_color */
-        NULL,	/* draw_line */
-        NULL,	/* get_bits */
-        fpng_get_params,
-        fpng_put_params,
-        NULL,	/* map_cmyk_color */
-        NULL,	/* get_xfont_procs */
-        NULL,	/* get_xfont_device */
-        NULL,	/* map_rgb_alpha_color */
-        gx_page_device_get_page_device,
-        NULL,	/* get_alpha_bits */
-        NULL,	/* copy_alpha */
-        NULL,	/* get_band */
-        NULL,	/* copy_rop */
-        NULL,	/* fill_path */
-        NULL,	/* stroke_path */
-        NULL,	/* fill_mask */
-        NULL,	/* fill_trapezoid */
-        NULL,	/* fill_parallelogram */
-        NULL,	/* fill_triangle */
-        NULL,	/* draw_thin_line */
-        NULL,	/* begin_image */
-        NULL,	/* image_data */
-        NULL,	/* end_image */
-        NULL,	/* strip_tile_rectangle */
-        NULL,	/* strip_copy_rop, */
-        NULL,	/* get_clipping_box */
-        NULL,	/* begin_typed_image */
-        NULL,	/* get_bits_rectangle */
-        NULL,	/* map_color_rgb_alpha */
-        NULL,	/* create_compositor */
-        NULL,	/* get_hardware_params */
-        NULL,	/* text_begin */
-        NULL,	/* finish_copydevice */
-        NULL,	/* begin_transparency_group */
-        NULL,	/* end_transparency_group */
-        NULL,	/* begin_transparency_mask */
-        NULL,	/* end_transparency_mask */
-        NULL,  /* discard_transparency_layer */
-        NULL,  /* get_color_mapping_procs */
-        NULL,  /* get_color_comp_index */
-        NULL,  /* encode_color */
-        NULL,  /* decode_color */
-        NULL,  /* pattern_manage */
-        NULL,  /* fill_rectangle_hl_color */
-        NULL,  /* include_color_space */
-        NULL,  /* fill_linear_color_scanline */
-        NULL,  /* fill_linear_color_trapezoid */
-        NULL,  /* fill_linear_color_triangle */
-        NULL,  /* update_spot_equivalent_colors */
-        NULL,  /* ret_devn_params */
-        NULL,  /* fillpage */
-        NULL,  /* push_transparency_state */
-        NULL,  /* pop_transparency_state */
-        NULL,  /* put_image */
-        fpng_dev_spec_op,  /* dev_spec_op */
-        NULL,  /* copy plane */
-        gx_default_get_profile, /* get_profile */
-        gx_default_set_graphics_type_tag /* set_graphics_type_tag */
-};
+    fpng_device_procs(gx_default_rgb_map_rgb_color, gx_default_rgb_map_color_rgb);
 const gx_device_fpng gs_fpng_device =
 {prn_device_body(gx_device_fpng, fpng_procs, "fpng",
                  DEFAULT_WIDTH_10THS, DEFAULT_HEIGHT_10THS,
@@ -188,14 +191,42 @@ const gx_device_fpng gs_fpng_device =
                  GX_DOWNSCALER_PARAMS_DEFAULTS
 };
 
+/* 8-bit gray. */
+
+static const gx_device_procs fpnggray_procs =
+    fpng_device_procs(gx_default_gray_map_rgb_color, gx_default_gray_map_color_rgb);
+const gx_device_fpng gs_fpnggray_device =
+{prn_device_body(gx_device_fpng, fpnggray_procs, "fpnggray",
+                 DEFAULT_WIDTH_10THS, DEFAULT_HEIGHT_10THS,
+                 X_DPI, Y_DPI,
+                 0, 0, 0, 0,	/* margins */
+                 1, 8, 255, 0, 256, 0, fpng_print_page),
+                 GX_DOWNSCALER_PARAMS_DEFAULTS
+};
+
 /* ------ Private definitions ------ */
 
+/*
+ * The bands are filtered and compressed on the rendering threads, each as
+ * a separate raw deflate block sequence, and written out in page order
+ * (see gx_process_page_options_t). The zlib header and the Adler-32 of the
+ * whole image data, which need the bands in order, are done when writing.
+ */
 typedef struct fpng_buffer_s {
     int size;
     int compressed;
+    uLong adler;        /* of the filtered rows of the band */
+    uLong length;       /* of the filtered rows of the band */
+    bool last;
     unsigned char data[1];
 } fpng_buffer_t;
 
+typedef struct fpng_output_s {
+    FILE *file;
+    uLong adler;        /* of the image data written so far */
+    bool first;
+} fpng_output_t;
+
 static int fpng_init_buffer(void *arg, gx_device *dev, gs_memory_t *mem, int w, int h, void **pbuffer)
 {
     /* Currently, we allocate a "worst case" buffer per band - this is
@@ -208,7 +239,9 @@ static int fpng_init_buffer(void *arg, gx_device *dev, gs_memory_t *mem, int w,
      * in paged mode. For now we leave this as an exercise for the reader.
      */
     fpng_buffer_t *buffer;
-    int size = deflateBound(NULL, (w*3+1)*h);
+    /* Leave room for the zlib header and checksum (see fpng_output), and
+     * the empty block of the final flush. */
+    int size = deflateBound(NULL, (w*dev->color_info.num_components+1)*h) + 16;
     buffer = (fpng_buffer_t *)gs_alloc_bytes(mem, sizeof(fpng_buffer_t) + size, "fpng_init_buffer");
     *pbuffer = (void *)buffer;
     if (buffer == NULL)
@@ -265,11 +298,11 @@ static void zfree(void *mem_, void *address)
     gs_free_object(mem, address, "zfree (fpng_process)");
 }
 
-static inline int paeth_predict(const unsigned char *d, int raster)
+static inline int paeth_predict(const unsigned char *d, int raster, int n)
 {
-    int a = d[-3]; /* Left */
+    int a = d[-n]; /* Left */
     int b = d[-raster]; /* Above */
-    int c = d[-3-raster]; /* Above left */
+    int c = d[-n-raster]; /* Above left */
     int p = a + b - c;
     int pa, pb, pc;
     pa = p - a;
@@ -293,25 +326,29 @@ static int fpng_process(void *arg, gx_device *dev, gx_device *bdev, const gs_int
     int code;
     gx_device_fpng *fdev = (gx_device_fpng *)dev;
     gs_get_bits_params_t params;
+    int n = dev->color_info.num_components;
     int w = rect->q.x - rect->p.x;
-    int raster = bitmap_raster(bdev->width * 3 * 8);
+    int raster = bitmap_raster(bdev->width * n * 8);
     int h = rect->q.y - rect->p.y;
-    int x, y;
+    int x, y, i;
     unsigned char *p;
     unsigned char sub = 1;
     unsigned char paeth = 4;
-    int firstband = (rect->p.y == 0);
     int lastband;
     gs_int_rect my_rect;
     z_stream stream;
     int err;
     int page_height = gx_downscaler_scale_rounded(dev->height, fdev->downscale.downscale_factor);
     fpng_buffer_t *buffer = (fpng_buffer_t *)buffer_;
+    uLong adler = adler32(0, NULL, 0);
 
+    buffer->compressed = 0;
+    buffer->length = 0;
+    buffer->last = false;
     if (h <= 0 || w <= 0)
         return 0;
 
-    lastband = (rect->q.y == page_height-1);
+    lastband = (rect->q.y == page_height);
 
     params.options = GB_COLORS_NATIVE | GB_ALPHA_NONE | GB_PACKING_CHUNKY | GB_RETURN_POINTER | GB_ALIGN_ANY | GB_OFFSET_0 | GB_RASTER_ANY;
     my_rect.p.x = 0;
@@ -328,64 +365,49 @@ static int fpng_process(void *arg, gx_device *dev, gx_device *bdev, const gs_int
     p += raster*(h-1);
     for (y = h-1; y > 0; y--)
     {
-        p += 3*(w-1);
+        p += n*(w-1);
         for (x = w-1; x > 0; x--)
         {
-            p[0] -= paeth_predict(p+0, raster);
-            p[1] -= paeth_predict(p+1, raster);
-            p[2] -= paeth_predict(p+2, raster);
-            p -= 3;
+            for (i = 0; i < n; i++)
+                p[i] -= paeth_predict(p+i, raster, n);
+            p -= n;
         }
-        p[0] -= p[-raster];
-        p[1] -= p[1-raster];
-        p[2] -= p[2-raster];
+        for (i = 0; i < n; i++)
+            p[i] -= p[i-raster];
         p -= raster;
     }
     /* Sub for the first line */
     {
-        p += 3*(w-1);
+        p += n*(w-1);
         for (x = w-1; x > 0; x--)
         {
-            p[2] -= p[-1];
-            p[1] -= p[-2];
-            p[0] -= p[-3];
-            p -= 3;
+            for (i = n-1; i >= 0; i--)
+                p[i] -= p[i-n];
+            p -= n;
         }
     }
 
-    /* Compress the data */
+    /* Compress the data, as raw deflate blocks: the zlib header and
+     * checksum are written by fpng_output. */
     stream.zalloc = zalloc;
     stream.zfree = zfree;
     stream.opaque = bdev->memory;
-    err = deflateInit(&stream, Z_DEFAULT_COMPRESSION);
+    err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
     if (err != Z_OK)
       return_error(gs_error_VMerror);
     p = params.data[0];
     stream.next_out = &buffer->data[0];
     stream.avail_out = buffer->size;
 
-    /* Nasty zlib hackery here. Zlib always outputs a 'start of stream'
-     * marker at the beginning. We just want a block, so for all blocks
-     * except the first one, we compress a single byte and flush it. This
-     * takes care of the 'start of stream' marker. Throw this deflate block
-     * away, and start compression again. */
-    if (!firstband)
-    {
-        stream.next_in = &sub;
-        stream.avail_in = 1;
-        deflate(&stream, Z_FULL_FLUSH);
-        stream.next_out = &buffer->data[0];
-        stream.avail_out = buffer->size;
-        stream.total_out = 0;
-    }
-
     stream.next_in = &sub;
     for (y = h-1; y >= 0; y--)
     {
+        adler = adler32(adler, stream.next_in, 1);
         stream.avail_in = 1;
         deflate(&stream, Z_NO_FLUSH);
+        adler = adler32(adler, p, w*n);
         stream.next_in = p;
-        stream.avail_in = w*3;
+        stream.avail_in = w*n;
         deflate(&stream, (y == 0 ? (lastband ? Z_FINISH : Z_FULL_FLUSH) : Z_NO_FLUSH));
         p += raster;
         stream.next_in = &paeth;
@@ -394,16 +416,37 @@ static int fpng_process(void *arg, gx_device *dev, gx_device *bdev, const gs_int
     deflateEnd(&stream);
 
     buffer->compressed = stream.total_out;
+    buffer->adler = adler;
+    buffer->length = (uLong)h * (w*n+1);
+    buffer->last = lastband;
 
     return code;
 }
 
 static int fpng_output(void *arg, gx_device *dev, void *buffer_)
 {
-    FILE *file = (FILE *)arg;
+    fpng_output_t *out = (fpng_output_t *)arg;
     fpng_buffer_t *buffer = (fpng_buffer_t *)buffer_;
+    unsigned char *data = &buffer->data[0];
+    int size = buffer->compressed;
 
-    putchunk("IDAT", &buffer->data[0], buffer->compressed, file);
+    if (buffer->length == 0)
+        return 0;
+    if (out->first) {
+        /* fpng_init_buffer left room for the header and the checksum. */
+        memmove(data + 2, data, size);
+        data[0] = 0x78;
+        data[1] = 0x9c;
+        size += 2;
+        out->adler = buffer->adler;
+        out->first = false;
+    } else
+        out->adler = adler32_combine(out->adler, buffer->adler, buffer->length);
+    if (buffer->last) {
+        big32(data + size, out->adler);
+        size += 4;
+    }
+    putchunk("IDAT", data, size, out->file);
 
     return 0;
 }
@@ -416,6 +459,8 @@ fpng_print_page(gx_device_printer *pdev, FILE *file)
     static const unsigned char pngsig[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
     unsigned char head[13];
     gx_process_page_options_t process = { 0 };
+    fpng_output_t out;
+    int code;
 
     fwrite(pngsig, 1, 8, file); /* Signature */
 
@@ -423,7 +468,7 @@ fpng_print_page(gx_device_printer *pdev, FILE *file)
     big32(&head[0], gx_downscaler_scale_rounded(pdev->width, fdev->downscale.downscale_factor));
     big32(&head[4], gx_downscaler_scale_rounded(pdev->height, fdev->downscale.downscale_factor));
     head[8] = 8; /* 8bpc */
-    head[9] = 2; /* rgb */
+    head[9] = (pdev->color_info.num_components == 1 ? 0 : 2); /* gray or rgb */
     head[10] = 0; /* compression */
     head[11] = 0; /* filter */
     head[12] = 0; /* interlace */
@@ -433,7 +478,14 @@ fpng_print_page(gx_device_printer *pdev, FILE *file)
     process.free_buffer_fn = fpng_free_buffer;
     process.process_fn = fpng_process;
     process.output_fn = fpng_output;
-    process.arg = file;
+    process.arg = &out;
+    out.file = file;
+    out.adler = adler32(0, NULL, 0);
+    out.first = true;
 
-    return gx_downscaler_process_page((gx_device *)pdev, &process, fdev->downscale.downscale_factor);
+    code = gx_downscaler_process_page((gx_device *)pdev, &process, fdev->downscale.downscale_factor);
+    if (code < 0)
+        return code;
+    putchunk("IEND", head, 0, file);
+    return 0;
 }
@@ -118,6 +118,8 @@ ENUM_PTRS_WITH(device_pdfwrite_enum_ptrs, gx_device_pdf *pdev)
  ENUM_PTR(39, gx_device_pdf, EmbeddedFiles);
  ENUM_PTR(40, gx_device_pdf, pdf_font_dir);
  ENUM_PTR(41, gx_device_pdf, ExtensionMetadata);
+ ENUM_PTR(42, gx_device_pdf, PassThroughWriter);
+ ENUM_PTR(43, gx_device_pdf, EncodePending);
 #define e1(i,elt) ENUM_PARAM_STRING_PTR(i + gx_device_pdf_num_ptrs, gx_device_pdf, elt);
 gx_device_pdf_do_param_strings(e1)
 #undef e1
@@ -170,6 +172,8 @@ static RELOC_PTRS_WITH(device_pdfwrite_reloc_ptrs, gx_device_pdf *pdev)
  RELOC_PTR(gx_device_pdf, EmbeddedFiles);
  RELOC_PTR(gx_device_pdf, pdf_font_dir);
  RELOC_PTR(gx_device_pdf, ExtensionMetadata);
+ RELOC_PTR(gx_device_pdf, PassThroughWriter);
+ RELOC_PTR(gx_device_pdf, EncodePending);
 #define r1(i,elt) RELOC_PARAM_STRING_PTR(gx_device_pdf,elt);
         gx_device_pdf_do_param_strings(r1)
 #undef r1
@@ -286,7 +290,8 @@ pdf_close_temp_file(gx_device_pdf *pdev, pdf_temp_file_t *ptf, int code)
     }
     if (file) {
         err = ferror(file) | fclose(file);
-        unlink(ptf->file_name);
+        if (ptf->file_name[0])	/* not held in memory */
+            unlink(ptf->file_name);
         ptf->file = 0;
     }
     ptf->save_strm = 0;
@@ -316,9 +321,13 @@ pdf_reset_page(gx_device_pdf * pdev)
     pdev->clip_path_id = pdev->no_clip_path_id;
 }
 
-/* Open a temporary file, with or without a stream. */
+/*
+ * Open a temporary file, with or without a stream.  With MaxTempMemorySize
+ * set, the files of the document are held in memory where the platform
+ * allows, until pdf_spill_temp_files moves them to disk.
+ */
 static int
-pdf_open_temp_file(gx_device_pdf *pdev, pdf_temp_file_t *ptf)
+pdf_open_temp_file(gx_device_pdf *pdev, pdf_temp_file_t *ptf, bool in_memory)
 {
     char fmode[4];
 
@@ -327,6 +336,14 @@ pdf_open_temp_file(gx_device_pdf *pdev, pdf_temp_file_t *ptf)
 
     strcpy(fmode, "w+");
     strcat(fmode, gp_fmode_binary_suffix);
+    ptf->file_name[0] = 0;
+    if (in_memory && pdev->MaxTempMemorySize > 0) {
+        ptf->file = gp_open_memory_scratch_file(pdev->memory,
+                                                gp_scratch_file_name_prefix,
+                                                fmode);
+        if (ptf->file != 0)
+            return 0;
+    }
     ptf->file =	gp_open_scratch_file_64(pdev->memory,
                                      gp_scratch_file_name_prefix,
                                      ptf->file_name,
@@ -338,7 +355,7 @@ pdf_open_temp_file(gx_device_pdf *pdev, pdf_temp_file_t *ptf)
 static int
 pdf_open_temp_stream(gx_device_pdf *pdev, pdf_temp_file_t *ptf)
 {
-    int code = pdf_open_temp_file(pdev, ptf);
+    int code = pdf_open_temp_file(pdev, ptf, true);
 
     if (code < 0)
         return code;
@@ -357,6 +374,65 @@ pdf_open_temp_stream(gx_device_pdf *pdev, pdf_temp_file_t *ptf)
     return 0;
 }
 
+/* Return the size of a temporary file, leaving its position alone. */
+static int64_t
+pdf_temp_file_size(pdf_temp_file_t *ptf)
+{
+    int64_t pos, size;
+
+    if (ptf->strm && s_is_valid(ptf->strm))
+        sflush(ptf->strm);
+    if (ptf->file == 0 || (pos = gp_ftell_64(ptf->file)) < 0 ||
+        gp_fseek_64(ptf->file, 0, SEEK_END) != 0)
+        return -1;
+    size = gp_ftell_64(ptf->file);
+    if (gp_fseek_64(ptf->file, pos, SEEK_SET) != 0)
+        return -1;
+    return size;
+}
+
+/*
+ * Move the temporary files held in memory to disk, largest first, until
+ * those left take no more than MaxTempMemorySize.  Called between pages,
+ * when no substream is open on them.
+ */
+static int
+pdf_spill_temp_files(gx_device_pdf *pdev)
+{
+    pdf_temp_file_t *files[4];
+    int64_t sizes[4], total = 0;
+    int i, n = 0;
+
+    files[0] = &pdev->xref;
+    files[1] = &pdev->asides;
+    files[2] = &pdev->streams;
+    files[3] = &pdev->pictures;
+    for (i = 0; i < 4; i++) {
+        if (files[i]->file == 0 || files[i]->file_name[0])
+            continue;
+        sizes[n] = pdf_temp_file_size(files[i]);
+        if (sizes[n] < 0)
+            return_error(gs_error_ioerror);
+        files[n] = files[i];
+        total += sizes[n++];
+    }
+    while (total > pdev->MaxTempMemorySize && n > 0) {
+        int largest = 0;
+
+        for (i = 1; i < n; i++)
+            if (sizes[i] > sizes[largest])
+                largest = i;
+        if (gp_spill_scratch_file(pdev->memory, files[largest]->file,
+                                  gp_scratch_file_name_prefix,
+                                  files[largest]->file_name) < 0)
+            return_error(gs_error_invalidfileaccess);
+        total -= sizes[largest];
+        files[largest] = files[--n];
+        sizes[largest] = sizes[n];
+    }
+    return 0;
+}
+
 /* Initialize the IDs allocated at startup. */
 void
 pdf_initialize_ids(gx_device_pdf * pdev)
@@ -713,7 +789,7 @@ pdf_open(gx_device * dev)
 
     pdev->InOutputPage = false;
 
-    if ((code = pdf_open_temp_file(pdev, &pdev->xref)) < 0 ||
+    if ((code = pdf_open_temp_file(pdev, &pdev->xref, true)) < 0 ||
         (code = pdf_open_temp_stream(pdev, &pdev->asides)) < 0 ||
         (code = pdf_open_temp_stream(pdev, &pdev->streams)) < 0 ||
         (code = pdf_open_temp_stream(pdev, &pdev->pictures)) < 0
@@ -1407,6 +1483,9 @@ pdf_output_page(gx_device * dev, int num_copies, int flush)
     }
     if (pdf_ferror(pdev))
         return_error(gs_error_ioerror);
+    if (pdev->MaxTempMemorySize > 0 &&
+        (code = pdf_spill_temp_files(pdev)) < 0)
+        return code;
 
     if ((code = gx_finish_output_page(dev, num_copies, flush)) < 0)
         return code;
@@ -1656,7 +1735,7 @@ static int pdf_linearise(gx_device_pdf *pdev, pdf_linearisation_t *linear_params
     code = gx_device_open_output_file((gx_device *)pdev, "/temp/linear.pdf",
                                    true, true, &linear_params->Lin_File.file);
 #else
-    code = pdf_open_temp_file(pdev, &linear_params->Lin_File);
+    code = pdf_open_temp_file(pdev, &linear_params->Lin_File, false);
 #endif
     if (code < 0)
         return code;
@@ -2542,6 +2621,9 @@ pdf_close(gx_device * dev)
       return_error(gs_error_undefined);
     dev->is_open = false;
 
+    /* Add the data of the images still being compressed, stop the threads. */
+    code = pdf_close_encode_queue(pdev);
+
     Catalog_id = pdev->Catalog->id;
     Info_id = pdev->Info->id;
     Pages_id = pdev->Pages->id;
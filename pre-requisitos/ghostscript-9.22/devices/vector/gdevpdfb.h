@@ -141,6 +141,7 @@ const gx_device_pdf PDF_DEVICE_IDENT =
  12000,				/* MaxClipPathSize */ /* HP LaserJet 1320 hangs with 14000. */
  256000,			/* MaxShadingBitmapSize */
  PDF_DEVICE_MaxInlineImageSize,	/* MaxInlineImageSize */
+ 0,				/* MaxTempMemorySize */
  {0, 0, 0},			/* OwnerPassword */
  {0, 0, 0},			/* UserPassword */
  0,				/* KeyLength */
@@ -269,6 +270,7 @@ const gx_device_pdf PDF_DEVICE_IDENT =
  true,				/* PreserveDeviceN */
  0,				/* PDFACompatibilityPolicy */
  true,				/* DetectDuplicateImages */
+ false,				/* DetectDuplicateFonts */
  false,				/* AllowIncrementalCFF */
  !PDF_FOR_OPDFREAD,		/* WantsToUnicode */
  !PDF_FOR_OPDFREAD,		/* WantsPageLabels */
@@ -284,5 +286,14 @@ const gx_device_pdf PDF_DEVICE_IDENT =
  false,                 /* FlattenFonts, writes text as outlines instead of fonts */
  -1,                    /* Last Form ID, start with -1 which means 'none' */
  0,                     /* ExtensionMetadata */
- 0                      /* PDFFormName */
+ 0,                     /* PDFFormName */
+ !PDF_FOR_OPDFREAD,     /* PassThroughJPEGImages */
+ false,                 /* JPEG_PassThrough */
+ 0,                     /* PassThroughOwner */
+ 0,                     /* PassThroughWriter */
+ {0, 0},                /* PassThroughTail */
+ 0,                     /* NumEncodeThreads */
+ 0,                     /* EncodeQueue */
+ 0,                     /* EncodePending */
+ 0                      /* EncodePendingCount */
 };
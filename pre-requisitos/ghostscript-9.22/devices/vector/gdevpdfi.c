@@ -79,6 +79,7 @@ typedef struct pdf_image_enum_s {
     pdf_image_writer writer;
     gs_matrix mat;
     gs_color_space_index initial_colorspace;
+    bool JPEG_PassThrough;	/* writing the DCTDecode data unchanged */
 } pdf_image_enum;
 gs_private_st_composite(st_pdf_image_enum, pdf_image_enum, "pdf_image_enum",
   pdf_image_enum_enum_ptrs, pdf_image_enum_reloc_ptrs);
@@ -1366,6 +1367,27 @@ pdf_begin_typed_image(gx_device_pdf *pdev, const gs_gstate * pgs,
         }
     }
 
+    /*
+     * If a DCTDecode filter offered us its data, write it unchanged
+     * instead of the samples when we would have used DCTEncode for them
+     * at the same resolution anyway.
+     */
+    if (pdev->JPEG_PassThrough) {
+        pdev->JPEG_PassThrough = false;
+        pie->JPEG_PassThrough =
+            (context == PDF_IMAGE_DEFAULT && pic->type->index == 1 &&
+             !is_mask && !in_line && !force_lossless &&
+             !convert_to_process_colors && pnamed == 0 &&
+             pdev->PassThroughOwner == NULL && pdev->binary_ok &&
+             !pdev->ForOPDFRead && format == gs_image_format_chunky &&
+             pim->BitsPerComponent == 8 &&
+             width == pim->Width && height == pim->Height &&
+             psdf_is_DCT_pass_through_image((gx_device_psdf *)pdev,
+                                            &image[0].pixel, pmat));
+        if (pie->JPEG_PassThrough)
+            pie->writer.alt_writer_count = 1;
+    }
+
     image[1] = image[0];
 
     pdev->ParamCompatibilityLevel = pdev->CompatibilityLevel;
@@ -1375,6 +1397,23 @@ pdf_begin_typed_image(gx_device_pdf *pdev, const gs_gstate * pgs,
     if (code < 0)
         goto fail_and_fallback;
 
+    /*
+     * With encoding threads, let the compression filter of an XObject
+     * image run apart, unless it is set up by AutoFilter, which compresses
+     * the data both ways to choose.  The data is kept in memory meanwhile.
+     */
+    if (context == PDF_IMAGE_DEFAULT && pic->type->index == 1 &&
+        !is_mask && !in_line && !pie->JPEG_PassThrough && pnamed == 0 &&
+        pdev->binary_ok && !pdev->ForOPDFRead &&
+        (double)pim->Width * pim->Height * num_components *
+            pim->BitsPerComponent / 8 < max_uint / 4 &&
+        pdf_can_encode_apart(pdev)) {
+        code = psdf_alloc_encode_work((gx_device_psdf *)pdev,
+                                      &pie->writer.binary[0].encode_work);
+        if (code < 0)
+            goto fail_and_fallback;
+    }
+
     /* Code below here deals with setting up the multiple data stream writing.
      * We can have up to 4 stream writers, which we keep in an array. We must
      * always have at least one which writes the uncompressed stream. If we
@@ -1390,6 +1429,9 @@ pdf_begin_typed_image(gx_device_pdf *pdev, const gs_gstate * pgs,
         code = new_setup_lossless_filters((gx_device_psdf *) pdev,
                                              &pie->writer.binary[0],
                                              &image[0].pixel, in_line, convert_to_process_colors, (gs_matrix *)pmat, (gs_gstate *)pgs);
+    } else if (pie->JPEG_PassThrough) {
+        /* No filters, the data is already encoded. */
+        code = 0;
     } else {
         if (force_lossless) {
             /*
@@ -1518,12 +1560,34 @@ pdf_begin_typed_image(gx_device_pdf *pdev, const gs_gstate * pgs,
         }
     }
 
+    if (pie->writer.binary[0].encode_work != NULL &&
+        !pie->writer.binary[0].encode_work->captured) {
+        /* No compression, or AutoFilter. */
+        psdf_free_encode_work(pie->writer.binary[0].encode_work);
+        pie->writer.binary[0].encode_work = NULL;
+    }
+
     for (i = 0; i < pie->writer.alt_writer_count; i++) {
         code = pdf_begin_image_data_decoded(pdev, num_components, pranges, i,
                              &image[i].pixel, &cs_value, pie);
         if (code < 0)
             goto fail_and_fallback;
     }
+    if (pie->JPEG_PassThrough) {
+        cos_stream_t *pcs = cos_stream_from_pipeline(pie->writer.binary[0].strm);
+
+        if (pcs == 0L) {
+            code = gs_note_error(gs_error_ioerror);
+            goto fail_and_fallback;
+        }
+        code = cos_dict_put_c_strings(cos_stream_dict(pcs),
+                                      pie->writer.pin->filter_names.Filter,
+                                      pie->writer.pin->filter_names.DCTDecode);
+        if (code < 0)
+            goto fail_and_fallback;
+        pdev->PassThroughWriter = pie->writer.binary[0].strm;
+        pdev->PassThroughTail[0] = pdev->PassThroughTail[1] = 0;
+    }
     if (pie->writer.alt_writer_count == 2) {
         psdf_setup_compression_chooser(&pie->writer.binary[2],
              (gx_device_psdf *)pdev, pim->Width, pim->Height,
@@ -1563,6 +1627,9 @@ pdf_begin_typed_image(gx_device_pdf *pdev, const gs_gstate * pgs,
     return 0;
 
 fail_and_fallback:
+    if (pie->writer.binary[0].encode_work != NULL &&
+        !pie->writer.binary[0].encode_work->captured)
+        psdf_free_encode_work(pie->writer.binary[0].encode_work);
     gs_free(mem->non_gc_memory, image, 4, sizeof(image_union_t),
                                       "pdf_begin_typed_image(image)");
     gs_free_object(mem, pie, "pdf_begin_image");
@@ -1665,14 +1732,65 @@ pdf_image_plane_data_alt(gx_image_enum_common_t * info,
 #undef ROW_BYTES
 }
 
+/*
+ * Stop passing the DCTDecode data through, because the image didn't read
+ * it: its samples come from elsewhere.
+ */
+static int
+pdf_image_cancel_pass_through(gx_device_pdf *pdev, pdf_image_enum *pie)
+{
+    cos_stream_t *pcs = cos_stream_from_pipeline(pie->writer.binary[0].strm);
+
+    pie->JPEG_PassThrough = false;
+    pdev->PassThroughWriter = 0;
+    if (pcs == 0L)
+        return_error(gs_error_ioerror);
+    return cos_dict_delete_c_key(cos_stream_dict(pcs),
+                                 pie->writer.pin->filter_names.Filter);
+}
+
+/* Finish the data of an image written with the DCTDecode data unchanged. */
+static int
+pdf_image_end_pass_through(gx_device_pdf *pdev, pdf_image_enum *pie)
+{
+    static const byte EOI[2] = {0xff, 0xd9};
+    uint ignore;
+
+    pdev->PassThroughWriter = 0;
+    /*
+     * The decoder usually stops reading after the last scan line,
+     * before the EOI marker.
+     */
+    if (pdev->PassThroughTail[0] != EOI[0] || pdev->PassThroughTail[1] != EOI[1])
+        if (sputs(pie->writer.binary[0].strm, EOI, sizeof(EOI), &ignore) < 0)
+            return_error(gs_error_ioerror);
+    return 0;
+}
+
 static int
 pdf_image_plane_data(gx_image_enum_common_t * info,
                      const gx_image_plane_t * planes, int height,
                      int *rows_used)
 {
+    gx_device_pdf *pdev = (gx_device_pdf *)info->dev;
     pdf_image_enum *pie = (pdf_image_enum *) info;
     int i;
 
+    if (pie->JPEG_PassThrough) {
+        if (pdev->PassThroughOwner == NULL &&
+            pdev->PassThroughWriter == pie->writer.binary[0].strm) {
+            /* No filter has passed any data. */
+            int code = pdf_image_cancel_pass_through(pdev, pie);
+
+            if (code < 0)
+                return code;
+        } else {
+            /* The filter writes the data, just count the rows. */
+            *rows_used = min(height, pie->rows_left);
+            pie->rows_left -= *rows_used;
+            return !pie->rows_left;
+        }
+    }
     for (i = 0; i < pie->writer.alt_writer_count; i++) {
         int code = pdf_image_plane_data_alt(info, planes, height, rows_used, i);
         if (code)
@@ -1825,6 +1943,14 @@ pdf_image_end_image_data(gx_image_enum_common_t * info, bool draw_last,
     int data_height = height - pie->rows_left;
     int code = 0;
 
+    if (pie->JPEG_PassThrough) {
+        if (data_height > 0)
+            code = pdf_image_end_pass_through(pdev, pie);
+        else
+            pdev->PassThroughWriter = 0;
+        if (code < 0)
+            return code;
+    }
     if (pie->writer.pres)
         ((pdf_x_object_t *)pie->writer.pres)->data_height = data_height;
     else if (data_height > 0)
@@ -2132,6 +2258,33 @@ gdev_pdf_dev_spec_op(gx_device *pdev1, int dev_spec_op, void *data, int size)
     switch (dev_spec_op) {
         case gxdso_pattern_can_accum:
             return 1;
+        case gxdso_JPEG_passthrough_query:
+            pdev->JPEG_PassThrough = pdev->PassThroughJPEGImages;
+            return (int)pdev->PassThroughJPEGImages;
+        case gxdso_JPEG_passthrough_begin:
+            if (pdev->PassThroughOwner == NULL)
+                pdev->PassThroughOwner = data;
+            return 0;
+        case gxdso_JPEG_passthrough_data:
+            if (pdev->PassThroughWriter != NULL && size > 0) {
+                const byte *p = (const byte *)data;
+                uint ignore;
+
+                if (sputs(pdev->PassThroughWriter, p, size, &ignore) < 0)
+                    return_error(gs_error_ioerror);
+                if (size > 1)
+                    pdev->PassThroughTail[0] = p[size - 2];
+                else
+                    pdev->PassThroughTail[0] = pdev->PassThroughTail[1];
+                pdev->PassThroughTail[1] = p[size - 1];
+            }
+            return 0;
+        case gxdso_JPEG_passthrough_end:
+            if (data == pdev->PassThroughOwner) {
+                pdev->PassThroughOwner = NULL;
+                pdev->PassThroughWriter = 0;
+            }
+            return 0;
         case gxdso_pdf_form_name:
             if (pdev->PDFFormName) {
                 gs_free_object(pdev->memory->non_gc_memory, pdev->PDFFormName, "free Name of Form for pdfmark");
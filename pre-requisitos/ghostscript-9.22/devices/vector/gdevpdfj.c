@@ -418,8 +418,11 @@ pdf_complete_image_data(gx_device_pdf *pdev, pdf_image_writer *piw, int data_h,
                         int width, int bits_per_pixel)
 {
     if (data_h != piw->height) {
-        if (piw->binary[0].strm->procs.process == s_DCTE_template.process ||
-            piw->binary[0].strm->procs.process == s_PNGPE_template.process ) {
+        const stream_template *templat =
+            psdf_stream_encoder_template(piw->binary[0].strm);
+
+        if (templat->process == s_DCTE_template.process ||
+            templat->process == s_PNGPE_template.process ) {
             /* 	Since DCTE and PNGPE can't safely close with incomplete data,
                 we add stub data to complete the stream.
             */
@@ -447,12 +450,22 @@ pdf_complete_image_data(gx_device_pdf *pdev, pdf_image_writer *piw, int data_h,
 int
 pdf_end_image_binary(gx_device_pdf *pdev, pdf_image_writer *piw, int data_h)
 {
+    psdf_encode_work_t *pw = piw->binary[0].encode_work;
     int code, code1 = 0;
 
+    if (pw != NULL)
+        pw->claimed = true;	/* closing the pipeline mustn't free it */
     if (piw->alt_writer_count > 2)
         code = pdf_choose_compression(piw, true);
     else
         code = psdf_end_binary(&piw->binary[0]);
+    if (pw != NULL) {
+        piw->binary[0].encode_work = NULL;
+        if (code < 0)
+            psdf_free_encode_work(pw);
+        else
+            code = pdf_submit_encode_work(pdev, piw->data, pw);
+    }
     /* If the image ended prematurely, update the Height. */
     if (data_h != piw->height) {
         char data[256];
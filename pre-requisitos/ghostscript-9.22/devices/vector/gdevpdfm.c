@@ -386,6 +386,7 @@ setup_pdfmark_stream_compression(gx_device_psdf *pdev0,
         return_error(gs_error_VMerror);
     if (templat->set_defaults)
         (*templat->set_defaults) (st);
+    psdf_set_flate_params((gx_device_psdf *)pdev, templat, st);
     if (s_add_filter(&pco->input_strm, templat, st, mem) == 0) {
         gs_free_object(mem, st, "setup_image_compression");
         return_error(gs_error_VMerror);
@@ -179,6 +179,7 @@ cos_object_init(cos_object_t *pco, gx_device_pdf *pdev,
         pco->md5_valid = 0;
         pco->stream_md5_valid = 0;
         memset(&pco->hash, 0x00, 16);
+        pco->encode_pending = 0;
     }
 }
 
@@ -1678,6 +1679,8 @@ cos_stream_release(cos_object_t *pco, client_name_t cname)
     cos_stream_piece_t *cur;
     cos_stream_piece_t *next;
 
+    if (pcs->encode_pending)
+        pdf_cancel_encode_work(pcs);
     for (cur = pcs->pieces; cur; cur = next) {
         next = cur->next;
         gs_free_object(cos_object_memory(pco), cur, cname);
@@ -1695,6 +1698,12 @@ static int hash_cos_stream(const cos_object_t *pco0, gs_md5_state_t *md5, gs_md5
     int64_t position_save;
     int result;
 
+    if (pcs->encode_pending) {
+        result = pdf_finish_encode_work(pdev, (cos_stream_t *)pcs);
+        if (result < 0)
+            return result;
+        pcsp = pcs->pieces;
+    }
     sflush(pdev->strm);
     sflush(pdev->streams.strm);
     position_save = gp_ftell_64(sfile);
@@ -1811,6 +1820,11 @@ cos_stream_contents_write(const cos_stream_t *pcs, gx_device_pdf *pdev)
     int code;
     stream_arcfour_state sarc4, *ss = NULL;
 
+    if (pcs->encode_pending) {
+        code = pdf_finish_encode_work(pdev, (cos_stream_t *)pcs);
+        if (code < 0)
+            return code;
+    }
     if (pdev->KeyLength) {
         code = pdf_encrypt_init(pdev, pcs->id, &sarc4);
         if (code < 0)
@@ -1862,6 +1876,12 @@ cos_stream_write(const cos_object_t *pco, gx_device_pdf *pdev, gs_id object_id)
         /* We have to break const here to clear the input_strm. */
         ((cos_object_t *)pco)->input_strm = 0;
     }
+    if (pcs->encode_pending) {
+        /* We need the length of the compressed data. */
+        code = pdf_finish_encode_work(pdev, (cos_stream_t *)pcs);
+        if (code < 0)
+            return code;
+    }
     stream_puts(s, "<<");
     cos_elements_write(s, pcs->elements, pdev, false, object_id);
     pprintld1(s, "/Length %ld>>stream\n", cos_stream_length(pcs));
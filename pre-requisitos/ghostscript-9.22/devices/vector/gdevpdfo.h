@@ -107,6 +107,9 @@ typedef struct cos_stream_piece_s cos_stream_piece_t;
  *
  * The written member records whether the object has been written (copied)
  * into the contents or resource file.
+ *
+ * The encode_pending member is set while the data of an image stream is
+ * being compressed by an encoding thread, see gdevpdfq.c.
  */
 #define cos_object_struct(otype_s, etype)\
 struct otype_s {\
@@ -128,12 +131,13 @@ struct otype_s {\
     byte stream_hash[16];	/* MD5 hash value (if stream) */\
     /* input_strm is introduced recently for pdfmark. */\
     /* Using this field, psdf_binary_writer_s may be simplified. */\
+    struct pdf_encode_pending_s *encode_pending; /* only for stream objects */\
 }
 cos_object_struct(cos_object_s, cos_element_t);
 #define private_st_cos_object()	/* in gdevpdfo.c */\
-  gs_private_st_ptrs4(st_cos_object, cos_object_t, "cos_object_t",\
+  gs_private_st_ptrs5(st_cos_object, cos_object_t, "cos_object_t",\
     cos_object_enum_ptrs, cos_object_reloc_ptrs, elements, pieces,\
-    pres, input_strm)
+    pres, input_strm, encode_pending)
 extern const cos_object_procs_t cos_generic_procs;
 #define cos_type_generic (&cos_generic_procs)
 
@@ -77,6 +77,7 @@ static const gs_param_item_t pdf_param_items[] = {
     pi("CompressStreams", gs_param_type_bool, CompressStreams),
     pi("PrintStatistics", gs_param_type_bool, PrintStatistics),
     pi("MaxInlineImageSize", gs_param_type_long, MaxInlineImageSize),
+    pi("MaxTempMemorySize", gs_param_type_long, MaxTempMemorySize),
 
         /* PDF Encryption */
     pi("OwnerPassword", gs_param_type_string, OwnerPassword),
@@ -117,6 +118,7 @@ static const gs_param_item_t pdf_param_items[] = {
     pi("PreserveDeviceN", gs_param_type_bool, PreserveDeviceN),
     pi("PDFACompatibilityPolicy", gs_param_type_int, PDFACompatibilityPolicy),
     pi("DetectDuplicateImages", gs_param_type_bool, DetectDuplicateImages),
+    pi("DetectDuplicateFonts", gs_param_type_bool, DetectDuplicateFonts),
     pi("AllowIncrementalCFF", gs_param_type_bool, AllowIncrementalCFF),
     pi("WantsToUnicode", gs_param_type_bool, WantsToUnicode),
     pi("AllowPSRepeatFunctions", gs_param_type_bool, AllowPSRepeatFunctions),
@@ -127,6 +129,8 @@ static const gs_param_item_t pdf_param_items[] = {
     pi("FastWebView", gs_param_type_bool, Linearise),
     pi("NoOutputFonts", gs_param_type_bool, FlattenFonts),
     pi("WantsPageLabels", gs_param_type_bool, WantsPageLabels),
+    pi("PassThroughJPEGImages", gs_param_type_bool, PassThroughJPEGImages),
+    pi("NumEncodeThreads", gs_param_type_int, NumEncodeThreads),
 #undef pi
     gs_param_item_end
 };
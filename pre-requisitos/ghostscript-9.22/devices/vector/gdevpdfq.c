@@ -0,0 +1,337 @@
+/* Copyright (C) 2001-2017 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  7 Mt. Lassen Drive - Suite A-134, San Rafael,
+   CA  94903, U.S.A., +1(415)492-9861, for further information.
+*/
+
+
+/* Image compression on encoding threads for pdfwrite */
+#include "memory_.h"
+#include "gx.h"
+#include "gserrors.h"
+#include "gxsync.h"
+#include "gdevpdfx.h"
+#include "gdevpdfo.h"
+
+/*
+ * With NumEncodeThreads > 0, the compression filters of an image written
+ * as an XObject aren't run as the data arrives: the data is kept in memory
+ * (see psdf_encode_work_t), and compressed by one of the encoding threads
+ * once the image ends.  The image stream stays empty meanwhile.  Its data
+ * is added in the order the images ended, whichever thread finishes first,
+ * so the output doesn't depend on the timing of the threads.  This is done
+ * as soon as the work at the head of the queue is finished, at the latest
+ * when the stream is written or hashed.
+ */
+
+/*
+ * Each thread has its own semaphore, signalled when it is woken up to take
+ * work from the queue: a gx_semaphore_t doesn't support several waiters.
+ */
+typedef struct pdf_encode_thread_s {
+    pdf_encode_queue_t *queue;
+    gp_thread_id thread;
+    gx_semaphore_t *wake;
+    bool idle;			/* waiting on wake, or about to */
+} pdf_encode_thread_t;
+
+struct pdf_encode_queue_s {
+    gs_memory_t *memory;	/* thread safe */
+    gx_monitor_t *lock;		/* protects the fields below and work->done */
+    gx_semaphore_t *finished;	/* signalled for each work done */
+    psdf_encode_work_t *first;	/* queued, not yet started */
+    psdf_encode_work_t *last;
+    bool stop;
+    int num_threads;
+    pdf_encode_thread_t *threads;
+};
+
+private_st_pdf_encode_pending();
+
+/* The most images waiting for their data, per thread. */
+#define PDF_ENCODE_PENDING_PER_THREAD 2
+
+static void
+pdf_encode_thread(void *data)
+{
+    pdf_encode_thread_t *t = (pdf_encode_thread_t *)data;
+    pdf_encode_queue_t *q = t->queue;
+    bool stop = false;
+
+    while (!stop) {
+        gx_semaphore_wait(t->wake);
+        for (;;) {
+            psdf_encode_work_t *pw;
+            int code;
+
+            gx_monitor_enter(q->lock);
+            pw = q->first;
+            if (pw == NULL) {
+                t->idle = true;
+                stop = q->stop;
+                gx_monitor_leave(q->lock);
+                break;
+            }
+            q->first = pw->next;
+            if (q->first == NULL)
+                q->last = NULL;
+            gx_monitor_leave(q->lock);
+            code = psdf_run_encode_work(pw);
+            gx_monitor_enter(q->lock);
+            pw->status = code;
+            pw->done = true;
+            gx_monitor_leave(q->lock);
+            gx_semaphore_signal(q->finished);
+        }
+    }
+}
+
+static void
+pdf_free_encode_queue(pdf_encode_queue_t *q)
+{
+    gs_memory_t *mem = q->memory;
+    int i;
+
+    if (q->threads) {
+        for (i = 0; i < q->num_threads; i++)
+            gx_semaphore_free(q->threads[i].wake);
+        gs_free_object(mem, q->threads, "pdf_free_encode_queue");
+    }
+    if (q->finished)
+        gx_semaphore_free(q->finished);
+    if (q->lock)
+        gx_monitor_free(q->lock);
+    gs_free_object(mem, q, "pdf_free_encode_queue");
+}
+
+static int
+pdf_start_encode_queue(gx_device_pdf *pdev)
+{
+    gs_memory_t *mem = pdev->memory->thread_safe_memory;
+    pdf_encode_queue_t *q;
+    int i, code = 0;
+
+    q = (pdf_encode_queue_t *)gs_alloc_bytes(mem, sizeof(*q),
+                                             "pdf_start_encode_queue");
+    if (q == NULL)
+        return_error(gs_error_VMerror);
+    memset(q, 0, sizeof(*q));
+    q->memory = mem;
+    q->lock = gx_monitor_label(gx_monitor_alloc(mem), "pdf encode queue");
+    q->finished = gx_semaphore_label(gx_semaphore_alloc(mem),
+                                     "pdf encode finished");
+    q->threads = (pdf_encode_thread_t *)
+        gs_alloc_byte_array(mem, pdev->NumEncodeThreads,
+                            sizeof(pdf_encode_thread_t),
+                            "pdf_start_encode_queue");
+    if (q->lock == NULL || q->finished == NULL || q->threads == NULL) {
+        pdf_free_encode_queue(q);
+        return_error(gs_error_VMerror);
+    }
+    for (i = 0; i < pdev->NumEncodeThreads; i++) {
+        pdf_encode_thread_t *t = &q->threads[i];
+
+        t->queue = q;
+        t->idle = false;
+        t->wake = gx_semaphore_label(gx_semaphore_alloc(mem),
+                                     "pdf encode wake");
+        if (t->wake == NULL) {
+            code = gs_note_error(gs_error_VMerror);
+            break;
+        }
+        /* Let it find the queue empty and go idle. */
+        gx_semaphore_signal(t->wake);
+        code = gp_thread_start(pdf_encode_thread, t, &t->thread);
+        if (code < 0) {
+            gx_semaphore_free(t->wake);
+            break;
+        }
+        gp_thread_label(t->thread, "pdf encode");
+        q->num_threads++;
+    }
+    if (q->num_threads == 0) {
+        /* Probably built without thread support. */
+        pdf_free_encode_queue(q);
+        return code;
+    }
+    pdev->EncodeQueue = q;
+    return 0;
+}
+
+bool
+pdf_can_encode_apart(gx_device_pdf *pdev)
+{
+    if (pdev->NumEncodeThreads <= 0)
+        return false;
+    if (pdev->EncodeQueue == NULL && pdf_start_encode_queue(pdev) < 0) {
+        emprintf(pdev->memory,
+                 "Can't start the image encoding threads, encoding images as they arrive.\n");
+        pdev->NumEncodeThreads = 0;
+        return false;
+    }
+    return true;
+}
+
+/* Wait for a work to be done. */
+static void
+pdf_wait_encode_work(pdf_encode_queue_t *q, psdf_encode_work_t *pw)
+{
+    gx_monitor_enter(q->lock);
+    while (!pw->done) {
+        gx_monitor_leave(q->lock);
+        /* This may be the signal of another work, check again. */
+        gx_semaphore_wait(q->finished);
+        gx_monitor_enter(q->lock);
+    }
+    gx_monitor_leave(q->lock);
+}
+
+static bool
+pdf_encode_work_done(pdf_encode_queue_t *q, psdf_encode_work_t *pw)
+{
+    bool done;
+
+    gx_monitor_enter(q->lock);
+    done = pw->done;
+    gx_monitor_leave(q->lock);
+    return done;
+}
+
+/* Add the compressed data of the oldest pending stream, once it is done. */
+static int
+pdf_retire_encode_work(gx_device_pdf *pdev)
+{
+    pdf_encode_pending_t *pp = pdev->EncodePending;
+    psdf_encode_work_t *pw = pp->work;
+    cos_stream_t *pcs = pp->pcs;
+    int code;
+
+    pdf_wait_encode_work(pdev->EncodeQueue, pw);
+    code = pw->status;
+    if (pcs != NULL) {
+        pcs->encode_pending = NULL;
+        if (code >= 0 && pw->size > 0)
+            code = cos_stream_add_bytes(pdev, pcs, pw->data, pw->size);
+    }
+    pdev->EncodePending = pp->next;
+    pdev->EncodePendingCount--;
+    psdf_free_encode_work(pw);
+    gs_free_object(pdev->pdf_memory, pp, "pdf_retire_encode_work");
+    return code;
+}
+
+int
+pdf_submit_encode_work(gx_device_pdf *pdev, cos_stream_t *pcs,
+                       psdf_encode_work_t *pw)
+{
+    pdf_encode_queue_t *q = pdev->EncodeQueue;
+    pdf_encode_pending_t *pp =
+        gs_alloc_struct(pdev->pdf_memory, pdf_encode_pending_t,
+                        &st_pdf_encode_pending, "pdf_submit_encode_work");
+    pdf_encode_pending_t **ppp;
+    pdf_encode_thread_t *t = NULL;
+    int i, code = 0;
+
+    if (pp == NULL) {
+        psdf_free_encode_work(pw);
+        return_error(gs_error_VMerror);
+    }
+    /*
+     * The data is compressed the same way as long as the filters are set
+     * the same, so we can tell duplicate images apart before having it.
+     */
+    psdf_encode_work_hash(pw, pcs->stream_hash);
+    pcs->stream_md5_valid = 1;
+    pp->next = NULL;
+    pp->pcs = pcs;
+    pp->work = pw;
+    pcs->encode_pending = pp;
+    for (ppp = &pdev->EncodePending; *ppp != NULL; ppp = &(*ppp)->next)
+        DO_NOTHING;
+    *ppp = pp;
+    pdev->EncodePendingCount++;
+
+    pw->next = NULL;
+    gx_monitor_enter(q->lock);
+    if (q->last != NULL)
+        q->last->next = pw;
+    else
+        q->first = pw;
+    q->last = pw;
+    /* Busy threads take it when they are done, otherwise wake one up. */
+    for (i = 0; i < q->num_threads; i++)
+        if (q->threads[i].idle) {
+            t = &q->threads[i];
+            t->idle = false;
+            break;
+        }
+    gx_monitor_leave(q->lock);
+    if (t != NULL)
+        gx_semaphore_signal(t->wake);
+
+    /* Add what is done, and keep the data in memory bounded. */
+    while (code >= 0 && pdev->EncodePending != NULL &&
+           (pdev->EncodePendingCount >
+                q->num_threads * PDF_ENCODE_PENDING_PER_THREAD ||
+            pdf_encode_work_done(q, pdev->EncodePending->work)))
+        code = pdf_retire_encode_work(pdev);
+    return code;
+}
+
+int
+pdf_finish_encode_work(gx_device_pdf *pdev, cos_stream_t *pcs)
+{
+    int code = 0, code1;
+
+    if (pcs != NULL && pcs->encode_pending == NULL)
+        return 0;
+    while (pdev->EncodePending != NULL) {
+        bool last = (pcs != NULL && pdev->EncodePending->pcs == pcs);
+
+        code1 = pdf_retire_encode_work(pdev);
+        if (code >= 0)
+            code = code1;
+        if (last)
+            break;
+    }
+    return code;
+}
+
+void
+pdf_cancel_encode_work(cos_stream_t *pcs)
+{
+    /* The data will be dropped when it is done. */
+    pcs->encode_pending->pcs = NULL;
+    pcs->encode_pending = NULL;
+}
+
+int
+pdf_close_encode_queue(gx_device_pdf *pdev)
+{
+    pdf_encode_queue_t *q = pdev->EncodeQueue;
+    int i, code;
+
+    if (q == NULL)
+        return 0;
+    code = pdf_finish_encode_work(pdev, NULL);
+    /* Each thread stops when it finds nothing more to do. */
+    gx_monitor_enter(q->lock);
+    q->stop = true;
+    gx_monitor_leave(q->lock);
+    for (i = 0; i < q->num_threads; i++)
+        gx_semaphore_signal(q->threads[i].wake);
+    for (i = 0; i < q->num_threads; i++)
+        gp_thread_finish(q->threads[i].thread);
+    pdf_free_encode_queue(q);
+    pdev->EncodeQueue = NULL;
+    return code;
+}
@@ -993,6 +993,8 @@ none_to_stream(gx_device_pdf * pdev)
             es->procs.process = templat->process;
             es->strm = s;
             (*templat->set_defaults) ((stream_state *) st);
+            psdf_set_flate_params((gx_device_psdf *)pdev, templat,
+                                  (stream_state *) st);
             (*templat->init) ((stream_state *) st);
             pdev->strm = s = es;
         }
@@ -2257,6 +2259,77 @@ pdf_write_value(const gx_device_pdf * pdev, const byte * vstr, uint size, gs_id
     return 0;
 }
 
+/* Record the decoding filter and parameters for an encoding filter. */
+static int
+pdf_put_filter(gx_device_pdf *pdev, const stream_state *st,
+               const pdf_filter_names_t *pfn, const char **pfilter_name,
+               bool *pbinary_ok, cos_dict_t **pdecode_parms)
+{
+    const stream_template *templat = st->templat;
+    int code;
+
+#define TEMPLATE_IS(atemp)\
+  (templat->process == (atemp).process)
+    if (TEMPLATE_IS(s_A85E_template))
+        *pbinary_ok = false;
+    else if (TEMPLATE_IS(s_CFE_template)) {
+        cos_param_list_writer_t writer;
+        stream_CF_state cfs;
+
+        *pdecode_parms =
+            cos_dict_alloc(pdev, "pdf_put_image_filters(decode_parms)");
+        if (*pdecode_parms == 0)
+            return_error(gs_error_VMerror);
+        CHECK(cos_param_list_writer_init(pdev, &writer, *pdecode_parms, 0));
+        /*
+         * If EndOfBlock is true, we mustn't write a Rows value.
+         * This is a hack....
+         */
+        cfs = *(const stream_CF_state *)st;
+        if (cfs.EndOfBlock)
+            cfs.Rows = 0;
+        CHECK(s_CF_get_params((gs_param_list *)&writer, &cfs, false));
+        *pfilter_name = pfn->CCITTFaxDecode;
+    } else if (TEMPLATE_IS(s_DCTE_template))
+        *pfilter_name = pfn->DCTDecode;
+    else if (TEMPLATE_IS(s_zlibE_template))
+        *pfilter_name = pfn->FlateDecode;
+    else if (TEMPLATE_IS(s_LZWE_template))
+        *pfilter_name = pfn->LZWDecode;
+#ifdef USE_LDF_JB2
+    else if (TEMPLATE_IS(s_jbig2encode_template))
+        *pfilter_name = pfn->JBIG2Decode;
+#endif
+#ifdef USE_LWF_JP2
+    else if (TEMPLATE_IS(s_jpxe_template))
+        *pfilter_name = pfn->JPXDecode;
+#endif
+    else if (TEMPLATE_IS(s_PNGPE_template)) {
+        /* This is a predictor for FlateDecode or LZWEncode. */
+        const stream_PNGP_state *const ss =
+            (const stream_PNGP_state *)st;
+
+        *pdecode_parms =
+            cos_dict_alloc(pdev, "pdf_put_image_filters(decode_parms)");
+        if (*pdecode_parms == 0)
+            return_error(gs_error_VMerror);
+        CHECK(cos_dict_put_c_key_int(*pdecode_parms, "/Predictor",
+                                     ss->Predictor));
+        CHECK(cos_dict_put_c_key_int(*pdecode_parms, "/Columns",
+                                     ss->Columns));
+        if (ss->Colors != 1)
+            CHECK(cos_dict_put_c_key_int(*pdecode_parms, "/Colors",
+                                         ss->Colors));
+        if (ss->BitsPerComponent != 8)
+            CHECK(cos_dict_put_c_key_int(*pdecode_parms,
+                                         "/BitsPerComponent",
+                                         ss->BitsPerComponent));
+    } else if (TEMPLATE_IS(s_RLE_template))
+        *pfilter_name = pfn->RunLengthDecode;
+#undef TEMPLATE_IS
+    return 0;
+}
+
 /* Store filters for a stream. */
 /* Currently this only saves parameters for CCITTFaxDecode. */
 int
@@ -2270,68 +2343,18 @@ pdf_put_filters(cos_dict_t *pcd, gx_device_pdf *pdev, stream *s,
     int code;
 
     for (; fs != 0; fs = fs->strm) {
-        const stream_state *st = fs->state;
-        const stream_template *templat = st->templat;
+        const psdf_encode_work_t *pw = psdf_encode_work_from_stream(fs);
 
-#define TEMPLATE_IS(atemp)\
-  (templat->process == (atemp).process)
-        if (TEMPLATE_IS(s_A85E_template))
-            binary_ok = false;
-        else if (TEMPLATE_IS(s_CFE_template)) {
-            cos_param_list_writer_t writer;
-            stream_CF_state cfs;
-
-            decode_parms =
-                cos_dict_alloc(pdev, "pdf_put_image_filters(decode_parms)");
-            if (decode_parms == 0)
-                return_error(gs_error_VMerror);
-            CHECK(cos_param_list_writer_init(pdev, &writer, decode_parms, 0));
-            /*
-             * If EndOfBlock is true, we mustn't write a Rows value.
-             * This is a hack....
-             */
-            cfs = *(const stream_CF_state *)st;
-            if (cfs.EndOfBlock)
-                cfs.Rows = 0;
-            CHECK(s_CF_get_params((gs_param_list *)&writer, &cfs, false));
-            filter_name = pfn->CCITTFaxDecode;
-        } else if (TEMPLATE_IS(s_DCTE_template))
-            filter_name = pfn->DCTDecode;
-        else if (TEMPLATE_IS(s_zlibE_template))
-            filter_name = pfn->FlateDecode;
-        else if (TEMPLATE_IS(s_LZWE_template))
-            filter_name = pfn->LZWDecode;
-#ifdef USE_LDF_JB2
-        else if (TEMPLATE_IS(s_jbig2encode_template))
-            filter_name = pfn->JBIG2Decode;
-#endif
-#ifdef USE_LWF_JP2
-        else if (TEMPLATE_IS(s_jpxe_template))
-            filter_name = pfn->JPXDecode;
-#endif
-        else if (TEMPLATE_IS(s_PNGPE_template)) {
-            /* This is a predictor for FlateDecode or LZWEncode. */
-            const stream_PNGP_state *const ss =
-                (const stream_PNGP_state *)st;
-
-            decode_parms =
-                cos_dict_alloc(pdev, "pdf_put_image_filters(decode_parms)");
-            if (decode_parms == 0)
-                return_error(gs_error_VMerror);
-            CHECK(cos_dict_put_c_key_int(decode_parms, "/Predictor",
-                                         ss->Predictor));
-            CHECK(cos_dict_put_c_key_int(decode_parms, "/Columns",
-                                         ss->Columns));
-            if (ss->Colors != 1)
-                CHECK(cos_dict_put_c_key_int(decode_parms, "/Colors",
-                                             ss->Colors));
-            if (ss->BitsPerComponent != 8)
-                CHECK(cos_dict_put_c_key_int(decode_parms,
-                                             "/BitsPerComponent",
-                                             ss->BitsPerComponent));
-        } else if (TEMPLATE_IS(s_RLE_template))
-            filter_name = pfn->RunLengthDecode;
-#undef TEMPLATE_IS
+        if (pw != NULL) {
+            /* The filters which will compress the data kept by fs. */
+            int i;
+
+            for (i = 0; i < pw->num_stages; i++)
+                CHECK(pdf_put_filter(pdev, pw->state[i], pfn, &filter_name,
+                                     &binary_ok, &decode_parms));
+        } else
+            CHECK(pdf_put_filter(pdev, fs->state, pfn, &filter_name,
+                                 &binary_ok, &decode_parms));
     }
     if (filter_name) {
         if (binary_ok) {
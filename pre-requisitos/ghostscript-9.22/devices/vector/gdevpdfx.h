@@ -268,6 +268,23 @@ struct pdf_article_s {
     "pdf_article_t", pdf_article_enum_ptrs, pdf_article_reloc_ptrs,\
     next, contents)
 
+/*
+ * Image streams whose data is being compressed by the encoding threads,
+ * in the order the images ended.  See gdevpdfq.c.
+ */
+typedef struct pdf_encode_queue_s pdf_encode_queue_t;
+typedef struct pdf_encode_pending_s pdf_encode_pending_t;
+struct pdf_encode_pending_s {
+    pdf_encode_pending_t *next;
+    cos_stream_t *pcs;		/* 0 if the stream has been released */
+    psdf_encode_work_t *work;	/* not enumerated, not in GC'd memory */
+};
+
+#define private_st_pdf_encode_pending()\
+  gs_private_st_ptrs2(st_pdf_encode_pending, pdf_encode_pending_t,\
+    "pdf_encode_pending_t", pdf_encode_pending_enum_ptrs,\
+    pdf_encode_pending_reloc_ptrs, next, pcs)
+
 /* ---------------- The device structure ---------------- */
 
 /* Resource lists */
@@ -601,6 +618,8 @@ struct gx_device_pdf_s {
                               a bitmap representation of a shading.
                               (Bigger shadings to be downsampled). */
     long MaxInlineImageSize;
+    long MaxTempMemorySize;   /* Keep the temporary files in memory up to
+                                 this many bytes in total, 0 = on disk. */
     /* Encryption parameters */
     gs_param_string OwnerPassword;
     gs_param_string UserPassword;
@@ -848,6 +867,8 @@ struct gx_device_pdf_s {
     bool PreserveDeviceN;
     int PDFACompatibilityPolicy;
     bool DetectDuplicateImages;
+    bool DetectDuplicateFonts;      /* Merge the same font embedded by several
+                                     * input files, see pdf_find_font_resource. */
     bool AllowIncrementalCFF;
     bool WantsToUnicode;
     bool WantsPageLabels;
@@ -889,6 +910,24 @@ struct gx_device_pdf_s {
                                      * after the form is processed. The name will be used to create a
                                      * local named object which pdfmark can reference.
                                      */
+    bool PassThroughJPEGImages;     /* If true, write the data of DCTDecode images unchanged
+                                     * instead of decoding and encoding it again.
+                                     */
+    bool JPEG_PassThrough;          /* A DCTDecode filter will pass its data to us, see
+                                     * gxdso_JPEG_passthrough_query.
+                                     */
+    void *PassThroughOwner;         /* The filter which began passing data, only compared
+                                     * with the one sending gxdso_JPEG_passthrough_end,
+                                     * so it isn't enumerated for the GC.
+                                     */
+    stream *PassThroughWriter;      /* The stream receiving the passed through data. */
+    byte PassThroughTail[2];        /* The last 2 bytes passed, to check the EOI marker. */
+    int NumEncodeThreads;           /* Threads compressing image data once an image ends,
+                                     * 0 to compress it as it arrives.
+                                     */
+    pdf_encode_queue_t *EncodeQueue; /* The encoding threads and their work, not in GC'd memory. */
+    pdf_encode_pending_t *EncodePending; /* Image streams waiting for their data, oldest first. */
+    int EncodePendingCount;
 };
 
 #define is_in_page(pdev)\
@@ -922,8 +961,10 @@ struct gx_device_pdf_s {
  m(38, outline_levels)
  m(39, gx_device_pdf, EmbeddedFiles);
  m(40, gx_device_pdf, pdf_font_dir);
- m(41, gx_device_pdf, Extension_Metadata);*/
-#define gx_device_pdf_num_ptrs 42
+ m(41, gx_device_pdf, Extension_Metadata);
+ m(42, gx_device_pdf, PassThroughWriter);
+ m(43, gx_device_pdf, EncodePending);*/
+#define gx_device_pdf_num_ptrs 44
 #define gx_device_pdf_do_param_strings(m)\
     m(0, OwnerPassword) m(1, UserPassword) m(2, NoEncrypt)\
     m(3, DocumentUUID) m(4, InstanceUUID)
@@ -1331,6 +1372,33 @@ int free_function_refs(gx_device_pdf *pdev, cos_object_t *pco);
 int pdf_write_font_bbox(gx_device_pdf *pdev, const gs_int_rect *pbox);
 int pdf_write_font_bbox_float(gx_device_pdf *pdev, const gs_rect *pbox);
 
+/* ---------------- Exported by gdevpdfq.c ---------------- */
+
+/*
+ * Return true if the data of an image may be compressed by an encoding
+ * thread, starting the threads if needed.
+ */
+bool pdf_can_encode_apart(gx_device_pdf *pdev);
+
+/*
+ * Queue the compression of an image's data, which has been captured by
+ * pw, for the stream pcs.
+ */
+int pdf_submit_encode_work(gx_device_pdf *pdev, cos_stream_t *pcs,
+                           psdf_encode_work_t *pw);
+
+/*
+ * Wait for the compressed data of pcs, and of all the streams queued
+ * before it, and add it to the streams.  pcs = 0 means all of them.
+ */
+int pdf_finish_encode_work(gx_device_pdf *pdev, cos_stream_t *pcs);
+
+/* Forget a stream which is released while waiting for its data. */
+void pdf_cancel_encode_work(cos_stream_t *pcs);
+
+/* Finish all the queued work and stop the encoding threads. */
+int pdf_close_encode_queue(gx_device_pdf *pdev);
+
 /* ---------------- Exported by gdevpdfm.c ---------------- */
 
 /*
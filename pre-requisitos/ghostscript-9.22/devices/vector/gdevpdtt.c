@@ -1157,7 +1157,14 @@ pdf_find_font_resource(gx_device_pdf *pdev, gs_font *font,
             int code;
 
             cfont = (gs_font_base *)font;
-            if (uid_is_XUID(&cfont->UID)){
+            /*
+             * The PDF interpreter makes this XUID from the input file name
+             * and the font object, so that only the same font object is
+             * merged.  With DetectDuplicateFonts the glyphs of a font from
+             * another object or input file are compared below instead,
+             * and the font is written once if they match.
+             */
+            if (uid_is_XUID(&cfont->UID) && !pdev->DetectDuplicateFonts){
                 int size = uid_XUID_size(&cfont->UID);
                 long *xvalues = uid_XUID_values(&cfont->UID);
                 if (xvalues && size >= 2 && xvalues[0] == 1000000) {
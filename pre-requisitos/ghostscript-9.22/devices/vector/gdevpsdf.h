@@ -107,6 +107,8 @@ typedef struct psdf_distiller_params_s {
     int OPM;
     bool PreserveOPIComments;
     bool UseFlateCompression;
+    int FlateLevel;		/* zlib level 0-9, -1 = zlib default */
+    int FlateStrategy;		/* zlib strategy, 0 = default */
 
     /* Color processing parameters */
 
@@ -197,6 +199,8 @@ extern const stream_template s_zlibE_template;
     1,		    /* Overprintmode (OPM) */ \
     0,		    /* PreserveOPIComments (false) */ \
     1,		    /* UseFlateCompression (true) */ \
+    -1,		    /* FlateLevel (zlib default) */ \
+    0,		    /* FlateStrategy (zlib default) */ \
         /* Color processing parameters */\
     {0},	    /* calCMYKProfile */ \
     {0},	    /* CalGrayProfile */ \
@@ -370,6 +374,33 @@ int psdf_closepath(gx_device_vector * vdev, double x0, double y0,
 
 /* ---------------- Binary (image) data procedures ---------------- */
 
+/*
+ * Define the structure for encoding image data apart from its pipeline.
+ * When a binary writer has one, setting up the image compression collects
+ * the compression filters here instead of adding them to the pipeline,
+ * which then ends with a filter keeping the data to compress in memory.
+ * psdf_run_encode_work compresses it afterwards, possibly on another
+ * thread: it only uses the allocator of the work, which is private to it
+ * and gets its memory from a thread safe allocator.
+ */
+#define psdf_encode_work_max_stages 3
+typedef struct psdf_encode_work_s psdf_encode_work_t;
+struct psdf_encode_work_s {
+    gs_memory_t *memory;	/* allocator for everything below */
+    int num_stages;
+    const stream_template *templat[psdf_encode_work_max_stages];
+    stream_state *state[psdf_encode_work_max_stages]; /* as added, last is first to run */
+    bool collecting;		/* setting up the compression */
+    bool captured;		/* the pipeline ends in the capture filter */
+    bool claimed;		/* the capture filter mustn't free it */
+    byte *data;			/* data to compress, then compressed data */
+    uint size;
+    uint capacity;
+    int status;			/* result of psdf_run_encode_work */
+    bool done;
+    psdf_encode_work_t *next;	/* for the client's queue */
+};
+
 /* Define the structure for writing binary data. */
 typedef struct psdf_binary_writer_s {
     gs_memory_t *memory;
@@ -381,6 +412,7 @@ typedef struct psdf_binary_writer_s {
      * Keeping the old structure until we have time
      * for this optimization.
      */
+    psdf_encode_work_t *encode_work; /* not enumerated, not in GC'd memory */
 } psdf_binary_writer;
 extern_st(st_psdf_binary_writer);
 #define public_st_psdf_binary_writer() /* in gdevpsdu.c */\
@@ -397,6 +429,11 @@ int psdf_begin_binary(gx_device_psdf * pdev, psdf_binary_writer * pbw);
 int psdf_encode_binary(psdf_binary_writer * pbw,
                        const stream_template * template, stream_state * ss);
 
+/* Apply FlateLevel and FlateStrategy to the state of a FlateEncode filter, */
+/* after its set_defaults and before its init. */
+void psdf_set_flate_params(const gx_device_psdf * pdev,
+                           const stream_template * template, stream_state * ss);
+
 /* Add a 2-D CCITTFax encoding filter. */
 /* Set EndOfBlock iff the stream is not ASCII85 encoded. */
 int psdf_CFE_binary(psdf_binary_writer * pbw, int w, int h, bool invert);
@@ -430,6 +467,10 @@ int new_setup_image_filters(gx_device_psdf *pdev, psdf_binary_writer *pbw,
                              const gs_gstate * pgs, bool lossless,
                              bool in_line, bool colour_conversion);
 
+bool psdf_is_DCT_pass_through_image(const gx_device_psdf *pdev,
+                                    const gs_pixel_image_t *pim,
+                                    const gs_matrix *pctm);
+
 /* Set up compression filters for a lossless image, with no downsampling, */
 /* no color space conversion, and only lossless filters. */
 /* Note that this may modify the image parameters. */
@@ -445,6 +486,34 @@ int new_resize_input(psdf_binary_writer *pbw, int width, int num_comps, int bpc_
 /* Finish writing binary data. */
 int psdf_end_binary(psdf_binary_writer * pbw);
 
+/* Allocate and free the work for encoding image data apart. */
+int psdf_alloc_encode_work(gx_device_psdf *pdev, psdf_encode_work_t **ppw);
+void psdf_free_encode_work(psdf_encode_work_t *pw);
+
+/* End the pipeline of pbw with the filter keeping the data for pw. */
+int psdf_capture_encode_work(psdf_binary_writer *pbw, psdf_encode_work_t *pw);
+
+/* Return the work kept by a stream, or NULL if it isn't a capture filter. */
+psdf_encode_work_t *psdf_encode_work_from_stream(const stream *s);
+
+/*
+ * Return the template of the first filter which will see the data written
+ * on s, looking into the work kept by a capture filter.
+ */
+const stream_template *psdf_stream_encoder_template(const stream *s);
+
+/*
+ * Compress the data of a work, replacing it with the result, and release
+ * the filter states.  This may be called on any thread.
+ */
+int psdf_run_encode_work(psdf_encode_work_t *pw);
+
+/*
+ * Compute an MD5 hash identifying the compressed data of a work before
+ * it is run: the data to compress and the settings of lossy filters.
+ */
+void psdf_encode_work_hash(const psdf_encode_work_t *pw, byte hash[16]);
+
 /* Set up image compression chooser. */
 int psdf_setup_compression_chooser(psdf_binary_writer *pbw,
                                    gx_device_psdf *pdev,
@@ -227,12 +227,15 @@ error:
 
 /* Add the appropriate image compression filter, if any. */
 static int
-setup_image_compression(psdf_binary_writer *pbw, const psdf_image_params *pdip,
-                        const gs_pixel_image_t * pim, const gs_gstate * pgs,
-                        bool lossless)
+setup_image_compression_filter(psdf_binary_writer *pbw,
+                               const psdf_image_params *pdip,
+                               const gs_pixel_image_t * pim,
+                               const gs_gstate * pgs, bool lossless)
 {
     gx_device_psdf *pdev = pbw->dev;
-    gs_memory_t *mem = pdev->v_memory;
+    gs_memory_t *mem = (pbw->encode_work != NULL &&
+                        pbw->encode_work->collecting ?
+                        pbw->encode_work->memory : pdev->v_memory);
     const stream_template *templat = pdip->filter_template;
     const stream_template *lossless_template =
         (pdev->params.UseFlateCompression &&
@@ -397,6 +400,28 @@ setup_image_compression(psdf_binary_writer *pbw, const psdf_image_params *pdip,
     return code;
 }
 
+/*
+ * Add the image compression filter, or collect it in the encode work of
+ * the writer, ending the pipeline with the filter keeping the data for it.
+ */
+static int
+setup_image_compression(psdf_binary_writer *pbw, const psdf_image_params *pdip,
+                        const gs_pixel_image_t * pim, const gs_gstate * pgs,
+                        bool lossless)
+{
+    psdf_encode_work_t *pw = pbw->encode_work;
+    int code;
+
+    if (pw == NULL || pw->captured)
+        return setup_image_compression_filter(pbw, pdip, pim, pgs, lossless);
+    pw->collecting = true;
+    code = setup_image_compression_filter(pbw, pdip, pim, pgs, lossless);
+    pw->collecting = false;
+    if (code >= 0 && pw->num_stages > 0)
+        code = psdf_capture_encode_work(pbw, pw);
+    return code;
+}
+
 /* Determine whether an image should be downsampled. */
 static bool
 do_downsample(const psdf_image_params *pdip, const gs_pixel_image_t *pim,
@@ -876,6 +901,73 @@ psdf_setup_image_colors_filter(psdf_binary_writer *pbw,
     return 0;
 }
 
+/*
+ * Compute the resolution of an image, -1 if there is no CTM:
+ *    W / (W * ImageMatrix^-1 * CTM / HWResolution).
+ * We can replace W by 1 to simplify the computation.
+ */
+static int
+image_resolution(const gx_device_psdf * pdev, const gs_pixel_image_t * pim,
+                 const gs_matrix * pctm, double *presolution)
+{
+    gs_point pt;
+    double resolution, resolutiony;
+    int code;
+
+    if (pctm == 0) {
+        *presolution = -1;
+        return 0;
+    }
+    /* We could do both X and Y, but why bother? */
+    code = gs_distance_transform_inverse(1.0, 0.0, &pim->ImageMatrix, &pt);
+    if (code < 0)
+        return code;
+    gs_distance_transform(pt.x, pt.y, pctm, &pt);
+    resolution = 1.0 / hypot(pt.x / pdev->HWResolution[0],
+                             pt.y / pdev->HWResolution[1]);
+
+    /* Actually we must do both X and Y, in case the image is ananmorphically scaled
+     * and one axis is not high enough resolution to be downsampled.
+     * Bug #696152
+     */
+    code = gs_distance_transform_inverse(0.0, 1.0, &pim->ImageMatrix, &pt);
+    if (code < 0)
+        return code;
+    gs_distance_transform(pt.x, pt.y, pctm, &pt);
+    resolutiony = 1.0 / hypot(pt.x / pdev->HWResolution[0],
+                              pt.y / pdev->HWResolution[1]);
+    *presolution = min(resolution, resolutiony);
+    return 0;
+}
+
+/*
+ * Determine whether new_setup_image_filters would write an 8-bit
+ * continuous tone image with DCTEncode at its own resolution, so that
+ * DCTDecode data can be written unchanged instead.
+ */
+bool
+psdf_is_DCT_pass_through_image(const gx_device_psdf * pdev,
+                               const gs_pixel_image_t * pim,
+                               const gs_matrix * pctm)
+{
+    const psdf_image_params *pdip;
+    int ncomp;
+    double resolution;
+
+    if (pim->ColorSpace == NULL || pim->BitsPerComponent != 8 ||
+        gs_color_space_get_index(pim->ColorSpace) == gs_color_space_index_Indexed)
+        return false;
+    ncomp = gs_color_space_num_components(pim->ColorSpace);
+    pdip = (ncomp == 1 ? &pdev->params.GrayImage : &pdev->params.ColorImage);
+    if (!pdip->Encode)
+        return false;
+    if (!pdip->AutoFilter && pdip->filter_template != &s_DCTE_template)
+        return false;
+    if (image_resolution(pdev, pim, pctm, &resolution) < 0)
+        return false;
+    return !do_downsample(pdip, pim, resolution);
+}
+
 /* Set up compression and downsampling filters for an image. */
 /* Note that this may modify the image parameters. */
 int
@@ -897,7 +989,7 @@ new_setup_image_filters(gx_device_psdf * pdev, psdf_binary_writer * pbw,
     int bpc = pim->BitsPerComponent;
     int bpc_out = pim->BitsPerComponent = min(bpc, 8);
     int ncomp;
-    double resolution, resolutiony;
+    double resolution;
 
     /*
      * The Adobe documentation doesn't say this, but mask images are
@@ -931,37 +1023,9 @@ new_setup_image_filters(gx_device_psdf * pdev, psdf_binary_writer * pbw,
         }
     }
 
-    /*
-     * We can compute the image resolution by:
-     *    W / (W * ImageMatrix^-1 * CTM / HWResolution).
-     * We can replace W by 1 to simplify the computation.
-     */
-    if (pctm == 0)
-        resolution = -1;
-    else {
-        gs_point pt;
-
-        /* We could do both X and Y, but why bother? */
-        code = gs_distance_transform_inverse(1.0, 0.0, &pim->ImageMatrix, &pt);
-        if (code < 0)
-            return code;
-        gs_distance_transform(pt.x, pt.y, pctm, &pt);
-        resolution = 1.0 / hypot(pt.x / pdev->HWResolution[0],
-                                 pt.y / pdev->HWResolution[1]);
-
-        /* Actually we must do both X and Y, in case the image is ananmorphically scaled
-         * and one axis is not high enough resolution to be downsampled.
-         * Bug #696152
-         */
-        code = gs_distance_transform_inverse(0.0, 1.0, &pim->ImageMatrix, &pt);
-        if (code < 0)
-            return code;
-        gs_distance_transform(pt.x, pt.y, pctm, &pt);
-        resolutiony = 1.0 / hypot(pt.x / pdev->HWResolution[0],
-                                 pt.y / pdev->HWResolution[1]);
-        if (resolutiony < resolution)
-            resolution = resolutiony;
-    }
+    code = image_resolution(pdev, pim, pctm, &resolution);
+    if (code < 0)
+        return code;
     if (ncomp == 1 && pim->ColorSpace && pim->ColorSpace->type->index != gs_color_space_index_Indexed) {
         /* Monochrome, gray, or mask */
         /* Check for downsampling. */
@@ -242,6 +242,8 @@ static const gs_param_item_t psdf_param_items[] = {
     /* (TransferFunctionInfo) */
     /* (UCRandBGInfo) */
     pi("UseFlateCompression", gs_param_type_bool, UseFlateCompression),
+    pi("FlateLevel", gs_param_type_int, FlateLevel),
+    pi("FlateStrategy", gs_param_type_int, FlateStrategy),
 
     /* Color image processing parameters */
 
@@ -1100,6 +1102,17 @@ gdev_psdf_put_params(gx_device * dev, gs_param_list * plist)
                       UCRandBGInfo_names, &ecode);
     ecode = param_put_bool(plist, "UseFlateCompression",
                            &params.UseFlateCompression, ecode);
+    if (params.FlateLevel < -1 || params.FlateLevel > 9) {
+        params.FlateLevel = pdev->params.FlateLevel;
+        ecode = gs_note_error(gs_error_rangecheck);
+        param_signal_error(plist, "FlateLevel", ecode);
+    }
+    /* Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE, Z_FIXED */
+    if (params.FlateStrategy < 0 || params.FlateStrategy > 4) {
+        params.FlateStrategy = pdev->params.FlateStrategy;
+        ecode = gs_note_error(gs_error_rangecheck);
+        param_signal_error(plist, "FlateStrategy", ecode);
+    }
 
     /* Color sampled image parameters */
 
@@ -24,11 +24,14 @@
 #include "strimpl.h"
 #include "sa85x.h"
 #include "scfx.h"
+#include "szlibx.h"
 #include "sdct.h"
 #include "sjpeg.h"
 #include "spprint.h"
 #include "gsovrc.h"
 #include "gsicc_cache.h"
+#include "gsmchunk.h"
+#include "gsmd5.h"
 
 /* Structure descriptors */
 public_st_device_psdf();
@@ -318,6 +321,7 @@ psdf_begin_binary(gx_device_psdf * pdev, psdf_binary_writer * pbw)
     pbw->target = pdev->strm;
     pbw->dev = pdev;
     pbw->strm = 0;		/* for GC in case of failure */
+    pbw->encode_work = 0;
     /* If not binary, set up the encoding stream. */
     if (!pdev->binary_ok) {
 #define BUF_SIZE 100		/* arbitrary */
@@ -349,10 +353,38 @@ int
 psdf_encode_binary(psdf_binary_writer * pbw, const stream_template * templat,
                    stream_state * ss)
 {
+    psdf_encode_work_t *pw = pbw->encode_work;
+
+    if (pbw->dev != NULL)
+        psdf_set_flate_params(pbw->dev, templat, ss);
+    if (pw != NULL && pw->collecting) {
+        /* Keep the filter for psdf_run_encode_work. */
+        if (pw->num_stages == psdf_encode_work_max_stages)
+            return_error(gs_error_limitcheck);
+        ss->templat = templat;
+        ss->memory = pw->memory;
+        if (templat->init && (*templat->init)(ss) < 0)
+            return_error(gs_error_ioerror);
+        pw->templat[pw->num_stages] = templat;
+        pw->state[pw->num_stages++] = ss;
+        return 0;
+    }
     return (s_add_filter(&pbw->strm, templat, ss, pbw->memory) == 0 ?
             gs_note_error(gs_error_VMerror) : 0);
 }
 
+void
+psdf_set_flate_params(const gx_device_psdf * pdev,
+                      const stream_template * templat, stream_state * ss)
+{
+    stream_zlib_state *const zs = (stream_zlib_state *)ss;
+
+    if (templat != &s_zlibE_template || ss == NULL)
+        return;
+    zs->level = pdev->params.FlateLevel;
+    zs->strategy = pdev->params.FlateStrategy;
+}
+
 /*
  * Acquire parameters, and optionally set up the filter for, a DCTEncode
  * filter.  This is a separate procedure so it can be used to validate
@@ -463,6 +495,230 @@ psdf_end_binary(psdf_binary_writer * pbw)
     return (status >= 0 ? 0 : gs_note_error(gs_error_ioerror));
 }
 
+/* ---------------- Encoding image data apart ---------------- */
+
+/* The filter ending a pipeline whose compression is done apart. */
+typedef struct stream_capture_state_s {
+    stream_state_common;
+    psdf_encode_work_t *work;	/* not enumerated */
+} stream_capture_state;
+gs_private_st_simple(st_capture_state, stream_capture_state,
+                     "stream_capture_state");
+
+static int
+s_capture_process(stream_state * st, stream_cursor_read * pr,
+                  stream_cursor_write * ignore_pw, bool last)
+{
+    psdf_encode_work_t *pw = ((stream_capture_state *)st)->work;
+    uint count = pr->limit - pr->ptr;
+
+    if (count > pw->capacity - pw->size) {
+        uint capacity = max(pw->capacity, 65536);
+        byte *data;
+
+        while (capacity - pw->size < count) {
+            if (capacity > max_uint / 2)
+                return ERRC;
+            capacity *= 2;
+        }
+        if (pw->data == NULL)
+            data = gs_alloc_bytes(pw->memory, capacity, "s_capture_process");
+        else
+            data = gs_resize_object(pw->memory, pw->data, capacity,
+                                    "s_capture_process");
+        if (data == NULL)
+            return ERRC;
+        pw->data = data;
+        pw->capacity = capacity;
+    }
+    memcpy(pw->data + pw->size, pr->ptr + 1, count);
+    pw->size += count;
+    pr->ptr = pr->limit;
+    return 0;
+}
+
+static void
+s_capture_release(stream_state * st)
+{
+    psdf_encode_work_t *pw = ((stream_capture_state *)st)->work;
+
+    if (pw != NULL && !pw->claimed)
+        psdf_free_encode_work(pw);
+}
+
+static const stream_template s_capture_template = {
+    &st_capture_state, NULL, s_capture_process, 1, 1, s_capture_release
+};
+
+int
+psdf_alloc_encode_work(gx_device_psdf *pdev, psdf_encode_work_t **ppw)
+{
+    gs_memory_t *mem;
+    psdf_encode_work_t *pw;
+    int code = gs_memory_chunk_wrap(&mem, pdev->memory->thread_safe_memory);
+
+    if (code < 0)
+        return code;
+    pw = (psdf_encode_work_t *)gs_alloc_bytes(mem, sizeof(*pw),
+                                              "psdf_alloc_encode_work");
+    if (pw == NULL) {
+        gs_memory_chunk_release(mem);
+        return_error(gs_error_VMerror);
+    }
+    memset(pw, 0, sizeof(*pw));
+    pw->memory = mem;
+    *ppw = pw;
+    return 0;
+}
+
+static void
+psdf_release_encode_stages(psdf_encode_work_t *pw)
+{
+    while (pw->num_stages > 0) {
+        stream_state *st = pw->state[--pw->num_stages];
+
+        if (pw->templat[pw->num_stages]->release)
+            (*pw->templat[pw->num_stages]->release)(st);
+        gs_free_object(pw->memory, st, "psdf_release_encode_stages");
+    }
+}
+
+void
+psdf_free_encode_work(psdf_encode_work_t *pw)
+{
+    psdf_release_encode_stages(pw);
+    /* This frees the data and pw itself. */
+    gs_memory_chunk_release(pw->memory);
+}
+
+int
+psdf_capture_encode_work(psdf_binary_writer *pbw, psdf_encode_work_t *pw)
+{
+    gs_memory_t *mem = pbw->dev->v_memory;
+    stream_capture_state *ss = (stream_capture_state *)
+        s_alloc_state(mem, s_capture_template.stype,
+                      "psdf_capture_encode_work");
+
+    if (ss == 0)
+        return_error(gs_error_VMerror);
+    ss->templat = &s_capture_template;
+    ss->work = pw;
+    if (s_add_filter(&pbw->strm, &s_capture_template, (stream_state *)ss,
+                     mem) == 0) {
+        gs_free_object(mem, ss, "psdf_capture_encode_work");
+        return_error(gs_error_VMerror);
+    }
+    pw->captured = true;
+    return 0;
+}
+
+psdf_encode_work_t *
+psdf_encode_work_from_stream(const stream *s)
+{
+    if (s->state == NULL || s->state->templat != &s_capture_template)
+        return NULL;
+    return ((const stream_capture_state *)s->state)->work;
+}
+
+const stream_template *
+psdf_stream_encoder_template(const stream *s)
+{
+    const psdf_encode_work_t *pw = psdf_encode_work_from_stream(s);
+
+    if (pw != NULL && pw->num_stages > 0)
+        return pw->templat[pw->num_stages - 1];
+    return s->state->templat;
+}
+
+/* Run one filter over the whole data of a work. */
+static int
+psdf_run_encode_stage(psdf_encode_work_t *pw, int i)
+{
+    const stream_template *templat = pw->templat[i];
+    uint capacity = max(pw->size / 2, 4096) + templat->min_out_size;
+    uint size = 0;
+    byte *out = gs_alloc_bytes(pw->memory, capacity, "psdf_run_encode_stage");
+    stream_cursor_read r;
+    stream_cursor_write w;
+    int status;
+
+    if (out == NULL)
+        return_error(gs_error_VMerror);
+    r.ptr = pw->data - 1;
+    r.limit = pw->data + pw->size - 1;
+    for (;;) {
+        byte *bigger;
+
+        w.ptr = out + size - 1;
+        w.limit = out + capacity - 1;
+        status = (*templat->process)(pw->state[i], &r, &w, true);
+        size = w.ptr + 1 - out;
+        if (status != 1)
+            break;
+        /* Output full, make more room. */
+        if (capacity > max_uint / 2) {
+            status = ERRC;
+            break;
+        }
+        bigger = gs_resize_object(pw->memory, out, capacity * 2,
+                                  "psdf_run_encode_stage");
+        if (bigger == NULL) {
+            status = ERRC;
+            break;
+        }
+        out = bigger;
+        capacity *= 2;
+    }
+    if (status < 0 && status != EOFC) {
+        gs_free_object(pw->memory, out, "psdf_run_encode_stage");
+        return_error(gs_error_ioerror);
+    }
+    gs_free_object(pw->memory, pw->data, "psdf_run_encode_stage");
+    pw->data = out;
+    pw->size = size;
+    pw->capacity = capacity;
+    return 0;
+}
+
+int
+psdf_run_encode_work(psdf_encode_work_t *pw)
+{
+    int i, code = 0;
+
+    for (i = pw->num_stages - 1; i >= 0 && code >= 0; i--)
+        code = psdf_run_encode_stage(pw, i);
+    psdf_release_encode_stages(pw);
+    return code;
+}
+
+void
+psdf_encode_work_hash(const psdf_encode_work_t *pw, byte hash[16])
+{
+    gs_md5_state_t md5;
+    int i, j;
+
+    gs_md5_init(&md5);
+    for (i = 0; i < pw->num_stages; i++) {
+        const stream_template *templat = pw->templat[i];
+
+        gs_md5_append(&md5, (const byte *)&templat->process,
+                      sizeof(templat->process));
+        if (templat->process == s_DCTE_template.process) {
+            /* The quality is in the quantization tables. */
+            const jpeg_compress_data *jcdp =
+                ((const stream_DCT_state *)pw->state[i])->data.compress;
+
+            for (j = 0; j < NUM_QUANT_TBLS; j++)
+                if (jcdp->cinfo.quant_tbl_ptrs[j] != NULL)
+                    gs_md5_append(&md5,
+                        (const byte *)jcdp->cinfo.quant_tbl_ptrs[j]->quantval,
+                        sizeof(jcdp->cinfo.quant_tbl_ptrs[j]->quantval));
+        }
+    }
+    gs_md5_append(&md5, pw->data, pw->size);
+    gs_md5_finish(&md5, hash);
+}
+
 /* ---------------- Overprint, Get Bits ---------------- */
 
 /*
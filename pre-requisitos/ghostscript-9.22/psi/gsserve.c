@@ -0,0 +1,479 @@
+/* Copyright (C) 2001-2017 Artifex Software, Inc.
+   All Rights Reserved.
+
+   This software is provided AS-IS with no warranty, either express or
+   implied.
+
+   This software is distributed under license and may not be copied,
+   modified or distributed except as expressly authorized under the terms
+   of the license contained in the file LICENSE in this distribution.
+
+   Refer to licensing information at http://www.artifex.com or contact
+   Artifex Software, Inc.,  7 Mt. Lassen Drive - Suite A-134, San Rafael,
+   CA  94903, U.S.A., +1(415)492-9861, for further information.
+*/
+
+
+/* gsserve.c */
+/*
+ * Ghostscript job server for Unix.  It initializes an instance once with
+ * the options given on its command line (the device and its parameters),
+ * then runs the jobs it receives on a Unix domain socket, so that the
+ * interpreter, its initialization files, fonts and ICC profiles are set
+ * up once instead of for every document.
+ *
+ *     gsserve [-j workers] socket [gs options]
+ *
+ * A request is one line of tab separated fields: the output file, then the
+ * input files to run, in order.  Fields starting with -d or -s set a
+ * device parameter for this job alone, as the same options of gs do
+ * (-dName, -dName=value, -sName=string).  The server answers with a line
+ * "OK" once the output file is complete, or "ERROR <code>", and closes
+ * the connection.
+ *
+ * Each job runs inside save/restore and sets OutputFile with
+ * setpagedevice, so that the restore closes the output file and puts the
+ * device back as it was for the next job.  Give an OutputFile for the time
+ * between jobs, such as -sOutputFile=/dev/null.  Don't use -dSAFER, which
+ * doesn't allow OutputFile to change.
+ *
+ * With -j, the initialized instance is forked into that many workers,
+ * which take requests from the socket in turn.  A worker that exits is
+ * replaced by a new one.  SIGTERM stops the server.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#define __PROTOTYPES__
+#include "ierrors.h"
+#include "iapi.h"
+
+#define MAX_WORKERS 64
+#define MAX_REQUEST (1024 * 1024)
+
+static volatile sig_atomic_t stopping = 0;
+
+/*********************************************************************/
+/* stdio functions */
+
+static int GSDLLCALL
+gsserve_stdin(void *instance, char *buf, int len)
+{
+    return 0;	/* Jobs don't read stdin */
+}
+
+/* Messages of the jobs go to the log of the server. */
+static int GSDLLCALL
+gsserve_stdout(void *instance, const char *str, int len)
+{
+    fwrite(str, 1, len, stderr);
+    fflush(stderr);
+    return len;
+}
+
+static int GSDLLCALL
+gsserve_stderr(void *instance, const char *str, int len)
+{
+    fwrite(str, 1, len, stderr);
+    fflush(stderr);
+    return len;
+}
+
+/*********************************************************************/
+/* Building the job */
+
+typedef struct job_s {
+    char *data;
+    int size;
+    int limit;
+} job_t;
+
+static int
+job_put(job_t *job, const char *str, int len)
+{
+    if (job->size + len + 1 > job->limit) {
+        int limit = (job->size + len + 1) * 2;
+        char *data = realloc(job->data, limit);
+
+        if (data == NULL)
+            return -1;
+        job->data = data;
+        job->limit = limit;
+    }
+    memcpy(job->data + job->size, str, len);
+    job->size += len;
+    job->data[job->size] = 0;
+    return 0;
+}
+
+static int
+job_puts(job_t *job, const char *str)
+{
+    return job_put(job, str, strlen(str));
+}
+
+/* Write a PostScript string. */
+static int
+job_put_string(job_t *job, const char *str, int len)
+{
+    char buf[5];
+    int i, code = job_puts(job, "(");
+
+    for (i = 0; i < len && code == 0; i++) {
+        unsigned char c = (unsigned char)str[i];
+
+        if (c == '(' || c == ')' || c == '\\') {
+            buf[0] = '\\';
+            buf[1] = c;
+            code = job_put(job, buf, 2);
+        } else if (c < 32 || c > 126) {
+            sprintf(buf, "\\%03o", c);
+            code = job_put(job, buf, 4);
+        } else
+            code = job_put(job, (const char *)&c, 1);
+    }
+    return code ? code : job_puts(job, ")");
+}
+
+static int
+is_name(const char *str, int len)
+{
+    int i;
+
+    if (len == 0)
+        return 0;
+    for (i = 0; i < len; i++)
+        if (!(str[i] >= 'a' && str[i] <= 'z') &&
+            !(str[i] >= 'A' && str[i] <= 'Z') &&
+            !(str[i] >= '0' && str[i] <= '9') &&
+            str[i] != '_' && str[i] != '.' && str[i] != '-')
+            return 0;
+    return 1;
+}
+
+/* Write -dName[=value] or -sName=string as a key and value. */
+static int
+job_put_param(job_t *job, const char *arg)
+{
+    const char *name = arg + 2;
+    const char *eq = strchr(name, '=');
+    int name_len = (eq ? eq - name : strlen(name));
+    const char *value = (eq ? eq + 1 : NULL);
+    int code;
+
+    if (!is_name(name, name_len))
+        return -1;
+    code = job_puts(job, " /");
+    if (code == 0)
+        code = job_put(job, name, name_len);
+    if (code == 0)
+        code = job_puts(job, " ");
+    if (code != 0)
+        return code;
+    if (arg[1] == 's') {
+        if (value == NULL)
+            return -1;
+        /* -sName=/Value, as gs takes it for ColorConversionStrategy. */
+        if (value[0] == '/' && is_name(value + 1, strlen(value + 1)))
+            return job_puts(job, value);
+        return job_put_string(job, value, strlen(value));
+    }
+    if (value == NULL || *value == 0)
+        return job_puts(job, "true");
+    if (!strcmp(value, "true") || !strcmp(value, "false"))
+        return job_puts(job, value);
+    if (value[0] == '/' && is_name(value + 1, strlen(value + 1)))
+        return job_puts(job, value);
+    {
+        char *end;
+
+        (void)strtod(value, &end);
+        if (*end != 0)
+            return -1;
+    }
+    return job_puts(job, value);
+}
+
+/*
+ * Make the PostScript of a request.  The job leaves nothing behind: on an
+ * error the stacks are cleared and the VM restored, then the error is
+ * raised again so that it ends the run_string with its code.
+ */
+static int
+make_job(job_t *job, char *request)
+{
+    char *fields[1024];
+    int num_fields = 0, i, code;
+    char *p = request;
+
+    for (;;) {
+        if (num_fields == sizeof(fields) / sizeof(fields[0]))
+            return -1;
+        fields[num_fields++] = p;
+        p = strchr(p, '\t');
+        if (p == NULL)
+            break;
+        *p++ = 0;
+    }
+    if (*fields[0] == 0)
+        return -1;
+    job->size = 0;
+    code = job_puts(job, "save mark {\n<< /OutputFile ");
+    if (code == 0)
+        code = job_put_string(job, fields[0], strlen(fields[0]));
+    for (i = 1; i < num_fields && code == 0; i++)
+        if (fields[i][0] == '-' && (fields[i][1] == 'd' || fields[i][1] == 's'))
+            code = job_put_param(job, fields[i]);
+    if (code == 0)
+        code = job_puts(job, " >> setpagedevice\n");
+    for (i = 1; i < num_fields && code == 0; i++) {
+        if (fields[i][0] == 0 ||
+            (fields[i][0] == '-' && (fields[i][1] == 'd' || fields[i][1] == 's')))
+            continue;
+        code = job_put_string(job, fields[i], strlen(fields[i]));
+        if (code == 0)
+            code = job_puts(job, " run\n");
+    }
+    if (code == 0)
+        code = job_puts(job,
+            "} stopped { $error /errorname get } { //null } ifelse\n"
+            "counttomark 1 add 1 roll cleartomark\n"
+            "cleardictstack exch restore\n"
+            "dup //null eq { pop } { /gsserve exch signalerror } ifelse\n");
+    return code;
+}
+
+/*********************************************************************/
+/* Serving */
+
+/* Read a request line, without its newline. */
+static char *
+read_request(int fd)
+{
+    char *buf = NULL;
+    int size = 0, limit = 0;
+
+    for (;;) {
+        int n;
+
+        if (size + 1 >= limit) {
+            char *nbuf;
+
+            limit = (limit ? limit * 2 : 4096);
+            if (limit > MAX_REQUEST || (nbuf = realloc(buf, limit)) == NULL) {
+                free(buf);
+                return NULL;
+            }
+            buf = nbuf;
+        }
+        n = read(fd, buf + size, 1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0 || buf[size] == '\n')
+            break;
+        size++;
+    }
+    if (size > 0 && buf[size - 1] == '\r')
+        size--;
+    buf[size] = 0;
+    return buf;
+}
+
+static void
+reply(int fd, const char *str)
+{
+    int len = strlen(str);
+
+    while (len > 0) {
+        int n = write(fd, str, len);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        str += n;
+        len -= n;
+    }
+}
+
+/* Take requests until the interpreter can't go on. */
+static int
+serve(void *instance, int listener)
+{
+    job_t job = { NULL, 0, 0 };
+    int code = 0;
+
+    while (!stopping) {
+        int fd = accept(listener, NULL, NULL);
+        char *request;
+        char answer[32];
+        int exit_code;
+
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("gsserve: accept");
+            code = gs_error_Fatal;
+            break;
+        }
+        request = read_request(fd);
+        if (request == NULL || make_job(&job, request) < 0) {
+            reply(fd, "ERROR bad request\n");
+            free(request);
+            close(fd);
+            continue;
+        }
+        free(request);
+        code = gsapi_run_string_with_length(instance, job.data, job.size,
+                                            0, &exit_code);
+        if (code == 0)
+            reply(fd, "OK\n");
+        else {
+            sprintf(answer, "ERROR %d\n", code);
+            reply(fd, answer);
+        }
+        close(fd);
+        if (code == gs_error_Quit || code == gs_error_Fatal ||
+            code == gs_error_InterpreterExit)
+            break;
+        code = 0;
+    }
+    free(job.data);
+    return code;
+}
+
+static void
+stop_handler(int sig)
+{
+    stopping = 1;
+}
+
+static int
+open_socket(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "gsserve: socket path too long: %s\n", path);
+        return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("gsserve: socket");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(fd, 16) < 0) {
+        perror("gsserve: bind");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static pid_t
+start_worker(void *instance, int listener)
+{
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        signal(SIGTERM, SIG_DFL);
+        exit(serve(instance, listener) == 0 ? 0 : 1);
+    }
+    return pid;
+}
+
+int main(int argc, char *argv[])
+{
+    void *instance;
+    int code, code1;
+    int num_workers = 0, arg = 1, listener, i;
+    pid_t workers[MAX_WORKERS];
+    const char *path;
+
+    if (argc > arg + 1 && !strcmp(argv[arg], "-j")) {
+        num_workers = atoi(argv[arg + 1]);
+        if (num_workers > MAX_WORKERS)
+            num_workers = MAX_WORKERS;
+        arg += 2;
+    }
+    if (argc <= arg) {
+        fprintf(stderr, "Usage: gsserve [-j workers] socket [gs options]\n");
+        return 1;
+    }
+    path = argv[arg];
+
+    if ((code = gsapi_new_instance(&instance, NULL)) < 0)
+        return 1;
+    gsapi_set_stdio(instance, gsserve_stdin, gsserve_stdout, gsserve_stderr);
+    code = gsapi_set_arg_encoding(instance, GS_ARG_ENCODING_UTF8);
+    /* The socket name stands in for argv[0]. */
+    if (code == 0)
+        code = gsapi_init_with_args(instance, argc - arg, argv + arg);
+    if (code < 0) {
+        gsapi_exit(instance);
+        gsapi_delete_instance(instance);
+        return 1;
+    }
+
+    listener = open_socket(path);
+    if (listener < 0) {
+        gsapi_exit(instance);
+        gsapi_delete_instance(instance);
+        return 1;
+    }
+    signal(SIGTERM, stop_handler);
+    signal(SIGINT, stop_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (num_workers <= 0)
+        code = serve(instance, listener);
+    else {
+        for (i = 0; i < num_workers; i++)
+            workers[i] = start_worker(instance, listener);
+        while (!stopping) {
+            int status;
+            pid_t pid = wait(&status);
+
+            if (pid < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            for (i = 0; i < num_workers; i++)
+                if (workers[i] == pid && !stopping) {
+                    fprintf(stderr, "gsserve: worker %d exited, starting another\n",
+                            (int)pid);
+                    workers[i] = start_worker(instance, listener);
+                }
+        }
+        for (i = 0; i < num_workers; i++)
+            if (workers[i] > 0)
+                kill(workers[i], SIGTERM);
+        for (;;)
+            if (wait(NULL) < 0 && errno != EINTR)
+                break;
+        code = 0;
+    }
+    close(listener);
+    unlink(path);
+
+    code1 = gsapi_exit(instance);
+    if (code == 0 || code == gs_error_Quit)
+        code = code1;
+    gsapi_delete_instance(instance);
+    return (code == 0 || code == gs_error_Quit) ? 0 : 1;
+}
@@ -1928,6 +1928,10 @@ $(PSOBJ)apitest.$(OBJ) : $(PSSRC)apitest.c $(GH)\
  $(locale__h) $(gp_h) $(INT_MAK) $(MAKEDIRS)
 	$(PSCC) $(PSO_)apitest.$(OBJ) $(C_) $(PSSRC)apitest.c
 
+$(PSOBJ)gsserve.$(OBJ) : $(PSSRC)gsserve.c $(ierrors_h) $(iapi_h)\
+ $(INT_MAK) $(MAKEDIRS)
+	$(PSCC) $(PSO_)gsserve.$(OBJ) $(C_) $(PSSRC)gsserve.c
+
 $(PSOBJ)iapi.$(OBJ) : $(PSSRC)iapi.c $(AK)\
  $(string__h) $(ierrors_h) $(gscdefs_h) $(gstypes_h) $(iapi_h)\
  $(iref_h) $(imain_h) $(imainarg_h) $(iminst_h) $(gslibctx_h)\
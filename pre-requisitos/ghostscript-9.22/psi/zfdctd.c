@@ -27,6 +27,9 @@
 #include "ialloc.h"
 #include "ifilter.h"
 #include "iparam.h"
+#include "igstate.h"
+#include "gxdevcli.h"
+#include "gxdevsop.h"
 
 private_st_jpeg_decompress_data();
 
@@ -48,6 +51,23 @@ find_stream_memory(i_ctx_t *i_ctx_p, int npop, uint *space)
     return idmemory->spaces_indexed[*space >> r_space_shift];
 }
 
+/* Hand the compressed data of a DCTDecode filter to the device. */
+static int
+PassThrough(void *d, byte *Buffer, uint Size)
+{
+    jpeg_decompress_data *jddp = (jpeg_decompress_data *)d;
+    gx_device *dev = (gx_device *)jddp->device;
+
+    if (Buffer == NULL) {
+        if (Size == 0)
+            dev_proc(dev, dev_spec_op)(dev, gxdso_JPEG_passthrough_end, jddp, 0);
+        else
+            dev_proc(dev, dev_spec_op)(dev, gxdso_JPEG_passthrough_begin, jddp, 0);
+    } else
+        dev_proc(dev, dev_spec_op)(dev, gxdso_JPEG_passthrough_data, Buffer, Size);
+    return 0;
+}
+
 /* <source> <dict> DCTDecode/filter <file> */
 /* <source> DCTDecode/filter <file> */
 static int
@@ -86,6 +106,24 @@ zDCTD(i_ctx_t *i_ctx_p)
         goto fail;
     if ((code = s_DCTD_put_params((gs_param_list *) & list, &state)) < 0)
         goto rel;
+    /*
+     * Offer the compressed data to the device, unless the dictionary
+     * set a ColorTransform: a DCTDecode filter reading the data again
+     * wouldn't know of it.
+     */
+    jddp->PassThrough = false;
+    jddp->StartedPassThrough = false;
+    jddp->PassThroughfn = NULL;
+    jddp->device = NULL;
+    if (state.ColorTransform == -1) {
+        gx_device *dev = gs_currentdevice(igs);
+
+        if (dev_proc(dev, dev_spec_op)(dev, gxdso_JPEG_passthrough_query, NULL, 0) > 0) {
+            jddp->PassThrough = true;
+            jddp->PassThroughfn = &PassThrough;
+            jddp->device = (void *)dev;
+        }
+    }
     /* Create the filter. */
     jddp->templat = s_DCTD_template;
     code = filter_read(i_ctx_p, 0, &jddp->templat,
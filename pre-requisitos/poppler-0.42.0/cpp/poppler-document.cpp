@@ -572,6 +572,20 @@ bool document::has_embedded_files() const
     return d->doc->getCatalog()->numEmbeddedFiles() > 0;
 }
 
+/**
+ Reads whether the current document has signature fields.
+
+ This is a very fast way to know whether the %document is signed: it looks
+ only at the form fields, without loading the pages. A field prepared for a
+ signature but not signed yet counts too.
+
+ \returns whether the document has signature fields
+ */
+bool document::has_signatures() const
+{
+    return d->doc->hasSignatures();
+}
+
 /**
  Reads all the %document-level embedded files of the %document.
 
@@ -79,6 +79,7 @@ public:
     toc* create_toc() const;
 
     bool has_embedded_files() const;
+    bool has_signatures() const;
     std::vector<embedded_file *> embedded_files() const;
 
     static document* load_from_file(const std::string &file_name,
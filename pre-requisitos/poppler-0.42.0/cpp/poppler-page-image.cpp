@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2017, Agencia Nacional de Telecomunicacoes
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "poppler-page-image.h"
+#include "poppler-page.h"
+
+#include "poppler-document-private.h"
+#include "poppler-page-private.h"
+
+#include "GfxState.h"
+#include "OutputDev.h"
+#include "PDFDoc.h"
+#include "Stream.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace poppler;
+
+class poppler::page_image_private
+{
+public:
+    page_image_private()
+        : width(0)
+        , height(0)
+        , bits_per_component(0)
+        , components(0)
+        , is_mask(false)
+        , is_inline(false)
+        , encoding(page_image::encoding_none)
+        , data(0)
+        , data_size(0)
+    {
+    }
+
+    static page_image create(page_image_private &dd)
+    {
+        return page_image(dd);
+    }
+
+    int width;
+    int height;
+    int bits_per_component;
+    int components;
+    bool is_mask;
+    bool is_inline;
+    rectf bbox;
+    page_image::encoding_enum encoding;
+    // data points either into the buffer the document was loaded from, or
+    // into copy.
+    const char *data;
+    size_t data_size;
+    byte_array copy;
+};
+
+namespace
+{
+
+page_image::encoding_enum stream_encoding(Stream *str)
+{
+    Stream *undecoded = str->getUndecodedStream();
+    if (str == undecoded) {
+        return page_image::encoding_none;
+    }
+    // With more than one filter the data is not in the encoding of the
+    // last one.
+    if (str->getNextStream() != undecoded) {
+        return page_image::encoding_other;
+    }
+    switch (str->getKind()) {
+    case strFlate:
+        return page_image::encoding_flate;
+    case strLZW:
+        return page_image::encoding_lzw;
+    case strRunLength:
+        return page_image::encoding_run_length;
+    case strCCITTFax:
+        return page_image::encoding_ccitt;
+    case strDCT:
+        return page_image::encoding_dct;
+    case strJBIG2:
+        return page_image::encoding_jbig2;
+    case strJPX:
+        return page_image::encoding_jpx;
+    default:
+        return page_image::encoding_other;
+    }
+}
+
+// Goes over the content of a page, collecting the images it draws instead
+// of drawing anything.
+class image_collector : public OutputDev
+{
+public:
+    image_collector(std::vector<page_image> *images)
+        : images(images)
+    {
+    }
+
+    virtual GBool upsideDown() { return gTrue; }
+    virtual GBool useDrawChar() { return gFalse; }
+    virtual GBool interpretType3Chars() { return gFalse; }
+    virtual GBool needNonText() { return gTrue; }
+    virtual GBool useTilingPatternFill() { return gTrue; }
+    virtual GBool tilingPatternFill(GfxState *, Gfx *, Catalog *, Object *,
+                                    double *, int, int, Dict *,
+                                    double *, double *,
+                                    int, int, int, int,
+                                    double, double)
+    {
+        // Skips the pattern, as drawing its tiles would only list the same
+        // images again.
+        return gTrue;
+    }
+
+    virtual void drawImageMask(GfxState *state, Object *, Stream *str,
+                               int width, int height, GBool,
+                               GBool, GBool inlineImg)
+    {
+        add(state, str, width, height, 0, inlineImg);
+    }
+    virtual void drawImage(GfxState *state, Object *, Stream *str,
+                           int width, int height, GfxImageColorMap *colorMap,
+                           GBool, int *, GBool inlineImg)
+    {
+        add(state, str, width, height, colorMap, inlineImg);
+    }
+    virtual void drawMaskedImage(GfxState *state, Object *, Stream *str,
+                                 int width, int height,
+                                 GfxImageColorMap *colorMap, GBool,
+                                 Stream *, int, int, GBool, GBool)
+    {
+        add(state, str, width, height, colorMap, gFalse);
+    }
+    virtual void drawSoftMaskedImage(GfxState *state, Object *, Stream *str,
+                                     int width, int height,
+                                     GfxImageColorMap *colorMap, GBool,
+                                     Stream *, int, int,
+                                     GfxImageColorMap *, GBool)
+    {
+        add(state, str, width, height, colorMap, gFalse);
+    }
+
+private:
+    void add(GfxState *state, Stream *str, int width, int height,
+             GfxImageColorMap *colorMap, GBool inlineImg);
+
+    std::vector<page_image> *images;
+};
+
+void image_collector::add(GfxState *state, Stream *str, int width, int height,
+                          GfxImageColorMap *colorMap, GBool inlineImg)
+{
+    page_image_private dd;
+    dd.width = width;
+    dd.height = height;
+    dd.is_mask = !colorMap;
+    dd.bits_per_component = colorMap ? colorMap->getBits() : 1;
+    dd.components = colorMap ? colorMap->getNumPixelComps() : 1;
+    dd.is_inline = inlineImg;
+    dd.encoding = stream_encoding(str);
+
+    // The image fills the unit square of its CTM.
+    double xmin = 0, ymin = 0, xmax = 0, ymax = 0;
+    for (int i = 0; i < 4; ++i) {
+        double x, y;
+        state->transform(i & 1, i >> 1, &x, &y);
+        if (i == 0 || x < xmin) xmin = x;
+        if (i == 0 || x > xmax) xmax = x;
+        if (i == 0 || y < ymin) ymin = y;
+        if (i == 0 || y > ymax) ymax = y;
+    }
+    dd.bbox = rectf(xmin, ymin, xmax - xmin, ymax - ymin);
+
+    // The data of an inline image is read from the content stream up to
+    // its end, which only the content parser knows, so it is left out.
+    if (!inlineImg) {
+        Stream *undecoded = str->getUndecodedStream();
+        MemStream *mem = dynamic_cast<MemStream *>(undecoded);
+        if (mem) {
+            // The document is in memory and not encrypted: the data is
+            // where it was loaded.
+            dd.data = mem->getData();
+            dd.data_size = mem->getLength();
+        } else {
+            undecoded->reset();
+            char buf[4096];
+            int n;
+            while ((n = undecoded->doGetChars(sizeof(buf), reinterpret_cast<Guchar *>(buf))) > 0) {
+                dd.copy.insert(dd.copy.end(), buf, buf + n);
+            }
+            undecoded->close();
+        }
+    }
+    images->push_back(page_image_private::create(dd));
+}
+
+}
+
+/**
+ \class poppler::page_image poppler-page-image.h "poppler/cpp/poppler-page-image.h"
+
+ An image drawn on a page, with its data as stored in the %document.
+
+ \see page::images
+ \since 0.42
+ */
+
+/**
+ \enum poppler::page_image::encoding_enum
+
+ The encoding of the data of an image: that of its filter if it has only
+ one, or encoding_other if it has several.
+*/
+
+page_image::page_image()
+    : d(new page_image_private())
+{
+}
+
+page_image::page_image(page_image_private &dd)
+    : d(new page_image_private(dd))
+{
+    if (!d->copy.empty()) {
+        d->data = &d->copy[0];
+        d->data_size = d->copy.size();
+    }
+}
+
+page_image::page_image(const page_image &pi)
+    : d(new page_image_private(*pi.d))
+{
+    if (!d->copy.empty()) {
+        d->data = &d->copy[0];
+    }
+}
+
+page_image::~page_image()
+{
+    delete d;
+}
+
+/**
+ \returns the width of the image, in its own pixels
+ */
+int page_image::width() const
+{
+    return d->width;
+}
+
+/**
+ \returns the height of the image, in its own pixels
+ */
+int page_image::height() const
+{
+    return d->height;
+}
+
+/**
+ \returns the bits of each color component of a pixel, 1 for masks
+ */
+int page_image::bits_per_component() const
+{
+    return d->bits_per_component;
+}
+
+/**
+ \returns the number of color components of a pixel, 1 for masks
+ */
+int page_image::components() const
+{
+    return d->components;
+}
+
+/**
+ \returns whether the image is a stencil mask, painting the fill color
+ */
+bool page_image::is_mask() const
+{
+    return d->is_mask;
+}
+
+/**
+ \returns whether the image is inline in the content of the page, in which
+          case it has no data
+ */
+bool page_image::is_inline() const
+{
+    return d->is_inline;
+}
+
+/**
+ \returns the area the image covers, in points from the top left corner of
+          the crop box of the page
+ */
+rectf page_image::bbox() const
+{
+    return d->bbox;
+}
+
+/**
+ \returns the encoding of data()
+ */
+page_image::encoding_enum page_image::encoding() const
+{
+    return d->encoding;
+}
+
+/**
+ The data of the image, still encoded, as stored in the %document.
+
+ For a %document loaded from memory without encryption the data is not
+ copied: it points into the buffer the %document was loaded from, and so is
+ valid as long as the %document is. Otherwise it is a copy owned by this
+ image.
+
+ \returns the encoded data, or a null pointer if the image has none
+ */
+const char* page_image::data() const
+{
+    return d->data;
+}
+
+/**
+ \returns the size in bytes of data()
+ */
+size_t page_image::data_size() const
+{
+    return d->data_size;
+}
+
+page_image& page_image::operator=(const page_image &pi)
+{
+    if (this != &pi) {
+        *d = *pi.d;
+        if (!d->copy.empty()) {
+            d->data = &d->copy[0];
+        }
+    }
+    return *this;
+}
+
+/**
+ Lists the images drawn on the page, in the order they are drawn, without
+ decoding them.
+
+ Images in tiling patterns are left out.
+
+ \returns the images of the page
+ \since 0.42
+ */
+std::vector<page_image> page::images() const
+{
+    std::vector<page_image> result;
+    image_collector collector(&result);
+    d->doc->doc->displayPage(&collector, d->index + 1, 72, 72, 0,
+                             gFalse, gTrue, gFalse);
+    return result;
+}
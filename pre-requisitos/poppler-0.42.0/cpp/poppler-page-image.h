@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017, Agencia Nacional de Telecomunicacoes
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef POPPLER_PAGE_IMAGE_H
+#define POPPLER_PAGE_IMAGE_H
+
+#include "poppler-global.h"
+#include "poppler-rectangle.h"
+
+namespace poppler
+{
+
+class page;
+class page_image_private;
+
+class POPPLER_CPP_EXPORT page_image
+{
+public:
+    enum encoding_enum {
+        encoding_none,
+        encoding_flate,
+        encoding_lzw,
+        encoding_run_length,
+        encoding_ccitt,
+        encoding_dct,
+        encoding_jbig2,
+        encoding_jpx,
+        encoding_other
+    };
+
+    page_image();
+    page_image(const page_image &pi);
+    ~page_image();
+
+    int width() const;
+    int height() const;
+    int bits_per_component() const;
+    int components() const;
+    bool is_mask() const;
+    bool is_inline() const;
+    rectf bbox() const;
+
+    encoding_enum encoding() const;
+    const char* data() const;
+    size_t data_size() const;
+
+    page_image& operator=(const page_image &pi);
+
+private:
+    page_image(page_image_private &dd);
+
+    page_image_private *d;
+    friend class page_image_private;
+};
+
+}
+
+#endif
@@ -24,6 +24,8 @@
 
 #include <config.h>
 
+#include <string.h>
+
 #include "PDFDoc.h"
 #if defined(HAVE_SPLASH)
 #include "SplashOutputDev.h"
@@ -38,13 +40,72 @@ public:
     page_renderer_private()
         : paper_color(0xffffffff)
         , hints(0)
+#if defined(HAVE_SPLASH)
+        , output_dev(0)
+#endif
+    {
+    }
+    ~page_renderer_private()
     {
+#if defined(HAVE_SPLASH)
+        delete output_dev;
+#endif
     }
 
+#if defined(HAVE_SPLASH)
+    SplashBitmap* render(const page *p, double xres, double yres,
+                         int x, int y, int w, int h, rotation_enum rotate);
+#endif
+
     argb paper_color;
     unsigned int hints;
+#if defined(HAVE_SPLASH)
+    // Kept from render to render, so that its bitmap is reused as long as
+    // the pages have the same size; made again when the paper color or the
+    // hints change.
+    SplashOutputDev *output_dev;
+    argb output_dev_paper_color;
+    unsigned int output_dev_hints;
+#endif
 };
 
+#if defined(HAVE_SPLASH)
+// Renders the page into the bitmap of output_dev, which is valid until the
+// next render.
+SplashBitmap* page_renderer_private::render(const page *p,
+                                            double xres, double yres,
+                                            int x, int y, int w, int h,
+                                            rotation_enum rotate)
+{
+    page_private *pp = page_private::get(p);
+    PDFDoc *pdfdoc = pp->doc->doc;
+
+    if (output_dev && (output_dev_paper_color != paper_color
+                       || output_dev_hints != hints)) {
+        delete output_dev;
+        output_dev = 0;
+    }
+    if (!output_dev) {
+        SplashColor bgColor;
+        bgColor[0] = paper_color & 0xff;
+        bgColor[1] = (paper_color >> 8) & 0xff;
+        bgColor[2] = (paper_color >> 16) & 0xff;
+        output_dev = new SplashOutputDev(splashModeXBGR8, 4, gFalse, bgColor, gTrue);
+        output_dev->setFontAntialias(hints & page_renderer::text_antialiasing ? gTrue : gFalse);
+        output_dev->setVectorAntialias(hints & page_renderer::antialiasing ? gTrue : gFalse);
+        output_dev->setFreeTypeHinting(hints & page_renderer::text_hinting ? gTrue : gFalse, gFalse);
+        output_dev_paper_color = paper_color;
+        output_dev_hints = hints;
+    }
+    output_dev->startDoc(pdfdoc);
+    pdfdoc->displayPageSlice(output_dev, pp->index + 1,
+                             xres, yres, int(rotate) * 90,
+                             gFalse, gTrue, gFalse,
+                             x, y, w, h);
+    return output_dev->getBitmap();
+}
+#endif
+
 
 /**
  \class poppler::page_renderer poppler-page-renderer.h "poppler/cpp/poppler-renderer.h"
@@ -165,24 +226,7 @@ image page_renderer::render_page(const page *p,
     }
 
 #if defined(HAVE_SPLASH)
-    page_private *pp = page_private::get(p);
-    PDFDoc *pdfdoc = pp->doc->doc;
-
-    SplashColor bgColor;
-    bgColor[0] = d->paper_color & 0xff;
-    bgColor[1] = (d->paper_color >> 8) & 0xff;
-    bgColor[2] = (d->paper_color >> 16) & 0xff;
-    SplashOutputDev splashOutputDev(splashModeXBGR8, 4, gFalse, bgColor, gTrue);
-    splashOutputDev.setFontAntialias(d->hints & text_antialiasing ? gTrue : gFalse);
-    splashOutputDev.setVectorAntialias(d->hints & antialiasing ? gTrue : gFalse);
-    splashOutputDev.setFreeTypeHinting(d->hints & text_hinting ? gTrue : gFalse, gFalse);
-    splashOutputDev.startDoc(pdfdoc);
-    pdfdoc->displayPageSlice(&splashOutputDev, pp->index + 1,
-                             xres, yres, int(rotate) * 90,
-                             gFalse, gTrue, gFalse,
-                             x, y, w, h);
-
-    SplashBitmap *bitmap = splashOutputDev.getBitmap();
+    SplashBitmap *bitmap = d->render(p, xres, yres, x, y, w, h, rotate);
     const int bw = bitmap->getWidth();
     const int bh = bitmap->getHeight();
 
@@ -195,6 +239,66 @@ image page_renderer::render_page(const page *p,
 #endif
 }
 
+/**
+ Render the specified page into an image of the caller.
+
+ As the other render_page(), but the page is written to \p target. If
+ \p target is an ARGB32 image of the size of the rendered page, its data is
+ overwritten, so a target made on a buffer of the caller is rendered into
+ that buffer; otherwise \p target is replaced with a new image. Rendering
+ the pages of the same size one after the other into the same target
+ allocates nothing past the first page.
+
+ \param p the page to render
+ \param target the image to render into
+ \param xres the X resolution, in dot per inch (DPI)
+ \param yres the Y resolution, in dot per inch (DPI)
+ \param x the X top-right coordinate, in pixels
+ \param y the Y top-right coordinate, in pixels
+ \param w the width in pixels of the area to render
+ \param h the height in pixels of the area to render
+ \param rotate the rotation to apply when rendering the page
+
+ \returns whether the page was rendered
+
+ \see can_render
+ \since 0.42
+ */
+bool page_renderer::render_page(const page *p, image &target,
+                                double xres, double yres,
+                                int x, int y, int w, int h,
+                                rotation_enum rotate) const
+{
+    if (!p) {
+        return false;
+    }
+
+#if defined(HAVE_SPLASH)
+    SplashBitmap *bitmap = d->render(p, xres, yres, x, y, w, h, rotate);
+    const int bw = bitmap->getWidth();
+    const int bh = bitmap->getHeight();
+    if (!target.is_valid() || target.format() != image::format_argb32
+        || target.width() != bw || target.height() != bh) {
+        target = image(bw, bh, image::format_argb32);
+        if (!target.is_valid()) {
+            return false;
+        }
+    }
+
+    const char *src = reinterpret_cast<const char *>(bitmap->getDataPtr());
+    char *dst = target.data();
+    const int row_bytes = bw * 4;
+    for (int row = 0; row < bh; ++row) {
+        memcpy(dst, src, row_bytes);
+        src += bitmap->getRowSize();
+        dst += target.bytes_per_row();
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
 /**
  Rendering capability test.
 
@@ -53,6 +53,10 @@ public:
                       double xres = 72.0, double yres = 72.0,
                       int x = -1, int y = -1, int w = -1, int h = -1,
                       rotation_enum rotate = rotate_0) const;
+    bool render_page(const page *p, image &target,
+                     double xres = 72.0, double yres = 72.0,
+                     int x = -1, int y = -1, int w = -1, int h = -1,
+                     rotation_enum rotate = rotate_0) const;
 
     static bool can_render();
 
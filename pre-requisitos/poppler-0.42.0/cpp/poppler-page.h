@@ -20,8 +20,11 @@
 #define POPPLER_PAGE_H
 
 #include "poppler-global.h"
+#include "poppler-page-image.h"
 #include "poppler-rectangle.h"
 
+#include <vector>
+
 namespace poppler
 {
 
@@ -63,6 +66,8 @@ public:
     ustring text(const rectf &rect = rectf()) const;
     ustring text(const rectf &rect, text_layout_enum layout_mode) const;
 
+    std::vector<page_image> images() const;
+
 private:
     page(document_private *doc, int index);
 
@@ -619,6 +619,9 @@ Goffset GooFile::size() const {
   return size.QuadPart;
 }
 
+void GooFile::prefetch(Goffset offset, Goffset n) const {
+}
+
 GooFile* GooFile::open(const GooString *fileName) {
   HANDLE handle = CreateFile(fileName->getCString(),
                               GENERIC_READ,
@@ -659,6 +662,12 @@ Goffset GooFile::size() const {
 #endif
 }
 
+void GooFile::prefetch(Goffset offset, Goffset n) const {
+#ifdef POSIX_FADV_WILLNEED
+  posix_fadvise(fd, offset, n, POSIX_FADV_WILLNEED);
+#endif
+}
+
 GooFile* GooFile::open(const GooString *fileName) {
 #ifdef VMS
   int fd = ::open(fileName->getCString(), Q_RDONLY, "ctx=stm");
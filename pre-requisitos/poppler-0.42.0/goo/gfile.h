@@ -137,6 +137,10 @@ class GooFile
 public:
   int read(char *buf, int n, Goffset offset) const;
   Goffset size() const;
+
+  // Tell the system that the <n> bytes at <offset> will be read soon,
+  // so it can start reading them in the background.
+  void prefetch(Goffset offset, Goffset n) const;
   
   static GooFile *open(const GooString *fileName);
   
@@ -46,6 +46,7 @@
 
 #include <stddef.h>
 #include <stdlib.h>
+#include <set>
 #include "goo/gmem.h"
 #include "Object.h"
 #include "PDFDoc.h"
@@ -85,6 +86,7 @@ Catalog::Catalog(PDFDoc *docA) {
   xref = doc->getXRef();
   pages = NULL;
   pageRefs = NULL;
+  pageParents = NULL;
   numPages = -1;
   pagesSize = 0;
   baseURI = NULL;
@@ -99,9 +101,10 @@ Catalog::Catalog(PDFDoc *docA) {
   viewerPrefs = NULL;
   structTreeRoot = NULL;
 
+  pagesAttrs = NULL;
   pagesList = NULL;
   pagesRefList = NULL;
-  attrsList = NULL;
+  attrsIdxList = NULL;
   kidsIdxList = NULL;
   lastCachedPage = 0;
   markInfo = markInfoNull;
@@ -148,12 +151,13 @@ Catalog::Catalog(PDFDoc *docA) {
 
 Catalog::~Catalog() {
   delete kidsIdxList;
-  if (attrsList) {
+  delete attrsIdxList;
+  if (pagesAttrs) {
     std::vector<PageAttrs *>::iterator it;
-    for (it = attrsList->begin() ; it != attrsList->end(); ++it ) {
+    for (it = pagesAttrs->begin() ; it != pagesAttrs->end(); ++it ) {
       delete *it;
     }
-    delete attrsList;
+    delete pagesAttrs;
   }
   delete pagesRefList;
   if (pagesList) {
@@ -174,6 +178,7 @@ Catalog::~Catalog() {
     gfree(pages);
   }
   gfree(pageRefs);
+  gfree(pageParents);
   names.free();
   dests.free();
   delete destNameTree;
@@ -242,9 +247,48 @@ Page *Catalog::getPage(int i)
        return NULL;
      }
   }
+  if (!pages[i-1]) {
+    pages[i-1] = loadPage(i);
+  }
   return pages[i-1];
 }
 
+void Catalog::releasePage(int i)
+{
+  catalogLocker();
+  if (i < 1 || i > lastCachedPage || !pages[i-1]) {
+    return;
+  }
+  delete pages[i-1];
+  pages[i-1] = NULL;
+}
+
+Page *Catalog::loadPage(int i)
+{
+  Object pageDict;
+  PageAttrs *attrs;
+  Page *p;
+
+  xref->fetch(pageRefs[i-1].num, pageRefs[i-1].gen, &pageDict);
+  if (!pageDict.isDict()) {
+    error(errSyntaxError, -1, "Page object (page {0:d}) is wrong type ({1:s})",
+          i, pageDict.getTypeName());
+    pageDict.free();
+    return NULL;
+  }
+  attrs = new PageAttrs(pageParents[i-1] >= 0
+			  ? (*pagesAttrs)[pageParents[i-1]] : (PageAttrs *)NULL,
+			pageDict.getDict());
+  p = new Page(doc, i, pageDict.getDict(), pageRefs[i-1], attrs, form);
+  pageDict.free();
+  if (!p->isOk()) {
+    error(errSyntaxError, -1, "Failed to create page (page {0:d})", i);
+    delete p;
+    return NULL;
+  }
+  return p;
+}
+
 Ref *Catalog::getPageRef(int i)
 {
   if (i < 1) return NULL;
@@ -308,7 +352,8 @@ GBool Catalog::cachePageTree(int page)
     pagesSize = getNumPages();
     pages = (Page **)gmallocn_checkoverflow(pagesSize, sizeof(Page *));
     pageRefs = (Ref *)gmallocn_checkoverflow(pagesSize, sizeof(Ref));
-    if (pages == NULL || pageRefs == NULL ) {
+    pageParents = (int *)gmallocn_checkoverflow(pagesSize, sizeof(int));
+    if (pages == NULL || pageRefs == NULL || pageParents == NULL) {
       error(errSyntaxError, -1, "Cannot allocate page cache");
       pagesDict->decRef();
       pagesSize = 0;
@@ -318,14 +363,17 @@ GBool Catalog::cachePageTree(int page)
       pages[i] = NULL;
       pageRefs[i].num = -1;
       pageRefs[i].gen = -1;
+      pageParents[i] = -1;
     }
 
     pagesList = new std::vector<Dict *>();
     pagesList->push_back(pagesDict);
     pagesRefList = new std::vector<Ref>();
     pagesRefList->push_back(pagesRef);
-    attrsList = new std::vector<PageAttrs *>();
-    attrsList->push_back(new PageAttrs(NULL, pagesDict));
+    pagesAttrs = new std::vector<PageAttrs *>();
+    pagesAttrs->push_back(new PageAttrs(NULL, pagesDict));
+    attrsIdxList = new std::vector<int>();
+    attrsIdxList->push_back(0);
     kidsIdxList = new std::vector<int>();
     kidsIdxList->push_back(0);
     lastCachedPage = 0;
@@ -355,8 +403,7 @@ GBool Catalog::cachePageTree(int page)
        }
        pagesList->pop_back();
        pagesRefList->pop_back();
-       delete attrsList->back();
-       attrsList->pop_back();
+       attrsIdxList->pop_back();
        kidsIdxList->pop_back();
        if (!kidsIdxList->empty()) kidsIdxList->back()++;
        kids.free();
@@ -392,17 +439,8 @@ GBool Catalog::cachePageTree(int page)
     kids.arrayGet(kidsIdx, &kid);
     kids.free();
     if (kid.isDict("Page") || (kid.isDict() && !kid.getDict()->hasKey("Kids"))) {
-      PageAttrs *attrs = new PageAttrs(attrsList->back(), kid.getDict());
-      Page *p = new Page(doc, lastCachedPage+1, kid.getDict(),
-                     kidRef.getRef(), attrs, form);
-      if (!p->isOk()) {
-        error(errSyntaxError, -1, "Failed to create page (page {0:d})", lastCachedPage+1);
-        delete p;
-        kidRef.free();
-        kid.free();
-        return gFalse;
-      }
-
+      // only the page's place in the tree is recorded here; the Page
+      // itself is built by getPage
       if (lastCachedPage >= numPages) {
         error(errSyntaxError, -1, "Page count in top-level pages object is incorrect");
         kidRef.free();
@@ -410,9 +448,9 @@ GBool Catalog::cachePageTree(int page)
         return gFalse;
       }
 
-      pages[lastCachedPage] = p;
       pageRefs[lastCachedPage].num = kidRef.getRefNum();
       pageRefs[lastCachedPage].gen = kidRef.getRefGen();
+      pageParents[lastCachedPage] = attrsIdxList->back();
 
       lastCachedPage++;
       kidsIdxList->back()++;
@@ -420,7 +458,9 @@ GBool Catalog::cachePageTree(int page)
     // This should really be isDict("Pages"), but I've seen at least one
     // PDF file where the /Type entry is missing.
     } else if (kid.isDict()) {
-      attrsList->push_back(new PageAttrs(attrsList->back(), kid.getDict()));
+      pagesAttrs->push_back(new PageAttrs((*pagesAttrs)[attrsIdxList->back()],
+					  kid.getDict()));
+      attrsIdxList->push_back(pagesAttrs->size() - 1);
       pagesRefList->push_back(kidRef.getRef());
       kid.getDict()->incRef();
       pagesList->push_back(kid.getDict());
@@ -841,10 +881,12 @@ int Catalog::getNumPages()
 	  if (p->isOk()) {
 	    pages = (Page **)gmallocn(1, sizeof(Page *));
 	    pageRefs = (Ref *)gmallocn(1, sizeof(Ref));
+	    pageParents = (int *)gmallocn(1, sizeof(int));
 
 	    pages[0] = p;
 	    pageRefs[0].num = pageRef.num;
 	    pageRefs[0].gen = pageRef.gen;
+	    pageParents[0] = -1;
 
 	    numPages = 1;
 	    lastCachedPage = 1;
@@ -1048,6 +1090,69 @@ Form *Catalog::getForm()
   return form;
 }
 
+// Looks for a field with FT Sig (which is inheritable) in the <fields>
+// array and the Kids below it.  <visited> breaks Kids loops.
+static GBool hasSignatureField(Object *fields, GBool parentIsSig,
+			       std::set<int> *visited) {
+  Object field, ft, kids;
+  GBool isSig, found;
+
+  found = gFalse;
+  for (int i = 0; !found && i < fields->arrayGetLength(); ++i) {
+    Object ref;
+    fields->arrayGetNF(i, &ref);
+    if (ref.isRef()) {
+      if (visited->find(ref.getRefNum()) != visited->end()) {
+	ref.free();
+	continue;
+      }
+      visited->insert(ref.getRefNum());
+    }
+    ref.free();
+    if (!fields->arrayGet(i, &field)->isDict()) {
+      field.free();
+      continue;
+    }
+    if (field.dictLookup("FT", &ft)->isName()) {
+      isSig = ft.isName("Sig");
+    } else {
+      isSig = parentIsSig;
+    }
+    ft.free();
+    if (isSig) {
+      found = gTrue;
+    } else {
+      if (field.dictLookup("Kids", &kids)->isArray()) {
+	found = hasSignatureField(&kids, isSig, visited);
+      }
+      kids.free();
+    }
+    field.free();
+  }
+  return found;
+}
+
+GBool Catalog::hasSignatureFields()
+{
+  Object sigFlags, fields;
+  std::set<int> visited;
+  GBool found;
+
+  if (!acroForm.isDict()) {
+    return gFalse;
+  }
+
+  // bit 1 is SignaturesExist
+  acroForm.dictLookup("SigFlags", &sigFlags);
+  found = sigFlags.isInt() && (sigFlags.getInt() & 1);
+  sigFlags.free();
+  if (!found && acroForm.dictLookup("Fields", &fields)->isArray()) {
+    found = hasSignatureField(&fields, gFalse, &visited);
+  }
+  fields.free();
+  return found;
+}
+
 ViewerPreferences *Catalog::getViewerPreferences()
 {
   catalogLocker();
@@ -115,9 +115,14 @@ public:
   // Get number of pages.
   int getNumPages();
 
-  // Get a page.
+  // Get a page.  Pages are only built when first asked for.
   Page *getPage(int i);
 
+  // Free page <i> if it has been built; it is built again the next
+  // time it is asked for.  Any Page pointer previously returned for it
+  // becomes invalid.
+  void releasePage(int i);
+
   // Get the reference for a page object.
   Ref *getPageRef(int i);
 
@@ -183,6 +188,11 @@ public:
   FormType getFormType();
   Form* getForm();
 
+  // Returns true if the document has a signature field, signed or not,
+  // from the SigFlags and the field tree of the AcroForm alone: unlike
+  // PDFDoc::getSignatureWidgets, no page or form widget is loaded.
+  GBool hasSignatureFields();
+
   ViewerPreferences *getViewerPreferences();
 
   enum PageMode {
@@ -226,12 +236,16 @@ private:
 
   PDFDoc *doc;
   XRef *xref;			// the xref table for this PDF file
-  Page **pages;			// array of pages
+  Page **pages;			// array of pages, NULL until built
   Ref *pageRefs;		// object ID for each page
+  int *pageParents;		// index in pagesAttrs of the attributes
+				//   each page inherits, or -1
   int lastCachedPage;
+  std::vector<PageAttrs *> *pagesAttrs; // attributes of each Pages node
   std::vector<Dict *> *pagesList;
   std::vector<Ref> *pagesRefList;
-  std::vector<PageAttrs *> *attrsList;
+  std::vector<int> *attrsIdxList;	// index in pagesAttrs of each
+					//   node in pagesList
   std::vector<int> *kidsIdxList;
   Form *form;
   ViewerPreferences *viewerPrefs;
@@ -256,7 +270,8 @@ private:
   PageLayout pageLayout;	// page layout
   Object additionalActions;     // page additional actions
 
-  GBool cachePageTree(int page); // Cache first <page> pages.
+  GBool cachePageTree(int page); // Index first <page> pages.
+  Page *loadPage(int i);
   Object *findDestInTree(Object *tree, GooString *name, Object *obj);
 
   Object *getNames();
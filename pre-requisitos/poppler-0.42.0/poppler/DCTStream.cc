@@ -22,22 +22,20 @@ static void str_init_source(j_decompress_ptr cinfo)
 
 static boolean str_fill_input_buffer(j_decompress_ptr cinfo)
 {
-  int c;
+  int n;
   struct str_src_mgr * src = (struct str_src_mgr *)cinfo->src;
+  // give back the start marker reset() consumed looking for it
   if (src->index == 0) {
-    c = 0xFF;
-    src->index++;
+    src->buffer[0] = 0xFF;
+    src->buffer[1] = 0xD8;
+    src->index = 2;
+    n = 2;
   }
-  else if (src->index == 1) {
-    c = 0xD8;
-    src->index++;
-  }
-  else c = src->str->getChar();
-  if (c != EOF)
+  else n = src->str->doGetChars(src->bufSize, src->buffer);
+  if (n > 0)
   {
-    src->buffer = c;
-    src->pub.next_input_byte = &src->buffer;
-    src->pub.bytes_in_buffer = 1;
+    src->pub.next_input_byte = src->buffer;
+    src->pub.bytes_in_buffer = n;
     return TRUE;
   }
   else return FALSE;
@@ -49,7 +47,9 @@ static void str_skip_input_data(j_decompress_ptr cinfo, long num_bytes)
   if (num_bytes > 0) {
     while (num_bytes > (long) src->pub.bytes_in_buffer) {
       num_bytes -= (long) src->pub.bytes_in_buffer;
-      str_fill_input_buffer(cinfo);
+      src->pub.bytes_in_buffer = 0;
+      if (!str_fill_input_buffer(cinfo))
+        return;
     }
     src->pub.next_input_byte += (size_t) num_bytes;
     src->pub.bytes_in_buffer -= (size_t) num_bytes;
@@ -106,6 +106,8 @@ void DCTStream::init()
   src.pub.next_input_byte = NULL;
   src.str = str;
   src.index = 0;
+  // inline images must not be read past their end, where the EI is
+  src.bufSize = dynamic_cast<EmbedStream *>(str->getBaseStream()) ? 1 : dctStreamBufSize;
   current = NULL;
   limit = NULL;
   
@@ -199,52 +201,81 @@ void DCTStream::reset() {
   }
 }
 
-// we can not go with inline since gcc
-// refuses to inline because of setjmp
-#define DO_GET_CHAR \
-  if (current == limit) { \
-    if (cinfo.output_scanline < cinfo.output_height) \
-    { \
-      if (!setjmp(err.setjmp_buffer)) \
-      { \
-        if (!jpeg_read_scanlines(&cinfo, row_buffer, 1)) c = EOF; \
-        else { \
-          current = &row_buffer[0][0]; \
-          limit = &row_buffer[0][(cinfo.output_width - 1) * cinfo.output_components] + cinfo.output_components; \
-          c = *current; \
-          ++current; \
-        } \
-      } \
-      else c = EOF; \
-    } \
-    else c = EOF; \
-  } else { \
-    c = *current; \
-    ++current; \
-  } \
+// Decode the next line into row_buffer.
+GBool DCTStream::readLine() {
+  if (!row_buffer || cinfo.output_scanline >= cinfo.output_height)
+    return gFalse;
+  if (setjmp(err.setjmp_buffer))
+    return gFalse;
+  if (!jpeg_read_scanlines(&cinfo, row_buffer, 1))
+    return gFalse;
+  current = &row_buffer[0][0];
+  limit = current + cinfo.output_width * cinfo.output_components;
+  return gTrue;
+}
 
-int DCTStream::getChar() {
-  int c;
+// Decode up to nLines lines straight into buffer, returning how many
+// were decoded.
+int DCTStream::readLines(Guchar *buffer, int nLines) {
+  JSAMPROW rows[16];
+  JDIMENSION first;
+  int rowSize, i;
 
-  DO_GET_CHAR
-  
-  return c;
+  if (!row_buffer || cinfo.output_scanline >= cinfo.output_height)
+    return 0;
+  if (nLines > 16)
+    nLines = 16;
+  rowSize = cinfo.output_width * cinfo.output_components;
+  for (i = 0; i < nLines; ++i)
+    rows[i] = buffer + i * rowSize;
+  first = cinfo.output_scanline;
+  if (!setjmp(err.setjmp_buffer)) {
+    while (cinfo.output_scanline - first < (JDIMENSION)nLines &&
+           cinfo.output_scanline < cinfo.output_height) {
+      if (!jpeg_read_scanlines(&cinfo, rows + (cinfo.output_scanline - first),
+                               nLines - (cinfo.output_scanline - first)))
+        break;
+    }
+  }
+  return cinfo.output_scanline - first;
+}
+
+int DCTStream::getChar() {
+  if (current == limit && !readLine())
+    return EOF;
+  return *current++;
 }
 
 int DCTStream::getChars(int nChars, Guchar *buffer) {
-  int c;
-  for (int i = 0; i < nChars; ++i) {
-    DO_GET_CHAR
-    if (likely(c != EOF)) buffer[i] = c;
-    else return i;
+  int n, m, rowSize;
+
+  n = 0;
+  while (n < nChars) {
+    if (current == limit) {
+      // whole lines go straight to the caller
+      rowSize = cinfo.output_width * cinfo.output_components;
+      if (row_buffer && rowSize > 0 && nChars - n >= rowSize) {
+        if ((m = readLines(buffer + n, (nChars - n) / rowSize)) == 0)
+          break;
+        n += m * rowSize;
+        continue;
+      }
+      if (!readLine())
+        break;
+    }
+    m = limit - current;
+    if (m > nChars - n)
+      m = nChars - n;
+    memcpy(buffer + n, current, m);
+    current += m;
+    n += m;
   }
-  return nChars;
+  return n;
 }
 
 int DCTStream::lookChar() {
-  if (unlikely(current == NULL)) {
+  if (current == limit && !readLine())
     return EOF;
-  }
   return *current;
 }
 
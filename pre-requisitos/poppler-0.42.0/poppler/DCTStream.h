@@ -47,9 +47,12 @@ extern "C" {
 #include <jerror.h>
 }
 
+#define dctStreamBufSize 4096
+
 struct str_src_mgr {
     struct jpeg_source_mgr pub;
-    JOCTET buffer;
+    JOCTET buffer[dctStreamBufSize];
+    int bufSize;		// bytes read at a time, 1 for inline images
     Stream *str;
     int index;
 };
@@ -75,6 +78,8 @@ public:
 
 private:
   void init();
+  GBool readLine();
+  int readLines(Guchar *buffer, int nLines);
 
   virtual GBool hasGetChars() { return true; }
   virtual int getChars(int nChars, Guchar *buffer);
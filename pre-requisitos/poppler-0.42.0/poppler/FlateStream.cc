@@ -20,124 +20,112 @@
 
 #if ENABLE_ZLIB_UNCOMPRESS
 
-#include "FlateStream.h"
+#include <string.h>
+#include "goo/gmem.h"
+#include "Object.h"
+#include "Stream.h"
 
-FlateStream::FlateStream(Stream *strA, int predictor, int columns, int colors, int bits) :
-  FilterStream(strA)
-{
-  if (predictor != 1) {
-    pred = new StreamPredictor(this, predictor, columns, colors, bits);
-  } else {
-    pred = NULL;
-  }
-  out_pos = 0;
-  memset(&d_stream, 0, sizeof(d_stream));
-  inflateInit(&d_stream);
-}
-
-FlateStream::~FlateStream() {
-  inflateEnd(&d_stream);
-  delete pred;
-  delete str;
+extern "C" {
+#include <zlib.h>
 }
 
-void FlateStream::reset() {
-  //FIXME: what are the semantics of reset?
-  //i.e. how much intialization has to happen in the constructor?
+//------------------------------------------------------------------------
+// FlateStream, zlib backend
+//------------------------------------------------------------------------
 
-  /* reinitialize zlib */
-  inflateEnd(&d_stream);
-  memset(&d_stream, 0, sizeof(d_stream));
-  inflateInit(&d_stream);
+#define zlibInSize 16384
 
-  str->reset();
-  d_stream.avail_in = 0;
-  status = Z_OK;
-  out_pos = 0;
-  out_buf_len = 0;
-}
-
-int FlateStream::getRawChar() {
-  return doGetRawChar();
-}
+// Start inflating the (already reset) stream with zlib.  Returns false
+// if the built-in decoder has to do it.
+GBool FlateStream::zlibReset() {
+  z_stream *zs;
 
-void FlateStream::getRawChars(int nChars, int *buffer) {
-  for (int i = 0; i < nChars; ++i)
-    buffer[i] = doGetRawChar();
-}
-
-int FlateStream::getChar() {
-  if (pred)
-    return pred->getChar();
-  else
-    return getRawChar();
+  if (!useZlib) {
+    return gFalse;
+  }
+  if (!zstream) {
+    zs = (z_stream *)gmalloc(sizeof(z_stream));
+    memset(zs, 0, sizeof(z_stream));
+    if (inflateInit(zs) != Z_OK) {
+      gfree(zs);
+      useZlib = gFalse;
+      return gFalse;
+    }
+    zstream = zs;
+    zlibIn = (Guchar *)gmalloc(zlibInSize);
+  } else {
+    zs = (z_stream *)zstream;
+    inflateReset(zs);
+  }
+  zs->next_in = zlibIn;
+  zs->avail_in = 0;
+  zlibOut = 0;
+  zlibActive = gTrue;
+  endOfBlock = eof = gFalse;
+  return gTrue;
 }
 
-int FlateStream::lookChar() {
-  if (pred)
-    return pred->lookChar();
-
-  if (fill_buffer())
-    return EOF;
+// Inflate up to a window of data into buf.
+void FlateStream::zlibReadSome() {
+  z_stream *zs = (z_stream *)zstream;
+  Goffset skip;
+  int n, status;
 
-  return out_buf[out_pos];
-}
-
-int FlateStream::fill_buffer() {
-  /* only fill the buffer if it has all been used */
-  if (out_pos >= out_buf_len) {
-    /* check if the flatestream has been exhausted */
-    if (status == Z_STREAM_END) {
-      return -1;
+  zs->next_out = buf;
+  zs->avail_out = flateWindow;
+  status = Z_OK;
+  while (zs->avail_out > 0) {
+    if (zs->avail_in == 0) {
+      if ((n = str->doGetChars(zlibInSize, zlibIn)) == 0) {
+	break;
+      }
+      zs->next_in = zlibIn;
+      zs->avail_in = n;
+    }
+    if ((status = inflate(zs, Z_NO_FLUSH)) != Z_OK) {
+      break;
     }
+  }
 
-    /* set to the begining of out_buf */
-    d_stream.avail_out = sizeof(out_buf);
-    d_stream.next_out = out_buf;
-    out_pos = 0;
-
-    while (1) {
-      /* buffer is empty so we need to fill it */
-      if (d_stream.avail_in == 0) {
-	int c;
-	/* read from the source stream */
-	while (d_stream.avail_in < sizeof(in_buf) && (c = str->getChar()) != EOF) {
-	  in_buf[d_stream.avail_in++] = c;
+  if (status != Z_OK && status != Z_STREAM_END) {
+    // malformed stream: decode it again with the built-in decoder,
+    // which is more forgiving, and drop what was already returned
+    skip = zlibOut;
+    zlibFallBack();
+    reset();
+    for (; skip > 0; --skip) {
+      while (remain == 0) {
+	if (endOfBlock && eof) {
+	  return;
 	}
-	d_stream.next_in = in_buf;
+	readSome();
       }
-
-      /* keep decompressing until we can't anymore */
-      if (d_stream.avail_out == 0 || d_stream.avail_in == 0 || (status != Z_OK && status != Z_BUF_ERROR))
-	break;
-      status = inflate(&d_stream, Z_SYNC_FLUSH);
+      index = (index + 1) & flateMask;
+      --remain;
     }
-
-    out_buf_len = sizeof(out_buf) - d_stream.avail_out;
-    if (status != Z_OK && status != Z_STREAM_END)
-      return -1;
-    if (!out_buf_len)
-      return -1;
+    return;
   }
 
-  return 0;
-}
-
-GooString *FlateStream::getPSFilter(int psLevel, const char *indent) {
-  GooString *s;
-
-  if (psLevel < 3 || pred) {
-    return NULL;
-  }
-  if (!(s = str->getPSFilter(psLevel, indent))) {
-    return NULL;
+  index = 0;
+  remain = flateWindow - zs->avail_out;
+  zlibOut += remain;
+  // the stream ended, or was truncated: keep what could be inflated
+  if (status == Z_STREAM_END || zs->avail_out > 0) {
+    endOfBlock = eof = gTrue;
   }
-  s->append(indent)->append("<< >> /FlateDecode filter\n");
-  return s;
 }
 
-GBool FlateStream::isBinary(GBool last) {
-  return str->isBinary(gTrue);
+// Stop using zlib for this stream.
+void FlateStream::zlibFallBack() {
+  if (zstream) {
+    inflateEnd((z_stream *)zstream);
+    gfree(zstream);
+    zstream = NULL;
+  }
+  gfree(zlibIn);
+  zlibIn = NULL;
+  useZlib = gFalse;
+  zlibActive = gFalse;
 }
 
 #endif
@@ -32,6 +32,7 @@
 #include <stddef.h>
 #include <string.h>
 #include <math.h>
+#include <algorithm>
 #include "GlobalParams.h"
 #include "Error.h"
 #include "Object.h"
@@ -44,9 +45,15 @@
 FontInfoScanner::FontInfoScanner(PDFDoc *docA, int firstPage) {
   doc = docA;
   currentPage = firstPage + 1;
+  pageXRef = NULL;
 }
 
 FontInfoScanner::~FontInfoScanner() {
+  for (std::map<int, FontInfo *>::iterator it = fontInfos.begin();
+       it != fontInfos.end(); ++it) {
+    delete it->second;
+  }
+  delete pageXRef;
 }
 
 GooList *FontInfoScanner::scan(int nPages) {
@@ -92,6 +99,147 @@ GooList *FontInfoScanner::scan(int nPages) {
   return result;
 }
 
+GooList *FontInfoScanner::scanPage(int pg) {
+  Page *page;
+  Dict *resDict;
+  Annots *annots;
+  Object obj1;
+  std::vector<int> fontNums;
+  std::set<int> pageFonts;
+
+  if (pg < 1 || pg > doc->getNumPages() || !(page = doc->getPage(pg))) {
+    return NULL;
+  }
+  if (!pageXRef) {
+    pageXRef = doc->getXRef()->copy();
+  }
+
+  GooList *result = new GooList();
+  if ((resDict = page->getResourceDictCopy(pageXRef))) {
+    collectFonts(resDict, &fontNums, result);
+    delete resDict;
+  }
+  annots = page->getAnnots();
+  for (int i = 0; i < annots->getNumAnnots(); ++i) {
+    if (annots->getAnnot(i)->getAppearanceResDict(&obj1)->isDict()) {
+      collectFonts(obj1.getDict(), &fontNums, result);
+    }
+    obj1.free();
+  }
+
+  for (size_t i = 0; i < fontNums.size(); ++i) {
+    FontInfo *info = fontInfos[fontNums[i]];
+    if (info && pageFonts.insert(fontNums[i]).second) {
+      result->append(new FontInfo(*info));
+    }
+  }
+  return result;
+}
+
+// Appends to fontNums the object numbers of the fonts used through
+// resDict, reading those not met before, and to directFonts the info of
+// the fonts that are not indirect objects.
+void FontInfoScanner::collectFonts(Dict *resDict, std::vector<int> *fontNums,
+				   GooList *directFonts) {
+  Object obj1, obj2, fontDictObj, objDict, resObj;
+  Dict *fontDict;
+  Ref fontDictRef, r;
+  GfxFont *font;
+  int i;
+
+  // the fonts in this resource dictionary
+  resDict->lookupNF("Font", &obj1);
+  obj1.fetch(pageXRef, &fontDictObj);
+  if (fontDictObj.isDict()) {
+    fontDict = fontDictObj.getDict();
+    for (i = 0; i < fontDict->getLength(); ++i) {
+      fontDict->getValNF(i, &obj2);
+      if (obj2.isRef() && fontInfos.count(obj2.getRefNum())) {
+	fontNums->push_back(obj2.getRefNum());
+	obj2.free();
+	continue;
+      }
+      obj2.fetch(pageXRef, &resObj);
+      font = NULL;
+      if (resObj.isDict()) {
+	if (obj2.isRef()) {
+	  r = obj2.getRef();
+	} else {
+	  // as GfxFontDict does for a font without an indirect reference
+	  r.num = i;
+	  if (obj1.isRef()) {
+	    fontDictRef = obj1.getRef();
+	    r.gen = 100000 + fontDictRef.num;
+	  } else {
+	    r.gen = 999999;
+	  }
+	}
+	font = GfxFont::makeFont(pageXRef, fontDict->getKey(i), r,
+				 resObj.getDict());
+	if (font && !font->isOk()) {
+	  font->decRefCnt();
+	  font = NULL;
+	}
+      }
+      if (obj2.isRef()) {
+	fontInfos[obj2.getRefNum()] = font ? new FontInfo(font, pageXRef) : NULL;
+	fontNums->push_back(obj2.getRefNum());
+      } else if (font) {
+	directFonts->append(new FontInfo(font, pageXRef));
+      }
+      if (font) {
+	font->decRefCnt();
+      }
+      resObj.free();
+      obj2.free();
+    }
+  }
+  fontDictObj.free();
+  obj1.free();
+
+  // the fonts of the forms and patterns of this resource dictionary,
+  // remembered by reference
+  const char *resTypes[] = { "XObject", "Pattern" };
+  for (Guint resType = 0; resType < sizeof(resTypes) / sizeof(resTypes[0]); ++resType) {
+    resDict->lookup(resTypes[resType], &objDict);
+    if (objDict.isDict()) {
+      for (i = 0; i < objDict.dictGetLength(); ++i) {
+	objDict.dictGetValNF(i, &obj1);
+	if (obj1.isRef()) {
+	  std::map<int, std::vector<int> >::iterator it =
+	      resourceFonts.find(obj1.getRefNum());
+	  if (it != resourceFonts.end()) {
+	    fontNums->insert(fontNums->end(), it->second.begin(), it->second.end());
+	    obj1.free();
+	    continue;
+	  }
+	  // an entry before the scan keeps a form that uses itself from
+	  // being scanned again
+	  resourceFonts[obj1.getRefNum()];
+	}
+	std::vector<int> objFonts;
+	obj1.fetch(pageXRef, &obj2);
+	if (obj2.isStream()) {
+	  obj2.streamGetDict()->lookup("Resources", &resObj);
+	  if (resObj.isDict() && resObj.getDict() != resDict) {
+	    collectFonts(resObj.getDict(), &objFonts, directFonts);
+	  }
+	  resObj.free();
+	}
+	if (obj1.isRef()) {
+	  std::sort(objFonts.begin(), objFonts.end());
+	  objFonts.erase(std::unique(objFonts.begin(), objFonts.end()), objFonts.end());
+	  resourceFonts[obj1.getRefNum()] = objFonts;
+	}
+	fontNums->insert(fontNums->end(), objFonts.begin(), objFonts.end());
+	obj1.free();
+	obj2.free();
+      }
+    }
+    objDict.free();
+  }
+}
+
 void FontInfoScanner::scanFonts(XRef *xrefA, Dict *resDict, GooList *fontsList) {
   Object obj1, obj2, objDict, resObj;
   Ref r;
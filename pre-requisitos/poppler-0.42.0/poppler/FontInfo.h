@@ -29,6 +29,10 @@
 #include "goo/gtypes.h"
 #include "goo/GooList.h"
 
+#include <map>
+#include <set>
+#include <vector>
+
 class GfxFont;
 class PDFDoc;
 
@@ -90,6 +94,15 @@ public:
 
   GooList *scan(int nPages);
 
+  // Returns the fonts used by page pg (1-based), including those of its
+  // forms, patterns and annotation appearances, or NULL if there is no
+  // such page. Unlike scan, each call lists every font of its page, and
+  // pages may come in any order. The fonts, forms and patterns met on
+  // earlier calls, by reference, are not read again, so that the pages of
+  // a document are best scanned with one scanner per thread, each on its
+  // own copy of the document.
+  GooList *scanPage(int pg);
+
 private:
 
   PDFDoc *doc;
@@ -97,7 +110,16 @@ private:
   std::set<int> fonts;
   std::set<int> visitedObjects;
 
+  // State of scanPage: its copy of the xref, made on first use, the info
+  // of each font by object number (NULL if it can't be read), and the
+  // object numbers of the fonts used by each form or pattern.
+  XRef *pageXRef;
+  std::map<int, FontInfo *> fontInfos;
+  std::map<int, std::vector<int> > resourceFonts;
+
   void scanFonts(XRef *xrefA, Dict *resDict, GooList *fontsList);
+  void collectFonts(Dict *resDict, std::vector<int> *fontNums,
+		    GooList *directFonts);
 };
 
 #endif
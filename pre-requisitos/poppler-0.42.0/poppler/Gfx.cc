@@ -4266,8 +4266,14 @@ void Gfx::doImage(Object *ref, Stream *str, GBool inlineImg) {
   GBool maskInterpolate;
   Stream *maskStr;
   Object obj1, obj2;
+  double *ctm;
   int i, n;
 
+  // let the decoder know the size the image is drawn at
+  ctm = state->getCTM();
+  str->setDrawSize(sqrt(ctm[0] * ctm[0] + ctm[1] * ctm[1]),
+		   sqrt(ctm[2] * ctm[2] + ctm[3] * ctm[3]));
+
   // get info from the stream
   bits = 0;
   csMode = streamCSNone;
@@ -622,6 +622,8 @@ GlobalParams::GlobalParams(const char *customPopplerDataDir)
   printCommands = gFalse;
   profileCommands = gFalse;
   errQuiet = gFalse;
+  jpxThreads = 1;
+  jpxReduce = gFalse;
 
   cidToUnicodeCache = new CharCodeToUnicodeCache(cidToUnicodeCacheSize);
   unicodeToUnicodeCache =
@@ -1692,6 +1694,24 @@ GBool GlobalParams::getErrQuiet() {
   return errQuiet;
 }
 
+int GlobalParams::getJpxThreads() {
+  int threads;
+
+  lockGlobalParams;
+  threads = jpxThreads;
+  unlockGlobalParams;
+  return threads;
+}
+
+GBool GlobalParams::getJpxReduce() {
+  GBool reduce;
+
+  lockGlobalParams;
+  reduce = jpxReduce;
+  unlockGlobalParams;
+  return reduce;
+}
+
 CharCodeToUnicode *GlobalParams::getCIDToUnicode(GooString *collection) {
   GooString *fileName;
   CharCodeToUnicode *ctu;
@@ -1968,6 +1988,18 @@ void GlobalParams::setErrQuiet(GBool errQuietA) {
   unlockGlobalParams;
 }
 
+void GlobalParams::setJpxThreads(int jpxThreadsA) {
+  lockGlobalParams;
+  jpxThreads = jpxThreadsA;
+  unlockGlobalParams;
+}
+
+void GlobalParams::setJpxReduce(GBool jpxReduceA) {
+  lockGlobalParams;
+  jpxReduce = jpxReduceA;
+  unlockGlobalParams;
+}
+
 void GlobalParams::addSecurityHandler(XpdfSecurityHandler *handler) {
 #ifdef ENABLE_PLUGINS
   lockGlobalParams;
@@ -185,6 +185,8 @@ public:
   GBool getPrintCommands();
   GBool getProfileCommands();
   GBool getErrQuiet();
+  int getJpxThreads();
+  GBool getJpxReduce();
 
   CharCodeToUnicode *getCIDToUnicode(GooString *collection);
   CharCodeToUnicode *getUnicodeToUnicode(GooString *fontName);
@@ -224,6 +226,8 @@ public:
   void setPrintCommands(GBool printCommandsA);
   void setProfileCommands(GBool profileCommandsA);
   void setErrQuiet(GBool errQuietA);
+  void setJpxThreads(int jpxThreadsA);
+  void setJpxReduce(GBool jpxReduceA);
 
   static GBool parseYesNo2(const char *token, GBool *flag);
 
@@ -311,6 +315,9 @@ private:
   GBool printCommands;		// print the drawing commands
   GBool profileCommands;	// profile the drawing commands
   GBool errQuiet;		// suppress error messages?
+  int jpxThreads;		// threads decoding each JPEG 2000 image
+  GBool jpxReduce;		// decode JPEG 2000 images only to the
+				//   resolution they are drawn at?
   double splashResolution;	// resolution when rasterizing images
 
   CharCodeToUnicodeCache *cidToUnicodeCache;
@@ -105,6 +105,29 @@ inline Guint JArithmeticDecoder::readByte() {
   return (Guint)str->getChar() & 0xff;
 }
 
+// RENORMD: shift a and c left until the top bit of a is set.  The
+// shift is done as many bits at a time as the current byte allows
+// instead of one bit per iteration.
+inline void JArithmeticDecoder::renormD() {
+  int n, k;
+
+#if defined(__GNUC__)
+  n = __builtin_clz(a);
+#else
+  for (n = 0; !(a & (0x80000000 >> n)); ++n) ;
+#endif
+  while (n > 0) {
+    if (ct == 0) {
+      byteIn();
+    }
+    k = n < ct ? n : ct;
+    a <<= k;
+    c <<= k;
+    ct -= k;
+    n -= k;
+  }
+}
+
 JArithmeticDecoder::~JArithmeticDecoder() {
   cleanup();
 }
@@ -195,15 +218,7 @@ int JArithmeticDecoder::decodeBit(Guint context,
 	bit = mpsCX;
 	stats->cxTab[context] = (nmpsTab[iCX] << 1) | mpsCX;
       }
-      // RENORMD
-      do {
-	if (ct == 0) {
-	  byteIn();
-	}
-	a <<= 1;
-	c <<= 1;
-	--ct;
-      } while (!(a & 0x80000000));
+      renormD();
     }
   } else {
     c -= a;
@@ -220,15 +235,7 @@ int JArithmeticDecoder::decodeBit(Guint context,
       }
     }
     a = qe;
-    // RENORMD
-    do {
-      if (ct == 0) {
-	byteIn();
-      }
-      a <<= 1;
-      c <<= 1;
-      --ct;
-    } while (!(a & 0x80000000));
+    renormD();
   }
   return bit;
 }
@@ -88,6 +88,7 @@ public:
 private:
 
   Guint readByte();
+  void renormD();
   int decodeIntBit(JArithmeticDecoderStats *stats);
   void byteIn();
 
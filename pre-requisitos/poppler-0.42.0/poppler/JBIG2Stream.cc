@@ -2924,6 +2924,27 @@ inline void JBIG2Stream::mmrAddPixelsNeg(int a1, int blackPixels,
   }
 }
 
+// Set pixels x0 <= x < x1 of a bitmap line, a byte at a time.
+static inline void mmrFillRun(Guchar *line, int x0, int x1) {
+  int b0, b1;
+  Guchar m0, m1;
+
+  if (x0 >= x1) {
+    return;
+  }
+  b0 = x0 >> 3;
+  b1 = (x1 - 1) >> 3;
+  m0 = (Guchar)(0xff >> (x0 & 7));
+  m1 = (Guchar)(0xff << (7 - ((x1 - 1) & 7)));
+  if (b0 == b1) {
+    line[b0] |= m0 & m1;
+    return;
+  }
+  line[b0] |= m0;
+  memset(line + b0 + 1, 0xff, b1 - b0 - 1);
+  line[b1] |= m1;
+}
+
 JBIG2Bitmap *JBIG2Stream::readGenericBitmap(GBool mmr, int w, int h,
 					    int templ, GBool tpgdOn,
 					    GBool useSkip, JBIG2Bitmap *skip,
@@ -3143,9 +3164,8 @@ JBIG2Bitmap *JBIG2Stream::readGenericBitmap(GBool mmr, int w, int h,
       // convert the run lengths to a bitmap line
       i = 0;
       while (1) {
-	for (x = codingLine[i]; x < codingLine[i+1]; ++x) {
-	  bitmap->setPixel(x, y);
-	}
+	mmrFillRun(bitmap->getDataPtr() + y * bitmap->getLineSize(),
+		   codingLine[i], codingLine[i+1]);
 	if (codingLine[i+1] >= w || codingLine[i+2] >= w) {
 	  break;
 	}
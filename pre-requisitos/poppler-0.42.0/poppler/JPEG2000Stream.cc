@@ -17,6 +17,7 @@
 
 #include "config.h"
 #include "JPEG2000Stream.h"
+#include "GlobalParams.h"
 #include <openjpeg.h>
 
 #define OPENJPEG_VERSION_ENCODE(major, minor, micro) (	\
@@ -44,6 +45,10 @@ struct JPXStreamPrivate {
   GBool indexed;
   GBool inited;
   int smaskInData;
+  int reduce;			// number of resolution levels not decoded
+  int width, height;		// size of the image in the dictionary
+  Guchar *expanded;		// components of a reduced image brought
+				//   back to width x height, or NULL
 #ifdef USE_OPENJPEG1
   opj_dinfo_t *dinfo;
   void init2(unsigned char *buf, int bufLen, OPJ_CODEC_FORMAT format, GBool indexed);
@@ -71,9 +76,47 @@ static inline int doLookChar(JPXStreamPrivate* priv) {
   if (unlikely(priv->counter >= priv->npixels))
     return EOF;
 
+  if (priv->expanded)
+    return priv->expanded[priv->ccounter * priv->npixels + priv->counter];
   return ((unsigned char *)priv->image->comps[priv->ccounter].data)[priv->counter];
 }
 
+// Largest number of resolution levels left out of a decode, keeping
+// enough of the image to read at the drawn size.
+#define MAX_JPX_REDUCE 5
+
+// Bring the 8 bit components of an image decoded at a reduced resolution
+// back to the size in the image dictionary, by replicating pixels.
+static void expandReduced(JPXStreamPrivate *priv) {
+  int rw = priv->image->comps[0].w;
+  int rh = priv->image->comps[0].h;
+  int w = priv->width, h = priv->height;
+  if (priv->reduce == 0 || (rw == w && rh == h) || rw < 1 || rh < 1)
+    return;
+  for (int component = 1; component < priv->ncomps; component++) {
+    if ((int)priv->image->comps[component].w != rw ||
+	(int)priv->image->comps[component].h != rh)
+      return;
+  }
+  priv->expanded = (Guchar *)gmallocn3_checkoverflow(priv->ncomps, w, h);
+  if (!priv->expanded)
+    return;
+  int *xMap = (int *)gmallocn(w, sizeof(int));
+  for (int x = 0; x < w; x++)
+    xMap[x] = (int)((long long)x * rw / w);
+  Guchar *p = priv->expanded;
+  for (int component = 0; component < priv->ncomps; component++) {
+    unsigned char *cdata = (unsigned char *)priv->image->comps[component].data;
+    for (int y = 0; y < h; y++) {
+      unsigned char *row = cdata + (long long)y * rh / h * rw;
+      for (int x = 0; x < w; x++)
+	*p++ = row[xMap[x]];
+    }
+  }
+  gfree(xMap);
+  priv->npixels = w * h;
+}
+
 static inline int doGetChar(JPXStreamPrivate* priv) {
   const int result = doLookChar(priv);
   if (++priv->ccounter == priv->ncomps) {
@@ -90,6 +133,9 @@ JPXStream::JPXStream(Stream *strA) : FilterStream(strA) {
   priv->npixels = 0;
   priv->ncomps = 0;
   priv->indexed = gFalse;
+  priv->reduce = 0;
+  priv->width = priv->height = 0;
+  priv->expanded = NULL;
 #ifdef USE_OPENJPEG1
   priv->dinfo = NULL;
 #endif
@@ -112,6 +158,8 @@ void JPXStream::close() {
     priv->image = NULL;
     priv->npixels = 0;
   }
+  gfree(priv->expanded);
+  priv->expanded = NULL;
 
 #ifdef USE_OPENJPEG1
   if (priv->dinfo != NULL) {
@@ -181,6 +229,34 @@ void JPXStream::getImageParams(int *bitsPerComponent, StreamColorSpaceMode *csMo
 }
 
 
+void JPXStream::setDrawSize(double width, double height) {
+  if (!globalParams->getJpxReduce() || !getDict() || width <= 0 || height <= 0)
+    return;
+  Object obj;
+  int w = 0, h = 0;
+  if (getDict()->lookup("Width", &obj)->isInt()) w = obj.getInt();
+  obj.free();
+  if (getDict()->lookup("Height", &obj)->isInt()) h = obj.getInt();
+  obj.free();
+  if (w < 1 || h < 1)
+    return;
+  // Each level halves the resolution.
+  double ratio = w / width < h / height ? w / width : h / height;
+  int reduce = 0;
+  while (reduce < MAX_JPX_REDUCE && (2 << reduce) <= ratio)
+    reduce++;
+  if (priv->inited) {
+    // Decoded already, at a high enough resolution?
+    if (reduce >= priv->reduce)
+      return;
+    close();
+    priv->inited = gFalse;
+  }
+  priv->reduce = reduce;
+  priv->width = w;
+  priv->height = h;
+}
+
 static void libopenjpeg_error_callback(const char *msg, void * /*client_data*/) {
   error(errSyntaxError, -1, "{0:s}", msg);
 }
@@ -219,6 +295,12 @@ void JPXStream::init()
   int length = 0;
   unsigned char *buf = str->toUnsignedChars(&length, bufSize);
   priv->init2(buf, length, CODEC_JP2, priv->indexed);
+  if (!priv->image && priv->reduce > 0) {
+    // Maybe fewer resolution levels than left out, decode them all.
+    close();
+    priv->reduce = 0;
+    priv->init2(buf, length, CODEC_JP2, priv->indexed);
+  }
   free(buf);
 
   if (priv->image) {
@@ -252,6 +334,7 @@ void JPXStream::init()
 	*(cdata++) = adjustComp(r, adjust, depth, sgndcorr, priv->indexed);
       }
     }
+    if (priv->image) expandReduced(priv);
   } else
     priv->npixels = 0;
 
@@ -271,6 +354,7 @@ void JPXStreamPrivate::init2(unsigned char *buf, int bufLen, OPJ_CODEC_FORMAT fo
   if (indexed)
     parameters.flags = OPJ_DPARAMETERS_IGNORE_PCLR_CMAP_CDEF_FLAG;
 #endif
+  parameters.cp_reduce = reduce;
 
   /* Configure the event manager to receive errors and warnings */
   opj_event_mgr_t event_mgr;
@@ -386,6 +470,11 @@ void JPXStream::init()
   int length = 0;
   unsigned char *buf = str->toUnsignedChars(&length, bufSize);
   priv->init2(OPJ_CODEC_JP2, buf, length, priv->indexed);
+  if (!priv->image && priv->reduce > 0) {
+    // Maybe fewer resolution levels than left out, decode them all.
+    priv->reduce = 0;
+    priv->init2(OPJ_CODEC_JP2, buf, length, priv->indexed);
+  }
   gfree(buf);
 
   if (priv->image) {
@@ -419,6 +508,7 @@ void JPXStream::init()
 	*(cdata++) = adjustComp(r, adjust, depth, sgndcorr, priv->indexed);
       }
     }
+    if (priv->image) expandReduced(priv);
   } else {
     priv->npixels = 0;
   }
@@ -459,6 +549,7 @@ void JPXStreamPrivate::init2(OPJ_CODEC_FORMAT format, unsigned char *buf, int le
   opj_set_default_decoder_parameters(&parameters);
   if (indexed)
     parameters.flags |= OPJ_DPARAMETERS_IGNORE_PCLR_CMAP_CDEF_FLAG;
+  parameters.cp_reduce = reduce;
 
   /* Get the decoder handle of the format */
   decoder = opj_create_decompress(format);
@@ -467,6 +558,13 @@ void JPXStreamPrivate::init2(OPJ_CODEC_FORMAT format, unsigned char *buf, int le
     goto error;
   }
 
+#if OPENJPEG_VERSION >= OPENJPEG_VERSION_ENCODE(2, 2, 0)
+  /* Decode the code blocks on several threads, if openjpeg was built
+     with thread support */
+  if (globalParams->getJpxThreads() > 1)
+    opj_codec_set_threads(decoder, globalParams->getJpxThreads());
+#endif
+
   /* Catch events using our callbacks */
   opj_set_warning_handler(decoder, libopenjpeg_warning_callback, NULL);
   opj_set_error_handler(decoder, libopenjpeg_error_callback, NULL);
@@ -38,6 +38,7 @@ public:
   virtual GooString *getPSFilter(int psLevel, const char *indent);
   virtual GBool isBinary(GBool last = gTrue);
   virtual void getImageParams(int *bitsPerComponent, StreamColorSpaceMode *csMode);
+  virtual void setDrawSize(double width, double height);
 
   int readStream(int nChars, Guchar *buffer) {
     return str->doGetChars(nChars, buffer);
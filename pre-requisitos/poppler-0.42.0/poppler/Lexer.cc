@@ -69,11 +69,73 @@ static const long long LongLongSafeLimit = (LLONG_MAX - 9) / 10;
 // Lexer
 //------------------------------------------------------------------------
 
+//------------------------------------------------------------------------
+// LexerStream
+//------------------------------------------------------------------------
+
+// The stream of a buffered lexer, reading through the lexer the chars it
+// has read ahead before going on with the current stream.
+class LexerStream: public Stream {
+public:
+
+  LexerStream(Lexer *lexerA): lexer(lexerA) {}
+  virtual StreamKind getKind()
+    { return cur() ? cur()->getKind() : strWeird; }
+  virtual void reset() {}
+  virtual int getChar() { return lexer->getChar(); }
+  virtual int lookChar() { return lexer->lookChar(); }
+  virtual int getUnfilteredChar() { return lexer->getChar(); }
+  virtual void unfilteredReset() {}
+  virtual Goffset getPos() { return lexer->getPos(); }
+  virtual void setPos(Goffset pos, int dir = 0) { lexer->setPos(pos, dir); }
+  virtual GBool isBinary(GBool last = gTrue)
+    { return cur() ? cur()->isBinary(last) : gFalse; }
+  virtual BaseStream *getBaseStream()
+    { return cur() ? cur()->getBaseStream() : (BaseStream *)NULL; }
+  virtual Stream *getUndecodedStream() { return this; }
+  virtual Dict *getDict()
+    { return cur() ? cur()->getDict() : (Dict *)NULL; }
+
+private:
+
+  virtual GBool hasGetChars() { return true; }
+  virtual int getChars(int nChars, Guchar *buffer);
+
+  Stream *cur()
+    { return lexer->curStr.isStream() ? lexer->curStr.getStream() : (Stream *)NULL; }
+
+  Lexer *lexer;
+};
+
+int LexerStream::getChars(int nChars, Guchar *buffer) {
+  int n, m;
+
+  for (n = 0; n < nChars; n += m) {
+    if (lexer->bufNext >= lexer->bufEnd && !lexer->fillBuf(gTrue)) {
+      break;
+    }
+    m = (int)(lexer->bufEnd - lexer->bufNext);
+    if (m > nChars - n) {
+      m = nChars - n;
+    }
+    memcpy(buffer + n, lexer->bufNext, m);
+    lexer->bufNext += m;
+  }
+  return n;
+}
+
+//------------------------------------------------------------------------
+// Lexer
+//------------------------------------------------------------------------
+
 Lexer::Lexer(XRef *xrefA, Stream *str) {
   Object obj;
 
   lookCharLastValueCached = LOOK_VALUE_NOT_CACHED;
   xref = xrefA;
+  buffered = gFalse;
+  buf = bufNext = bufEnd = NULL;
+  bufStr = NULL;
 
   curStr.initStream(str);
   streams = new Array(xref);
@@ -88,6 +150,10 @@ Lexer::Lexer(XRef *xrefA, Object *obj) {
 
   lookCharLastValueCached = LOOK_VALUE_NOT_CACHED;
   xref = xrefA;
+  buffered = gTrue;
+  buf = (Guchar *)gmalloc(lexBufSize);
+  bufNext = bufEnd = buf;
+  bufStr = NULL;
 
   if (obj->isStream()) {
     streams = new Array(xref);
@@ -112,11 +178,61 @@ Lexer::~Lexer() {
   if (freeArray) {
     delete streams;
   }
+  delete bufStr;
+  gfree(buf);
+}
+
+Stream *Lexer::getStream() {
+  if (!curStr.isStream()) {
+    return NULL;
+  }
+  if (!buffered) {
+    return curStr.getStream();
+  }
+  if (!bufStr) {
+    bufStr = new LexerStream(this);
+  }
+  return bufStr;
+}
+
+// Reads the next chars of the current stream into buf, going on to the
+// next streams at the end of the current one if advance is set.
+// Returns false if there are no more chars.
+GBool Lexer::fillBuf(GBool advance) {
+  int n;
+
+  while (!curStr.isNone()) {
+    n = curStr.getStream()->doGetChars(lexBufSize, buf);
+    if (n > 0) {
+      bufNext = buf;
+      bufEnd = buf + n;
+      return gTrue;
+    }
+    bufNext = bufEnd = buf;
+    if (!advance) {
+      return gFalse;
+    }
+    curStr.streamClose();
+    curStr.free();
+    ++strPtr;
+    if (strPtr < streams->getLength()) {
+      streams->get(strPtr, &curStr);
+      curStr.streamReset();
+    }
+  }
+  return gFalse;
 }
 
 int Lexer::getChar(GBool comesFromLook) {
   int c;
 
+  if (buffered) {
+    if (bufNext < bufEnd || fillBuf(!comesFromLook)) {
+      return comesFromLook ? *bufNext : *bufNext++;
+    }
+    return EOF;
+  }
+
   if (LOOK_VALUE_NOT_CACHED != lookCharLastValueCached) {
     c = lookCharLastValueCached;
     lookCharLastValueCached = LOOK_VALUE_NOT_CACHED;
@@ -141,7 +257,10 @@ int Lexer::getChar(GBool comesFromLook) {
 }
 
 int Lexer::lookChar() {
-  
+
+  if (buffered) {
+    return getChar(gTrue);
+  }
   if (LOOK_VALUE_NOT_CACHED != lookCharLastValueCached) {
     return lookCharLastValueCached;
   }
@@ -382,7 +501,7 @@ Object *Lexer::getObj(Object *obj, int objNum) {
 	  // we are growing see if the document is not malformed and we are growing too much
 	  if (objNum > 0 && xref != NULL)
 	  {
-	    int newObjNum = xref->getNumEntry(curStr.streamGetPos());
+	    int newObjNum = xref->getNumEntry(getPos());
 	    if (newObjNum != objNum)
 	    {
 	      error(errSyntaxError, getPos(), "Unterminated string");
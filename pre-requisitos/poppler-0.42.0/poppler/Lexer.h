@@ -34,8 +34,10 @@
 #include "Stream.h"
 
 class XRef;
+class LexerStream;
 
 #define tokBufSize 128		// size of token buffer
+#define lexBufSize 4096		// size of the buffer of content streams
 
 //------------------------------------------------------------------------
 // Lexer
@@ -49,7 +51,8 @@ public:
   Lexer(XRef *xrefA, Stream *str);
 
   // Construct a lexer for a stream or array of streams (assumes obj
-  // is either a stream or array of streams).
+  // is either a stream or array of streams).  These are content
+  // streams, which are read lexBufSize chars at a time.
   Lexer(XRef *xrefA, Object *obj);
 
   // Destructor.
@@ -65,18 +68,19 @@ public:
   // Skip over one character.
   void skipChar() { getChar(); }
 
-  // Get stream.
-  Stream *getStream()
-    { return curStr.isStream() ? curStr.getStream() : (Stream *)NULL; }
+  // Get stream.  When the lexer reads ahead, this is a stream that
+  // reads on from the lexer, for the data of inline images.
+  Stream *getStream();
 
   // Get current position in file.  This is only used for error
   // messages.
   Goffset getPos()
-    { return curStr.isStream() ? curStr.streamGetPos() : -1; }
+    { return curStr.isStream() ? curStr.streamGetPos() - (bufEnd - bufNext) : -1; }
 
   // Set position in file.
   void setPos(Goffset pos, int dir = 0)
-    { if (curStr.isStream()) curStr.streamSetPos(pos, dir); }
+    { bufNext = bufEnd = buf;
+      if (curStr.isStream()) curStr.streamSetPos(pos, dir); }
 
   // Returns true if <c> is a whitespace character.
   static GBool isSpace(int c);
@@ -95,6 +99,7 @@ private:
 
   int getChar(GBool comesFromLook = gFalse);
   int lookChar();
+  GBool fillBuf(GBool advance);
 
   Array *streams;		// array of input streams
   int strPtr;			// index of current stream
@@ -102,7 +107,17 @@ private:
   GBool freeArray;		// should lexer free the streams array?
   char tokBuf[tokBufSize];	// temporary token buffer
 
+  // Content streams are read in chunks into buf, saving a virtual
+  // call per char; the chars from bufNext to bufEnd are yet to be read.
+  GBool buffered;
+  Guchar *buf;
+  Guchar *bufNext;
+  Guchar *bufEnd;
+  LexerStream *bufStr;		// the stream getStream returns, or NULL
+
   XRef *xref;
+
+  friend class LexerStream;
 };
 
 #endif
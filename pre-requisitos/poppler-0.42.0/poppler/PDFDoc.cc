@@ -78,6 +78,7 @@
 #endif
 #include "PDFDoc.h"
 #include "Hints.h"
+#include "Trace.h"
 
 #if MULTITHREADED
 #  define pdfdocLocker()   MutexLocker locker(&mutex)
@@ -122,6 +123,7 @@ void PDFDoc::init()
   startXRefPos = -1;
   secHdlr = NULL;
   pageCache = NULL;
+  sharedXRef = gFalse;
 }
 
 PDFDoc::PDFDoc()
@@ -239,6 +241,42 @@ PDFDoc::PDFDoc(BaseStream *strA, GooString *ownerPassword,
   ok = setup(ownerPassword, userPassword);
 }
 
+PDFDoc *PDFDoc::copy() {
+  PDFDoc *doc;
+
+  if (!ok) {
+    return NULL;
+  }
+  doc = new PDFDoc();
+  doc->guiData = guiData;
+  if (fileName) {
+    doc->fileName = fileName->copy();
+  }
+#ifdef _WIN32
+  doc->fileNameU = NULL;
+  if (fileNameU) {
+    int n = wcslen(fileNameU);
+    doc->fileNameU = (wchar_t *)gmallocn(n + 1, sizeof(wchar_t));
+    memcpy(doc->fileNameU, fileNameU, (n + 1) * sizeof(wchar_t));
+  }
+#endif
+  // the base stream keeps a read position, the file is read with pread
+  doc->str = str->copy();
+  doc->pdfMajorVersion = pdfMajorVersion;
+  doc->pdfMinorVersion = pdfMinorVersion;
+  doc->startXRefPos = startXRefPos;
+  doc->xref = xref;
+  doc->secHdlr = secHdlr;
+  doc->sharedXRef = gTrue;
+  doc->catalog = new Catalog(doc);
+  if (doc->catalog->isOk()) {
+    doc->ok = gTrue;
+  } else {
+    doc->errCode = errBadCatalog;
+  }
+  return doc;
+}
+
 GBool PDFDoc::setup(GooString *ownerPassword, GooString *userPassword) {
   pdfdocLocker();
   str->setPos(0, -1);
@@ -312,7 +350,9 @@ PDFDoc::~PDFDoc() {
     }
     gfree(pageCache);
   }
-  delete secHdlr;
+  if (!sharedXRef) {
+    delete secHdlr;
+  }
 #ifndef DISABLE_OUTLINE
   if (outline) {
     delete outline;
@@ -321,7 +361,7 @@ PDFDoc::~PDFDoc() {
   if (catalog) {
     delete catalog;
   }
-  if (xref) {
+  if (xref && !sharedXRef) {
     delete xref;
   }
   if (hints) {
@@ -482,6 +522,7 @@ void PDFDoc::displayPage(OutputDev *out, int page,
 			 void *abortCheckCbkData,
                          GBool (*annotDisplayDecideCbk)(Annot *annot, void *user_data),
                          void *annotDisplayDecideCbkData, GBool copyXRef) {
+  POPPLER_TRACE_SPAN("PDFDoc::displayPage");
   if (globalParams->getPrintCommands()) {
     printf("***** page %d *****\n", page);
   }
@@ -635,6 +676,25 @@ Hints *PDFDoc::getHints()
 }
 
 int PDFDoc::savePageAs(GooString *name, int pageNo) 
+{
+  // Marking the objects of the page updates some of them (the page boxes,
+  // the links of its annotations and form fields), so they are marked in a
+  // copy of the xref table, and the next page starts from the file again.
+  // The special flags are scanned once here and go with every copy.
+  xref->scanSpecialFlags();
+  XRef *docXRef = xref;
+  xref = docXRef->copy();
+  if (!xref) {
+    xref = docXRef;
+    return errOpenFile;
+  }
+  int res = savePageCopyAs(name, pageNo);
+  delete xref;
+  xref = docXRef;
+  return res;
+}
+
+int PDFDoc::savePageCopyAs(GooString *name, int pageNo)
 {
   FILE *f;
   OutStream *outStr;
@@ -1468,7 +1528,7 @@ void PDFDoc::markDictionnary (Dict* dict, XRef * xRef, XRef *countRef, Guint num
       Object annotsObj;
       dict->getValNF(i, &annotsObj);
       if (!annotsObj.isNull()) {
-        markAnnotations(&annotsObj, xRef, countRef, 0, oldRefNum, newRefNum);
+        markAnnotations(&annotsObj, xRef, countRef, numOffset, oldRefNum, newRefNum);
         annotsObj.free();
       }
     }
@@ -1959,6 +2019,22 @@ Page *PDFDoc::parsePage(int page)
   return p;
 }
 
+void PDFDoc::prefetchPage(int page)
+{
+  std::vector<ByteRange> *ranges;
+
+  if (page < 1 || page > getNumPages() || !getHints()) {
+    return;
+  }
+  ranges = getHints()->getPageRanges(page);
+  if (ranges) {
+    for (size_t i = 0; i < ranges->size(); ++i) {
+      str->prefetch((*ranges)[i].offset, (*ranges)[i].length);
+    }
+    delete ranges;
+  }
+}
+
 Page *PDFDoc::getPage(int page)
 {
   if ((page < 1) || page > getNumPages()) return NULL;
@@ -1972,7 +2048,10 @@ Page *PDFDoc::getPage(int page)
       }
     }
     if (!pageCache[page-1]) {
+      prefetchPage(page);
       pageCache[page-1] = parsePage(page);
+      // the next page is likely to be asked for once this one is done
+      prefetchPage(page + 1);
     }
     if (pageCache[page-1]) {
        return pageCache[page-1];
@@ -1983,3 +2062,19 @@ Page *PDFDoc::getPage(int page)
 
   return catalog->getPage(page);
 }
+
+void PDFDoc::releasePage(int page)
+{
+  if ((page < 1) || page > getNumPages()) return;
+
+  if (isLinearized()) {
+    pdfdocLocker();
+    if (pageCache && pageCache[page-1]) {
+      delete pageCache[page-1];
+      pageCache[page-1] = NULL;
+      return;
+    }
+  }
+
+  catalog->releasePage(page);
+}
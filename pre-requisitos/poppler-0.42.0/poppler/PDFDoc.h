@@ -93,6 +93,13 @@ public:
 
   static PDFDoc *ErrorPDFDoc(int errorCode, GooString *fileNameA = NULL);
 
+  // Create another document on the same file, which shares the xref table
+  // (and the objects it has cached) of this one but has its own base
+  // stream, catalog and pages, so that each thread can display or save
+  // pages of its own copy. The copies must be deleted before this
+  // document, and none of them may change the xref table.
+  PDFDoc *copy();
+
   // Was PDF document successfully opened?
   GBool isOk() { return ok; }
 
@@ -149,6 +156,11 @@ public:
   // Get page.
   Page *getPage(int page);
 
+  // Free a page got from getPage once it is no longer needed, so that
+  // going through the pages of a large document does not keep them
+  // all in memory.  The page is built again if it is asked for later.
+  void releasePage(int page);
+
   // Display a page.
   void displayPage(OutputDev *out, int page,
 		   double hDPI, double vDPI, int rotate,
@@ -204,6 +216,10 @@ public:
 
   std::vector<FormWidgetSignature*> getSignatureWidgets();
 
+  // Does the document have a signature field?  Much cheaper than
+  // getSignatureWidgets, which loads the widgets of every page.
+  GBool hasSignatures() { return catalog->hasSignatureFields(); }
+
   // Check various permissions.
   GBool okToPrint(GBool ignoreOwnerPW = gFalse)
     { return xref->okToPrint(ignoreOwnerPW); }
@@ -237,7 +253,9 @@ public:
   //Return the PDF ID in the trailer dictionary (if any).
   GBool getID(GooString *permanent_id, GooString *update_id);
 
-  // Save one page with another name.
+  // Save one page with another name. The document itself is left
+  // unmodified, so that one PDFDoc can save any number of its pages, but
+  // not from several threads at once.
   int savePageAs(GooString *name, int pageNo);
   // Save this file with another name.
   int saveAs(GooString *name, PDFWriteMode mode=writeStandard);
@@ -271,6 +289,8 @@ public:
                                       Goffset uxrefOffset, OutStream* outStr, XRef *xRef);
 
 private:
+  // body of savePageAs, run on a copy of the xref table
+  int savePageCopyAs(GooString *name, int pageNo);
   // insert referenced objects in XRef
   void markDictionnary (Dict* dict, XRef *xRef, XRef *countRef, Guint numOffset, int oldRefNum, int newRefNum);
   void markObject (Object *obj, XRef *xRef, XRef *countRef, Guint numOffset, int oldRefNum, int newRefNum);
@@ -297,6 +317,7 @@ private:
   void saveCompleteRewrite (OutStream* outStr);
 
   Page *parsePage(int page);
+  void prefetchPage(int page);
 
   // Get hints.
   Hints *getHints();
@@ -332,6 +353,8 @@ private:
   Outline *outline;
 #endif
   Page **pageCache;
+  // the xref table and security handler belong to the copied document
+  GBool sharedXRef;
 
   GBool ok;
   int errCode;
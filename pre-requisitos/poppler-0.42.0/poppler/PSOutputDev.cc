@@ -68,9 +68,6 @@
 #if ENABLE_ZLIB
 #  include "FlateEncoder.h"
 #endif
-#if ENABLE_ZLIB_UNCOMPRESS
-#  include "FlateStream.h"
-#endif
 #include "Annot.h"
 #include "XRef.h"
 #include "PreScanOutputDev.h"
@@ -19,8 +19,35 @@
 #include <io.h>    // for setmode
 #endif
 #include <stdio.h>
+#include "Error.h"
+#include "Object.h"
+#include "Stream.h"
+#include "Linearization.h"
 
-size_t StdinCacheLoader::init(GooString *dummy, CachedFile *cachedFile)
+// Returns the file length given by the linearization dictionary at the
+// start of buf, or 0 if buf does not start with one.
+static size_t linearizedLength(char *buf, size_t size)
+{
+  Object obj;
+  MemStream *str;
+  size_t length;
+
+  obj.initNull();
+  str = new MemStream(buf, 0, size, &obj);
+  Linearization lin(str);
+  length = lin.getLength();
+  delete str;
+  return length;
+}
+
+StdinCacheLoader::StdinCacheLoader()
+{
+  cachedFile = NULL;
+  length = 0;
+  bytesRead = 0;
+}
+
+size_t StdinCacheLoader::init(GooString *dummy, CachedFile *cachedFileA)
 {
   size_t read, size = 0;
   char buf[CachedFileChunkSize];
@@ -29,19 +56,69 @@ size_t StdinCacheLoader::init(GooString *dummy, CachedFile *cachedFile)
   setmode(fileno(stdin), O_BINARY);
 #endif
 
+  cachedFile = cachedFileA;
   CachedFileWriter writer = CachedFileWriter (cachedFile, NULL);
-  do {
+  read = fread(buf, 1, CachedFileChunkSize, stdin);
+  (writer.write) (buf, read);
+  size += read;
+
+  // The rest of a linearized document is left in the pipe for load.
+  if (read == CachedFileChunkSize) {
+    length = linearizedLength(buf, read);
+    if (length > read) {
+      bytesRead = read;
+      return length;
+    }
+  }
+
+  while (read == CachedFileChunkSize) {
     read = fread(buf, 1, CachedFileChunkSize, stdin);
-    (writer.write) (buf, CachedFileChunkSize);
+    (writer.write) (buf, read);
     size += read;
   }
-  while (read == CachedFileChunkSize);
 
+  length = bytesRead = size;
   return size;
 }
 
 int StdinCacheLoader::load(const std::vector<ByteRange> &ranges, CachedFileWriter *writer)
 {
+  size_t end = 0;
+
+  // stdin cannot seek back, so everything up to the end of the last range
+  // is read and kept, including the chunks in between the ranges.
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (ranges[i].offset + ranges[i].length > end) {
+      end = ranges[i].offset + ranges[i].length;
+    }
+  }
+  if (end > length) end = length;
+  if (end <= bytesRead) return 0;
+  // A document cut short was reported by the load that reached its end.
+  if (feof(stdin)) return -1;
+
+  std::vector<int> chunks;
+  for (size_t chunk = bytesRead / CachedFileChunkSize;
+       chunk <= (end - 1) / CachedFileChunkSize; chunk++) {
+    chunks.push_back(chunk);
+  }
+  end = chunks.back() * (size_t)CachedFileChunkSize + CachedFileChunkSize;
+  if (end > length) end = length;
+
+  char buf[CachedFileChunkSize];
+  CachedFileWriter chunkWriter = CachedFileWriter (cachedFile, &chunks);
+  while (bytesRead < end) {
+    size_t toRead = end - bytesRead;
+    if (toRead > CachedFileChunkSize) toRead = CachedFileChunkSize;
+    size_t read = fread(buf, 1, toRead, stdin);
+    if (read == 0) {
+      error(errIO, -1, "Document on stdin ended at {0:uld} of {1:uld} bytes.",
+            (unsigned long)bytesRead, (unsigned long)length);
+      return -1;
+    }
+    (chunkWriter.write) (buf, read);
+    bytesRead += read;
+  }
+
   return 0;
 }
-
@@ -14,13 +14,31 @@
 
 #include "CachedFile.h"
 
+//------------------------------------------------------------------------
+// StdinCacheLoader
+//
+// Loads a document from stdin. A linearized document, whose linearization
+// dictionary in the first chunk gives the file length, is read from the
+// pipe only as far as the parser asks for, so its first page can be parsed
+// before the last byte arrives. Any other document is read whole by init.
+//------------------------------------------------------------------------
+
 class StdinCacheLoader : public CachedFileLoader {
 
 public:
 
+  StdinCacheLoader();
+
   size_t init(GooString *dummy, CachedFile* cachedFile);
   int load(const std::vector<ByteRange> &ranges, CachedFileWriter *writer);
 
+private:
+
+  CachedFile *cachedFile;
+  size_t length;		// length of the document, as far as it is known
+  size_t bytesRead;		// bytes read from stdin so far, in chunks
+				//   but for the last one
+
 };
 
 #endif
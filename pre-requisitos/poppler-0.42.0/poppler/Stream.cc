@@ -53,6 +53,9 @@
 #endif
 #include <string.h>
 #include <ctype.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "goo/gmem.h"
 #include "goo/gfile.h"
 #include "poppler-config.h"
@@ -70,10 +73,6 @@
 #include "DCTStream.h"
 #endif
 
-#ifdef ENABLE_ZLIB_UNCOMPRESS
-#include "FlateStream.h"
-#endif
-
 #ifdef ENABLE_LIBOPENJPEG
 #include "JPEG2000Stream.h"
 #else
@@ -580,6 +579,7 @@ StreamPredictor::StreamPredictor(Stream *strA, int predictorA,
   nComps = nCompsA;
   nBits = nBitsA;
   predLine = NULL;
+  rawLine = NULL;
   ok = gFalse;
 
   nVals = width * nComps;
@@ -594,6 +594,7 @@ StreamPredictor::StreamPredictor(Stream *strA, int predictorA,
   }
   predLine = (Guchar *)gmalloc(rowBytes);
   memset(predLine, 0, rowBytes);
+  rawLine = (int *)gmallocn(rowBytes - pixBytes, sizeof(int));
   predIdx = rowBytes;
 
   ok = gTrue;
@@ -601,6 +602,7 @@ StreamPredictor::StreamPredictor(Stream *strA, int predictorA,
 
 StreamPredictor::~StreamPredictor() {
   gfree(predLine);
+  gfree(rawLine);
 }
 
 int StreamPredictor::lookChar() {
@@ -642,14 +644,151 @@ int StreamPredictor::getChars(int nChars, Guchar *buffer) {
   return n;
 }
 
+// The PNG predictors undo the filtering of n bytes of raw data into
+// line, which holds the previous line on entry, and whose bpp bytes
+// before line[0] are zero.  With SSE2, lines of 3 or 4 byte pixels
+// are done a pixel at a time in vector registers, and "up" 16 bytes
+// at a time.
+
+#if defined(__SSE2__)
+
+static inline __m128i pngLoadPixel(const Guchar *p, int bpp) {
+  int v = 0;
+
+  memcpy(&v, p, bpp);
+  return _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), _mm_setzero_si128());
+}
+
+static inline void pngStorePixel(Guchar *p, __m128i x, int bpp) {
+  int v = _mm_cvtsi128_si32(_mm_packus_epi16(x, x));
+
+  memcpy(p, &v, bpp);
+}
+
+static inline __m128i pngAbs16(__m128i x) {
+  return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static inline __m128i pngSelect(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+#endif
+
+static void pngUnpredictSub(Guchar *line, Guchar *raw, int n, int bpp) {
+  int i = 0;
+
+#if defined(__SSE2__)
+  if ((bpp == 3 || bpp == 4) && n % bpp == 0) {
+    __m128i a = _mm_setzero_si128();
+    for (; i < n; i += bpp) {
+      a = _mm_add_epi8(a, pngLoadPixel(raw + i, bpp));
+      pngStorePixel(line + i, a, bpp);
+    }
+    return;
+  }
+#endif
+  for (; i < n; ++i) {
+    line[i] = line[i - bpp] + raw[i];
+  }
+}
+
+static void pngUnpredictUp(Guchar *line, Guchar *raw, int n) {
+  int i = 0;
+
+#if defined(__SSE2__)
+  for (; i + 16 <= n; i += 16) {
+    _mm_storeu_si128((__m128i *)(line + i),
+		     _mm_add_epi8(_mm_loadu_si128((__m128i *)(line + i)),
+				  _mm_loadu_si128((__m128i *)(raw + i))));
+  }
+#endif
+  for (; i < n; ++i) {
+    line[i] += raw[i];
+  }
+}
+
+static void pngUnpredictAvg(Guchar *line, Guchar *raw, int n, int bpp) {
+  int i = 0;
+
+#if defined(__SSE2__)
+  if ((bpp == 3 || bpp == 4) && n % bpp == 0) {
+    __m128i a = _mm_setzero_si128();
+    __m128i b;
+    for (; i < n; i += bpp) {
+      b = pngLoadPixel(line + i, bpp);
+      a = _mm_add_epi8(_mm_srli_epi16(_mm_add_epi16(a, b), 1),
+		       pngLoadPixel(raw + i, bpp));
+      pngStorePixel(line + i, a, bpp);
+    }
+    return;
+  }
+#endif
+  for (; i < n; ++i) {
+    line[i] = ((line[i - bpp] + line[i]) >> 1) + raw[i];
+  }
+}
+
+static void pngUnpredictPaeth(Guchar *line, Guchar *raw, int n, int bpp) {
+  Guchar upLeftBuf[gfxColorMaxComps * 2 + 1];
+  int left, up, upLeft, p, pa, pb, pc;
+  int i = 0, j;
+
+#if defined(__SSE2__)
+  if ((bpp == 3 || bpp == 4) && n % bpp == 0) {
+    __m128i a = _mm_setzero_si128(), b = _mm_setzero_si128(), c;
+    __m128i va, vb, vc, smallest, nearest;
+    for (; i < n; i += bpp) {
+      c = b;
+      b = pngLoadPixel(line + i, bpp);
+      // pa = |p - a| = |b - c|, pb = |p - b| = |a - c|, pc = |p - c|
+      vb = _mm_sub_epi16(a, c);
+      va = _mm_sub_epi16(b, c);
+      vc = pngAbs16(_mm_add_epi16(va, vb));
+      va = pngAbs16(va);
+      vb = pngAbs16(vb);
+      smallest = _mm_min_epi16(vc, _mm_min_epi16(va, vb));
+      nearest = pngSelect(_mm_cmpeq_epi16(smallest, va), a,
+			  pngSelect(_mm_cmpeq_epi16(smallest, vb), b, c));
+      a = _mm_add_epi8(nearest, pngLoadPixel(raw + i, bpp));
+      pngStorePixel(line + i, a, bpp);
+    }
+    return;
+  }
+#endif
+  // upLeftBuf keeps the bytes of the previous line last overwritten,
+  // so upLeftBuf[j] is the byte above and left of line[i]
+  memset(upLeftBuf, 0, bpp);
+  for (j = 0; i < n; ++i) {
+    left = line[i - bpp];
+    up = line[i];
+    upLeft = upLeftBuf[j];
+    upLeftBuf[j] = up;
+    if (++j == bpp)
+      j = 0;
+    p = left + up - upLeft;
+    if ((pa = p - left) < 0)
+      pa = -pa;
+    if ((pb = p - up) < 0)
+      pb = -pb;
+    if ((pc = p - upLeft) < 0)
+      pc = -pc;
+    if (pa <= pb && pa <= pc)
+      line[i] = left + raw[i];
+    else if (pb <= pc)
+      line[i] = up + raw[i];
+    else
+      line[i] = upLeft + raw[i];
+  }
+}
+
 GBool StreamPredictor::getNextLine() {
   int curPred;
   Guchar upLeftBuf[gfxColorMaxComps * 2 + 1];
-  int left, up, upLeft, p, pa, pb, pc;
-  int c;
+  Guchar *raw;
   Gulong inBuf, outBuf, bitMask;
   int inBits, outBits;
-  int i, j, k, kk;
+  int i, j, k, kk, n;
 
   // get PNG optimum predictor number
   if (predictor >= 10) {
@@ -661,61 +800,38 @@ GBool StreamPredictor::getNextLine() {
     curPred = predictor;
   }
 
-  // read the raw line, apply PNG (byte) predictor
-  int *rawCharLine = new int[rowBytes - pixBytes];
-  str->getRawChars(rowBytes - pixBytes, rawCharLine);
-  memset(upLeftBuf, 0, pixBytes + 1);
-  for (i = pixBytes; i < rowBytes; ++i) {
-    for (j = pixBytes; j > 0; --j) {
-      upLeftBuf[j] = upLeftBuf[j-1];
-    }
-    upLeftBuf[0] = predLine[i];
-    if ((c = rawCharLine[i - pixBytes]) == EOF) {
-      if (i > pixBytes) {
-	// this ought to return false, but some (broken) PDF files
-	// contain truncated image data, and Adobe apparently reads the
-	// last partial line
-	break;
-      }
-      delete[] rawCharLine;
-      return gFalse;
-    }
-    switch (curPred) {
-    case 11:			// PNG sub
-      predLine[i] = predLine[i - pixBytes] + (Guchar)c;
-      break;
-    case 12:			// PNG up
-      predLine[i] = predLine[i] + (Guchar)c;
-      break;
-    case 13:			// PNG average
-      predLine[i] = ((predLine[i - pixBytes] + predLine[i]) >> 1) +
-	            (Guchar)c;
-      break;
-    case 14:			// PNG Paeth
-      left = predLine[i - pixBytes];
-      up = predLine[i];
-      upLeft = upLeftBuf[pixBytes];
-      p = left + up - upLeft;
-      if ((pa = p - left) < 0)
-	pa = -pa;
-      if ((pb = p - up) < 0)
-	pb = -pb;
-      if ((pc = p - upLeft) < 0)
-	pc = -pc;
-      if (pa <= pb && pa <= pc)
-	predLine[i] = left + (Guchar)c;
-      else if (pb <= pc)
-	predLine[i] = up + (Guchar)c;
-      else
-	predLine[i] = upLeft + (Guchar)c;
-      break;
-    case 10:			// PNG none
-    default:			// no predictor or TIFF predictor
-      predLine[i] = (Guchar)c;
-      break;
-    }
+  // read the raw line; some (broken) PDF files contain truncated
+  // image data, and Adobe apparently reads the last partial line
+  str->getRawChars(rowBytes - pixBytes, rawLine);
+  // narrow it to bytes in place: each byte lands before the int it
+  // comes from
+  raw = (Guchar *)rawLine;
+  for (n = 0; n < rowBytes - pixBytes && rawLine[n] != EOF; ++n) {
+    raw[n] = (Guchar)rawLine[n];
+  }
+  if (n == 0) {
+    return gFalse;
+  }
+
+  // apply PNG (byte) predictor
+  switch (curPred) {
+  case 11:			// PNG sub
+    pngUnpredictSub(predLine + pixBytes, raw, n, pixBytes);
+    break;
+  case 12:			// PNG up
+    pngUnpredictUp(predLine + pixBytes, raw, n);
+    break;
+  case 13:			// PNG average
+    pngUnpredictAvg(predLine + pixBytes, raw, n, pixBytes);
+    break;
+  case 14:			// PNG Paeth
+    pngUnpredictPaeth(predLine + pixBytes, raw, n, pixBytes);
+    break;
+  case 10:			// PNG none
+  default:			// no predictor or TIFF predictor
+    memcpy(predLine + pixBytes, raw, n);
+    break;
   }
-  delete[] rawCharLine;
 
   // apply TIFF (component) predictor
   if (predictor == 2) {
@@ -766,6 +882,162 @@ GBool StreamPredictor::getNextLine() {
   return gTrue;
 }
 
+//------------------------------------------------------------------------
+// FileChunkCache
+//------------------------------------------------------------------------
+
+class FileChunkCache {
+public:
+
+  FileChunkCache(GooFile *fileA);
+  ~FileChunkCache();
+
+  void incRef();
+  void decRef();
+
+  // Read up to <n> bytes at <pos>, but not past the end of the chunk
+  // holding <pos>.  Returns the number of bytes read, 0 at the end of
+  // the file, or -1 on error.
+  int read(char *buf, int n, Goffset pos);
+
+  void prefetch(Goffset pos, Goffset len);
+
+private:
+
+  struct Chunk {
+    Goffset pos;		// offset in the file, -1 if unused
+    int len;			// number of valid bytes
+    Guint lastUse;
+    char *data;
+  };
+
+  GooFile *file;
+  Chunk chunks[fileChunkCacheSize];
+  int lastChunk;		// chunk used by the last read
+  Guint useCount;
+  int refCnt;
+#if MULTITHREADED
+  GooMutex mutex;
+#endif
+};
+
+FileChunkCache::FileChunkCache(GooFile *fileA) {
+  int i;
+
+  file = fileA;
+  for (i = 0; i < fileChunkCacheSize; ++i) {
+    chunks[i].pos = -1;
+    chunks[i].len = 0;
+    chunks[i].lastUse = 0;
+    chunks[i].data = NULL;
+  }
+  lastChunk = 0;
+  useCount = 0;
+  refCnt = 1;
+#if MULTITHREADED
+  gInitMutex(&mutex);
+#endif
+}
+
+FileChunkCache::~FileChunkCache() {
+  int i;
+
+  for (i = 0; i < fileChunkCacheSize; ++i) {
+    gfree(chunks[i].data);
+  }
+#if MULTITHREADED
+  gDestroyMutex(&mutex);
+#endif
+}
+
+void FileChunkCache::incRef() {
+#if MULTITHREADED
+  gLockMutex(&mutex);
+#endif
+  ++refCnt;
+#if MULTITHREADED
+  gUnlockMutex(&mutex);
+#endif
+}
+
+void FileChunkCache::decRef() {
+  int n;
+
+#if MULTITHREADED
+  gLockMutex(&mutex);
+#endif
+  n = --refCnt;
+#if MULTITHREADED
+  gUnlockMutex(&mutex);
+#endif
+  if (n == 0) {
+    delete this;
+  }
+}
+
+int FileChunkCache::read(char *buf, int n, Goffset pos) {
+  Goffset chunkPos;
+  Chunk *chunk;
+  int i, m;
+
+  if (pos < 0) {
+    return -1;
+  }
+  chunkPos = pos - pos % fileChunkSize;
+#if MULTITHREADED
+  MutexLocker locker(&mutex);
+#endif
+  chunk = &chunks[lastChunk];
+  if (chunk->pos != chunkPos) {
+    // look for the chunk, and if it isn't there read it in place of
+    // the least recently used one
+    for (i = 0; i < fileChunkCacheSize; ++i) {
+      if (chunks[i].pos == chunkPos) {
+	break;
+      }
+    }
+    if (i == fileChunkCacheSize) {
+      for (i = 0, m = 1; m < fileChunkCacheSize; ++m) {
+	if (chunks[m].lastUse < chunks[i].lastUse) {
+	  i = m;
+	}
+      }
+      chunk = &chunks[i];
+      if (!chunk->data) {
+	chunk->data = (char *)gmalloc(fileChunkSize);
+      }
+      chunk->pos = -1;
+      m = file->read(chunk->data, fileChunkSize, chunkPos);
+      if (m < 0) {
+	return -1;
+      }
+      chunk->pos = chunkPos;
+      chunk->len = m;
+    }
+    lastChunk = i;
+    chunk = &chunks[i];
+  }
+  chunk->lastUse = ++useCount;
+
+  m = chunk->len - (int)(pos - chunkPos);
+  if (m <= 0) {
+    return 0;
+  }
+  if (m > n) {
+    m = n;
+  }
+  memcpy(buf, chunk->data + (pos - chunkPos), m);
+  return m;
+}
+
+void FileChunkCache::prefetch(Goffset pos, Goffset len) {
+  Goffset chunkPos;
+
+  // whole chunks, since that is how they will be read
+  chunkPos = pos - pos % fileChunkSize;
+  file->prefetch(chunkPos, len + (pos - chunkPos));
+}
+
 //------------------------------------------------------------------------
 // FileStream
 //------------------------------------------------------------------------
@@ -774,6 +1046,22 @@ FileStream::FileStream(GooFile* fileA, Goffset startA, GBool limitedA,
 		       Goffset lengthA, Object *dictA):
     BaseStream(dictA, lengthA) {
   file = fileA;
+  cache = new FileChunkCache(file);
+  offset = start = startA;
+  limited = limitedA;
+  length = lengthA;
+  bufPtr = bufEnd = buf;
+  bufPos = start;
+  savePos = 0;
+  saved = gFalse;
+}
+
+FileStream::FileStream(GooFile* fileA, FileChunkCache *cacheA, Goffset startA,
+		       GBool limitedA, Goffset lengthA, Object *dictA):
+    BaseStream(dictA, lengthA) {
+  file = fileA;
+  cache = cacheA;
+  cache->incRef();
   offset = start = startA;
   limited = limitedA;
   length = lengthA;
@@ -785,15 +1073,16 @@ FileStream::FileStream(GooFile* fileA, Goffset startA, GBool limitedA,
 
 FileStream::~FileStream() {
   close();
+  cache->decRef();
 }
 
 BaseStream *FileStream::copy() {
-  return new FileStream(file, start, limited, length, &dict);
+  return new FileStream(file, cache, start, limited, length, &dict);
 }
 
 Stream *FileStream::makeSubStream(Goffset startA, GBool limitedA,
 				  Goffset lengthA, Object *dictA) {
-  return new FileStream(file, startA, limitedA, lengthA, dictA);
+  return new FileStream(file, cache, startA, limitedA, lengthA, dictA);
 }
 
 void FileStream::reset() {
@@ -824,7 +1113,7 @@ GBool FileStream::fillBuf() {
   } else {
     n = fileStreamBufSize;
   }
-  n = file->read(buf, n, offset);
+  n = cache->read(buf, n, offset);
   if (n == -1) {
     return gFalse;
   }
@@ -857,6 +1146,10 @@ void FileStream::moveStart(Goffset delta) {
   bufPos = start;
 }
 
+void FileStream::prefetch(Goffset pos, Goffset len) {
+  cache->prefetch(pos, len);
+}
+
 //------------------------------------------------------------------------
 // CachedFileStream
 //------------------------------------------------------------------------
@@ -1713,76 +2006,87 @@ inline void CCITTFaxStream::addPixelsNeg(int a1, int blackPixels) {
   }
 }
 
-int CCITTFaxStream::lookChar() {
+// Decode the next row into codingLine and set up for output.  Returns
+// false if there is no row.
+GBool CCITTFaxStream::readRow() {
   int code1, code2, code3;
-  int b1i, blackPixels, i, bits;
+  int b1i, blackPixels, i;
   GBool gotEOL;
 
-  if (buf != EOF) {
-    return buf;
-  }
-
-  // read the next row
-  if (outputBits == 0) {
-
-    // if at eof just return EOF
-    if (eof) {
-      return EOF;
-    }
-
-    err = gFalse;
-
-    // 2-D encoding
-    if (nextLine2D) {
-      for (i = 0; i < columns && codingLine[i] < columns; ++i) {
-	refLine[i] = codingLine[i];
-      }
-      for (; i < columns + 2; ++i) {
-	refLine[i] = columns;
-      }
-      codingLine[0] = 0;
-      a0i = 0;
-      b1i = 0;
-      blackPixels = 0;
-      // invariant:
-      // refLine[b1i-1] <= codingLine[a0i] < refLine[b1i] < refLine[b1i+1]
-      //                                                             <= columns
-      // exception at left edge:
-      //   codingLine[a0i = 0] = refLine[b1i = 0] = 0 is possible
-      // exception at right edge:
-      //   refLine[b1i] = refLine[b1i+1] = columns is possible
-      while (codingLine[a0i] < columns && !err) {
-	code1 = getTwoDimCode();
-	switch (code1) {
-	case twoDimPass:
-	  if (likely(b1i + 1 < columns + 2)) {
-	    addPixels(refLine[b1i + 1], blackPixels);
-	    if (refLine[b1i + 1] < columns) {
-	      b1i += 2;
-	    }
-	  }
-	  break;
-	case twoDimHoriz:
-	  code1 = code2 = 0;
-	  if (blackPixels) {
-	    do {
-	      code1 += code3 = getBlackCode();
-	    } while (code3 >= 64);
-	    do {
-	      code2 += code3 = getWhiteCode();
-	    } while (code3 >= 64);
-	  } else {
-	    do {
-	      code1 += code3 = getWhiteCode();
-	    } while (code3 >= 64);
-	    do {
-	      code2 += code3 = getBlackCode();
-	    } while (code3 >= 64);
+  err = gFalse;
+
+  // 2-D encoding
+  if (nextLine2D) {
+    for (i = 0; i < columns && codingLine[i] < columns; ++i) {
+      refLine[i] = codingLine[i];
+    }
+    for (; i < columns + 2; ++i) {
+      refLine[i] = columns;
+    }
+    codingLine[0] = 0;
+    a0i = 0;
+    b1i = 0;
+    blackPixels = 0;
+    // invariant:
+    // refLine[b1i-1] <= codingLine[a0i] < refLine[b1i] < refLine[b1i+1]
+    //                                                             <= columns
+    // exception at left edge:
+    //   codingLine[a0i = 0] = refLine[b1i = 0] = 0 is possible
+    // exception at right edge:
+    //   refLine[b1i] = refLine[b1i+1] = columns is possible
+    while (codingLine[a0i] < columns && !err) {
+      code1 = getTwoDimCode();
+      switch (code1) {
+      case twoDimPass:
+	if (likely(b1i + 1 < columns + 2)) {
+	  addPixels(refLine[b1i + 1], blackPixels);
+	  if (refLine[b1i + 1] < columns) {
+	    b1i += 2;
 	  }
-	  addPixels(codingLine[a0i] + code1, blackPixels);
-	  if (codingLine[a0i] < columns) {
-	    addPixels(codingLine[a0i] + code2, blackPixels ^ 1);
+	}
+	break;
+      case twoDimHoriz:
+	code1 = code2 = 0;
+	if (blackPixels) {
+	  do {
+	    code1 += code3 = getBlackCode();
+	  } while (code3 >= 64);
+	  do {
+	    code2 += code3 = getWhiteCode();
+	  } while (code3 >= 64);
+	} else {
+	  do {
+	    code1 += code3 = getWhiteCode();
+	  } while (code3 >= 64);
+	  do {
+	    code2 += code3 = getBlackCode();
+	  } while (code3 >= 64);
+	}
+	addPixels(codingLine[a0i] + code1, blackPixels);
+	if (codingLine[a0i] < columns) {
+	  addPixels(codingLine[a0i] + code2, blackPixels ^ 1);
+	}
+	while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+	  b1i += 2;
+	  if (unlikely(b1i > columns + 1)) {
+	    error(errSyntaxError, getPos(),
+	      "Bad 2D code {0:04x} in CCITTFax stream", code1);
+	    err = gTrue;
+	    break;
 	  }
+	}
+	break;
+      case twoDimVertR3:
+	if (unlikely(b1i > columns + 1)) {
+	  error(errSyntaxError, getPos(),
+	    "Bad 2D code {0:04x} in CCITTFax stream", code1);
+	  err = gTrue;
+	  break;
+	}
+	addPixels(refLine[b1i] + 3, blackPixels);
+	blackPixels ^= 1;
+	if (codingLine[a0i] < columns) {
+	  ++b1i;
 	  while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
 	    b1i += 2;
 	    if (unlikely(b1i > columns + 1)) {
@@ -1792,328 +2096,406 @@ int CCITTFaxStream::lookChar() {
 	      break;
 	    }
 	  }
+	}
+	break;
+      case twoDimVertR2:
+	if (unlikely(b1i > columns + 1)) {
+	  error(errSyntaxError, getPos(),
+	    "Bad 2D code {0:04x} in CCITTFax stream", code1);
+	  err = gTrue;
 	  break;
-	case twoDimVertR3:
-	  if (unlikely(b1i > columns + 1)) {
-	    error(errSyntaxError, getPos(),
-	      "Bad 2D code {0:04x} in CCITTFax stream", code1);
-	    err = gTrue;
-	    break;
-	  }
-	  addPixels(refLine[b1i] + 3, blackPixels);
-	  blackPixels ^= 1;
-	  if (codingLine[a0i] < columns) {
-	    ++b1i;
-	    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-	      b1i += 2;
-	      if (unlikely(b1i > columns + 1)) {
-		error(errSyntaxError, getPos(),
-		  "Bad 2D code {0:04x} in CCITTFax stream", code1);
-		err = gTrue;
-		break;
-	      }
+	}
+	addPixels(refLine[b1i] + 2, blackPixels);
+	blackPixels ^= 1;
+	if (codingLine[a0i] < columns) {
+	  ++b1i;
+	  while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+	    b1i += 2;
+	    if (unlikely(b1i > columns + 1)) {
+	      error(errSyntaxError, getPos(),
+		"Bad 2D code {0:04x} in CCITTFax stream", code1);
+	      err = gTrue;
+	      break;
 	    }
 	  }
+	}
+	break;
+      case twoDimVertR1:
+	if (unlikely(b1i > columns + 1)) {
+	  error(errSyntaxError, getPos(),
+	    "Bad 2D code {0:04x} in CCITTFax stream", code1);
+	  err = gTrue;
 	  break;
-	case twoDimVertR2:
-	  if (unlikely(b1i > columns + 1)) {
-	    error(errSyntaxError, getPos(),
-	      "Bad 2D code {0:04x} in CCITTFax stream", code1);
-	    err = gTrue;
-	    break;
-	  }
-	  addPixels(refLine[b1i] + 2, blackPixels);
-	  blackPixels ^= 1;
-	  if (codingLine[a0i] < columns) {
-	    ++b1i;
-	    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-	      b1i += 2;
-	      if (unlikely(b1i > columns + 1)) {
-		error(errSyntaxError, getPos(),
-		  "Bad 2D code {0:04x} in CCITTFax stream", code1);
-		err = gTrue;
-		break;
-	      }
+	}
+	addPixels(refLine[b1i] + 1, blackPixels);
+	blackPixels ^= 1;
+	if (codingLine[a0i] < columns) {
+	  ++b1i;
+	  while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+	    b1i += 2;
+	    if (unlikely(b1i > columns + 1)) {
+	      error(errSyntaxError, getPos(),
+		"Bad 2D code {0:04x} in CCITTFax stream", code1);
+	      err = gTrue;
+	      break;
 	    }
 	  }
+	}
+	break;
+      case twoDimVert0:
+	if (unlikely(b1i > columns + 1)) {
+	  error(errSyntaxError, getPos(),
+	    "Bad 2D code {0:04x} in CCITTFax stream", code1);
+	  err = gTrue;
 	  break;
-	case twoDimVertR1:
-	  if (unlikely(b1i > columns + 1)) {
-	    error(errSyntaxError, getPos(),
-	      "Bad 2D code {0:04x} in CCITTFax stream", code1);
-	    err = gTrue;
-	    break;
-	  }
-	  addPixels(refLine[b1i] + 1, blackPixels);
-	  blackPixels ^= 1;
-	  if (codingLine[a0i] < columns) {
-	    ++b1i;
-	    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-	      b1i += 2;
-	      if (unlikely(b1i > columns + 1)) {
-		error(errSyntaxError, getPos(),
-		  "Bad 2D code {0:04x} in CCITTFax stream", code1);
-		err = gTrue;
-		break;
-	      }
+	}
+	addPixels(refLine[b1i], blackPixels);
+	blackPixels ^= 1;
+	if (codingLine[a0i] < columns) {
+	  ++b1i;
+	  while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+	    b1i += 2;
+	    if (unlikely(b1i > columns + 1)) {
+	      error(errSyntaxError, getPos(),
+		"Bad 2D code {0:04x} in CCITTFax stream", code1);
+	      err = gTrue;
+	      break;
 	    }
 	  }
+	}
+	break;
+      case twoDimVertL3:
+	if (unlikely(b1i > columns + 1)) {
+	  error(errSyntaxError, getPos(),
+	    "Bad 2D code {0:04x} in CCITTFax stream", code1);
+	  err = gTrue;
 	  break;
-	case twoDimVert0:
-	  if (unlikely(b1i > columns + 1)) {
-	    error(errSyntaxError, getPos(),
-	      "Bad 2D code {0:04x} in CCITTFax stream", code1);
-	    err = gTrue;
-	    break;
-	  }
-	  addPixels(refLine[b1i], blackPixels);
-	  blackPixels ^= 1;
-	  if (codingLine[a0i] < columns) {
+	}
+	addPixelsNeg(refLine[b1i] - 3, blackPixels);
+	blackPixels ^= 1;
+	if (codingLine[a0i] < columns) {
+	  if (b1i > 0) {
+	    --b1i;
+	  } else {
 	    ++b1i;
-	    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-	      b1i += 2;
-	      if (unlikely(b1i > columns + 1)) {
-		error(errSyntaxError, getPos(),
-		  "Bad 2D code {0:04x} in CCITTFax stream", code1);
-		err = gTrue;
-		break;
-	      }
-	    }
-	  }
-	  break;
-	case twoDimVertL3:
-	  if (unlikely(b1i > columns + 1)) {
-	    error(errSyntaxError, getPos(),
-	      "Bad 2D code {0:04x} in CCITTFax stream", code1);
-	    err = gTrue;
-	    break;
 	  }
-	  addPixelsNeg(refLine[b1i] - 3, blackPixels);
-	  blackPixels ^= 1;
-	  if (codingLine[a0i] < columns) {
-	    if (b1i > 0) {
-	      --b1i;
-	    } else {
-	      ++b1i;
-	    }
-	    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-	      b1i += 2;
-	      if (unlikely(b1i > columns + 1)) {
-		error(errSyntaxError, getPos(),
-		  "Bad 2D code {0:04x} in CCITTFax stream", code1);
-		err = gTrue;
-		break;
-	      }
+	  while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+	    b1i += 2;
+	    if (unlikely(b1i > columns + 1)) {
+	      error(errSyntaxError, getPos(),
+		"Bad 2D code {0:04x} in CCITTFax stream", code1);
+	      err = gTrue;
+	      break;
 	    }
 	  }
+	}
+	break;
+      case twoDimVertL2:
+	if (unlikely(b1i > columns + 1)) {
+	  error(errSyntaxError, getPos(),
+	    "Bad 2D code {0:04x} in CCITTFax stream", code1);
+	  err = gTrue;
 	  break;
-	case twoDimVertL2:
-	  if (unlikely(b1i > columns + 1)) {
-	    error(errSyntaxError, getPos(),
-	      "Bad 2D code {0:04x} in CCITTFax stream", code1);
-	    err = gTrue;
-	    break;
+	}
+	addPixelsNeg(refLine[b1i] - 2, blackPixels);
+	blackPixels ^= 1;
+	if (codingLine[a0i] < columns) {
+	  if (b1i > 0) {
+	    --b1i;
+	  } else {
+	    ++b1i;
 	  }
-	  addPixelsNeg(refLine[b1i] - 2, blackPixels);
-	  blackPixels ^= 1;
-	  if (codingLine[a0i] < columns) {
-	    if (b1i > 0) {
-	      --b1i;
-	    } else {
-	      ++b1i;
-	    }
-	    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-	      b1i += 2;
-	      if (unlikely(b1i > columns + 1)) {
-	        error(errSyntaxError, getPos(),
-		  "Bad 2D code {0:04x} in CCITTFax stream", code1);
-	        err = gTrue;
-	        break;
-	      }
+	  while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+	    b1i += 2;
+	    if (unlikely(b1i > columns + 1)) {
+	      error(errSyntaxError, getPos(),
+		"Bad 2D code {0:04x} in CCITTFax stream", code1);
+	      err = gTrue;
+	      break;
 	    }
 	  }
+	}
+	break;
+      case twoDimVertL1:
+	if (unlikely(b1i > columns + 1)) {
+	  error(errSyntaxError, getPos(),
+	    "Bad 2D code {0:04x} in CCITTFax stream", code1);
+	  err = gTrue;
 	  break;
-	case twoDimVertL1:
-	  if (unlikely(b1i > columns + 1)) {
-	    error(errSyntaxError, getPos(),
-	      "Bad 2D code {0:04x} in CCITTFax stream", code1);
-	    err = gTrue;
-	    break;
+	}
+	addPixelsNeg(refLine[b1i] - 1, blackPixels);
+	blackPixels ^= 1;
+	if (codingLine[a0i] < columns) {
+	  if (b1i > 0) {
+	    --b1i;
+	  } else {
+	    ++b1i;
 	  }
-	  addPixelsNeg(refLine[b1i] - 1, blackPixels);
-	  blackPixels ^= 1;
-	  if (codingLine[a0i] < columns) {
-	    if (b1i > 0) {
-	      --b1i;
-	    } else {
-	      ++b1i;
-	    }
-	    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-	      b1i += 2;
-	      if (unlikely(b1i > columns + 1)) {
-		error(errSyntaxError, getPos(),
-		  "Bad 2D code {0:04x} in CCITTFax stream", code1);
-		err = gTrue;
-		break;
-	      }
+	  while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+	    b1i += 2;
+	    if (unlikely(b1i > columns + 1)) {
+	      error(errSyntaxError, getPos(),
+		"Bad 2D code {0:04x} in CCITTFax stream", code1);
+	      err = gTrue;
+	      break;
 	    }
 	  }
-	  break;
-	case EOF:
-	  addPixels(columns, 0);
-	  eof = gTrue;
-	  break;
-	default:
-	  error(errSyntaxError, getPos(),
-		"Bad 2D code {0:04x} in CCITTFax stream", code1);
-	  addPixels(columns, 0);
-	  err = gTrue;
-	  break;
 	}
+	break;
+      case EOF:
+	addPixels(columns, 0);
+	eof = gTrue;
+	break;
+      default:
+	error(errSyntaxError, getPos(),
+	      "Bad 2D code {0:04x} in CCITTFax stream", code1);
+	addPixels(columns, 0);
+	err = gTrue;
+	break;
       }
+    }
 
-    // 1-D encoding
-    } else {
-      codingLine[0] = 0;
-      a0i = 0;
-      blackPixels = 0;
-      while (codingLine[a0i] < columns) {
-	code1 = 0;
-	if (blackPixels) {
-	  do {
-	    code1 += code3 = getBlackCode();
-	  } while (code3 >= 64);
-	} else {
-	  do {
-	    code1 += code3 = getWhiteCode();
-	  } while (code3 >= 64);
-	}
-	addPixels(codingLine[a0i] + code1, blackPixels);
-	blackPixels ^= 1;
+  // 1-D encoding
+  } else {
+    codingLine[0] = 0;
+    a0i = 0;
+    blackPixels = 0;
+    while (codingLine[a0i] < columns) {
+      code1 = 0;
+      if (blackPixels) {
+	do {
+	  code1 += code3 = getBlackCode();
+	} while (code3 >= 64);
+      } else {
+	do {
+	  code1 += code3 = getWhiteCode();
+	} while (code3 >= 64);
       }
+      addPixels(codingLine[a0i] + code1, blackPixels);
+      blackPixels ^= 1;
     }
+  }
 
-    // check for end-of-line marker, skipping over any extra zero bits
-    // (if EncodedByteAlign is true and EndOfLine is false, there can
-    // be "false" EOL markers -- i.e., if the last n unused bits in
-    // row i are set to zero, and the first 11-n bits in row i+1
-    // happen to be zero -- so we don't look for EOL markers in this
-    // case)
-    gotEOL = gFalse;
-    if (!endOfBlock && row == rows - 1) {
-      eof = gTrue;
-    } else if (endOfLine || !byteAlign) {
-      code1 = lookBits(12);
-      if (endOfLine) {
-	while (code1 != EOF && code1 != 0x001) {
-	  eatBits(1);
-	  code1 = lookBits(12);
-	}
-      } else {
-	while (code1 == 0) {
-	  eatBits(1);
-	  code1 = lookBits(12);
-	}
+  // check for end-of-line marker, skipping over any extra zero bits
+  // (if EncodedByteAlign is true and EndOfLine is false, there can
+  // be "false" EOL markers -- i.e., if the last n unused bits in
+  // row i are set to zero, and the first 11-n bits in row i+1
+  // happen to be zero -- so we don't look for EOL markers in this
+  // case)
+  gotEOL = gFalse;
+  if (!endOfBlock && row == rows - 1) {
+    eof = gTrue;
+  } else if (endOfLine || !byteAlign) {
+    code1 = lookBits(12);
+    if (endOfLine) {
+      while (code1 != EOF && code1 != 0x001) {
+	eatBits(1);
+	code1 = lookBits(12);
       }
-      if (code1 == 0x001) {
-	eatBits(12);
-	gotEOL = gTrue;
+    } else {
+      while (code1 == 0) {
+	eatBits(1);
+	code1 = lookBits(12);
       }
     }
-
-    // byte-align the row
-    // (Adobe apparently doesn't do byte alignment after EOL markers
-    // -- I've seen CCITT image data streams in two different formats,
-    // both with the byteAlign flag set:
-    //   1. xx:x0:01:yy:yy
-    //   2. xx:00:1y:yy:yy
-    // where xx is the previous line, yy is the next line, and colons
-    // separate bytes.)
-    if (byteAlign && !gotEOL) {
-      inputBits &= ~7;
+    if (code1 == 0x001) {
+      eatBits(12);
+      gotEOL = gTrue;
     }
+  }
 
-    // check for end of stream
-    if (lookBits(1) == EOF) {
-      eof = gTrue;
-    }
+  // byte-align the row
+  // (Adobe apparently doesn't do byte alignment after EOL markers
+  // -- I've seen CCITT image data streams in two different formats,
+  // both with the byteAlign flag set:
+  //   1. xx:x0:01:yy:yy
+  //   2. xx:00:1y:yy:yy
+  // where xx is the previous line, yy is the next line, and colons
+  // separate bytes.)
+  if (byteAlign && !gotEOL) {
+    inputBits &= ~7;
+  }
 
-    // get 2D encoding tag
-    if (!eof && encoding > 0) {
-      nextLine2D = !lookBits(1);
-      eatBits(1);
-    }
+  // check for end of stream
+  if (lookBits(1) == EOF) {
+    eof = gTrue;
+  }
 
-    // check for end-of-block marker
-    if (endOfBlock && !endOfLine && byteAlign) {
-      // in this case, we didn't check for an EOL code above, so we
-      // need to check here
-      code1 = lookBits(24);
-      if (code1 == 0x001001) {
-	eatBits(12);
-	gotEOL = gTrue;
-      }
+  // get 2D encoding tag
+  if (!eof && encoding > 0) {
+    nextLine2D = !lookBits(1);
+    eatBits(1);
+  }
+
+  // check for end-of-block marker
+  if (endOfBlock && !endOfLine && byteAlign) {
+    // in this case, we didn't check for an EOL code above, so we
+    // need to check here
+    code1 = lookBits(24);
+    if (code1 == 0x001001) {
+      eatBits(12);
+      gotEOL = gTrue;
     }
-    if (endOfBlock && gotEOL) {
-      code1 = lookBits(12);
-      if (code1 == 0x001) {
-	eatBits(12);
-	if (encoding > 0) {
-	  lookBits(1);
-	  eatBits(1);
-	}
-	if (encoding >= 0) {
-	  for (i = 0; i < 4; ++i) {
-	    code1 = lookBits(12);
-	    if (code1 != 0x001) {
-	      error(errSyntaxError, getPos(),
-		    "Bad RTC code in CCITTFax stream");
-	    }
-	    eatBits(12);
-	    if (encoding > 0) {
-	      lookBits(1);
-	      eatBits(1);
-	    }
+  }
+  if (endOfBlock && gotEOL) {
+    code1 = lookBits(12);
+    if (code1 == 0x001) {
+      eatBits(12);
+      if (encoding > 0) {
+	lookBits(1);
+	eatBits(1);
+      }
+      if (encoding >= 0) {
+	for (i = 0; i < 4; ++i) {
+	  code1 = lookBits(12);
+	  if (code1 != 0x001) {
+	    error(errSyntaxError, getPos(),
+		  "Bad RTC code in CCITTFax stream");
+	  }
+	  eatBits(12);
+	  if (encoding > 0) {
+	    lookBits(1);
+	    eatBits(1);
 	  }
 	}
+      }
+      eof = gTrue;
+    }
+
+  // look for an end-of-line marker after an error -- we only do
+  // this if we know the stream contains end-of-line markers because
+  // the "just plow on" technique tends to work better otherwise
+  } else if (err && endOfLine) {
+    while (1) {
+      code1 = lookBits(13);
+      if (code1 == EOF) {
 	eof = gTrue;
+	return gFalse;
+      }
+      if ((code1 >> 1) == 0x001) {
+	break;
       }
+      eatBits(1);
+    }
+    eatBits(12); 
+    if (encoding > 0) {
+      eatBits(1);
+      nextLine2D = !(code1 & 1);
+    }
+  }
 
-    // look for an end-of-line marker after an error -- we only do
-    // this if we know the stream contains end-of-line markers because
-    // the "just plow on" technique tends to work better otherwise
-    } else if (err && endOfLine) {
-      while (1) {
-	code1 = lookBits(13);
-	if (code1 == EOF) {
-	  eof = gTrue;
-	  return EOF;
-	}
-	if ((code1 >> 1) == 0x001) {
-	  break;
-	}
-	eatBits(1);
+  // set up for output
+  if (codingLine[0] > 0) {
+    outputBits = codingLine[a0i = 0];
+  } else {
+    outputBits = codingLine[a0i = 1];
+  }
+
+  ++row;
+  return gTrue;
+}
+
+int CCITTFaxStream::lookChar() {
+  if (buf != EOF) {
+    return buf;
+  }
+
+  // read the next row
+  if (outputBits == 0) {
+    if (eof || !readRow()) {
+      return EOF;
+    }
+  }
+
+  buf = nextByte();
+  return buf;
+}
+
+int CCITTFaxStream::getChars(int nChars, Guchar *buffer) {
+  int n, rowBytes;
+
+  n = 0;
+  if (buf != EOF && n < nChars) {
+    buffer[n++] = buf;
+    buf = EOF;
+  }
+  rowBytes = (columns + 7) >> 3;
+  while (n < nChars) {
+    if (outputBits == 0) {
+      if (eof || !readRow()) {
+	break;
       }
-      eatBits(12); 
-      if (encoding > 0) {
-	eatBits(1);
-	nextLine2D = !(code1 & 1);
+      // a row wanted whole goes straight into the buffer
+      if (nChars - n >= rowBytes && packRow(buffer + n)) {
+	n += rowBytes;
+	continue;
       }
     }
+    buffer[n++] = nextByte();
+  }
+  return n;
+}
 
-    // set up for output
-    if (codingLine[0] > 0) {
-      outputBits = codingLine[a0i = 0];
-    } else {
-      outputBits = codingLine[a0i = 1];
+// Set the bits for pixels x0 .. x1-1 of a packed row.
+static inline void ccittSetBits(Guchar *line, int x0, int x1) {
+  int b0 = x0 >> 3, b1 = x1 >> 3;
+
+  if (b0 == b1) {
+    line[b0] |= (0xff >> (x0 & 7)) & ~(0xff >> (x1 & 7));
+    return;
+  }
+  line[b0] |= 0xff >> (x0 & 7);
+  memset(line + b0 + 1, 0xff, b1 - b0 - 1);
+  if (x1 & 7) {
+    line[b1] |= ~(0xff >> (x1 & 7));
+  }
+}
+
+// Pack the row just read into line, as the bytes nextByte() would
+// return for it.  Returns false, leaving the row to nextByte(), if its
+// changing elements don't increase up to columns.
+GBool CCITTFaxStream::packRow(Guchar *line) {
+  int rowBytes, i, x0, x1;
+
+  for (i = a0i, x0 = 0; i <= columns; ++i) {
+    if ((x1 = codingLine[i]) <= x0 || x1 > columns) {
+      return gFalse;
+    }
+    if (x1 == columns) {
+      break;
     }
+    x0 = x1;
+  }
+  if (i > columns) {
+    return gFalse;
+  }
 
-    ++row;
+  // runs alternate white (bits set) and black, starting with white
+  // at codingLine[0]
+  rowBytes = (columns + 7) >> 3;
+  memset(line, 0, rowBytes);
+  for (i = a0i, x0 = 0; x0 < columns; ++i) {
+    x1 = codingLine[i];
+    if (!(i & 1)) {
+      ccittSetBits(line, x0, x1);
+    }
+    x0 = x1;
   }
+  if (black) {
+    for (i = 0; i < rowBytes; ++i) {
+      line[i] ^= 0xff;
+    }
+  }
+  outputBits = 0;
+  return gTrue;
+}
+
+// Get the next byte of the current row.
+int CCITTFaxStream::nextByte() {
+  int c, bits;
 
-  // get a byte
   if (outputBits >= 8) {
-    buf = (a0i & 1) ? 0x00 : 0xff;
+    c = (a0i & 1) ? 0x00 : 0xff;
     outputBits -= 8;
     if (outputBits == 0 && codingLine[a0i] < columns) {
       ++a0i;
@@ -2121,19 +2503,19 @@ int CCITTFaxStream::lookChar() {
     }
   } else {
     bits = 8;
-    buf = 0;
+    c = 0;
     do {
       if (outputBits > bits) {
-	buf <<= bits;
+	c <<= bits;
 	if (!(a0i & 1)) {
-	  buf |= 0xff >> (8 - bits);
+	  c |= 0xff >> (8 - bits);
 	}
 	outputBits -= bits;
 	bits = 0;
       } else {
-	buf <<= outputBits;
+	c <<= outputBits;
 	if (!(a0i & 1)) {
-	  buf |= 0xff >> (8 - outputBits);
+	  c |= 0xff >> (8 - outputBits);
 	}
 	bits -= outputBits;
 	outputBits = 0;
@@ -2147,16 +2529,16 @@ int CCITTFaxStream::lookChar() {
 	  }
 	  outputBits = codingLine[a0i] - codingLine[a0i - 1];
 	} else if (bits > 0) {
-	  buf <<= bits;
+	  c <<= bits;
 	  bits = 0;
 	}
       }
     } while (bits);
   }
   if (black) {
-    buf ^= 0xff;
+    c ^= 0xff;
   }
-  return buf;
+  return c;
 }
 
 short CCITTFaxStream::getTwoDimCode() {
@@ -3865,7 +4247,6 @@ GBool DCTStream::isBinary(GBool last) {
 
 #endif
 
-#ifndef ENABLE_ZLIB_UNCOMPRESS
 //------------------------------------------------------------------------
 // FlateStream
 //------------------------------------------------------------------------
@@ -4514,6 +4895,13 @@ FlateStream::FlateStream(Stream *strA, int predictor, int columns,
   litCodeTab.codes = NULL;
   distCodeTab.codes = NULL;
   memset(buf, 0, flateWindow);
+  // inline images can't be read ahead of what inflating needs, and
+  // are small anyway
+  useZlib = !dynamic_cast<EmbedStream *>(str->getBaseStream());
+  zlibActive = gFalse;
+  zstream = NULL;
+  zlibIn = NULL;
+  zlibOut = 0;
 }
 
 FlateStream::~FlateStream() {
@@ -4526,6 +4914,9 @@ FlateStream::~FlateStream() {
   if (pred) {
     delete pred;
   }
+#if ENABLE_ZLIB_UNCOMPRESS
+  zlibFallBack();
+#endif
   delete str;
 }
 
@@ -4542,6 +4933,7 @@ void FlateStream::flateReset(GBool unfiltered) {
   compressedBlock = gFalse;
   endOfBlock = gTrue;
   eof = gTrue;
+  zlibActive = gFalse;
 }
 
 void FlateStream::unfilteredReset() {
@@ -4553,6 +4945,11 @@ void FlateStream::reset() {
 
   flateReset(gFalse);
 
+#if ENABLE_ZLIB_UNCOMPRESS
+  if (zlibReset())
+    return;
+#endif
+
   // read header
   //~ need to look at window size?
   endOfBlock = eof = gTrue;
@@ -4584,16 +4981,29 @@ int FlateStream::getChar() {
 }
 
 int FlateStream::getChars(int nChars, Guchar *buffer) {
+  int n, m;
+
   if (pred) {
     return pred->getChars(nChars, buffer);
-  } else {
-    for (int i = 0; i < nChars; ++i) {
-      const int c = doGetRawChar();
-      if (likely(c != EOF)) buffer[i] = c;
-      else return i;
-    }
-    return nChars;
   }
+  n = 0;
+  while (n < nChars) {
+    while (remain == 0) {
+      if (endOfBlock && eof)
+        return n;
+      readSome();
+    }
+    m = remain;
+    if (m > flateWindow - index)
+      m = flateWindow - index;
+    if (m > nChars - n)
+      m = nChars - n;
+    memcpy(buffer + n, buf + index, m);
+    index = (index + m) & flateMask;
+    remain -= m;
+    n += m;
+  }
+  return n;
 }
 
 int FlateStream::lookChar() {
@@ -4612,8 +5022,29 @@ int FlateStream::lookChar() {
 }
 
 void FlateStream::getRawChars(int nChars, int *buffer) {
-  for (int i = 0; i < nChars; ++i)
-    buffer[i] = doGetRawChar();
+  int n, m, i;
+
+  n = 0;
+  while (n < nChars) {
+    while (remain == 0) {
+      if (endOfBlock && eof) {
+        for (; n < nChars; ++n)
+          buffer[n] = EOF;
+        return;
+      }
+      readSome();
+    }
+    m = remain;
+    if (m > flateWindow - index)
+      m = flateWindow - index;
+    if (m > nChars - n)
+      m = nChars - n;
+    for (i = 0; i < m; ++i)
+      buffer[n + i] = buf[index + i];
+    index = (index + m) & flateMask;
+    remain -= m;
+    n += m;
+  }
 }
 
 int FlateStream::getRawChar() {
@@ -4643,6 +5074,13 @@ void FlateStream::readSome() {
   int i, j, k;
   int c;
 
+#if ENABLE_ZLIB_UNCOMPRESS
+  if (zlibActive) {
+    zlibReadSome();
+    return;
+  }
+#endif
+
   if (endOfBlock) {
     if (!startBlock())
       return;
@@ -4960,7 +5398,6 @@ int FlateStream::getCodeWord(int bits) {
   codeSize -= bits;
   return c;
 }
-#endif
 
 //------------------------------------------------------------------------
 // EOFStream
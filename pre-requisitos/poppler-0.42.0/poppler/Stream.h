@@ -220,6 +220,12 @@ public:
   virtual void getImageParams(int * /*bitsPerComponent*/,
 			      StreamColorSpaceMode * /*csMode*/) {}
 
+  // Tell an image decoder the size in device pixels the image is drawn
+  // at, before it is decoded.  Decoders able to decode at a lower
+  // resolution may do so, while still returning the number of pixels
+  // in the image dictionary.
+  virtual void setDrawSize(double /*width*/, double /*height*/) {}
+
   // Return the next stream in the "stack".
   virtual Stream *getNextStream() { return NULL; }
 
@@ -322,6 +328,10 @@ public:
   virtual Goffset getStart() = 0;
   virtual void moveStart(Goffset delta) = 0;
 
+  // Hint that the <len> bytes at <pos> in the file will be read soon,
+  // so that they can be read ahead in the background.
+  virtual void prefetch(Goffset pos, Goffset len) {}
+
 protected:
 
   Goffset length;
@@ -432,6 +442,7 @@ private:
   int pixBytes;			// bytes per pixel
   int rowBytes;			// bytes per line
   Guchar *predLine;		// line buffer
+  int *rawLine;			// raw (predicted) line
   int predIdx;			// current index in predLine
   GBool ok;
 };
@@ -442,6 +453,15 @@ private:
 
 #define fileStreamBufSize 256
 
+// The file is read in aligned chunks of fileChunkSize bytes, and the
+// last fileChunkCacheSize chunks read are kept, shared by a FileStream
+// and all the streams made from it, so that the many small reads of
+// the parser each do not cost a read from the file.
+#define fileChunkSize 65536
+#define fileChunkCacheSize 32
+
+class FileChunkCache;
+
 class FileStream: public BaseStream {
 public:
 
@@ -462,12 +482,15 @@ public:
   virtual void setPos(Goffset pos, int dir = 0);
   virtual Goffset getStart() { return start; }
   virtual void moveStart(Goffset delta);
+  virtual void prefetch(Goffset pos, Goffset len);
 
   virtual int getUnfilteredChar () { return getChar(); }
   virtual void unfilteredReset () { reset(); }
 
 private:
 
+  FileStream(GooFile* fileA, FileChunkCache *cacheA, Goffset startA,
+	     GBool limitedA, Goffset lengthA, Object *dictA);
   GBool fillBuf();
   
   virtual GBool hasGetChars() { return true; }
@@ -495,6 +518,7 @@ private:
 
 private:
   GooFile* file;
+  FileChunkCache *cache;
   Goffset offset;
   Goffset start;
   GBool limited;
@@ -575,6 +599,8 @@ public:
   virtual void setPos(Goffset pos, int dir = 0);
   virtual Goffset getStart() { return start; }
   virtual void moveStart(Goffset delta);
+  // Returns the data of the stream, in the buffer it was made on.
+  const char *getData() { return buf + start; }
 
   //if needFree = true, the stream will delete buf when it is destroyed
   //otherwise it will not touch it. Default value is false
@@ -805,6 +831,13 @@ public:
 private:
 
   void ccittReset(GBool unfiltered);
+  GBool readRow();
+  GBool packRow(Guchar *line);
+  int nextByte();
+
+  virtual GBool hasGetChars() { return true; }
+  virtual int getChars(int nChars, Guchar *buffer);
+
   int encoding;			// 'K' parameter
   GBool endOfLine;		// 'EndOfLine' parameter
   GBool byteAlign;		// 'EncodedByteAlign' parameter
@@ -942,7 +975,6 @@ private:
 
 #endif
 
-#ifndef ENABLE_ZLIB_UNCOMPRESS
 //------------------------------------------------------------------------
 // FlateStream
 //------------------------------------------------------------------------
@@ -1039,8 +1071,20 @@ private:
   void compHuffmanCodes(int *lengths, int n, FlateHuffmanTab *tab);
   int getHuffmanCodeWord(FlateHuffmanTab *tab);
   int getCodeWord(int bits);
+
+  // With ENABLE_ZLIB_UNCOMPRESS, zlib inflates the stream and the code
+  // above only takes over, from the start, if zlib finds it malformed
+  // (FlateStream.cc).
+  GBool zlibReset();
+  void zlibReadSome();
+  void zlibFallBack();
+
+  GBool useZlib;		// set if zlib may inflate this stream
+  GBool zlibActive;		// set while zlib is inflating it
+  void *zstream;		// zlib state (z_stream)
+  Guchar *zlibIn;		// zlib input buffer
+  Goffset zlibOut;		// bytes inflated by zlib since the reset
 };
-#endif
 
 //------------------------------------------------------------------------
 // EOFStream
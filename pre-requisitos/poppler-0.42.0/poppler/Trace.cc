@@ -0,0 +1,44 @@
+//========================================================================
+//
+// Trace.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Copyright 2017 Agencia Nacional de Telecomunicacoes
+//
+//========================================================================
+
+#include <config.h>
+
+#ifdef USE_GCC_PRAGMAS
+#pragma implementation
+#endif
+
+#include <stddef.h>
+#include "Trace.h"
+
+static TraceCallback traceBeginCbk = NULL;
+static TraceCallback traceEndCbk = NULL;
+static void *traceCbkData = NULL;
+
+void setTraceCallbacks(TraceCallback begin, TraceCallback end, void *data) {
+  traceBeginCbk = begin;
+  traceEndCbk = end;
+  traceCbkData = data;
+}
+
+TraceSpan::TraceSpan(const char *nameA) {
+  name = nameA;
+  // A span that began before the callbacks were cleared still ends.
+  traced = traceBeginCbk != NULL && traceEndCbk != NULL;
+  if (traced) {
+    (*traceBeginCbk)(traceCbkData, name);
+  }
+}
+
+TraceSpan::~TraceSpan() {
+  TraceCallback end = traceEndCbk;
+  if (traced && end) {
+    (*end)(traceCbkData, name);
+  }
+}
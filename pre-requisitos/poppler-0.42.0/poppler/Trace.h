@@ -0,0 +1,49 @@
+//========================================================================
+//
+// Trace.h
+//
+// This file is licensed under the GPLv2 or later
+//
+// Copyright 2017 Agencia Nacional de Telecomunicacoes
+//
+//========================================================================
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef USE_GCC_PRAGMAS
+#pragma interface
+#endif
+
+#include "goo/gtypes.h"
+
+// Hooks through which a program can put the time spent in some stages of
+// poppler, such as the display of a page, on its own timeline. Nothing is
+// traced until the program sets the callbacks, which then get the name of
+// each span as it begins and as it ends, on the thread that runs it. The
+// names are string literals.
+typedef void (*TraceCallback)(void *data, const char *name);
+
+extern void setTraceCallbacks(TraceCallback begin, TraceCallback end,
+			      void *data);
+
+// Traces the life of the object as a span.
+class TraceSpan {
+public:
+  TraceSpan(const char *nameA);
+  ~TraceSpan();
+
+private:
+  const char *name;
+  GBool traced;
+};
+
+// Traces the rest of the enclosing scope; compiled out with
+// POPPLER_TRACING_DISABLED.
+#ifdef POPPLER_TRACING_DISABLED
+#define POPPLER_TRACE_SPAN(name)
+#else
+#define POPPLER_TRACE_SPAN(name) TraceSpan traceSpan(name)
+#endif
+
+#endif
@@ -43,6 +43,8 @@
 #include <ctype.h>
 #include <limits.h>
 #include <float.h>
+#include <list>
+#include <map>
 #include "goo/gfile.h"
 #include "goo/gmem.h"
 #include "Object.h"
@@ -70,6 +72,11 @@
 #define permHighResPrint  (1<<11) // bit 12
 #define defPermFlags 0xfffc
 
+// Default number of fetched objects and of parsed object streams kept
+// by an XRef.
+#define defObjCacheSize 1024
+#define defObjStrCacheSize 64
+
 #if MULTITHREADED
 #  define xrefLocker()   MutexLocker locker(&mutex)
 #  define xrefCondLocker(X)  MutexLocker locker(&mutex, (X))
@@ -109,37 +116,162 @@ private:
   GBool ok;
 };
 
-class ObjectStreamKey : public PopplerCacheKey
+class ObjectStreamItem : public PopplerCacheItem
 {
   public:
-    ObjectStreamKey(int num) : objStrNum(num)
+    ObjectStreamItem(ObjectStream *objStr) : objStream(objStr)
     {
     }
 
-    bool operator==(const PopplerCacheKey &key) const
+    ~ObjectStreamItem()
     {
-      const ObjectStreamKey *k = static_cast<const ObjectStreamKey*>(&key);
-      return objStrNum == k->objStrNum;
+      delete objStream;
     }
 
-    const int objStrNum;
+    ObjectStream *objStream;
 };
 
-class ObjectStreamItem : public PopplerCacheItem
+// Copies <src> into <dst> with dictionaries and arrays copied all the
+// way down, so <dst> shares nothing that a caller could change.
+static Object *deepCopy(Object *src, Object *dst, XRef *xref) {
+  Object obj1, obj2;
+  int i;
+
+  if (src->isDict()) {
+    Dict *dict = src->getDict();
+    dst->initDict(xref);
+    for (i = 0; i < dict->getLength(); ++i) {
+      deepCopy(dict->getValNF(i, &obj1), &obj2, xref);
+      obj1.free();
+      dst->dictAdd(copyString(dict->getKey(i)), &obj2);
+    }
+  } else if (src->isArray()) {
+    Array *array = src->getArray();
+    dst->initArray(xref);
+    for (i = 0; i < array->getLength(); ++i) {
+      deepCopy(array->getNF(i, &obj1), &obj2, xref);
+      obj1.free();
+      dst->arrayAdd(&obj2);
+    }
+  } else {
+    src->copy(dst);
+  }
+  return dst;
+}
+
+// A fetched object as parsed.  Callers may change the dictionaries and
+// arrays they fetch (pdfunite rewrites page dictionaries, for instance),
+// so the cache keeps its own copy and hands out copies of it.
+class FetchedObjectItem : public PopplerCacheItem
 {
   public:
-    ObjectStreamItem(ObjectStream *objStr) : objStream(objStr)
+    FetchedObjectItem(Object *obj, int genA, Goffset offsetA, XRef *xref) :
+      gen(genA), offset(offsetA)
     {
+      deepCopy(obj, &item, xref);
     }
 
-    ~ObjectStreamItem()
+    ~FetchedObjectItem()
     {
-      delete objStream;
+      item.free();
     }
 
-    ObjectStream *objStream;
+    Object item;
+    int gen;			// generation and offset of the xref entry
+    Goffset offset;		//   the object was parsed from
+};
+
+//------------------------------------------------------------------------
+// XRefCache
+//------------------------------------------------------------------------
+
+// Least recently used cache of items keyed by object number.  Unlike
+// PopplerCache, lookups do not scan the cache, so it can be large.
+class XRefCache {
+public:
+
+  XRefCache(int maxItemsA) : maxItems(maxItemsA) {}
+  ~XRefCache() { clear(); }
+
+  // The item returned is owned by the cache.
+  PopplerCacheItem *lookup(int num);
+
+  // The cache takes ownership of <item>, replacing any item for <num>.
+  void put(int num, PopplerCacheItem *item);
+
+  void remove(int num);
+  void clear();
+
+  // Change the maximum number of items, dropping the least recently
+  // used ones if there are more.
+  void setMaxItems(int maxItemsA);
+  int getMaxItems() { return maxItems; }
+
+private:
+
+  struct Entry {
+    PopplerCacheItem *item;
+    std::list<int>::iterator use;	// position in <uses>
+  };
+
+  std::map<int, Entry> items;
+  std::list<int> uses;			// object numbers, most recent first
+  int maxItems;
 };
 
+PopplerCacheItem *XRefCache::lookup(int num) {
+  std::map<int, Entry>::iterator it = items.find(num);
+  if (it == items.end()) {
+    return NULL;
+  }
+  uses.splice(uses.begin(), uses, it->second.use);
+  return it->second.item;
+}
+
+void XRefCache::put(int num, PopplerCacheItem *item) {
+  Entry entry;
+
+  remove(num);
+  if (maxItems <= 0) {
+    delete item;
+    return;
+  }
+  while ((int)items.size() >= maxItems) {
+    remove(uses.back());
+  }
+  uses.push_front(num);
+  entry.item = item;
+  entry.use = uses.begin();
+  items[num] = entry;
+}
+
+void XRefCache::remove(int num) {
+  std::map<int, Entry>::iterator it = items.find(num);
+  if (it == items.end()) {
+    return;
+  }
+  delete it->second.item;
+  uses.erase(it->second.use);
+  items.erase(it);
+}
+
+void XRefCache::clear() {
+  std::map<int, Entry>::iterator it;
+
+  for (it = items.begin(); it != items.end(); ++it) {
+    delete it->second.item;
+  }
+  items.clear();
+  uses.clear();
+}
+
+void XRefCache::setMaxItems(int maxItemsA) {
+  maxItems = maxItemsA;
+  while ((int)items.size() > (maxItems > 0 ? maxItems : 0)) {
+    remove(uses.back());
+  }
+}
+
 ObjectStream::ObjectStream(XRef *xref, int objStrNumA, int recursion) {
   Stream *str;
   Parser *parser;
@@ -288,7 +420,8 @@ void XRef::init() {
   size = 0;
   streamEnds = NULL;
   streamEndsLen = 0;
-  objStrs = new PopplerCache(5);
+  objCache = new XRefCache(defObjCacheSize);
+  objStrs = new XRefCache(defObjStrCacheSize);
   mainXRefEntriesOffset = 0;
   xRefStream = gFalse;
   scannedSpecialFlags = gFalse;
@@ -398,9 +531,8 @@ XRef::~XRef() {
   if (streamEnds) {
     gfree(streamEnds);
   }
-  if (objStrs) {
-    delete objStrs;
-  }
+  delete objCache;
+  delete objStrs;
   if (strOwner) {
     delete str;
   }
@@ -410,6 +542,7 @@ XRef::~XRef() {
 }
 
 XRef *XRef::copy() {
+  xrefLocker();
   XRef *xref = new XRef();
   xref->str = str->copy();
   xref->strOwner = gTrue;
@@ -418,11 +551,16 @@ XRef *XRef::copy() {
   xref->ownerPasswordOk = ownerPasswordOk;
   xref->rootGen = rootGen;
   xref->rootNum = rootNum;
+  xref->objCache->setMaxItems(objCache->getMaxItems());
+  xref->objStrs->setMaxItems(objStrs->getMaxItems());
 
   xref->start = start;
   xref->prevXRefOffset = prevXRefOffset;
   xref->mainXRefEntriesOffset = mainXRefEntriesOffset;
   xref->xRefStream = xRefStream;
+  xref->mainXRefOffset = mainXRefOffset;
+  // the special flags are copied with the entries below
+  xref->scannedSpecialFlags = scannedSpecialFlags;
   trailerDict.copy(&xref->trailerDict);
   xref->encAlgorithm = encAlgorithm;
   xref->encRevision = encRevision;
@@ -910,6 +1048,7 @@ GBool XRef::constructXRef(GBool *wasReconstructed, GBool needCatalogDict) {
   capacity = 0;
   size = 0;
   entries = NULL;
+  flushCache();
 
   gotRoot = gFalse;
   streamEndsLen = streamEndsSize = 0;
@@ -1060,6 +1199,8 @@ void XRef::setEncryption(int permFlagsA, GBool ownerPasswordOkA,
   encVersion = encVersionA;
   encRevision = encRevisionA;
   encAlgorithm = encAlgorithmA;
+  // objects fetched so far were not decrypted
+  flushCache();
 }
 
 void XRef::getEncryptionParameters(Guchar **fileKeyA, CryptAlgorithm *encAlgorithmA,
@@ -1152,9 +1293,17 @@ Object *XRef::fetch(int num, int gen, Object *obj, int recursion) {
   switch (e->type) {
 
   case xrefEntryUncompressed:
+  {
     if (e->gen != gen) {
       goto err;
     }
+    PopplerCacheItem *item = objCache->lookup(num);
+    if (item) {
+      FetchedObjectItem *it = static_cast<FetchedObjectItem *>(item);
+      if (it->gen == e->gen && it->offset == e->offset) {
+	return deepCopy(&it->item, obj, this);
+      }
+    }
     obj1.initNull();
     parser = new Parser(this,
 	       new Lexer(this,
@@ -1202,7 +1351,14 @@ Object *XRef::fetch(int num, int gen, Object *obj, int recursion) {
     obj2.free();
     obj3.free();
     delete parser;
+    // streams keep a read position, so only other objects are kept;
+    // a nested fetch may have been cut short by the recursion limit
+    if (recursion == 0 && !obj->isStream() && !obj->isError() &&
+	!obj->isNull()) {
+      objCache->put(num, new FetchedObjectItem(obj, e->gen, e->offset, this));
+    }
     break;
+  }
 
   case xrefEntryCompressed:
   {
@@ -1218,8 +1374,7 @@ Object *XRef::fetch(int num, int gen, Object *obj, int recursion) {
     }
 
     ObjectStream *objStr = NULL;
-    ObjectStreamKey key(e->offset);
-    PopplerCacheItem *item = objStrs->lookup(key);
+    PopplerCacheItem *item = objStrs->lookup((int)e->offset);
     if (item) {
       ObjectStreamItem *it = static_cast<ObjectStreamItem *>(item);
       objStr = it->objStream;
@@ -1234,9 +1389,7 @@ Object *XRef::fetch(int num, int gen, Object *obj, int recursion) {
       } else {
 	// XRef could be reconstructed in constructor of ObjectStream:
 	e = getEntry(num);
-	ObjectStreamKey *newkey = new ObjectStreamKey(e->offset);
-	ObjectStreamItem *newitem = new ObjectStreamItem(objStr);
-	objStrs->put(newkey, newitem);
+	objStrs->put((int)e->offset, new ObjectStreamItem(objStr));
       }
     }
     objStr->getObject(e->gen, num, obj);
@@ -1258,6 +1411,17 @@ Object *XRef::fetch(int num, int gen, Object *obj, int recursion) {
   return obj->initNull();
 }
 
+void XRef::setCacheSize(int nObjects, int nObjStrs) {
+  xrefLocker();
+  objCache->setMaxItems(nObjects);
+  objStrs->setMaxItems(nObjStrs);
+}
+
+void XRef::flushCache() {
+  objCache->clear();
+  objStrs->clear();
+}
+
 void XRef::lock() {
 #if MULTITHREADED
   gLockMutex(&mutex);
@@ -1693,6 +1857,7 @@ void XRef::markUnencrypted(Object *obj) {
 }
 
 void XRef::scanSpecialFlags() {
+  xrefLocker();
   if (scannedSpecialFlags) {
     return;
   }
@@ -1731,6 +1896,9 @@ void XRef::scanSpecialFlags() {
   Object obj;
   markUnencrypted(trailerDict.dictLookupNF("Encrypt", &obj));
   obj.free();
+
+  // the Unencrypted flags change how objects are fetched
+  flushCache();
 }
 
 void XRef::markUnencrypted() {
@@ -1740,6 +1908,7 @@ void XRef::markUnencrypted() {
   if (obj.isRef()) {
     XRefEntry *e = getEntry(obj.getRefNum());
     e->setFlag(XRefEntry::Unencrypted, gTrue);
+    objCache->remove(obj.getRefNum());
   }
   obj.free();
 }
@@ -46,7 +46,7 @@
 class Dict;
 class Stream;
 class Parser;
-class PopplerCache;
+class XRefCache;
 
 //------------------------------------------------------------------------
 // XRef
@@ -145,6 +145,10 @@ public:
   // Fetch an indirect reference.
   Object *fetch(int num, int gen, Object *obj, int recursion = 0);
 
+  // Set the maximum number of fetched objects and of parsed object
+  // streams kept to speed up later fetches (0 disables either cache).
+  void setCacheSize(int nObjects, int nObjStrs);
+
   // Return the document's Info dictionary (if any).
   Object *getDocInfo(Object *obj);
   Object *getDocInfoNF(Object *obj);
@@ -206,7 +210,8 @@ private:
   Goffset *streamEnds;		// 'endstream' positions - only used in
 				//   damaged files
   int streamEndsLen;		// number of valid entries in streamEnds
-  PopplerCache *objStrs;	// cached object streams
+  XRefCache *objCache;		// cached fetched objects
+  XRefCache *objStrs;		// cached object streams
   GBool encrypted;		// true if file is encrypted
   int encRevision;		
   int encVersion;		// encryption algorithm
@@ -236,6 +241,7 @@ private:
   GBool parseEntry(Goffset offset, XRefEntry *entry);
   void readXRefUntil(int untilEntryNum, std::vector<int> *xrefStreamObjsNum = NULL);
   void markUnencrypted(Object *obj);
+  void flushCache();
 
   class XRefWriter {
   public:
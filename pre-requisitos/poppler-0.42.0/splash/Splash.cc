@@ -4155,7 +4155,11 @@ SplashBitmap *Splash::scaleImage(SplashImageSource src, void *srcData,
 
   dest = new SplashBitmap(scaledWidth, scaledHeight, 1, srcMode, srcAlpha, gTrue, bitmap->getSeparationList());
   if (dest->getDataPtr() != NULL) {
-    if (scaledHeight < srcHeight) {
+    if (scaledWidth == srcWidth && scaledHeight == srcHeight) {
+      // e.g., a scanned page rendered at its own resolution
+      copyImage(src, srcData, srcMode, nComps, srcAlpha,
+		srcWidth, srcHeight, dest);
+    } else if (scaledHeight < srcHeight) {
       if (scaledWidth < srcWidth) {
 	scaleImageYdXd(src, srcData, srcMode, nComps, srcAlpha,
 		      srcWidth, srcHeight, scaledWidth, scaledHeight, dest);
@@ -5031,6 +5035,49 @@ void Splash::scaleImageYuXuBilinear(SplashImageSource src, void *srcData,
   gfree(lineBuf2);
 }
 
+// Copy an image into a SplashBitmap of the same size, which is what
+// the scaling functions would produce, one row at a time.
+void Splash::copyImage(SplashImageSource src, void *srcData,
+		       SplashColorMode srcMode, int nComps,
+		       GBool srcAlpha, int width, int height,
+		       SplashBitmap *dest) {
+  Guchar *destPtr, *destAlphaPtr, *p;
+  Guchar t;
+  int y, x;
+
+  destPtr = dest->data;
+  destAlphaPtr = dest->alpha;
+  for (y = 0; y < height; ++y) {
+    (*src)(srcData, destPtr, destAlphaPtr);
+
+    // the image source returns RGB order, the bitmap stores BGR
+    switch (srcMode) {
+    case splashModeXBGR8:
+      for (x = 0, p = destPtr; x < width; ++x, p += 4) {
+	t = p[0];
+	p[0] = p[2];
+	p[2] = t;
+	p[3] = 255;
+      }
+      break;
+    case splashModeBGR8:
+      for (x = 0, p = destPtr; x < width; ++x, p += 3) {
+	t = p[0];
+	p[0] = p[2];
+	p[2] = t;
+      }
+      break;
+    default:
+      break;
+    }
+
+    destPtr += width * nComps;
+    if (srcAlpha) {
+      destAlphaPtr += width;
+    }
+  }
+}
+
 void Splash::vertFlipImage(SplashBitmap *img, int width, int height,
 			   int nComps) {
   Guchar *lineBuf;
@@ -5115,7 +5162,19 @@ void Splash::blitImage(SplashBitmap *src, GBool srcAlpha, int xDest, int yDest,
   if (x0 < w && y0 < h && x0 < x1 && y0 < y1) {
     pipeInit(&pipe, xDest + x0, yDest + y0, NULL, pixel,
 	     (Guchar)splashRound(state->fillAlpha * 255), srcAlpha, gFalse);
-    if (srcAlpha) {
+    if (!srcAlpha && src->getMode() == bitmap->mode &&
+	isSimpleCopy(&pipe)) {
+      // an opaque image over nothing special: the pipe would just
+      // copy the pixels
+      for (y = y0; y < y1; ++y) {
+	pipeSetXY(&pipe, xDest + x0, yDest + y);
+	memcpy(pipe.destColorPtr,
+	       src->getDataPtr() + y * src->getRowSize() +
+	         x0 * splashColorModeNComps[bitmap->mode],
+	       (x1 - x0) * splashColorModeNComps[bitmap->mode]);
+	memset(pipe.destAlphaPtr, 255, x1 - x0);
+      }
+    } else if (srcAlpha) {
       for (y = y0; y < y1; ++y) {
 	pipeSetXY(&pipe, xDest + x0, yDest + y);
 	ap = src->getAlphaPtr() + y * w + x0;
@@ -5156,6 +5215,32 @@ void Splash::blitImage(SplashBitmap *src, GBool srcAlpha, int xDest, int yDest,
   }
 }
 
+// Returns true if <pipe> writes its source color unchanged: a simple
+// pipe (see pipeInit) with identity transfer functions.
+GBool Splash::isSimpleCopy(SplashPipe *pipe) {
+  static Guchar identity[256];
+  static GBool identityInit = gFalse;
+  int i;
+
+  if (!identityInit) {
+    for (i = 0; i < 256; ++i) {
+      identity[i] = (Guchar)i;
+    }
+    identityInit = gTrue;
+  }
+  if (pipe->run == &Splash::pipeRunSimpleMono8) {
+    return !memcmp(state->grayTransfer, identity, 256);
+  }
+  if (pipe->run == &Splash::pipeRunSimpleRGB8 ||
+      pipe->run == &Splash::pipeRunSimpleBGR8 ||
+      pipe->run == &Splash::pipeRunSimpleXBGR8) {
+    return !memcmp(state->rgbTransferR, identity, 256) &&
+           !memcmp(state->rgbTransferG, identity, 256) &&
+           !memcmp(state->rgbTransferB, identity, 256);
+  }
+  return gFalse;
+}
+
 void Splash::blitImageClipped(SplashBitmap *src, GBool srcAlpha,
 			      int xSrc, int ySrc, int xDest, int yDest,
 			      int w, int h) {
@@ -396,10 +396,15 @@ private:
 		      GBool srcAlpha, int srcWidth, int srcHeight,
 		      int scaledWidth, int scaledHeight,
 		      SplashBitmap *dest);
+  void copyImage(SplashImageSource src, void *srcData,
+		 SplashColorMode srcMode, int nComps,
+		 GBool srcAlpha, int width, int height,
+		 SplashBitmap *dest);
   void vertFlipImage(SplashBitmap *img, int width, int height,
 		     int nComps);
   void blitImage(SplashBitmap *src, GBool srcAlpha, int xDest, int yDest,
 		 SplashClipResult clipRes);
+  GBool isSimpleCopy(SplashPipe *pipe);
   void blitImageClipped(SplashBitmap *src, GBool srcAlpha,
 			int xSrc, int ySrc, int xDest, int yDest,
 			int w, int h);
@@ -179,13 +179,50 @@ SplashError SplashBitmap::writePNMFile(char *fileName) {
 
 
 SplashError SplashBitmap::writePNMFile(FILE *f) {
+  SplashError e;
+
+  if ((e = writePNMHeader(f, height)) != splashOk) {
+    return e;
+  }
+  return writePNMRows(f);
+}
+
+SplashError SplashBitmap::writePNMHeader(FILE *f, int heightA) {
+  switch (mode) {
+
+  case splashModeMono1:
+    fprintf(f, "P4\n%d %d\n", width, heightA);
+    break;
+
+  case splashModeMono8:
+    fprintf(f, "P5\n%d %d\n255\n", width, heightA);
+    break;
+
+  case splashModeRGB8:
+  case splashModeXBGR8:
+  case splashModeBGR8:
+    fprintf(f, "P6\n%d %d\n255\n", width, heightA);
+    break;
+
+#if SPLASH_CMYK
+  case splashModeCMYK8:
+  case splashModeDeviceN8:
+    // PNM doesn't support CMYK
+    error(errInternal, -1, "unsupported SplashBitmap mode");
+    return splashErrGeneric;
+    break;
+#endif
+  }
+  return splashOk;
+}
+
+SplashError SplashBitmap::writePNMRows(FILE *f) {
   SplashColorPtr row, p;
   int x, y;
 
   switch (mode) {
 
   case splashModeMono1:
-    fprintf(f, "P4\n%d %d\n", width, height);
     row = data;
     for (y = 0; y < height; ++y) {
       p = row;
@@ -198,7 +235,6 @@ SplashError SplashBitmap::writePNMFile(FILE *f) {
     break;
 
   case splashModeMono8:
-    fprintf(f, "P5\n%d %d\n255\n", width, height);
     row = data;
     for (y = 0; y < height; ++y) {
       fwrite(row, 1, width, f);
@@ -207,7 +243,6 @@ SplashError SplashBitmap::writePNMFile(FILE *f) {
     break;
 
   case splashModeRGB8:
-    fprintf(f, "P6\n%d %d\n255\n", width, height);
     row = data;
     for (y = 0; y < height; ++y) {
       fwrite(row, 1, 3 * width, f);
@@ -216,7 +251,6 @@ SplashError SplashBitmap::writePNMFile(FILE *f) {
     break;
 
   case splashModeXBGR8:
-    fprintf(f, "P6\n%d %d\n255\n", width, height);
     row = data;
     for (y = 0; y < height; ++y) {
       p = row;
@@ -232,7 +266,6 @@ SplashError SplashBitmap::writePNMFile(FILE *f) {
 
 
   case splashModeBGR8:
-    fprintf(f, "P6\n%d %d\n255\n", width, height);
     row = data;
     for (y = 0; y < height; ++y) {
       p = row;
@@ -353,7 +386,22 @@ SplashError SplashBitmap::writeImgFile(SplashImageFileFormat format, char *fileN
 SplashError SplashBitmap::writeImgFile(SplashImageFileFormat format, FILE *f, int hDPI, int vDPI, const char *compressionString) {
   ImgWriter *writer;
 	SplashError e;
-  
+
+  if (!(writer = makeImgWriter(format, compressionString))) {
+    // Not the greatest error message, but users of this function should
+    // have already checked whether their desired format is compiled in.
+    error(errInternal, -1, "Support for this image type not compiled in");
+    return splashErrGeneric;
+  }
+
+	e = writeImgFile(writer, f, hDPI, vDPI);
+	delete writer;
+	return e;
+}
+
+ImgWriter *SplashBitmap::makeImgWriter(SplashImageFileFormat format, const char *compressionString) {
+  ImgWriter *writer;
+
   switch (format) {
     #ifdef ENABLE_LIBPNG
     case splashFormatPng:
@@ -402,15 +450,9 @@ SplashError SplashBitmap::writeImgFile(SplashImageFileFormat format, FILE *f, in
     #endif
 
     default:
-      // Not the greatest error message, but users of this function should
-      // have already checked whether their desired format is compiled in.
-      error(errInternal, -1, "Support for this image type not compiled in");
-      return splashErrGeneric;
+      return NULL;
   }
-
-	e = writeImgFile(writer, f, hDPI, vDPI);
-	delete writer;
-	return e;
+  return writer;
 }
 
 #include "poppler/GfxState_helpers.h"
@@ -631,23 +673,31 @@ SplashError SplashBitmap::writeImgFile(ImgWriter *writer, FILE *f, int hDPI, int
     return splashErrGeneric;
   }
 
+  if (writeImgRows(writer) != splashOk) {
+    return splashErrGeneric;
+  }
+
+  if (!writer->close()) {
+    return splashErrGeneric;
+  }
+
+  return splashOk;
+}
+
+// The rows go through ImgWriter::writeRow: writePointers writes a
+// whole image, which a strip is not.
+SplashError SplashBitmap::writeImgRows(ImgWriter *writer) {
   switch (mode) {
 #if SPLASH_CMYK
     case splashModeCMYK8:
       if (writer->supportCMYK()) {
-        SplashColorPtr row;
-        unsigned char **row_pointers = new unsigned char*[height];
-        row = data;
-
+        SplashColorPtr row = data;
         for (int y = 0; y < height; ++y) {
-          row_pointers[y] = row;
+          if (!writer->writeRow(&row)) {
+            return splashErrGeneric;
+          }
           row += rowSize;
         }
-        if (!writer->writePointers(row_pointers, height)) {
-          delete[] row_pointers;
-          return splashErrGeneric;
-        }
-        delete[] row_pointers;
       } else {
         unsigned char *row = new unsigned char[3 * width];
         for (int y = 0; y < height; y++) {
@@ -686,19 +736,13 @@ SplashError SplashBitmap::writeImgFile(ImgWriter *writer, FILE *f, int hDPI, int
 #endif
     case splashModeRGB8:
     {
-      SplashColorPtr row;
-      unsigned char **row_pointers = new unsigned char*[height];
-      row = data;
-
+      SplashColorPtr row = data;
       for (int y = 0; y < height; ++y) {
-        row_pointers[y] = row;
+        if (!writer->writeRow(&row)) {
+          return splashErrGeneric;
+        }
         row += rowSize;
       }
-      if (!writer->writePointers(row_pointers, height)) {
-        delete[] row_pointers;
-        return splashErrGeneric;
-      }
-      delete[] row_pointers;
     }
     break;
     
@@ -783,11 +827,7 @@ SplashError SplashBitmap::writeImgFile(ImgWriter *writer, FILE *f, int hDPI, int
     break;
     
     default:
-    // can't happen
-    break;
-  }
-  
-  if (!writer->close()) {
+    error(errInternal, -1, "unsupported SplashBitmap mode");
     return splashErrGeneric;
   }
 
@@ -76,6 +76,16 @@ public:
   SplashError writeImgFile(SplashImageFileFormat format, FILE *f, int hDPI, int vDPI, const char *compressionString = "");
   SplashError writeImgFile(ImgWriter *writer, FILE *f, int hDPI, int vDPI);
 
+  // Write an image a few rows at a time, e.g., a page rendered in
+  // horizontal strips: the header for an image of <heightA> rows is
+  // written (or <writer> initialized) once, then the rows of each
+  // strip, in order.  All the strips must have the same width and
+  // mode.  makeImgWriter returns NULL if <format> is not compiled in.
+  SplashError writePNMHeader(FILE *f, int heightA);
+  SplashError writePNMRows(FILE *f);
+  ImgWriter *makeImgWriter(SplashImageFileFormat format, const char *compressionString = "");
+  SplashError writeImgRows(ImgWriter *writer);
+
   enum ConversionMode
   {
       conversionOpaque,
@@ -119,12 +119,33 @@ SplashFTFontFile::SplashFTFontFile(SplashFTFontEngine *engineA,
 				   GBool trueTypeA, GBool type1A):
   SplashFontFile(idA, src)
 {
+  int flags[5];
+
   engine = engineA;
   face = faceA;
   codeToGID = codeToGIDA;
   codeToGIDLen = codeToGIDLenA;
   trueType = trueTypeA;
   type1 = type1A;
+
+  // the glyph bitmaps depend on the font data, the code-to-GID
+  // mapping, and the FreeType load flags (anti-aliasing is checked
+  // per SplashFont, since the engine can change it)
+  flags[0] = trueType;
+  flags[1] = type1;
+  flags[2] = (int)face->face_index;
+  flags[3] = engine->enableFreeTypeHinting;
+  flags[4] = engine->enableSlightHinting;
+  glyphKey = hashSrc();
+  if (codeToGID) {
+    glyphKey = hashGlyphKey(glyphKey, codeToGID,
+			    codeToGIDLen * (int)sizeof(int));
+  }
+  glyphKey = hashGlyphKey(glyphKey, &codeToGIDLen, (int)sizeof(int));
+  glyphKey = hashGlyphKey(glyphKey, flags, (int)sizeof(flags));
+  if (glyphKey == 0) {
+    glyphKey = 1;
+  }
 }
 
 SplashFTFontFile::~SplashFTFontFile() {
@@ -27,6 +27,9 @@
 #include <limits.h>
 #include <string.h>
 #include "goo/gmem.h"
+#if MULTITHREADED
+#include "goo/GooMutex.h"
+#endif
 #include "SplashMath.h"
 #include "SplashGlyphBitmap.h"
 #include "SplashFontFile.h"
@@ -41,6 +44,258 @@ struct SplashFontCacheTag {
   int x, y, w, h;		// offset and size of glyph
 };
 
+//------------------------------------------------------------------------
+// SplashGlyphCache
+//------------------------------------------------------------------------
+
+// Glyph bitmaps shared by all SplashFonts in the process, i.e., across
+// font engines, render threads, and documents.  A glyph is identified
+// by the font file's glyph key, the font matrix, the anti-aliasing
+// flag, the char code, and the fractional position.  Each SplashFont
+// still has its own small cache in front of this one; bitmaps are
+// always copied in and out, under the lock.
+
+struct SplashGlyphCacheEntry {
+  unsigned long long fontKey;
+  SplashCoord mat[4];
+  GBool aa;
+  int c;
+  short xFrac, yFrac;
+  int x, y, w, h;		// offset and size of glyph
+  int size;			// size of data, in bytes
+  Guchar *data;
+  SplashGlyphCacheEntry *hashNext;
+  SplashGlyphCacheEntry *prev;	// LRU list, most recently used first
+  SplashGlyphCacheEntry *next;
+};
+
+#define splashGlyphCacheHashSize 4096
+
+class SplashGlyphCache {
+public:
+
+  SplashGlyphCache();
+  ~SplashGlyphCache();
+
+  // Look up a glyph; on a hit, fill in <bitmap> with a copy of the
+  // cached bitmap.
+  GBool lookup(unsigned long long fontKey, SplashCoord *mat, GBool aa,
+	       int c, int xFrac, int yFrac, SplashGlyphBitmap *bitmap);
+
+  // Add a copy of <bitmap>, evicting the least recently used glyphs
+  // to stay under the size limit.
+  void insert(unsigned long long fontKey, SplashCoord *mat, GBool aa,
+	      int c, int xFrac, int yFrac, SplashGlyphBitmap *bitmap);
+
+  void setMaxSize(int maxSizeA);
+
+private:
+
+  static Guint hash(unsigned long long fontKey, SplashCoord *mat,
+		    int c, int xFrac, int yFrac);
+  SplashGlyphCacheEntry *find(Guint h, unsigned long long fontKey,
+			      SplashCoord *mat, GBool aa,
+			      int c, int xFrac, int yFrac);
+  void unlink(SplashGlyphCacheEntry *e);
+  void evict(int limit);
+
+  SplashGlyphCacheEntry *tab[splashGlyphCacheHashSize];
+  SplashGlyphCacheEntry *first, *last;
+  int size;			// total size of cached data, in bytes
+  int maxSize;
+#if MULTITHREADED
+  GooMutex mutex;
+#endif
+};
+
+SplashGlyphCache::SplashGlyphCache() {
+  int i;
+
+  for (i = 0; i < splashGlyphCacheHashSize; ++i) {
+    tab[i] = NULL;
+  }
+  first = last = NULL;
+  size = 0;
+  maxSize = splashGlyphCacheSize;
+#if MULTITHREADED
+  gInitMutex(&mutex);
+#endif
+}
+
+SplashGlyphCache::~SplashGlyphCache() {
+  evict(0);
+#if MULTITHREADED
+  gDestroyMutex(&mutex);
+#endif
+}
+
+Guint SplashGlyphCache::hash(unsigned long long fontKey, SplashCoord *mat,
+			     int c, int xFrac, int yFrac) {
+  unsigned long long h;
+  const Guchar *p;
+  int i;
+
+  h = fontKey;
+  p = (const Guchar *)mat;
+  for (i = 0; i < 4 * (int)sizeof(SplashCoord); ++i) {
+    h = (h ^ p[i]) * 1099511628211ULL;
+  }
+  h = (h ^ (Guint)c) * 1099511628211ULL;
+  h = (h ^ (Guint)((xFrac << 8) | yFrac)) * 1099511628211ULL;
+  return (Guint)(h ^ (h >> 32)) % splashGlyphCacheHashSize;
+}
+
+SplashGlyphCacheEntry *SplashGlyphCache::find(Guint h,
+					      unsigned long long fontKey,
+					      SplashCoord *mat, GBool aa,
+					      int c, int xFrac, int yFrac) {
+  SplashGlyphCacheEntry *e;
+
+  for (e = tab[h]; e; e = e->hashNext) {
+    if (e->fontKey == fontKey && e->c == c &&
+	(int)e->xFrac == xFrac && (int)e->yFrac == yFrac &&
+	e->aa == aa &&
+	e->mat[0] == mat[0] && e->mat[1] == mat[1] &&
+	e->mat[2] == mat[2] && e->mat[3] == mat[3]) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+void SplashGlyphCache::unlink(SplashGlyphCacheEntry *e) {
+  if (e->prev) {
+    e->prev->next = e->next;
+  } else {
+    first = e->next;
+  }
+  if (e->next) {
+    e->next->prev = e->prev;
+  } else {
+    last = e->prev;
+  }
+}
+
+void SplashGlyphCache::evict(int limit) {
+  SplashGlyphCacheEntry *e, **p;
+  Guint h;
+
+  while (last && size > limit) {
+    e = last;
+    unlink(e);
+    h = hash(e->fontKey, e->mat, e->c, e->xFrac, e->yFrac);
+    for (p = &tab[h]; *p != e; p = &(*p)->hashNext) ;
+    *p = e->hashNext;
+    size -= e->size;
+    gfree(e->data);
+    delete e;
+  }
+}
+
+GBool SplashGlyphCache::lookup(unsigned long long fontKey, SplashCoord *mat,
+			       GBool aa, int c, int xFrac, int yFrac,
+			       SplashGlyphBitmap *bitmap) {
+  SplashGlyphCacheEntry *e;
+  GBool hit;
+
+  hit = gFalse;
+#if MULTITHREADED
+  gLockMutex(&mutex);
+#endif
+  if ((e = find(hash(fontKey, mat, c, xFrac, yFrac),
+		fontKey, mat, aa, c, xFrac, yFrac))) {
+    if (e != first) {
+      unlink(e);
+      e->prev = NULL;
+      e->next = first;
+      first->prev = e;
+      first = e;
+    }
+    bitmap->x = e->x;
+    bitmap->y = e->y;
+    bitmap->w = e->w;
+    bitmap->h = e->h;
+    bitmap->aa = aa;
+    bitmap->data = (Guchar *)gmalloc(e->size);
+    memcpy(bitmap->data, e->data, e->size);
+    bitmap->freeData = gTrue;
+    hit = gTrue;
+  }
+#if MULTITHREADED
+  gUnlockMutex(&mutex);
+#endif
+  return hit;
+}
+
+void SplashGlyphCache::insert(unsigned long long fontKey, SplashCoord *mat,
+			      GBool aa, int c, int xFrac, int yFrac,
+			      SplashGlyphBitmap *bitmap) {
+  SplashGlyphCacheEntry *e;
+  int dataSize;
+  Guint h;
+
+  if (aa) {
+    dataSize = bitmap->w * bitmap->h;
+  } else {
+    dataSize = ((bitmap->w + 7) >> 3) * bitmap->h;
+  }
+#if MULTITHREADED
+  gLockMutex(&mutex);
+#endif
+  // don't let a few huge glyphs flush everything else
+  if (dataSize > 0 && dataSize <= maxSize / 64) {
+    h = hash(fontKey, mat, c, xFrac, yFrac);
+    // another thread may have rasterized the same glyph meanwhile
+    if (!find(h, fontKey, mat, aa, c, xFrac, yFrac)) {
+      evict(maxSize - dataSize);
+      e = new SplashGlyphCacheEntry;
+      e->fontKey = fontKey;
+      e->mat[0] = mat[0];
+      e->mat[1] = mat[1];
+      e->mat[2] = mat[2];
+      e->mat[3] = mat[3];
+      e->aa = aa;
+      e->c = c;
+      e->xFrac = (short)xFrac;
+      e->yFrac = (short)yFrac;
+      e->x = bitmap->x;
+      e->y = bitmap->y;
+      e->w = bitmap->w;
+      e->h = bitmap->h;
+      e->size = dataSize;
+      e->data = (Guchar *)gmalloc(dataSize);
+      memcpy(e->data, bitmap->data, dataSize);
+      e->hashNext = tab[h];
+      tab[h] = e;
+      e->prev = NULL;
+      e->next = first;
+      if (first) {
+	first->prev = e;
+      } else {
+	last = e;
+      }
+      first = e;
+      size += dataSize;
+    }
+  }
+#if MULTITHREADED
+  gUnlockMutex(&mutex);
+#endif
+}
+
+void SplashGlyphCache::setMaxSize(int maxSizeA) {
+#if MULTITHREADED
+  gLockMutex(&mutex);
+#endif
+  maxSize = maxSizeA < 0 ? 0 : maxSizeA;
+  evict(maxSize);
+#if MULTITHREADED
+  gUnlockMutex(&mutex);
+#endif
+}
+
+static SplashGlyphCache glyphCache;
+
 //------------------------------------------------------------------------
 // SplashFont
 //------------------------------------------------------------------------
@@ -82,20 +337,15 @@ void SplashFont::initCache() {
     }
   }
 
-  // set up the glyph pixmap cache
+  // set up the glyph pixmap cache, with as many sets (up to 32) as
+  // fit in splashFontBitmapCacheSize bytes
   cacheAssoc = 8;
-  if (glyphSize <= 64) {
-    cacheSets = 32;
-  } else if (glyphSize <= 128) {
-    cacheSets = 16;
-  } else if (glyphSize <= 256) {
-    cacheSets = 8;
-  } else if (glyphSize <= 512) {
-    cacheSets = 4;
-  } else if (glyphSize <= 1024) {
-    cacheSets = 2;
-  } else {
-    cacheSets = 1;
+  cacheSets = 1;
+  if (glyphSize > 0) {
+    while (cacheSets < 32 &&
+	   glyphSize <= splashFontBitmapCacheSize / (2 * cacheSets * cacheAssoc)) {
+      cacheSets <<= 1;
+    }
   }
   cache = (Guchar *)gmallocn_checkoverflow(cacheSets* cacheAssoc, glyphSize);
   if (cache != NULL) {
@@ -109,6 +359,10 @@ void SplashFont::initCache() {
   }
 }
 
+void SplashFont::setGlyphCacheSize(int size) {
+  glyphCache.setMaxSize(size);
+}
+
 SplashFont::~SplashFont() {
   fontFile->decRefCnt();
   if (cache) {
@@ -122,6 +376,7 @@ SplashFont::~SplashFont() {
 GBool SplashFont::getGlyph(int c, int xFrac, int yFrac,
 			   SplashGlyphBitmap *bitmap, int x0, int y0, SplashClip *clip, SplashClipResult *clipRes) {
   SplashGlyphBitmap bitmap2;
+  unsigned long long fontKey;
   int size;
   Guchar *p;
   int i, j, k;
@@ -164,9 +419,21 @@ GBool SplashFont::getGlyph(int c, int xFrac, int yFrac,
     }
   }
 
-  // generate the glyph bitmap
-  if (!makeGlyph(c, xFrac, yFrac, &bitmap2, x0, y0, clip, clipRes)) {
-    return gFalse;
+  // check the shared cache, else generate the glyph bitmap
+  fontKey = fontFile->getGlyphKey();
+  if (fontKey &&
+      glyphCache.lookup(fontKey, mat, aa, c, xFrac, yFrac, &bitmap2)) {
+    *clipRes = clip->testRect(x0 - bitmap2.x,
+			      y0 - bitmap2.y,
+			      x0 - bitmap2.x + bitmap2.w - 1,
+			      y0 - bitmap2.y + bitmap2.h - 1);
+  } else {
+    if (!makeGlyph(c, xFrac, yFrac, &bitmap2, x0, y0, clip, clipRes)) {
+      return gFalse;
+    }
+    if (fontKey && *clipRes != splashClipAllOutside) {
+      glyphCache.insert(fontKey, mat, aa, c, xFrac, yFrac, &bitmap2);
+    }
   }
 
   if (*clipRes == splashClipAllOutside)
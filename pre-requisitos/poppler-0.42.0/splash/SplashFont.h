@@ -43,6 +43,13 @@ class SplashPath;
 #define splashFontFractionMul \
                        ((SplashCoord)1 / (SplashCoord)splashFontFraction)
 
+// Size, in bytes, of the glyph bitmap cache of each SplashFont.
+#define splashFontBitmapCacheSize (256 * 1024)
+
+// Default limit, in bytes, on the glyph bitmap cache shared by all
+// SplashFonts in the process.
+#define splashGlyphCacheSize (16 * 1024 * 1024)
+
 //------------------------------------------------------------------------
 // SplashFont
 //------------------------------------------------------------------------
@@ -59,6 +66,11 @@ public:
 
   virtual ~SplashFont();
 
+  // Set the limit, in bytes, on the glyph bitmap cache shared by all
+  // fonts (across font engines, threads, and documents).  Zero
+  // disables it.
+  static void setGlyphCacheSize(int size);
+
   SplashFontFile *getFontFile() { return fontFile; }
 
   // Return true if <this> matches the specified font file and matrix.
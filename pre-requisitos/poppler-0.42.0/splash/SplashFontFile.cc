@@ -49,9 +49,37 @@ SplashFontFile::SplashFontFile(SplashFontFileID *idA, SplashFontSrc *srcA) {
   src = srcA;
   src->ref();
   refCnt = 0;
+  glyphKey = 0;
   doAdjustMatrix = gFalse;
 }
 
+unsigned long long SplashFontFile::hashGlyphKey(unsigned long long h,
+						const void *data, int len) {
+  const Guchar *p;
+  int i;
+
+  p = (const Guchar *)data;
+  for (i = 0; i < len; ++i) {
+    h = (h ^ p[i]) * 1099511628211ULL;
+  }
+  return h;
+}
+
+unsigned long long SplashFontFile::hashSrc() {
+  unsigned long long h;
+
+  h = 14695981039346656037ULL;
+  if (src->isFile) {
+    h = hashGlyphKey(h, "file", 4);
+    h = hashGlyphKey(h, src->fileName->getCString(),
+		     src->fileName->getLength());
+  } else {
+    h = hashGlyphKey(h, "buf", 3);
+    h = hashGlyphKey(h, src->buf, src->bufLen);
+  }
+  return h;
+}
+
 SplashFontFile::~SplashFontFile() {
   src->unref();
   delete id;
@@ -72,6 +72,12 @@ public:
   // Get the font file ID.
   SplashFontFileID *getID() { return id; }
 
+  // Get the key under which this font file's glyph bitmaps are shared
+  // with other font files (possibly from other documents) built from
+  // the same font data and rasterized the same way.  Zero means the
+  // glyphs are not shared.
+  unsigned long long getGlyphKey() { return glyphKey; }
+
   // Increment the reference count.
   void incRefCnt();
 
@@ -85,9 +91,17 @@ protected:
 
   SplashFontFile(SplashFontFileID *idA, SplashFontSrc *srcA);
 
+  // Fold <len> bytes of <data> into the glyph key <h> (FNV-1a).
+  static unsigned long long hashGlyphKey(unsigned long long h,
+					 const void *data, int len);
+
+  // Hash the font data from <src>, i.e., the file name or the buffer.
+  unsigned long long hashSrc();
+
   SplashFontFileID *id;
   SplashFontSrc *src;
   int refCnt;
+  unsigned long long glyphKey;
 
   friend class SplashFontEngine;
 };
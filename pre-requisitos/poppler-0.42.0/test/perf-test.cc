@@ -5,6 +5,15 @@
   A tool to stress-test poppler rendering and measure rendering times for
   very simplistic performance measuring.
 
+  With -bench, every file goes through all the stages we care about -
+  parsing, walking the page tree, rendering each page with Splash at
+  -dpi, decoding its images and extracting its text - and the times
+  (and the memory high-water mark) are written per file and per page
+  to a -csv and/or -json file, e.g.:
+    perf-test -bench -dpi 300 -recursive -csv run.csv corpus-dir
+  The CSV has a "page" row per page and then a "file" row per file, with
+  the totals; in a "file" row the page column holds the page count.
+
   TODO:
    * make it work with cairo output as well
    * print more info about document like e.g. enumarate images,
@@ -47,6 +56,13 @@
 #include <dirent.h>
 #endif
 
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
 #include "Error.h"
 #include "ErrorCodes.h"
 #include "goo/GooString.h"
@@ -57,6 +73,8 @@
 #include "Object.h" /* must be included before SplashOutputDev.h because of sloppiness in SplashOutputDev.h */
 #include "SplashOutputDev.h"
 #include "TextOutputDev.h"
+#include "GfxState.h"
+#include "Stream.h"
 #include "PDFDoc.h"
 #include "Link.h"
 
@@ -91,6 +109,8 @@ public:
 
     int pageCount(void) const { return _pageCount; }
 
+    PDFDoc *pdfDoc(void) const { return _pdfDoc; }
+
     bool load(const char *fileName);
     SplashBitmap *renderBitmap(int pageNo, double zoomReal, int rotation);
 
@@ -126,6 +146,10 @@ static StrList *gArgsListRoot = NULL;
 #define LOAD_ONLY_ARG       "-loadonly"
 #define PAGE_ARG            "-page"
 #define TEXT_ARG            "-text"
+#define BENCH_ARG           "-bench"
+#define DPI_ARG             "-dpi"
+#define CSV_ARG             "-csv"
+#define JSON_ARG            "-json"
 
 /* Should we record timings? True if -timings command-line argument was given. */
 static bool gfTimings = false;
@@ -176,6 +200,23 @@ static int  gPageNo = PAGE_NO_NOT_GIVEN;
    profiling load time */
 static bool gfLoadOnly = false;
 
+/* If true, run every stage (load, page tree walk, render, image
+   decoding, text extraction) on each file and record the times.
+   Controlled by -bench command-line argument. */
+static bool gfBenchmark = false;
+
+/* Resolution at which -bench renders the pages.
+   Controlled by -dpi command-line argument. */
+static int  gDpi = 72;
+
+/* Files to which -bench writes its records, as CSV and as JSON.
+   Controlled by -csv and -json command-line arguments. */
+static char *   gCsvFileName = NULL;
+static char *   gJsonFileName = NULL;
+static FILE *   gCsvFile = NULL;
+static FILE *   gJsonFile = NULL;
+static int      gJsonRecords = 0;
+
 #define PDF_FILE_DPI 72
 
 #define MAX_FILENAME_SIZE 1024
@@ -196,6 +237,12 @@ static bool gfLoadOnly = false;
   #define DIR_SEP_STR  "/"
 #endif
 
+/* GooTimer counts seconds */
+static double ElapsedMs(GooTimer *timer)
+{
+    return timer->getElapsed() * 1000.0;
+}
+
 void memzero(void *data, size_t len)
 {
     memset(data, 0, len);
@@ -557,7 +604,6 @@ char *makepath(char *buf, int buf_size, const char *path,
     return buf;
 }
 
-#ifdef _WIN32
 static int skip_matching_file(const char *filename)
 {
     if (0 == strcmp(".", filename))
@@ -566,7 +612,6 @@ static int skip_matching_file(const char *filename)
         return 1;
     return 0;
 }
-#endif
 
 int find_file_next(FindFileState *s, char *filename, int filename_size_max)
 {
@@ -625,6 +670,8 @@ CheckFile:
             if (!s->dir)
                 goto redo;
         } else {
+            if (skip_matching_file(dirent->d_name))
+                continue;
             if (fnmatch(s->pattern, dirent->d_name, 0) == 0) {
                 makepath(filename, filename_size_max,
                          s->dirpath, dirent->d_name);
@@ -815,6 +862,7 @@ void LogInfo(const char *fmt, ...)
 static void PrintUsageAndExit(int argc, char **argv)
 {
     printf("Usage: pdftest [-preview|-slowpreview] [-loadonly] [-timings] [-text] [-resolution NxM] [-recursive] [-page N] [-out out.txt] pdf-files-to-process\n");
+    printf("       pdftest -bench [-dpi N] [-loadonly] [-recursive] [-page N] [-csv out.csv] [-json out.json] pdf-files-to-process\n");
     for (int i=0; i < argc; i++) {
         printf("i=%d, '%s'\n", i, argv[i]);
     }
@@ -861,7 +909,7 @@ static void RenderPdfAsText(const char *fileName)
     }
 
     msTimer.stop();
-    timeInMs = msTimer.getElapsed();
+    timeInMs = ElapsedMs(&msTimer);
     LogInfo("load: %.2f ms\n", timeInMs);
 
     pageCount = pdfDoc->getNumPages();
@@ -879,7 +927,7 @@ static void RenderPdfAsText(const char *fileName)
         pdfDoc->displayPage(textOut, curPage, 72, 72, rotate, useMediaBox, crop, doLinks);
         txt = textOut->getText(0.0, 0.0, 10000.0, 10000.0);
         msTimer.stop();
-        timeInMs = msTimer.getElapsed();
+        timeInMs = ElapsedMs(&msTimer);
         if (gfTimings)
             LogInfo("page %d: %.2f ms\n", curPage, timeInMs);
         printf("%s\n", txt->getCString());
@@ -923,7 +971,7 @@ static void RenderPdf(const char *fileName)
         goto Error;
     }
     msTimer.stop();
-    timeInMs = msTimer.getElapsed();
+    timeInMs = ElapsedMs(&msTimer);
     LogInfo("load splash: %.2f ms\n", timeInMs);
     pageCount = engineSplash->pageCount();
 
@@ -940,7 +988,7 @@ static void RenderPdf(const char *fileName)
         GooTimer msTimer;
         bmpSplash = engineSplash->renderBitmap(curPage, 100.0, 0);
         msTimer.stop();
-        double timeInMs = msTimer.getElapsed();
+        double timeInMs = ElapsedMs(&msTimer);
         if (gfTimings) {
             if (!bmpSplash)
                 LogInfo("page splash %d: failed to render\n", curPage);
@@ -960,8 +1008,289 @@ Error:
     LogInfo("finished: %s\n", fileName);
 }
 
+/* An output device that only decodes the images drawn on a page, the
+   way image extraction does, counting them. */
+class ImageDecodeOutputDev: public OutputDev {
+public:
+    ImageDecodeOutputDev() : _count(0) { }
+
+    int count(void) const { return _count; }
+    void resetCount(void) { _count = 0; }
+
+    virtual GBool upsideDown() { return gTrue; }
+    virtual GBool useDrawChar() { return gFalse; }
+    virtual GBool interpretType3Chars() { return gFalse; }
+    virtual GBool needNonText() { return gTrue; }
+
+    virtual void drawImageMask(GfxState *state, Object *ref, Stream *str,
+                               int width, int height, GBool invert,
+                               GBool interpolate, GBool inlineImg) {
+        decodeMask(str, width, height);
+    }
+    virtual void drawImage(GfxState *state, Object *ref, Stream *str,
+                           int width, int height, GfxImageColorMap *colorMap,
+                           GBool interpolate, int *maskColors, GBool inlineImg) {
+        decodeImage(str, width, height, colorMap);
+    }
+    virtual void drawMaskedImage(GfxState *state, Object *ref, Stream *str,
+                                 int width, int height,
+                                 GfxImageColorMap *colorMap, GBool interpolate,
+                                 Stream *maskStr, int maskWidth, int maskHeight,
+                                 GBool maskInvert, GBool maskInterpolate) {
+        decodeImage(str, width, height, colorMap);
+        decodeMask(maskStr, maskWidth, maskHeight);
+    }
+    virtual void drawSoftMaskedImage(GfxState *state, Object *ref, Stream *str,
+                                     int width, int height,
+                                     GfxImageColorMap *colorMap,
+                                     GBool interpolate,
+                                     Stream *maskStr,
+                                     int maskWidth, int maskHeight,
+                                     GfxImageColorMap *maskColorMap,
+                                     GBool maskInterpolate) {
+        decodeImage(str, width, height, colorMap);
+        decodeImage(maskStr, maskWidth, maskHeight, maskColorMap);
+    }
+
+private:
+    void decodeMask(Stream *str, int width, int height) {
+        Guchar  buf[4096];
+        int     left = ((width + 7) / 8) * height;
+        int     n;
+
+        str->reset();
+        while (left > 0 && (n = str->doGetChars(left < (int)sizeof(buf) ? left : (int)sizeof(buf), buf)) > 0)
+            left -= n;
+        str->close();
+        ++_count;
+    }
+
+    void decodeImage(Stream *str, int width, int height, GfxImageColorMap *colorMap) {
+        if (!colorMap || !colorMap->isOk()) {
+            decodeMask(str, width, height);
+            return;
+        }
+        ImageStream *imgStr = new ImageStream(str, width, colorMap->getNumPixelComps(), colorMap->getBits());
+        imgStr->reset();
+        for (int y = 0; y < height; y++) {
+            if (!imgStr->getLine())
+                break;
+        }
+        imgStr->close();
+        delete imgStr;
+        ++_count;
+    }
+
+    int _count;
+};
+
+/* Times of one page, in milliseconds */
+struct BenchPage {
+    int     pageNo;
+    int     width, height;  /* size of the rendered bitmap */
+    double  renderMs;
+    int     images;
+    double  imagesMs;
+    int     textChars;
+    double  textMs;
+};
+
+/* Memory high-water mark of the process so far, in kilobytes, or -1
+   if not known */
+static long MaxRssKb(void)
+{
+#ifdef _WIN32
+    return -1;
+#else
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage))
+        return -1;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+static void JsonPrintString(FILE *f, const char *str)
+{
+    fputc('"', f);
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++) {
+        if ('"' == *p || '\\' == *p)
+            fprintf(f, "\\%c", *p);
+        else if (*p < 0x20)
+            fprintf(f, "\\u%04x", *p);
+        else
+            fputc(*p, f);
+    }
+    fputc('"', f);
+}
+
+static void CsvPrintString(FILE *f, const char *str)
+{
+    fputc('"', f);
+    for (const char *p = str; *p; p++) {
+        if ('"' == *p)
+            fputc('"', f);
+        fputc(*p, f);
+    }
+    fputc('"', f);
+}
+
+static void WriteBenchRecords(const char *fileName, bool ok, int pageCount,
+                              double loadMs, double treeMs,
+                              BenchPage *pages, int pagesCount, long maxRssKb)
+{
+    double  renderMs = 0, imagesMs = 0, textMs = 0;
+    int     images = 0, textChars = 0;
+    int     i;
+
+    for (i = 0; i < pagesCount; i++) {
+        renderMs += pages[i].renderMs;
+        images += pages[i].images;
+        imagesMs += pages[i].imagesMs;
+        textChars += pages[i].textChars;
+        textMs += pages[i].textMs;
+    }
+
+    if (gCsvFile) {
+        for (i = 0; i < pagesCount; i++) {
+            fprintf(gCsvFile, "page,");
+            CsvPrintString(gCsvFile, fileName);
+            fprintf(gCsvFile, ",1,%d,%d,%d,,,%.2f,%d,%.2f,%d,%.2f,\n",
+                    pages[i].pageNo, pages[i].width, pages[i].height,
+                    pages[i].renderMs, pages[i].images, pages[i].imagesMs,
+                    pages[i].textChars, pages[i].textMs);
+        }
+        fprintf(gCsvFile, "file,");
+        CsvPrintString(gCsvFile, fileName);
+        fprintf(gCsvFile, ",%d,%d,,,%.2f,%.2f,%.2f,%d,%.2f,%d,%.2f,%ld\n",
+                ok ? 1 : 0, pageCount, loadMs, treeMs,
+                renderMs, images, imagesMs, textChars, textMs, maxRssKb);
+        fflush(gCsvFile);
+    }
+
+    if (gJsonFile) {
+        fprintf(gJsonFile, "%s\n{\"file\": ", gJsonRecords ? "," : "");
+        JsonPrintString(gJsonFile, fileName);
+        fprintf(gJsonFile, ", \"ok\": %s, \"page_count\": %d, "
+                "\"load_ms\": %.2f, \"tree_ms\": %.2f, \"render_ms\": %.2f, "
+                "\"images\": %d, \"images_ms\": %.2f, \"text_chars\": %d, "
+                "\"text_ms\": %.2f, \"maxrss_kb\": %ld, \"pages\": [",
+                ok ? "true" : "false", pageCount, loadMs, treeMs, renderMs,
+                images, imagesMs, textChars, textMs, maxRssKb);
+        for (i = 0; i < pagesCount; i++) {
+            fprintf(gJsonFile, "%s\n  {\"page\": %d, \"width\": %d, \"height\": %d, "
+                    "\"render_ms\": %.2f, \"images\": %d, \"images_ms\": %.2f, "
+                    "\"text_chars\": %d, \"text_ms\": %.2f}",
+                    i ? "," : "", pages[i].pageNo, pages[i].width, pages[i].height,
+                    pages[i].renderMs, pages[i].images, pages[i].imagesMs,
+                    pages[i].textChars, pages[i].textMs);
+        }
+        fprintf(gJsonFile, "]}");
+        fflush(gJsonFile);
+        ++gJsonRecords;
+    }
+}
+
+static void BenchmarkPdf(const char *fileName)
+{
+    PdfEnginePoppler *      engine = NULL;
+    PDFDoc *                pdfDoc;
+    ImageDecodeOutputDev *  imageOut = NULL;
+    TextOutputDev *         textOut = NULL;
+    BenchPage *             pages = NULL;
+    int                     pagesCount = 0;
+    int                     pageCount = 0;
+    double                  loadMs = 0, treeMs = 0;
+    bool                    ok = false;
+
+    LogInfo("started: %s\n", fileName);
+
+    engine = new PdfEnginePoppler();
+    GooTimer msTimer;
+    if (!engine->load(fileName)) {
+        LogInfo("failed to load\n");
+        goto Exit;
+    }
+    msTimer.stop();
+    loadMs = ElapsedMs(&msTimer);
+    pdfDoc = engine->pdfDoc();
+    pageCount = engine->pageCount();
+    ok = true;
+
+    /* look up every page, as the tools listing pages do */
+    msTimer.start();
+    for (int curPage = 1; curPage <= pageCount; curPage++) {
+        pdfDoc->getPage(curPage);
+        pdfDoc->releasePage(curPage);
+    }
+    msTimer.stop();
+    treeMs = ElapsedMs(&msTimer);
+    LogInfo("load: %.2f ms, page tree: %.2f ms, page count: %d\n", loadMs, treeMs, pageCount);
+    if (gfLoadOnly)
+        goto Exit;
+
+    imageOut = new ImageDecodeOutputDev();
+    textOut = new TextOutputDev(NULL, gTrue, 0, gFalse, gFalse);
+    pages = (BenchPage *)zmalloc(sizeof(BenchPage) * (pageCount > 0 ? pageCount : 1));
+    for (int curPage = 1; curPage <= pageCount; curPage++) {
+        if ((gPageNo != PAGE_NO_NOT_GIVEN) && (gPageNo != curPage))
+            continue;
+
+        BenchPage *page = &pages[pagesCount++];
+        page->pageNo = curPage;
+
+        msTimer.start();
+        SplashBitmap *bmpSplash = engine->renderBitmap(curPage, gDpi * 100.0 / PDF_FILE_DPI, 0);
+        msTimer.stop();
+        page->renderMs = ElapsedMs(&msTimer);
+        if (bmpSplash) {
+            page->width = bmpSplash->getWidth();
+            page->height = bmpSplash->getHeight();
+        }
+        delete bmpSplash;
+
+        msTimer.start();
+        imageOut->resetCount();
+        pdfDoc->displayPage(imageOut, curPage, PDF_FILE_DPI, PDF_FILE_DPI, 0, gTrue, gFalse, gFalse);
+        msTimer.stop();
+        page->imagesMs = ElapsedMs(&msTimer);
+        page->images = imageOut->count();
+
+        msTimer.start();
+        pdfDoc->displayPage(textOut, curPage, PDF_FILE_DPI, PDF_FILE_DPI, 0, gFalse, gTrue, gFalse);
+        GooString *txt = textOut->getText(0.0, 0.0, 10000.0, 10000.0);
+        msTimer.stop();
+        page->textMs = ElapsedMs(&msTimer);
+        page->textChars = txt->getLength();
+        delete txt;
+
+        pdfDoc->releasePage(curPage);
+
+        if (gfTimings)
+            LogInfo("page %d (%dx%d): render %.2f ms, %d images %.2f ms, text %.2f ms\n",
+                    curPage, page->width, page->height, page->renderMs,
+                    page->images, page->imagesMs, page->textMs);
+    }
+
+Exit:
+    WriteBenchRecords(fileName, ok, pageCount, loadMs, treeMs, pages, pagesCount, MaxRssKb());
+    free(pages);
+    delete textOut;
+    delete imageOut;
+    delete engine;
+    LogInfo("finished: %s\n", fileName);
+}
+
 static void RenderFile(const char *fileName)
 {
+    if (gfBenchmark) {
+        BenchmarkPdf(fileName);
+        return;
+    }
+
     if (gfTextOnly) {
         RenderPdfAsText(fileName);
         return;
@@ -1063,6 +1392,28 @@ static void ParseCommandLine(int argc, char **argv)
                 gfTextOnly = true;
             } else if (str_ieq(arg, SLOW_PREVIEW_ARG)) {
                 gfSlowPreview = true;
+            } else if (str_ieq(arg, BENCH_ARG)) {
+                gfBenchmark = true;
+            } else if (str_ieq(arg, DPI_ARG)) {
+                /* expect an integer after that */
+                ++i;
+                if (i == argc)
+                    PrintUsageAndExit(argc, argv);
+                gDpi = atoi(argv[i]);
+                if (gDpi < 1)
+                    PrintUsageAndExit(argc, argv);
+            } else if (str_ieq(arg, CSV_ARG)) {
+                /* expect a file name after that */
+                ++i;
+                if (i == argc)
+                    PrintUsageAndExit(argc, argv);
+                gCsvFileName = str_dup(argv[i]);
+            } else if (str_ieq(arg, JSON_ARG)) {
+                /* expect a file name after that */
+                ++i;
+                if (i == argc)
+                    PrintUsageAndExit(argc, argv);
+                gJsonFileName = str_dup(argv[i]);
             } else if (str_ieq(arg, LOAD_ONLY_ARG)) {
                 gfLoadOnly = true;
             } else if (str_ieq(arg, PAGE_ARG)) {
@@ -1160,20 +1511,27 @@ bool IsFileName(char *path)
 #else
 bool IsDirectoryName(char *path)
 {
-    /* TODO: implement me */
-    return false;
+    struct stat     buf;
+
+    if (0 != stat(path, &buf))
+        return false;
+    return S_ISDIR(buf.st_mode);
 }
 
 bool IsFileName(char *path)
 {
-    /* TODO: implement me */
-    return true;
+    struct stat     buf;
+
+    if (0 != stat(path, &buf))
+        return false;
+    return S_ISREG(buf.st_mode);
 }
 #endif
 
 bool IsPdfFileName(char *path)
 {
-    if (str_endswith(path, ".pdf"))
+    size_t len = strlen(path);
+    if (len >= 4 && str_ieq(path + len - 4, ".pdf"))
         return true;
     return false;
 }
@@ -1262,6 +1620,23 @@ int main(int argc, char **argv)
     else
         gErrFile = stderr;
 
+    if (gCsvFileName) {
+        gCsvFile = fopen(gCsvFileName, "w");
+        if (!gCsvFile) {
+            printf("failed to open -csv file %s\n", gCsvFileName);
+            return 1;
+        }
+        fprintf(gCsvFile, "kind,file,ok,page,width,height,load_ms,tree_ms,render_ms,images,images_ms,text_chars,text_ms,maxrss_kb\n");
+    }
+    if (gJsonFileName) {
+        gJsonFile = fopen(gJsonFileName, "w");
+        if (!gJsonFile) {
+            printf("failed to open -json file %s\n", gJsonFileName);
+            return 1;
+        }
+        fprintf(gJsonFile, "[");
+    }
+
     PreviewBitmapInit();
 
     StrList * curr = gArgsListRoot;
@@ -1271,6 +1646,14 @@ int main(int argc, char **argv)
     }
     if (outFile)
         fclose(outFile);
+    if (gCsvFile)
+        fclose(gCsvFile);
+    if (gJsonFile) {
+        fprintf(gJsonFile, "\n]\n");
+        fclose(gJsonFile);
+    }
+    free(gCsvFileName);
+    free(gJsonFileName);
     PreviewBitmapDestroy();
     StrList_Destroy(&gArgsListRoot);
     delete globalParams;
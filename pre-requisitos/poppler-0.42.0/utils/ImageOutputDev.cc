@@ -39,9 +39,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #include <ctype.h>
 #include <math.h>
 #include "goo/gmem.h"
+#include "goo/GooHash.h"
+#include "goo/GooList.h"
+#include "goo/GooString.h"
 #include "goo/NetPBMWriter.h"
 #include "goo/PNGWriter.h"
 #include "goo/TiffWriter.h"
@@ -50,6 +54,7 @@
 #include "Object.h"
 #include "Stream.h"
 #include "JBIG2Stream.h"
+#include "Trace.h"
 #include "ImageOutputDev.h"
 
 ImageOutputDev::ImageOutputDev(char *fileRootA, GBool pageNamesA, GBool listImagesA) {
@@ -65,8 +70,14 @@ ImageOutputDev::ImageOutputDev(char *fileRootA, GBool pageNamesA, GBool listImag
   dumpJBIG2 = gFalse;
   dumpCCITT = gFalse;
   pageNames = pageNamesA;
+  nameTemplate = NULL;
+  written = NULL;
+  jsonFile = NULL;
+  jsonEmpty = gTrue;
+  images = NULL;
   imgNum = 0;
   pageNum = 0;
+  pageImgNum = 0;
   ok = gTrue;
   if (listImages) {
     printf("page   num  type   width height color comp bpc  enc interp  object ID x-ppi y-ppi size ratio\n");
@@ -80,10 +91,85 @@ ImageOutputDev::~ImageOutputDev() {
     gfree(fileName);
     gfree(fileRoot);
   }
+  gfree(nameTemplate);
+  if (written) {
+    deleteGooHash(written, GooString);
+  }
+  if (jsonFile) {
+    fprintf(jsonFile, jsonEmpty ? "]\n" : "\n]\n");
+    if (jsonFile != stdout) {
+      fclose(jsonFile);
+    } else {
+      fflush(stdout);
+    }
+  }
+}
+
+void ImageOutputDev::setNameTemplate(const char *nameTemplateA) {
+  gfree(nameTemplate);
+  nameTemplate = copyString(nameTemplateA);
+  if (!listImages) {
+    // each template char expands to at most 11 chars (an int)
+    fileName = (char *)grealloc(fileName, strlen(fileRoot) +
+				12 * strlen(nameTemplate) + 45);
+  }
+}
+
+void ImageOutputDev::enableDedup(GBool dedupA) {
+  if (dedupA && !written) {
+    written = new GooHash(gTrue);
+  } else if (!dedupA && written) {
+    deleteGooHash(written, GooString);
+    written = NULL;
+  }
+}
+
+GBool ImageOutputDev::openJSON(const char *jsonFileName) {
+  if (!strcmp(jsonFileName, "-")) {
+    jsonFile = stdout;
+  } else if (!(jsonFile = fopen(jsonFileName, "w"))) {
+    error(errIO, -1, "Couldn't open JSON file '{0:s}'", jsonFileName);
+    return gFalse;
+  }
+  fprintf(jsonFile, "[");
+  return gTrue;
 }
 
 void ImageOutputDev::setFilename(const char *fileExt) {
-  if (pageNames) {
+  const char *t;
+  char *p;
+  int width, val;
+
+  if (nameTemplate) {
+    p = fileName + sprintf(fileName, "%s", fileRoot);
+    for (t = nameTemplate; *t; ++t) {
+      if (*t != '%' || !t[1]) {
+	*p++ = *t;
+	continue;
+      }
+      ++t;
+      width = 1;
+      if (*t >= '1' && *t <= '9' && t[1]) {
+	width = *t++ - '0';
+      }
+      switch (*t) {
+      case 'p':
+	val = pageNum;
+	break;
+      case 'n':
+	val = imgNum;
+	break;
+      case 'i':
+	val = imgNum - pageImgNum;
+	break;
+      default:
+	*p++ = *t;
+	continue;
+      }
+      p += sprintf(p, "%0*d", width, val);
+    }
+    sprintf(p, ".%s", fileExt);
+  } else if (pageNames) {
     sprintf(fileName, "%s-%03d-%03d.%s", fileRoot, pageNum, imgNum, fileExt);
   } else {
     sprintf(fileName, "%s-%03d.%s", fileRoot, imgNum, fileExt);
@@ -118,17 +204,36 @@ static void printNumber(double d)
   }
 }
 
+// Write <str> to <f> as a JSON string.
+static void printJSONString(FILE *f, const char *str) {
+  const unsigned char *p;
+
+  fputc('"', f);
+  for (p = (const unsigned char *)str; *p; ++p) {
+    if (*p == '"' || *p == '\\') {
+      fprintf(f, "\\%c", *p);
+    } else if (*p < 0x20) {
+      fprintf(f, "\\u%04x", *p);
+    } else {
+      fputc(*p, f);
+    }
+  }
+  fputc('"', f);
+}
+
 void ImageOutputDev::listImage(GfxState *state, Object *ref, Stream *str,
 			       int width, int height,
 			       GfxImageColorMap *colorMap,
 			       GBool interpolate, GBool inlineImg,
-			       ImageType imageType) {
+			       ImageType imageType, int num,
+			       GooString *file, GBool duplicate) {
   const char *type;
   const char *colorspace;
   const char *enc;
   int components, bpc;
+  Ref imageRef;
+  GBool hasRef;
 
-  printf("%4d %5d ", pageNum, imgNum);
   type = "";
   switch (imageType) {
   case imgImage:
@@ -144,7 +249,6 @@ void ImageOutputDev::listImage(GfxState *state, Object *ref, Stream *str,
     type = "smask";
     break;
   }
-  printf("%-7s %5d %5d  ", type, width, height);
 
   colorspace = "-";
   /* masks and stencils default to ncomps = 1 and bpc = 1 */
@@ -186,7 +290,6 @@ void ImageOutputDev::listImage(GfxState *state, Object *ref, Stream *str,
     components = colorMap->getNumPixelComps();
     bpc = colorMap->getBits();
   }
-  printf("%-5s  %2d  %2d  ", colorspace, components, bpc);
 
   switch (str->getKind()) {
   case strCCITTFax:
@@ -213,21 +316,11 @@ void ImageOutputDev::listImage(GfxState *state, Object *ref, Stream *str,
     enc = "image";
     break;
   }
-  printf("%-5s  ", enc);
-
-  printf("%-3s  ", interpolate ? "yes" : "no");
 
-  if (inlineImg) {
-    printf("[inline]   ");
-  } else if (ref->isRef()) {
-    const Ref imageRef = ref->getRef();
-    if (imageRef.gen >= 100000) {
-      printf("[none]     ");
-    } else {
-      printf(" %6d %2d ", imageRef.num, imageRef.gen);
-    }
-  } else {
-    printf("[none]     ");
+  hasRef = gFalse;
+  if (!inlineImg && ref->isRef()) {
+    imageRef = ref->getRef();
+    hasRef = imageRef.gen < 100000;
   }
 
   double *mat = state->getCTM();
@@ -235,14 +328,6 @@ void ImageOutputDev::listImage(GfxState *state, Object *ref, Stream *str,
   double height2 = mat[1] + mat[3];
   double xppi = fabs(width*72.0/width2) + 0.5;
   double yppi = fabs(height*72.0/height2) + 0.5;
-  if (xppi < 1.0)
-    printf("%5.3f ", xppi);
-  else
-    printf("%5.0f ", xppi);
-  if (yppi < 1.0)
-    printf("%5.3f ", yppi);
-  else
-    printf("%5.0f ", yppi);
 
   Goffset embedSize = -1;
   if (!inlineImg)
@@ -258,6 +343,69 @@ void ImageOutputDev::listImage(GfxState *state, Object *ref, Stream *str,
   if (imageSize > 0)
     ratio = 100.0*embedSize/imageSize;
 
+  if (jsonFile) {
+    fprintf(jsonFile, "%s\n{\"page\": %d, \"num\": %d, \"type\": \"%s\", "
+	    "\"width\": %d, \"height\": %d, \"color\": \"%s\", "
+	    "\"comp\": %d, \"bpc\": %d, \"enc\": \"%s\", \"interp\": %s, ",
+	    jsonEmpty ? "" : ",", pageNum, num, type, width, height,
+	    colorspace, components, bpc, enc, interpolate ? "true" : "false");
+    jsonEmpty = gFalse;
+    if (hasRef) {
+      fprintf(jsonFile, "\"object\": %d, \"gen\": %d, ",
+	      imageRef.num, imageRef.gen);
+    } else {
+      fprintf(jsonFile, "\"object\": null, \"gen\": null, ");
+    }
+    fprintf(jsonFile, xppi < 1.0 ? "\"x-ppi\": %.3f, " : "\"x-ppi\": %.0f, ",
+	    xppi);
+    fprintf(jsonFile, yppi < 1.0 ? "\"y-ppi\": %.3f, " : "\"y-ppi\": %.0f, ",
+	    yppi);
+    if (embedSize < 0) {
+      fprintf(jsonFile, "\"size\": null, ");
+    } else {
+      fprintf(jsonFile, "\"size\": %lld, ", embedSize);
+    }
+    if (ratio < 0.0) {
+      fprintf(jsonFile, "\"ratio\": null, ");
+    } else {
+      fprintf(jsonFile, "\"ratio\": %.1f, ", ratio);
+    }
+    fprintf(jsonFile, "\"file\": ");
+    if (file) {
+      printJSONString(jsonFile, file->getCString());
+    } else {
+      fprintf(jsonFile, "null");
+    }
+    fprintf(jsonFile, ", \"duplicate\": %s}", duplicate ? "true" : "false");
+  }
+
+  if (!listImages) {
+    return;
+  }
+
+  printf("%4d %5d ", pageNum, num);
+  printf("%-7s %5d %5d  ", type, width, height);
+  printf("%-5s  %2d  %2d  ", colorspace, components, bpc);
+  printf("%-5s  ", enc);
+  printf("%-3s  ", interpolate ? "yes" : "no");
+
+  if (inlineImg) {
+    printf("[inline]   ");
+  } else if (hasRef) {
+    printf(" %6d %2d ", imageRef.num, imageRef.gen);
+  } else {
+    printf("[none]     ");
+  }
+
+  if (xppi < 1.0)
+    printf("%5.3f ", xppi);
+  else
+    printf("%5.0f ", xppi);
+  if (yppi < 1.0)
+    printf("%5.3f ", yppi);
+  else
+    printf("%5.0f ", yppi);
+
   if (embedSize < 0) {
     printf("   - ");
   } else if (embedSize <= 9999) {
@@ -286,13 +434,79 @@ void ImageOutputDev::listImage(GfxState *state, Object *ref, Stream *str,
     printf(" %3.1f%%\n", ratio);
   else
     printf("   - \n");
+}
 
-  ++imgNum;
+ExtractedImage::ExtractedImage(int pageNumA, int imgNumA,
+			       int widthA, int heightA) {
+  pageNum = pageNumA;
+  imgNum = imgNumA;
+  width = widthA;
+  height = heightA;
+  ext = NULL;
+  data = new GooString();
+  globals = NULL;
+  decodeParms.initNull();
+  format = ImageOutputDev::imgRGB;
+  rowSize = 0;
+}
+
+ExtractedImage::~ExtractedImage() {
+  delete data;
+  delete globals;
+  decodeParms.free();
+}
+
+// Copy a stream to a file, a buffer at a time.
+static void copyStream(Stream *str, FILE *f) {
+  Guchar buf[4096];
+  int n;
+
+  str->reset();
+  while ((n = str->doGetChars(sizeof(buf), buf)) > 0)
+    fwrite(buf, 1, n, f);
+  str->close();
 }
 
-void ImageOutputDev::writeRawImage(Stream *str, const char *ext) {
+void ImageOutputDev::writeRawImage(Stream *str, int width, int height,
+				   const char *ext, Stream *globalsStr) {
+  ExtractedImage *image;
+  Stream *rawStr;
   FILE *f;
-  int c;
+
+  rawStr = str->getNextStream();
+
+  if (images) {
+    image = new ExtractedImage(pageNum, imgNum, width, height);
+    ++imgNum;
+    image->ext = ext;
+    rawStr->fillGooString(image->data);
+    rawStr->close();
+    if (globalsStr) {
+      image->globals = new GooString();
+      globalsStr->fillGooString(image->globals);
+      globalsStr->close();
+    }
+    if (str->getDict()) {
+      str->getDict()->lookup("DecodeParms", &image->decodeParms);
+      if (image->decodeParms.isNull()) {
+	image->decodeParms.free();
+	str->getDict()->lookup("DP", &image->decodeParms);
+      }
+    }
+    images->append(image);
+    return;
+  }
+
+  // dump the JBIG2 globals stream, under the number of the image
+  if (globalsStr) {
+    setFilename("jb2g");
+    if (!(f = fopen(fileName, "wb"))) {
+      error(errIO, -1, "Couldn't open image file '{0:s}'", fileName);
+      return;
+    }
+    copyStream(globalsStr, f);
+    fclose(f);
+  }
 
   // open the image file
   setFilename(ext);
@@ -302,21 +516,15 @@ void ImageOutputDev::writeRawImage(Stream *str, const char *ext) {
     return;
   }
 
-  // initialize stream
-  str = str->getNextStream();
-  str->reset();
-
   // copy the stream
-  while ((c = str->getChar()) != EOF)
-    fputc(c, f);
-
-  str->close();
+  copyStream(rawStr, f);
   fclose(f);
 }
 
 void ImageOutputDev::writeImageFile(ImgWriter *writer, ImageFormat format, const char *ext,
                                     Stream *str, int width, int height, GfxImageColorMap *colorMap) {
-  FILE *f;
+  FILE *f = NULL;
+  ExtractedImage *image = NULL;
   ImageStream *imgStr = NULL;
   unsigned char *row;
   unsigned char *rowp;
@@ -326,17 +534,42 @@ void ImageOutputDev::writeImageFile(ImgWriter *writer, ImageFormat format, const
   GfxGray gray;
   Guchar zero = 0;
   int invert_bits;
+  int n, rowSize;
 
-  setFilename(ext);
-  ++imgNum;
-  if (!(f = fopen(fileName, "wb"))) {
-    error(errIO, -1, "Couldn't open image file '{0:s}'", fileName);
-    return;
+  switch (format) {
+  case imgRGB:
+    rowSize = width * 3;
+    break;
+  case imgCMYK:
+    rowSize = width * 4;
+    break;
+  case imgGray:
+    rowSize = width;
+    break;
+  case imgMonochrome:
+  default:
+    rowSize = (width + 7) / 8;
+    break;
   }
 
-  if (!writer->init(f, width, height, 72, 72)) {
-    error(errIO, -1, "Error writing '{0:s}'", fileName);
-    return;
+  if (images) {
+    image = new ExtractedImage(pageNum, imgNum, width, height);
+    ++imgNum;
+    image->format = format;
+    image->rowSize = rowSize;
+    images->append(image);
+  } else {
+    setFilename(ext);
+    ++imgNum;
+    if (!(f = fopen(fileName, "wb"))) {
+      error(errIO, -1, "Couldn't open image file '{0:s}'", fileName);
+      return;
+    }
+
+    if (!writer->init(f, width, height, 72, 72)) {
+      error(errIO, -1, "Error writing '{0:s}'", fileName);
+      return;
+    }
   }
 
   if (format != imgMonochrome) {
@@ -381,7 +614,6 @@ void ImageOutputDev::writeImageFile(ImgWriter *writer, ImageFormat format, const
           *rowp++ = 0;
         }
       }
-      writer->writeRow(&row);
       break;
 
     case imgCMYK:
@@ -402,7 +634,6 @@ void ImageOutputDev::writeImageFile(ImgWriter *writer, ImageFormat format, const
           *rowp++ = 0;
         }
       }
-      writer->writeRow(&row);
       break;
 
     case imgGray:
@@ -417,16 +648,20 @@ void ImageOutputDev::writeImageFile(ImgWriter *writer, ImageFormat format, const
           *rowp++ = 0;
         }
       }
-      writer->writeRow(&row);
       break;
 
     case imgMonochrome:
-      int size = (width + 7)/8;
-      for (int x = 0; x < size; x++)
-        row[x] = str->getChar() ^ invert_bits;
-      writer->writeRow(&row);
+      n = str->doGetChars(rowSize, row);
+      // missing data reads as EOF did, all bits set before inverting
+      memset(row + n, 0xff, rowSize - n);
+      for (int x = 0; x < rowSize; x++)
+        row[x] ^= invert_bits;
       break;
     }
+    if (image)
+      image->data->append((const char *)row, rowSize);
+    else
+      writer->writeRow(&row);
   }
 
   gfree(row);
@@ -435,13 +670,16 @@ void ImageOutputDev::writeImageFile(ImgWriter *writer, ImageFormat format, const
     delete imgStr;
   }
   str->close();
-  writer->close();
-  fclose(f);
+  if (!image) {
+    writer->close();
+    fclose(f);
+  }
 }
 
 void ImageOutputDev::writeImage(GfxState *state, Object *ref, Stream *str,
 				int width, int height,
 				GfxImageColorMap *colorMap, GBool inlineImg) {
+  POPPLER_TRACE_SPAN("ImageOutputDev::writeImage");
   ImageFormat format;
 
   if (dumpJPEG && str->getKind() == strDCT &&
@@ -450,70 +688,71 @@ void ImageOutputDev::writeImage(GfxState *state, Object *ref, Stream *str,
       !inlineImg) {
 
     // dump JPEG file
-    writeRawImage(str, "jpg");
+    writeRawImage(str, width, height, "jpg");
 
   } else if (dumpJP2 && str->getKind() == strJPX && !inlineImg) {
     // dump JPEG2000 file
-    writeRawImage(str, "jp2");
+    writeRawImage(str, width, height, "jp2");
 
   } else if (dumpJBIG2 && str->getKind() == strJBIG2 && !inlineImg) {
-    // dump JBIG2 globals stream if available
+    // dump JBIG2 embedded file, with its globals stream if available
     JBIG2Stream *jb2Str = static_cast<JBIG2Stream *>(str);
     Object *globals = jb2Str->getGlobalsStream();
-    if (globals->isStream()) {
-      FILE *f;
-      int c;
-      Stream *str = globals->getStream();
+    writeRawImage(str, width, height, "jb2e",
+                  globals->isStream() ? globals->getStream() : NULL);
 
-      setFilename("jb2g");
+  } else if (dumpCCITT && str->getKind() == strCCITTFax && !inlineImg) {
+    // write CCITT parameters, collected images have them in DecodeParms
+    CCITTFaxStream *ccittStr = static_cast<CCITTFaxStream *>(str);
+    FILE *f;
+    if (!images) {
+      setFilename("params");
       if (!(f = fopen(fileName, "wb"))) {
         error(errIO, -1, "Couldn't open image file '{0:s}'", fileName);
         return;
       }
-      str->reset();
-      while ((c = str->getChar()) != EOF)
-        fputc(c, f);
-      str->close();
-      fclose(f);
-    }
+      if (ccittStr->getEncoding() < 0)
+        fprintf(f, "-4 ");
+      else if (ccittStr->getEncoding() == 0)
+        fprintf(f, "-1 ");
+      else
+        fprintf(f, "-2 ");
 
-    // dump JBIG2 embedded file
-    writeRawImage(str, "jb2e");
+      if (ccittStr->getEndOfLine())
+        fprintf(f, "-A ");
+      else
+        fprintf(f, "-P ");
 
-  } else if (dumpCCITT && str->getKind() == strCCITTFax && !inlineImg) {
-    // write CCITT parameters
-    CCITTFaxStream *ccittStr = static_cast<CCITTFaxStream *>(str);
-    FILE *f;
-    setFilename("params");
-    if (!(f = fopen(fileName, "wb"))) {
-      error(errIO, -1, "Couldn't open image file '{0:s}'", fileName);
-      return;
-    }
-    if (ccittStr->getEncoding() < 0)
-      fprintf(f, "-4 ");
-    else if (ccittStr->getEncoding() == 0)
-      fprintf(f, "-1 ");
-    else
-      fprintf(f, "-2 ");
+      fprintf(f, "-X %d ", ccittStr->getColumns());
 
-    if (ccittStr->getEndOfLine())
-      fprintf(f, "-A ");
-    else
-      fprintf(f, "-P ");
+      if (ccittStr->getBlackIs1())
+        fprintf(f, "-W ");
+      else
+        fprintf(f, "-B ");
 
-    fprintf(f, "-X %d ", ccittStr->getColumns());
+      fprintf(f, "-M\n"); // PDF uses MSB first
 
-    if (ccittStr->getBlackIs1())
-      fprintf(f, "-W ");
-    else
-      fprintf(f, "-B ");
+      fclose(f);
+    }
 
-    fprintf(f, "-M\n"); // PDF uses MSB first
+    // dump CCITT file
+    writeRawImage(str, width, height, "ccitt");
 
-    fclose(f);
+  } else if (images) {
+    // keep the decoded rows, without converting gray or CMYK to RGB
+    if (!colorMap || (colorMap->getNumPixelComps() == 1 && colorMap->getBits() == 1)) {
+      format = imgMonochrome;
+    } else if (colorMap->getColorSpace()->getMode() == csDeviceGray ||
+               colorMap->getColorSpace()->getMode() == csCalGray) {
+      format = imgGray;
+    } else if (colorMap->getColorSpace()->getMode() == csDeviceCMYK ||
+               (colorMap->getColorSpace()->getMode() == csICCBased && colorMap->getNumPixelComps() == 4)) {
+      format = imgCMYK;
+    } else {
+      format = imgRGB;
+    }
 
-    // dump CCITT file
-    writeRawImage(str, "ccitt");
+    writeImageFile(NULL, format, NULL, str, width, height, colorMap);
 
   } else if (outputPNG && !(outputTiff && colorMap &&
                             (colorMap->getColorSpace()->getMode() == csDeviceCMYK ||
@@ -585,6 +824,60 @@ void ImageOutputDev::writeImage(GfxState *state, Object *ref, Stream *str,
   }
 }
 
+void ImageOutputDev::doImage(GfxState *state, Object *ref, Stream *str,
+			     int width, int height,
+			     GfxImageColorMap *colorMap,
+			     GBool interpolate, GBool inlineImg,
+			     ImageType imageType) {
+  GooString *key, *file;
+  GBool duplicate;
+  int num;
+
+  num = imgNum;
+  if (listImages) {
+    listImage(state, ref, str, width, height, colorMap, interpolate,
+	      inlineImg, imageType, num, NULL, gFalse);
+    ++imgNum;
+    return;
+  }
+
+  // an image object drawn again is not decoded and written again; a
+  // mask is keyed apart from the image it belongs to
+  key = NULL;
+  file = NULL;
+  duplicate = gFalse;
+  if (written && !images && !inlineImg && ref->isRef()) {
+    key = GooString::format("{0:d} {1:d} {2:d}", ref->getRef().num,
+			    ref->getRef().gen, (int)imageType);
+    if ((file = (GooString *)written->lookup(key))) {
+      duplicate = gTrue;
+      delete key;
+      key = NULL;
+      ++imgNum;
+    }
+  }
+  if (!duplicate) {
+    writeImage(state, ref, str, width, height, colorMap, inlineImg);
+    if (!images && imgNum > num) {
+      file = new GooString(fileName);
+    }
+  }
+
+  if (jsonFile) {
+    listImage(state, ref, str, width, height, colorMap, interpolate,
+	      inlineImg, imageType, num, file, duplicate);
+  }
+
+  if (key && file) {
+    written->add(key, file);
+  } else {
+    delete key;
+    if (!duplicate) {
+      delete file;
+    }
+  }
+}
+
 GBool ImageOutputDev::tilingPatternFill(GfxState *state, Gfx *gfx, Catalog *cat, Object *str,
 				  double *pmat, int paintType, int tilingType, Dict *resDict,
 				  double *mat, double *bbox,
@@ -597,33 +890,22 @@ GBool ImageOutputDev::tilingPatternFill(GfxState *state, Gfx *gfx, Catalog *cat,
 void ImageOutputDev::drawImageMask(GfxState *state, Object *ref, Stream *str,
 				   int width, int height, GBool invert,
 				   GBool interpolate, GBool inlineImg) {
-  if (listImages)
-    listImage(state, ref, str, width, height, NULL, interpolate, inlineImg, imgStencil);
-  else
-    writeImage(state, ref, str, width, height, NULL, inlineImg);
+  doImage(state, ref, str, width, height, NULL, interpolate, inlineImg, imgStencil);
 }
 
 void ImageOutputDev::drawImage(GfxState *state, Object *ref, Stream *str,
 			       int width, int height,
 			       GfxImageColorMap *colorMap,
 			       GBool interpolate, int *maskColors, GBool inlineImg) {
-  if (listImages)
-    listImage(state, ref, str, width, height, colorMap, interpolate, inlineImg, imgImage);
-  else
-    writeImage(state, ref, str, width, height, colorMap, inlineImg);
+  doImage(state, ref, str, width, height, colorMap, interpolate, inlineImg, imgImage);
 }
 
 void ImageOutputDev::drawMaskedImage(
   GfxState *state, Object *ref, Stream *str,
   int width, int height, GfxImageColorMap *colorMap, GBool interpolate,
   Stream *maskStr, int maskWidth, int maskHeight, GBool maskInvert, GBool maskInterpolate) {
-  if (listImages) {
-    listImage(state, ref, str, width, height, colorMap, interpolate, gFalse, imgImage);
-    listImage(state, ref, str, maskWidth, maskHeight, NULL, maskInterpolate, gFalse, imgMask);
-  } else {
-    writeImage(state, ref, str, width, height, colorMap, gFalse);
-    writeImage(state, ref, maskStr, maskWidth, maskHeight, NULL, gFalse);
-  }
+  doImage(state, ref, str, width, height, colorMap, interpolate, gFalse, imgImage);
+  doImage(state, ref, maskStr, maskWidth, maskHeight, NULL, maskInterpolate, gFalse, imgMask);
 }
 
 void ImageOutputDev::drawSoftMaskedImage(
@@ -631,11 +913,6 @@ void ImageOutputDev::drawSoftMaskedImage(
   int width, int height, GfxImageColorMap *colorMap, GBool interpolate,
   Stream *maskStr, int maskWidth, int maskHeight,
   GfxImageColorMap *maskColorMap, GBool maskInterpolate) {
-  if (listImages) {
-    listImage(state, ref, str, width, height, colorMap, interpolate, gFalse, imgImage);
-    listImage(state, ref, maskStr, maskWidth, maskHeight, maskColorMap, maskInterpolate, gFalse, imgSmask);
-  } else {
-    writeImage(state, ref, str, width, height, colorMap, gFalse);
-    writeImage(state, ref, maskStr, maskWidth, maskHeight, maskColorMap, gFalse);
-  }
+  doImage(state, ref, str, width, height, colorMap, interpolate, gFalse, imgImage);
+  doImage(state, ref, maskStr, maskWidth, maskHeight, maskColorMap, maskInterpolate, gFalse, imgSmask);
 }
@@ -40,6 +40,9 @@
 #include "OutputDev.h"
 
 class GfxState;
+class GooHash;
+class GooList;
+class GooString;
 
 //------------------------------------------------------------------------
 // ImageOutputDev
@@ -89,6 +92,30 @@ public:
   // Use CCITT format for CCITT files
   void enableCCITT(GBool ccitt) { dumpCCITT = ccitt; }
 
+  // Name the image files <fileRoot><nameTemplate>.<type> instead.  In
+  // the template, %p is replaced by the page number, %n by the image
+  // number, %i by the number of the image on its page (from 0), and
+  // %% by %.  A digit after the % gives the minimum width, padded
+  // with zeros, e.g., "-%3p-%3n" gives the names used by <pageNames>.
+  void setNameTemplate(const char *nameTemplateA);
+
+  // Write an image drawn more than once (the same image object, used
+  // the same way) only the first time it is drawn.
+  void enableDedup(GBool dedupA);
+
+  // Also write the information printed by listImages, as a JSON
+  // array with an object per image, to <jsonFileName> ("-" means
+  // stdout).  For written images, the object includes the file name.
+  // Returns false if the file can't be opened.
+  GBool openJSON(const char *jsonFileName);
+
+  // Keep the images in memory instead of writing files: an
+  // ExtractedImage is appended to <imagesA> for each image.  Images
+  // that would be dumped in their native format (see enableJpeg and
+  // friends) keep their undecoded bytes, the others are decoded to
+  // rows.  The caller owns <imagesA> and the images put in it.
+  void collectImages(GooList *imagesA) { images = imagesA; }
+
   // Check if file was successfully created.
   virtual GBool isOk() { return ok; }
 
@@ -106,7 +133,7 @@ public:
 
   // Start a page
   virtual void startPage(int pageNumA, GfxState *state, XRef *xref) 
-			{ pageNum = pageNumA; }
+			{ pageNum = pageNumA; pageImgNum = imgNum; }
  
   //---- get info about output device
 
@@ -149,14 +176,21 @@ public:
 private:
   // Sets the output filename with a given file extension
   void setFilename(const char *fileExt);
+  void doImage(GfxState *state, Object *ref, Stream *str,
+	       int width, int height,
+	       GfxImageColorMap *colorMap,
+	       GBool interpolate, GBool inlineImg,
+	       ImageType imageType);
   void listImage(GfxState *state, Object *ref, Stream *str,
 		 int width, int height,
 		 GfxImageColorMap *colorMap,
 		 GBool interpolate, GBool inlineImg,
-		 ImageType imageType);
+		 ImageType imageType, int num,
+		 GooString *file, GBool duplicate);
   void writeImage(GfxState *state, Object *ref, Stream *str,
                   int width, int height, GfxImageColorMap *colorMap, GBool inlineImg);
-  void writeRawImage(Stream *str, const char *ext);
+  void writeRawImage(Stream *str, int width, int height, const char *ext,
+                     Stream *globalsStr = NULL);
   void writeImageFile(ImgWriter *writer, ImageFormat format, const char *ext,
                       Stream *str, int width, int height, GfxImageColorMap *colorMap);
 
@@ -170,9 +204,39 @@ private:
   GBool outputPNG;		// set to output in PNG format
   GBool outputTiff;		// set to output in TIFF format
   GBool pageNames;		// set to include page number in file names
+  char *nameTemplate;		// file name template, or NULL
+  GooHash *written;		// files of the images written so far, by
+				//   object, generation, and image type;
+				//   NULL if duplicates are written
+  FILE *jsonFile;		// JSON image list, or NULL
+  GBool jsonEmpty;		// nothing written to jsonFile yet
+  GooList *images;		// collected images [ExtractedImage]
   int pageNum;			// current page number
   int imgNum;			// current image number
+  int pageImgNum;		// number of the first image on the page
   GBool ok;			// set up ok?
 };
 
+//------------------------------------------------------------------------
+// ExtractedImage
+//------------------------------------------------------------------------
+
+// An image kept in memory by ImageOutputDev::collectImages.
+struct ExtractedImage {
+  ExtractedImage(int pageNumA, int imgNumA, int widthA, int heightA);
+  ~ExtractedImage();
+
+  int pageNum;			// page the image is drawn on
+  int imgNum;			// image number, as in the file names
+  int width, height;		// size in pixels
+  const char *ext;		// native format ("jpg", "jp2", "jb2e" or
+				//   "ccitt"), or NULL if decoded
+  GooString *data;		// undecoded stream bytes, or the decoded
+				//   rows, rowSize bytes each
+  GooString *globals;		// JBIG2 globals stream, or NULL
+  Object decodeParms;		// DecodeParms of the image dictionary
+  ImageOutputDev::ImageFormat format;	// format of the decoded rows
+  int rowSize;			// bytes per decoded row
+};
+
 #endif
@@ -59,6 +59,9 @@ static GBool dumpJBIG2 = gFalse;
 static GBool dumpCCITT = gFalse;
 static GBool allFormats = gFalse;
 static GBool pageNames = gFalse;
+static char nameTemplate[256] = "";
+static GBool dedup = gFalse;
+static char jsonFileName[1024] = "";
 static char ownerPassword[33] = "\001";
 static char userPassword[33] = "\001";
 static GBool quiet = gFalse;
@@ -96,6 +99,12 @@ static const ArgDesc argDesc[] = {
    "user password (for encrypted files)"},
   {"-p",      argFlag,     &pageNames,     0,
    "include page numbers in output file names"},
+  {"-name",   argString,   nameTemplate,   sizeof(nameTemplate),
+   "output file name template (%p page, %n image, %i image on page)"},
+  {"-dedup",  argFlag,     &dedup,         0,
+   "write images drawn more than once only once"},
+  {"-json",   argString,   jsonFileName,   sizeof(jsonFileName),
+   "also write the image list as JSON to this file (- for stdout)"},
   {"-q",      argFlag,     &quiet,         0,
    "don't print any messages or errors"},
   {"-v",      argFlag,     &printVersion,  0,
@@ -198,7 +207,16 @@ int main(int argc, char *argv[]) {
 
   // write image files
   imgOut = new ImageOutputDev(imgRoot, pageNames, listImages);
+  if (jsonFileName[0] && !imgOut->openJSON(jsonFileName)) {
+    delete imgOut;
+    exitCode = 2;
+    goto err1;
+  }
   if (imgOut->isOk()) {
+    if (nameTemplate[0]) {
+      imgOut->setNameTemplate(nameTemplate);
+    }
+    imgOut->enableDedup(dedup);
     if (allFormats) {
       imgOut->enablePNG(gTrue);
       imgOut->enableTiff(gTrue);
@@ -214,8 +232,12 @@ int main(int argc, char *argv[]) {
       imgOut->enableJBig2(dumpJBIG2);
       imgOut->enableCCITT(dumpCCITT);
     }
-    doc->displayPages(imgOut, firstPage, lastPage, 72, 72, 0,
-                      gTrue, gFalse, gFalse);
+    // pages are freed as soon as they are done with, so that listing
+    // the images of a large document does not keep every page around
+    for (int pg = firstPage; pg <= lastPage; ++pg) {
+      doc->displayPage(imgOut, pg, 72, 72, 0, gTrue, gFalse, gFalse);
+      doc->releasePage(pg);
+    }
   }
   delete imgOut;
 
@@ -346,6 +346,7 @@ int main(int argc, char *argv[]) {
     } else {
       printf("Page rot:       %d\n", r);
     }
+    doc->releasePage(pg);
   } 
 
   // print the boxes
@@ -367,6 +368,7 @@ int main(int argc, char *argv[]) {
 	printBox(buf, page->getTrimBox());
 	sprintf(buf, "Page %4d ArtBox:   ", pg);
 	printBox(buf, page->getArtBox());
+	doc->releasePage(pg);
       }
     } else {
       page = doc->getPage(firstPage);
@@ -0,0 +1,613 @@
+//========================================================================
+//
+// pdfprobe.cc
+//
+// Reports, in a single parse of the document, what pdffonts, pdfimages
+// -list, pdfsig and pdftk dump_data would each tell about it: the page
+// boxes and rotation, the images of each page, whether a page has fonts
+// and the signature fields. It also tells, from where the glyphs of each
+// page are drawn, whether the page has a text layer of its own, one over
+// its scanned images, or none.
+//
+// This file is licensed under the GPLv2 or later
+//
+// Copyright 2017 Agencia Nacional de Telecomunicacoes
+//
+//========================================================================
+
+#include "config.h"
+#include <poppler-config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "parseargs.h"
+#include "goo/GooString.h"
+#include "goo/GooList.h"
+#include "goo/gmem.h"
+#include "GlobalParams.h"
+#include "Object.h"
+#include "Stream.h"
+#include "GfxState.h"
+#include "OutputDev.h"
+#include "Catalog.h"
+#include "Page.h"
+#include "Form.h"
+#include "PDFDoc.h"
+#include "PDFDocFactory.h"
+#include "FontInfo.h"
+#include "Error.h"
+#include "goo/GooMutex.h"
+#include <vector>
+#if MULTITHREADED && !defined(_WIN32)
+#include <pthread.h>
+#define PROBE_THREADS 1
+#endif
+
+//------------------------------------------------------------------------
+// ProbeOutputDev
+//------------------------------------------------------------------------
+
+// Collects one record per image drawn, with the same fields and names as
+// pdfimages -list, but for the page and image numbers, which are printed
+// with the page. Nothing is decoded. The boxes of the images and the
+// positions of a sample of the glyphs are kept to tell what text the page
+// has.
+class ProbeOutputDev: public OutputDev {
+public:
+  ProbeOutputDev(int maxGlyphsA);
+
+  // Set the list of GooStrings the images of the next page go to, and
+  // forget the images and glyphs of the previous one.
+  void setImages(GooList *imagesA);
+
+  // Number of glyphs drawn on the page, spaces aside.
+  int getNumGlyphs() { return numGlyphs; }
+
+  // What text the page has: "text" if most glyphs are off the images,
+  // "ocr" if they are over the images and spread over at least a quarter
+  // of their height, "image" if the page has images and no such text, and
+  // "empty" if it has neither.
+  const char *getTextKind();
+
+  virtual GBool upsideDown() { return gTrue; }
+  virtual GBool useDrawChar() { return gTrue; }
+  virtual GBool interpretType3Chars() { return gFalse; }
+  virtual GBool needNonText() { return gTrue; }
+  virtual GBool useTilingPatternFill() { return gTrue; }
+  virtual GBool tilingPatternFill(GfxState *state, Gfx *gfx, Catalog *cat, Object *str,
+				  double *pmat, int paintType, int tilingType, Dict *resDict,
+				  double *mat, double *bbox,
+				  int x0, int y0, int x1, int y1,
+				  double xStep, double yStep) { return gTrue; }
+
+  virtual void drawImageMask(GfxState *state, Object *ref, Stream *str,
+			     int width, int height, GBool invert,
+			     GBool interpolate, GBool inlineImg)
+    { listImage(state, str, width, height, NULL, "stencil"); }
+  virtual void drawImage(GfxState *state, Object *ref, Stream *str,
+			 int width, int height, GfxImageColorMap *colorMap,
+			 GBool interpolate, int *maskColors, GBool inlineImg)
+    { listImage(state, str, width, height, colorMap, "image"); }
+  virtual void drawMaskedImage(GfxState *state, Object *ref, Stream *str,
+			       int width, int height,
+			       GfxImageColorMap *colorMap,
+			       GBool interpolate,
+			       Stream *maskStr, int maskWidth, int maskHeight,
+			       GBool maskInvert, GBool maskInterpolate) {
+    listImage(state, str, width, height, colorMap, "image");
+    listImage(state, maskStr, maskWidth, maskHeight, NULL, "mask");
+  }
+  virtual void drawSoftMaskedImage(GfxState *state, Object *ref, Stream *str,
+				   int width, int height,
+				   GfxImageColorMap *colorMap,
+				   GBool interpolate,
+				   Stream *maskStr,
+				   int maskWidth, int maskHeight,
+				   GfxImageColorMap *maskColorMap,
+				   GBool maskInterpolate) {
+    listImage(state, str, width, height, colorMap, "image");
+    listImage(state, maskStr, maskWidth, maskHeight, maskColorMap, "smask");
+  }
+
+  virtual void drawChar(GfxState *state, double x, double y,
+			double dx, double dy,
+			double originX, double originY,
+			CharCode code, int nBytes, Unicode *u, int uLen);
+
+private:
+  struct ProbeBox {
+    double x0, y0, x1, y1;
+  };
+  struct ProbePoint {
+    double x, y;
+  };
+
+  void listImage(GfxState *state, Stream *str, int width, int height,
+		 GfxImageColorMap *colorMap, const char *type);
+
+  GooList *images;		// records of the current page
+  int maxGlyphs;		// glyphs kept per page
+  int numGlyphs;		// glyphs drawn on the page
+  int glyphStep;		// one glyph in glyphStep is kept
+  std::vector<ProbeBox> imageBoxes;	// device boxes of the images
+  std::vector<ProbePoint> glyphs;	// device centers of the kept glyphs
+};
+
+ProbeOutputDev::ProbeOutputDev(int maxGlyphsA) {
+  images = NULL;
+  maxGlyphs = maxGlyphsA > 1 ? maxGlyphsA : 1;
+  numGlyphs = 0;
+  glyphStep = 1;
+}
+
+void ProbeOutputDev::setImages(GooList *imagesA) {
+  images = imagesA;
+  imageBoxes.clear();
+  glyphs.clear();
+  numGlyphs = 0;
+  glyphStep = 1;
+}
+
+void ProbeOutputDev::drawChar(GfxState *state, double x, double y,
+			      double dx, double dy,
+			      double originX, double originY,
+			      CharCode code, int nBytes, Unicode *u, int uLen) {
+  ProbePoint glyph;
+
+  if (uLen == 1 && (u[0] == ' ' || u[0] == '\t')) {
+    return;
+  }
+  // a sample spread over the whole page is enough to tell where the text
+  // lies: when the sample is full, every other glyph of it is dropped and
+  // half as many are kept from then on
+  if (numGlyphs++ % glyphStep != 0) {
+    return;
+  }
+  if ((int)glyphs.size() >= maxGlyphs) {
+    size_t n = 0;
+    for (size_t i = 0; i < glyphs.size(); i += 2) {
+      glyphs[n++] = glyphs[i];
+    }
+    glyphs.resize(n);
+    glyphStep *= 2;
+    if ((numGlyphs - 1) % glyphStep != 0) {
+      return;
+    }
+  }
+  state->transform(x + dx / 2, y + dy / 2, &glyph.x, &glyph.y);
+  glyphs.push_back(glyph);
+}
+
+const char *ProbeOutputDev::getTextKind() {
+  ProbeBox covered;
+  double glyphY0, glyphY1;
+  int inImages;
+
+  if (glyphs.empty()) {
+    return imageBoxes.empty() ? "empty" : "image";
+  }
+  inImages = 0;
+  glyphY0 = glyphY1 = 0;
+  covered.x0 = covered.y0 = covered.x1 = covered.y1 = 0;
+  for (size_t i = 0; i < glyphs.size(); ++i) {
+    ProbePoint *glyph = &glyphs[i];
+    for (size_t j = 0; j < imageBoxes.size(); ++j) {
+      ProbeBox *box = &imageBoxes[j];
+      if (glyph->x < box->x0 || glyph->x > box->x1 ||
+	  glyph->y < box->y0 || glyph->y > box->y1) {
+	continue;
+      }
+      if (inImages == 0) {
+	glyphY0 = glyphY1 = glyph->y;
+	covered = *box;
+      } else {
+	if (glyph->y < glyphY0) glyphY0 = glyph->y;
+	if (glyph->y > glyphY1) glyphY1 = glyph->y;
+	if (box->y0 < covered.y0) covered.y0 = box->y0;
+	if (box->y1 > covered.y1) covered.y1 = box->y1;
+      }
+      ++inImages;
+      break;
+    }
+  }
+  if (2 * inImages < (int)glyphs.size()) {
+    return "text";
+  }
+  // a stamp or a caption over a scan does not make it searchable
+  if (4 * (glyphY1 - glyphY0) < covered.y1 - covered.y0) {
+    return "image";
+  }
+  return "ocr";
+}
+
+void ProbeOutputDev::listImage(GfxState *state, Stream *str,
+			       int width, int height,
+			       GfxImageColorMap *colorMap, const char *type) {
+  const char *colorspace;
+  const char *enc;
+  int components, bpc;
+
+  colorspace = "-";
+  // masks and stencils default to ncomps = 1 and bpc = 1
+  components = 1;
+  bpc = 1;
+  if (colorMap && colorMap->isOk()) {
+    switch (colorMap->getColorSpace()->getMode()) {
+      case csDeviceGray:
+      case csCalGray:
+        colorspace = "gray";
+        break;
+      case csDeviceRGB:
+      case csCalRGB:
+        colorspace = "rgb";
+        break;
+      case csDeviceCMYK:
+        colorspace = "cmyk";
+        break;
+      case csLab:
+        colorspace = "lab";
+        break;
+      case csICCBased:
+        colorspace = "icc";
+        break;
+      case csIndexed:
+        colorspace = "index";
+        break;
+      case csSeparation:
+        colorspace = "sep";
+        break;
+      case csDeviceN:
+        colorspace = "devn";
+        break;
+      case csPattern:
+      default:
+        colorspace = "-";
+        break;
+    }
+    components = colorMap->getNumPixelComps();
+    bpc = colorMap->getBits();
+  }
+
+  switch (str->getKind()) {
+  case strCCITTFax:
+    enc = "ccitt";
+    break;
+  case strDCT:
+    enc = "jpeg";
+    break;
+  case strJPX:
+    enc = "jpx";
+    break;
+  case strJBIG2:
+    enc = "jbig2";
+    break;
+  default:
+    enc = "image";
+    break;
+  }
+
+  double *mat = state->getCTM();
+  ProbeBox box;
+  double tx, ty;
+  state->transform(0, 0, &box.x0, &box.y0);
+  box.x1 = box.x0;
+  box.y1 = box.y0;
+  for (int i = 1; i < 4; ++i) {
+    state->transform(i & 1, i >> 1, &tx, &ty);
+    if (tx < box.x0) box.x0 = tx;
+    if (tx > box.x1) box.x1 = tx;
+    if (ty < box.y0) box.y0 = ty;
+    if (ty > box.y1) box.y1 = ty;
+  }
+  imageBoxes.push_back(box);
+
+  double width2 = mat[0] + mat[2];
+  double height2 = mat[1] + mat[3];
+  double xppi = width2 != 0 ? fabs(width*72.0/width2) : 0;
+  double yppi = height2 != 0 ? fabs(height*72.0/height2) : 0;
+
+  char buf[256];
+  snprintf(buf, sizeof(buf), "%s %d %d %s %d %d %s %.0f %.0f",
+	   type, width, height, colorspace, components, bpc, enc, xppi, yppi);
+  images->append(new GooString(buf));
+}
+
+//------------------------------------------------------------------------
+
+static char ownerPassword[33] = "\001";
+static char userPassword[33] = "\001";
+static int numThreads = 1;
+static int maxGlyphs = 1000;
+static GBool pagesOnly = gFalse;
+static GBool printVersion = gFalse;
+static GBool printHelp = gFalse;
+
+static const ArgDesc argDesc[] = {
+  {"-opw",    argString,   ownerPassword,  sizeof(ownerPassword),
+   "owner password (for encrypted files)"},
+  {"-upw",    argString,   userPassword,   sizeof(userPassword),
+   "user password (for encrypted files)"},
+  {"-j",      argInt,      &numThreads,    0,
+   "number of threads probing pages"},
+  {"-glyphs", argInt,      &maxGlyphs,     0,
+   "number of glyphs of each page kept to tell its text (default 1000)"},
+  {"-pages",  argFlag,     &pagesOnly,     0,
+   "print only the page boxes and rotation, without reading page contents"},
+  {"-v",      argFlag,     &printVersion,  0,
+   "print copyright and version info"},
+  {"-h",      argFlag,     &printHelp,     0,
+   "print usage information"},
+  {"-help",   argFlag,     &printHelp,     0,
+   "print usage information"},
+  {"--help",  argFlag,     &printHelp,     0,
+   "print usage information"},
+  {"-?",      argFlag,     &printHelp,     0,
+   "print usage information"},
+  {NULL}
+};
+
+// Returns the number of signature fields among the widgets of page.
+static int countSignatures(Page *page) {
+  FormPageWidgets *widgets = page->getFormWidgets();
+  int count = 0;
+
+  for (int i = 0; widgets != NULL && i < widgets->getNumWidgets(); ++i) {
+    if (widgets->getWidget(i)->getType() == formSignature) {
+      ++count;
+    }
+  }
+  delete widgets;
+  return count;
+}
+
+// Returns the number of fonts used by page pg, including those of its
+// forms and annotations. The scanner of the thread remembers the fonts and
+// forms that pages share.
+static int countFonts(FontInfoScanner *scanner, int pg) {
+  GooList *fonts = scanner->scanPage(pg);
+  int count = 0;
+
+  if (fonts) {
+    count = fonts->getLength();
+    deleteGooList(fonts, FontInfo);
+  }
+  return count;
+}
+
+static void appendBox(GooString *line, PDFRectangle *box) {
+  char buf[128];
+  snprintf(buf, sizeof(buf), " %g %g %g %g", box->x1, box->y1, box->x2, box->y2);
+  line->append(buf);
+}
+
+// What is printed about a page: its line and the records of its images.
+// The glyph count and text kind are appended to the line after the page
+// is displayed.
+struct PageRecord {
+  GooString *line;		// NULL if the page could not be read
+  GooList *images;
+};
+
+struct ProbeJob {
+  int numPages;
+  int nextPage;
+  PageRecord *records;
+  GooMutex mutex;
+};
+
+// Probes the pages of job with doc until there are none left.
+static void probePages(PDFDoc *doc, ProbeJob *job) {
+  ProbeOutputDev *probeOut = new ProbeOutputDev(maxGlyphs);
+  FontInfoScanner fontScanner(doc);
+  char buf[64];
+
+  while (true) {
+    gLockMutex(&job->mutex);
+    int pg = job->nextPage++;
+    gUnlockMutex(&job->mutex);
+    if (pg > job->numPages)
+      break;
+    PageRecord *record = &job->records[pg - 1];
+    Page *page = doc->getPage(pg);
+    if (!page) {
+      continue;
+    }
+    record->line = GooString::format("page {0:d}", pg);
+    appendBox(record->line, page->getMediaBox());
+    appendBox(record->line, page->getCropBox());
+    snprintf(buf, sizeof(buf), " %d %d %d", page->getRotate(),
+	     countFonts(&fontScanner, pg), countSignatures(page));
+    record->line->append(buf);
+    record->images = new GooList();
+    probeOut->setImages(record->images);
+    doc->displayPage(probeOut, pg, 72, 72, 0, gTrue, gFalse, gFalse);
+    snprintf(buf, sizeof(buf), " %d %s", probeOut->getNumGlyphs(),
+	     probeOut->getTextKind());
+    record->line->append(buf);
+    doc->releasePage(pg);
+  }
+  delete probeOut;
+}
+
+#if PROBE_THREADS
+struct ProbeThread {
+  ProbeJob *job;
+  PDFDoc *doc;
+  pthread_t thread;
+};
+
+static void *probeThread(void *arg) {
+  ProbeThread *t = (ProbeThread *)arg;
+
+  probePages(t->doc, t->job);
+  return NULL;
+}
+#endif
+
+int main(int argc, char *argv[]) {
+  PDFDoc *doc;
+  GooString *fileName;
+  GooString *ownerPW, *userPW;
+  ProbeJob job;
+  GBool ok;
+  int exitCode;
+  int numPages, numSignatures, imgNum;
+
+  exitCode = 99;
+
+  // parse args
+  ok = parseArgs(argDesc, &argc, argv);
+  if (!ok || argc != 2 || printVersion || printHelp) {
+    fprintf(stderr, "pdfprobe version %s\n", PACKAGE_VERSION);
+    fprintf(stderr, "%s\n", popplerCopyright);
+    fprintf(stderr, "%s\n", xpdfCopyright);
+    if (!printVersion) {
+      printUsage("pdfprobe", "<PDF-file>", argDesc);
+    }
+    if (printVersion || printHelp)
+      exitCode = 0;
+    goto err0;
+  }
+  fileName = new GooString(argv[1]);
+
+  // read config file
+  globalParams = new GlobalParams();
+  globalParams->setErrQuiet(gTrue);
+
+  // open PDF file
+  if (ownerPassword[0] != '\001') {
+    ownerPW = new GooString(ownerPassword);
+  } else {
+    ownerPW = NULL;
+  }
+  if (userPassword[0] != '\001') {
+    userPW = new GooString(userPassword);
+  } else {
+    userPW = NULL;
+  }
+  if (fileName->cmp("-") == 0) {
+      delete fileName;
+      fileName = new GooString("fd://0");
+  }
+
+  doc = PDFDocFactory().createPDFDoc(*fileName, ownerPW, userPW);
+  delete fileName;
+
+  if (userPW) {
+    delete userPW;
+  }
+  if (ownerPW) {
+    delete ownerPW;
+  }
+  if (!doc->isOk()) {
+    exitCode = 1;
+    goto err1;
+  }
+
+  // the document record comes first, so that a reader knows how many
+  // page records follow and whether the file must be left untouched
+  numPages = doc->getNumPages();
+  numSignatures = 0;
+  for (int pg = 1; pg <= numPages; ++pg) {
+    Page *page = doc->getPage(pg);
+    if (page) {
+      numSignatures += countSignatures(page);
+      doc->releasePage(pg);
+    }
+  }
+  printf("pdf %d %d\n", numPages, numSignatures);
+
+  // the boxes and rotation come from the page tree alone
+  if (pagesOnly) {
+    for (int pg = 1; pg <= numPages; ++pg) {
+      Page *page = doc->getPage(pg);
+      if (!page) {
+        continue;
+      }
+      GooString *line = GooString::format("page {0:d}", pg);
+      appendBox(line, page->getMediaBox());
+      appendBox(line, page->getCropBox());
+      line->appendf(" {0:d}", page->getRotate());
+      printf("%s\n", line->getCString());
+      delete line;
+      doc->releasePage(pg);
+    }
+    exitCode = 0;
+    goto err1;
+  }
+
+  // then each page, followed by its images; with several threads each one
+  // displays pages on its own copy of the document, and the records are
+  // printed in page order once all are done
+  job.numPages = numPages;
+  job.nextPage = 1;
+  job.records = (PageRecord *)gmallocn(numPages > 0 ? numPages : 1, sizeof(PageRecord));
+  for (int pg = 0; pg < numPages; ++pg) {
+    job.records[pg].line = NULL;
+    job.records[pg].images = NULL;
+  }
+  gInitMutex(&job.mutex);
+#if PROBE_THREADS
+  {
+    std::vector<ProbeThread> threads;
+    int nThreads = numThreads < numPages ? numThreads : numPages;
+    for (int i = 1; i < nThreads; i++) {
+      ProbeThread t;
+      t.job = &job;
+      t.doc = doc->copy();
+      if (t.doc && t.doc->isOk()) {
+        threads.push_back(t);
+      } else {
+        delete t.doc;
+      }
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+      if (pthread_create(&threads[i].thread, NULL, probeThread, &threads[i]) != 0) {
+        for (size_t j = i; j < threads.size(); j++)
+          delete threads[j].doc;
+        threads.resize(i);
+        break;
+      }
+    }
+    probePages(doc, &job);
+    for (size_t i = 0; i < threads.size(); i++) {
+      pthread_join(threads[i].thread, NULL);
+      delete threads[i].doc;
+    }
+  }
+#else
+  probePages(doc, &job);
+#endif
+  gDestroyMutex(&job.mutex);
+
+  imgNum = 0;
+  for (int pg = 1; pg <= numPages; ++pg) {
+    PageRecord *record = &job.records[pg - 1];
+    if (!record->line) {
+      continue;
+    }
+    printf("%s\n", record->line->getCString());
+    for (int i = 0; i < record->images->getLength(); ++i) {
+      GooString *image = (GooString *)record->images->get(i);
+      printf("image %d %d %s\n", pg, imgNum++, image->getCString());
+    }
+    delete record->line;
+    deleteGooList(record->images, GooString);
+  }
+  gfree(job.records);
+
+  exitCode = 0;
+
+ err1:
+  delete doc;
+  delete globalParams;
+ err0:
+
+  // check for memory leaks
+  Object::memCheck(stderr);
+  gMemReport(stderr);
+
+  return exitCode;
+}
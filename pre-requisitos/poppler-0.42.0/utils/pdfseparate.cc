@@ -17,15 +17,23 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
+#include <vector>
 #include "parseargs.h"
 #include "goo/GooString.h"
 #include "PDFDoc.h"
 #include "ErrorCodes.h"
 #include "GlobalParams.h"
+#include "goo/GooMutex.h"
 #include <ctype.h>
+#if MULTITHREADED && !defined(_WIN32)
+#include <pthread.h>
+#define SEPARATE_THREADS 1
+#endif
 
 static int firstPage = 0;
 static int lastPage = 0;
+static int numThreads = 1;
+static GBool printNames = gFalse;
 static GBool printVersion = gFalse;
 static GBool printHelp = gFalse;
 
@@ -34,6 +42,10 @@ static const ArgDesc argDesc[] = {
    "first page to extract"},
   {"-l", argInt, &lastPage, 0,
    "last page to extract"},
+  {"-j", argInt, &numThreads, 0,
+   "number of threads writing pages"},
+  {"-p", argFlag, &printNames, 0,
+   "print the name of each page file as soon as it is written"},
   {"-v", argFlag, &printVersion, 0,
    "print copyright and version info"},
   {"-h", argFlag, &printHelp, 0,
@@ -47,8 +59,62 @@ static const ArgDesc argDesc[] = {
   {NULL}
 };
 
-bool extractPages (const char *srcFileName, const char *destFileName) {
+// Pages still to be written, handed out to the threads one at a time
+struct SeparateJob {
+  const char *destFileName;
+  int nextPage;
+  bool failed;
+  GooMutex mutex;
+};
+
+// Writes the pages of job with doc until there are none left or one fails.
+static void savePages(PDFDoc *doc, SeparateJob *job) {
   char pathName[4096];
+
+  while (true) {
+    gLockMutex(&job->mutex);
+    int pageNo = job->failed ? lastPage + 1 : job->nextPage++;
+    gUnlockMutex(&job->mutex);
+    if (pageNo > lastPage)
+      return;
+    snprintf (pathName, sizeof (pathName) - 1, job->destFileName, pageNo);
+    GooString *gpageName = new GooString (pathName);
+    int errCode = doc->savePageAs(gpageName, pageNo);
+    delete gpageName;
+    if (errCode != errNone) {
+      gLockMutex(&job->mutex);
+      job->failed = true;
+      gUnlockMutex(&job->mutex);
+      return;
+    }
+    if (printNames) {
+      // a reader of the names can take the page while the next ones are written
+      gLockMutex(&job->mutex);
+      printf("%s\n", pathName);
+      fflush(stdout);
+      gUnlockMutex(&job->mutex);
+    }
+  }
+}
+
+#if SEPARATE_THREADS
+struct SeparateThread {
+  SeparateJob *job;
+  PDFDoc *doc;
+  pthread_t thread;
+};
+
+// savePageAs swaps the xref table of its document while it writes a page,
+// so every thread writes with its own copy of the document.
+static void *separateThread(void *arg) {
+  SeparateThread *t = (SeparateThread *)arg;
+
+  savePages(t->doc, t->job);
+  return NULL;
+}
+#endif
+
+bool extractPages (const char *srcFileName, const char *destFileName) {
   GooString *gfileName = new GooString (srcFileName);
   PDFDoc *doc = new PDFDoc (gfileName, NULL, NULL, NULL);
 
@@ -120,23 +186,48 @@ bool extractPages (const char *srcFileName, const char *destFileName) {
     return false;
   }
   free(auxDestFileName);
-  
-  for (int pageNo = firstPage; pageNo <= lastPage; pageNo++) {
-    snprintf (pathName, sizeof (pathName) - 1, destFileName, pageNo);
-    GooString *gpageName = new GooString (pathName);
-    PDFDoc *pagedoc = new PDFDoc (new GooString (srcFileName), NULL, NULL, NULL);
-    int errCode = pagedoc->savePageAs(gpageName, pageNo);
-    if ( errCode != errNone) {
-      delete gpageName;
-      delete doc;
-      delete pagedoc;
-      return false;
+
+  // The document is opened once and writes all its pages: the xref table and
+  // the page tree are read a single time, and not again for every page
+  SeparateJob job;
+  job.destFileName = destFileName;
+  job.nextPage = firstPage;
+  job.failed = false;
+  gInitMutex(&job.mutex);
+#if SEPARATE_THREADS
+  // the copies share the xref table of doc, and are all made before any
+  // page is written
+  std::vector<SeparateThread> threads;
+  int nThreads = numThreads < lastPage - firstPage + 1 ? numThreads : lastPage - firstPage + 1;
+  for (int i = 1; i < nThreads; i++) {
+    SeparateThread t;
+    t.job = &job;
+    t.doc = doc->copy();
+    if (t.doc && t.doc->isOk()) {
+      threads.push_back(t);
+    } else {
+      delete t.doc;
     }
-    delete pagedoc;
-    delete gpageName;
   }
+  for (size_t i = 0; i < threads.size(); i++) {
+    if (pthread_create(&threads[i].thread, NULL, separateThread, &threads[i]) != 0) {
+      for (size_t j = i; j < threads.size(); j++)
+        delete threads[j].doc;
+      threads.resize(i);
+      break;
+    }
+  }
+#endif
+  savePages(doc, &job);
+#if SEPARATE_THREADS
+  for (size_t i = 0; i < threads.size(); i++) {
+    pthread_join(threads[i].thread, NULL);
+    delete threads[i].doc;
+  }
+#endif
+  gDestroyMutex(&job.mutex);
   delete doc;
-  return true;
+  return !job.failed;
 }
 
 int
@@ -88,10 +88,13 @@ char *getReadableTime(time_t unix_time)
 static GBool printVersion = gFalse;
 static GBool printHelp = gFalse;
 static GBool dontVerifyCert = gFalse;
+static GBool quick = gFalse;
 
 static const ArgDesc argDesc[] = {
   {"-nocert", argFlag,     &dontVerifyCert,     0,
    "don't perform certificate validation"},
+  {"-quick",  argFlag,     &quick,         0,
+   "only tell whether the file has signatures, without validating them"},
 
   {"-v",      argFlag,     &printVersion,  0,
    "print copyright and version info"},
@@ -133,6 +136,10 @@ int main(int argc, char *argv[])
   }
 
   fileName = new GooString(argv[argc - 1]);
+  if (fileName->cmp("-") == 0) {
+    delete fileName;
+    fileName = new GooString("fd://0");
+  }
 
   // open PDF file
   doc = PDFDocFactory().createPDFDoc(*fileName, NULL, NULL);
@@ -142,6 +149,17 @@ int main(int argc, char *argv[])
     goto end;
   }
 
+  if (quick) {
+    if (doc->hasSignatures()) {
+      printf("File '%s' contains signatures\n", fileName->getCString());
+      exitCode = 0;
+    } else {
+      printf("File '%s' does not contain any signatures\n", fileName->getCString());
+      exitCode = 2;
+    }
+    goto end;
+  }
+
   sig_widgets = doc->getSignatureWidgets();
   sigCount = sig_widgets.size();
 
@@ -40,29 +40,27 @@
 #include <io.h>    // for setmode
 #endif
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
+#include <vector>
 #include "parseargs.h"
 #include "goo/gmem.h"
 #include "goo/GooString.h"
+#include "goo/ImgWriter.h"
+#include "Error.h"
 #include "GlobalParams.h"
 #include "Object.h"
 #include "PDFDoc.h"
 #include "PDFDocFactory.h"
+#include "splash/SplashErrorCodes.h"
 #include "splash/SplashBitmap.h"
 #include "splash/Splash.h"
 #include "SplashOutputDev.h"
 
-// Uncomment to build pdftoppm with pthreads
-// You may also have to change the buildsystem to
-// link pdftoppm to pthread library
-// This is here for developer testing not user ready
-// #define UTILS_USE_PTHREADS 1
-
-#ifdef UTILS_USE_PTHREADS
-#include <errno.h>
+#if MULTITHREADED && !defined(_WIN32)
 #include <pthread.h>
-#include <deque>
-#endif // UTILS_USE_PTHREADS
+#define BAND_THREADS 1
+#endif
 
 static int firstPage = 1;
 static int lastPage = 0;
@@ -81,8 +79,10 @@ static int w = 0;
 static int h = 0;
 static int sz = 0;
 static GBool useCropBox = gFalse;
+static int stripHeight = 0;
 static GBool mono = gFalse;
 static GBool gray = gFalse;
+static int threshold = 0;
 static GBool png = gFalse;
 static GBool jpeg = gFalse;
 static GBool jpegcmyk = gFalse;
@@ -100,9 +100,11 @@ static char userPassword[33] = "";
 static char TiffCompressionStr[16] = "";
 static char thinLineModeStr[8] = "";
 static SplashThinLineMode thinLineMode = splashThinLineDefault;
-#ifdef UTILS_USE_PTHREADS
-static int numberOfJobs = 1;
-#endif // UTILS_USE_PTHREADS
+#if BAND_THREADS
+static int numThreads = 1;
+#endif
+static int jpxThreads = 1;
+static GBool jpxReduce = gFalse;
 static GBool quiet = gFalse;
 static GBool printVersion = gFalse;
 static GBool printHelp = gFalse;
@@ -144,11 +146,15 @@ static const ArgDesc argDesc[] = {
    "size of crop square in pixels (sets W and H)"},
   {"-cropbox",argFlag,     &useCropBox,    0,
    "use the crop box rather than media box"},
+  {"-strip",  argInt,      &stripHeight,   0,
+   "render and write each page in strips of this many rows"},
 
   {"-mono",   argFlag,     &mono,          0,
    "generate a monochrome PBM file"},
   {"-gray",   argFlag,     &gray,          0,
    "generate a grayscale PGM file"},
+  {"-threshold", argInt,   &threshold,     0,
+   "generate a monochrome PBM file, thresholding a grayscale rendering at this level (1-255)"},
 #if ENABLE_LIBPNG
   {"-png",    argFlag,     &png,           0,
    "generate a PNG file"},
@@ -188,10 +194,14 @@ static const ArgDesc argDesc[] = {
   {"-upw",    argString,   userPassword,   sizeof(userPassword),
    "user password (for encrypted files)"},
   
-#ifdef UTILS_USE_PTHREADS
-  {"-j",      argInt,      &numberOfJobs,  0,
-   "number of jobs to run concurrently"},
-#endif // UTILS_USE_PTHREADS
+#if BAND_THREADS
+  {"-j",      argInt,      &numThreads,    0,
+   "number of threads rendering each page in bands"},
+#endif
+  {"-jpxthreads", argInt,  &jpxThreads,    0,
+   "number of threads decoding each JPEG 2000 image"},
+  {"-jpxreduce", argFlag,  &jpxReduce,     0,
+   "decode JPEG 2000 images only at the resolution they are drawn at"},
 
   {"-q",      argFlag,     &quiet,         0,
    "don't print any messages or errors"},
@@ -208,23 +218,249 @@ static const ArgDesc argDesc[] = {
   {NULL}
 };
 
+static SplashOutputDev *makeSplashOut(PDFDoc *doc, SplashColor paperColor) {
+  SplashOutputDev *splashOut;
+
+  splashOut = new SplashOutputDev(mono ? splashModeMono1 :
+				    gray ? splashModeMono8 :
+#if SPLASH_CMYK
+				    (jpegcmyk || overprint) ? splashModeDeviceN8 :
+#endif
+				             splashModeRGB8, 4,
+				  gFalse, paperColor, gTrue, thinLineMode);
+  splashOut->setFontAntialias(fontAntialias);
+  splashOut->setVectorAntialias(vectorAntialias);
+  splashOut->startDoc(doc);
+  return splashOut;
+}
+
+static void renderSlice(PDFDoc *doc, SplashOutputDev *splashOut,
+			int pg, int x, int y, int w, int h) {
+  doc->displayPageSlice(splashOut, 
+    pg, x_resolution, y_resolution, 
+    0,
+    !useCropBox, gFalse, gFalse,
+    x, y, w, h
+  );
+}
+
+// Makes a monochrome bitmap out of a grayscale one, with black for the
+// pixels darker than the threshold.
+static SplashBitmap *thresholdBitmap(SplashBitmap *grayBitmap) {
+  SplashBitmap *bitmap;
+  SplashColorPtr p, q;
+  int width, height;
+
+  width = grayBitmap->getWidth();
+  height = grayBitmap->getHeight();
+  bitmap = new SplashBitmap(width, height, 1, splashModeMono1, gFalse);
+  for (int yy = 0; yy < height; ++yy) {
+    p = grayBitmap->getDataPtr() + (size_t)yy * grayBitmap->getRowSize();
+    q = bitmap->getDataPtr() + (size_t)yy * bitmap->getRowSize();
+    memset(q, 0, bitmap->getRowSize());
+    for (int xx = 0; xx < width; ++xx) {
+      if (p[xx] >= threshold) {
+	q[xx >> 3] |= 0x80 >> (xx & 7);
+      }
+    }
+  }
+  return bitmap;
+}
+
+// Bands and strips are a multiple of this many rows high, so that the
+// halftone screens of monochrome output line up across them.
+#define bandRowAlign 64
+
+#if BAND_THREADS
+
+// A thread rendering one band of each page with its own copy of the
+// document and its own output device.
+struct BandThread {
+  PDFDoc *doc;
+  SplashOutputDev *splashOut;
+  int pg, x, y, w, h;
+  pthread_t thread;
+};
+
+static std::vector<BandThread> bandThreads;
+
+static void *renderBandThread(void *arg) {
+  BandThread *band = (BandThread *)arg;
+
+  renderSlice(band->doc, band->splashOut,
+	      band->pg, band->x, band->y, band->w, band->h);
+  return NULL;
+}
+
+static void copyBand(SplashBitmap *bitmap, SplashBitmap *band, int y) {
+  memcpy(bitmap->getDataPtr() + (size_t)y * bitmap->getRowSize(),
+	 band->getDataPtr(), (size_t)band->getHeight() * band->getRowSize());
+  if (bitmap->getAlphaPtr() && band->getAlphaPtr()) {
+    memcpy(bitmap->getAlphaPtr() + (size_t)y * bitmap->getWidth(),
+	   band->getAlphaPtr(), (size_t)band->getHeight() * band->getWidth());
+  }
+}
+
+// Renders the slice in horizontal bands, the first one in this thread
+// and the others in the band threads, and joins them into a new bitmap.
+// Every band runs the whole content stream of the page, clipped to the
+// band.
+static SplashBitmap *renderBands(PDFDoc *doc, SplashOutputDev *splashOut,
+				 int pg, int x, int y, int w, int h) {
+  SplashBitmap *bitmap, *band;
+  std::vector<bool> started;
+  int n, bandH;
+
+  n = (int)bandThreads.size() + 1;
+  bandH = (h + n - 1) / n;
+  bandH = (bandH + bandRowAlign - 1) / bandRowAlign * bandRowAlign;
+  n = (h + bandH - 1) / bandH;
+  started.resize(n - 1);
+  for (int i = 0; i < n - 1; ++i) {
+    BandThread *t = &bandThreads[i];
+    t->pg = pg;
+    t->x = x;
+    t->y = y + (i + 1) * bandH;
+    t->w = w;
+    t->h = i == n - 2 ? h - (i + 1) * bandH : bandH;
+    started[i] = pthread_create(&t->thread, NULL, renderBandThread, t) == 0;
+  }
+  renderSlice(doc, splashOut, pg, x, y, w, bandH);
+  for (int i = 0; i < n - 1; ++i) {
+    if (started[i]) {
+      pthread_join(bandThreads[i].thread, NULL);
+    } else {
+      renderBandThread(&bandThreads[i]);
+    }
+  }
+
+  band = splashOut->getBitmap();
+  bitmap = new SplashBitmap(w, h, 4, band->getMode(),
+			    band->getAlphaPtr() != NULL, gTrue,
+			    band->getSeparationList());
+  copyBand(bitmap, band, 0);
+  for (int i = 0; i < n - 1; ++i) {
+    copyBand(bitmap, bandThreads[i].splashOut->getBitmap(), (i + 1) * bandH);
+  }
+  return bitmap;
+}
+
+#endif
+
+// Renders a slice of the page, thresholded if asked to.  The bitmap
+// is the one of splashOut or a new one, which the caller deletes.
+static SplashBitmap *renderPageSlice(PDFDoc *doc, SplashOutputDev *splashOut,
+				     int pg, int x, int y, int w, int h) {
+  SplashBitmap *bitmap;
+
+#if BAND_THREADS
+  if (bandThreads.size() > 0 && h > bandRowAlign) {
+    bitmap = renderBands(doc, splashOut, pg, x, y, w, h);
+  } else
+#endif
+  {
+    renderSlice(doc, splashOut, pg, x, y, w, h);
+    bitmap = splashOut->getBitmap();
+  }
+  if (threshold > 0) {
+    SplashBitmap *grayBitmap = bitmap;
+    bitmap = thresholdBitmap(grayBitmap);
+    if (grayBitmap != splashOut->getBitmap()) {
+      delete grayBitmap;
+    }
+  }
+  return bitmap;
+}
+
+// Renders the slice in strips of stripHeight rows, one after the other,
+// and writes each one to the file before rendering the next, so that
+// only one strip of the page is ever in memory.  Every strip runs the
+// whole content stream of the page, clipped to the strip.
+static void savePageStrips(PDFDoc *doc, SplashOutputDev *splashOut,
+			   int pg, int x, int y, int w, int h,
+			   char *ppmFile) {
+  SplashBitmap *bitmap;
+  ImgWriter *writer;
+  FILE *f;
+  GBool ok;
+  int stripH, sy, sh;
+
+  if (ppmFile != NULL) {
+    if (!(f = fopen(ppmFile, "wb"))) {
+      error(errIO, -1, "Couldn't open file '{0:s}'", ppmFile);
+      return;
+    }
+  } else {
+#ifdef _WIN32
+    setmode(fileno(stdout), O_BINARY);
+#endif
+    f = stdout;
+  }
+
+  stripH = (stripHeight + bandRowAlign - 1) / bandRowAlign * bandRowAlign;
+  writer = NULL;
+  ok = gTrue;
+  for (sy = 0; ok && sy < h; sy += stripH) {
+    sh = h - sy < stripH ? h - sy : stripH;
+    bitmap = renderPageSlice(doc, splashOut, pg, x, y + sy, w, sh);
+    if (sy == 0) {
+      if (png) {
+	writer = bitmap->makeImgWriter(splashFormatPng);
+      } else if (jpeg) {
+	writer = bitmap->makeImgWriter(splashFormatJpeg);
+      } else if (jpegcmyk) {
+	writer = bitmap->makeImgWriter(splashFormatJpegCMYK);
+      } else if (tiff) {
+	writer = bitmap->makeImgWriter(splashFormatTiff, TiffCompressionStr);
+      }
+      if (writer) {
+	ok = writer->init(f, bitmap->getWidth(), h,
+			  x_resolution, y_resolution);
+      } else {
+	ok = bitmap->writePNMHeader(f, h) == splashOk;
+      }
+    }
+    if (ok) {
+      if (writer) {
+	ok = bitmap->writeImgRows(writer) == splashOk;
+      } else {
+	ok = bitmap->writePNMRows(f) == splashOk;
+      }
+    }
+    if (bitmap != splashOut->getBitmap()) {
+      delete bitmap;
+    }
+  }
+  if (writer) {
+    if (ok) {
+      writer->close();
+    }
+    delete writer;
+  }
+  if (!ok) {
+    error(errIO, -1, "Couldn't write page {0:d}", pg);
+  }
+  if (f != stdout) {
+    fclose(f);
+  }
+}
+
 static void savePageSlice(PDFDoc *doc,
                    SplashOutputDev *splashOut, 
                    int pg, int x, int y, int w, int h, 
                    double pg_w, double pg_h, 
                    char *ppmFile) {
+  SplashBitmap *bitmap;
+
   if (w == 0) w = (int)ceil(pg_w);
   if (h == 0) h = (int)ceil(pg_h);
   w = (x+w > pg_w ? (int)ceil(pg_w-x) : w);
   h = (y+h > pg_h ? (int)ceil(pg_h-y) : h);
-  doc->displayPageSlice(splashOut, 
-    pg, x_resolution, y_resolution, 
-    0,
-    !useCropBox, gFalse, gFalse,
-    x, y, w, h
-  );
-
-  SplashBitmap *bitmap = splashOut->getBitmap();
+  if (stripHeight > 0 && h > stripHeight) {
+    savePageStrips(doc, splashOut, pg, x, y, w, h, ppmFile);
+    return;
+  }
+  bitmap = renderPageSlice(doc, splashOut, pg, x, y, w, h);
   
   if (ppmFile != NULL) {
     if (png) {
@@ -253,58 +489,11 @@ static void savePageSlice(PDFDoc *doc,
       bitmap->writePNMFile(stdout);
     }
   }
-}
-
-#ifdef UTILS_USE_PTHREADS
-
-struct PageJob {
-  PDFDoc *doc;
-  int pg;
-  
-  double pg_w, pg_h;
-  SplashColor* paperColor;
-  
-  char *ppmFile;
-};
-
-static std::deque<PageJob> pageJobQueue;
-static pthread_mutex_t pageJobMutex = PTHREAD_MUTEX_INITIALIZER;
-
-static void processPageJobs() {
-  while(true) {
-    // pop the next job or exit if queue is empty
-    pthread_mutex_lock(&pageJobMutex);
-    
-    if(pageJobQueue.empty()) {
-      pthread_mutex_unlock(&pageJobMutex);
-      return;
-    }
-    
-    PageJob pageJob = pageJobQueue.front();
-    pageJobQueue.pop_front();
-    
-    pthread_mutex_unlock(&pageJobMutex);
-    
-    // process the job    
-    SplashOutputDev *splashOut = new SplashOutputDev(mono ? splashModeMono1 :
-                  gray ? splashModeMono8 :
-#if SPLASH_CMYK
-        			    (jpegcmyk || overprint) ? splashModeDeviceN8 :
-#endif
-		              splashModeRGB8, 4, gFalse, *pageJob.paperColor, gTrue, thinLineMode);
-    splashOut->setFontAntialias(fontAntialias);
-    splashOut->setVectorAntialias(vectorAntialias);
-    splashOut->startDoc(pageJob.doc);
-    
-    savePageSlice(pageJob.doc, splashOut, pageJob.pg, x, y, w, h, pageJob.pg_w, pageJob.pg_h, pageJob.ppmFile);
-    
-    delete splashOut;
-    delete[] pageJob.ppmFile;
+  if (bitmap != splashOut->getBitmap()) {
+    delete bitmap;
   }
 }
 
-#endif // UTILS_USE_PTHREADS
-
 static int numberOfCharacters(unsigned int n)
 {
   int charNum = 0;
@@ -324,11 +513,7 @@ int main(int argc, char *argv[]) {
   char *ppmFile;
   GooString *ownerPW, *userPW;
   SplashColor paperColor;
-#ifndef UTILS_USE_PTHREADS
   SplashOutputDev *splashOut;
-#else
-  pthread_t* jobs;
-#endif // UTILS_USE_PTHREADS
   GBool ok;
   int exitCode;
   int pg, pg_num_len;
@@ -341,6 +526,13 @@ int main(int argc, char *argv[]) {
   if (mono && gray) {
     ok = gFalse;
   }
+  if (threshold != 0) {
+    // the page is rendered anti-aliased in gray, and thresholded after
+    if (mono || gray || threshold < 0 || threshold > 255) {
+      ok = gFalse;
+    }
+    gray = gTrue;
+  }
   if ( resolution != 0.0 &&
        (x_resolution == 150.0 ||
         y_resolution == 150.0)) {
@@ -391,6 +583,8 @@ int main(int argc, char *argv[]) {
   if (quiet) {
     globalParams->setErrQuiet(quiet);
   }
+  globalParams->setJpxThreads(jpxThreads);
+  globalParams->setJpxReduce(jpxReduce);
 
   // open PDF file
   if (ownerPassword[0]) {
@@ -462,23 +656,21 @@ int main(int argc, char *argv[]) {
     paperColor[2] = 255;
   }
   
-#ifndef UTILS_USE_PTHREADS
-
-  splashOut = new SplashOutputDev(mono ? splashModeMono1 :
-				    gray ? splashModeMono8 :
-#if SPLASH_CMYK
-				    (jpegcmyk || overprint) ? splashModeDeviceN8 :
+  splashOut = makeSplashOut(doc, paperColor);
+#if BAND_THREADS
+  // the copies share the xref table of doc, and are all made before any
+  // page is rendered
+  for (int i = 1; i < numThreads; ++i) {
+    BandThread t;
+    t.doc = doc->copy();
+    if (t.doc && t.doc->isOk()) {
+      t.splashOut = makeSplashOut(t.doc, paperColor);
+      bandThreads.push_back(t);
+    } else {
+      delete t.doc;
+    }
+  }
 #endif
-				             splashModeRGB8, 4,
-				  gFalse, paperColor, gTrue, thinLineMode);
-
-
-
-  splashOut->setFontAntialias(fontAntialias);
-  splashOut->setVectorAntialias(vectorAntialias);
-  splashOut->startDoc(doc);
-  
-#endif // UTILS_USE_PTHREADS
   
   if (sz != 0) w = h = sz;
   pg_num_len = numberOfCharacters(doc->getNumPages());
@@ -516,7 +708,7 @@ int main(int argc, char *argv[]) {
       pg_h = tmp;
     }
     if (ppmRoot != NULL) {
-      const char *ext = png ? "png" : (jpeg || jpegcmyk) ? "jpg" : tiff ? "tif" : mono ? "pbm" : gray ? "pgm" : "ppm";
+      const char *ext = png ? "png" : (jpeg || jpegcmyk) ? "jpg" : tiff ? "tif" : (mono || threshold) ? "pbm" : gray ? "pgm" : "ppm";
       if (singleFile) {
         ppmFile = new char[strlen(ppmRoot) + 1 + strlen(ext) + 1];
         sprintf(ppmFile, "%s.%s", ppmRoot, ext);
@@ -527,53 +719,16 @@ int main(int argc, char *argv[]) {
     } else {
       ppmFile = NULL;
     }
-#ifndef UTILS_USE_PTHREADS
-    // process job in main thread
     savePageSlice(doc, splashOut, pg, x, y, w, h, pg_w, pg_h, ppmFile);
-    
     delete[] ppmFile;
-#else
-    
-    // queue job for worker threads
-    PageJob pageJob = {
-      .doc = doc,
-      .pg = pg,
-      
-      .pg_w = pg_w, .pg_h = pg_h,
-      
-      .paperColor = &paperColor,
-      
-      .ppmFile = ppmFile
-    };
-    
-    pageJobQueue.push_back(pageJob);
-    
-#endif // UTILS_USE_PTHREADS
-  }
-#ifndef UTILS_USE_PTHREADS
-  delete splashOut;
-#else
-  
-  // spawn worker threads and wait on them
-  jobs = (pthread_t*)malloc(numberOfJobs * sizeof(pthread_t));
-
-  for(int i=0; i < numberOfJobs; ++i) {
-    if(pthread_create(&jobs[i], NULL, (void* (*)(void*))processPageJobs, NULL) != 0) {
-	    fprintf(stderr, "pthread_create() failed with errno: %d\n", errno);
-	    exit(EXIT_FAILURE);
-    }
   }
-  
-  for(int i=0; i < numberOfJobs; ++i) {
-    if(pthread_join(jobs[i], NULL) != 0) {
-      fprintf(stderr, "pthread_join() failed with errno: %d\n", errno);
-      exit(EXIT_FAILURE);
-    }
+  delete splashOut;
+#if BAND_THREADS
+  for (size_t i = 0; i < bandThreads.size(); ++i) {
+    delete bandThreads[i].splashOut;
+    delete bandThreads[i].doc;
   }
-
-  free(jobs);
-  
-#endif // UTILS_USE_PTHREADS
+#endif
 
   exitCode = 0;
 
@@ -16,15 +16,22 @@
 
 #include <PDFDoc.h>
 #include <GlobalParams.h>
+#include <Decrypt.h>
 #include "parseargs.h"
 #include "config.h"
 #include <poppler-config.h>
+#include <stdarg.h>
+#include <string>
+#include <map>
 #include <vector>
 
+static GBool streamMerge = gFalse;
 static GBool printVersion = gFalse;
 static GBool printHelp = gFalse;
 
 static const ArgDesc argDesc[] = {
+  {"-stream", argFlag, &streamMerge, 0,
+   "merge the files one at a time and write identical streams once"},
   {"-v", argFlag, &printVersion, 0,
    "print copyright and version info"},
   {"-h", argFlag, &printHelp, 0,
@@ -164,6 +171,229 @@ void doMergeNameDict(PDFDoc *doc, XRef *srcXRef, XRef *countRef, int oldRefNum,
   }
 }
 
+// Removes from intents the output intents which doc does not have, or all
+// of them if doc has none at all
+void mergeOutputIntents(Object *intents, PDFDoc *doc) {
+  if (!intents->isArray() || intents->arrayGetLength() == 0)
+    return;
+  Object pagecatObj, pageintents;
+  doc->getXRef()->getCatalog(&pagecatObj);
+  Dict *pagecatDict = pagecatObj.getDict();
+  pagecatDict->lookup("OutputIntents", &pageintents);
+  if (pageintents.isArray() && pageintents.arrayGetLength() > 0) {
+    for (int j = intents->arrayGetLength() - 1; j >= 0; j--) {
+      Object intent;
+      intents->arrayGet(j, &intent, 0);
+      if (intent.isDict()) {
+        Object idf;
+        intent.dictLookup("OutputConditionIdentifier", &idf);
+        if (idf.isString()) {
+          GooString *gidf = idf.getString();
+          GBool removeIntent = gTrue;
+          for (int k = 0; k < pageintents.arrayGetLength(); k++) {
+            Object pgintent;
+            pageintents.arrayGet(k, &pgintent, 0);
+            if (pgintent.isDict()) {
+              Object pgidf;
+              pgintent.dictLookup("OutputConditionIdentifier", &pgidf);
+              if (pgidf.isString()) {
+                GooString *gpgidf = pgidf.getString();
+                if (gpgidf->cmp(gidf) == 0) {
+                  pgidf.free();
+                  removeIntent = gFalse;
+                  break;
+                }
+              }
+              pgidf.free();
+            }
+          }
+          if (removeIntent) {
+            intents->arrayRemove(j);
+            error(errSyntaxWarning, -1, "Output intent {0:s} missing in pdf {1:s}, removed",
+             gidf->getCString(), doc->getFileName()->getCString());
+          }
+        } else {
+          intents->arrayRemove(j);
+          error(errSyntaxWarning, -1, "Invalid output intent dict, missing required OutputConditionIdentifier");
+        }
+        idf.free();
+      } else {
+        intents->arrayRemove(j);
+      }
+      intent.free();
+    }
+  } else {
+    error(errSyntaxWarning, -1, "Output intents differs, remove them all");
+    intents->free();
+  }
+  pagecatObj.free();
+  pageintents.free();
+}
+
+//------------------------------------------------------------------------
+// Stream merge: each file is written out and closed before the next one
+// is read, and a stream equal to one already written is replaced by a
+// reference to it, so that fonts and images shared by the files (as the
+// GlyphLessFont of every page of Tesseract) are only stored once.
+//------------------------------------------------------------------------
+
+// Output stream held in memory, used to get the bytes of an object
+class MemOutStream : public OutStream {
+public:
+  MemOutStream() {}
+  virtual ~MemOutStream() {}
+  virtual void close() {}
+  virtual Goffset getPos() { return buf.getLength(); }
+  virtual void put(char c) { buf.append(c); }
+  virtual void printf(const char *format, ...);
+  GooString *getBuffer() { return &buf; }
+private:
+  GooString buf;
+};
+
+void MemOutStream::printf(const char *format, ...) {
+  char small[256];
+  va_list argptr;
+  va_start(argptr, format);
+  int n = vsnprintf(small, sizeof(small), format, argptr);
+  va_end(argptr);
+  if (n < 0)
+    return;
+  if (n < (int) sizeof(small)) {
+    buf.append(small, n);
+    return;
+  }
+  char *big = (char *) gmalloc(n + 1);
+  va_start(argptr, format);
+  vsnprintf(big, n + 1, format, argptr);
+  va_end(argptr);
+  buf.append(big, n);
+  gfree(big);
+}
+
+// Copies obj to newObj with numOffset added to its references, and the
+// references to dropped streams pointed to the streams they duplicate.
+// A stream keeps its own dict, which is changed in place, and gets a
+// direct Length, since equal streams differ in their Length objects.
+void remapObject(Object *obj, Object *newObj, XRef *xref, Guint numOffset, std::vector<Ref> *dupOf) {
+  Object obj1, obj2;
+  switch (obj->getType()) {
+    case objRef:
+      {
+        Ref ref = obj->getRef();
+        ref.num += numOffset;
+        if (ref.num < (int) dupOf->size() && (*dupOf)[ref.num].num > 0)
+          ref = (*dupOf)[ref.num];
+        newObj->initRef(ref.num, ref.gen);
+      }
+      break;
+    case objArray:
+      newObj->initArray(xref);
+      for (int i = 0; i < obj->arrayGetLength(); i++) {
+        remapObject(obj->arrayGetNF(i, &obj1), &obj2, xref, numOffset, dupOf);
+        newObj->arrayAdd(&obj2);
+        obj1.free();
+      }
+      break;
+    case objDict:
+      newObj->initDict(xref);
+      for (int i = 0; i < obj->dictGetLength(); i++) {
+        remapObject(obj->dictGetValNF(i, &obj1), &obj2, xref, numOffset, dupOf);
+        newObj->dictAdd(copyString(obj->dictGetKey(i)), &obj2);
+        obj1.free();
+      }
+      break;
+    case objStream:
+      {
+        Dict *dict = obj->streamGetDict();
+        for (int i = 0; i < dict->getLength(); i++) {
+          const char *key = dict->getKey(i);
+          if (strcmp(key, "Length") == 0) {
+            dict->getVal(i, &obj2);
+          } else {
+            remapObject(dict->getValNF(i, &obj1), &obj2, xref, numOffset, dupOf);
+            obj1.free();
+          }
+          dict->set(key, &obj2);
+        }
+        obj->copy(newObj);
+      }
+      break;
+    default:
+      obj->copy(newObj);
+      break;
+  }
+}
+
+// Writes the objects of doc marked in yRef from numOffset on, except the
+// streams equal to one written before, which are recorded in dupOf
+int writeDocObjects(PDFDoc *doc, OutStream *outStr, XRef *yRef, Guint numOffset,
+                    std::vector<Ref> *dupOf, std::map<std::string, Ref> *streams) {
+  XRef *xref = doc->getXRef();
+  int objectsCount = 0;
+  int n;
+
+  // Streams may be referenced from objects with lower numbers, so all
+  // of them are looked up before anything is written
+  Ref noRef = {0, 0};
+  dupOf->resize(yRef->getNumObjects(), noRef);
+  for (n = numOffset; n < yRef->getNumObjects(); n++) {
+    if (yRef->getEntry(n)->type == xrefEntryFree)
+      continue;
+    Object obj, newObj;
+    xref->fetch(n - numOffset, yRef->getEntry(n)->gen, &obj);
+    if (obj.isStream() && obj.getStream()->getKind() != strWeird) {
+      // the stream dict as it would be written, then its encoded data
+      MemOutStream memStr;
+      Object dictObj;
+      remapObject(&obj, &newObj, yRef, numOffset, dupOf);
+      dictObj.initDict(newObj.streamGetDict());
+      PDFDoc::writeObject(&dictObj, &memStr, xref, 0, NULL, cryptRC4, 0, 0, 0);
+      dictObj.free();
+      GooString *buf = memStr.getBuffer();
+      Stream *str = newObj.getStream();
+      int c;
+      str->unfilteredReset();
+      while ((c = str->getUnfilteredChar()) != EOF)
+        buf->append((char) c);
+      str->reset();
+      Guchar digest[16];
+      md5((Guchar *) buf->getCString(), buf->getLength(), digest);
+      std::string key((char *) digest, sizeof(digest));
+      char len[32];
+      sprintf(len, ":%d", buf->getLength());
+      key.append(len);
+      std::map<std::string, Ref>::iterator it = streams->find(key);
+      if (it != streams->end()) {
+        (*dupOf)[n] = it->second;
+        yRef->getEntry(n)->type = xrefEntryFree;
+      } else {
+        Ref ref = {n, yRef->getEntry(n)->gen};
+        (*streams)[key] = ref;
+      }
+      newObj.free();
+    }
+    obj.free();
+  }
+
+  for (n = numOffset; n < yRef->getNumObjects(); n++) {
+    if (yRef->getEntry(n)->type == xrefEntryFree)
+      continue;
+    Object obj, newObj;
+    int gen = yRef->getEntry(n)->gen;
+    xref->fetch(n - numOffset, gen, &obj);
+    remapObject(&obj, &newObj, yRef, numOffset, dupOf);
+    yRef->add(n, gen, outStr->getPos(), gTrue);
+    outStr->printf("%d %d obj\n", n, gen);
+    PDFDoc::writeObject(&newObj, outStr, xref, 0, NULL, cryptRC4, 0, 0, 0);
+    outStr->printf("\nendobj\n");
+    objectsCount++;
+    newObj.free();
+    obj.free();
+  }
+  return objectsCount;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 int main (int argc, char *argv[])
 ///////////////////////////////////////////////////////////////////////////
@@ -203,11 +433,13 @@ int main (int argc, char *argv[])
   exitCode = 0;
   globalParams = new GlobalParams();
 
+  Object intents;
+  Object metadata;
+  Object info;
   for (i = 1; i < argc - 1; i++) {
     GooString *gfileName = new GooString(argv[i]);
     PDFDoc *doc = new PDFDoc(gfileName, NULL, NULL, NULL);
     if (doc->isOk() && !doc->isEncrypted()) {
-      docs.push_back(doc);
       if (doc->getPDFMajorVersion() > majorVersion) {
         majorVersion = doc->getPDFMajorVersion();
         minorVersion = doc->getPDFMinorVersion();
@@ -216,6 +448,21 @@ int main (int argc, char *argv[])
           minorVersion = doc->getPDFMinorVersion();
         }
       }
+      if (!streamMerge) {
+        docs.push_back(doc);
+      } else if (docs.size() == 0) {
+        // only the first file is kept open, for its catalog entries
+        Object catObj;
+        docs.push_back(doc);
+        doc->getXRef()->getCatalog(&catObj);
+        catObj.dictLookup("OutputIntents", &intents);
+        catObj.dictLookupNF("Metadata", &metadata);
+        catObj.free();
+        doc->getXRef()->getDocInfoNF(&info);
+      } else {
+        mergeOutputIntents(&intents, doc);
+        delete doc;
+      }
     } else if (doc->isOk()) {
       error(errUnimplemented, -1, "Could not merge encrypted files ('{0:s}')", argv[i]);
       return -1;
@@ -237,7 +484,6 @@ int main (int argc, char *argv[])
   PDFDoc::writeHeader(outStr, majorVersion, minorVersion);
 
   // handle OutputIntents, AcroForm, OCProperties & Names
-  Object intents;
   Object afObj;
   Object ocObj;
   Object names;
@@ -245,7 +491,8 @@ int main (int argc, char *argv[])
     Object catObj;
     docs[0]->getXRef()->getCatalog(&catObj);
     Dict *catDict = catObj.getDict();
-    catDict->lookup("OutputIntents", &intents);
+    if (!streamMerge)
+      catDict->lookup("OutputIntents", &intents);
     catDict->lookupNF("AcroForm", &afObj);
     Ref *refPage = docs[0]->getCatalog()->getPageRef(1);
     if (!afObj.isNull()) {
@@ -259,62 +506,20 @@ int main (int argc, char *argv[])
     if (!names.isNull() && names.isDict()) {
       docs[0]->markPageObjects(names.getDict(), yRef, countRef, 0, refPage->num, refPage->num);
     }
-    if (intents.isArray() && intents.arrayGetLength() > 0) {
-      for (i = 1; i < (int) docs.size(); i++) {
-        Object pagecatObj, pageintents;
-        docs[i]->getXRef()->getCatalog(&pagecatObj);
-        Dict *pagecatDict = pagecatObj.getDict();
-        pagecatDict->lookup("OutputIntents", &pageintents);
-        if (pageintents.isArray() && pageintents.arrayGetLength() > 0) {
-          for (j = intents.arrayGetLength() - 1; j >= 0; j--) {
-            Object intent;
-            intents.arrayGet(j, &intent, 0);
-            if (intent.isDict()) {
-              Object idf;
-              intent.dictLookup("OutputConditionIdentifier", &idf);
-              if (idf.isString()) {
-                GooString *gidf = idf.getString();
-                GBool removeIntent = gTrue;
-                for (int k = 0; k < pageintents.arrayGetLength(); k++) {
-                  Object pgintent;
-                  pageintents.arrayGet(k, &pgintent, 0);
-                  if (pgintent.isDict()) {
-                    Object pgidf;
-                    pgintent.dictLookup("OutputConditionIdentifier", &pgidf);
-                    if (pgidf.isString()) {
-                      GooString *gpgidf = pgidf.getString();
-                      if (gpgidf->cmp(gidf) == 0) {
-                        pgidf.free();
-                        removeIntent = gFalse;
-                        break;
-                      }
-                    }
-                    pgidf.free();
-                  }
-                }
-                if (removeIntent) {
-                  intents.arrayRemove(j);
-                  error(errSyntaxWarning, -1, "Output intent {0:s} missing in pdf {1:s}, removed",
-                   gidf->getCString(), docs[i]->getFileName()->getCString());
-                }
-              } else {
-                intents.arrayRemove(j);
-                error(errSyntaxWarning, -1, "Invalid output intent dict, missing required OutputConditionIdentifier");
-              }
-              idf.free();
-            } else {
-              intents.arrayRemove(j);
-            }
-            intent.free();
-          }
-        } else {
-          error(errSyntaxWarning, -1, "Output intents differs, remove them all");
-          intents.free();
-          break;
-        }
-        pagecatObj.free();
-        pageintents.free();
-      }
+    // a stream merge keeps the XMP metadata and the document info of the
+    // first file, so that the parts of a PDF/A document merge into one
+    if (streamMerge && (metadata.isRef() || info.isRef())) {
+      Object docObjs, obj;
+      docObjs.initDict(docs[0]->getXRef());
+      if (metadata.isRef())
+        docObjs.dictAdd(copyString("Metadata"), metadata.copy(&obj));
+      if (info.isRef())
+        docObjs.dictAdd(copyString("Info"), info.copy(&obj));
+      docs[0]->markPageObjects(docObjs.getDict(), yRef, countRef, 0, refPage->num, refPage->num);
+      docObjs.free();
+    }
+    for (i = 1; i < (int) docs.size(); i++) {
+      mergeOutputIntents(&intents, docs[i]);
     }
     if (intents.isArray() && intents.arrayGetLength() > 0) {
       for (j = intents.arrayGetLength() - 1; j >= 0; j--) {
@@ -331,37 +536,64 @@ int main (int argc, char *argv[])
     catObj.free();
   }
 
-  for (i = 0; i < (int) docs.size(); i++) {
-    for (j = 1; j <= docs[i]->getNumPages(); j++) {
+  // In stream merge the pages are written along with their file, so the
+  // number of their parent is taken beyond the objects of the first file
+  int pagesNum = 0;
+  std::vector<int> pageNums;
+  std::vector<Ref> dupOf;
+  std::map<std::string, Ref> streams;
+  if (streamMerge && docs.size() >= 1) {
+    pagesNum = docs[0]->getXRef()->getNumObjects();
+    yRef->add(pagesNum, 0, 0, gFalse);
+  }
+
+  int numDocs = streamMerge ? argc - 2 : (int) docs.size();
+  for (i = 0; i < numDocs; i++) {
+    PDFDoc *doc;
+    std::vector<Object> docPages;
+    if (!streamMerge || i == 0) {
+      doc = docs[i];
+    } else {
+      doc = new PDFDoc(new GooString(argv[i + 1]), NULL, NULL, NULL);
+      if (!doc->isOk()) {
+        error(errSyntaxError, -1, "Could not merge damaged documents ('{0:s}')", argv[i + 1]);
+        return -1;
+      }
+    }
+    for (j = 1; j <= doc->getNumPages(); j++) {
       PDFRectangle *cropBox = NULL;
-      if (docs[i]->getCatalog()->getPage(j)->isCropped())
-        cropBox = docs[i]->getCatalog()->getPage(j)->getCropBox();
-      docs[i]->replacePageDict(j,
-	    docs[i]->getCatalog()->getPage(j)->getRotate(),
-	    docs[i]->getCatalog()->getPage(j)->getMediaBox(), cropBox);
-      Ref *refPage = docs[i]->getCatalog()->getPageRef(j);
+      if (doc->getCatalog()->getPage(j)->isCropped())
+        cropBox = doc->getCatalog()->getPage(j)->getCropBox();
+      doc->replacePageDict(j,
+	    doc->getCatalog()->getPage(j)->getRotate(),
+	    doc->getCatalog()->getPage(j)->getMediaBox(), cropBox);
+      Ref *refPage = doc->getCatalog()->getPageRef(j);
       Object page;
-      docs[i]->getXRef()->fetch(refPage->num, refPage->gen, &page);
+      doc->getXRef()->fetch(refPage->num, refPage->gen, &page);
       Dict *pageDict = page.getDict();
-      Dict *resDict = docs[i]->getCatalog()->getPage(j)->getResourceDict();
+      Dict *resDict = doc->getCatalog()->getPage(j)->getResourceDict();
       if (resDict) {
         Object *newResource = new Object();
         newResource->initDict(resDict);
         pageDict->set("Resources", newResource);
         delete newResource;
       }
-      pages.push_back(page);
-      offsets.push_back(numOffset);
-      docs[i]->markPageObjects(pageDict, yRef, countRef, numOffset, refPage->num, refPage->num);
+      if (streamMerge) {
+        docPages.push_back(page);
+      } else {
+        pages.push_back(page);
+        offsets.push_back(numOffset);
+      }
+      doc->markPageObjects(pageDict, yRef, countRef, numOffset, refPage->num, refPage->num);
       Object annotsObj;
       pageDict->lookupNF("Annots", &annotsObj);
       if (!annotsObj.isNull()) {
-        docs[i]->markAnnotations(&annotsObj, yRef, countRef, numOffset, refPage->num, refPage->num);
+        doc->markAnnotations(&annotsObj, yRef, countRef, numOffset, refPage->num, refPage->num);
         annotsObj.free();
       }
     }
     Object pageCatObj, pageNames;
-    docs[i]->getXRef()->getCatalog(&pageCatObj);
+    doc->getXRef()->getCatalog(&pageCatObj);
     Dict *pageCatDict = pageCatObj.getDict();
     pageCatDict->lookup("Names", &pageNames);
     if (!pageNames.isNull() && pageNames.isDict()) {
@@ -369,18 +601,63 @@ int main (int argc, char *argv[])
         names.free();
         names.initDict(yRef);
       }
-      doMergeNameDict(docs[i], yRef, countRef, 0, 0, names.getDict(), pageNames.getDict(), numOffset);
+      doMergeNameDict(doc, yRef, countRef, 0, 0, names.getDict(), pageNames.getDict(), numOffset);
     }
     pageNames.free();
     pageCatObj.free();
-    objectsCount += docs[i]->writePageObjects(outStr, yRef, numOffset, gTrue);
+    if (!streamMerge) {
+      objectsCount += doc->writePageObjects(outStr, yRef, numOffset, gTrue);
+    } else {
+      objectsCount += writeDocObjects(doc, outStr, yRef, numOffset, &dupOf, &streams);
+      for (j = 0; j < (int) docPages.size(); j++) {
+        int pageNum = yRef->getNumObjects();
+        yRef->add(pageNum, 0, outStr->getPos(), gTrue);
+        outStr->printf("%d 0 obj\n", pageNum);
+        outStr->printf("<< ");
+        Dict *pageDict = docPages[j].getDict();
+        for (int k = 0; k < pageDict->getLength(); k++) {
+          if (k > 0)
+            outStr->printf(" ");
+          const char *key = pageDict->getKey(k);
+          Object value;
+          pageDict->getValNF(k, &value);
+          if (strcmp(key, "Parent") == 0) {
+            outStr->printf("/Parent %d 0 R", pagesNum);
+          } else {
+            Object newValue;
+            remapObject(&value, &newValue, yRef, numOffset, &dupOf);
+            outStr->printf("/%s ", key);
+            PDFDoc::writeObject(&newValue, outStr, yRef, 0, NULL, cryptRC4, 0, 0, 0);
+            newValue.free();
+          }
+          value.free();
+        }
+        outStr->printf(" >>\nendobj\n");
+        objectsCount++;
+        pageNums.push_back(pageNum);
+        docPages[j].free();
+      }
+      if (i > 0)
+        delete doc;
+    }
     numOffset = yRef->getNumObjects() + 1;
   }
 
+  // the catalog entries of the first file may point to dropped streams too
+  if (streamMerge) {
+    Object *catalogObjs[] = { &intents, &afObj, &ocObj, &names, &metadata, &info };
+    for (i = 0; i < (int) (sizeof(catalogObjs) / sizeof(catalogObjs[0])); i++) {
+      Object newObj;
+      remapObject(catalogObjs[i], &newObj, docs[0]->getXRef(), 0, &dupOf);
+      catalogObjs[i]->free();
+      *catalogObjs[i] = newObj;
+    }
+  }
+
   rootNum = yRef->getNumObjects() + 1;
   yRef->add(rootNum, 0, outStr->getPos(), gTrue);
   outStr->printf("%d 0 obj\n", rootNum);
-  outStr->printf("<< /Type /Catalog /Pages %d 0 R", rootNum + 1);
+  outStr->printf("<< /Type /Catalog /Pages %d 0 R", streamMerge ? pagesNum : rootNum + 1);
   // insert OutputIntents
   if (intents.isArray() && intents.arrayGetLength() > 0) {
     outStr->printf(" /OutputIntents [");
@@ -413,16 +690,32 @@ int main (int argc, char *argv[])
     PDFDoc::writeObject(&names, outStr, yRef, 0, NULL, cryptRC4, 0, 0, 0);
     names.free();
   }
+  // insert Metadata
+  if (metadata.isRef()) {
+    outStr->printf(" /Metadata ");
+    PDFDoc::writeObject(&metadata, outStr, yRef, 0, NULL, cryptRC4, 0, 0, 0);
+  }
+  metadata.free();
   outStr->printf(">>\nendobj\n");
   objectsCount++;
 
-  yRef->add(rootNum + 1, 0, outStr->getPos(), gTrue);
-  outStr->printf("%d 0 obj\n", rootNum + 1);
-  outStr->printf("<< /Type /Pages /Kids [");
-  for (j = 0; j < (int) pages.size(); j++)
-    outStr->printf(" %d 0 R", rootNum + j + 2);
-  outStr->printf(" ] /Count %zd >>\nendobj\n", pages.size());
-  objectsCount++;
+  if (streamMerge) {
+    yRef->add(pagesNum, 0, outStr->getPos(), gTrue);
+    outStr->printf("%d 0 obj\n", pagesNum);
+    outStr->printf("<< /Type /Pages /Kids [");
+    for (j = 0; j < (int) pageNums.size(); j++)
+      outStr->printf(" %d 0 R", pageNums[j]);
+    outStr->printf(" ] /Count %zd >>\nendobj\n", pageNums.size());
+    objectsCount++;
+  } else {
+    yRef->add(rootNum + 1, 0, outStr->getPos(), gTrue);
+    outStr->printf("%d 0 obj\n", rootNum + 1);
+    outStr->printf("<< /Type /Pages /Kids [");
+    for (j = 0; j < (int) pages.size(); j++)
+      outStr->printf(" %d 0 R", rootNum + j + 2);
+    outStr->printf(" ] /Count %zd >>\nendobj\n", pages.size());
+    objectsCount++;
+  }
 
   for (i = 0; i < (int) pages.size(); i++) {
     yRef->add(rootNum + i + 2, 0, outStr->getPos(), gTrue);
@@ -450,8 +743,14 @@ int main (int argc, char *argv[])
   Ref ref;
   ref.num = rootNum;
   ref.gen = 0;
+  // dropped streams leave holes in the numbering of a stream merge
+  if (streamMerge)
+    objectsCount = yRef->getNumObjects();
   Dict *trailerDict = PDFDoc::createTrailerDict(objectsCount, gFalse, 0, &ref, yRef,
                                                 fileName, outStr->getPos());
+  if (info.isRef())
+    trailerDict->set("Info", &info);
+  info.free();
   PDFDoc::writeXRefTableTrailer(trailerDict, yRef, gTrue, // write all entries according to ISO 32000-1, 7.5.4 Cross-Reference Table: "For a file that has never been incrementally updated, the cross-reference section shall contain only one subsection, whose object numbering begins at 0."
                                 uxrefOffset, outStr, yRef);
   delete trailerDict;
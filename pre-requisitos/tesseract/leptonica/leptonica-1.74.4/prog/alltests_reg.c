@@ -36,6 +36,8 @@
  *        <command> == "compare" to make local files and compare with
  *                     the golden files
  *        <command> == "display" to make local files and display
+ *        <command> == "time" to make local files and write the timings
+ *                     of the timed operations to /tmp/lept/regout
  *
  *    You can also run each test individually with any one of these
  *    arguments.  Warning: if you run this with "display", a very
@@ -60,6 +62,7 @@ static const char *tests[] = {
                               "blend3_reg",
                               "blend4_reg",
                               "boxa1_reg",
+                              "ccittio_reg",
                               "ccthin1_reg",
                               "ccthin2_reg",
                               "cmapquant_reg",
@@ -89,6 +92,7 @@ static const char *tests[] = {
                               "findpattern_reg",
                               "fpix1_reg",
                               "fpix2_reg",
+                              "g4enc_reg",
                               "genfonts_reg",
 #if HAVE_LIBGIF
                               "gifio_reg",
@@ -100,9 +104,11 @@ static const char *tests[] = {
                               "insert_reg",
                               "ioformats_reg",
                               "jbclass_reg",
+                              "jbig2enc_reg",
 #if HAVE_LIBJP2K
                               "jp2kio_reg",
 #endif  /* HAVE_LIBJP2K */
+                              "jpegband_reg",
                               "jpegio_reg",
                               "kernel_reg",
                               "label_reg",
@@ -146,6 +152,7 @@ static const char *tests[] = {
                               "subpixel_reg",
                               "texturefill_reg",
                               "threshnorm_reg",
+                              "tiffindex_reg",
                               "translate_reg",
                               "warper_reg",
 #if HAVE_LIBWEBP
@@ -169,8 +176,9 @@ SARRAY      *sa;
 static char  mainName[] = "alltests_reg";
 
     if (argc != 2)
-        return ERROR_INT(" Syntax alltests_reg [generate | compare | display]",
-                         mainName, 1);
+        return ERROR_INT(
+            " Syntax alltests_reg [generate | compare | display | time]",
+            mainName, 1);
 
     l_getCurrentTime(&start, NULL);
     ntests = sizeof(tests) / sizeof(char *);
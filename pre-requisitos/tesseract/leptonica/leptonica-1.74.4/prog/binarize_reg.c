@@ -62,8 +62,15 @@ L_REGPARAMS  *rp;
     pixDestroy(&pixt2);
 
         /* Do combination of contrast norm and sauvola */
-    pixt1 = pixContrastNorm(NULL, pixs, 100, 100, 55, 1, 1);
-    pixSauvolaBinarizeTiled(pixt1, 8, 0.34, 1, 1, NULL, &pixt2);
+    pixt1 = pixt2 = NULL;
+    while (regTestTimeLoop(rp, "pixContrastNorm", pixs)) {
+        pixDestroy(&pixt1);
+        pixt1 = pixContrastNorm(NULL, pixs, 100, 100, 55, 1, 1);
+    }
+    while (regTestTimeLoop(rp, "pixSauvolaBinarizeTiled 8 0.34", pixt1)) {
+        pixDestroy(&pixt2);
+        pixSauvolaBinarizeTiled(pixt1, 8, 0.34, 1, 1, NULL, &pixt2);
+    }
     regTestWritePixAndCheck(rp, pixt1, IFF_PNG);
     regTestWritePixAndCheck(rp, pixt2, IFF_PNG);
     pixDisplayWithTitle(pixt1, 100, 500, NULL, rp->display);
@@ -82,18 +89,18 @@ PixTest1(PIX          *pixs,
          l_float32     factor,
          L_REGPARAMS  *rp)
 {
-l_int32  w, h;
-PIX     *pixm, *pixsd, *pixth, *pixd, *pixt;
-PIXA    *pixa;
+char   buf[64];
+PIX   *pixm, *pixsd, *pixth, *pixd, *pixt;
+PIXA  *pixa;
 
     pixm = pixsd = pixth = pixd = NULL;
-    pixGetDimensions(pixs, &w, &h, NULL);
 
         /* Get speed */
-    startTimer();
-    pixSauvolaBinarize(pixs, size, factor, 1, NULL, NULL, NULL, &pixd);
-    fprintf(stderr, "\nSpeed: 1 tile,  %7.3f Mpix/sec\n",
-            (w * h / 1000000.) / stopTimer());
+    snprintf(buf, sizeof(buf), "pixSauvolaBinarize %d %4.2f", size, factor);
+    while (regTestTimeLoop(rp, buf, pixs)) {
+        pixDestroy(&pixd);
+        pixSauvolaBinarize(pixs, size, factor, 1, NULL, NULL, NULL, &pixd);
+    }
     pixDestroy(&pixd);
 
         /* Get results */
@@ -126,18 +133,19 @@ PixTest2(PIX          *pixs,
          l_int32       ny,
          L_REGPARAMS  *rp)
 {
-l_int32  w, h;
-PIX     *pixth, *pixd, *pixt;
-PIXA    *pixa;
+char   buf[64];
+PIX   *pixth, *pixd, *pixt;
+PIXA  *pixa;
 
     pixth = pixd = NULL;
-    pixGetDimensions(pixs, &w, &h, NULL);
 
         /* Get speed */
-    startTimer();
-    pixSauvolaBinarizeTiled(pixs, size, factor, nx, ny, NULL, &pixd);
-    fprintf(stderr, "Speed: %d x %d tiles,  %7.3f Mpix/sec\n",
-            nx, ny, (w * h / 1000000.) / stopTimer());
+    snprintf(buf, sizeof(buf), "pixSauvolaBinarizeTiled %d %4.2f %d x %d",
+             size, factor, nx, ny);
+    while (regTestTimeLoop(rp, buf, pixs)) {
+        pixDestroy(&pixd);
+        pixSauvolaBinarizeTiled(pixs, size, factor, nx, ny, NULL, &pixd);
+    }
     pixDestroy(&pixd);
 
         /* Get results */
@@ -0,0 +1,334 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   ccittio_reg.c
+ *
+ *    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *    This is a Leptonica regression test for ccitt decoding
+ *    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *
+ *    This decodes raw g4 and g3 data with pixReadMemCcitt(), which
+ *    must give back the coded image.
+ *
+ *    The g4 data is made by g4EncodePix().  Leptonica has no g3
+ *    encoder, so the g3 data is made here: the rows are coded with
+ *    the one-dimensional (modified Huffman) code, with or without an
+ *    EOL code before each row and with or without byte alignment.
+ *    For mixed one- and two-dimensional coding (K > 0), a row that
+ *    repeats the row above is coded in two dimensions, as one V0 code
+ *    for each changing pixel and one for the end of the row.
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+    /* A code of the T.4 tables: the bits are the low len bits of code */
+typedef struct {
+    l_uint16  code;
+    l_uint16  len;
+} L_T4_CODE;
+
+static const L_T4_CODE  WhiteTermCodes[64] = {
+    {0x0035,  8}, {0x0007,  6}, {0x0007,  4}, {0x0008,  4},
+    {0x000b,  4}, {0x000c,  4}, {0x000e,  4}, {0x000f,  4},
+    {0x0013,  5}, {0x0014,  5}, {0x0007,  5}, {0x0008,  5},
+    {0x0008,  6}, {0x0003,  6}, {0x0034,  6}, {0x0035,  6},
+    {0x002a,  6}, {0x002b,  6}, {0x0027,  7}, {0x000c,  7},
+    {0x0008,  7}, {0x0017,  7}, {0x0003,  7}, {0x0004,  7},
+    {0x0028,  7}, {0x002b,  7}, {0x0013,  7}, {0x0024,  7},
+    {0x0018,  7}, {0x0002,  8}, {0x0003,  8}, {0x001a,  8},
+    {0x001b,  8}, {0x0012,  8}, {0x0013,  8}, {0x0014,  8},
+    {0x0015,  8}, {0x0016,  8}, {0x0017,  8}, {0x0028,  8},
+    {0x0029,  8}, {0x002a,  8}, {0x002b,  8}, {0x002c,  8},
+    {0x002d,  8}, {0x0004,  8}, {0x0005,  8}, {0x000a,  8},
+    {0x000b,  8}, {0x0052,  8}, {0x0053,  8}, {0x0054,  8},
+    {0x0055,  8}, {0x0024,  8}, {0x0025,  8}, {0x0058,  8},
+    {0x0059,  8}, {0x005a,  8}, {0x005b,  8}, {0x004a,  8},
+    {0x004b,  8}, {0x0032,  8}, {0x0033,  8}, {0x0034,  8}
+};
+static const L_T4_CODE  WhiteMakeupCodes[27] = {
+    {0x001b,  5}, {0x0012,  5}, {0x0017,  6}, {0x0037,  7},
+    {0x0036,  8}, {0x0037,  8}, {0x0064,  8}, {0x0065,  8},
+    {0x0068,  8}, {0x0067,  8}, {0x00cc,  9}, {0x00cd,  9},
+    {0x00d2,  9}, {0x00d3,  9}, {0x00d4,  9}, {0x00d5,  9},
+    {0x00d6,  9}, {0x00d7,  9}, {0x00d8,  9}, {0x00d9,  9},
+    {0x00da,  9}, {0x00db,  9}, {0x0098,  9}, {0x0099,  9},
+    {0x009a,  9}, {0x0018,  6}, {0x009b,  9}
+};
+static const L_T4_CODE  BlackTermCodes[64] = {
+    {0x0037, 10}, {0x0002,  3}, {0x0003,  2}, {0x0002,  2},
+    {0x0003,  3}, {0x0003,  4}, {0x0002,  4}, {0x0003,  5},
+    {0x0005,  6}, {0x0004,  6}, {0x0004,  7}, {0x0005,  7},
+    {0x0007,  7}, {0x0004,  8}, {0x0007,  8}, {0x0018,  9},
+    {0x0017, 10}, {0x0018, 10}, {0x0008, 10}, {0x0067, 11},
+    {0x0068, 11}, {0x006c, 11}, {0x0037, 11}, {0x0028, 11},
+    {0x0017, 11}, {0x0018, 11}, {0x00ca, 12}, {0x00cb, 12},
+    {0x00cc, 12}, {0x00cd, 12}, {0x0068, 12}, {0x0069, 12},
+    {0x006a, 12}, {0x006b, 12}, {0x00d2, 12}, {0x00d3, 12},
+    {0x00d4, 12}, {0x00d5, 12}, {0x00d6, 12}, {0x00d7, 12},
+    {0x006c, 12}, {0x006d, 12}, {0x00da, 12}, {0x00db, 12},
+    {0x0054, 12}, {0x0055, 12}, {0x0056, 12}, {0x0057, 12},
+    {0x0064, 12}, {0x0065, 12}, {0x0052, 12}, {0x0053, 12},
+    {0x0024, 12}, {0x0037, 12}, {0x0038, 12}, {0x0027, 12},
+    {0x0028, 12}, {0x0058, 12}, {0x0059, 12}, {0x002b, 12},
+    {0x002c, 12}, {0x005a, 12}, {0x0066, 12}, {0x0067, 12}
+};
+static const L_T4_CODE  BlackMakeupCodes[27] = {
+    {0x000f, 10}, {0x00c8, 12}, {0x00c9, 12}, {0x005b, 12},
+    {0x0033, 12}, {0x0034, 12}, {0x0035, 12}, {0x006c, 13},
+    {0x006d, 13}, {0x004a, 13}, {0x004b, 13}, {0x004c, 13},
+    {0x004d, 13}, {0x0072, 13}, {0x0073, 13}, {0x0074, 13},
+    {0x0075, 13}, {0x0076, 13}, {0x0077, 13}, {0x0052, 13},
+    {0x0053, 13}, {0x0054, 13}, {0x0055, 13}, {0x005a, 13},
+    {0x005b, 13}, {0x0064, 13}, {0x0065, 13}
+};
+static const L_T4_CODE  ExtMakeupCodes[13] = {
+    {0x0008, 11}, {0x000c, 11}, {0x000d, 11}, {0x0012, 12},
+    {0x0013, 12}, {0x0014, 12}, {0x0015, 12}, {0x0016, 12},
+    {0x0017, 12}, {0x001c, 12}, {0x001d, 12}, {0x001e, 12},
+    {0x001f, 12}
+};
+
+    /* Coded bits, from the msb of each byte */
+typedef struct {
+    l_uint8  *data;
+    size_t    nbits;
+} L_BIT_WRITER;
+
+static l_uint8 *G3EncodePix(PIX *pixs, l_int32 k, l_int32 eol,
+                            l_int32 bytealign, l_int32 rtc, size_t *psize);
+static void PutRun(L_BIT_WRITER *wr, l_int32 run, l_int32 color);
+static void PutBits(L_BIT_WRITER *wr, l_uint32 code, l_int32 len);
+static void DoG3Test(L_REGPARAMS *rp, PIX *pixs, l_int32 k);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, w, h;
+size_t        size;
+l_uint8      *data;
+PIX          *pixs, *pix1, *pix2;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+        /* g4 */
+    pixs = pixRead("test1.png");
+    pixGetDimensions(pixs, &w, &h, NULL);
+    g4EncodePix(pixs, &data, &size);
+    pix1 = pixReadMemCcitt(data, size, w, h, -1, 0);
+    regTestComparePix(rp, pixs, pix1);  /* 0 */
+    pixDestroy(&pix1);
+
+        /* Data that ends too soon is an error */
+    setMsgSeverity(L_SEVERITY_NONE);
+    pix1 = pixReadMemCcitt(data, size / 2, w, h, -1, 0);
+    setMsgSeverity(L_SEVERITY_INFO);
+    regTestCompareValues(rp, 1, pix1 == NULL, 0);  /* 1 */
+    pixDestroy(&pix1);
+    lept_free(data);
+
+        /* One-dimensional g3 */
+    DoG3Test(rp, pixs, 0);  /* 2 - 6 */
+
+        /* Mixed g3, where every other row repeats the one above it */
+    pix1 = pixScaleBySampling(pixs, 1.0, 2.0);
+    DoG3Test(rp, pix1, 4);  /* 7 - 11 */
+    pixDestroy(&pixs);
+    pixDestroy(&pix1);
+
+        /* Long runs, which take the makeup codes, and runs of 0 and 1 */
+    pixs = pixCreate(5300, 8, 1);
+    pixRasterop(pixs, 0, 1, 5300, 1, PIX_SET, NULL, 0, 0);
+    pixRasterop(pixs, 63, 2, 1728, 1, PIX_SET, NULL, 0, 0);
+    pixRasterop(pixs, 1791, 2, 1792, 1, PIX_SET, NULL, 0, 0);
+    pixRasterop(pixs, 0, 3, 2560, 1, PIX_SET, NULL, 0, 0);
+    pixRasterop(pixs, 2624, 3, 2676, 1, PIX_SET, NULL, 0, 0);
+    pixRasterop(pixs, 64, 4, 1, 1, PIX_SET, NULL, 0, 0);
+    pixRasterop(pixs, 66, 4, 5234, 1, PIX_SET, NULL, 0, 0);
+    for (i = 0; i < 5300; i += 2)
+        pixSetPixel(pixs, i + 1, 5, 1);
+    pixRasterop(pixs, 0, 6, 5300, 2, PIX_SRC, pixs, 0, 4);
+    DoG3Test(rp, pixs, 0);  /* 12 - 16 */
+    DoG3Test(rp, pixs, 2);  /* 17 - 21 */
+    pixDestroy(&pixs);
+
+        /* A k of 1 has no two-dimensional rows */
+    pixs = pixRead("rabi.png");
+    pix1 = pixScaleToGray(pixs, 0.5);
+    pix2 = pixThresholdToBinary(pix1, 128);
+    DoG3Test(rp, pix2, 1);  /* 22 - 26 */
+    pixDestroy(&pixs);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+
+    return regTestCleanup(rp);
+}
+
+
+    /* Decodes pixs coded with each of the g3 options */
+static void
+DoG3Test(L_REGPARAMS  *rp,
+         PIX          *pixs,
+         l_int32       k)
+{
+l_int32   w, h, eol, bytealign;
+size_t    size;
+l_uint8  *data;
+PIX      *pix1;
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    for (eol = 0; eol < 2; eol++) {
+        for (bytealign = 0; bytealign < 2; bytealign++) {
+            data = G3EncodePix(pixs, k, eol, bytealign, 0, &size);
+            pix1 = pixReadMemCcitt(data, size, w, h, k, bytealign);
+            regTestComparePix(rp, pixs, pix1);
+            pixDestroy(&pix1);
+            lept_free(data);
+        }
+    }
+
+        /* With the RTC (6 EOL) at the end */
+    data = G3EncodePix(pixs, k, 1, 0, 1, &size);
+    pix1 = pixReadMemCcitt(data, size, w, h, k, 0);
+    regTestComparePix(rp, pixs, pix1);
+    pixDestroy(&pix1);
+    lept_free(data);
+    return;
+}
+
+
+    /* Returns the g3 data of pixs, coded with the parameters of the
+     * CCITTFaxDecode filter (K, EndOfLine, EncodedByteAlign), and
+     * with the RTC if %rtc. */
+static l_uint8 *
+G3EncodePix(PIX      *pixs,
+            l_int32   k,
+            l_int32   eol,
+            l_int32   bytealign,
+            l_int32   rtc,
+            size_t   *psize)
+{
+l_int32        w, h, i, j, wpl, x, color, nchanges, twod;
+l_uint32      *line;
+L_BIT_WRITER   wr;
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    wpl = pixGetWpl(pixs);
+        /* At most 6 bits a pixel (white runs of 1), and 20 bits a row
+         * for the fill bits, EOL and tag bit */
+    wr.data = (l_uint8 *)LEPT_CALLOC((size_t)(w + 4) * h + 64, 1);
+    wr.nbits = 0;
+    for (i = 0; i < h; i++) {
+        line = pixGetData(pixs) + i * wpl;
+        twod = k > 0 && i % k != 0 &&
+               memcmp(line, line - wpl, 4 * wpl) == 0;
+        if (bytealign) {
+                /* Fill bits before the EOL, or before the row */
+            while ((wr.nbits + (eol ? 12 : 0)) % 8 != 0)
+                PutBits(&wr, 0, 1);
+        }
+        if (eol)
+            PutBits(&wr, 0x001, 12);
+        if (k > 0)
+            PutBits(&wr, !twod, 1);
+        if (twod) {
+                /* V0 for each change, then V0 to the end of the row */
+            nchanges = 0;
+            for (j = 1; j < w; j++) {
+                if (GET_DATA_BIT(line, j) != GET_DATA_BIT(line, j - 1))
+                    nchanges++;
+            }
+            nchanges += GET_DATA_BIT(line, 0);
+            for (j = 0; j <= nchanges; j++)
+                PutBits(&wr, 0x1, 1);
+            continue;
+        }
+        x = 0;
+        color = 0;
+        while (x < w) {
+            for (j = x; j < w && GET_DATA_BIT(line, j) == color; j++)
+                ;
+            PutRun(&wr, j - x, color);
+            x = j;
+            color = 1 - color;
+        }
+    }
+    if (rtc) {
+        for (i = 0; i < 6; i++) {
+            PutBits(&wr, 0x001, 12);
+            if (k > 0)
+                PutBits(&wr, 1, 1);
+        }
+    }
+    *psize = (wr.nbits + 7) / 8;
+    return wr.data;
+}
+
+
+static void
+PutRun(L_BIT_WRITER  *wr,
+       l_int32        run,
+       l_int32        color)
+{
+l_int32           m;
+const L_T4_CODE  *code;
+
+    while (run >= 2624) {
+        PutBits(wr, ExtMakeupCodes[12].code, ExtMakeupCodes[12].len);
+        run -= 2560;
+    }
+    if (run >= 64) {
+        m = run / 64;
+        if (m > 27)
+            code = &ExtMakeupCodes[m - 28];
+        else if (color == 0)
+            code = &WhiteMakeupCodes[m - 1];
+        else
+            code = &BlackMakeupCodes[m - 1];
+        PutBits(wr, code->code, code->len);
+        run -= 64 * m;
+    }
+    code = (color == 0) ? &WhiteTermCodes[run] : &BlackTermCodes[run];
+    PutBits(wr, code->code, code->len);
+}
+
+
+static void
+PutBits(L_BIT_WRITER  *wr,
+        l_uint32       code,
+        l_int32        len)
+{
+l_int32  i;
+
+    for (i = len - 1; i >= 0; i--, wr->nbits++) {
+        if ((code >> i) & 1)
+            wr->data[wr->nbits / 8] |= 0x80 >> (wr->nbits % 8);
+    }
+}
@@ -58,11 +58,21 @@ L_REGPARAMS  *rp;
      *            with output to both boxa and pixa                    *
      * --------------------------------------------------------------- */
         /* First, test with 4-cc */
-    boxa1= pixConnComp(pixs, &pixa1, 4);
+    boxa1 = boxa2 = NULL;
+    pixa1 = NULL;
+    while (regTestTimeLoop(rp, "pixConnComp 4 pixa", pixs)) {
+        boxaDestroy(&boxa1);
+        pixaDestroy(&pixa1);
+        boxa1 = pixConnComp(pixs, &pixa1, 4);
+    }
     n1 = boxaGetCount(boxa1);
-    boxa2= pixConnComp(pixs, NULL, 4);
+    while (regTestTimeLoop(rp, "pixConnComp 4 boxa", pixs)) {
+        boxaDestroy(&boxa2);
+        boxa2 = pixConnComp(pixs, NULL, 4);
+    }
     n2 = boxaGetCount(boxa2);
-    pixCountConnComp(pixs, 4, &n3);
+    while (regTestTimeLoop(rp, "pixCountConnComp 4", pixs))
+        pixCountConnComp(pixs, 4, &n3);
     fprintf(stderr, "Number of 4 c.c.:  n1 = %d; n2 = %d, n3 = %d\n",
             n1, n2, n3);
     regTestCompareValues(rp, n1, n2, 0);  /* 0 */
@@ -77,11 +87,21 @@ L_REGPARAMS  *rp;
     pixDestroy(&pix1);
 
         /* Test with 8-cc */
-    boxa1= pixConnComp(pixs, &pixa1, 8);
+    boxa1 = boxa2 = NULL;
+    pixa1 = NULL;
+    while (regTestTimeLoop(rp, "pixConnComp 8 pixa", pixs)) {
+        boxaDestroy(&boxa1);
+        pixaDestroy(&pixa1);
+        boxa1 = pixConnComp(pixs, &pixa1, 8);
+    }
     n1 = boxaGetCount(boxa1);
-    boxa2= pixConnComp(pixs, NULL, 8);
+    while (regTestTimeLoop(rp, "pixConnComp 8 boxa", pixs)) {
+        boxaDestroy(&boxa2);
+        boxa2 = pixConnComp(pixs, NULL, 8);
+    }
     n2 = boxaGetCount(boxa2);
-    pixCountConnComp(pixs, 8, &n3);
+    while (regTestTimeLoop(rp, "pixCountConnComp 8", pixs))
+        pixCountConnComp(pixs, 8, &n3);
     fprintf(stderr, "Number of 8 c.c.:  n1 = %d; n2 = %d, n3 = %d\n",
             n1, n2, n3);
     regTestCompareValues(rp, n1, n2, 0);  /* 5 */
@@ -0,0 +1,148 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   g4enc_reg.c
+ *
+ *    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *    This is a Leptonica regression test for g4 encoding
+ *    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *
+ *    This codes 1 bpp images with g4EncodePix() and decodes them
+ *    with pixReadMemCcitt(), which must give back the same image.
+ *
+ *    Images of at least 512 rows are coded in bands on separate
+ *    threads.  Each image is coded on one thread and then on several,
+ *    and the two must give the same bytes.  Without openmp there is
+ *    only one band, and this is the same as the plain round trip.
+ */
+
+#include "allheaders.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
+
+static void DoG4Test(L_REGPARAMS *rp, PIX *pixs, l_int32 nthreads);
+static void SetThreads(l_int32 nthreads);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j;
+BOX          *box;
+PIX          *pixs, *pix1;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+        /* Blank, black and one pixel wide images */
+    pixs = pixCreate(100, 50, 1);
+    DoG4Test(rp, pixs, 1);
+    pixSetAll(pixs);
+    DoG4Test(rp, pixs, 1);
+    pixDestroy(&pixs);
+    pixs = pixCreate(1, 20, 1);
+    for (i = 0; i < 20; i += 3)
+        pixSetPixel(pixs, 0, i, 1);
+    DoG4Test(rp, pixs, 1);
+    pixDestroy(&pixs);
+
+        /* Runs that end at and next to the word boundaries, and
+         * changes in every pixel */
+    pixs = pixCreate(97, 64, 1);
+    for (i = 0; i < 64; i++) {
+        for (j = 0; j < 97; j++) {
+            if ((i < 32 && j >= i && j < 97 - i) || (i >= 32 && (i + j) % 2))
+                pixSetPixel(pixs, j, i, 1);
+        }
+    }
+    DoG4Test(rp, pixs, 1);
+    pixDestroy(&pixs);
+
+        /* A page of text, in one band and in several */
+    pixs = pixRead("test1.png");
+    DoG4Test(rp, pixs, 1);
+    pixDestroy(&pixs);
+    pixs = pixRead("rabi.png");
+    DoG4Test(rp, pixs, 4);
+    pixDestroy(&pixs);
+
+        /* Three bands, starting at rows 0, 257 and 514; the second
+         * one is coded against a black row */
+    pixs = pixRead("rabi.png");
+    box = boxCreate(0, 1000, 2528, 771);
+    pix1 = pixClipRectangle(pixs, box, NULL);
+    pixRenderLine(pix1, 0, 256, 2527, 256, 1, L_SET_PIXELS);
+    pixSetPixel(pix1, 100, 257, 1);
+    DoG4Test(rp, pix1, 3);
+    boxDestroy(&box);
+    pixDestroy(&pixs);
+    pixDestroy(&pix1);
+
+    return regTestCleanup(rp);
+}
+
+
+static void
+DoG4Test(L_REGPARAMS  *rp,
+         PIX          *pixs,
+         l_int32       nthreads)
+{
+l_int32   w, h;
+size_t    size1, size2;
+l_uint8  *data1, *data2;
+PIX      *pix1, *pix2;
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    SetThreads(1);
+    g4EncodePix(pixs, &data1, &size1);
+    pix1 = pixReadMemCcitt(data1, size1, w, h, -1, 0);
+    regTestComparePix(rp, pixs, pix1);
+    SetThreads(nthreads);
+    g4EncodePix(pixs, &data2, &size2);
+    regTestCompareStrings(rp, data1, size1, data2, size2);
+    pix2 = pixReadMemCcitt(data2, size2, w, h, -1, 0);
+    regTestComparePix(rp, pixs, pix2);
+    SetThreads(1);
+
+    lept_free(data1);
+    lept_free(data2);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    return;
+}
+
+
+static void
+SetThreads(l_int32  nthreads)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif  /* _OPENMP */
+}
@@ -0,0 +1,460 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   jbig2enc_reg.c
+ *
+ *    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *    This is a Leptonica regression test for jbig2 encoding
+ *    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *
+ *    This codes 1 bpp images with jbig2EncodeGeneric(), as embedded
+ *    segments for pdf and as a standalone file, and decodes them,
+ *    which must give back the same image.
+ *
+ *    Leptonica has no jbig2 decoder, so a small one is here.  It
+ *    reads only what jbig2EncodeGeneric() writes: page information,
+ *    an immediate generic region with the MQ coder and template 0,
+ *    and the end of page and end of file segments.  It follows ITU-T
+ *    T.88 (6.2.5 and Annex E) and forms the contexts in the pixel
+ *    order of jbig2dec, independently of the encoder.
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+    /* Probability estimation state machine of the MQ coder (T.88, E.1.2) */
+struct MqState
+{
+    l_uint32  qe;
+    l_uint8   nmps;
+    l_uint8   nlps;
+    l_uint8   switchflag;
+};
+
+static const struct MqState  MqTable[47] = {
+    {0x5601,  1,  1, 1}, {0x3401,  2,  6, 0}, {0x1801,  3,  9, 0},
+    {0x0ac1,  4, 12, 0}, {0x0521,  5, 29, 0}, {0x0221, 38, 33, 0},
+    {0x5601,  7,  6, 1}, {0x5401,  8, 14, 0}, {0x4801,  9, 14, 0},
+    {0x3801, 10, 14, 0}, {0x3001, 11, 17, 0}, {0x2401, 12, 18, 0},
+    {0x1c01, 13, 20, 0}, {0x1601, 29, 21, 0}, {0x5601, 15, 14, 1},
+    {0x5401, 16, 14, 0}, {0x5101, 17, 15, 0}, {0x4801, 18, 16, 0},
+    {0x3801, 19, 17, 0}, {0x3401, 20, 18, 0}, {0x3001, 21, 19, 0},
+    {0x2801, 22, 19, 0}, {0x2401, 23, 20, 0}, {0x2201, 24, 21, 0},
+    {0x1c01, 25, 22, 0}, {0x1801, 26, 23, 0}, {0x1601, 27, 24, 0},
+    {0x1401, 28, 25, 0}, {0x1201, 29, 26, 0}, {0x1101, 30, 27, 0},
+    {0x0ac1, 31, 28, 0}, {0x09c1, 32, 29, 0}, {0x08a1, 33, 30, 0},
+    {0x0521, 34, 31, 0}, {0x0441, 35, 32, 0}, {0x02a1, 36, 33, 0},
+    {0x0221, 37, 34, 0}, {0x0141, 38, 35, 0}, {0x0111, 39, 36, 0},
+    {0x0085, 40, 37, 0}, {0x0049, 41, 38, 0}, {0x0025, 42, 39, 0},
+    {0x0015, 43, 40, 0}, {0x0009, 44, 41, 0}, {0x0005, 45, 42, 0},
+    {0x0001, 45, 43, 0}, {0x5601, 46, 46, 0}
+};
+
+    /* MQ decoder (T.88, E.3) */
+typedef struct {
+    const l_uint8  *data;
+    size_t          size;
+    size_t          pos;      /* byte of data being read */
+    l_uint32        c;
+    l_uint32        a;
+    l_int32         ct;
+    l_uint8        *index;    /* state of each context */
+    l_uint8        *mps;      /* more probable symbol of each context */
+} L_MQ_DECODER;
+
+    /* Segments that the decoder found */
+typedef struct {
+    l_int32  pagew, pageh;
+    l_int32  endofpage, endoffile;
+} L_JB2_INFO;
+
+static PIX *Jbig2Decode(const l_uint8 *data, size_t size,
+                        l_int32 fullheaders, L_JB2_INFO *info);
+static PIX *DecodeGenericRegion(const l_uint8 *data, size_t size,
+                                l_int32 w, l_int32 h, const l_int32 *at);
+static l_int32 GetPixel(PIX *pix, l_int32 x, l_int32 y);
+static l_uint32 GetU32(const l_uint8 *p);
+static l_int32 MqByte(L_MQ_DECODER *dec, size_t pos);
+static void MqByteIn(L_MQ_DECODER *dec);
+static l_int32 MqDecode(L_MQ_DECODER *dec, l_uint32 cx);
+static PIX *MakeSltpPix(void);
+static void DoJbig2Test(L_REGPARAMS *rp, PIX *pixs);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       i, j;
+PIX          *pixs;
+L_REGPARAMS  *rp;
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+        /* Blank and black images */
+    pixs = pixCreate(100, 50, 1);
+    DoJbig2Test(rp, pixs);
+    pixSetAll(pixs);
+    DoJbig2Test(rp, pixs);
+    pixDestroy(&pixs);
+
+        /* Odd widths, changes in every pixel, and rows that repeat */
+    pixs = pixCreate(1, 17, 1);
+    for (i = 0; i < 17; i += 3)
+        pixSetPixel(pixs, 0, i, 1);
+    DoJbig2Test(rp, pixs);
+    pixDestroy(&pixs);
+    pixs = pixCreate(97, 64, 1);
+    for (i = 0; i < 64; i++) {
+        for (j = 0; j < 97; j++) {
+            if ((i < 16 && j >= i && j < 97 - i) ||
+                (i >= 16 && i < 24) || (i >= 32 && (i + j) % 2))
+                pixSetPixel(pixs, j, i, 1);
+        }
+    }
+    DoJbig2Test(rp, pixs);
+    pixDestroy(&pixs);
+
+        /* Pixels in the context of the typical prediction bit, which
+         * must be the same context for the encoder and the decoder */
+    pixs = MakeSltpPix();
+    DoJbig2Test(rp, pixs);
+    pixDestroy(&pixs);
+
+        /* Pages of text */
+    pixs = pixRead("test1.png");
+    DoJbig2Test(rp, pixs);
+    pixDestroy(&pixs);
+    pixs = pixRead("rabi.png");
+    DoJbig2Test(rp, pixs);
+    pixDestroy(&pixs);
+
+    return regTestCleanup(rp);
+}
+
+
+static void
+DoJbig2Test(L_REGPARAMS  *rp,
+            PIX          *pixs)
+{
+size_t      size1, size2;
+l_uint8    *data1, *data2;
+PIX        *pix1, *pix2;
+L_JB2_INFO  info1, info2;
+
+        /* Embedded in pdf */
+    jbig2EncodeGeneric(pixs, 0, &data1, &size1);
+    pix1 = Jbig2Decode(data1, size1, 0, &info1);
+    regTestComparePix(rp, pixs, pix1);
+    regTestCompareValues(rp, pixGetWidth(pixs), info1.pagew, 0);
+    regTestCompareValues(rp, pixGetHeight(pixs), info1.pageh, 0);
+
+        /* Standalone file: the same segments, between the file header
+         * and the end of page and end of file segments */
+    jbig2EncodeGeneric(pixs, 1, &data2, &size2);
+    pix2 = Jbig2Decode(data2, size2, 1, &info2);
+    regTestComparePix(rp, pixs, pix2);
+    regTestCompareValues(rp, 1, info2.endofpage && info2.endoffile, 0);
+    regTestCompareStrings(rp, data1, size1, data2 + 13,
+                          (size2 >= size1 + 13) ? size1 : 0);
+
+    lept_free(data1);
+    lept_free(data2);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    return;
+}
+
+
+    /* Returns an image where many pixels have the neighbors that make
+     * context 0x9b25 of template 0 (T.88, 6.2.5.7, Figure 8), which is
+     * rare in real images */
+static PIX *
+MakeSltpPix(void)
+{
+static const l_int32  row2[5] = {1, 0, 0, 1, 1};  /* x - 2 to x + 2 */
+static const l_int32  row1[7] = {0, 1, 1, 0, 0, 1, 0};  /* x - 3 to x + 3 */
+static const l_int32  row0[4] = {0, 1, 0, 1};  /* x - 4 to x - 1 */
+l_int32  i, x, y, n;
+PIX     *pix;
+
+    pix = pixCreate(200, 60, 1);
+    n = 0;
+    for (y = 2; y < 60; y += 4) {
+        for (x = 4; x < 196; x += 10, n++) {
+            for (i = 0; i < 5; i++)
+                pixSetPixel(pix, x - 2 + i, y - 2, row2[i]);
+            for (i = 0; i < 7; i++)
+                pixSetPixel(pix, x - 3 + i, y - 1, row1[i]);
+            for (i = 0; i < 4; i++)
+                pixSetPixel(pix, x - 4 + i, y, row0[i]);
+            pixSetPixel(pix, x, y, (n * 7 + n / 5) % 3 == 0);
+        }
+    }
+    return pix;
+}
+
+
+    /* Returns the page of jbig2 data as written by jbig2EncodeGeneric(),
+     * or NULL if it has anything else */
+static PIX *
+Jbig2Decode(const l_uint8  *data,
+            size_t          size,
+            l_int32         fullheaders,
+            L_JB2_INFO     *info)
+{
+static const l_uint8  fileid[] = {0x97, 0x4a, 0x42, 0x32, 0x0d, 0x0a,
+                                  0x1a, 0x0a};
+l_int32         i, type, x, y, w, h, at[8];
+size_t          pos, length;
+const l_uint8  *seg;
+PIX            *pix, *pixr;
+
+    memset(info, 0, sizeof(L_JB2_INFO));
+    pos = 0;
+    if (fullheaders) {  /* sequential, with one page */
+        if (size < 13 || memcmp(data, fileid, 8) != 0 || data[8] != 0x01 ||
+            GetU32(data + 9) != 1)
+            return NULL;
+        pos = 13;
+    }
+
+    pix = NULL;
+    while (pos < size && !info->endoffile) {
+            /* Segment header, with a one byte page association and no
+             * referred-to segments */
+        if (pos + 11 > size || (data[pos + 4] & 0xc0) != 0 ||
+            data[pos + 5] != 0)
+            break;
+        type = data[pos + 4] & 0x3f;
+        length = GetU32(data + pos + 7);
+        seg = data + pos + 11;
+        pos += 11 + length;
+        if (pos > size)
+            break;
+        if (type == 48 && length == 19 && !pix) {  /* page information */
+            info->pagew = GetU32(seg);
+            info->pageh = GetU32(seg + 4);
+            if (info->pagew <= 0 || info->pageh <= 0)
+                break;
+            pix = pixCreate(info->pagew, info->pageh, 1);
+        } else if (type == 38 && length >= 26 && pix &&
+                   !info->endofpage) {  /* immediate generic region */
+            w = GetU32(seg);
+            h = GetU32(seg + 4);
+            x = GetU32(seg + 8);
+            y = GetU32(seg + 12);
+                /* Arithmetic coding, template 0, with TPGDON */
+            if (seg[17] != 0x08)
+                break;
+            for (i = 0; i < 8; i++)
+                at[i] = (l_int8)seg[18 + i];
+            pixr = DecodeGenericRegion(seg + 26, length - 26, w, h, at);
+            if (!pixr)
+                break;
+            pixRasterop(pix, x, y, w, h, PIX_SRC | PIX_DST, pixr, 0, 0);
+            pixDestroy(&pixr);
+        } else if (type == 49 && length == 0) {
+            info->endofpage = 1;
+        } else if (type == 51 && length == 0) {
+            info->endoffile = 1;
+        } else {
+            break;
+        }
+    }
+    if (pos != size || (fullheaders && !info->endoffile))
+        pixDestroy(&pix);
+    return pix;
+}
+
+
+    /* Decodes a generic region with template 0 and TPGDON (T.88, 6.2.5.7) */
+static PIX *
+DecodeGenericRegion(const l_uint8  *data,
+                    size_t          size,
+                    l_int32         w,
+                    l_int32         h,
+                    const l_int32  *at)
+{
+l_int32       x, y, ltp;
+l_uint32      cx;
+PIX          *pix;
+L_MQ_DECODER  dec;
+
+    if (w <= 0 || h <= 0)
+        return NULL;
+    pix = pixCreate(w, h, 1);
+    memset(&dec, 0, sizeof(L_MQ_DECODER));
+    dec.data = data;
+    dec.size = size;
+    dec.index = (l_uint8 *)LEPT_CALLOC(65536, 1);
+    dec.mps = (l_uint8 *)LEPT_CALLOC(65536, 1);
+
+        /* INITDEC */
+    dec.c = MqByte(&dec, 0) << 16;
+    MqByteIn(&dec);
+    dec.c <<= 7;
+    dec.ct -= 7;
+    dec.a = 0x8000;
+
+    ltp = 0;
+    for (y = 0; y < h; y++) {
+        ltp ^= MqDecode(&dec, 0x9b25);
+        if (ltp) {
+            if (y > 0)
+                pixRasterop(pix, 0, y, w, 1, PIX_SRC, pix, 0, y - 1);
+            continue;
+        }
+        for (x = 0; x < w; x++) {
+            cx = GetPixel(pix, x - 1, y) |
+                 GetPixel(pix, x - 2, y) << 1 |
+                 GetPixel(pix, x - 3, y) << 2 |
+                 GetPixel(pix, x - 4, y) << 3 |
+                 GetPixel(pix, x + at[0], y + at[1]) << 4 |
+                 GetPixel(pix, x + 2, y - 1) << 5 |
+                 GetPixel(pix, x + 1, y - 1) << 6 |
+                 GetPixel(pix, x, y - 1) << 7 |
+                 GetPixel(pix, x - 1, y - 1) << 8 |
+                 GetPixel(pix, x - 2, y - 1) << 9 |
+                 GetPixel(pix, x + at[2], y + at[3]) << 10 |
+                 GetPixel(pix, x + at[4], y + at[5]) << 11 |
+                 GetPixel(pix, x + 1, y - 2) << 12 |
+                 GetPixel(pix, x, y - 2) << 13 |
+                 GetPixel(pix, x - 1, y - 2) << 14 |
+                 GetPixel(pix, x + at[6], y + at[7]) << 15;
+            if (MqDecode(&dec, cx))
+                pixSetPixel(pix, x, y, 1);
+        }
+    }
+
+        /* The coder must not have read past the end of the data, except
+         * for the 0xff bytes it takes there */
+    if (dec.pos > size + 2)
+        pixDestroy(&pix);
+    LEPT_FREE(dec.index);
+    LEPT_FREE(dec.mps);
+    return pix;
+}
+
+
+static l_int32
+GetPixel(PIX      *pix,
+         l_int32   x,
+         l_int32   y)
+{
+l_uint32  *line;
+
+    if (x < 0 || y < 0 || x >= pixGetWidth(pix) || y >= pixGetHeight(pix))
+        return 0;
+    line = pixGetData(pix) + y * pixGetWpl(pix);
+    return GET_DATA_BIT(line, x);
+}
+
+
+static l_uint32
+GetU32(const l_uint8  *p)
+{
+    return (l_uint32)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+
+    /* Byte of the coded data; past the end it is 0xff (T.88, E.3.4) */
+static l_int32
+MqByte(L_MQ_DECODER  *dec,
+       size_t         pos)
+{
+    return (pos < dec->size) ? dec->data[pos] : 0xff;
+}
+
+
+static void
+MqByteIn(L_MQ_DECODER  *dec)
+{
+    if (MqByte(dec, dec->pos) == 0xff) {
+        if (MqByte(dec, dec->pos + 1) > 0x8f) {
+            dec->c += 0xff00;
+            dec->ct = 8;
+        } else {
+            dec->pos++;
+            dec->c += MqByte(dec, dec->pos) << 9;
+            dec->ct = 7;
+        }
+    } else {
+        dec->pos++;
+        dec->c += MqByte(dec, dec->pos) << 8;
+        dec->ct = 8;
+    }
+}
+
+
+static l_int32
+MqDecode(L_MQ_DECODER  *dec,
+         l_uint32       cx)
+{
+l_int32                d;
+l_uint32               qe;
+const struct MqState  *st;
+
+    st = &MqTable[dec->index[cx]];
+    qe = st->qe;
+    dec->a -= qe;
+    if ((dec->c >> 16) < qe) {  /* LPS_EXCHANGE */
+        if (dec->a < qe) {
+            d = dec->mps[cx];
+            dec->index[cx] = st->nmps;
+        } else {
+            d = 1 - dec->mps[cx];
+            if (st->switchflag)
+                dec->mps[cx] = 1 - dec->mps[cx];
+            dec->index[cx] = st->nlps;
+        }
+        dec->a = qe;
+    } else {
+        dec->c -= qe << 16;
+        if (dec->a & 0x8000)
+            return dec->mps[cx];
+        if (dec->a < qe) {  /* MPS_EXCHANGE */
+            d = 1 - dec->mps[cx];
+            if (st->switchflag)
+                dec->mps[cx] = 1 - dec->mps[cx];
+            dec->index[cx] = st->nlps;
+        } else {
+            d = dec->mps[cx];
+            dec->index[cx] = st->nmps;
+        }
+    }
+
+        /* RENORMD */
+    do {
+        if (dec->ct == 0)
+            MqByteIn(dec);
+        dec->a <<= 1;
+        dec->c <<= 1;
+        dec->ct--;
+    } while ((dec->a & 0x8000) == 0);
+    return d;
+}
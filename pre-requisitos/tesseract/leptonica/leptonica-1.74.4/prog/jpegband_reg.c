@@ -0,0 +1,222 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   jpegband_reg.c
+ *
+ *    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *    This is a Leptonica regression test for jpeg band writing
+ *    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *
+ *    Without progressive encoding, pixWriteMemJpeg() compresses
+ *    images of at least 512 rows in bands on separate threads, and
+ *    joins the bands with restart markers.  Each image is written on
+ *    one thread and then on several, and the two must decode to the
+ *    same image without warnings.  Progressive images are never
+ *    banded, so there the two must give the same bytes.
+ *
+ *    The bands need jpeg_mem_dest() in libjpeg and openmp; without
+ *    them there is only one band, and the restart markers are not
+ *    checked.
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+    /* Needed for HAVE_LIBJPEG */
+#ifdef HAVE_CONFIG_H
+#include <config_auto.h>
+#endif /* HAVE_CONFIG_H */
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
+
+#if HAVE_LIBJPEG
+#undef HAVE_STDLIB_H
+#include "jpeglib.h"
+#endif  /* HAVE_LIBJPEG */
+
+    /* Same test as in jpegio.c */
+#if defined(_OPENMP) && \
+    (JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED))
+#define  BANDS_WRITTEN   1
+#else
+#define  BANDS_WRITTEN   0
+#endif
+
+static void DoBandTest(L_REGPARAMS *rp, PIX *pixs, l_int32 nthreads,
+                       l_int32 nbands);
+static l_int32 CountRestartMarkers(l_uint8 *data, size_t size);
+static void SetThreads(l_int32 nthreads);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       same;
+size_t        size1, size2;
+l_uint8      *data1, *data2;
+PIX          *pixs, *pix1, *pix2;
+L_REGPARAMS  *rp;
+
+#if !HAVE_LIBJPEG
+    fprintf(stderr, "jpegio is not enabled\n"
+            "See environ.h: #define HAVE_LIBJPEG\n"
+            "See prog/Makefile: link in -ljpeg\n\n");
+    return 0;
+#endif  /* abort */
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+        /* Gray, in three bands of 8 row MCUs; the last is shorter */
+    pixs = pixRead("lighttext.jpg");
+    DoBandTest(rp, pixs, 3, 3);
+    pixDestroy(&pixs);
+
+        /* Color, with 16 row MCUs and with 8 row MCUs.  Only three
+         * bands fit in 908 rows, even with four threads. */
+    pixs = pixRead("test24.jpg");
+    pixSetText(pixs, "test24 in bands");
+    DoBandTest(rp, pixs, 2, 2);
+    DoBandTest(rp, pixs, 4, 3);
+    pixSetChromaSampling(pixs, 0);
+    DoBandTest(rp, pixs, 3, 3);
+
+        /* Fast dct, with and without chroma subsampling.  It does not
+         * give the same image as the accurate dct. */
+    pixWriteMemJpeg(&data1, &size1, pixs, 75, 0);
+    pixSetJpegFastEncode(pixs, 1);
+    pixWriteMemJpeg(&data2, &size2, pixs, 75, 0);
+    pix1 = pixReadMemJpeg(data1, size1, 0, 1, NULL, 0);
+    pix2 = pixReadMemJpeg(data2, size2, 0, 1, NULL, 0);
+    pixEqual(pix1, pix2, &same);
+    regTestCompareValues(rp, 0, same, 0);
+    lept_free(data1);
+    lept_free(data2);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    DoBandTest(rp, pixs, 3, 3);
+    pixSetChromaSampling(pixs, 1);
+    DoBandTest(rp, pixs, 3, 3);
+
+        /* Progressive: one band whatever the number of threads */
+    SetThreads(1);
+    pixWriteMemJpeg(&data1, &size1, pixs, 75, 1);
+    SetThreads(4);
+    pixWriteMemJpeg(&data2, &size2, pixs, 75, 1);
+    SetThreads(1);
+    regTestCompareStrings(rp, data1, size1, data2, size2);
+    lept_free(data1);
+    lept_free(data2);
+    pixDestroy(&pixs);
+
+        /* Too wide for a band in one restart interval, so there is
+         * one for each MCU row, and the markers wrap around */
+    pix1 = pixRead("lighttext.jpg");
+    pix2 = pixScaleToSize(pix1, 16400, 512);
+    pixs = pixConvertTo8(pix2, 0);
+    DoBandTest(rp, pixs, 2, 2);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    pixDestroy(&pixs);
+
+    return regTestCleanup(rp);
+}
+
+
+static void
+DoBandTest(L_REGPARAMS  *rp,
+           PIX          *pixs,
+           l_int32       nthreads,
+           l_int32       nbands)
+{
+char     *text1, *text2;
+l_int32   nwarn1, nwarn2, nrestart;
+size_t    size1, size2;
+l_uint8  *data1, *data2;
+PIX      *pix1, *pix2;
+
+    SetThreads(1);
+    pixWriteMemJpeg(&data1, &size1, pixs, 75, 0);
+    pix1 = pixReadMemJpeg(data1, size1, 0, 1, &nwarn1, 0);
+    SetThreads(nthreads);
+    pixWriteMemJpeg(&data2, &size2, pixs, 75, 0);
+    SetThreads(1);
+    pix2 = pixReadMemJpeg(data2, size2, 0, 1, &nwarn2, 0);
+    regTestCompareValues(rp, 0, nwarn1, 0);
+    regTestCompareValues(rp, 0, nwarn2, 0);
+    regTestComparePix(rp, pix1, pix2);
+    regTestCompareSimilarPix(rp, pixs, pix2, 40, 0.005, 0);
+
+        /* Each band but the last ends with a restart marker, and the
+         * image ends with the end marker */
+    nrestart = CountRestartMarkers(data2, size2);
+    regTestCompareValues(rp, 0xd9, data2[size2 - 1], 0);
+    if (!BANDS_WRITTEN) nbands = 1;
+    regTestCompareValues(rp, 1, (nrestart >= nbands - 1) ? 1 : 0, 0);
+
+        /* The text of the pix goes with the first band */
+    if ((text1 = pixGetText(pixs)) != NULL) {
+        if ((text2 = pixGetText(pix2)) == NULL)
+            text2 = (char *)"";
+        regTestCompareStrings(rp, (l_uint8 *)text1, strlen(text1),
+                              (l_uint8 *)text2, strlen(text2));
+    }
+
+    lept_free(data1);
+    lept_free(data2);
+    pixDestroy(&pix1);
+    pixDestroy(&pix2);
+    return;
+}
+
+
+    /* Restart markers are 0xffd0 - 0xffd7, and are only found in
+     * the entropy-coded data. */
+static l_int32
+CountRestartMarkers(l_uint8  *data,
+                    size_t    size)
+{
+l_int32  n;
+size_t   i;
+
+    for (i = 0, n = 0; i + 1 < size; i++) {
+        if (data[i] == 0xff && data[i + 1] >= 0xd0 && data[i + 1] <= 0xd7)
+            n++;
+    }
+    return n;
+}
+
+
+static void
+SetThreads(l_int32  nthreads)
+{
+#ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+#endif  /* _OPENMP */
+}
@@ -49,6 +49,7 @@ static const l_float32  ANGLE2 = 3.14159265 / 120.;
 static const l_int32    NTIMES = 24;
 
 static void RotateTest(PIX *pixs, l_float32 scale, L_REGPARAMS *rp);
+static PIX *TimedRotate(PIX *pixs, l_int32 type, L_REGPARAMS *rp);
 
 
 l_int32 main(int    argc,
@@ -111,6 +112,7 @@ RotateTest(PIX          *pixs,
            l_float32     scale,
            L_REGPARAMS  *rp)
 {
+char      buf[64];
 l_int32   w, h, d, i, outformat;
 PIX      *pixt, *pixd;
 PIXA     *pixa;
@@ -118,7 +120,7 @@ PIXA     *pixa;
     pixa = pixaCreate(0);
     pixGetDimensions(pixs, &w, &h, &d);
     outformat = (d == 8 || d == 32) ? IFF_JFIF_JPEG : IFF_PNG;
-    pixd = pixRotate(pixs, ANGLE1, L_ROTATE_SHEAR, L_BRING_IN_WHITE, w, h);
+    pixd = TimedRotate(pixs, L_ROTATE_SHEAR, rp);
     for (i = 1; i < NTIMES; i++) {
         if ((i % MODSIZE) == 0) {
             if (i == MODSIZE) {
@@ -136,7 +138,7 @@ PIXA     *pixa;
     }
     pixDestroy(&pixd);
 
-    pixd = pixRotate(pixs, ANGLE1, L_ROTATE_SAMPLING, L_BRING_IN_WHITE, w, h);
+    pixd = TimedRotate(pixs, L_ROTATE_SAMPLING, rp);
     for (i = 1; i < NTIMES; i++) {
         if ((i % MODSIZE) == 0) {
             if (i == MODSIZE) {
@@ -154,7 +156,7 @@ PIXA     *pixa;
     }
     pixDestroy(&pixd);
 
-    pixd = pixRotate(pixs, ANGLE1, L_ROTATE_AREA_MAP, L_BRING_IN_WHITE, w, h);
+    pixd = TimedRotate(pixs, L_ROTATE_AREA_MAP, rp);
     for (i = 1; i < NTIMES; i++) {
         if ((i % MODSIZE) == 0) {
             if (i == MODSIZE) {
@@ -172,7 +174,12 @@ PIXA     *pixa;
     }
     pixDestroy(&pixd);
 
-    pixd = pixRotateAMCorner(pixs, ANGLE2, L_BRING_IN_WHITE);
+    snprintf(buf, sizeof(buf), "pixRotateAMCorner %d bpp", d);
+    pixd = NULL;
+    while (regTestTimeLoop(rp, buf, pixs)) {
+        pixDestroy(&pixd);
+        pixd = pixRotateAMCorner(pixs, ANGLE2, L_BRING_IN_WHITE);
+    }
     for (i = 1; i < NTIMES; i++) {
         if ((i % MODSIZE) == 0) {
             if (i == MODSIZE) {
@@ -190,7 +197,10 @@ PIXA     *pixa;
     pixDestroy(&pixd);
 
     if (d == 32) {
-        pixd = pixRotateAMColorFast(pixs, ANGLE1, 0xb0ffb000);
+        while (regTestTimeLoop(rp, "pixRotateAMColorFast", pixs)) {
+            pixDestroy(&pixd);
+            pixd = pixRotateAMColorFast(pixs, ANGLE1, 0xb0ffb000);
+        }
         for (i = 1; i < NTIMES; i++) {
             if ((i % MODSIZE) == 0) {
                 if (i == MODSIZE) {
@@ -214,3 +224,32 @@ PIXA     *pixa;
     pixaDestroy(&pixa);
     return;
 }
+
+
+    /* Rotates pixs by ANGLE1, timing it in 'time' mode */
+static PIX *
+TimedRotate(PIX          *pixs,
+            l_int32       type,
+            L_REGPARAMS  *rp)
+{
+char         buf[64];
+const char  *typestr;
+l_int32      w, h, d;
+PIX         *pixd;
+
+    pixGetDimensions(pixs, &w, &h, &d);
+    if (type == L_ROTATE_SHEAR)
+        typestr = "shear";
+    else if (type == L_ROTATE_SAMPLING)
+        typestr = "sampling";
+    else
+        typestr = "area map";
+    snprintf(buf, sizeof(buf), "pixRotate %s %d bpp%s", typestr, d,
+             pixGetColormap(pixs) ? " cmap" : "");
+    pixd = NULL;
+    while (regTestTimeLoop(rp, buf, pixs)) {
+        pixDestroy(&pixd);
+        pixd = pixRotate(pixs, ANGLE1, type, L_BRING_IN_WHITE, w, h);
+    }
+    return pixd;
+}
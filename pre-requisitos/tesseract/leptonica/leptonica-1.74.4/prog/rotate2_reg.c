@@ -108,6 +108,7 @@ RotateTest(PIX          *pixs,
            l_float32     scale,
            L_REGPARAMS  *rp)
 {
+char      buf[64];
 l_int32   w, h, d, outformat;
 PIX      *pixt1, *pixt2, *pixt3, *pixd;
 PIXA     *pixa;
@@ -116,7 +117,13 @@ PIXA     *pixa;
     outformat = (d == 8 || d == 32) ? IFF_JFIF_JPEG : IFF_PNG;
 
     pixa = pixaCreate(0);
-    pixt1 = pixRotate(pixs, ANGLE1, L_ROTATE_SHEAR, L_BRING_IN_WHITE, w, h);
+    snprintf(buf, sizeof(buf), "pixRotate shear %d bpp", d);
+    pixt1 = NULL;
+    while (regTestTimeLoop(rp, buf, pixs)) {
+        pixDestroy(&pixt1);
+        pixt1 = pixRotate(pixs, ANGLE1, L_ROTATE_SHEAR, L_BRING_IN_WHITE,
+                          w, h);
+    }
     pixSaveTiled(pixt1, pixa, scale, 1, 20, 32);
     pixt2 = pixRotate(pixs, ANGLE1, L_ROTATE_SHEAR, L_BRING_IN_BLACK, w, h);
     pixSaveTiled(pixt2, pixa, scale, 0, 20, 0);
@@ -147,7 +154,13 @@ PIXA     *pixa;
     pixaDestroy(&pixa);
 
     pixa = pixaCreate(0);
-    pixt1 = pixRotate(pixs, ANGLE2, L_ROTATE_SAMPLING, L_BRING_IN_WHITE, w, h);
+    snprintf(buf, sizeof(buf), "pixRotate sampling %d bpp", d);
+    pixt1 = NULL;
+    while (regTestTimeLoop(rp, buf, pixs)) {
+        pixDestroy(&pixt1);
+        pixt1 = pixRotate(pixs, ANGLE2, L_ROTATE_SAMPLING, L_BRING_IN_WHITE,
+                          w, h);
+    }
     pixSaveTiled(pixt1, pixa, scale, 1, 20, 32);
     pixt2 = pixRotate(pixs, ANGLE2, L_ROTATE_SAMPLING, L_BRING_IN_BLACK, w, h);
     pixSaveTiled(pixt2, pixa, scale, 0, 20, 0);
@@ -164,7 +177,14 @@ PIXA     *pixa;
         pixt1 = pixScaleToGray2(pixs);
     else
         pixt1 = pixClone(pixs);
-    pixt2 = pixRotate(pixt1, ANGLE2, L_ROTATE_AREA_MAP, L_BRING_IN_WHITE, w, h);
+    snprintf(buf, sizeof(buf), "pixRotate area map %d bpp",
+             pixGetDepth(pixt1));
+    pixt2 = NULL;
+    while (regTestTimeLoop(rp, buf, pixt1)) {
+        pixDestroy(&pixt2);
+        pixt2 = pixRotate(pixt1, ANGLE2, L_ROTATE_AREA_MAP, L_BRING_IN_WHITE,
+                          w, h);
+    }
     pixSaveTiled(pixt2, pixa, scale, 1, 20, 0);
     pixt3 = pixRotate(pixt1, ANGLE2, L_ROTATE_AREA_MAP, L_BRING_IN_BLACK, w, h);
     pixSaveTiled(pixt3, pixa, scale, 0, 20, 0);
@@ -49,6 +49,8 @@ static const l_int32    SPACE = 30;
 static const l_int32    WIDTH = 300;
 static const l_float32  FACTOR[5] = {2.3, 1.5, 1.1, 0.6, 0.3};
 
+static PIX *TimedScale(L_REGPARAMS *rp, PIX *pixs, l_float32 factor);
+static PIX *TimedScaleToGray(L_REGPARAMS *rp, PIX *pixs, l_int32 factor);
 static void AddScaledImages(PIXA *pixa, const char *fname, l_int32 width);
 static void PixSave32(PIXA *pixa, PIX *pixc);
 static void PixaSaveDisplay(PIXA *pixa, L_REGPARAMS *rp);
@@ -69,29 +71,29 @@ L_REGPARAMS  *rp;
     fprintf(stderr, "\n-------------- Testing 1 bpp ----------\n");
     pixa = pixaCreate(0);
     pixs = pixRead(image[0]);
-    pixc = pixScale(pixs, 0.32, 0.32);
+    pixc = TimedScale(rp, pixs, 0.32);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 0 */
     pixSaveTiled(pixc, pixa, 1.0, 1, SPACE, 32);
     pixDestroy(&pixc);
 
-    pixc = pixScaleToGray3(pixs);
+    pixc = TimedScaleToGray(rp, pixs, 3);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 1 */
     PixSave32(pixa, pixc);
 
-    pixc = pixScaleToGray4(pixs);
+    pixc = TimedScaleToGray(rp, pixs, 4);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 2 */
     pixSaveTiled(pixc, pixa, 1.0, 1, SPACE, 32);
     pixDestroy(&pixc);
 
-    pixc = pixScaleToGray6(pixs);
+    pixc = TimedScaleToGray(rp, pixs, 6);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 3 */
     PixSave32(pixa, pixc);
 
-    pixc = pixScaleToGray8(pixs);
+    pixc = TimedScaleToGray(rp, pixs, 8);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 4 */
     PixSave32(pixa, pixc);
 
-    pixc = pixScaleToGray16(pixs);
+    pixc = TimedScaleToGray(rp, pixs, 16);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 5 */
     PixSave32(pixa, pixc);
     pixDestroy(&pixs);
@@ -108,13 +110,13 @@ L_REGPARAMS  *rp;
     pixa = pixaCreate(0);
     pixs = pixRead(image[1]);
     pixSaveTiled(pixs, pixa, 1.0, 1, SPACE, 32);
-    pixc = pixScale(pixs, 2.25, 2.25);
+    pixc = TimedScale(rp, pixs, 2.25);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 17 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.85, 0.85);
+    pixc = TimedScale(rp, pixs, 0.85);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 18 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.65, 0.65);
+    pixc = TimedScale(rp, pixs, 0.65);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 19 */
     PixSave32(pixa, pixc);
     PixaSaveDisplay(pixa, rp);  /* 20 */
@@ -125,13 +127,13 @@ L_REGPARAMS  *rp;
     pixa = pixaCreate(0);
     pixs = pixRead(image[2]);
     pixSaveTiled(pixs, pixa, 1.0, 1, SPACE, 32);
-    pixc = pixScale(pixs, 2.25, 2.25);
+    pixc = TimedScale(rp, pixs, 2.25);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 21 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.85, 0.85);
+    pixc = TimedScale(rp, pixs, 0.85);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 22 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.65, 0.65);
+    pixc = TimedScale(rp, pixs, 0.65);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 23 */
     PixSave32(pixa, pixc);
     PixaSaveDisplay(pixa, rp);  /* 24 */
@@ -142,13 +144,13 @@ L_REGPARAMS  *rp;
     pixa = pixaCreate(0);
     pixs = pixRead(image[3]);
     pixSaveTiled(pixs, pixa, 1.0, 1, SPACE, 32);
-    pixc = pixScale(pixs, 1.72, 1.72);
+    pixc = TimedScale(rp, pixs, 1.72);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 25 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.85, 0.85);
+    pixc = TimedScale(rp, pixs, 0.85);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 26 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.65, 0.65);
+    pixc = TimedScale(rp, pixs, 0.65);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 27 */
     PixSave32(pixa, pixc);
     PixaSaveDisplay(pixa, rp);  /* 28 */
@@ -159,13 +161,13 @@ L_REGPARAMS  *rp;
     pixa = pixaCreate(0);
     pixs = pixRead(image[4]);
     pixSaveTiled(pixs, pixa, 1.0, 1, SPACE, 32);
-    pixc = pixScale(pixs, 1.72, 1.72);
+    pixc = TimedScale(rp, pixs, 1.72);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 29 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.85, 0.85);
+    pixc = TimedScale(rp, pixs, 0.85);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 30 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.65, 0.65);
+    pixc = TimedScale(rp, pixs, 0.65);
     regTestWritePixAndCheck(rp, pixc, IFF_PNG);  /* 31 */
     PixSave32(pixa, pixc);
     PixaSaveDisplay(pixa, rp);  /* 32 */
@@ -176,13 +178,13 @@ L_REGPARAMS  *rp;
     pixa = pixaCreate(0);
     pixs = pixRead(image[5]);
     pixSaveTiled(pixs, pixa, 1.0, 1, SPACE, 32);
-    pixc = pixScale(pixs, 1.92, 1.92);
+    pixc = TimedScale(rp, pixs, 1.92);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 33 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.85, 0.85);
+    pixc = TimedScale(rp, pixs, 0.85);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 34 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.65, 0.65);
+    pixc = TimedScale(rp, pixs, 0.65);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 35 */
     PixSave32(pixa, pixc);
     pixDestroy(&pixs);
@@ -198,13 +200,13 @@ L_REGPARAMS  *rp;
     pixa = pixaCreate(0);
     pixs = pixRead(image[6]);
     pixSaveTiled(pixs, pixa, 1.0, 1, SPACE, 32);
-    pixc = pixScale(pixs, 1.92, 1.92);
+    pixc = TimedScale(rp, pixs, 1.92);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 38 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.85, 0.85);
+    pixc = TimedScale(rp, pixs, 0.85);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 39 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.65, 0.65);
+    pixc = TimedScale(rp, pixs, 0.65);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 40 */
     PixSave32(pixa, pixc);
     PixaSaveDisplay(pixa, rp);  /* 41 */
@@ -215,13 +217,13 @@ L_REGPARAMS  *rp;
     pixa = pixaCreate(0);
     pixs = pixRead(image[7]);
     pixSaveTiled(pixs, pixa, 1.0, 1, SPACE, 32);
-    pixc = pixScale(pixs, 1.92, 1.92);
+    pixc = TimedScale(rp, pixs, 1.92);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 42 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.85, 0.85);
+    pixc = TimedScale(rp, pixs, 0.85);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 43 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.65, 0.65);
+    pixc = TimedScale(rp, pixs, 0.65);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 44 */
     PixSave32(pixa, pixc);
     PixaSaveDisplay(pixa, rp);  /* 45 */
@@ -232,13 +234,13 @@ L_REGPARAMS  *rp;
     pixa = pixaCreate(0);
     pixs = pixRead(image[8]);
     pixSaveTiled(pixs, pixa, 1.0, 1, SPACE, 32);
-    pixc = pixScale(pixs, 1.42, 1.42);
+    pixc = TimedScale(rp, pixs, 1.42);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 46 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.85, 0.85);
+    pixc = TimedScale(rp, pixs, 0.85);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 47 */
     PixSave32(pixa, pixc);
-    pixc = pixScale(pixs, 0.65, 0.65);
+    pixc = TimedScale(rp, pixs, 0.65);
     regTestWritePixAndCheck(rp, pixc, IFF_JFIF_JPEG);  /* 48 */
     PixSave32(pixa, pixc);
     PixaSaveDisplay(pixa, rp);  /* 49 */
@@ -247,6 +249,61 @@ L_REGPARAMS  *rp;
     return regTestCleanup(rp);
 }
 
+    /* Scales pixs, timing it in 'time' mode */
+static PIX *
+TimedScale(L_REGPARAMS  *rp,
+           PIX          *pixs,
+           l_float32     factor)
+{
+char  buf[64];
+PIX  *pixd;
+
+    snprintf(buf, sizeof(buf), "pixScale %d bpp%s %4.2f", pixGetDepth(pixs),
+             pixGetColormap(pixs) ? " cmap" : "", factor);
+    pixd = NULL;
+    while (regTestTimeLoop(rp, buf, pixs)) {
+        pixDestroy(&pixd);
+        pixd = pixScale(pixs, factor, factor);
+    }
+    return pixd;
+}
+
+    /* Scales 1 bpp pixs to gray by the integer factor, timing it
+     * in 'time' mode */
+static PIX *
+TimedScaleToGray(L_REGPARAMS  *rp,
+                 PIX          *pixs,
+                 l_int32       factor)
+{
+char  buf[64];
+PIX  *pixd;
+
+    snprintf(buf, sizeof(buf), "pixScaleToGray%d", factor);
+    pixd = NULL;
+    while (regTestTimeLoop(rp, buf, pixs)) {
+        pixDestroy(&pixd);
+        switch (factor)
+        {
+        case 3:
+            pixd = pixScaleToGray3(pixs);
+            break;
+        case 4:
+            pixd = pixScaleToGray4(pixs);
+            break;
+        case 6:
+            pixd = pixScaleToGray6(pixs);
+            break;
+        case 8:
+            pixd = pixScaleToGray8(pixs);
+            break;
+        default:
+            pixd = pixScaleToGray16(pixs);
+            break;
+        }
+    }
+    return pixd;
+}
+
 static void
 AddScaledImages(PIXA         *pixa,
                 const char   *fname,
@@ -0,0 +1,320 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*
+ *   tiffindex_reg.c
+ *
+ *    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *    This is a Leptonica regression test for the tiff page index
+ *    !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+ *
+ *    This indexes the pages of multipage tiff data, from memory with
+ *    tiffGetPageIndexMem() and from a file with tiffGetPageIndex().
+ *
+ *    The index only reads the image directories, so the data is made
+ *    here: classic tiff in both byte orders and BigTIFF, each with three
+ *    directories written in the file in reverse page order.  Directory
+ *    chains that loop, end outside the data or start outside it are
+ *    also indexed.
+ *
+ *    With libtiff, pages written by pixaWriteMemMultipageTiff() are
+ *    read back in reverse order from their offsets, with
+ *    pixReadMemTiffPage() and pixReadFromMultipageTiff().
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config_auto.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <string.h>
+#include "allheaders.h"
+
+static const l_int32  Widths[3] = {300, 70000, 41};
+static const l_int32  Heights[3] = {200, 5, 65535};
+
+static l_uint8 *MakeTiffData(l_int32 bigend, l_int32 bigtiff,
+                             l_uint64 *offsets, size_t *psize);
+static void PutValue(l_uint8 *data, l_uint64 val, l_int32 nbytes,
+                     l_int32 bigend);
+static void DoIndexTest(L_REGPARAMS *rp, l_int32 bigend, l_int32 bigtiff);
+static void CheckIndex(L_REGPARAMS *rp, L_DNA *da, NUMA *naw, NUMA *nah,
+                       l_uint64 *offsets, l_int32 n);
+
+
+int main(int    argc,
+         char **argv)
+{
+l_int32       ret;
+l_uint8      *data;
+l_uint64      offsets[3];
+size_t        size;
+L_DNA        *da;
+NUMA         *naw, *nah;
+L_REGPARAMS  *rp;
+#if  HAVE_LIBTIFF
+l_int32       i;
+l_float32     w, h;
+l_float64     val;
+size_t        offset;
+PIX          *pix1, *pix2;
+PIXA         *pixa;
+#endif  /* HAVE_LIBTIFF */
+
+    if (regTestSetup(argc, argv, &rp))
+        return 1;
+
+    lept_mkdir("lept/tiffindex");
+
+        /* Classic tiff in both byte orders, and BigTIFF */
+    DoIndexTest(rp, 0, 0);  /* 0 - 17 */
+    DoIndexTest(rp, 1, 0);  /* 18 - 35 */
+    DoIndexTest(rp, 0, 1);  /* 36 - 53 */
+    DoIndexTest(rp, 1, 1);  /* 54 - 71 */
+
+        /* A chain that loops back ends after the last new directory */
+    data = MakeTiffData(1, 0, offsets, &size);
+    PutValue(data + offsets[2] + 2 + 3 * 12, offsets[1], 4, 1);
+    setMsgSeverity(L_SEVERITY_NONE);
+    ret = tiffGetPageIndexMem(data, size, &da, &naw, &nah);
+    setMsgSeverity(L_SEVERITY_INFO);
+    regTestCompareValues(rp, 0, ret, 0);  /* 72 */
+    CheckIndex(rp, da, naw, nah, offsets, 3);  /* 73 - 80 */
+    l_dnaDestroy(&da);
+    numaDestroy(&naw);
+    numaDestroy(&nah);
+
+        /* A chain that goes outside the data ends before it */
+    PutValue(data + offsets[1] + 2 + 3 * 12, size + 100, 4, 1);
+    setMsgSeverity(L_SEVERITY_NONE);
+    ret = tiffGetPageIndexMem(data, size, &da, NULL, NULL);
+    setMsgSeverity(L_SEVERITY_INFO);
+    regTestCompareValues(rp, 0, ret, 0);  /* 81 */
+    CheckIndex(rp, da, NULL, NULL, offsets, 2);  /* 82 - 83 */
+    l_dnaDestroy(&da);
+
+        /* Data cut before the first directory is an error */
+    setMsgSeverity(L_SEVERITY_NONE);
+    ret = tiffGetPageIndexMem(data, offsets[0] + 10, &da, &naw, NULL);
+    setMsgSeverity(L_SEVERITY_INFO);
+    regTestCompareValues(rp, 1, ret, 0);  /* 84 */
+    regTestCompareValues(rp, 1, da == NULL && naw == NULL, 0);  /* 85 */
+    lept_free(data);
+
+        /* So is data that is not tiff */
+    setMsgSeverity(L_SEVERITY_NONE);
+    ret = tiffGetPageIndexMem((l_uint8 *)"MM\0\52", 4, &da, NULL, NULL);
+    regTestCompareValues(rp, 1, ret, 0);  /* 86 */
+    ret = tiffGetPageIndexMem((l_uint8 *)"BM\0\52\0\0\0\10", 8, &da, NULL,
+                              NULL);
+    regTestCompareValues(rp, 1, ret, 0);  /* 87 */
+    setMsgSeverity(L_SEVERITY_INFO);
+
+#if  HAVE_LIBTIFF
+        /* Read back the pages written by libtiff, last page first */
+    pixa = pixaCreate(3);
+    pix1 = pixRead("feyn-fract.tif");
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pix1 = pixRead("weasel8.png");
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pix1 = pixRead("marge.jpg");
+    pixaAddPix(pixa, pix1, L_INSERT);
+    pixaWriteMemMultipageTiff(&data, &size, pixa);
+    l_binaryWrite("/tmp/lept/tiffindex/pixa.tif", "w", data, size);
+    ret = tiffGetPageIndexMem(data, size, &da, &naw, &nah);
+    regTestCompareValues(rp, 0, ret, 0);  /* 88 */
+    regTestCompareValues(rp, 3, l_dnaGetCount(da), 0);  /* 89 */
+    for (i = 2; i >= 0; i--) {  /* 90 - 101 */
+        pix1 = pixaGetPix(pixa, i, L_CLONE);
+        l_dnaGetDValue(da, i, &val);
+        pix2 = pixReadMemTiffPage(data, size, (size_t)val);
+        regTestComparePix(rp, pix1, pix2);
+        pixDestroy(&pix2);
+        numaGetFValue(naw, i, &w);
+        numaGetFValue(nah, i, &h);
+        regTestCompareValues(rp, pixGetWidth(pix1), w, 0);
+        regTestCompareValues(rp, pixGetHeight(pix1), h, 0);
+
+        offset = (size_t)val;
+        pix2 = pixReadFromMultipageTiff("/tmp/lept/tiffindex/pixa.tif",
+                                        &offset);
+        regTestComparePix(rp, pix1, pix2);
+        pixDestroy(&pix1);
+        pixDestroy(&pix2);
+    }
+    l_dnaDestroy(&da);
+    numaDestroy(&naw);
+    numaDestroy(&nah);
+    pixaDestroy(&pixa);
+    lept_free(data);
+#else
+    fprintf(stderr, "Omitting libtiff tests in tiffindex_reg\n");
+#endif  /* HAVE_LIBTIFF */
+
+    return regTestCleanup(rp);
+}
+
+
+    /* Indexes the made data from memory and from a file */
+static void
+DoIndexTest(L_REGPARAMS  *rp,
+            l_int32       bigend,
+            l_int32       bigtiff)
+{
+char       buf[256];
+l_int32    ret;
+l_uint8   *data;
+l_uint64   offsets[3];
+size_t     size;
+FILE      *fp;
+L_DNA     *da;
+NUMA      *naw, *nah;
+
+    data = MakeTiffData(bigend, bigtiff, offsets, &size);
+    ret = tiffGetPageIndexMem(data, size, &da, &naw, &nah);
+    regTestCompareValues(rp, 0, ret, 0);
+    CheckIndex(rp, da, naw, nah, offsets, 3);
+    l_dnaDestroy(&da);
+    numaDestroy(&naw);
+    numaDestroy(&nah);
+
+    snprintf(buf, sizeof(buf), "/tmp/lept/tiffindex/index%d%d.tif",
+             bigend, bigtiff);
+    l_binaryWrite(buf, "w", data, size);
+    fp = lept_fopen(buf, "rb");
+    ret = tiffGetPageIndex(fp, &da, &naw, &nah);
+    lept_fclose(fp);
+    regTestCompareValues(rp, 0, ret, 0);
+    CheckIndex(rp, da, naw, nah, offsets, 3);
+    l_dnaDestroy(&da);
+    numaDestroy(&naw);
+    numaDestroy(&nah);
+    lept_free(data);
+}
+
+
+    /* Checks the first n pages of an index */
+static void
+CheckIndex(L_REGPARAMS  *rp,
+           L_DNA        *da,
+           NUMA         *naw,
+           NUMA         *nah,
+           l_uint64     *offsets,
+           l_int32       n)
+{
+l_int32    i, same;
+l_float32  w, h;
+l_float64  val;
+
+    regTestCompareValues(rp, n, l_dnaGetCount(da), 0);
+    same = TRUE;
+    for (i = 0; i < n; i++) {
+        l_dnaGetDValue(da, i, &val);
+        if ((l_uint64)val != offsets[i]) same = FALSE;
+    }
+    regTestCompareValues(rp, TRUE, same, 0);
+    if (!naw || !nah)
+        return;
+    for (i = 0; i < n; i++) {
+        numaGetFValue(naw, i, &w);
+        numaGetFValue(nah, i, &h);
+        regTestCompareValues(rp, Widths[i], w, 0);
+        regTestCompareValues(rp, Heights[i], h, 0);
+    }
+}
+
+
+    /* Makes tiff data of three pages, with only the directories.  Each
+     * directory has ImageWidth, ImageLength and Compression.  They are
+     * written in reverse page order, so the chain goes back in the
+     * file.  The width of the first page is a SHORT; the others are
+     * LONG, or LONG8 in BigTIFF. */
+static l_uint8 *
+MakeTiffData(l_int32    bigend,
+             l_int32    bigtiff,
+             l_uint64  *offsets,
+             size_t    *psize)
+{
+l_int32   i, j, countsize, entrysize, offsize, dirsize, type;
+l_uint8  *data, *entry;
+size_t    start;
+
+    countsize = (bigtiff) ? 8 : 2;
+    entrysize = (bigtiff) ? 20 : 12;
+    offsize = (bigtiff) ? 8 : 4;
+    dirsize = countsize + 3 * entrysize + offsize;
+    start = (bigtiff) ? 16 : 8;
+    *psize = start + 3 * dirsize;
+    data = (l_uint8 *)lept_calloc(*psize, 1);
+
+    data[0] = data[1] = (bigend) ? 'M' : 'I';
+    PutValue(data + 2, (bigtiff) ? 43 : 42, 2, bigend);
+    if (bigtiff)
+        PutValue(data + 4, 8, 2, bigend);
+    for (i = 0; i < 3; i++)
+        offsets[i] = start + (2 - i) * dirsize;
+    PutValue(data + start - offsize, offsets[0], offsize, bigend);
+
+    for (i = 0; i < 3; i++) {
+        PutValue(data + offsets[i], 3, countsize, bigend);
+        for (j = 0; j < 3; j++) {
+            entry = data + offsets[i] + countsize + j * entrysize;
+            if (j == 0) {
+                type = (i == 0) ? 3 : ((bigtiff && i == 2) ? 16 : 4);
+                PutValue(entry, 256, 2, bigend);
+                PutValue(entry + 4 + offsize, Widths[i],
+                         (type == 3) ? 2 : ((type == 4) ? 4 : 8), bigend);
+            } else if (j == 1) {
+                type = 4;
+                PutValue(entry, 257, 2, bigend);
+                PutValue(entry + 4 + offsize, Heights[i], 4, bigend);
+            } else {
+                type = 3;
+                PutValue(entry, 259, 2, bigend);
+                PutValue(entry + 4 + offsize, 1, 2, bigend);
+            }
+            PutValue(entry + 2, type, 2, bigend);
+            PutValue(entry + 4, 1, offsize, bigend);
+        }
+        PutValue(data + offsets[i] + countsize + 3 * entrysize,
+                 (i < 2) ? offsets[i + 1] : 0, offsize, bigend);
+    }
+    return data;
+}
+
+
+static void
+PutValue(l_uint8   *data,
+         l_uint64   val,
+         l_int32    nbytes,
+         l_int32    bigend)
+{
+l_int32  i;
+
+    for (i = 0; i < nbytes; i++) {
+        data[bigend ? nbytes - 1 - i : i] = val & 0xff;
+        val >>= 8;
+    }
+}
@@ -70,6 +70,10 @@
  *      Apply inverse background map to image
  *          PIX       *pixApplyInvBackgroundGrayMap()   8 bpp
  *          PIX       *pixApplyInvBackgroundRGBMap()    32 bpp
+ *          static void       applyInvMapLine()
+ *
+ *      Threads for bands of lines
+ *          static l_int32    getBandThreads()
  *
  *      Apply variable map
  *          PIX       *pixApplyVariableGrayMap()        8 bpp
@@ -131,9 +135,17 @@
  *      useful for improving the appearance of pages with very light
  *      foreground or very dark background, and where the local TRC
  *      function doesn't change rapidly with position.
+ *
+ *  With OpenMP, the tile averages of the background maps, the
+ *  application of the inverse maps and the tiled TRC of contrast
+ *  normalization are made on bands of lines in parallel.  The results
+ *  are the same as with one thread.
  * </pre>
  */
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
 #include "allheaders.h"
 
     /* Default input parameters for pixBackgroundNormSimple()
@@ -152,8 +164,21 @@ static const l_int32  DEFAULT_BG_VAL = 200;       /*!< default bg value      */
 static const l_int32  DEFAULT_X_SMOOTH_SIZE = 2;  /*!< default x smooth size */
 static const l_int32  DEFAULT_Y_SMOOTH_SIZE = 1;  /*!< default y smooth size */
 
+    /* Images with fewer pixels are done on a single thread */
+static const l_int32  MIN_PARALLEL_PIXELS = 1000000;
+
+static void applyInvMapLine(l_uint32 *lined, l_uint32 *lines,
+                            const l_uint16 *factors, l_int32 nbytes);
+static l_int32 getBandThreads(PIX *pixs, l_int32 nbands);
 static l_int32 *iaaGetLinearTRC(l_int32 **iaa, l_int32 diff);
 
+    /* Index of byte n of a line in memory, as accessed by GET_DATA_BYTE() */
+#ifdef  L_BIG_ENDIAN
+#define  MEMORY_BYTE_INDEX(n)   (n)
+#else  /* L_LITTLE_ENDIAN */
+#define  MEMORY_BYTE_INDEX(n)   ((n) ^ 3)
+#endif  /* L_BIG_ENDIAN */
+
 #ifndef  NO_CONSOLE_IO
 #define  DEBUG_GLOBAL    0    /*!< set to 1 to debug pixGlobalNormNoSatRGB() */
 #endif  /* ~NO_CONSOLE_IO */
@@ -842,6 +867,7 @@ PIX     *pixmr, *pixmg, *pixmb;
  *      (1) The background is measured in regions that don't have
  *          images.  It is then propagated into the image regions,
  *          and finally smoothed in each image region.
+ *      (2) With OpenMP, the rows of tiles are averaged in parallel.
  * </pre>
  */
 l_int32
@@ -854,7 +880,7 @@ pixGetBackgroundGrayMap(PIX     *pixs,
                         PIX    **ppixd)
 {
 l_int32    w, h, wd, hd, wim, him, wpls, wplim, wpld, wplf;
-l_int32    xim, yim, delx, nx, ny, i, j, k, m;
+l_int32    xim, yim, delx, nx, ny, i, j, k, m, nthreads;
 l_int32    count, sum, val8;
 l_int32    empty, fgpixels;
 l_uint32  *datas, *dataim, *datad, *dataf, *lines, *lineim, *lined, *linef;
@@ -920,6 +946,11 @@ PIX       *pixd, *piximi, *pixb, *pixf, *pixims;
     datad = pixGetData(pixd);
     wplf = pixGetWpl(pixf);
     dataf = pixGetData(pixf);
+    nthreads = getBandThreads(pixs, ny);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, k, m, lines, linef, lined, delx, sum, count, val8)
+#endif  /* _OPENMP */
     for (i = 0; i < ny; i++) {
         lines = datas + sy * i * wpls;
         linef = dataf + sy * i * wplf;
@@ -1020,6 +1051,7 @@ PIX       *pixd, *piximi, *pixb, *pixf, *pixims;
  *          use this internally to generate the foreground mask.
  *          Otherwise, a grayscale version of pixs will be generated
  *          from the green component only, used, and destroyed.
+ *      (2) With OpenMP, the rows of tiles are averaged in parallel.
  * </pre>
  */
 l_int32
@@ -1035,7 +1067,7 @@ pixGetBackgroundRGBMap(PIX     *pixs,
                        PIX    **ppixmb)
 {
 l_int32    w, h, wm, hm, wim, him, wpls, wplim, wplf;
-l_int32    xim, yim, delx, nx, ny, i, j, k, m;
+l_int32    xim, yim, delx, nx, ny, i, j, k, m, nthreads;
 l_int32    count, rsum, gsum, bsum, rval, gval, bval;
 l_int32    empty, fgpixels;
 l_uint32   pixel;
@@ -1105,6 +1137,12 @@ PIX       *pixmr, *pixmg, *pixmb;
     datas = pixGetData(pixs);
     wplf = pixGetWpl(pixf);
     dataf = pixGetData(pixf);
+    nthreads = getBandThreads(pixs, ny);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, k, m, lines, linef, delx, rsum, gsum, bsum, count, \
+                    pixel, rval, gval, bval)
+#endif  /* _OPENMP */
     for (i = 0; i < ny; i++) {
         lines = datas + sy * i * wpls;
         linef = dataf + sy * i * wplf;
@@ -1887,6 +1925,14 @@ PIX       *pixsm, *pixd;
  * \param[in]    sx tile width in pixels
  * \param[in]    sy tile height in pixels
  * \return  pixd 8 bpp, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each row of tiles is a band of sy lines.  The map values of
+ *          the band are spread into a factor for each byte of a line,
+ *          which applyInvMapLine() then applies to each line.
+ *      (2) With OpenMP, the bands are done in parallel.
+ * </pre>
  */
 PIX *
 pixApplyInvBackgroundGrayMap(PIX     *pixs,
@@ -1894,10 +1940,11 @@ pixApplyInvBackgroundGrayMap(PIX     *pixs,
                              l_int32  sx,
                              l_int32  sy)
 {
-l_int32    w, h, wm, hm, wpls, wpld, i, j, k, m, xoff, yoff;
-l_int32    vals, vald;
-l_uint32   val16;
-l_uint32  *datas, *datad, *lines, *lined, *flines, *flined;
+l_int32    w, h, wm, hm, wpls, wpld, wplm, i, j, k, m, xoff, yoff;
+l_int32    nthreads, error;
+l_uint16   val16;
+l_uint16  *factors;
+l_uint32  *datas, *datad, *datam, *lines, *lined, *linem;
 PIX       *pixd;
 
     PROCNAME("pixApplyInvBackgroundGrayMap");
@@ -1915,30 +1962,52 @@ PIX       *pixd;
     wpls = pixGetWpl(pixs);
     pixGetDimensions(pixs, &w, &h, NULL);
     pixGetDimensions(pixm, &wm, &hm, NULL);
+    datam = pixGetData(pixm);
+    wplm = pixGetWpl(pixm);
     if ((pixd = pixCreateTemplate(pixs)) == NULL)
         return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
-    for (i = 0; i < hm; i++) {
-        lines = datas + sy * i * wpls;
-        lined = datad + sy * i * wpld;
-        yoff = sy * i;
-        for (j = 0; j < wm; j++) {
-            pixGetPixel(pixm, j, i, &val16);
-            xoff = sx * j;
+
+        /* Bytes not under a tile keep a factor of 0, as they were
+         * left at 0 before. */
+    nthreads = getBandThreads(pixs, hm);
+    error = 0;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1) \
+            private(i, j, k, m, xoff, yoff, val16, factors, lines, lined, \
+                    linem) reduction(|:error)
+#endif  /* _OPENMP */
+    {
+        factors = (l_uint16 *)LEPT_CALLOC(4 * wpls, sizeof(l_uint16));
+        if (!factors)
+            error = 1;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif  /* _OPENMP */
+        for (i = 0; i < hm; i++) {
+            if (!factors) continue;
+            linem = datam + i * wplm;
+            for (j = 0; j < wm; j++) {
+                val16 = GET_DATA_TWO_BYTES(linem, j);
+                xoff = sx * j;
+                for (m = 0; m < sx && xoff + m < w; m++)
+                    factors[MEMORY_BYTE_INDEX(xoff + m)] = val16;
+            }
+            yoff = sy * i;
             for (k = 0; k < sy && yoff + k < h; k++) {
-                flines = lines + k * wpls;
-                flined = lined + k * wpld;
-                for (m = 0; m < sx && xoff + m < w; m++) {
-                    vals = GET_DATA_BYTE(flines, xoff + m);
-                    vald = (vals * val16) / 256;
-                    vald = L_MIN(vald, 255);
-                    SET_DATA_BYTE(flined, xoff + m, vald);
-                }
+                lines = datas + (yoff + k) * wpls;
+                lined = datad + (yoff + k) * wpld;
+                applyInvMapLine(lined, lines, factors, 4 * wpls);
             }
         }
+        LEPT_FREE(factors);
     }
 
+    if (error) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("factors not made", procName, NULL);
+    }
     return pixd;
 }
 
@@ -1953,6 +2022,15 @@ PIX       *pixd;
  * \param[in]    sx tile width in pixels
  * \param[in]    sy tile height in pixels
  * \return  pixd 32 bpp rbg, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) As in pixApplyInvBackgroundGrayMap(), each line of a band of
+ *          sy lines is scaled byte by byte, here with the red, green
+ *          and blue factors interleaved as the components of the
+ *          pixels.  The factor of the 4th byte is 0, so it is cleared.
+ *      (2) With OpenMP, the bands are done in parallel.
+ * </pre>
  */
 PIX *
 pixApplyInvBackgroundRGBMap(PIX     *pixs,
@@ -1962,11 +2040,11 @@ pixApplyInvBackgroundRGBMap(PIX     *pixs,
                             l_int32  sx,
                             l_int32  sy)
 {
-l_int32    w, h, wm, hm, wpls, wpld, i, j, k, m, xoff, yoff;
-l_int32    rvald, gvald, bvald;
-l_uint32   vals;
-l_uint32   rval16, gval16, bval16;
-l_uint32  *datas, *datad, *lines, *lined, *flines, *flined;
+l_int32    w, h, wm, hm, wpls, wpld, wplm, i, j, k, m, xoff, yoff, n;
+l_int32    nthreads, error;
+l_uint16   rval16, gval16, bval16;
+l_uint16  *factors;
+l_uint32  *datas, *datad, *datamr, *datamg, *datamb, *lines, *lined;
 PIX       *pixd;
 
     PROCNAME("pixApplyInvBackgroundRGBMap");
@@ -1989,40 +2067,125 @@ PIX       *pixd;
     h = pixGetHeight(pixs);
     wm = pixGetWidth(pixmr);
     hm = pixGetHeight(pixmr);
+    if (pixGetWidth(pixmg) < wm || pixGetHeight(pixmg) < hm ||
+        pixGetWidth(pixmb) < wm || pixGetHeight(pixmb) < hm)
+        return (PIX *)ERROR_PTR("pix maps not all the same size",
+                                procName, NULL);
+    datamr = pixGetData(pixmr);
+    datamg = pixGetData(pixmg);
+    datamb = pixGetData(pixmb);
+    wplm = pixGetWpl(pixmr);
     if ((pixd = pixCreateTemplate(pixs)) == NULL)
         return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
-    for (i = 0; i < hm; i++) {
-        lines = datas + sy * i * wpls;
-        lined = datad + sy * i * wpld;
-        yoff = sy * i;
-        for (j = 0; j < wm; j++) {
-            pixGetPixel(pixmr, j, i, &rval16);
-            pixGetPixel(pixmg, j, i, &gval16);
-            pixGetPixel(pixmb, j, i, &bval16);
-            xoff = sx * j;
-            for (k = 0; k < sy && yoff + k < h; k++) {
-                flines = lines + k * wpls;
-                flined = lined + k * wpld;
+
+    nthreads = getBandThreads(pixs, hm);
+    error = 0;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1) \
+            private(i, j, k, m, n, xoff, yoff, rval16, gval16, bval16, \
+                    factors, lines, lined) reduction(|:error)
+#endif  /* _OPENMP */
+    {
+        factors = (l_uint16 *)LEPT_CALLOC(4 * wpls, sizeof(l_uint16));
+        if (!factors)
+            error = 1;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif  /* _OPENMP */
+        for (i = 0; i < hm; i++) {
+            if (!factors) continue;
+            for (j = 0; j < wm; j++) {
+                rval16 = GET_DATA_TWO_BYTES(datamr + i * wplm, j);
+                gval16 = GET_DATA_TWO_BYTES(datamg + i * wplm, j);
+                bval16 = GET_DATA_TWO_BYTES(datamb + i * wplm, j);
+                xoff = sx * j;
                 for (m = 0; m < sx && xoff + m < w; m++) {
-                    vals = *(flines + xoff + m);
-                    rvald = ((vals >> 24) * rval16) / 256;
-                    rvald = L_MIN(rvald, 255);
-                    gvald = (((vals >> 16) & 0xff) * gval16) / 256;
-                    gvald = L_MIN(gvald, 255);
-                    bvald = (((vals >> 8) & 0xff) * bval16) / 256;
-                    bvald = L_MIN(bvald, 255);
-                    composeRGBPixel(rvald, gvald, bvald, flined + xoff + m);
+                    n = 4 * (xoff + m);
+                    factors[MEMORY_BYTE_INDEX(n)] = rval16;
+                    factors[MEMORY_BYTE_INDEX(n + 1)] = gval16;
+                    factors[MEMORY_BYTE_INDEX(n + 2)] = bval16;
                 }
             }
+            yoff = sy * i;
+            for (k = 0; k < sy && yoff + k < h; k++) {
+                lines = datas + (yoff + k) * wpls;
+                lined = datad + (yoff + k) * wpld;
+                applyInvMapLine(lined, lines, factors, 4 * wpls);
+            }
         }
+        LEPT_FREE(factors);
     }
 
+    if (error) {
+        pixDestroy(&pixd);
+        return (PIX *)ERROR_PTR("factors not made", procName, NULL);
+    }
     return pixd;
 }
 
 
+/*!
+ * \brief   applyInvMapLine()
+ *
+ * \param[in]    lined     dest line
+ * \param[in]    lines     src line
+ * \param[in]    factors   8.8 factor for each byte, in memory order
+ * \param[in]    nbytes    number of bytes in the line
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each dest byte is min(255, (src byte * factor) / 256).  The
+ *          part that scaleBytesLineSimd() leaves is done here.
+ * </pre>
+ */
+static void
+applyInvMapLine(l_uint32        *lined,
+                l_uint32        *lines,
+                const l_uint16  *factors,
+                l_int32          nbytes)
+{
+l_int32   j, val;
+l_uint8  *bytess, *bytesd;
+
+    j = scaleBytesLineSimd(lined, lines, factors, nbytes);
+    bytess = (l_uint8 *)lines;
+    bytesd = (l_uint8 *)lined;
+    for (; j < nbytes; j++) {
+        val = ((l_int32)bytess[j] * factors[j]) >> 8;
+        bytesd[j] = L_MIN(val, 255);
+    }
+}
+
+
+/*------------------------------------------------------------------*
+ *                   Threads for bands of lines                     *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   getBandThreads()
+ *
+ * \param[in]    pixs     image being processed
+ * \param[in]    nbands   number of bands it is split into
+ * \return  number of threads to use; 1 without OpenMP
+ */
+static l_int32
+getBandThreads(PIX     *pixs,
+               l_int32  nbands)
+{
+l_int32  nthreads;
+
+    nthreads = 1;
+#ifdef _OPENMP
+    if ((l_float64)pixGetWidth(pixs) * pixGetHeight(pixs) >=
+        MIN_PARALLEL_PIXELS)
+        nthreads = L_MAX(1, L_MIN(omp_get_max_threads(), nbands));
+#endif  /* _OPENMP */
+    return nthreads;
+}
+
+
 /*------------------------------------------------------------------*
  *                         Apply variable map                       *
  *------------------------------------------------------------------*/
@@ -2812,6 +2975,8 @@ l_uint32  *data1, *data2, *line1, *line2;
  *          max value in the tile becomes 255.
  *      (5) The LUTs that do the mapping are generated as needed
  *          and stored for reuse in an integer array within the ptr array iaa[].
+ *      (6) All the LUTs are made before mapping, and with OpenMP the
+ *          rows of tiles are then mapped in parallel.
  * </pre>
  */
 PIX *
@@ -2822,7 +2987,7 @@ pixLinearTRCTiled(PIX       *pixd,
                   PIX       *pixmin,
                   PIX       *pixmax)
 {
-l_int32    i, j, k, m, w, h, wt, ht, wpl, wplt, xoff, yoff;
+l_int32    i, j, k, m, w, h, wt, ht, wpl, wplt, xoff, yoff, nthreads;
 l_int32    minval, maxval, val, sval;
 l_int32   *ia;
 l_int32  **iaa;
@@ -2852,6 +3017,25 @@ l_uint32  *data, *datamin, *datamax, *line, *tline, *linemin, *linemax;
     datamax = pixGetData(pixmax);
     wplt = pixGetWpl(pixmin);
     pixGetDimensions(pixmin, &wt, &ht, NULL);
+
+        /* Make all the TRCs first, so that the bands only read them */
+    for (i = 0; i < ht; i++) {
+        linemin = datamin + i * wplt;
+        linemax = datamax + i * wplt;
+        for (j = 0; j < wt; j++) {
+            minval = GET_DATA_BYTE(linemin, j);
+            maxval = GET_DATA_BYTE(linemax, j);
+            if (maxval != minval)
+                iaaGetLinearTRC(iaa, maxval - minval);
+        }
+    }
+
+    nthreads = getBandThreads(pixs, ht);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, k, m, line, linemin, linemax, yoff, xoff, minval, \
+                    maxval, ia, tline, val, sval)
+#endif  /* _OPENMP */
     for (i = 0; i < ht; i++) {
         line = data + sy * i * wpl;
         linemin = datamin + i * wplt;
@@ -2866,7 +3050,7 @@ l_uint32  *data, *datamin, *datamax, *line, *tline, *linemin, *linemax;
                         i, j, minval); */
                 continue;
             }
-            ia = iaaGetLinearTRC(iaa, maxval - minval);
+            ia = iaa[maxval - minval];
             for (k = 0; k < sy && yoff + k < h; k++) {
                 tline = line + k * wpl;
                 for (m = 0; m < sx && xoff + m < w; m++) {
@@ -413,6 +413,7 @@ LEPT_DLL extern CCBORDA * ccbaRead ( const char *filename );
 LEPT_DLL extern CCBORDA * ccbaReadStream ( FILE *fp );
 LEPT_DLL extern l_int32 ccbaWriteSVG ( const char *filename, CCBORDA *ccba );
 LEPT_DLL extern char * ccbaWriteSVGString ( const char *filename, CCBORDA *ccba );
+LEPT_DLL extern PIX * pixReadMemCcitt ( const l_uint8 *data, size_t size, l_int32 w, l_int32 h, l_int32 k, l_int32 bytealign );
 LEPT_DLL extern PIXA * pixaThinConnected ( PIXA *pixas, l_int32 type, l_int32 connectivity, l_int32 maxiters );
 LEPT_DLL extern PIX * pixThinConnected ( PIX *pixs, l_int32 type, l_int32 connectivity, l_int32 maxiters );
 LEPT_DLL extern PIX * pixThinConnectedBySet ( PIX *pixs, l_int32 type, SELA *sela, l_int32 maxiters );
@@ -600,6 +601,7 @@ LEPT_DLL extern BOXA * pixConnComp ( PIX *pixs, PIXA **ppixa, l_int32 connectivi
 LEPT_DLL extern BOXA * pixConnCompPixa ( PIX *pixs, PIXA **ppixa, l_int32 connectivity );
 LEPT_DLL extern BOXA * pixConnCompBB ( PIX *pixs, l_int32 connectivity );
 LEPT_DLL extern l_int32 pixCountConnComp ( PIX *pixs, l_int32 connectivity, l_int32 *pcount );
+LEPT_DLL extern BOXA * pixConnCompRuns ( PIX *pixs, l_int32 connectivity, NUMA **pnaa, PIX **ppixl, l_int32 nthreads );
 LEPT_DLL extern l_int32 nextOnPixelInRaster ( PIX *pixs, l_int32 xstart, l_int32 ystart, l_int32 *px, l_int32 *py );
 LEPT_DLL extern l_int32 nextOnPixelInRasterLow ( l_uint32 *data, l_int32 w, l_int32 h, l_int32 wpl, l_int32 xstart, l_int32 ystart, l_int32 *px, l_int32 *py );
 LEPT_DLL extern BOX * pixSeedfillBB ( PIX *pixs, L_STACK *stack, l_int32 x, l_int32 y, l_int32 connectivity );
@@ -620,6 +622,9 @@ LEPT_DLL extern PIX * pixWindowedMean ( PIX *pixs, l_int32 wc, l_int32 hc, l_int
 LEPT_DLL extern PIX * pixWindowedMeanSquare ( PIX *pixs, l_int32 wc, l_int32 hc, l_int32 hasborder );
 LEPT_DLL extern l_int32 pixWindowedVariance ( PIX *pixm, PIX *pixms, FPIX **pfpixv, FPIX **pfpixrv );
 LEPT_DLL extern DPIX * pixMeanSquareAccum ( PIX *pixs );
+LEPT_DLL extern l_int32 pixWindowedAccums ( PIX *pixs, PIX **ppixacc, DPIX **pdpixacc );
+LEPT_DLL extern PIX * pixWindowedMeanFromAccum ( PIX *pixacc, l_int32 wc, l_int32 hc, l_int32 d, l_int32 normflag );
+LEPT_DLL extern PIX * pixWindowedMeanSquareFromAccum ( DPIX *dpixacc, l_int32 wc, l_int32 hc );
 LEPT_DLL extern PIX * pixBlockrank ( PIX *pixs, PIX *pixacc, l_int32 wc, l_int32 hc, l_float32 rank );
 LEPT_DLL extern PIX * pixBlocksum ( PIX *pixs, PIX *pixacc, l_int32 wc, l_int32 hc );
 LEPT_DLL extern PIX * pixCensusTransform ( PIX *pixs, l_int32 halfsize, PIX *pixacc );
@@ -914,6 +919,7 @@ LEPT_DLL extern FPIX * fpixProjective ( FPIX *fpixs, l_float32 *vc, l_float32 in
 LEPT_DLL extern l_int32 linearInterpolatePixelFloat ( l_float32 *datas, l_int32 w, l_int32 h, l_float32 x, l_float32 y, l_float32 inval, l_float32 *pval );
 LEPT_DLL extern PIX * fpixThresholdToPix ( FPIX *fpix, l_float32 thresh );
 LEPT_DLL extern FPIX * pixComponentFunction ( PIX *pix, l_float32 rnum, l_float32 gnum, l_float32 bnum, l_float32 rdenom, l_float32 gdenom, l_float32 bdenom );
+LEPT_DLL extern l_int32 g4EncodePix ( PIX *pixs, l_uint8 **pdata, size_t *pnbytes );
 LEPT_DLL extern PIX * pixReadStreamGif ( FILE *fp );
 LEPT_DLL extern l_int32 pixWriteStreamGif ( FILE *fp, PIX *pix );
 LEPT_DLL extern PIX * pixReadMemGif ( const l_uint8 *cdata, size_t size );
@@ -1055,6 +1061,7 @@ LEPT_DLL extern JBDATA * jbDataRead ( const char *rootname );
 LEPT_DLL extern PIXA * jbDataRender ( JBDATA *data, l_int32 debugflag );
 LEPT_DLL extern l_int32 jbGetULCorners ( JBCLASSER *classer, PIX *pixs, BOXA *boxa );
 LEPT_DLL extern l_int32 jbGetLLCorners ( JBCLASSER *classer );
+LEPT_DLL extern l_int32 jbig2EncodeGeneric ( PIX *pixs, l_int32 fullheaders, l_uint8 **pdata, size_t *pnbytes );
 LEPT_DLL extern l_int32 readHeaderJp2k ( const char *filename, l_int32 *pw, l_int32 *ph, l_int32 *pbps, l_int32 *pspp );
 LEPT_DLL extern l_int32 freadHeaderJp2k ( FILE *fp, l_int32 *pw, l_int32 *ph, l_int32 *pbps, l_int32 *pspp );
 LEPT_DLL extern l_int32 readHeaderMemJp2k ( const l_uint8 *data, size_t size, l_int32 *pw, l_int32 *ph, l_int32 *pbps, l_int32 *pspp );
@@ -1077,6 +1084,7 @@ LEPT_DLL extern PIX * pixReadMemJpeg ( const l_uint8 *data, size_t size, l_int32
 LEPT_DLL extern l_int32 readHeaderMemJpeg ( const l_uint8 *data, size_t size, l_int32 *pw, l_int32 *ph, l_int32 *pspp, l_int32 *pycck, l_int32 *pcmyk );
 LEPT_DLL extern l_int32 pixWriteMemJpeg ( l_uint8 **pdata, size_t *psize, PIX *pix, l_int32 quality, l_int32 progressive );
 LEPT_DLL extern l_int32 pixSetChromaSampling ( PIX *pix, l_int32 sampling );
+LEPT_DLL extern l_int32 pixSetJpegFastEncode ( PIX *pix, l_int32 fast );
 LEPT_DLL extern L_KERNEL * kernelCreate ( l_int32 height, l_int32 width );
 LEPT_DLL extern void kernelDestroy ( L_KERNEL **pkel );
 LEPT_DLL extern L_KERNEL * kernelCopy ( L_KERNEL *kels );
@@ -1803,6 +1811,10 @@ LEPT_DLL extern void * pmsGetAlloc ( size_t nbytes );
 LEPT_DLL extern l_int32 pmsGetLevelForAlloc ( size_t nbytes, l_int32 *plevel );
 LEPT_DLL extern l_int32 pmsGetLevelForDealloc ( void *data, l_int32 *plevel );
 LEPT_DLL extern void pmsLogInfo (  );
+LEPT_DLL extern void * pixPoolAlloc ( size_t nbytes );
+LEPT_DLL extern void pixPoolDealloc ( void *data );
+LEPT_DLL extern l_int32 pixPoolSetLimit ( size_t maxbytes );
+LEPT_DLL extern l_int32 pixPoolGetInfo ( size_t *pidlebytes, size_t *phits, size_t *pmisses );
 LEPT_DLL extern l_int32 pixAddConstantGray ( PIX *pixs, l_int32 val );
 LEPT_DLL extern l_int32 pixMultConstantGray ( PIX *pixs, l_float32 val );
 LEPT_DLL extern PIX * pixAddGray ( PIX *pixd, PIX *pixs1, PIX *pixs2 );
@@ -1932,6 +1944,7 @@ LEPT_DLL extern l_int32 pixTilingGetSize ( PIXTILING *pt, l_int32 *pw, l_int32 *
 LEPT_DLL extern PIX * pixTilingGetTile ( PIXTILING *pt, l_int32 i, l_int32 j );
 LEPT_DLL extern l_int32 pixTilingNoStripOnPaint ( PIXTILING *pt );
 LEPT_DLL extern l_int32 pixTilingPaintTile ( PIX *pixd, l_int32 i, l_int32 j, PIX *pixs, PIXTILING *pt );
+LEPT_DLL extern l_int32 pixTilingProcess ( PIXTILING *pt, L_TILE_FUNC func, void *data, PIX **pixdarray, l_int32 ndest, l_int32 nthreads );
 LEPT_DLL extern PIX * pixReadStreamPng ( FILE *fp );
 LEPT_DLL extern l_int32 readHeaderPng ( const char *filename, l_int32 *pw, l_int32 *ph, l_int32 *pbps, l_int32 *pspp, l_int32 *piscmap );
 LEPT_DLL extern l_int32 freadHeaderPng ( FILE *fp, l_int32 *pw, l_int32 *ph, l_int32 *pbps, l_int32 *pspp, l_int32 *piscmap );
@@ -1942,6 +1955,7 @@ LEPT_DLL extern l_int32 fgetPngColormapInfo ( FILE *fp, PIXCMAP **pcmap, l_int32
 LEPT_DLL extern l_int32 pixWritePng ( const char *filename, PIX *pix, l_float32 gamma );
 LEPT_DLL extern l_int32 pixWriteStreamPng ( FILE *fp, PIX *pix, l_float32 gamma );
 LEPT_DLL extern l_int32 pixSetZlibCompression ( PIX *pix, l_int32 compval );
+LEPT_DLL extern l_int32 pixSetZlibFastEncode ( PIX *pix );
 LEPT_DLL extern void l_pngSetReadStrip16To8 ( l_int32 flag );
 LEPT_DLL extern PIX * pixReadMemPng ( const l_uint8 *filedata, size_t filesize );
 LEPT_DLL extern l_int32 pixWriteMemPng ( l_uint8 **pfiledata, size_t *pfilesize, PIX *pix, l_float32 gamma );
@@ -2165,6 +2179,10 @@ LEPT_DLL extern PIX * pixRead ( const char *filename );
 LEPT_DLL extern PIX * pixReadWithHint ( const char *filename, l_int32 hint );
 LEPT_DLL extern PIX * pixReadIndexed ( SARRAY *sa, l_int32 index );
 LEPT_DLL extern PIX * pixReadStream ( FILE *fp, l_int32 hint );
+LEPT_DLL extern PIX * pixReadMapped ( const char *filename );
+LEPT_DLL extern PIX * pixReadReduced ( const char *filename, l_int32 minres, l_int32 minsize );
+LEPT_DLL extern PIX * pixReadStreamReduced ( FILE *fp, l_int32 minres, l_int32 minsize );
+LEPT_DLL extern PIX * pixReadMemReduced ( const l_uint8 *data, size_t size, l_int32 minres, l_int32 minsize );
 LEPT_DLL extern l_int32 pixReadHeader ( const char *filename, l_int32 *pformat, l_int32 *pw, l_int32 *ph, l_int32 *pbps, l_int32 *pspp, l_int32 *piscmap );
 LEPT_DLL extern l_int32 findFileFormat ( const char *filename, l_int32 *pformat );
 LEPT_DLL extern l_int32 findFileFormatStream ( FILE *fp, l_int32 *pformat );
@@ -2246,6 +2264,7 @@ LEPT_DLL extern l_int32 regTestCheckFile ( L_REGPARAMS *rp, const char *localnam
 LEPT_DLL extern l_int32 regTestCompareFiles ( L_REGPARAMS *rp, l_int32 index1, l_int32 index2 );
 LEPT_DLL extern l_int32 regTestWritePixAndCheck ( L_REGPARAMS *rp, PIX *pix, l_int32 format );
 LEPT_DLL extern char * regTestGenLocalFilename ( L_REGPARAMS *rp, l_int32 index, l_int32 format );
+LEPT_DLL extern l_int32 regTestTimeLoop ( L_REGPARAMS *rp, const char *opname, PIX *pixs );
 LEPT_DLL extern l_int32 pixRasterop ( PIX *pixd, l_int32 dx, l_int32 dy, l_int32 dw, l_int32 dh, l_int32 op, PIX *pixs, l_int32 sx, l_int32 sy );
 LEPT_DLL extern l_int32 pixRasteropVip ( PIX *pixd, l_int32 bx, l_int32 bw, l_int32 vshift, l_int32 incolor );
 LEPT_DLL extern l_int32 pixRasteropHip ( PIX *pixd, l_int32 by, l_int32 bh, l_int32 hshift, l_int32 incolor );
@@ -2512,6 +2531,18 @@ LEPT_DLL extern l_int32 pixHShearIP ( PIX *pixs, l_int32 yloc, l_float32 radang,
 LEPT_DLL extern l_int32 pixVShearIP ( PIX *pixs, l_int32 xloc, l_float32 radang, l_int32 incolor );
 LEPT_DLL extern PIX * pixHShearLI ( PIX *pixs, l_int32 yloc, l_float32 radang, l_int32 incolor );
 LEPT_DLL extern PIX * pixVShearLI ( PIX *pixs, l_int32 xloc, l_float32 radang, l_int32 incolor );
+LEPT_DLL extern l_int32 setSimdLevel ( l_int32 newlevel );
+LEPT_DLL extern l_int32 rgbToGrayLineSimd ( l_uint32 *lined, const l_uint32 *lines, l_int32 w, l_float32 rwt, l_float32 gwt, l_float32 bwt );
+LEPT_DLL extern l_int32 rgbToGreenLineSimd ( l_uint32 *lined, const l_uint32 *lines, l_int32 w );
+LEPT_DLL extern l_int32 thresholdToBinaryLineSimd ( l_uint32 *lined, l_int32 w, const l_uint32 *lines, l_int32 thresh );
+LEPT_DLL extern l_int32 interpolateGrayLinesSimd ( l_int32 *sums, l_int32 w, const l_uint32 *line0, const l_uint32 *line1, l_int32 frac );
+LEPT_DLL extern l_int32 scaleGrayLILineSimd ( l_uint32 *lined, l_int32 wd, const l_int32 *sums, const l_int32 *xleft, const l_int32 *xright, const l_int32 *xfrac );
+LEPT_DLL extern l_int32 accumulateGrayLineSimd ( l_uint32 *sums, l_int32 w, const l_uint32 *line, l_int32 weight );
+LEPT_DLL extern l_int32 scaleToGray2LineSimd ( l_uint32 *lined, l_int32 wd, const l_uint32 *lines, l_int32 wpls, const l_uint8 *valtab );
+LEPT_DLL extern l_int32 countPixelsLineSimd ( const l_uint32 *line, l_int32 w, l_int32 *pcount );
+LEPT_DLL extern l_int32 scaleBytesLineSimd ( l_uint32 *lined, const l_uint32 *lines, const l_uint16 *factors, l_int32 nbytes );
+LEPT_DLL extern l_int32 transposeTileSimd ( l_uint32 *datad, l_int32 wpld, const l_uint32 *datas, l_int32 wpls, l_int32 size, l_int32 d );
+LEPT_DLL extern l_int32 rasteropWordsSimd ( l_uint32 *datad, l_int32 wpld, const l_uint32 *datas, l_int32 wpls, l_int32 nwords, l_int32 h, l_int32 op, l_int32 shift );
 LEPT_DLL extern PIX * pixDeskewBoth ( PIX *pixs, l_int32 redsearch );
 LEPT_DLL extern PIX * pixDeskew ( PIX *pixs, l_int32 redsearch );
 LEPT_DLL extern PIX * pixFindSkewAndDeskew ( PIX *pixs, l_int32 redsearch, l_float32 *pangle, l_float32 *pconf );
@@ -2591,10 +2622,13 @@ LEPT_DLL extern l_int32 findTiffCompression ( FILE *fp, l_int32 *pcomptype );
 LEPT_DLL extern l_int32 extractG4DataFromFile ( const char *filein, l_uint8 **pdata, size_t *pnbytes, l_int32 *pw, l_int32 *ph, l_int32 *pminisblack );
 LEPT_DLL extern PIX * pixReadMemTiff ( const l_uint8 *cdata, size_t size, l_int32 n );
 LEPT_DLL extern PIX * pixReadMemFromMultipageTiff ( const l_uint8 *cdata, size_t size, size_t *poffset );
+LEPT_DLL extern PIX * pixReadMemTiffPage ( const l_uint8 *cdata, size_t size, size_t offset );
 LEPT_DLL extern PIXA * pixaReadMemMultipageTiff ( const l_uint8 *data, size_t size );
 LEPT_DLL extern l_int32 pixaWriteMemMultipageTiff ( l_uint8 **pdata, size_t *psize, PIXA *pixa );
 LEPT_DLL extern l_int32 pixWriteMemTiff ( l_uint8 **pdata, size_t *psize, PIX *pix, l_int32 comptype );
 LEPT_DLL extern l_int32 pixWriteMemTiffCustom ( l_uint8 **pdata, size_t *psize, PIX *pix, l_int32 comptype, NUMA *natags, SARRAY *savals, SARRAY *satypes, NUMA *nasizes );
+LEPT_DLL extern l_int32 tiffGetPageIndex ( FILE *fp, L_DNA **pdaoffset, NUMA **pnaw, NUMA **pnah );
+LEPT_DLL extern l_int32 tiffGetPageIndexMem ( const l_uint8 *cdata, size_t size, L_DNA **pdaoffset, NUMA **pnaw, NUMA **pnah );
 LEPT_DLL extern l_int32 setMsgSeverity ( l_int32 newsev );
 LEPT_DLL extern l_int32 returnErrorInt ( const char *msg, const char *procname, l_int32 ival );
 LEPT_DLL extern l_float32 returnErrorFloat ( const char *msg, const char *procname, l_float32 fval );
@@ -2646,6 +2680,8 @@ LEPT_DLL extern l_uint8 * l_binaryRead ( const char *filename, size_t *pnbytes )
 LEPT_DLL extern l_uint8 * l_binaryReadStream ( FILE *fp, size_t *pnbytes );
 LEPT_DLL extern l_uint8 * l_binaryReadSelect ( const char *filename, size_t start, size_t nbytes, size_t *pnread );
 LEPT_DLL extern l_uint8 * l_binaryReadSelectStream ( FILE *fp, size_t start, size_t nbytes, size_t *pnread );
+LEPT_DLL extern l_uint8 * l_binaryMap ( const char *filename, size_t *pnbytes );
+LEPT_DLL extern l_int32 l_binaryUnmap ( l_uint8 *data, size_t nbytes );
 LEPT_DLL extern l_int32 l_binaryWrite ( const char *filename, const char *operation, void *data, size_t nbytes );
 LEPT_DLL extern size_t nbytesInFile ( const char *filename );
 LEPT_DLL extern size_t fnbytesInFile ( FILE *fp );
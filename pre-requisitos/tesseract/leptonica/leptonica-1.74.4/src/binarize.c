@@ -78,6 +78,31 @@
 #include <math.h>
 #include "allheaders.h"
 
+    /* Parameters and results of the tile operations, which are run
+     * by pixTilingProcess() */
+struct OtsuTileData
+{
+    l_float32   scorefract;
+    l_int32     nx;
+    l_int32    *thresh;    /* for each tile, in raster order */
+    PIX        *pixth;     /* the thresholds for binarizing, 1 per tile */
+};
+
+struct SauvolaTileData
+{
+    l_int32     whsize;
+    l_float32   factor;
+    l_int32     getth;     /* make the tile of threshold values */
+    l_int32     getd;      /* make the binarized tile */
+};
+
+static l_int32 otsuThreshTile(PIX *pixt, l_int32 i, l_int32 j, PIX **ppixd,
+                              void *data);
+static l_int32 otsuBinarizeTile(PIX *pixt, l_int32 i, l_int32 j,
+                                PIX **ppixd, void *data);
+static l_int32 sauvolaTile(PIX *pixt, l_int32 i, l_int32 j, PIX **ppixd,
+                           void *data);
+
 /*------------------------------------------------------------------*
  *                 Adaptive Otsu-based thresholding                 *
  *------------------------------------------------------------------*/
@@ -146,10 +171,10 @@ pixOtsuAdaptiveThreshold(PIX       *pixs,
                          PIX      **ppixth,
                          PIX      **ppixd)
 {
-l_int32     w, h, nx, ny, i, j, thresh;
-l_uint32    val;
-PIX        *pixt, *pixb, *pixthresh, *pixth, *pixd;
-PIXTILING  *pt;
+l_int32                w, h, nx, ny, i, j, thresh;
+PIX                   *pixthresh, *pixth, *pixd;
+PIXTILING             *pt;
+struct OtsuTileData    otsudata;
 
     PROCNAME("pixOtsuAdaptiveThreshold");
 
@@ -170,15 +195,22 @@ PIXTILING  *pt;
     smoothy = L_MIN(smoothy, (ny - 1) / 2);
     pt = pixTilingCreate(pixs, nx, ny, 0, 0, 0, 0);
     pixthresh = pixCreate(nx, ny, 8);
+    otsudata.scorefract = scorefract;
+    otsudata.nx = nx;
+    if ((otsudata.thresh = (l_int32 *)LEPT_CALLOC(nx * ny,
+                                                  sizeof(l_int32))) == NULL) {
+        pixDestroy(&pixthresh);
+        pixTilingDestroy(&pt);
+        return ERROR_INT("thresh not made", procName, 1);
+    }
+    pixTilingProcess(pt, otsuThreshTile, &otsudata, NULL, 0, 0);
     for (i = 0; i < ny; i++) {
         for (j = 0; j < nx; j++) {
-            pixt = pixTilingGetTile(pt, i, j);
-            pixSplitDistributionFgBg(pixt, scorefract, 1, &thresh,
-                                     NULL, NULL, NULL);
+            thresh = otsudata.thresh[i * nx + j];
             pixSetPixel(pixthresh, j, i, thresh);  /* see note (4) */
-            pixDestroy(&pixt);
         }
     }
+    LEPT_FREE(otsudata.thresh);
 
         /* Optionally smooth the threshold array */
     if (smoothx > 0 || smoothy > 0)
@@ -191,16 +223,8 @@ PIXTILING  *pt;
     if (ppixd) {
         pixd = pixCreate(w, h, 1);
         pixCopyResolution(pixd, pixs);
-        for (i = 0; i < ny; i++) {
-            for (j = 0; j < nx; j++) {
-                pixt = pixTilingGetTile(pt, i, j);
-                pixGetPixel(pixth, j, i, &val);
-                pixb = pixThresholdToBinary(pixt, val);
-                pixTilingPaintTile(pixd, i, j, pixb, pt);
-                pixDestroy(&pixt);
-                pixDestroy(&pixb);
-            }
-        }
+        otsudata.pixth = pixth;
+        pixTilingProcess(pt, otsuBinarizeTile, &otsudata, &pixd, 1, 0);
         *ppixd = pixd;
     }
 
@@ -457,7 +481,8 @@ PIX      *pixn, *pixm, *pixd, *pix1, *pix2, *pix3, *pix4;
  *              The mean square accumulator array for 16M pixels is 128 MB.
  *              Using tiles reduces the size of these arrays.
  *          (c) Each tile can be processed independently, in parallel,
- *              on a multicore processor.
+ *              on a multicore processor.  This is done with OpenMP;
+ *              see pixTilingProcess().
  *      (4) The Sauvola threshold is determined from the formula:
  *              t = m * (1 - k * (1 - s / 128))
  *          See pixSauvolaBinarize() for details.
@@ -472,10 +497,11 @@ pixSauvolaBinarizeTiled(PIX       *pixs,
                         PIX      **ppixth,
                         PIX      **ppixd)
 {
-l_int32     i, j, w, h, xrat, yrat;
-PIX        *pixth, *pixd, *tileth, *tiled, *pixt;
-PIX       **ptileth, **ptiled;
-PIXTILING  *pt;
+l_int32                  w, h, xrat, yrat;
+PIX                     *pixth, *pixd;
+PIX                     *pixdarray[2];
+PIXTILING               *pt;
+struct SauvolaTileData   sauvoladata;
 
     PROCNAME("pixSauvolaBinarizeTiled");
 
@@ -517,6 +543,7 @@ PIXTILING  *pt;
                                   ppixth, ppixd);
 
         /* We can use pixtiling for painting both outputs, if requested */
+    pixth = pixd = NULL;
     if (ppixth) {
         pixth = pixCreateNoInit(w, h, 8);
         *ppixth = pixth;
@@ -527,31 +554,87 @@ PIXTILING  *pt;
     }
     pt = pixTilingCreate(pixs, nx, ny, 0, 0, whsize + 1, whsize + 1);
     pixTilingNoStripOnPaint(pt);  /* pixSauvolaBinarize() does the stripping */
-
-    for (i = 0; i < ny; i++) {
-        for (j = 0; j < nx; j++) {
-            pixt = pixTilingGetTile(pt, i, j);
-            ptileth = (ppixth) ? &tileth : NULL;
-            ptiled = (ppixd) ? &tiled : NULL;
-            pixSauvolaBinarize(pixt, whsize, factor, 0, NULL, NULL,
-                               ptileth, ptiled);
-            if (ppixth) {  /* do not strip */
-                pixTilingPaintTile(pixth, i, j, tileth, pt);
-                pixDestroy(&tileth);
-            }
-            if (ppixd) {
-                pixTilingPaintTile(pixd, i, j, tiled, pt);
-                pixDestroy(&tiled);
-            }
-            pixDestroy(&pixt);
-        }
-    }
+    sauvoladata.whsize = whsize;
+    sauvoladata.factor = factor;
+    sauvoladata.getth = (ppixth != NULL);
+    sauvoladata.getd = (ppixd != NULL);
+    pixdarray[0] = pixth;
+    pixdarray[1] = pixd;
+    pixTilingProcess(pt, sauvolaTile, &sauvoladata, pixdarray, 2, 0);
 
     pixTilingDestroy(&pt);
     return 0;
 }
 
 
+/*!
+ * \brief   otsuThreshTile()
+ *
+ *  Tile operation of pixOtsuAdaptiveThreshold() that finds the
+ *  threshold of the tile.
+ */
+static l_int32
+otsuThreshTile(PIX      *pixt,
+               l_int32   i,
+               l_int32   j,
+               PIX     **ppixd,
+               void     *data)
+{
+struct OtsuTileData  *otsudata;
+
+    otsudata = (struct OtsuTileData *)data;
+    return pixSplitDistributionFgBg(pixt, otsudata->scorefract, 1,
+                                    &otsudata->thresh[i * otsudata->nx + j],
+                                    NULL, NULL, NULL);
+}
+
+
+/*!
+ * \brief   otsuBinarizeTile()
+ *
+ *  Tile operation of pixOtsuAdaptiveThreshold() that binarizes the
+ *  tile with its threshold.
+ */
+static l_int32
+otsuBinarizeTile(PIX      *pixt,
+                 l_int32   i,
+                 l_int32   j,
+                 PIX     **ppixd,
+                 void     *data)
+{
+l_uint32              val;
+struct OtsuTileData  *otsudata;
+
+    otsudata = (struct OtsuTileData *)data;
+    pixGetPixel(otsudata->pixth, j, i, &val);
+    ppixd[0] = pixThresholdToBinary(pixt, val);
+    return (ppixd[0] != NULL) ? 0 : 1;
+}
+
+
+/*!
+ * \brief   sauvolaTile()
+ *
+ *  Tile operation of pixSauvolaBinarizeTiled(), giving the tile of
+ *  threshold values and the binarized tile.
+ */
+static l_int32
+sauvolaTile(PIX      *pixt,
+            l_int32   i,
+            l_int32   j,
+            PIX     **ppixd,
+            void     *data)
+{
+struct SauvolaTileData  *sauvoladata;
+
+    sauvoladata = (struct SauvolaTileData *)data;
+    return pixSauvolaBinarize(pixt, sauvoladata->whsize,
+                              sauvoladata->factor, 0, NULL, NULL,
+                              sauvoladata->getth ? &ppixd[0] : NULL,
+                              sauvoladata->getd ? &ppixd[1] : NULL);
+}
+
+
 /*!
  * \brief   pixSauvolaBinarize()
  *
@@ -601,7 +684,9 @@ pixSauvolaBinarize(PIX       *pixs,
                    PIX      **ppixd)
 {
 l_int32  w, h;
-PIX     *pixg, *pixsc, *pixm, *pixms, *pixth, *pixd;
+DPIX    *dpixacc = NULL;
+PIX     *pixg = NULL, *pixsc = NULL, *pixacc = NULL, *pixm = NULL;
+PIX     *pixms = NULL, *pixth = NULL, *pixd = NULL;
 
     PROCNAME("pixSauvolaBinarize");
 
@@ -634,11 +719,16 @@ PIX     *pixg, *pixsc, *pixm, *pixms, *pixth, *pixd;
     if (!pixg || !pixsc)
         return ERROR_INT("pixg and pixsc not made", procName, 1);
 
-        /* All these functions strip off the border pixels. */
+        /* The accumulators of the values and their squares are made
+         * in one pass.  The windowed functions strip off the border. */
+    pixWindowedAccums(pixg, (ppixm || ppixth || ppixd) ? &pixacc : NULL,
+                      (ppixsd || ppixth || ppixd) ? &dpixacc : NULL);
     if (ppixm || ppixth || ppixd)
-        pixm = pixWindowedMean(pixg, whsize, whsize, 1, 1);
+        pixm = pixWindowedMeanFromAccum(pixacc, whsize, whsize, 8, 1);
     if (ppixsd || ppixth || ppixd)
-        pixms = pixWindowedMeanSquare(pixg, whsize, whsize, 1);
+        pixms = pixWindowedMeanSquareFromAccum(dpixacc, whsize, whsize);
+    pixDestroy(&pixacc);
+    dpixDestroy(&dpixacc);
     if (ppixth || ppixd)
         pixth = pixSauvolaGetThreshold(pixm, pixms, factor, ppixsd);
     if (ppixd) {
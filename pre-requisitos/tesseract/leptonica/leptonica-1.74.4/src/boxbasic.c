@@ -287,8 +287,7 @@ BOX  *box;
     if ((box = *pbox) == NULL)
         return;
 
-    boxChangeRefcount(box, -1);
-    if (boxGetRefcount(box) <= 0)
+    if ((l_int32)L_REFCOUNT_ADD(box->refcount, -1) <= 0)
         LEPT_FREE(box);
     *pbox = NULL;
     return;
@@ -435,7 +434,7 @@ boxGetRefcount(BOX  *box)
     if (!box)
         return ERROR_INT("box not defined", procName, UNDEF);
 
-    return box->refcount;
+    return L_REFCOUNT_GET(box->refcount);
 }
 
 /*!
@@ -453,7 +452,7 @@ boxChangeRefcount(BOX     *box,
     if (!box)
         return ERROR_INT("box not defined", procName, 1);
 
-    box->refcount += delta;
+    L_REFCOUNT_ADD(box->refcount, delta);
     return 0;
 }
 
@@ -541,7 +540,7 @@ BOXA    *boxac;
         return (BOXA *)ERROR_PTR("boxa not defined", procName, NULL);
 
     if (copyflag == L_CLONE) {
-        boxa->refcount++;
+        L_REFCOUNT_ADD(boxa->refcount, 1);
         return boxa;
     }
 
@@ -590,8 +589,7 @@ BOXA    *boxa;
         return;
 
         /* Decrement the ref count.  If it is 0, destroy the boxa. */
-    boxa->refcount--;
-    if (boxa->refcount <= 0) {
+    if ((l_int32)L_REFCOUNT_ADD(boxa->refcount, -1) <= 0) {
         for (i = 0; i < boxa->n; i++)
             boxDestroy(&boxa->box[i]);
         LEPT_FREE(boxa->box);
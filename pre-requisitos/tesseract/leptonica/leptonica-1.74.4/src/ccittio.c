@@ -0,0 +1,565 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*!
+ * \file ccittio.c
+ * <pre>
+ *
+ *      Decoding of raw CCITT fax (G3 and G4) data
+ *
+ *          PIX             *pixReadMemCcitt()
+ *
+ *      Static helpers
+ *          static L_CCITT_ENTRY  *ccittMakeTable()
+ *          static l_int32         ccittReadRun()
+ *          static l_int32         ccittDecodeRow1D()
+ *          static l_int32         ccittDecodeRow2D()
+ *          static void            ccittPaintRow()
+ *
+ *      This reads the bare coded data, such as the content of a pdf
+ *      stream with the CCITTFaxDecode filter, without going through
+ *      libtiff or a tiff container.  It does not need any external
+ *      library.
+ *
+ *      The decoder is driven by lookup tables indexed by the next 7, 12
+ *      or 13 bits of the data, taken from a 64-bit buffer, so that each
+ *      code is found with a single lookup.  Each row is decoded as the
+ *      list of the positions where the color changes, which is also the
+ *      reference for the two-dimensional coding of the next row, and
+ *      each black run is then painted a word at a time.
+ * </pre>
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+    /* Bits indexing the tables of run codes and of coding modes */
+static const l_int32  WHITE_TABLE_BITS = 12;
+static const l_int32  BLACK_TABLE_BITS = 13;
+static const l_int32  MODE_TABLE_BITS = 7;
+
+    /* Two-dimensional coding modes.  The vertical modes, with
+     * a1 - b1 from -3 to 3, are numbered from 0 to 6.  */
+static const l_int32  CCITT_PASS = 7;
+static const l_int32  CCITT_HORIZONTAL = 8;
+
+    /* A code of the data, with its length in bits and its value */
+typedef struct L_CCITT_CODE {
+    l_uint16   code;
+    l_uint8    nbits;
+    l_uint16   value;
+} L_CCITT_CODE;
+
+    /* Entry of a lookup table; %nbits is 0 for invalid bits */
+typedef struct L_CCITT_ENTRY {
+    l_int16    value;
+    l_uint8    nbits;
+} L_CCITT_ENTRY;
+
+    /* Coded data, read from the msb of each byte */
+typedef struct L_CCITT_READER {
+    const l_uint8  *data;
+    size_t          size;
+    size_t          pos;      /* next byte to load into %buf */
+    l_uint64        buf;      /* next bits, from the msb */
+    l_int32         nbits;    /* bits in %buf */
+    size_t          nused;    /* bits used so far */
+} L_CCITT_READER;
+
+    /* Terminating codes (runs 0 to 63), then makeup codes (runs of
+     * multiples of 64, to 1728), then the extended makeup codes
+     * (1792 to 2560) common to both colors.  */
+static const L_CCITT_CODE WhiteCodes[] = {
+    {0x035,  8,    0}, {0x007,  6,    1}, {0x007,  4,    2}, {0x008,  4,    3},
+    {0x00b,  4,    4}, {0x00c,  4,    5}, {0x00e,  4,    6}, {0x00f,  4,    7},
+    {0x013,  5,    8}, {0x014,  5,    9}, {0x007,  5,   10}, {0x008,  5,   11},
+    {0x008,  6,   12}, {0x003,  6,   13}, {0x034,  6,   14}, {0x035,  6,   15},
+    {0x02a,  6,   16}, {0x02b,  6,   17}, {0x027,  7,   18}, {0x00c,  7,   19},
+    {0x008,  7,   20}, {0x017,  7,   21}, {0x003,  7,   22}, {0x004,  7,   23},
+    {0x028,  7,   24}, {0x02b,  7,   25}, {0x013,  7,   26}, {0x024,  7,   27},
+    {0x018,  7,   28}, {0x002,  8,   29}, {0x003,  8,   30}, {0x01a,  8,   31},
+    {0x01b,  8,   32}, {0x012,  8,   33}, {0x013,  8,   34}, {0x014,  8,   35},
+    {0x015,  8,   36}, {0x016,  8,   37}, {0x017,  8,   38}, {0x028,  8,   39},
+    {0x029,  8,   40}, {0x02a,  8,   41}, {0x02b,  8,   42}, {0x02c,  8,   43},
+    {0x02d,  8,   44}, {0x004,  8,   45}, {0x005,  8,   46}, {0x00a,  8,   47},
+    {0x00b,  8,   48}, {0x052,  8,   49}, {0x053,  8,   50}, {0x054,  8,   51},
+    {0x055,  8,   52}, {0x024,  8,   53}, {0x025,  8,   54}, {0x058,  8,   55},
+    {0x059,  8,   56}, {0x05a,  8,   57}, {0x05b,  8,   58}, {0x04a,  8,   59},
+    {0x04b,  8,   60}, {0x032,  8,   61}, {0x033,  8,   62}, {0x034,  8,   63},
+    {0x01b,  5,   64}, {0x012,  5,  128}, {0x017,  6,  192}, {0x037,  7,  256},
+    {0x036,  8,  320}, {0x037,  8,  384}, {0x064,  8,  448}, {0x065,  8,  512},
+    {0x068,  8,  576}, {0x067,  8,  640}, {0x0cc,  9,  704}, {0x0cd,  9,  768},
+    {0x0d2,  9,  832}, {0x0d3,  9,  896}, {0x0d4,  9,  960}, {0x0d5,  9, 1024},
+    {0x0d6,  9, 1088}, {0x0d7,  9, 1152}, {0x0d8,  9, 1216}, {0x0d9,  9, 1280},
+    {0x0da,  9, 1344}, {0x0db,  9, 1408}, {0x098,  9, 1472}, {0x099,  9, 1536},
+    {0x09a,  9, 1600}, {0x018,  6, 1664}, {0x09b,  9, 1728}, {0x008, 11, 1792},
+    {0x00c, 11, 1856}, {0x00d, 11, 1920}, {0x012, 12, 1984}, {0x013, 12, 2048},
+    {0x014, 12, 2112}, {0x015, 12, 2176}, {0x016, 12, 2240}, {0x017, 12, 2304},
+    {0x01c, 12, 2368}, {0x01d, 12, 2432}, {0x01e, 12, 2496}, {0x01f, 12, 2560}
+};
+static const L_CCITT_CODE BlackCodes[] = {
+    {0x037, 10,    0}, {0x002,  3,    1}, {0x003,  2,    2}, {0x002,  2,    3},
+    {0x003,  3,    4}, {0x003,  4,    5}, {0x002,  4,    6}, {0x003,  5,    7},
+    {0x005,  6,    8}, {0x004,  6,    9}, {0x004,  7,   10}, {0x005,  7,   11},
+    {0x007,  7,   12}, {0x004,  8,   13}, {0x007,  8,   14}, {0x018,  9,   15},
+    {0x017, 10,   16}, {0x018, 10,   17}, {0x008, 10,   18}, {0x067, 11,   19},
+    {0x068, 11,   20}, {0x06c, 11,   21}, {0x037, 11,   22}, {0x028, 11,   23},
+    {0x017, 11,   24}, {0x018, 11,   25}, {0x0ca, 12,   26}, {0x0cb, 12,   27},
+    {0x0cc, 12,   28}, {0x0cd, 12,   29}, {0x068, 12,   30}, {0x069, 12,   31},
+    {0x06a, 12,   32}, {0x06b, 12,   33}, {0x0d2, 12,   34}, {0x0d3, 12,   35},
+    {0x0d4, 12,   36}, {0x0d5, 12,   37}, {0x0d6, 12,   38}, {0x0d7, 12,   39},
+    {0x06c, 12,   40}, {0x06d, 12,   41}, {0x0da, 12,   42}, {0x0db, 12,   43},
+    {0x054, 12,   44}, {0x055, 12,   45}, {0x056, 12,   46}, {0x057, 12,   47},
+    {0x064, 12,   48}, {0x065, 12,   49}, {0x052, 12,   50}, {0x053, 12,   51},
+    {0x024, 12,   52}, {0x037, 12,   53}, {0x038, 12,   54}, {0x027, 12,   55},
+    {0x028, 12,   56}, {0x058, 12,   57}, {0x059, 12,   58}, {0x02b, 12,   59},
+    {0x02c, 12,   60}, {0x05a, 12,   61}, {0x066, 12,   62}, {0x067, 12,   63},
+    {0x00f, 10,   64}, {0x0c8, 12,  128}, {0x0c9, 12,  192}, {0x05b, 12,  256},
+    {0x033, 12,  320}, {0x034, 12,  384}, {0x035, 12,  448}, {0x06c, 13,  512},
+    {0x06d, 13,  576}, {0x04a, 13,  640}, {0x04b, 13,  704}, {0x04c, 13,  768},
+    {0x04d, 13,  832}, {0x072, 13,  896}, {0x073, 13,  960}, {0x074, 13, 1024},
+    {0x075, 13, 1088}, {0x076, 13, 1152}, {0x077, 13, 1216}, {0x052, 13, 1280},
+    {0x053, 13, 1344}, {0x054, 13, 1408}, {0x055, 13, 1472}, {0x05a, 13, 1536},
+    {0x05b, 13, 1600}, {0x064, 13, 1664}, {0x065, 13, 1728}, {0x008, 11, 1792},
+    {0x00c, 11, 1856}, {0x00d, 11, 1920}, {0x012, 12, 1984}, {0x013, 12, 2048},
+    {0x014, 12, 2112}, {0x015, 12, 2176}, {0x016, 12, 2240}, {0x017, 12, 2304},
+    {0x01c, 12, 2368}, {0x01d, 12, 2432}, {0x01e, 12, 2496}, {0x01f, 12, 2560}
+};
+static const L_CCITT_CODE ModeCodes[] = {
+    {0x1, 1, 3}, {0x3, 3, 4}, {0x3, 6, 5}, {0x3, 7, 6},
+    {0x2, 3, 2}, {0x2, 6, 1}, {0x2, 7, 0},
+    {0x1, 4, 7}, {0x1, 3, 8}  /* CCITT_PASS, CCITT_HORIZONTAL */
+};
+
+static L_CCITT_ENTRY *ccittMakeTable(const L_CCITT_CODE *codes,
+                                     l_int32 ncodes, l_int32 tbits);
+static l_int32 ccittReadRun(L_CCITT_READER *cr, const L_CCITT_ENTRY *table,
+                            l_int32 tbits);
+static l_int32 ccittDecodeRow1D(L_CCITT_READER *cr,
+                                const L_CCITT_ENTRY *wtab,
+                                const L_CCITT_ENTRY *btab, l_int32 w,
+                                l_int32 *cur, l_int32 *pncur);
+static l_int32 ccittDecodeRow2D(L_CCITT_READER *cr,
+                                const L_CCITT_ENTRY *mtab,
+                                const L_CCITT_ENTRY *wtab,
+                                const L_CCITT_ENTRY *btab, l_int32 w,
+                                const l_int32 *ref, l_int32 *cur,
+                                l_int32 *pncur);
+static void ccittPaintRow(l_uint32 *line, const l_int32 *cur, l_int32 ncur,
+                          l_int32 w);
+
+
+/*---------------------------------------------------------------------*
+ *                        Reading the coded bits                       *
+ *---------------------------------------------------------------------*/
+    /* Returns the next %n bits, for %n up to 32.  Past the end of the
+     * data, the bits read as 0.  */
+static l_uint32
+ccittPeek(L_CCITT_READER  *cr,
+          l_int32          n)
+{
+l_uint64  byte;
+
+    while (cr->nbits <= 56) {
+        byte = (cr->pos < cr->size) ? cr->data[cr->pos] : 0;
+        cr->pos++;
+        cr->buf |= byte << (56 - cr->nbits);
+        cr->nbits += 8;
+    }
+    return (l_uint32)(cr->buf >> (64 - n));
+}
+
+
+    /* Drops the next %n bits, which must have been peeked */
+static void
+ccittSkip(L_CCITT_READER  *cr,
+          l_int32          n)
+{
+    cr->buf <<= n;
+    cr->nbits -= n;
+    cr->nused += n;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                           Raw CCITT decoding                        *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   pixReadMemCcitt()
+ *
+ * \param[in]    data const; CCITT fax coded, without any container
+ * \param[in]    size size of data
+ * \param[in]    w, h image width and height
+ * \param[in]    k coding: < 0 for G4; 0 for 1D G3; > 0 for mixed
+ *                 1D and 2D G3
+ * \param[in]    bytealign 1 if each coded row starts on a byte
+ *                         boundary; 0 otherwise
+ * \return  1 bpp pix, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The parameters are those of the CCITTFaxDecode filter of pdf
+ *          (Columns, Rows, K and EncodedByteAlign).
+ *      (2) The black runs are set to 1 in the pix.  A source where the
+ *          1 samples are to be shown as white (BlackIs1 in pdf, or a
+ *          tiff with min-is-black photometry) is not inverted here.
+ *      (3) For G3, each row may start with an EOL code, after any
+ *          number of fill bits.  With %bytealign, a row after an EOL
+ *          is not aligned, as the fill bits are then expected to put
+ *          the EOL itself at the end of a byte.  Decoding stops after
+ *          %h rows, so the code ending the data (RTC or EOFB) is not
+ *          needed.
+ *      (4) Data that is corrupt, ends before %h rows, or uses the
+ *          uncompressed mode, returns NULL.
+ * </pre>
+ */
+PIX *
+pixReadMemCcitt(const l_uint8  *data,
+                size_t          size,
+                l_int32         w,
+                l_int32         h,
+                l_int32         k,
+                l_int32         bytealign)
+{
+l_int32         i, wpl, twod, goteol, ncur, ret;
+l_int32        *ref, *cur, *tmp;
+l_uint32       *line;
+L_CCITT_ENTRY  *wtab, *btab, *mtab;
+L_CCITT_READER  cr;
+PIX            *pix;
+
+    PROCNAME("pixReadMemCcitt");
+
+    if (!data)
+        return (PIX *)ERROR_PTR("data not defined", procName, NULL);
+    if (w <= 0 || h <= 0)
+        return (PIX *)ERROR_PTR("invalid image size", procName, NULL);
+
+    if ((pix = pixCreate(w, h, 1)) == NULL)
+        return (PIX *)ERROR_PTR("pix not made", procName, NULL);
+    wtab = ccittMakeTable(WhiteCodes, sizeof(WhiteCodes) /
+                          sizeof(L_CCITT_CODE), WHITE_TABLE_BITS);
+    btab = ccittMakeTable(BlackCodes, sizeof(BlackCodes) /
+                          sizeof(L_CCITT_CODE), BLACK_TABLE_BITS);
+    mtab = ccittMakeTable(ModeCodes, sizeof(ModeCodes) /
+                          sizeof(L_CCITT_CODE), MODE_TABLE_BITS);
+        /* A row has at most w + 2 changes, then 3 sentinels at w */
+    ref = (l_int32 *)LEPT_CALLOC(w + 5, sizeof(l_int32));
+    cur = (l_int32 *)LEPT_CALLOC(w + 5, sizeof(l_int32));
+    if (!wtab || !btab || !mtab || !ref || !cur) {
+        pixDestroy(&pix);
+        L_ERROR("calloc fail for tables\n", procName);
+        goto cleanup;
+    }
+
+    memset(&cr, 0, sizeof(L_CCITT_READER));
+    cr.data = data;
+    cr.size = size;
+    ref[0] = ref[1] = ref[2] = w;  /* the row above the first is white */
+    line = pixGetData(pix);
+    wpl = pixGetWpl(pix);
+    goteol = 0;
+    for (i = 0; i < h; i++, line += wpl) {
+            /* After an EOL, the fill bits are before the next EOL */
+        if (bytealign && !goteol && (cr.nused & 7)) {
+            ccittPeek(&cr, 8);
+            ccittSkip(&cr, 8 - (cr.nused & 7));
+        }
+        goteol = 0;
+        twod = 1;
+        if (k >= 0) {
+                /* No code has 12 zero bits, so these are fill bits */
+            while (ccittPeek(&cr, 12) == 0 && cr.nused <= 8 * size)
+                ccittSkip(&cr, 1);
+            if (ccittPeek(&cr, 12) == 1) {
+                ccittSkip(&cr, 12);
+                goteol = 1;
+            }
+            twod = 0;
+            if (k > 0) {
+                twod = (ccittPeek(&cr, 1) == 0);
+                ccittSkip(&cr, 1);
+            }
+        }
+        if (twod)
+            ret = ccittDecodeRow2D(&cr, mtab, wtab, btab, w, ref, cur, &ncur);
+        else
+            ret = ccittDecodeRow1D(&cr, wtab, btab, w, cur, &ncur);
+        if (ret || cr.nused > 8 * size) {
+            L_ERROR("invalid or missing data in row %d\n", procName, i);
+            pixDestroy(&pix);
+            break;
+        }
+        ccittPaintRow(line, cur, ncur, w);
+
+            /* The row is the reference for the next one */
+        cur[ncur] = cur[ncur + 1] = cur[ncur + 2] = w;
+        tmp = ref;
+        ref = cur;
+        cur = tmp;
+    }
+
+cleanup:
+    LEPT_FREE(wtab);
+    LEPT_FREE(btab);
+    LEPT_FREE(mtab);
+    LEPT_FREE(ref);
+    LEPT_FREE(cur);
+    return pix;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                            Static helpers                           *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   ccittMakeTable()
+ *
+ * \param[in]    codes array of codes, none longer than %tbits
+ * \param[in]    ncodes number of codes
+ * \param[in]    tbits number of bits indexing the table
+ * \return  table of 2^tbits entries, or NULL on error
+ */
+static L_CCITT_ENTRY *
+ccittMakeTable(const L_CCITT_CODE  *codes,
+               l_int32              ncodes,
+               l_int32              tbits)
+{
+l_int32         i, j, shift, first;
+L_CCITT_ENTRY  *table;
+
+    table = (L_CCITT_ENTRY *)LEPT_CALLOC(1 << tbits, sizeof(L_CCITT_ENTRY));
+    if (!table)
+        return NULL;
+    for (i = 0; i < ncodes; i++) {
+        shift = tbits - codes[i].nbits;
+        first = codes[i].code << shift;
+        for (j = 0; j < (1 << shift); j++) {
+            table[first + j].value = codes[i].value;
+            table[first + j].nbits = codes[i].nbits;
+        }
+    }
+    return table;
+}
+
+
+/*!
+ * \brief   ccittReadRun()
+ *
+ * \param[in]    cr reader
+ * \param[in]    table of the run codes of the color
+ * \param[in]    tbits number of bits indexing the table
+ * \return  length of the run, or -1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) A run is any number of makeup codes, and a terminating code.
+ * </pre>
+ */
+static l_int32
+ccittReadRun(L_CCITT_READER       *cr,
+             const L_CCITT_ENTRY  *table,
+             l_int32               tbits)
+{
+l_int32               run;
+const L_CCITT_ENTRY  *entry;
+
+    run = 0;
+    while (1) {
+        entry = table + ccittPeek(cr, tbits);
+        if (entry->nbits == 0 || cr->nused > 8 * cr->size)
+            return -1;
+        ccittSkip(cr, entry->nbits);
+        run += entry->value;
+        if (entry->value < 64)
+            return run;
+    }
+}
+
+
+/*!
+ * \brief   ccittDecodeRow1D()
+ *
+ * \param[in]    cr reader
+ * \param[in]    wtab, btab tables of the white and black run codes
+ * \param[in]    w image width
+ * \param[in]    cur returns the changes of the row
+ * \param[out]   pncur number of changes
+ * \return  0 if OK, 1 on error
+ */
+static l_int32
+ccittDecodeRow1D(L_CCITT_READER       *cr,
+                 const L_CCITT_ENTRY  *wtab,
+                 const L_CCITT_ENTRY  *btab,
+                 l_int32               w,
+                 l_int32              *cur,
+                 l_int32              *pncur)
+{
+l_int32  x, run, ncur;
+
+    *pncur = 0;
+    for (x = 0, ncur = 0; x < w; ncur++) {
+        if (ncur & 1)
+            run = ccittReadRun(cr, btab, BLACK_TABLE_BITS);
+        else
+            run = ccittReadRun(cr, wtab, WHITE_TABLE_BITS);
+        if (run < 0 || ncur > w)
+            return 1;
+        x = L_MIN(x + run, w);
+        cur[ncur] = x;
+    }
+    *pncur = ncur;
+    return 0;
+}
+
+
+/*!
+ * \brief   ccittDecodeRow2D()
+ *
+ * \param[in]    cr reader
+ * \param[in]    mtab table of the mode codes
+ * \param[in]    wtab, btab tables of the white and black run codes
+ * \param[in]    w image width
+ * \param[in]    ref changes of the reference row, followed by sentinels
+ * \param[in]    cur returns the changes of the row
+ * \param[out]   pncur number of changes
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The changes alternate from white to black and back, so that
+ *          the color after a0 is given by the parity of the number of
+ *          changes so far.  b1 is the first change of the reference row
+ *          after a0 with that same parity, and b2 the one after it.
+ *      (2) The row starts at a0 = -1, before the first pixel.  For
+ *          corrupt data, the changes are clamped to [a0, w].
+ * </pre>
+ */
+static l_int32
+ccittDecodeRow2D(L_CCITT_READER       *cr,
+                 const L_CCITT_ENTRY  *mtab,
+                 const L_CCITT_ENTRY  *wtab,
+                 const L_CCITT_ENTRY  *btab,
+                 l_int32               w,
+                 const l_int32        *ref,
+                 l_int32              *cur,
+                 l_int32              *pncur)
+{
+l_int32               a0, a1, b1, b2, ri, ncur, mode, run1, run2;
+const L_CCITT_ENTRY  *entry;
+
+    *pncur = 0;
+    a0 = -1;
+    ri = 0;
+    ncur = 0;
+    while (a0 < w) {
+        entry = mtab + ccittPeek(cr, MODE_TABLE_BITS);
+        if (entry->nbits == 0 || cr->nused > 8 * cr->size || ncur > w)
+            return 1;
+        ccittSkip(cr, entry->nbits);
+        mode = entry->value;
+
+            /* b1 is at most one change before the previous b1 */
+        if (ri > 0)
+            ri--;
+        if ((ri & 1) != (ncur & 1))
+            ri++;
+        while (ref[ri] <= a0 && ref[ri] < w)
+            ri += 2;
+        b1 = ref[ri];
+        b2 = ref[ri + 1];
+
+        if (mode == CCITT_PASS) {
+            a0 = b2;
+        } else if (mode == CCITT_HORIZONTAL) {
+            if (ncur & 1) {
+                run1 = ccittReadRun(cr, btab, BLACK_TABLE_BITS);
+                run2 = ccittReadRun(cr, wtab, WHITE_TABLE_BITS);
+            } else {
+                run1 = ccittReadRun(cr, wtab, WHITE_TABLE_BITS);
+                run2 = ccittReadRun(cr, btab, BLACK_TABLE_BITS);
+            }
+            if (run1 < 0 || run2 < 0)
+                return 1;
+            a1 = L_MIN(L_MAX(a0, 0) + run1, w);
+            cur[ncur++] = a1;
+            a0 = L_MIN(a1 + run2, w);
+            cur[ncur++] = a0;
+        } else {  /* vertical */
+            a1 = b1 + mode - 3;
+            a1 = L_MAX(a1, L_MAX(a0, 0));
+            a0 = L_MIN(a1, w);
+            cur[ncur++] = a0;
+        }
+    }
+    *pncur = ncur;
+    return 0;
+}
+
+
+/*!
+ * \brief   ccittPaintRow()
+ *
+ * \param[in]    line of the pix, all 0
+ * \param[in]    cur changes of the row
+ * \param[in]    ncur number of changes
+ * \param[in]    w image width
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) The black runs go from each change at an even index to the
+ *          next change, or to the end of the row.
+ * </pre>
+ */
+static void
+ccittPaintRow(l_uint32       *line,
+              const l_int32  *cur,
+              l_int32         ncur,
+              l_int32         w)
+{
+l_int32   i, j, x0, x1, fw, lw;
+l_uint32  fmask, lmask;
+
+    for (i = 0; i < ncur; i += 2) {
+        x0 = cur[i];
+        x1 = (i + 1 < ncur) ? cur[i + 1] : w;
+        if (x1 <= x0)
+            continue;
+        fw = x0 >> 5;
+        lw = (x1 - 1) >> 5;
+        fmask = 0xffffffff >> (x0 & 31);
+        lmask = 0xffffffff << (31 - ((x1 - 1) & 31));
+        if (fw == lw) {
+            line[fw] |= fmask & lmask;
+        } else {
+            line[fw] |= fmask;
+            for (j = fw + 1; j < lw; j++)
+                line[j] = 0xffffffff;
+            line[lw] |= lmask;
+        }
+    }
+}
@@ -28,8 +28,9 @@
  * \file conncomp.c
  * <pre>
  *
- *    Connected component counting and extraction, using Heckbert's
- *    stack-based filling algorithm.
+ *    Connected component counting and extraction, using union-find
+ *    labeling of the runs of ON pixels, and Heckbert's stack-based
+ *    filling algorithm.
  *
  *      4- and 8-connected components: counts, bounding boxes and images
  *
@@ -39,6 +40,15 @@
  *           BOXA     *pixConnCompBB()
  *           l_int32   pixCountConnComp()
  *
+ *      Labeling of the runs, with bounding boxes, areas and label map:
+ *           BOXA     *pixConnCompRuns()
+ *           static l_int32  ccRunsLabel()
+ *           static BOXA    *ccRunsGetBoxa()
+ *           static l_int32  ccRunsExtractRow()
+ *           static l_int32  ccRunsFind()
+ *           static void     ccRunsUnionRows()
+ *           static void     ccRunsDestroy()
+ *
  *      Identify the next c.c. to be erased:
  *           l_int32   nextOnPixelInRaster()
  *           l_int32   nextOnPixelInRasterLow()
@@ -58,36 +68,34 @@
  *           static void    pushFillseg()
  *           static void    popFillseg()
  *
- *  The basic method in pixConnCompBB() is very simple.  We scan the
- *  image in raster order, looking for the next ON pixel.  When it
- *  is found, we erase it and every pixel of the 4- or 8-connected
- *  component to which it belongs, using Heckbert's seedfill
- *  algorithm.  As pixels are erased, we keep track of the
- *  minimum rectangle that encloses all erased pixels; after
- *  the connected component has been erased, we save its
- *  bounding box in an array of boxes.  When all pixels in the
- *  image have been erased, we have an array that describes every
- *  4- or 8-connected component in terms of its bounding box.
+ *  The top-level calls label the runs of ON pixels of each raster line.
+ *  The runs are found a word at a time, skipping the words that are
+ *  all OFF or, within a run, all ON.  A second pass joins each run with
+ *  the runs that it touches on the line above, in a union-find forest
+ *  where the root of each tree is its first run in raster order.  The
+ *  components, then numbered in the raster order of their roots, come
+ *  out in the order of their first ON pixel, which is the order in
+ *  which the seedfill method erased them.  The bounding boxes, areas,
+ *  images and label map of all components are all made from the runs
+ *  in a single pass over them.
  *
- *  pixConnCompPixa() is a slight variation on pixConnCompBB(),
- *  where we additionally save an array of images (in a Pixa)
- *  of each of the 4- or 8-connected components.  This is done trivially
- *  by maintaining two temporary images.  We erase a component from one,
- *  and use the bounding box to extract the pixels within the b.b.
- *  from each of the two images.  An XOR between these subimages
- *  gives the erased component.  Then we erase the component from the
- *  second image using the XOR again, with the extracted component
- *  placed on the second image at the location of the bounding box.
- *  Rasterop does all the work.  At the end, we have an array
- *  of the 4- or 8-connected components, as well as an array of the
- *  bounding boxes that describe where they came from in the original image.
+ *  With OpenMP, the image is cut into horizontal bands that are
+ *  labeled at the same time, and the trees are then merged across the
+ *  seams between the bands.  The results are the same for any number
+ *  of threads.
  *
- *  If you just want the number of connected components, pixCountConnComp()
- *  is a bit faster than pixConnCompBB(), because it doesn't have to
- *  keep track of the bounding rectangles for each c.c.
+ *  The seedfill functions erase one component at a time: from a seed
+ *  pixel found in raster order, Heckbert's algorithm erases every
+ *  pixel of the 4- or 8-connected component to which it belongs,
+ *  keeping track of the minimum rectangle that encloses the erased
+ *  pixels.
  * </pre>
  */
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
+#include <string.h>
 #include "allheaders.h"
 
 /*!
@@ -117,6 +125,37 @@ static void popFillseg(L_STACK *stack, l_int32 *pxleft, l_int32 *pxright,
                        l_int32 *py, l_int32 *pdy);
 
 
+/*!
+ * \brief   The struct CCRuns holds the runs of ON pixels of an image, in
+ *  raster order, and their labels.  During labeling, %label holds the
+ *  parent of each run in the union-find forest, which is always an
+ *  earlier run or the run itself.
+ */
+struct CCRuns
+{
+    l_int32    nruns;     /*!< number of runs                          */
+    l_int32    ncomp;     /*!< number of components                    */
+    l_int32   *rowstart;  /*!< first run of each line, and nruns       */
+    l_int32   *xstart;    /*!< first pixel of each run                 */
+    l_int32   *xend;      /*!< last pixel of each run                  */
+    l_int32   *label;     /*!< component index of each run             */
+};
+typedef struct CCRuns    CCRUNS;
+
+    /* Smallest band of lines labeled on each thread */
+static const l_int32  MIN_BAND_HEIGHT = 128;
+
+static l_int32 ccRunsLabel(PIX *pixs, l_int32 connectivity,
+                           l_int32 nthreads, CCRUNS *ccr);
+static BOXA *ccRunsGetBoxa(CCRUNS *ccr, PIX *pixs, NUMA **pnaa,
+                           PIX **ppixl);
+static l_int32 ccRunsExtractRow(const l_uint32 *line, l_int32 w,
+                                l_int32 wpl, l_int32 *xstart,
+                                l_int32 *xend);
+static void ccRunsUnionRows(CCRUNS *ccr, l_int32 y, l_int32 dist);
+static void ccRunsDestroy(CCRUNS *ccr);
+
+
 #ifndef  NO_CONSOLE_IO
 #define   DEBUG    0
 #endif  /* ~NO_CONSOLE_IO */
@@ -176,10 +215,9 @@ pixConnComp(PIX     *pixs,
  *      (1) This finds bounding boxes of 4- or 8-connected components
  *          in a binary image, and saves images of each c.c
  *          in a pixa array.
- *      (2) It sets up 2 temporary pix, and for each c.c. that is
- *          located in raster order, it erases the c.c. from one pix,
- *          then uses the b.b. to extract the c.c. from the two pix using
- *          an XOR, and finally erases the c.c. from the second pix.
+ *      (2) The runs of the image are labeled, and each c.c. is
+ *          painted from its runs into a pix the size of its b.b.,
+ *          with the resolution, colormap and text of pixs.
  *      (3) A clone of the returned boxa (where all boxes in the array
  *          are clones) is inserted into the pixa.
  *      (4) If the input is valid, this always returns a boxa and a pixa.
@@ -191,13 +229,14 @@ pixConnCompPixa(PIX     *pixs,
                 PIXA   **ppixa,
                 l_int32  connectivity)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pix1, *pix2, *pix3, *pix4;
-PIXA     *pixa;
-BOX      *box;
-BOXA     *boxa;
-L_STACK  *stack, *auxstack;
+l_int32    h, i, j, k, n, y, x0, x1, bx, by, bw, bh, wpld;
+l_int32   *first, *order, *rowof;
+l_uint32  *datad, *lined;
+PIX       *pix1;
+PIXA      *pixa;
+BOX       *box;
+BOXA      *boxa;
+CCRUNS     ccr;
 
     PROCNAME("pixConnCompPixa");
 
@@ -209,76 +248,80 @@ L_STACK  *stack, *auxstack;
     if (connectivity != 4 && connectivity != 8)
         return (BOXA *)ERROR_PTR("connectivity not 4 or 8", procName, NULL);
 
-    pix1 = pix2 = pix3 = pix4 = NULL;
-    stack = NULL;
+    if (ccRunsLabel(pixs, connectivity, 0, &ccr)) {
+        ccRunsDestroy(&ccr);
+        return (BOXA *)ERROR_PTR("runs not labeled", procName, NULL);
+    }
+    if ((boxa = ccRunsGetBoxa(&ccr, pixs, NULL, NULL)) == NULL) {
+        ccRunsDestroy(&ccr);
+        return (BOXA *)ERROR_PTR("boxa not made", procName, NULL);
+    }
     pixa = pixaCreate(0);
-    boxa = NULL;
     *ppixa = pixa;
-    pixZero(pixs, &iszero);
-    if (iszero)
-        return boxaCreate(1);  /* return empty boxa and empty pixa */
-
-    pix1 = pixCopy(NULL, pixs);
-    pix2 = pixCopy(NULL, pixs);
-    if (!pix1 || !pix2) {
-        L_ERROR("pix1 or pix2 not made\n", procName);
-        pixaDestroy(ppixa);
-        goto cleanup;
+    if ((n = boxaGetCount(boxa)) == 0) {
+        ccRunsDestroy(&ccr);
+        return boxa;  /* return empty boxa and empty pixa */
     }
 
+        /* Sort the runs by component, keeping the raster order */
     h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL) {
-        L_ERROR("stack not made\n", procName);
+    first = (l_int32 *)LEPT_CALLOC(n + 1, sizeof(l_int32));
+    order = (l_int32 *)LEPT_CALLOC(ccr.nruns, sizeof(l_int32));
+    rowof = (l_int32 *)LEPT_CALLOC(ccr.nruns, sizeof(l_int32));
+    if (!first || !order || !rowof) {
+        boxaDestroy(&boxa);
         pixaDestroy(ppixa);
+        L_ERROR("calloc fail for run order\n", procName);
         goto cleanup;
     }
-    auxstack = lstackCreate(0);
-    stack->auxstack = auxstack;
-    boxa = boxaCreate(0);
-
-    xstart = 0;
-    ystart = 0;
-    while (1) {
-        if (!nextOnPixelInRaster(pix1, xstart, ystart, &x, &y))
-            break;
-
-        if ((box = pixSeedfillBB(pix1, stack, x, y, connectivity)) == NULL) {
-            boxaDestroy(&boxa);
-            pixaDestroy(ppixa);
-            L_ERROR("box not made\n", procName);
-            goto cleanup;
+    for (i = 0; i < ccr.nruns; i++)
+        first[ccr.label[i] + 1]++;
+    for (k = 0; k < n; k++)
+        first[k + 1] += first[k];
+    for (y = 0; y < h; y++) {
+        for (i = ccr.rowstart[y]; i < ccr.rowstart[y + 1]; i++) {
+            rowof[i] = y;
+            order[first[ccr.label[i]]++] = i;
         }
-        boxaAddBox(boxa, box, L_INSERT);
-
-            /* Save the c.c. and remove from pix2 as well */
-        pix3 = pixClipRectangle(pix1, box, NULL);
-        pix4 = pixClipRectangle(pix2, box, NULL);
-        pixXor(pix3, pix3, pix4);
-        pixRasterop(pix2, box->x, box->y, box->w, box->h, PIX_SRC ^ PIX_DST,
-                    pix3, 0, 0);
-        pixaAddPix(pixa, pix3, L_INSERT);
-        pixDestroy(&pix4);
-
-        xstart = x;
-        ystart = y;
     }
 
-#if  DEBUG
-    pixCountPixels(pix1, &iszero, NULL);
-    fprintf(stderr, "Number of remaining pixels = %d\n", iszero);
-    pixWrite("junkremain", pix1, IFF_PNG);
-#endif  /* DEBUG */
+        /* Paint each c.c. from its runs; first[k] is now the
+         * end of the runs of c.c. k */
+    for (k = 0, j = 0; k < n; k++) {
+        box = boxaGetBox(boxa, k, L_CLONE);
+        boxGetGeometry(box, &bx, &by, &bw, &bh);
+        pix1 = pixCreate(bw, bh, 1);
+        pixCopyResolution(pix1, pixs);
+        pixCopyColormap(pix1, pixs);
+        pixCopyText(pix1, pixs);
+        datad = pixGetData(pix1);
+        wpld = pixGetWpl(pix1);
+        for (; j < first[k]; j++) {
+            i = order[j];
+            lined = datad + (rowof[i] - by) * wpld;
+            x0 = ccr.xstart[i] - bx;
+            x1 = ccr.xend[i] - bx;
+            for (; x0 <= x1 && (x0 & 31); x0++)
+                SET_DATA_BIT(lined, x0);
+            for (; x0 + 31 <= x1; x0 += 32)
+                lined[x0 >> 5] = 0xffffffff;
+            for (; x0 <= x1; x0++)
+                SET_DATA_BIT(lined, x0);
+        }
+        pixaAddPix(pixa, pix1, L_INSERT);
+        boxDestroy(&box);
+    }
 
         /* Remove old boxa of pixa and replace with a copy */
     boxaDestroy(&pixa->boxa);
     pixa->boxa = boxaCopy(boxa, L_COPY);
     *ppixa = pixa;
 
-        /* Cleanup, freeing the fillsegs on each stack */
 cleanup:
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pix1);
-    pixDestroy(&pix2);
+    LEPT_FREE(first);
+    LEPT_FREE(order);
+    LEPT_FREE(rowof);
+    ccRunsDestroy(&ccr);
     return boxa;
 }
 
@@ -294,22 +337,14 @@ cleanup:
  * Notes:
  *     (1) Finds bounding boxes of 4- or 8-connected components
  *         in a binary image.
- *     (2) This works on a copy of the input pix.  The c.c. are located
- *         in raster order and erased one at a time.  In the process,
- *         the b.b. is computed and saved.
+ *     (2) This labels the runs of the image; see pixConnCompRuns().
+ *         The c.c. are in the raster order of their first pixel.
  * </pre>
  */
 BOXA *
 pixConnCompBB(PIX     *pixs,
               l_int32  connectivity)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pix1;
-BOX      *box;
-BOXA     *boxa;
-L_STACK  *stack, *auxstack;
-
     PROCNAME("pixConnCompBB");
 
     if (!pixs || pixGetDepth(pixs) != 1)
@@ -317,53 +352,7 @@ L_STACK  *stack, *auxstack;
     if (connectivity != 4 && connectivity != 8)
         return (BOXA *)ERROR_PTR("connectivity not 4 or 8", procName, NULL);
 
-    boxa = NULL;
-    pix1 = NULL;
-    stack = NULL;
-    pixZero(pixs, &iszero);
-    if (iszero)
-        return boxaCreate(1);  /* return empty boxa */
-
-    if ((pix1 = pixCopy(NULL, pixs)) == NULL)
-        return (BOXA *)ERROR_PTR("pix1 not made", procName, NULL);
-
-    h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL) {
-        L_ERROR("stack not made\n", procName);
-        goto cleanup;
-    }
-    auxstack = lstackCreate(0);
-    stack->auxstack = auxstack;
-    boxa = boxaCreate(0);
-
-    xstart = 0;
-    ystart = 0;
-    while (1) {
-        if (!nextOnPixelInRaster(pix1, xstart, ystart, &x, &y))
-            break;
-
-        if ((box = pixSeedfillBB(pix1, stack, x, y, connectivity)) == NULL) {
-            L_ERROR("box not made\n", procName);
-            boxaDestroy(&boxa);
-            goto cleanup;
-        }
-        boxaAddBox(boxa, box, L_INSERT);
-
-        xstart = x;
-        ystart = y;
-    }
-
-#if  DEBUG
-    pixCountPixels(pix1, &iszero, NULL);
-    fprintf(stderr, "Number of remaining pixels = %d\n", iszero);
-    pixWrite("junkremain", pix1, IFF_PNG);
-#endif  /* DEBUG */
-
-        /* Cleanup, freeing the fillsegs on each stack */
-cleanup:
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pix1);
-    return boxa;
+    return pixConnCompRuns(pixs, connectivity, NULL, NULL, 0);
 }
 
 
@@ -378,18 +367,14 @@ cleanup:
  * Notes:
  *     (1 This is the top-level call for getting the number of
  *         4- or 8-connected components in a 1 bpp image.
- *     2 It works on a copy of the input pix.  The c.c. are located
- *         in raster order and erased one at a time.
+ *     2 It labels the runs of the image, without making any boxes.
  */
 l_int32
 pixCountConnComp(PIX      *pixs,
                  l_int32   connectivity,
                  l_int32  *pcount)
 {
-l_int32   h, iszero;
-l_int32   x, y, xstart, ystart;
-PIX      *pix1;
-L_STACK  *stack, *auxstack;
+CCRUNS  ccr;
 
     PROCNAME("pixCountConnComp");
 
@@ -401,40 +386,402 @@ L_STACK  *stack, *auxstack;
     if (connectivity != 4 && connectivity != 8)
         return ERROR_INT("connectivity not 4 or 8", procName, 1);
 
-    stack = NULL;
-    pixZero(pixs, &iszero);
-    if (iszero)
-        return 0;
+    if (ccRunsLabel(pixs, connectivity, 0, &ccr))
+        return ERROR_INT("runs not labeled", procName, 1);
+    *pcount = ccr.ncomp;
+    ccRunsDestroy(&ccr);
+    return 0;
+}
 
-    if ((pix1 = pixCopy(NULL, pixs)) == NULL)
-        return ERROR_INT("pix1 not made", procName, 1);
-    h = pixGetHeight(pixs);
-    if ((stack = lstackCreate(h)) == NULL) {
-        pixDestroy(&pix1);
-        return ERROR_INT("stack not made\n", procName, 1);
+
+/*-----------------------------------------------------------------------*
+ *                    Union-find labeling of the runs                    *
+ *-----------------------------------------------------------------------*/
+/*!
+ * \brief   pixConnCompRuns()
+ *
+ * \param[in]    pixs 1 bpp
+ * \param[in]    connectivity 4 or 8
+ * \param[out]   pnaa [optional] number of pixels of each c.c.
+ * \param[out]   ppixl [optional] 32 bpp label map
+ * \param[in]    nthreads threads to use; 0 for the default
+ * \return  boxa of the c.c., or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The c.c. are in the raster order of their first pixel, as
+ *          with pixConnCompBB().  Each pixel of the label map is 0 for
+ *          OFF pixels, and the index of its c.c. in the boxa plus 1
+ *          for ON pixels.
+ *      (2) With OpenMP, the image is labeled in up to %nthreads
+ *          horizontal bands at the same time, of at least
+ *          MIN_BAND_HEIGHT lines; the default is the number of threads
+ *          of OpenMP.  The results do not depend on it.
+ *      (3) If pixs is empty, this returns an empty boxa.
+ * </pre>
+ */
+BOXA *
+pixConnCompRuns(PIX     *pixs,
+                l_int32  connectivity,
+                NUMA   **pnaa,
+                PIX    **ppixl,
+                l_int32  nthreads)
+{
+BOXA    *boxa;
+CCRUNS   ccr;
+
+    PROCNAME("pixConnCompRuns");
+
+    if (pnaa) *pnaa = NULL;
+    if (ppixl) *ppixl = NULL;
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return (BOXA *)ERROR_PTR("pixs undefined or not 1 bpp", procName, NULL);
+    if (connectivity != 4 && connectivity != 8)
+        return (BOXA *)ERROR_PTR("connectivity not 4 or 8", procName, NULL);
+
+    if (ccRunsLabel(pixs, connectivity, nthreads, &ccr)) {
+        ccRunsDestroy(&ccr);
+        return (BOXA *)ERROR_PTR("runs not labeled", procName, NULL);
+    }
+    boxa = ccRunsGetBoxa(&ccr, pixs, pnaa, ppixl);
+    ccRunsDestroy(&ccr);
+    if (!boxa)
+        return (BOXA *)ERROR_PTR("boxa not made", procName, NULL);
+    return boxa;
+}
+
+
+/*!
+ * \brief   ccRunsGetBoxa()
+ *
+ * \param[in]    ccr labeled runs of pixs
+ * \param[in]    pixs 1 bpp
+ * \param[out]   pnaa [optional] number of pixels of each c.c.
+ * \param[out]   ppixl [optional] 32 bpp label map
+ * \return  boxa of the c.c., or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This makes all the results in one pass over the runs.
+ * </pre>
+ */
+static BOXA *
+ccRunsGetBoxa(CCRUNS  *ccr,
+              PIX     *pixs,
+              NUMA   **pnaa,
+              PIX    **ppixl)
+{
+l_int32    w, h, i, k, y, x, n, wpll;
+l_int32   *minx, *maxx, *miny, *maxy, *area;
+l_uint32  *datal, *linel;
+BOXA      *boxa;
+
+    PROCNAME("ccRunsGetBoxa");
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    n = ccr->ncomp;
+    boxa = NULL;
+    minx = (l_int32 *)LEPT_CALLOC(n + 1, sizeof(l_int32));
+    maxx = (l_int32 *)LEPT_CALLOC(n + 1, sizeof(l_int32));
+    miny = (l_int32 *)LEPT_CALLOC(n + 1, sizeof(l_int32));
+    maxy = (l_int32 *)LEPT_CALLOC(n + 1, sizeof(l_int32));
+    area = (l_int32 *)LEPT_CALLOC(n + 1, sizeof(l_int32));
+    if (!minx || !maxx || !miny || !maxy || !area) {
+        L_ERROR("calloc fail for c.c. data\n", procName);
+        goto cleanup;
     }
-    auxstack = lstackCreate(0);
-    stack->auxstack = auxstack;
-
-    xstart = 0;
-    ystart = 0;
-    while (1) {
-        if (!nextOnPixelInRaster(pix1, xstart, ystart, &x, &y))
-            break;
-
-        pixSeedfill(pix1, stack, x, y, connectivity);
-        (*pcount)++;
-        xstart = x;
-        ystart = y;
+    if (ppixl) {
+        if ((*ppixl = pixCreate(w, h, 32)) == NULL) {
+            L_ERROR("pixl not made\n", procName);
+            goto cleanup;
+        }
+        pixCopyResolution(*ppixl, pixs);
     }
 
-        /* Cleanup, freeing the fillsegs on each stack */
-    lstackDestroy(&stack, TRUE);
-    pixDestroy(&pix1);
+        /* One pass over the runs; the first run of each c.c. is on
+         * its top line */
+    for (k = 0; k < n; k++) {
+        minx[k] = w;
+        maxx[k] = -1;
+    }
+    datal = (ppixl) ? pixGetData(*ppixl) : NULL;
+    wpll = (ppixl) ? pixGetWpl(*ppixl) : 0;
+    for (y = 0; y < h; y++) {
+        linel = (datal) ? datal + y * wpll : NULL;
+        for (i = ccr->rowstart[y]; i < ccr->rowstart[y + 1]; i++) {
+            k = ccr->label[i];
+            if (maxx[k] < 0)
+                miny[k] = y;
+            maxy[k] = y;
+            minx[k] = L_MIN(minx[k], ccr->xstart[i]);
+            maxx[k] = L_MAX(maxx[k], ccr->xend[i]);
+            area[k] += ccr->xend[i] - ccr->xstart[i] + 1;
+            if (linel) {
+                for (x = ccr->xstart[i]; x <= ccr->xend[i]; x++)
+                    linel[x] = k + 1;
+            }
+        }
+    }
+
+    boxa = boxaCreate(L_MAX(1, n));
+    if (pnaa) *pnaa = numaCreate(L_MAX(1, n));
+    for (k = 0; k < n; k++) {
+        boxaAddBox(boxa, boxCreate(minx[k], miny[k], maxx[k] - minx[k] + 1,
+                                   maxy[k] - miny[k] + 1), L_INSERT);
+        if (pnaa) numaAddNumber(*pnaa, area[k]);
+    }
+
+cleanup:
+    if (!boxa && ppixl) pixDestroy(ppixl);
+    LEPT_FREE(minx);
+    LEPT_FREE(maxx);
+    LEPT_FREE(miny);
+    LEPT_FREE(maxy);
+    LEPT_FREE(area);
+    return boxa;
+}
+
+
+/*!
+ * \brief   ccRunsLabel()
+ *
+ * \param[in]    pixs 1 bpp
+ * \param[in]    connectivity 4 or 8
+ * \param[in]    nthreads threads to use; 0 for the default
+ * \param[out]   ccr runs of pixs and their c.c. index
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The lines are scanned twice, to count the runs and then to
+ *          store them, each line on its own.  The unions are made
+ *          within each band of lines, and then across the seams.
+ *      (2) As the parent of a run is never after it, the root of each
+ *          tree is its first run, and the c.c. are numbered in a
+ *          single pass in raster order.
+ *      (3) ccr must be destroyed with ccRunsDestroy(), even on error.
+ * </pre>
+ */
+static l_int32
+ccRunsLabel(PIX      *pixs,
+            l_int32   connectivity,
+            l_int32   nthreads,
+            CCRUNS   *ccr)
+{
+l_int32    w, h, wpl, y, i, b, nbands, dist, ncomp;
+l_uint32  *data;
+
+    PROCNAME("ccRunsLabel");
+
+    memset(ccr, 0, sizeof(CCRUNS));
+    pixGetDimensions(pixs, &w, &h, NULL);
+    data = pixGetData(pixs);
+    wpl = pixGetWpl(pixs);
+    dist = (connectivity == 8) ? 1 : 0;
+#ifdef _OPENMP
+    if (nthreads <= 0)
+        nthreads = omp_get_max_threads();
+#endif  /* _OPENMP */
+    nbands = L_MAX(1, L_MIN(nthreads, h / MIN_BAND_HEIGHT));
+
+    if ((ccr->rowstart = (l_int32 *)LEPT_CALLOC(h + 1, sizeof(l_int32)))
+        == NULL)
+        return ERROR_INT("rowstart not made", procName, 1);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nbands) if (nbands > 1)
+#endif  /* _OPENMP */
+    for (y = 0; y < h; y++) {
+        ccr->rowstart[y + 1] = ccRunsExtractRow(data + y * wpl, w, wpl,
+                                                NULL, NULL);
+    }
+    for (y = 0; y < h; y++)
+        ccr->rowstart[y + 1] += ccr->rowstart[y];
+    ccr->nruns = ccr->rowstart[h];
+
+    ccr->xstart = (l_int32 *)LEPT_CALLOC(ccr->nruns + 1, sizeof(l_int32));
+    ccr->xend = (l_int32 *)LEPT_CALLOC(ccr->nruns + 1, sizeof(l_int32));
+    ccr->label = (l_int32 *)LEPT_CALLOC(ccr->nruns + 1, sizeof(l_int32));
+    if (!ccr->xstart || !ccr->xend || !ccr->label)
+        return ERROR_INT("run arrays not made", procName, 1);
+
+        /* Bands of lines, then the seams between them */
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nbands) if (nbands > 1) private(y, i)
+#endif  /* _OPENMP */
+    for (b = 0; b < nbands; b++) {
+        l_int32  y0 = (l_int32)((l_int64)h * b / nbands);
+        l_int32  y1 = (l_int32)((l_int64)h * (b + 1) / nbands);
+        for (y = y0; y < y1; y++) {
+            i = ccr->rowstart[y];
+            ccRunsExtractRow(data + y * wpl, w, wpl, ccr->xstart + i,
+                             ccr->xend + i);
+            for (; i < ccr->rowstart[y + 1]; i++)
+                ccr->label[i] = i;
+            if (y > y0)
+                ccRunsUnionRows(ccr, y, dist);
+        }
+    }
+    for (b = 1; b < nbands; b++)
+        ccRunsUnionRows(ccr, (l_int32)((l_int64)h * b / nbands), dist);
+
+        /* Replace each parent by the c.c. index; the parent, which is
+         * not after the run, already has it */
+    ncomp = 0;
+    for (i = 0; i < ccr->nruns; i++) {
+        if (ccr->label[i] == i)
+            ccr->label[i] = ncomp++;
+        else
+            ccr->label[i] = ccr->label[ccr->label[i]];
+    }
+    ccr->ncomp = ncomp;
     return 0;
 }
 
 
+/*!
+ * \brief   ccRunsExtractRow()
+ *
+ * \param[in]    line of a 1 bpp pix
+ * \param[in]    w width
+ * \param[in]    wpl words of the line
+ * \param[in]    xstart, xend [optional] arrays for the runs; use null
+ *                                       for both to just count them
+ * \return  number of runs of ON pixels of the line
+ *
+ * <pre>
+ * Notes:
+ *      (1) The pad bits after w are ignored.
+ * </pre>
+ */
+static l_int32
+ccRunsExtractRow(const l_uint32  *line,
+                 l_int32          w,
+                 l_int32          wpl,
+                 l_int32         *xstart,
+                 l_int32         *xend)
+{
+l_int32   j, bit, inrun, nruns, x0;
+l_uint32  word, rest;
+
+    nruns = 0;
+    inrun = 0;
+    x0 = 0;
+    for (j = 0; j < wpl; j++) {
+        word = line[j];
+        if (j == wpl - 1 && (w & 31))
+            word &= ~(0xffffffff >> (w & 31));
+        if (word == (inrun ? 0xffffffff : 0))
+            continue;
+        bit = 0;
+        while (bit < 32) {
+            rest = (inrun ? ~word : word) << bit;
+            if (rest == 0)
+                break;
+#if defined(__GNUC__)
+            bit += __builtin_clz(rest);
+#else
+            while (!(rest & 0x80000000)) {
+                rest <<= 1;
+                bit++;
+            }
+#endif  /* __GNUC__ */
+            if (inrun) {
+                if (xstart) {
+                    xstart[nruns] = x0;
+                    xend[nruns] = 32 * j + bit - 1;
+                }
+                nruns++;
+            } else {
+                x0 = 32 * j + bit;
+            }
+            inrun = !inrun;
+        }
+    }
+    if (inrun) {
+        if (xstart) {
+            xstart[nruns] = x0;
+            xend[nruns] = w - 1;
+        }
+        nruns++;
+    }
+    return nruns;
+}
+
+
+    /* Returns the root of run i, halving the path to it */
+static l_int32
+ccRunsFind(l_int32  *parent,
+           l_int32   i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+
+/*!
+ * \brief   ccRunsUnionRows()
+ *
+ * \param[in]    ccr runs, with labels holding the parents
+ * \param[in]    y line, > 0, whose runs are joined to those above
+ * \param[in]    dist 0 for 4-connectivity; 1 for 8-connectivity
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Runs touch if they overlap, or for 8-connectivity, also if
+ *          they meet at a corner.  Of two trees, the one with the later
+ *          root is put under the other root.
+ * </pre>
+ */
+static void
+ccRunsUnionRows(CCRUNS   *ccr,
+                l_int32   y,
+                l_int32   dist)
+{
+l_int32   i, p, q, pend, iend, ri, rq;
+l_int32  *xstart, *xend, *parent;
+
+    xstart = ccr->xstart;
+    xend = ccr->xend;
+    parent = ccr->label;
+    p = ccr->rowstart[y - 1];
+    pend = ccr->rowstart[y];
+    iend = ccr->rowstart[y + 1];
+    for (i = pend; i < iend; i++) {
+        while (p < pend && xend[p] + dist < xstart[i])
+            p++;
+        for (q = p; q < pend && xstart[q] <= xend[i] + dist; q++) {
+            ri = ccRunsFind(parent, i);
+            rq = ccRunsFind(parent, q);
+            if (ri < rq)
+                parent[rq] = ri;
+            else if (rq < ri)
+                parent[ri] = rq;
+        }
+    }
+}
+
+
+/*!
+ * \brief   ccRunsDestroy()
+ *
+ * \param[in]    ccr runs
+ * \return  void
+ */
+static void
+ccRunsDestroy(CCRUNS  *ccr)
+{
+    LEPT_FREE(ccr->rowstart);
+    LEPT_FREE(ccr->xstart);
+    LEPT_FREE(ccr->xend);
+    LEPT_FREE(ccr->label);
+    memset(ccr, 0, sizeof(CCRUNS));
+}
+
+
 /*!
  * \brief   nextOnPixelInRaster()
  *
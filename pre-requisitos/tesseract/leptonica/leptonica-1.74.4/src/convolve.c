@@ -38,6 +38,8 @@
  *      Accumulator for 1, 8 and 32 bpp convolution
  *          PIX          *pixBlockconvAccum()
  *          static void   blockconvAccumLow()
+ *          static void   accumBandLow()
+ *          static l_int32  getAccumThreads()
  *
  *      Un-normalized grayscale block convolution
  *          PIX          *pixBlockconvGrayUnnormalized()
@@ -53,6 +55,9 @@
  *          PIX          *pixWindowedMeanSquare()
  *          l_int32       pixWindowedVariance()
  *          DPIX         *pixMeanSquareAccum()
+ *          l_int32       pixWindowedAccums()
+ *          PIX          *pixWindowedMeanFromAccum()
+ *          PIX          *pixWindowedMeanSquareFromAccum()
  *
  *      Binary block sum and rank filter
  *          PIX          *pixBlockrank()
@@ -81,10 +86,21 @@
  *      Additive gaussian noise
  *          PIX          *pixAddGaussNoise()
  *          l_float32     gaussDistribSampling()
+ *
+ *  The accumulators (integral images) are found on bands of lines in
+ *  parallel when built with OpenMP, and the block and windowed
+ *  convolutions over them are done on lines in parallel.  The results
+ *  are the same as with one thread.  To share the accumulators among
+ *  several window sizes or statistics of the same image, make them once
+ *  with pixWindowedAccums() and use the *FromAccum() functions, or
+ *  pass them to pixBlockconvGray().
  * </pre>
  */
 
 #include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
 #include "allheaders.h"
 
     /* These globals determine the subsampling factors for
@@ -93,16 +109,29 @@
 LEPT_DLL l_int32  ConvolveSamplingFactX = 1;
 LEPT_DLL l_int32  ConvolveSamplingFactY = 1;
 
+    /* Images with fewer pixels are done on a single thread */
+static const l_int32  MIN_PARALLEL_PIXELS = 1000000;
+
     /* Low-level static functions */
 static void blockconvLow(l_uint32 *data, l_int32 w, l_int32 h, l_int32 wpl,
                          l_uint32 *dataa, l_int32 wpla, l_int32 wc,
                          l_int32 hc);
-static void blockconvAccumLow(l_uint32 *datad, l_int32 w, l_int32 h,
-                              l_int32 wpld, l_uint32 *datas, l_int32 d,
+static void blockconvAccumLow(l_uint32 *datad, l_int32 wpld,
+                              l_float64 *datasq, l_int32 wplsq, l_int32 w,
+                              l_int32 h, l_uint32 *datas, l_int32 d,
                               l_int32 wpls);
+static void accumBandLow(l_uint32 *datad, l_int32 wpld, l_float64 *datasq,
+                         l_int32 wplsq, l_int32 w, l_int32 y0, l_int32 y1,
+                         l_uint32 *datas, l_int32 d, l_int32 wpls);
+static l_int32 getAccumThreads(l_int32 w, l_int32 h);
 static void blocksumLow(l_uint32 *datad, l_int32 w, l_int32 h, l_int32 wpl,
                         l_uint32 *dataa, l_int32 wpla, l_int32 wc, l_int32 hc);
 
+    /* Tile operation of pixBlockconvTiled(), run by pixTilingProcess();
+     * data is the array {wc, hc} */
+static l_int32 blockconvTile(PIX *pixt, l_int32 i, l_int32 j, PIX **ppixd,
+                             void *data);
+
 
 /*----------------------------------------------------------------------*
  *             Top-level grayscale or color block convolution           *
@@ -320,7 +349,7 @@ blockconvLow(l_uint32  *data,
              l_int32    wc,
              l_int32    hc)
 {
-l_int32    i, j, imax, imin, jmax, jmin;
+l_int32    i, j, imax, imin, jmax, jmin, nthreads;
 l_int32    wn, hn, fwc, fhc, wmwc, hmhc;
 l_float32  norm, normh, normw;
 l_uint32   val;
@@ -341,6 +370,11 @@ l_uint32  *linemina, *linemaxa, *line;
         /*------------------------------------------------------------*
          *  Compute, using b.c. only to set limits on the accum image *
          *------------------------------------------------------------*/
+    nthreads = getAccumThreads(w, h);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, imin, imax, jmin, jmax, line, linemina, linemaxa, val)
+#endif  /* _OPENMP */
     for (i = 0; i < h; i++) {
         imin = L_MAX(i - 1 - hc, 0);
         imax = L_MIN(i + hc, h - 1);
@@ -473,7 +507,7 @@ PIX       *pixd;
     datad = pixGetData(pixd);
     wpls = pixGetWpl(pixs);
     wpld = pixGetWpl(pixd);
-    blockconvAccumLow(datad, w, h, wpld, datas, d, wpls);
+    blockconvAccumLow(datad, wpld, NULL, 0, w, h, datas, d, wpls);
 
     return pixd;
 }
@@ -482,8 +516,12 @@ PIX       *pixd;
 /*
  *  blockconvAccumLow()
  *
- *      Input:  datad  (32 bpp dest)
- *              w, h, wpld (of 32 bpp dest)
+ *      Input:  datad [optional] (32 bpp dest for the sums)
+ *              wpld (of datad)
+ *              datasq [optional] (64 bit float dest for the sums of
+ *                                 squares; 8 bpp src only)
+ *              wplsq (of datasq)
+ *              w, h (of src and dest)
  *              datas (1, 8 or 32 bpp src)
  *              d (bpp of src)
  *              wpls (of src)
@@ -492,107 +530,188 @@ PIX       *pixd;
  *  Notes:
  *      (1) The general recursion relation is
  *             a(i,j) = v(i,j) + a(i-1, j) + a(i, j-1) - a(i-1, j-1)
- *          For the first line, this reduces to the special case
- *             a(0,j) = v(0,j) + a(0, j-1), j > 0
- *          For the first column, the special case is
- *             a(i,0) = v(i,0) + a(i-1, 0), i > 0
+ *          which is found here as
+ *             a(i,j) = r(i,j) + a(i-1, j)
+ *          where r(i,j) is the sum of v(i,k) for 0 <= k <= j.
+ *      (2) With more than one thread, the lines are split into bands,
+ *          and the accumulator of each band is found in parallel as if
+ *          the band started the image.  The last line of each band is
+ *          then completed in order, and added to the other lines of the
+ *          following band.  All sums are exact (modulo 2^32 for the
+ *          32 bpp accumulator, and far below 2^53 for the squares), so
+ *          the result does not depend on the number of threads.
  */
 static void
-blockconvAccumLow(l_uint32  *datad,
-                  l_int32    w,
-                  l_int32    h,
-                  l_int32    wpld,
-                  l_uint32  *datas,
-                  l_int32    d,
-                  l_int32    wpls)
+blockconvAccumLow(l_uint32   *datad,
+                  l_int32     wpld,
+                  l_float64  *datasq,
+                  l_int32     wplsq,
+                  l_int32     w,
+                  l_int32     h,
+                  l_uint32   *datas,
+                  l_int32     d,
+                  l_int32     wpls)
 {
-l_uint8    val;
-l_int32    i, j;
-l_uint32   val32;
-l_uint32  *lines, *lined, *linedp;
-
-    PROCNAME("blockconvAccumLow");
-
-    lines = datas;
-    lined = datad;
+l_int32     b, i, j, y0, y1, nbands;
+l_uint32   *lined, *linedp;
+l_float64  *linesq, *linesqp;
+
+    nbands = getAccumThreads(w, h);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nbands) if (nbands > 1)
+#endif  /* _OPENMP */
+    for (b = 0; b < nbands; b++) {
+        accumBandLow(datad, wpld, datasq, wplsq, w, b * h / nbands,
+                     (b + 1) * h / nbands, datas, d, wpls);
+    }
+    if (nbands == 1)
+        return;
 
-    if (d == 1) {
-            /* Do the first line */
-        for (j = 0; j < w; j++) {
-            val = GET_DATA_BIT(lines, j);
-            if (j == 0)
-                lined[0] = val;
-            else
-                lined[j] = lined[j - 1] + val;
+        /* Complete the last line of each band, in order */
+    for (b = 1; b < nbands; b++) {
+        i = (b + 1) * h / nbands - 1;
+        y0 = b * h / nbands;
+        if (datad) {
+            lined = datad + i * wpld;
+            linedp = datad + (y0 - 1) * wpld;
+            for (j = 0; j < w; j++)
+                lined[j] += linedp[j];
         }
+        if (datasq) {
+            linesq = datasq + i * wplsq;
+            linesqp = datasq + (y0 - 1) * wplsq;
+            for (j = 0; j < w; j++)
+                linesq[j] += linesqp[j];
+        }
+    }
 
-            /* Do the other lines */
-        for (i = 1; i < h; i++) {
-            lines = datas + i * wpls;
-            lined = datad + i * wpld;  /* curr dest line */
-            linedp = lined - wpld;   /* prev dest line */
-            for (j = 0; j < w; j++) {
-                val = GET_DATA_BIT(lines, j);
-                if (j == 0)
-                    lined[0] = val + linedp[0];
-                else
-                    lined[j] = val + lined[j - 1] + linedp[j] - linedp[j - 1];
+        /* Add the last line of the previous band to the rest */
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nbands - 1) \
+            private(i, j, y0, y1, lined, linedp, linesq, linesqp)
+#endif  /* _OPENMP */
+    for (b = 1; b < nbands; b++) {
+        y0 = b * h / nbands;
+        y1 = (b + 1) * h / nbands - 1;
+        for (i = y0; i < y1; i++) {
+            if (datad) {
+                lined = datad + i * wpld;
+                linedp = datad + (y0 - 1) * wpld;
+                for (j = 0; j < w; j++)
+                    lined[j] += linedp[j];
+            }
+            if (datasq) {
+                linesq = datasq + i * wplsq;
+                linesqp = datasq + (y0 - 1) * wplsq;
+                for (j = 0; j < w; j++)
+                    linesq[j] += linesqp[j];
             }
         }
-    } else if (d == 8) {
-            /* Do the first line */
-        for (j = 0; j < w; j++) {
-            val = GET_DATA_BYTE(lines, j);
-            if (j == 0)
-                lined[0] = val;
-            else
-                lined[j] = lined[j - 1] + val;
-        }
+    }
 
-            /* Do the other lines */
-        for (i = 1; i < h; i++) {
-            lines = datas + i * wpls;
-            lined = datad + i * wpld;  /* curr dest line */
-            linedp = lined - wpld;   /* prev dest line */
-            for (j = 0; j < w; j++) {
-                val = GET_DATA_BYTE(lines, j);
-                if (j == 0)
-                    lined[0] = val + linedp[0];
-                else
-                    lined[j] = val + lined[j - 1] + linedp[j] - linedp[j - 1];
+    return;
+}
+
+
+/*
+ *  accumBandLow()
+ *
+ *      Input:  datad, wpld, datasq, wplsq, w, datas, d, wpls
+ *                  (see blockconvAccumLow())
+ *              y0, y1 (first line of the band, and one past the last)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) This finds the accumulators of lines y0 through y1 - 1 as if
+ *          line y0 were the first line of the image.
+ */
+static void
+accumBandLow(l_uint32   *datad,
+             l_int32     wpld,
+             l_float64  *datasq,
+             l_int32     wplsq,
+             l_int32     w,
+             l_int32     y0,
+             l_int32     y1,
+             l_uint32   *datas,
+             l_int32     d,
+             l_int32     wpls)
+{
+l_int32     i, j, val;
+l_uint32    sum;
+l_float64   sumsq;
+l_uint32   *lines, *lined, *linedp;
+l_float64  *linesq, *linesqp;
+
+    for (i = y0; i < y1; i++) {
+        lines = datas + i * wpls;
+        if (datad) {
+            lined = datad + i * wpld;
+            sum = 0;
+            if (d == 1) {
+                for (j = 0; j < w; j++) {
+                    sum += GET_DATA_BIT(lines, j);
+                    lined[j] = sum;
+                }
+            } else if (d == 8) {
+                for (j = 0; j < w; j++) {
+                    sum += GET_DATA_BYTE(lines, j);
+                    lined[j] = sum;
+                }
+            } else {  /* d == 32 */
+                for (j = 0; j < w; j++) {
+                    sum += lines[j];
+                    lined[j] = sum;
+                }
+            }
+            if (i > y0) {
+                linedp = lined - wpld;
+                for (j = 0; j < w; j++)
+                    lined[j] += linedp[j];
             }
         }
-    } else if (d == 32) {
-            /* Do the first line */
-        for (j = 0; j < w; j++) {
-            val32 = lines[j];
-            if (j == 0)
-                lined[0] = val32;
-            else
-                lined[j] = lined[j - 1] + val32;
-        }
-
-            /* Do the other lines */
-        for (i = 1; i < h; i++) {
-            lines = datas + i * wpls;
-            lined = datad + i * wpld;  /* curr dest line */
-            linedp = lined - wpld;   /* prev dest line */
+        if (datasq) {
+            linesq = datasq + i * wplsq;
+            sumsq = 0.0;
             for (j = 0; j < w; j++) {
-                val32 = lines[j];
-                if (j == 0)
-                    lined[0] = val32 + linedp[0];
-                else
-                    lined[j] = val32 + lined[j - 1] + linedp[j] - linedp[j - 1];
+                val = GET_DATA_BYTE(lines, j);
+                sumsq += val * val;
+                linesq[j] = sumsq;
+            }
+            if (i > y0) {
+                linesqp = linesq - wplsq;
+                for (j = 0; j < w; j++)
+                    linesq[j] += linesqp[j];
             }
         }
-    } else {
-        L_ERROR("depth not 1, 8 or 32 bpp\n", procName);
     }
 
     return;
 }
 
 
+/*
+ *  getAccumThreads()
+ *
+ *      Input:  w, h (of the image)
+ *      Return: number of threads (and bands of lines) to use;
+ *              1 without OpenMP
+ */
+static l_int32
+getAccumThreads(l_int32  w,
+                l_int32  h)
+{
+l_int32  nthreads;
+
+    nthreads = 1;
+#ifdef _OPENMP
+    if ((l_float64)w * h >= MIN_PARALLEL_PIXELS)
+        nthreads = L_MAX(1, L_MIN(omp_get_max_threads(), h));
+#endif  /* _OPENMP */
+    return nthreads;
+}
+
+
 /*----------------------------------------------------------------------*
  *               Un-normalized grayscale block convolution              *
  *----------------------------------------------------------------------*/
@@ -720,7 +839,8 @@ PIX       *pixsb, *pixacc, *pixd;
  *          (b) The accumulator array for 16M pixels is 64 MB; using
  *              tiles reduces the size of this array.
  *          (c) Each tile can be processed independently, in parallel,
- *              on a multicore processor.
+ *              on a multicore processor.  This is done with OpenMP;
+ *              see pixTilingProcess().
  * </pre>
  */
 PIX *
@@ -730,9 +850,9 @@ pixBlockconvTiled(PIX     *pix,
                   l_int32  nx,
                   l_int32  ny)
 {
-l_int32     i, j, w, h, d, xrat, yrat;
-PIX        *pixs, *pixd, *pixc, *pixt;
-PIX        *pixr, *pixrc, *pixg, *pixgc, *pixb, *pixbc;
+l_int32     w, h, d, xrat, yrat;
+l_int32     size[2];
+PIX        *pixs, *pixd;
 PIXTILING  *pt;
 
     PROCNAME("pixBlockconvTiled");
@@ -793,40 +913,53 @@ PIXTILING  *pt;
         return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
     }
     pt = pixTilingCreate(pixs, nx, ny, 0, 0, wc + 2, hc + 2);
-    for (i = 0; i < ny; i++) {
-        for (j = 0; j < nx; j++) {
-            pixt = pixTilingGetTile(pt, i, j);
-
-                /* Convolve over the tile */
-            if (d == 8) {
-                pixc = pixBlockconvGrayTile(pixt, NULL, wc, hc);
-            } else { /* d == 32 */
-                pixr = pixGetRGBComponent(pixt, COLOR_RED);
-                pixrc = pixBlockconvGrayTile(pixr, NULL, wc, hc);
-                pixDestroy(&pixr);
-                pixg = pixGetRGBComponent(pixt, COLOR_GREEN);
-                pixgc = pixBlockconvGrayTile(pixg, NULL, wc, hc);
-                pixDestroy(&pixg);
-                pixb = pixGetRGBComponent(pixt, COLOR_BLUE);
-                pixbc = pixBlockconvGrayTile(pixb, NULL, wc, hc);
-                pixDestroy(&pixb);
-                pixc = pixCreateRGBImage(pixrc, pixgc, pixbc);
-                pixDestroy(&pixrc);
-                pixDestroy(&pixgc);
-                pixDestroy(&pixbc);
-            }
-
-            pixTilingPaintTile(pixd, i, j, pixc, pt);
-            pixDestroy(&pixt);
-            pixDestroy(&pixc);
-        }
-    }
+    size[0] = wc;
+    size[1] = hc;
+    pixTilingProcess(pt, blockconvTile, size, &pixd, 1, 0);
 
     pixDestroy(&pixs);
     pixTilingDestroy(&pt);
     return pixd;
 }
 
+/*!
+ * \brief   blockconvTile()
+ *
+ *  Convolves one tile of pixBlockconvTiled(), of 8 or 32 bpp.
+ */
+static l_int32
+blockconvTile(PIX      *pixt,
+              l_int32   i,
+              l_int32   j,
+              PIX     **ppixd,
+              void     *data)
+{
+l_int32   wc, hc;
+PIX      *pixr, *pixrc, *pixg, *pixgc, *pixb, *pixbc;
+
+    wc = ((l_int32 *)data)[0];
+    hc = ((l_int32 *)data)[1];
+    if (pixGetDepth(pixt) == 8) {
+        ppixd[0] = pixBlockconvGrayTile(pixt, NULL, wc, hc);
+    } else { /* d == 32 */
+        pixr = pixGetRGBComponent(pixt, COLOR_RED);
+        pixrc = pixBlockconvGrayTile(pixr, NULL, wc, hc);
+        pixDestroy(&pixr);
+        pixg = pixGetRGBComponent(pixt, COLOR_GREEN);
+        pixgc = pixBlockconvGrayTile(pixg, NULL, wc, hc);
+        pixDestroy(&pixg);
+        pixb = pixGetRGBComponent(pixt, COLOR_BLUE);
+        pixbc = pixBlockconvGrayTile(pixb, NULL, wc, hc);
+        pixDestroy(&pixb);
+        ppixd[0] = pixCreateRGBImage(pixrc, pixgc, pixbc);
+        pixDestroy(&pixrc);
+        pixDestroy(&pixgc);
+        pixDestroy(&pixbc);
+    }
+    return (ppixd[0] != NULL) ? 0 : 1;
+}
+
+
 
 /*!
  * \brief   pixBlockconvGrayTile()
@@ -986,7 +1119,9 @@ pixWindowedStats(PIX     *pixs,
                  FPIX   **pfpixv,
                  FPIX   **pfpixrv)
 {
-PIX  *pixb, *pixm, *pixms;
+l_int32  needm, needms;
+DPIX    *dpixacc;
+PIX     *pixb, *pixacc, *pixm, *pixms;
 
     PROCNAME("pixWindowedStats");
 
@@ -1007,16 +1142,20 @@ PIX  *pixb, *pixm, *pixms;
     else
         pixb = pixClone(pixs);
 
-    if (!pfpixv && !pfpixrv) {
-        if (ppixm) *ppixm = pixWindowedMean(pixb, wc, hc, 1, 1);
-        if (ppixms) *ppixms = pixWindowedMeanSquare(pixb, wc, hc, 1);
-        pixDestroy(&pixb);
-        return 0;
-    }
+        /* Make the accumulators that are needed in one pass */
+    needm = (ppixm || pfpixv || pfpixrv);
+    needms = (ppixms || pfpixv || pfpixrv);
+    pixacc = NULL;
+    dpixacc = NULL;
+    pixWindowedAccums(pixb, (needm) ? &pixacc : NULL,
+                      (needms) ? &dpixacc : NULL);
+    pixm = (needm) ? pixWindowedMeanFromAccum(pixacc, wc, hc, 8, 1) : NULL;
+    pixms = (needms) ? pixWindowedMeanSquareFromAccum(dpixacc, wc, hc) : NULL;
+    pixDestroy(&pixacc);
+    dpixDestroy(&dpixacc);
 
-    pixm = pixWindowedMean(pixb, wc, hc, 1, 1);
-    pixms = pixWindowedMeanSquare(pixb, wc, hc, 1);
-    pixWindowedVariance(pixm, pixms, pfpixv, pfpixrv);
+    if (pfpixv || pfpixrv)
+        pixWindowedVariance(pixm, pixms, pfpixv, pfpixrv);
     if (ppixm)
         *ppixm = pixm;
     else
@@ -1054,7 +1193,8 @@ PIX  *pixb, *pixm, *pixms;
  *          within the window, rather than a normalized convolution,
  *          use %normflag == 0.
  *      (4) This builds a block accumulator pix, uses it here, and
- *          destroys it.
+ *          destroys it.  To use one accumulator for several windows,
+ *          see pixWindowedMeanFromAccum().
  *      (5) The added border, along with the use of an accumulator array,
  *          allows computation without special treatment of pixels near
  *          the image boundary, and runs in a time that is independent
@@ -1068,11 +1208,8 @@ pixWindowedMean(PIX     *pixs,
                 l_int32  hasborder,
                 l_int32  normflag)
 {
-l_int32    i, j, w, h, d, wd, hd, wplc, wpld, wincr, hincr;
-l_uint32   val;
-l_uint32  *datac, *datad, *linec1, *linec2, *lined;
-l_float32  norm;
-PIX       *pixb, *pixc, *pixd;
+l_int32  d;
+PIX     *pixb, *pixc, *pixd;
 
     PROCNAME("pixWindowedMean");
 
@@ -1084,8 +1221,6 @@ PIX       *pixb, *pixc, *pixd;
     if (wc < 2 || hc < 2)
         return (PIX *)ERROR_PTR("wc and hc not >= 2", procName, NULL);
 
-    pixb = pixc = pixd = NULL;
-
         /* Add border if requested */
     if (!hasborder)
         pixb = pixAddBorderGeneral(pixs, wc + 1, wc + 1, hc + 1, hc + 1, 0);
@@ -1093,51 +1228,12 @@ PIX       *pixb, *pixc, *pixd;
         pixb = pixClone(pixs);
 
         /* Make the accumulator pix from pixb */
-    if ((pixc = pixBlockconvAccum(pixb)) == NULL) {
+    pixd = NULL;
+    if ((pixc = pixBlockconvAccum(pixb)) == NULL)
         L_ERROR("pixc not made\n", procName);
-        goto cleanup;
-    }
-    wplc = pixGetWpl(pixc);
-    datac = pixGetData(pixc);
-
-        /* The output has wc + 1 border pixels stripped from each side
-         * of pixb, and hc + 1 border pixels stripped from top and bottom. */
-    pixGetDimensions(pixb, &w, &h, NULL);
-    wd = w - 2 * (wc + 1);
-    hd = h - 2 * (hc + 1);
-    if (wd < 2 || hd < 2) {
-        L_ERROR("w or h is too small for the kernel\n", procName);
-        goto cleanup;
-    }
-    if ((pixd = pixCreate(wd, hd, d)) == NULL) {
-        L_ERROR("pixd not made\n", procName);
-        goto cleanup;
-    }
-    wpld = pixGetWpl(pixd);
-    datad = pixGetData(pixd);
-
-    wincr = 2 * wc + 1;
-    hincr = 2 * hc + 1;
-    norm = 1.0;  /* use this for sum-in-window */
-    if (normflag)
-        norm = 1.0 / (wincr * hincr);
-    for (i = 0; i < hd; i++) {
-        linec1 = datac + i * wplc;
-        linec2 = datac + (i + hincr) * wplc;
-        lined = datad + i * wpld;
-        for (j = 0; j < wd; j++) {
-            val = linec2[j + wincr] - linec2[j] - linec1[j + wincr] + linec1[j];
-            if (d == 8) {
-                val = (l_uint8)(norm * val);
-                SET_DATA_BYTE(lined, j, val);
-            } else {  /* d == 32 */
-                val = (l_uint32)(norm * val);
-                lined[j] = val;
-            }
-        }
-    }
+    else
+        pixd = pixWindowedMeanFromAccum(pixc, wc, hc, d, normflag);
 
-cleanup:
     pixDestroy(&pixb);
     pixDestroy(&pixc);
     return pixd;
@@ -1184,14 +1280,8 @@ pixWindowedMeanSquare(PIX     *pixs,
                       l_int32  hc,
                       l_int32  hasborder)
 {
-l_int32     i, j, w, h, wd, hd, wpl, wpld, wincr, hincr;
-l_uint32    ival;
-l_uint32   *datad, *lined;
-l_float64   norm;
-l_float64   val;
-l_float64  *data, *line1, *line2;
-DPIX       *dpix;
-PIX        *pixb, *pixd;
+DPIX  *dpix;
+PIX   *pixb, *pixd;
 
     PROCNAME("pixWindowedMeanSquare");
 
@@ -1200,52 +1290,18 @@ PIX        *pixb, *pixd;
     if (wc < 2 || hc < 2)
         return (PIX *)ERROR_PTR("wc and hc not >= 2", procName, NULL);
 
-    pixd = NULL;
-
         /* Add border if requested */
     if (!hasborder)
         pixb = pixAddBorderGeneral(pixs, wc + 1, wc + 1, hc + 1, hc + 1, 0);
     else
         pixb = pixClone(pixs);
 
-    if ((dpix = pixMeanSquareAccum(pixb)) == NULL) {
+    pixd = NULL;
+    if ((dpix = pixMeanSquareAccum(pixb)) == NULL)
         L_ERROR("dpix not made\n", procName);
-        goto cleanup;
-    }
-    wpl = dpixGetWpl(dpix);
-    data = dpixGetData(dpix);
-
-        /* The output has wc + 1 border pixels stripped from each side
-         * of pixb, and hc + 1 border pixels stripped from top and bottom. */
-    pixGetDimensions(pixb, &w, &h, NULL);
-    wd = w - 2 * (wc + 1);
-    hd = h - 2 * (hc + 1);
-    if (wd < 2 || hd < 2) {
-        L_ERROR("w or h too small for kernel\n", procName);
-        goto cleanup;
-    }
-    if ((pixd = pixCreate(wd, hd, 32)) == NULL) {
-        L_ERROR("pixd not made\n", procName);
-        goto cleanup;
-    }
-    wpld = pixGetWpl(pixd);
-    datad = pixGetData(pixd);
-
-    wincr = 2 * wc + 1;
-    hincr = 2 * hc + 1;
-    norm = 1.0 / (wincr * hincr);
-    for (i = 0; i < hd; i++) {
-        line1 = data + i * wpl;
-        line2 = data + (i + hincr) * wpl;
-        lined = datad + i * wpld;
-        for (j = 0; j < wd; j++) {
-            val = line2[j + wincr] - line2[j] - line1[j + wincr] + line1[j];
-            ival = (l_uint32)(norm * val);
-            lined[j] = ival;
-        }
-    }
+    else
+        pixd = pixWindowedMeanSquareFromAccum(dpix, wc, hc);
 
-cleanup:
     dpixDestroy(&dpix);
     pixDestroy(&pixb);
     return pixd;
@@ -1368,50 +1424,248 @@ FPIX       *fpixv, *fpixrv;  /* variance and square root of variance */
 DPIX *
 pixMeanSquareAccum(PIX  *pixs)
 {
-l_int32     i, j, w, h, wpl, wpls, val;
-l_uint32   *datas, *lines;
-l_float64  *data, *line, *linep;
-DPIX       *dpix;
+l_int32  w, h;
+DPIX    *dpix;
 
     PROCNAME("pixMeanSquareAccum");
 
-
     if (!pixs || (pixGetDepth(pixs) != 8))
         return (DPIX *)ERROR_PTR("pixs undefined or not 8 bpp", procName, NULL);
     pixGetDimensions(pixs, &w, &h, NULL);
     if ((dpix = dpixCreate(w, h)) ==  NULL)
         return (DPIX *)ERROR_PTR("dpix not made", procName, NULL);
 
-    datas = pixGetData(pixs);
-    wpls = pixGetWpl(pixs);
-    data = dpixGetData(dpix);
-    wpl = dpixGetWpl(dpix);
-
-    lines = datas;
-    line = data;
-    for (j = 0; j < w; j++) {   /* first line */
-        val = GET_DATA_BYTE(lines, j);
-        if (j == 0)
-            line[0] = val * val;
-        else
-            line[j] = line[j - 1] + val * val;
+    blockconvAccumLow(NULL, 0, dpixGetData(dpix), dpixGetWpl(dpix), w, h,
+                      pixGetData(pixs), 8, pixGetWpl(pixs));
+    return dpix;
+}
+
+
+/*!
+ * \brief   pixWindowedAccums()
+ *
+ * \param[in]    pixs 8 bpp grayscale
+ * \param[out]   ppixacc [optional] 32 bpp accumulator of the pixel values
+ * \param[out]   pdpixacc [optional] accumulator of the squared values
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This makes, in a single pass over pixs, the accumulators
+ *          that pixBlockconvAccum() and pixMeanSquareAccum() make
+ *          separately.
+ *      (2) The accumulators do not depend on the window size.  Use them
+ *          with pixWindowedMeanFromAccum() and
+ *          pixWindowedMeanSquareFromAccum() for as many window sizes as
+ *          needed; the 32 bpp one can also be given to pixBlockconvGray().
+ *          For the windowed functions, pixs must already have the border
+ *          they require; see pixWindowedMean().
+ * </pre>
+ */
+l_int32
+pixWindowedAccums(PIX    *pixs,
+                  PIX   **ppixacc,
+                  DPIX  **pdpixacc)
+{
+l_int32     w, h;
+l_uint32   *datad;
+l_float64  *datasq;
+DPIX       *dpix;
+PIX        *pixd;
+
+    PROCNAME("pixWindowedAccums");
+
+    if (ppixacc) *ppixacc = NULL;
+    if (pdpixacc) *pdpixacc = NULL;
+    if (!ppixacc && !pdpixacc)
+        return ERROR_INT("no output requested", procName, 1);
+    if (!pixs || pixGetDepth(pixs) != 8)
+        return ERROR_INT("pixs not defined or not 8 bpp", procName, 1);
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    pixd = NULL;
+    dpix = NULL;
+    datad = NULL;
+    datasq = NULL;
+    if (ppixacc) {
+        if ((pixd = pixCreate(w, h, 32)) == NULL)
+            return ERROR_INT("pixd not made", procName, 1);
+        datad = pixGetData(pixd);
+    }
+    if (pdpixacc) {
+        if ((dpix = dpixCreate(w, h)) == NULL) {
+            pixDestroy(&pixd);
+            return ERROR_INT("dpix not made", procName, 1);
+        }
+        datasq = dpixGetData(dpix);
     }
 
-        /* Do the other lines */
-    for (i = 1; i < h; i++) {
-        lines = datas + i * wpls;
-        line = data + i * wpl;  /* current dest line */
-        linep = line - wpl;;  /* prev dest line */
-        for (j = 0; j < w; j++) {
-            val = GET_DATA_BYTE(lines, j);
-            if (j == 0)
-                line[0] = linep[0] + val * val;
-            else
-                line[j] = line[j - 1] + linep[j] - linep[j - 1] + val * val;
+    blockconvAccumLow(datad, (pixd) ? pixGetWpl(pixd) : 0,
+                      datasq, (dpix) ? dpixGetWpl(dpix) : 0, w, h,
+                      pixGetData(pixs), 8, pixGetWpl(pixs));
+    if (ppixacc) *ppixacc = pixd;
+    if (pdpixacc) *pdpixacc = dpix;
+    return 0;
+}
+
+
+/*!
+ * \brief   pixWindowedMeanFromAccum()
+ *
+ * \param[in]    pixacc    32 bpp accumulator of an image with border
+ * \param[in]    wc, hc    half width/height of convolution kernel
+ * \param[in]    d         depth of the output: 8 or 32
+ * \param[in]    normflag  1 for normalization to get average in window;
+ *                         0 for the sum in the window (un-normalized)
+ * \return  pixd 8 or 32 bpp, average over kernel window
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is pixWindowedMean(), given the accumulator of the image
+ *          with its border of (wc + 1) pixels on left and right and
+ *          (hc + 1) on top and bottom.  The output has the border removed.
+ *      (2) Make %pixacc with pixBlockconvAccum() or pixWindowedAccums().
+ * </pre>
+ */
+PIX *
+pixWindowedMeanFromAccum(PIX     *pixacc,
+                         l_int32  wc,
+                         l_int32  hc,
+                         l_int32  d,
+                         l_int32  normflag)
+{
+l_int32    i, j, w, h, wd, hd, wplc, wpld, wincr, hincr, nthreads;
+l_uint32   val;
+l_uint32  *datac, *datad, *linec1, *linec2, *lined;
+l_float32  norm;
+PIX       *pixd;
+
+    PROCNAME("pixWindowedMeanFromAccum");
+
+    if (!pixacc || pixGetDepth(pixacc) != 32)
+        return (PIX *)ERROR_PTR("pixacc undefined or not 32 bpp",
+                                procName, NULL);
+    if (d != 8 && d != 32)
+        return (PIX *)ERROR_PTR("d not 8 or 32 bpp", procName, NULL);
+    if (wc < 2 || hc < 2)
+        return (PIX *)ERROR_PTR("wc and hc not >= 2", procName, NULL);
+
+        /* The output has wc + 1 border pixels stripped from each side
+         * of pixb, and hc + 1 border pixels stripped from top and bottom. */
+    pixGetDimensions(pixacc, &w, &h, NULL);
+    wd = w - 2 * (wc + 1);
+    hd = h - 2 * (hc + 1);
+    if (wd < 2 || hd < 2)
+        return (PIX *)ERROR_PTR("w or h is too small for the kernel",
+                                procName, NULL);
+    if ((pixd = pixCreate(wd, hd, d)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    wplc = pixGetWpl(pixacc);
+    datac = pixGetData(pixacc);
+    wpld = pixGetWpl(pixd);
+    datad = pixGetData(pixd);
+
+    wincr = 2 * wc + 1;
+    hincr = 2 * hc + 1;
+    norm = 1.0;  /* use this for sum-in-window */
+    if (normflag)
+        norm = 1.0 / (wincr * hincr);
+    nthreads = getAccumThreads(wd, hd);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, linec1, linec2, lined, val)
+#endif  /* _OPENMP */
+    for (i = 0; i < hd; i++) {
+        linec1 = datac + i * wplc;
+        linec2 = datac + (i + hincr) * wplc;
+        lined = datad + i * wpld;
+        for (j = 0; j < wd; j++) {
+            val = linec2[j + wincr] - linec2[j] - linec1[j + wincr] + linec1[j];
+            if (d == 8) {
+                val = (l_uint8)(norm * val);
+                SET_DATA_BYTE(lined, j, val);
+            } else {  /* d == 32 */
+                val = (l_uint32)(norm * val);
+                lined[j] = val;
+            }
         }
     }
 
-    return dpix;
+    return pixd;
+}
+
+
+/*!
+ * \brief   pixWindowedMeanSquareFromAccum()
+ *
+ * \param[in]    dpixacc   accumulator of squares of an image with border
+ * \param[in]    wc, hc    half width/height of convolution kernel
+ * \return  pixd 32 bpp, average over rectangular window of
+ *                    width = 2 * wc + 1 and height = 2 * hc + 1
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is pixWindowedMeanSquare(), given the accumulator of the
+ *          squares of the image with its border of (wc + 1) pixels on
+ *          left and right and (hc + 1) on top and bottom.  The output has
+ *          the border removed.
+ *      (2) Make %dpixacc with pixMeanSquareAccum() or pixWindowedAccums().
+ * </pre>
+ */
+PIX *
+pixWindowedMeanSquareFromAccum(DPIX    *dpixacc,
+                               l_int32  wc,
+                               l_int32  hc)
+{
+l_int32     i, j, w, h, wd, hd, wpl, wpld, wincr, hincr, nthreads;
+l_uint32    ival;
+l_uint32   *datad, *lined;
+l_float64   norm;
+l_float64   val;
+l_float64  *data, *line1, *line2;
+PIX        *pixd;
+
+    PROCNAME("pixWindowedMeanSquareFromAccum");
+
+    if (!dpixacc)
+        return (PIX *)ERROR_PTR("dpixacc not defined", procName, NULL);
+    if (wc < 2 || hc < 2)
+        return (PIX *)ERROR_PTR("wc and hc not >= 2", procName, NULL);
+
+        /* The output has wc + 1 border pixels stripped from each side
+         * of pixb, and hc + 1 border pixels stripped from top and bottom. */
+    dpixGetDimensions(dpixacc, &w, &h);
+    wd = w - 2 * (wc + 1);
+    hd = h - 2 * (hc + 1);
+    if (wd < 2 || hd < 2)
+        return (PIX *)ERROR_PTR("w or h too small for kernel", procName, NULL);
+    if ((pixd = pixCreate(wd, hd, 32)) == NULL)
+        return (PIX *)ERROR_PTR("pixd not made", procName, NULL);
+    wpl = dpixGetWpl(dpixacc);
+    data = dpixGetData(dpixacc);
+    wpld = pixGetWpl(pixd);
+    datad = pixGetData(pixd);
+
+    wincr = 2 * wc + 1;
+    hincr = 2 * hc + 1;
+    norm = 1.0 / (wincr * hincr);
+    nthreads = getAccumThreads(wd, hd);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, line1, line2, lined, val, ival)
+#endif  /* _OPENMP */
+    for (i = 0; i < hd; i++) {
+        line1 = data + i * wpl;
+        line2 = data + (i + hincr) * wpl;
+        lined = datad + i * wpld;
+        for (j = 0; j < wd; j++) {
+            val = line2[j + wincr] - line2[j] - line1[j + wincr] + line1[j];
+            ival = (l_uint32)(norm * val);
+            lined[j] = ival;
+        }
+    }
+
+    return pixd;
 }
 
 
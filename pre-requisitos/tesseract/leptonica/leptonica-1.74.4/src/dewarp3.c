@@ -35,6 +35,7 @@
  *          static l_int32     dewarpaApplyInit()
  *          static PIX        *pixApplyVertDisparity()
  *          static PIX        *pixApplyHorizDisparity()
+ *          static l_int32     getDisparityThreads()
  *
  *      Apply disparity array to boxa
  *          l_int32            dewarpaApplyDisparityBoxa()
@@ -52,13 +53,20 @@
  */
 
 #include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
 #include "allheaders.h"
 
+    /* Images with fewer pixels are done on a single thread */
+static const l_int32  MIN_PARALLEL_PIXELS = 1000000;
+
 static l_int32 dewarpaApplyInit(L_DEWARPA *dewa, l_int32 pageno, PIX *pixs,
                                 l_int32 x, l_int32 y, L_DEWARP **pdew,
                                 const char *debugfile);
 static PIX *pixApplyVertDisparity(L_DEWARP *dew, PIX *pixs, l_int32 grayin);
 static PIX * pixApplyHorizDisparity(L_DEWARP *dew, PIX *pixs, l_int32 grayin);
+static l_int32 getDisparityThreads(l_int32 w, l_int32 h);
 static BOXA *boxaApplyDisparity(L_DEWARP *dew, BOXA *boxa, l_int32 direction,
                                 l_int32 mapdir);
 
@@ -302,6 +310,8 @@ PIX       *pix1;
  *      (2) Specify gray color for pixels brought in from the outside:
  *          0 is black, 255 is white.  Use -1 to select pixels from the
  *          boundary of the source image.
+ *      (3) Each line of pixd is only read from pixs, so bands of lines
+ *          are done on separate threads with OpenMP.
  * </pre>
  */
 static PIX *
@@ -309,7 +319,7 @@ pixApplyVertDisparity(L_DEWARP  *dew,
                       PIX       *pixs,
                       l_int32    grayin)
 {
-l_int32     i, j, w, h, d, fw, fh, wpld, wplf, isrc, val8;
+l_int32     i, j, w, h, d, fw, fh, wpld, wplf, isrc, val8, nthreads;
 l_uint32   *datad, *lined;
 l_float32  *dataf, *linef;
 void      **lineptrs;
@@ -342,8 +352,13 @@ PIX        *pixd;
     dataf = fpixGetData(fpix);
     wpld = pixGetWpl(pixd);
     wplf = fpixGetWpl(fpix);
+    nthreads = getDisparityThreads(w, h);
     if (d == 1) {
         lineptrs = pixGetLinePtrs(pixs, NULL);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, lined, linef, isrc)
+#endif  /* _OPENMP */
         for (i = 0; i < h; i++) {
             lined = datad + i * wpld;
             linef = dataf + i * wplf;
@@ -359,6 +374,10 @@ PIX        *pixd;
         }
     } else if (d == 8) {
         lineptrs = pixGetLinePtrs(pixs, NULL);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, lined, linef, isrc, val8)
+#endif  /* _OPENMP */
         for (i = 0; i < h; i++) {
             lined = datad + i * wpld;
             linef = dataf + i * wplf;
@@ -374,6 +393,10 @@ PIX        *pixd;
         }
     } else {  /* d == 32 */
         lineptrs = pixGetLinePtrs(pixs, NULL);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, lined, linef, isrc)
+#endif  /* _OPENMP */
         for (i = 0; i < h; i++) {
             lined = datad + i * wpld;
             linef = dataf + i * wplf;
@@ -412,6 +435,8 @@ PIX        *pixd;
  *      (3) The input pixs has already been corrected for vertical disparity.
  *          If the horizontal disparity array doesn't exist, this returns
  *          a clone of %pixs.
+ *      (4) As for vertical disparity, bands of lines are done on separate
+ *          threads with OpenMP.
  * </pre>
  */
 static PIX *
@@ -419,7 +444,7 @@ pixApplyHorizDisparity(L_DEWARP  *dew,
                        PIX       *pixs,
                        l_int32    grayin)
 {
-l_int32     i, j, w, h, d, fw, fh, wpls, wpld, wplf, jsrc, val8;
+l_int32     i, j, w, h, d, fw, fh, wpls, wpld, wplf, jsrc, val8, nthreads;
 l_uint32   *datas, *lines, *datad, *lined;
 l_float32  *dataf, *linef;
 FPIX       *fpix;
@@ -453,7 +478,12 @@ PIX        *pixd;
     wpls = pixGetWpl(pixs);
     wpld = pixGetWpl(pixd);
     wplf = fpixGetWpl(fpix);
+    nthreads = getDisparityThreads(w, h);
     if (d == 1) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, lines, lined, linef, jsrc)
+#endif  /* _OPENMP */
         for (i = 0; i < h; i++) {
             lines = datas + i * wpls;
             lined = datad + i * wpld;
@@ -469,6 +499,10 @@ PIX        *pixd;
             }
         }
     } else if (d == 8) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, lines, lined, linef, jsrc, val8)
+#endif  /* _OPENMP */
         for (i = 0; i < h; i++) {
             lines = datas + i * wpls;
             lined = datad + i * wpld;
@@ -484,6 +518,10 @@ PIX        *pixd;
             }
         }
     } else {  /* d == 32 */
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, lines, lined, linef, jsrc)
+#endif  /* _OPENMP */
         for (i = 0; i < h; i++) {
             lines = datas + i * wpls;
             lined = datad + i * wpld;
@@ -502,6 +540,28 @@ PIX        *pixd;
 }
 
 
+/*!
+ * \brief   getDisparityThreads()
+ *
+ * \param[in]    w, h size of the image the disparity is applied to
+ * \return  number of threads (and bands of lines) to use;
+ *              1 without OpenMP
+ */
+static l_int32
+getDisparityThreads(l_int32  w,
+                    l_int32  h)
+{
+l_int32  nthreads;
+
+    nthreads = 1;
+#ifdef _OPENMP
+    if ((l_float64)w * h >= MIN_PARALLEL_PIXELS)
+        nthreads = L_MAX(1, L_MIN(omp_get_max_threads(), h));
+#endif  /* _OPENMP */
+    return nthreads;
+}
+
+
 /*----------------------------------------------------------------------*
  *                 Apply warping disparity array to boxa                *
  *----------------------------------------------------------------------*/
@@ -810,21 +870,23 @@ FPIX       *fpixt1, *fpixt2;
         /* Destroy the existing arrays if they are too small */
     if (dew->fullvdispar) {
         fpixGetDimensions(dew->fullvdispar, &fw, &fh);
-        if (width > fw || height > fw)
+        if (width > fw || height > fh)
             fpixDestroy(&dew->fullvdispar);
     }
     if (dew->fullhdispar) {
         fpixGetDimensions(dew->fullhdispar, &fw, &fh);
-        if (width > fw || height > fw)
+        if (width > fw || height > fh)
             fpixDestroy(&dew->fullhdispar);
     }
 
-        /* Find the required width and height expansion deltas */
-    deltaw = width - dew->sampling * (dew->nx - 1) + 2;
-    deltah = height - dew->sampling * (dew->ny - 1) + 2;
+        /* Find the required width and height expansion deltas.  The
+         * sampled arrays span sampling * (n - 1) pixels of the reduced
+         * image, and redfactor times that at full resolution. */
     redfactor = dew->redfactor;
-    deltaw = redfactor * L_MAX(0, deltaw);
-    deltah = redfactor * L_MAX(0, deltah);
+    deltaw = width - redfactor * dew->sampling * (dew->nx - 1) + 2;
+    deltah = height - redfactor * dew->sampling * (dew->ny - 1) + 2;
+    deltaw = L_MAX(0, deltaw);
+    deltah = L_MAX(0, deltah);
 
         /* Generate the full res vertical array if it doesn't exist,
          * extending it as required to make it big enough.  Use x,y
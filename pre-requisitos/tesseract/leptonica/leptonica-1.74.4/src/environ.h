@@ -247,6 +247,19 @@ enum {
 };
 
 
+/*------------------------------------------------------------------------*
+ *                 Instruction sets of the vectorized code                *
+ *------------------------------------------------------------------------*/
+
+/*! Instruction sets of the vectorized code; see setSimdLevel() */
+enum {
+    L_SIMD_AUTO = -1,        /* widest set of the processor in use        */
+    L_SIMD_NONE = 0,         /* scalar code only                          */
+    L_SIMD_SSE2 = 1,
+    L_SIMD_AVX2 = 2
+};
+
+
 /*------------------------------------------------------------------------*
  *                     Path separator conversion                          *
  *------------------------------------------------------------------------*/
@@ -286,6 +299,38 @@ typedef struct L_WallTimer  L_WALLTIMER;
 #define LEPT_FREE(ptr)                   free(ptr)
 
 
+/*------------------------------------------------------------------------*
+ *                           Reference counts                             *
+ *                                                                        *
+ *  Clones of a Pix, Box, Boxa or Pixa are the same object, which is      *
+ *  freed when the last of them is destroyed.  By default the counts      *
+ *  are plain integers, and clones of one object must not be made or     *
+ *  destroyed on several threads at once.  Build the library with         *
+ *  LEPT_ATOMIC_REFCOUNT defined (e.g., CPPFLAGS=-DLEPT_ATOMIC_REFCOUNT,  *
+ *  or the cmake option ATOMIC_REFCOUNT) to update them atomically, so    *
+ *  that each thread can be handed its own clone and destroy it there.   *
+ *  The content of a shared object is still not guarded: threads may     *
+ *  read it, but changes need a copy or a lock of their own.              *
+ *------------------------------------------------------------------------*/
+#if defined(LEPT_ATOMIC_REFCOUNT) && defined(__GNUC__)
+  #define L_REFCOUNT_ADD(count, delta) \
+          __atomic_add_fetch(&(count), (delta), __ATOMIC_ACQ_REL)
+  #define L_REFCOUNT_GET(count)  __atomic_load_n(&(count), __ATOMIC_ACQUIRE)
+#elif defined(LEPT_ATOMIC_REFCOUNT) && defined(_MSC_VER)
+  #include <intrin.h>
+  #define L_REFCOUNT_ADD(count, delta) \
+          ((l_uint32)_InterlockedExchangeAdd((volatile long *)&(count), \
+                                             (delta)) + (delta))
+  #define L_REFCOUNT_GET(count) \
+          ((l_uint32)_InterlockedOr((volatile long *)&(count), 0))
+#elif defined(LEPT_ATOMIC_REFCOUNT)
+  #error "LEPT_ATOMIC_REFCOUNT needs gcc, clang or msvc"
+#else
+  #define L_REFCOUNT_ADD(count, delta)  ((count) += (delta))
+  #define L_REFCOUNT_GET(count)         (count)
+#endif  /* LEPT_ATOMIC_REFCOUNT */
+
+
 /*------------------------------------------------------------------------*
  *         Control printing of error, warning, and info messages          *
  *                                                                        *
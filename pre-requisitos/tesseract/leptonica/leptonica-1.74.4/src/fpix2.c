@@ -100,8 +100,14 @@
  */
 
 #include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
 #include "allheaders.h"
 
+    /* Arrays with fewer pixels are done on a single thread */
+static const l_int32  MIN_PARALLEL_PIXELS = 1000000;
+
 /*--------------------------------------------------------------------*
  *                     FPix  <-->  Pix conversions                    *
  *--------------------------------------------------------------------*/
@@ -909,13 +915,15 @@ l_float64   maxval;
  *          This also has the advantage that if we subsample by %factor,
  *          throwing out all the interpolated pixels, we regain the
  *          original low resolution fpix.
+ *      (2) Each row of fpixs fills its own band of rows of fpixd, so the
+ *          bands are done on separate threads with OpenMP.
  * </pre>
  */
 FPIX *
 fpixScaleByInteger(FPIX    *fpixs,
                    l_int32  factor)
 {
-l_int32     i, j, k, m, ws, hs, wd, hd, wpls, wpld;
+l_int32     i, j, k, m, ws, hs, wd, hd, wpls, wpld, nthreads;
 l_float32   val0, val1, val2, val3;
 l_float32  *datas, *datad, *lines, *lined, *fract;
 FPIX       *fpixd;
@@ -936,6 +944,13 @@ FPIX       *fpixd;
     fract = (l_float32 *)LEPT_CALLOC(factor, sizeof(l_float32));
     for (i = 0; i < factor; i++)
         fract[i] = i / (l_float32)factor;
+    nthreads = 1;
+#ifdef _OPENMP
+    if ((l_float64)wd * hd >= MIN_PARALLEL_PIXELS)
+        nthreads = L_MAX(1, L_MIN(omp_get_max_threads(), hs - 1));
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            private(j, k, m, lines, lined, val0, val1, val2, val3)
+#endif  /* _OPENMP */
     for (i = 0; i < hs - 1; i++) {
         lines = datas + i * wpls;
         for (j = 0; j < ws - 1; j++) {
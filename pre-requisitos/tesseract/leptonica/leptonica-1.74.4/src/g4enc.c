@@ -0,0 +1,583 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*!
+ * \file g4enc.c
+ * <pre>
+ *
+ *      Ccitt g4 encoding of 1 bpp images in memory
+ *
+ *          Top level
+ *              l_int32         g4EncodePix()
+ *
+ *          Row coding
+ *              static void     g4EncodeBand()
+ *              static l_int32  g4FindChanges()
+ *              static void     g4EncodeRow()
+ *              static void     g4PutRun()
+ *
+ *          Bit output
+ *              static void     g4WriterInit()
+ *              static void     g4PutBits()
+ *              static void     g4AppendWriter()
+ *
+ *      This writes the bare T.6 (g4, K < 0) coded data of a pix, with
+ *      no tiff container, for a pdf image with /Filter /CCITTFaxDecode
+ *      and /K -1.  Unlike writing a tiff file with libtiff and pulling
+ *      the strip out of it, it needs neither libtiff nor a temporary
+ *      file, and it is much faster: the changing pixels of each row are
+ *      found a word at a time, and the codes are put out whole.
+ *
+ *      Every row is coded against the one above it, so a g4 stream has
+ *      no independent strips.  Still, the coding of a row depends only
+ *      on the pixels of the two rows, not on the coded data before it.
+ *      Large images are therefore cut into bands of rows that are coded
+ *      on separate threads, each band against the last row of the band
+ *      above, and the bit strings of the bands are joined in order.
+ *      The result is the same as coding the image on one thread.
+ *
+ *      As everywhere in leptonica, a 1 in the pix is black, which is
+ *      also the g4 convention with /BlackIs1 false.
+ * </pre>
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
+
+    /* Fewest rows in a band that is coded on its own thread */
+static const l_int32  G4_MIN_BAND_ROWS = 256;
+
+    /* A code of the g4 tables: the bits are the low len bits of code */
+struct G4Code
+{
+    l_uint16  code;
+    l_uint16  len;
+};
+typedef struct G4Code  L_G4_CODE;
+
+    /* White runs of 0 to 63 */
+static const L_G4_CODE  WhiteTermCodes[64] = {
+    {0x0035,  8}, {0x0007,  6}, {0x0007,  4}, {0x0008,  4},
+    {0x000b,  4}, {0x000c,  4}, {0x000e,  4}, {0x000f,  4},
+    {0x0013,  5}, {0x0014,  5}, {0x0007,  5}, {0x0008,  5},
+    {0x0008,  6}, {0x0003,  6}, {0x0034,  6}, {0x0035,  6},
+    {0x002a,  6}, {0x002b,  6}, {0x0027,  7}, {0x000c,  7},
+    {0x0008,  7}, {0x0017,  7}, {0x0003,  7}, {0x0004,  7},
+    {0x0028,  7}, {0x002b,  7}, {0x0013,  7}, {0x0024,  7},
+    {0x0018,  7}, {0x0002,  8}, {0x0003,  8}, {0x001a,  8},
+    {0x001b,  8}, {0x0012,  8}, {0x0013,  8}, {0x0014,  8},
+    {0x0015,  8}, {0x0016,  8}, {0x0017,  8}, {0x0028,  8},
+    {0x0029,  8}, {0x002a,  8}, {0x002b,  8}, {0x002c,  8},
+    {0x002d,  8}, {0x0004,  8}, {0x0005,  8}, {0x000a,  8},
+    {0x000b,  8}, {0x0052,  8}, {0x0053,  8}, {0x0054,  8},
+    {0x0055,  8}, {0x0024,  8}, {0x0025,  8}, {0x0058,  8},
+    {0x0059,  8}, {0x005a,  8}, {0x005b,  8}, {0x004a,  8},
+    {0x004b,  8}, {0x0032,  8}, {0x0033,  8}, {0x0034,  8}
+};
+
+    /* White runs of 64 to 1728, in steps of 64 */
+static const L_G4_CODE  WhiteMakeupCodes[27] = {
+    {0x001b,  5}, {0x0012,  5}, {0x0017,  6}, {0x0037,  7},
+    {0x0036,  8}, {0x0037,  8}, {0x0064,  8}, {0x0065,  8},
+    {0x0068,  8}, {0x0067,  8}, {0x00cc,  9}, {0x00cd,  9},
+    {0x00d2,  9}, {0x00d3,  9}, {0x00d4,  9}, {0x00d5,  9},
+    {0x00d6,  9}, {0x00d7,  9}, {0x00d8,  9}, {0x00d9,  9},
+    {0x00da,  9}, {0x00db,  9}, {0x0098,  9}, {0x0099,  9},
+    {0x009a,  9}, {0x0018,  6}, {0x009b,  9}
+};
+
+    /* Black runs of 0 to 63 */
+static const L_G4_CODE  BlackTermCodes[64] = {
+    {0x0037, 10}, {0x0002,  3}, {0x0003,  2}, {0x0002,  2},
+    {0x0003,  3}, {0x0003,  4}, {0x0002,  4}, {0x0003,  5},
+    {0x0005,  6}, {0x0004,  6}, {0x0004,  7}, {0x0005,  7},
+    {0x0007,  7}, {0x0004,  8}, {0x0007,  8}, {0x0018,  9},
+    {0x0017, 10}, {0x0018, 10}, {0x0008, 10}, {0x0067, 11},
+    {0x0068, 11}, {0x006c, 11}, {0x0037, 11}, {0x0028, 11},
+    {0x0017, 11}, {0x0018, 11}, {0x00ca, 12}, {0x00cb, 12},
+    {0x00cc, 12}, {0x00cd, 12}, {0x0068, 12}, {0x0069, 12},
+    {0x006a, 12}, {0x006b, 12}, {0x00d2, 12}, {0x00d3, 12},
+    {0x00d4, 12}, {0x00d5, 12}, {0x00d6, 12}, {0x00d7, 12},
+    {0x006c, 12}, {0x006d, 12}, {0x00da, 12}, {0x00db, 12},
+    {0x0054, 12}, {0x0055, 12}, {0x0056, 12}, {0x0057, 12},
+    {0x0064, 12}, {0x0065, 12}, {0x0052, 12}, {0x0053, 12},
+    {0x0024, 12}, {0x0037, 12}, {0x0038, 12}, {0x0027, 12},
+    {0x0028, 12}, {0x0058, 12}, {0x0059, 12}, {0x002b, 12},
+    {0x002c, 12}, {0x005a, 12}, {0x0066, 12}, {0x0067, 12}
+};
+
+    /* Black runs of 64 to 1728, in steps of 64 */
+static const L_G4_CODE  BlackMakeupCodes[27] = {
+    {0x000f, 10}, {0x00c8, 12}, {0x00c9, 12}, {0x005b, 12},
+    {0x0033, 12}, {0x0034, 12}, {0x0035, 12}, {0x006c, 13},
+    {0x006d, 13}, {0x004a, 13}, {0x004b, 13}, {0x004c, 13},
+    {0x004d, 13}, {0x0072, 13}, {0x0073, 13}, {0x0074, 13},
+    {0x0075, 13}, {0x0076, 13}, {0x0077, 13}, {0x0052, 13},
+    {0x0053, 13}, {0x0054, 13}, {0x0055, 13}, {0x005a, 13},
+    {0x005b, 13}, {0x0064, 13}, {0x0065, 13}
+};
+
+    /* Runs of either color of 1792 to 2560, in steps of 64 */
+static const L_G4_CODE  ExtMakeupCodes[13] = {
+    {0x0008, 11}, {0x000c, 11}, {0x000d, 11}, {0x0012, 12},
+    {0x0013, 12}, {0x0014, 12}, {0x0015, 12}, {0x0016, 12},
+    {0x0017, 12}, {0x001c, 12}, {0x001d, 12}, {0x001e, 12},
+    {0x001f, 12}
+};
+
+    /* Mode codes (T.4, 4.2.1.3.3), with the vertical modes by a1 - b1 */
+static const L_G4_CODE  PassCode = {0x1, 4};
+static const L_G4_CODE  HorizCode = {0x1, 3};
+static const L_G4_CODE  VertCodes[7] = {
+    {0x2, 7}, {0x2, 6}, {0x2, 3}, {0x1, 1}, {0x3, 3}, {0x3, 6}, {0x3, 7}
+};
+
+    /* Bit string of coded data */
+struct G4Writer
+{
+    l_uint8   *data;        /* whole bytes out                         */
+    size_t     n;           /* number of bytes in data                 */
+    size_t     nalloc;      /* size of data                            */
+    l_uint32   acc;         /* bits not yet in data, in the low nacc   */
+    l_int32    nacc;        /* number of bits in acc; less than 8      */
+};
+typedef struct G4Writer  L_G4_WRITER;
+
+static void g4EncodeBand(L_G4_WRITER *wr, PIX *pixs, l_int32 y0,
+                          l_int32 y1, l_int32 *ref, l_int32 *cur);
+static l_int32 g4FindChanges(const l_uint32 *line, l_int32 w, l_int32 wpl,
+                             l_int32 *changes);
+static void g4EncodeRow(L_G4_WRITER *wr, const l_int32 *ref,
+                        const l_int32 *cur, l_int32 w);
+static void g4PutRun(L_G4_WRITER *wr, l_int32 run, l_int32 color);
+static void g4WriterInit(L_G4_WRITER *wr, size_t nalloc);
+static void g4PutBits(L_G4_WRITER *wr, l_uint32 code, l_int32 len);
+static void g4AppendWriter(L_G4_WRITER *wr, L_G4_WRITER *wrs);
+
+
+/*---------------------------------------------------------------------*
+ *                              Top level                              *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   g4EncodePix()
+ *
+ * \param[in]    pixs 1 bpp
+ * \param[out]   pdata g4 data
+ * \param[out]   pnbytes size of the data
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is lossless.  A colormap of pixs is ignored: a 1 bit
+ *          is black.
+ *      (2) For pdf, the data is the stream of an image with
+ *          /Filter /CCITTFaxDecode, /DecodeParms << /K -1 /Columns w >>,
+ *          /ColorSpace /DeviceGray and /BitsPerComponent 1.  It ends
+ *          with the end of block code (two EOL), padded to a byte.
+ *      (3) Images of at least 2 * G4_MIN_BAND_ROWS rows are coded in
+ *          bands on as many threads as openmp allows.
+ * </pre>
+ */
+l_int32
+g4EncodePix(PIX       *pixs,
+            l_uint8  **pdata,
+            size_t    *pnbytes)
+{
+l_int32       w, h, i, nbands, nthreads, nfail;
+size_t        nalloc;
+L_G4_WRITER  *wrs;
+
+    PROCNAME("g4EncodePix");
+
+    if (!pdata)
+        return ERROR_INT("&data not defined", procName, 1);
+    *pdata = NULL;
+    if (!pnbytes)
+        return ERROR_INT("&nbytes not defined", procName, 1);
+    *pnbytes = 0;
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return ERROR_INT("pixs undefined or not 1 bpp", procName, 1);
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif  /* _OPENMP */
+    nbands = L_MAX(1, L_MIN(nthreads, h / G4_MIN_BAND_ROWS));
+    if ((wrs = (L_G4_WRITER *)LEPT_CALLOC(nbands, sizeof(L_G4_WRITER)))
+        == NULL)
+        return ERROR_INT("writers not made", procName, 1);
+
+        /* Band i has rows [h * i / nbands, h * (i + 1) / nbands) */
+    nalloc = (size_t)pixGetWpl(pixs) * h / nbands / 2 + 64;
+    nfail = 0;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nbands) if (nbands > 1) \
+            schedule(static) reduction(+:nfail)
+#endif  /* _OPENMP */
+    for (i = 0; i < nbands; i++) {
+        l_int32  *ref, *cur;
+
+            /* Changing pixels of a row, with 3 sentinels at w */
+        ref = (l_int32 *)LEPT_CALLOC(w + 4, sizeof(l_int32));
+        cur = (l_int32 *)LEPT_CALLOC(w + 4, sizeof(l_int32));
+        g4WriterInit(&wrs[i], nalloc);
+        if (ref && cur && wrs[i].data) {
+            g4EncodeBand(&wrs[i], pixs, (l_int64)h * i / nbands,
+                          (l_int64)h * (i + 1) / nbands, ref, cur);
+        }
+        if (!ref || !cur || !wrs[i].data)
+            nfail++;
+        LEPT_FREE(ref);
+        LEPT_FREE(cur);
+    }
+
+        /* Join the bands, and end the block with two EOL codes */
+    for (i = 1; i < nbands && nfail == 0; i++) {
+        g4AppendWriter(&wrs[0], &wrs[i]);
+        if (!wrs[0].data)
+            nfail++;
+    }
+    if (nfail == 0) {
+        g4PutBits(&wrs[0], 0x001, 12);
+        g4PutBits(&wrs[0], 0x001, 12);
+        if (wrs[0].nacc > 0)
+            g4PutBits(&wrs[0], 0, 8 - wrs[0].nacc);
+        if (!wrs[0].data)
+            nfail++;
+    }
+    for (i = 1; i < nbands; i++)
+        LEPT_FREE(wrs[i].data);
+    if (nfail > 0) {
+        LEPT_FREE(wrs[0].data);
+        LEPT_FREE(wrs);
+        return ERROR_INT("coded data not stored", procName, 1);
+    }
+
+    *pdata = wrs[0].data;
+    *pnbytes = wrs[0].n;
+    LEPT_FREE(wrs);
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                              Row coding                             *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   g4EncodeBand()
+ *
+ * \param[in]    wr
+ * \param[in]    pixs 1 bpp
+ * \param[in]    y0, y1 rows [y0, y1) to code
+ * \param[in]    ref, cur arrays of at least w + 3 for changing pixels
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) The reference row of y0 is row y0 - 1; above the first
+ *          row it is white.
+ * </pre>
+ */
+static void
+g4EncodeBand(L_G4_WRITER  *wr,
+              PIX          *pixs,
+              l_int32       y0,
+              l_int32       y1,
+              l_int32      *ref,
+              l_int32      *cur)
+{
+l_int32    w, wpl, y;
+l_int32   *tmp;
+l_uint32  *data;
+
+    w = pixGetWidth(pixs);
+    data = pixGetData(pixs);
+    wpl = pixGetWpl(pixs);
+    if (y0 == 0)
+        ref[0] = ref[1] = ref[2] = w;
+    else
+        g4FindChanges(data + (y0 - 1) * wpl, w, wpl, ref);
+    for (y = y0; y < y1; y++) {
+        g4FindChanges(data + y * wpl, w, wpl, cur);
+        g4EncodeRow(wr, ref, cur, w);
+        tmp = ref;
+        ref = cur;
+        cur = tmp;
+    }
+}
+
+
+/*!
+ * \brief   g4FindChanges()
+ *
+ * \param[in]    line of a 1 bpp pix
+ * \param[in]    w width
+ * \param[in]    wpl words of the line
+ * \param[in]    changes array of at least w + 3
+ * \return  number of changing pixels of the line
+ *
+ * <pre>
+ * Notes:
+ *      (1) A changing pixel has another color than the one to its
+ *          left; left of the line is white.  So the pixels at even
+ *          indices of changes turn black, and those at odd indices
+ *          turn white.  The x of the n changing pixels are followed by
+ *          3 times w.
+ *      (2) Runs of whole words of one color are skipped, and the
+ *          changes in a word are found by counting leading zeros.  The
+ *          pad bits after w are ignored.
+ * </pre>
+ */
+static l_int32
+g4FindChanges(const l_uint32  *line,
+              l_int32          w,
+              l_int32          wpl,
+              l_int32         *changes)
+{
+l_int32   j, bit, color, n, x;
+l_uint32  word, rest;
+
+    n = 0;
+    color = 0;
+    for (j = 0; j < wpl; j++) {
+        word = line[j];
+        if (j == wpl - 1 && (w & 31))
+            word &= ~(0xffffffff >> (w & 31));
+        if (word == (color ? 0xffffffff : 0))
+            continue;
+        bit = 0;
+        while (bit < 32) {
+            rest = (color ? ~word : word) << bit;
+            if (rest == 0)
+                break;
+#if defined(__GNUC__)
+            bit += __builtin_clz(rest);
+#else
+            while (!(rest & 0x80000000)) {
+                rest <<= 1;
+                bit++;
+            }
+#endif  /* __GNUC__ */
+            x = 32 * j + bit;
+            if (x >= w)  /* black run to the end; pad bits are 0 */
+                break;
+            changes[n++] = x;
+            color = !color;
+        }
+    }
+    changes[n] = changes[n + 1] = changes[n + 2] = w;
+    return n;
+}
+
+
+/*!
+ * \brief   g4EncodeRow()
+ *
+ * \param[in]    wr
+ * \param[in]    ref changing pixels of the reference row
+ * \param[in]    cur changing pixels of the row to code
+ * \param[in]    w width
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the two-dimensional coding of T.4, 4.2.1.3.  The
+ *          coding starts at a0 just left of the row, where the color
+ *          is white.  b1 is the first changing pixel of the reference
+ *          row right of a0 that turns to the other color than that at
+ *          a0, and b2 the next one; a1 and a2 are the next two changing
+ *          pixels of the row itself.  Then there is
+ *              pass mode, if b2 is left of a1: a0 moves to b2
+ *              vertical mode, if a1 is within 3 of b1: a0 moves to a1
+ *              horizontal mode otherwise: the runs a0a1 and a1a2 are
+ *                coded, and a0 moves to a2
+ *      (2) When a0 moves left of the last b1, b1 may be an earlier
+ *          change of ref, so its index first steps back.
+ * </pre>
+ */
+static void
+g4EncodeRow(L_G4_WRITER    *wr,
+            const l_int32  *ref,
+            const l_int32  *cur,
+            l_int32         w)
+{
+l_int32  a0, a1, a2, b1, b2, i, j, color, d;
+
+    a0 = -1;
+    color = 0;
+    i = 0;
+    j = 0;
+    while (a0 < w) {
+        while (j > 0 && ref[j - 1] > a0)
+            j--;
+        while (ref[j] <= a0)
+            j++;
+        if ((j & 1) != color)  /* ref[j] turns to the color at a0 */
+            j++;
+        b1 = ref[j];
+        b2 = ref[j + 1];
+        a1 = cur[i];
+        d = a1 - b1;
+        if (b2 < a1) {
+            g4PutBits(wr, PassCode.code, PassCode.len);
+            a0 = b2;
+        } else if (d >= -3 && d <= 3) {
+            g4PutBits(wr, VertCodes[d + 3].code, VertCodes[d + 3].len);
+            a0 = a1;
+            color = !color;
+            i++;
+        } else {
+            a2 = cur[i + 1];
+            g4PutBits(wr, HorizCode.code, HorizCode.len);
+            g4PutRun(wr, a1 - L_MAX(a0, 0), color);
+            g4PutRun(wr, a2 - a1, !color);
+            a0 = a2;
+            i += 2;
+        }
+    }
+}
+
+
+/*!
+ * \brief   g4PutRun()
+ *
+ * \param[in]    wr
+ * \param[in]    run length of the run, >= 0
+ * \param[in]    color 0 for white, 1 for black
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) A run is coded as makeup codes for its multiple of 64,
+ *          with as many of the longest one (2560) as it takes, and a
+ *          terminating code for the rest.
+ * </pre>
+ */
+static void
+g4PutRun(L_G4_WRITER  *wr,
+         l_int32       run,
+         l_int32       color)
+{
+const L_G4_CODE  *term, *makeup, *code;
+
+    term = (color) ? BlackTermCodes : WhiteTermCodes;
+    makeup = (color) ? BlackMakeupCodes : WhiteMakeupCodes;
+    while (run >= 2560 + 64) {
+        g4PutBits(wr, ExtMakeupCodes[12].code, ExtMakeupCodes[12].len);
+        run -= 2560;
+    }
+    if (run >= 64) {
+        if (run >= 1792)
+            code = &ExtMakeupCodes[run / 64 - 28];
+        else
+            code = &makeup[run / 64 - 1];
+        g4PutBits(wr, code->code, code->len);
+        run &= 63;
+    }
+    g4PutBits(wr, term[run].code, term[run].len);
+}
+
+
+/*---------------------------------------------------------------------*
+ *                              Bit output                             *
+ *---------------------------------------------------------------------*/
+static void
+g4WriterInit(L_G4_WRITER  *wr,
+             size_t        nalloc)
+{
+    wr->n = 0;
+    wr->nalloc = nalloc;
+    wr->acc = 0;
+    wr->nacc = 0;
+    wr->data = (l_uint8 *)LEPT_MALLOC(nalloc);
+}
+
+
+/*!
+ * \brief   g4PutBits()
+ *
+ * \param[in]    wr
+ * \param[in]    code bits in the low len bits
+ * \param[in]    len number of bits; at most 24
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) If the data can not grow, it is freed and set to null; the
+ *          bits that follow are dropped, and the caller finds no data.
+ * </pre>
+ */
+static void
+g4PutBits(L_G4_WRITER  *wr,
+          l_uint32      code,
+          l_int32       len)
+{
+    wr->acc = (wr->acc << len) | code;
+    wr->nacc += len;
+    while (wr->nacc >= 8) {
+        wr->nacc -= 8;
+        if (wr->data) {
+            if (wr->n == wr->nalloc) {
+                wr->data = (l_uint8 *)reallocNew((void **)&wr->data,
+                                                 wr->nalloc, 2 * wr->nalloc);
+                wr->nalloc *= 2;
+            }
+            if (wr->data)
+                wr->data[wr->n++] = (l_uint8)(wr->acc >> wr->nacc);
+        }
+    }
+    wr->acc &= (1 << wr->nacc) - 1;
+}
+
+
+    /* Appends the bits of wrs to those of wr */
+static void
+g4AppendWriter(L_G4_WRITER  *wr,
+               L_G4_WRITER  *wrs)
+{
+size_t  i;
+
+    if (wr->nacc == 0 && wr->data) {  /* byte aligned */
+        if (wr->nalloc < wr->n + wrs->n) {
+            wr->data = (l_uint8 *)reallocNew((void **)&wr->data, wr->nalloc,
+                                             wr->n + wrs->n + 64);
+            wr->nalloc = wr->n + wrs->n + 64;
+        }
+        if (wr->data) {
+            memcpy(wr->data + wr->n, wrs->data, wrs->n);
+            wr->n += wrs->n;
+        }
+    } else {
+        for (i = 0; i < wrs->n; i++)
+            g4PutBits(wr, wrs->data[i], 8);
+    }
+    g4PutBits(wr, wrs->acc, wrs->nacc);
+}
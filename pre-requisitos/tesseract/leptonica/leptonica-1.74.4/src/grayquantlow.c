@@ -337,8 +337,10 @@ l_uint32 sword, dword;
 #endif
         break;
     case 8:
-            /* Unrolled as 8 source words, 1 dest word */
-        for (j = 0, scount = 0, dcount = 0; j + 31 < w; j += 32) {
+            /* Vectorized where possible, then unrolled as 8 source
+             * words, 1 dest word */
+        j = thresholdToBinaryLineSimd(lined, w, lines, thresh);
+        for (scount = j / 4, dcount = j / 32; j + 31 < w; j += 32) {
             dword = 0;
             for (k = 0; k < 8; k++) {
                 sword = lines[scount++];
@@ -144,7 +144,8 @@ enum {
     L_JPEG_ENCODE     = 1,  /*!< use dct encoding: 8 and 32 bpp, no cmap    */
     L_G4_ENCODE       = 2,  /*!< use ccitt g4 fax encoding: 1 bpp           */
     L_FLATE_ENCODE    = 3,  /*!< use flate encoding: any depth, cmap ok     */
-    L_JP2K_ENCODE     = 4   /*!< use jp2k encoding: 8 and 32 bpp, no cmap   */
+    L_JP2K_ENCODE     = 4,  /*!< use jp2k encoding: 8 and 32 bpp, no cmap   */
+    L_JBIG2_ENCODE    = 5   /*!< use jbig2 generic encoding: 1 bpp          */
 };
 
 
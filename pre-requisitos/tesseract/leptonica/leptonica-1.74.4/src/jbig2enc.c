@@ -0,0 +1,600 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*!
+ * \file jbig2enc.c
+ * <pre>
+ *
+ *      Lossless jbig2 encoding of 1 bpp images as a generic region
+ *
+ *          Top level
+ *              l_int32         jbig2EncodeGeneric()
+ *
+ *          Generic region coding
+ *              static void     jbig2EncodeRegion()
+ *              static l_int32  jbig2RowIsCopy()
+ *
+ *          MQ arithmetic coder
+ *              static void     mqEncoderInit()
+ *              static void     mqEncode()
+ *              static void     mqByteOut()
+ *              static void     mqPutByte()
+ *              static void     mqEncoderFlush()
+ *
+ *          Segment headers
+ *              static l_uint8 *jbig2PutSegmentHeader()
+ *              static l_uint8 *jbig2PutU32()
+ *
+ *      The image is coded as a single immediate generic region (ITU-T
+ *      T.88, 6.2) with the MQ coder, the 16 pixel template 0 in its
+ *      nominal configuration, and typical prediction of the rows that
+ *      repeat the one above (TPGDON), which makes blank margins and
+ *      gaps between text lines nearly free.  There is no symbol
+ *      dictionary, so the coding is lossless and needs no globals.
+ *
+ *      The output is a page information segment followed by the region
+ *      segment: the embedded organization that pdf readers take in a
+ *      /JBIG2Decode stream.  With full headers it gets the file header
+ *      and the end of page and end of file segments as well, and is a
+ *      standalone .jb2 file for jbig2 decoders.
+ *
+ *      As everywhere in leptonica, a 1 in the pix is black, which is
+ *      also the jbig2 convention.
+ * </pre>
+ */
+
+#include <string.h>
+#include "allheaders.h"
+
+    /* Segment types (T.88, 7.3) */
+#define  JBIG2_SEG_GENERIC_REGION   38   /* immediate generic region */
+#define  JBIG2_SEG_PAGE_INFO        48
+#define  JBIG2_SEG_END_OF_PAGE      49
+#define  JBIG2_SEG_END_OF_FILE      51
+
+    /* Bytes in a segment header with one page association byte and no
+     * referred-to segments */
+#define  JBIG2_SEG_HEADER_SIZE      11
+
+    /* Context of the typical prediction bit for template 0 */
+#define  JBIG2_SLTP_CONTEXT         0x9b25
+
+    /* Number of contexts of template 0 */
+#define  JBIG2_NUM_CONTEXTS         65536
+
+    /* Probability estimation state machine of the MQ coder (T.88, E.1.2) */
+struct MqState
+{
+    l_uint32  qe;
+    l_uint8   nmps;
+    l_uint8   nlps;
+    l_uint8   switchflag;
+};
+
+static const struct MqState  MqTable[47] = {
+    {0x5601,  1,  1, 1}, {0x3401,  2,  6, 0}, {0x1801,  3,  9, 0},
+    {0x0ac1,  4, 12, 0}, {0x0521,  5, 29, 0}, {0x0221, 38, 33, 0},
+    {0x5601,  7,  6, 1}, {0x5401,  8, 14, 0}, {0x4801,  9, 14, 0},
+    {0x3801, 10, 14, 0}, {0x3001, 11, 17, 0}, {0x2401, 12, 18, 0},
+    {0x1c01, 13, 20, 0}, {0x1601, 29, 21, 0}, {0x5601, 15, 14, 1},
+    {0x5401, 16, 14, 0}, {0x5101, 17, 15, 0}, {0x4801, 18, 16, 0},
+    {0x3801, 19, 17, 0}, {0x3401, 20, 18, 0}, {0x3001, 21, 19, 0},
+    {0x2801, 22, 19, 0}, {0x2401, 23, 20, 0}, {0x2201, 24, 21, 0},
+    {0x1c01, 25, 22, 0}, {0x1801, 26, 23, 0}, {0x1601, 27, 24, 0},
+    {0x1401, 28, 25, 0}, {0x1201, 29, 26, 0}, {0x1101, 30, 27, 0},
+    {0x0ac1, 31, 28, 0}, {0x09c1, 32, 29, 0}, {0x08a1, 33, 30, 0},
+    {0x0521, 34, 31, 0}, {0x0441, 35, 32, 0}, {0x02a1, 36, 33, 0},
+    {0x0221, 37, 34, 0}, {0x0141, 38, 35, 0}, {0x0111, 39, 36, 0},
+    {0x0085, 40, 37, 0}, {0x0049, 41, 38, 0}, {0x0025, 42, 39, 0},
+    {0x0015, 43, 40, 0}, {0x0009, 44, 41, 0}, {0x0005, 45, 42, 0},
+    {0x0001, 45, 43, 0}, {0x5601, 46, 46, 0}
+};
+
+    /* Coder registers and output */
+struct MqEncoder
+{
+    l_uint32   a;           /* interval size                           */
+    l_uint32   c;           /* code register                           */
+    l_int32    ct;          /* bits to shift before the next byte out  */
+    l_int32    b;           /* last byte out, still open to a carry    */
+    l_int32    started;     /* b is a byte of the output, not the      */
+                            /* placeholder before the first one        */
+    l_uint8   *data;        /* bytes out, not counting b               */
+    size_t     n;           /* number of bytes in data                 */
+    size_t     nalloc;      /* size of data                            */
+    l_uint8   *cx;          /* state index << 1 | mps, by context      */
+};
+typedef struct MqEncoder  L_MQ_ENCODER;
+
+static void jbig2EncodeRegion(L_MQ_ENCODER *enc, PIX *pixs);
+static l_int32 jbig2RowIsCopy(const l_uint32 *line, const l_uint32 *lineup,
+                              l_int32 w);
+static void mqEncoderInit(L_MQ_ENCODER *enc, size_t nalloc);
+static void mqEncode(L_MQ_ENCODER *enc, l_uint32 cx, l_int32 bit);
+static void mqByteOut(L_MQ_ENCODER *enc);
+static void mqPutByte(L_MQ_ENCODER *enc, l_int32 byte);
+static void mqEncoderFlush(L_MQ_ENCODER *enc);
+static l_uint8 *jbig2PutSegmentHeader(l_uint8 *p, l_uint32 segnum,
+                                      l_int32 type, l_int32 page,
+                                      l_uint32 length);
+static l_uint8 *jbig2PutU32(l_uint8 *p, l_uint32 val);
+
+
+/*---------------------------------------------------------------------*
+ *                              Top level                              *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   jbig2EncodeGeneric()
+ *
+ * \param[in]    pixs 1 bpp
+ * \param[in]    fullheaders 1 for a standalone jbig2 file; 0 for the
+ *                           segments embedded in a pdf stream
+ * \param[out]   pdata jbig2 data
+ * \param[out]   pnbytes size of the data
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is lossless.  A colormap of pixs is ignored: a 1 bit
+ *          is black.
+ *      (2) The resolution of pixs, if any, goes to the page information
+ *          segment.
+ *      (3) For pdf, the data is the stream of an image with
+ *          /Filter /JBIG2Decode, /ColorSpace /DeviceGray and
+ *          /BitsPerComponent 1, and no /JBIG2Globals.
+ * </pre>
+ */
+l_int32
+jbig2EncodeGeneric(PIX       *pixs,
+                   l_int32    fullheaders,
+                   l_uint8  **pdata,
+                   size_t    *pnbytes)
+{
+static const l_uint8  fileid[] = {0x97, 0x4a, 0x42, 0x32, 0x0d, 0x0a,
+                                  0x1a, 0x0a};
+    /* Adaptive pixels of template 0 at their nominal places */
+static const l_uint8  atpixels[] = {0x03, 0xff, 0xfd, 0xff, 0x02, 0xfe,
+                                    0xfe, 0xfe};
+l_int32       w, h, xres, yres;
+size_t        nbytes;
+l_uint8      *data, *p;
+L_MQ_ENCODER  enc;
+
+    PROCNAME("jbig2EncodeGeneric");
+
+    if (!pdata)
+        return ERROR_INT("&data not defined", procName, 1);
+    *pdata = NULL;
+    if (!pnbytes)
+        return ERROR_INT("&nbytes not defined", procName, 1);
+    *pnbytes = 0;
+    if (!pixs || pixGetDepth(pixs) != 1)
+        return ERROR_INT("pixs undefined or not 1 bpp", procName, 1);
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    mqEncoderInit(&enc, (size_t)pixGetWpl(pixs) * h / 4 + 64);
+    if (!enc.data || !enc.cx) {
+        LEPT_FREE(enc.data);
+        LEPT_FREE(enc.cx);
+        return ERROR_INT("encoder not made", procName, 1);
+    }
+    jbig2EncodeRegion(&enc, pixs);
+    mqEncoderFlush(&enc);
+    LEPT_FREE(enc.cx);
+    if (!enc.data)
+        return ERROR_INT("coded data not stored", procName, 1);
+
+    nbytes = 2 * JBIG2_SEG_HEADER_SIZE + 19 + 26 + enc.n;
+    if (fullheaders)
+        nbytes += 13 + 2 * JBIG2_SEG_HEADER_SIZE;
+    if ((data = (l_uint8 *)LEPT_CALLOC(nbytes, 1)) == NULL) {
+        LEPT_FREE(enc.data);
+        return ERROR_INT("data not made", procName, 1);
+    }
+
+    p = data;
+    if (fullheaders) {  /* sequential organization, one page */
+        memcpy(p, fileid, sizeof(fileid));
+        p += sizeof(fileid);
+        *p++ = 0x01;
+        p = jbig2PutU32(p, 1);
+    }
+
+        /* Page information; the resolution is in pixels per meter */
+    pixGetResolution(pixs, &xres, &yres);
+    p = jbig2PutSegmentHeader(p, 0, JBIG2_SEG_PAGE_INFO, 1, 19);
+    p = jbig2PutU32(p, w);
+    p = jbig2PutU32(p, h);
+    p = jbig2PutU32(p, (xres > 0) ? (l_uint32)(xres / 0.0254 + 0.5) : 0);
+    p = jbig2PutU32(p, (yres > 0) ? (l_uint32)(yres / 0.0254 + 0.5) : 0);
+    *p++ = 0x01;  /* eventually lossless, white background, combined by OR */
+    *p++ = 0;  /* no striping */
+    *p++ = 0;
+
+        /* The region covers the page */
+    p = jbig2PutSegmentHeader(p, 1, JBIG2_SEG_GENERIC_REGION, 1,
+                              26 + enc.n);
+    p = jbig2PutU32(p, w);
+    p = jbig2PutU32(p, h);
+    p = jbig2PutU32(p, 0);
+    p = jbig2PutU32(p, 0);
+    *p++ = 0;  /* combined by OR */
+    *p++ = 0x08;  /* arithmetic coding, template 0, TPGDON */
+    memcpy(p, atpixels, sizeof(atpixels));
+    p += sizeof(atpixels);
+    memcpy(p, enc.data, enc.n);
+    p += enc.n;
+    LEPT_FREE(enc.data);
+
+    if (fullheaders) {
+        p = jbig2PutSegmentHeader(p, 2, JBIG2_SEG_END_OF_PAGE, 1, 0);
+        p = jbig2PutSegmentHeader(p, 3, JBIG2_SEG_END_OF_FILE, 0, 0);
+    }
+
+    *pdata = data;
+    *pnbytes = nbytes;
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                        Generic region coding                        *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   jbig2EncodeRegion()
+ *
+ * \param[in]    enc
+ * \param[in]    pixs 1 bpp
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) The context of a pixel at (x, y) has, from its high bit
+ *          down, the pixels at
+ *              (x-2, y-2) ... (x+2, y-2)
+ *              (x-3, y-1) ... (x+3, y-1)
+ *              (x-4, y) ... (x-1, y)
+ *          with pixels outside the image as 0.  Each row keeps the
+ *          three groups in shift registers that take one new pixel
+ *          per step.
+ *      (2) With TPGDON, each row starts with one bit that says whether
+ *          its "is a copy of the row above" flag differs from that of
+ *          the previous row; rows that are copies are not coded.  Above
+ *          the first row is a white row.
+ * </pre>
+ */
+static void
+jbig2EncodeRegion(L_MQ_ENCODER  *enc,
+                  PIX           *pixs)
+{
+l_int32    w, h, wpl, x, y, ltp, copy, bit;
+l_uint32   w0, w1, w2;
+l_uint32  *data, *line, *line1, *line2;
+
+    pixGetDimensions(pixs, &w, &h, NULL);
+    data = pixGetData(pixs);
+    wpl = pixGetWpl(pixs);
+    ltp = 0;
+    for (y = 0; y < h; y++) {
+        line = data + y * wpl;
+        line1 = (y >= 1) ? line - wpl : NULL;
+        line2 = (y >= 2) ? line - 2 * wpl : NULL;
+
+        copy = jbig2RowIsCopy(line, line1, w);
+        mqEncode(enc, JBIG2_SLTP_CONTEXT, copy != ltp);
+        ltp = copy;
+        if (copy)
+            continue;
+
+        w0 = 0;
+        w1 = 0;
+        w2 = 0;
+        if (line1) {
+            w1 = GET_DATA_BIT(line1, 0) << 2;
+            if (w > 1) w1 |= GET_DATA_BIT(line1, 1) << 1;
+            if (w > 2) w1 |= GET_DATA_BIT(line1, 2);
+        }
+        if (line2) {
+            w2 = GET_DATA_BIT(line2, 0) << 1;
+            if (w > 1) w2 |= GET_DATA_BIT(line2, 1);
+        }
+        for (x = 0; x < w; x++) {
+            w1 <<= 1;
+            if (line1 && x + 3 < w)
+                w1 |= GET_DATA_BIT(line1, x + 3);
+            w1 &= 0x7f;
+            w2 <<= 1;
+            if (line2 && x + 2 < w)
+                w2 |= GET_DATA_BIT(line2, x + 2);
+            w2 &= 0x1f;
+            bit = GET_DATA_BIT(line, x);
+            mqEncode(enc, (w2 << 11) | (w1 << 4) | w0, bit);
+            w0 = ((w0 << 1) | bit) & 0xf;
+        }
+    }
+}
+
+
+/*!
+ * \brief   jbig2RowIsCopy()
+ *
+ * \param[in]    line
+ * \param[in]    lineup the row above; NULL for a white row
+ * \param[in]    w width in pixels
+ * \return  1 if the w pixels of line are those of lineup, 0 otherwise
+ */
+static l_int32
+jbig2RowIsCopy(const l_uint32  *line,
+               const l_uint32  *lineup,
+               l_int32          w)
+{
+l_int32   i, nfull, extra;
+l_uint32  mask;
+
+    nfull = w >> 5;
+    extra = w & 31;
+    mask = (extra) ? 0xffffffff << (32 - extra) : 0;
+    for (i = 0; i < nfull; i++) {
+        if (line[i] != ((lineup) ? lineup[i] : 0))
+            return 0;
+    }
+    if (extra && ((line[nfull] ^ ((lineup) ? lineup[nfull] : 0)) & mask))
+        return 0;
+    return 1;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                          MQ arithmetic coder                        *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   mqEncoderInit()
+ *
+ * \param[in]    enc
+ * \param[in]    nalloc initial size of the output buffer
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is INITENC of T.88, E.2.8, with all contexts in state 0
+ *          and 0 as their more probable symbol.  On failure to allocate,
+ *          enc->data or enc->cx is NULL.
+ * </pre>
+ */
+static void
+mqEncoderInit(L_MQ_ENCODER  *enc,
+              size_t         nalloc)
+{
+    enc->a = 0x8000;
+    enc->c = 0;
+    enc->ct = 12;
+    enc->b = 0;
+    enc->started = 0;
+    enc->n = 0;
+    enc->nalloc = nalloc;
+    enc->data = (l_uint8 *)LEPT_MALLOC(nalloc);
+    enc->cx = (l_uint8 *)LEPT_CALLOC(JBIG2_NUM_CONTEXTS, 1);
+}
+
+
+/*!
+ * \brief   mqEncode()
+ *
+ * \param[in]    enc
+ * \param[in]    cx context
+ * \param[in]    bit 0 or 1
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is CODEMPS and CODELPS of T.88, E.2.4 - E.2.5, with
+ *          the conditional exchange, followed by RENORME.
+ * </pre>
+ */
+static void
+mqEncode(L_MQ_ENCODER  *enc,
+         l_uint32       cx,
+         l_int32        bit)
+{
+l_int32   state, index, mps;
+l_uint32  qe;
+
+    state = enc->cx[cx];
+    index = state >> 1;
+    mps = state & 1;
+    qe = MqTable[index].qe;
+    enc->a -= qe;
+    if (bit == mps) {
+        if (enc->a & 0x8000) {
+            enc->c += qe;
+            return;
+        }
+        if (enc->a < qe)
+            enc->a = qe;
+        else
+            enc->c += qe;
+        enc->cx[cx] = (MqTable[index].nmps << 1) | mps;
+    } else {
+        if (enc->a < qe)
+            enc->c += qe;
+        else
+            enc->a = qe;
+        if (MqTable[index].switchflag)
+            mps = 1 - mps;
+        enc->cx[cx] = (MqTable[index].nlps << 1) | mps;
+    }
+
+    do {
+        enc->a <<= 1;
+        enc->c <<= 1;
+        if (--enc->ct == 0)
+            mqByteOut(enc);
+    } while ((enc->a & 0x8000) == 0);
+}
+
+
+/*!
+ * \brief   mqByteOut()
+ *
+ * \param[in]    enc
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is BYTEOUT of T.88, E.2.7.  A carry goes into the last
+ *          byte out; after a 0xff byte only 7 bits are taken, so that
+ *          a carry never has to go further back.
+ * </pre>
+ */
+static void
+mqByteOut(L_MQ_ENCODER  *enc)
+{
+    if (enc->b != 0xff && enc->c >= 0x8000000) {
+        enc->b++;
+        enc->c &= 0x7ffffff;
+    }
+    if (enc->b == 0xff) {
+        mqPutByte(enc, enc->c >> 20);
+        enc->c &= 0xfffff;
+        enc->ct = 7;
+    } else {
+        mqPutByte(enc, enc->c >> 19);
+        enc->c &= 0x7ffff;
+        enc->ct = 8;
+    }
+}
+
+
+/*!
+ * \brief   mqPutByte()
+ *
+ * \param[in]    enc
+ * \param[in]    byte the next byte out
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) The byte is held in enc->b, and the one it replaces goes to
+ *          the output.  The buffer doubles when full; should that fail,
+ *          the rest of the bytes are dropped and the flush reports it.
+ * </pre>
+ */
+static void
+mqPutByte(L_MQ_ENCODER  *enc,
+          l_int32        byte)
+{
+    if (enc->started && enc->data) {
+        if (enc->n == enc->nalloc) {
+            enc->data = (l_uint8 *)reallocNew((void **)&enc->data,
+                                              enc->nalloc, 2 * enc->nalloc);
+            enc->nalloc *= 2;
+        }
+        if (enc->data)
+            enc->data[enc->n++] = enc->b;
+    }
+    enc->b = byte;
+    enc->started = 1;
+}
+
+
+/*!
+ * \brief   mqEncoderFlush()
+ *
+ * \param[in]    enc
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is FLUSH of T.88, E.2.9, which sets as many low bits of
+ *          the code register as it can to 1, followed by the 0xffac
+ *          marker that ends the coded data.
+ * </pre>
+ */
+static void
+mqEncoderFlush(L_MQ_ENCODER  *enc)
+{
+l_uint32  tempc;
+
+    tempc = enc->c + enc->a;
+    enc->c |= 0xffff;
+    if (enc->c >= tempc)
+        enc->c -= 0x8000;
+    enc->c <<= enc->ct;
+    mqByteOut(enc);
+    enc->c <<= enc->ct;
+    mqByteOut(enc);
+    if (enc->b != 0xff)
+        mqPutByte(enc, 0xff);
+    mqPutByte(enc, 0xac);
+    mqPutByte(enc, 0);  /* pushes out the 0xac */
+}
+
+
+/*---------------------------------------------------------------------*
+ *                           Segment headers                           *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   jbig2PutSegmentHeader()
+ *
+ * \param[in]    p where to write the JBIG2_SEG_HEADER_SIZE bytes
+ * \param[in]    segnum segment number
+ * \param[in]    type segment type
+ * \param[in]    page page association; 0 for none
+ * \param[in]    length size of the segment data
+ * \return  p after the header
+ */
+static l_uint8 *
+jbig2PutSegmentHeader(l_uint8   *p,
+                      l_uint32   segnum,
+                      l_int32    type,
+                      l_int32    page,
+                      l_uint32   length)
+{
+    p = jbig2PutU32(p, segnum);
+    *p++ = type;  /* one byte page association */
+    *p++ = 0;  /* no referred-to segments */
+    *p++ = page;
+    return jbig2PutU32(p, length);
+}
+
+
+/*!
+ * \brief   jbig2PutU32()
+ *
+ * \param[in]    p
+ * \param[in]    val
+ * \return  p after val, written big-endian
+ */
+static l_uint8 *
+jbig2PutU32(l_uint8   *p,
+            l_uint32   val)
+{
+    p[0] = (val >> 24) & 0xff;
+    p[1] = (val >> 16) & 0xff;
+    p[2] = (val >> 8) & 0xff;
+    p[3] = val & 0xff;
+    return p + 4;
+}
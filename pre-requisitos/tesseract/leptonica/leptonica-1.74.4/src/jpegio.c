@@ -47,8 +47,14 @@
  *          l_int32          readHeaderMemJpeg()
  *          l_int32          pixWriteMemJpeg()
  *
- *    Setting special flag for chroma sampling on write
+ *    Setting special flags for chroma sampling and dct on write
  *          l_int32          pixSetChromaSampling()
+ *          l_int32          pixSetJpegFastEncode()
+ *
+ *    Static helpers for writing
+ *          static l_int32   jpegWriteRows()
+ *          static l_int32   jpegJoinBands()
+ *          static l_int32   jpegFindScan()
  *
  *    Static system helpers
  *          static void      jpeg_error_catch_all_1()
@@ -95,6 +101,15 @@
  *    both channels.  Before writing, call pixSetChromaSampling(pix, 0)
  *    to prevent chroma subsampling.
  *
+ *    How to encode faster
+ *    --------------------
+ *    Huffman table optimization is never done on write.  For images
+ *    that are only intermediate, or low quality image layers, call
+ *    pixSetJpegFastEncode(pix, 1) before writing to use the fast
+ *    integer dct.  Large images written without progressive encoding
+ *    are compressed in bands on as many threads as openmp allows;
+ *    see pixWriteStreamJpeg().
+ *
  *    How to extract just the luminance channel in reading RGB
  *    --------------------------------------------------------
  *    For higher resolution and faster decoding of an RGB image, you
@@ -133,6 +148,10 @@
 #include <string.h>
 #include "allheaders.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
+
 /* --------------------------------------------*/
 #if  HAVE_LIBJPEG   /* defined in environ.h */
 /* --------------------------------------------*/
@@ -147,6 +166,25 @@
 #undef HAVE_STDLIB_H
 #include "jpeglib.h"
 
+    /* Bands are compressed to memory, which older libjpeg lacks */
+#if  JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
+#define  JPEG_BANDS_SUPPORTED   1
+#else
+#define  JPEG_BANDS_SUPPORTED   0
+#endif
+
+    /* Fewest rows in a band that is compressed on its own thread */
+static const l_int32  JPEG_MIN_BAND_ROWS = 256;
+
+static l_int32 jpegWriteRows(FILE *fp, l_uint8 **pdata, unsigned long *psize,
+                             PIX *pix, l_int32 y0, l_int32 y1,
+                             l_int32 quality, l_int32 progressive,
+                             l_int32 special, l_int32 restart);
+static l_int32 jpegJoinBands(FILE *fp, l_uint8 **bandata,
+                             unsigned long *bandsize, l_int32 nbands,
+                             l_int32 h, l_int32 nrestart);
+static unsigned long jpegFindScan(l_uint8 *data, unsigned long size,
+                                  l_int32 h);
 static void jpeg_error_catch_all_1(j_common_ptr cinfo);
 static void jpeg_error_catch_all_2(j_common_ptr cinfo);
 static l_uint8 jpeg_getc(j_decompress_ptr cinfo);
@@ -191,7 +229,10 @@ struct callback_data {
  *      (2) Use this if you want the jpeg library to create
  *          an 8 bpp colormapped image.
  *      (3) Images reduced by factors of 2, 4 or 8 can be returned
- *          significantly faster than full resolution images.
+ *          significantly faster than full resolution images.  Their
+ *          resolution is that of the file divided by the reduction.
+ *          To select the reduction from a target resolution or size,
+ *          see pixReadReduced().
  *      (4) If the jpeg data is bad, the jpeg library will continue
  *          silently, or return warnings, or attempt to exit.  Depending
  *          on the severity of the data corruption, there are two possible
@@ -458,13 +499,16 @@ jmp_buf                        jmpbuf;  /* must be local to the function */
     if (pnwarn) *pnwarn = nwarn;
 
         /* If the pixel density is neither 1 nor 2, it may not be defined.
-         * In that case, don't set the resolution.  */
+         * In that case, don't set the resolution.  A reduced image has
+         * the resolution of the file divided by the reduction.  */
     if (cinfo.density_unit == 1) {  /* pixels per inch */
-        pixSetXRes(pix, cinfo.X_density);
-        pixSetYRes(pix, cinfo.Y_density);
+        pixSetXRes(pix, cinfo.X_density / reduction);
+        pixSetYRes(pix, cinfo.Y_density / reduction);
     } else if (cinfo.density_unit == 2) {  /* pixels per centimeter */
-        pixSetXRes(pix, (l_int32)((l_float32)cinfo.X_density * 2.54 + 0.5));
-        pixSetYRes(pix, (l_int32)((l_float32)cinfo.Y_density * 2.54 + 0.5));
+        pixSetXRes(pix, (l_int32)((l_float32)cinfo.X_density * 2.54 /
+                                  reduction + 0.5));
+        pixSetYRes(pix, (l_int32)((l_float32)cinfo.Y_density * 2.54 /
+                                  reduction + 0.5));
     }
 
     if (cinfo.output_components != spp)
@@ -782,6 +826,13 @@ FILE  *fp;
  *          also 8 bits, and compresses that.  It uses 2 Huffman tables,
  *          a higher resolution one (with more quantization levels)
  *          for luminosity and a lower resolution one for the chromas.
+ *      (6) Without progressive encoding, images of at least
+ *          2 * JPEG_MIN_BAND_ROWS rows are compressed in bands of whole
+ *          MCU rows on as many threads as openmp allows.  Each band
+ *          ends a restart interval, so the bands are simply joined,
+ *          with the restart markers renumbered.  The image decodes
+ *          exactly as when compressed on one thread; the file is
+ *          a few bytes larger per band.
  * </pre>
  */
 l_int32
@@ -790,16 +841,11 @@ pixWriteStreamJpeg(FILE    *fp,
                    l_int32  quality,
                    l_int32  progressive)
 {
-l_int32                      xres, yres;
-l_int32                      i, j, k;
-l_int32                      w, h, d, wpl, spp, colorflag, rowsamples;
-l_uint32                    *ppixel, *line, *data;
-JSAMPROW                     rowbuffer;
-PIX                         *pix;
-struct jpeg_compress_struct  cinfo;
-struct jpeg_error_mgr        jerr;
-char                        *text;
-jmp_buf                      jmpbuf;  /* must be local to the function */
+l_int32         w, h, d, i, special, nthreads, nbands, nfail, ret;
+l_int32         mcuw, mcuh, nmcurows, bandrows, restartrows;
+l_uint8       **bandata;
+unsigned long  *bandsize;
+PIX            *pix;
 
     PROCNAME("pixWriteStreamJpeg");
 
@@ -831,8 +877,124 @@ jmp_buf                      jmpbuf;  /* must be local to the function */
     if (!pix)
         return ERROR_INT("pix not made", procName, 1);
     pixSetPadBits(pix, 0);
-
     rewind(fp);
+
+        /* Only values up to L_JPEG_SPECIAL_MASK of pixs->special are
+         * flags for jpeg; larger ones are for other formats. */
+    special = pixs->special;
+    if (special < 0 || special > L_JPEG_SPECIAL_MASK)
+        special = 0;
+
+    nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif  /* _OPENMP */
+    nbands = 1;
+    if (JPEG_BANDS_SUPPORTED && !progressive)
+        nbands = L_MAX(1, L_MIN(nthreads, h / JPEG_MIN_BAND_ROWS));
+    if (nbands == 1) {
+        ret = jpegWriteRows(fp, NULL, NULL, pix, 0, h, quality, progressive,
+                            special, 0);
+        pixDestroy(&pix);
+        return ret;
+    }
+
+        /* Bands are whole MCU rows, and each is a whole number of
+         * restart intervals.  The chroma is subsampled 2x2 unless
+         * the image is gray or that is turned off. */
+    d = pixGetDepth(pix);
+    mcuw = mcuh = (d == 8 || (special & L_NO_CHROMA_SAMPLING_JPEG)) ? 8 : 16;
+    nmcurows = (h + mcuh - 1) / mcuh;
+    bandrows = (nmcurows + nbands - 1) / nbands;
+    nbands = (nmcurows + bandrows - 1) / bandrows;
+    restartrows = bandrows;
+    if ((l_int64)restartrows * ((w + mcuw - 1) / mcuw) > 65535)
+        restartrows = 1;  /* the interval is at most 65535 MCUs */
+    bandata = (l_uint8 **)LEPT_CALLOC(nbands, sizeof(l_uint8 *));
+    bandsize = (unsigned long *)LEPT_CALLOC(nbands, sizeof(unsigned long));
+    if (!bandata || !bandsize) {
+        LEPT_FREE(bandata);
+        LEPT_FREE(bandsize);
+        pixDestroy(&pix);
+        return ERROR_INT("band arrays not made", procName, 1);
+    }
+
+    nfail = 0;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nbands) schedule(static) \
+            reduction(+:nfail)
+#endif  /* _OPENMP */
+    for (i = 0; i < nbands; i++) {
+        if (jpegWriteRows(NULL, &bandata[i], &bandsize[i], pix,
+                          i * bandrows * mcuh,
+                          L_MIN(h, (i + 1) * bandrows * mcuh), quality, 0,
+                          special, restartrows * ((w + mcuw - 1) / mcuw)))
+            nfail++;
+    }
+    ret = 1;
+    if (nfail == 0)
+        ret = jpegJoinBands(fp, bandata, bandsize, nbands, h,
+                            bandrows / restartrows);
+
+        /* The band data was allocated by libjpeg */
+    for (i = 0; i < nbands; i++)
+        free(bandata[i]);
+    LEPT_FREE(bandata);
+    LEPT_FREE(bandsize);
+    pixDestroy(&pix);
+    if (ret)
+        return ERROR_INT("bands not written", procName, 1);
+    return 0;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                     Static helpers for writing                      *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   jpegWriteRows()
+ *
+ * \param[in]    fp file stream; or NULL to write to memory
+ * \param[out]   pdata, psize data and size written to memory; use
+ *                       if fp is NULL, and free the data with free()
+ * \param[in]    pix 8, 24 or 32 bpp, no cmap
+ * \param[in]    y0, y1 rows [y0, y1) to compress
+ * \param[in]    quality 1 - 100
+ * \param[in]    progressive 0 for baseline sequential; 1 for progressive
+ * \param[in]    special jpeg flags of the pix
+ * \param[in]    restart restart interval in MCUs; 0 for none
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The rows are written as an image of their own.  The text of
+ *          the pix is written as a comment only with the top row.
+ * </pre>
+ */
+static l_int32
+jpegWriteRows(FILE           *fp,
+              l_uint8       **pdata,
+              unsigned long  *psize,
+              PIX            *pix,
+              l_int32         y0,
+              l_int32         y1,
+              l_int32         quality,
+              l_int32         progressive,
+              l_int32         special,
+              l_int32         restart)
+{
+l_int32                      xres, yres;
+l_int32                      i, j, k;
+l_int32                      w, d, wpl, spp, colorflag, rowsamples;
+l_uint32                    *ppixel, *line, *data;
+JSAMPROW                     rowbuffer;
+struct jpeg_compress_struct  cinfo;
+struct jpeg_error_mgr        jerr;
+char                        *text;
+jmp_buf                      jmpbuf;  /* must be local to the function */
+
+    PROCNAME("jpegWriteRows");
+
     rowbuffer = NULL;
 
         /* Modify the jpeg error handling to catch fatal errors  */
@@ -841,15 +1003,25 @@ jmp_buf                      jmpbuf;  /* must be local to the function */
     jerr.error_exit = jpeg_error_catch_all_1;
     if (setjmp(jmpbuf)) {
         LEPT_FREE(rowbuffer);
-        pixDestroy(&pix);
         return ERROR_INT("internal jpeg error", procName, 1);
     }
 
         /* Initialize the jpeg structs for compression */
     jpeg_create_compress(&cinfo);
+#if  JPEG_BANDS_SUPPORTED
+    if (!fp) {
+        *pdata = NULL;
+        *psize = 0;
+        jpeg_mem_dest(&cinfo, pdata, psize);
+    } else {
+        jpeg_stdio_dest(&cinfo, fp);
+    }
+#else
     jpeg_stdio_dest(&cinfo, fp);
+#endif  /* JPEG_BANDS_SUPPORTED */
+    w = pixGetWidth(pix);
     cinfo.image_width  = w;
-    cinfo.image_height = h;
+    cinfo.image_height = y1 - y0;
 
         /* Set the color space and number of components */
     d = pixGetDepth(pix);
@@ -883,6 +1055,12 @@ jmp_buf                      jmpbuf;  /* must be local to the function */
     if (progressive)
         jpeg_simple_progression(&cinfo);
 
+        /* The fast integer dct is less accurate at high quality, but
+         * that is rarely visible at quality below about 90. */
+    if (special & L_FAST_DCT_JPEG)
+        cinfo.dct_method = JDCT_IFAST;
+    cinfo.restart_interval = restart;
+
         /* Set the chroma subsampling parameters.  This is done in
          * YUV color space.  The Y (intensity) channel is never subsampled.
          * The standard subsampling is 2x2 on both the U and V channels.
@@ -891,7 +1069,7 @@ jmp_buf                      jmpbuf;  /* must be local to the function */
          * The standard subsampling is written as 4:2:0.
          * We allow high quality where there is no subsampling on the
          * chroma channels: denoted as 4:4:4.  */
-    if (pixs->special == L_NO_CHROMA_SAMPLING_JPEG) {
+    if (special & L_NO_CHROMA_SAMPLING_JPEG) {
         cinfo.comp_info[0].h_samp_factor = 1;
         cinfo.comp_info[0].v_samp_factor = 1;
         cinfo.comp_info[1].h_samp_factor = 1;
@@ -904,7 +1082,7 @@ jmp_buf                      jmpbuf;  /* must be local to the function */
 
         /* Cap the text the length limit, 65533, for JPEG_COM payload.
          * Just to be safe, subtract 100 to cover the Adobe name space.  */
-    if ((text = pixGetText(pix)) != NULL) {
+    if (y0 == 0 && (text = pixGetText(pix)) != NULL) {
         if (strlen(text) > 65433) {
             L_WARNING("text is %lu bytes; clipping to 65433\n",
                    procName, (unsigned long)strlen(text));
@@ -918,13 +1096,13 @@ jmp_buf                      jmpbuf;  /* must be local to the function */
     rowsamples = spp * w;
     if ((rowbuffer = (JSAMPROW)LEPT_CALLOC(sizeof(JSAMPLE), rowsamples))
         == NULL) {
-        pixDestroy(&pix);
+        jpeg_destroy_compress(&cinfo);
         return ERROR_INT("calloc fail for rowbuffer", procName, 1);
     }
 
     data = pixGetData(pix);
     wpl  = pixGetWpl(pix);
-    for (i = 0; i < h; i++) {
+    for (i = y0; i < y1; i++) {
         line = data + i * wpl;
         if (colorflag == 0) {        /* 8 bpp gray */
             for (j = 0; j < w; j++)
@@ -947,13 +1125,110 @@ jmp_buf                      jmpbuf;  /* must be local to the function */
     }
     jpeg_finish_compress(&cinfo);
 
-    pixDestroy(&pix);
     LEPT_FREE(rowbuffer);
     jpeg_destroy_compress(&cinfo);
     return 0;
 }
 
 
+/*!
+ * \brief   jpegJoinBands()
+ *
+ * \param[in]    fp file stream
+ * \param[in]    bandata, bandsize jpeg data of each band, top to bottom
+ * \param[in]    nbands
+ * \param[in]    h height of the whole image
+ * \param[in]    nrestart number of restart intervals in each band
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This writes the headers of the first band, with the image
+ *          height set to %h, then the entropy-coded data of each band
+ *          in turn, with a restart marker ending each band but the last.
+ *      (2) Restart markers count modulo 8 over the image, so those in
+ *          the bands, which count from 0 in each, are renumbered in place.
+ * </pre>
+ */
+static l_int32
+jpegJoinBands(FILE            *fp,
+              l_uint8        **bandata,
+              unsigned long   *bandsize,
+              l_int32          nbands,
+              l_int32          h,
+              l_int32          nrestart)
+{
+l_uint8        *data, marker[2];
+l_int32         b, n;
+unsigned long   start, size, i;
+
+    PROCNAME("jpegJoinBands");
+
+    for (b = 0; b < nbands; b++) {
+        data = bandata[b];
+        size = bandsize[b];
+        if ((start = jpegFindScan(data, size, (b == 0) ? h : 0)) == 0 ||
+            start + 2 > size || data[size - 2] != 0xff ||
+            data[size - 1] != 0xd9)
+            return ERROR_INT("band data not valid", procName, 1);
+        if (b == 0 && fwrite(data, 1, start, fp) != start)
+            return ERROR_INT("header not written", procName, 1);
+
+            /* Restart interval n of the image is followed by marker
+             * 0xd0 + n % 8.  Entropy-coded data never has 0xff followed
+             * by anything but 0 or a marker. */
+        n = b * nrestart;
+        for (i = start; i + 2 < size; i++) {
+            if (data[i] == 0xff && data[i + 1] >= 0xd0 && data[i + 1] <= 0xd7)
+                data[i + 1] = 0xd0 + n++ % 8;
+        }
+        if (fwrite(data + start, 1, size - 2 - start, fp) != size - 2 - start)
+            return ERROR_INT("band not written", procName, 1);
+        marker[0] = 0xff;
+        marker[1] = (b < nbands - 1) ? 0xd0 + ((b + 1) * nrestart - 1) % 8
+                                     : 0xd9;
+        if (fwrite(marker, 1, 2, fp) != 2)
+            return ERROR_INT("marker not written", procName, 1);
+    }
+    return 0;
+}
+
+
+/*!
+ * \brief   jpegFindScan()
+ *
+ * \param[in]    data jpeg data
+ * \param[in]    size of data
+ * \param[in]    h if > 0, set the image height in the frame header
+ * \return  offset of the entropy-coded data of the first scan, or 0
+ *              if not found
+ */
+static unsigned long
+jpegFindScan(l_uint8        *data,
+             unsigned long   size,
+             l_int32         h)
+{
+l_int32        marker;
+unsigned long  pos, len;
+
+    if (size < 4 || data[0] != 0xff || data[1] != 0xd8)
+        return 0;
+    for (pos = 2; pos + 4 <= size && data[pos] == 0xff; pos += 2 + len) {
+        marker = data[pos + 1];
+        len = (data[pos + 2] << 8) | data[pos + 3];
+        if (pos + 2 + len > size)
+            return 0;
+        if (marker >= 0xc0 && marker <= 0xc2 && h > 0 && len >= 7) {
+            data[pos + 5] = (h >> 8) & 0xff;
+            data[pos + 6] = h & 0xff;
+        }
+        if (marker == 0xda)
+            return pos + 2 + len;
+    }
+    return 0;
+}
+
+
 /*---------------------------------------------------------------------*
  *                         Read/write to memory                        *
  *---------------------------------------------------------------------*/
@@ -1118,7 +1393,7 @@ FILE    *fp;
 
 
 /*---------------------------------------------------------------------*
- *           Setting special flag for chroma sampling on write         *
+ *        Setting special flags for chroma sampling and dct on write   *
  *---------------------------------------------------------------------*/
 /*!
  * \brief   pixSetChromaSampling()
@@ -1133,20 +1408,67 @@ FILE    *fp;
  *          considerably smaller and the appearance is typically satisfactory.
  *          To get full resolution output in the chroma channels for
  *          jpeg writing, call this with %sampling == 0.
+ *      (2) This keeps the dct set by pixSetJpegFastEncode().
  * </pre>
  */
 l_int32
 pixSetChromaSampling(PIX     *pix,
                      l_int32  sampling)
 {
+l_int32  special;
+
     PROCNAME("pixSetChromaSampling");
 
     if (!pix)
         return ERROR_INT("pix not defined", procName, 1 );
+    special = pix->special;
+    if (special < 0 || special > L_JPEG_SPECIAL_MASK)
+        special = 0;
     if (sampling)
-        pixSetSpecial(pix, 0);  /* default */
+        special &= ~L_NO_CHROMA_SAMPLING_JPEG;  /* default */
+    else
+        special |= L_NO_CHROMA_SAMPLING_JPEG;
+    pixSetSpecial(pix, special);
+    return 0;
+}
+
+
+/*!
+ * \brief   pixSetJpegFastEncode()
+ *
+ * \param[in]    pix
+ * \param[in]    fast 1 for the fast integer dct; 0 for the default
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) With %fast, jpeg writing of the pix uses the fast integer
+ *          dct (JDCT_IFAST) instead of the accurate one.  It is a bit
+ *          less accurate, which is rarely visible at quality below
+ *          about 90.  Use it for intermediate images and for image
+ *          layers such as the background of a page.
+ *      (2) This keeps the chroma sampling set by pixSetChromaSampling(),
+ *          and replaces any other flag in pix->special.
+ * </pre>
+ */
+l_int32
+pixSetJpegFastEncode(PIX     *pix,
+                     l_int32  fast)
+{
+l_int32  special;
+
+    PROCNAME("pixSetJpegFastEncode");
+
+    if (!pix)
+        return ERROR_INT("pix not defined", procName, 1 );
+    special = pix->special;
+    if (special < 0 || special > L_JPEG_SPECIAL_MASK)
+        special = 0;
+    if (fast)
+        special |= L_FAST_DCT_JPEG;
     else
-        pixSetSpecial(pix, L_NO_CHROMA_SAMPLING_JPEG);
+        special &= ~L_FAST_DCT_JPEG;
+    pixSetSpecial(pix, special);
     return 0;
 }
 
@@ -138,6 +138,13 @@ l_int32 pixSetChromaSampling(PIX *pix, l_int32 sampling)
 
 /* ----------------------------------------------------------------------*/
 
+l_int32 pixSetJpegFastEncode(PIX *pix, l_int32 fast)
+{
+    return ERROR_INT("function not present", "pixSetJpegFastEncode", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
 /* --------------------------------------------*/
 #endif  /* !HAVE_LIBJPEG */
 /* --------------------------------------------*/
@@ -58,6 +58,11 @@
  *         void     resetMorphBoundaryCondition()
  *         l_int32  getMorphBorderPixelColor()
  *
+ *     Static helpers for large brick Sels
+ *         static PIX     *pixBrickByDoubling()
+ *         static void     brickDoublingHorizLow()
+ *         static void     brickDoublingVertLow()
+ *
  *     Static helpers for arg processing
  *         static PIX     *processMorphArgs1()
  *         static PIX     *processMorphArgs2()
@@ -157,6 +162,12 @@
  *  of a hit-miss Sel), followed by the HMT.
  *  Both of these 'generalized' functions are idempotent.
  *
+ *  The brick functions pixDilateBrick(), pixErodeBrick(), pixOpenBrick()
+ *  and pixCloseBrick() do a linear Sel of size n with n rasterops.
+ *  When a side of the brick is at least MIN_DOUBLING_BRICK_SIZE, they
+ *  instead grow the brick by doubling, with about log2(n) passes over
+ *  the image, and give exactly the same result.
+ *
  *  These functions are extensively tested in prog/binmorph1_reg.c,
  *  prog/binmorph2_reg.c, and prog/binmorph3_reg.c.
  * </pre>
@@ -174,6 +185,17 @@ LEPT_DLL l_int32  MORPH_BC = ASYMMETRIC_MORPH_BC;
     /* We accept this cost in extra rasterops for decomposing exactly. */
 static const l_int32  ACCEPTABLE_COST = 5;
 
+    /* Bricks with a side at least this large are done by doubling */
+static const l_int32  MIN_DOUBLING_BRICK_SIZE = 16;
+
+    /* Static helpers for large brick Sels */
+static PIX *pixBrickByDoubling(PIX *pixs, l_int32 type, l_int32 hsize,
+                               l_int32 vsize);
+static void brickDoublingHorizLow(l_uint32 *data, l_int32 wpl, l_int32 h,
+                                  l_int32 size, l_int32 type);
+static void brickDoublingVertLow(l_uint32 *data, l_int32 wpl, l_int32 h,
+                                 l_int32 size, l_int32 type);
+
     /* Static helpers for arg processing */
 static PIX * processMorphArgs1(PIX *pixd, PIX *pixs, SEL *sel, PIX **ppixt);
 static PIX * processMorphArgs2(PIX *pixd, PIX *pixs, SEL *sel);
@@ -668,7 +690,9 @@ PIX  *pixt;
  * Notes:
  *      (1) Sel is a brick with all elements being hits
  *      (2) The origin is at (x, y) = (hsize/2, vsize/2)
- *      (3) Do separably if both hsize and vsize are > 1.
+ *      (3) Do separably if both hsize and vsize are > 1.  If either
+ *          is at least MIN_DOUBLING_BRICK_SIZE, do it by doubling;
+ *          see pixBrickByDoubling().
  *      (4) There are three cases:
  *          (a) pixd == null   (result into new pixd)
  *          (b) pixd == pixs   (in-place; writes result back to pixs)
@@ -700,6 +724,15 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
+    if (L_MAX(hsize, vsize) >= MIN_DOUBLING_BRICK_SIZE) {
+        if ((pixt = pixBrickByDoubling(pixs, L_MORPH_DILATE, hsize, vsize))
+            == NULL)
+            return (PIX *)ERROR_PTR("pixt not made", procName, pixd);
+        if (!pixd)
+            return pixt;
+        pixTransferAllData(pixd, &pixt, 0, 0);
+        return pixd;
+    }
     if (hsize == 1 || vsize == 1) {  /* no intermediate result */
         sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
         pixd = pixDilate(pixd, pixs, sel);
@@ -732,7 +765,9 @@ SEL  *sel, *selh, *selv;
  * Notes:
  *      (1) Sel is a brick with all elements being hits
  *      (2) The origin is at (x, y) = (hsize/2, vsize/2)
- *      (3) Do separably if both hsize and vsize are > 1.
+ *      (3) Do separably if both hsize and vsize are > 1.  If either
+ *          is at least MIN_DOUBLING_BRICK_SIZE, do it by doubling;
+ *          see pixBrickByDoubling().
  *      (4) There are three cases:
  *          (a) pixd == null   (result into new pixd)
  *          (b) pixd == pixs   (in-place; writes result back to pixs)
@@ -764,6 +799,15 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
+    if (L_MAX(hsize, vsize) >= MIN_DOUBLING_BRICK_SIZE) {
+        if ((pixt = pixBrickByDoubling(pixs, L_MORPH_ERODE, hsize, vsize))
+            == NULL)
+            return (PIX *)ERROR_PTR("pixt not made", procName, pixd);
+        if (!pixd)
+            return pixt;
+        pixTransferAllData(pixd, &pixt, 0, 0);
+        return pixd;
+    }
     if (hsize == 1 || vsize == 1) {  /* no intermediate result */
         sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
         pixd = pixErode(pixd, pixs, sel);
@@ -796,7 +840,9 @@ SEL  *sel, *selh, *selv;
  * Notes:
  *      (1) Sel is a brick with all elements being hits
  *      (2) The origin is at (x, y) = (hsize/2, vsize/2)
- *      (3) Do separably if both hsize and vsize are > 1.
+ *      (3) Do separably if both hsize and vsize are > 1.  If either
+ *          is at least MIN_DOUBLING_BRICK_SIZE, do it by doubling;
+ *          see pixBrickByDoubling().
  *      (4) There are three cases:
  *          (a) pixd == null   (result into new pixd)
  *          (b) pixd == pixs   (in-place; writes result back to pixs)
@@ -814,7 +860,7 @@ pixOpenBrick(PIX     *pixd,
              l_int32  hsize,
              l_int32  vsize)
 {
-PIX  *pixt;
+PIX  *pixt, *pixt2;
 SEL  *sel, *selh, *selv;
 
     PROCNAME("pixOpenBrick");
@@ -828,6 +874,17 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
+    if (L_MAX(hsize, vsize) >= MIN_DOUBLING_BRICK_SIZE) {
+        pixt = pixBrickByDoubling(pixs, L_MORPH_ERODE, hsize, vsize);
+        pixt2 = pixBrickByDoubling(pixt, L_MORPH_DILATE, hsize, vsize);
+        pixDestroy(&pixt);
+        if (!pixt2)
+            return (PIX *)ERROR_PTR("pixt2 not made", procName, pixd);
+        if (!pixd)
+            return pixt2;
+        pixTransferAllData(pixd, &pixt2, 0, 0);
+        return pixd;
+    }
     if (hsize == 1 || vsize == 1) {  /* no intermediate result */
         sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
         pixd = pixOpen(pixd, pixs, sel);
@@ -862,7 +919,9 @@ SEL  *sel, *selh, *selv;
  * Notes:
  *      (1) Sel is a brick with all elements being hits
  *      (2) The origin is at (x, y) = (hsize/2, vsize/2)
- *      (3) Do separably if both hsize and vsize are > 1.
+ *      (3) Do separably if both hsize and vsize are > 1.  If either
+ *          is at least MIN_DOUBLING_BRICK_SIZE, do it by doubling;
+ *          see pixBrickByDoubling().
  *      (4) There are three cases:
  *          (a) pixd == null   (result into new pixd)
  *          (b) pixd == pixs   (in-place; writes result back to pixs)
@@ -880,7 +939,7 @@ pixCloseBrick(PIX     *pixd,
               l_int32  hsize,
               l_int32  vsize)
 {
-PIX  *pixt;
+PIX  *pixt, *pixt2;
 SEL  *sel, *selh, *selv;
 
     PROCNAME("pixCloseBrick");
@@ -894,6 +953,17 @@ SEL  *sel, *selh, *selv;
 
     if (hsize == 1 && vsize == 1)
         return pixCopy(pixd, pixs);
+    if (L_MAX(hsize, vsize) >= MIN_DOUBLING_BRICK_SIZE) {
+        pixt = pixBrickByDoubling(pixs, L_MORPH_DILATE, hsize, vsize);
+        pixt2 = pixBrickByDoubling(pixt, L_MORPH_ERODE, hsize, vsize);
+        pixDestroy(&pixt);
+        if (!pixt2)
+            return (PIX *)ERROR_PTR("pixt2 not made", procName, pixd);
+        if (!pixd)
+            return pixt2;
+        pixTransferAllData(pixd, &pixt2, 0, 0);
+        return pixd;
+    }
     if (hsize == 1 || vsize == 1) {  /* no intermediate result */
         sel = selCreateBrick(vsize, hsize, vsize / 2, hsize / 2, SEL_HIT);
         pixd = pixClose(pixd, pixs, sel);
@@ -1006,6 +1076,204 @@ SEL     *sel, *selh, *selv;
 }
 
 
+/*-----------------------------------------------------------------*
+ *               Static helpers for large brick Sels               *
+ *-----------------------------------------------------------------*/
+/*!
+ * \brief   pixBrickByDoubling()
+ *
+ * \param[in]    pixs 1 bpp
+ * \param[in]    type L_MORPH_DILATE or L_MORPH_ERODE
+ * \param[in]    hsize width of brick Sel
+ * \param[in]    vsize height of brick Sel
+ * \return  pixd, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This gives the same result as the separable rasterop
+ *          dilation or erosion with the brick, with the origin at
+ *          (hsize/2, vsize/2) and the current boundary condition.
+ *      (2) A brick of size n whose origin is at its first pixel is
+ *          grown from size k to 2k by combining the image with itself
+ *          shifted by k, until k is the largest power of 2 not
+ *          exceeding n; one more shift by n - k completes it.  The
+ *          shift to the actual origin is done when the result is
+ *          clipped out.
+ *      (3) The image is first embedded in a border of boundary condition
+ *          pixels, wide enough that the edges of the bordered image,
+ *          which the low-level functions leave partly unprocessed, are
+ *          beyond the reach of the operation.
+ * </pre>
+ */
+static PIX *
+pixBrickByDoubling(PIX     *pixs,
+                   l_int32  type,
+                   l_int32  hsize,
+                   l_int32  vsize)
+{
+l_int32    w, h, border, bordercolor, x, y;
+l_uint32  *data;
+BOX       *box;
+PIX       *pixt, *pixd;
+
+    PROCNAME("pixBrickByDoubling");
+
+    if (!pixs)
+        return (PIX *)ERROR_PTR("pixs not defined", procName, NULL);
+
+    border = 32 * (2 + (L_MAX(hsize, vsize) + 31) / 32);
+    if (type == L_MORPH_DILATE)
+        bordercolor = 0;
+    else
+        bordercolor = getMorphBorderPixelColor(L_MORPH_ERODE, 1);
+    if ((pixt = pixAddBorder(pixs, border, bordercolor)) == NULL)
+        return (PIX *)ERROR_PTR("pixt not made", procName, NULL);
+
+    data = pixGetData(pixt);
+    if (hsize > 1) {
+        brickDoublingHorizLow(data, pixGetWpl(pixt), pixGetHeight(pixt),
+                              hsize, type);
+    }
+    if (vsize > 1) {
+        brickDoublingVertLow(data, pixGetWpl(pixt), pixGetHeight(pixt),
+                             vsize, type);
+    }
+
+        /* The dilated pixel at x is at x + hsize/2 in pixt, and the
+         * eroded pixel at x is at x - hsize/2 */
+    pixGetDimensions(pixs, &w, &h, NULL);
+    if (type == L_MORPH_DILATE) {
+        x = border + hsize / 2;
+        y = border + vsize / 2;
+    } else {
+        x = border - hsize / 2;
+        y = border - vsize / 2;
+    }
+    box = boxCreate(x, y, w, h);
+    pixd = pixClipRectangle(pixt, box, NULL);
+    pixCopyResolution(pixd, pixs);
+    pixCopyText(pixd, pixs);
+    pixCopyInputFormat(pixd, pixs);
+    boxDestroy(&box);
+    pixDestroy(&pixt);
+    return pixd;
+}
+
+
+/*!
+ * \brief   brickDoublingHorizLow()
+ *
+ * \param[in]    data 1 bpp image data, in place
+ * \param[in]    wpl
+ * \param[in]    h
+ * \param[in]    size width of brick
+ * \param[in]    type L_MORPH_DILATE or L_MORPH_ERODE
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This replaces each pixel at x by the OR (for dilation) of the
+ *          pixels in [x - size + 1, x], or the AND (for erosion) of the
+ *          pixels in [x, x + size - 1].
+ *      (2) Each row is processed in the direction that reads only words
+ *          not yet changed in the current pass.  The first (dilation)
+ *          or last (erosion) few words of each row, within the shift,
+ *          are not changed.
+ * </pre>
+ */
+static void
+brickDoublingHorizLow(l_uint32  *data,
+                      l_int32    wpl,
+                      l_int32    h,
+                      l_int32    size,
+                      l_int32    type)
+{
+l_int32    i, j, k, shift, nw, nb;
+l_uint32  *line;
+
+    for (k = 1; k < size; k *= 2) {
+        shift = (2 * k <= size) ? k : size - k;
+        nw = shift / 32;
+        nb = shift & 31;
+        for (i = 0; i < h; i++) {
+            line = data + i * wpl;
+            if (type == L_MORPH_DILATE) {
+                if (nb == 0) {
+                    for (j = wpl - 1; j >= nw; j--)
+                        line[j] |= line[j - nw];
+                } else {
+                    for (j = wpl - 1; j > nw; j--) {
+                        line[j] |= (line[j - nw] >> nb) |
+                                   (line[j - nw - 1] << (32 - nb));
+                    }
+                }
+            } else {  /* erode */
+                if (nb == 0) {
+                    for (j = 0; j < wpl - nw; j++)
+                        line[j] &= line[j + nw];
+                } else {
+                    for (j = 0; j < wpl - nw - 1; j++) {
+                        line[j] &= (line[j + nw] << nb) |
+                                   (line[j + nw + 1] >> (32 - nb));
+                    }
+                }
+            }
+        }
+        if (shift < k) break;  /* the last, partial shift */
+    }
+    return;
+}
+
+
+/*!
+ * \brief   brickDoublingVertLow()
+ *
+ * \param[in]    data 1 bpp image data, in place
+ * \param[in]    wpl
+ * \param[in]    h
+ * \param[in]    size height of brick
+ * \param[in]    type L_MORPH_DILATE or L_MORPH_ERODE
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the vertical counterpart of brickDoublingHorizLow(),
+ *          combining whole rows of words.
+ * </pre>
+ */
+static void
+brickDoublingVertLow(l_uint32  *data,
+                     l_int32    wpl,
+                     l_int32    h,
+                     l_int32    size,
+                     l_int32    type)
+{
+l_int32    i, j, k, shift;
+l_uint32  *line, *lines;
+
+    for (k = 1; k < size; k *= 2) {
+        shift = (2 * k <= size) ? k : size - k;
+        if (type == L_MORPH_DILATE) {
+            for (i = h - 1; i >= shift; i--) {
+                line = data + i * wpl;
+                lines = line - shift * wpl;
+                for (j = 0; j < wpl; j++)
+                    line[j] |= lines[j];
+            }
+        } else {  /* erode */
+            for (i = 0; i < h - shift; i++) {
+                line = data + i * wpl;
+                lines = line + shift * wpl;
+                for (j = 0; j < wpl; j++)
+                    line[j] &= lines[j];
+            }
+        }
+        if (shift < k) break;  /* the last, partial shift */
+    }
+    return;
+}
+
+
 /*-----------------------------------------------------------------*
  *     Binary composed morphological (raster) ops with brick Sels  *
  *-----------------------------------------------------------------*/
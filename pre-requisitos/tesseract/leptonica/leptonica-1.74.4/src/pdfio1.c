@@ -1192,7 +1192,8 @@ PIX     *pix;
  * \brief   pixConvertToPdf()
  *
  * \param[in]      pix
- * \param[in]      type L_G4_ENCODE, L_JPEG_ENCODE, L_FLATE_ENCODE
+ * \param[in]      type L_G4_ENCODE, L_JPEG_ENCODE, L_FLATE_ENCODE,
+ *                      L_JBIG2_ENCODE
  * \param[in]      quality used for JPEG only; 0 for default (75)
  * \param[in]      fileout output pdf file; only required on last image on page
  * \param[in]      x, y location of lower-left corner of image, in pixels,
@@ -1237,7 +1238,7 @@ size_t    nbytes;
     if (!pix)
         return ERROR_INT("pix not defined", procName, 1);
     if (type != L_G4_ENCODE && type != L_JPEG_ENCODE &&
-        type != L_FLATE_ENCODE)
+        type != L_FLATE_ENCODE && type != L_JBIG2_ENCODE)
         return ERROR_INT("invalid conversion type", procName, 1);
     if (!plpd || (position == L_LAST_IMAGE)) {
         if (!fileout)
@@ -55,6 +55,7 @@
  *          static L_COMP_DATA  *pixGenerateJpegData()
  *          static L_COMP_DATA  *pixGenerateG4Data()
  *          L_COMP_DATA         *l_generateG4Data()
+ *          static L_COMP_DATA  *pixGenerateJbig2Data()
  *
  *       Other
  *          l_int32              cidConvertToPdfData()
@@ -106,6 +107,7 @@ static L_COMP_DATA  *pixGenerateFlateData(PIX *pixs, l_int32 ascii85flag);
 static L_COMP_DATA  *pixGenerateJpegData(PIX *pixs, l_int32 ascii85flag,
                                          l_int32 quality);
 static L_COMP_DATA  *pixGenerateG4Data(PIX *pixs, l_int32 ascii85flag);
+static L_COMP_DATA  *pixGenerateJbig2Data(PIX *pixs, l_int32 ascii85flag);
 
 static l_int32       l_generatePdf(l_uint8 **pdata, size_t *pnbytes,
                                    L_PDF_DATA  *lpd);
@@ -152,7 +154,8 @@ static l_int32   var_WRITE_DATE_AND_VERSION = 1;
  * \brief   pixConvertToPdfData()
  *
  * \param[in]      pix all depths; cmap OK
- * \param[in]      type L_G4_ENCODE, L_JPEG_ENCODE, L_FLATE_ENCODE
+ * \param[in]      type L_G4_ENCODE, L_JPEG_ENCODE, L_FLATE_ENCODE,
+ *                      L_JBIG2_ENCODE
  * \param[in]      quality used for JPEG only; 0 for default (75)
  * \param[out]     pdata pdf array
  * \param[out]     pnbytes number of bytes in pdf array
@@ -1001,7 +1004,8 @@ PIX          *pix;
  * \brief   pixGenerateCIData()
  *
  * \param[in]    pixs 8 or 32 bpp, no colormap
- * \param[in]    type L_G4_ENCODE, L_JPEG_ENCODE, L_FLATE_ENCODE
+ * \param[in]    type L_G4_ENCODE, L_JPEG_ENCODE, L_FLATE_ENCODE,
+ *                    L_JBIG2_ENCODE
  * \param[in]    quality used for jpeg only; 0 for default (75)
  * \param[in]    ascii85 0 for binary; 1 for ascii85-encoded
  * \param[out]   pcid compressed data
@@ -1012,6 +1016,9 @@ PIX          *pix;
  *      (1) Set ascii85:
  *           ~ 0 for binary data (not permitted in PostScript)
  *           ~ 1 for ascii85 (5 for 4) encoded binary data
+ *      (2) L_JBIG2_ENCODE, for 1 bpp, is lossless and typically gives
+ *          2 to 4 times smaller scans than L_G4_ENCODE.  It is only
+ *          for pdf, which decodes it with /JBIG2Decode.
  * </pre>
  */
 l_int32
@@ -1032,7 +1039,7 @@ PIXCMAP  *cmap;
     if (!pixs)
         return ERROR_INT("pixs not defined", procName, 1);
     if (type != L_G4_ENCODE && type != L_JPEG_ENCODE &&
-        type != L_FLATE_ENCODE)
+        type != L_FLATE_ENCODE && type != L_JBIG2_ENCODE)
         return ERROR_INT("invalid conversion type", procName, 1);
     if (ascii85 != 0 && ascii85 != 1)
         return ERROR_INT("invalid ascii85", procName, 1);
@@ -1046,7 +1053,7 @@ PIXCMAP  *cmap;
     } else if (d < 8 && type == L_JPEG_ENCODE) {
         L_WARNING("pixs has < 8 bpp; using flate encoding\n", procName);
         type = L_FLATE_ENCODE;
-    } else if (d > 1 && type == L_G4_ENCODE) {
+    } else if (d > 1 && (type == L_G4_ENCODE || type == L_JBIG2_ENCODE)) {
         L_WARNING("pixs has > 1 bpp; using flate encoding\n", procName);
         type = L_FLATE_ENCODE;
     }
@@ -1057,6 +1064,9 @@ PIXCMAP  *cmap;
     } else if (type == L_G4_ENCODE) {
         if ((*pcid = pixGenerateG4Data(pixs, ascii85)) == NULL)
             return ERROR_INT("g4 data not made", procName, 1);
+    } else if (type == L_JBIG2_ENCODE) {
+        if ((*pcid = pixGenerateJbig2Data(pixs, ascii85)) == NULL)
+            return ERROR_INT("jbig2 data not made", procName, 1);
     } else if (type == L_FLATE_ENCODE) {
         if ((*pcid = pixGenerateFlateData(pixs, ascii85)) == NULL)
             return ERROR_INT("flate data not made", procName, 1);
@@ -1275,7 +1285,7 @@ L_COMP_DATA  *cid;
  * \brief   pixGenerateG4Data()
  *
  * \param[in]    pixs 1 bpp
- * \param[in]    ascii85flag 0 for gzipped; 1 for ascii85-encoded gzipped
+ * \param[in]    ascii85flag 0 for g4 compressed; 1 for ascii85-encoded g4
  * \return  cid g4 compressed image data, or NULL on error
  *
  * <pre>
@@ -1283,13 +1293,18 @@ L_COMP_DATA  *cid;
  *      (1) Set ascii85flag:
  *           ~ 0 for binary data (not permitted in PostScript)
  *           ~ 1 for ascii85 (5 for 4) encoded binary data
+ *      (2) The data is coded in memory by g4EncodePix(), with no
+ *          tiff file in between.
  * </pre>
  */
 static L_COMP_DATA *
 pixGenerateG4Data(PIX     *pixs,
                   l_int32  ascii85flag)
 {
-char         *tname;
+l_uint8      *datacomp = NULL;  /* g4 compressed raster data */
+char         *data85 = NULL;  /* ascii85 encoded g4 compressed data */
+l_int32       nbytes85;
+size_t        nbytescomp;
 L_COMP_DATA  *cid;
 
     PROCNAME("pixGenerateG4Data");
@@ -1299,13 +1314,34 @@ L_COMP_DATA  *cid;
     if (pixGetDepth(pixs) != 1)
         return (L_COMP_DATA *)ERROR_PTR("pixs not 1 bpp", procName, NULL);
 
-        /* Compress to a temp tiff g4 file */
-    tname = l_makeTempFilename();
-    pixWrite(tname, pixs, IFF_TIFF_G4);
+    if (g4EncodePix(pixs, &datacomp, &nbytescomp))
+        return (L_COMP_DATA *)ERROR_PTR("datacomp not made", procName, NULL);
 
-    cid = l_generateG4Data(tname, ascii85flag);
-    lept_rmfile(tname);
-    LEPT_FREE(tname);
+        /* Optionally, encode the compressed data */
+    if (ascii85flag == 1) {
+        data85 = encodeAscii85(datacomp, nbytescomp, &nbytes85);
+        LEPT_FREE(datacomp);
+        if (!data85)
+            return (L_COMP_DATA *)ERROR_PTR("data85 not made", procName, NULL);
+        else
+            data85[nbytes85 - 1] = '\0';  /* remove the newline */
+    }
+
+    cid = (L_COMP_DATA *)LEPT_CALLOC(1, sizeof(L_COMP_DATA));
+    if (ascii85flag == 0) {
+        cid->datacomp = datacomp;
+    } else {  /* ascii85 */
+        cid->data85 = data85;
+        cid->nbytes85 = nbytes85;
+    }
+    cid->type = L_G4_ENCODE;
+    cid->nbytescomp = nbytescomp;
+    cid->w = pixGetWidth(pixs);
+    cid->h = pixGetHeight(pixs);
+    cid->bps = 1;
+    cid->spp = 1;
+    cid->minisblack = 0;
+    cid->res = pixGetXRes(pixs);
     return cid;
 }
 
@@ -1387,6 +1423,69 @@ FILE         *fp;
 }
 
 
+/*!
+ * \brief   pixGenerateJbig2Data()
+ *
+ * \param[in]    pixs 1 bpp
+ * \param[in]    ascii85flag 0 for jbig2; 1 for ascii85-encoded jbig2
+ * \return  cid jbig2 compressed image data, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The data is a lossless generic region with the page
+ *          information segment before it, as embedded in a pdf stream;
+ *          see jbig2EncodeGeneric().  It needs no /JBIG2Globals.
+ *      (2) Like g4, this is coded in memory and needs no libtiff.
+ * </pre>
+ */
+static L_COMP_DATA *
+pixGenerateJbig2Data(PIX     *pixs,
+                     l_int32  ascii85flag)
+{
+l_uint8      *datacomp = NULL;  /* jbig2 compressed raster data */
+char         *data85 = NULL;  /* ascii85 encoded jbig2 data */
+l_int32       nbytes85;
+size_t        nbytescomp;
+L_COMP_DATA  *cid;
+
+    PROCNAME("pixGenerateJbig2Data");
+
+    if (!pixs)
+        return (L_COMP_DATA *)ERROR_PTR("pixs not defined", procName, NULL);
+    if (pixGetDepth(pixs) != 1)
+        return (L_COMP_DATA *)ERROR_PTR("pixs not 1 bpp", procName, NULL);
+
+    if (jbig2EncodeGeneric(pixs, 0, &datacomp, &nbytescomp))
+        return (L_COMP_DATA *)ERROR_PTR("datacomp not made", procName, NULL);
+
+        /* Optionally, encode the compressed data */
+    if (ascii85flag == 1) {
+        data85 = encodeAscii85(datacomp, nbytescomp, &nbytes85);
+        LEPT_FREE(datacomp);
+        if (!data85)
+            return (L_COMP_DATA *)ERROR_PTR("data85 not made", procName, NULL);
+        else
+            data85[nbytes85 - 1] = '\0';  /* remove the newline */
+    }
+
+    cid = (L_COMP_DATA *)LEPT_CALLOC(1, sizeof(L_COMP_DATA));
+    if (ascii85flag == 0) {
+        cid->datacomp = datacomp;
+    } else {  /* ascii85 */
+        cid->data85 = data85;
+        cid->nbytes85 = nbytes85;
+    }
+    cid->type = L_JBIG2_ENCODE;
+    cid->nbytescomp = nbytescomp;
+    cid->w = pixGetWidth(pixs);
+    cid->h = pixGetHeight(pixs);
+    cid->bps = 1;
+    cid->spp = 1;
+    cid->res = pixGetXRes(pixs);
+    return cid;
+}
+
+
 /*!
  * \brief   cidConvertToPdfData()
  *
@@ -1794,7 +1893,7 @@ SARRAY       *sa;
         if ((cid = pdfdataGetCid(lpd, i)) == NULL)
             return ERROR_INT("cid not found", procName, 1);
 
-        if (cid->type == L_G4_ENCODE) {
+        if (cid->type == L_G4_ENCODE || cid->type == L_JBIG2_ENCODE) {
             if (var_WRITE_G4_IMAGE_MASK) {
                 cstr = stringNew("/ImageMask true\n"
                                  "/ColorSpace /DeviceGray");
@@ -1803,14 +1902,18 @@ SARRAY       *sa;
             }
             bstr = stringNew("/BitsPerComponent 1\n"
                              "/Interpolate true");
-            snprintf(buff, sizeof(buff),
-                     "/Filter /CCITTFaxDecode\n"
-                     "/DecodeParms\n"
-                     "<<\n"
-                     "/K -1\n"
-                     "/Columns %d\n"
-                     ">>", cid->w);
-            fstr = stringNew(buff);
+            if (cid->type == L_JBIG2_ENCODE) {
+                fstr = stringNew("/Filter /JBIG2Decode");
+            } else {
+                snprintf(buff, sizeof(buff),
+                         "/Filter /CCITTFaxDecode\n"
+                         "/DecodeParms\n"
+                         "<<\n"
+                         "/K -1\n"
+                         "/Columns %d\n"
+                         ">>", cid->w);
+                fstr = stringNew(buff);
+            }
         } else if (cid->type == L_JPEG_ENCODE) {
             if (cid->spp == 1)
                 cstr = stringNew("/ColorSpace /DeviceGray");
@@ -569,6 +569,13 @@ struct PixTiling
 };
 typedef struct PixTiling PIXTILING;
 
+/*! Operation on one tile, for pixTilingProcess() */
+typedef l_int32 (*L_TILE_FUNC)(struct Pix *pixt, l_int32 i, l_int32 j,
+                               struct Pix **ppixd, void *data);
+
+/*! Most results of each tile for pixTilingProcess() */
+#define  L_MAX_TILE_DEST      4
+
 
 /*-------------------------------------------------------------------------*
  *                       FPix: pix with float array                        *
@@ -1226,14 +1233,19 @@ enum {
 
 /*-------------------------------------------------------------------------*
  *    Flag(s) used in the 'special' pix field for non-default operations   *
- *      - 0 is default for chroma sampling in jpeg                         *
+ *      - 0 is default for chroma sampling and dct in jpeg                 *
+ *      - 1-3 are the jpeg write flags below, which can be or-ed           *
  *      - 10-19 are used for zlib compression in png write                 *
+ *      - 20 selects the fast zlib encoding in png and tiff-zip write      *
  *      - 4 and 8 are used for specifying connectivity in labelling        *
  *-------------------------------------------------------------------------*/
 
 /*! Flags used in Pix::special */
 enum {
-    L_NO_CHROMA_SAMPLING_JPEG = 1   /*!< Write full resolution chroma      */
+    L_NO_CHROMA_SAMPLING_JPEG = 1,  /*!< Write full resolution chroma      */
+    L_FAST_DCT_JPEG = 2,            /*!< Write jpeg with the fast int dct  */
+    L_JPEG_SPECIAL_MASK = 3,        /*!< All jpeg write flags              */
+    L_FAST_ZLIB_ENCODE = 20         /*!< Write png and tiff-zip for speed  */
 };
 
 
@@ -122,8 +122,10 @@
  *
  *  At the lowest level, you can specify the function that does the
  *  allocation and deallocation of the data field in the pix.
- *  By default, this is malloc and free.  However, by calling
- *  setPixMemoryManager(), custom functions can be substituted.
+ *  By default, this is pixPoolAlloc() and pixPoolDealloc(), which use
+ *  malloc and free unless a pool is enabled with pixPoolSetLimit().
+ *  However, by calling setPixMemoryManager(), custom functions can
+ *  be substituted.
  *  When using this, keep two things in mind:
  *
  *   (1) Call setPixMemoryManager() before any pix have been allocated
@@ -132,6 +134,7 @@
  *  In pixalloc.c, we provide an example custom allocator and deallocator.
  *  To use it, you must call pmsCreate() before any pix have been allocated
  *  and pmsDestroy() at the end after all pix have been destroyed.
+ *  The default pool, unlike it, can be enabled and disabled at any time.
  *
  *
  *  Direct manipulation of the pix data field
@@ -203,8 +206,8 @@ static void pixFree(PIX *pix);
  *  effect on memory management for other data structs, which are          *
  *  controlled by the #defines in environ.h.  Likewise, the #defines       *
  *  in environ.h have no effect on the pix memory management.              *
- *  The default functions are malloc and free.  Use setPixMemoryManager()  *
- *  to specify other functions to use.                                     *
+ *  The default functions are pixPoolAlloc() and pixPoolDealloc(), in      *
+ *  pixalloc.c.  Use setPixMemoryManager() to specify other functions.     *
  *-------------------------------------------------------------------------*/
 
 /*! Pix memory manager */
@@ -223,8 +226,8 @@ struct PixMemoryManager
 
 /*! Default Pix memory manager */
 static struct PixMemoryManager  pix_mem_manager = {
-    &malloc,
-    &free
+    &pixPoolAlloc,
+    &pixPoolDealloc
 };
 
 static void *
@@ -511,6 +514,9 @@ PIX      *pixd;
  *              decrements the ref count, nulls the handle, and
  *              only destroys the pix when pixDestroy() has been
  *              called on all handles.
+ *      (3) If the library is built with LEPT_ATOMIC_REFCOUNT (see
+ *          environ.h), clones may be handed to other threads, which
+ *          read the image and destroy their clone when done.
  * </pre>
  */
 PIX *
@@ -580,8 +586,9 @@ char      *text;
 
     if (!pix) return;
 
-    pixChangeRefcount(pix, -1);
-    if (pixGetRefcount(pix) <= 0) {
+        /* The count this decrement leaves is the one that matters:
+         * another thread may destroy its clone meanwhile */
+    if ((l_int32)L_REFCOUNT_ADD(pix->refcount, -1) <= 0) {
         if ((data = pixGetData(pix)) != NULL)
             pix_free(data);
         if ((text = pixGetText(pix)) != NULL)
@@ -1217,7 +1224,7 @@ pixGetRefcount(PIX  *pix)
 
     if (!pix)
         return ERROR_INT("pix not defined", procName, UNDEF);
-    return pix->refcount;
+    return L_REFCOUNT_GET(pix->refcount);
 }
 
 
@@ -1230,7 +1237,7 @@ pixChangeRefcount(PIX     *pix,
     if (!pix)
         return ERROR_INT("pix not defined", procName, 1);
 
-    pix->refcount += delta;
+    L_REFCOUNT_ADD(pix->refcount, delta);
     return 0;
 }
 
@@ -1639,6 +1646,9 @@ pixSetData(PIX       *pix,
  *          pix->data ptr is set to NULL.
  *      (3) If refcount > 1, this simply returns a copy of the data,
  *          using the pix allocator, and leaving the input pix unchanged.
+ *      (4) Either way the data comes from the pix allocator.  Give it
+ *          back to a pix, or free it with pixPoolDealloc() if the
+ *          default allocator is in use; not with free().
  */
 l_uint32 *
 pixExtractData(PIX  *pixs)
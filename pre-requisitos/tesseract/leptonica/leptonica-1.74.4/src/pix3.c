@@ -2084,8 +2084,8 @@ l_uint32  *line;
     endmask = (endbits == 0) ? 0 : (0xffffffffU << (32 - endbits));
 
     tab = (tab8) ? tab8 : makePixelSumTab8();
-    sum = 0;
-    for (j = 0; j < fullwords; j++) {
+    j = countPixelsLineSimd(line, w, &sum) >> 5;
+    for (; j < fullwords; j++) {
         word = line[j];
         if (word) {
             sum += tab[word & 0xff] +
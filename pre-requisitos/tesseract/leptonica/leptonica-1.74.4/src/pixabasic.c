@@ -409,8 +409,7 @@ PIXA    *pixa;
         return;
 
         /* Decrement the refcount.  If it is 0, destroy the pixa. */
-    pixaChangeRefcount(pixa, -1);
-    if (pixa->refcount <= 0) {
+    if ((l_int32)L_REFCOUNT_ADD(pixa->refcount, -1) <= 0) {
         for (i = 0; i < pixa->n; i++)
             pixDestroy(&pixa->pix[i]);
         LEPT_FREE(pixa->pix);
@@ -641,7 +640,7 @@ pixaChangeRefcount(PIXA    *pixa,
     if (!pixa)
         return ERROR_INT("pixa not defined", procName, 1);
 
-    pixa->refcount += delta;
+    L_REFCOUNT_ADD(pixa->refcount, delta);
     return 0;
 }
 
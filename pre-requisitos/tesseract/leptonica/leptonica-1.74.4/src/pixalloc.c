@@ -38,11 +38,30 @@
  *          l_int32       pmsGetLevelForAlloc()
  *          l_int32       pmsGetLevelForDealloc()
  *          void          pmsLogInfo()
+ *
+ *      Thread-safe pool of pix data, the default pix allocator
+ *
+ *          void         *pixPoolAlloc()
+ *          void          pixPoolDealloc()
+ *          l_int32       pixPoolSetLimit()
+ *          l_int32       pixPoolGetInfo()
+ *          static l_int32       pixPoolGetClass()
+ *          static void          pixPoolMakeKey()
+ *          static PIXPOOLCACHE *pixPoolGetCache()
+ *          static void          pixPoolFlushCache()
+ *          static void          pixPoolTrim()
  * </pre>
  */
 
 #include "allheaders.h"
 
+#if !defined(_WIN32) && defined(__GNUC__)
+#define  HAVE_PIX_POOL   1
+#include <pthread.h>
+#else
+#define  HAVE_PIX_POOL   0
+#endif
+
 /*-------------------------------------------------------------------------*
  *                          Pix Memory Storage                             *
  *                                                                         *
@@ -533,3 +552,438 @@ L_PIX_MEM_STORE  *pms;
 
     return;
 }
+
+
+/*-------------------------------------------------------------------------*
+ *                          Pool of pix data                               *
+ *                                                                         *
+ *  pixPoolAlloc() and pixPoolDealloc() are the default pix allocator      *
+ *  and deallocator.  Until a limit is set with pixPoolSetLimit(), they    *
+ *  just call malloc and free.  With a limit, freed blocks of at least     *
+ *  64 KB are kept for reuse, in size classes with 4 sizes to each power   *
+ *  of 2.  A long-running process that makes pix of the same few sizes     *
+ *  for every page then reuses memory that is already mapped, instead of   *
+ *  getting fresh pages from the system, and faulting them in, for each    *
+ *  page.                                                                  *
+ *-------------------------------------------------------------------------*/
+/*
+ *  Every block has a header, before the data, with its size class.
+ *  Idle blocks are kept in a list for each class, shared by all threads
+ *  and guarded by a mutex.  In front of the shared lists, each thread
+ *  caches one idle block of each class, which it takes and returns
+ *  without locking.
+ *
+ *  The limit is on the total size of the idle blocks, cached or shared.
+ *  When a freed block would take the total over the limit, the shared
+ *  blocks are freed, largest first, down to 3/4 of the limit; if the
+ *  block still doesn't fit, it is freed too.  Setting the limit again
+ *  frees the shared blocks above it, and each thread frees its cache
+ *  the next time it uses the pool.
+ *
+ *  As with any pix allocator, data given to a pix with pixSetData() must
+ *  come from the allocator, e.g., from pixExtractData().  The last word
+ *  of the header, just before the data, marks the blocks of the pool;
+ *  a malloc'd array without it is reported, and freed with free().
+ */
+
+    /* Number of size classes; the largest is 1.75 GB */
+#define  PIX_POOL_NCLASSES   60
+
+    /* Smallest block kept by the pool, which is the size of class 0 */
+static const size_t  PIX_POOL_MIN_BYTES = 65536;
+
+static const l_uint32  PIX_POOL_MAGIC = 0x506f4f4c;  /* "PoOL" */
+
+/*! Header of a block of pix data; its last word is PIX_POOL_MAGIC */
+union PixPoolBlock
+{
+    struct {
+        size_t               size;   /*!< bytes of data after the header */
+        union PixPoolBlock  *next;   /*!< next idle block of the class   */
+        l_int32              cls;    /*!< size class, or -1 if none      */
+    } h;
+    char  pad[32];                   /*!< keeps the alignment of malloc  */
+};
+typedef union PixPoolBlock   PIXPOOLBLOCK;
+
+    /* The word just before the data of a block */
+#define  PIX_POOL_MAGIC_OF(block)   (((l_uint32 *)((block) + 1))[-1])
+
+/*! Idle blocks cached by a thread */
+struct PixPoolCache
+{
+    l_int32        generation;                 /*!< of the limit        */
+    PIXPOOLBLOCK  *block[PIX_POOL_NCLASSES];   /*!< one of each class   */
+};
+typedef struct PixPoolCache   PIXPOOLCACHE;
+
+#if HAVE_PIX_POOL
+static pthread_mutex_t  PixPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t   PixPoolKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t    PixPoolKey;
+static l_int32          PixPoolKeyValid = 0;
+static PIXPOOLBLOCK    *PixPoolShared[PIX_POOL_NCLASSES];
+
+    /* These are read and written with atomic operations */
+static size_t   PixPoolLimit = 0;
+static size_t   PixPoolIdleBytes = 0;
+static l_int32  PixPoolGeneration = 0;
+static size_t   PixPoolHits = 0;
+static size_t   PixPoolMisses = 0;
+
+static PIXPOOLCACHE *pixPoolGetCache(void);
+static void pixPoolFlushCache(void *cache);
+static void pixPoolTrim(size_t target);
+#endif  /* HAVE_PIX_POOL */
+
+static l_int32 pixPoolGetClass(size_t nbytes, size_t *psize);
+
+
+/*!
+ * \brief   pixPoolAlloc()
+ *
+ * \param[in]   nbytes of data
+ * \return  data ptr, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This takes an idle block of the size class of %nbytes, from
+ *          the cache of the thread or from the shared lists, if the
+ *          pool is enabled and has one.  Otherwise, it allocates a
+ *          new block.  The data is not initialized.
+ * </pre>
+ */
+void *
+pixPoolAlloc(size_t  nbytes)
+{
+l_int32        cls;
+size_t         size;
+PIXPOOLBLOCK  *block;
+
+    PROCNAME("pixPoolAlloc");
+
+    block = NULL;
+    cls = pixPoolGetClass(nbytes, &size);
+#if HAVE_PIX_POOL
+    if (cls >= 0) {
+        PIXPOOLCACHE  *cache;
+
+        cache = pixPoolGetCache();
+        if (cache && (block = cache->block[cls]) != NULL) {
+            cache->block[cls] = NULL;
+        } else if (__atomic_load_n(&PixPoolShared[cls], __ATOMIC_RELAXED)) {
+            pthread_mutex_lock(&PixPoolMutex);
+            if ((block = PixPoolShared[cls]) != NULL)
+                __atomic_store_n(&PixPoolShared[cls], block->h.next,
+                                 __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&PixPoolMutex);
+        }
+        if (block) {
+            __atomic_sub_fetch(&PixPoolIdleBytes, size, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&PixPoolHits, 1, __ATOMIC_RELAXED);
+        } else if (__atomic_load_n(&PixPoolLimit, __ATOMIC_RELAXED) > 0) {
+            __atomic_add_fetch(&PixPoolMisses, 1, __ATOMIC_RELAXED);
+        }
+    }
+#endif  /* HAVE_PIX_POOL */
+
+    if (!block) {
+        if ((block = (PIXPOOLBLOCK *)malloc(sizeof(PIXPOOLBLOCK) + size))
+            == NULL)
+            return ERROR_PTR("block not made", procName, NULL);
+        block->h.size = size;
+        block->h.cls = cls;
+        PIX_POOL_MAGIC_OF(block) = PIX_POOL_MAGIC;
+    }
+    block->h.next = NULL;
+    return (void *)(block + 1);
+}
+
+
+/*!
+ * \brief   pixPoolDealloc()
+ *
+ * \param[in]   data to be freed or kept for reuse
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) If the pool is enabled and %data fits under the limit, its
+ *          block is cached by the thread, or put in the shared list of
+ *          its size class if the thread already has one.
+ * </pre>
+ */
+void
+pixPoolDealloc(void  *data)
+{
+l_int32        cls;
+size_t         size;
+PIXPOOLBLOCK  *block;
+
+    PROCNAME("pixPoolDealloc");
+
+    if (!data) return;
+    block = (PIXPOOLBLOCK *)data - 1;
+    if (PIX_POOL_MAGIC_OF(block) != PIX_POOL_MAGIC) {
+        L_ERROR("data not from pixPoolAlloc(); freed\n", procName);
+        free(data);
+        return;
+    }
+    cls = block->h.cls;
+    size = block->h.size;
+
+#if HAVE_PIX_POOL
+    if (cls >= 0 && cls < PIX_POOL_NCLASSES) {
+        l_int32        keep;
+        size_t         limit;
+        PIXPOOLCACHE  *cache;
+
+        cache = pixPoolGetCache();
+        limit = __atomic_load_n(&PixPoolLimit, __ATOMIC_RELAXED);
+        keep = (size <= limit);
+        if (keep && __atomic_add_fetch(&PixPoolIdleBytes, size,
+                                       __ATOMIC_RELAXED) > limit) {
+            pixPoolTrim(3 * (limit / 4));
+            if (__atomic_load_n(&PixPoolIdleBytes, __ATOMIC_RELAXED) > limit) {
+                __atomic_sub_fetch(&PixPoolIdleBytes, size, __ATOMIC_RELAXED);
+                keep = 0;
+            }
+        }
+        if (keep) {
+            if (cache && !cache->block[cls]) {
+                cache->block[cls] = block;
+            } else {
+                pthread_mutex_lock(&PixPoolMutex);
+                block->h.next = PixPoolShared[cls];
+                __atomic_store_n(&PixPoolShared[cls], block, __ATOMIC_RELAXED);
+                pthread_mutex_unlock(&PixPoolMutex);
+            }
+            return;
+        }
+    }
+#endif  /* HAVE_PIX_POOL */
+
+    PIX_POOL_MAGIC_OF(block) = 0;
+    free(block);
+    return;
+}
+
+
+/*!
+ * \brief   pixPoolSetLimit()
+ *
+ * \param[in]   maxbytes most bytes of idle data kept; 0 to keep none
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) The pool is disabled by default.  A limit enables it, and 0
+ *          disables it again.  It can be set at any time, from any
+ *          thread; if it changes, idle blocks above the new limit are
+ *          freed.
+ *      (2) A worker that keeps about k full pages of pix alive at a
+ *          time needs a limit of about k times the size of those pix.
+ *      (3) The pool needs pthreads; elsewhere, this returns 1 and the
+ *          allocator stays malloc and free.
+ * </pre>
+ */
+l_int32
+pixPoolSetLimit(size_t  maxbytes)
+{
+    PROCNAME("pixPoolSetLimit");
+
+#if HAVE_PIX_POOL
+    if (__atomic_exchange_n(&PixPoolLimit, maxbytes, __ATOMIC_RELAXED)
+        == maxbytes)
+        return 0;
+    __atomic_add_fetch(&PixPoolGeneration, 1, __ATOMIC_RELAXED);
+    pixPoolGetCache();  /* flushes the cache of this thread */
+    pixPoolTrim(maxbytes);
+    return 0;
+#else
+    if (maxbytes == 0)
+        return 0;
+    return ERROR_INT("pix pool not supported on this platform", procName, 1);
+#endif  /* HAVE_PIX_POOL */
+}
+
+
+/*!
+ * \brief   pixPoolGetInfo()
+ *
+ * \param[out]   pidlebytes [optional] bytes of idle data in the pool
+ * \param[out]   phits [optional] allocations served by the pool
+ * \param[out]   pmisses [optional] allocations that the enabled pool
+ *                                  could not serve
+ * \return  0 if OK, 1 on error
+ */
+l_int32
+pixPoolGetInfo(size_t  *pidlebytes,
+               size_t  *phits,
+               size_t  *pmisses)
+{
+    PROCNAME("pixPoolGetInfo");
+
+    if (!pidlebytes && !phits && !pmisses)
+        return ERROR_INT("no output requested", procName, 1);
+#if HAVE_PIX_POOL
+    if (pidlebytes)
+        *pidlebytes = __atomic_load_n(&PixPoolIdleBytes, __ATOMIC_RELAXED);
+    if (phits) *phits = __atomic_load_n(&PixPoolHits, __ATOMIC_RELAXED);
+    if (pmisses) *pmisses = __atomic_load_n(&PixPoolMisses, __ATOMIC_RELAXED);
+#else
+    if (pidlebytes) *pidlebytes = 0;
+    if (phits) *phits = 0;
+    if (pmisses) *pmisses = 0;
+#endif  /* HAVE_PIX_POOL */
+    return 0;
+}
+
+
+/*!
+ * \brief   pixPoolGetClass()
+ *
+ * \param[in]    nbytes of data
+ * \param[out]   psize bytes of data in a block of the class
+ * \return  size class, or -1 if the pool doesn't keep blocks for %nbytes
+ */
+static l_int32
+pixPoolGetClass(size_t   nbytes,
+                size_t  *psize)
+{
+l_int32  cls;
+size_t   size;
+
+    *psize = nbytes;
+    if (nbytes < PIX_POOL_MIN_BYTES)
+        return -1;
+    for (cls = 0; cls < PIX_POOL_NCLASSES; cls++) {
+        size = (size_t)(4 + (cls & 3)) << (14 + (cls >> 2));
+        if (size >= nbytes) {
+            *psize = size;
+            return cls;
+        }
+    }
+    return -1;
+}
+
+
+#if HAVE_PIX_POOL
+static void
+pixPoolMakeKey(void)
+{
+    if (pthread_key_create(&PixPoolKey, pixPoolFlushCache) == 0)
+        PixPoolKeyValid = 1;
+}
+
+
+/*!
+ * \brief   pixPoolGetCache()
+ *
+ * \return  cache of the calling thread, or NULL if the pool is disabled
+ *
+ * <pre>
+ * Notes:
+ *      (1) A cache is made on the first use of the enabled pool by the
+ *          thread, and is emptied when the limit has changed since the
+ *          thread last used it.
+ * </pre>
+ */
+static PIXPOOLCACHE *
+pixPoolGetCache(void)
+{
+l_int32        generation;
+PIXPOOLCACHE  *cache;
+
+    pthread_once(&PixPoolKeyOnce, pixPoolMakeKey);
+    if (!PixPoolKeyValid)
+        return NULL;
+    generation = __atomic_load_n(&PixPoolGeneration, __ATOMIC_RELAXED);
+    cache = (PIXPOOLCACHE *)pthread_getspecific(PixPoolKey);
+    if (cache && cache->generation != generation) {
+        pixPoolFlushCache(cache);
+        cache = NULL;
+        pthread_setspecific(PixPoolKey, NULL);
+    }
+    if (!cache && __atomic_load_n(&PixPoolLimit, __ATOMIC_RELAXED) > 0) {
+        if ((cache = (PIXPOOLCACHE *)calloc(1, sizeof(PIXPOOLCACHE)))
+            == NULL)
+            return NULL;
+        cache->generation = generation;
+        pthread_setspecific(PixPoolKey, cache);
+    }
+    return cache;
+}
+
+
+/*!
+ * \brief   pixPoolFlushCache()
+ *
+ * \param[in]    cache of a thread
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This frees the cache and its blocks.  It is also the
+ *          destructor of the cache when its thread exits.
+ * </pre>
+ */
+static void
+pixPoolFlushCache(void  *cache)
+{
+l_int32        cls;
+PIXPOOLBLOCK  *block;
+
+    for (cls = 0; cls < PIX_POOL_NCLASSES; cls++) {
+        if ((block = ((PIXPOOLCACHE *)cache)->block[cls]) != NULL) {
+            __atomic_sub_fetch(&PixPoolIdleBytes, block->h.size,
+                               __ATOMIC_RELAXED);
+            PIX_POOL_MAGIC_OF(block) = 0;
+            free(block);
+        }
+    }
+    free(cache);
+}
+
+
+/*!
+ * \brief   pixPoolTrim()
+ *
+ * \param[in]    target bytes of idle data to trim down to
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) This frees shared blocks, largest first, until the idle
+ *          data is no more than %target.  The blocks cached by threads
+ *          are not touched.
+ * </pre>
+ */
+static void
+pixPoolTrim(size_t  target)
+{
+l_int32        cls;
+PIXPOOLBLOCK  *block, *freed;
+
+    freed = NULL;
+    pthread_mutex_lock(&PixPoolMutex);
+    for (cls = PIX_POOL_NCLASSES - 1; cls >= 0; cls--) {
+        while ((block = PixPoolShared[cls]) != NULL &&
+               __atomic_load_n(&PixPoolIdleBytes, __ATOMIC_RELAXED) > target) {
+            __atomic_store_n(&PixPoolShared[cls], block->h.next,
+                             __ATOMIC_RELAXED);
+            __atomic_sub_fetch(&PixPoolIdleBytes, block->h.size,
+                               __ATOMIC_RELAXED);
+            block->h.next = freed;
+            freed = block;
+        }
+    }
+    pthread_mutex_unlock(&PixPoolMutex);
+
+    while ((block = freed) != NULL) {  /* free outside the lock */
+        freed = block->h.next;
+        PIX_POOL_MAGIC_OF(block) = 0;
+        free(block);
+    }
+}
+#endif  /* HAVE_PIX_POOL */
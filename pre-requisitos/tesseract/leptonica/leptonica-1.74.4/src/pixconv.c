@@ -741,6 +741,8 @@ pixConvertRGBToLuminance(PIX *pixs)
  * <pre>
  * Notes:
  *      (1) Use a weighted average of the RGB values.
+ *      (2) Most of each line is converted by vectorized code, where
+ *          available; see simdlow.c.  The result is the same.
  * </pre>
  */
 PIX *
@@ -792,7 +794,8 @@ PIX       *pixd;
     for (i = 0; i < h; i++) {
         lines = datas + i * wpls;
         lined = datad + i * wpld;
-        for (j = 0; j < w; j++) {
+        j = rgbToGrayLineSimd(lined, lines, w, rwt, gwt, bwt);
+        for (; j < w; j++) {
             word = *(lines + j);
             val = (l_int32)(rwt * ((word >> L_RED_SHIFT) & 0xff) +
                             gwt * ((word >> L_GREEN_SHIFT) & 0xff) +
@@ -848,7 +851,8 @@ PIX       *pixd;
     for (i = 0; i < h; i++) {
         lines = datas + i * wpls;
         lined = datad + i * wpld;
-        for (j = 0; j < w; j++, lines++) {
+        j = rgbToGreenLineSimd(lined, lines, w);
+        for (lines += j; j < w; j++, lines++) {
             val = ((*lines) >> L_GREEN_SHIFT) & 0xff;
             SET_DATA_BYTE(lined, j, val);
         }
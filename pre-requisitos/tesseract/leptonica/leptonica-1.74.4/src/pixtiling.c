@@ -36,6 +36,7 @@
  *        PIX             *pixTilingGetTile()
  *        l_int32          pixTilingNoStripOnPaint()
  *        l_int32          pixTilingPaintTile()
+ *        l_int32          pixTilingProcess()
  *
  *   This provides a simple way to split an image into tiles
  *   and to perform operations independently on each tile.
@@ -82,11 +83,30 @@
  *      for pixels that are near the image boundary.
  *    ~ The tiles are labeled by (i, j) = (row, column),
  *      and in this example there is one row and nx columns.
+ *
+ *   The same loop can be run on several threads by pixTilingProcess(),
+ *   which takes the operation on one tile as a function and paints
+ *   its results as they come:
+ *
+ *     static l_int32 SomeTileFunc(PIX *pixt, l_int32 i, l_int32 j,
+ *                                 PIX **ppixd, void *data) {
+ *         ppixd[0] = SomeOperation(pixt, 30, 0, ...);
+ *         return 0;
+ *     }
+ *     ...
+ *     pixTilingProcess(pt, SomeTileFunc, NULL, &pixd, 1, 0);
  * </pre>
  */
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
 #include "allheaders.h"
 
+static l_int32 pixTilingProcessTile(PIXTILING *pt, l_int32 index,
+                                    L_TILE_FUNC func, void *data,
+                                    PIX **pixdarray, l_int32 ndest);
+
 
 /*!
  * \brief   pixTilingCreate()
@@ -420,3 +440,121 @@ l_int32  w, h;
 
     return 0;
 }
+
+
+/*!
+ * \brief   pixTilingProcess()
+ *
+ * \param[in]    pt         pixtiling
+ * \param[in]    func       operation on each tile
+ * \param[in]    data       passed to func; can be null
+ * \param[in]    pixdarray  ndest pix to paint the results in; each can
+ *                          be null, to ignore that result
+ * \param[in]    ndest      number of results of each tile; 0 to
+ *                          L_MAX_TILE_DEST
+ * \param[in]    nthreads   threads to use; 0 for the default
+ * \return  0 if OK, 1 on error or if func fails on a tile
+ *
+ * <pre>
+ * Notes:
+ *      (1) func is called with each tile from pixTilingGetTile(), its
+ *          indices (i, j) and an array of ndest null pix, which it may
+ *          set to new pix; each one set is painted in the pix of
+ *          pixdarray with the same index by pixTilingPaintTile(), and
+ *          destroyed.  It returns 0 if OK.  A tile on which it fails
+ *          is not painted, but the other tiles are processed.
+ *      (2) With OpenMP, the tiles are taken in any order by up to
+ *          nthreads threads; the default is that of OpenMP, as set by
+ *          OMP_NUM_THREADS.  func must then only read pt and data, or
+ *          write to separate parts of data for each tile.  The painting
+ *          is done one tile at a time, as adjacent tiles can share the
+ *          words of the dest.  Without OpenMP, or with nthreads == 1,
+ *          the tiles are processed in order on the calling thread.
+ *      (3) Leptonica error messages can be printed from several threads
+ *          at the same time.
+ * </pre>
+ */
+l_int32
+pixTilingProcess(PIXTILING    *pt,
+                 L_TILE_FUNC   func,
+                 void         *data,
+                 PIX         **pixdarray,
+                 l_int32       ndest,
+                 l_int32       nthreads)
+{
+l_int32  index, ntiles, nfail;
+
+    PROCNAME("pixTilingProcess");
+
+    if (!pt)
+        return ERROR_INT("pt not defined", procName, 1);
+    if (!func)
+        return ERROR_INT("func not defined", procName, 1);
+    if (ndest < 0 || ndest > L_MAX_TILE_DEST)
+        return ERROR_INT("invalid ndest", procName, 1);
+    if (ndest > 0 && !pixdarray)
+        return ERROR_INT("pixdarray not defined", procName, 1);
+
+    ntiles = pt->nx * pt->ny;
+#ifdef _OPENMP
+    if (nthreads <= 0)
+        nthreads = omp_get_max_threads();
+#endif  /* _OPENMP */
+    nthreads = L_MAX(1, L_MIN(nthreads, ntiles));
+    nfail = 0;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) if (nthreads > 1) \
+            schedule(dynamic) reduction(+:nfail)
+#endif  /* _OPENMP */
+    for (index = 0; index < ntiles; index++)
+        nfail += pixTilingProcessTile(pt, index, func, data, pixdarray, ndest);
+
+    if (nfail > 0)
+        return ERROR_INT("operation failed on some tiles", procName, 1);
+    return 0;
+}
+
+
+/*!
+ * \brief   pixTilingProcessTile()
+ *
+ * \param[in]    pt, func, data, pixdarray, ndest  see pixTilingProcess()
+ * \param[in]    index      of the tile, in raster order
+ * \return  0 if OK, 1 on error
+ */
+static l_int32
+pixTilingProcessTile(PIXTILING    *pt,
+                     l_int32       index,
+                     L_TILE_FUNC   func,
+                     void         *data,
+                     PIX         **pixdarray,
+                     l_int32       ndest)
+{
+l_int32  i, j, k, ret;
+PIX     *pixt;
+PIX     *tiled[L_MAX_TILE_DEST];
+
+    PROCNAME("pixTilingProcessTile");
+
+    i = index / pt->nx;
+    j = index % pt->nx;
+    if ((pixt = pixTilingGetTile(pt, i, j)) == NULL)
+        return ERROR_INT("tile not made", procName, 1);
+    for (k = 0; k < L_MAX_TILE_DEST; k++)
+        tiled[k] = NULL;
+    ret = func(pixt, i, j, tiled, data);
+    pixDestroy(&pixt);
+
+#ifdef _OPENMP
+#pragma omp critical (pixtiling_paint)
+#endif  /* _OPENMP */
+    {
+        for (k = 0; k < ndest; k++) {
+            if (ret == 0 && tiled[k] && pixdarray[k])
+                pixTilingPaintTile(pixdarray[k], i, j, tiled[k], pt);
+        }
+    }
+    for (k = 0; k < L_MAX_TILE_DEST; k++)
+        pixDestroy(&tiled[k]);
+    return (ret == 0) ? 0 : 1;
+}
@@ -117,6 +117,13 @@ l_int32 pixSetZlibCompression(PIX *pix, l_int32 compval)
 
 /* ----------------------------------------------------------------------*/
 
+l_int32 pixSetZlibFastEncode(PIX *pix)
+{
+    return ERROR_INT("function not present", "pixSetZlibFastEncode", 1);
+}
+
+/* ----------------------------------------------------------------------*/
+
 void l_pngSetReadStrip16To8(l_int32 flag)
 {
     L_ERROR("function not present\n", "l_pngSetReadStrip16To8");
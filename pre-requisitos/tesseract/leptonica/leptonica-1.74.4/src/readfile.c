@@ -35,6 +35,13 @@
  *           PIX       *pixReadWithHint()
  *           PIX       *pixReadIndexed()
  *           PIX       *pixReadStream()
+ *           PIX       *pixReadMapped()
+ *
+ *      Reading with jpeg reduction
+ *           PIX       *pixReadReduced()
+ *           PIX       *pixReadStreamReduced()
+ *           PIX       *pixReadMemReduced()
+ *           static l_int32  jpegSelectReduction()
  *
  *      Read header information from file
  *           l_int32    pixReadHeader()
@@ -99,6 +106,8 @@ static const unsigned char JP2K_IMAGE_DATA[12] = { 0x00, 0x00, 0x00, 0x0C,
                                                    0x6A, 0x50, 0x20, 0x20,
                                                    0x0D, 0x0A, 0x87, 0x0A };
 
+static l_int32 jpegSelectReduction(FILE *fp, l_int32 minres, l_int32 minsize);
+
 
 /*---------------------------------------------------------------------*
  *          Top-level functions for reading images from file           *
@@ -405,6 +414,230 @@ PIX      *pix;
 }
 
 
+/*!
+ * \brief   pixReadMapped()
+ *
+ * \param[in]    filename with full pathname or in local directory
+ * \return  pix if OK; NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This maps the file into memory with l_binaryMap() and decodes
+ *          it with pixReadMem().  The format is found from the mapped
+ *          bytes, so the file is opened once and never copied through
+ *          a stream; this helps with large page images, in particular
+ *          in a ram disk.
+ *      (2) As with pixReadMem(), a jpeg comment is not read, and the
+ *          input format of a 1 bpp tiff is recorded as IFF_TIFF_G4.
+ *          Use pixRead() if you need those.
+ * </pre>
+ */
+PIX *
+pixReadMapped(const char  *filename)
+{
+size_t    size;
+l_uint8  *data;
+PIX      *pix;
+
+    PROCNAME("pixReadMapped");
+
+    if (!filename)
+        return (PIX *)ERROR_PTR("filename not defined", procName, NULL);
+
+    if ((data = l_binaryMap(filename, &size)) == NULL) {
+        L_ERROR("image file not mapped: %s\n", procName, filename);
+        return NULL;
+    }
+    pix = pixReadMem(data, size);
+    l_binaryUnmap(data, size);
+    if (!pix)
+        return (PIX *)ERROR_PTR("pix not read", procName, NULL);
+    return pix;
+}
+
+
+/*---------------------------------------------------------------------*
+ *                     Reading with jpeg reduction                     *
+ *---------------------------------------------------------------------*/
+/*!
+ * \brief   pixReadReduced()
+ *
+ * \param[in]    filename with full pathname or in local directory
+ * \param[in]    minres smallest acceptable resolution, in ppi; 0 for none
+ * \param[in]    minsize smallest acceptable width and height; 0 for none
+ * \return  pix if OK; NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) See pixReadStreamReduced().
+ * </pre>
+ */
+PIX *
+pixReadReduced(const char  *filename,
+               l_int32      minres,
+               l_int32      minsize)
+{
+FILE  *fp;
+PIX   *pix;
+
+    PROCNAME("pixReadReduced");
+
+    if (!filename)
+        return (PIX *)ERROR_PTR("filename not defined", procName, NULL);
+
+    if ((fp = fopenReadStream(filename)) == NULL) {
+        L_ERROR("image file not found: %s\n", procName, filename);
+        return NULL;
+    }
+    pix = pixReadStreamReduced(fp, minres, minsize);
+    fclose(fp);
+    if (!pix)
+        return (PIX *)ERROR_PTR("pix not read", procName, NULL);
+    return pix;
+}
+
+
+/*!
+ * \brief   pixReadStreamReduced()
+ *
+ * \param[in]    fp file stream
+ * \param[in]    minres smallest acceptable resolution, in ppi; 0 for none
+ * \param[in]    minsize smallest acceptable width and height; 0 for none
+ * \return  pix if OK; NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) Jpeg images are decoded with the largest reduction, of 2, 4
+ *          or 8, that keeps both resolutions at least %minres and both
+ *          dimensions at least %minsize.  The reduction is done by
+ *          libjpeg in the DCT domain, so that the time and memory of
+ *          the decoding drop with the area of the result.
+ *      (2) A jpeg without a resolution is only reduced for %minsize.
+ *          The resolution of a reduced pix is divided by the reduction.
+ *      (3) Other formats are read at full size, as with pixReadStream(),
+ *          and so is every format if both %minres and %minsize are 0.
+ * </pre>
+ */
+PIX *
+pixReadStreamReduced(FILE    *fp,
+                     l_int32  minres,
+                     l_int32  minsize)
+{
+l_int32   format, reduction, ret;
+l_uint8  *comment;
+PIX      *pix;
+
+    PROCNAME("pixReadStreamReduced");
+
+    if (!fp)
+        return (PIX *)ERROR_PTR("stream not defined", procName, NULL);
+
+    findFileFormatStream(fp, &format);
+    if (format != IFF_JFIF_JPEG || (minres <= 0 && minsize <= 0))
+        return pixReadStream(fp, 0);
+
+    reduction = jpegSelectReduction(fp, minres, minsize);
+    if ((pix = pixReadStreamJpeg(fp, 0, reduction, NULL, 0)) == NULL)
+        return (PIX *)ERROR_PTR( "jpeg: no pix returned", procName, NULL);
+    ret = fgetJpegComment(fp, &comment);
+    if (!ret && comment)
+        pixSetText(pix, (char *)comment);
+    LEPT_FREE(comment);
+    pixSetInputFormat(pix, format);
+    return pix;
+}
+
+
+/*!
+ * \brief   pixReadMemReduced()
+ *
+ * \param[in]    data const; encoded
+ * \param[in]    size size of data
+ * \param[in]    minres smallest acceptable resolution, in ppi; 0 for none
+ * \param[in]    minsize smallest acceptable width and height; 0 for none
+ * \return  pix, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is a variation of pixReadStreamReduced(), where the data
+ *          is read from a memory buffer rather than a file.  Formats
+ *          other than jpeg are read with pixReadMem().
+ * </pre>
+ */
+PIX *
+pixReadMemReduced(const l_uint8  *data,
+                  size_t          size,
+                  l_int32         minres,
+                  l_int32         minsize)
+{
+l_int32  format;
+FILE    *fp;
+PIX     *pix;
+
+    PROCNAME("pixReadMemReduced");
+
+    if (!data)
+        return (PIX *)ERROR_PTR("data not defined", procName, NULL);
+    if (size < 12)
+        return (PIX *)ERROR_PTR("size < 12", procName, NULL);
+
+    findFileFormatBuffer(data, &format);
+    if (format != IFF_JFIF_JPEG || (minres <= 0 && minsize <= 0))
+        return pixReadMem(data, size);
+
+    if ((fp = fopenReadFromMemory(data, size)) == NULL)
+        return (PIX *)ERROR_PTR("stream not opened", procName, NULL);
+    pix = pixReadStreamReduced(fp, minres, minsize);
+    fclose(fp);
+    if (!pix)
+        return (PIX *)ERROR_PTR("pix not read", procName, NULL);
+    return pix;
+}
+
+
+/*!
+ * \brief   jpegSelectReduction()
+ *
+ * \param[in]    fp file stream of a jpeg image
+ * \param[in]    minres smallest acceptable resolution, in ppi; 0 for none
+ * \param[in]    minsize smallest acceptable width and height; 0 for none
+ * \return  reduction 1, 2, 4 or 8
+ *
+ * <pre>
+ * Notes:
+ *      (1) Side-effect: this rewinds the stream.
+ *      (2) A header that can't be read gives no reduction, leaving the
+ *          error to the decoder.
+ * </pre>
+ */
+static l_int32
+jpegSelectReduction(FILE    *fp,
+                    l_int32  minres,
+                    l_int32  minsize)
+{
+l_int32  w, h, xres, yres, reduction;
+
+    if (freadHeaderJpeg(fp, &w, &h, NULL, NULL, NULL))
+        return 1;
+    xres = yres = 0;
+    if (minres > 0 && (fgetJpegResolution(fp, &xres, &yres) ||
+                       xres <= 0 || yres <= 0))
+        return 1;  /* unknown resolution */
+
+    for (reduction = 8; reduction > 1; reduction /= 2) {
+        if (minres > 0 &&
+            (xres / reduction < minres || yres / reduction < minres))
+            continue;
+        if (minsize > 0 &&
+            (w / reduction < minsize || h / reduction < minsize))
+            continue;
+        break;
+    }
+    rewind(fp);
+    return reduction;
+}
+
+
 
 /*---------------------------------------------------------------------*
  *                     Read header information from file               *
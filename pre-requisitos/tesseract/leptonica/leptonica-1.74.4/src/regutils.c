@@ -40,9 +40,11 @@
  *           l_int32    regTestCompareFiles()
  *           l_int32    regTestWritePixAndCheck()
  *           char      *regTestGenLocalFilename()
+ *           l_int32    regTestTimeLoop()
  *
- *       Static function
+ *       Static functions
  *           char      *getRootNameFromArgv0()
+ *           l_int32    regTestWriteTimings()
  *
  *  See regutils.h for how to use this.  Here is a minimal setup:
  *
@@ -67,6 +69,10 @@ extern l_int32 NumImageFileFormatExtensions;
 extern const char *ImageFileFormatExtensions[];
 
 static char *getRootNameFromArgv0(const char *argv0);
+static l_int32 regTestWriteTimings(L_REGPARAMS *rp);
+
+    /* Default number of runs of each timed operation in 'time' mode */
+static const l_int32  DEFAULT_TIME_REPEATS = 10;
 
 /*--------------------------------------------------------------------*
  *                      Regression test utilities                     *
@@ -74,9 +80,9 @@ static char *getRootNameFromArgv0(const char *argv0);
 /*!
  * \brief   regTestSetup()
  *
- * \param[in]    argc from invocation; can be either 1 or 2
+ * \param[in]    argc from invocation; can be 1, 2, or 3 for "time"
  * \param[in]    argv to regtest: %argv[1] is one of these:
- *                    "generate", "compare", "display"
+ *                    "generate", "compare", "display", "time"
  * \param[out]   prp all regression params
  * \return  0 if OK, 1 on error
  *
@@ -106,6 +112,13 @@ static char *getRootNameFromArgv0(const char *argv0);
  *              or failure is with tests that do not involve golden files.
  *              The display field in rp is TRUE, and this is used by
  *              pixDisplayWithTitle().
+ *          Case 4:
+ *              The second arg is "time", optionally followed by the
+ *              number of runs of each timed operation.  The test runs
+ *              as for "display", but without display, and the operations
+ *              timed with regTestTimeLoop() are repeated and recorded.
+ *              The timings are written as json to the file
+ *              "/tmp/lept/regout/<testname>_time.json".
  *      (2) See regutils.h for examples of usage.
  * </pre>
  */
@@ -120,9 +133,10 @@ L_REGPARAMS  *rp;
 
     PROCNAME("regTestSetup");
 
-    if (argc != 1 && argc != 2) {
+    if (argc < 1 || argc > 3 || (argc == 3 && strcmp(argv[1], "time"))) {
         snprintf(errormsg, sizeof(errormsg),
-            "Syntax: %s [ [compare] | generate | display ]", argv[0]);
+            "Syntax: %s [ [compare] | generate | display | time [n] ]",
+            argv[0]);
         return ERROR_INT(errormsg, procName, 1);
     }
 
@@ -136,6 +150,7 @@ L_REGPARAMS  *rp;
     *prp = rp;
     rp->testname = testname;
     rp->index = -1;  /* increment before each test */
+    rp->nrepeat = 1;
 
         /* Initialize to true.  A failure in any test is registered
          * as a failure of the regression test. */
@@ -159,10 +174,19 @@ L_REGPARAMS  *rp;
     } else if (!strcmp(argv[1], "display")) {
         rp->mode = L_REG_DISPLAY;
         rp->display = TRUE;
+    } else if (!strcmp(argv[1], "time")) {
+        rp->mode = L_REG_TIME;
+        rp->nrepeat = (argc == 3) ? atoi(argv[2]) : DEFAULT_TIME_REPEATS;
+        if (rp->nrepeat < 1) {
+            LEPT_FREE(rp);
+            return ERROR_INT("number of runs must be positive", procName, 1);
+        }
+        rp->timings = sarrayCreate(0);
     } else {
         LEPT_FREE(rp);
         snprintf(errormsg, sizeof(errormsg),
-            "Syntax: %s [ [generate] | compare | display ]", argv[0]);
+            "Syntax: %s [ [generate] | compare | display | time [n] ]",
+            argv[0]);
         return ERROR_INT(errormsg, procName, 1);
     }
 
@@ -192,6 +216,7 @@ L_REGPARAMS  *rp;
  * Notes:
  *      (1) This copies anything written to the temporary file to the
  *          output file /tmp/lept/reg_results.txt.
+ *      (2) In 'time' mode, this writes the recorded timings.
  * </pre>
  */
 l_int32
@@ -211,6 +236,13 @@ size_t   nbytes;
     fprintf(stderr, "Time: %7.3f sec\n", stopTimerNested(rp->tstart));
     fprintf(stderr, "################################################\n");
 
+        /* In time mode, write out the timings */
+    if (rp->mode == L_REG_TIME)
+        regTestWriteTimings(rp);
+    LEPT_FREE(rp->tname);
+    LEPT_FREE(rp->timer);
+    sarrayDestroy(&rp->timings);
+
         /* If generating golden files or running in display mode, release rp */
     if (!rp->fp) {
         LEPT_FREE(rp->testname);
@@ -481,7 +513,8 @@ l_int32  w, h, factor, similar;
  *      (1) This function does one of three things, depending on the mode:
  *           * "generate": makes a "golden" file as a copy %localname.
  *           * "compare": compares %localname contents with the golden file
- *           * "display": makes the %localname file but does no comparison
+ *           * "display" or "time": makes the %localname file but does
+ *             no comparison
  *      (2) The canonical format of the golden filenames is:
  *            /tmp/lept/golden/<root of main name>_golden.<index>.
  *                                                       <ext of localname>
@@ -509,14 +542,14 @@ PIX     *pix1, *pix2;
         return ERROR_INT("local name not defined", procName, 1);
     }
     if (rp->mode != L_REG_GENERATE && rp->mode != L_REG_COMPARE &&
-        rp->mode != L_REG_DISPLAY) {
+        rp->mode != L_REG_DISPLAY && rp->mode != L_REG_TIME) {
         rp->success = FALSE;
         return ERROR_INT("invalid mode", procName, 1);
     }
     rp->index++;
 
-        /* If display mode, no generation and no testing */
-    if (rp->mode == L_REG_DISPLAY) return 0;
+        /* If display or time mode, no generation and no testing */
+    if (rp->mode == L_REG_DISPLAY || rp->mode == L_REG_TIME) return 0;
 
         /* Generate the golden file name; used in 'generate' and 'compare' */
     splitPathAtExtension(localname, NULL, &ext);
@@ -761,6 +794,140 @@ l_int32  ind;
 }
 
 
+/*!
+ * \brief   regTestTimeLoop()
+ *
+ * \param[in]    rp       regtest parameters
+ * \param[in]    opname   name of the timed operation
+ * \param[in]    pixs     [optional] input image, for the throughput
+ * \return  1 to run the operation again, 0 when done or on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the condition of a while loop whose body is the
+ *          operation to be timed:
+ *              while (regTestTimeLoop(rp, "pixScale 0.5", pixs)) {
+ *                  pixDestroy(&pixd);
+ *                  pixd = pixScale(pixs, 0.5, 0.5);
+ *              }
+ *          The body must free the result of the previous run, because
+ *          it is run more than once in 'time' mode.
+ *      (2) Except in 'time' mode, the body is run once and nothing is
+ *          recorded.  In 'time' mode, it is run rp->nrepeat times, and
+ *          the mean wall time of a run is recorded with %opname and with
+ *          the index of the next check, which typically tests the result.
+ *          If %pixs is given, its size is used for the throughput in
+ *          megapixels/sec.
+ *      (3) Timed loops cannot be nested.  %opname should not contain
+ *          double quotes; they are replaced by single quotes in the
+ *          json output.
+ * </pre>
+ */
+l_int32
+regTestTimeLoop(L_REGPARAMS  *rp,
+                const char   *opname,
+                PIX          *pixs)
+{
+char       buf[512];
+char      *name;
+l_int32    i;
+l_float32  sec, rate;
+
+    PROCNAME("regTestTimeLoop");
+
+    if (!rp)
+        return ERROR_INT("rp not defined", procName, 0);
+    if (!opname) {
+        rp->success = FALSE;
+        return ERROR_INT("opname not defined", procName, 0);
+    }
+
+        /* Single run, unless timing */
+    if (rp->mode != L_REG_TIME) {
+        rp->tcount = 1 - rp->tcount;
+        return rp->tcount;
+    }
+
+    if (rp->tcount == 0) {  /* start the runs */
+        LEPT_FREE(rp->tname);
+        rp->tname = stringNew(opname);
+        rp->tmpix = 0.0;
+        if (pixs)
+            rp->tmpix = (l_float32)pixGetWidth(pixs) * pixGetHeight(pixs) /
+                        1000000.;
+        rp->tcount = 1;
+        rp->timer = startWallTimer();
+        return 1;
+    }
+    if (rp->tcount < rp->nrepeat) {
+        rp->tcount++;
+        return 1;
+    }
+
+        /* Done; record the mean time of a run */
+    sec = stopWallTimer(&rp->timer) / rp->nrepeat;
+    rate = (sec > 0.0) ? rp->tmpix / sec : 0.0;
+    name = rp->tname;
+    for (i = 0; name[i] != '\0'; i++) {
+        if (name[i] == '"') name[i] = '\'';
+    }
+    snprintf(buf, sizeof(buf),
+             "    {\"index\": %d, \"operation\": \"%s\", "
+             "\"seconds\": %.6f, \"megapixels\": %.4f, "
+             "\"mpix_per_sec\": %.3f}",
+             rp->index + 1, name, sec, rp->tmpix, rate);
+    sarrayAddString(rp->timings, buf, L_COPY);
+    fprintf(stderr, "Time %s_reg %d: %s: %.3f ms, %.2f Mpix/sec\n",
+            rp->testname, rp->index + 1, name, 1000. * sec, rate);
+    rp->tcount = 0;
+    return 0;
+}
+
+
+/*!
+ * \brief   regTestWriteTimings()
+ *
+ * \param[in]    rp       regtest parameters
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This writes the timings recorded by regTestTimeLoop() as json
+ *          to /tmp/lept/regout/<testname>_time.json.
+ * </pre>
+ */
+static l_int32
+regTestWriteTimings(L_REGPARAMS  *rp)
+{
+char     buf[256];
+char    *vers;
+l_int32  i, n;
+FILE    *fp;
+
+    PROCNAME("regTestWriteTimings");
+
+    snprintf(buf, sizeof(buf), "/tmp/lept/regout/%s_time.json",
+             rp->testname);
+    if ((fp = fopenWriteStream(buf, "w")) == NULL)
+        return ERROR_INT("stream not opened for timings", procName, 1);
+
+    vers = getLeptonicaVersion();
+    fprintf(fp, "{\n  \"test\": \"%s\",\n  \"version\": \"%s\",\n"
+            "  \"repeats\": %d,\n  \"timings\": [\n",
+            rp->testname, vers, rp->nrepeat);
+    LEPT_FREE(vers);
+    n = sarrayGetCount(rp->timings);
+    for (i = 0; i < n; i++) {
+        fprintf(fp, "%s%s\n", sarrayGetString(rp->timings, i, L_NOCOPY),
+                (i < n - 1) ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    fclose(fp);
+    fprintf(stderr, "Timings written to %s\n", buf);
+    return 0;
+}
+
+
 /*!
  * \brief   getRootNameFromArgv0()
  *
@@ -58,6 +58,12 @@
  *           control of the display variable.  Display is enabled only
  *           for this case.
  *
+ *       Case 4: distance_reg time [nrepeat]
+ *           This runs the test like 'display', but without display, and
+ *           repeats each timed operation %nrepeat times (default 10).
+ *           The wall time and throughput of each timed operation are
+ *           written to /tmp/lept/regout/distance_time.json.
+ *
  *   Regression tests follow the pattern given below.  Tests are
  *   automatically numbered sequentially, and it is convenient to
  *   comment each with a number to keep track (for comparison tests
@@ -101,6 +107,16 @@
  *       regTestWritePixAndCheck(rp, pix1, IFF_PNG);  // 5
  *       regTestWritePixAndCheck(rp, pix2, IFF_JFIF_JPEG);  // 6
  *
+ *       // Timing an operation.  The body runs once, except in 'time'
+ *       // mode where it runs %nrepeat times; the megapixels of pix1 give
+ *       // the throughput.  The body must free the result of the
+ *       // previous pass.
+ *       while (regTestTimeLoop(rp, "pixScale 0.5", pix1)) {
+ *           pixDestroy(&pix3);
+ *           pix3 = pixScale(pix1, 0.5, 0.5);
+ *       }
+ *       regTestWritePixAndCheck(rp, pix3, IFF_PNG);  // 7
+ *
  *       // Display if reg test was called in 'display' mode
  *       pixDisplayWithTitle(pix1, 100, 100, NULL, rp->display);
  *
@@ -119,11 +135,17 @@ struct L_RegParams
     FILE    *fp;        /*!< stream to temporary output file for compare mode */
     char    *testname;  /*!< name of test, without '_reg'                     */
     char    *tempfile;  /*!< name of temp file for compare mode output        */
-    l_int32  mode;      /*!< generate, compare or display                     */
+    l_int32  mode;      /*!< generate, compare, display or time               */
     l_int32  index;     /*!< index into saved files for this test; 0-based    */
     l_int32  success;   /*!< overall result of the test                       */
     l_int32  display;   /*!< 1 if in display mode; 0 otherwise                */
     L_TIMER  tstart;    /*!< marks beginning of the reg test                  */
+    l_int32  nrepeat;   /*!< runs of each timed operation                     */
+    l_int32  tcount;    /*!< runs so far of the current timed operation       */
+    char    *tname;     /*!< name of the current timed operation              */
+    l_float32     tmpix;   /*!< megapixels input to the timed operation       */
+    L_WALLTIMER  *timer;   /*!< wall timer for the timed operation            */
+    SARRAY  *timings;   /*!< json record of each timed operation              */
 };
 typedef struct L_RegParams  L_REGPARAMS;
 
@@ -132,7 +154,8 @@ typedef struct L_RegParams  L_REGPARAMS;
 enum {
     L_REG_GENERATE = 0,
     L_REG_COMPARE = 1,
-    L_REG_DISPLAY = 2
+    L_REG_DISPLAY = 2,
+    L_REG_TIME = 3
 };
 
 
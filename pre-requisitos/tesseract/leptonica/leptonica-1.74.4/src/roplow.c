@@ -38,6 +38,7 @@
  *           static void     rasteropWordAlignedLow()
  *           static void     rasteropVAlignedLow()
  *           static void     rasteropGeneralLow()
+ *           static l_int32  rasteropFullWordsLow()
  *
  * </pre>
  */
@@ -73,6 +74,11 @@ static void rasteropGeneralLow(l_uint32 *datad, l_int32 dwpl, l_int32 dx,
                                l_int32 op, l_uint32 *datas, l_int32 swpl,
                                l_int32 sx, l_int32 sy);
 
+static l_int32 rasteropFullWordsLow(l_uint32 *pdfwfull, l_int32 dwpl,
+                                    l_uint32 *psfwfull, l_int32 swpl,
+                                    l_int32 dnfullw, l_int32 dh, l_int32 op,
+                                    l_int32 shift);
+
 
 static const l_uint32 lmask32[] = {0x0,
     0x80000000, 0xc0000000, 0xe0000000, 0xf0000000,
@@ -616,6 +622,7 @@ l_uint32  *pdfword;    /* ptr to first dest word */
 l_int32    lwbits;     /* number of ovrhang bits in last partial word */
 l_uint32   lwmask;     /* mask for last partial word */
 l_uint32  *lines, *lined;
+l_int32    nvec;       /* number of full words done by vector ops */
 l_int32    i, j;
 
 
@@ -629,6 +636,15 @@ l_int32    i, j;
     psfword = datas + swpl * sy + (sx >> 5);
     pdfword = datad + dwpl * dy + (dx >> 5);
 
+        /* vector ops do the leading full words, where they can */
+    if (nfullw > 0) {
+        nvec = rasteropFullWordsLow(pdfword, dwpl, psfword, swpl,
+                                    nfullw, dh, op, 0);
+        pdfword += nvec;
+        psfword += nvec;
+        nfullw -= nvec;
+    }
+
     /*--------------------------------------------------------*
      *            Now we're ready to do the ops               *
      *--------------------------------------------------------*/
@@ -851,6 +867,7 @@ l_uint32   dlwmask;    /* mask for last partial dest word */
 l_int32    dlwbits;    /* last word dest bits in ovrhang */
 l_uint32  *pdlwpart;   /* ptr to last partial dest word */
 l_uint32  *pslwpart;   /* ptr to last partial src word */
+l_int32    nvec;       /* number of full words done by vector ops */
 l_int32    i, j;
 
 
@@ -913,6 +930,17 @@ l_int32    i, j;
         }
     }
 
+        /* vector ops do the leading full words, where they can */
+    if (dfwfullb) {
+        nvec = rasteropFullWordsLow(pdfwfull, dwpl, psfwfull, swpl,
+                                    dnfullw, dh, op, 0);
+        pdfwfull += nvec;
+        psfwfull += nvec;
+        dnfullw -= nvec;
+        if (dnfullw == 0)
+            dfwfullb = 0;
+    }
+
 
     /*--------------------------------------------------------*
      *            Now we're ready to do the ops               *
@@ -1388,6 +1416,7 @@ l_int32    srightmask;  /* mask for selecting sleftshift bits that have      */
 l_int32    sfwshiftdir; /* either SHIFT_LEFT or SHIFT_RIGHT                  */
 l_int32    sfwaddb;     /* boolean: do we need an additional sfw right shift? */
 l_int32    slwaddb;     /* boolean: do we need an additional slw right shift? */
+l_int32    nvec;        /* number of full words done by vector ops           */
 l_int32    i, j;
 
 
@@ -1485,6 +1514,17 @@ l_int32    i, j;
             slwaddb = 1;   /* must rshift in next src word by srightshift */
     }
 
+        /* vector ops do the leading full words, where they can */
+    if (dfwfullb) {
+        nvec = rasteropFullWordsLow(pdfwfull, dwpl, psfwfull, swpl,
+                                    dnfullw, dh, op, sleftshift);
+        pdfwfull += nvec;
+        psfwfull += nvec;
+        dnfullw -= nvec;
+        if (dnfullw == 0)
+            dfwfullb = 0;
+    }
+
 
     /*--------------------------------------------------------*
      *            Now we're ready to do the ops               *
@@ -2118,3 +2158,43 @@ l_int32    i, j;
 
     return;
 }
+
+
+/*--------------------------------------------------------------------*
+ *               Static low-level rasterop of full words              *
+ *--------------------------------------------------------------------*/
+/*!
+ * \brief   rasteropFullWordsLow()
+ *
+ * \param[in]    pdfwfull  ptr to first full dest word
+ * \param[in]    dwpl      wpl of dest
+ * \param[in]    psfwfull  ptr to first full src word
+ * \param[in]    swpl      wpl of src
+ * \param[in]    dnfullw   number of full dest words on each line
+ * \param[in]    dh        height of dest rectangle
+ * \param[in]    op        op code
+ * \param[in]    shift     left shift of the src words; 0 if aligned
+ * \return  number of leading full words done on each line
+ *
+ *  The blitters above call this before their own full word loops,
+ *  which then start past the words done here; see rasteropWordsSimd().
+ *  Nothing is done when the src and dest rectangles share memory,
+ *  because the vector ops would then not see the words in the order
+ *  the scalar loops do.
+ */
+static l_int32
+rasteropFullWordsLow(l_uint32  *pdfwfull,
+                     l_int32    dwpl,
+                     l_uint32  *psfwfull,
+                     l_int32    swpl,
+                     l_int32    dnfullw,
+                     l_int32    dh,
+                     l_int32    op,
+                     l_int32    shift)
+{
+    if (pdfwfull < psfwfull + (dh - 1) * swpl + dnfullw + 1 &&
+        psfwfull < pdfwfull + (dh - 1) * dwpl + dnfullw)
+        return 0;
+    return rasteropWordsSimd(pdfwfull, dwpl, psfwfull, swpl, dnfullw, dh,
+                             op, shift);
+}
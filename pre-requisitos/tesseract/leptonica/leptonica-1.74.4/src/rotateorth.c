@@ -36,6 +36,9 @@
  *
  *      90-degree rotation (both directions)
  *            PIX             *pixRotate90()
+ *            static void      transposeTiled()
+ *            static void      transposeTiled1()
+ *            static l_uint64  transposeBits8()
  *
  *      Left-right flip
  *            PIX             *pixFlipLR()
@@ -53,10 +56,20 @@
 #include <string.h>
 #include "allheaders.h"
 
+static void transposeTiled(l_uint32 *datad, l_int32 wpld, l_uint32 *datas,
+                           l_int32 wpls, l_int32 w, l_int32 h, l_int32 d);
+static void transposeTiled1(l_uint32 *datad, l_int32 wpld, l_uint32 *datas,
+                            l_int32 wpls, l_int32 w, l_int32 h);
+static l_uint64 transposeBits8(l_uint64 x);
 static l_uint8 *makeReverseByteTab1(void);
 static l_uint8 *makeReverseByteTab2(void);
 static l_uint8 *makeReverseByteTab4(void);
 
+    /* Sides of the square tiles in which 90 degree rotations are made,
+     * in pixels.  A tile of src and one of dest fit in the L1 cache. */
+static const l_int32  RotateTileSize = 64;
+static const l_int32  RotateTileSize1 = 256;  /* for 1 bpp */
+
 
 /*------------------------------------------------------------------*
  *           Top-level rotation by multiples of 90 degrees          *
@@ -157,6 +170,13 @@ l_int32  d;
  *      (1) This does a 90 degree rotation of the image about the center,
  *          either cw or ccw, returning a new pix.
  *      (2) The direction must be either 1 (cw) or -1 (ccw).
+ *      (3) Rotating is transposing with the src lines taken from the
+ *          bottom up (cw) or with the dest lines stored from the bottom
+ *          up (ccw).  For 1, 8 and 32 bpp the transpose is made in
+ *          square tiles, so that neither image is walked down a
+ *          column across the whole page; 1 bpp transposes 8x8 bit
+ *          blocks at a time and skips those that are all 0, and 8 and
+ *          32 bpp use transposeTileSimd() when it is available.
  * </pre>
  */
 PIX *
@@ -164,8 +184,8 @@ pixRotate90(PIX     *pixs,
             l_int32  direction)
 {
 l_int32    wd, hd, d, wpls, wpld;
-l_int32    i, j, k, m, iend, nswords;
-l_uint32   val, word;
+l_int32    i, j;
+l_uint32   val;
 l_uint32  *lines, *datas, *lined, *datad;
 PIX       *pixd;
 
@@ -191,19 +211,19 @@ PIX       *pixd;
     datad = pixGetData(pixd);
     wpld = pixGetWpl(pixd);
 
+    if (d == 1 || d == 8 || d == 32) {
+        if (direction == 1)
+            transposeTiled(datad, wpld, datas + (wd - 1) * wpls, -wpls,
+                           hd, wd, d);
+        else
+            transposeTiled(datad + (hd - 1) * wpld, -wpld, datas, wpls,
+                           hd, wd, d);
+        return pixd;
+    }
+
     if (direction == 1) {  /* clockwise */
         switch (d)
         {
-            case 32:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas + (wd - 1) * wpls;
-                    for (j = 0; j < wd; j++) {
-                        lined[j] = lines[i];
-                        lines -= wpls;
-                    }
-                }
-                break;
             case 16:
                 for (i = 0; i < hd; i++) {
                     lined = datad + i * wpld;
@@ -215,17 +235,6 @@ PIX       *pixd;
                     }
                 }
                 break;
-            case 8:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas + (wd - 1) * wpls;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_BYTE(lines, i)))
-                            SET_DATA_BYTE(lined, j, val);
-                        lines -= wpls;
-                    }
-                }
-                break;
             case 4:
                 for (i = 0; i < hd; i++) {
                     lined = datad + i * wpld;
@@ -248,32 +257,6 @@ PIX       *pixd;
                     }
                 }
                 break;
-            case 1:
-                nswords = hd / 32;
-                for (j = 0; j < wd; j++) {
-                    lined = datad;
-                    lines = datas + (wd - 1 - j) * wpls;
-                    for (k = 0; k < nswords; k++) {
-                        word = lines[k];
-                        if (!word) {
-                            lined += 32 * wpld;
-                            continue;
-                        } else {
-                            iend = 32 * (k + 1);
-                            for (m = 0, i = 32 * k; i < iend; i++, m++) {
-                                if ((word << m) & 0x80000000)
-                                    SET_DATA_BIT(lined, j);
-                                lined += wpld;
-                            }
-                        }
-                    }
-                    for (i = 32 * nswords; i < hd; i++) {
-                        if (GET_DATA_BIT(lines, i))
-                            SET_DATA_BIT(lined, j);
-                        lined += wpld;
-                    }
-                }
-                break;
             default:
                 pixDestroy(&pixd);
                 L_ERROR("illegal depth: %d\n", procName, d);
@@ -282,16 +265,6 @@ PIX       *pixd;
     } else  {     /* direction counter-clockwise */
         switch (d)
         {
-            case 32:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas;
-                    for (j = 0; j < wd; j++) {
-                        lined[j] = lines[hd - 1 - i];
-                        lines += wpls;
-                    }
-                }
-                break;
             case 16:
                 for (i = 0; i < hd; i++) {
                     lined = datad + i * wpld;
@@ -303,17 +276,6 @@ PIX       *pixd;
                     }
                 }
                 break;
-            case 8:
-                for (i = 0; i < hd; i++) {
-                    lined = datad + i * wpld;
-                    lines = datas;
-                    for (j = 0; j < wd; j++) {
-                        if ((val = GET_DATA_BYTE(lines, hd - 1 - i)))
-                            SET_DATA_BYTE(lined, j, val);
-                        lines += wpls;
-                    }
-                }
-                break;
             case 4:
                 for (i = 0; i < hd; i++) {
                     lined = datad + i * wpld;
@@ -336,32 +298,6 @@ PIX       *pixd;
                     }
                 }
                 break;
-            case 1:
-                nswords = hd / 32;
-                for (j = 0; j < wd; j++) {
-                    lined = datad + (hd - 1) * wpld;
-                    lines = datas + (wd - 1 - j) * wpls;
-                    for (k = 0; k < nswords; k++) {
-                        word = lines[k];
-                        if (!word) {
-                            lined -= 32 * wpld;
-                            continue;
-                        } else {
-                            iend = 32 * (k + 1);
-                            for (m = 0, i = 32 * k; i < iend; i++, m++) {
-                                if ((word << m) & 0x80000000)
-                                    SET_DATA_BIT(lined, wd - 1 - j);
-                                lined -= wpld;
-                            }
-                        }
-                    }
-                    for (i = 32 * nswords; i < hd; i++) {
-                        if (GET_DATA_BIT(lines, i))
-                            SET_DATA_BIT(lined, wd - 1 - j);
-                        lined -= wpld;
-                    }
-                }
-                break;
             default:
                 pixDestroy(&pixd);
                 L_ERROR("illegal depth: %d\n", procName, d);
@@ -373,6 +309,159 @@ PIX       *pixd;
 }
 
 
+/*!
+ * \brief   transposeTiled()
+ *
+ * \param[in]    datad   dest data; lines of h pixels
+ * \param[in]    wpld    dest words per line; can be negative
+ * \param[in]    datas   src data; lines of w pixels
+ * \param[in]    wpls    src words per line; can be negative
+ * \param[in]    w, h    src width and height
+ * \param[in]    d       depth, 1, 8 or 32 bpp
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) Sets pixel j of dest line i to pixel i of src line j.  The
+ *          dest must be cleared beforehand.
+ *      (2) Whole tiles go to transposeTileSimd(); the partial ones at
+ *          the right and bottom, and all of them when there is no
+ *          SIMD, are done here a pixel at a time.
+ * </pre>
+ */
+static void
+transposeTiled(l_uint32  *datad,
+               l_int32    wpld,
+               l_uint32  *datas,
+               l_int32    wpls,
+               l_int32    w,
+               l_int32    h,
+               l_int32    d)
+{
+l_int32    i, j, x0, y0, tw, th, size;
+l_uint32  *lines, *lined, *tiles, *tiled;
+
+    if (d == 1) {
+        transposeTiled1(datad, wpld, datas, wpls, w, h);
+        return;
+    }
+
+    size = RotateTileSize;
+    for (y0 = 0; y0 < h; y0 += size) {
+        th = L_MIN(size, h - y0);
+        for (x0 = 0; x0 < w; x0 += size) {
+            tw = L_MIN(size, w - x0);
+            tiles = datas + y0 * wpls + x0 * d / 32;
+            tiled = datad + x0 * wpld + y0 * d / 32;
+            if (tw == size && th == size &&
+                transposeTileSimd(tiled, wpld, tiles, wpls, size, d))
+                continue;
+            for (i = 0; i < tw; i++) {
+                lined = tiled + i * wpld;
+                lines = tiles;
+                if (d == 8) {
+                    for (j = 0; j < th; j++, lines += wpls)
+                        SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, i));
+                } else {  /* d == 32 */
+                    for (j = 0; j < th; j++, lines += wpls)
+                        lined[j] = lines[i];
+                }
+            }
+        }
+    }
+}
+
+
+/*!
+ * \brief   transposeTiled1()
+ *
+ * \param[in]    datad   1 bpp dest data, cleared; lines of h pixels
+ * \param[in]    wpld    dest words per line; can be negative
+ * \param[in]    datas   1 bpp src data; lines of w pixels
+ * \param[in]    wpls    src words per line; can be negative
+ * \param[in]    w, h    src width and height
+ * \return  void
+ *
+ * <pre>
+ * Notes:
+ *      (1) The src is read 8 lines by 8 pixels at a time, as the bytes
+ *          of a 64-bit word, which transposeBits8() turns into the 8
+ *          bytes of 8 dest lines.  Blocks that are all 0, as most of a
+ *          text page is, are left as they are in the cleared dest.
+ *      (2) Missing lines of the last band are read as 0, which keeps
+ *          the dest padding clear; pixels past the end of the src
+ *          lines go to dest lines that are not stored.
+ * </pre>
+ */
+static void
+transposeTiled1(l_uint32  *datad,
+                l_int32    wpld,
+                l_uint32  *datas,
+                l_int32    wpls,
+                l_int32    w,
+                l_int32    h)
+{
+l_int32    k, x, y, x0, y0, xend, yend, nlines, npix, size;
+l_uint32   byte;
+l_uint64   block;
+l_uint32  *lines;
+
+    size = RotateTileSize1;
+    for (y0 = 0; y0 < h; y0 += size) {
+        yend = L_MIN(y0 + size, h);
+        for (x0 = 0; x0 < w; x0 += size) {
+            xend = L_MIN(x0 + size, w);
+            for (y = y0; y < yend; y += 8) {
+                nlines = L_MIN(8, h - y);
+                lines = datas + y * wpls;
+                for (x = x0; x < xend; x += 8) {
+                    block = 0;
+                    for (k = 0; k < nlines; k++) {
+                        byte = GET_DATA_BYTE(lines + k * wpls, x >> 3);
+                        block |= (l_uint64)byte << (56 - 8 * k);
+                    }
+                    if (!block)
+                        continue;
+                    block = transposeBits8(block);
+                    npix = L_MIN(8, w - x);
+                    for (k = 0; k < npix; k++)
+                        SET_DATA_BYTE(datad + (x + k) * wpld, y >> 3,
+                                      (block >> (56 - 8 * k)) & 0xff);
+                }
+            }
+        }
+    }
+}
+
+
+/*!
+ * \brief   transposeBits8()
+ *
+ * \param[in]    x   8x8 bit matrix, line 0 in the high byte and
+ *                   column 0 in the high bit of each byte
+ * \return  the transposed matrix
+ *
+ * <pre>
+ * Notes:
+ *      (1) Swaps the 2x2, then 4x4, then 8x8 blocks across the diagonal
+ *          (Hacker's Delight, sec. 7-3).
+ * </pre>
+ */
+static l_uint64
+transposeBits8(l_uint64  x)
+{
+l_uint64  t;
+
+    t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+
 /*------------------------------------------------------------------*
  *                            Left-right flip                       *
  *------------------------------------------------------------------*/
@@ -231,14 +231,16 @@ scaleGrayLILow(l_uint32  *datad,
                l_int32    hs,
                l_int32    wpls)
 {
-l_int32    i, j, wm2, hm2;
-l_int32    xpm, ypm;  /* location in src image, to 1/16 of a pixel */
-l_int32    xp, yp, xf, yf;  /* src pixel and pixel fraction coordinates */
-l_int32    v00, v01, v10, v11, v00_val, v01_val, v10_val, v11_val;
-l_uint8    val;
-l_uint32  *lines, *lined;
+l_int32    i, j, k, wm2, hm2;
+l_int32    xpm, ypm, lastypm;  /* location in src image, to 1/16 of a pixel */
+l_int32    xp, yp, yf;  /* src pixel and pixel fraction coordinates */
+l_int32    val;
+l_int32   *sums, *xtab, *xleft, *xright, *xfrac;
+l_uint32  *lines, *nexts, *lined;
 l_float32  scx, scy;
 
+    PROCNAME("scaleGrayLILow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -248,51 +250,58 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
+        /* The bilinear interpolation is done in two passes: vertically,
+         * over the whole src line, then horizontally, which gives the
+         * same sums as weighting each of the 4 nearest src pixels by
+         * its fractional area.  Near the right side and the bottom,
+         * the missing neighbors are replaced by the nearest pixels.
+         * The src columns of each dest column are the same for all
+         * dest lines, and are found once. */
+    sums = (l_int32 *)LEPT_CALLOC(ws, sizeof(l_int32));
+    xtab = (l_int32 *)LEPT_CALLOC(3 * wd, sizeof(l_int32));
+    if (!sums || !xtab) {
+        LEPT_FREE(sums);
+        LEPT_FREE(xtab);
+        L_ERROR("calloc fail for tables\n", procName);
+        return;
+    }
+    xleft = xtab;
+    xright = xtab + wd;
+    xfrac = xtab + 2 * wd;
+    for (j = 0; j < wd; j++) {
+        xpm = (l_int32)(scx * (l_float32)j);
+        xp = xpm >> 4;
+        xleft[j] = xp;
+        xright[j] = (xp > wm2) ? xp : xp + 1;
+        xfrac[j] = xpm & 0x0f;
+    }
+
         /* Iterate over the destination pixels */
-    for (i = 0; i < hd; i++) {
+    for (i = 0, lastypm = -1; i < hd; i++) {
         ypm = (l_int32)(scy * (l_float32)i);
         yp = ypm >> 4;
         yf = ypm & 0x0f;
         lined = datad + i * wpld;
-        lines = datas + yp * wpls;
-        for (j = 0; j < wd; j++) {
-            xpm = (l_int32)(scx * (l_float32)j);
-            xp = xpm >> 4;
-            xf = xpm & 0x0f;
-
-                /* Do bilinear interpolation.  Without this, we could
-                 * simply subsample:
-                 *   SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xp));
-                 * which is faster but gives lousy results!  */
-            v00_val = GET_DATA_BYTE(lines, xp);
-            if (xp > wm2 || yp > hm2) {
-                if (yp > hm2 && xp <= wm2) {  /* pixels near bottom */
-                    v01_val = v00_val;
-                    v10_val = GET_DATA_BYTE(lines, xp + 1);
-                    v11_val = v10_val;
-                } else if (xp > wm2 && yp <= hm2) {  /* pixels near rt side */
-                    v01_val = GET_DATA_BYTE(lines + wpls, xp);
-                    v10_val = v00_val;
-                    v11_val = v01_val;
-                } else {  /* pixels at LR corner */
-                    v10_val = v01_val = v11_val = v00_val;
-                }
-            } else {
-                v10_val = GET_DATA_BYTE(lines, xp + 1);
-                v01_val = GET_DATA_BYTE(lines + wpls, xp);
-                v11_val = GET_DATA_BYTE(lines + wpls, xp + 1);
+        if (ypm != lastypm) {  /* else the sums of the previous line hold */
+            lines = datas + yp * wpls;
+            nexts = (yp > hm2) ? lines : lines + wpls;
+            k = interpolateGrayLinesSimd(sums, ws, lines, nexts, yf);
+            for (; k < ws; k++) {
+                sums[k] = (16 - yf) * GET_DATA_BYTE(lines, k) +
+                          yf * GET_DATA_BYTE(nexts, k);
             }
-
-            v00 = (16 - xf) * (16 - yf) * v00_val;
-            v10 = xf * (16 - yf) * v10_val;
-            v01 = (16 - xf) * yf * v01_val;
-            v11 = xf * yf * v11_val;
-
-            val = (l_uint8)((v00 + v01 + v10 + v11 + 128) / 256);
+            lastypm = ypm;
+        }
+        j = scaleGrayLILineSimd(lined, wd, sums, xleft, xright, xfrac);
+        for (; j < wd; j++) {
+            val = ((16 - xfrac[j]) * sums[xleft[j]] +
+                   xfrac[j] * sums[xright[j]] + 128) / 256;
             SET_DATA_BYTE(lined, j, val);
         }
     }
 
+    LEPT_FREE(sums);
+    LEPT_FREE(xtab);
     return;
 }
 
@@ -1427,19 +1436,16 @@ scaleGrayAreaMapLow(l_uint32  *datad,
 l_int32    i, j, k, m, wm2, hm2;
 l_int32    xu, yu;  /* UL corner in src image, to 1/16 of a pixel */
 l_int32    xl, yl;  /* LR corner in src image, to 1/16 of a pixel */
-l_int32    xup, yup, xuf, yuf;  /* UL src pixel: integer and fraction */
-l_int32    xlp, ylp, xlf, ylf;  /* LR src pixel: integer and fraction */
-l_int32    delx, dely, area;
-l_int32    v00;  /* contrib. from UL src pixel */
-l_int32    v01;  /* contrib. from LL src pixel */
-l_int32    v10;  /* contrib from UR src pixel */
-l_int32    v11;  /* contrib from LR src pixel */
-l_int32    vin;  /* contrib from all full interior src pixels */
-l_int32    vmid;  /* contrib from side parts that are full in 1 direction */
-l_int32    val;
-l_uint32  *lines, *lined;
+l_int32    yup, yuf;  /* UL src pixel: integer and fraction */
+l_int32    ylp, ylf;  /* LR src pixel: integer and fraction */
+l_int32    dely, weight, areay, val;
+l_int32   *xtab, *xup, *xuf, *xlp, *xlf, *areax;
+l_uint32   sum;
+l_uint32  *lines, *linek, *lined, *colsums, *prefix;
 l_float32  scx, scy;
 
+    PROCNAME("scaleGrayAreaMapLow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -1449,6 +1455,40 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
+        /* The weight of each src pixel is the product of the sub-pixels
+         * covered in x and in y, so the area map sum is done in two
+         * passes.  For each dest line, the src lines are summed into
+         * one line of column sums, each weighted by its sub-pixels in y.
+         * Each dest pixel then takes its two partial end columns and,
+         * from the running sums of the columns, all the full columns
+         * between them.  The sums can wrap in 32 bits, but their
+         * differences are exact.  The src columns of each dest column
+         * are the same for all dest lines, and are found once. */
+    colsums = (l_uint32 *)LEPT_CALLOC(ws, sizeof(l_uint32));
+    prefix = (l_uint32 *)LEPT_CALLOC(ws + 1, sizeof(l_uint32));
+    xtab = (l_int32 *)LEPT_CALLOC(5 * wd, sizeof(l_int32));
+    if (!colsums || !prefix || !xtab) {
+        LEPT_FREE(colsums);
+        LEPT_FREE(prefix);
+        LEPT_FREE(xtab);
+        L_ERROR("calloc fail for tables\n", procName);
+        return;
+    }
+    xup = xtab;
+    xuf = xtab + wd;
+    xlp = xtab + 2 * wd;
+    xlf = xtab + 3 * wd;
+    areax = xtab + 4 * wd;
+    for (j = 0; j < wd; j++) {
+        xu = (l_int32)(scx * j);
+        xl = (l_int32)(scx * (j + 1.0));
+        xup[j] = xu >> 4;
+        xuf[j] = xu & 0x0f;
+        xlp[j] = xl >> 4;
+        xlf[j] = xl & 0x0f;
+        areax[j] = (16 - xuf[j]) + 16 * (xlp[j] - xup[j] - 1) + xlf[j];
+    }
+
         /* Iterate over the destination pixels */
     for (i = 0; i < hd; i++) {
         yu = (l_int32)(scy * i);
@@ -1460,46 +1500,45 @@ l_float32  scx, scy;
         dely = ylp - yup;
         lined = datad + i * wpld;
         lines = datas + yup * wpls;
-        for (j = 0; j < wd; j++) {
-            xu = (l_int32)(scx * j);
-            xl = (l_int32)(scx * (j + 1.0));
-            xup = xu >> 4;
-            xuf = xu & 0x0f;
-            xlp = xl >> 4;
-            xlf = xl & 0x0f;
-            delx = xlp - xup;
 
-                /* If near the edge, just use a src pixel value */
-            if (xlp > wm2 || ylp > hm2) {
-                SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xup));
-                continue;
-            }
+            /* If near the edge, just use a src pixel value */
+        if (ylp > hm2) {
+            for (j = 0; j < wd; j++)
+                SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xup[j]));
+            continue;
+        }
 
-                /* Area summed over, in subpixels.  This varies
-                 * due to the quantization, so we can't simply take
-                 * the area to be a constant: area = scx * scy. */
-            area = ((16 - xuf) + 16 * (delx - 1) + xlf) *
-                   ((16 - yuf) + 16 * (dely - 1) + ylf);
+            /* Sum the src lines in y: the partial top and bottom lines,
+             * which are the same line if dely == 0, and the full lines
+             * between them. */
+        memset(colsums, 0, ws * sizeof(l_uint32));
+        for (k = 0; k <= dely; k++) {
+            if (k == dely)
+                weight = (dely == 0) ? (16 - yuf) + ylf : ylf;
+            else
+                weight = (k == 0) ? 16 - yuf : 16;
+            if (weight == 0) continue;
+            linek = lines + k * wpls;
+            m = accumulateGrayLineSimd(colsums, ws, linek, weight);
+            for (; m < ws; m++)
+                colsums[m] += weight * GET_DATA_BYTE(linek, m);
+        }
+        for (k = 0; k < ws; k++)
+            prefix[k + 1] = prefix[k] + colsums[k];
 
-                /* Do area map summation */
-            v00 = (16 - xuf) * (16 - yuf) * GET_DATA_BYTE(lines, xup);
-            v10 = xlf * (16 - yuf) * GET_DATA_BYTE(lines, xlp);
-            v01 = (16 - xuf) * ylf * GET_DATA_BYTE(lines + dely * wpls, xup);
-            v11 = xlf * ylf * GET_DATA_BYTE(lines + dely * wpls, xlp);
-            for (vin = 0, k = 1; k < dely; k++) {  /* for full src pixels */
-                 for (m = 1; m < delx; m++) {
-                     vin += 256 * GET_DATA_BYTE(lines + k * wpls, xup + m);
-                 }
+            /* Area summed over, in subpixels.  This varies
+             * due to the quantization, so we can't simply take
+             * the area to be a constant: area = scx * scy. */
+        areay = (16 - yuf) + 16 * (dely - 1) + ylf;
+        for (j = 0; j < wd; j++) {
+            if (xlp[j] > wm2) {
+                SET_DATA_BYTE(lined, j, GET_DATA_BYTE(lines, xup[j]));
+                continue;
             }
-            for (vmid = 0, k = 1; k < dely; k++)  /* for left side */
-                vmid += (16 - xuf) * 16 * GET_DATA_BYTE(lines + k * wpls, xup);
-            for (k = 1; k < dely; k++)  /* for right side */
-                vmid += xlf * 16 * GET_DATA_BYTE(lines + k * wpls, xlp);
-            for (m = 1; m < delx; m++)  /* for top side */
-                vmid += 16 * (16 - yuf) * GET_DATA_BYTE(lines, xup + m);
-            for (m = 1; m < delx; m++)  /* for bottom side */
-                vmid += 16 * ylf * GET_DATA_BYTE(lines + dely * wpls, xup + m);
-            val = (v00 + v01 + v10 + v11 + vin + vmid + 128) / area;
+            sum = (16 - xuf[j]) * colsums[xup[j]] + xlf[j] * colsums[xlp[j]];
+            if (xlp[j] - xup[j] > 1)  /* for full src columns */
+                sum += 16 * (prefix[xlp[j]] - prefix[xup[j] + 1]);
+            val = (l_int32)(sum + 128) / (areax[j] * areay);
 #if  DEBUG_OVERFLOW
             if (val > 255) fprintf(stderr, "val overflow: %d\n", val);
 #endif  /* DEBUG_OVERFLOW */
@@ -1507,6 +1546,9 @@ l_float32  scx, scy;
         }
     }
 
+    LEPT_FREE(colsums);
+    LEPT_FREE(prefix);
+    LEPT_FREE(xtab);
     return;
 }
 
@@ -1683,6 +1725,8 @@ l_float32  wratio, hratio;
  *  converts from the sum of ON pixels in the 2x2 block to
  *  an 8 bpp grayscale value between 0 for 4 bits ON
  *  and 255 for 0 bits ON.
+ *  Most of each line is done by vectorized code, where available,
+ *  with the same result; see simdlow.c.
  */
 void
 scaleToGray2Low(l_uint32  *datad,
@@ -1709,7 +1753,8 @@ l_uint32  *lines, *lined;
     for (i = 0, l = 0; i < hd; i++, l += 2) {
         lines = datas + l * wpls;
         lined = datad + i * wpld;
-        for (j = 0, k = 0; j < wd4; j += 4, k++) {
+        j = scaleToGray2LineSimd(lined, wd4, lines, wpls, valtab);
+        for (k = j / 4; j < wd4; j += 4, k++) {
             sbyte1 = GET_DATA_BYTE(lines, k);
             sbyte2 = GET_DATA_BYTE(lines + wpls, k);
             sum = sumtab[sbyte1] + sumtab[sbyte2];
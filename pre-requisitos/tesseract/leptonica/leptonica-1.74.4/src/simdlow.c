@@ -0,0 +1,1360 @@
+/*====================================================================*
+ -  Copyright (C) 2001 Leptonica.  All rights reserved.
+ -
+ -  Redistribution and use in source and binary forms, with or without
+ -  modification, are permitted provided that the following conditions
+ -  are met:
+ -  1. Redistributions of source code must retain the above copyright
+ -     notice, this list of conditions and the following disclaimer.
+ -  2. Redistributions in binary form must reproduce the above
+ -     copyright notice, this list of conditions and the following
+ -     disclaimer in the documentation and/or other materials
+ -     provided with the distribution.
+ -
+ -  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ -  ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ -  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ -  A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL ANY
+ -  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ -  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ -  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ -  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ -  OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ -  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ -  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *====================================================================*/
+
+/*!
+ * \file simdlow.c
+ * <pre>
+ *
+ *      Vectorized inner loops of some pixelwise conversions
+ *
+ *          Selection of the instruction set
+ *              l_int32    setSimdLevel()
+ *
+ *          RGB to gray, by one line
+ *              l_int32    rgbToGrayLineSimd()
+ *              l_int32    rgbToGreenLineSimd()
+ *
+ *          Simple binarization of 8 bpp, by one line
+ *              l_int32    thresholdToBinaryLineSimd()
+ *
+ *          Grayscale scaling, by one line
+ *              l_int32    interpolateGrayLinesSimd()
+ *              l_int32    scaleGrayLILineSimd()
+ *              l_int32    accumulateGrayLineSimd()
+ *              l_int32    scaleToGray2LineSimd()
+ *
+ *          Pixel counts of 1 bpp, by one line
+ *              l_int32    countPixelsLineSimd()
+ *
+ *          Scaling of the bytes of a line by 8.8 factors
+ *              l_int32    scaleBytesLineSimd()
+ *
+ *          Transpose of a square tile of 8 or 32 bpp
+ *              l_int32    transposeTileSimd()
+ *
+ *          Rasterop of the full words of a rectangle
+ *              l_int32    rasteropWordsSimd()
+ *
+ *      Each line function converts the longest prefix of the line that
+ *      fills whole vectors and returns its width in pixels, so that the
+ *      caller finishes the line with its own scalar loop.  The results
+ *      are bit for bit those of the scalar code.  Builds for other
+ *      processors or compilers, or for big-endian hosts, get line
+ *      functions that return 0; transposeTileSimd() then returns 0
+ *      and leaves the tile to the caller.
+ *
+ *      SSE2 is part of every x86-64 processor; AVX2 is used only when
+ *      the processor in use has it.
+ * </pre>
+ */
+
+#include "allheaders.h"
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(L_BIG_ENDIAN)
+#define  HAVE_X86_SIMD   1
+#include <immintrin.h>
+#else
+#define  HAVE_X86_SIMD   0
+#endif
+
+    /* Level in use, or -1 until it is first needed */
+static l_int32  SimdLevel = -1;
+
+static l_int32 simdGetLevel(void);
+
+#if HAVE_X86_SIMD
+static l_int32 rgbToGrayLineSse2(l_uint32 *lined, const l_uint32 *lines,
+                                 l_int32 w, l_float32 rwt, l_float32 gwt,
+                                 l_float32 bwt);
+static l_int32 rgbToGrayLineAvx2(l_uint32 *lined, const l_uint32 *lines,
+                                 l_int32 w, l_float32 rwt, l_float32 gwt,
+                                 l_float32 bwt);
+static l_int32 rgbToGreenLineSse2(l_uint32 *lined, const l_uint32 *lines,
+                                  l_int32 w);
+static l_int32 rgbToGreenLineAvx2(l_uint32 *lined, const l_uint32 *lines,
+                                  l_int32 w);
+static l_int32 thresholdToBinaryLineSse2(l_uint32 *lined, l_int32 w,
+                                         const l_uint32 *lines,
+                                         l_int32 thresh);
+static l_int32 thresholdToBinaryLineAvx2(l_uint32 *lined, l_int32 w,
+                                         const l_uint32 *lines,
+                                         l_int32 thresh);
+static l_int32 interpolateGrayLinesSse2(l_int32 *sums, l_int32 w,
+                                        const l_uint32 *line0,
+                                        const l_uint32 *line1, l_int32 frac);
+static l_int32 scaleGrayLILineAvx2(l_uint32 *lined, l_int32 wd,
+                                   const l_int32 *sums, const l_int32 *xleft,
+                                   const l_int32 *xright,
+                                   const l_int32 *xfrac);
+static l_int32 accumulateGrayLineSse2(l_uint32 *sums, l_int32 w,
+                                      const l_uint32 *line, l_int32 weight);
+static l_int32 scaleToGray2LineAvx2(l_uint32 *lined, l_int32 wd,
+                                    const l_uint32 *lines, l_int32 wpls,
+                                    const l_uint8 *valtab);
+static l_int32 countPixelsLineSse2(const l_uint32 *line, l_int32 w,
+                                   l_int32 *pcount);
+static l_int32 countPixelsLineAvx2(const l_uint32 *line, l_int32 w,
+                                   l_int32 *pcount);
+static l_int32 scaleBytesLineSse2(l_uint32 *lined, const l_uint32 *lines,
+                                  const l_uint16 *factors, l_int32 nbytes);
+static l_int32 scaleBytesLineAvx2(l_uint32 *lined, const l_uint32 *lines,
+                                  const l_uint16 *factors, l_int32 nbytes);
+static void transposeTile8Sse2(l_uint32 *datad, l_int32 wpld,
+                               const l_uint32 *datas, l_int32 wpls,
+                               l_int32 size);
+static void transposeTile32Sse2(l_uint32 *datad, l_int32 wpld,
+                                const l_uint32 *datas, l_int32 wpls,
+                                l_int32 size);
+static l_int32 rasteropLineSse2(l_uint32 *lined, const l_uint32 *lines,
+                                l_int32 nwords, l_int32 shift, l_int32 comb,
+                                l_uint32 sinv, l_uint32 dinv, l_uint32 rinv);
+static l_int32 rasteropLineAvx2(l_uint32 *lined, const l_uint32 *lines,
+                                l_int32 nwords, l_int32 shift, l_int32 comb,
+                                l_uint32 sinv, l_uint32 dinv, l_uint32 rinv);
+#endif  /* HAVE_X86_SIMD */
+
+    /* Combinations of src and dest words in rasteropWordsSimd() */
+enum {
+    ROP_COMB_COPY = 0,   /* src only */
+    ROP_COMB_AND = 1,
+    ROP_COMB_OR = 2,
+    ROP_COMB_XOR = 3
+};
+
+
+/*------------------------------------------------------------------*
+ *                 Selection of the instruction set                 *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   setSimdLevel()
+ *
+ * \param[in]    newlevel   L_SIMD_NONE, L_SIMD_SSE2, L_SIMD_AVX2 or
+ *                          L_SIMD_AUTO
+ * \return  oldlevel
+ *
+ * <pre>
+ * Notes:
+ *      (1) By default the widest instruction set of the processor is
+ *          used.  A lower level can be chosen, as to compare with the
+ *          scalar code; a level above what the processor supports is
+ *          lowered to it.  L_SIMD_AUTO goes back to the default.
+ *      (2) This is meant to be called before any processing starts,
+ *          not while other threads are converting images.
+ * </pre>
+ */
+l_int32
+setSimdLevel(l_int32  newlevel)
+{
+l_int32  oldlevel, maxlevel;
+
+    oldlevel = simdGetLevel();
+    SimdLevel = -1;
+    maxlevel = simdGetLevel();
+    if (newlevel != L_SIMD_AUTO && newlevel < maxlevel)
+        SimdLevel = L_MAX(newlevel, L_SIMD_NONE);
+    return oldlevel;
+}
+
+
+/*!
+ * \brief   simdGetLevel()
+ *
+ * \return  level in use, detected on the first call
+ */
+static l_int32
+simdGetLevel(void)
+{
+    if (SimdLevel < 0) {
+#if HAVE_X86_SIMD
+        __builtin_cpu_init();
+        SimdLevel = __builtin_cpu_supports("avx2") ? L_SIMD_AVX2
+                                                   : L_SIMD_SSE2;
+#else
+        SimdLevel = L_SIMD_NONE;
+#endif  /* HAVE_X86_SIMD */
+    }
+    return SimdLevel;
+}
+
+
+/*------------------------------------------------------------------*
+ *                       RGB to gray, by line                       *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   rgbToGrayLineSimd()
+ *
+ * \param[in]    lined   8 bpp dest line
+ * \param[in]    lines   32 bpp src line
+ * \param[in]    w       width in pixels
+ * \param[in]    rwt, gwt, bwt   weights, as used by pixConvertRGBToGray()
+ * \return  number of pixels converted from the start of the line
+ *
+ * <pre>
+ * Notes:
+ *      (1) The weighted sum is made in float in the same order as in
+ *          pixConvertRGBToGray(), and rounded in double, so the gray
+ *          values are the same.  A build that lets the compiler fuse
+ *          multiplies and adds (e.g., -mfma) could round the scalar sum
+ *          differently, so nothing is vectorized there.
+ * </pre>
+ */
+l_int32
+rgbToGrayLineSimd(l_uint32        *lined,
+                  const l_uint32  *lines,
+                  l_int32          w,
+                  l_float32        rwt,
+                  l_float32        gwt,
+                  l_float32        bwt)
+{
+#if HAVE_X86_SIMD && !defined(__FMA__)
+    switch (simdGetLevel())
+    {
+    case L_SIMD_AVX2:
+        return rgbToGrayLineAvx2(lined, lines, w, rwt, gwt, bwt);
+    case L_SIMD_SSE2:
+        return rgbToGrayLineSse2(lined, lines, w, rwt, gwt, bwt);
+    default:
+        break;
+    }
+#endif  /* HAVE_X86_SIMD && !__FMA__ */
+    return 0;
+}
+
+
+/*!
+ * \brief   rgbToGreenLineSimd()
+ *
+ * \param[in]    lined   8 bpp dest line
+ * \param[in]    lines   32 bpp src line
+ * \param[in]    w       width in pixels
+ * \return  number of pixels converted from the start of the line
+ *
+ * <pre>
+ * Notes:
+ *      (1) The gray value is the green component, as in
+ *          pixConvertRGBToGrayFast().
+ * </pre>
+ */
+l_int32
+rgbToGreenLineSimd(l_uint32        *lined,
+                   const l_uint32  *lines,
+                   l_int32          w)
+{
+#if HAVE_X86_SIMD
+    switch (simdGetLevel())
+    {
+    case L_SIMD_AVX2:
+        return rgbToGreenLineAvx2(lined, lines, w);
+    case L_SIMD_SSE2:
+        return rgbToGreenLineSse2(lined, lines, w);
+    default:
+        break;
+    }
+#endif  /* HAVE_X86_SIMD */
+    return 0;
+}
+
+
+/*------------------------------------------------------------------*
+ *                Simple binarization of 8 bpp, by line             *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   thresholdToBinaryLineSimd()
+ *
+ * \param[in]    lined    1 bpp dest line
+ * \param[in]    w        width in pixels
+ * \param[in]    lines    8 bpp src line
+ * \param[in]    thresh   pixels below this are set to 1
+ * \return  number of pixels binarized from the start of the line,
+ *          a multiple of 32
+ */
+l_int32
+thresholdToBinaryLineSimd(l_uint32        *lined,
+                          l_int32          w,
+                          const l_uint32  *lines,
+                          l_int32          thresh)
+{
+#if HAVE_X86_SIMD
+    if (thresh <= 0)  /* no pixel is below; left to the scalar code */
+        return 0;
+    switch (simdGetLevel())
+    {
+    case L_SIMD_AVX2:
+        return thresholdToBinaryLineAvx2(lined, w, lines, thresh);
+    case L_SIMD_SSE2:
+        return thresholdToBinaryLineSse2(lined, w, lines, thresh);
+    default:
+        break;
+    }
+#endif  /* HAVE_X86_SIMD */
+    return 0;
+}
+
+
+/*------------------------------------------------------------------*
+ *                  Grayscale scaling, by one line                  *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   interpolateGrayLinesSimd()
+ *
+ * \param[in]    sums    w interpolated values, in 1/16 of a gray level
+ * \param[in]    w       width in pixels
+ * \param[in]    line0, line1   8 bpp src lines
+ * \param[in]    frac    weight of line1, in 1/16; 0 to 15
+ * \return  number of pixels interpolated from the start of the lines
+ *
+ * <pre>
+ * Notes:
+ *      (1) Sets sums[x] to (16 - frac) * line0[x] + frac * line1[x],
+ *          for the vertical pass of scaleGrayLILow().
+ * </pre>
+ */
+l_int32
+interpolateGrayLinesSimd(l_int32         *sums,
+                         l_int32          w,
+                         const l_uint32  *line0,
+                         const l_uint32  *line1,
+                         l_int32          frac)
+{
+#if HAVE_X86_SIMD
+    if (simdGetLevel() >= L_SIMD_SSE2)
+        return interpolateGrayLinesSse2(sums, w, line0, line1, frac);
+#endif  /* HAVE_X86_SIMD */
+    return 0;
+}
+
+
+/*!
+ * \brief   scaleGrayLILineSimd()
+ *
+ * \param[in]    lined    8 bpp dest line
+ * \param[in]    wd       dest width in pixels
+ * \param[in]    sums     src line from interpolateGrayLinesSimd()
+ * \param[in]    xleft, xright   src columns of each dest pixel
+ * \param[in]    xfrac    weight of the right column, in 1/16
+ * \return  number of dest pixels made from the start of the line
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the horizontal pass of scaleGrayLILow().  With the
+ *          sums of each column gathered by index, it needs AVX2.
+ * </pre>
+ */
+l_int32
+scaleGrayLILineSimd(l_uint32       *lined,
+                    l_int32         wd,
+                    const l_int32  *sums,
+                    const l_int32  *xleft,
+                    const l_int32  *xright,
+                    const l_int32  *xfrac)
+{
+#if HAVE_X86_SIMD
+    if (simdGetLevel() >= L_SIMD_AVX2)
+        return scaleGrayLILineAvx2(lined, wd, sums, xleft, xright, xfrac);
+#endif  /* HAVE_X86_SIMD */
+    return 0;
+}
+
+
+/*!
+ * \brief   accumulateGrayLineSimd()
+ *
+ * \param[in]    sums     w column sums
+ * \param[in]    w        width in pixels
+ * \param[in]    line     8 bpp src line
+ * \param[in]    weight   0 to 32
+ * \return  number of pixels added from the start of the line
+ *
+ * <pre>
+ * Notes:
+ *      (1) Adds weight * line[x] to sums[x], for the vertical pass of
+ *          scaleGrayAreaMapLow().
+ * </pre>
+ */
+l_int32
+accumulateGrayLineSimd(l_uint32        *sums,
+                       l_int32          w,
+                       const l_uint32  *line,
+                       l_int32          weight)
+{
+#if HAVE_X86_SIMD
+    if (simdGetLevel() >= L_SIMD_SSE2)
+        return accumulateGrayLineSse2(sums, w, line, weight);
+#endif  /* HAVE_X86_SIMD */
+    return 0;
+}
+
+
+/*!
+ * \brief   scaleToGray2LineSimd()
+ *
+ * \param[in]    lined    8 bpp dest line
+ * \param[in]    wd       dest width in pixels
+ * \param[in]    lines    first of the 2 1 bpp src lines
+ * \param[in]    wpls     src words/line
+ * \param[in]    valtab   made from makeValTabSG2()
+ * \return  number of dest pixels made from the start of the line,
+ *          a multiple of 64
+ *
+ * <pre>
+ * Notes:
+ *      (1) The ON pixels of each 2x2 block are counted with shifts
+ *          and masks, and the counts looked up in valtab with a byte
+ *          shuffle, which needs AVX2 here.
+ * </pre>
+ */
+l_int32
+scaleToGray2LineSimd(l_uint32        *lined,
+                     l_int32          wd,
+                     const l_uint32  *lines,
+                     l_int32          wpls,
+                     const l_uint8   *valtab)
+{
+#if HAVE_X86_SIMD
+    if (simdGetLevel() >= L_SIMD_AVX2)
+        return scaleToGray2LineAvx2(lined, wd, lines, wpls, valtab);
+#endif  /* HAVE_X86_SIMD */
+    return 0;
+}
+
+
+/*------------------------------------------------------------------*
+ *                 Pixel counts of 1 bpp, by one line               *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   countPixelsLineSimd()
+ *
+ * \param[in]    line     1 bpp src line
+ * \param[in]    w        width in pixels
+ * \param[out]   pcount   number of ON pixels counted
+ * \return  number of pixels counted from the start of the line,
+ *          a multiple of 128
+ *
+ * <pre>
+ * Notes:
+ *      (1) The bits of each byte are counted with shifts and masks in
+ *          SSE2, or with a nibble lookup in a byte shuffle in AVX2,
+ *          and the byte counts summed in 64-bit lanes.
+ * </pre>
+ */
+l_int32
+countPixelsLineSimd(const l_uint32  *line,
+                    l_int32          w,
+                    l_int32         *pcount)
+{
+    *pcount = 0;
+#if HAVE_X86_SIMD
+    switch (simdGetLevel())
+    {
+    case L_SIMD_AVX2:
+        return countPixelsLineAvx2(line, w, pcount);
+    case L_SIMD_SSE2:
+        return countPixelsLineSse2(line, w, pcount);
+    default:
+        break;
+    }
+#endif  /* HAVE_X86_SIMD */
+    return 0;
+}
+
+
+/*------------------------------------------------------------------*
+ *            Scaling of the bytes of a line by 8.8 factors         *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   scaleBytesLineSimd()
+ *
+ * \param[in]    lined     dest line
+ * \param[in]    lines     src line
+ * \param[in]    factors   one factor for each byte, in memory order
+ * \param[in]    nbytes    number of bytes
+ * \return  number of bytes scaled from the start of the line
+ *
+ * <pre>
+ * Notes:
+ *      (1) Each dest byte is min(255, (src byte * factor) / 256), which
+ *          is how pixApplyInvBackgroundGrayMap() and
+ *          pixApplyInvBackgroundRGBMap() apply their inverse maps.
+ *      (2) The bytes are taken in memory order, whatever the depth; the
+ *          caller lays out the factors to match.
+ * </pre>
+ */
+l_int32
+scaleBytesLineSimd(l_uint32        *lined,
+                   const l_uint32  *lines,
+                   const l_uint16  *factors,
+                   l_int32          nbytes)
+{
+#if HAVE_X86_SIMD
+    switch (simdGetLevel())
+    {
+    case L_SIMD_AVX2:
+        return scaleBytesLineAvx2(lined, lines, factors, nbytes);
+    case L_SIMD_SSE2:
+        return scaleBytesLineSse2(lined, lines, factors, nbytes);
+    default:
+        break;
+    }
+#endif  /* HAVE_X86_SIMD */
+    return 0;
+}
+
+
+/*------------------------------------------------------------------*
+ *               Transpose of a square tile of 8 or 32 bpp          *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   transposeTileSimd()
+ *
+ * \param[in]    datad   first word of the dest tile
+ * \param[in]    wpld    dest words per line; can be negative
+ * \param[in]    datas   first word of the src tile
+ * \param[in]    wpls    src words per line; can be negative
+ * \param[in]    size    width and height of the tile, a multiple of 8
+ * \param[in]    d       depth, 8 or 32 bpp
+ * \return  1 if the tile was transposed, 0 if left to the caller
+ *
+ * <pre>
+ * Notes:
+ *      (1) Pixel j of dest line i is set to pixel i of src line j, for
+ *          i and j below size.  Both tiles start on a word boundary.
+ *      (2) With a negative stride the lines go up in memory, which
+ *          turns the transpose into a rotation by 90 degrees; see
+ *          pixRotate90().
+ * </pre>
+ */
+l_int32
+transposeTileSimd(l_uint32        *datad,
+                  l_int32          wpld,
+                  const l_uint32  *datas,
+                  l_int32          wpls,
+                  l_int32          size,
+                  l_int32          d)
+{
+#if HAVE_X86_SIMD
+    if (simdGetLevel() >= L_SIMD_SSE2 && size % 8 == 0) {
+        if (d == 8) {
+            transposeTile8Sse2(datad, wpld, datas, wpls, size);
+            return 1;
+        } else if (d == 32) {
+            transposeTile32Sse2(datad, wpld, datas, wpls, size);
+            return 1;
+        }
+    }
+#endif  /* HAVE_X86_SIMD */
+    return 0;
+}
+
+
+/*------------------------------------------------------------------*
+ *             Rasterop of the full words of a rectangle            *
+ *------------------------------------------------------------------*/
+/*!
+ * \brief   rasteropWordsSimd()
+ *
+ * \param[in]    datad    first full dest word of the first line
+ * \param[in]    wpld     dest words per line
+ * \param[in]    datas    src word that is shifted into it
+ * \param[in]    wpls     src words per line
+ * \param[in]    nwords   number of full dest words on each line
+ * \param[in]    h        number of lines
+ * \param[in]    op       op code of one of the 12 src and dest ops
+ * \param[in]    shift    left shift of the src words, 0 - 31
+ * \return  number of words done from the start of each line
+ *
+ * <pre>
+ * Notes:
+ *      (1) Dest word j is set to op applied to itself and to the src
+ *          word (lines[j] << shift) | (lines[j + 1] >> (32 - shift)),
+ *          which is lines[j] itself when shift is 0.  This is the full
+ *          word loop of each of the blitters in roplow.c.
+ *      (2) With a shift, lines[nwords] is read, as by those loops.
+ *      (3) The src and dest must not overlap.  Ops that ignore the src
+ *          or the dest, such as PIX_CLR and PIX_DST, return 0.
+ * </pre>
+ */
+l_int32
+rasteropWordsSimd(l_uint32        *datad,
+                  l_int32          wpld,
+                  const l_uint32  *datas,
+                  l_int32          wpls,
+                  l_int32          nwords,
+                  l_int32          h,
+                  l_int32          op,
+                  l_int32          shift)
+{
+#if HAVE_X86_SIMD
+l_int32   i, comb, level, ndone;
+l_uint32  sinv, dinv, rinv;
+
+    if (shift < 0 || shift > 31)
+        return 0;
+
+        /* Each op is ((s ^ sinv) comb (d ^ dinv)) ^ rinv */
+    sinv = dinv = rinv = 0;
+    switch (op)
+    {
+    case PIX_SRC:
+        comb = ROP_COMB_COPY;
+        break;
+    case PIX_NOT(PIX_SRC):
+        comb = ROP_COMB_COPY;
+        sinv = 0xffffffff;
+        break;
+    case (PIX_SRC | PIX_DST):
+        comb = ROP_COMB_OR;
+        break;
+    case (PIX_SRC & PIX_DST):
+        comb = ROP_COMB_AND;
+        break;
+    case (PIX_SRC ^ PIX_DST):
+        comb = ROP_COMB_XOR;
+        break;
+    case (PIX_NOT(PIX_SRC) | PIX_DST):
+        comb = ROP_COMB_OR;
+        sinv = 0xffffffff;
+        break;
+    case (PIX_NOT(PIX_SRC) & PIX_DST):
+        comb = ROP_COMB_AND;
+        sinv = 0xffffffff;
+        break;
+    case (PIX_SRC | PIX_NOT(PIX_DST)):
+        comb = ROP_COMB_OR;
+        dinv = 0xffffffff;
+        break;
+    case (PIX_SRC & PIX_NOT(PIX_DST)):
+        comb = ROP_COMB_AND;
+        dinv = 0xffffffff;
+        break;
+    case (PIX_NOT(PIX_SRC | PIX_DST)):
+        comb = ROP_COMB_OR;
+        rinv = 0xffffffff;
+        break;
+    case (PIX_NOT(PIX_SRC & PIX_DST)):
+        comb = ROP_COMB_AND;
+        rinv = 0xffffffff;
+        break;
+    case (PIX_NOT(PIX_SRC ^ PIX_DST)):
+        comb = ROP_COMB_XOR;
+        rinv = 0xffffffff;
+        break;
+    default:
+        return 0;
+    }
+
+    level = simdGetLevel();
+    ndone = 0;
+    for (i = 0; i < h; i++) {
+        if (level == L_SIMD_AVX2)
+            ndone = rasteropLineAvx2(datad + i * wpld, datas + i * wpls,
+                                     nwords, shift, comb, sinv, dinv, rinv);
+        else if (level == L_SIMD_SSE2)
+            ndone = rasteropLineSse2(datad + i * wpld, datas + i * wpls,
+                                     nwords, shift, comb, sinv, dinv, rinv);
+    }
+    return ndone;
+#else
+    return 0;
+#endif  /* HAVE_X86_SIMD */
+}
+
+
+#if HAVE_X86_SIMD
+/*------------------------------------------------------------------*
+ *                     SSE2 and AVX2 inner loops                    *
+ *------------------------------------------------------------------*
+ *  In a little-endian word of 8 bpp pixels, the first pixel is the  *
+ *  last byte in memory.  Reversing the order of the words of a      *
+ *  vector of bytes thus puts the pixels in reverse order, which is  *
+ *  the order of the bits of a 1 bpp dest word, and lets the byte    *
+ *  mask of a comparison be stored as it is.  Likewise, the 8 bpp    *
+ *  bytes made from 4 RGB pixels are stored with the 4 values in     *
+ *  reverse order.                                                   *
+ *------------------------------------------------------------------*/
+
+    /* Makes the 8 bpp word of the 4 gray values in vals */
+static inline l_uint32
+packGrayWordSse2(__m128i  vals)
+{
+    vals = _mm_shuffle_epi32(vals, _MM_SHUFFLE(0, 1, 2, 3));
+    vals = _mm_packs_epi32(vals, vals);
+    vals = _mm_packus_epi16(vals, vals);
+    return (l_uint32)_mm_cvtsi128_si32(vals);
+}
+
+    /* Stores the 2 8 bpp words of the 8 gray values in lo and hi */
+static inline void
+storeGrayWordsSse2(l_uint32  *lined,
+                   __m128i    lo,
+                   __m128i    hi)
+{
+    lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(0, 1, 2, 3));
+    hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(0, 1, 2, 3));
+    lo = _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+    _mm_storel_epi64((__m128i *)lined, lo);
+}
+
+    /* Loads 16 8 bpp pixels, from a word boundary, as 16-bit values
+     * in the order of the pixels */
+static inline void
+loadGrayPixelsSse2(const l_uint32  *line,
+                   __m128i         *plo,
+                   __m128i         *phi)
+{
+__m128i  bytes, zero;
+
+    bytes = _mm_loadu_si128((const __m128i *)line);
+    zero = _mm_setzero_si128();
+    *plo = _mm_unpacklo_epi8(bytes, zero);
+    *plo = _mm_shufflelo_epi16(*plo, _MM_SHUFFLE(0, 1, 2, 3));
+    *plo = _mm_shufflehi_epi16(*plo, _MM_SHUFFLE(0, 1, 2, 3));
+    *phi = _mm_unpackhi_epi8(bytes, zero);
+    *phi = _mm_shufflelo_epi16(*phi, _MM_SHUFFLE(0, 1, 2, 3));
+    *phi = _mm_shufflehi_epi16(*phi, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+static l_int32
+rgbToGrayLineSse2(l_uint32        *lined,
+                  const l_uint32  *lines,
+                  l_int32          w,
+                  l_float32        rwt,
+                  l_float32        gwt,
+                  l_float32        bwt)
+{
+l_int32  j;
+__m128   rw, gw, bw, sum;
+__m128i  word, mask, vals;
+__m128d  half, lo, hi;
+
+    rw = _mm_set1_ps(rwt);
+    gw = _mm_set1_ps(gwt);
+    bw = _mm_set1_ps(bwt);
+    half = _mm_set1_pd(0.5);
+    mask = _mm_set1_epi32(0xff);
+    for (j = 0; j + 3 < w; j += 4) {
+        word = _mm_loadu_si128((const __m128i *)(lines + j));
+        sum = _mm_mul_ps(rw, _mm_cvtepi32_ps(_mm_and_si128(
+                  _mm_srli_epi32(word, L_RED_SHIFT), mask)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(gw, _mm_cvtepi32_ps(_mm_and_si128(
+                  _mm_srli_epi32(word, L_GREEN_SHIFT), mask))));
+        sum = _mm_add_ps(sum, _mm_mul_ps(bw, _mm_cvtepi32_ps(_mm_and_si128(
+                  _mm_srli_epi32(word, L_BLUE_SHIFT), mask))));
+        lo = _mm_add_pd(_mm_cvtps_pd(sum), half);
+        hi = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(sum, sum)), half);
+        vals = _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+        lined[j >> 2] = packGrayWordSse2(vals);
+    }
+    return j;
+}
+
+__attribute__((target("avx2")))
+static l_int32
+rgbToGrayLineAvx2(l_uint32        *lined,
+                  const l_uint32  *lines,
+                  l_int32          w,
+                  l_float32        rwt,
+                  l_float32        gwt,
+                  l_float32        bwt)
+{
+l_int32  j;
+__m256   rw, gw, bw, sum;
+__m256i  word, mask;
+__m256d  half;
+__m128i  lo, hi;
+
+    rw = _mm256_set1_ps(rwt);
+    gw = _mm256_set1_ps(gwt);
+    bw = _mm256_set1_ps(bwt);
+    half = _mm256_set1_pd(0.5);
+    mask = _mm256_set1_epi32(0xff);
+    for (j = 0; j + 7 < w; j += 8) {
+        word = _mm256_loadu_si256((const __m256i *)(lines + j));
+        sum = _mm256_mul_ps(rw, _mm256_cvtepi32_ps(_mm256_and_si256(
+                  _mm256_srli_epi32(word, L_RED_SHIFT), mask)));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(gw, _mm256_cvtepi32_ps(
+                  _mm256_and_si256(_mm256_srli_epi32(word, L_GREEN_SHIFT),
+                                   mask))));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(bw, _mm256_cvtepi32_ps(
+                  _mm256_and_si256(_mm256_srli_epi32(word, L_BLUE_SHIFT),
+                                   mask))));
+        lo = _mm256_cvttpd_epi32(_mm256_add_pd(
+                 _mm256_cvtps_pd(_mm256_castps256_ps128(sum)), half));
+        hi = _mm256_cvttpd_epi32(_mm256_add_pd(
+                 _mm256_cvtps_pd(_mm256_extractf128_ps(sum, 1)), half));
+        storeGrayWordsSse2(lined + (j >> 2), lo, hi);
+    }
+    return j;
+}
+
+static l_int32
+rgbToGreenLineSse2(l_uint32        *lined,
+                   const l_uint32  *lines,
+                   l_int32          w)
+{
+l_int32  j;
+__m128i  word, mask;
+
+    mask = _mm_set1_epi32(0xff);
+    for (j = 0; j + 3 < w; j += 4) {
+        word = _mm_loadu_si128((const __m128i *)(lines + j));
+        lined[j >> 2] = packGrayWordSse2(_mm_and_si128(
+                            _mm_srli_epi32(word, L_GREEN_SHIFT), mask));
+    }
+    return j;
+}
+
+__attribute__((target("avx2")))
+static l_int32
+rgbToGreenLineAvx2(l_uint32        *lined,
+                   const l_uint32  *lines,
+                   l_int32          w)
+{
+l_int32  j;
+__m256i  word, mask, vals, order, gather;
+
+        /* Reverses the 4 values of each 128-bit lane into its first
+         * word; the first words of both lanes of 2 vectors are then
+         * gathered in order */
+    order = _mm256_setr_epi8(12, 8, 4, 0, -1, -1, -1, -1,
+                             -1, -1, -1, -1, -1, -1, -1, -1,
+                             12, 8, 4, 0, -1, -1, -1, -1,
+                             -1, -1, -1, -1, -1, -1, -1, -1);
+    gather = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    mask = _mm256_set1_epi32(0xff);
+    for (j = 0; j + 15 < w; j += 16) {
+        word = _mm256_loadu_si256((const __m256i *)(lines + j));
+        vals = _mm256_shuffle_epi8(_mm256_and_si256(
+                   _mm256_srli_epi32(word, L_GREEN_SHIFT), mask), order);
+        word = _mm256_loadu_si256((const __m256i *)(lines + j + 8));
+        word = _mm256_shuffle_epi8(_mm256_and_si256(
+                   _mm256_srli_epi32(word, L_GREEN_SHIFT), mask), order);
+        vals = _mm256_or_si256(vals, _mm256_slli_si256(word, 4));
+        vals = _mm256_permutevar8x32_epi32(vals, gather);
+        _mm_storeu_si128((__m128i *)(lined + (j >> 2)),
+                         _mm256_castsi256_si128(vals));
+    }
+    return j;
+}
+
+static l_int32
+thresholdToBinaryLineSse2(l_uint32        *lined,
+                          l_int32          w,
+                          const l_uint32  *lines,
+                          l_int32          thresh)
+{
+l_int32   j;
+l_uint32  hibits, lobits;
+__m128i   maxval, pix;
+
+        /* gval < thresh  <==>  min(gval, thresh - 1) == gval */
+    maxval = _mm_set1_epi8((char)L_MIN(thresh - 1, 255));
+    for (j = 0; j + 31 < w; j += 32) {
+        pix = _mm_loadu_si128((const __m128i *)(lines + (j >> 2)));
+        pix = _mm_shuffle_epi32(pix, _MM_SHUFFLE(0, 1, 2, 3));
+        hibits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(pix, maxval),
+                                                  pix));
+        pix = _mm_loadu_si128((const __m128i *)(lines + (j >> 2) + 4));
+        pix = _mm_shuffle_epi32(pix, _MM_SHUFFLE(0, 1, 2, 3));
+        lobits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(pix, maxval),
+                                                  pix));
+        lined[j >> 5] = (hibits << 16) | lobits;
+    }
+    return j;
+}
+
+__attribute__((target("avx2")))
+static l_int32
+thresholdToBinaryLineAvx2(l_uint32        *lined,
+                          l_int32          w,
+                          const l_uint32  *lines,
+                          l_int32          thresh)
+{
+l_int32  j;
+__m256i  maxval, order, pix;
+
+    maxval = _mm256_set1_epi8((char)L_MIN(thresh - 1, 255));
+    order = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    for (j = 0; j + 31 < w; j += 32) {
+        pix = _mm256_loadu_si256((const __m256i *)(lines + (j >> 2)));
+        pix = _mm256_permutevar8x32_epi32(pix, order);
+        lined[j >> 5] = (l_uint32)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_min_epu8(pix, maxval), pix));
+    }
+    return j;
+}
+static l_int32
+interpolateGrayLinesSse2(l_int32         *sums,
+                         l_int32          w,
+                         const l_uint32  *line0,
+                         const l_uint32  *line1,
+                         l_int32          frac)
+{
+l_int32  j;
+__m128i  w0, w1, zero, lo0, hi0, lo1, hi1, lo, hi;
+
+    w0 = _mm_set1_epi16(16 - frac);
+    w1 = _mm_set1_epi16(frac);
+    zero = _mm_setzero_si128();
+    for (j = 0; j + 15 < w; j += 16) {
+        loadGrayPixelsSse2(line0 + (j >> 2), &lo0, &hi0);
+        loadGrayPixelsSse2(line1 + (j >> 2), &lo1, &hi1);
+        lo = _mm_add_epi16(_mm_mullo_epi16(lo0, w0), _mm_mullo_epi16(lo1, w1));
+        hi = _mm_add_epi16(_mm_mullo_epi16(hi0, w0), _mm_mullo_epi16(hi1, w1));
+        _mm_storeu_si128((__m128i *)(sums + j), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i *)(sums + j + 4),
+                         _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i *)(sums + j + 8),
+                         _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i *)(sums + j + 12),
+                         _mm_unpackhi_epi16(hi, zero));
+    }
+    return j;
+}
+
+__attribute__((target("avx2")))
+static l_int32
+scaleGrayLILineAvx2(l_uint32       *lined,
+                    l_int32         wd,
+                    const l_int32  *sums,
+                    const l_int32  *xleft,
+                    const l_int32  *xright,
+                    const l_int32  *xfrac)
+{
+l_int32  j;
+__m256i  sixteen, half, frac, left, right, vals;
+
+    sixteen = _mm256_set1_epi32(16);
+    half = _mm256_set1_epi32(128);
+    for (j = 0; j + 7 < wd; j += 8) {
+        frac = _mm256_loadu_si256((const __m256i *)(xfrac + j));
+        left = _mm256_i32gather_epi32((const int *)sums, _mm256_loadu_si256(
+                   (const __m256i *)(xleft + j)), 4);
+        right = _mm256_i32gather_epi32((const int *)sums, _mm256_loadu_si256(
+                    (const __m256i *)(xright + j)), 4);
+        vals = _mm256_add_epi32(
+                   _mm256_mullo_epi32(_mm256_sub_epi32(sixteen, frac), left),
+                   _mm256_mullo_epi32(frac, right));
+        vals = _mm256_srli_epi32(_mm256_add_epi32(vals, half), 8);
+        storeGrayWordsSse2(lined + (j >> 2), _mm256_castsi256_si128(vals),
+                           _mm256_extracti128_si256(vals, 1));
+    }
+    return j;
+}
+
+static l_int32
+accumulateGrayLineSse2(l_uint32        *sums,
+                       l_int32          w,
+                       const l_uint32  *line,
+                       l_int32          weight)
+{
+l_int32   j;
+l_uint32  *psum;
+__m128i   wt, zero, lo, hi;
+
+    wt = _mm_set1_epi16(weight);
+    zero = _mm_setzero_si128();
+    for (j = 0; j + 15 < w; j += 16) {
+        loadGrayPixelsSse2(line + (j >> 2), &lo, &hi);
+        lo = _mm_mullo_epi16(lo, wt);
+        hi = _mm_mullo_epi16(hi, wt);
+        psum = sums + j;
+        _mm_storeu_si128((__m128i *)psum, _mm_add_epi32(
+            _mm_loadu_si128((const __m128i *)psum),
+            _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128((__m128i *)(psum + 4), _mm_add_epi32(
+            _mm_loadu_si128((const __m128i *)(psum + 4)),
+            _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128((__m128i *)(psum + 8), _mm_add_epi32(
+            _mm_loadu_si128((const __m128i *)(psum + 8)),
+            _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128((__m128i *)(psum + 12), _mm_add_epi32(
+            _mm_loadu_si128((const __m128i *)(psum + 12)),
+            _mm_unpackhi_epi16(hi, zero)));
+    }
+    return j;
+}
+
+    /* Looks up in tab the sums of the 2-bit fields of a and b at shift */
+__attribute__((target("avx2")))
+static inline __m128i
+sumPairsToGray2(__m128i  a,
+                __m128i  b,
+                l_int32  shift,
+                __m128i  tab)
+{
+__m128i  three;
+
+    three = _mm_set1_epi8(3);
+    a = _mm_and_si128(_mm_srli_epi16(a, shift), three);
+    b = _mm_and_si128(_mm_srli_epi16(b, shift), three);
+    return _mm_shuffle_epi8(tab, _mm_add_epi8(a, b));
+}
+
+__attribute__((target("avx2")))
+static l_int32
+scaleToGray2LineAvx2(l_uint32        *lined,
+                     l_int32          wd,
+                     const l_uint32  *lines,
+                     l_int32          wpls,
+                     const l_uint8   *valtab)
+{
+l_int32  j;
+__m128i  tab, ones, a, b, v0, v1, v2, v3, v32, v10;
+
+        /* Each src byte makes 4 dest pixels, which are the dest word of
+         * the same index.  The 4 values are stored in reverse, and the
+         * words in reverse by 4, as the src bytes are in memory. */
+    tab = _mm_setr_epi8(valtab[0], valtab[1], valtab[2], valtab[3],
+                        valtab[4], 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    ones = _mm_set1_epi8(0x55);
+    for (j = 0; j + 63 < wd; j += 64) {
+        a = _mm_loadu_si128((const __m128i *)(lines + (j >> 4)));
+        b = _mm_loadu_si128((const __m128i *)(lines + wpls + (j >> 4)));
+        a = _mm_add_epi8(_mm_and_si128(a, ones),
+                         _mm_and_si128(_mm_srli_epi16(a, 1), ones));
+        b = _mm_add_epi8(_mm_and_si128(b, ones),
+                         _mm_and_si128(_mm_srli_epi16(b, 1), ones));
+        v0 = sumPairsToGray2(a, b, 6, tab);
+        v1 = sumPairsToGray2(a, b, 4, tab);
+        v2 = sumPairsToGray2(a, b, 2, tab);
+        v3 = sumPairsToGray2(a, b, 0, tab);
+        v32 = _mm_unpacklo_epi8(v3, v2);
+        v10 = _mm_unpacklo_epi8(v1, v0);
+        _mm_storeu_si128((__m128i *)(lined + (j >> 2)), _mm_shuffle_epi32(
+            _mm_unpacklo_epi16(v32, v10), _MM_SHUFFLE(0, 1, 2, 3)));
+        _mm_storeu_si128((__m128i *)(lined + (j >> 2) + 4), _mm_shuffle_epi32(
+            _mm_unpackhi_epi16(v32, v10), _MM_SHUFFLE(0, 1, 2, 3)));
+        v32 = _mm_unpackhi_epi8(v3, v2);
+        v10 = _mm_unpackhi_epi8(v1, v0);
+        _mm_storeu_si128((__m128i *)(lined + (j >> 2) + 8), _mm_shuffle_epi32(
+            _mm_unpacklo_epi16(v32, v10), _MM_SHUFFLE(0, 1, 2, 3)));
+        _mm_storeu_si128((__m128i *)(lined + (j >> 2) + 12), _mm_shuffle_epi32(
+            _mm_unpackhi_epi16(v32, v10), _MM_SHUFFLE(0, 1, 2, 3)));
+    }
+    return j;
+}
+
+static l_int32
+countPixelsLineSse2(const l_uint32  *line,
+                    l_int32          w,
+                    l_int32         *pcount)
+{
+l_int32  j;
+__m128i  m1, m2, m4, zero, sum, v;
+
+    m1 = _mm_set1_epi8(0x55);
+    m2 = _mm_set1_epi8(0x33);
+    m4 = _mm_set1_epi8(0x0f);
+    zero = _mm_setzero_si128();
+    sum = _mm_setzero_si128();
+    for (j = 0; j + 127 < w; j += 128) {
+        v = _mm_loadu_si128((const __m128i *)(line + (j >> 5)));
+        v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+        v = _mm_add_epi8(_mm_and_si128(v, m2),
+                         _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+        v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+    }
+    *pcount = _mm_cvtsi128_si32(sum) +
+              _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+    return j;
+}
+
+__attribute__((target("avx2")))
+static l_int32
+countPixelsLineAvx2(const l_uint32  *line,
+                    l_int32          w,
+                    l_int32         *pcount)
+{
+l_int32  j;
+__m128i  sum128;
+__m256i  tab, m4, zero, sum, v;
+
+    tab = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    m4 = _mm256_set1_epi8(0x0f);
+    zero = _mm256_setzero_si256();
+    sum = _mm256_setzero_si256();
+    for (j = 0; j + 255 < w; j += 256) {
+        v = _mm256_loadu_si256((const __m256i *)(line + (j >> 5)));
+        v = _mm256_add_epi8(
+                _mm256_shuffle_epi8(tab, _mm256_and_si256(v, m4)),
+                _mm256_shuffle_epi8(tab, _mm256_and_si256(
+                    _mm256_srli_epi16(v, 4), m4)));
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(v, zero));
+    }
+    sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum),
+                           _mm256_extracti128_si256(sum, 1));
+    *pcount = _mm_cvtsi128_si32(sum128) +
+              _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum128, sum128));
+    if (j + 127 < w) {  /* one more SSE2 vector */
+        l_int32  count;
+        j += countPixelsLineSse2(line + (j >> 5), 128, &count);
+        *pcount += count;
+    }
+    return j;
+}
+
+    /* Scales 8 bytes, as 16-bit values, by 8 factors.  The product has
+     * more than 16 bits only when it is 65536 or more, and then the
+     * result is 255. */
+static inline __m128i
+scaleBytesSse2(__m128i  vals,
+               __m128i  facs)
+{
+__m128i  lo, over;
+
+    lo = _mm_srli_epi16(_mm_mullo_epi16(vals, facs), 8);
+    over = _mm_cmpeq_epi16(_mm_mulhi_epu16(vals, facs), _mm_setzero_si128());
+    return _mm_or_si128(lo, _mm_andnot_si128(over, _mm_set1_epi16(255)));
+}
+
+static l_int32
+scaleBytesLineSse2(l_uint32        *lined,
+                   const l_uint32  *lines,
+                   const l_uint16  *factors,
+                   l_int32          nbytes)
+{
+l_int32  j;
+__m128i  bytes, lo, hi, zero;
+
+    zero = _mm_setzero_si128();
+    for (j = 0; j + 15 < nbytes; j += 16) {
+        bytes = _mm_loadu_si128((const __m128i *)(lines + (j >> 2)));
+        lo = scaleBytesSse2(_mm_unpacklo_epi8(bytes, zero),
+                 _mm_loadu_si128((const __m128i *)(factors + j)));
+        hi = scaleBytesSse2(_mm_unpackhi_epi8(bytes, zero),
+                 _mm_loadu_si128((const __m128i *)(factors + j + 8)));
+        _mm_storeu_si128((__m128i *)(lined + (j >> 2)),
+                         _mm_packus_epi16(lo, hi));
+    }
+    return j;
+}
+
+__attribute__((target("avx2")))
+static l_int32
+scaleBytesLineAvx2(l_uint32        *lined,
+                   const l_uint32  *lines,
+                   const l_uint16  *factors,
+                   l_int32          nbytes)
+{
+l_int32  j;
+__m256i  vals, facs, lo, hi, over, mask, zero;
+
+    mask = _mm256_set1_epi16(255);
+    zero = _mm256_setzero_si256();
+    for (j = 0; j + 31 < nbytes; j += 32) {
+        vals = _mm256_cvtepu8_epi16(
+                   _mm_loadu_si128((const __m128i *)(lines + (j >> 2))));
+        facs = _mm256_loadu_si256((const __m256i *)(factors + j));
+        lo = _mm256_srli_epi16(_mm256_mullo_epi16(vals, facs), 8);
+        over = _mm256_cmpeq_epi16(_mm256_mulhi_epu16(vals, facs), zero);
+        lo = _mm256_or_si256(lo, _mm256_andnot_si256(over, mask));
+        vals = _mm256_cvtepu8_epi16(
+                   _mm_loadu_si128((const __m128i *)(lines + (j >> 2) + 4)));
+        facs = _mm256_loadu_si256((const __m256i *)(factors + j + 16));
+        hi = _mm256_srli_epi16(_mm256_mullo_epi16(vals, facs), 8);
+        over = _mm256_cmpeq_epi16(_mm256_mulhi_epu16(vals, facs), zero);
+        hi = _mm256_or_si256(hi, _mm256_andnot_si256(over, mask));
+            /* packus works within 128-bit lanes */
+        _mm256_storeu_si256((__m256i *)(lined + (j >> 2)),
+                            _mm256_permute4x64_epi64(
+                                _mm256_packus_epi16(lo, hi),
+                                _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    return j;
+}
+
+    /* The 8x8 blocks of bytes are transposed in memory order.  Byte k
+     * of a line holds pixel k ^ 3, so the src lines are taken in the
+     * order k ^ 3 and the transposed lines stored in that order too,
+     * which together transpose the pixels. */
+static void
+transposeTile8Sse2(l_uint32        *datad,
+                   l_int32          wpld,
+                   const l_uint32  *datas,
+                   l_int32          wpls,
+                   l_int32          size)
+{
+l_int32          i, j, k;
+const l_uint32  *lines;
+l_uint32        *lined;
+__m128i          r[8], a0, a1, a2, a3, b0, b1, b2, b3, c[4];
+
+    for (i = 0; i < size; i += 8) {
+        for (j = 0; j < size; j += 8) {
+            lines = datas + j * wpls + (i >> 2);
+            for (k = 0; k < 8; k++)
+                r[k] = _mm_loadl_epi64(
+                           (const __m128i *)(lines + (k ^ 3) * wpls));
+            a0 = _mm_unpacklo_epi8(r[0], r[1]);
+            a1 = _mm_unpacklo_epi8(r[2], r[3]);
+            a2 = _mm_unpacklo_epi8(r[4], r[5]);
+            a3 = _mm_unpacklo_epi8(r[6], r[7]);
+            b0 = _mm_unpacklo_epi16(a0, a1);
+            b1 = _mm_unpackhi_epi16(a0, a1);
+            b2 = _mm_unpacklo_epi16(a2, a3);
+            b3 = _mm_unpackhi_epi16(a2, a3);
+            c[0] = _mm_unpacklo_epi32(b0, b2);
+            c[1] = _mm_unpackhi_epi32(b0, b2);
+            c[2] = _mm_unpacklo_epi32(b1, b3);
+            c[3] = _mm_unpackhi_epi32(b1, b3);
+            lined = datad + i * wpld + (j >> 2);
+            for (k = 0; k < 8; k += 2) {
+                _mm_storel_epi64((__m128i *)(lined + (k ^ 3) * wpld),
+                                 c[k >> 1]);
+                _mm_storel_epi64((__m128i *)(lined + ((k + 1) ^ 3) * wpld),
+                                 _mm_unpackhi_epi64(c[k >> 1], c[k >> 1]));
+            }
+        }
+    }
+}
+
+static void
+transposeTile32Sse2(l_uint32        *datad,
+                    l_int32          wpld,
+                    const l_uint32  *datas,
+                    l_int32          wpls,
+                    l_int32          size)
+{
+l_int32          i, j;
+const l_uint32  *lines;
+l_uint32        *lined;
+__m128i          r0, r1, r2, r3, t0, t1, t2, t3;
+
+    for (i = 0; i < size; i += 4) {
+        for (j = 0; j < size; j += 4) {
+            lines = datas + j * wpls + i;
+            r0 = _mm_loadu_si128((const __m128i *)lines);
+            r1 = _mm_loadu_si128((const __m128i *)(lines + wpls));
+            r2 = _mm_loadu_si128((const __m128i *)(lines + 2 * wpls));
+            r3 = _mm_loadu_si128((const __m128i *)(lines + 3 * wpls));
+            t0 = _mm_unpacklo_epi32(r0, r1);
+            t1 = _mm_unpacklo_epi32(r2, r3);
+            t2 = _mm_unpackhi_epi32(r0, r1);
+            t3 = _mm_unpackhi_epi32(r2, r3);
+            lined = datad + i * wpld + j;
+            _mm_storeu_si128((__m128i *)lined, _mm_unpacklo_epi64(t0, t1));
+            _mm_storeu_si128((__m128i *)(lined + wpld),
+                             _mm_unpackhi_epi64(t0, t1));
+            _mm_storeu_si128((__m128i *)(lined + 2 * wpld),
+                             _mm_unpacklo_epi64(t2, t3));
+            _mm_storeu_si128((__m128i *)(lined + 3 * wpld),
+                             _mm_unpackhi_epi64(t2, t3));
+        }
+    }
+}
+
+static l_int32
+rasteropLineSse2(l_uint32        *lined,
+                 const l_uint32  *lines,
+                 l_int32          nwords,
+                 l_int32          shift,
+                 l_int32          comb,
+                 l_uint32         sinv,
+                 l_uint32         dinv,
+                 l_uint32         rinv)
+{
+l_int32  j;
+__m128i  vsinv, vdinv, vrinv, lcount, rcount, s, d;
+
+    vsinv = _mm_set1_epi32(sinv);
+    vdinv = _mm_set1_epi32(dinv);
+    vrinv = _mm_set1_epi32(rinv);
+    lcount = _mm_cvtsi32_si128(shift);
+    rcount = _mm_cvtsi32_si128(32 - shift);
+    for (j = 0; j + 3 < nwords; j += 4) {
+        s = _mm_loadu_si128((const __m128i *)(lines + j));
+        if (shift) {
+            s = _mm_or_si128(_mm_sll_epi32(s, lcount),
+                    _mm_srl_epi32(
+                        _mm_loadu_si128((const __m128i *)(lines + j + 1)),
+                        rcount));
+        }
+        s = _mm_xor_si128(s, vsinv);
+        if (comb != ROP_COMB_COPY) {
+            d = _mm_xor_si128(
+                    _mm_loadu_si128((const __m128i *)(lined + j)), vdinv);
+            if (comb == ROP_COMB_AND)
+                s = _mm_and_si128(s, d);
+            else if (comb == ROP_COMB_OR)
+                s = _mm_or_si128(s, d);
+            else
+                s = _mm_xor_si128(s, d);
+        }
+        _mm_storeu_si128((__m128i *)(lined + j), _mm_xor_si128(s, vrinv));
+    }
+    return j;
+}
+
+__attribute__((target("avx2")))
+static l_int32
+rasteropLineAvx2(l_uint32        *lined,
+                 const l_uint32  *lines,
+                 l_int32          nwords,
+                 l_int32          shift,
+                 l_int32          comb,
+                 l_uint32         sinv,
+                 l_uint32         dinv,
+                 l_uint32         rinv)
+{
+l_int32  j;
+__m128i  lcount, rcount;
+__m256i  vsinv, vdinv, vrinv, s, d;
+
+    vsinv = _mm256_set1_epi32(sinv);
+    vdinv = _mm256_set1_epi32(dinv);
+    vrinv = _mm256_set1_epi32(rinv);
+    lcount = _mm_cvtsi32_si128(shift);
+    rcount = _mm_cvtsi32_si128(32 - shift);
+    for (j = 0; j + 7 < nwords; j += 8) {
+        s = _mm256_loadu_si256((const __m256i *)(lines + j));
+        if (shift) {
+            s = _mm256_or_si256(_mm256_sll_epi32(s, lcount),
+                    _mm256_srl_epi32(
+                        _mm256_loadu_si256((const __m256i *)(lines + j + 1)),
+                        rcount));
+        }
+        s = _mm256_xor_si256(s, vsinv);
+        if (comb != ROP_COMB_COPY) {
+            d = _mm256_xor_si256(
+                    _mm256_loadu_si256((const __m256i *)(lined + j)), vdinv);
+            if (comb == ROP_COMB_AND)
+                s = _mm256_and_si256(s, d);
+            else if (comb == ROP_COMB_OR)
+                s = _mm256_or_si256(s, d);
+            else
+                s = _mm256_xor_si256(s, d);
+        }
+        _mm256_storeu_si256((__m256i *)(lined + j),
+                            _mm256_xor_si256(s, vrinv));
+    }
+    if (j + 3 < nwords)  /* one more SSE2 vector */
+        j += rasteropLineSse2(lined + j, lines + j, 4, shift, comb,
+                              sinv, dinv, rinv);
+    return j;
+}
+#endif  /* HAVE_X86_SIMD */
@@ -47,6 +47,7 @@
  *
  *      Differential square sum function for scoring
  *          l_int32    pixFindDifferentialSquareSum()
+ *          static l_int32  pixFindShearScores()
  *
  *      Measures of variance of row sums
  *          l_int32    pixFindNormalizedSquareSum()
@@ -91,9 +92,17 @@
  *      significantly over the page.  Local skew determination
  *      is not very important except for locating lines of
  *      handwritten text that may be mixed with printed text.
+ *
+ *      With OpenMP, the scores of the sweep, and the two new scores of
+ *      each step of the binary search, are computed at the same time,
+ *      each thread shearing into its own image.  The scores, and thus
+ *      the angles found, are the same as with a single thread.
  * </pre>
  */
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif  /* _OPENMP */
 #include <math.h>
 #include "allheaders.h"
 
@@ -128,6 +137,9 @@ static const l_float32  MINSCORE_THRESHOLD_CONSTANT = 0.000002;
     /* Default binarization threshold value */
 static const l_int32  DEFAULT_BINARY_THRESHOLD = 130;
 
+static l_int32 pixFindShearScores(PIX *pixs, l_int32 pivot, l_int32 nangles,
+                                  const l_float32 *angles, l_float32 *scores);
+
 #ifndef  NO_CONSOLE_IO
 #define  DEBUG_PRINT_SCORES     0
 #define  DEBUG_PRINT_SWEEP      0
@@ -417,11 +429,11 @@ pixFindSkewSweep(PIX        *pixs,
                  l_float32   sweeprange,
                  l_float32   sweepdelta)
 {
-l_int32    ret, bzero, i, nangles;
-l_float32  deg2rad, theta;
-l_float32  sum, maxscore, maxangle;
-NUMA      *natheta, *nascore;
-PIX       *pix, *pixt;
+l_int32     ret, bzero, i, nangles;
+l_float32   maxscore, maxangle;
+l_float32  *thetas, *scores;
+NUMA       *natheta, *nascore;
+PIX        *pix;
 
     PROCNAME("pixFindSkewSweep");
 
@@ -435,7 +447,6 @@ PIX       *pix, *pixt;
     if (reduction != 1 && reduction != 2 && reduction != 4 && reduction != 8)
         return ERROR_INT("reduction must be in {1,2,4,8}", procName, 1);
 
-    deg2rad = 3.1415926535 / 180.;
     ret = 0;
 
         /* Generate reduced image, if requested */
@@ -457,33 +468,35 @@ PIX       *pix, *pixt;
     nangles = (l_int32)((2. * sweeprange) / sweepdelta + 1);
     natheta = numaCreate(nangles);
     nascore = numaCreate(nangles);
-    pixt = pixCreateTemplate(pix);
+    thetas = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
+    scores = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
 
-    if (!pix || !pixt) {
-        ret = ERROR_INT("pix and pixt not both made", procName, 1);
+    if (!pix) {
+        ret = ERROR_INT("pix not made", procName, 1);
         goto cleanup;
     }
-    if (!natheta || !nascore) {
-        ret = ERROR_INT("natheta and nascore not both made", procName, 1);
+    if (!natheta || !nascore || !thetas || !scores) {
+        ret = ERROR_INT("angle and score arrays not all made", procName, 1);
         goto cleanup;
     }
 
-    for (i = 0; i < nangles; i++) {
-        theta = -sweeprange + i * sweepdelta;   /* degrees */
-
-            /* Shear pix about the UL corner and put the result in pixt */
-        pixVShearCorner(pixt, pix, deg2rad * theta, L_BRING_IN_WHITE);
-
-            /* Get score */
-        pixFindDifferentialSquareSum(pixt, &sum);
+        /* Get the scores, shearing pix about the UL corner */
+    for (i = 0; i < nangles; i++)
+        thetas[i] = -sweeprange + i * sweepdelta;   /* degrees */
+    if (pixFindShearScores(pix, L_SHEAR_ABOUT_CORNER, nangles, thetas,
+                           scores)) {
+        ret = ERROR_INT("scores not found", procName, 1);
+        goto cleanup;
+    }
 
+    for (i = 0; i < nangles; i++) {
 #if  DEBUG_PRINT_SCORES
-        L_INFO("sum(%7.2f) = %7.0f\n", procName, theta, sum);
+        L_INFO("sum(%7.2f) = %7.0f\n", procName, thetas[i], scores[i]);
 #endif  /* DEBUG_PRINT_SCORES */
 
             /* Save the result in the output arrays */
-        numaAddNumber(nascore, sum);
-        numaAddNumber(natheta, theta);
+        numaAddNumber(nascore, scores[i]);
+        numaAddNumber(natheta, thetas[i]);
     }
 
         /* Find the location of the maximum (i.e., the skew angle)
@@ -519,7 +532,8 @@ PIX       *pix, *pixt;
 
 cleanup:
     pixDestroy(&pix);
-    pixDestroy(&pixt);
+    LEPT_FREE(thetas);
+    LEPT_FREE(scores);
     numaDestroy(&nascore);
     numaDestroy(&natheta);
     return ret;
@@ -670,17 +684,19 @@ pixFindSkewSweepAndSearchScorePivot(PIX        *pixs,
                                     l_float32   minbsdelta,
                                     l_int32     pivot)
 {
-l_int32    ret, bzero, i, nangles, n, ratio, maxindex, minloc;
-l_int32    width, height;
-l_float32  deg2rad, theta, delta;
-l_float32  sum, maxscore, maxangle;
-l_float32  centerangle, leftcenterangle, rightcenterangle;
-l_float32  lefttemp, righttemp;
-l_float32  bsearchscore[5];
-l_float32  minscore, minthresh;
-l_float32  rangeleft;
-NUMA      *natheta, *nascore;
-PIX       *pixsw, *pixsch, *pixt1, *pixt2;
+l_int32     ret, bzero, i, nangles, n, ratio, maxindex, minloc;
+l_int32     width, height;
+l_float32   delta;
+l_float32   maxscore, maxangle;
+l_float32   centerangle, leftcenterangle, rightcenterangle;
+l_float32   lefttemp, righttemp;
+l_float32   bsearchscore[5];
+l_float32   bsangles[3], bsscores[3];
+l_float32   minscore, minthresh;
+l_float32   rangeleft;
+l_float32  *thetas, *scores;
+NUMA       *natheta, *nascore;
+PIX        *pixsw, *pixsch;
 
     PROCNAME("pixFindSkewSweepAndSearchScorePivot");
 
@@ -700,7 +716,6 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
     if (pivot != L_SHEAR_ABOUT_CORNER && pivot != L_SHEAR_ABOUT_CENTER)
         return ERROR_INT("invalid pivot", procName, 1);
 
-    deg2rad = 3.1415926535 / 180.;
     ret = 0;
 
         /* Generate reduced image for binary search, if requested */
@@ -732,50 +747,38 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
             pixsw = pixReduceRankBinaryCascade(pixsch, 1, 2, 2, 0);
     }
 
-    pixt1 = pixCreateTemplate(pixsw);
-    if (ratio == 1)
-        pixt2 = pixClone(pixt1);
-    else
-        pixt2 = pixCreateTemplate(pixsch);
-
     nangles = (l_int32)((2. * sweeprange) / sweepdelta + 1);
     natheta = numaCreate(nangles);
     nascore = numaCreate(nangles);
+    thetas = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
+    scores = (l_float32 *)LEPT_CALLOC(nangles, sizeof(l_float32));
 
     if (!pixsch || !pixsw) {
         ret = ERROR_INT("pixsch and pixsw not both made", procName, 1);
         goto cleanup;
     }
-    if (!pixt1 || !pixt2) {
-        ret = ERROR_INT("pixt1 and pixt2 not both made", procName, 1);
-        goto cleanup;
-    }
-    if (!natheta || !nascore) {
-        ret = ERROR_INT("natheta and nascore not both made", procName, 1);
+    if (!natheta || !nascore || !thetas || !scores) {
+        ret = ERROR_INT("angle and score arrays not all made", procName, 1);
         goto cleanup;
     }
 
         /* Do sweep */
     rangeleft = sweepcenter - sweeprange;
-    for (i = 0; i < nangles; i++) {
-        theta = rangeleft + i * sweepdelta;   /* degrees */
-
-            /* Shear pix and put the result in pixt1 */
-        if (pivot == L_SHEAR_ABOUT_CORNER)
-            pixVShearCorner(pixt1, pixsw, deg2rad * theta, L_BRING_IN_WHITE);
-        else
-            pixVShearCenter(pixt1, pixsw, deg2rad * theta, L_BRING_IN_WHITE);
-
-            /* Get score */
-        pixFindDifferentialSquareSum(pixt1, &sum);
+    for (i = 0; i < nangles; i++)
+        thetas[i] = rangeleft + i * sweepdelta;   /* degrees */
+    if (pixFindShearScores(pixsw, pivot, nangles, thetas, scores)) {
+        ret = ERROR_INT("sweep scores not found", procName, 1);
+        goto cleanup;
+    }
 
+    for (i = 0; i < nangles; i++) {
 #if  DEBUG_PRINT_SCORES
-        L_INFO("sum(%7.2f) = %7.0f\n", procName, theta, sum);
+        L_INFO("sum(%7.2f) = %7.0f\n", procName, thetas[i], scores[i]);
 #endif  /* DEBUG_PRINT_SCORES */
 
             /* Save the result in the output arrays */
-        numaAddNumber(nascore, sum);
-        numaAddNumber(natheta, theta);
+        numaAddNumber(nascore, scores[i]);
+        numaAddNumber(natheta, thetas[i]);
     }
 
         /* Find the largest of the set (maxscore at maxangle) */
@@ -815,25 +818,16 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
         /* Do binary search to find skew angle.
          * First, set up initial three points. */
     centerangle = maxangle;
-    if (pivot == L_SHEAR_ABOUT_CORNER) {
-        pixVShearCorner(pixt2, pixsch, deg2rad * centerangle, L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[2]);
-        pixVShearCorner(pixt2, pixsch, deg2rad * (centerangle - sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[0]);
-        pixVShearCorner(pixt2, pixsch, deg2rad * (centerangle + sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[4]);
-    } else {
-        pixVShearCenter(pixt2, pixsch, deg2rad * centerangle, L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[2]);
-        pixVShearCenter(pixt2, pixsch, deg2rad * (centerangle - sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[0]);
-        pixVShearCenter(pixt2, pixsch, deg2rad * (centerangle + sweepdelta),
-                        L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[4]);
+    bsangles[0] = centerangle;
+    bsangles[1] = centerangle - sweepdelta;
+    bsangles[2] = centerangle + sweepdelta;
+    if (pixFindShearScores(pixsch, pivot, 3, bsangles, bsscores)) {
+        ret = ERROR_INT("search scores not found", procName, 1);
+        goto cleanup;
     }
+    bsearchscore[2] = bsscores[0];
+    bsearchscore[0] = bsscores[1];
+    bsearchscore[4] = bsscores[2];
 
     numaAddNumber(nascore, bsearchscore[2]);
     numaAddNumber(natheta, centerangle);
@@ -846,27 +840,19 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
     delta = 0.5 * sweepdelta;
     while (delta >= minbsdelta)
     {
-            /* Get the left intermediate score */
+            /* Get the left and right intermediate scores */
         leftcenterangle = centerangle - delta;
-        if (pivot == L_SHEAR_ABOUT_CORNER)
-            pixVShearCorner(pixt2, pixsch, deg2rad * leftcenterangle,
-                            L_BRING_IN_WHITE);
-        else
-            pixVShearCenter(pixt2, pixsch, deg2rad * leftcenterangle,
-                            L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[1]);
+        rightcenterangle = centerangle + delta;
+        bsangles[0] = leftcenterangle;
+        bsangles[1] = rightcenterangle;
+        if (pixFindShearScores(pixsch, pivot, 2, bsangles, bsscores)) {
+            ret = ERROR_INT("search scores not found", procName, 1);
+            goto cleanup;
+        }
+        bsearchscore[1] = bsscores[0];
+        bsearchscore[3] = bsscores[1];
         numaAddNumber(nascore, bsearchscore[1]);
         numaAddNumber(natheta, leftcenterangle);
-
-            /* Get the right intermediate score */
-        rightcenterangle = centerangle + delta;
-        if (pivot == L_SHEAR_ABOUT_CORNER)
-            pixVShearCorner(pixt2, pixsch, deg2rad * rightcenterangle,
-                            L_BRING_IN_WHITE);
-        else
-            pixVShearCenter(pixt2, pixsch, deg2rad * rightcenterangle,
-                            L_BRING_IN_WHITE);
-        pixFindDifferentialSquareSum(pixt2, &bsearchscore[3]);
         numaAddNumber(nascore, bsearchscore[3]);
         numaAddNumber(natheta, rightcenterangle);
 
@@ -960,8 +946,8 @@ PIX       *pixsw, *pixsch, *pixt1, *pixt2;
 cleanup:
     pixDestroy(&pixsw);
     pixDestroy(&pixsch);
-    pixDestroy(&pixt1);
-    pixDestroy(&pixt2);
+    LEPT_FREE(thetas);
+    LEPT_FREE(scores);
     numaDestroy(&nascore);
     numaDestroy(&natheta);
     return ret;
@@ -1148,6 +1134,75 @@ NUMA      *na;
 }
 
 
+/*!
+ * \brief   pixFindShearScores()
+ *
+ * \param[in]    pixs  1 bpp
+ * \param[in]    pivot  L_SHEAR_ABOUT_CORNER, L_SHEAR_ABOUT_CENTER
+ * \param[in]    nangles  number of angles
+ * \param[in]    angles  vertical shear angles; in degrees
+ * \param[out]   scores  differential square sum at each angle
+ * \return  0 if OK, 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) With OpenMP, the angles are shared among up to %nangles
+ *          threads, each of which shears pixs into its own image.
+ *      (2) Each score is that of pixFindDifferentialSquareSum() on pixs
+ *          sheared by pixVShearCorner() or pixVShearCenter().
+ * </pre>
+ */
+static l_int32
+pixFindShearScores(PIX              *pixs,
+                   l_int32           pivot,
+                   l_int32           nangles,
+                   const l_float32  *angles,
+                   l_float32        *scores)
+{
+l_int32    i, nthreads, error;
+l_float32  deg2rad;
+
+    PROCNAME("pixFindShearScores");
+
+    deg2rad = 3.1415926535 / 180.;
+    nthreads = 1;
+#ifdef _OPENMP
+    nthreads = L_MAX(1, L_MIN(omp_get_max_threads(), nangles));
+#endif  /* _OPENMP */
+
+    error = 0;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) if (nthreads > 1) \
+                     private(i) reduction(|:error)
+#endif  /* _OPENMP */
+    {
+    PIX  *pixt;
+
+        if ((pixt = pixCreateTemplate(pixs)) == NULL)
+            error = 1;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif  /* _OPENMP */
+        for (i = 0; i < nangles; i++) {
+            scores[i] = 0.0;
+            if (!pixt) continue;
+            if (pivot == L_SHEAR_ABOUT_CORNER)
+                pixVShearCorner(pixt, pixs, deg2rad * angles[i],
+                                L_BRING_IN_WHITE);
+            else
+                pixVShearCenter(pixt, pixs, deg2rad * angles[i],
+                                L_BRING_IN_WHITE);
+            error |= pixFindDifferentialSquareSum(pixt, &scores[i]);
+        }
+        pixDestroy(&pixt);
+    }
+
+    if (error)
+        return ERROR_INT("shear scores not all made", procName, 1);
+    return 0;
+}
+
+
 /*----------------------------------------------------------------*
  *                        Normalized square sum                   *
  *----------------------------------------------------------------*/
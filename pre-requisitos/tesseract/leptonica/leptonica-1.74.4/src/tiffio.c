@@ -80,11 +80,19 @@
  *             [10 static helper functions]
  *             PIX       *pixReadMemTiff();
  *             PIX       *pixReadMemFromMultipageTiff();
+ *             PIX       *pixReadMemTiffPage();
  *             PIXA      *pixaReadMemMultipageTiff()    [ special top level ]
  *             l_int32    pixaWriteMemMultipageTiff()   [ special top level ]
  *             l_int32    pixWriteMemTiff();
  *             l_int32    pixWriteMemTiffCustom();
  *
+ *     Page index of multipage tiff (does not need libtiff)
+ *             l_int32    tiffGetPageIndex()
+ *             l_int32    tiffGetPageIndexMem()
+ *      static l_int32    tiffIndexPages()
+ *      static l_int32    tiffIndexRead()
+ *      static l_uint64   tiffIndexValue()
+ *
  *  Note:  To include all necessary functions, use libtiff version 3.7.4
  *         (or later)
  *  Note:  On Windows with 2 bpp or 4 bpp images, the bytes in the
@@ -101,6 +109,7 @@
 #endif  /* HAVE_CONFIG_H */
 
 #include <string.h>
+#include <limits.h>
 #include <sys/types.h>
 #ifndef _MSC_VER
 #include <unistd.h>
@@ -959,6 +968,11 @@ char      *text;
         TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
     } else if (comptype == IFF_TIFF_ZIP) {
         TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_ADOBE_DEFLATE);
+            /* The zlib level follows the png write of the pix */
+        if (pix->special >= 10 && pix->special < 20)
+            TIFFSetField(tif, TIFFTAG_ZIPQUALITY, pix->special - 10);
+        else if (pix->special == L_FAST_ZLIB_ENCODE)
+            TIFFSetField(tif, TIFFTAG_ZIPQUALITY, 1);
     } else {
         L_WARNING("unknown tiff compression; using none\n", procName);
         TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
@@ -2535,6 +2549,56 @@ TIFF     *tif;
 }
 
 
+/*!
+ * \brief   pixReadMemTiffPage()
+ *
+ * \param[in]    cdata      const; tiff-encoded
+ * \param[in]    size       size of cdata
+ * \param[in]    offset     directory offset of the page; 0 for the first
+ * \return  pix, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This reads the page whose directory is at %offset, as given
+ *          by tiffGetPageIndexMem(), without reading any other
+ *          directory.
+ *      (2) The data is only read, and each call has its own tiff
+ *          stream, so several threads can read different pages of the
+ *          same data at once.
+ * </pre>
+ */
+PIX *
+pixReadMemTiffPage(const l_uint8  *cdata,
+                   size_t          size,
+                   size_t          offset)
+{
+l_uint8  *data;
+l_int32   retval;
+PIX      *pix;
+TIFF     *tif;
+
+    PROCNAME("pixReadMemTiffPage");
+
+    if (!cdata)
+        return (PIX *)ERROR_PTR("cdata not defined", procName, NULL);
+
+    data = (l_uint8 *)cdata;  /* we're really not going to change this */
+    if ((tif = fopenTiffMemstream("tifferror", "r", &data, &size)) == NULL)
+        return (PIX *)ERROR_PTR("tiff stream not opened", procName, NULL);
+
+    retval = (offset == 0) ? TIFFSetDirectory(tif, 0)
+                           : TIFFSetSubDirectory(tif, offset);
+    pix = NULL;
+    if (retval != 0 && (pix = pixReadFromTiffStream(tif)) != NULL)
+        pixSetInputFormat(pix, IFF_TIFF);
+    TIFFClose(tif);
+    if (!pix)
+        L_ERROR("page at offset %lu not read\n", procName,
+                (unsigned long)offset);
+    return pix;
+}
+
+
 /*!
  * \brief   pixaReadMemMultipageTiff()
  *
@@ -2723,3 +2787,277 @@ TIFF    *tif;
 /* --------------------------------------------*/
 #endif  /* HAVE_LIBTIFF */
 /* --------------------------------------------*/
+
+
+/*--------------------------------------------------------------*
+ *      Page index of multipage tiff (does not need libtiff)    *
+ *--------------------------------------------------------------*/
+static l_int32   tiffIndexPages(FILE *fp, const l_uint8 *cdata, size_t size,
+                                L_DNA **pdaoffset, NUMA **pnaw, NUMA **pnah);
+static l_int32   tiffIndexRead(FILE *fp, const l_uint8 *cdata, size_t size,
+                               l_uint64 offset, l_uint8 *buf, size_t nbytes);
+static l_uint64  tiffIndexValue(const l_uint8 *buf, l_int32 nbytes,
+                                l_int32 bigend);
+
+    /* Largest number of entries taken in an image directory */
+static const l_uint64  MAX_TIFF_DIR_ENTRIES = 65535;
+
+
+/*!
+ * \brief   tiffGetPageIndex()
+ *
+ * \param[in]    fp           file stream opened for read
+ * \param[out]   pdaoffset    directory offset of each page
+ * \param[out]   pnaw         [optional] width of each page
+ * \param[out]   pnah         [optional] height of each page
+ * \return  0 if OK; 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This reads the chain of image directories once.  Each offset
+ *          can then be given to pixReadFromMultipageTiff() to read that
+ *          page, without going through the directories before it.
+ *      (2) Only the directories are read, for both classic and BigTIFF
+ *          files in either byte order, so this works without libtiff.
+ *      (3) A chain that loops back, or a directory that can't be read
+ *          after the first, ends the index with a warning; libtiff
+ *          also stops reading pages there.
+ * </pre>
+ */
+l_int32
+tiffGetPageIndex(FILE    *fp,
+                 L_DNA  **pdaoffset,
+                 NUMA   **pnaw,
+                 NUMA   **pnah)
+{
+    PROCNAME("tiffGetPageIndex");
+
+    if (pnaw) *pnaw = NULL;
+    if (pnah) *pnah = NULL;
+    if (!pdaoffset)
+        return ERROR_INT("&daoffset not defined", procName, 1);
+    *pdaoffset = NULL;
+    if (!fp)
+        return ERROR_INT("stream not defined", procName, 1);
+
+    return tiffIndexPages(fp, NULL, 0, pdaoffset, pnaw, pnah);
+}
+
+
+/*!
+ * \brief   tiffGetPageIndexMem()
+ *
+ * \param[in]    cdata        const; tiff-encoded
+ * \param[in]    size         size of cdata
+ * \param[out]   pdaoffset    directory offset of each page
+ * \param[out]   pnaw         [optional] width of each page
+ * \param[out]   pnah         [optional] height of each page
+ * \return  0 if OK; 1 on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This is the read-from-memory version of tiffGetPageIndex().
+ *          Page i can then be read on any thread, in any order, with
+ *            l_dnaGetDValue(daoffset, i, &val);
+ *            pix = pixReadMemTiffPage(cdata, size, (size_t)val);
+ * </pre>
+ */
+l_int32
+tiffGetPageIndexMem(const l_uint8  *cdata,
+                    size_t          size,
+                    L_DNA         **pdaoffset,
+                    NUMA          **pnaw,
+                    NUMA          **pnah)
+{
+    PROCNAME("tiffGetPageIndexMem");
+
+    if (pnaw) *pnaw = NULL;
+    if (pnah) *pnah = NULL;
+    if (!pdaoffset)
+        return ERROR_INT("&daoffset not defined", procName, 1);
+    *pdaoffset = NULL;
+    if (!cdata)
+        return ERROR_INT("cdata not defined", procName, 1);
+
+    return tiffIndexPages(NULL, cdata, size, pdaoffset, pnaw, pnah);
+}
+
+
+/*!
+ * \brief   tiffIndexPages()
+ *
+ * \param[in]    fp           [optional] file stream opened for read
+ * \param[in]    cdata        [optional] tiff-encoded; used if fp is NULL
+ * \param[in]    size         size of cdata
+ * \param[out]   pdaoffset    directory offset of each page
+ * \param[out]   pnaw         [optional] width of each page
+ * \param[out]   pnah         [optional] height of each page
+ * \return  0 if OK; 1 on error
+ */
+static l_int32
+tiffIndexPages(FILE           *fp,
+               const l_uint8  *cdata,
+               size_t          size,
+               L_DNA         **pdaoffset,
+               NUMA          **pnaw,
+               NUMA          **pnah)
+{
+l_uint8   header[16];
+l_uint8  *dir, *entry;
+l_int32   bigend, countsize, entrysize, offsize, tag, type;
+l_uint64  offset, i, nentries, dirsize, w, h, val;
+L_ASET   *seen;
+L_DNA    *da;
+RB_TYPE   key;
+
+    PROCNAME("tiffIndexPages");
+
+    if (tiffIndexRead(fp, cdata, size, 0, header, 8))
+        return ERROR_INT("header not read", procName, 1);
+    if (header[0] == 'I' && header[1] == 'I')
+        bigend = 0;
+    else if (header[0] == 'M' && header[1] == 'M')
+        bigend = 1;
+    else
+        return ERROR_INT("not a tiff file", procName, 1);
+    if (tiffIndexValue(header + 2, 2, bigend) == 42) {  /* classic */
+        countsize = 2;
+        entrysize = 12;
+        offsize = 4;
+        offset = tiffIndexValue(header + 4, 4, bigend);
+    } else if (tiffIndexValue(header + 2, 2, bigend) == 43) {  /* BigTIFF */
+        if (tiffIndexRead(fp, cdata, size, 0, header, 16) ||
+            tiffIndexValue(header + 4, 2, bigend) != 8)
+            return ERROR_INT("invalid BigTIFF header", procName, 1);
+        countsize = 8;
+        entrysize = 20;
+        offsize = 8;
+        offset = tiffIndexValue(header + 8, 8, bigend);
+    } else {
+        return ERROR_INT("not a tiff file", procName, 1);
+    }
+
+    da = l_dnaCreate(0);
+    if (pnaw) *pnaw = numaCreate(0);
+    if (pnah) *pnah = numaCreate(0);
+    seen = l_asetCreate(L_UINT_TYPE);
+    while (offset != 0) {
+        key.utype = offset;
+        if (l_asetFind(seen, key)) {
+            L_WARNING("directory chain loops back to offset %llu\n",
+                      procName, (unsigned long long)offset);
+            break;
+        }
+        l_asetInsert(seen, key);
+
+            /* Read the entries and the offset of the next directory */
+        nentries = 0;
+        dir = NULL;
+        if (!tiffIndexRead(fp, cdata, size, offset, header, countsize))
+            nentries = tiffIndexValue(header, countsize, bigend);
+        if (nentries > 0 && nentries <= MAX_TIFF_DIR_ENTRIES) {
+            dirsize = nentries * entrysize + offsize;
+            dir = (l_uint8 *)LEPT_CALLOC(dirsize, 1);
+            if (tiffIndexRead(fp, cdata, size, offset + countsize, dir,
+                              dirsize)) {
+                LEPT_FREE(dir);
+                dir = NULL;
+            }
+        }
+        if (!dir) {
+            L_WARNING("directory at offset %llu not read\n", procName,
+                      (unsigned long long)offset);
+            break;
+        }
+
+        w = h = 0;
+        for (i = 0; i < nentries; i++) {
+            entry = dir + i * entrysize;
+            tag = tiffIndexValue(entry, 2, bigend);
+            type = tiffIndexValue(entry + 2, 2, bigend);
+            if (tag != 256 && tag != 257)  /* ImageWidth, ImageLength */
+                continue;
+            if (type == 3)  /* SHORT */
+                val = tiffIndexValue(entry + 4 + offsize, 2, bigend);
+            else if (type == 4)  /* LONG */
+                val = tiffIndexValue(entry + 4 + offsize, 4, bigend);
+            else if (type == 16)  /* LONG8 */
+                val = tiffIndexValue(entry + 4 + offsize, 8, bigend);
+            else
+                continue;
+            if (tag == 256)
+                w = val;
+            else
+                h = val;
+        }
+        l_dnaAddNumber(da, (l_float64)offset);
+        if (pnaw) numaAddNumber(*pnaw, (l_float32)w);
+        if (pnah) numaAddNumber(*pnah, (l_float32)h);
+        offset = tiffIndexValue(dir + nentries * entrysize, offsize, bigend);
+        LEPT_FREE(dir);
+    }
+    l_asetDestroy(&seen);
+
+    if (l_dnaGetCount(da) == 0) {
+        l_dnaDestroy(&da);
+        if (pnaw) numaDestroy(pnaw);
+        if (pnah) numaDestroy(pnah);
+        return ERROR_INT("no image directory", procName, 1);
+    }
+    *pdaoffset = da;
+    return 0;
+}
+
+
+/*!
+ * \brief   tiffIndexRead()
+ *
+ * \param[in]    fp         [optional] file stream opened for read
+ * \param[in]    cdata      [optional] tiff-encoded; used if fp is NULL
+ * \param[in]    size       size of cdata
+ * \param[in]    offset     where to read
+ * \param[in]    buf        to hold %nbytes
+ * \param[in]    nbytes     number of bytes to read
+ * \return  0 if OK; 1 if the bytes are not all there
+ */
+static l_int32
+tiffIndexRead(FILE           *fp,
+              const l_uint8  *cdata,
+              size_t          size,
+              l_uint64        offset,
+              l_uint8        *buf,
+              size_t          nbytes)
+{
+    if (!fp) {
+        if (offset > size || nbytes > size - offset)
+            return 1;
+        memcpy(buf, cdata + offset, nbytes);
+        return 0;
+    }
+    if (offset > (l_uint64)LONG_MAX || fseek(fp, (long)offset, SEEK_SET))
+        return 1;
+    return (fread(buf, 1, nbytes, fp) != nbytes);
+}
+
+
+/*!
+ * \brief   tiffIndexValue()
+ *
+ * \param[in]    buf        holding the value
+ * \param[in]    nbytes     size of the value: 2, 4 or 8
+ * \param[in]    bigend     1 for big-endian (MM) data; 0 for little (II)
+ * \return  the value
+ */
+static l_uint64
+tiffIndexValue(const l_uint8  *buf,
+               l_int32         nbytes,
+               l_int32         bigend)
+{
+l_int32   i;
+l_uint64  val;
+
+    val = 0;
+    for (i = 0; i < nbytes; i++)
+        val = (val << 8) | buf[bigend ? i : nbytes - 1 - i];
+    return val;
+}
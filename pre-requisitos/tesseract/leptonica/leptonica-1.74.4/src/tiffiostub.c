@@ -207,6 +207,14 @@ PIX * pixReadMemFromMultipageTiff(const l_uint8 *cdata, size_t size,
 
 /* ----------------------------------------------------------------------*/
 
+PIX * pixReadMemTiffPage(const l_uint8 *cdata, size_t size, size_t offset)
+{
+    return (PIX *)ERROR_PTR("function not present",
+                            "pixReadMemTiffPage", NULL);
+}
+
+/* ----------------------------------------------------------------------*/
+
 PIXA * pixaReadMemMultipageTiff(const l_uint8 *data, size_t size)
 {
     return (PIXA *)ERROR_PTR("function not present",
@@ -57,6 +57,8 @@
  *           l_uint8   *l_binaryReadStream()
  *           l_uint8   *l_binaryReadSelect()
  *           l_uint8   *l_binaryReadSelectStream()
+ *           l_uint8   *l_binaryMap()
+ *           l_int32    l_binaryUnmap()
  *           l_int32    l_binaryWrite()
  *           l_int32    nbytesInFile()
  *           l_int32    fnbytesInFile()
@@ -178,6 +180,7 @@
 #else
 #include <sys/stat.h>  /* for stat, mkdir(2) */
 #include <sys/types.h>
+#include <sys/mman.h>  /* for mmap */
 #endif
 
 #include <string.h>
@@ -1308,6 +1311,93 @@ size_t    bytesleft, bytestoread, nread, filebytes;
 }
 
 
+/*!
+ * \brief   l_binaryMap()
+ *
+ * \param[in]    filename
+ * \param[out]   pnbytes size of the file
+ * \return  read-only data, or NULL on error
+ *
+ * <pre>
+ * Notes:
+ *      (1) This maps the file read-only into memory, so that it can be
+ *          decoded with pixReadMem() and the other *Mem() readers
+ *          without first copying it through the stream into a buffer.
+ *          The pages are brought in by the kernel as they are touched,
+ *          and for a file in a ram disk (e.g., tmpfs) there is no copy.
+ *      (2) The data must be released with l_binaryUnmap(), with the same
+ *          %nbytes, and must not be written or freed with LEPT_FREE().
+ *      (3) Unlike l_binaryRead(), the data is not null-terminated, and
+ *          an empty file or one that is not a regular file (e.g., a pipe)
+ *          is an error.  Use l_binaryReadStream() for those.
+ *      (4) On windows, this falls back to l_binaryRead().
+ * </pre>
+ */
+l_uint8 *
+l_binaryMap(const char  *filename,
+            size_t      *pnbytes)
+{
+#ifndef _WIN32
+void        *data;
+FILE        *fp;
+struct stat  st;
+#endif  /* !_WIN32 */
+
+    PROCNAME("l_binaryMap");
+
+    if (!pnbytes)
+        return (l_uint8 *)ERROR_PTR("pnbytes not defined", procName, NULL);
+    *pnbytes = 0;
+    if (!filename)
+        return (l_uint8 *)ERROR_PTR("filename not defined", procName, NULL);
+
+#ifndef _WIN32
+    if ((fp = fopenReadStream(filename)) == NULL)
+        return (l_uint8 *)ERROR_PTR("file stream not opened", procName, NULL);
+    if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode) ||
+        st.st_size == 0) {
+        fclose(fp);
+        return (l_uint8 *)ERROR_PTR("not a non-empty regular file",
+                                    procName, NULL);
+    }
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    fclose(fp);  /* the mapping stays valid */
+    if (data == MAP_FAILED)
+        return (l_uint8 *)ERROR_PTR("file not mapped", procName, NULL);
+    *pnbytes = st.st_size;
+    return (l_uint8 *)data;
+#else
+    return l_binaryRead(filename, pnbytes);
+#endif  /* !_WIN32 */
+}
+
+
+/*!
+ * \brief   l_binaryUnmap()
+ *
+ * \param[in]    data returned by l_binaryMap(); can be null
+ * \param[in]    nbytes size returned by l_binaryMap()
+ * \return  0 if OK; 1 on error
+ */
+l_int32
+l_binaryUnmap(l_uint8  *data,
+              size_t    nbytes)
+{
+    PROCNAME("l_binaryUnmap");
+
+    if (!data)
+        return 0;
+
+#ifndef _WIN32
+    if (munmap(data, nbytes) != 0)
+        return ERROR_INT("data not unmapped", procName, 1);
+#else
+    LEPT_FREE(data);
+#endif  /* !_WIN32 */
+    return 0;
+}
+
+
 /*!
  * \brief   l_binaryWrite()
  *
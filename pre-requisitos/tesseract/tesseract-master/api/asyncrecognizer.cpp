@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////
+// File:        asyncrecognizer.cpp
+// Description: Non blocking recognition of pages on a pool of workers.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "asyncrecognizer.h"
+
+#include "allheaders.h"
+#include "parallelpages.h"
+#include "tprintf.h"
+
+namespace tesseract {
+
+AsyncJob::AsyncJob(Pix* pix, int timeout_millisec, AsyncJobCallback callback,
+                   void* user_data)
+  : pix_(pix), timeout_millisec_(timeout_millisec), callback_(callback),
+    user_data_(user_data), text_(NULL), confidence_(0), cancelled_(false),
+    state_(ASYNC_JOB_PENDING) {
+  monitor_.cancel = CancelFunc;
+  monitor_.cancel_this = this;
+}
+
+AsyncJob::~AsyncJob() {
+  Cancel();
+  Wait();
+  pixDestroy(&pix_);
+  delete [] text_;
+}
+
+AsyncJobState AsyncJob::state() const {
+  SVAutoLock lock(&mutex_);
+  return state_;
+}
+
+bool AsyncJob::finished() const {
+  AsyncJobState s = state();
+  return s != ASYNC_JOB_PENDING && s != ASYNC_JOB_RUNNING;
+}
+
+void AsyncJob::Wait() {
+  finished_.Wait();
+  // Passes the signal on to the next waiter.
+  finished_.Signal();
+}
+
+void AsyncJob::Cancel() {
+  if (!finished()) cancelled_ = true;
+}
+
+bool AsyncJob::CancelFunc(void* cancel_this, int words) {
+  return static_cast<AsyncJob*>(cancel_this)->cancelled_;
+}
+
+void AsyncJob::SetState(AsyncJobState state) {
+  SVAutoLock lock(&mutex_);
+  state_ = state;
+}
+
+void AsyncJob::Finish(AsyncJobState state) {
+  SetState(state);
+  if (callback_ != NULL) callback_(this, user_data_);
+  // The job may be deleted as soon as this returns.
+  finished_.Signal();
+}
+
+AsyncRecognizer::AsyncRecognizer() : running_(false) {
+}
+
+AsyncRecognizer::~AsyncRecognizer() {
+  if (!running_) return;
+  // The stop requests go behind the pending jobs, which the workers drain
+  // as cancelled, so that every job still gets its callback.
+  mutex_.Lock();
+  for (int i = 0; i < jobs_.size(); ++i) jobs_[i]->Cancel();
+  for (int i = 0; i < workers_.size(); ++i) jobs_.push_back(NULL);
+  mutex_.Unlock();
+  for (int i = 0; i < workers_.size(); ++i) jobs_available_.Signal();
+  for (int i = 0; i < workers_.size(); ++i) worker_done_.Wait();
+  DeleteWorkers();
+}
+
+bool AsyncRecognizer::Start(TessBaseAPI* api, int num_threads) {
+  if (running_) return false;
+  if (num_threads < 1) num_threads = 1;
+  for (int i = 0; i < num_threads; ++i) {
+    Worker* worker = new Worker;
+    worker->pool = this;
+    worker->api = new TessBaseAPI;
+    workers_.push_back(worker);
+    if (InitWorkerApi(api, worker->api) != 0) {
+      tprintf("Error: cannot initialize the recognition workers\n");
+      DeleteWorkers();
+      return false;
+    }
+  }
+  running_ = true;
+  for (int i = 0; i < workers_.size(); ++i)
+    SVSync::StartThread(WorkerThread, workers_[i]);
+  return true;
+}
+
+AsyncJob* AsyncRecognizer::Submit(Pix* pix, int timeout_millisec,
+                                  AsyncJobCallback callback,
+                                  void* user_data) {
+  if (!running_) {
+    pixDestroy(&pix);
+    return NULL;
+  }
+  AsyncJob* job = new AsyncJob(pix, timeout_millisec, callback, user_data);
+  mutex_.Lock();
+  jobs_.push_back(job);
+  mutex_.Unlock();
+  jobs_available_.Signal();
+  return job;
+}
+
+void* AsyncRecognizer::WorkerThread(void* arg) {
+  Worker* worker = static_cast<Worker*>(arg);
+  worker->pool->RunWorker(worker->api);
+  return NULL;
+}
+
+void AsyncRecognizer::RunWorker(TessBaseAPI* api) {
+  while (true) {
+    jobs_available_.Wait();
+    mutex_.Lock();
+    AsyncJob* job = jobs_[0];
+    jobs_.remove(0);
+    mutex_.Unlock();
+    if (job == NULL) break;
+    RunJob(api, job);
+  }
+  worker_done_.Signal();
+}
+
+void AsyncRecognizer::RunJob(TessBaseAPI* api, AsyncJob* job) {
+  if (job->cancelled_) {
+    job->Finish(ASYNC_JOB_CANCELLED);
+    return;
+  }
+  job->SetState(ASYNC_JOB_RUNNING);
+  // The deadline counts from the start of the recognition, not from the
+  // submission, as the time spent in the queue is the caller's choice.
+  if (job->timeout_millisec_ > 0)
+    job->monitor_.set_deadline_msecs(job->timeout_millisec_);
+  api->SetBorrowedImage(job->pix_);
+  AsyncJobState state = ASYNC_JOB_DONE;
+  if (api->Recognize(&job->monitor_) < 0) {
+    if (job->cancelled_)
+      state = ASYNC_JOB_CANCELLED;
+    else if (job->monitor_.deadline_exceeded())
+      state = ASYNC_JOB_TIMED_OUT;
+    else
+      state = ASYNC_JOB_FAILED;
+  }
+  // A page stopped at the deadline keeps the words recognized so far.
+  if (state == ASYNC_JOB_DONE || state == ASYNC_JOB_TIMED_OUT) {
+    job->text_ = api->GetUTF8Text();
+    job->confidence_ = api->MeanTextConf();
+  }
+  api->Clear();
+  pixDestroy(&job->pix_);
+  job->Finish(state);
+}
+
+void AsyncRecognizer::DeleteWorkers() {
+  for (int i = 0; i < workers_.size(); ++i) {
+    delete workers_[i]->api;
+    delete workers_[i];
+  }
+  workers_.clear();
+}
+
+}  // namespace tesseract.
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////
+// File:        asyncrecognizer.h
+// Description: Non blocking recognition of pages on a pool of workers.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_ASYNCRECOGNIZER_H_
+#define TESSERACT_API_ASYNCRECOGNIZER_H_
+
+#include <atomic>
+#include "baseapi.h"
+#include "genericvector.h"
+#include "ocrclass.h"
+#include "platform.h"
+#include "publictypes.h"
+#include "svutil.h"
+
+struct Pix;
+
+namespace tesseract {
+
+class AsyncJob;
+
+// Called on the worker thread when a job reaches a final state, before any
+// Wait on it returns. It must not block for long or delete the job.
+typedef void (*AsyncJobCallback)(AsyncJob* job, void* user_data);
+
+// A page submitted to an AsyncRecognizer. The submitter owns it, and may
+// delete it at any time: an unfinished job is cancelled and waited for.
+class TESS_API AsyncJob {
+ public:
+  ~AsyncJob();
+
+  AsyncJobState state() const;
+  // Returns true once the job is in a final state.
+  bool finished() const;
+  // Blocks until the job is finished. Any number of threads may wait.
+  void Wait();
+  // Asks the job to stop. A pending job is dropped, and a running one stops
+  // at the next word, with a final state of ASYNC_JOB_CANCELLED. Finished
+  // jobs are left as they are.
+  void Cancel();
+  // Percent of the words recognized so far.
+  int progress() const { return monitor_.progress; }
+
+  // Results, valid once finished. The UTF-8 text, owned by the job, is NULL
+  // unless the job is done or timed out; the confidence is that of
+  // TessBaseAPI::MeanTextConf, or 0 without text.
+  const char* text() const { return text_; }
+  int confidence() const { return confidence_; }
+
+ private:
+  friend class AsyncRecognizer;
+
+  AsyncJob(Pix* pix, int timeout_millisec, AsyncJobCallback callback,
+           void* user_data);
+
+  // Cancel function of monitor_.
+  static bool CancelFunc(void* cancel_this, int words);
+  void SetState(AsyncJobState state);
+  // Sets the final state, calls the callback and releases the waiters.
+  void Finish(AsyncJobState state);
+
+  Pix* pix_;  // Owned until the worker has recognized it.
+  int timeout_millisec_;
+  AsyncJobCallback callback_;
+  void* user_data_;
+  ETEXT_DESC monitor_;
+  char* text_;
+  int confidence_;
+  std::atomic<bool> cancelled_;
+  mutable SVMutex mutex_;  // Guards state_.
+  AsyncJobState state_;
+  SVSemaphore finished_;   // Signalled once finished, and by every Wait.
+};
+
+// Recognizes pages without blocking the submitter, on a pool of worker
+// threads, each owning its own TessBaseAPI initialized like a given one,
+// so a single thread can keep many pages in flight. Pages are started in
+// the order they were submitted.
+class TESS_API AsyncRecognizer {
+ public:
+  AsyncRecognizer();
+  // Cancels the pending jobs, whose callbacks still run, and waits for the
+  // running ones. The jobs themselves are left to their owners.
+  ~AsyncRecognizer();
+
+  // Starts num_threads workers, at least one, initialized with
+  // InitWorkerApi from api, which is only read here. Returns false if a
+  // worker fails to initialize, leaving no workers.
+  bool Start(TessBaseAPI* api, int num_threads);
+  // Queues pix, taking ownership of it, for recognition with a deadline of
+  // timeout_millisec from its start, or none if not positive. callback, if
+  // not NULL, is called with user_data when the job finishes. Returns the
+  // new job, owned by the caller, or NULL if there are no workers.
+  AsyncJob* Submit(Pix* pix, int timeout_millisec, AsyncJobCallback callback,
+                   void* user_data);
+
+ private:
+  struct Worker {
+    AsyncRecognizer* pool;
+    TessBaseAPI* api;
+  };
+
+  static void* WorkerThread(void* arg);
+  void RunWorker(TessBaseAPI* api);
+  // Recognizes the page of job on api and finishes the job.
+  static void RunJob(TessBaseAPI* api, AsyncJob* job);
+  // Deletes the worker apis.
+  void DeleteWorkers();
+
+  GenericVector<Worker*> workers_;
+  GenericVector<AsyncJob*> jobs_;  // FIFO of jobs; NULL asks a worker to exit.
+  SVMutex mutex_;                  // Guards jobs_.
+  SVSemaphore jobs_available_;
+  SVSemaphore worker_done_;
+  bool running_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_API_ASYNCRECOGNIZER_H_
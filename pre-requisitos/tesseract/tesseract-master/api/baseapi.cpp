@@ -58,8 +58,14 @@
 #include "mutableiterator.h"
 #include "thresholder.h"
 #include "tesseractclass.h"
+#include "pagecache.h"
+#include "pagedewarp.h"
+#include "pageprofile.h"
 #include "pageres.h"
 #include "paragraphs.h"
+#include "parallelpages.h"
+#include "pdfreader.h"
+#include "tracing.h"
 #include "tessvars.h"
 #include "control.h"
 #include "dict.h"
@@ -73,13 +79,19 @@
 #include "tessbox.h"
 #include "makerow.h"
 #include "otsuthr.h"
+#include "opthreads.h"
 #include "osdetect.h"
 #include "params.h"
+#include "pageresults.h"
 #include "renderer.h"
 #include "strngs.h"
+#include "textwriter.h"
 #include "openclwrapper.h"
 
 BOOL_VAR(stream_filelist, FALSE, "Stream a filelist from stdin");
+INT_VAR(pix_pool_mb, 0,
+        "Keep up to this many MB of freed image buffers for reuse by later"
+        " pages (0 = off)");
 
 namespace tesseract {
 
@@ -103,6 +115,26 @@ const char* kOldVarsFile = "failed_vars.txt";
 /** Max string length of an int.  */
 const int kMaxIntSize = 22;
 
+// A read-only mapping of an input file, released when it goes out of scope.
+class FileMapping {
+ public:
+  FileMapping() : data_(NULL), size_(0) {}
+  ~FileMapping() { l_binaryUnmap(data_, size_); }
+
+  // Returns false if the file cannot be mapped, e.g. it is not a regular
+  // file, in which case it is read by name as before.
+  bool Map(const char* filename) {
+    data_ = l_binaryMap(filename, &size_);
+    return data_ != NULL;
+  }
+  const l_uint8* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  l_uint8* data_;
+  size_t size_;
+};
+
 /* Add all available languages recursively.
 */
 static void addAvailableLanguages(const STRING &datadir, const STRING &base,
@@ -167,6 +199,15 @@ TessBaseAPI::TessBaseAPI()
       osd_tesseract_(nullptr),
       equ_detect_(nullptr),
       reader_(nullptr),
+      input_image_data_(nullptr),
+      has_input_page_geometry_(false),
+      page_cache_(nullptr),
+      cached_page_(nullptr),
+      duplicate_pages_(nullptr),
+      owns_duplicate_pages_(false),
+      dewarp_models_(nullptr),
+      owns_dewarp_models_(false),
+      profile_(new PageProfile),
       // Thresholder is initialized to NULL here, but will be set before use by:
       // A constructor of a derived API,  SetThresholder(), or
       // created implicitly when used in InternalSetImage.
@@ -174,12 +215,14 @@ TessBaseAPI::TessBaseAPI()
       paragraph_models_(nullptr),
       block_list_(nullptr),
       page_res_(nullptr),
+      page_results_(nullptr),
       input_file_(nullptr),
       output_file_(nullptr),
       datapath_(nullptr),
       language_(nullptr),
       last_oem_requested_(OEM_DEFAULT),
       recognition_done_(false),
+      required_analysis_(ANALYSIS_ALL),
       truth_cb_(NULL),
       rect_left_(0),
       rect_top_(0),
@@ -190,6 +233,7 @@ TessBaseAPI::TessBaseAPI()
 
 TessBaseAPI::~TessBaseAPI() {
   End();
+  delete profile_;
 }
 
 /**
@@ -275,6 +319,14 @@ bool TessBaseAPI::SetVariable(const char* name, const char* value) {
                               tesseract_->params());
 }
 
+bool TessBaseAPI::SetVariables(const GenericVector<STRING>& names,
+                               const GenericVector<STRING>& values) {
+  if (tesseract_ == NULL) tesseract_ = new Tesseract;
+  return ParamUtils::SetParams(names, values,
+                               SET_PARAM_CONSTRAINT_NON_INIT_ONLY,
+                               tesseract_->params());
+}
+
 bool TessBaseAPI::SetDebugVariable(const char* name, const char* value) {
   if (tesseract_ == NULL) tesseract_ = new Tesseract;
   return ParamUtils::SetParam(name, value, SET_PARAM_CONSTRAINT_DEBUG_ONLY,
@@ -282,30 +334,30 @@ bool TessBaseAPI::SetDebugVariable(const char* name, const char* value) {
 }
 
 bool TessBaseAPI::GetIntVariable(const char *name, int *value) const {
-  IntParam *p = ParamUtils::FindParam<IntParam>(
-      name, GlobalParams()->int_params, tesseract_->params()->int_params);
+  IntParam *p = ParamUtils::FindParams(
+      name, tesseract_->params()).int_param;
   if (p == NULL) return false;
   *value = (inT32)(*p);
   return true;
 }
 
 bool TessBaseAPI::GetBoolVariable(const char *name, bool *value) const {
-  BoolParam *p = ParamUtils::FindParam<BoolParam>(
-      name, GlobalParams()->bool_params, tesseract_->params()->bool_params);
+  BoolParam *p = ParamUtils::FindParams(
+      name, tesseract_->params()).bool_param;
   if (p == NULL) return false;
   *value = (BOOL8)(*p);
   return true;
 }
 
 const char *TessBaseAPI::GetStringVariable(const char *name) const {
-  StringParam *p = ParamUtils::FindParam<StringParam>(
-      name, GlobalParams()->string_params, tesseract_->params()->string_params);
+  StringParam *p = ParamUtils::FindParams(
+      name, tesseract_->params()).string_param;
   return (p != NULL) ? p->string() : NULL;
 }
 
 bool TessBaseAPI::GetDoubleVariable(const char *name, double *value) const {
-  DoubleParam *p = ParamUtils::FindParam<DoubleParam>(
-      name, GlobalParams()->double_params, tesseract_->params()->double_params);
+  DoubleParam *p = ParamUtils::FindParams(
+      name, tesseract_->params()).double_param;
   if (p == NULL) return false;
   *value = (double)(*p);
   return true;
@@ -590,6 +642,26 @@ void TessBaseAPI::SetImage(Pix* pix) {
   }
 }
 
+void TessBaseAPI::SetBorrowedImage(Pix* pix) {
+  if (InternalSetImage()) {
+    thresholder_->SetBorrowedImage(pix);
+    SetInputImage(thresholder_->GetPixRect());
+  }
+}
+
+void TessBaseAPI::SetBorrowedImage(unsigned char* imagedata,
+                                   int width, int height,
+                                   int bytes_per_pixel, int bytes_per_line) {
+  if (InternalSetImage()) {
+    if (!thresholder_->SetBorrowedImage(imagedata, width, height,
+                                        bytes_per_pixel, bytes_per_line)) {
+      thresholder_->SetImage(imagedata, width, height,
+                             bytes_per_pixel, bytes_per_line);
+    }
+    SetInputImage(thresholder_->GetPixRect());
+  }
+}
+
 /**
  * Restrict recognition to a sub-rectangle of the image. Call after SetImage.
  * Each SetRectangle clears the recogntion results so multiple rectangles
@@ -806,6 +878,7 @@ PageIterator* TessBaseAPI::AnalyseLayout(bool merge_similar_words) {
   if (FindLines() == 0) {
     if (block_list_->empty())
       return NULL;  // The page was empty.
+    ClearPageResults();
     page_res_ = new PAGE_RES(merge_similar_words, block_list_, NULL);
     DetectParagraphs(false);
     return new PageIterator(
@@ -823,8 +896,13 @@ PageIterator* TessBaseAPI::AnalyseLayout(bool merge_similar_words) {
 int TessBaseAPI::Recognize(ETEXT_DESC* monitor) {
   if (tesseract_ == NULL)
     return -1;
+  TESS_TRACE_SPAN("TessBaseAPI::Recognize");
+  // The limit is per thread, so it is set by each call, from the thread
+  // that recognizes.
+  SetIntraOpThreads(tesseract_->tessedit_intra_op_threads);
   if (FindLines() != 0)
     return -1;
+  ClearPageResults();
   delete page_res_;
   if (block_list_->empty()) {
     page_res_ = new PAGE_RES(false, block_list_,
@@ -873,6 +951,7 @@ int TessBaseAPI::Recognize(ETEXT_DESC* monitor) {
     #endif  // GRAPHICS_DISABLED
     // The page_res is invalid after an interactive session, so cleanup
     // in a way that lets us continue to the next page without crashing.
+    ClearPageResults();
     delete page_res_;
     page_res_ = NULL;
     return -1;
@@ -888,18 +967,161 @@ int TessBaseAPI::Recognize(ETEXT_DESC* monitor) {
     fclose(training_output_file);
   } else {
     // Now run the main recognition.
+    bool paragraphs = (required_analysis_ & ANALYSIS_PARAGRAPHS) != 0;
     bool wait_for_text = true;
     GetBoolVariable("paragraph_text_based", &wait_for_text);
-    if (!wait_for_text) DetectParagraphs(false);
+    if (paragraphs && !wait_for_text) DetectParagraphs(false);
+    tesseract_->set_font_recognition(
+        (required_analysis_ & ANALYSIS_FONTS) != 0);
     if (tesseract_->recog_all_words(page_res_, monitor, NULL, NULL, 0)) {
-      if (wait_for_text) DetectParagraphs(true);
+      if (paragraphs && wait_for_text) DetectParagraphs(true);
     } else {
       result = -1;
     }
   }
+  CountPageResults();
   return result;
 }
 
+/** Adds the words, blobs and lines of page_res_ to the profile. */
+void TessBaseAPI::CountPageResults() {
+  int words = 0, blobs = 0, lines = 0;
+  PAGE_RES_IT page_res_it(page_res_);
+  for (page_res_it.restart_page(); page_res_it.word() != NULL;
+       page_res_it.forward()) {
+    ++words;
+    blobs += page_res_it.word()->word->cblob_list()->length();
+    if (page_res_it.row() != page_res_it.prev_row()) ++lines;
+  }
+  profile_->AddCount(PROFILE_WORDS, words);
+  profile_->AddCount(PROFILE_BLOBS, blobs);
+  profile_->AddCount(PROFILE_LINES, lines);
+}
+
+/** Returns true if the whitelists of two fields are the same. */
+static bool SameWhitelist(const char* whitelist1, const char* whitelist2) {
+  if (whitelist1 == NULL || whitelist2 == NULL)
+    return whitelist1 == whitelist2;
+  return strcmp(whitelist1, whitelist2) == 0;
+}
+
+bool TessBaseAPI::RecognizeFields(const OcrField* fields, int num_fields,
+                                  char** texts, int* confidences) {
+  if (tesseract_ == NULL)
+    return false;
+  if (thresholder_ == NULL || thresholder_->IsEmpty()) {
+    tprintf("Please call SetImage before attempting recognition.\n");
+    return false;
+  }
+  SetIntraOpThreads(tesseract_->tessedit_intra_op_threads);
+  int left, top, width, height, image_width, image_height;
+  thresholder_->GetImageSizes(&left, &top, &width, &height,
+                              &image_width, &image_height);
+  thresholder_->SetRectangle(0, 0, image_width, image_height);
+  ClearResults();
+  tesseract_->set_profile(profile_);
+  {
+    ProfileTimer timer(profile_, PROFILE_THRESHOLD);
+    if (!Threshold(tesseract_->mutable_pix_binary())) return false;
+  }
+  GenericVector<STRING> field_texts;
+  field_texts.init_to_size(num_fields, STRING());
+  // Last row of each field, to separate its lines, and the sum of the
+  // confidences of its words.
+  GenericVector<const ROW_RES*> last_rows;
+  last_rows.init_to_size(num_fields, NULL);
+  GenericVector<int> word_counts;
+  word_counts.init_to_size(num_fields, 0);
+  // Fields already segmented, or invalid.
+  GenericVector<bool> segmented;
+  segmented.init_to_size(num_fields, false);
+  for (int f = 0; f < num_fields; ++f) {
+    const OcrField& field = fields[f];
+    confidences[f] = 0;
+    if (field.psm < 0 || field.psm >= PSM_COUNT ||
+        PSM_OSD_ENABLED(field.psm) || field.psm == PSM_AUTO_ONLY ||
+        field.left < 0 || field.top < 0 || field.width <= 0 ||
+        field.height <= 0 || field.left + field.width > image_width ||
+        field.top + field.height > image_height) {
+      tprintf("Warning: invalid field %d\n", f);
+      confidences[f] = -1;
+      segmented[f] = true;
+    }
+  }
+  STRING page_whitelist = tesseract_->tessedit_char_whitelist.string();
+  int page_mode = tesseract_->tessedit_pageseg_mode;
+  bool page_no_language_model = tesseract_->tessedit_no_language_model;
+  // The blocks of the fields are recognized together, with no single row or
+  // single word clean up of the whole page.
+  tesseract_->tessedit_pageseg_mode.set_value(PSM_SINGLE_BLOCK);
+  for (int first = 0; first < num_fields; ++first) {
+    if (segmented[first]) continue;
+    const char* whitelist = fields[first].whitelist;
+    bool no_language_model = fields[first].no_language_model;
+    for (int f = first; f < num_fields; ++f) {
+      if (segmented[f] || !SameWhitelist(fields[f].whitelist, whitelist) ||
+          fields[f].no_language_model != no_language_model)
+        continue;
+      segmented[f] = true;
+      const OcrField& field = fields[f];
+      BLOCK_LIST blocks;
+      ProfileTimer timer(profile_, PROFILE_LAYOUT);
+      if (tesseract_->SegmentRegion(field.left, field.top, field.width,
+                                    field.height, field.psm, &blocks) < 0) {
+        confidences[f] = -1;
+        continue;
+      }
+      // The index of the blocks leads their words back to the field.
+      BLOCK_IT block_it(&blocks);
+      for (block_it.mark_cycle_pt(); !block_it.cycled_list();
+           block_it.forward()) {
+        block_it.data()->set_index(f);
+      }
+      block_it.set_to_list(block_list_);
+      block_it.move_to_last();
+      block_it.add_list_after(&blocks);
+    }
+    if (block_list_->empty()) continue;
+    tesseract_->tessedit_char_whitelist.set_value(
+        whitelist != NULL ? whitelist : page_whitelist.string());
+    tesseract_->SetBlackAndWhitelist();
+    tesseract_->tessedit_no_language_model.set_value(
+        no_language_model || page_no_language_model);
+    page_res_ = new PAGE_RES(tesseract_->AnyLSTMLang(), block_list_,
+                             &tesseract_->prev_word_best_choice_);
+    tesseract_->recog_all_words(page_res_, NULL, NULL, NULL, 0);
+    CountPageResults();
+    PAGE_RES_IT page_res_it(page_res_);
+    for (page_res_it.restart_page(); page_res_it.word() != NULL;
+         page_res_it.forward()) {
+      int f = page_res_it.block()->block->index();
+      WERD_CHOICE* choice = page_res_it.word()->best_choice;
+      if (choice == NULL) continue;
+      if (word_counts[f] > 0)
+        field_texts[f] += page_res_it.row() != last_rows[f] ? "\n" : " ";
+      field_texts[f] += choice->unichar_string();
+      last_rows[f] = page_res_it.row();
+      int w_conf = static_cast<int>(100 + 5 * choice->certainty());
+      confidences[f] += ClipToRange(w_conf, 0, 100);
+      ++word_counts[f];
+    }
+    ClearPageResults();
+    delete page_res_;
+    page_res_ = NULL;
+    block_list_->clear();
+  }
+  tesseract_->tessedit_char_whitelist.set_value(page_whitelist.string());
+  tesseract_->SetBlackAndWhitelist();
+  tesseract_->tessedit_pageseg_mode.set_value(page_mode);
+  tesseract_->tessedit_no_language_model.set_value(page_no_language_model);
+  for (int f = 0; f < num_fields; ++f) {
+    if (word_counts[f] > 0) confidences[f] /= word_counts[f];
+    texts[f] = new char[field_texts[f].length() + 1];
+    strcpy(texts[f], field_texts[f].string());
+  }
+  return true;
+}
+
 /** Tests the chopper by exhaustively running chop_one_blob. */
 int TessBaseAPI::RecognizeForChopTest(ETEXT_DESC* monitor) {
   if (tesseract_ == NULL)
@@ -917,6 +1139,7 @@ int TessBaseAPI::RecognizeForChopTest(ETEXT_DESC* monitor) {
 
   recognition_done_ = true;
 
+  ClearPageResults();
   page_res_ = new PAGE_RES(false, block_list_,
                            &(tesseract_->prev_word_best_choice_));
 
@@ -937,6 +1160,16 @@ void TessBaseAPI::SetInputImage(Pix* pix) { tesseract_->set_pix_original(pix); }
 
 Pix* TessBaseAPI::GetInputImage() { return tesseract_->pix_original(); }
 
+void TessBaseAPI::SetInputImageData(L_Compressed_Data* data) {
+  if (input_image_data_ != data) l_CIDataDestroy(&input_image_data_);
+  input_image_data_ = data;
+}
+
+void TessBaseAPI::SetInputPageGeometry(const PdfPageGeometry* geometry) {
+  has_input_page_geometry_ = geometry != NULL;
+  if (geometry != NULL) input_page_geometry_ = *geometry;
+}
+
 const char * TessBaseAPI::GetInputName() {
   if (input_file_)
     return input_file_->c_str();
@@ -982,6 +1215,9 @@ bool TessBaseAPI::ProcessPagesFileList(FILE *flist,
   if (renderer && !renderer->BeginDocument(unknown_title_)) {
     return false;
   }
+  ParallelPageProcessor pages(this, retry_config, timeout_millisec, renderer);
+  pages.Start(tesseract_->tessedit_page_threads,
+              tesseract_->tessedit_page_readahead);
 
   // Loop over all pages - or just the requested one
   while (true) {
@@ -992,21 +1228,19 @@ bool TessBaseAPI::ProcessPagesFileList(FILE *flist,
       snprintf(pagename, sizeof(pagename), "%s", lines[page].c_str());
     }
     chomp_string(pagename);
-    Pix *pix = pixRead(pagename);
+    Pix *pix = pixReadReduced(pagename, tesseract_->tessedit_jpeg_min_dpi, 0);
     if (pix == NULL) {
       tprintf("Image file %s cannot be read!\n", pagename);
       return false;
     }
     tprintf("Page %d : %s\n", page, pagename);
-    bool r = ProcessPage(pix, page, pagename, retry_config,
-                         timeout_millisec, renderer);
-    pixDestroy(&pix);
-    if (!r) return false;
+    if (!pages.AddPage(pix, page, pagename)) return false;
     if (tessedit_page_number >= 0) break;
     ++page;
   }
 
   // Finish producing output
+  if (!pages.Finish()) return false;
   if (renderer && !renderer->EndDocument()) {
     return false;
   }
@@ -1021,39 +1255,178 @@ bool TessBaseAPI::ProcessPagesMultipageTiff(const l_uint8 *data,
                                             TessResultRenderer* renderer,
                                             int tessedit_page_number) {
 #ifndef ANDROID_BUILD
-  Pix *pix = NULL;
+  // The page directories are indexed in one pass, so that each page is read
+  // from its own offset and a selected page without those before it.
+  L_DNA *offsets = NULL;
+  if (data) {
+    tiffGetPageIndexMem(data, size, &offsets, NULL, NULL);
+  } else {
+    FILE *fp = fopen(filename, "rb");
+    if (fp != NULL) {
+      tiffGetPageIndex(fp, &offsets, NULL, NULL);
+      fclose(fp);
+    }
+  }
+  if (offsets == NULL) return false;
+  int num_pages = l_dnaGetCount(offsets);
   int page = (tessedit_page_number >= 0) ? tessedit_page_number : 0;
-  size_t offset = 0;
-  for (; ; ++page) {
-    if (tessedit_page_number >= 0)
-      page = tessedit_page_number;
-    pix = (data) ? pixReadMemFromMultipageTiff(data, size, &offset)
-                 : pixReadFromMultipageTiff(filename, &offset);
+  int end_page = (tessedit_page_number >= 0) ? page + 1 : num_pages;
+  if (end_page > num_pages) {
+    tprintf("Error: %s has no page %d\n", filename, page + 1);
+    l_dnaDestroy(&offsets);
+    return false;
+  }
+  ParallelPageProcessor pages(this, retry_config, timeout_millisec, renderer);
+  pages.Start(tesseract_->tessedit_page_threads,
+              tesseract_->tessedit_page_readahead);
+  bool ok = true;
+  for (; page < end_page; ++page) {
+    double dir_offset = 0.0;
+    l_dnaGetDValue(offsets, page, &dir_offset);
+    size_t offset = static_cast<size_t>(dir_offset);
+    Pix *pix = (data) ? pixReadMemTiffPage(data, size, offset)
+                      : pixReadFromMultipageTiff(filename, &offset);
     if (pix == NULL) break;
     tprintf("Page %d\n", page + 1);
     char page_str[kMaxIntSize];
     snprintf(page_str, kMaxIntSize - 1, "%d", page);
     SetVariable("applybox_page", page_str);
-    bool r = ProcessPage(pix, page, filename, retry_config,
-                           timeout_millisec, renderer);
-    pixDestroy(&pix);
-    if (!r) return false;
-    if (tessedit_page_number >= 0) break;
-    if (!offset) break;
+    if (!pages.AddPage(pix, page, filename)) {
+      ok = false;
+      break;
+    }
   }
-  return true;
+  l_dnaDestroy(&offsets);
+  return pages.Finish() && ok;
 #else
   return false;
 #endif
 }
 
+// Returns true if the 1-based page is in list, a comma separated list of
+// page numbers and ranges such as "3,7-9".
+static bool PageInList(const char* list, int page) {
+  while (*list != '\0') {
+    char* end;
+    long first = strtol(list, &end, 10);
+    long last = first;
+    if (end == list) return false;
+    if (*end == '-') {
+      list = end + 1;
+      last = strtol(list, &end, 10);
+      if (end == list) return false;
+    }
+    if (first <= page && page <= last) return true;
+    list = end;
+    while (*list == ',' || *list == ' ') ++list;
+  }
+  return false;
+}
+
+// A blank page for a page of PDF input left out by tessedit_skip_pages:
+// 1 pixel per point, upright, so that nothing is found on it quickly.
+static Pix* BlankPdfPage(const PdfPageGeometry& geometry) {
+  int width = static_cast<int>(geometry.crop_box[2] - geometry.crop_box[0]);
+  int height = static_cast<int>(geometry.crop_box[3] - geometry.crop_box[1]);
+  if (geometry.rotate % 180 != 0) Swap(&width, &height);
+  Pix* pix = pixCreate(MAX(width, 1), MAX(height, 1), 1);
+  if (pix != NULL) pixSetResolution(pix, 72, 72);
+  return pix;
+}
+
+bool TessBaseAPI::ProcessPagesPdf(const l_uint8 *data,
+                                  size_t size,
+                                  const char* filename,
+                                  const char* retry_config,
+                                  int timeout_millisec,
+                                  TessResultRenderer* renderer,
+                                  int tessedit_page_number) {
+  PdfPageReader reader;
+  if (!reader.Open(filename, data, size)) return false;
+  int num_pages = reader.NumPages();
+  int first_page = (tessedit_page_number >= 0) ? tessedit_page_number : 0;
+  int end_page = (tessedit_page_number >= 0) ? first_page + 1 : num_pages;
+  end_page = MIN(end_page, num_pages);
+  const char* skip_pages = tesseract_->tessedit_skip_pages.string();
+  // With several decode threads, the pages are decoded by a stage of their
+  // own, ahead of the one recognizing them. A skipped page isn't even
+  // decoded.
+  GenericVector<int> decode_pages;
+  for (int page = first_page; page < end_page; ++page) {
+    if (!PageInList(skip_pages, page + 1)) decode_pages.push_back(page);
+  }
+  PdfPageDecoder decoder;
+  int decode_threads = tesseract_->tessedit_page_decode_threads;
+  int decode_depth = tesseract_->tessedit_page_decode_depth;
+  if (decode_depth <= 0) decode_depth = 2 * decode_threads;
+  bool staged = decode_threads > 1 && decode_pages.size() > 1 &&
+      decoder.Start(filename, data, size, decode_pages, decode_threads,
+                    decode_depth);
+  // The renderers copy the pages from a document of their own, opened on
+  // first use.
+  PdfPageCopier source(filename, data, size);
+  ParallelPageProcessor pages(this, retry_config, timeout_millisec, renderer);
+  pages.Start(tesseract_->tessedit_page_threads,
+              tesseract_->tessedit_page_readahead);
+  for (int page = first_page; page < end_page; ++page) {
+    L_Compressed_Data *data = NULL;
+    PdfPageGeometry geometry;
+    if (!reader.GetPageGeometry(page, &geometry)) {
+      tprintf("Error: cannot read the page tree for page %d of %s\n",
+              page + 1, filename);
+      return false;
+    }
+    geometry.source = &source;
+    Pix *pix;
+    if (PageInList(skip_pages, page + 1))
+      pix = BlankPdfPage(geometry);
+    else if (staged)
+      pix = decoder.Next(&data);
+    else
+      pix = reader.GetPage(page, &data);
+    if (pix == NULL) {
+      tprintf("Error: cannot read page %d of %s\n", page + 1, filename);
+      l_CIDataDestroy(&data);
+      return false;
+    }
+    tprintf("Page %d\n", page + 1);
+    char page_str[kMaxIntSize];
+    snprintf(page_str, kMaxIntSize - 1, "%d", page);
+    SetVariable("applybox_page", page_str);
+    if (!pages.AddPage(pix, page, filename, data, &geometry)) return false;
+  }
+  bool ok = pages.Finish();
+  if (tesseract_->tessedit_page_pipeline_stats) {
+    tprintf("Pipeline decode: threads %d, depth %d, max ready %d\n",
+            staged ? decoder.num_threads() : 1, staged ? decoder.depth() : 0,
+            decoder.max_ready());
+    tprintf("Pipeline recognize: threads %d, readahead %d, max queued %d\n",
+            MAX(pages.num_threads(), 1), pages.readahead(),
+            pages.max_queued());
+    tprintf("Pipeline render: max waiting %d\n", pages.max_waiting());
+  }
+  return ok;
+}
+
 // Master ProcessPages calls ProcessPagesInternal and then does any post-
 // processing required due to being in a training mode.
 bool TessBaseAPI::ProcessPages(const char* filename, const char* retry_config,
                                int timeout_millisec,
                                TessResultRenderer* renderer) {
+  const char* trace_file = tesseract_->tessedit_trace_file.string();
+  bool tracing = trace_file[0] != '\0';
+  if (tracing) {
+    TraceRecorder::Start();
+    SetPdfTracing(true);
+  }
   bool result =
       ProcessPagesInternal(filename, retry_config, timeout_millisec, renderer);
+  if (tracing) {
+    SetPdfTracing(false);
+    TraceRecorder::Stop();
+    if (!TraceRecorder::WriteJSON(trace_file))
+      tprintf("Error: cannot write trace %s\n", trace_file);
+  }
   if (result) {
     if (tesseract_->tessedit_train_from_boxes &&
         !tesseract_->WriteTRFile(*output_file_)) {
@@ -1080,6 +1453,9 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
                                        int timeout_millisec,
                                        TessResultRenderer* renderer) {
   PERF_COUNT_START("ProcessPages")
+  // Only pages of the same document are near-duplicates of one another.
+  if (duplicate_pages_ != NULL) duplicate_pages_->Clear();
+  if (dewarp_models_ != NULL) dewarp_models_->Clear();
   bool stdInput = !strcmp(filename, "stdin") || !strcmp(filename, "-");
   if (stdInput) {
 #ifdef WIN32
@@ -1096,18 +1472,25 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
 
   // At this point we are officially in autodection territory.
   // That means any data in stdin must be buffered, to make it
-  // seekable.
+  // seekable. A file is mapped instead, so that it is opened once
+  // and decoded in place rather than reread for each step.
   std::string buf;
+  FileMapping mapping;
   const l_uint8 *data = NULL;
+  size_t size = 0;
   if (stdInput) {
     buf.assign((std::istreambuf_iterator<char>(std::cin)),
                (std::istreambuf_iterator<char>()));
     data = reinterpret_cast<const l_uint8 *>(buf.data());
+    size = buf.size();
+  } else if (mapping.Map(filename)) {
+    data = mapping.data();
+    size = mapping.size();
   }
 
   // Here is our autodetection
   int format;
-  int r = (stdInput) ?
+  int r = (data) ?
       findFileFormatBuffer(data, &format) :
       findFileFormat(filename, &format);
 
@@ -1127,6 +1510,20 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
                                 tesseract_->tessedit_page_number);
   }
 
+  // PDF pages are decoded or rendered straight into memory
+  if (format == IFF_LPDF) {
+    if (renderer && !renderer->BeginDocument(unknown_title_)) {
+      return false;
+    }
+    if (!ProcessPagesPdf(data, size, filename, retry_config,
+                         timeout_millisec, renderer,
+                         tesseract_->tessedit_page_number) ||
+        (renderer && !renderer->EndDocument())) {
+      return false;
+    }
+    return true;
+  }
+
   // Maybe we have a TIFF which is potentially multipage
   bool tiff = (format == IFF_TIFF || format == IFF_TIFF_PACKBITS ||
                format == IFF_TIFF_RLE || format == IFF_TIFF_G3 ||
@@ -1136,7 +1533,11 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
   // Fail early if we can, before producing any output
   Pix *pix = NULL;
   if (!tiff) {
-    pix = (stdInput) ? pixReadMem(data, buf.size()) : pixRead(filename);
+    // Oversampled JPEG scans are reduced while decoding, and the pix keeps
+    // the reduced resolution, which SetImage passes on to the thresholder.
+    int min_dpi = tesseract_->tessedit_jpeg_min_dpi;
+    pix = (data) ? pixReadMemReduced(data, size, min_dpi, 0)
+                 : pixReadReduced(filename, min_dpi, 0);
     if (pix == NULL) {
       return false;
     }
@@ -1150,7 +1551,7 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
 
   // Produce output
   r = (tiff) ?
-      ProcessPagesMultipageTiff(data, buf.size(), filename, retry_config,
+      ProcessPagesMultipageTiff(data, size, filename, retry_config,
                                 timeout_millisec, renderer,
                                 tesseract_->tessedit_page_number) :
       ProcessPage(pix, 0, filename, retry_config,
@@ -1167,15 +1568,145 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
   return true;
 }
 
+// Longest side of the reduced image that TextHeight measures.
+const int kTextHeightSampleSize = 2500;
+// Fewest character sized components for TextHeight to trust their median.
+const int kMinTextComponents = 50;
+// Largest factor by which WorkingImage reduces a page.
+const int kMaxWorkingReduction = 4;
+
+// Returns the median height in pixels of the character sized connected
+// components of pix, measured on a thresholded reduction of it, or 0 if
+// there are too few of them to tell. Most of them are lower case letters,
+// so it is a little above the x-height of the body text.
+static int TextHeight(Pix* pix) {
+  int depth = pixGetDepth(pix);
+  Pix* reduced = depth == 1 ? pixClone(pix) : pixConvertTo8(pix, false);
+  int reduction = 1;
+  while (reduced != NULL &&
+         MAX(pixGetWidth(reduced), pixGetHeight(reduced)) >
+             kTextHeightSampleSize) {
+    Pix* half = depth == 1 ? pixReduceRankBinary2(reduced, 1, NULL)
+                           : pixScaleAreaMap2(reduced);
+    pixDestroy(&reduced);
+    reduced = half;
+    reduction *= 2;
+  }
+  if (reduced == NULL) return 0;
+  Pix* binary = NULL;
+  if (depth == 1) {
+    binary = pixClone(reduced);
+  } else {
+    // A single tile is a global Otsu threshold.
+    pixOtsuAdaptiveThreshold(reduced, pixGetWidth(reduced),
+                             pixGetHeight(reduced), 0, 0, 0.1, NULL, &binary);
+  }
+  pixDestroy(&reduced);
+  if (binary == NULL) return 0;
+  Boxa* boxes = pixConnCompBB(binary, 8);
+  int max_height = pixGetHeight(binary) / 20;
+  pixDestroy(&binary);
+  if (boxes == NULL) return 0;
+  // Rules, specks and pictures are left out by their size and shape.
+  Numa* heights = numaCreate(0);
+  for (int i = 0; i < boxaGetCount(boxes); ++i) {
+    l_int32 x, y, w, h;
+    boxaGetBoxGeometry(boxes, i, &x, &y, &w, &h);
+    if (h >= 3 && h <= max_height && w <= 3 * h && h <= 4 * w)
+      numaAddNumber(heights, h);
+  }
+  boxaDestroy(&boxes);
+  l_float32 median = 0.0f;
+  if (numaGetCount(heights) >= kMinTextComponents)
+    numaGetMedian(heights, &median);
+  numaDestroy(&heights);
+  return static_cast<int>(median * reduction + 0.5f);
+}
+
+// Returns pix at the resolution where its text is about target_height
+// pixels high, or NULL if it is close enough as it is. Pages are reduced by
+// a power of 2, or doubled when the text is under half the target, with
+// their resolution changed along with their size, so that what is
+// rendered in points still lines up with the original page.
+static Pix* WorkingImage(Pix* pix, int target_height) {
+  int depth = pixGetDepth(pix);
+  if (target_height <= 0 || pixGetColormap(pix) != NULL ||
+      (depth != 1 && depth != 8 && depth != 32)) {
+    return NULL;
+  }
+  int height = TextHeight(pix);
+  if (height <= 0) return NULL;
+  int reduction = 1;
+  while (reduction < kMaxWorkingReduction &&
+         height >= 2 * reduction * target_height) {
+    reduction *= 2;
+  }
+  Pix* result = NULL;
+  if (reduction > 1) {
+    result = pixClone(pix);
+    for (int r = 1; r < reduction && result != NULL; r *= 2) {
+      Pix* half = pixGetDepth(result) == 1 ? pixScaleToGray2(result)
+                                           : pixScaleAreaMap2(result);
+      pixDestroy(&result);
+      result = half;
+    }
+    if (result == NULL) return NULL;
+    pixSetXRes(result, pixGetXRes(pix) / reduction);
+    pixSetYRes(result, pixGetYRes(pix) / reduction);
+  } else if (2 * height < target_height && depth != 1) {
+    // Binary pages gain nothing from more pixels of the same edges.
+    result = depth == 8 ? pixScaleGray2xLI(pix) : pixScaleColor2xLI(pix);
+    if (result == NULL) return NULL;
+    pixSetXRes(result, pixGetXRes(pix) * 2);
+    pixSetYRes(result, pixGetYRes(pix) * 2);
+  }
+  return result;
+}
+
 bool TessBaseAPI::ProcessPage(Pix* pix, int page_index, const char* filename,
                               const char* retry_config, int timeout_millisec,
                               TessResultRenderer* renderer) {
   PERF_COUNT_START("ProcessPage")
   SetInputName(filename);
-  SetImage(pix);
+  // Nothing changes the page while it is recognized, so it is not copied.
+  SetBorrowedImage(pix);
   bool failed = false;
+  // Without a renderer the caller renders, and looks the page up itself.
+  bool cached = renderer != NULL && BeginCachedPage(renderer);
+  // Only the analyses the renderers read are done. Without a renderer the
+  // caller may read anything.
+  if (renderer != NULL) {
+    required_analysis_ = 0;
+    for (TessResultRenderer* r = renderer; r != NULL; r = r->next())
+      required_analysis_ |= r->RequiredAnalysis();
+  }
+  // The page is recognized, and rendered, at its working resolution.
+  Pix* working = NULL;
+  if (!cached && tesseract_->tessedit_adaptive_resolution) {
+    working = WorkingImage(pix, tesseract_->tessedit_target_text_height);
+    if (working != NULL) {
+      SetBorrowedImage(working);
+      pix = working;
+    }
+  }
+  // Curled text lines are straightened before anything looks at them,
+  // unless the text is laid over the original page.
+  Pix* dewarped = NULL;
+  if (!cached && tesseract_->tessedit_dewarp && !tesseract_->textonly_pdf) {
+    if (dewarp_models_ == NULL) {
+      dewarp_models_ = new DewarpModelIndex;
+      owns_dewarp_models_ = true;
+    }
+    dewarped = dewarp_models_->Dewarp(pix, page_index);
+    if (dewarped != NULL) {
+      SetBorrowedImage(dewarped);
+      pix = dewarped;
+    }
+  }
 
-  if (tesseract_->tessedit_pageseg_mode == PSM_AUTO_ONLY) {
+  if (cached) {
+    // The renderers redraw the page from the cache.
+  } else if (tesseract_->tessedit_pageseg_mode == PSM_AUTO_ONLY) {
     // Disabled character recognition
     PageIterator* it = AnalyseLayout();
 
@@ -1207,14 +1738,14 @@ bool TessBaseAPI::ProcessPage(Pix* pix, int page_index, const char* filename,
 #endif  // ANDROID_BUILD
   }
 
-  if (failed && retry_config != NULL && retry_config[0] != '\0') {
+  if (failed && !cached && retry_config != NULL && retry_config[0] != '\0') {
     // Save current config variables before switching modes.
     FILE* fp = fopen(kOldVarsFile, "wb");
     PrintVariables(fp);
     fclose(fp);
     // Switch to alternate mode for retry.
     ReadConfigFile(retry_config);
-    SetImage(pix);
+    SetBorrowedImage(pix);
     Recognize(NULL);
     // Restore saved config variables.
     ReadConfigFile(kOldVarsFile);
@@ -1223,11 +1754,214 @@ bool TessBaseAPI::ProcessPage(Pix* pix, int page_index, const char* filename,
   if (renderer && !failed) {
     failed = !renderer->AddImage(this);
   }
+  if (renderer) EndCachedPage(!failed);
+  required_analysis_ = ANALYSIS_ALL;
+  SetInputImageData(NULL);
+  SetInputPageGeometry(NULL);
+  pixDestroy(&working);
+  pixDestroy(&dewarped);
 
   PERF_COUNT_END
   return !failed;
 }
 
+// Params that don't change the results of a page, as they only say where
+// and how much of them to cache.
+static const char* const kPageCacheParams[] = {
+  "page_cache_dir", "page_cache_size", "tessedit_reuse_duplicate_pages", NULL
+};
+
+// Appends the size and modification time of the file at path, or -1 if
+// there is none, so that a replaced file changes the page cache key.
+static void AddFileStamp(const STRING& path, STRING* settings) {
+  *settings += " ";
+  *settings += path;
+  struct stat st;
+  if (stat(path.string(), &st) != 0) {
+    settings->add_str_int(":", -1);
+    return;
+  }
+  char stamp[64];
+  snprintf(stamp, sizeof(stamp), ":%lld:%lld",
+           static_cast<long long>(st.st_size),
+           static_cast<long long>(st.st_mtime));
+  *settings += stamp;
+}
+
+bool TessBaseAPI::BeginCachedPage(TessResultRenderer* renderer) {
+  EndCachedPage(false);
+  const char* dir = tesseract_ != NULL ? tesseract_->page_cache_dir.string()
+                                       : NULL;
+  bool use_dir = dir != NULL && dir[0] != '\0';
+  bool use_duplicates = tesseract_ != NULL &&
+      tesseract_->tessedit_reuse_duplicate_pages;
+  Pix* pix = tesseract_ != NULL ? GetInputImage() : NULL;
+  if (renderer == NULL || (!use_dir && !use_duplicates) || pix == NULL)
+    return false;
+  // Mixed raster content pages are split by the words of the recognition,
+  // which a cached page doesn't have.
+  if (tesseract_->pdf_mrc && !tesseract_->textonly_pdf) return false;
+  // Everything besides the image that the rendered results depend on.
+  STRING settings;
+  settings.add_str_int("oem=", last_oem_requested_);
+  settings.add_str_int(" psm=", tesseract_->tessedit_pageseg_mode);
+  // Reduced pages are stored reduced by the pdf renderer.
+  if (tesseract_->tessedit_color_reduction) settings += " reduce";
+  if (tesseract_->tessedit_dewarp && !tesseract_->textonly_pdf)
+    settings += " dewarp";
+  settings += " lang=";
+  settings += GetInitLanguagesAsString();
+  // Every param that isn't at its default, such as white and black lists,
+  // user words and patterns or skipped blank pages, and the traineddata and
+  // user files of each language as they are now.
+  settings += " params=";
+  ParamUtils::AppendNonDefaultParams(GlobalParams(), kPageCacheParams,
+                                     &settings);
+  for (int i = -1; i < tesseract_->num_sub_langs(); ++i) {
+    Tesseract* lang_t = i < 0 ? tesseract_ : tesseract_->get_sub_lang(i);
+    Dict& dict = lang_t->getDict();
+    settings += " |";
+    ParamUtils::AppendNonDefaultParams(lang_t->params(), kPageCacheParams,
+                                       &settings);
+    const STRING& prefix = lang_t->language_data_path_prefix;
+    AddFileStamp(prefix + kTrainedDataSuffix, &settings);
+    if (!dict.user_words_file.empty())
+      AddFileStamp(dict.user_words_file, &settings);
+    else if (!dict.user_words_suffix.empty())
+      AddFileStamp(prefix + dict.user_words_suffix, &settings);
+    if (!dict.user_patterns_file.empty())
+      AddFileStamp(dict.user_patterns_file, &settings);
+    else if (!dict.user_patterns_suffix.empty())
+      AddFileStamp(prefix + dict.user_patterns_suffix, &settings);
+  }
+  const PdfPageGeometry* geometry = GetInputPageGeometry();
+  if (geometry != NULL) {
+    settings += " page=";
+    for (int i = 0; i < 4; ++i)
+      settings.add_str_double(i == 0 ? "" : ",", geometry->media_box[i]);
+    for (int i = 0; i < 4; ++i)
+      settings.add_str_double(",", geometry->crop_box[i]);
+    settings.add_str_int(",", geometry->rotate);
+  }
+  settings += " renderers=";
+  int num_renderers = 0;
+  for (TessResultRenderer* r = renderer; r != NULL; r = r->next()) {
+    if (!r->AddPageCacheKey(&settings)) return false;
+    ++num_renderers;
+  }
+
+  if (cached_page_ == NULL) cached_page_ = new CachedPage;
+  cached_page_->active = true;
+  cached_page_->settings = settings;
+  cached_page_->name = "";
+  cached_page_->hit = false;
+  if (use_dir) {
+    inT64 max_bytes = static_cast<inT64>(tesseract_->page_cache_size) << 20;
+    if (page_cache_ != NULL && page_cache_->dir() != dir) {
+      delete page_cache_;
+      page_cache_ = NULL;
+    }
+    if (page_cache_ == NULL) page_cache_ = new PageResultCache(dir, max_bytes);
+    page_cache_->set_max_bytes(max_bytes);
+    cached_page_->name = PageResultCache::EntryName(pix, settings);
+    cached_page_->hit = page_cache_->Lookup(cached_page_->name, settings,
+                                            &cached_page_->kinds,
+                                            &cached_page_->results) &&
+        cached_page_->kinds.size() == num_renderers;
+  }
+  if (!cached_page_->hit) {
+    cached_page_->kinds.clear();
+    cached_page_->results.clear();
+  }
+  if (!cached_page_->hit && use_duplicates) {
+    if (duplicate_pages_ == NULL) {
+      duplicate_pages_ = new DuplicatePageIndex;
+      owns_duplicate_pages_ = true;
+    }
+    cached_page_->page = DuplicatePageIndex::ReducePage(pix);
+    cached_page_->hit = cached_page_->page != NULL &&
+        duplicate_pages_->Lookup(
+            cached_page_->page, settings,
+            tesseract_->tessedit_duplicate_page_confidence,
+            &cached_page_->kinds, &cached_page_->results) &&
+        cached_page_->kinds.size() == num_renderers;
+    if (!cached_page_->hit) {
+      cached_page_->kinds.clear();
+      cached_page_->results.clear();
+    }
+  }
+  return cached_page_->hit;
+}
+
+void TessBaseAPI::EndCachedPage(bool ok) {
+  if (cached_page_ == NULL || !cached_page_->active) return;
+  if (ok && !cached_page_->hit && page_cache_ != NULL &&
+      cached_page_->name.length() > 0) {
+    page_cache_->Store(cached_page_->name, cached_page_->settings,
+                       cached_page_->kinds, cached_page_->results);
+  }
+  if (ok && !cached_page_->hit && cached_page_->page != NULL &&
+      duplicate_pages_ != NULL && page_res_ != NULL &&
+      tesseract_->ImageWidth() > 0) {
+    // Later pages are checked against the words found on this one, brought
+    // to the scale of its reduced image.
+    Boxa* words = GetWords(NULL);
+    if (words != NULL) {
+      float scale = static_cast<float>(pixGetWidth(cached_page_->page)) /
+          tesseract_->ImageWidth();
+      Boxa* scaled = boxaTransform(words, 0, 0, scale, scale);
+      boxaDestroy(&words);
+      words = scaled;
+    }
+    duplicate_pages_->Add(cached_page_->page, words, cached_page_->settings,
+                          cached_page_->kinds, cached_page_->results);
+    cached_page_->page = NULL;
+  }
+  pixDestroy(&cached_page_->page);
+  cached_page_->active = false;
+  cached_page_->hit = false;
+  cached_page_->kinds.clear();
+  cached_page_->results.clear();
+}
+
+const char* TessBaseAPI::GetCachedPageResult(const char* kind) const {
+  if (cached_page_ == NULL || !cached_page_->hit) return NULL;
+  for (int i = 0; i < cached_page_->kinds.size(); ++i) {
+    if (cached_page_->kinds[i] == kind)
+      return cached_page_->results[i].string();
+  }
+  return NULL;
+}
+
+void TessBaseAPI::AddPageResult(const char* kind, const char* result) {
+  if (cached_page_ == NULL || !cached_page_->active || cached_page_->hit)
+    return;
+  cached_page_->kinds.push_back(STRING(kind));
+  cached_page_->results.push_back(STRING(result));
+}
+
+void TessBaseAPI::ShareDuplicatePages(TessBaseAPI* api) {
+  if (api == this) return;
+  if (api->duplicate_pages_ == NULL) {
+    api->duplicate_pages_ = new DuplicatePageIndex;
+    api->owns_duplicate_pages_ = true;
+  }
+  if (owns_duplicate_pages_) delete duplicate_pages_;
+  duplicate_pages_ = api->duplicate_pages_;
+  owns_duplicate_pages_ = false;
+}
+
+void TessBaseAPI::ShareDewarpModels(TessBaseAPI* api) {
+  if (api == this) return;
+  if (api->dewarp_models_ == NULL) {
+    api->dewarp_models_ = new DewarpModelIndex;
+    api->owns_dewarp_models_ = true;
+  }
+  if (owns_dewarp_models_) delete dewarp_models_;
+  dewarp_models_ = api->dewarp_models_;
+  owns_dewarp_models_ = false;
+}
+
 /**
  * Get a left-to-right iterator to the results of LayoutAnalysis and/or
  * Recognize. The returned iterator must be deleted after use.
@@ -1269,12 +2003,35 @@ ResultIterator* TessBaseAPI::GetIterator() {
 MutableIterator* TessBaseAPI::GetMutableIterator() {
   if (tesseract_ == NULL || page_res_ == NULL)
     return NULL;
+  // The results may be changed through it.
+  ClearPageResults();
   return new MutableIterator(page_res_, tesseract_,
                              thresholder_->GetScaleFactor(),
                              thresholder_->GetScaledYResolution(),
                              rect_left_, rect_top_, rect_width_, rect_height_);
 }
 
+/**
+ * Returns the results of the page flattened by PageResults::Build, walking
+ * them only the first time they are asked for.
+ */
+const PageResults* TessBaseAPI::GetPageResults(ETEXT_DESC* monitor) {
+  if (page_results_ != NULL) return page_results_;
+  if (tesseract_ == NULL || (page_res_ == NULL && Recognize(monitor) < 0))
+    return NULL;
+  ResultIterator* it = GetIterator();
+  if (it == NULL) return NULL;
+  page_results_ = new PageResults;
+  page_results_->Build(it);
+  delete it;
+  return page_results_;
+}
+
+void TessBaseAPI::ClearPageResults() {
+  delete page_results_;
+  page_results_ = NULL;
+}
+
 /** Make a text string from the internal data structures. */
 char* TessBaseAPI::GetUTF8Text() {
   if (tesseract_ == NULL ||
@@ -1294,49 +2051,32 @@ char* TessBaseAPI::GetUTF8Text() {
 }
 
 /**
- * Gets the block orientation at the current iterator position.
- */
-static tesseract::Orientation GetBlockTextOrientation(const PageIterator *it) {
-  tesseract::Orientation orientation;
-  tesseract::WritingDirection writing_direction;
-  tesseract::TextlineOrder textline_order;
-  float deskew_angle;
-  it->Orientation(&orientation, &writing_direction, &textline_order,
-                  &deskew_angle);
-  return orientation;
-}
-
-/**
- * Fits a line to the baseline at the given level, and appends its coefficients
+ * Fits a line to the baseline of the line, and appends its coefficients
  * to the hOCR string.
  * NOTE: The hOCR spec is unclear on how to specify baseline coefficients for
  * rotated textlines. For this reason, on textlines that are not upright, this
  * method currently only inserts a 'textangle' property to indicate the rotation
  * direction and does not add any baseline information to the hocr string.
  */
-static void AddBaselineCoordsTohOCR(const PageIterator *it,
-                                    PageIteratorLevel level,
-                                    STRING* hocr_str) {
-  tesseract::Orientation orientation = GetBlockTextOrientation(it);
+static void AddBaselineCoordsTohOCR(const PageResultBlock& block,
+                                    const PageResultLine& line,
+                                    TextWriter* hocr_str) {
+  tesseract::Orientation orientation = block.orientation;
   if (orientation != ORIENTATION_PAGE_UP) {
     hocr_str->add_str_int("; textangle ", 360 - orientation * 90);
     return;
   }
 
-  int left, top, right, bottom;
-  it->BoundingBox(level, &left, &top, &right, &bottom);
-
   // Try to get the baseline coordinates at this level.
-  int x1, y1, x2, y2;
-  if (!it->Baseline(level, &x1, &y1, &x2, &y2))
+  if (!line.baseline.ok)
     return;
   // Following the description of this field of the hOCR spec, we convert the
   // baseline coordinates so that "the bottom left of the bounding box is the
   // origin".
-  x1 -= left;
-  x2 -= left;
-  y1 -= bottom;
-  y2 -= bottom;
+  int x1 = line.baseline.x1 - line.box.left;
+  int x2 = line.baseline.x2 - line.box.left;
+  int y1 = line.baseline.y1 - line.box.bottom;
+  int y2 = line.baseline.y2 - line.box.bottom;
 
   // Now fit a line through the points so we can extract coefficients for the
   // equation:  y = p1 x + p0
@@ -1353,7 +2093,21 @@ static void AddBaselineCoordsTohOCR(const PageIterator *it,
   hocr_str->add_str_double(" ", round(p0 * 1000.0) / 1000.0);
 }
 
-static void AddIdTohOCR(STRING* hocr_str, const std::string base, int num1,
+// Appends text to writer with the escapes of HOcrEscape.
+static void AppendHOcrEscaped(const char* text, TextWriter* writer) {
+  for (const char* ptr = text; *ptr; ptr++) {
+    switch (*ptr) {
+      case '<': *writer += "&lt;"; break;
+      case '>': *writer += "&gt;"; break;
+      case '&': *writer += "&amp;"; break;
+      case '"': *writer += "&quot;"; break;
+      case '\'': *writer += "&#39;"; break;
+      default: *writer += *ptr;
+    }
+  }
+}
+
+static void AddIdTohOCR(TextWriter* hocr_str, const std::string base, int num1,
                         int num2) {
   const size_t BUFSIZE = 64;
   char id_buffer[BUFSIZE];
@@ -1368,38 +2122,34 @@ static void AddIdTohOCR(STRING* hocr_str, const std::string base, int num1,
   *hocr_str += "'";
 }
 
-static void AddBoxTohOCR(const ResultIterator* it, PageIteratorLevel level,
-                         STRING* hocr_str) {
-  int left, top, right, bottom;
-  it->BoundingBox(level, &left, &top, &right, &bottom);
+// Adds the box, and for a textline, given with its block, its baseline
+// coordinates and heights.
+static void AddBoxTohOCR(const PageResultBox& box,
+                         const PageResultBlock* block,
+                         const PageResultLine* line, TextWriter* hocr_str) {
   // This is the only place we use double quotes instead of single quotes,
   // but it may too late to change for consistency
-  hocr_str->add_str_int(" title=\"bbox ", left);
-  hocr_str->add_str_int(" ", top);
-  hocr_str->add_str_int(" ", right);
-  hocr_str->add_str_int(" ", bottom);
+  hocr_str->add_str_int(" title=\"bbox ", box.left);
+  hocr_str->add_str_int(" ", box.top);
+  hocr_str->add_str_int(" ", box.right);
+  hocr_str->add_str_int(" ", box.bottom);
   // Add baseline coordinates & heights for textlines only.
-  if (level == RIL_TEXTLINE) {
-    AddBaselineCoordsTohOCR(it, level, hocr_str);
+  if (line != NULL) {
+    AddBaselineCoordsTohOCR(*block, *line, hocr_str);
     // add custom height measures
-    float row_height, descenders, ascenders;  // row attributes
-    it->RowAttributes(&row_height, &descenders, &ascenders);
     // TODO(rays): Do we want to limit these to a single decimal place?
-    hocr_str->add_str_double("; x_size ", row_height);
-    hocr_str->add_str_double("; x_descenders ", descenders * -1);
-    hocr_str->add_str_double("; x_ascenders ", ascenders);
+    hocr_str->add_str_double("; x_size ", line->row_height);
+    hocr_str->add_str_double("; x_descenders ", line->descenders * -1);
+    hocr_str->add_str_double("; x_ascenders ", line->ascenders);
   }
   *hocr_str += "\">";
 }
 
-static void AddBoxToTSV(const PageIterator* it, PageIteratorLevel level,
-                        STRING* hocr_str) {
-  int left, top, right, bottom;
-  it->BoundingBox(level, &left, &top, &right, &bottom);
-  hocr_str->add_str_int("\t", left);
-  hocr_str->add_str_int("\t", top);
-  hocr_str->add_str_int("\t", right - left);
-  hocr_str->add_str_int("\t", bottom - top);
+static void AddBoxToTSV(const PageResultBox& box, TextWriter* hocr_str) {
+  hocr_str->add_str_int("\t", box.left);
+  hocr_str->add_str_int("\t", box.top);
+  hocr_str->add_str_int("\t", box.right - box.left);
+  hocr_str->add_str_int("\t", box.bottom - box.top);
 }
 
 /**
@@ -1425,18 +2175,32 @@ char* TessBaseAPI::GetHOCRText(int page_number) {
  * Returned string must be freed with the delete [] operator.
  */
 char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
-  if (tesseract_ == NULL || (page_res_ == NULL && Recognize(monitor) < 0))
-    return NULL;
+  STRING hocr_str;
+  {
+    StringTextWriter writer(&hocr_str);
+    if (!WriteHOCRText(monitor, page_number, &writer)) return NULL;
+  }
+  char *ret = new char[hocr_str.length() + 1];
+  strcpy(ret, hocr_str.string());
+  return ret;
+}
+
+/**
+ * Writes the hOCR markup of GetHOCRText to writer as it is produced,
+ * without building the whole page in memory.
+ * Returns false if recognition fails, before anything is written.
+ */
+bool TessBaseAPI::WriteHOCRText(ETEXT_DESC* monitor, int page_number,
+                                TextWriter* hocr_str) {
+  const PageResults* results = GetPageResults(monitor);
+  if (results == NULL)
+    return false;
 
   int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1;
   int page_id = page_number + 1;  // hOCR uses 1-based page numbers.
-  bool para_is_ltr = true;        // Default direction is LTR
-  const char* paragraph_lang = NULL;
   bool font_info = false;
   GetBoolVariable("hocr_font_info", &font_info);
 
-  STRING hocr_str("");
-
   if (input_file_ == NULL)
       SetInputName(NULL);
 
@@ -1457,137 +2221,128 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
   delete[] utf8_str;
 #endif
 
-  hocr_str += "  <div class='ocr_page'";
-  AddIdTohOCR(&hocr_str, "page", page_id, -1);
-  hocr_str += " title='image \"";
+  *hocr_str += "  <div class='ocr_page'";
+  AddIdTohOCR(hocr_str, "page", page_id, -1);
+  *hocr_str += " title='image \"";
   if (input_file_) {
-    hocr_str += HOcrEscape(input_file_->string());
+    AppendHOcrEscaped(input_file_->string(), hocr_str);
   } else {
-    hocr_str += "unknown";
-  }
-  hocr_str.add_str_int("\"; bbox ", rect_left_);
-  hocr_str.add_str_int(" ", rect_top_);
-  hocr_str.add_str_int(" ", rect_width_);
-  hocr_str.add_str_int(" ", rect_height_);
-  hocr_str.add_str_int("; ppageno ", page_number);
-  hocr_str += "'>\n";
-
-  ResultIterator *res_it = GetIterator();
-  while (!res_it->Empty(RIL_BLOCK)) {
-    if (res_it->Empty(RIL_WORD)) {
-      res_it->Next(RIL_WORD);
-      continue;
-    }
+    *hocr_str += "unknown";
+  }
+  hocr_str->add_str_int("\"; bbox ", rect_left_);
+  hocr_str->add_str_int(" ", rect_top_);
+  hocr_str->add_str_int(" ", rect_width_);
+  hocr_str->add_str_int(" ", rect_height_);
+  hocr_str->add_str_int("; ppageno ", page_number);
+  *hocr_str += "'>\n";
+
+  for (int w = 0; w < static_cast<int>(results->words.size()); ++w) {
+    const PageResultWord& word = results->words[w];
+    const PageResultBlock& block = results->blocks[word.block];
+    const PageResultPara& para = results->paras[word.para];
+    bool para_is_ltr = para.is_ltr;
+    const char* paragraph_lang = para.lang;
 
     // Open any new block/paragraph/textline.
-    if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
-      para_is_ltr = true;  // reset to default direction
-      hocr_str += "   <div class='ocr_carea'";
-      AddIdTohOCR(&hocr_str, "block", page_id, bcnt);
-      AddBoxTohOCR(res_it, RIL_BLOCK, &hocr_str);
-    }
-    if (res_it->IsAtBeginningOf(RIL_PARA)) {
-      hocr_str += "\n    <p class='ocr_par'";
-      para_is_ltr = res_it->ParagraphIsLtr();
+    if (results->FirstWordInBlock(w)) {
+      *hocr_str += "   <div class='ocr_carea'";
+      AddIdTohOCR(hocr_str, "block", page_id, bcnt);
+      AddBoxTohOCR(block.box, NULL, NULL, hocr_str);
+    }
+    if (results->FirstWordInPara(w)) {
+      *hocr_str += "\n    <p class='ocr_par'";
       if (!para_is_ltr) {
-        hocr_str += " dir='rtl'";
+        *hocr_str += " dir='rtl'";
       }
-      AddIdTohOCR(&hocr_str, "par", page_id, pcnt);
-      paragraph_lang = res_it->WordRecognitionLanguage();
+      AddIdTohOCR(hocr_str, "par", page_id, pcnt);
       if (paragraph_lang) {
-        hocr_str += " lang='";
-        hocr_str += paragraph_lang;
-        hocr_str += "'";
+        *hocr_str += " lang='";
+        *hocr_str += paragraph_lang;
+        *hocr_str += "'";
       }
-      AddBoxTohOCR(res_it, RIL_PARA, &hocr_str);
+      AddBoxTohOCR(para.box, NULL, NULL, hocr_str);
     }
-    if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
-      hocr_str += "\n     <span class='ocr_line'";
-      AddIdTohOCR(&hocr_str, "line", page_id, lcnt);
-      AddBoxTohOCR(res_it, RIL_TEXTLINE, &hocr_str);
+    if (results->FirstWordInLine(w)) {
+      *hocr_str += "\n     <span class='ocr_line'";
+      AddIdTohOCR(hocr_str, "line", page_id, lcnt);
+      AddBoxTohOCR(results->lines[word.line].box, &block,
+                   &results->lines[word.line], hocr_str);
     }
 
     // Now, process the word...
-    hocr_str += "<span class='ocrx_word'";
-    AddIdTohOCR(&hocr_str, "word", page_id, wcnt);
-    int left, top, right, bottom;
-    bool bold, italic, underlined, monospace, serif, smallcaps;
-    int pointsize, font_id;
-    const char *font_name;
-    res_it->BoundingBox(RIL_WORD, &left, &top, &right, &bottom);
-    font_name = res_it->WordFontAttributes(&bold, &italic, &underlined,
-                                           &monospace, &serif, &smallcaps,
-                                           &pointsize, &font_id);
-    hocr_str.add_str_int(" title='bbox ", left);
-    hocr_str.add_str_int(" ", top);
-    hocr_str.add_str_int(" ", right);
-    hocr_str.add_str_int(" ", bottom);
-    hocr_str.add_str_int("; x_wconf ", res_it->Confidence(RIL_WORD));
+    *hocr_str += "<span class='ocrx_word'";
+    AddIdTohOCR(hocr_str, "word", page_id, wcnt);
+    hocr_str->add_str_int(" title='bbox ", word.box.left);
+    hocr_str->add_str_int(" ", word.box.top);
+    hocr_str->add_str_int(" ", word.box.right);
+    hocr_str->add_str_int(" ", word.box.bottom);
+    hocr_str->add_str_int("; x_wconf ", word.confidence);
     if (font_info) {
-      if (font_name) {
-        hocr_str += "; x_font ";
-        hocr_str += HOcrEscape(font_name);
+      if (word.font_name) {
+        *hocr_str += "; x_font ";
+        AppendHOcrEscaped(word.font_name, hocr_str);
       }
-      hocr_str.add_str_int("; x_fsize ", pointsize);
+      hocr_str->add_str_int("; x_fsize ", word.pointsize);
     }
-    hocr_str += "'";
-    const char* lang = res_it->WordRecognitionLanguage();
+    *hocr_str += "'";
+    const char* lang = word.lang;
     if (lang && (!paragraph_lang || strcmp(lang, paragraph_lang))) {
-      hocr_str += " lang='";
-      hocr_str += lang;
-      hocr_str += "'";
+      *hocr_str += " lang='";
+      *hocr_str += lang;
+      *hocr_str += "'";
     }
-    switch (res_it->WordDirection()) {
+    switch (word.direction) {
       // Only emit direction if different from current paragraph direction
       case DIR_LEFT_TO_RIGHT:
-        if (!para_is_ltr) hocr_str += " dir='ltr'";
+        if (!para_is_ltr) *hocr_str += " dir='ltr'";
         break;
       case DIR_RIGHT_TO_LEFT:
-        if (para_is_ltr) hocr_str += " dir='rtl'";
+        if (para_is_ltr) *hocr_str += " dir='rtl'";
         break;
       case DIR_MIX:
       case DIR_NEUTRAL:
       default:  // Do nothing.
         break;
     }
-    hocr_str += ">";
-    bool last_word_in_line = res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD);
-    bool last_word_in_para = res_it->IsAtFinalElement(RIL_PARA, RIL_WORD);
-    bool last_word_in_block = res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD);
-    if (bold) hocr_str += "<strong>";
-    if (italic) hocr_str += "<em>";
-    do {
-      const std::unique_ptr<const char[]> grapheme(
-          res_it->GetUTF8Text(RIL_SYMBOL));
-      if (grapheme && grapheme[0] != 0) {
-        hocr_str += HOcrEscape(grapheme.get());
-      }
-      res_it->Next(RIL_SYMBOL);
-    } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
-    if (italic) hocr_str += "</em>";
-    if (bold) hocr_str += "</strong>";
-    hocr_str += "</span> ";
+    *hocr_str += ">";
+    if (word.bold) *hocr_str += "<strong>";
+    if (word.italic) *hocr_str += "<em>";
+    AppendHOcrEscaped(results->WordText(word), hocr_str);
+    if (word.italic) *hocr_str += "</em>";
+    if (word.bold) *hocr_str += "</strong>";
+    *hocr_str += "</span> ";
     wcnt++;
     // Close any ending block/paragraph/textline.
-    if (last_word_in_line) {
-      hocr_str += "\n     </span>";
+    if (results->LastWordInLine(w)) {
+      *hocr_str += "\n     </span>";
       lcnt++;
     }
-    if (last_word_in_para) {
-      hocr_str += "\n    </p>\n";
+    if (results->LastWordInPara(w)) {
+      *hocr_str += "\n    </p>\n";
       pcnt++;
-      para_is_ltr = true;  // back to default direction
     }
-    if (last_word_in_block) {
-      hocr_str += "   </div>\n";
+    if (results->LastWordInBlock(w)) {
+      *hocr_str += "   </div>\n";
       bcnt++;
     }
   }
-  hocr_str += "  </div>\n";
+  *hocr_str += "  </div>\n";
+  return true;
+}
 
-  char *ret = new char[hocr_str.length() + 1];
-  strcpy(ret, hocr_str.string());
-  delete res_it;
+/**
+ * Make a single line JSON object from GetPageProfile, with the 0-based
+ * page_number appearing as 1-based.
+ * Returned string must be freed with the delete [] operator.
+ */
+char* TessBaseAPI::GetProfileJSON(int page_number) {
+  STRING json;
+  json.add_str_int("{\"page\":", page_number + 1);
+  json += ",\"profile\":";
+  profile_->AppendJSON(&json);
+  json += "}";
+  char* ret = new char[json.length() + 1];
+  strcpy(ret, json.string());
   return ret;
 }
 
@@ -1597,101 +2352,90 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
  * Returned string must be freed with the delete [] operator.
  */
 char* TessBaseAPI::GetTSVText(int page_number) {
-  if (tesseract_ == NULL || (page_res_ == NULL && Recognize(NULL) < 0))
-    return NULL;
+  STRING tsv_str;
+  {
+    StringTextWriter writer(&tsv_str);
+    if (!WriteTSVText(page_number, &writer)) return NULL;
+  }
+  char* ret = new char[tsv_str.length() + 1];
+  strcpy(ret, tsv_str.string());
+  return ret;
+}
 
-  int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1;
-  int page_id = page_number + 1;  // we use 1-based page numbers.
+/**
+ * Writes the rows of GetTSVText to writer as they are produced.
+ * Returns false if recognition fails, before anything is written.
+ */
+bool TessBaseAPI::WriteTSVText(int page_number, TextWriter* tsv_str) {
+  const PageResults* results = GetPageResults(NULL);
+  if (results == NULL)
+    return false;
 
-  STRING tsv_str("");
+  int page_id = page_number + 1;  // we use 1-based page numbers.
 
   int page_num = page_id, block_num = 0, par_num = 0, line_num = 0,
       word_num = 0;
 
-  tsv_str.add_str_int("1\t", page_num);  // level 1 - page
-  tsv_str.add_str_int("\t", block_num);
-  tsv_str.add_str_int("\t", par_num);
-  tsv_str.add_str_int("\t", line_num);
-  tsv_str.add_str_int("\t", word_num);
-  tsv_str.add_str_int("\t", rect_left_);
-  tsv_str.add_str_int("\t", rect_top_);
-  tsv_str.add_str_int("\t", rect_width_);
-  tsv_str.add_str_int("\t", rect_height_);
-  tsv_str += "\t-1\t\n";
-
-  ResultIterator* res_it = GetIterator();
-  while (!res_it->Empty(RIL_BLOCK)) {
-    if (res_it->Empty(RIL_WORD)) {
-      res_it->Next(RIL_WORD);
-      continue;
-    }
+  tsv_str->add_str_int("1\t", page_num);  // level 1 - page
+  tsv_str->add_str_int("\t", block_num);
+  tsv_str->add_str_int("\t", par_num);
+  tsv_str->add_str_int("\t", line_num);
+  tsv_str->add_str_int("\t", word_num);
+  tsv_str->add_str_int("\t", rect_left_);
+  tsv_str->add_str_int("\t", rect_top_);
+  tsv_str->add_str_int("\t", rect_width_);
+  tsv_str->add_str_int("\t", rect_height_);
+  *tsv_str += "\t-1\t\n";
+
+  for (int w = 0; w < static_cast<int>(results->words.size()); ++w) {
+    const PageResultWord& word = results->words[w];
 
     // Add rows for any new block/paragraph/textline.
-    if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
+    if (results->FirstWordInBlock(w)) {
       block_num++, par_num = 0, line_num = 0, word_num = 0;
-      tsv_str.add_str_int("2\t", page_num);  // level 2 - block
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_BLOCK, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for block
-    }
-    if (res_it->IsAtBeginningOf(RIL_PARA)) {
+      tsv_str->add_str_int("2\t", page_num);  // level 2 - block
+      tsv_str->add_str_int("\t", block_num);
+      tsv_str->add_str_int("\t", par_num);
+      tsv_str->add_str_int("\t", line_num);
+      tsv_str->add_str_int("\t", word_num);
+      AddBoxToTSV(results->blocks[word.block].box, tsv_str);
+      *tsv_str += "\t-1\t\n";  // end of row for block
+    }
+    if (results->FirstWordInPara(w)) {
       par_num++, line_num = 0, word_num = 0;
-      tsv_str.add_str_int("3\t", page_num);  // level 3 - paragraph
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_PARA, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for para
-    }
-    if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
+      tsv_str->add_str_int("3\t", page_num);  // level 3 - paragraph
+      tsv_str->add_str_int("\t", block_num);
+      tsv_str->add_str_int("\t", par_num);
+      tsv_str->add_str_int("\t", line_num);
+      tsv_str->add_str_int("\t", word_num);
+      AddBoxToTSV(results->paras[word.para].box, tsv_str);
+      *tsv_str += "\t-1\t\n";  // end of row for para
+    }
+    if (results->FirstWordInLine(w)) {
       line_num++, word_num = 0;
-      tsv_str.add_str_int("4\t", page_num);  // level 4 - line
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_TEXTLINE, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for line
+      tsv_str->add_str_int("4\t", page_num);  // level 4 - line
+      tsv_str->add_str_int("\t", block_num);
+      tsv_str->add_str_int("\t", par_num);
+      tsv_str->add_str_int("\t", line_num);
+      tsv_str->add_str_int("\t", word_num);
+      AddBoxToTSV(results->lines[word.line].box, tsv_str);
+      *tsv_str += "\t-1\t\n";  // end of row for line
     }
 
     // Now, process the word...
-    int left, top, right, bottom;
-    res_it->BoundingBox(RIL_WORD, &left, &top, &right, &bottom);
     word_num++;
-    tsv_str.add_str_int("5\t", page_num);  // level 5 - word
-    tsv_str.add_str_int("\t", block_num);
-    tsv_str.add_str_int("\t", par_num);
-    tsv_str.add_str_int("\t", line_num);
-    tsv_str.add_str_int("\t", word_num);
-    tsv_str.add_str_int("\t", left);
-    tsv_str.add_str_int("\t", top);
-    tsv_str.add_str_int("\t", right - left);
-    tsv_str.add_str_int("\t", bottom - top);
-    tsv_str.add_str_int("\t", res_it->Confidence(RIL_WORD));
-    tsv_str += "\t";
-
-    // Increment counts if at end of block/paragraph/textline.
-    if (res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD)) lcnt++;
-    if (res_it->IsAtFinalElement(RIL_PARA, RIL_WORD)) pcnt++;
-    if (res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD)) bcnt++;
-
-    do {
-      tsv_str +=
-          std::unique_ptr<const char[]>(res_it->GetUTF8Text(RIL_SYMBOL)).get();
-      res_it->Next(RIL_SYMBOL);
-    } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
-    tsv_str += "\n";  // end of row
-    wcnt++;
+    tsv_str->add_str_int("5\t", page_num);  // level 5 - word
+    tsv_str->add_str_int("\t", block_num);
+    tsv_str->add_str_int("\t", par_num);
+    tsv_str->add_str_int("\t", line_num);
+    tsv_str->add_str_int("\t", word_num);
+    AddBoxToTSV(word.box, tsv_str);
+    tsv_str->add_str_int("\t", word.confidence);
+    *tsv_str += "\t";
+    *tsv_str += results->WordText(word);
+    *tsv_str += "\n";  // end of row
   }
-
-  char* ret = new char[tsv_str.length() + 1];
-  strcpy(ret, tsv_str.string());
-  delete res_it;
-  return ret;
+  return true;
 }
 
 /** The 5 numbers output for each box (the usual 4 and a page number.) */
@@ -1782,6 +2526,7 @@ char* TessBaseAPI::GetUNLVText() {
   if (tesseract_ == NULL ||
       (!recognition_done_ && Recognize(NULL) < 0))
     return NULL;
+  tesseract_->RunDeferredRejection(page_res_);
   bool tilde_crunch_written = false;
   bool last_char_was_newline = true;
   bool last_char_was_tilde = false;
@@ -2026,6 +2771,7 @@ bool TessBaseAPI::AdaptToWordStr(PageSegMode mode, const char* wordstr) {
     }
     if (text[t] != '\0' || wordstr[w] != '\0') {
       // No match.
+      ClearPageResults();
       delete page_res_;
       GenericVector<TBOX> boxes;
       page_res_ = tesseract_->SetupApplyBoxes(boxes, block_list_);
@@ -2061,6 +2807,8 @@ void TessBaseAPI::Clear() {
     thresholder_->Clear();
   ClearResults();
   if (tesseract_ != NULL) SetInputImage(NULL);
+  SetInputImageData(NULL);
+  SetInputPageGeometry(NULL);
 }
 
 /**
@@ -2073,6 +2821,7 @@ void TessBaseAPI::End() {
   Clear();
   delete thresholder_;
   thresholder_ = NULL;
+  ClearPageResults();
   delete page_res_;
   page_res_ = NULL;
   delete block_list_;
@@ -2097,6 +2846,16 @@ void TessBaseAPI::End() {
   datapath_ = NULL;
   delete language_;
   language_ = NULL;
+  delete page_cache_;
+  page_cache_ = NULL;
+  delete cached_page_;
+  cached_page_ = NULL;
+  if (owns_duplicate_pages_) delete duplicate_pages_;
+  duplicate_pages_ = NULL;
+  owns_duplicate_pages_ = false;
+  if (owns_dewarp_models_) delete dewarp_models_;
+  dewarp_models_ = NULL;
+  owns_dewarp_models_ = false;
 }
 
 // Clear any library-level memory caches.
@@ -2197,6 +2956,9 @@ bool TessBaseAPI::InternalSetImage() {
   if (thresholder_ == NULL)
     thresholder_ = new ImageThresholder;
   ClearResults();
+  // The pool is process wide; this only changes it when the value does.
+  pixPoolSetLimit(pix_pool_mb > 0 ? static_cast<size_t>(pix_pool_mb) << 20
+                                  : 0);
   return true;
 }
 
@@ -2222,11 +2984,51 @@ bool TessBaseAPI::Threshold(Pix** pix) {
   PageSegMode pageseg_mode =
       static_cast<PageSegMode>(
           static_cast<int>(tesseract_->tessedit_pageseg_mode));
-  if (!thresholder_->ThresholdToPix(pageseg_mode, pix)) return false;
+  int method = tesseract_->thresholding_method;
+  if (method < 0 || method >= THRESHOLD_METHOD_COUNT) {
+    tprintf("Warning. Invalid thresholding method %d. Using Otsu.\n", method);
+    method = THRESHOLD_OTSU;
+  }
+  thresholder_->SetThresholdMethod(
+      static_cast<ThresholdMethod>(method),
+      tesseract_->thresholding_window_size, tesseract_->thresholding_kfactor,
+      tesseract_->thresholding_tile_size,
+      tesseract_->thresholding_smooth_kernel_size,
+      tesseract_->thresholding_score_fraction);
   thresholder_->GetImageSizes(&rect_left_, &rect_top_,
                               &rect_width_, &rect_height_,
                               &image_width_, &image_height_);
-  if (!thresholder_->IsBinary()) {
+  // A blank page is thresholded to nothing, so that layout and recognition
+  // are over as soon as they start, and its renderers write an empty page.
+  bool blank = tesseract_->tessedit_skip_blank_pages &&
+      thresholder_->IsBlank(tesseract_->tessedit_blank_page_ink);
+  // The whole image is reduced, so only when it is all being recognized,
+  // and its input image is taken again, as it was a clone of the original.
+  if (!blank && tesseract_->tessedit_color_reduction &&
+      !thresholder_->IsBinary() &&
+      rect_width_ == image_width_ && rect_height_ == image_height_) {
+    Pix* input = GetInputImage();
+    int input_depth = input != NULL ? pixGetDepth(input) : 0;
+    if (thresholder_->ReduceColor() != IMAGE_COLOR) {
+      Pix* reduced = thresholder_->GetPixRect();
+      if (pixGetDepth(reduced) != input_depth) {
+        SetInputImage(reduced);
+      } else {
+        pixDestroy(&reduced);
+      }
+    }
+  }
+  if (blank) {
+    *pix = pixCreate(rect_width_, rect_height_, 1);
+    if (*pix == NULL) return false;
+    profile_->AddCount(PROFILE_BLANK, 1);
+  } else if (!thresholder_->ThresholdToPix(pageseg_mode, pix)) {
+    return false;
+  }
+  thresholder_->GetImageSizes(&rect_left_, &rect_top_,
+                              &rect_width_, &rect_height_,
+                              &image_width_, &image_height_);
+  if (!blank && !thresholder_->IsBinary()) {
     tesseract_->set_pix_thresholds(thresholder_->GetPixRectThresholds());
     tesseract_->set_pix_grey(thresholder_->GetPixRectGrey());
   } else {
@@ -2251,6 +3053,7 @@ bool TessBaseAPI::Threshold(Pix** pix) {
 
 /** Find lines from the image making the BLOCK_LIST. */
 int TessBaseAPI::FindLines() {
+  TESS_TRACE_SPAN("TessBaseAPI::FindLines");
   if (thresholder_ == NULL || thresholder_->IsEmpty()) {
     tprintf("Please call SetImage before attempting recognition.\n");
     return -1;
@@ -2264,9 +3067,10 @@ int TessBaseAPI::FindLines() {
     tesseract_ = new Tesseract;
     tesseract_->InitAdaptiveClassifier(nullptr);
   }
-  if (tesseract_->pix_binary() == NULL &&
-      !Threshold(tesseract_->mutable_pix_binary())) {
-    return -1;
+  tesseract_->set_profile(profile_);
+  if (tesseract_->pix_binary() == NULL) {
+    ProfileTimer timer(profile_, PROFILE_THRESHOLD);
+    if (!Threshold(tesseract_->mutable_pix_binary())) return -1;
   }
 
   tesseract_->PrepareForPageseg();
@@ -2302,6 +3106,7 @@ int TessBaseAPI::FindLines() {
     }
   }
 
+  ProfileTimer timer(profile_, PROFILE_LAYOUT);
   if (tesseract_->SegmentPage(input_file_, block_list_, osd_tess, &osr) < 0)
     return -1;
   // If Devanagari is being recognized, we use different images for page seg
@@ -2316,10 +3121,12 @@ void TessBaseAPI::ClearResults() {
     tesseract_->Clear();
   }
   if (page_res_ != NULL) {
+    ClearPageResults();
     delete page_res_;
     page_res_ = NULL;
   }
   recognition_done_ = false;
+  profile_->Clear();
   if (block_list_ == NULL)
     block_list_ = new BLOCK_LIST;
   else
@@ -2342,6 +3149,7 @@ void TessBaseAPI::ClearResults() {
 int TessBaseAPI::TextLength(int* blob_count) {
   if (tesseract_ == NULL || page_res_ == NULL)
     return 0;
+  tesseract_->RunDeferredRejection(page_res_);
 
   PAGE_RES_IT   page_res_it(page_res_);
   int total_length = 2;
@@ -48,6 +48,7 @@ class WERD;
 struct Pix;
 struct Box;
 struct Pixa;
+struct L_Compressed_Data;
 struct Boxa;
 class ETEXT_DESC;
 struct OSResults;
@@ -61,15 +62,23 @@ struct TBLOB;
 
 namespace tesseract {
 
+struct CachedPage;
 class Dawg;
+class DewarpModelIndex;
 class Dict;
+class DuplicatePageIndex;
 class EquationDetect;
 class PageIterator;
+class PageProfile;
+class PdfPageCopier;
+class PageResultCache;
+struct PageResults;
 class LTRResultIterator;
 class ResultIterator;
 class MutableIterator;
 class TessResultRenderer;
 class Tesseract;
+class TextWriter;
 class Trie;
 class Wordrec;
 
@@ -89,6 +98,36 @@ typedef void (Wordrec::*FillLatticeFunc)(const MATRIX &ratings,
 typedef TessCallback4<const UNICHARSET &, int, PageIterator *, Pix *>
     TruthCallback;
 
+/**
+ * Geometry of the PDF page an input image was read from, in points of the
+ * page's default user space, and where to copy the page itself from.
+ */
+struct PdfPageGeometry {
+  double media_box[4];    ///< x1 y1 x2 y2 of the /MediaBox.
+  double crop_box[4];     ///< x1 y1 x2 y2 of the /CropBox.
+  int rotate;             ///< /Rotate, a multiple of 90.
+  PdfPageCopier* source;  ///< Copies the page for pdf_overlay, or NULL.
+                          ///< Only used by the renderers, in page order.
+  int page_index;         ///< 0-based index of the page in source.
+};
+
+/**
+ * A rectangle of the image for TessBaseAPI::RecognizeFields, such as a field
+ * of a form, in the coordinates of the full image.
+ */
+struct OcrField {
+  int left;
+  int top;
+  int width;
+  int height;
+  PageSegMode psm;        ///< Layout of the field. OSD modes are not allowed.
+  const char* whitelist;  ///< Characters allowed, or NULL for the
+                          ///< tessedit_char_whitelist in force.
+  bool no_language_model; ///< Recognize with no dictionary, ambiguities or
+                          ///< fixspace, as by tessedit_no_language_model,
+                          ///< for IDs and codes. False if left out.
+};
+
 /**
  * Base class for all tesseract APIs.
  * Specific classes can add ability to work on different inputs or produce
@@ -138,6 +177,27 @@ class TESS_API TessBaseAPI {
   // Takes ownership of the input pix.
   void SetInputImage(Pix *pix);
   Pix* GetInputImage();
+  /**
+   * The original compressed form of the input image, such as the JPEG or
+   * CCITT G4 stream of a scanned PDF page, lets the PDF renderer embed
+   * the image exactly as it came instead of encoding it again. Takes
+   * ownership. It is only used while it matches the input image size,
+   * and it is dropped when ProcessPage returns and by Clear().
+   */
+  void SetInputImageData(L_Compressed_Data* data);
+  L_Compressed_Data* GetInputImageData() const { return input_image_data_; }
+  /**
+   * The geometry of the PDF page the input image shows, if it came from
+   * one. A text only PDF renderer then places the text layer in that
+   * page's own coordinate system, ready to be stamped onto it, or with
+   * pdf_overlay draws it over a copy of the page. The geometry is copied;
+   * NULL clears it. Like the input image data it is dropped when
+   * ProcessPage returns and by Clear().
+   */
+  void SetInputPageGeometry(const PdfPageGeometry* geometry);
+  const PdfPageGeometry* GetInputPageGeometry() const {
+    return has_input_page_geometry_ ? &input_page_geometry_ : NULL;
+  }
   int GetSourceYResolution();
   const char* GetDatapath();
 
@@ -158,6 +218,14 @@ class TESS_API TessBaseAPI {
    * (init variables should be passed to Init()).
    */
   bool SetVariable(const char* name, const char* value);
+  /**
+   * Sets each of names to the value at the same index of values, as
+   * SetVariable does. Returns false if any name lookup failed, after
+   * setting all the others. Meant for applying a whole set of per-request
+   * overrides at once.
+   */
+  bool SetVariables(const GenericVector<STRING>& names,
+                    const GenericVector<STRING>& values);
   bool SetDebugVariable(const char* name, const char* value);
 
   /**
@@ -352,6 +420,26 @@ class TESS_API TessBaseAPI {
    */
   void SetImage(Pix* pix);
 
+  /**
+   * Provide an image for Tesseract to recognize without copying it.
+   * Like SetImage(Pix*), but Tesseract keeps a clone of pix instead of a
+   * copy, unless it has to be converted, so the caller may pixDestroy pix,
+   * but must not change it until the next SetImage, Clear or End.
+   */
+  void SetBorrowedImage(Pix* pix);
+
+  /**
+   * Like the SetImage for raw data, but wraps imagedata in a Pix instead of
+   * copying it, for 8 bit greyscale (bytes_per_pixel=1) or binary
+   * (bytes_per_pixel=0, a one pixel is WHITE) only. The rows are converted
+   * in place to the word order of leptonica, so imagedata is changed, and
+   * must stay valid and unchanged until the next SetImage, Clear or End.
+   * imagedata must start on a 4 byte boundary and bytes_per_line must be a
+   * multiple of 4, or it is copied as by SetImage.
+   */
+  void SetBorrowedImage(unsigned char* imagedata, int width, int height,
+                        int bytes_per_pixel, int bytes_per_line);
+
   /**
    * Set the resolution of the source image in pixels per inch so font size
    * information can be calculated in results.  Call this after SetImage().
@@ -365,6 +453,17 @@ class TESS_API TessBaseAPI {
    */
   void SetRectangle(int left, int top, int width, int height);
 
+  /**
+   * Get the rectangle of the image that was last thresholded, which is
+   * the one the current results cover.
+   */
+  void GetRectangle(int* left, int* top, int* width, int* height) const {
+    *left = rect_left_;
+    *top = rect_top_;
+    *width = rect_width_;
+    *height = rect_height_;
+  }
+
   /**
    * In extreme cases only, usually with a subclass of Thresholder, it
    * is possible to provide a different Thresholder. The Thresholder may
@@ -504,6 +603,22 @@ class TESS_API TessBaseAPI {
    */
   int Recognize(ETEXT_DESC* monitor);
 
+  /**
+   * Recognizes num_fields rectangles of the image from SetImage, each with
+   * its own page segmentation mode and whitelist, thresholding the image
+   * only once. Fields with the same whitelist and no_language_model are
+   * recognized together, so that their words are spread over the pass 1
+   * threads and their lines batched through the LSTM. Any rectangle set by SetRectangle is reset.
+   * Fills texts[i] with the UTF-8 text of field i, lines separated by
+   * newlines, which the caller must delete [], and confidences[i] with the
+   * mean confidence of its words, 0 with no words, or -1 if the field or
+   * its mode is invalid (texts[i] is then empty).
+   * Returns false if the image could not be thresholded, or there is no
+   * engine to recognize it with.
+   */
+  bool RecognizeFields(const OcrField* fields, int num_fields, char** texts,
+                       int* confidences);
+
   /**
    * Methods to retrieve information after SetAndThresholdImage(),
    * Recognize() or TesseractRect(). (Recognize is called implicitly if needed.)
@@ -547,12 +662,48 @@ class TESS_API TessBaseAPI {
    * metadata used by side-effect processes, such as reading a box
    * file or formatting as hOCR.
    *
+   * The page is only given the analyses that the renderers need (see
+   * TessResultRenderer::RequiredAnalysis), so its results lack the others,
+   * such as the paragraphs of a page rendered as PDF only.
+   *
    * See ProcessPages for desciptions of other parameters.
    */
   bool ProcessPage(Pix* pix, int page_index, const char* filename,
                    const char* retry_config, int timeout_millisec,
                    TessResultRenderer* renderer);
 
+  /**
+   * Page result cache, enabled by the page_cache_dir variable, and index
+   * of the near-duplicate pages of the document, enabled by
+   * tessedit_reuse_duplicate_pages. BeginCachedPage looks the current
+   * input image up in them for the renderer chain, which must all support
+   * the cache (see TessResultRenderer::AddPageCacheKey). On a hit it
+   * returns true, and the page is then rendered without recognizing it:
+   * the renderers take what they produced before from
+   * GetCachedPageResult. On a miss the renderers hand what they produce to
+   * AddPageResult, and EndCachedPage stores it if ok. ProcessPage does all
+   * of this by itself; it is only for callers that recognize and render a
+   * page separately.
+   */
+  bool BeginCachedPage(TessResultRenderer* renderer);
+  void EndCachedPage(bool ok);
+  /** Returns the cached result of the given kind, or NULL if none. */
+  const char* GetCachedPageResult(const char* kind) const;
+  /** Records the result of a renderer for the page being cached. */
+  void AddPageResult(const char* kind, const char* result);
+  /**
+   * Makes this api look up and add pages in the index of near-duplicate
+   * pages of api (see tessedit_reuse_duplicate_pages), so that workers
+   * recognizing the pages of one document on different threads find the
+   * pages of one another. api must outlive this one.
+   */
+  TESS_LOCAL void ShareDuplicatePages(TessBaseAPI* api);
+  /**
+   * Likewise makes this api keep and borrow the dewarp models of the pages
+   * of a document (see tessedit_dewarp) in those of api.
+   */
+  TESS_LOCAL void ShareDewarpModels(TessBaseAPI* api);
+
   /**
    * Get a reading-order iterator to the results of LayoutAnalysis and/or
    * Recognize. The returned iterator must be deleted after use.
@@ -573,6 +724,16 @@ class TESS_API TessBaseAPI {
    */
   MutableIterator* GetMutableIterator();
 
+  /**
+   * Get the results of the page flattened into the plain records of
+   * PageResults, in reading order, recognizing the page first if needed.
+   * The records are built on the first call and kept, so the renderers of
+   * a page share them. Returns NULL on error. Owned by the API, and valid
+   * until the results change, as with GetIterator. Getting a
+   * MutableIterator drops them.
+   */
+  const PageResults* GetPageResults(ETEXT_DESC* monitor);
+
   /**
    * The recognized text is returned as a char* which is coded
    * as UTF8 and must be freed with the delete [] operator.
@@ -605,6 +766,29 @@ class TESS_API TessBaseAPI {
    */
   char* GetTSVText(int page_number);
 
+  /**
+   * Write the output of GetHOCRText or GetTSVText to writer piece by
+   * piece, for renderers that stream pages without holding them whole.
+   * Return false, having written nothing, if recognition fails.
+   */
+  bool WriteHOCRText(ETEXT_DESC* monitor, int page_number,
+                     TextWriter* writer);
+  bool WriteTSVText(int page_number, TextWriter* writer);
+
+  /**
+   * Returns the time spent in each stage of the last recognized page and
+   * its counts of blobs, words, lines and retries. It is cleared with the
+   * results, and renderers add their own time to it. See pageprofile.h.
+   */
+  PageProfile* GetPageProfile() { return profile_; }
+
+  /**
+   * Make a single line JSON object from GetPageProfile, with the 0-based
+   * page_number appearing as 1-based.
+   * Returned string must be freed with the delete [] operator.
+   */
+  char* GetProfileJSON(int page_number);
+
   /**
    * The recognized text is returned as a char* which is coded in the same
    * format as a box file used in training.
@@ -807,6 +991,9 @@ class TESS_API TessBaseAPI {
   /** Delete the pageres and block list ready for a new page. */
   void ClearResults();
 
+  /** Drops the records of GetPageResults, as the results change. */
+  TESS_LOCAL void ClearPageResults();
+
   /**
    * Return an LTR Result Iterator -- used only for training, as we really want
    * to ignore all BiDi smarts at that point.
@@ -841,6 +1028,9 @@ class TESS_API TessBaseAPI {
   TESS_LOCAL PAGE_RES* RecognitionPass2(BLOCK_LIST* block_list,
                                         PAGE_RES* pass1_result);
 
+  /** Adds the words, blobs and lines of page_res_ to the profile. */
+  TESS_LOCAL void CountPageResults();
+
   //// paragraphs.cpp ////////////////////////////////////////////////////
   TESS_LOCAL void DetectParagraphs(bool after_text_recognition);
 
@@ -866,16 +1056,28 @@ class TESS_API TessBaseAPI {
   Tesseract*        osd_tesseract_;   ///< For orientation & script detection.
   EquationDetect*   equ_detect_;      ///<The equation detector.
   FileReader reader_;                 ///< Reads files from any filesystem.
+  L_Compressed_Data* input_image_data_;  ///< Original data of input image.
+  PdfPageGeometry input_page_geometry_;  ///< Source page of input image.
+  bool has_input_page_geometry_;         ///< input_page_geometry_ is set.
+  PageResultCache* page_cache_;       ///< Opened when first used.
+  CachedPage* cached_page_;           ///< Page going through page_cache_.
+  DuplicatePageIndex* duplicate_pages_;  ///< Pages of the current document.
+  bool owns_duplicate_pages_;         ///< duplicate_pages_ isn't shared.
+  DewarpModelIndex* dewarp_models_;   ///< Models of the current document.
+  bool owns_dewarp_models_;           ///< dewarp_models_ isn't shared.
+  PageProfile* profile_;              ///< Profile of the current page.
   ImageThresholder* thresholder_;     ///< Image thresholding module.
   GenericVector<ParagraphModel *>* paragraph_models_;
   BLOCK_LIST*       block_list_;      ///< The page layout.
   PAGE_RES*         page_res_;        ///< The page-level data.
+  PageResults*      page_results_;    ///< page_res_ flattened, if asked.
   STRING*           input_file_;      ///< Name used by training code.
   STRING*           output_file_;     ///< Name used by debug code.
   STRING*           datapath_;        ///< Current location of tessdata.
   STRING*           language_;        ///< Last initialized language.
   OcrEngineMode last_oem_requested_;  ///< Last ocr language mode requested.
   bool          recognition_done_;   ///< page_res_ contains recognition data.
+  int           required_analysis_;  ///< PageAnalysis flags Recognize does.
   TruthCallback *truth_cb_;           /// fxn for setting truth_* in WERD_RES
 
   /**
@@ -906,6 +1108,14 @@ class TESS_API TessBaseAPI {
                                  int timeout_millisec,
                                  TessResultRenderer* renderer,
                                  int tessedit_page_number);
+  // PDF input is read through poppler when available, one Pix per page.
+  bool ProcessPagesPdf(const unsigned char *data,
+                       size_t size,
+                       const char* filename,
+                       const char* retry_config,
+                       int timeout_millisec,
+                       TessResultRenderer* renderer,
+                       int tessedit_page_number);
   // There's currently no way to pass a document title from the
   // Tesseract command line, and we have multiple places that choose
   // to set the title to an empty string. Using a single named
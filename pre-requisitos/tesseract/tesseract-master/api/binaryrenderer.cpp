@@ -0,0 +1,172 @@
+///////////////////////////////////////////////////////////////////////
+// File:        binaryrenderer.cpp
+// Description: Binary result rendering interface to inject into
+//              TessBaseAPI.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <string>
+#include "baseapi.h"
+#include "binaryresult.h"
+#include "pageresults.h"
+#include "renderer.h"
+
+namespace tesseract {
+
+static_assert(sizeof(TessBinaryHeader) == 16, "TessBinaryHeader layout");
+static_assert(sizeof(TessBinaryPage) == 40, "TessBinaryPage layout");
+static_assert(sizeof(TessBinaryBlock) == 24, "TessBinaryBlock layout");
+static_assert(sizeof(TessBinaryLine) == 24, "TessBinaryLine layout");
+static_assert(sizeof(TessBinaryWord) == 32, "TessBinaryWord layout");
+static_assert(sizeof(TessBinaryFooter) == 16, "TessBinaryFooter layout");
+
+// Every record of the file starts at a multiple of this.
+const int kBinaryAlignment = 8;
+
+// Appenders of little-endian fields, whatever the byte order of the host.
+static void AppendU32(uint32_t value, std::string* out) {
+  char bytes[4];
+  for (int i = 0; i < 4; ++i) bytes[i] = static_cast<char>(value >> (8 * i));
+  out->append(bytes, 4);
+}
+
+static void AppendU64(uint64_t value, std::string* out) {
+  AppendU32(static_cast<uint32_t>(value), out);
+  AppendU32(static_cast<uint32_t>(value >> 32), out);
+}
+
+static void AppendFloat(float value, std::string* out) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  AppendU32(bits, out);
+}
+
+// Appends box as a TessBinaryBox.
+static void AppendBox(const PageResultBox& box, std::string* out) {
+  AppendU32(box.left, out);
+  AppendU32(box.top, out);
+  AppendU32(box.right, out);
+  AppendU32(box.bottom, out);
+}
+
+// The lines and words of a block or line are counted as they are found,
+// so each is appended with a placeholder count, patched once it ends.
+static void PatchU32(size_t offset, uint32_t value, std::string* out) {
+  std::string bytes;
+  AppendU32(value, &bytes);
+  out->replace(offset, 4, bytes);
+}
+
+TessBinaryRenderer::TessBinaryRenderer(const char* outputbase)
+    : TessResultRenderer(outputbase, "tbr"), offset_(0) {
+}
+
+// Only blocks, lines and words are written.
+int TessBinaryRenderer::RequiredAnalysis() const {
+  return 0;
+}
+
+bool TessBinaryRenderer::BeginDocumentHandler() {
+  std::string header(TESS_BINARY_MAGIC, 4);
+  AppendU32(TESS_BINARY_VERSION, &header);
+  AppendU32(sizeof(TessBinaryHeader), &header);
+  AppendU32(0, &header);
+  page_offsets_.clear();
+  offset_ = 0;
+  AppendData(header.data(), header.size());
+  offset_ += header.size();
+  return true;
+}
+
+bool TessBinaryRenderer::AddImageHandler(TessBaseAPI* api) {
+  const PageResults* results = api->GetPageResults(NULL);
+  if (results == NULL) return false;
+  std::string blocks, lines, words, text;
+  int num_blocks = 0, num_lines = 0, num_words = 0;
+  size_t block_count_pos = 0, line_count_pos = 0;
+  int block_lines = 0, line_words = 0;
+  for (int w = 0; w < static_cast<int>(results->words.size()); ++w) {
+    const PageResultWord& word = results->words[w];
+    if (results->FirstWordInBlock(w)) {
+      AppendBox(results->blocks[word.block].box, &blocks);
+      AppendU32(num_lines, &blocks);
+      block_count_pos = blocks.size();
+      AppendU32(0, &blocks);
+      block_lines = 0;
+      ++num_blocks;
+    }
+    if (results->FirstWordInLine(w)) {
+      AppendBox(results->lines[word.line].box, &lines);
+      AppendU32(num_words, &lines);
+      line_count_pos = lines.size();
+      AppendU32(0, &lines);
+      line_words = 0;
+      ++num_lines;
+      PatchU32(block_count_pos, ++block_lines, &blocks);
+    }
+    AppendBox(word.box, &words);
+    AppendFloat(word.confidence, &words);
+    AppendU32(text.size(), &words);
+    AppendU32(word.text_length, &words);
+    AppendU32(0, &words);
+    text.append(results->WordText(word), word.text_length);
+    text.push_back('\0');
+    ++num_words;
+    PatchU32(line_count_pos, ++line_words, &lines);
+  }
+
+  size_t record_size = sizeof(TessBinaryPage) + blocks.size() + lines.size() +
+                       words.size() + text.size();
+  size_t padding = (kBinaryAlignment - record_size % kBinaryAlignment) %
+                   kBinaryAlignment;
+  record_size += padding;
+  std::string page;
+  int left, top, width, height;
+  api->GetRectangle(&left, &top, &width, &height);
+  AppendU32(record_size, &page);
+  AppendU32(imagenum(), &page);
+  AppendU32(left, &page);
+  AppendU32(top, &page);
+  AppendU32(left + width, &page);
+  AppendU32(top + height, &page);
+  AppendU32(num_blocks, &page);
+  AppendU32(num_lines, &page);
+  AppendU32(num_words, &page);
+  AppendU32(text.size(), &page);
+  text.append(padding, '\0');
+
+  page_offsets_.push_back(offset_);
+  AppendData(page.data(), page.size());
+  AppendData(blocks.data(), blocks.size());
+  AppendData(lines.data(), lines.size());
+  AppendData(words.data(), words.size());
+  AppendData(text.data(), text.size());
+  offset_ += record_size;
+  return true;
+}
+
+bool TessBinaryRenderer::EndDocumentHandler() {
+  std::string index;
+  for (int i = 0; i < page_offsets_.size(); ++i)
+    AppendU64(page_offsets_[i], &index);
+  AppendU64(offset_, &index);
+  AppendU32(page_offsets_.size(), &index);
+  index.append(TESS_BINARY_FOOTER_MAGIC, 4);
+  AppendData(index.data(), index.size());
+  offset_ += index.size();
+  return true;
+}
+
+}  // namespace tesseract.
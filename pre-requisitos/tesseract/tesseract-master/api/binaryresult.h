@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////
+// File:        binaryresult.h
+// Description: Layout of the binary result files of TessBinaryRenderer.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_BINARYRESULT_H_
+#define TESSERACT_API_BINARYRESULT_H_
+
+/*
+ * A .tbr file holds the word boxes, confidences and text of a document in
+ * a form that can be mapped into memory and read in place, from C or C++,
+ * without any parsing. All integers are little-endian, and every structure
+ * starts at a multiple of 8 bytes from the start of the file.
+ *
+ *   TessBinaryHeader
+ *   page record, for each page in the order rendered:
+ *     TessBinaryPage
+ *     TessBinaryBlock[num_blocks]
+ *     TessBinaryLine[num_lines]
+ *     TessBinaryWord[num_words]
+ *     char text[text_size]    UTF-8 of the words, each ending in '\0'
+ *     zero padding up to record_size
+ *   uint64_t page_offsets[num_pages]    file offset of each page record
+ *   TessBinaryFooter                    the last 16 bytes of the file
+ *
+ * Blocks, lines and words are in reading order, and each block or line
+ * refers to a range of the lines or words of its page. Boxes are in the
+ * pixel coordinates of the image, with the origin at the top left, and
+ * right and bottom exclusive. Readers should check the magic numbers and
+ * the version, which changes with any change to the layout.
+ */
+
+#include <stdint.h>
+
+#define TESS_BINARY_MAGIC "TBRF"
+#define TESS_BINARY_FOOTER_MAGIC "TBRE"
+#define TESS_BINARY_VERSION 1
+
+typedef struct TessBinaryHeader {
+  char magic[4];          /* TESS_BINARY_MAGIC */
+  uint32_t version;       /* TESS_BINARY_VERSION */
+  uint32_t header_size;   /* sizeof(TessBinaryHeader) */
+  uint32_t reserved;
+} TessBinaryHeader;
+
+typedef struct TessBinaryBox {
+  int32_t left, top, right, bottom;
+} TessBinaryBox;
+
+typedef struct TessBinaryPage {
+  uint32_t record_size;   /* Bytes of the record, padding included. */
+  int32_t page_number;    /* 0-based. */
+  TessBinaryBox box;      /* Recognized rectangle of the image. */
+  uint32_t num_blocks, num_lines, num_words;
+  uint32_t text_size;     /* Bytes of the text. */
+} TessBinaryPage;
+
+typedef struct TessBinaryBlock {
+  TessBinaryBox box;
+  uint32_t first_line, num_lines;
+} TessBinaryBlock;
+
+typedef struct TessBinaryLine {
+  TessBinaryBox box;
+  uint32_t first_word, num_words;
+} TessBinaryLine;
+
+typedef struct TessBinaryWord {
+  TessBinaryBox box;
+  float confidence;       /* 0 to 100, as ResultIterator::Confidence. */
+  uint32_t text_offset;   /* From the start of the text of the page. */
+  uint32_t text_length;   /* Bytes, without the '\0'. */
+  uint32_t reserved;
+} TessBinaryWord;
+
+typedef struct TessBinaryFooter {
+  uint64_t page_offsets;  /* File offset of the page_offsets array. */
+  uint32_t num_pages;
+  char magic[4];          /* TESS_BINARY_FOOTER_MAGIC */
+} TessBinaryFooter;
+
+#endif  /* TESSERACT_API_BINARYRESULT_H_ */
@@ -19,6 +19,7 @@
 #   define TESS_CAPI_INCLUDE_BASEAPI
 #endif
 #include "capi.h"
+#include "asyncrecognizer.h"
 #include "genericvector.h"
 #include "strngs.h"
 
@@ -812,3 +813,66 @@ TESS_API float TESS_CALL TessChoiceIteratorConfidence(const TessChoiceIterator*
 {
     return handle->Confidence();
 }
+
+TESS_API TessAsyncRecognizer* TESS_CALL TessAsyncRecognizerCreate(TessBaseAPI* handle, int num_threads)
+{
+    TessAsyncRecognizer* recognizer = new TessAsyncRecognizer;
+    if (!recognizer->Start(handle, num_threads))
+    {
+        delete recognizer;
+        return NULL;
+    }
+    return recognizer;
+}
+
+TESS_API void TESS_CALL TessAsyncRecognizerDelete(TessAsyncRecognizer* recognizer)
+{
+    delete recognizer;
+}
+
+TESS_API TessAsyncJob* TESS_CALL TessAsyncRecognizerSubmit(TessAsyncRecognizer* recognizer, struct Pix* pix,
+                                                           int timeout_millisec, TessAsyncCallback callback,
+                                                           void* user_data)
+{
+    return recognizer->Submit(pix, timeout_millisec, callback, user_data);
+}
+
+TESS_API void TESS_CALL TessAsyncJobDelete(TessAsyncJob* job)
+{
+    delete job;
+}
+
+TESS_API TessAsyncJobState TESS_CALL TessAsyncJobGetState(const TessAsyncJob* job)
+{
+    return job->state();
+}
+
+TESS_API BOOL TESS_CALL TessAsyncJobIsFinished(const TessAsyncJob* job)
+{
+    return job->finished() ? TRUE : FALSE;
+}
+
+TESS_API void TESS_CALL TessAsyncJobWait(TessAsyncJob* job)
+{
+    job->Wait();
+}
+
+TESS_API void TESS_CALL TessAsyncJobCancel(TessAsyncJob* job)
+{
+    job->Cancel();
+}
+
+TESS_API int TESS_CALL TessAsyncJobGetProgress(const TessAsyncJob* job)
+{
+    return job->progress();
+}
+
+TESS_API const char* TESS_CALL TessAsyncJobGetUTF8Text(const TessAsyncJob* job)
+{
+    return job->text();
+}
+
+TESS_API int TESS_CALL TessAsyncJobMeanTextConf(const TessAsyncJob* job)
+{
+    return job->confidence();
+}
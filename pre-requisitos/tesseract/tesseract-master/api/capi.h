@@ -23,6 +23,10 @@
 #   include "pageiterator.h"
 #   include "resultiterator.h"
 #   include "renderer.h"
+namespace tesseract {
+class AsyncRecognizer;
+class AsyncJob;
+}
 #else
 #   include "platform.h"
 #   include <stdio.h>
@@ -73,6 +77,9 @@ typedef tesseract::ParagraphJustification TessParagraphJustification;
 typedef tesseract::WritingDirection TessWritingDirection;
 typedef tesseract::TextlineOrder TessTextlineOrder;
 typedef PolyBlockType TessPolyBlockType;
+typedef tesseract::AsyncRecognizer TessAsyncRecognizer;
+typedef tesseract::AsyncJob TessAsyncJob;
+typedef tesseract::AsyncJobState TessAsyncJobState;
 #else
 typedef struct TessResultRenderer TessResultRenderer;
 typedef struct TessTextRenderer TessTextRenderer;
@@ -98,8 +105,15 @@ typedef enum TessParagraphJustification { JUSTIFICATION_UNKNOWN, JUSTIFICATION_L
 typedef enum TessWritingDirection  { WRITING_DIRECTION_LEFT_TO_RIGHT, WRITING_DIRECTION_RIGHT_TO_LEFT, WRITING_DIRECTION_TOP_TO_BOTTOM } TessWritingDirection;
 typedef enum TessTextlineOrder     { TEXTLINE_ORDER_LEFT_TO_RIGHT, TEXTLINE_ORDER_RIGHT_TO_LEFT, TEXTLINE_ORDER_TOP_TO_BOTTOM } TessTextlineOrder;
 typedef struct ETEXT_DESC ETEXT_DESC;
+typedef struct TessAsyncRecognizer TessAsyncRecognizer;
+typedef struct TessAsyncJob TessAsyncJob;
+typedef enum TessAsyncJobState     { ASYNC_JOB_PENDING, ASYNC_JOB_RUNNING, ASYNC_JOB_DONE, ASYNC_JOB_TIMED_OUT, ASYNC_JOB_CANCELLED,
+                                     ASYNC_JOB_FAILED } TessAsyncJobState;
 #endif
 
+/* Called on a worker thread when an asynchronous job finishes. */
+typedef void (*TessAsyncCallback)(TessAsyncJob* job, void* user_data);
+
 struct Pix;
 struct Boxa;
 struct Pixa;
@@ -390,6 +404,26 @@ TESS_API BOOL  TESS_CALL TessChoiceIteratorNext(TessChoiceIterator* handle);
 TESS_API const char* TESS_CALL TessChoiceIteratorGetUTF8Text(const TessChoiceIterator* handle);
 TESS_API float TESS_CALL TessChoiceIteratorConfidence(const TessChoiceIterator* handle);
 
+/* Asynchronous recognition */
+
+TESS_API TessAsyncRecognizer*
+               TESS_CALL TessAsyncRecognizerCreate(TessBaseAPI* handle, int num_threads);
+TESS_API void  TESS_CALL TessAsyncRecognizerDelete(TessAsyncRecognizer* recognizer);
+TESS_API TessAsyncJob*
+               TESS_CALL TessAsyncRecognizerSubmit(TessAsyncRecognizer* recognizer, struct Pix* pix, int timeout_millisec,
+                                                   TessAsyncCallback callback, void* user_data);
+
+TESS_API void  TESS_CALL TessAsyncJobDelete(TessAsyncJob* job);
+TESS_API TessAsyncJobState
+               TESS_CALL TessAsyncJobGetState(const TessAsyncJob* job);
+TESS_API BOOL  TESS_CALL TessAsyncJobIsFinished(const TessAsyncJob* job);
+TESS_API void  TESS_CALL TessAsyncJobWait(TessAsyncJob* job);
+TESS_API void  TESS_CALL TessAsyncJobCancel(TessAsyncJob* job);
+TESS_API int   TESS_CALL TessAsyncJobGetProgress(const TessAsyncJob* job);
+TESS_API const char*
+               TESS_CALL TessAsyncJobGetUTF8Text(const TessAsyncJob* job);
+TESS_API int   TESS_CALL TessAsyncJobMeanTextConf(const TessAsyncJob* job);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,592 @@
+/**********************************************************************
+ * File:        ocrbench.cpp
+ * Description: Throughput and accuracy benchmark of TessBaseAPI over a
+ *              corpus of page images, with comparison to a baseline.
+ *
+ * (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ ** http://www.apache.org/licenses/LICENSE-2.0
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ *
+ **********************************************************************/
+//
+// Usage: ocrbench [options] CORPUS_DIR...
+//
+// Every image file of the corpus dirs is a page. Its ground truth, if any,
+// is <name>.gt.txt or else <name>.txt next to it, as testing/phototest.tif
+// has testing/phototest.txt. The pages are recognized by --threads engines,
+// each with its own TessBaseAPI on its own thread taking the next page, as
+// the OCR server's tesseractd does, --repeat times over.
+//
+// The report is a list of "metric value" lines:
+//
+//   - pages, pages_per_second over the wall time of all the runs;
+//   - latency_mean, latency_p50, _p90, _p99 and _max of a page, in seconds
+//     from reading the image to getting its text;
+//   - peak_rss_mb of the whole process;
+//   - stage_<name>, the mean seconds a page spent in each PageProfile
+//     stage, and count_<name>, the mean of each PageProfile counter;
+//   - cer and wer, the character and word error rates against the ground
+//     truth: the edit distance of the texts, with runs of whitespace made
+//     one space, over the length of the truth, summed over all the pages
+//     that have one.
+//
+// --save writes the report to a file. --baseline reads a saved report and
+// prints each metric next to it; metrics that got worse by more than
+// --tolerance percent are marked, and make ocrbench exit with status 2, so
+// that a script can gate an engine setting change on it.
+
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allheaders.h"
+#include "baseapi.h"
+#include "genericvector.h"
+#include "pageprofile.h"
+#include "strngs.h"
+#include "unichar.h"
+
+using tesseract::char32;
+using tesseract::UNICHAR;
+
+namespace {
+
+const int kDefaultThreads = 1;
+const int kDefaultRepeat = 1;
+const double kDefaultTolerance = 5.0;
+const char* const kImageExtensions[] = {
+  ".tif", ".tiff", ".png", ".jpg", ".jpeg", ".pbm", ".pgm", ".ppm", ".pnm",
+  ".bmp", ".gif", ".webp", ".jp2", NULL
+};
+
+struct BenchConfig {
+  const char* datapath;
+  const char* language;
+  tesseract::OcrEngineMode oem;
+  int psm;  // -1 keeps the default of the language's configs.
+  int threads;
+  int repeat;
+  double tolerance;
+  bool per_page;
+  const char* save_file;
+  const char* baseline_file;
+  GenericVector<STRING> vars;
+  GenericVector<STRING> values;
+  GenericVector<STRING> corpus_dirs;
+};
+
+BenchConfig config;
+
+// A page of the corpus.
+struct Page {
+  STRING image;
+  STRING truth;  // The ground truth text, if has_truth.
+  bool has_truth;
+};
+
+// The outcome of one recognition of a page.
+struct PageRun {
+  bool ok;
+  double seconds;
+  double stages[tesseract::PROFILE_STAGE_COUNT];
+  int counts[tesseract::PROFILE_COUNTER_COUNT];
+  // Edit distances to the truth and its lengths, in chars and words.
+  int char_errors, chars;
+  int word_errors, words;
+};
+
+// A metric of the report and whether lower values are better.
+struct Metric {
+  STRING name;
+  double value;
+  bool lower_is_better;
+};
+
+void PrintUsage(const char* program) {
+  fprintf(stderr,
+          "Usage:\n"
+          "  %s [options] CORPUS_DIR...\n\n"
+          "Options:\n"
+          "  --tessdata-dir PATH\n"
+          "                  Location of the tessdata folder.\n"
+          "  -l LANG[+LANG]  Languages (default eng).\n"
+          "  --oem NUM       OCR engine mode (default %d).\n"
+          "  --psm NUM       Page segmentation mode (default: the "
+          "engine's).\n"
+          "  -c VAR=VALUE    Set a config variable; may be repeated.\n"
+          "  --threads NUM   Pages recognized at the same time, each by "
+          "its own\n"
+          "                  engine (default %d).\n"
+          "  --repeat NUM    Times the corpus is recognized (default %d).\n"
+          "  --per-page      Print the time and error rates of every page.\n"
+          "  --save FILE     Write the report to FILE.\n"
+          "  --baseline FILE Compare the report with one saved by --save.\n"
+          "  --tolerance PCT Change of a metric for the worse that is a "
+          "regression\n"
+          "                  (default %g).\n\n"
+          "Exits with 1 on errors and 2 on regressions from the baseline.\n",
+          program, tesseract::OEM_DEFAULT, kDefaultThreads, kDefaultRepeat,
+          kDefaultTolerance);
+}
+
+void ParseArgs(int argc, char** argv) {
+  config.datapath = NULL;
+  config.language = "eng";
+  config.oem = tesseract::OEM_DEFAULT;
+  config.psm = -1;
+  config.threads = kDefaultThreads;
+  config.repeat = kDefaultRepeat;
+  config.tolerance = kDefaultTolerance;
+  config.per_page = false;
+  config.save_file = NULL;
+  config.baseline_file = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--tessdata-dir") == 0 && i + 1 < argc) {
+      config.datapath = argv[++i];
+    } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+      config.language = argv[++i];
+    } else if (strcmp(argv[i], "--oem") == 0 && i + 1 < argc) {
+      config.oem = static_cast<tesseract::OcrEngineMode>(atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--psm") == 0 && i + 1 < argc) {
+      config.psm = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+      const char* arg = argv[++i];
+      const char* eq = strchr(arg, '=');
+      if (eq == NULL || eq == arg) {
+        PrintUsage(argv[0]);
+        exit(1);
+      }
+      STRING var;
+      var.assign(arg, eq - arg);
+      config.vars.push_back(var);
+      config.values.push_back(eq + 1);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      config.threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      config.repeat = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--per-page") == 0) {
+      config.per_page = true;
+    } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+      config.save_file = argv[++i];
+    } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      config.baseline_file = argv[++i];
+    } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      config.tolerance = atof(argv[++i]);
+    } else if (argv[i][0] != '-') {
+      config.corpus_dirs.push_back(argv[i]);
+    } else {
+      PrintUsage(argv[0]);
+      exit(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? 0
+                                                                         : 1);
+    }
+  }
+  if (config.corpus_dirs.empty() || config.oem < 0 ||
+      config.oem >= tesseract::OEM_COUNT) {
+    PrintUsage(argv[0]);
+    exit(1);
+  }
+  if (config.threads <= 0) config.threads = kDefaultThreads;
+  if (config.repeat <= 0) config.repeat = kDefaultRepeat;
+  if (config.tolerance < 0.0) config.tolerance = 0.0;
+}
+
+bool IsImageFile(const char* name) {
+  const char* ext = strrchr(name, '.');
+  if (ext == NULL) return false;
+  for (int i = 0; kImageExtensions[i] != NULL; ++i) {
+    if (strcasecmp(ext, kImageExtensions[i]) == 0) return true;
+  }
+  return false;
+}
+
+// Reads the whole of filename to text, returning false if it can't.
+bool ReadTextFile(const STRING& filename, STRING* text) {
+  GenericVector<char> data;
+  if (!tesseract::LoadDataFromFile(filename.string(), &data)) return false;
+  text->assign(data.empty() ? "" : &data[0], data.size());
+  return true;
+}
+
+// Adds the pages of dir to pages, in the order of their names.
+bool ListCorpus(const STRING& dir, GenericVector<Page>* pages) {
+  DIR* d = opendir(dir.string());
+  if (d == NULL) {
+    perror(dir.string());
+    return false;
+  }
+  std::vector<std::string> names;
+  struct dirent* entry;
+  while ((entry = readdir(d)) != NULL) {
+    if (IsImageFile(entry->d_name)) names.push_back(entry->d_name);
+  }
+  closedir(d);
+  std::sort(names.begin(), names.end());
+  for (const std::string& name : names) {
+    Page page;
+    page.image = dir;
+    page.image += "/";
+    page.image += name.c_str();
+    STRING base = dir;
+    base += "/";
+    base += name.substr(0, name.rfind('.')).c_str();
+    page.has_truth = ReadTextFile(base + ".gt.txt", &page.truth) ||
+                     ReadTextFile(base + ".txt", &page.truth);
+    pages->push_back(page);
+  }
+  return true;
+}
+
+bool IsSpace(char32 ch) {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' ||
+         ch == '\f' || ch == '\v' || ch == 0xa0;
+}
+
+// Splits utf8 text to its unicodes, with runs of whitespace made one space
+// and none at either end, and to its words.
+void Tokenize(const char* text, std::vector<char32>* chars,
+              std::vector<std::vector<char32> >* words) {
+  std::vector<char32> unicodes = UNICHAR::UTF8ToUTF32(text);
+  chars->clear();
+  words->clear();
+  bool in_word = false;
+  for (char32 ch : unicodes) {
+    if (IsSpace(ch)) {
+      in_word = false;
+      continue;
+    }
+    if (!in_word) {
+      if (!chars->empty()) chars->push_back(' ');
+      words->push_back(std::vector<char32>());
+      in_word = true;
+    }
+    chars->push_back(ch);
+    words->back().push_back(ch);
+  }
+}
+
+// Returns the Levenshtein distance of a and b, with two rows of the table.
+template <typename T>
+int EditDistance(const std::vector<T>& a, const std::vector<T>& b) {
+  std::vector<int> prev(b.size() + 1), row(b.size() + 1);
+  for (size_t j = 0; j <= b.size(); ++j) prev[j] = j;
+  for (size_t i = 1; i <= a.size(); ++i) {
+    row[0] = i;
+    for (size_t j = 1; j <= b.size(); ++j) {
+      int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+      row[j] = std::min(std::min(prev[j] + 1, row[j - 1] + 1),
+                        prev[j - 1] + cost);
+    }
+    prev.swap(row);
+  }
+  return prev[b.size()];
+}
+
+void ScoreText(const char* text, const STRING& truth, PageRun* run) {
+  std::vector<char32> chars, truth_chars;
+  std::vector<std::vector<char32> > words, truth_words;
+  Tokenize(text, &chars, &words);
+  Tokenize(truth.string(), &truth_chars, &truth_words);
+  run->char_errors = EditDistance(chars, truth_chars);
+  run->chars = truth_chars.size();
+  run->word_errors = EditDistance(words, truth_words);
+  run->words = truth_words.size();
+}
+
+int InitApi(tesseract::TessBaseAPI* api) {
+  if (api->Init(config.datapath, config.language, config.oem, NULL, 0,
+                &config.vars, &config.values, false) != 0) {
+    return -1;
+  }
+  if (config.psm >= 0)
+    api->SetPageSegMode(static_cast<tesseract::PageSegMode>(config.psm));
+  return 0;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+double SecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Recognizes pages taken from next until all num_runs are done, writing the
+// outcome of run r to runs[r] for page r % pages.size().
+void RunWorker(tesseract::TessBaseAPI* api, const GenericVector<Page>& pages,
+               std::atomic<int>* next, int num_runs, PageRun* runs) {
+  int r;
+  while ((r = (*next)++) < num_runs) {
+    const Page& page = pages[r % pages.size()];
+    PageRun* run = &runs[r];
+    memset(run, 0, sizeof(*run));
+    Clock::time_point start = Clock::now();
+    Pix* pix = pixRead(page.image.string());
+    char* text = NULL;
+    if (pix != NULL) {
+      api->SetInputName(page.image.string());
+      api->SetImage(pix);
+      text = api->GetUTF8Text();
+    }
+    run->seconds = SecondsSince(start);
+    run->ok = text != NULL;
+    if (run->ok) {
+      const tesseract::PageProfile* profile = api->GetPageProfile();
+      for (int s = 0; s < tesseract::PROFILE_STAGE_COUNT; ++s)
+        run->stages[s] = profile->time(static_cast<tesseract::ProfileStage>(s));
+      for (int c = 0; c < tesseract::PROFILE_COUNTER_COUNT; ++c)
+        run->counts[c] =
+            profile->count(static_cast<tesseract::ProfileCounter>(c));
+      if (page.has_truth) ScoreText(text, page.truth, run);
+    } else {
+      fprintf(stderr, "ocrbench: cannot recognize %s\n", page.image.string());
+    }
+    delete[] text;
+    api->Clear();
+    pixDestroy(&pix);
+  }
+}
+
+// Returns the p-th percentile of the sorted values, by the nearest rank.
+double Percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  int rank = static_cast<int>(p / 100.0 * sorted.size() + 0.999999);
+  return sorted[std::min(std::max(rank, 1), static_cast<int>(sorted.size())) -
+                1];
+}
+
+double PeakRssMB() {
+#ifndef _WIN32
+  struct rusage usage;
+  // ru_maxrss is in kilobytes on Linux.
+  if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss / 1024.0;
+#endif
+  return 0.0;
+}
+
+void AddMetric(const char* name, double value, bool lower_is_better,
+               GenericVector<Metric>* metrics) {
+  Metric metric;
+  metric.name = name;
+  metric.value = value;
+  metric.lower_is_better = lower_is_better;
+  metrics->push_back(metric);
+}
+
+void MakeReport(const GenericVector<Page>& pages,
+                const std::vector<PageRun>& runs, double wall_seconds,
+                GenericVector<Metric>* metrics) {
+  std::vector<double> latencies;
+  double stages[tesseract::PROFILE_STAGE_COUNT] = {0.0};
+  double counts[tesseract::PROFILE_COUNTER_COUNT] = {0.0};
+  inT64 char_errors = 0, chars = 0, word_errors = 0, words = 0;
+  double total_seconds = 0.0;
+  int num_runs = runs.size();
+  for (int r = 0; r < num_runs; ++r) {
+    const PageRun& run = runs[r];
+    if (!run.ok) continue;
+    latencies.push_back(run.seconds);
+    total_seconds += run.seconds;
+    for (int s = 0; s < tesseract::PROFILE_STAGE_COUNT; ++s)
+      stages[s] += run.stages[s];
+    for (int c = 0; c < tesseract::PROFILE_COUNTER_COUNT; ++c)
+      counts[c] += run.counts[c];
+    // The error rates are taken from the last run of each page, which are
+    // the same in every run unless the engine is not deterministic.
+    if (r + pages.size() >= num_runs) {
+      char_errors += run.char_errors;
+      chars += run.chars;
+      word_errors += run.word_errors;
+      words += run.words;
+    }
+  }
+  std::sort(latencies.begin(), latencies.end());
+  int done = latencies.size();
+  AddMetric("pages", done, false, metrics);
+  AddMetric("pages_per_second", wall_seconds > 0.0 ? done / wall_seconds : 0.0,
+            false, metrics);
+  AddMetric("latency_mean", done > 0 ? total_seconds / done : 0.0, true,
+            metrics);
+  AddMetric("latency_p50", Percentile(latencies, 50), true, metrics);
+  AddMetric("latency_p90", Percentile(latencies, 90), true, metrics);
+  AddMetric("latency_p99", Percentile(latencies, 99), true, metrics);
+  AddMetric("latency_max", latencies.empty() ? 0.0 : latencies.back(), true,
+            metrics);
+  AddMetric("peak_rss_mb", PeakRssMB(), true, metrics);
+  for (int s = 0; s < tesseract::PROFILE_STAGE_COUNT; ++s) {
+    STRING name = "stage_";
+    name += tesseract::PageProfile::StageName(
+        static_cast<tesseract::ProfileStage>(s));
+    AddMetric(name.string(), done > 0 ? stages[s] / done : 0.0, true,
+              metrics);
+  }
+  // The counts tell how much work the stages had, not how well they did.
+  for (int c = 0; c < tesseract::PROFILE_COUNTER_COUNT; ++c) {
+    STRING name = "count_";
+    name += tesseract::PageProfile::CounterName(
+        static_cast<tesseract::ProfileCounter>(c));
+    AddMetric(name.string(), done > 0 ? counts[c] / done : 0.0, false,
+              metrics);
+  }
+  if (chars > 0) {
+    AddMetric("cer", static_cast<double>(char_errors) / chars, true, metrics);
+    AddMetric("wer", words > 0 ? static_cast<double>(word_errors) / words
+                               : 0.0, true, metrics);
+  }
+}
+
+bool IsCount(const Metric& metric) {
+  return strncmp(metric.name.string(), "count_", 6) == 0 ||
+         strcmp(metric.name.string(), "pages") == 0;
+}
+
+void WriteReport(const GenericVector<Metric>& metrics, FILE* fp) {
+  for (int m = 0; m < metrics.size(); ++m)
+    fprintf(fp, "%s %.6g\n", metrics[m].name.string(), metrics[m].value);
+}
+
+// Prints metrics next to those of the baseline file, and sets regressed if
+// any got worse by more than the tolerance. Returns false if the file can't
+// be read.
+bool CompareWithBaseline(const GenericVector<Metric>& metrics,
+                         const char* filename, bool* regressed) {
+  *regressed = false;
+  FILE* fp = fopen(filename, "r");
+  if (fp == NULL) {
+    perror(filename);
+    return false;
+  }
+  GenericVector<STRING> names;
+  GenericVector<double> values;
+  char name[256];
+  double value;
+  while (fscanf(fp, "%255s %lf", name, &value) == 2) {
+    names.push_back(name);
+    values.push_back(value);
+  }
+  fclose(fp);
+  printf("\n%-24s %14s %14s %9s\n", "metric", "baseline", "current",
+         "change");
+  for (int m = 0; m < metrics.size(); ++m) {
+    const Metric& metric = metrics[m];
+    int b = names.get_index(metric.name);
+    if (b < 0) {
+      printf("%-24s %14s %14.6g\n", metric.name.string(), "-", metric.value);
+      continue;
+    }
+    double base = values[b];
+    double change = base != 0.0 ? 100.0 * (metric.value - base) / base
+                                : (metric.value != 0.0 ? 100.0 : 0.0);
+    bool worse = metric.lower_is_better ? change > config.tolerance
+                                        : change < -config.tolerance;
+    // Error rates near zero swing by large percentages on a single char,
+    // so they only regress by more than 0.1% absolute as well.
+    if (worse && (strcmp(metric.name.string(), "cer") == 0 ||
+                  strcmp(metric.name.string(), "wer") == 0)) {
+      worse = metric.value - base > 0.001;
+    }
+    if (IsCount(metric)) worse = false;
+    printf("%-24s %14.6g %14.6g %+8.1f%%%s\n", metric.name.string(), base,
+           metric.value, change, worse ? "  REGRESSION" : "");
+    if (worse) *regressed = true;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ParseArgs(argc, argv);
+  GenericVector<Page> pages;
+  for (int d = 0; d < config.corpus_dirs.size(); ++d) {
+    if (!ListCorpus(config.corpus_dirs[d], &pages)) return EXIT_FAILURE;
+  }
+  if (pages.empty()) {
+    fprintf(stderr, "ocrbench: no images in the corpus\n");
+    return EXIT_FAILURE;
+  }
+
+  // The engines are loaded before the clock starts, as a server loads them
+  // once for many pages.
+  std::vector<std::unique_ptr<tesseract::TessBaseAPI> > apis;
+  for (int t = 0; t < config.threads; ++t) {
+    apis.emplace_back(new tesseract::TessBaseAPI);
+    if (InitApi(apis.back().get()) != 0) {
+      fprintf(stderr, "ocrbench: could not initialize tesseract\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  int num_runs = pages.size() * config.repeat;
+  std::vector<PageRun> runs(num_runs);
+  std::atomic<int> next(0);
+  Clock::time_point start = Clock::now();
+  if (config.threads == 1) {
+    RunWorker(apis[0].get(), pages, &next, num_runs, &runs[0]);
+  } else {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < config.threads; ++t) {
+      threads.emplace_back(RunWorker, apis[t].get(), std::cref(pages), &next,
+                           num_runs, &runs[0]);
+    }
+    for (std::thread& thread : threads) thread.join();
+  }
+  double wall_seconds = SecondsSince(start);
+
+  bool failed = false;
+  for (int r = 0; r < num_runs; ++r) {
+    if (!runs[r].ok) failed = true;
+    if (!config.per_page) continue;
+    const PageRun& run = runs[r];
+    printf("%s %.3fs", pages[r % pages.size()].image.string(), run.seconds);
+    if (run.chars > 0) {
+      printf(" cer %.4f wer %.4f",
+             static_cast<double>(run.char_errors) / run.chars,
+             run.words > 0 ? static_cast<double>(run.word_errors) / run.words
+                           : 0.0);
+    }
+    printf("\n");
+  }
+
+  GenericVector<Metric> metrics;
+  MakeReport(pages, runs, wall_seconds, &metrics);
+  printf("# %s oem %d psm %d threads %d repeat %d\n", config.language,
+         config.oem, config.psm, config.threads, config.repeat);
+  WriteReport(metrics, stdout);
+  if (config.save_file != NULL) {
+    FILE* fp = fopen(config.save_file, "w");
+    if (fp == NULL) {
+      perror(config.save_file);
+      return EXIT_FAILURE;
+    }
+    WriteReport(metrics, fp);
+    fclose(fp);
+  }
+  bool regressed = false;
+  if (config.baseline_file != NULL &&
+      !CompareWithBaseline(metrics, config.baseline_file, &regressed)) {
+    return EXIT_FAILURE;
+  }
+  if (failed) return EXIT_FAILURE;
+  return regressed ? 2 : EXIT_SUCCESS;
+}
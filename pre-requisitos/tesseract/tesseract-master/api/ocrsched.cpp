@@ -0,0 +1,737 @@
+/**********************************************************************
+ * File:        ocrsched.cpp
+ * Description: Input folder scheduler for the OCR server.
+ *              Watches the input trees with inotify, claims new PDF
+ *              files and runs the OCR driver on them, smallest first,
+ *              instead of having the driver poll the folders.
+ *
+ * (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ ** http://www.apache.org/licenses/LICENSE-2.0
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ *
+ **********************************************************************/
+//
+// Usage: ocrsched [options] BASE_DIR...
+//
+// Every BASE_DIR/<in> tree is watched. A *.pdf file that is closed after
+// writing or moved into the tree is claimed with the same protocol the
+// driver's own polling loop uses, so schedulers and drivers on other hosts
+// sharing the folders keep working:
+//
+//   1. the file is skipped while any <file>.*.tmp exists (another host);
+//   2. the file is opened and flock()ed exclusively, which fails while a
+//      writer or another claimer holds a lock on it;
+//   3. <file>.<host>.tmp is created exclusively;
+//   4. <file> is renamed to <file>.<host>.processing; rename is atomic, so
+//      only one claimer can succeed.
+//
+// The claimed file is then handed to the driver as
+//
+//   <driver> --file BASE_DIR <file>
+//
+// which OCRs it (sending its pages to tesseractd) and moves it out of the
+// input tree. The lock is held until the driver exits. Nothing is polled:
+// the scheduler sleeps in poll() until a file arrives or a driver exits.
+//
+// The flock only holds within one host, and a host that dies leaves its
+// claims behind until it is started again. With --lease SECONDS, claims
+// become leases: the scheduler renews those of its running drivers by
+// touching their <file>.<host>.tmp every third of the lease. A claim of
+// another host whose .tmp was not touched for a whole lease is expired: its
+// <file>.<host>.processing is renamed back to <file>, which only one of
+// the hosts racing for it achieves, and that host removes the .tmp and
+// queues the file again. The modification times are set by the file
+// server, and the age of a .tmp is measured against the modification time
+// of .ocrsched.<host>.clock in the input tree, touched just before, so the
+// hosts' clocks need not agree. Every host sharing the
+// folders must run ocrsched with the same lease, as the driver's polling
+// loop does not renew its claims.
+//
+// Hosts share out whole files only: the driver of a claimed file sends all
+// its pages to the tesseractd of its own host.
+//
+// Pending files wait in a priority queue, so small documents are not stuck
+// behind large ones:
+//
+//   - files below a subfolder given a class with --priority go before
+//     those of lower classes (the default class is 0);
+//   - within a class the smallest file goes first, the size standing for
+//     the work, as the pages are only counted once the driver probes it;
+//   - with --aging, a file that has waited one second weighs as many
+//     bytes less, so large files still overtake smaller newer ones;
+//   - with --small-size, small files may start on --small-jobs extra
+//     slots while all the others are busy. Their pages then take turns
+//     with those of the running files on tesseractd, page by page.
+
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/file.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <syslog.h>
+#include <unistd.h>
+
+#include "genericheap.h"
+#include "genericvector.h"
+#include "host.h"
+#include "kdpair.h"
+#include "strngs.h"
+
+namespace {
+
+const char kDefaultDriver[] = "/usr/local/bin/ocr";
+const char kDefaultInDir[] = "Entrada";
+const int kDefaultJobs = 2;
+const int kDefaultSmallJobs = 1;
+// How long a locked file waits before it is tried again.
+const int kRetryMillisec = 5000;
+const uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+// The class of the files below a subfolder of the input folders.
+struct PriorityClass {
+  STRING dir;
+  int priority;
+};
+
+struct SchedulerConfig {
+  const char* driver;
+  const char* in_dir;
+  STRING host;
+  int jobs;
+  inT64 aging;       // Bytes a second of waiting weighs, 0 for none.
+  inT64 small_size;  // Largest file allowed on the extra slots.
+  int small_jobs;
+  int lease;         // Seconds a claim lasts without renewal, 0 forever.
+  GenericVector<PriorityClass> priorities;
+  GenericVector<STRING> base_dirs;
+};
+
+SchedulerConfig config;
+
+// A watched directory and the base dir its tree belongs to.
+struct Watch {
+  int wd;
+  int base;
+  STRING path;
+};
+
+// A claimed file and the driver process working on it.
+struct Job {
+  pid_t pid;
+  int lock_fd;
+  bool extra;  // Runs on one of the small file slots.
+  STRING file;
+};
+
+// A file waiting to be claimed.
+struct PendingFile {
+  STRING file;
+  int base;
+  inT64 size;
+};
+
+// The order of a pending file: the higher class first, then the lowest
+// due, which is the size, less the waiting time when aging.
+struct QueueKey {
+  int priority;
+  double due;
+
+  bool operator<(const QueueKey& other) const {
+    if (priority != other.priority) return priority > other.priority;
+    return due < other.due;
+  }
+  bool operator==(const QueueKey& other) const {
+    return priority == other.priority && due == other.due;
+  }
+};
+
+typedef tesseract::KDPairInc<QueueKey, PendingFile> QueueEntry;
+
+tesseract::GenericHeap<QueueEntry> queue;
+GenericVector<Watch> watches;
+GenericVector<Job> jobs;
+GenericVector<PendingFile> deferred;  // Locked files, retried later.
+int inotify_fd = -1;
+
+void PrintUsage(const char* program) {
+  fprintf(stderr,
+          "Usage:\n"
+          "  %s [options] BASE_DIR...\n\n"
+          "Options:\n"
+          "  --driver PATH   OCR driver run on claimed files (default %s).\n"
+          "  --in NAME       Input folder below every base dir "
+          "(default %s).\n"
+          "  --jobs NUM      Files processed at the same time (default %d).\n"
+          "  --host NAME     Host name used in claim files "
+          "(default: short host name).\n"
+          "  --priority NAME=N\n"
+          "                  Class of the files below subfolder NAME of the "
+          "input\n"
+          "                  folder; higher classes go first (default 0).\n"
+          "  --aging BYTES   File size a second of waiting makes up for "
+          "(default 0,\n"
+          "                  smallest file first).\n"
+          "  --small-size BYTES\n"
+          "                  Files up to this size may run on extra slots "
+          "(default 0).\n"
+          "  --small-jobs NUM\n"
+          "                  Extra slots for small files (default %d).\n"
+          "  --lease SECONDS Renew the claims of this host, and expire "
+          "those of other\n"
+          "                  hosts not renewed for as long (default 0: "
+          "never).\n",
+          program, kDefaultDriver, kDefaultInDir, kDefaultJobs,
+          kDefaultSmallJobs);
+}
+
+void ParseArgs(int argc, char** argv) {
+  config.driver = kDefaultDriver;
+  config.in_dir = kDefaultInDir;
+  config.jobs = kDefaultJobs;
+  config.aging = 0;
+  config.small_size = 0;
+  config.small_jobs = kDefaultSmallJobs;
+  config.lease = 0;
+  char hostname[256];
+  if (gethostname(hostname, sizeof(hostname)) != 0) hostname[0] = '\0';
+  hostname[sizeof(hostname) - 1] = '\0';
+  char* dot = strchr(hostname, '.');
+  if (dot != NULL) *dot = '\0';
+  config.host = hostname;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--driver") == 0 && i + 1 < argc) {
+      config.driver = argv[++i];
+    } else if (strcmp(argv[i], "--in") == 0 && i + 1 < argc) {
+      config.in_dir = argv[++i];
+    } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+      config.jobs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+      config.host = argv[++i];
+    } else if (strcmp(argv[i], "--priority") == 0 && i + 1 < argc) {
+      const char* arg = argv[++i];
+      const char* eq = strrchr(arg, '=');
+      if (eq == NULL || eq == arg) {
+        PrintUsage(argv[0]);
+        exit(1);
+      }
+      PriorityClass priority_class;
+      priority_class.dir.assign(arg, eq - arg);
+      priority_class.priority = atoi(eq + 1);
+      config.priorities.push_back(priority_class);
+    } else if (strcmp(argv[i], "--aging") == 0 && i + 1 < argc) {
+      config.aging = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--small-size") == 0 && i + 1 < argc) {
+      config.small_size = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--small-jobs") == 0 && i + 1 < argc) {
+      config.small_jobs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--lease") == 0 && i + 1 < argc) {
+      config.lease = atoi(argv[++i]);
+    } else if (argv[i][0] != '-') {
+      config.base_dirs.push_back(argv[i]);
+    } else {
+      PrintUsage(argv[0]);
+      exit(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? 0
+                                                                         : 1);
+    }
+  }
+  if (config.base_dirs.empty()) {
+    PrintUsage(argv[0]);
+    exit(1);
+  }
+  if (config.jobs <= 0) config.jobs = kDefaultJobs;
+  if (config.aging < 0) config.aging = 0;
+  if (config.small_jobs < 0) config.small_jobs = 0;
+  if (config.lease < 0) config.lease = 0;
+}
+
+bool EndsWith(const STRING& str, const char* suffix, bool ignore_case) {
+  int len = strlen(suffix);
+  if (str.length() < len) return false;
+  const char* tail = str.string() + str.length() - len;
+  return ignore_case ? strcasecmp(tail, suffix) == 0
+                     : strcmp(tail, suffix) == 0;
+}
+
+// Returns the input tree of base dir base.
+STRING InputDir(int base) {
+  STRING dir = config.base_dirs[base];
+  if (!EndsWith(dir, "/", false)) dir += "/";
+  dir += config.in_dir;
+  return dir;
+}
+
+// Returns true if another host has claimed file, by the driver protocol.
+bool ClaimedElsewhere(const STRING& file) {
+  STRING pattern = file;
+  pattern += ".*.tmp";
+  glob_t matches;
+  bool found = glob(pattern.string(), GLOB_NOSORT, NULL, &matches) == 0 &&
+               matches.gl_pathc > 0;
+  globfree(&matches);
+  return found;
+}
+
+// Returns the class of file, from the first subfolder of the input tree of
+// base dir base it lies in.
+int PriorityOf(const STRING& file, int base) {
+  STRING dir = InputDir(base);
+  dir += "/";
+  if (config.priorities.empty() ||
+      strncmp(file.string(), dir.string(), dir.length()) != 0)
+    return 0;
+  const char* sub = file.string() + dir.length();
+  const char* slash = strchr(sub, '/');
+  if (slash == NULL) return 0;
+  for (int i = 0; i < config.priorities.size(); ++i) {
+    const STRING& name = config.priorities[i].dir;
+    if (name.length() == slash - sub &&
+        strncmp(name.string(), sub, slash - sub) == 0)
+      return config.priorities[i].priority;
+  }
+  return 0;
+}
+
+void Enqueue(const STRING& file, int base) {
+  if (!EndsWith(file, ".pdf", true)) return;
+  struct stat st;
+  if (stat(file.string(), &st) != 0 || !S_ISREG(st.st_mode)) return;
+  PendingFile pending;
+  pending.file = file;
+  pending.base = base;
+  pending.size = st.st_size;
+  QueueKey key;
+  key.priority = PriorityOf(file, base);
+  // The change time is when the file landed in the folder, by write or
+  // rename; a copy that keeps its modification time does not jump ahead.
+  // Both terms are in seconds, so due is when the file would be done if
+  // it was processed at aging bytes per second from its arrival.
+  key.due = config.aging > 0 ? static_cast<double>(st.st_ctime) +
+                                   static_cast<double>(st.st_size) /
+                                       config.aging
+                             : static_cast<double>(st.st_size);
+  QueueEntry entry(key, pending);
+  queue.Push(&entry);
+}
+
+// Puts back the claims this host left behind when it was stopped, as the
+// driver's polling loop does on startup, and queues every input file.
+// The folder is watched before it is listed, so a file that lands in
+// between is both listed and reported; Claim fails on the second entry.
+void RecoverAndScan(const STRING& dir, int base, bool recover) {
+  int wd = inotify_add_watch(inotify_fd, dir.string(), kWatchMask);
+  if (wd < 0) {
+    syslog(LOG_ERR, "cannot watch %s: %m", dir.string());
+  } else {
+    // Watching a folder again gives back the watch it already has.
+    int w = 0;
+    while (w < watches.size() && watches[w].wd != wd) ++w;
+    if (w == watches.size()) watches.push_back(Watch());
+    watches[w].wd = wd;
+    watches[w].base = base;
+    watches[w].path = dir;
+  }
+  DIR* d = opendir(dir.string());
+  if (d == NULL) return;
+  STRING processing_suffix = ".";
+  processing_suffix += config.host;
+  STRING tmp_suffix = processing_suffix;
+  processing_suffix += ".processing";
+  tmp_suffix += ".tmp";
+  GenericVector<STRING> files, subdirs;
+  struct dirent* entry;
+  while ((entry = readdir(d)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    STRING path = dir;
+    path += "/";
+    path += entry->d_name;
+    struct stat st;
+    if (lstat(path.string(), &st) != 0) continue;
+    if (S_ISDIR(st.st_mode)) {
+      subdirs.push_back(path);
+    } else if (recover && EndsWith(path, tmp_suffix.string(), true)) {
+      unlink(path.string());
+    } else if (recover && EndsWith(path, processing_suffix.string(), true)) {
+      STRING original;
+      original.assign(path.string(),
+                      path.length() - processing_suffix.length());
+      rename(path.string(), original.string());
+      files.push_back(original);
+    } else {
+      files.push_back(path);
+    }
+  }
+  closedir(d);
+  for (int i = 0; i < files.size(); ++i) Enqueue(files[i], base);
+  for (int i = 0; i < subdirs.size(); ++i)
+    RecoverAndScan(subdirs[i], base, recover);
+}
+
+// Claims file for this host. Returns the fd holding its lock, -1 if it
+// is gone or claimed by someone else, or -2 if it is still locked.
+int Claim(const STRING& file) {
+  if (ClaimedElsewhere(file)) return -1;
+  int fd = open(file.string(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    close(fd);
+    return -2;
+  }
+  STRING tmp = file;
+  tmp += ".";
+  tmp += config.host;
+  STRING processing = tmp;
+  tmp += ".tmp";
+  processing += ".processing";
+  int tmp_fd = open(tmp.string(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                    0644);
+  if (tmp_fd < 0) {
+    close(fd);
+    return -1;
+  }
+  close(tmp_fd);
+  if (rename(file.string(), processing.string()) != 0) {
+    unlink(tmp.string());
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Runs the driver on a claimed file.
+bool StartJob(const STRING& file, int base, int lock_fd, bool extra) {
+  pid_t pid = fork();
+  if (pid < 0) {
+    syslog(LOG_ERR, "cannot fork for %s: %m", file.string());
+    return false;
+  }
+  if (pid == 0) {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigprocmask(SIG_SETMASK, &signals, NULL);
+    execl(config.driver, config.driver, "--file",
+          config.base_dirs[base].string(), file.string(),
+          static_cast<char*>(NULL));
+    syslog(LOG_ERR, "cannot run %s: %m", config.driver);
+    _exit(127);
+  }
+  Job job;
+  job.pid = pid;
+  job.lock_fd = lock_fd;
+  job.extra = extra;
+  job.file = file;
+  jobs.push_back(job);
+  return true;
+}
+
+// Gives a claim back, so the file can be picked up again.
+void Unclaim(const STRING& file, int lock_fd) {
+  STRING tmp = file;
+  tmp += ".";
+  tmp += config.host;
+  STRING processing = tmp;
+  tmp += ".tmp";
+  processing += ".processing";
+  rename(processing.string(), file.string());
+  unlink(tmp.string());
+  close(lock_fd);
+}
+
+// Starts drivers on queued files while there are free job slots. Once the
+// regular slots are taken, small files are looked for further down the
+// queue for the extra slots, and the larger ones passed over are put back.
+void Dispatch() {
+  int extra_jobs = 0;
+  for (int i = 0; i < jobs.size(); ++i)
+    if (jobs[i].extra) ++extra_jobs;
+  GenericVector<QueueEntry> passed;
+  QueueEntry entry;
+  while (queue.Pop(&entry)) {
+    const PendingFile& pending = entry.data;
+    bool extra = jobs.size() - extra_jobs >= config.jobs;
+    if (extra && (config.small_size <= 0 || extra_jobs >= config.small_jobs)) {
+      queue.Push(&entry);
+      break;
+    }
+    if (extra && pending.size > config.small_size) {
+      passed.push_back(entry);
+      continue;
+    }
+    // A file may be queued more than once by successive events; the
+    // later copies fail to claim it because it is gone.
+    int fd = Claim(pending.file);
+    if (fd == -2) {
+      deferred.push_back(pending);
+      continue;
+    }
+    if (fd < 0) continue;
+    if (!StartJob(pending.file, pending.base, fd, extra)) {
+      Unclaim(pending.file, fd);
+    } else if (extra) {
+      ++extra_jobs;
+    }
+  }
+  for (int i = 0; i < passed.size(); ++i) queue.Push(&passed[i]);
+}
+
+void RequeueDeferred() {
+  for (int i = 0; i < deferred.size(); ++i)
+    Enqueue(deferred[i].file, deferred[i].base);
+  deferred.clear();
+}
+
+int FindWatch(int wd) {
+  for (int i = 0; i < watches.size(); ++i)
+    if (watches[i].wd == wd) return i;
+  return -1;
+}
+
+void ReadWatchEvents() {
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t len = read(inotify_fd, buf, sizeof(buf));
+  for (char* p = buf; len > 0 && p < buf + len;) {
+    const struct inotify_event* event =
+        reinterpret_cast<const struct inotify_event*>(p);
+    p += sizeof(struct inotify_event) + event->len;
+    int w = FindWatch(event->wd);
+    if (w < 0) continue;
+    if (event->mask & IN_IGNORED) {
+      watches.remove(w);
+      continue;
+    }
+    if (event->len == 0) continue;
+    STRING path = watches[w].path;
+    path += "/";
+    path += event->name;
+    if (event->mask & IN_ISDIR) {
+      // Files may have landed before the watch on the new folder exists.
+      if (event->mask & (IN_CREATE | IN_MOVED_TO))
+        RecoverAndScan(path, watches[w].base, false);
+    } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+      Enqueue(path, watches[w].base);
+    }
+  }
+}
+
+// Reaps finished drivers and releases their locks.
+void ReapJobs() {
+  int status;
+  pid_t pid;
+  while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+    for (int i = 0; i < jobs.size(); ++i) {
+      if (jobs[i].pid != pid) continue;
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        syslog(LOG_INFO, "OCR driver ended with status %d for %s", status,
+               jobs[i].file.string());
+      close(jobs[i].lock_fd);
+      jobs.remove(i);
+      break;
+    }
+  }
+}
+
+// Renews the leases of the running drivers.
+void RenewLeases() {
+  for (int i = 0; i < jobs.size(); ++i) {
+    STRING tmp = jobs[i].file;
+    tmp += ".";
+    tmp += config.host;
+    tmp += ".tmp";
+    utimensat(AT_FDCWD, tmp.string(), NULL, 0);
+  }
+}
+
+// Returns the time of the file server of the input tree of base dir base,
+// as the modification time it gives the clock file of this host there when
+// it is touched, or -1 if it can't be touched.
+time_t ServerTime(int base) {
+  STRING clock = InputDir(base);
+  clock += "/.ocrsched.";
+  clock += config.host;
+  clock += ".clock";
+  int fd = open(clock.string(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) return -1;
+  struct stat st;
+  bool ok = futimens(fd, NULL) == 0 && fstat(fd, &st) == 0;
+  close(fd);
+  return ok ? st.st_mtime : -1;
+}
+
+// Expires the claims of other hosts in the watched folders whose lease
+// ran out, and queues their files again.
+void ExpireLeases() {
+  // The markers are timed by the file server, so their age is too.
+  GenericVector<time_t> server_now;
+  for (int b = 0; b < config.base_dirs.size(); ++b)
+    server_now.push_back(ServerTime(b));
+  for (int w = 0; w < watches.size(); ++w) {
+    time_t now = server_now[watches[w].base];
+    if (now < 0) continue;
+    DIR* d = opendir(watches[w].path.string());
+    if (d == NULL) continue;
+    GenericVector<STRING> stale;
+    struct dirent* entry;
+    while ((entry = readdir(d)) != NULL) {
+      STRING name = entry->d_name;
+      if (!EndsWith(name, ".tmp", false)) continue;
+      stale.push_back(name);
+    }
+    closedir(d);
+    for (int i = 0; i < stale.size(); ++i) {
+      // <file>.<host>.tmp, where <file> is a pdf and <host> is not this one.
+      STRING stem;
+      stem.assign(stale[i].string(), stale[i].length() - 4);
+      const char* dot = strrchr(stem.string(), '.');
+      if (dot == NULL) continue;
+      STRING host = dot + 1;
+      stem.truncate_at(dot - stem.string());
+      if (host == config.host || !EndsWith(stem, ".pdf", true)) continue;
+      STRING dir = watches[w].path;
+      dir += "/";
+      STRING tmp = dir + stale[i];
+      struct stat st;
+      if (stat(tmp.string(), &st) != 0 || now - st.st_mtime < config.lease)
+        continue;
+      STRING file = dir + stem;
+      STRING processing = file;
+      processing += ".";
+      processing += host;
+      processing += ".processing";
+      // A claim that never got to the rename has no .processing, and only
+      // its .tmp is left to remove.
+      if (rename(processing.string(), file.string()) != 0 && errno != ENOENT)
+        continue;
+      unlink(tmp.string());
+      syslog(LOG_INFO, "lease of %s on %s expired", file.string(),
+             host.string());
+      Enqueue(file, watches[w].base);
+    }
+  }
+}
+
+void StopJobs() {
+  for (int i = 0; i < jobs.size(); ++i) kill(jobs[i].pid, SIGTERM);
+  while (!jobs.empty()) {
+    pid_t pid = waitpid(-1, NULL, 0);
+    if (pid < 0 && errno != EINTR) break;
+    for (int i = 0; i < jobs.size(); ++i) {
+      if (jobs[i].pid == pid) {
+        close(jobs[i].lock_fd);
+        jobs.remove(i);
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ParseArgs(argc, argv);
+  openlog("ocrsched", LOG_NDELAY | LOG_PID, LOG_LOCAL0);
+
+  // Child exits and stop requests are read from a signalfd, so the only
+  // place the scheduler ever waits is the poll below.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGCHLD);
+  sigaddset(&signals, SIGTERM);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGHUP);
+  sigprocmask(SIG_BLOCK, &signals, NULL);
+  int signal_fd = signalfd(-1, &signals, SFD_CLOEXEC | SFD_NONBLOCK);
+  inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+  if (signal_fd < 0 || inotify_fd < 0) {
+    perror("ocrsched");
+    return EXIT_FAILURE;
+  }
+  for (int b = 0; b < config.base_dirs.size(); ++b) {
+    syslog(LOG_INFO, "OCR started, monitoring: %s",
+           config.base_dirs[b].string());
+    RecoverAndScan(InputDir(b), b, true);
+  }
+  if (watches.empty()) {
+    fprintf(stderr, "ocrsched: no input folder could be watched\n");
+    return EXIT_FAILURE;
+  }
+
+  time_t next_renewal = 0;
+  while (true) {
+    time_t now = time(NULL);
+    if (config.lease > 0 && now >= next_renewal) {
+      RenewLeases();
+      ExpireLeases();
+      next_renewal = now + MAX(config.lease / 3, 1);
+    }
+    Dispatch();
+    struct pollfd fds[2];
+    fds[0].fd = inotify_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = signal_fd;
+    fds[1].events = POLLIN;
+    int timeout = deferred.empty() ? -1 : kRetryMillisec;
+    if (config.lease > 0) {
+      int renewal = static_cast<int>(next_renewal - now) * 1000;
+      if (timeout < 0 || renewal < timeout) timeout = renewal;
+    }
+    int ready = poll(fds, 2, timeout);
+    if (ready < 0 && errno != EINTR) {
+      perror("poll");
+      break;
+    }
+    if (ready == 0) RequeueDeferred();
+    if (fds[0].revents & POLLIN) ReadWatchEvents();
+    if (fds[1].revents & POLLIN) {
+      struct signalfd_siginfo info;
+      bool stop = false;
+      while (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+        if (info.ssi_signo != SIGCHLD) stop = true;
+      }
+      ReapJobs();
+      if (stop) {
+        syslog(LOG_INFO, "OCR stopped");
+        StopJobs();
+        return EXIT_SUCCESS;
+      }
+    }
+  }
+  StopJobs();
+  return EXIT_FAILURE;
+}
+
+#else  // __linux__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char** argv) {
+  fprintf(stderr, "%s: inotify is not supported on this platform\n",
+          argv[0]);
+  return EXIT_FAILURE;
+}
+
+#endif  // __linux__
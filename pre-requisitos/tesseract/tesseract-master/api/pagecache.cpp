@@ -0,0 +1,426 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagecache.cpp
+// Description: On disk cache of rendered page results.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "pagecache.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+#include "allheaders.h"
+#include "kdpair.h"
+#include "tprintf.h"
+
+namespace tesseract {
+
+// First line of every entry, changed whenever the format changes.
+const char kEntryMagic[] = "tesseract page cache 1\n";
+const char kEntrySuffix[] = ".page";
+// Largest number of results an entry may hold.
+const int kMaxEntryResults = 16;
+
+// Reduction of the pages compared by DuplicatePageIndex.
+const int kDuplicateReduction = 2;
+// Pages of a document kept by DuplicatePageIndex, the oldest going first.
+const int kMaxDuplicatePages = 64;
+// Side of the grid of cells whose ink makes up the signature of a page.
+const int kSignatureGrid = 8;
+// Most bits by which the signatures of near-duplicate pages differ.
+const int kMaxSignatureDistance = 10;
+// Largest difference in size of near-duplicate pages, as a fraction of it.
+const double kMaxSizeChange = 0.02;
+// Largest offset between near-duplicate pages as a fraction of their size,
+// as the results reused are that far off on the new page.
+const double kMaxPageShift = 0.01;
+// Search range for the best alignment around that of the centroids.
+const int kAlignmentSearch = 2;
+// Ink further than this from any ink of the other page is a difference.
+const int kInkTolerance = 3;
+// Largest fraction of the ink of a page, and of a word, that may differ.
+const double kMaxPageMismatch = 0.05;
+const double kMaxWordMismatch = 0.1;
+
+// Two independent 64 bit hashes, fed with 32 bit words.
+struct PageHash {
+  PageHash() : a(14695981039346656037ULL), b(0x9E3779B97F4A7C15ULL) {}
+  void Add(uinT32 word) {
+    a = (a ^ word) * 1099511628211ULL;
+    b = (b + word) * 0xFF51AFD7ED558CCDULL;
+    b ^= b >> 29;
+  }
+  void AddBytes(const char* data, int length) {
+    for (int i = 0; i < length; ++i) Add(static_cast<unsigned char>(data[i]));
+  }
+  uinT64 a;
+  uinT64 b;
+};
+
+CachedPage::~CachedPage() {
+  pixDestroy(&page);
+}
+
+PageResultCache::PageResultCache(const char* dir, inT64 max_bytes)
+  : dir_(dir), max_bytes_(max_bytes), bytes_(-1) {
+#ifndef _WIN32
+  // Only the last level is created.
+  mkdir(dir, 0777);
+#endif
+}
+
+STRING PageResultCache::EntryName(Pix* pix, const STRING& settings) {
+  PageHash hash;
+  hash.Add(pixGetWidth(pix));
+  hash.Add(pixGetHeight(pix));
+  hash.Add(pixGetDepth(pix));
+  hash.Add(pixGetXRes(pix));
+  hash.Add(pixGetYRes(pix));
+  // Bits past the width in the last word of each line are undefined, so
+  // they are masked off.
+  int width_bits = pixGetWidth(pix) * pixGetDepth(pix);
+  int full_words = width_bits / 32;
+  uinT32 last_mask = width_bits % 32 == 0
+      ? 0 : ~0U << (32 - width_bits % 32);
+  const l_uint32* data = pixGetData(pix);
+  int wpl = pixGetWpl(pix);
+  for (int y = 0; y < pixGetHeight(pix); ++y, data += wpl) {
+    for (int x = 0; x < full_words; ++x) hash.Add(data[x]);
+    if (last_mask != 0) hash.Add(data[full_words] & last_mask);
+  }
+  hash.AddBytes(settings.string(), settings.length());
+  char name[40];
+  snprintf(name, sizeof(name), "%016llx%016llx",
+           static_cast<unsigned long long>(hash.a),
+           static_cast<unsigned long long>(hash.b));
+  return STRING(name);
+}
+
+bool PageResultCache::Lookup(const STRING& name, const STRING& settings,
+                             GenericVector<STRING>* kinds,
+                             GenericVector<STRING>* results) {
+  STRING path = dir_ + "/" + name + kEntrySuffix;
+  GenericVector<char> data;
+  if (!LoadDataFromFile(path, &data)) return false;
+  data.push_back('\0');
+  const char* p = &data[0];
+  const char* end = p + data.size() - 1;
+  int magic_length = strlen(kEntryMagic);
+  if (end - p < magic_length || strncmp(p, kEntryMagic, magic_length) != 0)
+    return false;
+  p += magic_length;
+  // The settings are stored in full, so a hash collision between different
+  // settings cannot serve the wrong results.
+  if (end - p < settings.length() + 1 ||
+      strncmp(p, settings.string(), settings.length()) != 0 ||
+      p[settings.length()] != '\n')
+    return false;
+  p += settings.length() + 1;
+  int count;
+  int consumed;
+  if (sscanf(p, "%d\n%n", &count, &consumed) != 1 || count < 0 ||
+      count > kMaxEntryResults)
+    return false;
+  p += consumed;
+  kinds->clear();
+  results->clear();
+  for (int i = 0; i < count; ++i) {
+    char kind[32];
+    int length;
+    if (sscanf(p, "%31s %d\n%n", kind, &length, &consumed) != 2 ||
+        length < 0 || end - p - consumed < length)
+      return false;
+    p += consumed;
+    kinds->push_back(STRING(kind));
+    STRING result;
+    result.assign(p, length);
+    results->push_back(result);
+    p += length;
+  }
+#ifndef _WIN32
+  // Touching the entry is what keeps it alive in Evict.
+  utime(path.string(), NULL);
+#endif
+  return true;
+}
+
+void PageResultCache::Store(const STRING& name, const STRING& settings,
+                            const GenericVector<STRING>& kinds,
+                            const GenericVector<STRING>& results) {
+  if (kinds.empty() || kinds.size() != results.size() ||
+      kinds.size() > kMaxEntryResults)
+    return;
+  STRING path = dir_ + "/" + name + kEntrySuffix;
+  STRING tmp_path = path;
+#ifndef _WIN32
+  tmp_path.add_str_int(".", getpid());
+#endif
+  tmp_path += ".tmp";
+  FILE* fp = fopen(tmp_path.string(), "wb");
+  if (fp == NULL) {
+    tprintf("Warning: cannot write page cache entry %s\n", tmp_path.string());
+    return;
+  }
+  bool ok = fputs(kEntryMagic, fp) >= 0 &&
+      fprintf(fp, "%s\n%d\n", settings.string(), kinds.size()) > 0;
+  for (int i = 0; ok && i < kinds.size(); ++i) {
+    int length = results[i].length();
+    ok = fprintf(fp, "%s %d\n", kinds[i].string(), length) > 0 &&
+        fwrite(results[i].string(), 1, length, fp) ==
+            static_cast<size_t>(length);
+  }
+  inT64 size = ftell(fp);
+  ok = fclose(fp) == 0 && ok;
+  if (!ok || rename(tmp_path.string(), path.string()) != 0) {
+    remove(tmp_path.string());
+    return;
+  }
+  if (bytes_ >= 0) bytes_ += size;
+  if (bytes_ < 0 || bytes_ > max_bytes_) Evict(path);
+}
+
+void PageResultCache::Evict(const STRING& keep) {
+#ifndef _WIN32
+  DIR* dir = opendir(dir_.string());
+  if (dir == NULL) return;
+  // Entries by last use, oldest first.
+  GenericVector<KDPairInc<inT64, STRING> > entries;
+  inT64 total = 0;
+  int suffix_length = strlen(kEntrySuffix);
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    int length = strlen(entry->d_name);
+    if (length <= suffix_length ||
+        strcmp(entry->d_name + length - suffix_length, kEntrySuffix) != 0)
+      continue;
+    STRING path = dir_ + "/" + entry->d_name;
+    struct stat st;
+    if (stat(path.string(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+    total += st.st_size;
+    if (path == keep) continue;
+    inT64 last_use = static_cast<inT64>(st.st_mtime) * 1000000000;
+#ifdef __linux__
+    last_use += st.st_mtim.tv_nsec;
+#endif
+    entries.push_back(KDPairInc<inT64, STRING>(last_use, path));
+  }
+  closedir(dir);
+  if (total > max_bytes_) {
+    entries.sort();
+    inT64 target = max_bytes_ / 10 * 9;
+    for (int i = 0; i < entries.size() && total > target; ++i) {
+      struct stat st;
+      const char* path = entries[i].data.string();
+      if (stat(path, &st) == 0 && remove(path) == 0) total -= st.st_size;
+    }
+  }
+  bytes_ = total;
+#endif  // _WIN32
+}
+
+// Returns the number of pixels of pix in box, which may reach outside it.
+static int CountInBox(Pix* pix, Box* box, l_int32* tab) {
+  Pix* clip = pixClipRectangle(pix, box, NULL);
+  l_int32 count = 0;
+  if (clip != NULL) pixCountPixels(clip, &count, tab);
+  pixDestroy(&clip);
+  return count;
+}
+
+DuplicatePageIndex::~DuplicatePageIndex() {
+  Clear();
+}
+
+void DuplicatePageIndex::Clear() {
+  SVAutoLock lock(&mutex_);
+  for (int i = 0; i < entries_.size(); ++i) {
+    pixDestroy(&entries_[i]->page);
+    boxaDestroy(&entries_[i]->words);
+    delete entries_[i];
+  }
+  entries_.clear();
+}
+
+Pix* DuplicatePageIndex::ReducePage(Pix* pix) {
+  // Thin strokes survive the reduction by taking the darkest pixels.
+  if (pixGetDepth(pix) == 1 && pixGetColormap(pix) == NULL)
+    return pixReduceRankBinary2(pix, 1, NULL);
+  Pix* grey = pixConvertTo8(pix, false);
+  Pix* reduced = grey != NULL
+      ? pixScaleGrayMinMax(grey, kDuplicateReduction, kDuplicateReduction,
+                           L_CHOOSE_MIN)
+      : NULL;
+  pixDestroy(&grey);
+  if (reduced == NULL) return NULL;
+  // A single tile is a global Otsu threshold.
+  Pix* page = NULL;
+  pixOtsuAdaptiveThreshold(reduced, pixGetWidth(reduced),
+                           pixGetHeight(reduced), 0, 0, 0.1, NULL, &page);
+  pixDestroy(&reduced);
+  return page;
+}
+
+uinT64 DuplicatePageIndex::Signature(Pix* page) {
+  int width = pixGetWidth(page);
+  int height = pixGetHeight(page);
+  l_int32* tab = makePixelSumTab8();
+  int counts[kSignatureGrid * kSignatureGrid];
+  for (int y = 0; y < kSignatureGrid; ++y) {
+    for (int x = 0; x < kSignatureGrid; ++x) {
+      int left = x * width / kSignatureGrid;
+      int top = y * height / kSignatureGrid;
+      Box* cell = boxCreate(left, top, (x + 1) * width / kSignatureGrid - left,
+                            (y + 1) * height / kSignatureGrid - top);
+      counts[y * kSignatureGrid + x] = CountInBox(page, cell, tab);
+      boxDestroy(&cell);
+    }
+  }
+  LEPT_FREE(tab);
+  // Each bit tells whether a cell has more ink than the median cell, which
+  // a slight shift, or a lighter or darker scan, rarely changes.
+  GenericVector<int> sorted;
+  for (int i = 0; i < kSignatureGrid * kSignatureGrid; ++i)
+    sorted.push_back(counts[i]);
+  sorted.sort();
+  int median = sorted[sorted.size() / 2];
+  uinT64 signature = 0;
+  for (int i = 0; i < kSignatureGrid * kSignatureGrid; ++i) {
+    if (counts[i] > median) signature |= 1ULL << i;
+  }
+  return signature;
+}
+
+double DuplicatePageIndex::Agreement(const Entry& entry, Pix* page) {
+  Pix* old_page = entry.page;
+  int width = pixGetWidth(old_page);
+  int height = pixGetHeight(old_page);
+  if (abs(pixGetWidth(page) - width) > width * kMaxSizeChange ||
+      abs(pixGetHeight(page) - height) > height * kMaxSizeChange)
+    return 0.0;
+  l_int32* tab = makePixelSumTab8();
+  l_int32 old_area = 0, new_area = 0;
+  pixCountPixels(old_page, &old_area, tab);
+  pixCountPixels(page, &new_area, tab);
+  if (old_area == 0 || new_area == 0) {
+    LEPT_FREE(tab);
+    return old_area == new_area && boxaGetCount(entry.words) == 0 ? 1.0 : 0.0;
+  }
+  // The new page is aligned on the old one, first by their centroids.
+  l_float32 old_x, old_y, new_x, new_y;
+  pixCentroid(old_page, NULL, tab, &old_x, &old_y);
+  pixCentroid(page, NULL, tab, &new_x, &new_y);
+  l_int32 dx = 0, dy = 0;
+  pixBestCorrelation(old_page, page, old_area, new_area,
+                     static_cast<int>(floor(old_x - new_x + 0.5)),
+                     static_cast<int>(floor(old_y - new_y + 0.5)),
+                     kAlignmentSearch, tab, &dx, &dy, NULL, 0);
+  if (abs(dx) > width * kMaxPageShift || abs(dy) > height * kMaxPageShift) {
+    LEPT_FREE(tab);
+    return 0.0;
+  }
+  Pix* aligned = pixCreate(width, height, 1);
+  pixRasterop(aligned, dx, dy, pixGetWidth(page), pixGetHeight(page), PIX_SRC,
+              page, 0, 0);
+  // Differences are the ink of either page that is not close to any ink of
+  // the other, so that the jitter of a new scan doesn't count.
+  Pix* near_old = pixDilateBrick(NULL, old_page, kInkTolerance, kInkTolerance);
+  Pix* near_new = pixDilateBrick(NULL, aligned, kInkTolerance, kInkTolerance);
+  Pix* added = pixSubtract(NULL, aligned, near_old);
+  Pix* missing = pixSubtract(NULL, old_page, near_new);
+  pixDestroy(&near_old);
+  pixDestroy(&near_new);
+  l_int32 added_area = 0, missing_area = 0, aligned_area = 0;
+  pixCountPixels(added, &added_area, tab);
+  pixCountPixels(missing, &missing_area, tab);
+  pixCountPixels(aligned, &aligned_area, tab);
+  double agreement = 0.0;
+  // New ink anywhere on the page may be text the old page didn't have.
+  if (added_area + missing_area <=
+      kMaxPageMismatch * (old_area + aligned_area)) {
+    int num_words = boxaGetCount(entry.words);
+    int num_agreeing = 0;
+    for (int i = 0; i < num_words; ++i) {
+      Box* box = boxaGetBox(entry.words, i, L_CLONE);
+      int ink = CountInBox(old_page, box, tab) + CountInBox(aligned, box, tab);
+      int mismatch = CountInBox(added, box, tab) +
+          CountInBox(missing, box, tab);
+      if (mismatch <= kMaxWordMismatch * ink) ++num_agreeing;
+      boxDestroy(&box);
+    }
+    agreement = num_words > 0
+        ? static_cast<double>(num_agreeing) / num_words : 1.0;
+  }
+  pixDestroy(&aligned);
+  pixDestroy(&added);
+  pixDestroy(&missing);
+  LEPT_FREE(tab);
+  return agreement;
+}
+
+bool DuplicatePageIndex::Lookup(Pix* page, const STRING& settings,
+                                double min_confidence,
+                                GenericVector<STRING>* kinds,
+                                GenericVector<STRING>* results) {
+  uinT64 signature = Signature(page);
+  SVAutoLock lock(&mutex_);
+  const Entry* best = NULL;
+  double best_agreement = 0.0;
+  for (int i = 0; i < entries_.size(); ++i) {
+    const Entry* entry = entries_[i];
+    if (entry->settings != settings) continue;
+    uinT64 diff = entry->signature ^ signature;
+    int distance = 0;
+    for (; diff != 0; diff &= diff - 1) ++distance;
+    if (distance > kMaxSignatureDistance) continue;
+    double agreement = Agreement(*entry, page);
+    if (agreement >= min_confidence && agreement > best_agreement) {
+      best = entry;
+      best_agreement = agreement;
+    }
+  }
+  if (best == NULL) return false;
+  *kinds = best->kinds;
+  *results = best->results;
+  return true;
+}
+
+void DuplicatePageIndex::Add(Pix* page, Boxa* words, const STRING& settings,
+                             const GenericVector<STRING>& kinds,
+                             const GenericVector<STRING>& results) {
+  Entry* entry = new Entry;
+  entry->page = page;
+  entry->words = words != NULL ? words : boxaCreate(0);
+  entry->signature = Signature(page);
+  entry->settings = settings;
+  entry->kinds = kinds;
+  entry->results = results;
+  SVAutoLock lock(&mutex_);
+  if (entries_.size() >= kMaxDuplicatePages) {
+    pixDestroy(&entries_[0]->page);
+    boxaDestroy(&entries_[0]->words);
+    delete entries_[0];
+    entries_.remove(0);
+  }
+  entries_.push_back(entry);
+}
+
+}  // namespace tesseract.
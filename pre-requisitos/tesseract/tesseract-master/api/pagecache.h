@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagecache.h
+// Description: On disk cache of rendered page results.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_PAGECACHE_H_
+#define TESSERACT_API_PAGECACHE_H_
+
+#include "genericvector.h"
+#include "host.h"
+#include "platform.h"
+#include "strngs.h"
+#include "svutil.h"
+
+struct Boxa;
+struct Pix;
+
+namespace tesseract {
+
+// A page rendered through a PageResultCache or a DuplicatePageIndex by
+// TessBaseAPI.
+struct CachedPage {
+  CachedPage() : active(false), hit(false), page(NULL) {}
+  ~CachedPage();
+
+  bool active;     // name and settings identify the page being rendered.
+  bool hit;        // kinds and results were read from the cache.
+  STRING name;     // Entry of the page.
+  STRING settings;
+  // The result each renderer of the chain produced for the page, by kind.
+  GenericVector<STRING> kinds;
+  GenericVector<STRING> results;
+  // Reduced binary image the page is compared on in a DuplicatePageIndex.
+  Pix* page;
+};
+
+// Keeps the results renderers produced for a page image, so that the same
+// image met again (a resubmitted scan, a cover sheet or form shared by many
+// documents) is rendered without being recognized. Entries are files in one
+// directory, named after a hash of the page image and of the settings the
+// results depend on. Reading an entry marks it as recently used, and once
+// the directory grows past its size limit the least recently used entries
+// are removed. Several processes may share the directory: entries are
+// written to a temporary file and renamed into place.
+class TESS_LOCAL PageResultCache {
+ public:
+  PageResultCache(const char* dir, inT64 max_bytes);
+
+  const STRING& dir() const { return dir_; }
+  void set_max_bytes(inT64 max_bytes) { max_bytes_ = max_bytes; }
+
+  // Returns the name of the entry of pix under the given settings.
+  static STRING EntryName(Pix* pix, const STRING& settings);
+
+  // Fills kinds and results with the results stored under name for the
+  // given settings, and returns true, or returns false if there are none.
+  bool Lookup(const STRING& name, const STRING& settings,
+              GenericVector<STRING>* kinds, GenericVector<STRING>* results);
+  // Stores results, one for each of kinds, under name. Failing to write
+  // only loses the entry.
+  void Store(const STRING& name, const STRING& settings,
+             const GenericVector<STRING>& kinds,
+             const GenericVector<STRING>& results);
+
+ private:
+  // Removes the least recently used entries, other than the one at path
+  // keep, until the directory is back under 90% of max_bytes_.
+  void Evict(const STRING& keep);
+
+  STRING dir_;
+  inT64 max_bytes_;
+  // Size of the directory as last scanned plus what was stored since, or
+  // -1 before the first scan.
+  inT64 bytes_;
+};
+
+// Keeps the pages of a document rendered so far, so that a page met again
+// within it, typically a new scan of an attachment repeated in a dossier,
+// is rendered with the results of the earlier page. Unlike PageResultCache
+// the image need not be the same: pages are first matched on a coarse
+// signature of their ink, then aligned, and the results are only reused if
+// the words of the earlier page are found again in place on the new one.
+// Several TessBaseAPI recognizing the pages of a document on different
+// threads may share one index.
+class TESS_LOCAL DuplicatePageIndex {
+ public:
+  DuplicatePageIndex() {}
+  ~DuplicatePageIndex();
+
+  // Forgets every page, when a new document begins.
+  void Clear();
+
+  // Returns the reduced binary image of pix that pages are compared on, or
+  // NULL on failure.
+  static Pix* ReducePage(Pix* pix);
+
+  // Looks for an earlier page of which page, as given by ReducePage, is a
+  // near-duplicate under the same settings, with at least min_confidence
+  // of its words found again in place. On success fills kinds and results
+  // with what the renderers produced for it and returns true.
+  bool Lookup(Pix* page, const STRING& settings, double min_confidence,
+              GenericVector<STRING>* kinds, GenericVector<STRING>* results);
+  // Adds a page, taking ownership of page and of words, the boxes of its
+  // words in the coordinates of page.
+  void Add(Pix* page, Boxa* words, const STRING& settings,
+           const GenericVector<STRING>& kinds,
+           const GenericVector<STRING>& results);
+
+ private:
+  struct Entry {
+    Pix* page;
+    Boxa* words;
+    uinT64 signature;
+    STRING settings;
+    GenericVector<STRING> kinds;
+    GenericVector<STRING> results;
+  };
+
+  // Returns a 64 bit signature of the ink of page, in which near-duplicate
+  // pages differ by few bits.
+  static uinT64 Signature(Pix* page);
+  // Returns the fraction of the words of entry found again in place in
+  // page, or 0 if the pages can't be aligned or differ outside the words.
+  static double Agreement(const Entry& entry, Pix* page);
+
+  GenericVector<Entry*> entries_;
+  SVMutex mutex_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_API_PAGECACHE_H_
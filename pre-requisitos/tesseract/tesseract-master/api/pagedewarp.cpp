@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagedewarp.cpp
+// Description: Straightening of the curled text lines of scanned pages.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "pagedewarp.h"
+
+#include <stdlib.h>
+#include "allheaders.h"
+
+namespace tesseract {
+
+// Reduction of the page image models are built on.
+const int kDewarpReduction = 2;
+// Sampling of the disparity arrays on the reduced image, the default of
+// leptonica at full resolution.
+const int kDewarpSampling = 15;
+// Farthest page whose model a page without one may borrow.
+const int kMaxDewarpRefDistance = 8;
+
+// Returns the 2x reduced binary image of pix that its model is built on,
+// or NULL on failure.
+static Pix* ModelImage(Pix* pix) {
+  if (pixGetDepth(pix) == 1) return pixReduceRankBinary2(pix, 1, NULL);
+  Pix* grey = pixConvertTo8(pix, false);
+  Pix* reduced = grey != NULL ? pixScaleAreaMap2(grey) : NULL;
+  pixDestroy(&grey);
+  if (reduced == NULL) return NULL;
+  // Background normalization evens out the shadow of the gutter.
+  Pix* binary = pixAdaptThresholdToBinary(reduced, NULL, 1.0f);
+  pixDestroy(&reduced);
+  return binary;
+}
+
+DewarpModelIndex::~DewarpModelIndex() {
+  Clear();
+}
+
+void DewarpModelIndex::Clear() {
+  SVAutoLock lock(&mutex_);
+  for (int i = 0; i < models_.size(); ++i) lept_free(models_[i].data);
+  models_.clear();
+}
+
+Pix* DewarpModelIndex::Dewarp(Pix* pix, int page_index) {
+  int depth = pixGetDepth(pix);
+  if (page_index < 0 || pixGetColormap(pix) != NULL ||
+      (depth != 1 && depth != 8 && depth != 32)) {
+    return NULL;
+  }
+  Pix* binary = ModelImage(pix);
+  if (binary == NULL) return NULL;
+  // A dewarpa of its own, holding the model of this page and those it may
+  // borrow, lets pages be dewarped on several threads at once.
+  L_DEWARPA* dewa = dewarpaCreate(page_index + 1, kDewarpSampling,
+                                  kDewarpReduction, 0, kMaxDewarpRefDistance);
+  L_DEWARP* dew = dewa != NULL ? dewarpCreate(binary, page_index) : NULL;
+  pixDestroy(&binary);
+  if (dew == NULL) {
+    dewarpaDestroy(&dewa);
+    return NULL;
+  }
+  dewarpaInsertDewarp(dewa, dew);
+  dewarpBuildPageModel(dew, NULL);
+  dewarpaSetValidModels(dewa, 0, 0);
+  if (dew->vvalid) {
+    unsigned char* data;
+    size_t size;
+    if (dewarpWriteMem(&data, &size, dew) == 0) Add(page_index, data, size);
+  } else {
+    SVAutoLock lock(&mutex_);
+    for (int i = 0; i < models_.size(); ++i) {
+      int distance = abs(models_[i].page - page_index);
+      if (distance % 2 != 0 || distance > kMaxDewarpRefDistance) continue;
+      L_DEWARP* ref = dewarpReadMem(models_[i].data, models_[i].size);
+      if (ref != NULL) dewarpaInsertDewarp(dewa, ref);
+    }
+  }
+  dewarpaInsertRefModels(dewa, 0, 0);
+  Pix* result = NULL;
+  if (dewarpaGetDewarp(dewa, page_index) != NULL &&
+      dewarpaApplyDisparity(dewa, page_index, pix, 255, 0, 0, &result,
+                            NULL) != 0) {
+    pixDestroy(&result);
+  }
+  dewarpaDestroy(&dewa);
+  return result;
+}
+
+void DewarpModelIndex::Add(int page, unsigned char* data, size_t size) {
+  SVAutoLock lock(&mutex_);
+  // Pages come about in order, so models far behind this one are done with.
+  for (int i = models_.size() - 1; i >= 0; --i) {
+    if (models_[i].page < page - 2 * kMaxDewarpRefDistance) {
+      lept_free(models_[i].data);
+      models_.remove(i);
+    }
+  }
+  Model model = {page, data, size};
+  models_.push_back(model);
+}
+
+}  // namespace tesseract.
@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pagedewarp.h
+// Description: Straightening of the curled text lines of scanned pages.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_PAGEDEWARP_H_
+#define TESSERACT_API_PAGEDEWARP_H_
+
+#include <stddef.h>
+#include "genericvector.h"
+#include "platform.h"
+#include "svutil.h"
+
+struct Pix;
+
+namespace tesseract {
+
+// Keeps the leptonica dewarp models of the pages of a document, the
+// disparity that straightens their text lines, for tessedit_dewarp.
+// Models are built on a 2x reduced binary image of the page. A page with
+// too few long text lines for a model of its own borrows that of the
+// nearest page on the same side of the book, as facing pages of a bound
+// register curl the opposite way. Several TessBaseAPI recognizing the
+// pages of a document on different threads may share one index, and then
+// only borrow from pages already done.
+class TESS_LOCAL DewarpModelIndex {
+ public:
+  DewarpModelIndex() {}
+  ~DewarpModelIndex();
+
+  // Forgets every model, when a new document begins.
+  void Clear();
+
+  // Returns pix, page page_index of the document, with its text lines
+  // straightened, or NULL if there is no model for it or it fails.
+  Pix* Dewarp(Pix* pix, int page_index);
+
+ private:
+  struct Model {
+    int page;
+    unsigned char* data;  // As serialized by dewarpWriteMem.
+    size_t size;
+  };
+
+  // Adds the model of page, serialized in data, taking ownership of it.
+  void Add(int page, unsigned char* data, size_t size);
+
+  GenericVector<Model> models_;
+  SVMutex mutex_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_API_PAGEDEWARP_H_
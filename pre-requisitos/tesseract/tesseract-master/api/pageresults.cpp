@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pageresults.cpp
+// Description: The results of a page flattened into plain records, for
+//              renderers.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "pageresults.h"
+
+#include <memory>  // std::unique_ptr
+#include "resultiterator.h"
+
+namespace tesseract {
+
+static PageResultBox GetBox(const ResultIterator* it,
+                            PageIteratorLevel level) {
+  PageResultBox box = {0, 0, 0, 0};
+  it->BoundingBox(level, &box.left, &box.top, &box.right, &box.bottom);
+  return box;
+}
+
+static PageResultBaseline GetBaseline(const ResultIterator* it,
+                                      PageIteratorLevel level) {
+  PageResultBaseline baseline = {false, 0, 0, 0, 0};
+  baseline.ok = it->Baseline(level, &baseline.x1, &baseline.y1,
+                             &baseline.x2, &baseline.y2);
+  return baseline;
+}
+
+void PageResults::Build(ResultIterator* it) {
+  blocks.clear();
+  paras.clear();
+  lines.clear();
+  words.clear();
+  text.clear();
+  while (!it->Empty(RIL_BLOCK)) {
+    if (it->Empty(RIL_WORD)) {
+      it->Next(RIL_WORD);
+      continue;
+    }
+    if (it->IsAtBeginningOf(RIL_BLOCK)) {
+      PageResultBlock block;
+      block.box = GetBox(it, RIL_BLOCK);
+      it->Orientation(&block.orientation, &block.writing_direction,
+                      &block.textline_order, &block.deskew_angle);
+      blocks.push_back(block);
+    }
+    if (it->IsAtBeginningOf(RIL_PARA)) {
+      PageResultPara para;
+      para.box = GetBox(it, RIL_PARA);
+      para.is_ltr = it->ParagraphIsLtr();
+      para.lang = it->WordRecognitionLanguage();
+      paras.push_back(para);
+    }
+    if (it->IsAtBeginningOf(RIL_TEXTLINE)) {
+      PageResultLine line;
+      line.box = GetBox(it, RIL_TEXTLINE);
+      line.baseline = GetBaseline(it, RIL_TEXTLINE);
+      it->RowAttributes(&line.row_height, &line.descenders, &line.ascenders);
+      lines.push_back(line);
+    }
+
+    PageResultWord word;
+    word.box = GetBox(it, RIL_WORD);
+    word.baseline = GetBaseline(it, RIL_WORD);
+    word.confidence = it->Confidence(RIL_WORD);
+    word.block = blocks.size() - 1;
+    word.para = paras.size() - 1;
+    word.line = lines.size() - 1;
+    word.lang = it->WordRecognitionLanguage();
+    word.direction = it->WordDirection();
+    word.bold = word.italic = word.underlined = false;
+    word.monospace = word.serif = word.smallcaps = false;
+    word.font_name = it->WordFontAttributes(
+        &word.bold, &word.italic, &word.underlined, &word.monospace,
+        &word.serif, &word.smallcaps, &word.pointsize, &word.font_id);
+    // The text is that of the symbols, as the renderers always wrote it.
+    word.text_offset = text.size();
+    do {
+      const std::unique_ptr<const char[]> grapheme(
+          it->GetUTF8Text(RIL_SYMBOL));
+      if (grapheme != NULL) text += grapheme.get();
+      it->Next(RIL_SYMBOL);
+    } while (!it->Empty(RIL_BLOCK) && !it->IsAtBeginningOf(RIL_WORD));
+    word.text_length = text.size() - word.text_offset;
+    text.push_back('\0');
+    words.push_back(word);
+  }
+}
+
+}  // namespace tesseract.
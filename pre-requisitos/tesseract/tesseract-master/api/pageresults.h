@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pageresults.h
+// Description: The results of a page flattened into plain records, for
+//              renderers.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_PAGERESULTS_H_
+#define TESSERACT_API_PAGERESULTS_H_
+
+#include <string>
+#include <vector>
+#include "platform.h"
+#include "publictypes.h"
+#include "unichar.h"
+
+namespace tesseract {
+
+class ResultIterator;
+
+// A bounding box in the coordinates of the input image, top down.
+struct PageResultBox {
+  int left, top, right, bottom;
+};
+
+// A baseline from (x1, y1) to (x2, y2), valid only if ok.
+struct PageResultBaseline {
+  bool ok;
+  int x1, y1, x2, y2;
+};
+
+struct PageResultBlock {
+  PageResultBox box;
+  Orientation orientation;
+  WritingDirection writing_direction;
+  TextlineOrder textline_order;
+  float deskew_angle;
+};
+
+struct PageResultPara {
+  PageResultBox box;
+  bool is_ltr;
+  const char* lang;  // Language of its first word, or NULL.
+};
+
+struct PageResultLine {
+  PageResultBox box;
+  PageResultBaseline baseline;
+  float row_height;
+  float descenders;
+  float ascenders;
+};
+
+struct PageResultWord {
+  PageResultBox box;
+  PageResultBaseline baseline;
+  float confidence;
+  // Indices of the block, paragraph and line of the word.
+  int block;
+  int para;
+  int line;
+  // The UTF-8 text of the word starts at text_offset of PageResults::text,
+  // and is '\0' terminated.
+  int text_offset;
+  int text_length;
+  const char* lang;  // Language the word was recognized in, or NULL.
+  StrongScriptDirection direction;
+  // As given by LTRResultIterator::WordFontAttributes, with font_name NULL
+  // and the flags false if the word has no font.
+  const char* font_name;
+  int font_id;
+  int pointsize;
+  bool bold;
+  bool italic;
+  bool underlined;
+  bool monospace;
+  bool serif;
+  bool smallcaps;
+};
+
+// The blocks, paragraphs, lines and words of a recognized page, with their
+// final coordinates and text, in reading order. Walking a ResultIterator
+// works out the reading order and denormalizes a box for every call, and
+// the hOCR, TSV, PDF and binary renderers would each do it again for the
+// same page, so TessBaseAPI::GetPageResults walks it once into these
+// vectors, and the renderers read them instead. Empty blocks, such as
+// images, are left out. Names and languages point into the recognizer, so
+// the records are only valid as long as the results they came from.
+struct TESS_API PageResults {
+  // Replaces the records with those of the page it walks.
+  void Build(ResultIterator* it);
+
+  const char* WordText(const PageResultWord& word) const {
+    return text.c_str() + word.text_offset;
+  }
+  // Whether word i is the first one of its block, paragraph or line.
+  bool FirstWordInBlock(int i) const {
+    return i == 0 || words[i - 1].block != words[i].block;
+  }
+  bool FirstWordInPara(int i) const {
+    return i == 0 || words[i - 1].para != words[i].para;
+  }
+  bool FirstWordInLine(int i) const {
+    return i == 0 || words[i - 1].line != words[i].line;
+  }
+  // Whether word i is the last one of its line, paragraph or block.
+  bool LastWordInLine(int i) const {
+    return i + 1 == static_cast<int>(words.size()) ||
+        words[i + 1].line != words[i].line;
+  }
+  bool LastWordInPara(int i) const {
+    return i + 1 == static_cast<int>(words.size()) ||
+        words[i + 1].para != words[i].para;
+  }
+  bool LastWordInBlock(int i) const {
+    return i + 1 == static_cast<int>(words.size()) ||
+        words[i + 1].block != words[i].block;
+  }
+
+  std::vector<PageResultBlock> blocks;
+  std::vector<PageResultPara> paras;
+  std::vector<PageResultLine> lines;
+  std::vector<PageResultWord> words;
+  std::string text;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_API_PAGERESULTS_H_
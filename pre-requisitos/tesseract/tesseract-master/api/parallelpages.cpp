@@ -0,0 +1,316 @@
+///////////////////////////////////////////////////////////////////////
+// File:        parallelpages.cpp
+// Description: Page parallel recognition for TessBaseAPI::ProcessPages.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "parallelpages.h"
+
+#include <stdio.h>
+#include "allheaders.h"
+#include "baseapi.h"
+#include "params.h"
+#include "renderer.h"
+#include "tesseractclass.h"
+#include "tprintf.h"
+
+namespace tesseract {
+
+const int kMaxIntSize = 22;
+
+// Appends the names and current values of params to vars and values.
+static void CollectIntParams(const GenericVector<IntParam*>& params,
+                             GenericVector<STRING>* vars,
+                             GenericVector<STRING>* values) {
+  for (int i = 0; i < params.size(); ++i) {
+    STRING value;
+    value.add_str_int("", *params[i]);
+    vars->push_back(params[i]->name_str());
+    values->push_back(value);
+  }
+}
+
+static void CollectBoolParams(const GenericVector<BoolParam*>& params,
+                              GenericVector<STRING>* vars,
+                              GenericVector<STRING>* values) {
+  for (int i = 0; i < params.size(); ++i) {
+    vars->push_back(params[i]->name_str());
+    values->push_back(*params[i] ? "1" : "0");
+  }
+}
+
+static void CollectStringParams(const GenericVector<StringParam*>& params,
+                                GenericVector<STRING>* vars,
+                                GenericVector<STRING>* values) {
+  for (int i = 0; i < params.size(); ++i) {
+    vars->push_back(params[i]->name_str());
+    values->push_back(params[i]->string());
+  }
+}
+
+static void CollectDoubleParams(const GenericVector<DoubleParam*>& params,
+                                GenericVector<STRING>* vars,
+                                GenericVector<STRING>* values) {
+  for (int i = 0; i < params.size(); ++i) {
+    char value[64];
+    snprintf(value, sizeof(value), "%.17g", static_cast<double>(*params[i]));
+    vars->push_back(params[i]->name_str());
+    values->push_back(value);
+  }
+}
+
+int InitWorkerApi(TessBaseAPI* api, TessBaseAPI* worker) {
+  if (api->tesseract() == NULL) return -1;
+  // Every worker gets the current value of every member param, so the
+  // clones behave as api does after its configs and SetVariable calls.
+  GenericVector<STRING> vars, values;
+  const ParamsVectors* params = api->tesseract()->params();
+  CollectIntParams(params->int_params, &vars, &values);
+  CollectBoolParams(params->bool_params, &vars, &values);
+  CollectStringParams(params->string_params, &vars, &values);
+  CollectDoubleParams(params->double_params, &vars, &values);
+  // The workers already share the cores by pages, so unless told otherwise
+  // each recognizes its page on its own thread.
+  if (api->tesseract()->tessedit_intra_op_threads == 0) {
+    vars.push_back("tessedit_intra_op_threads");
+    values.push_back("1");
+  }
+  return worker->Init(api->GetDatapath(), api->GetInitLanguagesAsString(),
+                      api->oem(), NULL, 0, &vars, &values, false);
+}
+
+ParallelPageProcessor::ParallelPageProcessor(TessBaseAPI* api,
+                                             const char* retry_config,
+                                             int timeout_millisec,
+                                             TessResultRenderer* renderer)
+  : api_(api), retry_config_(retry_config),
+    timeout_millisec_(timeout_millisec), renderer_(renderer),
+    num_threads_(0), readahead_(0), idle_workers_(0), waiting_workers_(0),
+    max_queued_(0), max_waiting_(0), next_job_serial_(0),
+    next_render_serial_(0), failed_(false), running_(false) {
+}
+
+ParallelPageProcessor::~ParallelPageProcessor() {
+  Finish();
+}
+
+void ParallelPageProcessor::Start(int num_threads, int readahead) {
+  if (num_threads < 2 || running_) return;
+  if (retry_config_ != NULL && retry_config_[0] != '\0') {
+    tprintf("Warning: a retry config disables parallel pages\n");
+    return;
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    Worker* worker = new Worker;
+    worker->pool = this;
+    worker->api = new TessBaseAPI;
+    worker->waiting = false;
+    worker->serial = -1;
+    workers_.push_back(worker);
+    if (InitWorkerApi(api_, worker->api) != 0) {
+      tprintf("Warning: cannot start page workers, running sequentially\n");
+      DeleteWorkers();
+      return;
+    }
+    // A page is a near-duplicate of earlier pages of the document whichever
+    // worker recognized them.
+    worker->api->ShareDuplicatePages(api_);
+    worker->api->ShareDewarpModels(api_);
+  }
+  num_threads_ = num_threads;
+  readahead_ = MAX(readahead, 0);
+  for (int i = 0; i < num_threads + readahead_; ++i) free_slots_.Signal();
+  running_ = true;
+  for (int i = 0; i < workers_.size(); ++i)
+    SVSync::StartThread(WorkerThread, workers_[i]);
+}
+
+bool ParallelPageProcessor::AddPage(Pix* pix, int page_index,
+                                    const char* filename,
+                                    L_Compressed_Data* data,
+                                    const PdfPageGeometry* geometry) {
+  if (!running_) {
+    api_->SetInputImageData(data);
+    api_->SetInputPageGeometry(geometry);
+    bool r = api_->ProcessPage(pix, page_index, filename, retry_config_,
+                               timeout_millisec_, renderer_);
+    pixDestroy(&pix);
+    return r;
+  }
+  free_slots_.Wait();
+  PageJob job;
+  job.pix = pix;
+  job.pixc = NULL;
+  job.data = data;
+  job.has_geometry = geometry != NULL;
+  if (geometry != NULL) job.geometry = *geometry;
+  job.page_index = page_index;
+  job.filename = filename;
+  // Pages beyond the idle workers wait for one to finish, possibly for
+  // long with a deep readahead, so they are held compressed meanwhile.
+  mutex_.Lock();
+  bool wait = readahead_ > 0 && jobs_.size() >= idle_workers_;
+  mutex_.Unlock();
+  if (wait) CompressJob(&job);
+  mutex_.Lock();
+  job.serial = next_job_serial_++;
+  jobs_.push_back(job);
+  max_queued_ = MAX(max_queued_, jobs_.size());
+  bool failed = failed_;
+  mutex_.Unlock();
+  jobs_available_.Signal();
+  return !failed;
+}
+
+bool ParallelPageProcessor::Finish() {
+  if (running_) {
+    PageJob stop;
+    stop.pix = NULL;
+    stop.pixc = NULL;
+    stop.data = NULL;
+    stop.has_geometry = false;
+    stop.page_index = -1;
+    stop.serial = -1;
+    mutex_.Lock();
+    for (int i = 0; i < workers_.size(); ++i) jobs_.push_back(stop);
+    mutex_.Unlock();
+    for (int i = 0; i < workers_.size(); ++i) jobs_available_.Signal();
+    for (int i = 0; i < workers_.size(); ++i) worker_done_.Wait();
+    running_ = false;
+    DeleteWorkers();
+  }
+  return !failed_;
+}
+
+void ParallelPageProcessor::CompressJob(PageJob* job) {
+  int depth = pixGetDepth(job->pix);
+  // 16 bpp would come back as 8 bpp from png, so it is kept as it is.
+  if (depth == 16) return;
+  // Leptonica may be built without tiff, and then binary pages go to png.
+  if (depth == 1 && pixGetColormap(job->pix) == NULL)
+    job->pixc = pixcompCreateFromPix(job->pix, IFF_TIFF_G4);
+  // Gray and color pages are only held until a worker is free, so they
+  // are encoded for speed rather than size.
+  if (job->pixc == NULL) {
+    pixSetZlibFastEncode(job->pix);
+    job->pixc = pixcompCreateFromPix(job->pix, IFF_PNG);
+  }
+  if (job->pixc != NULL) pixDestroy(&job->pix);
+}
+
+void* ParallelPageProcessor::WorkerThread(void* arg) {
+  Worker* worker = static_cast<Worker*>(arg);
+  worker->pool->RunWorker(worker);
+  return NULL;
+}
+
+void ParallelPageProcessor::RunWorker(Worker* worker) {
+  while (true) {
+    mutex_.Lock();
+    ++idle_workers_;
+    mutex_.Unlock();
+    jobs_available_.Wait();
+    mutex_.Lock();
+    --idle_workers_;
+    PageJob job = jobs_[0];
+    jobs_.remove(0);
+    worker->serial = job.serial;
+    bool failed = failed_;
+    mutex_.Unlock();
+    if (job.pix == NULL && job.pixc == NULL) break;
+    if (job.pixc != NULL) {
+      job.pix = pixCreateFromPixcomp(job.pixc);
+      pixcompDestroy(&job.pixc);
+      if (job.pix == NULL)
+        tprintf("Error: cannot decompress page %d\n", job.page_index);
+    }
+    // Once a page has failed the rest are only passed through, so that
+    // waiting workers get their turn and the pool drains.
+    bool ok = !failed && job.pix != NULL;
+    if (ok) {
+      char page_str[kMaxIntSize];
+      snprintf(page_str, kMaxIntSize - 1, "%d", job.page_index);
+      worker->api->SetVariable("applybox_page", page_str);
+      // The page is looked up in the result cache with what the renderer
+      // will see, and skips recognition on a hit.
+      bool cached = false;
+      if (renderer_ != NULL) {
+        worker->api->SetInputName(job.filename.string());
+        worker->api->SetBorrowedImage(job.pix);
+        worker->api->SetInputPageGeometry(job.has_geometry ? &job.geometry
+                                                           : NULL);
+        cached = worker->api->BeginCachedPage(renderer_);
+      }
+      if (!cached) {
+        ok = worker->api->ProcessPage(job.pix, job.page_index,
+                                      job.filename.string(), NULL,
+                                      timeout_millisec_, NULL);
+      }
+    }
+    WaitForTurn(worker);
+    if (ok && renderer_ != NULL) {
+      // ProcessPage drops the input image data and page geometry when it
+      // returns, so they are only handed over for the renderer.
+      worker->api->SetInputImageData(job.data);
+      job.data = NULL;
+      worker->api->SetInputPageGeometry(job.has_geometry ? &job.geometry
+                                                         : NULL);
+      ok = renderer_->AddImage(worker->api);
+    }
+    EndTurn(ok);
+    worker->api->EndCachedPage(ok);
+    worker->api->SetInputImageData(NULL);
+    worker->api->SetInputPageGeometry(NULL);
+    l_CIDataDestroy(&job.data);
+    pixDestroy(&job.pix);
+    free_slots_.Signal();
+  }
+  worker_done_.Signal();
+}
+
+void ParallelPageProcessor::WaitForTurn(Worker* worker) {
+  mutex_.Lock();
+  if (next_render_serial_ == worker->serial) {
+    mutex_.Unlock();
+    return;
+  }
+  worker->waiting = true;
+  max_waiting_ = MAX(max_waiting_, ++waiting_workers_);
+  mutex_.Unlock();
+  worker->turn.Wait();
+}
+
+void ParallelPageProcessor::EndTurn(bool ok) {
+  SVAutoLock lock(&mutex_);
+  if (!ok) failed_ = true;
+  ++next_render_serial_;
+  for (int i = 0; i < workers_.size(); ++i) {
+    Worker* worker = workers_[i];
+    if (worker->waiting && worker->serial == next_render_serial_) {
+      worker->waiting = false;
+      --waiting_workers_;
+      worker->turn.Signal();
+    }
+  }
+}
+
+void ParallelPageProcessor::DeleteWorkers() {
+  for (int i = 0; i < workers_.size(); ++i) {
+    delete workers_[i]->api;
+    delete workers_[i];
+  }
+  workers_.clear();
+}
+
+}  // namespace tesseract.
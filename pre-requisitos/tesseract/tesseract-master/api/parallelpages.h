@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////
+// File:        parallelpages.h
+// Description: Page parallel recognition for TessBaseAPI::ProcessPages.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_PARALLELPAGES_H_
+#define TESSERACT_API_PARALLELPAGES_H_
+
+#include "baseapi.h"
+#include "genericvector.h"
+#include "platform.h"
+#include "strngs.h"
+#include "svutil.h"
+
+struct Pix;
+struct PixComp;
+struct L_Compressed_Data;
+
+namespace tesseract {
+
+class TessResultRenderer;
+
+// Initializes worker with the languages, engine mode and current params of
+// api, so that it recognizes as api does, but on a single thread per page
+// unless tessedit_intra_op_threads is set. Returns the result of Init, or
+// -1 if api was never initialized.
+TESS_LOCAL int InitWorkerApi(TessBaseAPI* api, TessBaseAPI* worker);
+
+// Runs the pages of a document through ProcessPage, either directly on the
+// given api, or spread over a pool of worker threads, each owning its own
+// TessBaseAPI initialized like the given one. Workers may finish in any
+// order, but the renderer always receives the pages in the order they
+// were added, and only one AddImage call runs at a time.
+class TESS_LOCAL ParallelPageProcessor {
+ public:
+  ParallelPageProcessor(TessBaseAPI* api, const char* retry_config,
+                        int timeout_millisec, TessResultRenderer* renderer);
+  // Waits for any pages still in flight.
+  ~ParallelPageProcessor();
+
+  // Starts num_threads workers, with room for readahead more pages
+  // waiting for them. With fewer than two threads, a retry config (which
+  // is applied through a fixed temporary file), or if a worker fails to
+  // initialize, pages are processed directly by api.
+  void Start(int num_threads, int readahead = 0);
+  // Processes pix, taking ownership of it, as page page_index of filename.
+  // data is the optional original compressed form of pix (see
+  // TessBaseAPI::SetInputImageData), also owned from here on, and
+  // geometry the optional PDF page it came from (copied).
+  // In parallel mode this only queues the page, blocking while all workers
+  // are busy and the readahead is full. A page that has to wait is held
+  // compressed. Returns false once any page has failed.
+  bool AddPage(Pix* pix, int page_index, const char* filename,
+               L_Compressed_Data* data = NULL,
+               const PdfPageGeometry* geometry = NULL);
+  // Waits until all added pages are rendered. Returns false if any failed.
+  bool Finish();
+
+  // Queue high-water marks, for tessedit_page_pipeline_stats: the most
+  // pages waiting for a worker, and the most recognized pages waiting for
+  // their turn to render, at once.
+  int max_queued() const { return max_queued_; }
+  int max_waiting() const { return max_waiting_; }
+  // The number of workers started, 0 if pages were processed directly.
+  int num_threads() const { return num_threads_; }
+  int readahead() const { return readahead_; }
+
+ private:
+  struct PageJob {
+    Pix* pix;         // NULL asks the worker to exit, unless pixc is set.
+    PixComp* pixc;    // Compressed page while it waits for a worker.
+    L_Compressed_Data* data;
+    PdfPageGeometry geometry;
+    bool has_geometry;
+    int page_index;
+    int serial;       // Order in which the page must be rendered.
+    STRING filename;
+  };
+  struct Worker {
+    ParallelPageProcessor* pool;
+    TessBaseAPI* api;
+    SVSemaphore turn;  // Signalled when the worker may render.
+    bool waiting;      // The worker is blocked on turn.
+    int serial;        // Serial of the page the worker holds.
+  };
+
+  // Compresses the page of job into job->pixc, losslessly and fast, and
+  // destroys its pix. Keeps the pix if it can't be compressed.
+  static void CompressJob(PageJob* job);
+  static void* WorkerThread(void* arg);
+  void RunWorker(Worker* worker);
+  // Blocks until the page held by worker is the next one to render.
+  void WaitForTurn(Worker* worker);
+  // Passes the turn to the next page, recording a failure if !ok.
+  void EndTurn(bool ok);
+  // Deletes the worker apis.
+  void DeleteWorkers();
+
+  TessBaseAPI* api_;
+  const char* retry_config_;
+  int timeout_millisec_;
+  TessResultRenderer* renderer_;
+
+  GenericVector<Worker*> workers_;
+  GenericVector<PageJob> jobs_;  // FIFO of pages waiting for a worker.
+  SVMutex mutex_;                // Guards jobs_, the counters and failed_.
+  SVSemaphore jobs_available_;
+  SVSemaphore free_slots_;       // Limits the number of pages in flight.
+  SVSemaphore worker_done_;
+  int num_threads_;
+  int readahead_;                // Pages allowed in flight beyond workers.
+  int idle_workers_;             // Workers waiting for a job.
+  int waiting_workers_;          // Workers waiting for their turn.
+  int max_queued_;
+  int max_waiting_;
+  int next_job_serial_;
+  int next_render_serial_;
+  bool failed_;
+  bool running_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_API_PARALLELPAGES_H_
@@ -0,0 +1,929 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pdfreader.cpp
+// Description: PDF input for TessBaseAPI, using poppler.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+// Include automatically generated configuration file if running autoconf.
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif
+
+#include "pdfreader.h"
+
+#include <string.h>
+#include <map>
+#include "allheaders.h"
+#include "baseapi.h"
+
+#ifdef HAVE_POPPLER
+#include "GlobalParams.h"
+#include "GfxState.h"
+#include "OutputDev.h"
+#include "PDFDoc.h"
+#include "Page.h"
+#include "SplashOutputDev.h"
+#include "Stream.h"
+#include "Trace.h"
+#include "splash/SplashBitmap.h"
+#endif  // HAVE_POPPLER
+
+#include "tprintf.h"
+#include "tracing.h"
+
+namespace tesseract {
+
+#ifdef HAVE_POPPLER
+
+// An image is taken as the whole page when it covers at least this
+// fraction of the page on both axes.
+const double kMinPageCoverage = 0.95;
+// Resolutions outside this range are not believable for a scan, and the
+// page is rendered instead.
+const int kMinImageResolution = 70;
+const int kMaxImageResolution = 1200;
+
+// poppler keeps its configuration in a process wide object, which must
+// exist before the first document is opened. Its class name is shadowed
+// by tesseract's GlobalParams() function, hence the elaborated type.
+static void InitPopplerGlobals() {
+  static SVMutex globals_mutex;
+  globals_mutex.Lock();
+  if (globalParams == NULL) {
+    globalParams = new class GlobalParams();
+    globalParams->setErrQuiet(gTrue);
+  }
+  globals_mutex.Unlock();
+}
+
+// Opens filename, or the in-memory document data/size when data is not
+// NULL. Returns NULL on failure.
+static PDFDoc* OpenDocument(const char* filename, const unsigned char* data,
+                            size_t size) {
+  InitPopplerGlobals();
+  PDFDoc* doc;
+  if (data != NULL) {
+    Object dict;
+    dict.initNull();
+    MemStream* str = new MemStream(
+        reinterpret_cast<char*>(const_cast<unsigned char*>(data)), 0, size,
+        &dict);
+    doc = new PDFDoc(str, NULL, NULL);
+  } else {
+    doc = new PDFDoc(new GooString(filename), NULL, NULL);
+  }
+  if (!doc->isOk()) {
+    tprintf("Error: cannot open pdf %s (poppler error %d)\n", filename,
+            doc->getErrorCode());
+    delete doc;
+    return NULL;
+  }
+  return doc;
+}
+
+// Returns the sample value that paints black in a 1 bit image.
+static int BlackSample(GfxImageColorMap* color_map) {
+  Guchar sample = 1;
+  GfxGray level;
+  color_map->getGray(&sample, &level);
+  return colToByte(level) < 128 ? 1 : 0;
+}
+
+// Returns the EncodedByteAlign parameter of a CCITTFaxDecode stream,
+// which poppler does not give away.
+static bool EncodedByteAlign(Stream* str) {
+  bool byte_align = false;
+  Object parms;
+  str->getDict()->lookup("DecodeParms", &parms);
+  if (parms.isNull()) {
+    parms.free();
+    str->getDict()->lookup("DP", &parms);
+  }
+  if (parms.isDict()) {
+    Object align;
+    parms.dictLookup("EncodedByteAlign", &align);
+    byte_align = align.isBool() && align.getBool();
+    align.free();
+  }
+  parms.free();
+  return byte_align;
+}
+
+// Decodes a 1 bit CCITT image with leptonica straight from its coded
+// bytes, which is much faster than poppler's pixel by pixel ImageStream.
+// Returns NULL if the image is not one, or cannot be decoded that way.
+static Pix* CcittToPix(Stream* str, int width, int height,
+                       GfxImageColorMap* color_map) {
+  if (str->getKind() != strCCITTFax || color_map->getNumPixelComps() != 1 ||
+      color_map->getBits() != 1)
+    return NULL;
+  Stream* raw = str->getNextStream();
+  if (raw == NULL || raw->getBaseStream() != raw) return NULL;
+  CCITTFaxStream* ccitt = static_cast<CCITTFaxStream*>(str);
+  if (ccitt->getColumns() != width) return NULL;
+  GooString bytes;
+  raw->fillGooString(&bytes);
+  raw->close();
+  if (bytes.getLength() == 0) return NULL;
+  Pix* pix = pixReadMemCcitt(
+      reinterpret_cast<const l_uint8*>(bytes.getCString()),
+      bytes.getLength(), width, height, ccitt->getEncoding(),
+      EncodedByteAlign(str));
+  // The decoder sets the CCITT black runs, whose sample value depends on
+  // BlackIs1, and the Decode array may swap the colors again.
+  int ccitt_black = ccitt->getBlackIs1() ? 1 : 0;
+  if (pix != NULL && ccitt_black != BlackSample(color_map))
+    pixInvert(pix, pix);
+  return pix;
+}
+
+// Converts one image of a PDF page into a Pix, keeping 1 bit and gray
+// images at their own depth.
+static Pix* ImageToPix(Stream* str, int width, int height,
+                       GfxImageColorMap* color_map) {
+  int comps = color_map->getNumPixelComps();
+  int bits = color_map->getBits();
+  bool mono = comps == 1 && bits == 1;
+  bool gray = !mono && color_map->getColorSpace()->getNComps() == 1;
+  Pix* pix = pixCreate(width, height, mono ? 1 : (gray ? 8 : 32));
+  if (pix == NULL) return NULL;
+  int black_sample = mono ? BlackSample(color_map) : 0;
+  ImageStream* img_str = new ImageStream(str, width, comps, bits);
+  img_str->reset();
+  l_uint32* data = pixGetData(pix);
+  int wpl = pixGetWpl(pix);
+  unsigned int* rgb_line = gray || mono ? NULL : new unsigned int[width];
+  Guchar* gray_line = gray ? new Guchar[width] : NULL;
+  for (int y = 0; y < height; ++y) {
+    Guchar* line = img_str->getLine();
+    if (line == NULL) break;
+    l_uint32* pix_line = data + y * wpl;
+    if (mono) {
+      for (int x = 0; x < width; ++x) {
+        if (line[x] == black_sample) SET_DATA_BIT(pix_line, x);
+      }
+    } else if (gray) {
+      color_map->getGrayLine(line, gray_line, width);
+      for (int x = 0; x < width; ++x)
+        SET_DATA_BYTE(pix_line, x, gray_line[x]);
+    } else {
+      color_map->getRGBLine(line, rgb_line, width);
+      for (int x = 0; x < width; ++x)
+        pix_line[x] = rgb_line[x] << 8;
+    }
+  }
+  delete [] rgb_line;
+  delete [] gray_line;
+  img_str->close();
+  delete img_str;
+  return pix;
+}
+
+// Returns the undecoded stream of a JPEG or CCITT G4 image, if it can be
+// embedded as it is in the PDF written by TessPDFRenderer: no other filter
+// or encryption on top, a plain gray or RGB color space, default decode
+// ranges and no CCITT parameters that the renderer does not write.
+// Returns NULL otherwise.
+static L_COMP_DATA* PassThroughData(Stream* str, int width, int height,
+                                    GfxImageColorMap* color_map) {
+  Stream* raw = str->getNextStream();
+  if (raw == NULL || raw->getBaseStream() != raw) return NULL;
+  GfxColorSpaceMode mode = color_map->getColorSpace()->getMode();
+  if (mode != csDeviceGray && mode != csCalGray && mode != csDeviceRGB &&
+      mode != csCalRGB && mode != csICCBased)
+    return NULL;
+  int comps = color_map->getNumPixelComps();
+  if (comps != 1 && comps != 3) return NULL;
+  for (int i = 0; i < comps; ++i) {
+    if (color_map->getDecodeLow(i) != 0.0 ||
+        color_map->getDecodeHigh(i) != 1.0)
+      return NULL;
+  }
+  int type;
+  if (str->getKind() == strDCT) {
+    if (color_map->getBits() != 8) return NULL;
+    type = L_JPEG_ENCODE;
+  } else if (str->getKind() == strCCITTFax) {
+    CCITTFaxStream* ccitt = static_cast<CCITTFaxStream*>(str);
+    if (comps != 1 || ccitt->getEncoding() >= 0 || ccitt->getEndOfLine() ||
+        ccitt->getBlackIs1() || ccitt->getColumns() != width)
+      return NULL;
+    if (EncodedByteAlign(str)) return NULL;
+    type = L_G4_ENCODE;
+  } else {
+    return NULL;
+  }
+  GooString bytes;
+  raw->fillGooString(&bytes);
+  raw->close();
+  if (bytes.getLength() == 0) return NULL;
+  L_COMP_DATA* cid =
+      static_cast<L_COMP_DATA*>(LEPT_CALLOC(1, sizeof(L_COMP_DATA)));
+  cid->datacomp = static_cast<l_uint8*>(LEPT_MALLOC(bytes.getLength()));
+  memcpy(cid->datacomp, bytes.getCString(), bytes.getLength());
+  cid->nbytescomp = bytes.getLength();
+  cid->type = type;
+  cid->w = width;
+  cid->h = height;
+  cid->bps = color_map->getBits();
+  cid->spp = comps;
+  return cid;
+}
+
+// Output device that watches what a page draws at 72 dpi, and keeps the
+// page image when the page turns out to contain a single upright image
+// covering it and nothing else visible. Invisible text (render mode 3,
+// as written by our own pdf renderer) does not count.
+class ImageCaptureDev : public OutputDev {
+ public:
+  // Keeps the undecoded image data as well when want_data is true.
+  ImageCaptureDev(double page_width, double page_height, bool want_data)
+    : page_width_(page_width), page_height_(page_height),
+      want_data_(want_data), pix_(NULL), data_(NULL), resolution_(0),
+      rejected_(false) {}
+  virtual ~ImageCaptureDev() {
+    pixDestroy(&pix_);
+    l_CIDataDestroy(&data_);
+  }
+
+  virtual GBool upsideDown() { return gTrue; }
+  virtual GBool useDrawChar() { return gTrue; }
+  virtual GBool interpretType3Chars() { return gFalse; }
+
+  virtual void stroke(GfxState* state) { rejected_ = true; }
+  virtual void fill(GfxState* state) { rejected_ = true; }
+  virtual void eoFill(GfxState* state) { rejected_ = true; }
+  virtual void drawChar(GfxState* state, double x, double y,
+                        double dx, double dy,
+                        double originX, double originY,
+                        CharCode code, int nBytes, Unicode* u, int uLen) {
+    if (state->getRender() != 3) rejected_ = true;
+  }
+  virtual void drawImageMask(GfxState* state, Object* ref, Stream* str,
+                             int width, int height, GBool invert,
+                             GBool interpolate, GBool inlineImg) {
+    rejected_ = true;
+    OutputDev::drawImageMask(state, ref, str, width, height, invert,
+                             interpolate, inlineImg);
+  }
+  virtual void drawImage(GfxState* state, Object* ref, Stream* str,
+                         int width, int height, GfxImageColorMap* color_map,
+                         GBool interpolate, int* mask_colors,
+                         GBool inlineImg) {
+    bool take = !rejected_ && pix_ == NULL && mask_colors == NULL &&
+                IsPageImage(state, width);
+    if (take) {
+      pix_ = CcittToPix(str, width, height, color_map);
+      if (pix_ == NULL) pix_ = ImageToPix(str, width, height, color_map);
+      if (pix_ != NULL && want_data_ && !inlineImg)
+        data_ = PassThroughData(str, width, height, color_map);
+    }
+    if (pix_ == NULL || !take) {
+      rejected_ = true;
+      // Skips the data of an inline image.
+      OutputDev::drawImage(state, ref, str, width, height, color_map,
+                           interpolate, mask_colors, inlineImg);
+    }
+  }
+  virtual void drawMaskedImage(GfxState* state, Object* ref, Stream* str,
+                               int width, int height,
+                               GfxImageColorMap* color_map, GBool interpolate,
+                               Stream* mask_str, int mask_width,
+                               int mask_height, GBool mask_invert,
+                               GBool mask_interpolate) {
+    rejected_ = true;
+  }
+  virtual void drawSoftMaskedImage(GfxState* state, Object* ref, Stream* str,
+                                   int width, int height,
+                                   GfxImageColorMap* color_map,
+                                   GBool interpolate, Stream* mask_str,
+                                   int mask_width, int mask_height,
+                                   GfxImageColorMap* mask_color_map,
+                                   GBool mask_interpolate) {
+    rejected_ = true;
+  }
+
+  // Gives away the captured image and its undecoded data, or NULL if the
+  // page must be rendered.
+  Pix* TakeImage(L_COMP_DATA** data) {
+    if (rejected_ || pix_ == NULL) return NULL;
+    Pix* pix = pix_;
+    pix_ = NULL;
+    pixSetResolution(pix, resolution_, resolution_);
+    if (data != NULL) {
+      *data = data_;
+      data_ = NULL;
+    }
+    return pix;
+  }
+
+  static GBool AbortCheck(void* data) {
+    return static_cast<ImageCaptureDev*>(data)->rejected_;
+  }
+
+ private:
+  // Returns true if the image about to be drawn is upright, not mirrored
+  // and covers the page, and records its resolution.
+  bool IsPageImage(GfxState* state, int width) {
+    double* ctm = state->getCTM();
+    // The device is upside down, so an upright image has a negative
+    // vertical scale.
+    if (ctm[1] != 0.0 || ctm[2] != 0.0 || ctm[0] <= 0.0 || ctm[3] >= 0.0)
+      return false;
+    if (ctm[0] < page_width_ * kMinPageCoverage ||
+        -ctm[3] < page_height_ * kMinPageCoverage)
+      return false;
+    resolution_ = static_cast<int>(width * 72.0 / ctm[0] + 0.5);
+    return resolution_ >= kMinImageResolution &&
+           resolution_ <= kMaxImageResolution;
+  }
+
+  double page_width_;
+  double page_height_;
+  bool want_data_;
+  Pix* pix_;
+  L_COMP_DATA* data_;
+  int resolution_;
+  bool rejected_;
+};
+
+PdfPageReader::PdfPageReader() : doc_(NULL) {
+}
+
+PdfPageReader::~PdfPageReader() {
+  delete doc_;
+}
+
+bool PdfPageReader::Open(const char* filename, const unsigned char* data,
+                         size_t size) {
+  delete doc_;
+  doc_ = OpenDocument(filename, data, size);
+  return doc_ != NULL;
+}
+
+int PdfPageReader::NumPages() const {
+  return doc_ != NULL ? doc_->getNumPages() : 0;
+}
+
+Pix* PdfPageReader::GetPage(int page_index, L_COMP_DATA** data) {
+  if (data != NULL) *data = NULL;
+  if (page_index < 0 || page_index >= NumPages()) return NULL;
+  int page = page_index + 1;
+  Pix* pix = ExtractPageImage(page, data);
+  if (pix == NULL) pix = RenderPage(page);
+  return pix;
+}
+
+bool PdfPageReader::GetPageGeometry(int page_index,
+                                    PdfPageGeometry* geometry) const {
+  if (page_index < 0 || page_index >= NumPages()) return false;
+  Page* page = doc_->getPage(page_index + 1);
+  if (page == NULL) return false;
+  const PDFRectangle* media_box = page->getMediaBox();
+  const PDFRectangle* crop_box = page->getCropBox();
+  geometry->media_box[0] = media_box->x1;
+  geometry->media_box[1] = media_box->y1;
+  geometry->media_box[2] = media_box->x2;
+  geometry->media_box[3] = media_box->y2;
+  geometry->crop_box[0] = crop_box->x1;
+  geometry->crop_box[1] = crop_box->y1;
+  geometry->crop_box[2] = crop_box->x2;
+  geometry->crop_box[3] = crop_box->y2;
+  geometry->rotate = page->getRotate();
+  geometry->source = NULL;
+  geometry->page_index = page_index;
+  return true;
+}
+
+Pix* PdfPageReader::ExtractPageImage(int page, L_COMP_DATA** data) {
+  // The page is drawn with its /Rotate undone, so that the image is found
+  // upright in the unrotated crop box, and is then turned in memory to show
+  // the page as displayed, which is what RenderPage gives as well.
+  int rotate = ((doc_->getPageRotate(page) % 360) + 360) % 360;
+  if (rotate % 90 != 0) return NULL;
+  ImageCaptureDev dev(doc_->getPageCropWidth(page),
+                      doc_->getPageCropHeight(page),
+                      data != NULL && rotate == 0);
+  doc_->displayPage(&dev, page, 72, 72, (360 - rotate) % 360, gFalse, gTrue,
+                    gFalse, &ImageCaptureDev::AbortCheck, &dev);
+  Pix* pix = dev.TakeImage(data);
+  if (pix != NULL && rotate != 0) {
+    // The undecoded data still holds the unrotated image, so none is kept.
+    Pix* upright = pixRotateOrth(pix, rotate / 90);
+    pixDestroy(&pix);
+    pix = upright;
+  }
+  return pix;
+}
+
+Pix* PdfPageReader::RenderPage(int page) {
+  SplashColor paper_color;
+  paper_color[0] = paper_color[1] = paper_color[2] = 0xff;
+  SplashOutputDev dev(splashModeRGB8, 4, gFalse, paper_color);
+  dev.startDoc(doc_);
+  doc_->displayPage(&dev, page, kRenderResolution, kRenderResolution, 0,
+                    gFalse, gTrue, gFalse);
+  SplashBitmap* bitmap = dev.getBitmap();
+  int width = bitmap->getWidth();
+  int height = bitmap->getHeight();
+  Pix* pix = pixCreate(width, height, 32);
+  if (pix == NULL) return NULL;
+  l_uint32* data = pixGetData(pix);
+  int wpl = pixGetWpl(pix);
+  const Guchar* src = bitmap->getDataPtr();
+  for (int y = 0; y < height; ++y, src += bitmap->getRowSize()) {
+    l_uint32* pix_line = data + y * wpl;
+    const Guchar* p = src;
+    for (int x = 0; x < width; ++x, p += 3)
+      composeRGBPixel(p[0], p[1], p[2], pix_line + x);
+  }
+  pixSetResolution(pix, kRenderResolution, kRenderResolution);
+  return pix;
+}
+
+// Writes objects of a PDF document for another PDF file. The indirect
+// objects they refer to get new numbers, and are copied in turn.
+class ObjectCopier {
+ public:
+  ObjectCopier(XRef* xref, Ref page_ref, long int page_objnum,
+               long int first_objnum)
+    : xref_(xref), page_ref_(page_ref), page_objnum_(page_objnum),
+      next_objnum_(first_objnum) {}
+
+  // Appends obj, a direct object, to out.
+  void Write(Object* obj, std::string* out) {
+    char buf[64];
+    switch (obj->getType()) {
+      case objBool:
+        *out += obj->getBool() ? "true" : "false";
+        break;
+      case objInt:
+        snprintf(buf, sizeof(buf), "%d", obj->getInt());
+        *out += buf;
+        break;
+      case objInt64:
+        snprintf(buf, sizeof(buf), "%lld", obj->getInt64());
+        *out += buf;
+        break;
+      case objReal:
+        WriteReal(obj->getReal(), out);
+        break;
+      case objString:
+        WriteString(obj->getString(), out);
+        break;
+      case objName:
+        WriteName(obj->getName(), out);
+        break;
+      case objArray:
+        *out += "[";
+        for (int i = 0; i < obj->arrayGetLength(); ++i) {
+          Object item;
+          if (i > 0) *out += " ";
+          Write(obj->arrayGetNF(i, &item), out);
+          item.free();
+        }
+        *out += "]";
+        break;
+      case objDict:
+        *out += "<<\n";
+        WriteEntries(obj->getDict(), NULL, out);
+        *out += ">>";
+        break;
+      case objRef: {
+        long int objnum = Renumber(obj->getRef());
+        if (objnum > 0) {
+          snprintf(buf, sizeof(buf), "%ld 0 R", objnum);
+          *out += buf;
+        } else {
+          *out += "null";
+        }
+        break;
+      }
+      default:  // A stream is only ever an indirect object.
+        *out += "null";
+        break;
+    }
+  }
+
+  // Appends the entries of dict but skip, one per line. poppler's Dict is
+  // shadowed by tesseract's.
+  void WriteEntries(::Dict* dict, const char* skip, std::string* out) {
+    for (int i = 0; i < dict->getLength(); ++i) {
+      const char* key = dict->getKey(i);
+      if (skip != NULL && strcmp(key, skip) == 0) continue;
+      Object value;
+      WriteName(key, out);
+      *out += " ";
+      Write(dict->getValNF(i, &value), out);
+      *out += "\n";
+      value.free();
+    }
+  }
+
+  // Returns the new number of the indirect object ref, which CopyReferred
+  // copies. Returns 0 for another page or a node of the page tree, which
+  // are not copied.
+  long int Renumber(Ref ref) {
+    std::pair<int, int> key(ref.num, ref.gen);
+    std::map<std::pair<int, int>, long int>::iterator it = numbers_.find(key);
+    if (it != numbers_.end()) return it->second;
+    long int objnum = 0;
+    if (ref.num == page_ref_.num && ref.gen == page_ref_.gen) {
+      objnum = page_objnum_;
+    } else {
+      Object obj;
+      xref_->fetch(ref.num, ref.gen, &obj);
+      if (!obj.isDict("Page") && !obj.isDict("Pages") &&
+          !obj.isDict("Catalog")) {
+        objnum = next_objnum_++;
+        queue_.push_back(ref);
+      }
+      obj.free();
+    }
+    numbers_[key] = objnum;
+    return objnum;
+  }
+
+  // Appends to objects the objects numbered by Renumber so far, in the
+  // order of their numbers, and then those they refer to.
+  void CopyReferred(GenericVector<std::string>* objects) {
+    for (int i = 0; i < queue_.size(); ++i) {
+      Ref ref = queue_[i];
+      char buf[64];
+      snprintf(buf, sizeof(buf), "%ld 0 obj\n",
+               numbers_[std::make_pair(ref.num, ref.gen)]);
+      std::string text(buf);
+      Object obj;
+      xref_->fetch(ref.num, ref.gen, &obj);
+      if (obj.isStream()) {
+        std::string data;
+        ReadUndecoded(obj.getStream(), &data);
+        text += "<<\n";
+        WriteEntries(obj.streamGetDict(), "Length", &text);
+        AppendStreamData(data, &text);
+      } else {
+        Write(&obj, &text);
+        text += "\nendobj\n";
+      }
+      obj.free();
+      objects->push_back(text);
+    }
+  }
+
+  // Reads the data of str as stored in the file, still filtered, but
+  // decrypted.
+  static void ReadUndecoded(Stream* str, std::string* data) {
+    Stream* raw = str->getUndecodedStream();
+    Guchar buf[4096];
+    int n;
+    raw->reset();
+    while ((n = raw->doGetChars(sizeof(buf), buf)) > 0)
+      data->append(reinterpret_cast<char*>(buf), n);
+    raw->close();
+  }
+
+  // Ends a stream object whose dictionary was opened and filled but for its
+  // /Length.
+  static void AppendStreamData(const std::string& data, std::string* out) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "/Length %lu\n>>\nstream\n",
+             static_cast<unsigned long>(data.size()));
+    *out += buf;
+    *out += data;
+    *out += "\nendstream\nendobj\n";
+  }
+
+ private:
+  // Writes value without an exponent, which PDF does not have.
+  static void WriteReal(double value, std::string* out) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.6f", value);
+    int len = strlen(buf);
+    while (buf[len - 1] == '0') --len;
+    if (buf[len - 1] == '.') --len;
+    out->append(buf, len);
+  }
+
+  static void WriteString(GooString* str, std::string* out) {
+    static const char kHex[] = "0123456789abcdef";
+    *out += "<";
+    for (int i = 0; i < str->getLength(); ++i) {
+      unsigned char c = str->getChar(i);
+      *out += kHex[c >> 4];
+      *out += kHex[c & 15];
+    }
+    *out += ">";
+  }
+
+  // Escapes delimiters and anything but printable ASCII as #xx.
+  static void WriteName(const char* name, std::string* out) {
+    *out += "/";
+    for (const char* p = name; *p != '\0'; ++p) {
+      unsigned char c = *p;
+      if (c <= ' ' || c > '~' || strchr("#()<>[]{}/%", c) != NULL) {
+        char buf[4];
+        snprintf(buf, sizeof(buf), "#%02x", c);
+        *out += buf;
+      } else {
+        *out += c;
+      }
+    }
+  }
+
+  XRef* xref_;
+  Ref page_ref_;
+  long int page_objnum_;
+  long int next_objnum_;
+  std::map<std::pair<int, int>, long int> numbers_;
+  GenericVector<Ref> queue_;  // Renumbered objects, in the order of numbers.
+};
+
+PdfPageCopier::PdfPageCopier(const char* filename, const unsigned char* data,
+                             size_t size)
+  : filename_(filename), data_(data), size_(size), doc_(NULL),
+    failed_(false) {
+}
+
+PdfPageCopier::~PdfPageCopier() {
+  delete doc_;
+}
+
+bool PdfPageCopier::CopyPage(int page_index, long int page_objnum,
+                             long int first_objnum,
+                             GenericVector<std::string>* objects,
+                             std::string* annots) {
+  annots->clear();
+  if (doc_ == NULL && !failed_) {
+    doc_ = OpenDocument(filename_, data_, size_);
+    failed_ = doc_ == NULL;
+  }
+  if (doc_ == NULL || page_index < 0 || page_index >= doc_->getNumPages())
+    return false;
+  Page* page = doc_->getPage(page_index + 1);
+  if (page == NULL) return false;
+  ObjectCopier copier(doc_->getXRef(), page->getRef(), page_objnum,
+                      first_objnum + 1);
+
+  // The form draws the page in its default user space, clipped to the
+  // media box as the page is.
+  char buf[512];
+  const PDFRectangle* box = page->getMediaBox();
+  snprintf(buf, sizeof(buf),
+           "%ld 0 obj\n"
+           "<<\n"
+           "/Type /XObject\n"
+           "/Subtype /Form\n"
+           "/BBox [%.4f %.4f %.4f %.4f]\n",
+           first_objnum, box->x1, box->y1, box->x2, box->y2);
+  std::string form(buf);
+  form += "/Resources ";
+  Object resources;
+  if (page->getResourceDict() != NULL)
+    resources.initDict(page->getResourceDict());
+  else
+    resources.initDict(doc_->getXRef());
+  copier.Write(&resources, &form);
+  resources.free();
+  form += "\n";
+  if (page->getGroup() != NULL) {
+    Object group;
+    group.initDict(page->getGroup());
+    form += "/Group ";
+    copier.Write(&group, &form);
+    group.free();
+    form += "\n";
+  }
+
+  // A single content stream is taken as it is, filters and all. An array
+  // of them is decoded and joined.
+  std::string data;
+  Object contents;
+  if (page->getContents(&contents)->isStream()) {
+    ObjectCopier::ReadUndecoded(contents.getStream(), &data);
+    const char* kFilterKeys[] = {"Filter", "DecodeParms"};
+    for (int i = 0; i < 2; ++i) {
+      Object value;
+      if (!contents.streamGetDict()->lookupNF(kFilterKeys[i], &value)
+          ->isNull()) {
+        form += i == 0 ? "/Filter " : "/DecodeParms ";
+        copier.Write(&value, &form);
+        form += "\n";
+      }
+      value.free();
+    }
+  } else if (contents.isArray()) {
+    GooString joined;
+    for (int i = 0; i < contents.arrayGetLength(); ++i) {
+      Object part;
+      if (contents.arrayGet(i, &part)->isStream()) {
+        part.getStream()->fillGooString(&joined);
+        part.getStream()->close();
+        joined.append('\n');
+      }
+      part.free();
+    }
+    size_t len = 0;
+    unsigned char* comp = zlibCompress(
+        reinterpret_cast<unsigned char*>(joined.getCString()),
+        joined.getLength(), &len);
+    if (comp == NULL) {
+      contents.free();
+      return false;
+    }
+    data.assign(reinterpret_cast<char*>(comp), len);
+    lept_free(comp);
+    form += "/Filter /FlateDecode\n";
+  }
+  contents.free();
+  ObjectCopier::AppendStreamData(data, &form);
+  objects->push_back(form);
+
+  Object annots_obj;
+  if (page->getAnnots(&annots_obj)->isArray() &&
+      annots_obj.arrayGetLength() > 0)
+    copier.Write(&annots_obj, annots);
+  annots_obj.free();
+  copier.CopyReferred(objects);
+  return true;
+}
+
+static void TraceBegin(void* data, const char* name) {
+  TraceRecorder::Begin(name);
+}
+
+static void TraceEnd(void* data, const char* name) {
+  TraceRecorder::End(name);
+}
+
+void SetPdfTracing(bool on) {
+  if (on)
+    setTraceCallbacks(TraceBegin, TraceEnd, NULL);
+  else
+    setTraceCallbacks(NULL, NULL, NULL);
+}
+
+#else  // HAVE_POPPLER
+
+PdfPageReader::PdfPageReader() : doc_(NULL) {
+}
+
+PdfPageReader::~PdfPageReader() {
+}
+
+bool PdfPageReader::Open(const char* filename, const unsigned char* data,
+                         size_t size) {
+  tprintf("Error: %s is a pdf, but tesseract was built without poppler\n",
+          filename);
+  return false;
+}
+
+int PdfPageReader::NumPages() const {
+  return 0;
+}
+
+Pix* PdfPageReader::GetPage(int page_index, L_COMP_DATA** data) {
+  if (data != NULL) *data = NULL;
+  return NULL;
+}
+
+bool PdfPageReader::GetPageGeometry(int page_index,
+                                    PdfPageGeometry* geometry) const {
+  return false;
+}
+
+Pix* PdfPageReader::ExtractPageImage(int page, L_COMP_DATA** data) {
+  return NULL;
+}
+
+Pix* PdfPageReader::RenderPage(int page) {
+  return NULL;
+}
+
+PdfPageCopier::PdfPageCopier(const char* filename, const unsigned char* data,
+                             size_t size)
+  : filename_(filename), data_(data), size_(size), doc_(NULL),
+    failed_(false) {
+}
+
+PdfPageCopier::~PdfPageCopier() {
+}
+
+bool PdfPageCopier::CopyPage(int page_index, long int page_objnum,
+                             long int first_objnum,
+                             GenericVector<std::string>* objects,
+                             std::string* annots) {
+  return false;
+}
+
+void SetPdfTracing(bool on) {
+}
+
+#endif  // HAVE_POPPLER
+
+PdfPageDecoder::PdfPageDecoder()
+  : depth_(0), next_decode_(0), next_out_(0), ready_(0), max_ready_(0),
+    stop_(false) {
+}
+
+PdfPageDecoder::~PdfPageDecoder() {
+  Stop();
+  for (int i = 0; i < slots_.size(); ++i) {
+    pixDestroy(&slots_[i]->pix);
+    l_CIDataDestroy(&slots_[i]->data);
+    delete slots_[i];
+  }
+}
+
+bool PdfPageDecoder::Start(const char* filename, const unsigned char* data,
+                           size_t size, const GenericVector<int>& pages,
+                           int num_threads, int depth) {
+  if (num_threads < 1 || !threads_.empty()) return false;
+  for (int i = 0; i < num_threads; ++i) {
+    DecodeThread* thread = new DecodeThread;
+    thread->decoder = this;
+    threads_.push_back(thread);
+    if (!thread->reader.Open(filename, data, size)) {
+      Stop();
+      return false;
+    }
+  }
+  pages_ = pages;
+  for (int i = 0; i < pages_.size(); ++i) {
+    Slot* slot = new Slot;
+    slot->pix = NULL;
+    slot->data = NULL;
+    slots_.push_back(slot);
+  }
+  depth_ = MAX(depth, num_threads);
+  for (int i = 0; i < depth_; ++i) free_slots_.Signal();
+  for (int i = 0; i < threads_.size(); ++i)
+    SVSync::StartThread(ThreadFunc, threads_[i]);
+  return true;
+}
+
+Pix* PdfPageDecoder::Next(L_Compressed_Data** data) {
+  *data = NULL;
+  if (next_out_ >= slots_.size()) return NULL;
+  Slot* slot = slots_[next_out_++];
+  slot->decoded.Wait();
+  mutex_.Lock();
+  --ready_;
+  mutex_.Unlock();
+  Pix* pix = slot->pix;
+  *data = slot->data;
+  slot->pix = NULL;
+  slot->data = NULL;
+  free_slots_.Signal();
+  return pix;
+}
+
+void* PdfPageDecoder::ThreadFunc(void* arg) {
+  DecodeThread* thread = static_cast<DecodeThread*>(arg);
+  thread->decoder->RunThread(thread);
+  return NULL;
+}
+
+void PdfPageDecoder::RunThread(DecodeThread* thread) {
+  while (true) {
+    free_slots_.Wait();
+    mutex_.Lock();
+    int index = stop_ ? pages_.size() : next_decode_++;
+    mutex_.Unlock();
+    if (index >= pages_.size()) break;
+    Slot* slot = slots_[index];
+    slot->pix = thread->reader.GetPage(pages_[index], &slot->data);
+    mutex_.Lock();
+    max_ready_ = MAX(max_ready_, ++ready_);
+    mutex_.Unlock();
+    slot->decoded.Signal();
+  }
+  thread_done_.Signal();
+}
+
+void PdfPageDecoder::Stop() {
+  if (threads_.empty()) return;
+  // Threads that were never started are told apart by depth_, which is
+  // only set once they all opened the document.
+  if (depth_ > 0) {
+    mutex_.Lock();
+    stop_ = true;
+    mutex_.Unlock();
+    for (int i = 0; i < threads_.size(); ++i) free_slots_.Signal();
+    for (int i = 0; i < threads_.size(); ++i) thread_done_.Wait();
+  }
+  for (int i = 0; i < threads_.size(); ++i) delete threads_[i];
+  threads_.clear();
+}
+
+}  // namespace tesseract.
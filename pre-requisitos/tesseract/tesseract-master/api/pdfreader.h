@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pdfreader.h
+// Description: PDF input for TessBaseAPI, using poppler.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_PDFREADER_H_
+#define TESSERACT_API_PDFREADER_H_
+
+#include <stddef.h>
+#include <string>
+#include "genericvector.h"
+#include "platform.h"
+#include "svutil.h"
+
+class PDFDoc;
+struct L_Compressed_Data;
+struct Pix;
+
+namespace tesseract {
+
+struct PdfPageGeometry;
+
+// Reads the pages of a PDF document as Pix, without temporary files.
+// A page that is nothing but one upright full page image (the usual
+// scanned document) is returned as that image, decoded at its native
+// resolution. Any other page is rendered with poppler's Splash backend.
+// Only functional when built with poppler (HAVE_POPPLER); otherwise
+// Open always fails.
+class TESS_LOCAL PdfPageReader {
+ public:
+  PdfPageReader();
+  ~PdfPageReader();
+
+  // Opens filename, or the in-memory document data/size when data is
+  // not NULL. The memory must stay valid while the reader is open.
+  bool Open(const char* filename, const unsigned char* data, size_t size);
+  // Returns the number of pages of the open document.
+  int NumPages() const;
+  // Returns page page_index (0-based) as a new Pix owned by the caller,
+  // with its resolution set, or NULL on failure. If data is not NULL, it
+  // receives the undecoded JPEG or CCITT G4 stream of an extracted page
+  // image when that can be embedded as it is in an output PDF, and NULL
+  // otherwise. The caller owns it as well.
+  Pix* GetPage(int page_index, L_Compressed_Data** data = NULL);
+  // Fills in the MediaBox, CropBox and rotation of page page_index.
+  // Returns false if there is no such page.
+  bool GetPageGeometry(int page_index, PdfPageGeometry* geometry) const;
+
+  // Resolution used to render pages that are not a single image.
+  static const int kRenderResolution = 300;
+
+ private:
+  // Returns the single full page image of the page, or NULL if the page
+  // has to be rendered.
+  Pix* ExtractPageImage(int page, L_Compressed_Data** data);
+  // Renders the page at kRenderResolution.
+  Pix* RenderPage(int page);
+
+  PDFDoc* doc_;
+};
+
+// Decodes a list of pages of a PDF document ahead of its consumer, on
+// several threads, each with its own PdfPageReader on the document, and
+// hands the pages out in list order. At most depth pages are decoded or
+// being decoded that Next has not returned yet.
+class TESS_LOCAL PdfPageDecoder {
+ public:
+  PdfPageDecoder();
+  // Stops the threads and drops any page not taken.
+  ~PdfPageDecoder();
+
+  // Starts num_threads threads decoding pages (0-based page indices) of
+  // the document, opened as by PdfPageReader::Open. depth is raised to
+  // num_threads if smaller. Returns false if a reader cannot be opened.
+  bool Start(const char* filename, const unsigned char* data, size_t size,
+             const GenericVector<int>& pages, int num_threads, int depth);
+  // Returns the next page of the list, as PdfPageReader::GetPage does,
+  // blocking until it is decoded. Returns NULL on failure or past the end.
+  Pix* Next(L_Compressed_Data** data);
+
+  // The most pages that were decoded and waiting for Next at once.
+  int max_ready() const { return max_ready_; }
+  int num_threads() const { return threads_.size(); }
+  int depth() const { return depth_; }
+
+ private:
+  struct Slot {
+    Pix* pix;
+    L_Compressed_Data* data;
+    SVSemaphore decoded;  // Signalled once pix and data are set.
+  };
+  struct DecodeThread {
+    PdfPageDecoder* decoder;
+    PdfPageReader reader;
+  };
+
+  static void* ThreadFunc(void* arg);
+  void RunThread(DecodeThread* thread);
+  // Stops and deletes the threads.
+  void Stop();
+
+  GenericVector<int> pages_;
+  GenericVector<Slot*> slots_;        // One per entry of pages_.
+  GenericVector<DecodeThread*> threads_;
+  SVMutex mutex_;                     // Guards the counters and stop_.
+  SVSemaphore free_slots_;            // Limits the pages decoded ahead.
+  SVSemaphore thread_done_;
+  int depth_;
+  int next_decode_;                   // Next entry of pages_ to decode.
+  int next_out_;                      // Next entry Next returns.
+  int ready_;                         // Decoded entries not returned yet.
+  int max_ready_;
+  bool stop_;
+};
+
+// Copies pages of a PDF document into another PDF file, each as a form
+// XObject that draws the page as it is, together with all the objects the
+// page refers to. The document is opened on first use, as by
+// PdfPageReader::Open, and must stay valid as long. Only functional when
+// built with poppler (HAVE_POPPLER); otherwise CopyPage always fails.
+// Exported as the PdfPageGeometry of TessBaseAPI points to it.
+class TESS_API PdfPageCopier {
+ public:
+  PdfPageCopier(const char* filename, const unsigned char* data, size_t size);
+  ~PdfPageCopier();
+
+  // Copies page page_index (0-based) for a file in which its page object is
+  // page_objnum. Appends to objects the form XObject first_objnum, which
+  // draws the page in its default user space, then the objects it uses,
+  // numbered on from first_objnum + 1, each a whole "n 0 obj ... endobj".
+  // annots is set to the /Annots array of the page, empty if none.
+  // References to the page become page_objnum, and those to other pages
+  // null. Returns false if the page cannot be copied, as from an encrypted
+  // document.
+  bool CopyPage(int page_index, long int page_objnum, long int first_objnum,
+                GenericVector<std::string>* objects, std::string* annots);
+
+ private:
+  const char* filename_;
+  const unsigned char* data_;
+  size_t size_;
+  PDFDoc* doc_;
+  bool failed_;  // Opening the document failed.
+};
+
+// Records the spans poppler traces, such as the rendering of pages, with
+// TraceRecorder while on. Does nothing without poppler.
+TESS_LOCAL void SetPdfTracing(bool on);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_API_PDFREADER_H_
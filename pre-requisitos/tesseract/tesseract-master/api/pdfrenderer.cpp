@@ -21,9 +21,13 @@
 #endif
 
 #include <memory>  // std::unique_ptr
+#include <string>
 #include "allheaders.h"
 #include "baseapi.h"
 #include "math.h"
+#include "object_cache.h"
+#include "pageresults.h"
+#include "pdfreader.h"
 #include "renderer.h"
 #include "strngs.h"
 #include "tprintf.h"
@@ -176,17 +180,319 @@ static const int kCharWidth = 2;
 // letter 'c'
 static const int kMaxBytesPerCodepoint = 20;
 
+// The objects of the GlyphLessFont, with its CIDToGIDMap already
+// compressed and pdf.ttf already read, laid out one after the other in data,
+// so that each document just copies them.
+struct PDFFontObjects {
+  void Append(const char* object, size_t size) {
+    data.append(object, size);
+    sizes.push_back(size);
+  }
+
+  std::string data;
+  GenericVector<long int> sizes;  // Size in data of each object.
+};
+
+// Builds the font objects of the PDF, 3 to 8, from the pdf.ttf in datadir.
+// Returns NULL on error.
+static PDFFontObjects* LoadPDFFontObjects(STRING datadir) {
+  char buf[kBasicBufSize];
+  size_t n;
+  std::unique_ptr<PDFFontObjects> objects(new PDFFontObjects);
+
+  // TYPE0 FONT
+  n = snprintf(buf, sizeof(buf),
+               "3 0 obj\n"
+               "<<\n"
+               "  /BaseFont /GlyphLessFont\n"
+               "  /DescendantFonts [ %ld 0 R ]\n"
+               "  /Encoding /Identity-H\n"
+               "  /Subtype /Type0\n"
+               "  /ToUnicode %ld 0 R\n"
+               "  /Type /Font\n"
+               ">>\n"
+               "endobj\n",
+               4L,         // CIDFontType2 font
+               6L          // ToUnicode
+               );
+  if (n >= sizeof(buf)) return NULL;
+  objects->Append(buf, n);
+
+  // CIDFONTTYPE2
+  n = snprintf(buf, sizeof(buf),
+               "4 0 obj\n"
+               "<<\n"
+               "  /BaseFont /GlyphLessFont\n"
+               "  /CIDToGIDMap %ld 0 R\n"
+               "  /CIDSystemInfo\n"
+               "  <<\n"
+               "     /Ordering (Identity)\n"
+               "     /Registry (Adobe)\n"
+               "     /Supplement 0\n"
+               "  >>\n"
+               "  /FontDescriptor %ld 0 R\n"
+               "  /Subtype /CIDFontType2\n"
+               "  /Type /Font\n"
+               "  /DW %d\n"
+               ">>\n"
+               "endobj\n",
+               5L,         // CIDToGIDMap
+               7L,         // Font descriptor
+               1000 / kCharWidth);
+  if (n >= sizeof(buf)) return NULL;
+  objects->Append(buf, n);
+
+  // CIDTOGIDMAP
+  const int kCIDToGIDMapSize = 2 * (1 << 16);
+  const std::unique_ptr<unsigned char[]> cidtogidmap(
+      new unsigned char[kCIDToGIDMapSize]);
+  for (int i = 0; i < kCIDToGIDMapSize; i++) {
+    cidtogidmap[i] = (i % 2) ? 1 : 0;
+  }
+  size_t len;
+  unsigned char *comp = zlibCompress(cidtogidmap.get(), kCIDToGIDMapSize, &len);
+  n = snprintf(buf, sizeof(buf),
+               "5 0 obj\n"
+               "<<\n"
+               "  /Length %lu /Filter /FlateDecode\n"
+               ">>\n"
+               "stream\n",
+               (unsigned long)len);
+  if (n >= sizeof(buf)) {
+    lept_free(comp);
+    return NULL;
+  }
+  const char *endstream_endobj =
+      "\nendstream\n"
+      "endobj\n";
+  std::string object(buf, n);
+  object.append(reinterpret_cast<char *>(comp), len);
+  object += endstream_endobj;
+  lept_free(comp);
+  objects->Append(object.data(), object.size());
+
+  const char *stream =
+      "/CIDInit /ProcSet findresource begin\n"
+      "12 dict begin\n"
+      "begincmap\n"
+      "/CIDSystemInfo\n"
+      "<<\n"
+      "  /Registry (Adobe)\n"
+      "  /Ordering (UCS)\n"
+      "  /Supplement 0\n"
+      ">> def\n"
+      "/CMapName /Adobe-Identify-UCS def\n"
+      "/CMapType 2 def\n"
+      "1 begincodespacerange\n"
+      "<0000> <FFFF>\n"
+      "endcodespacerange\n"
+      "1 beginbfrange\n"
+      "<0000> <FFFF> <0000>\n"
+      "endbfrange\n"
+      "endcmap\n"
+      "CMapName currentdict /CMap defineresource pop\n"
+      "end\n"
+      "end\n";
+
+  // TOUNICODE
+  n = snprintf(buf, sizeof(buf),
+               "6 0 obj\n"
+               "<< /Length %lu >>\n"
+               "stream\n"
+               "%s"
+               "endstream\n"
+               "endobj\n", (unsigned long) strlen(stream), stream);
+  if (n >= sizeof(buf)) return NULL;
+  objects->Append(buf, n);
+
+  // FONT DESCRIPTOR
+  n = snprintf(buf, sizeof(buf),
+               "7 0 obj\n"
+               "<<\n"
+               "  /Ascent %d\n"
+               "  /CapHeight %d\n"
+               "  /Descent -1\n"       // Spec says must be negative
+               "  /Flags 5\n"          // FixedPitch + Symbolic
+               "  /FontBBox  [ 0 0 %d %d ]\n"
+               "  /FontFile2 %ld 0 R\n"
+               "  /FontName /GlyphLessFont\n"
+               "  /ItalicAngle 0\n"
+               "  /StemV 80\n"
+               "  /Type /FontDescriptor\n"
+               ">>\n"
+               "endobj\n",
+               1000,
+               1000,
+               1000 / kCharWidth,
+               1000,
+               8L      // Font data
+               );
+  if (n >= sizeof(buf)) return NULL;
+  objects->Append(buf, n);
+
+  n = snprintf(buf, sizeof(buf), "%s/pdf.ttf", datadir.string());
+  if (n >= sizeof(buf)) return NULL;
+  FILE *fp = fopen(buf, "rb");
+  if (!fp) {
+    tprintf("Can not open file \"%s\"!\n", buf);
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  long int size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  const std::unique_ptr<char[]> buffer(new char[size]);
+  if (fread(buffer.get(), 1, size, fp) != static_cast<size_t>(size)) {
+    fclose(fp);
+    return NULL;
+  }
+  fclose(fp);
+  // FONTFILE2
+  n = snprintf(buf, sizeof(buf),
+               "8 0 obj\n"
+               "<<\n"
+               "  /Length %ld\n"
+               "  /Length1 %ld\n"
+               ">>\n"
+               "stream\n", size, size);
+  if (n >= sizeof(buf)) return NULL;
+  object.assign(buf, n);
+  object.append(buffer.get(), size);
+  object += endstream_endobj;
+  objects->Append(object.data(), object.size());
+  return objects.release();
+}
+
+// The font objects of every datadir used so far, shared by all renderers.
+static ObjectCache<PDFFontObjects>* FontObjectCache() {
+  static ObjectCache<PDFFontObjects> cache;
+  return &cache;
+}
+
+// Name of the color space of the output intent of PDF/A documents.
+static const char kOutputCondition[] = "sRGB IEC61966-2.1";
+
+// Appends the size lowest bytes of value to data, most significant first.
+static void AppendBigEndian(uint32_t value, int size, std::string* data) {
+  for (int i = size - 1; i >= 0; --i)
+    *data += static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+// Returns an ICC XYZType tag of the color x, y, z.
+static std::string XYZTag(double x, double y, double z) {
+  std::string tag("XYZ \0\0\0\0", 8);
+  const double xyz[3] = {x, y, z};
+  for (double v : xyz)
+    AppendBigEndian(static_cast<int32_t>(floor(v * 65536 + 0.5)), 4, &tag);
+  return tag;
+}
+
+// Builds the ICC profile of the output intent of PDF/A documents: an ICC
+// version 2 display profile of sRGB, with its primaries adapted to D50 and
+// its tone curve sampled at 1024 points.
+static std::string MakeSRGBProfile() {
+  std::string desc("desc\0\0\0\0", 8);
+  AppendBigEndian(sizeof(kOutputCondition), 4, &desc);
+  desc.append(kOutputCondition, sizeof(kOutputCondition));
+  desc.append(4 + 4 + 2 + 1 + 67, '\0');  // no Unicode nor ScriptCode name
+  const char kCopyright[] = "No copyright, use freely";
+  std::string cprt("text\0\0\0\0", 8);
+  cprt.append(kCopyright, sizeof(kCopyright));
+  const int kCurvePoints = 1024;
+  std::string curv("curv\0\0\0\0", 8);
+  AppendBigEndian(kCurvePoints, 4, &curv);
+  for (int i = 0; i < kCurvePoints; ++i) {
+    double v = static_cast<double>(i) / (kCurvePoints - 1);
+    v = v <= 0.04045 ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4);
+    AppendBigEndian(static_cast<uint32_t>(floor(v * 65535 + 0.5)), 2, &curv);
+  }
+  const struct {
+    const char* signature;
+    std::string data;
+  } tags[] = {
+    {"desc", desc},
+    {"cprt", cprt},
+    {"wtpt", XYZTag(0.9642, 1.0, 0.8249)},
+    {"rXYZ", XYZTag(0.4361, 0.2225, 0.0139)},
+    {"gXYZ", XYZTag(0.3851, 0.7169, 0.0971)},
+    {"bXYZ", XYZTag(0.1431, 0.0606, 0.7141)},
+    {"rTRC", curv},
+  };
+  const int kNumTags = sizeof(tags) / sizeof(tags[0]);
+  const char* kSharedTRC[] = {"gTRC", "bTRC"};
+
+  // The header, with the size filled in last.
+  std::string profile(8, '\0');
+  profile.append("\x02\x10\0\0" "mntrRGB XYZ ", 16);
+  const int kDate[] = {2017, 1, 1, 0, 0, 0};
+  for (int field : kDate) AppendBigEndian(field, 2, &profile);
+  profile += "acsp";
+  profile.append(4 + 4 + 4 + 4 + 8 + 4, '\0');
+  profile += XYZTag(0.9642, 1.0, 0.8249).substr(8);  // D50 illuminant
+  profile.append(4 + 44, '\0');
+
+  // The tag table, followed by the tags at 4 byte boundaries.
+  AppendBigEndian(kNumTags + 2, 4, &profile);
+  uint32_t offset = profile.size() + 12 * (kNumTags + 2);
+  std::string data;
+  for (int i = 0; i < kNumTags; ++i) {
+    uint32_t size = tags[i].data.size();
+    profile += tags[i].signature;
+    AppendBigEndian(offset + data.size(), 4, &profile);
+    AppendBigEndian(size, 4, &profile);
+    if (i == kNumTags - 1) {
+      for (const char* signature : kSharedTRC) {
+        profile += signature;
+        AppendBigEndian(offset + data.size(), 4, &profile);
+        AppendBigEndian(size, 4, &profile);
+      }
+    }
+    data += tags[i].data;
+    data.append((4 - size % 4) % 4, '\0');
+  }
+  profile += data;
+  std::string size;
+  AppendBigEndian(profile.size(), 4, &size);
+  profile.replace(0, 4, size);
+  return profile;
+}
+
+// Returns date, as l_getFormattedDate writes it, in the ISO 8601 form of
+// XMP.
+static STRING XmpDate(const STRING& date) {
+  const char* d = date.string();
+  if (date.length() < 15) return "";
+  char buf[kBasicBufSize];
+  snprintf(buf, sizeof(buf), "%.4s-%.2s-%.2sT%.2s:%.2s:%.2s",
+           d, d + 4, d + 6, d + 8, d + 10, d + 12);
+  STRING xmp = buf;
+  // The offset from UTC is written +HH'mm'.
+  if (d[14] == 'Z' || date.length() < 20) {
+    xmp += "Z";
+  } else {
+    snprintf(buf, sizeof(buf), "%c%.2s:%.2s", d[14], d + 15, d + 18);
+    xmp += buf;
+  }
+  return xmp;
+}
+
 /**********************************************************************
  * PDF Renderer interface implementation
  **********************************************************************/
 
 TessPDFRenderer::TessPDFRenderer(const char *outputbase, const char *datadir,
-                                 bool textonly)
+                                 bool textonly, bool pdfa)
     : TessResultRenderer(outputbase, "pdf") {
   obj_  = 0;
   datadir_ = datadir;
   textonly_ = textonly;
+  pdfa_ = pdfa;
   offsets_.push_back(0);
+  font_objects_ = FontObjectCache()->Get(
+      datadir, NewTessCallback(&LoadPDFFontObjects, STRING(datadir)));
+}
+
+TessPDFRenderer::~TessPDFRenderer() {
+  FontObjectCache()->Free(font_objects_);
 }
 
 void TessPDFRenderer::AppendPDFObjectDIY(size_t objectsize) {
@@ -323,11 +629,59 @@ bool CodepointToUtf16be(int code, char utf16[kMaxBytesPerCodepoint]) {
   return true;
 }
 
+// Computes the matrix that maps the width x height points of a page image
+// onto the crop box of the PDF page it was read from, in that page's
+// default user space. The image shows the crop box as displayed, that is
+// turned clockwise by /Rotate, so the rotation is undone here.
+static void SourcePageMatrix(const PdfPageGeometry& geometry,
+                             double width, double height, double m[6]) {
+  const double* box = geometry.crop_box;
+  double x0 = MIN(box[0], box[2]);
+  double y0 = MIN(box[1], box[3]);
+  double box_width = fabs(box[2] - box[0]);
+  double box_height = fabs(box[3] - box[1]);
+  int rotate = ((geometry.rotate % 360) + 360) % 360;
+  bool sideways = rotate == 90 || rotate == 270;
+  double sx = (sideways ? box_height : box_width) / width;
+  double sy = (sideways ? box_width : box_height) / height;
+  switch (rotate) {
+    case 90:
+      m[0] = 0;   m[1] = sx;  m[2] = -sy; m[3] = 0;
+      m[4] = x0 + box_width;  m[5] = y0;
+      break;
+    case 180:
+      m[0] = -sx; m[1] = 0;   m[2] = 0;   m[3] = -sy;
+      m[4] = x0 + box_width;  m[5] = y0 + box_height;
+      break;
+    case 270:
+      m[0] = 0;   m[1] = -sx; m[2] = sy;  m[3] = 0;
+      m[4] = x0;  m[5] = y0 + box_height;
+      break;
+    default:
+      m[0] = sx;  m[1] = 0;   m[2] = 0;   m[3] = sy;
+      m[4] = x0;  m[5] = y0;
+      break;
+  }
+}
+
 char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
-                                         double width, double height) {
+                                         double width, double height,
+                                         bool mrc) {
   STRING pdf_str("");
   double ppi = api->GetSourceYResolution();
 
+  // A text layer for a PDF source page is drawn in that page's own user
+  // space, so that it lines up when stamped onto the original.
+  const PdfPageGeometry* source_page =
+      textonly_ ? api->GetInputPageGeometry() : NULL;
+  if (source_page != NULL) {
+    double m[6];
+    SourcePageMatrix(*source_page, width, height, m);
+    pdf_str += "q";
+    for (int i = 0; i < 6; ++i) pdf_str.add_str_double(" ", prec(m[i]));
+    pdf_str += " cm\n";
+  }
+
   // These initial conditions are all arbitrary and will be overwritten
   double old_x = 0.0, old_y = 0.0;
   int old_fontsize = 0;
@@ -349,7 +703,7 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
   pdf_str.add_str_double("", prec(height));
   pdf_str += " 0 0 cm";
   if (!textonly_) {
-    pdf_str += " /Im1 Do";
+    pdf_str += mrc ? " /Im1 Do /Im2 Do" : " /Im1 Do";
   }
   pdf_str += " Q\n";
 
@@ -358,57 +712,45 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
   int line_x2 = 0;
   int line_y2 = 0;
 
-  ResultIterator *res_it = api->GetIterator();
-  while (!res_it->Empty(RIL_BLOCK)) {
-    if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
+  const PageResults* results = api->GetPageResults(NULL);
+  int num_words = results != NULL ? results->words.size() : 0;
+  for (int w = 0; w < num_words; ++w) {
+    const PageResultWord& word = results->words[w];
+    if (results->FirstWordInBlock(w)) {
       pdf_str += "BT\n3 Tr";     // Begin text object, use invisible ink
       old_fontsize = 0;          // Every block will declare its fontsize
       new_block = true;          // Every block will declare its affine matrix
     }
 
-    if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
-      int x1, y1, x2, y2;
-      res_it->Baseline(RIL_TEXTLINE, &x1, &y1, &x2, &y2);
-      ClipBaseline(ppi, x1, y1, x2, y2, &line_x1, &line_y1, &line_x2, &line_y2);
-    }
-
-    if (res_it->Empty(RIL_WORD)) {
-      res_it->Next(RIL_WORD);
-      continue;
+    if (results->FirstWordInLine(w)) {
+      const PageResultBaseline& line = results->lines[word.line].baseline;
+      ClipBaseline(ppi, line.x1, line.y1, line.x2, line.y2,
+                   &line_x1, &line_y1, &line_x2, &line_y2);
     }
 
     // Writing direction changes at a per-word granularity
-    tesseract::WritingDirection writing_direction;
-    {
-      tesseract::Orientation orientation;
-      tesseract::TextlineOrder textline_order;
-      float deskew_angle;
-      res_it->Orientation(&orientation, &writing_direction,
-                          &textline_order, &deskew_angle);
-      if (writing_direction != WRITING_DIRECTION_TOP_TO_BOTTOM) {
-        switch (res_it->WordDirection()) {
-          case DIR_LEFT_TO_RIGHT:
-            writing_direction = WRITING_DIRECTION_LEFT_TO_RIGHT;
-            break;
-          case DIR_RIGHT_TO_LEFT:
-            writing_direction = WRITING_DIRECTION_RIGHT_TO_LEFT;
-            break;
-          default:
-            writing_direction = old_writing_direction;
-        }
+    tesseract::WritingDirection writing_direction =
+        results->blocks[word.block].writing_direction;
+    if (writing_direction != WRITING_DIRECTION_TOP_TO_BOTTOM) {
+      switch (word.direction) {
+        case DIR_LEFT_TO_RIGHT:
+          writing_direction = WRITING_DIRECTION_LEFT_TO_RIGHT;
+          break;
+        case DIR_RIGHT_TO_LEFT:
+          writing_direction = WRITING_DIRECTION_RIGHT_TO_LEFT;
+          break;
+        default:
+          writing_direction = old_writing_direction;
       }
     }
 
     // Where is word origin and how long is it?
     double x, y, word_length;
-    {
-      int word_x1, word_y1, word_x2, word_y2;
-      res_it->Baseline(RIL_WORD, &word_x1, &word_y1, &word_x2, &word_y2);
-      GetWordBaseline(writing_direction, ppi, height,
-                      word_x1, word_y1, word_x2, word_y2,
-                      line_x1, line_y1, line_x2, line_y2,
-                      &x, &y, &word_length);
-    }
+    GetWordBaseline(writing_direction, ppi, height,
+                    word.baseline.x1, word.baseline.y1,
+                    word.baseline.x2, word.baseline.y2,
+                    line_x1, line_y1, line_x2, line_y2,
+                    &x, &y, &word_length);
 
     if (writing_direction != old_writing_direction || new_block) {
       AffineMatrix(writing_direction,
@@ -437,10 +779,7 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
     // in Arabic, Tesseract will happily return a fontsize of zero,
     // so we make up a default number to protect ourselves.
     {
-      bool bold, italic, underlined, monospace, serif, smallcaps;
-      int font_id;
-      res_it->WordFontAttributes(&bold, &italic, &underlined, &monospace,
-                                 &serif, &smallcaps, &fontsize, &font_id);
+      fontsize = word.pointsize;
       const int kDefaultFontsize = 8;
       if (fontsize <= 0)
         fontsize = kDefaultFontsize;
@@ -452,25 +791,17 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
       }
     }
 
-    bool last_word_in_line = res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD);
-    bool last_word_in_block = res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD);
     STRING pdf_word("");
     int pdf_word_len = 0;
-    do {
-      const std::unique_ptr<const char[]> grapheme(
-          res_it->GetUTF8Text(RIL_SYMBOL));
-      if (grapheme && grapheme[0] != '\0') {
-        std::vector<char32> unicodes = UNICHAR::UTF8ToUTF32(grapheme.get());
-        char utf16[kMaxBytesPerCodepoint];
-        for (char32 code : unicodes) {
-          if (CodepointToUtf16be(code, utf16)) {
-            pdf_word += utf16;
-            pdf_word_len++;
-          }
-        }
+    std::vector<char32> unicodes =
+        UNICHAR::UTF8ToUTF32(results->WordText(word));
+    char utf16[kMaxBytesPerCodepoint];
+    for (char32 code : unicodes) {
+      if (CodepointToUtf16be(code, utf16)) {
+        pdf_word += utf16;
+        pdf_word_len++;
       }
-      res_it->Next(RIL_SYMBOL);
-    } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
+    }
     if (word_length > 0 && pdf_word_len > 0 && fontsize > 0) {
       double h_stretch =
           kCharWidth * prec(100.0 * word_length / (fontsize * pdf_word_len));
@@ -480,16 +811,18 @@ char* TessPDFRenderer::GetPDFTextObjects(TessBaseAPI* api,
       pdf_str += pdf_word;       // UTF-16BE representation
       pdf_str += "> ] TJ";       // show the text
     }
-    if (last_word_in_line) {
+    if (results->LastWordInLine(w)) {
       pdf_str += " \n";
     }
-    if (last_word_in_block) {
+    if (results->LastWordInBlock(w)) {
       pdf_str += "ET\n";         // end the text object
     }
   }
+  if (source_page != NULL) {
+    pdf_str += "Q\n";
+  }
   char *ret = new char[pdf_str.length() + 1];
   strcpy(ret, pdf_str.string());
-  delete res_it;
   return ret;
 }
 
@@ -497,6 +830,11 @@ bool TessPDFRenderer::BeginDocumentHandler() {
   char buf[kBasicBufSize];
   size_t n;
 
+  if (font_objects_ == NULL) return false;
+  char* datestr = l_getFormattedDate();
+  date_ = datestr;
+  lept_free(datestr);
+
   n = snprintf(buf, sizeof(buf),
                "%%PDF-1.5\n"
                "%%%c%c%c%c\n",
@@ -504,15 +842,30 @@ bool TessPDFRenderer::BeginDocumentHandler() {
   if (n >= sizeof(buf)) return false;
   AppendPDFObject(buf);
 
+  // A PDF/A document has its output intent and metadata right after the
+  // fonts.
+  long int profile_obj = 3 + font_objects_->sizes.size();
+  char pdfa_entries[kBasicBufSize] = "";
+  if (pdfa_) {
+    n = snprintf(pdfa_entries, sizeof(pdfa_entries),
+                 "  /Metadata %ld 0 R\n"
+                 "  /OutputIntents [ << /Type /OutputIntent /S /GTS_PDFA1\n"
+                 "    /OutputConditionIdentifier (%s)\n"
+                 "    /DestOutputProfile %ld 0 R >> ]\n",
+                 profile_obj + 1, kOutputCondition, profile_obj);
+    if (n >= sizeof(pdfa_entries)) return false;
+  }
+
   // CATALOG
   n = snprintf(buf, sizeof(buf),
                "1 0 obj\n"
                "<<\n"
                "  /Type /Catalog\n"
                "  /Pages %ld 0 R\n"
+               "%s"
                ">>\n"
                "endobj\n",
-               2L);
+               2L, pdfa_entries);
   if (n >= sizeof(buf)) return false;
   AppendPDFObject(buf);
 
@@ -521,188 +874,235 @@ bool TessPDFRenderer::BeginDocumentHandler() {
   // at the end of the PDF file.
   AppendPDFObject("");
 
-  // TYPE0 FONT
-  n = snprintf(buf, sizeof(buf),
-               "3 0 obj\n"
-               "<<\n"
-               "  /BaseFont /GlyphLessFont\n"
-               "  /DescendantFonts [ %ld 0 R ]\n"
-               "  /Encoding /Identity-H\n"
-               "  /Subtype /Type0\n"
-               "  /ToUnicode %ld 0 R\n"
-               "  /Type /Font\n"
-               ">>\n"
-               "endobj\n",
-               4L,         // CIDFontType2 font
-               6L          // ToUnicode
-               );
-  if (n >= sizeof(buf)) return false;
-  AppendPDFObject(buf);
+  // The font objects, 3 to 8, are the same in every document.
+  for (int i = 0; i < font_objects_->sizes.size(); ++i) {
+    AppendPDFObjectDIY(font_objects_->sizes[i]);
+  }
+  AppendData(font_objects_->data.data(), font_objects_->data.size());
+  return !pdfa_ || AppendPDFAObjects();
+}
 
-  // CIDFONTTYPE2
-  n = snprintf(buf, sizeof(buf),
-               "4 0 obj\n"
-               "<<\n"
-               "  /BaseFont /GlyphLessFont\n"
-               "  /CIDToGIDMap %ld 0 R\n"
-               "  /CIDSystemInfo\n"
-               "  <<\n"
-               "     /Ordering (Identity)\n"
-               "     /Registry (Adobe)\n"
-               "     /Supplement 0\n"
-               "  >>\n"
-               "  /FontDescriptor %ld 0 R\n"
-               "  /Subtype /CIDFontType2\n"
-               "  /Type /Font\n"
-               "  /DW %d\n"
-               ">>\n"
-               "endobj\n",
-               5L,         // CIDToGIDMap
-               7L,         // Font descriptor
-               1000 / kCharWidth);
-  if (n >= sizeof(buf)) return false;
-  AppendPDFObject(buf);
+bool TessPDFRenderer::AppendPDFAObjects() {
+  char buf[kBasicBufSize];
+  size_t n;
 
-  // CIDTOGIDMAP
-  const int kCIDToGIDMapSize = 2 * (1 << 16);
-  const std::unique_ptr<unsigned char[]> cidtogidmap(
-      new unsigned char[kCIDToGIDMapSize]);
-  for (int i = 0; i < kCIDToGIDMapSize; i++) {
-    cidtogidmap[i] = (i % 2) ? 1 : 0;
-  }
+  // OUTPUT INTENT PROFILE
+  static const std::string profile = MakeSRGBProfile();
   size_t len;
-  unsigned char *comp = zlibCompress(cidtogidmap.get(), kCIDToGIDMapSize, &len);
+  unsigned char *comp = zlibCompress(
+      reinterpret_cast<unsigned char *>(const_cast<char *>(profile.data())),
+      profile.size(), &len);
+  if (comp == NULL) return false;
   n = snprintf(buf, sizeof(buf),
-               "5 0 obj\n"
+               "%ld 0 obj\n"
                "<<\n"
+               "  /N 3\n"
                "  /Length %lu /Filter /FlateDecode\n"
                ">>\n"
-               "stream\n",
-               (unsigned long)len);
+               "stream\n", obj_, (unsigned long)len);
   if (n >= sizeof(buf)) {
     lept_free(comp);
     return false;
   }
-  AppendString(buf);
-  long objsize = strlen(buf);
-  AppendData(reinterpret_cast<char *>(comp), len);
-  objsize += len;
-  lept_free(comp);
   const char *endstream_endobj =
-      "endstream\n"
+      "\nendstream\n"
       "endobj\n";
-  AppendString(endstream_endobj);
-  objsize += strlen(endstream_endobj);
-  AppendPDFObjectDIY(objsize);
-
-  const char *stream =
-      "/CIDInit /ProcSet findresource begin\n"
-      "12 dict begin\n"
-      "begincmap\n"
-      "/CIDSystemInfo\n"
-      "<<\n"
-      "  /Registry (Adobe)\n"
-      "  /Ordering (UCS)\n"
-      "  /Supplement 0\n"
-      ">> def\n"
-      "/CMapName /Adobe-Identify-UCS def\n"
-      "/CMapType 2 def\n"
-      "1 begincodespacerange\n"
-      "<0000> <FFFF>\n"
-      "endcodespacerange\n"
-      "1 beginbfrange\n"
-      "<0000> <FFFF> <0000>\n"
-      "endbfrange\n"
-      "endcmap\n"
-      "CMapName currentdict /CMap defineresource pop\n"
-      "end\n"
-      "end\n";
-
-  // TOUNICODE
-  n = snprintf(buf, sizeof(buf),
-               "6 0 obj\n"
-               "<< /Length %lu >>\n"
-               "stream\n"
-               "%s"
-               "endstream\n"
-               "endobj\n", (unsigned long) strlen(stream), stream);
-  if (n >= sizeof(buf)) return false;
-  AppendPDFObject(buf);
-
-  // FONT DESCRIPTOR
+  std::string object(buf, n);
+  object.append(reinterpret_cast<char *>(comp), len);
+  object += endstream_endobj;
+  lept_free(comp);
+  AppendData(object.data(), object.size());
+  AppendPDFObjectDIY(object.size());
+
+  // METADATA
+  // The XMP packet repeats the entries of the /Info dictionary.
+  STRING escaped_title = HOcrEscape(title());
+  std::string xmp =
+      "<?xpacket begin=\"\xEF\xBB\xBF\" id=\"W5M0MpCehiHzreSzNTczkc9d\"?>\n"
+      "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">\n"
+      " <rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+      "  <rdf:Description rdf:about=\"\"\n"
+      "    xmlns:dc=\"http://purl.org/dc/elements/1.1/\"\n"
+      "    xmlns:xmp=\"http://ns.adobe.com/xap/1.0/\"\n"
+      "    xmlns:pdf=\"http://ns.adobe.com/pdf/1.3/\"\n"
+      "    xmlns:pdfaid=\"http://www.aiim.org/pdfa/ns/id/\">\n"
+      "   <dc:format>application/pdf</dc:format>\n"
+      "   <dc:title><rdf:Alt><rdf:li xml:lang=\"x-default\">";
+  xmp += escaped_title.string();
+  xmp += "</rdf:li></rdf:Alt></dc:title>\n"
+      "   <xmp:CreateDate>";
+  xmp += XmpDate(date_).string();
+  xmp += "</xmp:CreateDate>\n"
+      "   <pdf:Producer>Tesseract " TESSERACT_VERSION_STR "</pdf:Producer>\n"
+      "   <pdfaid:part>2</pdfaid:part>\n"
+      "   <pdfaid:conformance>B</pdfaid:conformance>\n"
+      "  </rdf:Description>\n"
+      " </rdf:RDF>\n"
+      "</x:xmpmeta>\n"
+      "<?xpacket end=\"w\"?>";
   n = snprintf(buf, sizeof(buf),
-               "7 0 obj\n"
+               "%ld 0 obj\n"
                "<<\n"
-               "  /Ascent %d\n"
-               "  /CapHeight %d\n"
-               "  /Descent -1\n"       // Spec says must be negative
-               "  /Flags 5\n"          // FixedPitch + Symbolic
-               "  /FontBBox  [ 0 0 %d %d ]\n"
-               "  /FontFile2 %ld 0 R\n"
-               "  /FontName /GlyphLessFont\n"
-               "  /ItalicAngle 0\n"
-               "  /StemV 80\n"
-               "  /Type /FontDescriptor\n"
+               "  /Type /Metadata\n"
+               "  /Subtype /XML\n"
+               "  /Length %lu\n"
                ">>\n"
-               "endobj\n",
-               1000,
-               1000,
-               1000 / kCharWidth,
-               1000,
-               8L      // Font data
-               );
+               "stream\n", obj_, (unsigned long)xmp.size());
   if (n >= sizeof(buf)) return false;
-  AppendPDFObject(buf);
+  object.assign(buf, n);
+  object += xmp;
+  object += endstream_endobj;
+  AppendData(object.data(), object.size());
+  AppendPDFObjectDIY(object.size());
+  return true;
+}
 
-  n = snprintf(buf, sizeof(buf), "%s/pdf.ttf", datadir_);
-  if (n >= sizeof(buf)) return false;
-  FILE *fp = fopen(buf, "rb");
-  if (!fp) {
-    tprintf("Can not open file \"%s\"!\n", buf);
-    return false;
+// Frees cid, unless it is the caller's original image data.
+static void DestroyCIData(L_COMP_DATA **cid, const L_COMP_DATA *original) {
+  if (*cid != original)
+    l_CIDataDestroy(cid);
+  *cid = NULL;
+}
+
+// Reduction of the foreground of a mixed raster content page, which only
+// has to carry the color of the text under its mask.
+const int kMrcForegroundReduction = 8;
+const int kMrcJpegQuality = 75;
+
+// Averages the pixels of src, 8 bpp grey or 32 bpp rgb, over each cell of
+// reduction x reduction pixels, counting only those whose bit in mask is
+// inside. A cell with none of them takes the average of all the counted
+// pixels if fill_with_mean, or else the cell before it, so that the
+// background doesn't show the text it lost at its edges.
+static Pix *MaskedReduce(Pix *src, Pix *mask, bool inside, int reduction,
+                         bool fill_with_mean) {
+  int w = pixGetWidth(src);
+  int h = pixGetHeight(src);
+  int depth = pixGetDepth(src);
+  int channels = depth == 32 ? 3 : 1;
+  int cells_w = (w + reduction - 1) / reduction;
+  int cells_h = (h + reduction - 1) / reduction;
+  GenericVector<l_uint32> sums;
+  GenericVector<l_uint32> counts;
+  sums.init_to_size(cells_w * cells_h * channels, 0);
+  counts.init_to_size(cells_w * cells_h, 0);
+  double totals[3] = {0.0, 0.0, 0.0};
+  double total_count = 0.0;
+  l_uint32 *src_data = pixGetData(src);
+  l_uint32 *mask_data = pixGetData(mask);
+  int src_wpl = pixGetWpl(src);
+  int mask_wpl = pixGetWpl(mask);
+  for (int y = 0; y < h; ++y) {
+    l_uint32 *src_line = src_data + y * src_wpl;
+    l_uint32 *mask_line = mask_data + y * mask_wpl;
+    int cell_row = (y / reduction) * cells_w;
+    for (int x = 0; x < w; ++x) {
+      if ((GET_DATA_BIT(mask_line, x) != 0) != inside) continue;
+      int cell = cell_row + x / reduction;
+      ++counts[cell];
+      if (channels == 3) {
+        l_int32 rgb[3];
+        extractRGBValues(src_line[x], &rgb[0], &rgb[1], &rgb[2]);
+        for (int c = 0; c < 3; ++c) sums[cell * 3 + c] += rgb[c];
+      } else {
+        sums[cell] += GET_DATA_BYTE(src_line, x);
+      }
+    }
   }
-  fseek(fp, 0, SEEK_END);
-  long int size = ftell(fp);
-  fseek(fp, 0, SEEK_SET);
-  const std::unique_ptr<char[]> buffer(new char[size]);
-  if (fread(buffer.get(), 1, size, fp) != static_cast<size_t>(size)) {
-    fclose(fp);
-    return false;
+  for (int cell = 0; cell < counts.size(); ++cell) {
+    total_count += counts[cell];
+    for (int c = 0; c < channels; ++c)
+      totals[c] += sums[cell * channels + c];
   }
-  fclose(fp);
-  // FONTFILE2
-  n = snprintf(buf, sizeof(buf),
-               "8 0 obj\n"
-               "<<\n"
-               "  /Length %ld\n"
-               "  /Length1 %ld\n"
-               ">>\n"
-               "stream\n", size, size);
-  if (n >= sizeof(buf)) {
-    return false;
+  int mean[3] = {255, 255, 255};
+  if (total_count > 0) {
+    for (int c = 0; c < channels; ++c)
+      mean[c] = static_cast<int>(totals[c] / total_count + 0.5);
   }
-  AppendString(buf);
-  objsize  = strlen(buf);
-  AppendData(buffer.get(), size);
-  objsize += size;
-  AppendString(endstream_endobj);
-  objsize += strlen(endstream_endobj);
-  AppendPDFObjectDIY(objsize);
-  return true;
+
+  Pix *dest = pixCreate(cells_w, cells_h, depth);
+  if (dest == NULL) return NULL;
+  l_uint32 *dest_data = pixGetData(dest);
+  int dest_wpl = pixGetWpl(dest);
+  int value[3] = {mean[0], mean[1], mean[2]};
+  for (int y = 0; y < cells_h; ++y) {
+    l_uint32 *dest_line = dest_data + y * dest_wpl;
+    for (int x = 0; x < cells_w; ++x) {
+      int cell = y * cells_w + x;
+      if (counts[cell] > 0) {
+        for (int c = 0; c < channels; ++c) {
+          value[c] = (sums[cell * channels + c] + counts[cell] / 2) /
+              counts[cell];
+        }
+      } else if (fill_with_mean) {
+        for (int c = 0; c < channels; ++c) value[c] = mean[c];
+      }
+      if (channels == 3) {
+        composeRGBPixel(value[0], value[1], value[2], dest_line + x);
+      } else {
+        SET_DATA_BYTE(dest_line, x, value[0]);
+      }
+    }
+  }
+  return dest;
 }
 
-bool TessPDFRenderer::imageToPDFObj(Pix *pix,
-                                    char *filename,
-                                    long int objnum,
-                                    char **pdf_object,
-                                    long int *pdf_object_size) {
-  size_t n;
-  char b0[kBasicBufSize];
-  char b1[kBasicBufSize];
-  char b2[kBasicBufSize];
-  if (!pdf_object_size || !pdf_object)
+// Makes the three layers of a mixed raster content page from pix, 8 bpp
+// grey or 32 bpp rgb, and binary, its thresholded image of the same size:
+// the text mask, the ink of binary in the words found by api, at full
+// resolution; the foreground, the color of that ink, at a low one; and the
+// background, pix without that ink, reduced by bg_reduction. Returns them
+// from the bottom up, background, foreground and mask, or NULL if the page
+// has no words or can't be split.
+static Pixa *MakeMrcLayers(TessBaseAPI *api, Pix *pix, Pix *binary,
+                           int bg_reduction) {
+  Pix *words = pixCreateTemplate(binary);
+  if (words == NULL) return NULL;
+  int num_words = 0;
+  const PageResults* results = api->GetPageResults(NULL);
+  if (results != NULL) {
+    for (const PageResultWord& word : results->words) {
+      const PageResultBox& box = word.box;
+      if (box.right > box.left && box.bottom > box.top) {
+        pixRasterop(words, box.left, box.top, box.right - box.left,
+                    box.bottom - box.top, PIX_SET, NULL, 0, 0);
+        ++num_words;
+      }
+    }
+  }
+  Pix *mask = num_words > 0 ? pixAnd(NULL, words, binary) : NULL;
+  pixDestroy(&words);
+  if (mask == NULL) return NULL;
+  // The antialiased edges of the ink are left out of the background too.
+  Pix *halo = pixDilateBrick(NULL, mask, 3, 3);
+  Pix *foreground = NULL, *background = NULL;
+  if (halo != NULL) {
+    foreground = MaskedReduce(pix, mask, true, kMrcForegroundReduction, true);
+    background = MaskedReduce(pix, halo, false, bg_reduction, false);
+    pixDestroy(&halo);
+  }
+  Pixa *layers = NULL;
+  if (foreground != NULL && background != NULL) {
+    layers = pixaCreate(3);
+    pixaAddPix(layers, background, L_INSERT);
+    pixaAddPix(layers, foreground, L_INSERT);
+    pixaAddPix(layers, mask, L_INSERT);
+  } else {
+    pixDestroy(&mask);
+    pixDestroy(&foreground);
+    pixDestroy(&background);
+  }
+  return layers;
+}
+
+bool TessPDFRenderer::AppendImageObject(Pix *pix,
+                                        const char *filename,
+                                        L_COMP_DATA *original,
+                                        bool jbig2,
+                                        long int objnum,
+                                        long int *pdf_object_size) {
+  if (!pdf_object_size)
     return false;
-  *pdf_object = NULL;
   *pdf_object_size = 0;
   if (!filename)
     return false;
@@ -712,7 +1112,24 @@ bool TessPDFRenderer::imageToPDFObj(Pix *pix,
 
   int format, sad;
   findFileFormat(filename, &format);
-  if (pixGetSpp(pix) == 4 && format == IFF_PNG) {
+  // The image fills the page whatever its size, so the original is also
+  // reused for a page recognized at another resolution, as long as it has
+  // the same shape. It is not reused for a page that
+  // tessedit_color_reduction took down to grey or binary, so that it is
+  // stored reduced.
+  if (original != NULL &&
+      abs(original->w * pixGetHeight(pix) - original->h * pixGetWidth(pix)) <=
+          original->w + original->h &&
+      (original->bps * original->spp <= pixGetDepth(pix) ||
+       pixGetDepth(pix) == 32)) {
+    cid = original;
+    sad = 0;
+  } else if (pixGetDepth(pix) == 1 && !pixGetColormap(pix)) {
+    // Generic region JBIG2 is lossless and typically 2-4x smaller than G4
+    // on scanned text. Both are coded in memory, straight from the pix.
+    sad = pixGenerateCIData(pix, jbig2 ? L_JBIG2_ENCODE : L_G4_ENCODE, 0, 0,
+                            &cid);
+  } else if (pixGetSpp(pix) == 4 && format == IFF_PNG) {
     Pix *p1 = pixAlphaBlendUniform(pix, 0xffffff00);
     sad = pixGenerateCIData(p1, L_FLATE_ENCODE, 0, 0, &cid);
     pixDestroy(&p1);
@@ -721,10 +1138,24 @@ bool TessPDFRenderer::imageToPDFObj(Pix *pix,
   }
 
   if (sad || !cid) {
-    l_CIDataDestroy(&cid);
+    DestroyCIData(&cid, original);
     return false;
   }
 
+  bool ok = AppendCIDataObject(cid, false, 0, objnum, pdf_object_size);
+  DestroyCIData(&cid, original);
+  return ok;
+}
+
+bool TessPDFRenderer::AppendCIDataObject(L_COMP_DATA *cid, bool image_mask,
+                                         long int mask_objnum,
+                                         long int objnum,
+                                         long int *pdf_object_size) {
+  size_t n;
+  char b0[kBasicBufSize];
+  char b1[kBasicBufSize];
+  char b2[kBasicBufSize];
+  *pdf_object_size = 0;
   const char *group4 = "";
   const char *filter;
   switch(cid->type) {
@@ -741,21 +1172,42 @@ bool TessPDFRenderer::imageToPDFObj(Pix *pix,
     case L_JP2K_ENCODE:
       filter = "/JPXDecode";
       break;
+    case L_JBIG2_ENCODE:
+      filter = "/JBIG2Decode";
+      break;
     default:
-      l_CIDataDestroy(&cid);
       return false;
   }
 
   // Maybe someday we will accept RGBA but today is not that day.
   // It requires creating an /SMask for the alpha channel.
   // http://stackoverflow.com/questions/14220221
+  // An image mask has no color space, and is drawn by the image that takes
+  // it as its /Mask.
   const char *colorspace;
-  if (cid->ncolors > 0) {
+  if (image_mask) {
+    if (cid->bps != 1 || cid->spp != 1) return false;
+    colorspace = "  /ImageMask true\n";
+  } else if (mask_objnum > 0) {
+    switch (cid->spp) {
+      case 1:
+        n = snprintf(b0, sizeof(b0), "  /ColorSpace /DeviceGray\n"
+                     "  /Mask %ld 0 R\n", mask_objnum);
+        break;
+      case 3:
+        n = snprintf(b0, sizeof(b0), "  /ColorSpace /DeviceRGB\n"
+                     "  /Mask %ld 0 R\n", mask_objnum);
+        break;
+      default:
+        return false;
+    }
+    if (n >= sizeof(b0)) return false;
+    colorspace = b0;
+  } else if (cid->ncolors > 0) {
     n = snprintf(b0, sizeof(b0),
                  "  /ColorSpace [ /Indexed /DeviceRGB %d %s ]\n",
                  cid->ncolors - 1, cid->cmapdatahex);
     if (n >= sizeof(b0)) {
-      l_CIDataDestroy(&cid);
       return false;
     }
     colorspace = b0;
@@ -768,7 +1220,6 @@ bool TessPDFRenderer::imageToPDFObj(Pix *pix,
         colorspace = "  /ColorSpace /DeviceRGB\n";
         break;
       default:
-        l_CIDataDestroy(&cid);
         return false;
     }
   }
@@ -783,59 +1234,94 @@ bool TessPDFRenderer::imageToPDFObj(Pix *pix,
                "  /Subtype /Image\n",
                objnum, (unsigned long) cid->nbytescomp);
   if (n >= sizeof(b1)) {
-    l_CIDataDestroy(&cid);
     return false;
   }
 
-  n = snprintf(b2, sizeof(b2),
-               "  /Width %d\n"
-               "  /Height %d\n"
-               "  /BitsPerComponent %d\n"
-               "  /Filter %s\n"
-               "  /DecodeParms\n"
-               "  <<\n"
-               "    /Predictor %d\n"
-               "    /Colors %d\n"
-               "%s"
-               "    /Columns %d\n"
-               "    /BitsPerComponent %d\n"
-               "  >>\n"
-               ">>\n"
-               "stream\n",
-               cid->w, cid->h, cid->bps, filter, predictor, cid->spp,
-               group4, cid->w, cid->bps);
+  // The only parameter of /JBIG2Decode is the globals segment, which the
+  // generic region doesn't use.
+  if (cid->type == L_JBIG2_ENCODE) {
+    n = snprintf(b2, sizeof(b2),
+                 "  /Width %d\n"
+                 "  /Height %d\n"
+                 "  /BitsPerComponent %d\n"
+                 "  /Filter %s\n"
+                 ">>\n"
+                 "stream\n",
+                 cid->w, cid->h, cid->bps, filter);
+  } else {
+    n = snprintf(b2, sizeof(b2),
+                 "  /Width %d\n"
+                 "  /Height %d\n"
+                 "  /BitsPerComponent %d\n"
+                 "  /Filter %s\n"
+                 "  /DecodeParms\n"
+                 "  <<\n"
+                 "    /Predictor %d\n"
+                 "    /Colors %d\n"
+                 "%s"
+                 "    /Columns %d\n"
+                 "    /BitsPerComponent %d\n"
+                 "  >>\n"
+                 ">>\n"
+                 "stream\n",
+                 cid->w, cid->h, cid->bps, filter, predictor, cid->spp,
+                 group4, cid->w, cid->bps);
+  }
   if (n >= sizeof(b2)) {
-    l_CIDataDestroy(&cid);
     return false;
   }
 
   const char *b3 =
-      "endstream\n"
+      "\nendstream\n"
       "endobj\n";
 
-  size_t b1_len = strlen(b1);
-  size_t b2_len = strlen(b2);
-  size_t b3_len = strlen(b3);
-  size_t colorspace_len = strlen(colorspace);
-
-  *pdf_object_size =
-      b1_len + colorspace_len + b2_len + cid->nbytescomp + b3_len;
-  *pdf_object = new char[*pdf_object_size];
-
-  char *p = *pdf_object;
-  memcpy(p, b1, b1_len);
-  p += b1_len;
-  memcpy(p, colorspace, colorspace_len);
-  p += colorspace_len;
-  memcpy(p, b2, b2_len);
-  p += b2_len;
-  memcpy(p, cid->datacomp, cid->nbytescomp);
-  p += cid->nbytescomp;
-  memcpy(p, b3, b3_len);
-  l_CIDataDestroy(&cid);
+  // The compressed data goes straight from the codec buffer to the
+  // output, without assembling the whole object in memory first.
+  AppendString(b1);
+  AppendString(colorspace);
+  AppendString(b2);
+  AppendData(reinterpret_cast<const char *>(cid->datacomp),
+             cid->nbytescomp);
+  AppendString(b3);
+  *pdf_object_size = strlen(b1) + strlen(colorspace) + strlen(b2) +
+      cid->nbytescomp + strlen(b3);
   return true;
 }
 
+bool TessPDFRenderer::AppendMrcObjects(Pixa *layers, bool jbig2) {
+  // The mask is the object right after the foreground that takes it.
+  for (int i = 0; i < 3; ++i) {
+    bool mask = i == 2;
+    int type = !mask ? L_JPEG_ENCODE : jbig2 ? L_JBIG2_ENCODE : L_G4_ENCODE;
+    Pix *layer = pixaGetPix(layers, i, L_CLONE);
+    // At the quality of the layers the fast dct makes no visible difference.
+    if (layer != NULL && !mask) pixSetJpegFastEncode(layer, 1);
+    L_COMP_DATA *cid = NULL;
+    long int objsize = 0;
+    bool ok = layer != NULL &&
+        pixGenerateCIData(layer, type, mask ? 0 : kMrcJpegQuality, 0,
+                          &cid) == 0 &&
+        AppendCIDataObject(cid, mask, i == 1 ? obj_ + 1 : 0, obj_, &objsize);
+    l_CIDataDestroy(&cid);
+    pixDestroy(&layer);
+    if (!ok) return false;
+    AppendPDFObjectDIY(objsize);
+  }
+  return true;
+}
+
+bool TessPDFRenderer::AddPageCacheKey(STRING* key) const {
+  // The text objects of a full page also draw its image.
+  *key += textonly_ ? "pdf-textonly;" : "pdf;";
+  return true;
+}
+
+// The invisible text follows the baselines, and is sized from the rows, so
+// neither paragraphs nor fonts show in it.
+int TessPDFRenderer::RequiredAnalysis() const {
+  return ANALYSIS_BASELINES;
+}
+
 bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
   size_t n;
   char buf[kBasicBufSize];
@@ -848,16 +1334,78 @@ bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
   double width = pixGetWidth(pix) * 72.0 / ppi;
   double height = pixGetHeight(pix) * 72.0 / ppi;
 
-  snprintf(buf2, sizeof(buf2), "/XObject << /Im1 %ld 0 R >>\n", obj_ + 2);
-  const char *xobject = (textonly_) ? "" : buf2;
+  // A text only page for a PDF source page takes over its geometry.
+  char boxes[kBasicBufSize];
+  const PdfPageGeometry* source_page =
+      textonly_ ? api->GetInputPageGeometry() : NULL;
+  if (source_page != NULL) {
+    const double* media_box = source_page->media_box;
+    const double* crop_box = source_page->crop_box;
+    n = snprintf(boxes, sizeof(boxes),
+                 "/MediaBox [%.2f %.2f %.2f %.2f]\n"
+                 "  /CropBox [%.2f %.2f %.2f %.2f]\n"
+                 "  /Rotate %d\n",
+                 media_box[0], media_box[1], media_box[2], media_box[3],
+                 crop_box[0], crop_box[1], crop_box[2], crop_box[3],
+                 source_page->rotate);
+  } else {
+    n = snprintf(boxes, sizeof(boxes), "/MediaBox [0 0 %.2f %.2f]\n",
+                 width, height);
+  }
+  if (n >= sizeof(boxes)) return false;
+
+  // With pdf_overlay, a text only page for a PDF source page draws that page
+  // first, copied as the form /Pg, and keeps its annotations.
+  bool overlay = false;
+  api->GetBoolVariable("pdf_overlay", &overlay);
+  overlay = overlay && source_page != NULL;
+  GenericVector<std::string> source_objects;
+  std::string annots;
+  if (overlay &&
+      (source_page->source == NULL ||
+       !source_page->source->CopyPage(source_page->page_index, obj_,
+                                      obj_ + 2, &source_objects, &annots))) {
+    tprintf("Error: cannot copy page %d of the PDF input\n",
+            source_page->page_index + 1);
+    return false;
+  }
+  if (!annots.empty()) annots = "  /Annots " + annots + "\n";
+
+  // A color or grey page in mixed raster content is drawn as its background,
+  // /Im1, and then its foreground, /Im2, through the text mask.
+  Pixa *mrc_layers = NULL;
+  bool mrc = false;
+  api->GetBoolVariable("pdf_mrc", &mrc);
+  if (mrc && !textonly_ &&
+      (pixGetDepth(pix) == 8 || pixGetDepth(pix) == 32) &&
+      !pixGetColormap(pix)) {
+    int bg_reduction = 3;
+    api->GetIntVariable("pdf_mrc_reduction", &bg_reduction);
+    Pix *binary = api->GetThresholdedImage();
+    if (binary != NULL && pixSizesEqual(binary, pix))
+      mrc_layers = MakeMrcLayers(api, pix, binary, MAX(bg_reduction, 1));
+    pixDestroy(&binary);
+  }
+  if (mrc_layers != NULL) {
+    snprintf(buf2, sizeof(buf2), "/XObject << /Im1 %ld 0 R /Im2 %ld 0 R >>\n",
+             obj_ + 2, obj_ + 3);
+  } else {
+    snprintf(buf2, sizeof(buf2), "/XObject << /Im1 %ld 0 R >>\n", obj_ + 2);
+  }
+  if (overlay)
+    snprintf(buf2, sizeof(buf2), "/XObject << /Pg %ld 0 R >>\n", obj_ + 2);
+  const char *xobject = (textonly_ && !overlay) ? "" : buf2;
 
   // PAGE
-  n = snprintf(buf, sizeof(buf),
+  GenericVector<char> page;
+  page.init_to_size(kBasicBufSize + annots.size(), '\0');
+  n = snprintf(&page[0], page.size(),
                "%ld 0 obj\n"
                "<<\n"
                "  /Type /Page\n"
                "  /Parent %ld 0 R\n"
-               "  /MediaBox [0 0 %.2f %.2f]\n"
+               "  %s"
+               "%s"
                "  /Contents %ld 0 R\n"
                "  /Resources\n"
                "  <<\n"
@@ -869,20 +1417,38 @@ bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
                "endobj\n",
                obj_,
                2L,  // Pages object
-               width, height,
+               boxes,
+               annots.c_str(),
                obj_ + 1,  // Contents object
                xobject,   // Image object
                3L);       // Type0 Font
-  if (n >= sizeof(buf)) return false;
+  if (n >= static_cast<size_t>(page.size())) {
+    pixaDestroy(&mrc_layers);
+    return false;
+  }
   pages_.push_back(obj_);
-  AppendPDFObject(buf);
+  AppendPDFObject(&page[0]);
 
   // CONTENTS
-  const std::unique_ptr<char[]> pdftext(GetPDFTextObjects(api, width, height));
-  const size_t pdftext_len = strlen(pdftext.get());
+  const char* pdftext = api->GetCachedPageResult(file_extension());
+  std::unique_ptr<char[]> new_pdftext;
+  if (pdftext == NULL) {
+    new_pdftext.reset(GetPDFTextObjects(api, width, height,
+                                        mrc_layers != NULL));
+    pdftext = new_pdftext.get();
+    api->AddPageResult(file_extension(), pdftext);
+  }
+  std::string overlay_text;
+  if (overlay) {
+    overlay_text = "q /Pg Do Q\n";
+    overlay_text += pdftext;
+    pdftext = overlay_text.c_str();
+  }
+  const size_t pdftext_len = strlen(pdftext);
   size_t len;
   unsigned char *comp_pdftext = zlibCompress(
-      reinterpret_cast<unsigned char *>(pdftext.get()), pdftext_len, &len);
+      reinterpret_cast<unsigned char *>(const_cast<char *>(pdftext)),
+      pdftext_len, &len);
   long comp_pdftext_len = len;
   n = snprintf(buf, sizeof(buf),
                "%ld 0 obj\n"
@@ -892,6 +1458,7 @@ bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
                "stream\n", obj_, comp_pdftext_len);
   if (n >= sizeof(buf)) {
     lept_free(comp_pdftext);
+    pixaDestroy(&mrc_layers);
     return false;
   }
   AppendString(buf);
@@ -900,21 +1467,34 @@ bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
   objsize += comp_pdftext_len;
   lept_free(comp_pdftext);
   const char *b2 =
-      "endstream\n"
+      "\nendstream\n"
       "endobj\n";
   AppendString(b2);
   objsize += strlen(b2);
   AppendPDFObjectDIY(objsize);
 
-  if (!textonly_) {
-    char *pdf_object = nullptr;
-    if (!imageToPDFObj(pix, filename, obj_, &pdf_object, &objsize)) {
+  if (mrc_layers != NULL) {
+    bool jbig2 = true;
+    api->GetBoolVariable("pdf_jbig2", &jbig2);
+    bool ok = AppendMrcObjects(mrc_layers, jbig2);
+    pixaDestroy(&mrc_layers);
+    if (!ok) return false;
+  } else if (!textonly_) {
+    bool jbig2 = true;
+    api->GetBoolVariable("pdf_jbig2", &jbig2);
+    if (!AppendImageObject(pix, filename, api->GetInputImageData(), jbig2,
+                           obj_, &objsize)) {
       return false;
     }
-    AppendData(pdf_object, objsize);
     AppendPDFObjectDIY(objsize);
-    delete[] pdf_object;
   }
+  for (int i = 0; i < source_objects.size(); ++i) {
+    AppendData(source_objects[i].data(), source_objects[i].size());
+    AppendPDFObjectDIY(source_objects[i].size());
+  }
+  // Nothing of the page is kept past this point except its xref offsets,
+  // so hand it to the file now rather than when the stdio buffer fills.
+  FlushOutput();
   return true;
 }
 
@@ -967,7 +1547,6 @@ bool TessPDFRenderer::EndDocumentHandler() {
     }
   }
 
-  char* datestr = l_getFormattedDate();
   n = snprintf(buf, sizeof(buf),
                "%ld 0 obj\n"
                "<<\n"
@@ -976,8 +1555,8 @@ bool TessPDFRenderer::EndDocumentHandler() {
                "  /Title <%s>\n"
                ">>\n"
                "endobj\n",
-               obj_, TESSERACT_VERSION_STR, datestr, utf16_title.c_str());
-  lept_free(datestr);
+               obj_, TESSERACT_VERSION_STR, date_.string(),
+               utf16_title.c_str());
   if (n >= sizeof(buf)) return false;
   AppendPDFObject(buf);
   n = snprintf(buf, sizeof(buf),
@@ -991,12 +1570,20 @@ bool TessPDFRenderer::EndDocumentHandler() {
     if (n >= sizeof(buf)) return false;
     AppendString(buf);
   }
+  // The file identifier is a hash of what sets the document apart.
+  STRING id_key = title();
+  id_key.add_str_int(date_.string(), offsets_.back());
+  l_uint64 id[2];
+  l_hashStringToUint64(id_key.string(), &id[0]);
+  id_key += "#";
+  l_hashStringToUint64(id_key.string(), &id[1]);
   n = snprintf(buf, sizeof(buf),
                "trailer\n"
                "<<\n"
                "  /Size %ld\n"
                "  /Root %ld 0 R\n"
                "  /Info %ld 0 R\n"
+               "  /ID [ <%016llx%016llx> <%016llx%016llx> ]\n"
                ">>\n"
                "startxref\n"
                "%ld\n"
@@ -1004,6 +1591,10 @@ bool TessPDFRenderer::EndDocumentHandler() {
                obj_,
                1L,               // catalog
                obj_ - 1,         // info
+               static_cast<unsigned long long>(id[0]),
+               static_cast<unsigned long long>(id[1]),
+               static_cast<unsigned long long>(id[0]),
+               static_cast<unsigned long long>(id[1]),
                offsets_.back());
   if (n >= sizeof(buf)) return false;
   AppendString(buf);
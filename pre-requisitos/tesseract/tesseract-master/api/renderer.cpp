@@ -23,7 +23,9 @@
 #include <memory>  // std::unique_ptr
 #include "baseapi.h"
 #include "genericvector.h"
+#include "pageprofile.h"
 #include "renderer.h"
+#include "textwriter.h"
 
 namespace tesseract {
 
@@ -35,6 +37,7 @@ TessResultRenderer::TessResultRenderer(const char *outputbase,
     : file_extension_(extension),
       title_(""), imagenum_(-1),
       fout_(stdout),
+      writer_(NULL),
       next_(NULL),
       happy_(true) {
   if (strcmp(outputbase, "-") && strcmp(outputbase, "stdout")) {
@@ -44,9 +47,11 @@ TessResultRenderer::TessResultRenderer(const char *outputbase,
       happy_ = false;
     }
   }
+  if (fout_ != NULL) writer_ = new FileTextWriter(fout_);
 }
 
 TessResultRenderer::~TessResultRenderer() {
+  delete writer_;
   if (fout_ != nullptr) {
     if (fout_ != stdout)
       fclose(fout_);
@@ -83,7 +88,12 @@ bool TessResultRenderer::BeginDocument(const char* title) {
 bool TessResultRenderer::AddImage(TessBaseAPI* api) {
   if (!happy_) return false;
   ++imagenum_;
-  bool ok = AddImageHandler(api);
+  bool ok;
+  {
+    ProfileTimer timer(api->GetPageProfile(), PROFILE_RENDER);
+    ok = AddImageHandler(api);
+    if (!writer_->Flush()) happy_ = false;
+  }
   if (next_) {
     ok = next_->AddImage(api) && ok;
   }
@@ -93,6 +103,7 @@ bool TessResultRenderer::AddImage(TessBaseAPI* api) {
 bool TessResultRenderer::EndDocument() {
   if (!happy_) return false;
   bool ok = EndDocumentHandler();
+  if (!writer_->Flush()) happy_ = false;
   if (next_) {
     ok = next_->EndDocument() && ok;
   }
@@ -104,8 +115,16 @@ void TessResultRenderer::AppendString(const char* s) {
 }
 
 void TessResultRenderer::AppendData(const char* s, int len) {
-  int n = fwrite(s, 1, len, fout_);
-  if (n != len) happy_ = false;
+  writer_->Append(s, len);
+  if (!writer_->ok()) happy_ = false;
+}
+
+TextWriter* TessResultRenderer::writer() {
+  return writer_;
+}
+
+void TessResultRenderer::FlushOutput() {
+  if (!writer_->Flush() || fflush(fout_) != 0) happy_ = false;
 }
 
 bool TessResultRenderer::BeginDocumentHandler() {
@@ -124,13 +143,28 @@ TessTextRenderer::TessTextRenderer(const char *outputbase)
     : TessResultRenderer(outputbase, "txt") {
 }
 
+bool TessTextRenderer::AddPageCacheKey(STRING* key) const {
+  *key += "txt;";
+  return true;
+}
+
+// The paragraphs are separated by blank lines.
+int TessTextRenderer::RequiredAnalysis() const {
+  return ANALYSIS_PARAGRAPHS;
+}
+
 bool TessTextRenderer::AddImageHandler(TessBaseAPI* api) {
-  const std::unique_ptr<const char[]> utf8(api->GetUTF8Text());
-  if (utf8 == NULL) {
-    return false;
+  const char* cached = api->GetCachedPageResult(file_extension());
+  std::unique_ptr<const char[]> utf8;
+  if (cached == NULL) {
+    utf8.reset(api->GetUTF8Text());
+    if (utf8 == NULL) {
+      return false;
+    }
+    api->AddPageResult(file_extension(), utf8.get());
   }
 
-  AppendString(utf8.get());
+  AppendString(cached != NULL ? cached : utf8.get());
 
   const char* pageSeparator = api->GetStringVariable("page_separator");
   if (pageSeparator != nullptr && *pageSeparator != '\0') {
@@ -153,6 +187,11 @@ TessHOcrRenderer::TessHOcrRenderer(const char *outputbase, bool font_info)
     font_info_ = font_info;
 }
 
+int TessHOcrRenderer::RequiredAnalysis() const {
+  return ANALYSIS_PARAGRAPHS | ANALYSIS_BASELINES |
+      (font_info_ ? ANALYSIS_FONTS : 0);
+}
+
 bool TessHOcrRenderer::BeginDocumentHandler() {
   AppendString(
       "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
@@ -186,12 +225,7 @@ bool TessHOcrRenderer::EndDocumentHandler() {
 }
 
 bool TessHOcrRenderer::AddImageHandler(TessBaseAPI* api) {
-  const std::unique_ptr<const char[]> hocr(api->GetHOCRText(imagenum()));
-  if (hocr == NULL) return false;
-
-  AppendString(hocr.get());
-
-  return true;
+  return api->WriteHOCRText(NULL, imagenum(), writer());
 }
 
 /**********************************************************************
@@ -207,6 +241,10 @@ TessTsvRenderer::TessTsvRenderer(const char* outputbase, bool font_info)
   font_info_ = font_info;
 }
 
+int TessTsvRenderer::RequiredAnalysis() const {
+  return ANALYSIS_PARAGRAPHS;
+}
+
 bool TessTsvRenderer::BeginDocumentHandler() {
   // Output TSV column headings
   AppendString(
@@ -218,10 +256,36 @@ bool TessTsvRenderer::BeginDocumentHandler() {
 bool TessTsvRenderer::EndDocumentHandler() { return true; }
 
 bool TessTsvRenderer::AddImageHandler(TessBaseAPI* api) {
-  const std::unique_ptr<const char[]> tsv(api->GetTSVText(imagenum()));
-  if (tsv == NULL) return false;
+  return api->WriteTSVText(imagenum(), writer());
+}
 
-  AppendString(tsv.get());
+/**********************************************************************
+ * Profile Renderer interface implementation
+ **********************************************************************/
+TessProfileRenderer::TessProfileRenderer(const char* outputbase)
+    : TessResultRenderer(outputbase, "profile.json") {
+}
+
+int TessProfileRenderer::RequiredAnalysis() const {
+  return 0;
+}
+
+bool TessProfileRenderer::BeginDocumentHandler() {
+  AppendString("[\n");
+  return true;
+}
+
+bool TessProfileRenderer::EndDocumentHandler() {
+  AppendString("\n]\n");
+  return true;
+}
+
+bool TessProfileRenderer::AddImageHandler(TessBaseAPI* api) {
+  const std::unique_ptr<const char[]> json(api->GetProfileJSON(imagenum()));
+  if (json == NULL) return false;
+
+  if (imagenum() > 0) AppendString(",\n");
+  AppendString(json.get());
 
   return true;
 }
@@ -233,6 +297,10 @@ TessUnlvRenderer::TessUnlvRenderer(const char *outputbase)
     : TessResultRenderer(outputbase, "unlv") {
 }
 
+int TessUnlvRenderer::RequiredAnalysis() const {
+  return 0;
+}
+
 bool TessUnlvRenderer::AddImageHandler(TessBaseAPI* api) {
   const std::unique_ptr<const char[]> unlv(api->GetUNLVText());
   if (unlv == NULL) return false;
@@ -249,6 +317,10 @@ TessBoxTextRenderer::TessBoxTextRenderer(const char *outputbase)
     : TessResultRenderer(outputbase, "box") {
 }
 
+int TessBoxTextRenderer::RequiredAnalysis() const {
+  return 0;
+}
+
 bool TessBoxTextRenderer::AddImageHandler(TessBaseAPI* api) {
   const std::unique_ptr<const char[]> text(api->GetBoxText(imagenum()));
   if (text == NULL) return false;
@@ -264,6 +336,10 @@ bool TessBoxTextRenderer::AddImageHandler(TessBaseAPI* api) {
 TessOsdRenderer::TessOsdRenderer(const char* outputbase)
     : TessResultRenderer(outputbase, "osd") {}
 
+int TessOsdRenderer::RequiredAnalysis() const {
+  return 0;
+}
+
 bool TessOsdRenderer::AddImageHandler(TessBaseAPI* api) {
   char* osd = api->GetOsdText(imagenum());
   if (osd == NULL) return false;
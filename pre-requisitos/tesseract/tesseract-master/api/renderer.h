@@ -25,9 +25,16 @@
 #include "platform.h"
 #include "publictypes.h"
 
+struct L_Compressed_Data;
+struct Pix;
+struct Pixa;
+
 namespace tesseract {
 
+class FileTextWriter;
+struct PDFFontObjects;
 class TessBaseAPI;
+class TextWriter;
 
 /**
  * Interface for rendering tesseract results into a document, such as text,
@@ -91,6 +98,22 @@ class TESS_API TessResultRenderer {
      */
     int imagenum() const { return imagenum_; }
 
+    /**
+     * Page result cache support (see TessBaseAPI::BeginCachedPage).
+     * A renderer that can draw a page again from the result it produced
+     * for it appends to key what else that result depends on, and returns
+     * true. Renderers that cannot return false, which keeps the whole
+     * chain out of the cache.
+     */
+    virtual bool AddPageCacheKey(STRING* key) const { return false; }
+
+    /**
+     * Returns the PageAnalysis flags of what the renderer reads from a page
+     * besides its words. TessBaseAPI::ProcessPage skips the analyses that
+     * no renderer of the chain needs. Renderers that don't say need all.
+     */
+    virtual int RequiredAnalysis() const { return ANALYSIS_ALL; }
+
   protected:
     /**
      * Called by concrete classes.
@@ -125,12 +148,21 @@ class TESS_API TessResultRenderer {
     // This method will grow the output buffer if needed.
     void AppendData(const char* s, int len);
 
+    // The buffered writer behind AppendString and AppendData, for renderers
+    // that stream a page piece by piece. It is flushed after each image.
+    TextWriter* writer();
+
+    // Renderers that produce one self-contained chunk per image can call
+    // this after each image so the output file grows as pages complete.
+    void FlushOutput();
+
   private:
     const char* file_extension_;  // standard extension for generated output
     STRING title_;                // title of document being renderered
     int imagenum_;                // index of last image added
 
     FILE* fout_;                  // output file pointer
+    FileTextWriter* writer_;      // buffers all the output to fout_
     TessResultRenderer* next_;    // Can link multiple renderers together
     bool happy_;                  // I get grumpy when the disk fills up, etc.
 };
@@ -142,6 +174,9 @@ class TESS_API TessTextRenderer : public TessResultRenderer {
  public:
   explicit TessTextRenderer(const char *outputbase);
 
+  virtual bool AddPageCacheKey(STRING* key) const;
+  virtual int RequiredAnalysis() const;
+
  protected:
   virtual bool AddImageHandler(TessBaseAPI* api);
 };
@@ -154,6 +189,8 @@ class TESS_API TessHOcrRenderer : public TessResultRenderer {
   explicit TessHOcrRenderer(const char *outputbase, bool font_info);
   explicit TessHOcrRenderer(const char *outputbase);
 
+  virtual int RequiredAnalysis() const;
+
  protected:
   virtual bool BeginDocumentHandler();
   virtual bool AddImageHandler(TessBaseAPI* api);
@@ -171,6 +208,8 @@ class TESS_API TessTsvRenderer : public TessResultRenderer {
   explicit TessTsvRenderer(const char* outputbase, bool font_info);
   explicit TessTsvRenderer(const char* outputbase);
 
+  virtual int RequiredAnalysis() const;
+
  protected:
   virtual bool BeginDocumentHandler();
   virtual bool AddImageHandler(TessBaseAPI* api);
@@ -180,6 +219,44 @@ class TESS_API TessTsvRenderer : public TessResultRenderer {
   bool font_info_;              // whether to print font information
 };
 
+/**
+ * Renders the boxes, confidences and text of the blocks, lines and words
+ * of each page into the binary layout of binaryresult.h, for readers that
+ * map the file into memory instead of parsing hOCR or TSV.
+ */
+class TESS_API TessBinaryRenderer : public TessResultRenderer {
+ public:
+  explicit TessBinaryRenderer(const char* outputbase);
+
+  virtual int RequiredAnalysis() const;
+
+ protected:
+  virtual bool BeginDocumentHandler();
+  virtual bool AddImageHandler(TessBaseAPI* api);
+  virtual bool EndDocumentHandler();
+
+ private:
+  GenericVector<inT64> page_offsets_;  // File offset of each page record.
+  inT64 offset_;                       // Bytes written so far.
+};
+
+/**
+ * Renders the PageProfile of each page as a JSON array, one object per page.
+ * Put it at the end of the chain, so that its render times include the
+ * other renderers.
+ */
+class TESS_API TessProfileRenderer : public TessResultRenderer {
+ public:
+  explicit TessProfileRenderer(const char* outputbase);
+
+  virtual int RequiredAnalysis() const;
+
+ protected:
+  virtual bool BeginDocumentHandler();
+  virtual bool AddImageHandler(TessBaseAPI* api);
+  virtual bool EndDocumentHandler();
+};
+
 /**
  * Renders tesseract output into searchable PDF
  */
@@ -187,7 +264,15 @@ class TESS_API TessPDFRenderer : public TessResultRenderer {
  public:
   // datadir is the location of the TESSDATA. We need it because
   // we load a custom PDF font from this location.
-  TessPDFRenderer(const char* outputbase, const char* datadir, bool textonly);
+  // If pdfa, the document is written as PDF/A-2b, with its XMP metadata
+  // and an sRGB output intent. Pages copied with pdf_overlay conform only
+  // if their source does.
+  TessPDFRenderer(const char* outputbase, const char* datadir, bool textonly,
+                  bool pdfa = false);
+  virtual ~TessPDFRenderer();
+
+  virtual bool AddPageCacheKey(STRING* key) const;
+  virtual int RequiredAnalysis() const;
 
  protected:
   virtual bool BeginDocumentHandler();
@@ -204,16 +289,37 @@ class TESS_API TessPDFRenderer : public TessResultRenderer {
   GenericVector<long int> offsets_;  // offset of every PDF object in bytes
   GenericVector<long int> pages_;    // object number for every /Page object
   const char *datadir_;              // where to find the custom font
+  PDFFontObjects* font_objects_;     // shared, loaded from datadir_
   bool textonly_;                    // skip images if set
+  bool pdfa_;                        // write PDF/A-2b if set
+  STRING date_;                      // creation date, in the PDF way
+  // Appends the output intent profile and XMP metadata of PDF/A.
+  bool AppendPDFAObjects();
   // Bookkeeping only. DIY = Do It Yourself.
   void AppendPDFObjectDIY(size_t objectsize);
   // Bookkeeping + emit data.
   void AppendPDFObject(const char *data);
   // Create the /Contents object for an entire page.
-  char* GetPDFTextObjects(TessBaseAPI* api, double width, double height);
-  // Turn an image into a PDF object. Only transcode if we have to.
-  static bool imageToPDFObj(Pix *pix, char *filename, long int objnum,
-                          char **pdf_object, long int *pdf_object_size);
+  // If mrc, the page is drawn from the two images of AppendMrcObjects.
+  char* GetPDFTextObjects(TessBaseAPI* api, double width, double height,
+                          bool mrc);
+  // Turn an image into a PDF object and append it to the output.
+  // Only transcode if we have to: original compressed data of the same
+  // size as pix (see TessBaseAPI::SetInputImageData) is used as it is.
+  // Otherwise a binary pix is encoded as JBIG2 if jbig2 is set.
+  bool AppendImageObject(Pix *pix, const char *filename,
+                         L_Compressed_Data *original, bool jbig2,
+                         long int objnum, long int *pdf_object_size);
+  // Appends cid as image object objnum. An image_mask is written as a
+  // stencil mask, and an image with a mask_objnum takes that object as its
+  // /Mask.
+  bool AppendCIDataObject(L_Compressed_Data *cid, bool image_mask,
+                          long int mask_objnum, long int objnum,
+                          long int *pdf_object_size);
+  // Appends the background, foreground and text mask of a mixed raster
+  // content page as the next three objects, encoding the first two as JPEG
+  // and the mask as JBIG2 if jbig2 is set, or else G4.
+  bool AppendMrcObjects(Pixa *layers, bool jbig2);
 };
 
 
@@ -224,6 +330,8 @@ class TESS_API TessUnlvRenderer : public TessResultRenderer {
  public:
   explicit TessUnlvRenderer(const char *outputbase);
 
+  virtual int RequiredAnalysis() const;
+
  protected:
   virtual bool AddImageHandler(TessBaseAPI* api);
 };
@@ -235,6 +343,8 @@ class TESS_API TessBoxTextRenderer : public TessResultRenderer {
  public:
   explicit TessBoxTextRenderer(const char *outputbase);
 
+  virtual int RequiredAnalysis() const;
+
  protected:
   virtual bool AddImageHandler(TessBaseAPI* api);
 };
@@ -246,6 +356,8 @@ class TESS_API TessOsdRenderer : public TessResultRenderer {
  public:
   explicit TessOsdRenderer(const char* outputbase);
 
+  virtual int RequiredAnalysis() const;
+
  protected:
   virtual bool AddImageHandler(TessBaseAPI* api);
 };
@@ -0,0 +1,1183 @@
+/**********************************************************************
+ * File:        tesseractd.cpp
+ * Description: Persistent OCR worker daemon.
+ *              Keeps one initialized TessBaseAPI per worker thread and
+ *              serves page OCR requests over a local (unix) socket, so
+ *              that callers no longer pay model initialization per page.
+ *
+ * (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+ ** Licensed under the Apache License, Version 2.0 (the "License");
+ ** you may not use this file except in compliance with the License.
+ ** You may obtain a copy of the License at
+ ** http://www.apache.org/licenses/LICENSE-2.0
+ ** Unless required by applicable law or agreed to in writing, software
+ ** distributed under the License is distributed on an "AS IS" BASIS,
+ ** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ ** See the License for the specific language governing permissions and
+ ** limitations under the License.
+ *
+ **********************************************************************/
+//
+// Protocol: a client connects to the socket and writes one request per
+// line, fields separated by a TAB:
+//
+//   <image file>\t<output base>\t<formats>[\t<document>]\n
+//
+// <formats> is a comma separated list of pdf, hocr, tsv, tbr, txt and profile
+// (the same names as the tesseract command line configs). profile writes the
+// time of each stage of every page to <output base>.profile.json, and is
+// always the last renderer, whatever its place in the list. Multipage TIFF
+// images are written as a single multipage document, as the tesseract
+// command does.
+// For every request the daemon answers with exactly one line:
+//
+//   OK <pages>\n            on success
+//   ERR <message>\n         on failure
+//
+// A connection may carry any number of requests, answered in order; a
+// connection has one request in service at a time, so parallelism comes
+// from concurrent connections.
+//
+// Requests of all connections wait in one queue, grouped by <document>
+// (by default the directory of the image, which is where the OCR driver
+// keeps the pages of one input file). When a worker becomes free it takes
+// the next request by the --fairness policy:
+//
+//   round-robin   documents take turns, one page each (default);
+//   fewest        the document with the fewest queued pages goes first,
+//                 so short documents overtake long ones;
+//   fifo          requests in arrival order, whatever their document.
+//
+// With -c multilang_vote_pages=N, the language vote of a document is shared
+// by the workers, so the pages of a document spread over several workers
+// still stop trying the other languages once it is decided.
+//
+// Every page is recognized as if by a fresh process, unless --adapt-document
+// is given: then a worker keeps what its adaptive classifier learned while
+// it serves pages of one document in a row, with the adapted templates
+// bounded by classify_adapt_max_configs (1024 unless set with -c) so that
+// later pages don't get slower. The fewest and fifo policies keep more of
+// the pages of a document on one worker.
+//
+// Freed image buffers are kept for the next pages in leptonica's pix pool,
+// up to pix_pool_mb (64 MB per worker unless set with -c; 0 turns it off),
+// so that every page doesn't map and fault in fresh memory for its images.
+//
+// With --metrics [ADDR:]PORT, the daemon answers HTTP GET /metrics on that
+// TCP port with its metrics in the Prometheus text format: queued requests
+// and documents, busy workers and open connections, counts of requests,
+// pages and blank pages (skipped with tessedit_skip_blank_pages),
+// histograms of the time requests wait in the queue, of the time they take
+// to serve and of each recognition stage of every page (from the page
+// profile), the busy time of every worker, and the resident memory of the
+// daemon, current and peak. The workers are threads of one process, so
+// memory is only known for all of them.
+//
+// Initializing the workers takes seconds, and is the same for every
+// replica of the daemon. With --hold, the daemon stops after the workers
+// are initialized and waits for SIGUSR1 before it listens on its socket, so
+// that it can be checkpointed at that point by a process checkpointing
+// tool (criu, or the checkpoint commands of the container runtime) and new
+// replicas restored from the image, ready to serve. --ready-file tells when
+// it is time to checkpoint. With --mmap, the traineddata is mapped from its
+// file and stays out of the image.
+
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "allheaders.h"
+#include "baseapi.h"
+#include "dict.h"
+#include "genericvector.h"
+#include "pageprofile.h"
+#include "params.h"
+#include "renderer.h"
+#include "strngs.h"
+#include "svutil.h"
+#include "tesseractclass.h"
+#include "tprintf.h"
+
+namespace {
+
+const char kDefaultSocket[] = "/tmp/tesseractd.sock";
+const int kMaxRequestLine = 4096;
+const int kListenBacklog = 64;
+// Documents whose language vote is remembered, the oldest is dropped first.
+const int kMaxVotedDocuments = 64;
+// Default pix_pool_mb for each worker: a 300 dpi A4 page in color, with
+// its gray, binary and reduced images.
+const int kPixPoolMbPerWorker = 64;
+// Upper bounds in seconds of the buckets of the latency histograms.
+const double kLatencyBuckets[] = {0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5,
+                                  1, 2.5, 5, 10, 30, 60};
+const int kNumLatencyBuckets =
+    sizeof(kLatencyBuckets) / sizeof(kLatencyBuckets[0]);
+// A metrics client that does not send its request or read the answer in
+// this time is dropped.
+const int kMetricsTimeoutSec = 2;
+
+enum FairnessPolicy {
+  FAIRNESS_ROUND_ROBIN,
+  FAIRNESS_FEWEST,
+  FAIRNESS_FIFO,
+};
+
+// Global daemon configuration, filled in by ParseArgs.
+struct DaemonConfig {
+  const char* socket_path;
+  const char* datapath;
+  const char* lang;
+  tesseract::OcrEngineMode oem;
+  tesseract::PageSegMode psm;
+  int num_workers;
+  bool mmap;
+  const char* ready_file;
+  bool hold;
+  FairnessPolicy fairness;
+  int page_timeout;  // Milliseconds per page, or 0 for no deadline.
+  bool adapt_document;
+  const char* metrics_address;  // Interface of the metrics port.
+  int metrics_port;             // 0 for no metrics.
+  GenericVector<STRING> vars_vec;
+  GenericVector<STRING> vars_values;
+};
+
+DaemonConfig config;
+
+// A request line read from a connection, waiting for a worker.
+struct Request {
+  int fd;
+  long serial;    // Arrival order.
+  double queued;  // Time it was queued, see Now.
+  STRING line;
+};
+
+// The queued requests of one document.
+struct DocumentQueue {
+  STRING name;
+  GenericVector<Request> requests;
+};
+
+// Requests waiting for a free worker, by document.
+SVMutex queue_mutex;
+SVSemaphore queue_signal;
+GenericVector<DocumentQueue> documents;
+int next_document = 0;  // Round-robin position in documents.
+long next_serial = 0;
+
+// The language vote of a document, summed over the workers.
+struct DocumentVote {
+  STRING name;
+  GenericVector<int> votes;
+};
+
+// Language votes of the documents seen lately, newest first.
+SVMutex vote_mutex;
+GenericVector<DocumentVote> document_votes;
+
+// Connections handed back by the workers after a request, to be watched
+// for the next one. The event loop is woken through return_pipe.
+SVMutex return_mutex;
+GenericVector<int> returned_connections;
+int return_pipe[2];
+
+// Cumulative histogram of latencies, in the buckets of kLatencyBuckets.
+struct Histogram {
+  long buckets[kNumLatencyBuckets];
+  long count;
+  double sum;
+};
+
+// Counters of one worker.
+struct WorkerMetrics {
+  double busy_seconds;
+  long requests;
+  long pages;
+};
+
+// Metrics of the daemon, guarded by metrics_mutex.
+struct DaemonMetrics {
+  long requests_ok;
+  long requests_failed;
+  long pages;
+  long blank_pages;
+  int busy_workers;
+  Histogram queue_wait;
+  Histogram request_time;
+  Histogram stages[tesseract::PROFILE_STAGE_COUNT];
+  GenericVector<WorkerMetrics> workers;
+};
+
+SVMutex metrics_mutex;
+DaemonMetrics metrics;
+
+// Signalled once by every worker after its TessBaseAPI::Init returns.
+SVSemaphore init_done;
+SVMutex init_mutex;
+int init_failures = 0;
+
+void PrintUsage(const char* program) {
+  fprintf(stderr,
+          "Usage:\n"
+          "  %s [options]\n\n"
+          "Options:\n"
+          "  --socket PATH         Unix socket to listen on (default %s).\n"
+          "  --threads NUM         Number of recognizer threads "
+          "(default: number of cores).\n"
+          "  --tessdata-dir PATH   Specify the location of tessdata path.\n"
+          "  -l LANG[+LANG]        Specify language(s) used for OCR.\n"
+          "  --oem NUM             Specify OCR Engine mode.\n"
+          "  --psm NUM             Specify page segmentation mode.\n"
+          "  --mmap                Share read-only mappings of the traineddata\n"
+          "                        between workers and processes.\n"
+          "  --ready-file PATH     Write the pid to PATH once the workers are\n"
+          "                        initialized.\n"
+          "  --hold                Once initialized, wait for SIGUSR1 before\n"
+          "                        listening, so that the daemon can be\n"
+          "                        checkpointed and restored ready to serve.\n"
+          "  --fairness POLICY     Order of pages of different documents:\n"
+          "                        round-robin (default), fewest or fifo.\n"
+          "  --page-timeout MSECS  Deadline of the recognition of each page.\n"
+          "                        Pages about to miss it are finished with\n"
+          "                        faster settings.\n"
+          "  --adapt-document      Keep the adaptive classifier of a worker\n"
+          "                        between pages of the same document.\n"
+          "  --metrics [ADDR:]PORT Serve Prometheus metrics over HTTP on\n"
+          "                        PORT, on every interface unless ADDR.\n"
+          "  -c VAR=VALUE          Set value for config variables.\n",
+          program, kDefaultSocket);
+}
+
+void ParseArgs(int argc, char** argv) {
+  config.socket_path = kDefaultSocket;
+  config.datapath = NULL;
+  config.lang = "eng";
+  config.oem = tesseract::OEM_DEFAULT;
+  config.psm = tesseract::PSM_AUTO;
+  config.num_workers = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+  config.mmap = false;
+  config.ready_file = NULL;
+  config.hold = false;
+  config.fairness = FAIRNESS_ROUND_ROBIN;
+  config.page_timeout = 0;
+  config.adapt_document = false;
+  config.metrics_address = NULL;
+  config.metrics_port = 0;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      config.socket_path = argv[++i];
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      config.num_workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--tessdata-dir") == 0 && i + 1 < argc) {
+      config.datapath = argv[++i];
+    } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+      config.lang = argv[++i];
+    } else if (strcmp(argv[i], "--oem") == 0 && i + 1 < argc) {
+      config.oem = static_cast<tesseract::OcrEngineMode>(atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--psm") == 0 && i + 1 < argc) {
+      config.psm = static_cast<tesseract::PageSegMode>(atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--mmap") == 0) {
+      config.mmap = true;
+    } else if (strcmp(argv[i], "--ready-file") == 0 && i + 1 < argc) {
+      config.ready_file = argv[++i];
+    } else if (strcmp(argv[i], "--hold") == 0) {
+      config.hold = true;
+    } else if (strcmp(argv[i], "--fairness") == 0 && i + 1 < argc) {
+      const char* policy = argv[++i];
+      if (strcmp(policy, "round-robin") == 0) {
+        config.fairness = FAIRNESS_ROUND_ROBIN;
+      } else if (strcmp(policy, "fewest") == 0) {
+        config.fairness = FAIRNESS_FEWEST;
+      } else if (strcmp(policy, "fifo") == 0) {
+        config.fairness = FAIRNESS_FIFO;
+      } else {
+        fprintf(stderr, "Unknown fairness policy: %s\n", policy);
+        exit(1);
+      }
+    } else if (strcmp(argv[i], "--page-timeout") == 0 && i + 1 < argc) {
+      config.page_timeout = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--adapt-document") == 0) {
+      config.adapt_document = true;
+    } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+      char* arg = argv[++i];
+      char* colon = strrchr(arg, ':');
+      if (colon != NULL) {
+        *colon = '\0';
+        config.metrics_address = arg;
+      }
+      config.metrics_port = atoi(colon != NULL ? colon + 1 : arg);
+      if (config.metrics_port <= 0 || config.metrics_port > 65535) {
+        fprintf(stderr, "Invalid metrics port: %s\n", argv[i]);
+        exit(1);
+      }
+    } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+      STRING var(argv[++i]);
+      const char* eq = strchr(var.string(), '=');
+      if (eq == NULL) {
+        fprintf(stderr, "Missing = in configvar assignment: %s\n", var.string());
+        exit(1);
+      }
+      int name_len = eq - var.string();
+      STRING name;
+      name.assign(var.string(), name_len);
+      config.vars_vec.push_back(name);
+      config.vars_values.push_back(STRING(eq + 1));
+    } else {
+      PrintUsage(argv[0]);
+      exit(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0 ? 0
+                                                                         : 1);
+    }
+  }
+  if (config.num_workers <= 0) config.num_workers = 4;
+  // The workers already share the cores by requests, so unless told
+  // otherwise each recognizes its page on its own thread.
+  // Adapted templates that persist over a document are bounded too.
+  // The image buffers of a page are pooled for the next pages, with room
+  // for the pix that a worker has alive at a time.
+  bool intra_op_set = false;
+  bool max_configs_set = false;
+  bool pix_pool_set = false;
+  for (int i = 0; i < config.vars_vec.size(); ++i) {
+    if (config.vars_vec[i] == "tessedit_intra_op_threads") intra_op_set = true;
+    if (config.vars_vec[i] == "classify_adapt_max_configs")
+      max_configs_set = true;
+    if (config.vars_vec[i] == "pix_pool_mb") pix_pool_set = true;
+  }
+  if (!intra_op_set) {
+    config.vars_vec.push_back("tessedit_intra_op_threads");
+    config.vars_values.push_back("1");
+  }
+  if (config.adapt_document && !max_configs_set) {
+    config.vars_vec.push_back("classify_adapt_max_configs");
+    config.vars_values.push_back("1024");
+  }
+  if (!pix_pool_set) {
+    STRING pool_mb;
+    pool_mb.add_str_int("", kPixPoolMbPerWorker * config.num_workers);
+    config.vars_vec.push_back("pix_pool_mb");
+    config.vars_values.push_back(pool_mb);
+  }
+}
+
+// Returns the time in seconds of a monotonic clock.
+double Now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void Observe(Histogram* histogram, double seconds) {
+  for (int b = 0; b < kNumLatencyBuckets; ++b) {
+    if (seconds <= kLatencyBuckets[b]) ++histogram->buckets[b];
+  }
+  ++histogram->count;
+  histogram->sum += seconds;
+}
+
+// Renderer chained last when metrics are served: it adds the stage times
+// of each page to the metrics. It writes nothing, and leaves the page
+// cache key as the other renderers make it.
+class MetricsRenderer : public tesseract::TessResultRenderer {
+ public:
+  explicit MetricsRenderer(int worker)
+    : tesseract::TessResultRenderer("-", "metrics"), worker_(worker) {}
+
+  virtual bool AddPageCacheKey(STRING* key) const { return true; }
+
+ protected:
+  virtual bool AddImageHandler(tesseract::TessBaseAPI* api) {
+    const tesseract::PageProfile* profile = api->GetPageProfile();
+    SVAutoLock lock(&metrics_mutex);
+    ++metrics.pages;
+    ++metrics.workers[worker_].pages;
+    if (profile == NULL) return true;
+    metrics.blank_pages += profile->count(tesseract::PROFILE_BLANK);
+    for (int s = 0; s < tesseract::PROFILE_STAGE_COUNT; ++s) {
+      tesseract::ProfileStage stage = static_cast<tesseract::ProfileStage>(s);
+      Observe(&metrics.stages[s], profile->time(stage));
+    }
+    return true;
+  }
+
+ private:
+  int worker_;
+};
+
+// Builds the renderer chain for a request. Returns NULL if no format is
+// recognized. The returned root renderer owns the rest of the chain.
+tesseract::TessResultRenderer* CreateRenderers(tesseract::TessBaseAPI* api,
+                                               const char* outputbase,
+                                               const char* formats,
+                                               int worker) {
+  tesseract::TessResultRenderer* root = NULL;
+  STRING fmt_list(formats);
+  GenericVector<STRING> fmts;
+  fmt_list.split(',', &fmts);
+  bool profile = false;
+  for (int i = 0; i < fmts.size(); ++i) {
+    tesseract::TessResultRenderer* renderer = NULL;
+    bool font_info = false;
+    api->GetBoolVariable("hocr_font_info", &font_info);
+    if (fmts[i] == "pdf") {
+      bool textonly = false;
+      api->GetBoolVariable("textonly_pdf", &textonly);
+      bool pdfa = false;
+      api->GetBoolVariable("pdf_pdfa", &pdfa);
+      renderer = new tesseract::TessPDFRenderer(outputbase, api->GetDatapath(),
+                                                textonly, pdfa);
+    } else if (fmts[i] == "hocr") {
+      renderer = new tesseract::TessHOcrRenderer(outputbase, font_info);
+    } else if (fmts[i] == "tsv") {
+      renderer = new tesseract::TessTsvRenderer(outputbase, font_info);
+    } else if (fmts[i] == "tbr") {
+      renderer = new tesseract::TessBinaryRenderer(outputbase);
+    } else if (fmts[i] == "txt") {
+      renderer = new tesseract::TessTextRenderer(outputbase);
+    } else if (fmts[i] == "profile") {
+      profile = true;
+      continue;
+    } else {
+      tprintf("Ignoring unknown output format '%s'\n", fmts[i].string());
+      continue;
+    }
+    if (root == NULL) {
+      root = renderer;
+    } else {
+      root->insert(renderer);
+    }
+  }
+  if (profile) {
+    // Last, so that its render times include all the other renderers.
+    tesseract::TessResultRenderer* renderer =
+        new tesseract::TessProfileRenderer(outputbase);
+    if (root == NULL) {
+      root = renderer;
+    } else {
+      tesseract::TessResultRenderer* last = root;
+      while (last->next() != NULL) last = last->next();
+      last->insert(renderer);
+    }
+  }
+  if (root != NULL && config.metrics_port > 0) {
+    // After the profile too, so that the render time is complete.
+    tesseract::TessResultRenderer* last = root;
+    while (last->next() != NULL) last = last->next();
+    last->insert(new MetricsRenderer(worker));
+  }
+  return root;
+}
+
+// Writes remaining bytes from p to fd. Errors are ignored: a client that
+// went away just loses its answer.
+void WriteAll(int fd, const char* p, int remaining) {
+  while (remaining > 0) {
+    ssize_t written = write(fd, p, remaining);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) return;
+    p += written;
+    remaining -= written;
+  }
+}
+
+// Sends a single reply line on the connection.
+void Reply(int fd, const STRING& line) {
+  STRING msg(line);
+  msg += "\n";
+  WriteAll(fd, msg.string(), msg.length());
+}
+
+// Runs one request line on the given api of worker worker and answers on
+// fd. Unless keep_adaptation, the adaptive classifier starts afresh.
+// Returns false if the request failed.
+bool ServeRequest(tesseract::TessBaseAPI* api, int worker, int fd, char* line,
+                  bool keep_adaptation) {
+  int len = strlen(line);
+  while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+    line[--len] = '\0';
+  if (len == 0) return true;
+  char* image = line;
+  char* outputbase = strchr(image, '\t');
+  char* formats = outputbase != NULL ? strchr(outputbase + 1, '\t') : NULL;
+  if (formats == NULL) {
+    Reply(fd, "ERR malformed request");
+    return false;
+  }
+  *outputbase++ = '\0';
+  *formats++ = '\0';
+  char* document = strchr(formats, '\t');
+  if (document != NULL) *document = '\0';
+  tesseract::TessResultRenderer* renderer =
+      CreateRenderers(api, outputbase, formats, worker);
+  if (renderer == NULL) {
+    Reply(fd, "ERR no valid output format");
+    return false;
+  }
+  // Unless the previous request was a page of the same document, anything
+  // the adaptive classifier learned on it is discarded.
+  if (!keep_adaptation) api->ClearAdaptiveClassifier();
+  api->SetOutputName(outputbase);
+  bool ok = api->ProcessPages(image, NULL, config.page_timeout, renderer);
+  STRING reply;
+  if (ok) {
+    reply.add_str_int("OK ", renderer->imagenum() + 1);
+  } else {
+    reply = "ERR processing failed for ";
+    reply += image;
+  }
+  delete renderer;
+  Reply(fd, reply);
+  return ok;
+}
+
+// Returns the document a request line belongs to: its optional fourth
+// field, or else the directory of its image.
+STRING RequestDocument(const STRING& line) {
+  STRING fields_line;
+  fields_line.assign(line.string(), strcspn(line.string(), "\r\n"));
+  GenericVector<STRING> fields;
+  fields_line.split('\t', &fields);
+  STRING document;
+  if (fields.size() >= 4) {
+    document = fields[3];
+  } else if (fields.size() > 0) {
+    const char* image = fields[0].string();
+    const char* slash = strrchr(image, '/');
+    if (slash != NULL) document.assign(image, slash - image);
+  }
+  return document;
+}
+
+// Queues a complete request line read from fd and wakes a worker.
+void QueueRequest(int fd, const STRING& line) {
+  Request request;
+  request.fd = fd;
+  request.line = line;
+  STRING document = RequestDocument(line);
+  queue_mutex.Lock();
+  request.serial = next_serial++;
+  request.queued = Now();
+  int d = 0;
+  while (d < documents.size() && documents[d].name != document) ++d;
+  if (d == documents.size()) {
+    DocumentQueue queue;
+    queue.name = document;
+    documents.push_back(queue);
+  }
+  documents[d].requests.push_back(request);
+  queue_mutex.Unlock();
+  queue_signal.Signal();
+}
+
+// Takes the next request by the fairness policy. Must be called with
+// queue_mutex held and at least one request queued.
+Request TakeRequest() {
+  int best = 0;
+  switch (config.fairness) {
+    case FAIRNESS_ROUND_ROBIN:
+      best = next_document < documents.size() ? next_document : 0;
+      break;
+    case FAIRNESS_FEWEST:
+      for (int d = 1; d < documents.size(); ++d) {
+        if (documents[d].requests.size() < documents[best].requests.size())
+          best = d;
+      }
+      break;
+    case FAIRNESS_FIFO:
+      for (int d = 1; d < documents.size(); ++d) {
+        if (documents[d].requests[0].serial <
+            documents[best].requests[0].serial)
+          best = d;
+      }
+      break;
+  }
+  Request request = documents[best].requests[0];
+  documents[best].requests.remove(0);
+  if (documents[best].requests.empty()) {
+    // The next document slides into position best.
+    documents.remove(best);
+    next_document = best;
+  } else {
+    next_document = best + 1;
+  }
+  return request;
+}
+
+// Loads the language vote of document into api and returns it in votes.
+void LoadDocumentVote(tesseract::TessBaseAPI* api, const STRING& document,
+                      GenericVector<int>* votes) {
+  votes->truncate(0);
+  vote_mutex.Lock();
+  for (int d = 0; d < document_votes.size(); ++d) {
+    if (document_votes[d].name == document) {
+      *votes = document_votes[d].votes;
+      break;
+    }
+  }
+  vote_mutex.Unlock();
+  api->tesseract()->SetLanguageVotes(*votes);
+}
+
+// Adds what api voted since LoadDocumentVote returned before to the shared
+// vote of document, so that workers serving the same document concurrently
+// all count.
+void SaveDocumentVote(tesseract::TessBaseAPI* api, const STRING& document,
+                      const GenericVector<int>& before) {
+  const GenericVector<int>& after = api->tesseract()->language_votes();
+  if (after.empty()) return;
+  vote_mutex.Lock();
+  int d = 0;
+  while (d < document_votes.size() && document_votes[d].name != document) ++d;
+  if (d == document_votes.size()) {
+    if (d == kMaxVotedDocuments) document_votes.remove(--d);
+    DocumentVote vote;
+    vote.name = document;
+    document_votes.insert(vote, 0);
+    d = 0;
+  }
+  GenericVector<int>* votes = &document_votes[d].votes;
+  if (votes->size() != after.size()) votes->init_to_size(after.size(), 0);
+  for (int i = 0; i < after.size(); ++i) {
+    (*votes)[i] += after[i] - (i < before.size() ? before[i] : 0);
+  }
+  vote_mutex.Unlock();
+}
+
+// Hands a connection back to the event loop once its request is answered.
+void ReturnConnection(int fd) {
+  return_mutex.Lock();
+  returned_connections.push_back(fd);
+  return_mutex.Unlock();
+  char wake = 0;
+  while (write(return_pipe[1], &wake, 1) < 0 && errno == EINTR) {
+  }
+}
+
+// Worker thread: initializes its own TessBaseAPI once, then serves
+// requests taken from the document queues for the lifetime of the daemon.
+// arg is the index of the worker.
+void* WorkerThread(void* arg) {
+  int worker = static_cast<int>(reinterpret_cast<intptr_t>(arg));
+  tesseract::TessBaseAPI* api = new tesseract::TessBaseAPI;
+  int failed = api->Init(config.datapath, config.lang, config.oem, NULL, 0,
+                         &config.vars_vec, &config.vars_values, false);
+  if (!failed) api->SetPageSegMode(config.psm);
+  if (failed) {
+    init_mutex.Lock();
+    ++init_failures;
+    init_mutex.Unlock();
+  }
+  init_done.Signal();
+  if (failed) {
+    delete api;
+    return NULL;
+  }
+  STRING last_document;
+  bool served_any = false;
+  while (true) {
+    queue_signal.Wait();
+    queue_mutex.Lock();
+    Request request = TakeRequest();
+    queue_mutex.Unlock();
+    char line[kMaxRequestLine];
+    strncpy(line, request.line.string(), sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    STRING document = RequestDocument(request.line);
+    GenericVector<int> votes;
+    LoadDocumentVote(api, document, &votes);
+    bool keep_adaptation =
+        config.adapt_document && served_any && document == last_document;
+    double start = Now();
+    metrics_mutex.Lock();
+    ++metrics.busy_workers;
+    Observe(&metrics.queue_wait, start - request.queued);
+    metrics_mutex.Unlock();
+    bool ok = ServeRequest(api, worker, request.fd, line, keep_adaptation);
+    double seconds = Now() - start;
+    metrics_mutex.Lock();
+    --metrics.busy_workers;
+    if (ok) {
+      ++metrics.requests_ok;
+    } else {
+      ++metrics.requests_failed;
+    }
+    Observe(&metrics.request_time, seconds);
+    metrics.workers[worker].busy_seconds += seconds;
+    ++metrics.workers[worker].requests;
+    metrics_mutex.Unlock();
+    last_document = document;
+    served_any = true;
+    SaveDocumentVote(api, document, votes);
+    ReturnConnection(request.fd);
+  }
+  return NULL;
+}
+
+void AppendMetric(STRING* out, const char* name, const char* labels,
+                  double value) {
+  char buf[256];
+  snprintf(buf, sizeof(buf), "%s%s %.17g\n", name, labels, value);
+  *out += buf;
+}
+
+void AppendHelp(STRING* out, const char* name, const char* type,
+                const char* help) {
+  char buf[512];
+  snprintf(buf, sizeof(buf), "# HELP %s %s\n# TYPE %s %s\n", name, help,
+           name, type);
+  *out += buf;
+}
+
+// Appends histogram, whose series get the extra label label="value" when
+// label is not NULL.
+void AppendHistogram(STRING* out, const char* name, const char* label,
+                     const char* value, const Histogram& histogram) {
+  char prefix[128] = "";
+  if (label != NULL)
+    snprintf(prefix, sizeof(prefix), "%s=\"%s\",", label, value);
+  STRING series(name);
+  series += "_bucket";
+  char labels[160];
+  for (int b = 0; b < kNumLatencyBuckets; ++b) {
+    snprintf(labels, sizeof(labels), "{%sle=\"%g\"}", prefix,
+             kLatencyBuckets[b]);
+    AppendMetric(out, series.string(), labels, histogram.buckets[b]);
+  }
+  snprintf(labels, sizeof(labels), "{%sle=\"+Inf\"}", prefix);
+  AppendMetric(out, series.string(), labels, histogram.count);
+  // The labels of _sum and _count are the prefix without its comma.
+  labels[0] = '\0';
+  if (label != NULL)
+    snprintf(labels, sizeof(labels), "{%s=\"%s\"}", label, value);
+  series = name;
+  series += "_sum";
+  AppendMetric(out, series.string(), labels, histogram.sum);
+  series = name;
+  series += "_count";
+  AppendMetric(out, series.string(), labels, histogram.count);
+}
+
+// Returns the resident memory of the daemon in bytes, or -1.
+double ResidentBytes() {
+  FILE* fp = fopen("/proc/self/statm", "r");
+  if (fp == NULL) return -1;
+  long size = 0, resident = 0;
+  int n = fscanf(fp, "%ld %ld", &size, &resident);
+  fclose(fp);
+  return n == 2 ? static_cast<double>(resident) * sysconf(_SC_PAGESIZE) : -1;
+}
+
+// Makes the metrics page, with connections open on the request socket.
+STRING FormatMetrics(int connections) {
+  int queued_requests = 0;
+  queue_mutex.Lock();
+  int queued_documents = documents.size();
+  for (int d = 0; d < documents.size(); ++d)
+    queued_requests += documents[d].requests.size();
+  queue_mutex.Unlock();
+
+  STRING out;
+  AppendHelp(&out, "tesseractd_queued_requests", "gauge",
+             "Requests waiting for a worker.");
+  AppendMetric(&out, "tesseractd_queued_requests", "", queued_requests);
+  AppendHelp(&out, "tesseractd_queued_documents", "gauge",
+             "Documents with requests waiting for a worker.");
+  AppendMetric(&out, "tesseractd_queued_documents", "", queued_documents);
+  AppendHelp(&out, "tesseractd_connections", "gauge",
+             "Open client connections.");
+  AppendMetric(&out, "tesseractd_connections", "", connections);
+  AppendHelp(&out, "tesseractd_workers", "gauge", "Recognizer threads.");
+  AppendMetric(&out, "tesseractd_workers", "", config.num_workers);
+
+  SVAutoLock lock(&metrics_mutex);
+  AppendHelp(&out, "tesseractd_busy_workers", "gauge",
+             "Workers serving a request.");
+  AppendMetric(&out, "tesseractd_busy_workers", "", metrics.busy_workers);
+  AppendHelp(&out, "tesseractd_requests_total", "counter",
+             "Requests served, by result.");
+  AppendMetric(&out, "tesseractd_requests_total", "{result=\"ok\"}",
+               metrics.requests_ok);
+  AppendMetric(&out, "tesseractd_requests_total", "{result=\"error\"}",
+               metrics.requests_failed);
+  AppendHelp(&out, "tesseractd_pages_total", "counter", "Pages rendered.");
+  AppendMetric(&out, "tesseractd_pages_total", "", metrics.pages);
+  AppendHelp(&out, "tesseractd_blank_pages_total", "counter",
+             "Pages found blank and not recognized.");
+  AppendMetric(&out, "tesseractd_blank_pages_total", "",
+               metrics.blank_pages);
+  AppendHelp(&out, "tesseractd_queue_wait_seconds", "histogram",
+             "Time requests waited for a worker.");
+  AppendHistogram(&out, "tesseractd_queue_wait_seconds", NULL, NULL,
+                  metrics.queue_wait);
+  AppendHelp(&out, "tesseractd_request_seconds", "histogram",
+             "Time workers took to serve a request.");
+  AppendHistogram(&out, "tesseractd_request_seconds", NULL, NULL,
+                  metrics.request_time);
+  AppendHelp(&out, "tesseractd_page_stage_seconds", "histogram",
+             "Time of each recognition stage of a page; lstm and adaptation"
+             " are part of pass1 or pass2, beam_search of lstm.");
+  for (int s = 0; s < tesseract::PROFILE_STAGE_COUNT; ++s) {
+    AppendHistogram(&out, "tesseractd_page_stage_seconds", "stage",
+                    tesseract::PageProfile::StageName(
+                        static_cast<tesseract::ProfileStage>(s)),
+                    metrics.stages[s]);
+  }
+  char labels[64];
+  AppendHelp(&out, "tesseractd_worker_busy_seconds_total", "counter",
+             "Time each worker spent serving requests.");
+  for (int w = 0; w < metrics.workers.size(); ++w) {
+    snprintf(labels, sizeof(labels), "{worker=\"%d\"}", w);
+    AppendMetric(&out, "tesseractd_worker_busy_seconds_total", labels,
+                 metrics.workers[w].busy_seconds);
+  }
+  AppendHelp(&out, "tesseractd_worker_requests_total", "counter",
+             "Requests served by each worker.");
+  for (int w = 0; w < metrics.workers.size(); ++w) {
+    snprintf(labels, sizeof(labels), "{worker=\"%d\"}", w);
+    AppendMetric(&out, "tesseractd_worker_requests_total", labels,
+                 metrics.workers[w].requests);
+  }
+  AppendHelp(&out, "tesseractd_worker_pages_total", "counter",
+             "Pages rendered by each worker.");
+  for (int w = 0; w < metrics.workers.size(); ++w) {
+    snprintf(labels, sizeof(labels), "{worker=\"%d\"}", w);
+    AppendMetric(&out, "tesseractd_worker_pages_total", labels,
+                 metrics.workers[w].pages);
+  }
+  AppendHelp(&out, "tesseractd_resident_bytes", "gauge",
+             "Resident memory of the daemon.");
+  AppendMetric(&out, "tesseractd_resident_bytes", "", ResidentBytes());
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    AppendHelp(&out, "tesseractd_max_resident_bytes", "gauge",
+               "Peak resident memory of the daemon.");
+    AppendMetric(&out, "tesseractd_max_resident_bytes", "",
+                 usage.ru_maxrss * 1024.0);
+  }
+  return out;
+}
+
+// Answers one HTTP request on the metrics port and closes the connection.
+// It is served right away by the event loop, with short socket timeouts,
+// as the page takes no time to make.
+void ServeMetrics(int listen_fd, int connections) {
+  int fd = accept(listen_fd, NULL, NULL);
+  if (fd < 0) return;
+  struct timeval timeout;
+  timeout.tv_sec = kMetricsTimeoutSec;
+  timeout.tv_usec = 0;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  char buf[1024];
+  ssize_t len = read(fd, buf, sizeof(buf) - 1);
+  if (len <= 0) {
+    close(fd);
+    return;
+  }
+  buf[len] = '\0';
+  STRING response;
+  if (strncmp(buf, "GET /metrics ", 13) == 0 ||
+      strncmp(buf, "GET / ", 6) == 0) {
+    STRING body = FormatMetrics(connections);
+    char header[256];
+    snprintf(header, sizeof(header),
+             "HTTP/1.0 200 OK\r\n"
+             "Content-Type: text/plain; version=0.0.4\r\n"
+             "Content-Length: %d\r\n"
+             "Connection: close\r\n\r\n",
+             body.length());
+    response = header;
+    response += body;
+  } else {
+    response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n"
+               "Connection: close\r\n\r\n";
+  }
+  WriteAll(fd, response.string(), response.length());
+  close(fd);
+}
+
+// A connection watched by the event loop, with the bytes read so far.
+struct Connection {
+  int fd;
+  STRING pending;
+};
+
+// Moves the first complete line of connection out of its buffer into
+// line. Returns false if no complete line has arrived yet.
+bool TakeLine(Connection* connection, STRING* line) {
+  const char* start = connection->pending.string();
+  const char* newline = strchr(start, '\n');
+  if (newline == NULL) return false;
+  line->assign(start, newline - start + 1);
+  STRING rest(newline + 1);
+  connection->pending = rest;
+  return true;
+}
+
+// Accepts connections and reads their request lines, so that requests, not
+// connections, are what the workers are scheduled on. A connection is not
+// watched while one of its requests is queued or in service. metrics_fd is
+// the metrics port, or -1.
+void RunEventLoop(int listen_fd, int metrics_fd) {
+  GenericVector<Connection> idle;   // Waiting for their next request.
+  GenericVector<Connection> busy;   // A request is queued or in service.
+  GenericVector<struct pollfd> fds;
+  while (true) {
+    fds.truncate(0);
+    struct pollfd pfd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    pfd.fd = listen_fd;
+    fds.push_back(pfd);
+    pfd.fd = return_pipe[0];
+    fds.push_back(pfd);
+    for (int i = 0; i < idle.size(); ++i) {
+      pfd.fd = idle[i].fd;
+      fds.push_back(pfd);
+    }
+    pfd.fd = metrics_fd;
+    fds.push_back(pfd);
+    if (poll(&fds[0], fds.size(), -1) < 0) {
+      if (errno == EINTR) continue;
+      perror("poll");
+      return;
+    }
+    // Read idle connections first, their indices follow fds.
+    for (int i = idle.size() - 1; i >= 0; --i) {
+      if (fds[i + 2].revents == 0) continue;
+      char buf[kMaxRequestLine];
+      ssize_t len = read(idle[i].fd, buf, sizeof(buf) - 1);
+      if (len < 0 && errno == EINTR) continue;
+      if (len <= 0 || idle[i].pending.length() + len >= kMaxRequestLine) {
+        close(idle[i].fd);
+        idle.remove(i);
+        continue;
+      }
+      buf[len] = '\0';
+      idle[i].pending += buf;
+      STRING line;
+      if (TakeLine(&idle[i], &line)) {
+        busy.push_back(idle[i]);
+        idle.remove(i);
+        QueueRequest(busy.back().fd, line);
+      }
+    }
+    if (fds[1].revents & POLLIN) {
+      char drain[64];
+      while (read(return_pipe[0], drain, sizeof(drain)) < 0 &&
+             errno == EINTR) {
+      }
+      return_mutex.Lock();
+      GenericVector<int> returned = returned_connections;
+      returned_connections.truncate(0);
+      return_mutex.Unlock();
+      for (int r = 0; r < returned.size(); ++r) {
+        for (int i = 0; i < busy.size(); ++i) {
+          if (busy[i].fd != returned[r]) continue;
+          // Clients may send their next request before the answer.
+          STRING line;
+          if (TakeLine(&busy[i], &line)) {
+            QueueRequest(busy[i].fd, line);
+          } else {
+            idle.push_back(busy[i]);
+            busy.remove(i);
+          }
+          break;
+        }
+      }
+    }
+    if (fds.back().revents & POLLIN)
+      ServeMetrics(metrics_fd, idle.size() + busy.size());
+    if (fds[0].revents & POLLIN) {
+      Connection connection;
+      connection.fd = accept(listen_fd, NULL, NULL);
+      if (connection.fd < 0) {
+        if (errno == EINTR || errno == ECONNABORTED) continue;
+        perror("accept");
+        return;
+      }
+      idle.push_back(connection);
+    }
+  }
+}
+
+// Writes the pid of the daemon to path, through a temporary file so that
+// the file is complete as soon as it exists.
+bool WriteReadyFile(const char* path) {
+  STRING tmp_path(path);
+  tmp_path += ".tmp";
+  FILE* fp = fopen(tmp_path.string(), "w");
+  if (fp == NULL) {
+    perror(tmp_path.string());
+    return false;
+  }
+  bool ok = fprintf(fp, "%d\n", static_cast<int>(getpid())) > 0;
+  ok = fclose(fp) == 0 && ok;
+  if (!ok || rename(tmp_path.string(), path) != 0) {
+    perror(path);
+    unlink(tmp_path.string());
+    return false;
+  }
+  return true;
+}
+
+void RemoveSocket(int sig) {
+  unlink(config.socket_path);
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+int OpenListeningSocket(const char* path) {
+  struct sockaddr_un addr;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "Socket path too long: %s\n", path);
+    return -1;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  unlink(path);
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+      listen(fd, kListenBacklog) < 0) {
+    perror(path);
+    close(fd);
+    return -1;
+  }
+  // Page workers run as the same user as the daemon, but be lenient so the
+  // driver can also be started by another account of the same group.
+  chmod(path, 0660);
+  return fd;
+}
+
+// Opens the TCP port of the metrics. Returns its fd, or -1.
+int OpenMetricsSocket(const char* address, int port) {
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (address != NULL && address[0] != '\0' &&
+      inet_pton(AF_INET, address, &addr.sin_addr) != 1) {
+    fprintf(stderr, "Invalid metrics address: %s\n", address);
+    return -1;
+  }
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+      listen(fd, kListenBacklog) < 0) {
+    perror("metrics port");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+#if !defined(DEBUG)
+  // Disable debugging and informational messages from Leptonica.
+  setMsgSeverity(L_SEVERITY_ERROR);
+#endif
+  ParseArgs(argc, argv);
+
+  // Create the global DawgCache before any TessBaseAPI, so that all workers
+  // share the same dawgs and it is the last object destroyed.
+  tesseract::Dict::GlobalDawgCache();
+
+  // tessdata_mmap is a global parameter and must be set before the
+  // traineddata is loaded by Init.
+  if (config.mmap) {
+    tesseract::ParamsVectors no_member_params;
+    tesseract::ParamUtils::SetParam("tessdata_mmap", "1",
+                                    tesseract::SET_PARAM_CONSTRAINT_NONE,
+                                    &no_member_params);
+  }
+
+  // With --hold, SIGUSR1 is taken by sigwait below. It is blocked before
+  // the workers start, so that they inherit the mask and leave it to this
+  // thread.
+  sigset_t resume_signals;
+  sigemptyset(&resume_signals);
+  sigaddset(&resume_signals, SIGUSR1);
+  if (config.hold) pthread_sigmask(SIG_BLOCK, &resume_signals, NULL);
+
+  WorkerMetrics idle_worker = {0.0, 0, 0};
+  metrics.workers.init_to_size(config.num_workers, idle_worker);
+  for (int i = 0; i < config.num_workers; ++i)
+    SVSync::StartThread(WorkerThread,
+                        reinterpret_cast<void*>(static_cast<intptr_t>(i)));
+  for (int i = 0; i < config.num_workers; ++i) init_done.Wait();
+  if (init_failures > 0) {
+    fprintf(stderr, "Could not initialize tesseract.\n");
+    return EXIT_FAILURE;
+  }
+  if (config.ready_file != NULL && !WriteReadyFile(config.ready_file))
+    return EXIT_FAILURE;
+  if (config.hold) {
+    tprintf("tesseractd: %d workers initialized, waiting for SIGUSR1\n",
+            config.num_workers);
+    int sig = 0;
+    sigwait(&resume_signals, &sig);
+  }
+
+  int listen_fd = OpenListeningSocket(config.socket_path);
+  if (listen_fd < 0 || pipe(return_pipe) != 0) return EXIT_FAILURE;
+  int metrics_fd = -1;
+  if (config.metrics_port > 0) {
+    metrics_fd = OpenMetricsSocket(config.metrics_address, config.metrics_port);
+    if (metrics_fd < 0) return EXIT_FAILURE;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGTERM, RemoveSocket);
+  signal(SIGINT, RemoveSocket);
+  signal(SIGHUP, RemoveSocket);
+  tprintf("tesseractd: %d workers ready on %s\n", config.num_workers,
+          config.socket_path);
+
+  RunEventLoop(listen_fd, metrics_fd);
+  close(listen_fd);
+  unlink(config.socket_path);
+  return EXIT_FAILURE;
+}
+
+#else  // _WIN32
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char** argv) {
+  fprintf(stderr, "%s: unix sockets are not supported on this platform\n",
+          argv[0]);
+  return EXIT_FAILURE;
+}
+
+#endif  // _WIN32
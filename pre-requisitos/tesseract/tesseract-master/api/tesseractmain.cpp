@@ -366,8 +366,15 @@ void PreloadRenderers(
     if (b) {
       bool textonly;
       api->GetBoolVariable("textonly_pdf", &textonly);
+      bool pdfa;
+      api->GetBoolVariable("pdf_pdfa", &pdfa);
       renderers->push_back(new tesseract::TessPDFRenderer(
-          outputbase, api->GetDatapath(), textonly));
+          outputbase, api->GetDatapath(), textonly, pdfa));
+    }
+
+    api->GetBoolVariable("tessedit_create_binary", &b);
+    if (b) {
+      renderers->push_back(new tesseract::TessBinaryRenderer(outputbase));
     }
 
     api->GetBoolVariable("tessedit_write_unlv", &b);
@@ -393,6 +400,15 @@ void PreloadRenderers(
       (*renderers)[0]->insert((*renderers)[r]);
       (*renderers)[r] = NULL;
     }
+    // The profile goes at the end of the chain, so that its render times
+    // include all the other renderers.
+    bool b;
+    api->GetBoolVariable("tessedit_create_profile", &b);
+    if (b && pagesegmode != tesseract::PSM_OSD_ONLY) {
+      tesseract::TessResultRenderer* last = (*renderers)[0];
+      while (last->next() != NULL) last = last->next();
+      last->insert(new tesseract::TessProfileRenderer(outputbase));
+    }
   }
 }
 
@@ -477,7 +493,9 @@ int main(int argc, char** argv) {
   if (pagesegmode == tesseract::PSM_AUTO_ONLY) {
     int ret_val = EXIT_SUCCESS;
 
-    Pix* pixs = pixRead(image);
+    int min_dpi = 0;
+    api.GetIntVariable("tessedit_jpeg_min_dpi", &min_dpi);
+    Pix* pixs = pixReadReduced(image, min_dpi, 0);
     if (!pixs) {
       fprintf(stderr, "Cannot open input file: %s\n", image);
       return 2;
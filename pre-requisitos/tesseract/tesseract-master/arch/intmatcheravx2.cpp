@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intmatcheravx2.cpp
+// Description: Architecture-specific kernels of the static classifier.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+// This code can't compile without "-mavx2", so use dummy stubs.
+
+#include "intmatcheravx2.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace tesseract {
+void ClassPrunerCountsAVX2(const uint32_t* const* pruners, int num_pruners,
+                           const int* offsets, int num_features, int* counts) {
+  fprintf(stderr, "ClassPrunerCountsAVX2 can't be used on this build\n");
+  abort();
+}
+void ProtoDistancesAVX2(const uint32_t* protos, int n, int x, int y,
+                        int theta, int theta_fudge, int mult_shift,
+                        int mult_mask, int table_shift, int table_mask,
+                        uint32_t* distances) {
+  fprintf(stderr, "ProtoDistancesAVX2 can't be used on this build\n");
+  abort();
+}
+}  // namespace tesseract
+
+#else  // !defined(__AVX2__)
+
+#include <immintrin.h>
+#include <stdint.h>
+#include "intmatcheravx2.h"
+
+namespace tesseract {
+
+// Classes in each class pruner, 16 in each of its 2 words.
+const int kClassesPerPruner = 32;
+// Classes whose weights are in each byte of a pruner word.
+const int kClassesPerByte = 4;
+// Bytes of pruner words, so classes of each weight position, in a register.
+const int kBytesPerRegister = 8;
+
+// Sums the class pruner weights of num_features features for every class of
+// num_pruners class pruners, adding the sums to counts.
+// Uses Intel AVX2 intrinsics to access the SIMD instruction set.
+void ClassPrunerCountsAVX2(const uint32_t* const* pruners, int num_pruners,
+                           const int* offsets, int num_features, int* counts) {
+  const __m256i mask = _mm256_set1_epi32(3);
+  for (int p = 0; p < num_pruners; ++p) {
+    const uint32_t* pruner = pruners[p];
+    // Each of the 8 bytes of the 2 pruner words goes to a 32 bit lane, and
+    // sums[j] adds up the weight at bits 2j of the lanes, so lane i of sums[j]
+    // is the count of class kClassesPerByte * i + j.
+    __m256i sums[kClassesPerByte];
+    for (int j = 0; j < kClassesPerByte; ++j) sums[j] = _mm256_setzero_si256();
+    for (int f = 0; f < num_features; ++f) {
+      __m128i words = _mm_loadl_epi64(
+          reinterpret_cast<const __m128i*>(pruner + offsets[f]));
+      __m256i bytes = _mm256_cvtepu8_epi32(words);
+      sums[0] = _mm256_add_epi32(sums[0], _mm256_and_si256(bytes, mask));
+      sums[1] = _mm256_add_epi32(
+          sums[1], _mm256_and_si256(_mm256_srli_epi32(bytes, 2), mask));
+      sums[2] = _mm256_add_epi32(
+          sums[2], _mm256_and_si256(_mm256_srli_epi32(bytes, 4), mask));
+      sums[3] = _mm256_add_epi32(sums[3], _mm256_srli_epi32(bytes, 6));
+    }
+    int32_t lanes[kClassesPerByte][kBytesPerRegister];
+    for (int j = 0; j < kClassesPerByte; ++j) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[j]), sums[j]);
+    }
+    int* class_counts = counts + p * kClassesPerPruner;
+    for (int i = 0; i < kBytesPerRegister; ++i) {
+      for (int j = 0; j < kClassesPerByte; ++j) {
+        class_counts[i * kClassesPerByte + j] += lanes[j][i];
+      }
+    }
+  }
+}
+
+// Computes the feature to proto distances of the integer matcher for n
+// protos against the feature at x, y, theta, 8 protos at a time.
+// Uses Intel AVX2 intrinsics to access the SIMD instruction set.
+void ProtoDistancesAVX2(const uint32_t* protos, int n, int x, int y,
+                        int theta, int theta_fudge, int mult_shift,
+                        int mult_mask, int table_shift, int table_mask,
+                        uint32_t* distances) {
+  const __m256i feature_x = _mm256_set1_epi32(x - 128);
+  const __m256i feature_y = _mm256_set1_epi32(y - 128);
+  const __m256i feature_theta = _mm256_set1_epi32(theta);
+  const __m256i fudge = _mm256_set1_epi32(theta_fudge);
+  const __m256i byte_mask = _mm256_set1_epi32(0xff);
+  const __m256i max_mult = _mm256_set1_epi32(mult_mask);
+  const __m256i max_distance = _mm256_set1_epi32(table_mask + 1);
+  const __m128i mult_count = _mm_cvtsi32_si128(mult_shift);
+  const __m128i table_count = _mm_cvtsi32_si128(table_shift);
+  for (int i = 0; i < n; i += 8) {
+    __m256i packed =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(protos + i));
+    __m256i a = _mm256_srai_epi32(_mm256_slli_epi32(packed, 24), 24);
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(packed, 8), byte_mask);
+    __m256i c = _mm256_srai_epi32(_mm256_slli_epi32(packed, 8), 24);
+    __m256i angle = _mm256_srli_epi32(packed, 24);
+    // A3 = ((A * (X - 128)) << 1) - B * (Y - 128) + (C << 9).
+    __m256i a3 = _mm256_slli_epi32(_mm256_mullo_epi32(a, feature_x), 1);
+    a3 = _mm256_sub_epi32(a3, _mm256_mullo_epi32(b, feature_y));
+    a3 = _mm256_add_epi32(a3, _mm256_slli_epi32(c, 9));
+    // M3 = ((inT8)(Theta - Angle) * theta_fudge) << 1.
+    __m256i m3 = _mm256_sub_epi32(feature_theta, angle);
+    m3 = _mm256_srai_epi32(_mm256_slli_epi32(m3, 24), 24);
+    m3 = _mm256_slli_epi32(_mm256_mullo_epi32(m3, fudge), 1);
+    // Negative values are complemented, not negated, as in the scalar code.
+    a3 = _mm256_xor_si256(a3, _mm256_srai_epi32(a3, 31));
+    m3 = _mm256_xor_si256(m3, _mm256_srai_epi32(m3, 31));
+    a3 = _mm256_min_epi32(_mm256_sra_epi32(a3, mult_count), max_mult);
+    m3 = _mm256_min_epi32(_mm256_sra_epi32(m3, mult_count), max_mult);
+    __m256i a4 = _mm256_add_epi32(_mm256_mullo_epi32(a3, a3),
+                                  _mm256_mullo_epi32(m3, m3));
+    a4 = _mm256_min_epu32(_mm256_srl_epi32(a4, table_count), max_distance);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(distances + i), a4);
+  }
+}
+
+}  // namespace tesseract.
+
+#endif  // !defined(__AVX2__)
@@ -0,0 +1,48 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intmatcheravx2.h
+// Description: Architecture-specific kernels of the static classifier.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_INTMATCHERAVX2_H_
+#define TESSERACT_ARCH_INTMATCHERAVX2_H_
+
+#include <stdint.h>
+
+namespace tesseract {
+
+// Sums the class pruner weights of num_features features for every class of
+// num_pruners class pruners, adding the sums to counts. Each pruner holds 32
+// classes of 2 bit weights, and offsets[f] is the index in every pruner of
+// the 2 words holding the weights for feature f, so class c of pruner p
+// gets (pruners[p][offsets[f] + c / 16] >> (2 * (c % 16))) & 3 added to
+// counts[32 * p + c] for each f.
+// Uses Intel AVX2 intrinsics to access the SIMD instruction set.
+void ClassPrunerCountsAVX2(const uint32_t* const* pruners, int num_pruners,
+                           const int* offsets, int num_features, int* counts);
+
+// Computes the feature to proto distances of the integer matcher for n
+// protos, each packed as the A (signed), B, C (signed) and Angle bytes of an
+// INT_PROTO_STRUCT, against the feature at x, y, theta. The distances are
+// truncated, clipped and scaled as IntegerMatcher::UpdateTablesForFeature
+// does, so they index its similarity evidence table, except that distances
+// beyond table_mask are written as table_mask + 1. protos and distances must
+// have room for n rounded up to a multiple of 8.
+// Uses Intel AVX2 intrinsics to access the SIMD instruction set.
+void ProtoDistancesAVX2(const uint32_t* protos, int n, int x, int y,
+                        int theta, int theta_fudge, int mult_shift,
+                        int mult_mask, int table_shift, int table_mask,
+                        uint32_t* distances);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_ARCH_INTMATCHERAVX2_H_
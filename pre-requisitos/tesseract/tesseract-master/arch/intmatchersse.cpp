@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intmatchersse.cpp
+// Description: Architecture-specific kernels of the static classifier.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__SSE4_1__)
+// This code can't compile without "-msse4.1", so use dummy stubs.
+
+#include "intmatchersse.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace tesseract {
+void ClassPrunerCountsSSE(const uint32_t* const* pruners, int num_pruners,
+                          const int* offsets, int num_features, int* counts) {
+  fprintf(stderr, "ClassPrunerCountsSSE can't be used on this build\n");
+  abort();
+}
+void ProtoDistancesSSE(const uint32_t* protos, int n, int x, int y,
+                       int theta, int theta_fudge, int mult_shift,
+                       int mult_mask, int table_shift, int table_mask,
+                       uint32_t* distances) {
+  fprintf(stderr, "ProtoDistancesSSE can't be used on this build\n");
+  abort();
+}
+}  // namespace tesseract
+
+#else  // !defined(__SSE4_1__)
+
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <stdint.h>
+#include "intmatchersse.h"
+
+namespace tesseract {
+
+// Classes in each class pruner, 16 in each of its 2 words.
+const int kClassesPerPruner = 32;
+// Classes whose weights are in each byte of a pruner word.
+const int kClassesPerByte = 4;
+// Bytes of pruner words, so classes of each weight position, in a register.
+const int kBytesPerRegister = 4;
+// Registers holding the 8 bytes of the 2 pruner words.
+const int kRegistersPerFeature = 2;
+
+// Sums the class pruner weights of num_features features for every class of
+// num_pruners class pruners, adding the sums to counts.
+// Uses Intel SSE4.1 intrinsics to access the SIMD instruction set.
+void ClassPrunerCountsSSE(const uint32_t* const* pruners, int num_pruners,
+                          const int* offsets, int num_features, int* counts) {
+  const __m128i mask = _mm_set1_epi32(3);
+  for (int p = 0; p < num_pruners; ++p) {
+    const uint32_t* pruner = pruners[p];
+    // Each byte of the 2 pruner words goes to a 32 bit lane, of sums[0] for
+    // the first word and of sums[1] for the second. sums[r][j] adds up the
+    // weight at bits 2j of the lanes, so lane i of sums[r][j] is the count of
+    // class 16 * r + kClassesPerByte * i + j.
+    __m128i sums[kRegistersPerFeature][kClassesPerByte];
+    for (int r = 0; r < kRegistersPerFeature; ++r) {
+      for (int j = 0; j < kClassesPerByte; ++j)
+        sums[r][j] = _mm_setzero_si128();
+    }
+    for (int f = 0; f < num_features; ++f) {
+      __m128i words = _mm_loadl_epi64(
+          reinterpret_cast<const __m128i*>(pruner + offsets[f]));
+      for (int r = 0; r < kRegistersPerFeature; ++r) {
+        __m128i bytes = _mm_cvtepu8_epi32(r == 0 ? words
+                                                 : _mm_srli_si128(words, 4));
+        sums[r][0] = _mm_add_epi32(sums[r][0], _mm_and_si128(bytes, mask));
+        sums[r][1] = _mm_add_epi32(
+            sums[r][1], _mm_and_si128(_mm_srli_epi32(bytes, 2), mask));
+        sums[r][2] = _mm_add_epi32(
+            sums[r][2], _mm_and_si128(_mm_srli_epi32(bytes, 4), mask));
+        sums[r][3] = _mm_add_epi32(sums[r][3], _mm_srli_epi32(bytes, 6));
+      }
+    }
+    int* class_counts = counts + p * kClassesPerPruner;
+    for (int r = 0; r < kRegistersPerFeature; ++r) {
+      int32_t lanes[kClassesPerByte][kBytesPerRegister];
+      for (int j = 0; j < kClassesPerByte; ++j) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[j]), sums[r][j]);
+      }
+      for (int i = 0; i < kBytesPerRegister; ++i) {
+        for (int j = 0; j < kClassesPerByte; ++j) {
+          class_counts[(r * kBytesPerRegister + i) * kClassesPerByte + j] +=
+              lanes[j][i];
+        }
+      }
+    }
+  }
+}
+
+// Computes the feature to proto distances of the integer matcher for n
+// protos against the feature at x, y, theta, 4 protos at a time.
+// Uses Intel SSE4.1 intrinsics to access the SIMD instruction set.
+void ProtoDistancesSSE(const uint32_t* protos, int n, int x, int y,
+                       int theta, int theta_fudge, int mult_shift,
+                       int mult_mask, int table_shift, int table_mask,
+                       uint32_t* distances) {
+  const __m128i feature_x = _mm_set1_epi32(x - 128);
+  const __m128i feature_y = _mm_set1_epi32(y - 128);
+  const __m128i feature_theta = _mm_set1_epi32(theta);
+  const __m128i fudge = _mm_set1_epi32(theta_fudge);
+  const __m128i byte_mask = _mm_set1_epi32(0xff);
+  const __m128i max_mult = _mm_set1_epi32(mult_mask);
+  const __m128i max_distance = _mm_set1_epi32(table_mask + 1);
+  const __m128i mult_count = _mm_cvtsi32_si128(mult_shift);
+  const __m128i table_count = _mm_cvtsi32_si128(table_shift);
+  for (int i = 0; i < n; i += 4) {
+    __m128i packed =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(protos + i));
+    __m128i a = _mm_srai_epi32(_mm_slli_epi32(packed, 24), 24);
+    __m128i b = _mm_and_si128(_mm_srli_epi32(packed, 8), byte_mask);
+    __m128i c = _mm_srai_epi32(_mm_slli_epi32(packed, 8), 24);
+    __m128i angle = _mm_srli_epi32(packed, 24);
+    // A3 = ((A * (X - 128)) << 1) - B * (Y - 128) + (C << 9).
+    __m128i a3 = _mm_slli_epi32(_mm_mullo_epi32(a, feature_x), 1);
+    a3 = _mm_sub_epi32(a3, _mm_mullo_epi32(b, feature_y));
+    a3 = _mm_add_epi32(a3, _mm_slli_epi32(c, 9));
+    // M3 = ((inT8)(Theta - Angle) * theta_fudge) << 1.
+    __m128i m3 = _mm_sub_epi32(feature_theta, angle);
+    m3 = _mm_srai_epi32(_mm_slli_epi32(m3, 24), 24);
+    m3 = _mm_slli_epi32(_mm_mullo_epi32(m3, fudge), 1);
+    // Negative values are complemented, not negated, as in the scalar code.
+    a3 = _mm_xor_si128(a3, _mm_srai_epi32(a3, 31));
+    m3 = _mm_xor_si128(m3, _mm_srai_epi32(m3, 31));
+    a3 = _mm_min_epi32(_mm_sra_epi32(a3, mult_count), max_mult);
+    m3 = _mm_min_epi32(_mm_sra_epi32(m3, mult_count), max_mult);
+    __m128i a4 =
+        _mm_add_epi32(_mm_mullo_epi32(a3, a3), _mm_mullo_epi32(m3, m3));
+    a4 = _mm_min_epu32(_mm_srl_epi32(a4, table_count), max_distance);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(distances + i), a4);
+  }
+}
+
+}  // namespace tesseract.
+
+#endif  // !defined(__SSE4_1__)
@@ -18,17 +18,25 @@
 
 #include "intsimdmatrix.h"
 #include "intsimdmatrixavx2.h"
+#include "intsimdmatrixavx512.h"
 #include "intsimdmatrixsse.h"
 #include "simddetect.h"
 
 namespace tesseract {
 
+// Alignment in bytes of the weights written by SerializeShaped.
+const int kShapedAlignment = 64;
+// Number of values describing the layout of the reshaped weights.
+const int kNumLayoutValues = 5;
+
 // Factory makes and returns an IntSimdMatrix (sub)class of the best
 // available type for the current architecture.
 /* static */
 IntSimdMatrix* IntSimdMatrix::GetFastestMultiplier() {
   IntSimdMatrix* multiplier = nullptr;
-  if (SIMDDetect::IsAVX2Available()) {
+  if (SIMDDetect::IsAVX512BWAvailable()) {
+    multiplier = new IntSimdMatrixAVX512();
+  } else if (SIMDDetect::IsAVX2Available()) {
     multiplier = new IntSimdMatrixAVX2();
   } else if (SIMDDetect::IsSSEAvailable()) {
     multiplier = new IntSimdMatrixSSE();
@@ -43,13 +51,12 @@ IntSimdMatrix* IntSimdMatrix::GetFastestMultiplier() {
 // partial_funcs_, it does nothing.
 void IntSimdMatrix::Init(const GENERIC_2D_ARRAY<int8_t>& w) {
   if (partial_funcs_.empty()) return;
+  shaped_view_ = nullptr;
   int num_out = w.dim1();
   int num_in = w.dim2() - 1;
-  // The rounded-up sizes of the reshaped weight matrix, excluding biases.
-  int rounded_num_in = Roundup(num_in, num_inputs_per_group_);
   int rounded_num_out = RoundOutputs(num_out);
   // Add the bias and compute the required size.
-  shaped_w_.resize((rounded_num_in + 1) * rounded_num_out, 0);
+  shaped_w_.assign(ShapedSize(w), 0);
   int shaped_index = 0;
   int output = 0;
   // Each number of registers needs a different format! Iterates over the
@@ -87,6 +94,65 @@ void IntSimdMatrix::Init(const GENERIC_2D_ARRAY<int8_t>& w) {
   }
 }
 
+// Writes the layout of the reshaped copy of w and the reshaped weights
+// themselves, padded to start on a cache line boundary of fp.
+bool IntSimdMatrix::SerializeShaped(const GENERIC_2D_ARRAY<int8_t>& w,
+                                    TFile* fp) const {
+  int32_t layout[kNumLayoutValues] = {
+      num_outputs_per_register_, max_output_registers_,
+      num_inputs_per_register_, num_inputs_per_group_, num_input_groups_};
+  if (fp->FWrite(layout, sizeof(layout[0]), kNumLayoutValues) !=
+      kNumLayoutValues)
+    return false;
+  int32_t size = IsShaped() ? ShapedSize(w) : 0;
+  if (fp->FWrite(&size, sizeof(size), 1) != 1) return false;
+  // The padding is relative to the start of the component, which is itself
+  // aligned in an aligned traineddata file.
+  int data_start = fp->Tell() + sizeof(int32_t);
+  int32_t padding =
+      (kShapedAlignment - data_start % kShapedAlignment) % kShapedAlignment;
+  if (fp->FWrite(&padding, sizeof(padding), 1) != 1) return false;
+  static const char kZeros[kShapedAlignment] = {0};
+  if (padding > 0 && fp->FWrite(kZeros, 1, padding) != padding) return false;
+  return size == 0 || fp->FWrite(ShapedData(), 1, size) == size;
+}
+
+// Reads the weights written by SerializeShaped for w, using them as they
+// are if they have the right layout.
+bool IntSimdMatrix::DeSerializeShaped(const GENERIC_2D_ARRAY<int8_t>& w,
+                                      TFile* fp) {
+  int32_t layout[kNumLayoutValues];
+  if (fp->FReadEndian(layout, sizeof(layout[0]), kNumLayoutValues) !=
+      kNumLayoutValues)
+    return false;
+  int32_t size, padding;
+  if (fp->FReadEndian(&size, sizeof(size), 1) != 1) return false;
+  if (fp->FReadEndian(&padding, sizeof(padding), 1) != 1) return false;
+  if (size < 0 || padding < 0 || padding >= kShapedAlignment) return false;
+  if (padding > 0 && fp->FRead(nullptr, 1, padding) != padding) return false;
+  bool same_layout = IsShaped() && size == ShapedSize(w) &&
+                     layout[0] == num_outputs_per_register_ &&
+                     layout[1] == max_output_registers_ &&
+                     layout[2] == num_inputs_per_register_ &&
+                     layout[3] == num_inputs_per_group_ &&
+                     layout[4] == num_input_groups_;
+  if (!same_layout) {
+    // Shaped for some other machine.
+    if (size > 0 && fp->FRead(nullptr, 1, size) != size) return false;
+    Init(w);
+    return true;
+  }
+  const char* view = fp->ReadView(1, size);
+  if (view != nullptr) {
+    shaped_w_.clear();
+    shaped_view_ = reinterpret_cast<const int8_t*>(view);
+    return true;
+  }
+  shaped_view_ = nullptr;
+  shaped_w_.resize(size);
+  return fp->FRead(shaped_w_.data(), 1, size) == size;
+}
+
 // Computes matrix.vector v = Wu.
 // u is of size W.dim2() - 1 and the output v is of size W.dim1().
 // u is imagined to have an extra element at the end with value 1, to
@@ -106,7 +172,7 @@ void IntSimdMatrix::MatrixDotVector(const GENERIC_2D_ARRAY<int8_t>& w,
       v[i] = (static_cast<double>(total) / MAX_INT8 + wi[num_in]) * scales[i];
     }
   } else {
-    const int8_t* w_data = shaped_w_.data();
+    const int8_t* w_data = ShapedData();
     const double* scales_data = &scales[0];
     // Each call to a partial_func_ produces group_size outputs, except the
     // last one, which can produce less.
@@ -66,7 +66,8 @@ class IntSimdMatrix {
         max_output_registers_(1),
         num_inputs_per_register_(1),
         num_inputs_per_group_(1),
-        num_input_groups_(1) {}
+        num_input_groups_(1),
+        shaped_view_(nullptr) {}
 
   // Factory makes and returns an IntSimdMatrix (sub)class of the best
   // available type for the current architecture.
@@ -75,6 +76,18 @@ class IntSimdMatrix {
   // Computes a reshaped copy of the weight matrix w. If there are no
   // partial_funcs_, it does nothing.
   void Init(const GENERIC_2D_ARRAY<int8_t>& w);
+  // Returns true if Init computes a reshaped copy of the weights, which
+  // SerializeShaped can save.
+  bool IsShaped() const { return !partial_funcs_.empty(); }
+  // Writes the layout of the reshaped copy of w and the reshaped weights
+  // themselves, padded to start on a cache line boundary of fp.
+  // Returns false in case of error.
+  bool SerializeShaped(const GENERIC_2D_ARRAY<int8_t>& w, TFile* fp) const;
+  // Reads the weights written by SerializeShaped for w. If they were shaped
+  // for the layout this instance uses, they are used as they are, in place
+  // if fp is a view, otherwise they are skipped and Init(w) computes them
+  // again. Returns false in case of error.
+  bool DeSerializeShaped(const GENERIC_2D_ARRAY<int8_t>& w, TFile* fp);
 
   // Rounds the size up to a multiple of the input register size (in int8_t).
   int RoundInputs(int size) const {
@@ -113,6 +126,15 @@ class IntSimdMatrix {
   static int Roundup(int input, int factor) {
     return (input + factor - 1) / factor * factor;
   }
+  // Returns the size of the reshaped copy of w made by Init.
+  int ShapedSize(const GENERIC_2D_ARRAY<int8_t>& w) const {
+    return (Roundup(w.dim2() - 1, num_inputs_per_group_) + 1) *
+           RoundOutputs(w.dim1());
+  }
+  // Returns the reshaped weights, wherever they are.
+  const int8_t* ShapedData() const {
+    return shaped_view_ != nullptr ? shaped_view_ : shaped_w_.data();
+  }
 
   // Number of 32 bit outputs held in each register.
   int num_outputs_per_register_;
@@ -126,6 +148,9 @@ class IntSimdMatrix {
   int num_input_groups_;
   // The weights matrix reorganized in whatever way suits this instance.
   std::vector<int8_t> shaped_w_;
+  // Reshaped weights used in place from a mapped model instead of shaped_w_,
+  // or nullptr.
+  const int8_t* shaped_view_;
   // A series of functions to compute a partial result.
   std::vector<PartialFunc> partial_funcs_;
 };
@@ -0,0 +1,240 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intsimdmatrixavx512.cpp
+// Description: matrix-vector product for 8-bit data on avx512.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "intsimdmatrixavx512.h"
+#include "simddetect.h"
+
+#ifdef __AVX512BW__
+#include <immintrin.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace tesseract {
+
+// Number of outputs held in each register. 16 x 32 bit ints.
+constexpr int kNumOutputsPerRegister = 16;
+// Maximum number of registers that we will use.
+constexpr int kMaxOutputRegisters = 8;
+// Number of inputs in the inputs register.
+constexpr int kNumInputsPerRegister = 64;
+// Number of inputs in each weight group.
+constexpr int kNumInputsPerGroup = 4;
+// Number of groups of inputs to be broadcast.
+constexpr int kNumInputGroups = kNumInputsPerRegister / kNumInputsPerGroup;
+
+// Computes one set of 4x16 products of inputs and weights, adding to result.
+// Horizontally adds 4 adjacent results, making 16x32-bit results.
+// rep_input is assumed to be a 16x replicated set of 4x8-bit signed integers.
+// As for avx2, wi must previously have been re-organized with blocks of 4x16
+// weights in contiguous memory, and is incremented by the amount read.
+// There is no 512 bit sign instruction, so the signs of the weights are moved
+// onto the inputs with a masked negate, leaving the weights always +ve.
+// kVnni selects the single dot product instruction of AVX512-VNNI over the
+// pair of multiply-adds, which gives the same results, as the 16 bit sums of
+// 2 products of 7 bit magnitudes cannot saturate.
+template <bool kVnni>
+inline void MultiplyGroup(const __m512i& rep_input, const __m512i& ones,
+                          const int8_t*& wi, __m512i& result);
+
+template <>
+inline void MultiplyGroup<false>(const __m512i& rep_input, const __m512i& ones,
+                                 const int8_t*& wi, __m512i& result) {
+  // Load a 4x16 block of weights.
+  __m512i weights = _mm512_loadu_si512(reinterpret_cast<const void*>(wi));
+  wi += kNumInputsPerRegister;
+  __mmask64 negative = _mm512_movepi8_mask(weights);
+  __m512i reps = _mm512_mask_sub_epi8(rep_input, negative,
+                                      _mm512_setzero_si512(), rep_input);
+  weights = _mm512_abs_epi8(weights);
+  // Multiply 64x8-bit weights by 64x8-bit reps to make 32x16-bit results,
+  // with adjacent pairs added, then multiply by 16-bit ones to add the
+  // adjacent pairs again into 16x32-bit results.
+  weights = _mm512_maddubs_epi16(weights, reps);
+  weights = _mm512_madd_epi16(weights, ones);
+  result = _mm512_add_epi32(result, weights);
+}
+
+#ifdef __AVX512VNNI__
+template <>
+inline void MultiplyGroup<true>(const __m512i& rep_input, const __m512i& ones,
+                                const int8_t*& wi, __m512i& result) {
+  // Load a 4x16 block of weights.
+  __m512i weights = _mm512_loadu_si512(reinterpret_cast<const void*>(wi));
+  wi += kNumInputsPerRegister;
+  __mmask64 negative = _mm512_movepi8_mask(weights);
+  __m512i reps = _mm512_mask_sub_epi8(rep_input, negative,
+                                      _mm512_setzero_si512(), rep_input);
+  weights = _mm512_abs_epi8(weights);
+  // Multiply and add groups of 4 adjacent products straight into result.
+  result = _mm512_dpbusd_epi32(result, weights, reps);
+}
+#endif  // __AVX512VNNI__
+
+// Returns the next 4 inputs at u, replicated 16 times.
+inline __m512i ReplicateGroup(const int8_t* u) {
+  int32_t group;
+  memcpy(&group, u, sizeof(group));
+  return _mm512_set1_epi32(group);
+}
+
+// Extracts and converts 16x32-bit results from result, adding the bias from
+// wi and scaling by scales, before storing in *v. Note that wi, scales and v
+// are expected to contain 16 consecutive elements or num_out if less.
+inline void ExtractResults(const __m512i& result, const int8_t*& wi,
+                           const double*& scales, int num_out, double*& v) {
+  int32_t res[kNumOutputsPerRegister];
+  _mm512_storeu_si512(reinterpret_cast<void*>(res), result);
+  for (int out = 0; out < num_out; ++out) {
+    *v++ = (static_cast<double>(res[out]) / MAX_INT8 + *wi++) * *scales++;
+  }
+}
+
+// Computes part of matrix.vector v = Wu. Computes N=128 results.
+// The weights *must* be arranged so that consecutive reads from wi
+// provides (num_in/kNumInputsPerGroup groups of (N output dim groups of
+// (kNumInputsPerGroup inputs))). After that there must be N consecutive
+// bias weights, before continuing with any more weights.
+// u must be padded out with zeros to
+// kNumInputsPerGroup*ceil(num_in/kNumInputsPerGroup) elements.
+// Unlike avx2, each group of inputs is broadcast straight from memory, as
+// there is no cheaper way to rotate a 512 bit register.
+template <bool kVnni>
+static void PartialMatrixDotVector128(const int8_t* wi, const double* scales,
+                                      const int8_t* u, int num_in, int num_out,
+                                      double* v) {
+  // Register containing 16-bit ones for horizontal add with 16->32 bit
+  // conversion.
+  __m512i ones = _mm512_set1_epi16(1);
+  // Initialize all the results to 0.
+  __m512i result0 = _mm512_setzero_si512();
+  __m512i result1 = _mm512_setzero_si512();
+  __m512i result2 = _mm512_setzero_si512();
+  __m512i result3 = _mm512_setzero_si512();
+  __m512i result4 = _mm512_setzero_si512();
+  __m512i result5 = _mm512_setzero_si512();
+  __m512i result6 = _mm512_setzero_si512();
+  __m512i result7 = _mm512_setzero_si512();
+  for (int j = 0; j < num_in; j += kNumInputsPerGroup) {
+    __m512i rep_input = ReplicateGroup(u + j);
+    // Mul-add, with horizontal add of the 4 inputs to each of the results.
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result0);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result1);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result2);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result3);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result4);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result5);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result6);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result7);
+  }
+  ExtractResults(result0, wi, scales, kNumOutputsPerRegister, v);
+  ExtractResults(result1, wi, scales, kNumOutputsPerRegister, v);
+  ExtractResults(result2, wi, scales, kNumOutputsPerRegister, v);
+  ExtractResults(result3, wi, scales, kNumOutputsPerRegister, v);
+  ExtractResults(result4, wi, scales, kNumOutputsPerRegister, v);
+  ExtractResults(result5, wi, scales, kNumOutputsPerRegister, v);
+  ExtractResults(result6, wi, scales, kNumOutputsPerRegister, v);
+  num_out -= kNumOutputsPerRegister * 7;
+  ExtractResults(result7, wi, scales,
+                 std::min(kNumOutputsPerRegister, num_out), v);
+}
+
+// Computes part of matrix.vector v = Wu. Computes N=64 results.
+// For details see PartialMatrixDotVector128 with N=64.
+template <bool kVnni>
+static void PartialMatrixDotVector64(const int8_t* wi, const double* scales,
+                                     const int8_t* u, int num_in, int num_out,
+                                     double* v) {
+  __m512i ones = _mm512_set1_epi16(1);
+  __m512i result0 = _mm512_setzero_si512();
+  __m512i result1 = _mm512_setzero_si512();
+  __m512i result2 = _mm512_setzero_si512();
+  __m512i result3 = _mm512_setzero_si512();
+  for (int j = 0; j < num_in; j += kNumInputsPerGroup) {
+    __m512i rep_input = ReplicateGroup(u + j);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result0);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result1);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result2);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result3);
+  }
+  ExtractResults(result0, wi, scales, kNumOutputsPerRegister, v);
+  ExtractResults(result1, wi, scales, kNumOutputsPerRegister, v);
+  ExtractResults(result2, wi, scales, kNumOutputsPerRegister, v);
+  num_out -= kNumOutputsPerRegister * 3;
+  ExtractResults(result3, wi, scales,
+                 std::min(kNumOutputsPerRegister, num_out), v);
+}
+
+// Computes part of matrix.vector v = Wu. Computes N=32 results.
+// For details see PartialMatrixDotVector128 with N=32.
+template <bool kVnni>
+static void PartialMatrixDotVector32(const int8_t* wi, const double* scales,
+                                     const int8_t* u, int num_in, int num_out,
+                                     double* v) {
+  __m512i ones = _mm512_set1_epi16(1);
+  __m512i result0 = _mm512_setzero_si512();
+  __m512i result1 = _mm512_setzero_si512();
+  for (int j = 0; j < num_in; j += kNumInputsPerGroup) {
+    __m512i rep_input = ReplicateGroup(u + j);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result0);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result1);
+  }
+  ExtractResults(result0, wi, scales, kNumOutputsPerRegister, v);
+  num_out -= kNumOutputsPerRegister;
+  ExtractResults(result1, wi, scales,
+                 std::min(kNumOutputsPerRegister, num_out), v);
+}
+
+// Computes part of matrix.vector v = Wu. Computes N=16 results.
+// For details see PartialMatrixDotVector128 with N=16.
+template <bool kVnni>
+static void PartialMatrixDotVector16(const int8_t* wi, const double* scales,
+                                     const int8_t* u, int num_in, int num_out,
+                                     double* v) {
+  __m512i ones = _mm512_set1_epi16(1);
+  __m512i result0 = _mm512_setzero_si512();
+  for (int j = 0; j < num_in; j += kNumInputsPerGroup) {
+    __m512i rep_input = ReplicateGroup(u + j);
+    MultiplyGroup<kVnni>(rep_input, ones, wi, result0);
+  }
+  ExtractResults(result0, wi, scales, num_out, v);
+}
+#else
+namespace tesseract {
+#endif  // __AVX512BW__
+
+IntSimdMatrixAVX512::IntSimdMatrixAVX512() {
+#ifdef __AVX512BW__
+  num_outputs_per_register_ = kNumOutputsPerRegister;
+  max_output_registers_ = kMaxOutputRegisters;
+  num_inputs_per_register_ = kNumInputsPerRegister;
+  num_inputs_per_group_ = kNumInputsPerGroup;
+  num_input_groups_ = kNumInputGroups;
+#ifdef __AVX512VNNI__
+  if (SIMDDetect::IsAVX512VNNIAvailable()) {
+    partial_funcs_ = {
+        PartialMatrixDotVector128<true>, PartialMatrixDotVector64<true>,
+        PartialMatrixDotVector32<true>, PartialMatrixDotVector16<true>};
+    return;
+  }
+#endif  // __AVX512VNNI__
+  partial_funcs_ = {
+      PartialMatrixDotVector128<false>, PartialMatrixDotVector64<false>,
+      PartialMatrixDotVector32<false>, PartialMatrixDotVector16<false>};
+#endif  // __AVX512BW__
+}
+
+}  // namespace tesseract.
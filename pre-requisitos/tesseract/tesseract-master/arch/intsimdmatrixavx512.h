@@ -0,0 +1,32 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intsimdmatrixavx512.h
+// Description: AVX-512 implementation of 8-bit int SIMD matrix multiply.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+#ifndef TESSERACT_ARCH_INTSIMDMATRIXAVX512_H_
+#define TESSERACT_ARCH_INTSIMDMATRIXAVX512_H_
+
+#include "intsimdmatrix.h"
+
+namespace tesseract {
+
+// AVX-512BW implementation of IntSimdMatrix, using the VNNI dot product
+// instruction instead of the multiply-add pair if the cpu has it.
+class IntSimdMatrixAVX512 : public IntSimdMatrix {
+ public:
+  IntSimdMatrixAVX512();
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_ARCH_INTSIMDMATRIXAVX512_H_
@@ -40,6 +40,7 @@ bool SIMDDetect::avx_available_;
 bool SIMDDetect::avx2_available_;
 bool SIMDDetect::avx512F_available_;
 bool SIMDDetect::avx512BW_available_;
+bool SIMDDetect::avx512VNNI_available_;
 // If true, then SSe4.1 has been detected.
 bool SIMDDetect::sse_available_;
 
@@ -65,6 +66,7 @@ SIMDDetect::SIMDDetect() {
       avx2_available_ = (ebx & 0x00000020) != 0;
       avx512F_available_ = (ebx & 0x00010000) != 0;
       avx512BW_available_ = (ebx & 0x40000000) != 0;
+      avx512VNNI_available_ = (ecx & 0x00000800) != 0;
     }
   }
 #elif defined(_WIN32)
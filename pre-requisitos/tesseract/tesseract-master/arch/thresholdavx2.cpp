@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdavx2.cpp
+// Description: Architecture-specific kernel of the Otsu thresholder.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+// This code can't compile without "-mavx2", so use dummy stubs.
+
+#include "thresholdavx2.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace tesseract {
+void ThresholdRowAVX2(const uint32_t* src, int num_channels, int num_words,
+                      const int* thresholds, const int* hi_values,
+                      uint32_t* dst) {
+  fprintf(stderr, "ThresholdRowAVX2 can't be used on this build\n");
+  abort();
+}
+}  // namespace tesseract
+
+#else  // !defined(__AVX2__)
+
+#include <immintrin.h>
+#include <stdint.h>
+#include "thresholdavx2.h"
+
+namespace tesseract {
+
+// Makes the tests of ThresholdRowAVX2 for each byte of a pixel word in
+// memory, where channel ch of a 32 bit pixel is byte 3 - ch. A byte passes
+// when ((value ^ 0x80) > *threshold, as signed bytes) ^ *invert) & *enable
+// is not zero.
+static void MakeByteTests(int num_channels, const int* thresholds,
+                          const int* hi_values, __m256i* threshold,
+                          __m256i* invert, __m256i* enable) {
+  uint32_t threshold_word = 0, invert_word = 0, enable_word = 0;
+  for (int b = 0; b < 4; ++b) {
+    int ch = num_channels == 1 ? 0 : 3 - b;
+    if (hi_values[ch] < 0) continue;
+    threshold_word |= ((thresholds[ch] ^ 0x80) & 0xff) << (8 * b);
+    if (hi_values[ch] != 0) invert_word |= 0xffu << (8 * b);
+    enable_word |= 0xffu << (8 * b);
+  }
+  *threshold = _mm256_set1_epi32(threshold_word);
+  *invert = _mm256_set1_epi32(invert_word);
+  *enable = _mm256_set1_epi32(enable_word);
+}
+
+// Thresholds 32 * num_words pixels of a row of an 8 or 32 bit leptonica
+// image to num_words words of 1 bit pixels.
+// Uses Intel AVX2 intrinsics to access the SIMD instruction set.
+void ThresholdRowAVX2(const uint32_t* src, int num_channels, int num_words,
+                      const int* thresholds, const int* hi_values,
+                      uint32_t* dst) {
+  __m256i threshold, invert, enable;
+  MakeByteTests(num_channels, thresholds, hi_values, &threshold, &invert,
+                &enable);
+  const __m256i sign = _mm256_set1_epi8(static_cast<char>(0x80));
+  const __m256i* data = reinterpret_cast<const __m256i*>(src);
+  if (num_channels == 1) {
+    // Pixel x is byte x ^ 3 in memory, so reversing the words puts pixel
+    // 31 - b in byte b, and the mask of the bytes is that of the pixels.
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    for (int w = 0; w < num_words; ++w, ++data) {
+      __m256i v = _mm256_xor_si256(_mm256_loadu_si256(data), sign);
+      __m256i on = _mm256_xor_si256(_mm256_cmpgt_epi8(v, threshold), invert);
+      on = _mm256_permutevar8x32_epi32(_mm256_and_si256(on, enable), reverse);
+      dst[w] = _mm256_movemask_epi8(on);
+    }
+  } else {
+    // The packs below leave the groups of 4 pixels in the order 0, 2, 4, 6,
+    // 1, 3, 5, 7. Put them back in reverse order, then reverse the bytes of
+    // each group, so that byte b holds pixel 31 - b.
+    const __m256i reverse_groups = _mm256_setr_epi32(7, 3, 6, 2, 5, 1, 4, 0);
+    const __m256i reverse_bytes =
+        _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                         3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i zero = _mm256_setzero_si256();
+    for (int w = 0; w < num_words; ++w) {
+      // -1 in each pixel that passes no test, 8 pixels per register.
+      __m256i off[4];
+      for (int i = 0; i < 4; ++i, ++data) {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256(data), sign);
+        __m256i on =
+            _mm256_xor_si256(_mm256_cmpgt_epi8(v, threshold), invert);
+        off[i] = _mm256_cmpeq_epi32(_mm256_and_si256(on, enable), zero);
+      }
+      __m256i bytes =
+          _mm256_packs_epi16(_mm256_packs_epi32(off[0], off[1]),
+                             _mm256_packs_epi32(off[2], off[3]));
+      bytes = _mm256_permutevar8x32_epi32(bytes, reverse_groups);
+      bytes = _mm256_shuffle_epi8(bytes, reverse_bytes);
+      dst[w] = ~static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+    }
+  }
+}
+
+}  // namespace tesseract.
+
+#endif  // !defined(__AVX2__)
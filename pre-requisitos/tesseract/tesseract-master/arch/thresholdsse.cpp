@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdsse.cpp
+// Description: Architecture-specific kernel of the Otsu thresholder.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__SSE4_1__)
+// This code can't compile without "-msse4.1", so use dummy stubs.
+
+#include "thresholdsse.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace tesseract {
+void ThresholdRowSSE(const uint32_t* src, int num_channels, int num_words,
+                     const int* thresholds, const int* hi_values,
+                     uint32_t* dst) {
+  fprintf(stderr, "ThresholdRowSSE can't be used on this build\n");
+  abort();
+}
+}  // namespace tesseract
+
+#else  // !defined(__SSE4_1__)
+
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <stdint.h>
+#include "thresholdsse.h"
+
+namespace tesseract {
+
+// Makes the tests of ThresholdRowSSE for each byte of a pixel word in
+// memory, where channel ch of a 32 bit pixel is byte 3 - ch. A byte passes
+// when ((value ^ 0x80) > *threshold, as signed bytes) ^ *invert) & *enable
+// is not zero.
+static void MakeByteTests(int num_channels, const int* thresholds,
+                          const int* hi_values, __m128i* threshold,
+                          __m128i* invert, __m128i* enable) {
+  uint32_t threshold_word = 0, invert_word = 0, enable_word = 0;
+  for (int b = 0; b < 4; ++b) {
+    int ch = num_channels == 1 ? 0 : 3 - b;
+    if (hi_values[ch] < 0) continue;
+    threshold_word |= ((thresholds[ch] ^ 0x80) & 0xff) << (8 * b);
+    if (hi_values[ch] != 0) invert_word |= 0xffu << (8 * b);
+    enable_word |= 0xffu << (8 * b);
+  }
+  *threshold = _mm_set1_epi32(threshold_word);
+  *invert = _mm_set1_epi32(invert_word);
+  *enable = _mm_set1_epi32(enable_word);
+}
+
+// Thresholds 32 * num_words pixels of a row of an 8 or 32 bit leptonica
+// image to num_words words of 1 bit pixels.
+// Uses Intel SSE4.1 intrinsics to access the SIMD instruction set.
+void ThresholdRowSSE(const uint32_t* src, int num_channels, int num_words,
+                     const int* thresholds, const int* hi_values,
+                     uint32_t* dst) {
+  __m128i threshold, invert, enable;
+  MakeByteTests(num_channels, thresholds, hi_values, &threshold, &invert,
+                &enable);
+  const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+  const __m128i* data = reinterpret_cast<const __m128i*>(src);
+  if (num_channels == 1) {
+    for (int w = 0; w < num_words; ++w, data += 2) {
+      // Pixel x is byte x ^ 3 in memory, so reversing the words puts pixel
+      // 15 - b in byte b, and the mask of the bytes is that of the pixels.
+      uint32_t halves[2];
+      for (int h = 0; h < 2; ++h) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128(data + h), sign);
+        __m128i on = _mm_xor_si128(_mm_cmpgt_epi8(v, threshold), invert);
+        on = _mm_shuffle_epi32(_mm_and_si128(on, enable), 0x1b);
+        halves[h] = _mm_movemask_epi8(on);
+      }
+      dst[w] = (halves[0] << 16) | halves[1];
+    }
+  } else {
+    // Reverses bytes, so that byte b holds pixel 15 - b.
+    const __m128i reverse =
+        _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i zero = _mm_setzero_si128();
+    for (int w = 0; w < num_words; ++w) {
+      uint32_t halves[2];
+      for (int h = 0; h < 2; ++h) {
+        // -1 in each pixel that passes no test, 4 pixels per register.
+        __m128i off[4];
+        for (int i = 0; i < 4; ++i, ++data) {
+          __m128i v = _mm_xor_si128(_mm_loadu_si128(data), sign);
+          __m128i on = _mm_xor_si128(_mm_cmpgt_epi8(v, threshold), invert);
+          off[i] = _mm_cmpeq_epi32(_mm_and_si128(on, enable), zero);
+        }
+        __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(off[0], off[1]),
+                                        _mm_packs_epi32(off[2], off[3]));
+        bytes = _mm_shuffle_epi8(bytes, reverse);
+        halves[h] = ~_mm_movemask_epi8(bytes) & 0xffff;
+      }
+      dst[w] = (halves[0] << 16) | halves[1];
+    }
+  }
+}
+
+}  // namespace tesseract.
+
+#endif  // !defined(__SSE4_1__)
@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdsse.h
+// Description: Architecture-specific kernel of the Otsu thresholder.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_THRESHOLDSSE_H_
+#define TESSERACT_ARCH_THRESHOLDSSE_H_
+
+#include <stdint.h>
+
+namespace tesseract {
+
+// Thresholds 32 * num_words pixels of a row of an 8 or 32 bit leptonica
+// image to num_words words of 1 bit pixels, pixel x going to the most
+// significant bit first, as in a leptonica image. num_channels (1 or 4) is
+// the bytes per pixel, and src must hold pixel 0 in its first word. A pixel
+// is set when for any channel ch with hi_values[ch] >= 0 the test
+// (value > thresholds[ch]) == (hi_values[ch] == 0) holds, as in
+// ImageThresholder::ThresholdRectToPix.
+// Uses Intel SSE4.1 intrinsics to access the SIMD instruction set.
+void ThresholdRowSSE(const uint32_t* src, int num_channels, int num_words,
+                     const int* thresholds, const int* hi_values,
+                     uint32_t* dst);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_ARCH_THRESHOLDSSE_H_
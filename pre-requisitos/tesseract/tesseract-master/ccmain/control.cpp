@@ -40,12 +40,14 @@
 #include "lstmrecognizer.h"
 #include "ocrclass.h"
 #include "output.h"
+#include "pageprofile.h"
 #include "pgedit.h"
 #include "reject.h"
 #include "sorthelper.h"
 #include "tessbox.h"
 #include "tesseractclass.h"
 #include "tessvars.h"
+#include "tracing.h"
 #include "werdit.h"
 
 #define MIN_FONT_ROW_COUNT  8
@@ -55,6 +57,15 @@ const char* const kBackUpConfigFile = "tempconfigdata.config";
 // Min believable x-height for any text when refitting as a fraction of
 // original x-height
 const double kMinRefitXHeightFraction = 0.5;
+// Min number of acceptable words voted before the document language is
+// chosen, so that a nearly blank page does not decide it.
+const int kMinLanguageVoteWords = 20;
+// Words recognized before RecogAllWordsPassN trusts their rate to tell if
+// the rest of the page will miss the deadline.
+const int kMinDeadlineWords = 4;
+// Margin on the projected time of the rest of a page, as the words or lines
+// left may be harder than the average so far.
+const double kDeadlineSafetyFactor = 1.25;
 
 
 /**
@@ -193,6 +204,7 @@ void Tesseract::SetupWordPassN(int pass_n, WordData* word) {
       WERD_RES* word_res = new WERD_RES;
       word_res->InitForRetryRecognition(*word->word);
       word->lang_words.push_back(word_res);
+      if (SkipLanguage(lang_t)) continue;
       // LSTM doesn't get setup for pass2.
       if (pass_n == 1 || lang_t->tessedit_ocr_engine_mode != OEM_LSTM_ONLY) {
         word_res->SetupForRecognition(
@@ -209,12 +221,17 @@ void Tesseract::SetupWordPassN(int pass_n, WordData* word) {
 // Runs word recognition on all the words.
 bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
                                    PAGE_RES_IT* pr_it,
-                                   GenericVector<WordData>* words) {
+                                   GenericVector<WordData>* words,
+                                   bool* make_last_fuzzy) {
+  double start_left = monitor != NULL ? monitor->seconds_to_deadline() : 0.0;
   // TODO(rays) Before this loop can be parallelized (it would yield a massive
   // speed-up) all remaining member globals need to be converted to local/heap
   // (eg set_pass1 and set_pass2) and an intermediate adaption pass needs to be
   // added. The results will be significantly different with adaption on, and
   // deterioration will need investigation.
+  // RecogAllWordsPass1Par gets around this for pass 1 by running independent
+  // rows on separate copies of the languages.
+  if (make_last_fuzzy != NULL) *make_last_fuzzy = false;
   pr_it->restart_page();
   for (int w = 0; w < words->size(); ++w) {
     WordData* word = &(*words)[w];
@@ -243,6 +260,10 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
         }
         return false;
       }
+      if (!deadline_mode_ && w >= kMinDeadlineWords &&
+          DeadlineApproaching(monitor, start_left, w, words->size())) {
+        SetDeadlineMode(true);
+      }
     }
     if (word->word->tess_failed) {
       int s;
@@ -256,7 +277,9 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
       pr_it->forward();
     ASSERT_HOST(pr_it->word() != NULL);
     bool make_next_word_fuzzy = false;
-    if (!AnyLSTMLang() &&
+    if (deadline_mode_ && !no_language_model_ && profile_ != NULL)
+      profile_->AddCount(PROFILE_DEGRADED, 1);
+    if (!AnyLSTMLang() && !deadline_mode_ &&
         ReassignDiacritics(pass_n, pr_it, &make_next_word_fuzzy)) {
       // Needs to be setup again to see the new outlines in the chopped_word.
       SetupWordPassN(pass_n, word);
@@ -271,11 +294,25 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
     pr_it->forward();
     if (make_next_word_fuzzy && pr_it->word() != NULL) {
       pr_it->MakeCurrentWordFuzzy();
+    } else if (make_last_fuzzy != NULL && w + 1 == words->size()) {
+      *make_last_fuzzy = make_next_word_fuzzy;
     }
   }
   return true;
 }
 
+// Returns true if the rest of the total items, after done of them took the
+// time since start_left, would not be done before the deadline of monitor.
+bool Tesseract::DeadlineApproaching(const ETEXT_DESC* monitor,
+                                    double start_left, int done,
+                                    int total) const {
+  if (!tessedit_deadline_degrade || monitor == NULL || done <= 0)
+    return false;
+  double left = monitor->seconds_to_deadline();
+  double elapsed = start_left - left;
+  return elapsed * (total - done) / done * kDeadlineSafetyFactor > left;
+}
+
 /**
  * recog_all_words()
  *
@@ -302,16 +339,24 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
                                 const TBOX* target_word_box,
                                 const char* word_config,
                                 int dopasses) {
+  TESS_TRACE_SPAN("Tesseract::recog_all_words");
   PAGE_RES_IT page_res_it(page_res);
+  page_res->rejection_deferred = false;
 
   if (tessedit_minimal_rej_pass1) {
     tessedit_test_adaption.set_value (TRUE);
     tessedit_minimal_rejection.set_value (TRUE);
   }
 
+  double pass1_left = monitor != NULL ? monitor->seconds_to_deadline() : 0.0;
   if (dopasses==0 || dopasses==1) {
     page_res_it.restart_page();
     // ****************** Pass 1 *******************
+    ProfileTimer timer(profile_, PROFILE_PASS1);
+    // Without a language model the whole page is recognized the cheap way
+    // the deadline mode recognizes the rest of a late page.
+    SetNoLanguageModel(tessedit_no_language_model);
+    SetDeadlineMode(no_language_model_);
 
     // If the adaptive classifier is full switch to one we prepared earlier,
     // ie on the previous page. If the current adaptive classifier is non-empty,
@@ -330,16 +375,6 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
         sub_langs_[i]->StartBackupAdaptiveClassifier();
       }
     }
-    // Set up all words ready for recognition, so that if parallelism is on
-    // all the input and output classes are ready to run the classifier.
-    GenericVector<WordData> words;
-    SetupAllWordsPassN(1, target_word_box, word_config, page_res, &words);
-    if (tessedit_parallelize) {
-      PrerecAllWordsPar(words);
-    }
-
-    stats_.word_count = words.size();
-
     stats_.dict_words = 0;
     stats_.doc_blob_quality = 0;
     stats_.doc_outline_errs = 0;
@@ -348,8 +383,36 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     stats_.doc_good_char_quality = 0;
 
     most_recently_used_ = this;
-    // Run pass 1 word recognition.
-    if (!RecogAllWordsPassN(1, monitor, &page_res_it, &words)) return false;
+    bool pass1_ok;
+    int pass1_threads = Pass1Threads(page_res, monitor, target_word_box);
+    if (pass1_threads > 1) {
+      // Run pass 1 word recognition on groups of rows in parallel.
+      pass1_ok = RecogAllWordsPass1Par(pass1_threads, page_res, monitor);
+    } else {
+      // Set up all words ready for recognition, so that if parallelism is on
+      // all the input and output classes are ready to run the classifier.
+      GenericVector<WordData> words;
+      SetupAllWordsPassN(1, target_word_box, word_config, page_res, &words);
+      if (tessedit_parallelize) {
+        PrerecAllWordsPar(words);
+      }
+#ifndef ANDROID_BUILD
+      LSTMPrerecAllWords(words, monitor);
+#endif
+
+      stats_.word_count = words.size();
+
+      // Run pass 1 word recognition.
+      pass1_ok = RecogAllWordsPassN(1, monitor, &page_res_it, &words, NULL);
+#ifndef ANDROID_BUILD
+      ClearLSTMPrerecWords();
+#endif
+    }
+    if (!pass1_ok) return false;
+    if (!language_votes_.empty() && document_language_ == NULL) {
+      ++language_votes_.back();
+      DecideDocumentLanguage();
+    }
     // Pass 1 post-processing.
     for (page_res_it.restart_page(); page_res_it.word() != NULL;
          page_res_it.forward()) {
@@ -375,8 +438,12 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
   if (dopasses == 1) return true;
 
   // ****************** Pass 2 *******************
+  // Pass 2 takes about as long as pass 1, so skip it if it can't fit.
+  if (!deadline_mode_ && DeadlineApproaching(monitor, pass1_left, 1, 2))
+    SetDeadlineMode(true);
   if (tessedit_tess_adaption_mode != 0x0 && !tessedit_test_adaption &&
-      AnyTessLang()) {
+      AnyTessLang() && !deadline_mode_) {
+    ProfileTimer timer(profile_, PROFILE_PASS2);
     page_res_it.restart_page();
     GenericVector<WordData> words;
     SetupAllWordsPassN(2, target_word_box, word_config, page_res, &words);
@@ -385,7 +452,8 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     }
     most_recently_used_ = this;
     // Run pass 2 word recognition.
-    if (!RecogAllWordsPassN(2, monitor, &page_res_it, &words)) return false;
+    if (!RecogAllWordsPassN(2, monitor, &page_res_it, &words, NULL))
+      return false;
   }
 
   // The next passes are only required for Tess-only.
@@ -395,18 +463,28 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     set_global_loc_code(LOC_FUZZY_SPACE);
 
     if (!tessedit_test_adaption && tessedit_fix_fuzzy_spaces
-        && !tessedit_word_for_word && !right_to_left())
+        && !tessedit_word_for_word && !right_to_left() && !deadline_mode_)
       fix_fuzzy_spaces(monitor, stats_.word_count, page_res);
 
     // ****************** Pass 4 *******************
-    if (tessedit_enable_dict_correction) dictionary_correction_pass(page_res);
-    if (tessedit_enable_bigram_correction) bigram_correction_pass(page_res);
+    if (!no_language_model_) {
+      if (tessedit_enable_dict_correction)
+        dictionary_correction_pass(page_res);
+      if (tessedit_enable_bigram_correction) bigram_correction_pass(page_res);
+    }
 
     // ****************** Pass 5,6 *******************
-    rejection_passes(page_res, monitor, target_word_box, word_config);
+    // Only the reject maps and unlv_crunch_modes depend on these, so unless
+    // output_pass below writes them they wait for RunDeferredRejection.
+    bool writes_results =
+        (dopasses == 0 || dopasses == 2) && (monitor || tessedit_write_unlv);
+    if (tessedit_lazy_rejection && !writes_results && target_word_box == NULL)
+      page_res->rejection_deferred = true;
+    else
+      rejection_passes(page_res, monitor, target_word_box, word_config);
 
     // ****************** Pass 8 *******************
-    font_recognition_pass(page_res);
+    if (font_recognition_) font_recognition_pass(page_res);
 
     // ****************** Pass 9 *******************
     // Check the correctness of the final results.
@@ -691,6 +769,12 @@ void Tesseract::rejection_passes(PAGE_RES* page_res,
   }
 }
 
+void Tesseract::RunDeferredRejection(PAGE_RES* page_res) {
+  if (page_res == NULL || !page_res->rejection_deferred) return;
+  page_res->rejection_deferred = false;
+  rejection_passes(page_res, NULL, NULL, NULL);
+}
+
 void Tesseract::blamer_pass(PAGE_RES* page_res) {
   if (!wordrec_run_blamer) return;
   PAGE_RES_IT page_res_it(page_res);
@@ -921,6 +1005,17 @@ static bool WordsAcceptable(const PointerVector<WERD_RES>& words) {
   return true;
 }
 
+// Returns true if the LSTM result words are accepted by the dictionary and
+// stopper, and none has a certainty below min_certainty.
+static bool LSTMWordsSure(const PointerVector<WERD_RES>& words,
+                          double min_certainty) {
+  if (!WordsAcceptable(words)) return false;
+  for (int w = 0; w < words.size(); ++w) {
+    if (words[w]->best_choice->certainty() < min_certainty) return false;
+  }
+  return true;
+}
+
 // Moves good-looking "noise"/diacritics from the reject list to the main
 // blob list on the current word. Returns true if anything was done, and
 // sets make_next_word_fuzzy if blob(s) were added to the end of the word.
@@ -1304,6 +1399,8 @@ void Tesseract::classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
       most_recently_used_ = word->tesseract;
     return;
   }
+  // Once the document language is chosen, it is the only one set up.
+  if (document_language_ != NULL) most_recently_used_ = document_language_;
   int sub = sub_langs_.size();
   if (most_recently_used_ != this) {
     // Get the index of the most_recently_used_.
@@ -1313,25 +1410,41 @@ void Tesseract::classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
   most_recently_used_->RetryWithLanguage(
       *word_data, recognizer, debug, &word_data->lang_words[sub], &best_words);
   Tesseract* best_lang_tess = most_recently_used_;
-  if (!WordsAcceptable(best_words)) {
+  if (!WordsAcceptable(best_words) && document_language_ == NULL &&
+      !deadline_mode_) {
     // Try all the other languages to see if they are any better.
-    if (most_recently_used_ != this &&
-        this->RetryWithLanguage(*word_data, recognizer, debug,
-                                &word_data->lang_words[sub_langs_.size()],
-                                &best_words) > 0) {
-      best_lang_tess = this;
+    int retries = 0;
+    if (most_recently_used_ != this) {
+      ++retries;
+      if (this->RetryWithLanguage(*word_data, recognizer, debug,
+                                  &word_data->lang_words[sub_langs_.size()],
+                                  &best_words) > 0) {
+        best_lang_tess = this;
+      }
     }
     for (int i = 0; !WordsAcceptable(best_words) && i < sub_langs_.size();
          ++i) {
-      if (most_recently_used_ != sub_langs_[i] &&
-          sub_langs_[i]->RetryWithLanguage(*word_data, recognizer, debug,
+      if (most_recently_used_ == sub_langs_[i]) continue;
+      ++retries;
+      if (sub_langs_[i]->RetryWithLanguage(*word_data, recognizer, debug,
                                            &word_data->lang_words[i],
                                            &best_words) > 0) {
         best_lang_tess = sub_langs_[i];
       }
     }
+    if (profile_ != NULL) profile_->AddCount(PROFILE_RETRIES, retries);
   }
   most_recently_used_ = best_lang_tess;
+  if (pass_n == 1 && multilang_vote_pages > 0 && !sub_langs_.empty() &&
+      document_language_ == NULL && WordsAcceptable(best_words)) {
+    if (language_votes_.empty())
+      language_votes_.init_to_size(sub_langs_.size() + 2, 0);
+    // The sub_langs_.size() entry is for the master language.
+    int lang = 0;
+    while (lang < sub_langs_.size() && sub_langs_[lang] != best_lang_tess)
+      ++lang;
+    ++language_votes_[lang];
+  }
   if (!best_words.empty()) {
     if (best_words.size() == 1 && !best_words[0]->combination) {
       // Move the best single result to the main word.
@@ -1353,6 +1466,38 @@ void Tesseract::classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
   }
 }
 
+// Replaces the document language vote and decides on it.
+void Tesseract::SetLanguageVotes(const GenericVector<int>& votes) {
+  ResetLanguageVote();
+  if (votes.size() != sub_langs_.size() + 2) return;
+  language_votes_ = votes;
+  DecideDocumentLanguage();
+}
+
+// Chooses the document language once enough pages have voted and one
+// language got multilang_vote_ratio of the words.
+void Tesseract::DecideDocumentLanguage() {
+  if (multilang_vote_pages <= 0 || language_votes_.empty() ||
+      language_votes_.back() < multilang_vote_pages)
+    return;
+  int num_langs = sub_langs_.size() + 1;
+  int total = 0;
+  int best = 0;
+  for (int s = 0; s < num_langs; ++s) {
+    total += language_votes_[s];
+    if (language_votes_[s] > language_votes_[best]) best = s;
+  }
+  // Too few words to tell, keep voting on the next pages.
+  if (total < kMinLanguageVoteWords) return;
+  if (language_votes_[best] < multilang_vote_ratio * total) return;
+  document_language_ = best < sub_langs_.size() ? sub_langs_[best] : this;
+  if (multilang_debug_level > 0) {
+    tprintf("Document language is %s, with %d of %d words in %d pages\n",
+            document_language_->lang.string(), language_votes_[best], total,
+            language_votes_.back());
+  }
+}
+
 /**
  * classify_word_pass1
  *
@@ -1369,9 +1514,16 @@ void Tesseract::classify_word_pass1(const WordData& word_data,
 #ifndef ANDROID_BUILD
   if (tessedit_ocr_engine_mode == OEM_LSTM_ONLY ||
       tessedit_ocr_engine_mode == OEM_TESSERACT_LSTM_COMBINED) {
-    if (!(*in_word)->odd_size || tessedit_ocr_engine_mode == OEM_LSTM_ONLY) {
+    // In the deadline mode, odd words don't wait for tesseract either.
+    if (!(*in_word)->odd_size || tessedit_ocr_engine_mode == OEM_LSTM_ONLY ||
+        deadline_mode_) {
       LSTMRecognizeWord(*block, row, *in_word, out_words);
-      if (!out_words->empty())
+      // In the combined mode, words the LSTM is unsure of may also be given
+      // to tesseract, keeping them in out_words to compare with its result.
+      if (!out_words->empty() &&
+          (tessedit_ocr_engine_mode == OEM_LSTM_ONLY ||
+           !lstm_legacy_on_doubt || deadline_mode_ ||
+           LSTMWordsSure(*out_words, lstm_legacy_min_certainty)))
         return;  // Successful lstm recognition.
     }
     if (tessedit_ocr_engine_mode == OEM_LSTM_ONLY) {
@@ -1391,21 +1543,41 @@ void Tesseract::classify_word_pass1(const WordData& word_data,
   match_word_pass_n(1, word, row, block);
   if (!word->tess_failed && !word->word->flag(W_REP_CHAR)) {
     word->tess_would_adapt = AdaptableWord(word);
-    bool adapt_ok = word_adaptable(word, tessedit_tess_adaption_mode);
-
-    if (adapt_ok) {
-      // Send word to adaptive classifier for training.
-      word->BestChoiceToCorrectText();
-      LearnWord(NULL, word);
-      // Mark misadaptions if running blamer.
-      if (word->blamer_bundle != NULL) {
-        word->blamer_bundle->SetMisAdaptionDebug(word->best_choice,
-                                                 wordrec_debug_blamer);
-      }
+    // RecogAllWordsPass1Par does the rest for the best result of each word.
+    if (!defer_adaption_) {
+      if (!deadline_mode_) AdaptToPass1Word(word);
+
+      if (tessedit_enable_doc_dict && !word->IsAmbiguous())
+        tess_add_doc_word(word->best_choice);
     }
+  }
+  if (!out_words->empty()) {
+    // The LSTM was unsure of its words, so keep the better of them and the
+    // tesseract word, unless tesseract failed.
+    if (word->tess_failed || word->best_choice == NULL) return;
+    PointerVector<WERD_RES> tess_words;
+    tess_words.push_back(word);
+    *in_word = NULL;
+    SelectBestWords(classify_max_rating_ratio, classify_max_certainty_margin,
+                    classify_debug_level > 0, &tess_words, out_words);
+  }
+}
 
-    if (tessedit_enable_doc_dict && !word->IsAmbiguous())
-      tess_add_doc_word(word->best_choice);
+// Sends the pass 1 result word to the adaptive classifier for training,
+// if it is good enough.
+void Tesseract::AdaptToPass1Word(WERD_RES* word) {
+  bool adapt_ok = word_adaptable(word, tessedit_tess_adaption_mode);
+
+  if (adapt_ok) {
+    ProfileTimer timer(profile_, PROFILE_ADAPTATION);
+    // Send word to adaptive classifier for training.
+    word->BestChoiceToCorrectText();
+    LearnWord(NULL, word);
+    // Mark misadaptions if running blamer.
+    if (word->blamer_bundle != NULL) {
+      word->blamer_bundle->SetMisAdaptionDebug(word->best_choice,
+                                               wordrec_debug_blamer);
+    }
   }
 }
 
@@ -115,7 +115,9 @@ void Tesseract::fix_fuzzy_spaces(ETEXT_DESC *monitor,
             debug_fix_space_level.set_value(10);
           if (word_res->word->cblob_list()->empty())
             prevent_null_wd_fixsp = TRUE;
-          if (prevent_null_wd_fixsp) {
+          if (prevent_null_wd_fixsp ||
+              fuzzy_gaps_are_spaces(word_res_it_from, word_res_it_to.data(),
+                                    row_res_it.data()->row)) {
             word_res_it_from = word_res_it_to;
           } else {
             fuzzy_space_words.assign_to_sublist(&word_res_it_from,
@@ -142,6 +144,33 @@ void Tesseract::fix_fuzzy_spaces(ETEXT_DESC *monitor,
   }
 }
 
+/**
+ * @name fuzzy_gaps_are_spaces()
+ * Cheap check before the search of fix_fuzzy_space_list, which classifies a
+ * new combination word for every distinct gap width in the run. Returns TRUE
+ * if every gap between the words from word_it to last_word is at least
+ * fixsp_clear_space_ratio times the space size of the row, so that no
+ * joining is plausible and the run can keep its spacing unsearched.
+ */
+BOOL8 Tesseract::fuzzy_gaps_are_spaces(WERD_RES_IT word_it,
+                                       WERD_RES *last_word,
+                                       ROW *row) {
+  if (fixsp_clear_space_ratio <= 0.0 || row->space() <= 0)
+    return FALSE;
+  double min_space = fixsp_clear_space_ratio * row->space();
+  inT16 prev_right = word_it.data()->word->bounding_box().right();
+  while (word_it.data() != last_word) {
+    word_it.forward();
+    TBOX box = word_it.data()->word->bounding_box();
+    if (box.left() - prev_right < min_space)
+      return FALSE;
+    prev_right = box.right();
+  }
+  if (debug_fix_space_level > 1)
+    tprintf("Fuzzy spaces all wider than %g, not searched\n", min_space);
+  return TRUE;
+}
+
 void Tesseract::fix_fuzzy_space_list(WERD_RES_LIST &best_perm,
                                      ROW *row,
                                      BLOCK* block) {
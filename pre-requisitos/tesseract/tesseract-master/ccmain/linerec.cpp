@@ -21,11 +21,14 @@
 #include "allheaders.h"
 #include "boxread.h"
 #include "imagedata.h"
+#include "kdpair.h"
 #ifndef ANDROID_BUILD
+#include "input.h"
 #include "lstmrecognizer.h"
 #include "recodebeam.h"
 #endif
 #include "ndminx.h"
+#include "pageprofile.h"
 #include "pageres.h"
 #include "tprintf.h"
 
@@ -216,33 +219,198 @@ ImageData* Tesseract::GetRectImage(const TBOX& box, const BLOCK& block,
 }
 
 #ifndef ANDROID_BUILD
-// Recognizes a word or group of words, converting to WERD_RES in *words.
-// Analogous to classify_word_pass1, but can handle a group of words as well.
-void Tesseract::LSTMRecognizeWord(const BLOCK& block, ROW *row, WERD_RES *word,
-                                  PointerVector<WERD_RES>* words) {
+// Returns the box of word that LSTMRecognizeWord recognizes, before the
+// padding, widened to the ascenders and descenders of the row.
+static TBOX LSTMWordBox(const Tesseract& tess, ROW* row, const WERD_RES* word) {
   TBOX word_box = word->word->bounding_box();
   // Get the word image - no frills.
-  if (tessedit_pageseg_mode == PSM_SINGLE_WORD ||
-      tessedit_pageseg_mode == PSM_RAW_LINE) {
+  if (tess.tessedit_pageseg_mode == PSM_SINGLE_WORD ||
+      tess.tessedit_pageseg_mode == PSM_RAW_LINE) {
     // In single word mode, use the whole image without any other row/word
     // interpretation.
-    word_box = TBOX(0, 0, ImageWidth(), ImageHeight());
+    word_box = TBOX(0, 0, tess.ImageWidth(), tess.ImageHeight());
   } else {
-    float baseline = row->base_line((word_box.left() + word_box.right()) / 2);
+    float baseline =
+        row->base_line((word_box.left() + word_box.right()) / 2);
     if (baseline + row->descenders() < word_box.bottom())
       word_box.set_bottom(baseline + row->descenders());
     if (baseline + row->x_height() + row->ascenders() > word_box.top())
       word_box.set_top(baseline + row->x_height() + row->ascenders());
   }
-  ImageData* im_data = GetRectImage(word_box, block, kImagePadding, &word_box);
+  return word_box;
+}
+
+// Returns the image LSTMRecognizeWord recognizes for word, setting word_box
+// to the box it covers, or NULL if there is none.
+ImageData* Tesseract::GetLSTMWordImage(const BLOCK& block, ROW* row,
+                                       const WERD_RES* word, TBOX* word_box) {
+  *word_box = LSTMWordBox(*this, row, word);
+  return GetRectImage(*word_box, block, kImagePadding, word_box);
+}
+
+// Number of line images LSTMWordImage keeps.
+const int kNumLSTMLineImages = 4;
+
+// As GetLSTMWordImage, but the image, prescaled to target_height, belongs
+// to the line images of the master language, which keep the last few.
+const ImageData* Tesseract::LSTMWordImage(const BLOCK& block, ROW* row,
+                                          const WERD_RES* word,
+                                          int target_height, TBOX* word_box) {
+  TBOX box = LSTMWordBox(*this, row, word);
+  Pix* source = BestPix();
+  GenericVector<LSTMLineImage>& line_images =
+      lstm_line_images_owner_->lstm_line_images_;
+  LSTMLineImage* line_image = NULL;
+  for (int i = 0; i < line_images.size() && line_image == NULL; ++i) {
+    if (line_images[i].source == source && line_images[i].box == box &&
+        line_images[i].rotation == block.re_rotation())
+      line_image = &line_images[i];
+  }
+  if (line_image == NULL) {
+    TBOX revised_box;
+    ImageData* image = GetRectImage(box, block, kImagePadding, &revised_box);
+    if (image == NULL) return NULL;
+    int& next = lstm_line_images_owner_->lstm_line_images_next_;
+    if (line_images.size() < kNumLSTMLineImages) {
+      line_images.push_back(LSTMLineImage());
+      next = line_images.size() - 1;
+    } else {
+      pixDestroy(&line_images[next].source);
+      delete line_images[next].image;
+    }
+    line_image = &line_images[next];
+    next = (next + 1) % kNumLSTMLineImages;
+    line_image->source = pixClone(source);
+    line_image->box = box;
+    line_image->rotation = block.re_rotation();
+    line_image->revised_box = revised_box;
+    line_image->image = image;
+    line_image->scaled_height = -1;
+  }
+  if (line_image->scaled_height != target_height) {
+    line_image->image->CachePreScaled(target_height, kMaxInputHeight);
+    line_image->scaled_height = target_height;
+  }
+  *word_box = line_image->revised_box;
+  return line_image->image;
+}
+
+// Frees the line images of LSTMWordImage.
+void Tesseract::ClearLSTMLineImages() {
+  for (int i = 0; i < lstm_line_images_.size(); ++i) {
+    pixDestroy(&lstm_line_images_[i].source);
+    delete lstm_line_images_[i].image;
+  }
+  lstm_line_images_.clear();
+  lstm_line_images_next_ = 0;
+}
+
+// Recognizes a word or group of words, converting to WERD_RES in *words.
+// Analogous to classify_word_pass1, but can handle a group of words as well.
+void Tesseract::LSTMRecognizeWord(const BLOCK& block, ROW *row, WERD_RES *word,
+                                  PointerVector<WERD_RES>* words) {
+  // Words are mostly taken in the order they were recognized ahead, so the
+  // search starts at the one expected next.
+  int num_prerec = lstm_prerec_words_.size();
+  for (int i = 0; i < num_prerec; ++i) {
+    int index = (lstm_prerec_next_ + i) % num_prerec;
+    if (lstm_prerec_words_[index] != word) continue;
+    PointerVector<WERD_RES>* results = lstm_prerec_results_[index];
+    for (int w = 0; w < results->size(); ++w) {
+      words->push_back((*results)[w]);
+      (*results)[w] = NULL;
+    }
+    results->truncate(0);
+    lstm_prerec_words_[index] = NULL;
+    lstm_prerec_next_ = index + 1;
+    SearchWords(words);
+    return;
+  }
+  ProfileTimer timer(profile_, PROFILE_LSTM);
+  TBOX word_box;
+  const ImageData* im_data =
+      LSTMWordImage(block, row, word, lstm_recognizer_->NumInputs(),
+                    &word_box);
   if (im_data == NULL) return;
+  lstm_recognizer_->SetFastBeamSearch(lstm_fast_beam_search ||
+                                     deadline_mode_);
+  lstm_recognizer_->SetUseDict(!no_language_model_);
   lstm_recognizer_->RecognizeLine(*im_data, true, classify_debug_level > 0,
                                   kWorstDictCertainty / kCertaintyScale,
                                   word_box, words);
-  delete im_data;
   SearchWords(words);
 }
 
+// Recognizes ahead, lstm_batch_size lines at a time, the words that pass 1
+// will give to LSTMRecognizeWord in the master language, keeping the results
+// for LSTMRecognizeWord to pick up.
+void Tesseract::LSTMPrerecAllWords(const GenericVector<WordData>& words,
+                                   ETEXT_DESC* monitor) {
+  ClearLSTMPrerecWords();
+  if (lstm_recognizer_ == NULL || lstm_batch_size <= 1 ||
+      classify_debug_level > 0)
+    return;
+  if (tessedit_ocr_engine_mode != OEM_LSTM_ONLY &&
+      tessedit_ocr_engine_mode != OEM_TESSERACT_LSTM_COMBINED)
+    return;
+  if (SkipLanguage(this)) return;
+  ProfileTimer timer(profile_, PROFILE_LSTM);
+  PointerVector<ImageData> images;
+  GenericVector<TBOX> boxes;
+  // Index into images of each word by width, so that a batch holds lines of
+  // similar widths and wastes little on padding.
+  GenericVector<KDPairInc<int, int> > order;
+  for (int w = 0; w < words.size(); ++w) {
+    const WordData& word_data = words[w];
+    if (word_data.word->done ||
+        word_data.lang_words.size() <= sub_langs_.size())
+      continue;
+    const WERD_RES* word = word_data.lang_words[sub_langs_.size()];
+    if (word->odd_size && tessedit_ocr_engine_mode != OEM_LSTM_ONLY) continue;
+    TBOX word_box;
+    ImageData* im_data =
+        GetLSTMWordImage(*word_data.block, word_data.row, word, &word_box);
+    if (im_data == NULL) continue;
+    order.push_back(KDPairInc<int, int>(word_box.width(), images.size()));
+    images.push_back(im_data);
+    boxes.push_back(word_box);
+    lstm_prerec_words_.push_back(word);
+    lstm_prerec_results_.push_back(new PointerVector<WERD_RES>);
+  }
+  order.sort();
+  lstm_recognizer_->SetFastBeamSearch(lstm_fast_beam_search ||
+                                     deadline_mode_);
+  lstm_recognizer_->SetUseDict(!no_language_model_);
+  double start_left = monitor != NULL ? monitor->seconds_to_deadline() : 0.0;
+  for (int start = 0; start < order.size(); start += lstm_batch_size) {
+    if (!deadline_mode_ &&
+        DeadlineApproaching(monitor, start_left, start, order.size())) {
+      SetDeadlineMode(true);
+      lstm_recognizer_->SetFastBeamSearch(true);
+    }
+    int end = MIN(start + lstm_batch_size, order.size());
+    GenericVector<const ImageData*> batch_images;
+    GenericVector<TBOX> batch_boxes;
+    GenericVector<PointerVector<WERD_RES>*> batch_words;
+    for (int i = start; i < end; ++i) {
+      int index = order[i].data;
+      batch_images.push_back(images[index]);
+      batch_boxes.push_back(boxes[index]);
+      batch_words.push_back(lstm_prerec_results_[index]);
+    }
+    lstm_recognizer_->RecognizeLines(batch_images, true, false,
+                                     kWorstDictCertainty / kCertaintyScale,
+                                     batch_boxes, batch_words);
+  }
+}
+
+// Frees the results of LSTMPrerecAllWords that were not picked up.
+void Tesseract::ClearLSTMPrerecWords() {
+  lstm_prerec_words_.clear();
+  lstm_prerec_results_.clear();
+  lstm_prerec_next_ = 0;
+}
+
 // Apply segmentation search to the given set of words, within the constraints
 // of the existing ratings matrix. If there is already a best_choice on a word
 // leaves it untouched and just sets the done/accepted etc flags.
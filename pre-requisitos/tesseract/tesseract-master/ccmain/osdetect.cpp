@@ -46,6 +46,11 @@ const float kHanRatioInJapanese = 0.3;
 
 const float kNonAmbiguousMargin = 1.0;
 
+// With osd_fast, the page is reduced by 2 or 4 while it stays at least this
+// resolution, which still leaves enough pixels in body text to classify.
+const int kMinReducedOsdResolution = 150;
+const int kMaxOsdReduction = 4;
+
 // General scripts
 static const char* han_script = "Han";
 static const char* latin_script = "Latin";
@@ -151,24 +156,26 @@ void OSResults::accumulate(const OSResults& osr) {
   update_best_script(best_result.orientation_id);
 }
 
-// Detect and erase horizontal/vertical lines and picture regions from the
-// image, so that non-text blobs are removed from consideration.
-void remove_nontext_regions(tesseract::Tesseract *tess, BLOCK_LIST *blocks,
+// Returns the resolution of pix, or kMinCredibleResolution if it has none.
+static int CredibleResolution(Pix* pix) {
+  if (kMinCredibleResolution > pixGetXRes(pix)) {
+    tprintf("Warning. Invalid resolution %d dpi. Using %d instead.\n",
+            pixGetXRes(pix), kMinCredibleResolution);
+    return kMinCredibleResolution;
+  }
+  return pixGetXRes(pix);
+}
+
+// Detect and erase horizontal/vertical lines and picture regions from pix,
+// so that non-text blobs are removed from consideration.
+void remove_nontext_regions(tesseract::Tesseract *tess, Pix* pix,
+                            int resolution, BLOCK_LIST *blocks,
                             TO_BLOCK_LIST *to_blocks) {
-  Pix *pix = tess->pix_binary();
   ASSERT_HOST(pix != NULL);
   int vertical_x = 0;
   int vertical_y = 1;
   tesseract::TabVector_LIST v_lines;
   tesseract::TabVector_LIST h_lines;
-  int resolution;
-  if (kMinCredibleResolution > pixGetXRes(pix)) {
-    resolution = kMinCredibleResolution;
-    tprintf("Warning. Invalid resolution %d dpi. Using %d instead.\n",
-            pixGetXRes(pix), resolution);
-  } else {
-    resolution = pixGetXRes(pix);
-  }
 
   tesseract::LineFinder::FindAndRemoveLines(resolution, false, pix,
                                             &vertical_x, &vertical_y,
@@ -178,8 +185,7 @@ void remove_nontext_regions(tesseract::Tesseract *tess, BLOCK_LIST *blocks,
     pixSubtract(pix, pix, im_pix);
     pixDestroy(&im_pix);
   }
-  tess->mutable_textord()->find_components(tess->pix_binary(),
-                                           blocks, to_blocks);
+  tess->mutable_textord()->find_components(pix, blocks, to_blocks);
 }
 
 // Find connected components in the page and process a subset until finished or
@@ -196,22 +202,46 @@ int orientation_and_script_detection(STRING& filename,
   if (lastdot != NULL)
     name[lastdot-name.string()] = '\0';
 
-  ASSERT_HOST(tess->pix_binary() != NULL)
-  int width = pixGetWidth(tess->pix_binary());
-  int height = pixGetHeight(tess->pix_binary());
+  Pix* pix = tess->pix_binary();
+  ASSERT_HOST(pix != NULL)
+  int width = pixGetWidth(pix);
+  int height = pixGetHeight(pix);
+  int resolution = CredibleResolution(pix);
 
   BLOCK_LIST blocks;
-  if (!read_unlv_file(name, width, height, &blocks))
+  bool fast = tess->osd_fast;
+  if (read_unlv_file(name, width, height, &blocks)) {
+    // The zones are in the coordinates of the full page.
+    fast = false;
+  }
+  // Blobs are found on a reduced copy of the page if it is fine enough, as
+  // orientation is as clear from fewer pixels and they take less time.
+  int reduction = 1;
+  while (fast && reduction < kMaxOsdReduction &&
+         resolution / (reduction * 2) >= kMinReducedOsdResolution)
+    reduction *= 2;
+  if (reduction > 1) {
+    pix = pixReduceRankBinaryCascade(pix, 2, reduction > 2 ? 2 : 0, 0, 0);
+    if (pix == NULL) {
+      pix = tess->pix_binary();
+      reduction = 1;
+    } else {
+      width = pixGetWidth(pix);
+      height = pixGetHeight(pix);
+      resolution /= reduction;
+      pixSetResolution(pix, resolution, resolution);
+    }
+  }
+  if (blocks.empty())
     FullPageBlock(width, height, &blocks);
 
   // Try to remove non-text regions from consideration.
   TO_BLOCK_LIST land_blocks, port_blocks;
-  remove_nontext_regions(tess, &blocks, &port_blocks);
+  remove_nontext_regions(tess, pix, resolution, &blocks, &port_blocks);
 
   if (port_blocks.empty()) {
     // page segmentation did not succeed, so we need to find_components first.
-    tess->mutable_textord()->find_components(tess->pix_binary(),
-                                             &blocks, &port_blocks);
+    tess->mutable_textord()->find_components(pix, &blocks, &port_blocks);
   } else {
     page_box.set_left(0);
     page_box.set_bottom(0);
@@ -222,13 +252,16 @@ int orientation_and_script_detection(STRING& filename,
                                           &port_blocks, true);
   }
 
-  return os_detect(&port_blocks, osr, tess);
+  if (reduction > 1) pixDestroy(&pix);
+
+  float min_margin = tess->osd_fast ? tess->min_orientation_margin : 0.0;
+  return os_detect(&port_blocks, min_margin, osr, tess);
 }
 
 // Filter and sample the blobs.
 // Returns a non-zero number of blobs if the page was successfully processed, or
 // zero if the page had too few characters to be reliable
-int os_detect(TO_BLOCK_LIST* port_blocks, OSResults* osr,
+int os_detect(TO_BLOCK_LIST* port_blocks, float min_margin, OSResults* osr,
               tesseract::Tesseract* tess) {
   int blobs_total = 0;
   TO_BLOCK_IT block_it;
@@ -261,7 +294,7 @@ int os_detect(TO_BLOCK_LIST* port_blocks, OSResults* osr,
       filtered_it.add_to_end(bbox);
     }
   }
-  return os_detect_blobs(NULL, &filtered_list, osr, tess);
+  return os_detect_blobs(NULL, &filtered_list, min_margin, osr, tess);
 }
 
 // Detect orientation and script from a list of blobs.
@@ -271,14 +304,14 @@ int os_detect(TO_BLOCK_LIST* port_blocks, OSResults* osr,
 // constrains both orientation and script detection to consider only scripts
 // from the list.
 int os_detect_blobs(const GenericVector<int>* allowed_scripts,
-                    BLOBNBOX_CLIST* blob_list, OSResults* osr,
-                    tesseract::Tesseract* tess) {
+                    BLOBNBOX_CLIST* blob_list, float min_margin,
+                    OSResults* osr, tesseract::Tesseract* tess) {
   OSResults osr_;
   if (osr == NULL)
     osr = &osr_;
 
   osr->unicharset = &tess->unicharset;
-  OrientationDetector o(allowed_scripts, osr);
+  OrientationDetector o(allowed_scripts, min_margin, osr);
   ScriptDetector s(allowed_scripts, osr, tess);
 
   BLOBNBOX_C_IT filtered_it(blob_list);
@@ -301,9 +334,12 @@ int os_detect_blobs(const GenericVector<int>* allowed_scripts,
   }
   QRSequenceGenerator sequence(number_of_blobs);
   int num_blobs_evaluated = 0;
+  // With a stopping margin, as few blobs as make a reliable page will do.
+  int min_to_try =
+      min_margin > 0.0f ? kMinCharactersToTry / 2 : kMinCharactersToTry;
   for (int i = 0; i < real_max; ++i) {
     if (os_detect_blob(blobs[sequence.GetVal()], &o, &s, osr, tess)
-        && i > kMinCharactersToTry) {
+        && i > min_to_try) {
       break;
     }
     ++num_blobs_evaluated;
@@ -366,8 +402,10 @@ bool os_detect_blob(BLOBNBOX* bbox, OrientationDetector* o,
 
 
 OrientationDetector::OrientationDetector(
-    const GenericVector<int>* allowed_scripts, OSResults* osr) {
+    const GenericVector<int>* allowed_scripts, float min_margin,
+    OSResults* osr) {
   osr_ = osr;
+  min_margin_ = min_margin;
   allowed_scripts_ = allowed_scripts;
 }
 
@@ -432,10 +470,10 @@ bool OrientationDetector::detect_blob(BLOB_CHOICE_LIST* scores) {
   for (int i = 0; total_blob_o_score != 0 && i < 4; ++i) {
     osr_->orientations[i] += log(blob_o_score[i] / total_blob_o_score);
   }
-
-  // TODO(ranjith) Add an early exit test, based on min_orientation_margin,
-  // as used in pagesegmain.cpp.
-  return false;
+  if (min_margin_ <= 0.0f) return false;
+  // The same margin as pagesegmain.cpp checks against min_orientation_margin.
+  osr_->update_best_orientation();
+  return osr_->best_result.oconfidence > min_margin_;
 }
 
 int OrientationDetector::get_orientation() {
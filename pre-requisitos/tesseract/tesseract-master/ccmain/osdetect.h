@@ -81,12 +81,15 @@ struct OSResults {
 
 class OrientationDetector {
  public:
+  // If min_margin is positive, detect_blob reports that the orientation is
+  // sure once the margin between the best two orientations exceeds it.
   OrientationDetector(const GenericVector<int>* allowed_scripts,
-                      OSResults* results);
+                      float min_margin, OSResults* results);
   bool detect_blob(BLOB_CHOICE_LIST* scores);
   int get_orientation();
  private:
   OSResults* osr_;
+  float min_margin_;
   const GenericVector<int>* allowed_scripts_;
 };
 
@@ -117,12 +120,14 @@ int orientation_and_script_detection(STRING& filename,
                                      OSResults*,
                                      tesseract::Tesseract*);
 
-int os_detect(TO_BLOCK_LIST* port_blocks,
+// If min_margin is positive, stop as soon as the orientation margin exceeds
+// it and the script is sure, instead of classifying a fixed number of blobs.
+int os_detect(TO_BLOCK_LIST* port_blocks, float min_margin,
               OSResults* osr,
               tesseract::Tesseract* tess);
 
 int os_detect_blobs(const GenericVector<int>* allowed_scripts,
-                    BLOBNBOX_CLIST* blob_list,
+                    BLOBNBOX_CLIST* blob_list, float min_margin,
                     OSResults* osr,
                     tesseract::Tesseract* tess);
 
@@ -33,6 +33,8 @@
 #include "config_auto.h"
 #endif
 
+#include <time.h>
+
 #include "allheaders.h"
 #include "blobbox.h"
 #include "blread.h"
@@ -177,6 +179,81 @@ int Tesseract::SegmentPage(const STRING* input_file, BLOCK_LIST* blocks,
   return auto_page_seg_ret_val;
 }
 
+// Moves the block and everything in it by shift.
+static void MoveBlock(const ICOORD& shift, BLOCK* block) {
+  block->move(shift);
+  if (block->poly_block() != NULL) block->poly_block()->move(shift);
+  ROW_IT row_it(block->row_list());
+  for (row_it.mark_cycle_pt(); !row_it.cycled_list(); row_it.forward()) {
+    ROW* row = row_it.data();
+    row->move(shift);
+    WERD_IT word_it(row->word_list());
+    for (word_it.mark_cycle_pt(); !word_it.cycled_list(); word_it.forward()) {
+      C_BLOB_IT blob_it(word_it.data()->rej_cblob_list());
+      for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward())
+        blob_it.data()->move(shift);
+    }
+  }
+  C_BLOB_IT blob_it(block->blob_list());
+  for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward())
+    blob_it.data()->move(shift);
+  blob_it.set_to_list(block->reject_blobs());
+  for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward())
+    blob_it.data()->move(shift);
+}
+
+// Segments the rectangle of the page at left, top (in image coordinates) on
+// its own with pageseg_mode, and adds the blocks found to the end of blocks.
+// The region is cut out of the thresholded page, so the page is not
+// thresholded again, and layout analysis only looks at the region.
+int Tesseract::SegmentRegion(int left, int top, int width, int height,
+                             PageSegMode pageseg_mode, BLOCK_LIST* blocks) {
+  ASSERT_HOST(pix_binary_ != NULL);
+  ASSERT_HOST(!PSM_OSD_ENABLED(pageseg_mode));
+  int page_height = pixGetHeight(pix_binary_);
+  Pix* page_binary = pix_binary_;
+  Pix* page_grey = pix_grey_;
+  Pix* page_thresholds = pix_thresholds_;
+  Box* box = boxCreate(left, top, width, height);
+  pix_binary_ = pixClipRectangle(page_binary, box, NULL);
+  pix_grey_ = page_grey != NULL ? pixClipRectangle(page_grey, box, NULL)
+                                : NULL;
+  pix_thresholds_ = page_thresholds != NULL
+      ? pixClipRectangle(page_thresholds, box, NULL) : NULL;
+  boxDestroy(&box);
+  int result = -1;
+  if (pix_binary_ != NULL) {
+    int page_mode = tessedit_pageseg_mode;
+    tessedit_pageseg_mode.set_value(pageseg_mode);
+    PrepareForPageseg();
+    BLOCK_LIST region_blocks;
+    OSResults osr;
+    result = SegmentPage(NULL, &region_blocks, NULL, &osr);
+    if (result >= 0) PrepareForTessOCR(&region_blocks, NULL, &osr);
+    tessedit_pageseg_mode.set_value(page_mode);
+    // Tesseract coordinates start at the bottom of the image.
+    ICOORD shift(left, page_height - top - height);
+    BLOCK_IT block_it(&region_blocks);
+    for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward())
+      MoveBlock(shift, block_it.data());
+    block_it.set_to_list(blocks);
+    block_it.move_to_last();
+    block_it.add_list_after(&region_blocks);
+  }
+  pixDestroy(&pix_binary_);
+  pixDestroy(&pix_grey_);
+  pixDestroy(&pix_thresholds_);
+  pix_binary_ = page_binary;
+  pix_grey_ = page_grey;
+  pix_thresholds_ = page_thresholds;
+  // PrepareForPageseg gave the region to the sub-languages.
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    pixDestroy(&sub_langs_[i]->pix_binary_);
+    sub_langs_[i]->pix_binary_ = pixClone(pix_binary_);
+  }
+  return result;
+}
+
 /**
  * Auto page segmentation. Divide the page image into blocks of uniform
  * text linespacing and images.
@@ -210,6 +287,7 @@ int Tesseract::AutoPageSeg(PageSegMode pageseg_mode, BLOCK_LIST* blocks,
   // The blocks made by the ColumnFinder. Moved to blocks before return.
   BLOCK_LIST found_blocks;
   TO_BLOCK_LIST temp_blocks;
+  clock_t start_t = clock();
 
   ColumnFinder* finder = SetupPageSegAndDetectOrientation(
       pageseg_mode, blocks, osd_tess, osr, &temp_blocks, &photomask_pix,
@@ -226,12 +304,20 @@ int Tesseract::AutoPageSeg(PageSegMode pageseg_mode, BLOCK_LIST* blocks,
     if (equ_detect_) {
       finder->SetEquationDetect(equ_detect_);
     }
+    finder->set_fast_single_column(textord_fast_single_column);
     result = finder->FindBlocks(pageseg_mode, scaled_color_, scaled_factor_,
                                 to_block, photomask_pix, pix_thresholds_,
                                 pix_grey_, &pixa_debug_, &found_blocks,
                                 diacritic_blobs, to_blocks);
     if (result >= 0)
       finder->GetDeskewVectors(&deskew_, &reskew_);
+    if (tessedit_timing_debug) {
+      clock_t layout_t = clock();
+      tprintf("Layout: %s (column check took %.3f sec, layout took %.2f sec)\n",
+              finder->single_column_page() ? "single column" : "full analysis",
+              finder->single_column_check_secs(),
+              static_cast<double>(layout_t - start_t) / CLOCKS_PER_SEC);
+    }
     delete finder;
   }
   pixDestroy(&photomask_pix);
@@ -358,7 +444,9 @@ ColumnFinder* Tesseract::SetupPageSegAndDetectOrientation(
                                  osd_tess->unicharset, &osd_scripts);
         }
       }
-      os_detect_blobs(&osd_scripts, &osd_blobs, osr, osd_tess);
+      float osd_stop_margin = osd_fast ? min_orientation_margin : 0.0;
+      os_detect_blobs(&osd_scripts, &osd_blobs, osd_stop_margin, osr,
+                      osd_tess);
       if (pageseg_mode == PSM_OSD_ONLY) {
         delete finder;
         return NULL;
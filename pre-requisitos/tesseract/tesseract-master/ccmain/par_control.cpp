@@ -21,9 +21,17 @@
 #ifdef _OPENMP
 #include <omp.h>
 #endif  // _OPENMP
+#include "lstmrecognizer.h"
+#include "opthreads.h"
+#include "params.h"
+#include "tessdatamanager.h"
 
 namespace tesseract {
 
+// Number of row groups per thread of pass 1 when all the languages run the
+// LSTM, for the threads that finish early to take over.
+const int kLSTMRowGroupsPerThread = 4;
+
 struct BlobData {
   BlobData() : blob(NULL), choices(NULL) {}
   BlobData(int index, Tesseract* tess, const WERD_RES& word)
@@ -44,6 +52,7 @@ void Tesseract::PrerecAllWordsPar(const GenericVector<WordData>& words) {
         words[w].word->ratings->get(0, 0) == NULL) {
       for (int s = 0; s < words[w].lang_words.size(); ++s) {
         Tesseract* sub = s < sub_langs_.size() ? sub_langs_[s] : this;
+        if (SkipLanguage(sub)) continue;
         const WERD_RES& word = *words[w].lang_words[s];
         for (int b = 0; b < word.chopped_word->NumBlobs(); ++b) {
           blobs.push_back(BlobData(b, sub, word));
@@ -54,7 +63,8 @@ void Tesseract::PrerecAllWordsPar(const GenericVector<WordData>& words) {
   // Pre-classify all the blobs.
   if (tessedit_parallelize > 1) {
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(10)
+    int num_threads = IntraOpThreads(10);
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
 #endif  // _OPENMP
     for (int b = 0; b < blobs.size(); ++b) {
       *blobs[b].choices =
@@ -69,6 +79,420 @@ void Tesseract::PrerecAllWordsPar(const GenericVector<WordData>& words) {
   }
 }
 
+// Collects the names and current values of the init params in params, so a
+// helper can load the same data as the instance they belong to.
+template <class T>
+static void CollectInitParams(const GenericVector<T*>& params,
+                              const ParamsVectors* member_params,
+                              GenericVector<STRING>* vars,
+                              GenericVector<STRING>* values) {
+  for (int i = 0; i < params.size(); ++i) {
+    if (!params[i]->is_init()) continue;
+    STRING value;
+    ParamUtils::GetParamAsString(params[i]->name_str(), member_params, &value);
+    vars->push_back(params[i]->name_str());
+    values->push_back(value);
+  }
+}
+
+// Sets each param of dst to the value of the param of the same name in src.
+// Instances of the same class register their member params in the same
+// order, so the names are just a check.
+template <class T>
+static void CopyParamValues(const GenericVector<T*>& src,
+                            const GenericVector<T*>& dst) {
+  for (int i = 0; i < src.size() && i < dst.size(); ++i) {
+    if (strcmp(src[i]->name_str(), dst[i]->name_str()) == 0)
+      dst[i]->set_value(*src[i]);
+  }
+}
+
+// A group of consecutive rows of a page, moved for the duration of pass 1
+// into a PAGE_RES of its own, so that the Tesseract that recognizes them
+// never walks over the rows of another group.
+struct Pass1RowGroup {
+  Pass1RowGroup() : tesseract(NULL), num_words(0), ok(true),
+                    make_last_fuzzy(false), last_word(NULL) {}
+
+  Tesseract* tesseract;
+  PAGE_RES page_res;
+  // The BLOCK_RES of page_res each copy of a block in page_res came from.
+  GenericVector<BLOCK_RES*> source_blocks;
+  int num_words;
+  bool ok;
+  // Set if the word after last_word, in the next group, must be made fuzzy.
+  bool make_last_fuzzy;
+  WERD_RES* last_word;
+};
+
+// Moves the rows of page_res into num_groups groups of consecutive rows with
+// about the same number of words each.
+static void SplitPageRows(int num_groups, PAGE_RES* page_res,
+                          PointerVector<Pass1RowGroup>* groups) {
+  int words_left = 0;
+  BLOCK_RES_IT b_it(&page_res->block_res_list);
+  for (b_it.mark_cycle_pt(); !b_it.cycled_list(); b_it.forward()) {
+    ROW_RES_IT r_it(&b_it.data()->row_res_list);
+    for (r_it.mark_cycle_pt(); !r_it.cycled_list(); r_it.forward())
+      words_left += r_it.data()->word_res_list.length();
+  }
+  Pass1RowGroup* group = NULL;
+  int group_words = 0;
+  int target_words = 0;
+  for (b_it.mark_cycle_pt(); !b_it.cycled_list(); b_it.forward()) {
+    BLOCK_RES* block = b_it.data();
+    BLOCK_RES* group_block = NULL;
+    ROW_RES_IT r_it(&block->row_res_list);
+    while (!r_it.empty()) {
+      r_it.move_to_first();
+      ROW_RES* row = r_it.extract();
+      int row_words = row->word_res_list.length();
+      // Close the group at the row boundary nearest to its target.
+      if (group == NULL ||
+          (groups->size() < num_groups && group_words > 0 &&
+           group_words + row_words - target_words >
+               target_words - group_words)) {
+        int groups_left = num_groups - groups->size();
+        target_words = (words_left + groups_left - 1) / groups_left;
+        group = new Pass1RowGroup;
+        groups->push_back(group);
+        group_words = 0;
+        group_block = NULL;
+      }
+      if (group_block == NULL) {
+        group_block = new BLOCK_RES;
+        group_block->block = block->block;
+        group_block->char_count = block->char_count;
+        group_block->rej_count = block->rej_count;
+        group_block->font_class = block->font_class;
+        group_block->row_count = block->row_count;
+        group_block->x_height = block->x_height;
+        group_block->font_assigned = block->font_assigned;
+        group_block->bold = block->bold;
+        group_block->italic = block->italic;
+        BLOCK_RES_IT gb_it(&group->page_res.block_res_list);
+        gb_it.add_to_end(group_block);
+        group->source_blocks.push_back(block);
+      }
+      ROW_RES_IT gr_it(&group_block->row_res_list);
+      gr_it.add_to_end(row);
+      group_words += row_words;
+      words_left -= row_words;
+    }
+  }
+}
+
+// Moves the rows of the groups back to page_res, in their original order.
+static void JoinPageRows(PointerVector<Pass1RowGroup>* groups) {
+  for (int g = 0; g < groups->size(); ++g) {
+    Pass1RowGroup* group = (*groups)[g];
+    BLOCK_RES_IT gb_it(&group->page_res.block_res_list);
+    int b = 0;
+    for (gb_it.mark_cycle_pt(); !gb_it.cycled_list(); gb_it.forward(), ++b) {
+      ROW_RES_IT gr_it(&gb_it.data()->row_res_list);
+      ROW_RES_IT r_it(&group->source_blocks[b]->row_res_list);
+      while (!gr_it.empty()) {
+        gr_it.move_to_first();
+        r_it.add_to_end(gr_it.extract());
+      }
+    }
+  }
+}
+
+// Returns the number of threads pass 1 of the given page may recognize
+// rows with, creating the helper copies of the languages if needed.
+// Returns 1 if pass 1 must run sequentially on this.
+int Tesseract::Pass1Threads(PAGE_RES* page_res, ETEXT_DESC* monitor,
+                            const TBOX* target_word_box) {
+  if (tessedit_pass1_threads < 2 || target_word_box != NULL) return 1;
+  // Every group of rows checks the deadline on its own, but the callbacks
+  // are not meant to be called from several threads.
+  if (monitor != NULL &&
+      (monitor->cancel != NULL || monitor->progress_callback != NULL))
+    return 1;
+  int num_threads =
+      MIN(tessedit_pass1_threads, IntraOpThreads(tessedit_pass1_threads));
+  int num_rows = 0;
+  BLOCK_RES_IT b_it(&page_res->block_res_list);
+  for (b_it.mark_cycle_pt(); !b_it.cycled_list(); b_it.forward())
+    num_rows += b_it.data()->row_res_list.length();
+  num_threads = MIN(num_threads, num_rows);
+  if (num_threads < 2) return 1;
+  if (pass1_helpers_.size() >= num_threads - 1) return num_threads;
+
+  STRING langs = lang;
+  for (int s = 0; s < sub_langs_.size(); ++s) {
+    langs += "+";
+    langs += sub_langs_[s]->lang;
+  }
+  GenericVector<STRING> vars, values;
+  CollectInitParams(params()->int_params, params(), &vars, &values);
+  CollectInitParams(params()->bool_params, params(), &vars, &values);
+  CollectInitParams(params()->string_params, params(), &vars, &values);
+  CollectInitParams(params()->double_params, params(), &vars, &values);
+  while (pass1_helpers_.size() < num_threads - 1) {
+    Tesseract* helper = new Tesseract;
+    TessdataManager mgr;
+    bool ok = helper->init_tesseract(
+        datadir.string(), NULL, langs.string(),
+        static_cast<OcrEngineMode>(static_cast<int>(tessedit_ocr_engine_mode)),
+        NULL, 0, &vars, &values, false, &mgr) >= 0;
+    ok = ok && helper->sub_langs_.size() == sub_langs_.size();
+    for (int s = 0; ok && s < sub_langs_.size(); ++s)
+      ok = helper->sub_langs_[s]->lang == sub_langs_[s]->lang;
+    if (!ok) {
+      tprintf("Warning: cannot load another %s for pass 1,"
+              " running it on one thread\n", langs.string());
+      delete helper;
+      pass1_helpers_.clear();
+      tessedit_pass1_threads.set_value(1);
+      return 1;
+    }
+    pass1_helpers_.push_back(helper);
+  }
+  return num_threads;
+}
+
+// Runs pass 1 on groups of consecutive rows of the page at once, on this
+// and its num_threads - 1 helpers, and then adapts to the words in page order.
+// Each group starts with no previous word, so the first word of each row
+// group loses the context of the word before it. That context only matters
+// to the legacy engine, so with only LSTM languages the page is cut into
+// several smaller groups per thread, which the threads take as they become
+// free, so that a few long lines don't leave the other threads idle.
+// Returns false on timeout, like RecogAllWordsPassN.
+bool Tesseract::RecogAllWordsPass1Par(int num_threads, PAGE_RES* page_res,
+                                      ETEXT_DESC* monitor) {
+  int num_groups = num_threads;
+  if (!AnyTessLang()) {
+    int num_rows = 0;
+    BLOCK_RES_IT b_it(&page_res->block_res_list);
+    for (b_it.mark_cycle_pt(); !b_it.cycled_list(); b_it.forward())
+      num_rows += b_it.data()->row_res_list.length();
+    num_groups = MAX(num_threads,
+                     MIN(num_rows, num_threads * kLSTMRowGroupsPerThread));
+  }
+  PointerVector<Pass1RowGroup> groups;
+  SplitPageRows(num_groups, page_res, &groups);
+  GenericVector<int> votes = language_votes_;
+  // The helpers classify with the adapted templates of this, which nobody
+  // changes until all the groups are done.
+  GenericVector<Tesseract*> instances;
+  GenericVector<ADAPT_TEMPLATES> helper_templates;
+  for (int i = 0; i < num_threads; ++i) {
+    Tesseract* tess = i == 0 ? this : pass1_helpers_[i - 1];
+    instances.push_back(tess);
+    if (tess != this) SharePageWithHelper(tess);
+    tess->SetDeadlineMode(deadline_mode_);
+    tess->SetNoLanguageModel(no_language_model_);
+    for (int s = 0; s <= sub_langs_.size(); ++s) {
+      Tesseract* lang_t = s < sub_langs_.size() ? sub_langs_[s] : this;
+      Tesseract* tess_t = s < sub_langs_.size() ? tess->sub_langs_[s] : tess;
+      tess_t->defer_adaption_ = true;
+      if (tess_t != lang_t) {
+        helper_templates.push_back(tess_t->AdaptedTemplates);
+        tess_t->AdaptedTemplates = lang_t->AdaptedTemplates;
+      }
+    }
+  }
+  // Each thread recognizes its groups with the instance of its own, one
+  // group at a time.
+  int intra_op_threads = IntraOpThreads(0);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1)
+#endif  // _OPENMP
+  for (int g = 0; g < groups.size(); ++g) {
+    Pass1RowGroup* group = groups[g];
+#ifdef _OPENMP
+    Tesseract* tess = instances[omp_get_thread_num()];
+#else
+    Tesseract* tess = this;
+#endif  // _OPENMP
+    group->tesseract = tess;
+    SetIntraOpThreads(1);
+    ETEXT_DESC group_monitor;
+    if (monitor != NULL) group_monitor.end_time = monitor->end_time;
+    GenericVector<WordData> words;
+    tess->SetupAllWordsPassN(1, NULL, NULL, &group->page_res, &words);
+    group->num_words = words.size();
+#ifndef ANDROID_BUILD
+    tess->LSTMPrerecAllWords(words, monitor != NULL ? &group_monitor : NULL);
+#endif
+    PAGE_RES_IT page_res_it(&group->page_res);
+    group->ok = tess->RecogAllWordsPassN(1, monitor != NULL ? &group_monitor
+                                                            : NULL,
+                                         &page_res_it, &words,
+                                         &group->make_last_fuzzy);
+#ifndef ANDROID_BUILD
+    tess->ClearLSTMPrerecWords();
+#endif
+    for (page_res_it.restart_page(); page_res_it.word() != NULL;
+         page_res_it.forward()) {
+      group->last_word = page_res_it.word();
+      if (tess != this) AdoptHelperWord(*tess, page_res_it.word());
+    }
+  }
+  SetIntraOpThreads(intra_op_threads);
+  JoinPageRows(&groups);
+  bool ok = true;
+  stats_.word_count = 0;
+  for (int g = 0; g < groups.size(); ++g) {
+    ok = ok && groups[g]->ok;
+    stats_.word_count += groups[g]->num_words;
+  }
+  int t = 0;
+  for (int i = 0; i < instances.size(); ++i) {
+    Tesseract* tess = instances[i];
+    // The whole page degrades if any group ran out of time.
+    if (tess->deadline_mode()) SetDeadlineMode(true);
+    for (int s = 0; s <= sub_langs_.size(); ++s) {
+      Tesseract* lang_t = s < sub_langs_.size() ? sub_langs_[s] : this;
+      Tesseract* tess_t = s < sub_langs_.size() ? tess->sub_langs_[s] : tess;
+      tess_t->defer_adaption_ = false;
+      if (tess_t != lang_t) tess_t->AdaptedTemplates = helper_templates[t++];
+    }
+    if (tess == this) continue;
+    // Add the votes of the helper for this page to those of this.
+    const GenericVector<int>& helper_votes = tess->language_votes();
+    if (!helper_votes.empty()) {
+      if (language_votes_.empty())
+        language_votes_.init_to_size(helper_votes.size(), 0);
+      for (int v = 0; v < helper_votes.size(); ++v)
+        language_votes_[v] += helper_votes[v] - (votes.empty() ? 0 : votes[v]);
+    }
+    UnsharePageWithHelper(tess);
+  }
+  if (!ok) return false;
+  // Apply the fuzzy spaces that crossed the groups, and learn from the words
+  // in page order, as RecogAllWordsPassN would for a single group.
+  int g = 0;
+  bool make_fuzzy = false;
+  PAGE_RES_IT page_res_it(page_res);
+  for (page_res_it.restart_page(); page_res_it.word() != NULL;
+       page_res_it.forward()) {
+    WERD_RES* word = page_res_it.word();
+    if (make_fuzzy) page_res_it.MakeCurrentWordFuzzy();
+    make_fuzzy = false;
+    while (g < groups.size() && groups[g]->last_word == NULL) ++g;
+    if (g < groups.size() && groups[g]->last_word == word) {
+      make_fuzzy = groups[g]->make_last_fuzzy;
+      ++g;
+    }
+    Tesseract* lang_t = word->tesseract;
+    if (lang_t == NULL || word->tess_failed || word->word->flag(W_REP_CHAR))
+      continue;
+    if (!deadline_mode_) lang_t->AdaptToPass1Word(word);
+    if (lang_t->tessedit_enable_doc_dict && !word->IsAmbiguous()) {
+      lang_t->tess_add_doc_word(word->best_choice);
+      // Keep the document dictionaries of the helpers the same as this.
+      for (int h = 0; h < pass1_helpers_.size(); ++h) {
+        Tesseract* helper_t = MatchingLanguage(lang_t, pass1_helpers_[h]);
+        if (helper_t != NULL) helper_t->tess_add_doc_word(word->best_choice);
+      }
+    }
+  }
+  return true;
+}
+
+// Returns the language of other, ie other or one of its sub_langs_, that is
+// at the same index in other as lang_t is in this, or NULL if lang_t is not
+// one of the languages of this.
+Tesseract* Tesseract::MatchingLanguage(const Tesseract* lang_t,
+                                       Tesseract* other) const {
+  if (lang_t == this) return other;
+  for (int s = 0; s < sub_langs_.size(); ++s) {
+    if (sub_langs_[s] == lang_t) return other->sub_langs_[s];
+  }
+  return NULL;
+}
+
+// Returns a clone of the copy in copies of the image pix of this, making
+// the copy if it is the first time pix is asked for, or NULL if pix is NULL.
+static Pix* HelperPix(Pix* pix, GenericVector<Pix*>* originals,
+                      GenericVector<Pix*>* copies) {
+  if (pix == NULL) return NULL;
+  int index = originals->get_index(pix);
+  if (index < 0) {
+    originals->push_back(pix);
+    copies->push_back(pixCopy(NULL, pix));
+    index = copies->size() - 1;
+  }
+  return pixClone((*copies)[index]);
+}
+
+// Copies the params, images and document language vote of this to the
+// same languages of the pass 1 helper.
+void Tesseract::SharePageWithHelper(Tesseract* helper) {
+  // The helper gets copies of the images, as clones would have their
+  // reference counts changed by several threads at once, which leptonica
+  // only allows with LEPT_ATOMIC_REFCOUNT. The languages of the helper share
+  // one copy of each image, so their LSTM line images are still shared.
+  GenericVector<Pix*> originals;
+  GenericVector<Pix*> copies;
+  for (int s = 0; s <= sub_langs_.size(); ++s) {
+    Tesseract* lang_t = s < sub_langs_.size() ? sub_langs_[s] : this;
+    Tesseract* helper_t = s < sub_langs_.size() ? helper->sub_langs_[s]
+                                                : helper;
+    const ParamsVectors* src = lang_t->params();
+    ParamsVectors* dst = helper_t->params();
+    CopyParamValues(src->int_params, dst->int_params);
+    CopyParamValues(src->bool_params, dst->bool_params);
+    CopyParamValues(src->string_params, dst->string_params);
+    CopyParamValues(src->double_params, dst->double_params);
+    pixDestroy(&helper_t->pix_binary_);
+    pixDestroy(&helper_t->pix_grey_);
+    pixDestroy(&helper_t->pix_original_);
+    helper_t->pix_binary_ = HelperPix(lang_t->pix_binary_, &originals,
+                                      &copies);
+    helper_t->pix_grey_ = HelperPix(lang_t->pix_grey_, &originals, &copies);
+    helper_t->pix_original_ = HelperPix(lang_t->pix_original_, &originals,
+                                        &copies);
+    helper_t->source_resolution_ = lang_t->source_resolution_;
+  }
+  for (int i = 0; i < copies.size(); ++i) pixDestroy(&copies[i]);
+  helper->SetBlackAndWhitelist();
+  helper->SetLanguageVotes(language_votes_);
+  helper->set_profile(profile_);
+  helper->most_recently_used_ = helper;
+}
+
+// Undoes SharePageWithHelper.
+void Tesseract::UnsharePageWithHelper(Tesseract* helper) {
+  helper->Clear();
+  helper->set_pix_original(NULL);
+}
+
+// Makes the choices of word that are in the unicharset from use to instead.
+static void ReplaceWordUnicharset(const UNICHARSET* from, const UNICHARSET* to,
+                                  WERD_RES* word) {
+  if (word->uch_set == from) word->uch_set = to;
+  if (word->raw_choice != NULL && word->raw_choice->unicharset() == from)
+    word->raw_choice->set_unicharset(to);
+  if (word->ep_choice != NULL && word->ep_choice->unicharset() == from)
+    word->ep_choice->set_unicharset(to);
+  WERD_CHOICE_IT wc_it(&word->best_choices);
+  for (wc_it.mark_cycle_pt(); !wc_it.cycled_list(); wc_it.forward()) {
+    if (wc_it.data()->unicharset() == from)
+      wc_it.data()->set_unicharset(to);
+  }
+}
+
+// Points the word that the pass 1 helper recognized at the languages of
+// this instead of those of the helper.
+void Tesseract::AdoptHelperWord(const Tesseract& helper, WERD_RES* word) {
+  for (int s = 0; s <= sub_langs_.size(); ++s) {
+    Tesseract* lang_t = s < sub_langs_.size() ? sub_langs_[s] : this;
+    const Tesseract* helper_t = s < sub_langs_.size() ? helper.sub_langs_[s]
+                                                      : &helper;
+    if (word->tesseract == helper_t) word->tesseract = lang_t;
+    ReplaceWordUnicharset(&helper_t->unicharset, &lang_t->unicharset, word);
+    // Words recognized by the LSTM are in the unicharset of its recognizer.
+    if (helper_t->lstm_recognizer_ != NULL && lang_t->lstm_recognizer_ != NULL)
+      ReplaceWordUnicharset(&helper_t->lstm_recognizer_->GetUnicharset(),
+                            &lang_t->lstm_recognizer_->GetUnicharset(), word);
+  }
+}
+
 }  // namespace tesseract.
 
 
@@ -192,6 +192,9 @@ bool Tesseract::init_tesseract_lang_data(
       lstm_recognizer_ = new LSTMRecognizer;
       ASSERT_HOST(
           lstm_recognizer_->Load(lstm_use_matrix ? language : nullptr, mgr));
+      // Quantize a float model in memory, the same conversion that
+      // combine_tessdata -c writes to disk. Int models are left unchanged.
+      if (lstm_convert_to_int) lstm_recognizer_->ConvertToInt();
     } else {
       tprintf("Error: LSTM requested, but not present!! Loading tesseract.\n");
       tessedit_ocr_engine_mode.set_value(OEM_TESSERACT_ONLY);
@@ -338,6 +341,7 @@ int Tesseract::init_tesseract(const char *arg0, const char *textbase,
           tprintf("Failed loading language '%s'\n", lang_str);
           delete tess_to_init;
         } else {
+          tess_to_init->lstm_line_images_owner_ = this;
           sub_langs_.push_back(tess_to_init);
           // Add any languages that this language requires
           ParseLanguageString(tess_to_init->tessedit_load_sublangs.string(),
@@ -76,6 +76,48 @@ Tesseract::Tesseract()
           " 5=line, 6=word, 7=char"
           " (Values from PageSegMode enum in publictypes.h)",
           this->params()),
+      INT_MEMBER(thresholding_method, 0,
+                 "Thresholding method: 0=Otsu, 1=adaptive Otsu, 2=Sauvola"
+                 " (Values from ThresholdMethod enum in thresholder.h)",
+                 this->params()),
+      double_MEMBER(thresholding_window_size, 0.33,
+                    "Window size of Sauvola, in inches", this->params()),
+      double_MEMBER(thresholding_kfactor, 0.34,
+                    "Factor of the local deviation in Sauvola thresholds",
+                    this->params()),
+      double_MEMBER(thresholding_tile_size, 0.33,
+                    "Tile size of adaptive Otsu, in inches", this->params()),
+      double_MEMBER(thresholding_smooth_kernel_size, 0.0,
+                    "Smoothing of adaptive Otsu thresholds, in inches",
+                    this->params()),
+      double_MEMBER(thresholding_score_fraction, 0.1,
+                    "Fraction of the best Otsu score accepted by adaptive Otsu",
+                    this->params()),
+      BOOL_MEMBER(tessedit_adaptive_resolution, false,
+                  "Recognize each page at the resolution where its text is"
+                  " about tessedit_target_text_height pixels high",
+                  this->params()),
+      INT_MEMBER(tessedit_target_text_height, 20,
+                 "Median height in pixels of the characters of a page at the"
+                 " resolution picked by tessedit_adaptive_resolution",
+                 this->params()),
+      BOOL_MEMBER(tessedit_skip_blank_pages, false,
+                  "Threshold pages with next to no ink to nothing, skipping"
+                  " their layout and recognition",
+                  this->params()),
+      double_MEMBER(tessedit_blank_page_ink, 0.0002,
+                    "Largest fraction of ink of a page skipped as blank",
+                    this->params()),
+      BOOL_MEMBER(tessedit_dewarp, false,
+                  "Straighten the curled text lines of pages, such as scans"
+                  " of bound books, before recognizing them; not with"
+                  " textonly_pdf",
+                  this->params()),
+      BOOL_MEMBER(tessedit_color_reduction, false,
+                  "Reduce color images with little color to grey and bitonal"
+                  " images to binary before thresholding, and keep them"
+                  " reduced",
+                  this->params()),
       INT_INIT_MEMBER(tessedit_ocr_engine_mode, tesseract::OEM_DEFAULT,
                       "Which OCR engine(s) to run (Tesseract, LSTM, both)."
                       " Defaults to loading and running the most accurate"
@@ -216,6 +258,13 @@ Tesseract::Tesseract()
       double_MEMBER(test_pt_y, 99999.99, "ycoord", this->params()),
       INT_MEMBER(multilang_debug_level, 0, "Print multilang debug info.",
                  this->params()),
+      INT_MEMBER(multilang_vote_pages, 0,
+                 "Pages of a document voting on its language, after which the"
+                 " winner is the only language tried. 0 tries all, always",
+                 this->params()),
+      double_MEMBER(multilang_vote_ratio, 0.9,
+                    "Share of the voted words the winning language needs",
+                    this->params()),
       INT_MEMBER(paragraph_debug_level, 0, "Print paragraph debug info.",
                  this->params()),
       BOOL_MEMBER(paragraph_text_based, true,
@@ -224,6 +273,35 @@ Tesseract::Tesseract()
                   this->params()),
       BOOL_MEMBER(lstm_use_matrix, 1,
                   "Use ratings matrix/beam search with lstm", this->params()),
+      INT_MEMBER(lstm_batch_size, 16,
+                 "Number of lines the LSTM recognizes in a single pass",
+                 this->params()),
+      BOOL_MEMBER(lstm_fast_beam_search, false,
+                  "Decode LSTM lines with a faster, less exhaustive beam"
+                  " search",
+                  this->params()),
+      BOOL_MEMBER(lstm_convert_to_int, false,
+                  "Convert a float LSTM model to int8 weights when loading it",
+                  this->params()),
+      BOOL_MEMBER(lstm_legacy_on_doubt, false,
+                  "In the combined mode, also recognize the words the LSTM is"
+                  " unsure of with tesseract, keeping the better result",
+                  this->params()),
+      double_MEMBER(lstm_legacy_min_certainty, -5.0,
+                    "Certainty under which lstm_legacy_on_doubt takes an LSTM"
+                    " word as unsure, even if the dictionary accepts it",
+                    this->params()),
+      BOOL_MEMBER(tessedit_deadline_degrade, true,
+                  "When a page is about to miss its deadline, recognize the"
+                  " rest of it without pass 2, adaption or other languages,"
+                  " and with LSTM only and a fast beam search",
+                  this->params()),
+      BOOL_MEMBER(tessedit_no_language_model, false,
+                  "Recognize without a language model, for codes and"
+                  " numbers: as tessedit_deadline_degrade does, but for the"
+                  " whole page, and with no dictionary in the LSTM search or"
+                  " dictionary correction",
+                  this->params()),
       STRING_MEMBER(outlines_odd, "%| ", "Non standard number of outlines",
                     this->params()),
       STRING_MEMBER(outlines_2, "ij!?%\":;", "Non standard number of outlines",
@@ -267,6 +345,10 @@ Tesseract::Tesseract()
                   this->params()),
       BOOL_MEMBER(tessedit_debug_quality_metrics, false,
                   "Output data to debug file", this->params()),
+      BOOL_MEMBER(tessedit_lazy_rejection, true,
+                  "Defer the document quality rejection passes until the"
+                  " reject maps are read",
+                  this->params()),
       BOOL_MEMBER(bland_unrej, false, "unrej potential with no checks",
                   this->params()),
       double_MEMBER(quality_rowrej_pc, 1.1,
@@ -333,6 +415,10 @@ Tesseract::Tesseract()
                  "How many non-noise blbs either side?", this->params()),
       double_MEMBER(fixsp_small_outlines_size, 0.28, "Small if lt xht x this",
                     this->params()),
+      double_MEMBER(fixsp_clear_space_ratio, 1.5,
+                    "Don't search fuzzy spaces that are all at least this times"
+                    " the space size of the row (0 to search all)",
+                    this->params()),
       BOOL_MEMBER(tessedit_prefer_joined_punct, false,
                   "Reward punctation joins", this->params()),
       INT_MEMBER(fixsp_done_mode, 1, "What constitues done for spacing",
@@ -391,9 +477,33 @@ Tesseract::Tesseract()
                   this->params()),
       BOOL_MEMBER(tessedit_create_pdf, false, "Write .pdf output file",
                   this->params()),
+      BOOL_MEMBER(tessedit_create_binary, false,
+                  "Write .tbr binary result file", this->params()),
+      BOOL_MEMBER(tessedit_create_profile, false,
+                  "Write .profile.json file of the time of each stage",
+                  this->params()),
       BOOL_MEMBER(textonly_pdf, false,
                   "Create PDF with only one invisible text layer",
                   this->params()),
+      BOOL_MEMBER(pdf_overlay, false,
+                  "With textonly_pdf, draw the text layer of a page of PDF"
+                  " input over a copy of that page",
+                  this->params()),
+      BOOL_MEMBER(pdf_pdfa, false,
+                  "Write PDF output as PDF/A-2b, with XMP metadata and an sRGB"
+                  " output intent",
+                  this->params()),
+      BOOL_MEMBER(pdf_jbig2, true,
+                  "Encode binary page images in PDF output as lossless JBIG2"
+                  " instead of G4",
+                  this->params()),
+      BOOL_MEMBER(pdf_mrc, false,
+                  "Split color and grey page images in PDF output into a text"
+                  " mask, a foreground and a reduced background",
+                  this->params()),
+      INT_MEMBER(pdf_mrc_reduction, 3,
+                 "Reduction of the background of pdf_mrc pages",
+                 this->params()),
       STRING_MEMBER(unrecognised_char, "|",
                     "Output char for unidentified blobs", this->params()),
       INT_MEMBER(suspect_level, 99, "Suspect marker level", this->params()),
@@ -459,6 +569,10 @@ Tesseract::Tesseract()
                  "-1 -> All pages"
                  " , else specific page to process",
                  this->params()),
+      STRING_MEMBER(tessedit_skip_pages, "",
+                    "Pages of PDF input left out of recognition, as 1-based"
+                    " numbers and ranges (3,7-9): their output page is empty",
+                    this->params()),
       BOOL_MEMBER(tessedit_write_images, false,
                   "Capture the image from the IPE", this->params()),
       BOOL_MEMBER(interactive_display_mode, false, "Run interactively?",
@@ -474,6 +588,10 @@ Tesseract::Tesseract()
                   this->params()),
       double_MEMBER(min_orientation_margin, 7.0,
                     "Min acceptable orientation margin", this->params()),
+      BOOL_MEMBER(osd_fast, false,
+                  "Detect orientation on a reduced copy of the page, and stop"
+                  " once the margin exceeds min_orientation_margin",
+                  this->params()),
       BOOL_MEMBER(textord_tabfind_show_vlines, false, "Debug line finding",
                   this->params()),
       BOOL_MEMBER(textord_use_cjk_fp_model, FALSE, "Use CJK fixed pitch model",
@@ -488,6 +606,10 @@ Tesseract::Tesseract()
                        this->params()),
       BOOL_MEMBER(textord_equation_detect, false, "Turn on equation detector",
                   this->params()),
+      BOOL_MEMBER(textord_fast_single_column, false,
+                  "Skip tab stop and table finding on pages that look like a "
+                  "single column of text",
+                  this->params()),
       BOOL_MEMBER(textord_tabfind_vertical_text, true,
                   "Enable vertical detection", this->params()),
       BOOL_MEMBER(textord_tabfind_force_vertical_text, false,
@@ -503,6 +625,54 @@ Tesseract::Tesseract()
           this->params()),
       INT_MEMBER(tessedit_parallelize, 0, "Run in parallel where possible",
                  this->params()),
+      INT_MEMBER(tessedit_page_threads, 1,
+                 "Number of pages ProcessPages recognizes in parallel",
+                 this->params()),
+      INT_MEMBER(tessedit_page_readahead, 0,
+                 "Pages ProcessPages decodes ahead of the page threads, held"
+                 " compressed until a thread takes them",
+                 this->params()),
+      INT_MEMBER(tessedit_page_decode_threads, 1,
+                 "Threads ProcessPages decodes the pages of PDF input on,"
+                 " ahead of the page threads, each with its own reader",
+                 this->params()),
+      INT_MEMBER(tessedit_page_decode_depth, 0,
+                 "Decoded PDF pages the decode threads may keep waiting for"
+                 " the page threads, 0 for twice the decode threads",
+                 this->params()),
+      BOOL_MEMBER(tessedit_page_pipeline_stats, false,
+                  "Print the threads, depths and queue high-water marks of"
+                  " each stage once ProcessPages ends a PDF",
+                  this->params()),
+      INT_MEMBER(tessedit_intra_op_threads, 0,
+                 "Threads each parallel step of recognizing a page may use,"
+                 " 0 for the built-in defaults, 1 for a single thread",
+                 this->params()),
+      INT_MEMBER(tessedit_pass1_threads, 1,
+                 "Number of threads pass 1 recognizes the"
+                 " rows of a page with, each on its own copy of the languages",
+                 this->params()),
+      INT_MEMBER(tessedit_jpeg_min_dpi, 0,
+                 "Decode JPEG pages reduced by 2, 4 or 8 as long as they keep"
+                 " at least this resolution, 0 to decode them at full size",
+                 this->params()),
+      STRING_MEMBER(page_cache_dir, "",
+                    "Directory of the page result cache, empty disables it",
+                    this->params()),
+      INT_MEMBER(page_cache_size, 1024,
+                 "Size limit of the page result cache in MB", this->params()),
+      BOOL_MEMBER(tessedit_reuse_duplicate_pages, false,
+                  "Render pages that are near-duplicates of an earlier page of"
+                  " the document with its results instead of recognizing them",
+                  this->params()),
+      double_MEMBER(tessedit_duplicate_page_confidence, 0.98,
+                    "Fraction of the words of an earlier page that must be"
+                    " found again in place on a page to reuse its results",
+                    this->params()),
+      STRING_MEMBER(tessedit_trace_file, "",
+                    "Write a Chrome/Perfetto JSON trace of the work of each"
+                    " thread in ProcessPages to this file, empty for none",
+                    this->params()),
       BOOL_MEMBER(preserve_interword_spaces, false,
                   "Preserve multiple interword spaces", this->params()),
       STRING_MEMBER(page_separator, "\f",
@@ -611,12 +781,21 @@ Tesseract::Tesseract()
       deskew_(1.0f, 0.0f),
       reskew_(1.0f, 0.0f),
       most_recently_used_(this),
+      document_language_(NULL),
+      defer_adaption_(false),
+      deadline_mode_(false),
+      no_language_model_(false),
+      font_recognition_(true),
       font_table_size_(0),
       equ_detect_(NULL),
 #ifndef ANDROID_BUILD
       lstm_recognizer_(NULL),
 #endif
-      train_line_page_num_(0) {
+      lstm_prerec_next_(0),
+      lstm_line_images_next_(0),
+      lstm_line_images_owner_(this),
+      train_line_page_num_(0),
+      profile_(NULL) {
 }
 
 Tesseract::~Tesseract() {
@@ -654,6 +833,9 @@ void Tesseract::Clear() {
   reskew_ = FCOORD(1.0f, 0.0f);
   splitter_.Clear();
   scaled_factor_ = -1;
+#ifndef ANDROID_BUILD
+  ClearLSTMLineImages();
+#endif
   for (int i = 0; i < sub_langs_.size(); ++i)
     sub_langs_[i]->Clear();
 }
@@ -677,6 +859,37 @@ void Tesseract::ResetDocumentDictionary() {
   for (int i = 0; i < sub_langs_.size(); ++i) {
     sub_langs_[i]->getDict().ResetDocumentDictionary();
   }
+  for (int h = 0; h < pass1_helpers_.size(); ++h)
+    pass1_helpers_[h]->ResetDocumentDictionary();
+}
+
+void Tesseract::set_profile(PageProfile* profile) {
+  profile_ = profile;
+#ifndef ANDROID_BUILD
+  if (lstm_recognizer_ != NULL) lstm_recognizer_->set_profile(profile);
+#endif
+  for (int i = 0; i < sub_langs_.size(); ++i)
+    sub_langs_[i]->set_profile(profile);
+  for (int h = 0; h < pass1_helpers_.size(); ++h)
+    pass1_helpers_[h]->set_profile(profile);
+}
+
+void Tesseract::SetDeadlineMode(bool on) {
+  deadline_mode_ = on;
+  for (int i = 0; i < sub_langs_.size(); ++i)
+    sub_langs_[i]->deadline_mode_ = on;
+}
+
+void Tesseract::SetNoLanguageModel(bool on) {
+  no_language_model_ = on;
+  for (int i = 0; i < sub_langs_.size(); ++i)
+    sub_langs_[i]->no_language_model_ = on;
+}
+
+// Forget the document language vote.
+void Tesseract::ResetLanguageVote() {
+  language_votes_.truncate(0);
+  document_language_ = NULL;
 }
 
 void Tesseract::SetBlackAndWhitelist() {
@@ -100,6 +100,7 @@ class DocumentData;
 class EquationDetect;
 class ImageData;
 class LSTMRecognizer;
+class PageProfile;
 class Tesseract;
 
 // A collection of various variables for statistics and debugging.
@@ -150,6 +151,16 @@ struct WordData {
   PointerVector<WERD_RES> lang_words;
 };
 
+// A line image made for the LSTM by LSTMWordImage, with what it was made from.
+struct LSTMLineImage {
+  Pix* source;       // Clone of the BestPix it was clipped from.
+  TBOX box;          // Box asked for, before the padding.
+  FCOORD rotation;   // re_rotation of the block.
+  TBOX revised_box;  // Box the image covers.
+  ImageData* image;  // Owned.
+  int scaled_height; // Target height it is prescaled for, or -1.
+};
+
 // Definition of a Tesseract WordRecognizer. The WordData provides the context
 // of row/block, in_word holds an initialized, possibly pre-classified word,
 // that the recognizer may or may not consume (but if so it sets *in_word=NULL)
@@ -176,6 +187,16 @@ class Tesseract : public Wordrec {
   void ResetAdaptiveClassifier();
   // Clear the document dictionary for this and all subclassifiers.
   void ResetDocumentDictionary();
+  // Forgets the document language vote, so that the next page tries all the
+  // languages again. Call between documents.
+  void ResetLanguageVote();
+  // The document language vote so far: the words recognized acceptably by
+  // each of sub_langs_ and, at index sub_langs_.size(), by this, followed by
+  // the number of pages voted. Empty if nothing was voted yet.
+  const GenericVector<int>& language_votes() const { return language_votes_; }
+  // Replaces the document language vote, eg with one carried over from
+  // another Tesseract of the same languages, and decides on it.
+  void SetLanguageVotes(const GenericVector<int>& votes);
 
   // Set the equation detector.
   void SetEquationDetect(EquationDetect* detector);
@@ -261,6 +282,31 @@ class Tesseract : public Wordrec {
   bool right_to_left() const {
     return right_to_left_;
   }
+  PageProfile* profile() const {
+    return profile_;
+  }
+  // Sets the profile, not owned, that this, its sub-languages, pass 1
+  // helpers and LSTM recognizers add their times to. May be NULL.
+  void set_profile(PageProfile* profile);
+  // True while the rest of the page is recognized with the cheaper
+  // settings of tessedit_deadline_degrade.
+  bool deadline_mode() const {
+    return deadline_mode_;
+  }
+  // Sets the deadline mode of this and its sub-languages.
+  void SetDeadlineMode(bool on);
+  // True while the page is recognized without a language model, as set by
+  // tessedit_no_language_model. The deadline mode is then on too.
+  bool no_language_model() const {
+    return no_language_model_;
+  }
+  // Sets the no language model mode of this and its sub-languages.
+  void SetNoLanguageModel(bool on);
+  // Whether recog_all_words smooths the fonts of the words over the page
+  // with font_recognition_pass. Only output of the word fonts needs it.
+  void set_font_recognition(bool on) {
+    font_recognition_ = on;
+  }
   int num_sub_langs() const {
     return sub_langs_.size();
   }
@@ -303,6 +349,12 @@ class Tesseract : public Wordrec {
 
   int SegmentPage(const STRING* input_file, BLOCK_LIST* blocks,
                   Tesseract* osd_tess, OSResults* osr);
+  // Segments the rectangle of the page at left, top (in image coordinates),
+  // which must lie inside the image, on its own with pageseg_mode, which
+  // must not need OSD, and adds the blocks found to the end of blocks, in
+  // the coordinates of the page. Returns the result of SegmentPage.
+  int SegmentRegion(int left, int top, int width, int height,
+                    PageSegMode pageseg_mode, BLOCK_LIST* blocks);
   void SetupWordScripts(BLOCK_LIST* blocks);
   int AutoPageSeg(PageSegMode pageseg_mode, BLOCK_LIST* blocks,
                   TO_BLOCK_LIST* to_blocks, BLOBNBOX_LIST* diacritic_blobs,
@@ -313,6 +365,16 @@ class Tesseract : public Wordrec {
       Pix** music_mask_pix);
   // par_control.cpp
   void PrerecAllWordsPar(const GenericVector<WordData>& words);
+  // Returns the number of threads pass 1 of the given page may recognize
+  // rows with, creating the helper copies of the languages if needed.
+  // Returns 1 if pass 1 must run sequentially on this.
+  int Pass1Threads(PAGE_RES* page_res, ETEXT_DESC* monitor,
+                   const TBOX* target_word_box);
+  // Runs pass 1 on num_threads groups of consecutive rows of the page at once,
+  // on this and its helpers, and then adapts to the words in page order.
+  // Returns false on timeout, like RecogAllWordsPassN.
+  bool RecogAllWordsPass1Par(int num_threads, PAGE_RES* page_res,
+                             ETEXT_DESC* monitor);
 
   //// linerec.cpp
   // Generates training data for training a line recognizer, eg LSTM.
@@ -345,10 +407,32 @@ class Tesseract : public Wordrec {
   // is also returned to enable calculation of output bounding boxes.
   ImageData* GetRectImage(const TBOX& box, const BLOCK& block, int padding,
                           TBOX* revised_box) const;
+  // Returns the image LSTMRecognizeWord recognizes for word, setting word_box
+  // to the box it covers, or NULL if there is none.
+  ImageData* GetLSTMWordImage(const BLOCK& block, ROW* row,
+                              const WERD_RES* word, TBOX* word_box);
+  // As GetLSTMWordImage, but the image, prescaled to target_height, belongs
+  // to the line images of the master language, which keep the last few, so
+  // that a word retried in another language is not clipped and scaled again.
+  // It is valid until the page is cleared or kNumLSTMLineImages more calls.
+  const ImageData* LSTMWordImage(const BLOCK& block, ROW* row,
+                                 const WERD_RES* word, int target_height,
+                                 TBOX* word_box);
+  // Frees the line images of LSTMWordImage.
+  void ClearLSTMLineImages();
   // Recognizes a word or group of words, converting to WERD_RES in *words.
   // Analogous to classify_word_pass1, but can handle a group of words as well.
   void LSTMRecognizeWord(const BLOCK& block, ROW *row, WERD_RES *word,
                          PointerVector<WERD_RES>* words);
+  // Recognizes ahead, lstm_batch_size lines at a time, the words that pass 1
+  // will give to LSTMRecognizeWord in the master language, keeping the
+  // results for LSTMRecognizeWord to pick up.
+  // Switches to the deadline mode when monitor, which may be NULL, is about
+  // to run out of time.
+  void LSTMPrerecAllWords(const GenericVector<WordData>& words,
+                          ETEXT_DESC* monitor);
+  // Frees the results of LSTMPrerecAllWords that were not picked up.
+  void ClearLSTMPrerecWords();
   // Apply segmentation search to the given set of words, within the constraints
   // of the existing ratings matrix. If there is already a best_choice on a word
   // leaves it untouched and just sets the done/accepted etc flags.
@@ -365,10 +449,19 @@ class Tesseract : public Wordrec {
                           GenericVector<WordData>* words);
   // Sets up the single word ready for whichever engine is to be run.
   void SetupWordPassN(int pass_n, WordData* word);
-  // Runs word recognition on all the words.
+  // Runs word recognition on all the words. If make_last_fuzzy is not NULL,
+  // it is set if the word following the last one in words, which pr_it
+  // does not reach, should be made fuzzy.
   bool RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
                           PAGE_RES_IT* pr_it,
-                          GenericVector<WordData>* words);
+                          GenericVector<WordData>* words,
+                          bool* make_last_fuzzy);
+  // Returns true if tessedit_deadline_degrade is on and, at the rate that
+  // the time since start_left, the seconds_to_deadline() of monitor when the
+  // first item started, was spent on done of total items, the rest of them
+  // would not be done before the deadline of monitor.
+  bool DeadlineApproaching(const ETEXT_DESC* monitor, double start_left,
+                           int done, int total) const;
   bool recog_all_words(PAGE_RES* page_res,
                        ETEXT_DESC* monitor,
                        const TBOX* target_word_box,
@@ -378,6 +471,10 @@ class Tesseract : public Wordrec {
                         ETEXT_DESC* monitor,
                         const TBOX* target_word_box,
                         const char* word_config);
+  // Runs the rejection passes that recog_all_words deferred under
+  // tessedit_lazy_rejection, if any. Must be called on page_res before its
+  // reject maps or unlv_crunch_modes are read.
+  void RunDeferredRejection(PAGE_RES* page_res);
   void bigram_correction_pass(PAGE_RES *page_res);
   void blamer_pass(PAGE_RES* page_res);
   // Sets script positions and detects smallcaps on all output words.
@@ -429,6 +526,29 @@ class Tesseract : public Wordrec {
                            STRING* best_str, float* c2);
   void classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
                                   WordData* word_data);
+  // Returns true if lang_t, one of this and sub_langs_, is not to be tried,
+  // because the document language vote chose another one.
+  bool SkipLanguage(const Tesseract* lang_t) const {
+    return document_language_ != NULL && lang_t != document_language_;
+  }
+  // Chooses the document language once enough pages have voted and one
+  // language has won clearly.
+  void DecideDocumentLanguage();
+  // Returns the language of other, ie other or one of its sub_langs_, that is
+  // at the same index in other as lang_t is in this, or NULL if lang_t is not
+  // one of the languages of this.
+  Tesseract* MatchingLanguage(const Tesseract* lang_t, Tesseract* other) const;
+  // Copies the params, images and document language vote of this to the
+  // same languages of the pass 1 helper, and lends it the adapted templates.
+  void SharePageWithHelper(Tesseract* helper);
+  // Undoes SharePageWithHelper.
+  void UnsharePageWithHelper(Tesseract* helper);
+  // Points the word that the pass 1 helper recognized at the languages of
+  // this instead of those of the helper.
+  void AdoptHelperWord(const Tesseract& helper, WERD_RES* word);
+  // Sends the pass 1 result word to the adaptive classifier for training,
+  // if it is good enough.
+  void AdaptToPass1Word(WERD_RES* word);
   void classify_word_pass1(const WordData& word_data,
                            WERD_RES** in_word,
                            PointerVector<WERD_RES>* out_words);
@@ -640,6 +760,8 @@ class Tesseract : public Wordrec {
   inT16 fp_eval_word_spacing(WERD_RES_LIST &word_res_list);
   void fix_noisy_space_list(WERD_RES_LIST &best_perm, ROW *row, BLOCK* block);
   void fix_fuzzy_space_list(WERD_RES_LIST &best_perm, ROW *row, BLOCK* block);
+  BOOL8 fuzzy_gaps_are_spaces(WERD_RES_IT word_it, WERD_RES *last_word,
+                              ROW *row);
   void fix_sp_fp_word(WERD_RES_IT &word_res_it, ROW *row, BLOCK* block);
   void fix_fuzzy_spaces(                      //find fuzzy words
                         ETEXT_DESC *monitor,  //progress monitor
@@ -814,6 +936,36 @@ class Tesseract : public Wordrec {
             "Page seg mode: 0=osd only, 1=auto+osd, 2=auto, 3=col, 4=block,"
             " 5=line, 6=word, 7=char"
             " (Values from PageSegMode enum in publictypes.h)");
+  INT_VAR_H(thresholding_method, 0,
+            "Thresholding method: 0=Otsu, 1=adaptive Otsu, 2=Sauvola"
+            " (Values from ThresholdMethod enum in thresholder.h)");
+  double_VAR_H(thresholding_window_size, 0.33,
+               "Window size of Sauvola, in inches");
+  double_VAR_H(thresholding_kfactor, 0.34,
+               "Factor of the local deviation in Sauvola thresholds");
+  double_VAR_H(thresholding_tile_size, 0.33,
+               "Tile size of adaptive Otsu, in inches");
+  double_VAR_H(thresholding_smooth_kernel_size, 0.0,
+               "Smoothing of adaptive Otsu thresholds, in inches");
+  double_VAR_H(thresholding_score_fraction, 0.1,
+               "Fraction of the best Otsu score accepted by adaptive Otsu");
+  BOOL_VAR_H(tessedit_adaptive_resolution, false,
+             "Recognize each page at the resolution where its text is about"
+             " tessedit_target_text_height pixels high");
+  INT_VAR_H(tessedit_target_text_height, 20,
+            "Median height in pixels of the characters of a page at the"
+            " resolution picked by tessedit_adaptive_resolution");
+  BOOL_VAR_H(tessedit_skip_blank_pages, false,
+             "Threshold pages with next to no ink to nothing, skipping their"
+             " layout and recognition");
+  double_VAR_H(tessedit_blank_page_ink, 0.0002,
+               "Largest fraction of ink of a page skipped as blank");
+  BOOL_VAR_H(tessedit_dewarp, false,
+             "Straighten the curled text lines of pages, such as scans of"
+             " bound books, before recognizing them; not with textonly_pdf");
+  BOOL_VAR_H(tessedit_color_reduction, false,
+             "Reduce color images with little color to grey and bitonal"
+             " images to binary before thresholding, and keep them reduced");
   INT_VAR_H(tessedit_ocr_engine_mode, tesseract::OEM_DEFAULT,
             "Which OCR engine(s) to run (Tesseract, LSTM, both). Defaults"
             " to loading and running the most accurate available.");
@@ -911,11 +1063,37 @@ class Tesseract : public Wordrec {
   double_VAR_H(test_pt_x, 99999.99, "xcoord");
   double_VAR_H(test_pt_y, 99999.99, "ycoord");
   INT_VAR_H(multilang_debug_level, 0, "Print multilang debug info.");
+  INT_VAR_H(multilang_vote_pages, 0,
+            "Pages of a document voting on its language, after which the"
+            " winner is the only language tried. 0 tries all, always");
+  double_VAR_H(multilang_vote_ratio, 0.9,
+               "Share of the voted words the winning language needs");
   INT_VAR_H(paragraph_debug_level, 0, "Print paragraph debug info.");
   BOOL_VAR_H(paragraph_text_based, true,
              "Run paragraph detection on the post-text-recognition "
              "(more accurate)");
   BOOL_VAR_H(lstm_use_matrix, 1, "Use ratings matrix/beam searct with lstm");
+  INT_VAR_H(lstm_batch_size, 16,
+            "Number of lines the LSTM recognizes in a single pass");
+  BOOL_VAR_H(lstm_fast_beam_search, false,
+             "Decode LSTM lines with a faster, less exhaustive beam search");
+  BOOL_VAR_H(lstm_convert_to_int, false,
+             "Convert a float LSTM model to int8 weights when loading it");
+  BOOL_VAR_H(lstm_legacy_on_doubt, false,
+             "In the combined mode, also recognize the words the LSTM is"
+             " unsure of with tesseract, keeping the better result");
+  double_VAR_H(lstm_legacy_min_certainty, -5.0,
+               "Certainty under which lstm_legacy_on_doubt takes an LSTM"
+               " word as unsure, even if the dictionary accepts it");
+  BOOL_VAR_H(tessedit_deadline_degrade, true,
+             "When a page is about to miss its deadline, recognize the rest"
+             " of it without pass 2, adaption or other languages, and with"
+             " LSTM only and a fast beam search");
+  BOOL_VAR_H(tessedit_no_language_model, false,
+             "Recognize without a language model, for codes and numbers:"
+             " as tessedit_deadline_degrade does, but for the whole page,"
+             " and with no dictionary in the LSTM search or dictionary"
+             " correction");
   STRING_VAR_H(outlines_odd, "%| ", "Non standard number of outlines");
   STRING_VAR_H(outlines_2, "ij!?%\":;", "Non standard number of outlines");
   BOOL_VAR_H(docqual_excuse_outline_errs, false,
@@ -951,6 +1129,9 @@ class Tesseract : public Wordrec {
   BOOL_VAR_H(tessedit_debug_doc_rejection, false, "Page stats");
   BOOL_VAR_H(tessedit_debug_quality_metrics, false,
              "Output data to debug file");
+  BOOL_VAR_H(tessedit_lazy_rejection, true,
+             "Defer the document quality rejection passes until the reject"
+             " maps are read");
   BOOL_VAR_H(bland_unrej, false, "unrej potential with no checks");
   double_VAR_H(quality_rowrej_pc, 1.1,
                "good_quality_doc gte good char limit");
@@ -993,6 +1174,9 @@ class Tesseract : public Wordrec {
   INT_VAR_H(fixsp_non_noise_limit, 1,
             "How many non-noise blbs either side?");
   double_VAR_H(fixsp_small_outlines_size, 0.28, "Small if lt xht x this");
+  double_VAR_H(fixsp_clear_space_ratio, 1.5,
+               "Don't search fuzzy spaces that are all at least this times"
+               " the space size of the row (0 to search all)");
   BOOL_VAR_H(tessedit_prefer_joined_punct, false, "Reward punctation joins");
   INT_VAR_H(fixsp_done_mode, 1, "What constitues done for spacing");
   INT_VAR_H(debug_fix_space_level, 0, "Contextual fixspace debug");
@@ -1030,8 +1214,25 @@ class Tesseract : public Wordrec {
   BOOL_VAR_H(tessedit_create_hocr, false, "Write .html hOCR output file");
   BOOL_VAR_H(tessedit_create_tsv, false, "Write .tsv output file");
   BOOL_VAR_H(tessedit_create_pdf, false, "Write .pdf output file");
+  BOOL_VAR_H(tessedit_create_binary, false, "Write .tbr binary result file");
+  BOOL_VAR_H(tessedit_create_profile, false,
+             "Write .profile.json file of the time of each stage");
   BOOL_VAR_H(textonly_pdf, false,
              "Create PDF with only one invisible text layer");
+  BOOL_VAR_H(pdf_overlay, false,
+             "With textonly_pdf, draw the text layer of a page of PDF input"
+             " over a copy of that page");
+  BOOL_VAR_H(pdf_pdfa, false,
+             "Write PDF output as PDF/A-2b, with XMP metadata and an sRGB"
+             " output intent");
+  BOOL_VAR_H(pdf_jbig2, true,
+             "Encode binary page images in PDF output as lossless JBIG2"
+             " instead of G4");
+  BOOL_VAR_H(pdf_mrc, false,
+             "Split color and grey page images in PDF output into a text"
+             " mask, a foreground and a reduced background");
+  INT_VAR_H(pdf_mrc_reduction, 3,
+            "Reduction of the background of pdf_mrc pages");
   STRING_VAR_H(unrecognised_char, "|",
                "Output char for unidentified blobs");
   INT_VAR_H(suspect_level, 99, "Suspect marker level");
@@ -1072,6 +1273,9 @@ class Tesseract : public Wordrec {
   BOOL_VAR_H(tessedit_create_boxfile, false, "Output text with boxes");
   INT_VAR_H(tessedit_page_number, -1,
             "-1 -> All pages, else specific page to process");
+  STRING_VAR_H(tessedit_skip_pages, "",
+               "Pages of PDF input left out of recognition, as 1-based"
+               " numbers and ranges (3,7-9): their output page is empty");
   BOOL_VAR_H(tessedit_write_images, false, "Capture the image from the IPE");
   BOOL_VAR_H(interactive_display_mode, false, "Run interactively?");
   STRING_VAR_H(file_type, ".tif", "Filename extension");
@@ -1084,6 +1288,9 @@ class Tesseract : public Wordrec {
   // choice in OSResults::orientations) to believe the page orientation.
   double_VAR_H(min_orientation_margin, 7.0,
                "Min acceptable orientation margin");
+  BOOL_VAR_H(osd_fast, false,
+             "Detect orientation on a reduced copy of the page, and stop"
+             " once the margin exceeds min_orientation_margin");
   BOOL_VAR_H(textord_tabfind_show_vlines, false, "Debug line finding");
   BOOL_VAR_H(textord_use_cjk_fp_model, FALSE, "Use CJK fixed pitch model");
   BOOL_VAR_H(poly_allow_detailed_fx, false,
@@ -1092,6 +1299,9 @@ class Tesseract : public Wordrec {
              "Only initialize with the config file. Useful if the instance is "
              "not going to be used for OCR but say only for layout analysis.");
   BOOL_VAR_H(textord_equation_detect, false, "Turn on equation detector");
+  BOOL_VAR_H(textord_fast_single_column, false,
+             "Skip tab stop and table finding on pages that look like a "
+             "single column of text");
   BOOL_VAR_H(textord_tabfind_vertical_text, true, "Enable vertical detection");
   BOOL_VAR_H(textord_tabfind_force_vertical_text, false,
              "Force using vertical text page mode");
@@ -1101,6 +1311,41 @@ class Tesseract : public Wordrec {
   double_VAR_H(textord_tabfind_aligned_gap_fraction, 0.75,
                "Fraction of height used as a minimum gap for aligned blobs.");
   INT_VAR_H(tessedit_parallelize, 0, "Run in parallel where possible");
+  INT_VAR_H(tessedit_page_threads, 1,
+            "Number of pages ProcessPages recognizes in parallel");
+  INT_VAR_H(tessedit_page_readahead, 0,
+            "Pages ProcessPages decodes ahead of the page threads, held"
+            " compressed until a thread takes them");
+  INT_VAR_H(tessedit_page_decode_threads, 1,
+            "Threads ProcessPages decodes the pages of PDF input on, ahead"
+            " of the page threads, each with its own reader");
+  INT_VAR_H(tessedit_page_decode_depth, 0,
+            "Decoded PDF pages the decode threads may keep waiting for the"
+            " page threads, 0 for twice the decode threads");
+  BOOL_VAR_H(tessedit_page_pipeline_stats, false,
+             "Print the threads, depths and queue high-water marks of each"
+             " stage once ProcessPages ends a PDF");
+  INT_VAR_H(tessedit_intra_op_threads, 0,
+            "Threads each parallel step of recognizing a page may use,"
+            " 0 for the built-in defaults, 1 for a single thread");
+  INT_VAR_H(tessedit_pass1_threads, 1,
+            "Number of threads pass 1 recognizes the"
+            " rows of a page with, each on its own copy of the languages");
+  INT_VAR_H(tessedit_jpeg_min_dpi, 0,
+            "Decode JPEG pages reduced by 2, 4 or 8 as long as they keep at"
+            " least this resolution, 0 to decode them at full size");
+  STRING_VAR_H(page_cache_dir, "",
+               "Directory of the page result cache, empty disables it");
+  INT_VAR_H(page_cache_size, 1024, "Size limit of the page result cache in MB");
+  BOOL_VAR_H(tessedit_reuse_duplicate_pages, false,
+             "Render pages that are near-duplicates of an earlier page of the"
+             " document with its results instead of recognizing them");
+  double_VAR_H(tessedit_duplicate_page_confidence, 0.98,
+               "Fraction of the words of an earlier page that must be found"
+               " again in place on a page to reuse its results");
+  STRING_VAR_H(tessedit_trace_file, "",
+               "Write a Chrome/Perfetto JSON trace of the work of each thread"
+               " in ProcessPages to this file, empty for none");
   BOOL_VAR_H(preserve_interword_spaces, false,
              "Preserve multiple interword spaces");
   STRING_VAR_H(page_separator, "\f",
@@ -1216,14 +1461,46 @@ class Tesseract : public Wordrec {
   // Most recently used Tesseract out of this and sub_langs_. The default
   // language for the next word.
   Tesseract* most_recently_used_;
+  // The document language vote, as returned by language_votes().
+  GenericVector<int> language_votes_;
+  // The language chosen by the vote, the only one tried for the rest of the
+  // document. NULL while the vote goes on.
+  Tesseract* document_language_;
+  // Copies of this and sub_langs_ that recognize the rows of a page in
+  // parallel with this in pass 1. Created on demand by SetupPass1Helpers.
+  PointerVector<Tesseract> pass1_helpers_;
+  // If true, classify_word_pass1 leaves the adaptive classifier and the
+  // document dictionary alone, so RecogAllWordsPass1Par can update them
+  // later, in word order.
+  bool defer_adaption_;
+  // See deadline_mode().
+  bool deadline_mode_;
+  // See no_language_model().
+  bool no_language_model_;
+  // See set_font_recognition().
+  bool font_recognition_;
   // The size of the font table, ie max possible font id + 1.
   int font_table_size_;
   // Equation detector. Note: this pointer is NOT owned by the class.
   EquationDetect* equ_detect_;
   // LSTM recognizer, if available.
   LSTMRecognizer* lstm_recognizer_;
+  // Words recognized ahead by LSTMPrerecAllWords, and the results of each,
+  // until LSTMRecognizeWord takes them. Taken words are set to NULL.
+  GenericVector<const WERD_RES*> lstm_prerec_words_;
+  PointerVector<PointerVector<WERD_RES> > lstm_prerec_results_;
+  // Index in lstm_prerec_words_ of the next word expected.
+  int lstm_prerec_next_;
+  // Line images of LSTMWordImage, used as a ring, with the index of the next
+  // to replace. The sub languages use those of their master, which is
+  // lstm_line_images_owner_.
+  GenericVector<LSTMLineImage> lstm_line_images_;
+  int lstm_line_images_next_;
+  Tesseract* lstm_line_images_owner_;
   // Output "page" number (actually line number) using TrainLineRecognizer.
   int train_line_page_num_;
+  // Profile of the current page, not owned. May be NULL.
+  PageProfile* profile_;
 };
 
 }  // namespace tesseract
@@ -21,19 +21,56 @@
 
 #include "thresholder.h"
 
+#include <stdint.h>
 #include <string.h>
 
 #include "otsuthr.h"
 
 #include "openclwrapper.h"
+#include "simddetect.h"
+#include "thresholdavx2.h"
+#include "thresholdsse.h"
+#include "tracing.h"
 
 namespace tesseract {
 
+// Smallest half window of Sauvola that Leptonica accepts.
+const int kMinSauvolaHalfWindow = 2;
+// Approximate size in pixels of the tiles of Sauvola, which keep the integral
+// images of the local statistics small.
+const int kSauvolaTileSize = 250;
+// Smallest tile of the adaptive Otsu that Leptonica accepts.
+const int kMinOtsuTileSize = 16;
+// Pixels looked at along the shorter side by ReduceColor.
+const int kColorSampleSize = 400;
+// pixColorFraction limits near black and near white, and the spread of the
+// components that makes a pixel colored, as in pixColorsForQuantization.
+const int kColorDarkThresh = 20;
+const int kColorLightThresh = 248;
+const int kColorDiffThresh = 30;
+// Fraction of colored pixels below which an image is taken for grey.
+const double kMaxGreyColorFraction = 0.00025;
+// Grey levels between these are mid tones, and a bitonal image has at most
+// kMaxBitonalMidFraction of them, from the antialiased edges of the ink.
+const int kBitonalDarkLevel = 48;
+const int kBitonalLightLevel = 208;
+const double kMaxBitonalMidFraction = 0.01;
+// Reduction of the image looked at by IsBlank.
+const int kBlankReduction = 4;
+// Fraction of each side of the page left out by IsBlank.
+const double kBlankMargin = 0.08;
+// Ink is darker than this fraction of the grey of the paper.
+const double kBlankInkLevel = 0.6;
+// Components of the reduction up to this size in both directions are specks.
+const int kBlankSpeckSize = 2;
+
 ImageThresholder::ImageThresholder()
-  : pix_(NULL),
+  : pix_(NULL), borrowed_data_(false),
     image_width_(0), image_height_(0),
     pix_channels_(0), pix_wpl_(0),
-    scale_(1), yres_(300), estimated_res_(300) {
+    scale_(1), yres_(300), estimated_res_(300),
+    threshold_method_(THRESHOLD_OTSU), window_size_(0.33), kfactor_(0.34),
+    tile_size_(0.33), smooth_size_(0.0), score_fraction_(0.1) {
   SetRectangle(0, 0, 0, 0);
 }
 
@@ -43,6 +80,9 @@ ImageThresholder::~ImageThresholder() {
 
 // Destroy the Pix if there is one, freeing memory.
 void ImageThresholder::Clear() {
+  // Clones of pix_ share its header, so none of them frees borrowed data.
+  if (pix_ != NULL && borrowed_data_) pixSetData(pix_, NULL);
+  borrowed_data_ = false;
   pixDestroy(&pix_);
 }
 
@@ -116,6 +156,42 @@ void ImageThresholder::SetImage(const unsigned char* imagedata,
   pixDestroy(&pix);
 }
 
+bool ImageThresholder::SetBorrowedImage(unsigned char* imagedata,
+                                        int width, int height,
+                                        int bytes_per_pixel,
+                                        int bytes_per_line) {
+  Clear();
+  if ((bytes_per_pixel != 0 && bytes_per_pixel != 1) ||
+      bytes_per_line % 4 != 0 ||
+      reinterpret_cast<uintptr_t>(imagedata) % 4 != 0) {
+    tprintf("Cannot wrap image data with %d bytes per pixel and %d per line\n",
+            bytes_per_pixel, bytes_per_line);
+    return false;
+  }
+  Pix* pix = pixCreateHeader(width, height, bytes_per_pixel == 0 ? 1 : 8);
+  if (pix == NULL || bytes_per_line / 4 < pixGetWpl(pix)) {
+    tprintf("Image data of %d bytes per line is too short\n", bytes_per_line);
+    pixDestroy(&pix);
+    return false;
+  }
+  pixSetWpl(pix, bytes_per_line / 4);
+  pixSetData(pix, reinterpret_cast<l_uint32*>(imagedata));
+  // Leptonica keeps the pixels of a word from its most significant byte.
+  pixEndianByteSwap(pix);
+  if (bytes_per_pixel == 0) pixInvert(pix, pix);
+  pixSetYRes(pix, 300);
+  pix_ = pix;
+  borrowed_data_ = true;
+  image_width_ = width;
+  image_height_ = height;
+  pix_channels_ = bytes_per_pixel;
+  pix_wpl_ = pixGetWpl(pix_);
+  scale_ = 1;
+  estimated_res_ = yres_ = pixGetYRes(pix_);
+  Init();
+  return true;
+}
+
 // Store the coordinates of the rectangle to process for later use.
 // Doesn't actually do any thresholding.
 void ImageThresholder::SetRectangle(int left, int top, int width, int height) {
@@ -146,14 +222,21 @@ void ImageThresholder::GetImageSizes(int* left, int* top,
 // immediately after, but may not go away until after the Thresholder has
 // finished with it.
 void ImageThresholder::SetImage(const Pix* pix) {
-  if (pix_ != NULL)
-    pixDestroy(&pix_);
+  SetPix(pix, true);
+}
+
+void ImageThresholder::SetBorrowedImage(const Pix* pix) {
+  SetPix(pix, false);
+}
+
+void ImageThresholder::SetPix(const Pix* pix, bool copy) {
+  Clear();
   Pix* src = const_cast<Pix*>(pix);
   int depth;
   pixGetDimensions(src, &image_width_, &image_height_, &depth);
   // Convert the image as necessary so it is one of binary, plain RGB, or
-  // 8 bit with no colormap. Guarantee that we always end up with our own copy,
-  // not just a clone of the input.
+  // 8 bit with no colormap. Unless borrowing, guarantee that we always end up
+  // with our own copy, not just a clone of the input.
   if (pixGetColormap(src)) {
     Pix* tmp = pixRemoveColormap(src, REMOVE_CMAP_BASED_ON_SRC);
     depth = pixGetDepth(tmp);
@@ -166,7 +249,7 @@ void ImageThresholder::SetImage(const Pix* pix) {
   } else if (depth > 1 && depth < 8) {
     pix_ = pixConvertTo8(src, false);
   } else {
-    pix_ = pixCopy(NULL, src);
+    pix_ = copy ? pixCopy(NULL, src) : pixClone(src);
   }
   depth = pixGetDepth(pix_);
   pix_channels_ = depth / 8;
@@ -176,11 +259,102 @@ void ImageThresholder::SetImage(const Pix* pix) {
   Init();
 }
 
+void ImageThresholder::ReplacePix(Pix* pix) {
+  if (borrowed_data_) pixSetData(pix_, NULL);
+  borrowed_data_ = false;
+  pixDestroy(&pix_);
+  pix_ = pix;
+  pix_channels_ = pixGetDepth(pix_) / 8;
+  pix_wpl_ = pixGetWpl(pix_);
+}
+
+// Classifies the source image from a subsample of its pixels, and replaces
+// a grey looking color image with its luminance and a bitonal looking one
+// with its threshold at the middle grey.
+ImageColorClass ImageThresholder::ReduceColor() {
+  if (IsBinary()) return IMAGE_BITONAL;
+  int factor = MAX(1, MIN(image_width_, image_height_) / kColorSampleSize);
+  if (IsColor()) {
+    l_float32 pix_fraction, color_fraction;
+    if (pixColorFraction(pix_, kColorDarkThresh, kColorLightThresh,
+                         kColorDiffThresh, factor, &pix_fraction,
+                         &color_fraction) != 0 ||
+        pix_fraction * color_fraction >= kMaxGreyColorFraction) {
+      return IMAGE_COLOR;
+    }
+    Pix* grey = pixConvertRGBToLuminance(pix_);
+    if (grey == NULL) return IMAGE_COLOR;
+    pixCopyResolution(grey, pix_);
+    ReplacePix(grey);
+  }
+  if (pixGetDepth(pix_) != 8) return IMAGE_GREY;
+  NUMA* histogram = pixGetGrayHistogram(pix_, factor);
+  if (histogram == NULL) return IMAGE_GREY;
+  l_float32 total, mid;
+  numaGetSum(histogram, &total);
+  numaGetSumOnInterval(histogram, kBitonalDarkLevel, kBitonalLightLevel,
+                       &mid);
+  numaDestroy(&histogram);
+  if (total <= 0 || mid > kMaxBitonalMidFraction * total) return IMAGE_GREY;
+  Pix* binary = pixThresholdToBinary(pix_, 128);
+  if (binary == NULL) return IMAGE_GREY;
+  pixCopyResolution(binary, pix_);
+  ReplacePix(binary);
+  return IMAGE_BITONAL;
+}
+
+// Returns true if the rectangle is blank but for specks, margins and at most
+// max_ink of its area in ink.
+bool ImageThresholder::IsBlank(double max_ink) {
+  Pix* pix = GetPixRect();
+  Pix* ink = NULL;
+  if (IsBinary()) {
+    ink = pixReduceRankBinaryCascade(pix, 1, 1, 0, 0);
+  } else {
+    Pix* grey = pixConvertTo8(pix, false);
+    Pix* reduced = grey != NULL ? pixScaleGrayMinMax(grey, kBlankReduction,
+                                                     kBlankReduction,
+                                                     L_CHOOSE_MIN)
+                                : NULL;
+    pixDestroy(&grey);
+    NUMA* histogram = reduced != NULL ? pixGetGrayHistogram(reduced, 1) : NULL;
+    l_float32 paper = 0.0f;
+    if (histogram != NULL &&
+        numaHistogramGetValFromRank(histogram, 0.5, &paper) == 0) {
+      ink = pixThresholdToBinary(reduced,
+                                 static_cast<int>(paper * kBlankInkLevel));
+    }
+    numaDestroy(&histogram);
+    pixDestroy(&reduced);
+  }
+  pixDestroy(&pix);
+  if (ink == NULL) return false;
+  int width = pixGetWidth(ink);
+  int height = pixGetHeight(ink);
+  int margin_x = static_cast<int>(width * kBlankMargin);
+  int margin_y = static_cast<int>(height * kBlankMargin);
+  Box* box = boxCreate(margin_x, margin_y, width - 2 * margin_x,
+                       height - 2 * margin_y);
+  Pix* inner = pixClipRectangle(ink, box, NULL);
+  boxDestroy(&box);
+  pixDestroy(&ink);
+  if (inner == NULL) return false;
+  Pix* marks = pixSelectBySize(inner, kBlankSpeckSize, kBlankSpeckSize, 8,
+                               L_SELECT_IF_EITHER, L_SELECT_IF_GT, NULL);
+  l_int32 count = 0;
+  bool blank = marks != NULL && pixCountPixels(marks, &count, NULL) == 0 &&
+      count <= max_ink * pixGetWidth(inner) * pixGetHeight(inner);
+  pixDestroy(&marks);
+  pixDestroy(&inner);
+  return blank;
+}
+
 // Threshold the source image as efficiently as possible to the output Pix.
 // Creates a Pix and sets pix to point to the resulting pointer.
 // Caller must use pixDestroy to free the created Pix.
 /// Returns false on error.
 bool ImageThresholder::ThresholdToPix(PageSegMode pageseg_mode, Pix** pix) {
+  TESS_TRACE_SPAN("ImageThresholder::ThresholdToPix");
   if (image_width_ > MAX_INT16 || image_height_ > MAX_INT16) {
     tprintf("Image too large: (%d, %d)\n", image_width_, image_height_);
     return false;
@@ -191,12 +365,26 @@ bool ImageThresholder::ThresholdToPix(PageSegMode pageseg_mode, Pix** pix) {
     Pix* original = GetPixRect();
     *pix = pixCopy(nullptr, original);
     pixDestroy(&original);
+  } else if (threshold_method_ != THRESHOLD_OTSU) {
+    AdaptiveThresholdRectToPix(pix);
   } else {
     OtsuThresholdRectToPix(pix_, pix);
   }
   return true;
 }
 
+void ImageThresholder::SetThresholdMethod(ThresholdMethod method,
+                                          double window_size, double kfactor,
+                                          double tile_size, double smooth_size,
+                                          double score_fraction) {
+  threshold_method_ = method;
+  window_size_ = window_size;
+  kfactor_ = kfactor;
+  tile_size_ = tile_size;
+  smooth_size_ = smooth_size;
+  score_fraction_ = score_fraction;
+}
+
 // Gets a pix that contains an 8 bit threshold value at each pixel. The
 // returned pix may be an integer reduction of the binary image such that
 // the scale factor may be inferred from the ratio of the sizes, even down
@@ -290,6 +478,43 @@ void ImageThresholder::OtsuThresholdRectToPix(Pix* src_pix,
   PERF_COUNT_END
 }
 
+// Thresholds the grey of the rectangle with the Leptonica method chosen by
+// SetThresholdMethod, falling back to Otsu if Leptonica fails.
+void ImageThresholder::AdaptiveThresholdRectToPix(Pix** out_pix) {
+  PERF_COUNT_START("AdaptiveThresholdRectToPix")
+  Pix* grey = GetPixRectGrey();
+  int width = pixGetWidth(grey);
+  int height = pixGetHeight(grey);
+  int result = 1;
+  if (threshold_method_ == THRESHOLD_SAUVOLA) {
+    // Leptonica needs the window to fit in the image and in every tile.
+    int half_window = MAX(kMinSauvolaHalfWindow,
+                          static_cast<int>(window_size_ * yres_ / 2));
+    half_window = MIN(half_window, (MIN(width, height) - 3) / 2);
+    int tile_size = MAX(kSauvolaTileSize, half_window + 2);
+    int nx = MAX(1, width / tile_size);
+    int ny = MAX(1, height / tile_size);
+    if (half_window >= kMinSauvolaHalfWindow) {
+      result = pixSauvolaBinarizeTiled(grey, half_window, MAX(kfactor_, 0.0),
+                                       nx, ny, NULL, out_pix);
+    }
+  } else {
+    int tile_size = MAX(kMinOtsuTileSize,
+                        static_cast<int>(tile_size_ * yres_));
+    int half_smooth = MAX(0, static_cast<int>(smooth_size_ * yres_ / 2));
+    result = pixOtsuAdaptiveThreshold(grey, tile_size, tile_size, half_smooth,
+                                      half_smooth, score_fraction_, NULL,
+                                      out_pix);
+  }
+  pixDestroy(&grey);
+  PERF_COUNT_END
+  if (result != 0 || *out_pix == NULL) {
+    // Too small for the windows, or out of memory.
+    pixDestroy(out_pix);
+    OtsuThresholdRectToPix(pix_, out_pix);
+  }
+}
+
 /// Threshold the rectangle, taking everything except the src_pix
 /// from the class, using thresholds/hi_values to the output pix.
 /// NOTE that num_channels is the size of the thresholds and hi_values
@@ -305,10 +530,26 @@ void ImageThresholder::ThresholdRectToPix(Pix* src_pix,
   int wpl = pixGetWpl(*pix);
   int src_wpl = pixGetWpl(src_pix);
   uinT32* srcdata = pixGetData(src_pix);
+  // The SIMD kernels do whole words of the output, and need the rectangle
+  // to start on a source word.
+  int simd_words = 0;
+  if ((SIMDDetect::IsAVX2Available() || SIMDDetect::IsSSEAvailable()) &&
+      (num_channels == 4 || (num_channels == 1 && rect_left_ % 4 == 0)))
+    simd_words = rect_width_ / 32;
   for (int y = 0; y < rect_height_; ++y) {
     const uinT32* linedata = srcdata + (y + rect_top_) * src_wpl;
     uinT32* pixline = pixdata + y * wpl;
-    for (int x = 0; x < rect_width_; ++x) {
+    if (simd_words > 0) {
+      const uinT32* rectdata = linedata + rect_left_ * num_channels / 4;
+      if (SIMDDetect::IsAVX2Available()) {
+        ThresholdRowAVX2(rectdata, num_channels, simd_words, thresholds,
+                         hi_values, pixline);
+      } else {
+        ThresholdRowSSE(rectdata, num_channels, simd_words, thresholds,
+                        hi_values, pixline);
+      }
+    }
+    for (int x = simd_words * 32; x < rect_width_; ++x) {
       bool white_result = true;
       for (int ch = 0; ch < num_channels; ++ch) {
         int pixel =
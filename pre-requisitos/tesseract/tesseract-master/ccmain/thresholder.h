@@ -27,6 +27,21 @@ struct Pix;
 
 namespace tesseract {
 
+// How ThresholdToPix binarizes an image that is not already binary.
+enum ThresholdMethod {
+  THRESHOLD_OTSU,           // One Otsu threshold per channel for the image.
+  THRESHOLD_ADAPTIVE_OTSU,  // Leptonica Otsu threshold per tile of grey.
+  THRESHOLD_SAUVOLA,        // Leptonica tiled Sauvola on the grey image.
+  THRESHOLD_METHOD_COUNT
+};
+
+// What ReduceColor found the source image to be.
+enum ImageColorClass {
+  IMAGE_BITONAL,  // Only near black and near white pixels, or binary.
+  IMAGE_GREY,     // Too little color to matter, but with mid tones.
+  IMAGE_COLOR,    // Color, or nothing was checked.
+};
+
 /// Base class for all tesseract image thresholding classes.
 /// Specific classes can add new thresholding methods by
 /// overriding ThresholdToPix.
@@ -55,6 +70,17 @@ class TESS_API ImageThresholder {
   void SetImage(const unsigned char* imagedata, int width, int height,
                 int bytes_per_pixel, int bytes_per_line);
 
+  /// Like SetImage above, but wraps imagedata in a Pix instead of copying
+  /// it, for greyscale of 8 bits per pixel and binary (bytes_per_pixel=0)
+  /// only. imagedata must start on a 4 byte boundary and bytes_per_line
+  /// must be a multiple of 4. The rows are converted in place to the word
+  /// order of leptonica, and binary is inverted to make one pixels black,
+  /// so imagedata is changed, and must stay valid and unchanged until the
+  /// next SetImage or Clear. Returns false, setting no image, if imagedata
+  /// can't be wrapped.
+  bool SetBorrowedImage(unsigned char* imagedata, int width, int height,
+                        int bytes_per_pixel, int bytes_per_line);
+
   /// Store the coordinates of the rectangle to process for later use.
   /// Doesn't actually do any thresholding.
   void SetRectangle(int left, int top, int width, int height);
@@ -114,12 +140,42 @@ class TESS_API ImageThresholder {
   /// finished with it.
   void SetImage(const Pix* pix);
 
+  /// Like SetImage for Pix, but keeps a clone of pix instead of a copy when
+  /// it needs no conversion, so pix must not be changed until the next
+  /// SetImage or Clear.
+  void SetBorrowedImage(const Pix* pix);
+
   /// Threshold the source image as efficiently as possible to the output Pix.
   /// Creates a Pix and sets pix to point to the resulting pointer.
   /// Caller must use pixDestroy to free the created Pix.
   /// Returns false on error.
   virtual bool ThresholdToPix(PageSegMode pageseg_mode, Pix** pix);
 
+  // Selects the method of ThresholdToPix, THRESHOLD_OTSU by default. The
+  // sizes are in inches of the source image. window_size and kfactor are
+  // the window and the deviation factor of Sauvola, and tile_size,
+  // smooth_size and score_fraction are the tiles, the smoothing of the tile
+  // thresholds and the fraction of the best Otsu score accepted by the
+  // adaptive Otsu.
+  void SetThresholdMethod(ThresholdMethod method, double window_size,
+                          double kfactor, double tile_size,
+                          double smooth_size, double score_fraction);
+
+  // Classifies the source image from a subsample of its pixels, and replaces
+  // a grey looking color image with its luminance and a bitonal looking one
+  // with its threshold at the middle grey, so that thresholding and whatever
+  // stores the image deal with one channel or one bit. Takes a few
+  // milliseconds, far less than the Otsu it saves. The whole image is
+  // reduced, whatever the rectangle, so any clone of it taken before, such
+  // as the input image of TessBaseAPI, must be taken again.
+  ImageColorClass ReduceColor();
+
+  // Returns true if the rectangle is blank but for specks, the shadows of
+  // the edges and holes of the paper, and at most max_ink of its area in
+  // ink darker than 60% of the paper. It is looked at reduced 4 times, with
+  // the darkest pixel of each cell, so that no stroke is lost.
+  bool IsBlank(double max_ink);
+
   // Gets a pix that contains an 8 bit threshold value at each pixel. The
   // returned pix may be an integer reduction of the binary image such that
   // the scale factor may be inferred from the ratio of the sizes, even down
@@ -149,6 +205,13 @@ class TESS_API ImageThresholder {
   /// Common initialization shared between SetImage methods.
   virtual void Init();
 
+  /// Sets pix_ from pix, converted as SetImage needs, and copied if copy or
+  /// if it was not converted.
+  void SetPix(const Pix* pix, bool copy);
+
+  /// Replaces pix_ with pix, taking ownership of it.
+  void ReplacePix(Pix* pix);
+
   /// Return true if we are processing the full image.
   bool IsFullImage() const {
     return rect_left_ == 0 && rect_top_ == 0 &&
@@ -158,6 +221,10 @@ class TESS_API ImageThresholder {
   // Otsu thresholds the rectangle, taking the rectangle from *this.
   void OtsuThresholdRectToPix(Pix* src_pix, Pix** out_pix) const;
 
+  // Thresholds the grey of the rectangle with the Leptonica method chosen by
+  // SetThresholdMethod, falling back to Otsu if Leptonica fails.
+  void AdaptiveThresholdRectToPix(Pix** out_pix);
+
   /// Threshold the rectangle, taking everything except the src_pix
   /// from the class, using thresholds/hi_values to the output pix.
   /// NOTE that num_channels is the size of the thresholds and hi_values
@@ -170,6 +237,8 @@ class TESS_API ImageThresholder {
   /// Clone or other copy of the source Pix.
   /// The pix will always be PixDestroy()ed on destruction of the class.
   Pix*                 pix_;
+  /// True if the data of pix_ belongs to the caller of SetBorrowedImage.
+  bool                 borrowed_data_;
 
   int                  image_width_;    //< Width of source pix_.
   int                  image_height_;   //< Height of source pix_.
@@ -183,6 +252,13 @@ class TESS_API ImageThresholder {
   int                  rect_top_;
   int                  rect_width_;
   int                  rect_height_;
+  // Settings of SetThresholdMethod.
+  ThresholdMethod      threshold_method_;
+  double               window_size_;
+  double               kfactor_;
+  double               tile_size_;
+  double               smooth_size_;
+  double               score_fraction_;
 };
 
 }  // namespace tesseract.
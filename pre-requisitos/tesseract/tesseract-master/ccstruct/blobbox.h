@@ -22,6 +22,7 @@
 
 #include          "clst.h"
 #include          "elst2.h"
+#include          "objectpool.h"
 #include          "werd.h"
 #include          "ocrblock.h"
 #include          "statistc.h"
@@ -125,7 +126,8 @@ class ColPartition;
 
 class BLOBNBOX;
 ELISTIZEH (BLOBNBOX)
-class BLOBNBOX:public ELIST_LINK
+class BLOBNBOX : public ELIST_LINK,
+                 public tesseract::PooledObject<BLOBNBOX>
 {
   public:
     BLOBNBOX() {
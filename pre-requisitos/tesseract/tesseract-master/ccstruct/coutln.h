@@ -22,6 +22,7 @@
 
 #include          "crakedge.h"
 #include          "mod128.h"
+#include          "objectpool.h"
 #include          "bits16.h"
 #include          "rect.h"
 #include          "blckerr.h"
@@ -66,7 +67,8 @@ class DLLSYM C_OUTLINE;          //forward declaration
 struct Pix;
 
 ELISTIZEH (C_OUTLINE)
-class DLLSYM C_OUTLINE:public ELIST_LINK {
+class DLLSYM C_OUTLINE : public ELIST_LINK,
+                          public tesseract::PooledObject<C_OUTLINE> {
  public:
   C_OUTLINE() {  //empty constructor
       steps = NULL;
@@ -34,11 +34,16 @@
 #include "boxread.h"
 #include "callcpp.h"
 #include "helpers.h"
+#include "opthreads.h"
 #include "tprintf.h"
 
 // Number of documents to read ahead while training. Doesn't need to be very
 // large.
 const int kMaxReadAhead = 8;
+// Number of pages that a document load pre-scales at a time.
+const int kPreScaleBatchSize = 64;
+// Default number of threads to pre-scale a batch of pages on.
+const int kNumPreScaleThreads = 4;
 
 namespace tesseract {
 
@@ -119,14 +124,21 @@ int FloatWordFeature::SortByXBucket(const void* v1, const void* v2) {
   return x_diff;
 }
 
-ImageData::ImageData() : page_number_(-1), vertical_text_(false) {
+ImageData::ImageData()
+  : page_number_(-1), pix_(NULL), vertical_text_(false), scaled_pix_(NULL),
+    scaled_target_height_(0), scaled_max_height_(0), input_width_(0),
+    input_height_(0) {
 }
-// Takes ownership of the pix and destroys it.
+// Takes ownership of the pix.
 ImageData::ImageData(bool vertical, Pix* pix)
-  : page_number_(0), vertical_text_(vertical) {
+  : page_number_(0), pix_(NULL), vertical_text_(vertical), scaled_pix_(NULL),
+    scaled_target_height_(0), scaled_max_height_(0), input_width_(0),
+    input_height_(0) {
   SetPix(pix);
 }
 ImageData::~ImageData() {
+  pixDestroy(&pix_);
+  pixDestroy(&scaled_pix_);
 }
 
 // Builds and returns an ImageData from the basic data. Note that imagedata,
@@ -165,7 +177,13 @@ ImageData* ImageData::Build(const char* name, int page_number, const char* lang,
 bool ImageData::Serialize(TFile* fp) const {
   if (!imagefilename_.Serialize(fp)) return false;
   if (fp->FWrite(&page_number_, sizeof(page_number_), 1) != 1) return false;
-  if (!image_data_.Serialize(fp)) return false;
+  if (pix_ != NULL) {
+    GenericVector<char> image_data;
+    SetPixInternal(pix_, &image_data);
+    if (!image_data.Serialize(fp)) return false;
+  } else if (!image_data_.Serialize(fp)) {
+    return false;
+  }
   if (!language_.Serialize(fp)) return false;
   if (!transcription_.Serialize(fp)) return false;
   // WARNING: Will not work across different endian machines.
@@ -182,6 +200,8 @@ bool ImageData::DeSerialize(TFile* fp) {
   if (!imagefilename_.DeSerialize(fp)) return false;
   if (fp->FReadEndian(&page_number_, sizeof(page_number_), 1) != 1)
     return false;
+  pixDestroy(&pix_);
+  pixDestroy(&scaled_pix_);
   if (!image_data_.DeSerialize(fp)) return false;
   if (!language_.DeSerialize(fp)) return false;
   if (!transcription_.DeSerialize(fp)) return false;
@@ -208,13 +228,19 @@ bool ImageData::SkipDeSerialize(TFile* fp) {
   return fp->FRead(&vertical, sizeof(vertical), 1) == 1;
 }
 
-// Saves the given Pix as a PNG-encoded string and destroys it.
+// Takes ownership of the given Pix, which is only PNG-encoded if *this is
+// serialized.
 void ImageData::SetPix(Pix* pix) {
-  SetPixInternal(pix, &image_data_);
+  pixDestroy(&scaled_pix_);
+  pixDestroy(&pix_);
+  image_data_.clear();
+  pix_ = pix;
 }
 
-// Returns the Pix image for *this. Must be pixDestroyed after use.
+// Returns the Pix image for *this. Must be pixDestroyed after use, and not
+// changed, as it may be shared with *this.
 Pix* ImageData::GetPix() const {
+  if (pix_ != NULL) return pixClone(pix_);
   return GetPixInternal(image_data_);
 }
 
@@ -229,10 +255,18 @@ Pix* ImageData::PreScale(int target_height, int max_height, float* scale_factor,
                          GenericVector<TBOX>* boxes) const {
   int input_width = 0;
   int input_height = 0;
-  Pix* src_pix = GetPix();
-  ASSERT_HOST(src_pix != NULL);
-  input_width = pixGetWidth(src_pix);
-  input_height = pixGetHeight(src_pix);
+  Pix* src_pix = NULL;
+  bool cached = scaled_pix_ != NULL && target_height == scaled_target_height_ &&
+                max_height == scaled_max_height_;
+  if (cached) {
+    input_width = input_width_;
+    input_height = input_height_;
+  } else {
+    src_pix = GetPix();
+    ASSERT_HOST(src_pix != NULL);
+    input_width = pixGetWidth(src_pix);
+    input_height = pixGetHeight(src_pix);
+  }
   if (target_height == 0) {
     target_height = MIN(input_height, max_height);
   }
@@ -241,8 +275,10 @@ Pix* ImageData::PreScale(int target_height, int max_height, float* scale_factor,
     *scaled_width = IntCastRounded(im_factor * input_width);
   if (scaled_height != NULL)
     *scaled_height = target_height;
-  // Get the scaled image.
-  Pix* pix = pixScale(src_pix, im_factor, im_factor);
+  // Get the scaled image. The callers may change it, so never share the
+  // cached one.
+  Pix* pix = cached ? pixCopy(NULL, scaled_pix_)
+                    : pixScale(src_pix, im_factor, im_factor);
   if (pix == NULL) {
     tprintf("Scaling pix of size %d, %d by factor %g made null pix!!\n",
             input_width, input_height, im_factor);
@@ -268,8 +304,31 @@ Pix* ImageData::PreScale(int target_height, int max_height, float* scale_factor,
   return pix;
 }
 
+// Decodes and scales the image as PreScale(target_height, max_height) does,
+// and keeps the result, so that PreScale with the same heights only has to
+// copy it. Must be called before *this is shared between threads.
+void ImageData::CachePreScaled(int target_height, int max_height) {
+  pixDestroy(&scaled_pix_);
+  Pix* src_pix = GetPix();
+  if (src_pix == NULL) return;
+  input_width_ = pixGetWidth(src_pix);
+  input_height_ = pixGetHeight(src_pix);
+  int height = target_height;
+  if (height == 0) height = MIN(input_height_, max_height);
+  float im_factor = static_cast<float>(height) / input_height_;
+  scaled_pix_ = pixScale(src_pix, im_factor, im_factor);
+  pixDestroy(&src_pix);
+  scaled_target_height_ = target_height;
+  scaled_max_height_ = max_height;
+}
+
 int ImageData::MemoryUsed() const {
-  return image_data_.size();
+  int memory = image_data_.size();
+  if (pix_ != NULL)
+    memory += pixGetWpl(pix_) * pixGetHeight(pix_) * 4;
+  if (scaled_pix_ != NULL)
+    memory += pixGetWpl(scaled_pix_) * pixGetHeight(scaled_pix_) * 4;
+  return memory;
 }
 
 // Draws the data in a new window.
@@ -323,12 +382,11 @@ void ImageData::AddBoxes(const GenericVector<TBOX>& boxes,
   }
 }
 
-// Saves the given Pix as a PNG-encoded string and destroys it.
+// Saves the given Pix as a PNG-encoded string.
 void ImageData::SetPixInternal(Pix* pix, GenericVector<char>* image_data) {
   l_uint8* data;
   size_t size;
   pixWriteMem(&data, &size, pix, IFF_PNG);
-  pixDestroy(&pix);
   image_data->resize_no_init(size);
   memcpy(&(*image_data)[0], data, size);
   lept_free(data);
@@ -379,7 +437,9 @@ DocumentData::DocumentData(const STRING& name)
       total_pages_(-1),
       memory_used_(0),
       max_memory_(0),
-      reader_(NULL) {}
+      reader_(NULL),
+      prescale_target_height_(0),
+      prescale_max_height_(0) {}
 
 DocumentData::~DocumentData() {
   SVAutoLock lock_p(&pages_mutex_);
@@ -531,7 +591,11 @@ bool DocumentData::ReCachePages() {
   }
   pages_offset_ %= loaded_pages;
   // Skip pages before the first one we want, and load the rest until max
-  // memory and skip the rest after that.
+  // memory and skip the rest after that. Pages to pre-scale are counted in
+  // batches, their memory known only once they are scaled, so the memory
+  // may go over by up to a batch.
+  int batch_size = prescale_max_height_ > 0 ? kPreScaleBatchSize : 1;
+  int counted_pages = 0;
   int page;
   for (page = 0; page < loaded_pages; ++page) {
     if (page < pages_offset_ ||
@@ -547,9 +611,11 @@ bool DocumentData::ReCachePages() {
         image_data->set_imagefilename(document_name_);
         image_data->set_page_number(page);
       }
-      set_memory_used(memory_used() + image_data->MemoryUsed());
+      if (pages_.size() - counted_pages >= batch_size)
+        counted_pages = CountNewPages(counted_pages);
     }
   }
+  CountNewPages(counted_pages);
   if (page < loaded_pages) {
     tprintf("Deserialize failed: %s read %d/%d pages\n",
             document_name_.string(), page, loaded_pages);
@@ -563,9 +629,30 @@ bool DocumentData::ReCachePages() {
   return !pages_.empty();
 }
 
+// Pre-scales the pages of pages_ from index first, if enabled, and counts
+// up their memory. Returns the new number of counted pages. Call with the
+// pages_mutex_ held.
+int DocumentData::CountNewPages(int first) {
+  int num_pages = pages_.size();
+  if (prescale_max_height_ > 0) {
+#ifdef _OPENMP
+    int num_threads = IntraOpThreads(kNumPreScaleThreads);
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+#endif
+    for (int p = first; p < num_pages; ++p) {
+      pages_[p]->CachePreScaled(prescale_target_height_, prescale_max_height_);
+    }
+  }
+  inT64 memory = memory_used();
+  for (int p = first; p < num_pages; ++p) memory += pages_[p]->MemoryUsed();
+  set_memory_used(memory);
+  return num_pages;
+}
+
 // A collection of DocumentData that knows roughly how much memory it is using.
 DocumentCache::DocumentCache(inT64 max_memory)
-    : num_pages_per_doc_(0), max_memory_(max_memory) {}
+    : num_pages_per_doc_(0), max_memory_(max_memory),
+      prescale_target_height_(0), prescale_max_height_(0), shuffle_(false) {}
 DocumentCache::~DocumentCache() {}
 
 // Adds all the documents in the list of filenames, counting memory.
@@ -584,6 +671,7 @@ bool DocumentCache::LoadDocuments(const GenericVector<STRING>& filenames,
     STRING filename = filenames[arg];
     DocumentData* document = new DocumentData(filename);
     document->SetDocument(filename.string(), fair_share_memory, reader);
+    document->SetPreScale(prescale_target_height_, prescale_max_height_);
     AddToCache(document);
   }
   if (!documents_.empty()) {
@@ -662,7 +750,7 @@ const ImageData* DocumentCache::GetPageSequential(int serial) {
   }
   int doc_index = serial / num_pages_per_doc_ % num_docs;
   const ImageData* doc =
-      documents_[doc_index]->GetPage(serial % num_pages_per_doc_);
+      documents_[doc_index]->GetPage(SequentialPageIndex(serial));
   // Count up total memory. Background loading makes it more complicated to
   // keep a running count.
   inT64 total_memory = 0;
@@ -698,6 +786,37 @@ const ImageData* DocumentCache::GetPageSequential(int serial) {
   return doc;
 }
 
+static int GreatestCommonDivisor(int a, int b) {
+  while (b != 0) {
+    int remainder = a % b;
+    a = b;
+    b = remainder;
+  }
+  return a;
+}
+
+// Returns the index in its document of the page with the given serial for
+// GetPageSequential, which is shuffled per epoch if shuffle_.
+int DocumentCache::SequentialPageIndex(int serial) const {
+  int num_pages = num_pages_per_doc_;
+  int index = serial % num_pages;
+  if (!shuffle_ || num_pages < 2) return index;
+  // The permutation index -> (step * index + offset) % num_pages, with step
+  // coprime to num_pages, costs nothing to evaluate and is different for
+  // each document and epoch, yet the same on every run.
+  int doc_serial = serial / num_pages;
+  int epoch = doc_serial / documents_.size();
+  TRand random;
+  random.set_seed(static_cast<uinT64>(epoch) * 0x10000001 +
+                  doc_serial % documents_.size());
+  random.IntRand();
+  int step = 1 + random.IntRand() % (num_pages - 1);
+  while (GreatestCommonDivisor(step, num_pages) != 1) step = step % (num_pages - 1) + 1;
+  int offset = random.IntRand() % num_pages;
+  return static_cast<int>((static_cast<inT64>(step) * index + offset) %
+                          num_pages);
+}
+
 // Helper counts the number of adjacent cached neighbours of index looking in
 // direction dir, ie index+dir, index+2*dir etc.
 int DocumentCache::CountNeighbourDocs(int index, int dir) {
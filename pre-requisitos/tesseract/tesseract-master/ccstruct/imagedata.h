@@ -133,6 +133,7 @@ class ImageData {
   void set_page_number(int num) {
     page_number_ = num;
   }
+  // The PNG data of the image, empty if it was given to SetPix.
   const GenericVector<char>& image_data() const {
     return image_data_;
   }
@@ -154,9 +155,11 @@ class ImageData {
   const STRING& box_text(int index) const {
     return box_texts_[index];
   }
-  // Saves the given Pix as a PNG-encoded string and destroys it.
+  // Takes ownership of the given Pix, which is only PNG-encoded if *this is
+  // serialized.
   void SetPix(Pix* pix);
-  // Returns the Pix image for *this. Must be pixDestroyed after use.
+  // Returns the Pix image for *this. Must be pixDestroyed after use, and not
+  // changed, as it may be shared with *this.
   Pix* GetPix() const;
   // Gets anything and everything with a non-NULL pointer, prescaled to a
   // given target_height (if 0, then the original image height), and aligned.
@@ -167,6 +170,10 @@ class ImageData {
   Pix* PreScale(int target_height, int max_height, float* scale_factor,
                 int* scaled_width, int* scaled_height,
                 GenericVector<TBOX>* boxes) const;
+  // Decodes and scales the image as PreScale(target_height, max_height) does,
+  // and keeps the result, so that PreScale with the same heights only has to
+  // copy it. Must be called before *this is shared between threads.
+  void CachePreScaled(int target_height, int max_height);
 
   int MemoryUsed() const;
 
@@ -180,7 +187,7 @@ class ImageData {
                 const GenericVector<int>& box_pages);
 
  private:
-  // Saves the given Pix as a PNG-encoded string and destroys it.
+  // Saves the given Pix as a PNG-encoded string.
   static void SetPixInternal(Pix* pix, GenericVector<char>* image_data);
   // Returns the Pix image for the image_data. Must be pixDestroyed after use.
   static Pix* GetPixInternal(const GenericVector<char>& image_data);
@@ -192,11 +199,21 @@ class ImageData {
   STRING imagefilename_;             // File to read image from.
   inT32 page_number_;                // Page number if multi-page tif or -1.
   GenericVector<char> image_data_;   // PNG file data.
+  // Image given to SetPix, if not NULL, instead of image_data_, so that
+  // recognizing a line does not have to encode and decode it.
+  Pix* pix_;
   STRING language_;                  // Language code for image.
   STRING transcription_;             // UTF-8 ground truth of image.
   GenericVector<TBOX> boxes_;        // If non-empty boxes of the image.
   GenericVector<STRING> box_texts_;  // String for text in each box.
   bool vertical_text_;               // Image has been rotated from vertical.
+  // Image scaled by CachePreScaled, if not NULL, with the heights it was
+  // scaled for and the size of the original image. Not serialized.
+  Pix* scaled_pix_;
+  int scaled_target_height_;
+  int scaled_max_height_;
+  int input_width_;
+  int input_height_;
 };
 
 // A collection of ImageData that knows roughly how much memory it is using.
@@ -266,6 +283,13 @@ class DocumentData {
   inT64 UnCache();
   // Shuffles all the pages in the document.
   void Shuffle();
+  // Makes the pages pre-scaled by CachePreScaled with the given heights as
+  // they are loaded, from the next load on.
+  void SetPreScale(int target_height, int max_height) {
+    SVAutoLock lock(&pages_mutex_);
+    prescale_target_height_ = target_height;
+    prescale_max_height_ = max_height;
+  }
 
  private:
   // Sets the value of total_pages_ behind a mutex.
@@ -280,6 +304,10 @@ class DocumentData {
   // Locks the pages_mutex_ and Loads as many pages can fit in max_memory_
   // starting at index pages_offset_.
   bool ReCachePages();
+  // Pre-scales the pages of pages_ from index first, if enabled, and counts
+  // up their memory. Returns the new number of counted pages. Call with the
+  // pages_mutex_ held.
+  int CountNewPages(int first);
 
  private:
   // A name for this document.
@@ -296,6 +324,10 @@ class DocumentData {
   inT64 max_memory_;
   // Saved reader from LoadDocument to allow re-caching.
   FileReader reader_;
+  // Heights for CachePreScaled of each loaded page, if prescale_max_height_
+  // is positive.
+  int prescale_target_height_;
+  int prescale_max_height_;
   // Mutex that protects pages_ and pages_offset_ against multiple parallel
   // loads, and provides a wait for page.
   SVMutex pages_mutex_;
@@ -323,6 +355,19 @@ class DocumentCache {
   // The reader is used to read the files.
   bool LoadDocuments(const GenericVector<STRING>& filenames,
                      CachingStrategy cache_strategy, FileReader reader);
+  // Pre-scales every page with ImageData::CachePreScaled as its document
+  // is loaded, which happens in the background ahead of the reader, so
+  // GetPageBySerial hands out pages that are ready to use. The memory of the
+  // scaled images counts against the limit, so fewer pages fit in memory.
+  // Call before LoadDocuments.
+  void SetPreScale(int target_height, int max_height) {
+    prescale_target_height_ = target_height;
+    prescale_max_height_ = max_height;
+  }
+  // With CS_SEQUENTIAL, visits the pages of each document in a different
+  // order in each epoch, while still reading the documents one after the
+  // other, so that the disk access stays sequential.
+  void set_shuffle(bool shuffle) { shuffle_ = shuffle; }
 
   // Adds document to the cache.
   bool AddToCache(DocumentData* data);
@@ -359,6 +404,9 @@ class DocumentCache {
   // Helper counts the number of adjacent cached neighbour documents_ of index
   // looking in direction dir, ie index+dir, index+2*dir etc.
   int CountNeighbourDocs(int index, int dir);
+  // Returns the index in its document of the page with the given serial for
+  // GetPageSequential, which is shuffled per epoch if shuffle_.
+  int SequentialPageIndex(int serial) const;
 
   // A group of pages that corresponds in some loose way to a document.
   PointerVector<DocumentData> documents_;
@@ -369,6 +417,11 @@ class DocumentCache {
   int num_pages_per_doc_;
   // Max memory allowed in this cache.
   inT64 max_memory_;
+  // Heights for DocumentData::SetPreScale, used if prescale_max_height_ > 0.
+  int prescale_target_height_;
+  int prescale_max_height_;
+  // Shuffle the order of the pages in each epoch.
+  bool shuffle_;
 };
 
 }  // namespace tesseract
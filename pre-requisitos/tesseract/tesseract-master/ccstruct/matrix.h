@@ -51,13 +51,14 @@ class GENERIC_2D_ARRAY {
   // member will be routed to the base class implementation. Subclasses can
   // either pass the memory in, or allocate after by calling Resize().
   GENERIC_2D_ARRAY(int dim1, int dim2, const T& empty, T* array)
-    : empty_(empty), dim1_(dim1), dim2_(dim2), array_(array)  {
+    : empty_(empty), dim1_(dim1), dim2_(dim2), array_(array),
+      array_is_view_(false) {
     size_allocated_ = dim1 * dim2;
   }
   // Original constructor for a full rectangular matrix DOES allocate memory
   // and initialize it to empty.
   GENERIC_2D_ARRAY(int dim1, int dim2, const T& empty)
-    : empty_(empty), dim1_(dim1), dim2_(dim2)  {
+    : empty_(empty), dim1_(dim1), dim2_(dim2), array_is_view_(false) {
     int new_size = dim1 * dim2;
     array_ = new T[new_size];
     size_allocated_ = new_size;
@@ -67,14 +68,14 @@ class GENERIC_2D_ARRAY {
   // Default constructor for array allocation. Use Resize to set the size.
   GENERIC_2D_ARRAY()
     : array_(NULL), empty_(static_cast<T>(0)), dim1_(0), dim2_(0),
-      size_allocated_(0) {
+      size_allocated_(0), array_is_view_(false) {
   }
   GENERIC_2D_ARRAY(const GENERIC_2D_ARRAY<T>& src)
     : array_(NULL), empty_(static_cast<T>(0)), dim1_(0), dim2_(0),
-      size_allocated_(0) {
+      size_allocated_(0), array_is_view_(false) {
     *this = src;
   }
-  virtual ~GENERIC_2D_ARRAY() { delete[] array_; }
+  virtual ~GENERIC_2D_ARRAY() { DeleteArray(); }
 
   void operator=(const GENERIC_2D_ARRAY<T>& src) {
     ResizeNoInit(src.dim1(), src.dim2());
@@ -88,7 +89,7 @@ class GENERIC_2D_ARRAY {
   void ResizeNoInit(int size1, int size2, int pad = 0) {
     int new_size = size1 * size2 + pad;
     if (new_size > size_allocated_) {
-      delete [] array_;
+      DeleteArray();
       array_ = new T[new_size];
       size_allocated_ = new_size;
     }
@@ -121,7 +122,7 @@ class GENERIC_2D_ARRAY {
           }
         }
       }
-      delete[] array_;
+      DeleteArray();
       array_ = new_array;
       dim1_ = size1;
       dim2_ = size2;
@@ -175,6 +176,31 @@ class GENERIC_2D_ARRAY {
     if (fp->FReadEndian(array_, sizeof(*array_), size) != size) return false;
     return true;
   }
+  // As DeSerialize, but if fp can give a view of the elements (see
+  // TFile::ReadView) they are used in place, without a copy. The array must
+  // then not be written to until the next Resize, and the memory of fp must
+  // outlive it. The size of T must be a power of 2.
+  bool DeSerializeInPlace(tesseract::TFile* fp) {
+    inT32 size1, size2;
+    if (fp->FReadEndian(&size1, sizeof(size1), 1) != 1) return false;
+    if (fp->FReadEndian(&size2, sizeof(size2), 1) != 1) return false;
+    if (fp->FReadEndian(&empty_, sizeof(empty_), 1) != 1) return false;
+    const char* view = NULL;
+    if (size1 > 0 && size2 > 0) view = fp->ReadView(sizeof(T), size1 * size2);
+    if (view == NULL) {
+      ResizeNoInit(size1, size2);
+      int size = num_elements();
+      return fp->FReadEndian(array_, sizeof(*array_), size) == size;
+    }
+    DeleteArray();
+    array_ = reinterpret_cast<T*>(const_cast<char*>(view));
+    array_is_view_ = true;
+    // Any Resize must allocate.
+    size_allocated_ = 0;
+    dim1_ = size1;
+    dim2_ = size2;
+    return true;
+  }
 
   // Writes to the given file. Returns false in case of error.
   // Assumes a T::Serialize(FILE*) const function.
@@ -461,6 +487,12 @@ class GENERIC_2D_ARRAY {
   }
 
  protected:
+  // Frees array_, unless it is a view from DeSerializeInPlace, leaving it
+  // owned by *this once replaced.
+  void DeleteArray() {
+    if (!array_is_view_) delete[] array_;
+    array_is_view_ = false;
+  }
   // Factored helper to serialize the size.
   bool SerializeSize(FILE* fp) const {
     inT32 size = dim1_;
@@ -505,6 +537,8 @@ class GENERIC_2D_ARRAY {
   // needed. If Resize is used, memory is retained so it can be re-expanded
   // without a further alloc, and this stores the allocated size.
   int size_allocated_;
+  // True if array_ points into memory owned elsewhere.
+  bool array_is_view_;
 };
 
 // A generic class to store a banded triangular matrix with entries of type T.
@@ -560,7 +594,7 @@ class BandTriMatrix : public GENERIC_2D_ARRAY<T> {
         }
       }
     }
-    delete[] this->array_;
+    this->DeleteArray();
     this->array_ = new_array;
     this->dim1_ = new_dim1;
     this->dim2_ = new_dim2;
@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 
+#include "objectpool.h"
 #include "quspline.h"
 #include "werd.h"
 
@@ -29,7 +30,7 @@ class TO_ROW;
 
 struct PARA;
 
-class ROW:public ELIST_LINK
+class ROW : public ELIST_LINK, public tesseract::PooledObject<ROW>
 {
   friend void tweak_row_baseline(ROW *, double, double);
   public:
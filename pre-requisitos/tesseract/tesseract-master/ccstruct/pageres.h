@@ -25,6 +25,7 @@
 #include "elst.h"
 #include "genericvector.h"
 #include "normalis.h"
+#include "objectpool.h"
 #include "ocrblock.h"
 #include "ocrrow.h"
 #include "params_training_featdef.h"
@@ -71,11 +72,15 @@ class PAGE_RES {                 // page result
   // caused misadaption could be marked. However, since words could be
   // deleted/split/merged, the log is stored on the PAGE_RES level.
   GenericVector<STRING> misadaption_log;
+  // True while the document quality rejection passes of the page are yet to
+  // be run on the reject maps, as left by Tesseract::recog_all_words.
+  bool rejection_deferred;
 
   inline void Init() {
     char_count = 0;
     rej_count = 0;
     rejected = FALSE;
+    rejection_deferred = false;
     prev_word_best_choice = NULL;
     blame_reasons.init_to_size(IRR_NUM_REASONS, 0);
   }
@@ -152,7 +157,8 @@ enum CRUNCH_MODE
 
 // WERD_RES is a collection of publicly accessible members that gathers
 // information about a word result.
-class WERD_RES : public ELIST_LINK {
+class WERD_RES : public ELIST_LINK,
+                 public tesseract::PooledObject<WERD_RES> {
  public:
   // Which word is which?
   // There are 3 coordinate spaces in use here: a possibly rotated pixel space,
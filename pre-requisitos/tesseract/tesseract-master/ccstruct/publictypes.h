@@ -282,6 +282,33 @@ enum OcrEngineMode {
   OEM_COUNT			// Number of OEMs
 };
 
+/**
+ * States of a page submitted to an AsyncRecognizer. All but the first two
+ * are final.
+ */
+enum AsyncJobState {
+  ASYNC_JOB_PENDING,    // Waiting for a worker.
+  ASYNC_JOB_RUNNING,    // Being recognized.
+  ASYNC_JOB_DONE,       // Recognized.
+  ASYNC_JOB_TIMED_OUT,  // Stopped at the deadline, with the partial text.
+  ASYNC_JOB_CANCELLED,  // Cancelled before or during recognition.
+  ASYNC_JOB_FAILED,     // Recognition failed.
+};
+
+/**
+ * The analyses of a recognized page that its output may need besides the
+ * words, their boxes and confidences. A TessResultRenderer declares the ones
+ * it reads (see TessResultRenderer::RequiredAnalysis), and Recognize skips
+ * the post-processing that only the others need.
+ */
+enum PageAnalysis {
+  ANALYSIS_PARAGRAPHS = 1,  // Paragraph boundaries and models.
+  ANALYSIS_FONTS = 2,       // Font names and styles of the words.
+  ANALYSIS_BASELINES = 4,   // Baselines of the lines and words.
+  ANALYSIS_CHOICES = 8,     // Alternative choices of the symbols.
+  ANALYSIS_ALL = 15,
+};
+
 }  // namespace tesseract.
 
 #endif  // TESSERACT_CCSTRUCT_PUBLICTYPES_H_
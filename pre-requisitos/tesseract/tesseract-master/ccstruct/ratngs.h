@@ -296,6 +296,11 @@ class WERD_CHOICE : public ELIST_LINK {
   const UNICHARSET *unicharset() const {
     return unicharset_;
   }
+  // Switches to another unicharset with the same unichar ids, eg the
+  // unicharset of another Tesseract loaded with the same language.
+  void set_unicharset(const UNICHARSET *unicharset) {
+    unicharset_ = unicharset;
+  }
   inline int length() const {
     return length_;
   }
@@ -21,13 +21,14 @@
 #define           STEPBLOB_H
 
 #include          "coutln.h"
+#include          "objectpool.h"
 #include          "rect.h"
 
 class C_BLOB;
 struct Pix;
 ELISTIZEH(C_BLOB)
 
-class C_BLOB:public ELIST_LINK
+class C_BLOB : public ELIST_LINK, public tesseract::PooledObject<C_BLOB>
 {
   public:
     C_BLOB() {
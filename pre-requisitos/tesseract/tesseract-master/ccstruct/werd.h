@@ -23,6 +23,7 @@
 #include          "params.h"
 #include          "bits16.h"
 #include          "elst2.h"
+#include          "objectpool.h"
 #include          "strngs.h"
 #include          "blckerr.h"
 #include          "stepblob.h"
@@ -57,7 +58,7 @@ enum DISPLAY_FLAGS
 
 class ROW;                       //forward decl
 
-class WERD : public ELIST2_LINK {
+class WERD : public ELIST2_LINK, public tesseract::PooledObject<WERD> {
   public:
     WERD() {}
     // WERD constructed with:
@@ -62,6 +62,13 @@ class DoublePtr {
       src.other_end_ = NULL;
     }
   }
+  // The same steal, for the moves of the containers.
+  DoublePtr(DoublePtr&& src) : other_end_(NULL) {
+    *this = src;
+  }
+  void operator=(DoublePtr&& src) {
+    *this = src;
+  }
 
   // Connects this and other, discarding any existing connections.
   void Connect(DoublePtr* other) {
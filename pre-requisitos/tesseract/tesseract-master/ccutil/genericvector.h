@@ -23,6 +23,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <utility>
 
 #include "tesscallback.h"
 #include "errcode.h"
@@ -37,8 +38,10 @@
 template <typename T>
 class GenericVector {
  public:
+  // Allocates nothing until the first element is added, as many vectors
+  // stay empty.
   GenericVector() {
-    init(kDefaultVectorSize);
+    init(0);
   }
   GenericVector(int size, T init_val) {
     init(size);
@@ -50,8 +53,14 @@ class GenericVector {
     this->init(other.size());
     this->operator+=(other);
   }
+  // Move, taking the elements and callbacks of other, which is left empty.
+  GenericVector(GenericVector&& other) {
+    this->init(0);
+    this->take(&other);
+  }
   GenericVector<T> &operator+=(const GenericVector& other);
   GenericVector<T> &operator=(const GenericVector& other);
+  GenericVector<T> &operator=(GenericVector&& other);
 
   ~GenericVector();
 
@@ -230,7 +239,9 @@ class GenericVector {
   // to two Ts and returns negative if the first element is to appear earlier
   // in the result and positive if it is to appear later, with 0 for equal.
   void sort(int (*comparator)(const void*, const void*)) {
-    qsort(data_, size_used_, sizeof(*data_), comparator);
+    // An empty vector may have no array, which qsort must not be given.
+    if (size_used_ > 0)
+      qsort(data_, size_used_, sizeof(*data_), comparator);
   }
 
   // Searches the array (assuming sorted in ascending order, using sort()) for
@@ -341,6 +352,9 @@ class GenericVector {
 
   // Init the object, allocating size memory.
   void init(int size);
+  // Takes the elements and callbacks of other, leaving it empty. this must
+  // own nothing.
+  void take(GenericVector* other);
 
   // We are assuming that the object generally placed in thie
   // vector are small enough that for efficiency it makes sense
@@ -468,6 +482,8 @@ class PointerVector : public GenericVector<T*> {
     this->init(other.size());
     this->operator+=(other);
   }
+  PointerVector(PointerVector&& other)
+    : GenericVector<T*>(std::move(other)) {}
   PointerVector<T>& operator+=(const PointerVector& other) {
     this->reserve(this->size_used_ + other.size_used_);
     for (int i = 0; i < other.size(); ++i) {
@@ -667,8 +683,18 @@ GenericVector<T>::~GenericVector() {
   clear();
 }
 
+template <typename T>
+void GenericVector<T>::take(GenericVector* other) {
+  size_used_ = other->size_used_;
+  size_reserved_ = other->size_reserved_;
+  data_ = other->data_;
+  clear_cb_ = other->clear_cb_;
+  compare_cb_ = other->compare_cb_;
+  other->init(0);
+}
+
 // Reserve some memory. If the internal array contains elements, they are
-// copied.
+// moved.
 template <typename T>
 void GenericVector<T>::reserve(int size) {
   if (size_reserved_ >= size || size <= 0)
@@ -676,7 +702,7 @@ void GenericVector<T>::reserve(int size) {
   if (size < kDefaultVectorSize) size = kDefaultVectorSize;
   T* new_array = new T[size];
   for (int i = 0; i < size_used_; ++i)
-    new_array[i] = data_[i];
+    new_array[i] = std::move(data_[i]);
   delete[] data_;
   data_ = new_array;
   size_reserved_ = size;
@@ -790,7 +816,7 @@ int GenericVector<T>::push_back(T object) {
   if (size_used_ == size_reserved_)
     double_the_size();
   index = size_used_++;
-  data_[index] = object;
+  data_[index] = std::move(object);
   return index;
 }
 
@@ -837,6 +863,15 @@ GenericVector<T> &GenericVector<T>::operator=(const GenericVector& other) {
   return *this;
 }
 
+template <typename T>
+GenericVector<T> &GenericVector<T>::operator=(GenericVector&& other) {
+  if (&other != this) {
+    this->clear();
+    this->take(&other);
+  }
+  return *this;
+}
+
 // Add a callback to be called to delete the elements when the array took
 // their ownership.
 template <typename T>
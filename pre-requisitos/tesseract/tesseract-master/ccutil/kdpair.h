@@ -94,6 +94,9 @@ class KDPtrPair {
   KDPtrPair(KDPtrPair& src) : data_(src.data_), key_(src.key_) {
     src.data_ = NULL;
   }
+  KDPtrPair(KDPtrPair&& src) : data_(src.data_), key_(src.key_) {
+    src.data_ = NULL;
+  }
   // Destructor deletes data, assuming it is the sole owner.
   ~KDPtrPair() {
     delete this->data_;
@@ -107,6 +110,9 @@ class KDPtrPair {
     src.data_ = NULL;
     this->key_ = src.key_;
   }
+  void operator=(KDPtrPair&& src) {
+    operator=(src);
+  }
 
   int operator==(const KDPtrPair<Key, Data>& other) const {
     return key_ == other.key_;
@@ -148,9 +154,13 @@ struct KDPtrPairInc : public KDPtrPair<Key, Data> {
   KDPtrPairInc() : KDPtrPair<Key, Data>() {}
   KDPtrPairInc(Key k, Data* d) : KDPtrPair<Key, Data>(k, d) {}
   KDPtrPairInc(KDPtrPairInc& src) : KDPtrPair<Key, Data>(src) {}
+  KDPtrPairInc(KDPtrPairInc&& src) : KDPtrPair<Key, Data>(src) {}
   void operator=(KDPtrPairInc& src) {
     KDPtrPair<Key, Data>::operator=(src);
   }
+  void operator=(KDPtrPairInc&& src) {
+    KDPtrPair<Key, Data>::operator=(src);
+  }
   // Operator< facilitates sorting in increasing order.
   int operator<(const KDPtrPairInc<Key, Data>& other) const {
     return this->key() < other.key();
@@ -165,9 +175,13 @@ struct KDPtrPairDec : public KDPtrPair<Key, Data> {
   KDPtrPairDec() : KDPtrPair<Key, Data>() {}
   KDPtrPairDec(Key k, Data* d) : KDPtrPair<Key, Data>(k, d) {}
   KDPtrPairDec(KDPtrPairDec& src) : KDPtrPair<Key, Data>(src) {}
+  KDPtrPairDec(KDPtrPairDec&& src) : KDPtrPair<Key, Data>(src) {}
   void operator=(KDPtrPairDec& src) {
     KDPtrPair<Key, Data>::operator=(src);
   }
+  void operator=(KDPtrPairDec&& src) {
+    KDPtrPair<Key, Data>::operator=(src);
+  }
   // Operator< facilitates sorting in decreasing order by using operator> on
   // the key values.
   int operator<(const KDPtrPairDec<Key, Data>& other) const {
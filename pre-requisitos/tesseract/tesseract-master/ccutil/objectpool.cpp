@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////
+// File:        objectpool.cpp
+// Description: Slab allocator for the small objects of the page layout.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "objectpool.h"
+
+#include <stdlib.h>
+#include <new>
+#include "ccutil.h"
+
+namespace tesseract {
+
+// Bytes in each slab.
+const size_t kSlabSize = 64 * 1024;
+// Blocks are multiples of this, which is what malloc aligns to.
+const size_t kBlockAlign = 16;
+// Blocks moved between a thread cache and its pool at a time.
+const int kBatchSize = 32;
+// Pools that get a cache in each thread. There is one pool per pooled class.
+const int kMaxCachedPools = 16;
+
+// Blocks of one pool kept by one thread, so that most allocations need no
+// lock. Plain data, so that it is still usable while the thread exits.
+struct PoolCache {
+  ObjectPool* pool;
+  void* free_list;
+  int count;
+};
+
+enum CacheState { CACHE_UNUSED, CACHE_LIVE, CACHE_DEAD };
+
+static thread_local PoolCache thread_caches[kMaxCachedPools];
+static thread_local CacheState thread_cache_state = CACHE_UNUSED;
+
+// Returns the blocks cached by the thread to their pools when it exits.
+// Blocks freed on the thread after that go straight to the pools.
+class PoolCacheFlusher {
+ public:
+  PoolCacheFlusher() {}
+  ~PoolCacheFlusher() {
+    thread_cache_state = CACHE_DEAD;
+    for (int i = 0; i < kMaxCachedPools; ++i) {
+      PoolCache* cache = &thread_caches[i];
+      if (cache->count == 0) continue;
+      void* tail = cache->free_list;
+      while (*static_cast<void**>(tail) != NULL)
+        tail = *static_cast<void**>(tail);
+      cache->pool->GiveBatch(cache->free_list, tail, cache->count);
+      cache->free_list = NULL;
+      cache->count = 0;
+    }
+  }
+  void Touch() {}
+};
+
+static thread_local PoolCacheFlusher thread_cache_flusher;
+
+// Returns the cache of the pool with the given index for the calling thread,
+// or NULL if the pool must be used without one.
+static PoolCache* ThreadCache(int index) {
+  if (index < 0 || thread_cache_state == CACHE_DEAD) return NULL;
+  if (thread_cache_state == CACHE_UNUSED) {
+    // Using the flusher makes the thread run its destructor at exit.
+    thread_cache_flusher.Touch();
+    thread_cache_state = CACHE_LIVE;
+  }
+  return &thread_caches[index];
+}
+
+// Pools may be made while other statics are constructed.
+static CCUtilMutex* PoolIndexMutex() {
+  static CCUtilMutex mutex;
+  return &mutex;
+}
+static int num_cached_pools = 0;
+
+ObjectPool::ObjectPool(size_t object_size)
+  : mutex_(new CCUtilMutex), free_list_(NULL), slab_next_(NULL),
+    slab_end_(NULL) {
+  if (object_size < sizeof(void*)) object_size = sizeof(void*);
+  block_size_ = (object_size + kBlockAlign - 1) / kBlockAlign * kBlockAlign;
+  PoolIndexMutex()->Lock();
+  cache_index_ = num_cached_pools < kMaxCachedPools ? num_cached_pools++ : -1;
+  PoolIndexMutex()->Unlock();
+}
+
+void* ObjectPool::Allocate() {
+  PoolCache* cache = ThreadCache(cache_index_);
+  if (cache == NULL) {
+    void* block = NULL;
+    TakeBatch(1, &block);
+    return block;
+  }
+  if (cache->count == 0) {
+    cache->pool = this;
+    cache->count = TakeBatch(kBatchSize, &cache->free_list);
+  }
+  void* block = cache->free_list;
+  cache->free_list = *static_cast<void**>(block);
+  --cache->count;
+  return block;
+}
+
+void ObjectPool::Free(void* ptr) {
+  PoolCache* cache = ThreadCache(cache_index_);
+  if (cache == NULL) {
+    *static_cast<void**>(ptr) = NULL;
+    GiveBatch(ptr, ptr, 1);
+    return;
+  }
+  cache->pool = this;
+  *static_cast<void**>(ptr) = cache->free_list;
+  cache->free_list = ptr;
+  if (++cache->count < 2 * kBatchSize) return;
+  // Give back the earliest freed half, keeping the blocks that are most
+  // likely to still be in the cache of the processor.
+  void* tail = cache->free_list;
+  for (int i = 1; i < kBatchSize; ++i)
+    tail = *static_cast<void**>(tail);
+  void* head = *static_cast<void**>(tail);
+  *static_cast<void**>(tail) = NULL;
+  void* last = head;
+  while (*static_cast<void**>(last) != NULL)
+    last = *static_cast<void**>(last);
+  GiveBatch(head, last, cache->count - kBatchSize);
+  cache->count = kBatchSize;
+}
+
+int ObjectPool::TakeBatch(int count, void** head) {
+  int taken = 0;
+  mutex_->Lock();
+  while (taken < count && free_list_ != NULL) {
+    void* block = free_list_;
+    free_list_ = *static_cast<void**>(block);
+    *static_cast<void**>(block) = *head;
+    *head = block;
+    ++taken;
+  }
+  // Carve the rest from the slab back to front, so that the chain hands
+  // them out in address order.
+  int needed = count - taken;
+  if (needed > 0) {
+    size_t slab_blocks = (slab_end_ - slab_next_) / block_size_;
+    if (slab_blocks == 0) {
+      slab_blocks = kSlabSize / block_size_;
+      if (slab_blocks == 0) slab_blocks = 1;
+      slab_next_ = static_cast<char*>(malloc(slab_blocks * block_size_));
+      if (slab_next_ == NULL) {
+        slab_end_ = NULL;
+        mutex_->Unlock();
+        if (taken > 0) return taken;
+        throw std::bad_alloc();
+      }
+      slab_end_ = slab_next_ + slab_blocks * block_size_;
+      slabs_.push_back(slab_next_);
+    }
+    if (static_cast<size_t>(needed) > slab_blocks) needed = slab_blocks;
+    char* first = slab_next_;
+    slab_next_ += needed * block_size_;
+    for (char* block = slab_next_; block > first; ++taken) {
+      block -= block_size_;
+      *reinterpret_cast<void**>(block) = *head;
+      *head = block;
+    }
+  }
+  mutex_->Unlock();
+  return taken;
+}
+
+void ObjectPool::GiveBatch(void* head, void* tail, int count) {
+  if (count == 0) return;
+  mutex_->Lock();
+  *static_cast<void**>(tail) = free_list_;
+  free_list_ = head;
+  mutex_->Unlock();
+}
+
+}  // namespace tesseract.
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////
+// File:        objectpool.h
+// Description: Slab allocator for the small objects of the page layout.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_OBJECTPOOL_H_
+#define TESSERACT_CCUTIL_OBJECTPOOL_H_
+
+#include <stddef.h>
+#include "genericvector.h"
+
+namespace tesseract {
+
+class CCUtilMutex;
+
+// Hands out blocks of a single size, carved consecutively out of large slabs
+// so that objects made one after the other sit next to each other in memory.
+// Freed blocks are kept for reuse, first by the thread that freed them and
+// then, in batches, by any thread. Slabs are never given back, and a pool
+// must never be deleted, as threads may still hold some of its blocks.
+class ObjectPool {
+ public:
+  explicit ObjectPool(size_t object_size);
+
+  // Returns an uninitialized block of at least object_size bytes, aligned
+  // like the result of malloc.
+  void* Allocate();
+  // Takes back a block returned by Allocate.
+  void Free(void* ptr);
+
+  // Moves up to count free blocks onto the chain at *head and returns how
+  // many it moved. Used by the per-thread caches.
+  int TakeBatch(int count, void** head);
+  // Takes back a chain of count blocks that runs from head to tail.
+  void GiveBatch(void* head, void* tail, int count);
+
+ private:
+  // Size of each block, rounded up to keep blocks aligned.
+  size_t block_size_;
+  // Index of the caches of this pool in each thread, or -1 if there are too
+  // many pools to cache them all.
+  int cache_index_;
+  CCUtilMutex* mutex_;
+  // Chain of free blocks, linked through their first word.
+  void* free_list_;
+  // Unused end of the last slab.
+  char* slab_next_;
+  char* slab_end_;
+  GenericVector<char*> slabs_;
+
+  // Not defined, as pools are never deleted.
+  ~ObjectPool();
+};
+
+// Base class that makes new and delete of T use an ObjectPool of its own.
+// Add it as the last base of T, after its list link; being empty, it does
+// not change the layout of T. Subclasses of T, which are bigger, still go to
+// the global heap.
+template <typename T>
+class PooledObject {
+ public:
+  static void* operator new(size_t size) {
+    if (size != sizeof(T)) return ::operator new(size);
+    return Pool()->Allocate();
+  }
+  static void operator delete(void* ptr, size_t size) {
+    if (ptr == NULL) return;
+    if (size != sizeof(T)) {
+      ::operator delete(ptr);
+      return;
+    }
+    Pool()->Free(ptr);
+  }
+
+ private:
+  // Made on first use, so that objects owned by other statics can be made
+  // and deleted at any time.
+  static ObjectPool* Pool() {
+    static ObjectPool* pool = new ObjectPool(sizeof(T));
+    return pool;
+  }
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCUTIL_OBJECTPOOL_H_
@@ -162,6 +162,16 @@ class ETEXT_DESC {             // output header
     return (now.tv_sec > end_time.tv_sec || (now.tv_sec == end_time.tv_sec &&
                                              now.tv_usec > end_time.tv_usec));
   }
+
+  // Returns the seconds left before the end_time, negative once it has
+  // passed, or a very large value if no deadline was set.
+  double seconds_to_deadline() const {
+    if (end_time.tv_sec == 0 && end_time.tv_usec == 0) return 1e30;
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (end_time.tv_sec - now.tv_sec) +
+        (end_time.tv_usec - now.tv_usec) * 1e-6;
+  }
 };
 
 #endif  // CCUTIL_OCRCLASS_H_
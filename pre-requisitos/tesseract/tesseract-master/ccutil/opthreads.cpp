@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////
+// File:        opthreads.cpp
+// Description: Per-thread limit on the threads of each parallel loop.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "opthreads.h"
+
+namespace tesseract {
+
+// The limit belongs to the thread, so that page workers sharing a process
+// can each run with their own.
+static thread_local int intra_op_threads = 0;
+
+void SetIntraOpThreads(int num_threads) {
+  intra_op_threads = num_threads > 0 ? num_threads : 0;
+}
+
+int IntraOpThreads(int default_threads) {
+#ifdef _OPENMP
+  return intra_op_threads > 0 ? intra_op_threads : default_threads;
+#else
+  return 1;
+#endif
+}
+
+}  // namespace tesseract.
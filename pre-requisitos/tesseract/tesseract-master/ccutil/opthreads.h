@@ -0,0 +1,35 @@
+///////////////////////////////////////////////////////////////////////
+// File:        opthreads.h
+// Description: Per-thread limit on the threads of each parallel loop.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_OPTHREADS_H_
+#define TESSERACT_CCUTIL_OPTHREADS_H_
+
+namespace tesseract {
+
+// Sets the number of threads that each OpenMP parallel loop run on the
+// calling thread may use, or 0 to let each loop use its built-in default.
+// 1 keeps everything the calling thread runs on that thread.
+void SetIntraOpThreads(int num_threads);
+
+// Returns the number of threads that a parallel loop whose built-in default
+// is default_threads should use on the calling thread. Always 1 without
+// OpenMP.
+int IntraOpThreads(int default_threads);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCUTIL_OPTHREADS_H_
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pageprofile.cpp
+// Description: Time spent in each stage of the recognition of a page.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "pageprofile.h"
+
+#include <stdio.h>
+#include <chrono>
+#include "strngs.h"
+
+namespace tesseract {
+
+static const char* const kStageNames[PROFILE_STAGE_COUNT] = {
+  "threshold", "layout", "pass1", "pass2", "lstm", "beam_search",
+  "adaptation", "render"
+};
+static const char* const kCounterNames[PROFILE_COUNTER_COUNT] = {
+  "blobs", "words", "lines", "retries", "degraded", "blank"
+};
+
+// Returns the time in nanoseconds of a monotonic clock.
+static int64_t NowNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+PageProfile::PageProfile() {
+  Clear();
+}
+
+void PageProfile::Clear() {
+  for (int s = 0; s < PROFILE_STAGE_COUNT; ++s) nanoseconds_[s] = 0;
+  for (int c = 0; c < PROFILE_COUNTER_COUNT; ++c) counts_[c] = 0;
+}
+
+void PageProfile::AddTime(ProfileStage stage, double seconds) {
+  nanoseconds_[stage] += static_cast<int64_t>(seconds * 1e9);
+}
+
+void PageProfile::AddCount(ProfileCounter counter, int count) {
+  counts_[counter] += count;
+}
+
+double PageProfile::time(ProfileStage stage) const {
+  return nanoseconds_[stage] * 1e-9;
+}
+
+int PageProfile::count(ProfileCounter counter) const {
+  return counts_[counter];
+}
+
+const char* PageProfile::StageName(ProfileStage stage) {
+  return kStageNames[stage];
+}
+
+const char* PageProfile::CounterName(ProfileCounter counter) {
+  return kCounterNames[counter];
+}
+
+void PageProfile::AppendJSON(STRING* json) const {
+  char buffer[64];
+  *json += "{\"time\":{";
+  for (int s = 0; s < PROFILE_STAGE_COUNT; ++s) {
+    snprintf(buffer, sizeof(buffer), "%s\"%s\":%.6f", s > 0 ? "," : "",
+             kStageNames[s], time(static_cast<ProfileStage>(s)));
+    *json += buffer;
+  }
+  *json += "},\"count\":{";
+  for (int c = 0; c < PROFILE_COUNTER_COUNT; ++c) {
+    snprintf(buffer, sizeof(buffer), "%s\"%s\":%d", c > 0 ? "," : "",
+             kCounterNames[c], count(static_cast<ProfileCounter>(c)));
+    *json += buffer;
+  }
+  *json += "}}";
+}
+
+ProfileTimer::ProfileTimer(PageProfile* profile, ProfileStage stage)
+  : profile_(profile), stage_(stage),
+    start_(profile != NULL ? NowNanoseconds() : 0) {
+}
+
+ProfileTimer::~ProfileTimer() {
+  if (profile_ != NULL)
+    profile_->AddTime(stage_, (NowNanoseconds() - start_) * 1e-9);
+}
+
+}  // namespace tesseract.
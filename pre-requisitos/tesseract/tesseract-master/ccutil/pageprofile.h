@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////
+// File:        pageprofile.h
+// Description: Time spent in each stage of the recognition of a page.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_PAGEPROFILE_H_
+#define TESSERACT_CCUTIL_PAGEPROFILE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include "platform.h"
+
+class STRING;
+
+namespace tesseract {
+
+// Stages timed by PageProfile. Some run inside others: LSTM and adaptation
+// are part of pass 1 or 2, and beam search is part of LSTM.
+enum ProfileStage {
+  PROFILE_THRESHOLD,    // Binarization of the image.
+  PROFILE_LAYOUT,       // Page layout analysis, including OSD.
+  PROFILE_PASS1,        // First recognition pass over all words.
+  PROFILE_PASS2,        // Second pass, with the adapted classifier.
+  PROFILE_LSTM,         // LSTM recognition of lines and words.
+  PROFILE_BEAM_SEARCH,  // Decoding of the LSTM outputs.
+  PROFILE_ADAPTATION,   // Training of the adaptive classifier.
+  PROFILE_RENDER,       // Output renderers.
+  PROFILE_STAGE_COUNT
+};
+
+// Counters kept by PageProfile.
+enum ProfileCounter {
+  PROFILE_BLOBS,    // Blobs of the recognized words.
+  PROFILE_WORDS,    // Recognized words.
+  PROFILE_LINES,    // Text lines.
+  PROFILE_RETRIES,  // Words recognized again in another language.
+  PROFILE_DEGRADED,  // Words recognized in the deadline mode.
+  PROFILE_BLANK,    // 1 if the page was found blank and not recognized.
+  PROFILE_COUNTER_COUNT
+};
+
+// Wall time of each stage and counts of the objects of a page. Stages that
+// run on several threads at once add the time of every thread, so the
+// updates are atomic.
+class TESS_API PageProfile {
+ public:
+  PageProfile();
+
+  // Zeroes all times and counts.
+  void Clear();
+
+  void AddTime(ProfileStage stage, double seconds);
+  void AddCount(ProfileCounter counter, int count);
+
+  // Returns the time in seconds of the stage.
+  double time(ProfileStage stage) const;
+  int count(ProfileCounter counter) const;
+
+  // Returns the name of the stage or counter used in the JSON.
+  static const char* StageName(ProfileStage stage);
+  static const char* CounterName(ProfileCounter counter);
+
+  // Appends the profile to json as a single line JSON object, with times in
+  // seconds, like {"time":{"threshold":0.012,...},"count":{"blobs":...}}.
+  void AppendJSON(STRING* json) const;
+
+ private:
+  std::atomic<int64_t> nanoseconds_[PROFILE_STAGE_COUNT];
+  std::atomic<int> counts_[PROFILE_COUNTER_COUNT];
+};
+
+// Adds the wall time from its construction to its destruction to a stage of
+// the profile, which may be NULL to time nothing.
+class TESS_API ProfileTimer {
+ public:
+  ProfileTimer(PageProfile* profile, ProfileStage stage);
+  ~ProfileTimer();
+
+ private:
+  PageProfile* profile_;
+  ProfileStage stage_;
+  // Start time in nanoseconds of a monotonic clock.
+  int64_t start_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCUTIL_PAGEPROFILE_H_
@@ -31,12 +31,60 @@
 #define EQUAL         '='
 
 tesseract::ParamsVectors *GlobalParams() {
-  static tesseract::ParamsVectors global_params = tesseract::ParamsVectors();
+  static tesseract::ParamsVectors global_params;
   return &global_params;
 }
 
 namespace tesseract {
 
+// FNV-1a hash of the name.
+size_t ParamsVectors::NameHash::operator()(const char *name) const {
+  size_t hash = 2166136261u;
+  for (; *name != '\0'; ++name) {
+    hash ^= static_cast<unsigned char>(*name);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+NamedParams ParamsVectors::Find(const char *name) const {
+  std::lock_guard<std::mutex> lock(index_mutex_);
+  if (!index_valid_) BuildIndex();
+  NameIndex::const_iterator it = index_.find(name);
+  return it != index_.end() ? it->second : NamedParams();
+}
+
+void ParamsVectors::InvalidateIndex() {
+  std::lock_guard<std::mutex> lock(index_mutex_);
+  index_valid_ = false;
+  index_.clear();
+}
+
+// Should a name be repeated within a type, the first param wins, as it did
+// for the linear search of FindParam.
+void ParamsVectors::BuildIndex() const {
+  index_.clear();
+  index_.reserve(int_params.size() + bool_params.size() +
+                 string_params.size() + double_params.size());
+  for (int i = 0; i < int_params.size(); ++i) {
+    NamedParams &entry = index_[int_params[i]->name_str()];
+    if (entry.int_param == NULL) entry.int_param = int_params[i];
+  }
+  for (int i = 0; i < bool_params.size(); ++i) {
+    NamedParams &entry = index_[bool_params[i]->name_str()];
+    if (entry.bool_param == NULL) entry.bool_param = bool_params[i];
+  }
+  for (int i = 0; i < string_params.size(); ++i) {
+    NamedParams &entry = index_[string_params[i]->name_str()];
+    if (entry.string_param == NULL) entry.string_param = string_params[i];
+  }
+  for (int i = 0; i < double_params.size(); ++i) {
+    NamedParams &entry = index_[double_params[i]->name_str()];
+    if (entry.double_param == NULL) entry.double_param = double_params[i];
+  }
+  index_valid_ = true;
+}
+
 bool ParamUtils::ReadParamsFile(const char *file,
                                 SetParamConstraint constraint,
                                 ParamsVectors *member_params) {
@@ -88,25 +136,37 @@ bool ParamUtils::ReadParamsFromFp(SetParamConstraint constraint, TFile *fp,
   return anyerr;
 }
 
+NamedParams ParamUtils::FindParams(const char *name,
+                                  const ParamsVectors *member_params) {
+  NamedParams params = GlobalParams()->Find(name);
+  if (member_params == NULL) return params;
+  NamedParams members = member_params->Find(name);
+  if (params.int_param == NULL) params.int_param = members.int_param;
+  if (params.bool_param == NULL) params.bool_param = members.bool_param;
+  if (params.string_param == NULL)
+    params.string_param = members.string_param;
+  if (params.double_param == NULL)
+    params.double_param = members.double_param;
+  return params;
+}
+
 bool ParamUtils::SetParam(const char *name, const char* value,
                           SetParamConstraint constraint,
                           ParamsVectors *member_params) {
+  NamedParams params = FindParams(name, member_params);
   // Look for the parameter among string parameters.
-  StringParam *sp = FindParam<StringParam>(name, GlobalParams()->string_params,
-                                           member_params->string_params);
+  StringParam *sp = params.string_param;
   if (sp != NULL && sp->constraint_ok(constraint)) sp->set_value(value);
   if (*value == '\0') return (sp != NULL);
 
   // Look for the parameter among int parameters.
   int intval;
-  IntParam *ip = FindParam<IntParam>(name, GlobalParams()->int_params,
-                                     member_params->int_params);
+  IntParam *ip = params.int_param;
   if (ip && ip->constraint_ok(constraint) && sscanf(value, "%d", &intval) == 1)
     ip->set_value(intval);
 
   // Look for the parameter among bool parameters.
-  BoolParam *bp = FindParam<BoolParam>(name, GlobalParams()->bool_params,
-                                       member_params->bool_params);
+  BoolParam *bp = params.bool_param;
   if (bp != NULL && bp->constraint_ok(constraint)) {
     if (*value == 'T' || *value == 't' ||
         *value == 'Y' || *value == 'y' || *value == '1') {
@@ -119,8 +179,7 @@ bool ParamUtils::SetParam(const char *name, const char* value,
 
   // Look for the parameter among double parameters.
   double doubleval;
-  DoubleParam *dp = FindParam<DoubleParam>(name, GlobalParams()->double_params,
-                                           member_params->double_params);
+  DoubleParam *dp = params.double_param;
   if (dp != NULL && dp->constraint_ok(constraint)) {
 #ifdef EMBEDDED
       doubleval = strtofloat(value);
@@ -129,22 +188,36 @@ bool ParamUtils::SetParam(const char *name, const char* value,
 #endif
       dp->set_value(doubleval);
   }
-  return (sp || ip || bp || dp);
+  return !params.empty();
+}
+
+bool ParamUtils::SetParams(const GenericVector<STRING> &names,
+                           const GenericVector<STRING> &values,
+                           SetParamConstraint constraint,
+                           ParamsVectors *member_params) {
+  ASSERT_HOST(names.size() == values.size());
+  bool all_found = true;
+  for (int i = 0; i < names.size(); ++i) {
+    if (!SetParam(names[i].string(), values[i].string(), constraint,
+                  member_params)) {
+      all_found = false;
+    }
+  }
+  return all_found;
 }
 
 bool ParamUtils::GetParamAsString(const char *name,
                                   const ParamsVectors* member_params,
                                   STRING *value) {
+  NamedParams params = FindParams(name, member_params);
   // Look for the parameter among string parameters.
-  StringParam *sp = FindParam<StringParam>(name, GlobalParams()->string_params,
-                                           member_params->string_params);
+  StringParam *sp = params.string_param;
   if (sp) {
     *value = sp->string();
     return true;
   }
   // Look for the parameter among int parameters.
-  IntParam *ip = FindParam<IntParam>(name, GlobalParams()->int_params,
-                                     member_params->int_params);
+  IntParam *ip = params.int_param;
   if (ip) {
     char buf[128];
     snprintf(buf, sizeof(buf), "%d", inT32(*ip));
@@ -152,15 +225,13 @@ bool ParamUtils::GetParamAsString(const char *name,
     return true;
   }
   // Look for the parameter among bool parameters.
-  BoolParam *bp = FindParam<BoolParam>(name, GlobalParams()->bool_params,
-                                       member_params->bool_params);
+  BoolParam *bp = params.bool_param;
   if (bp != NULL) {
     *value = BOOL8(*bp) ? "1": "0";
     return true;
   }
   // Look for the parameter among double parameters.
-  DoubleParam *dp = FindParam<DoubleParam>(name, GlobalParams()->double_params,
-                                           member_params->double_params);
+  DoubleParam *dp = params.double_param;
   if (dp != NULL) {
     char buf[128];
     snprintf(buf, sizeof(buf), "%g", double(*dp));
@@ -215,4 +286,51 @@ void ParamUtils::ResetToDefaults(ParamsVectors* member_params) {
   }
 }
 
+// Returns true if name is one of the NULL-terminated names, which may be
+// NULL.
+static bool IsNamed(const char* name, const char* const* names) {
+  for (; names != NULL && *names != NULL; ++names) {
+    if (strcmp(name, *names) == 0) return true;
+  }
+  return false;
+}
+
+void ParamUtils::AppendNonDefaultParams(const ParamsVectors* params,
+                                        const char* const* skip_names,
+                                        STRING* out) {
+  for (int i = 0; i < params->int_params.size(); ++i) {
+    const IntParam* param = params->int_params[i];
+    if (param->is_default() || IsNamed(param->name_str(), skip_names))
+      continue;
+    *out += " ";
+    *out += param->name_str();
+    out->add_str_int("=", *param);
+  }
+  for (int i = 0; i < params->bool_params.size(); ++i) {
+    const BoolParam* param = params->bool_params[i];
+    if (param->is_default() || IsNamed(param->name_str(), skip_names))
+      continue;
+    *out += " ";
+    *out += param->name_str();
+    out->add_str_int("=", static_cast<BOOL8>(*param));
+  }
+  for (int i = 0; i < params->string_params.size(); ++i) {
+    const StringParam* param = params->string_params[i];
+    if (param->is_default() || IsNamed(param->name_str(), skip_names))
+      continue;
+    *out += " ";
+    *out += param->name_str();
+    *out += "=";
+    *out += param->string();
+  }
+  for (int i = 0; i < params->double_params.size(); ++i) {
+    const DoubleParam* param = params->double_params[i];
+    if (param->is_default() || IsNamed(param->name_str(), skip_names))
+      continue;
+    *out += " ";
+    *out += param->name_str();
+    out->add_str_double("=", *param);
+  }
+}
+
 }  // namespace tesseract
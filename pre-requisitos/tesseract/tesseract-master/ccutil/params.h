@@ -21,6 +21,9 @@
 #define           PARAMS_H
 
 #include          <stdio.h>
+#include          <string.h>
+#include          <mutex>
+#include          <unordered_map>
 
 #include          "genericvector.h"
 #include          "strngs.h"
@@ -40,11 +43,58 @@ enum SetParamConstraint {
   SET_PARAM_CONSTRAINT_NON_INIT_ONLY,
 };
 
+// The params of each type that have a given name, NULL for the types
+// that have none.
+struct NamedParams {
+  NamedParams()
+    : int_param(NULL), bool_param(NULL), string_param(NULL),
+      double_param(NULL) {}
+  bool empty() const {
+    return int_param == NULL && bool_param == NULL && string_param == NULL &&
+           double_param == NULL;
+  }
+
+  IntParam *int_param;
+  BoolParam *bool_param;
+  StringParam *string_param;
+  DoubleParam *double_param;
+};
+
 struct ParamsVectors {
+  ParamsVectors() : index_valid_(false) {}
+
+  // Returns the params named name, looked up in a hash index of the
+  // vectors. The index is built on the first lookup after a param joined
+  // or left the vectors, so lookups don't scan the hundreds of params of a
+  // Tesseract. Lookups may run on several threads at once.
+  NamedParams Find(const char *name) const;
+  // Called by the params as they join or leave the vectors.
+  void InvalidateIndex();
+
   GenericVector<IntParam *> int_params;
   GenericVector<BoolParam *> bool_params;
   GenericVector<StringParam *> string_params;
   GenericVector<DoubleParam *> double_params;
+
+ private:
+  // The index is keyed by the names of the params themselves, which live
+  // as long as the params.
+  struct NameHash {
+    size_t operator()(const char *name) const;
+  };
+  struct NameEqual {
+    bool operator()(const char *name1, const char *name2) const {
+      return strcmp(name1, name2) == 0;
+    }
+  };
+  typedef std::unordered_map<const char *, NamedParams, NameHash, NameEqual>
+      NameIndex;
+
+  void BuildIndex() const;
+
+  mutable std::mutex index_mutex_;  // Guards index_ and index_valid_.
+  mutable NameIndex index_;
+  mutable bool index_valid_;
 };
 
 // Utility functions for working with Tesseract parameters.
@@ -69,6 +119,19 @@ class ParamUtils {
                        SetParamConstraint constraint,
                        ParamsVectors *member_params);
 
+  // Sets each of names to the value at the same index of values, as a
+  // config file would. Returns false if any name was not found, after
+  // setting all the others.
+  static bool SetParams(const GenericVector<STRING> &names,
+                        const GenericVector<STRING> &values,
+                        SetParamConstraint constraint,
+                        ParamsVectors *member_params);
+
+  // Returns the params with the given name, of each type, from
+  // GlobalParams() or else from member_params, which may be NULL.
+  static NamedParams FindParams(const char *name,
+                                const ParamsVectors *member_params);
+
   // Returns the pointer to the parameter with the given name (of the
   // appropriate type) if it was found in the vector obtained from
   // GlobalParams() or in the given member_params.
@@ -106,6 +169,13 @@ class ParamUtils {
 
   // Resets all parameters back to default values;
   static void ResetToDefaults(ParamsVectors* member_params);
+
+  // Appends " name=value" to out for each of params whose value is not its
+  // default, but for those named in skip_names, a NULL-terminated array that
+  // may be NULL.
+  static void AppendNonDefaultParams(const ParamsVectors* params,
+                                     const char* const* skip_names,
+                                     STRING* out);
 };
 
 // Definition of various parameter types.
@@ -145,22 +215,27 @@ class IntParam : public Param {
             ParamsVectors *vec) : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->int_params);
+    params_vec_ = vec;
     vec->int_params.push_back(this);
+    vec->InvalidateIndex();
+  }
+  ~IntParam() {
+    ParamUtils::RemoveParam<IntParam>(this, &params_vec_->int_params);
+    params_vec_->InvalidateIndex();
   }
-  ~IntParam() { ParamUtils::RemoveParam<IntParam>(this, params_vec_); }
   operator inT32() const { return value_; }
   void operator=(inT32 value) { value_ = value; }
   void set_value(inT32 value) { value_ = value; }
   void ResetToDefault() {
     value_ = default_;
   }
+  bool is_default() const { return value_ == default_; }
 
  private:
   inT32 value_;
   inT32 default_;
-  // Pointer to the vector that contains this param (not owened by this class).
-  GenericVector<IntParam *> *params_vec_;
+  // Pointer to the vectors that contain this param (not owened by this class).
+  ParamsVectors *params_vec_;
 };
 
 class BoolParam : public Param {
@@ -169,22 +244,27 @@ class BoolParam : public Param {
             ParamsVectors *vec) : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->bool_params);
+    params_vec_ = vec;
     vec->bool_params.push_back(this);
+    vec->InvalidateIndex();
+  }
+  ~BoolParam() {
+    ParamUtils::RemoveParam<BoolParam>(this, &params_vec_->bool_params);
+    params_vec_->InvalidateIndex();
   }
-  ~BoolParam() { ParamUtils::RemoveParam<BoolParam>(this, params_vec_); }
   operator BOOL8() const { return value_; }
   void operator=(BOOL8 value) { value_ = value; }
   void set_value(BOOL8 value) { value_ = value; }
   void ResetToDefault() {
     value_ = default_;
   }
+  bool is_default() const { return value_ == default_; }
 
  private:
   BOOL8 value_;
   BOOL8 default_;
-  // Pointer to the vector that contains this param (not owned by this class).
-  GenericVector<BoolParam *> *params_vec_;
+  // Pointer to the vectors that contain this param (not owned by this class).
+  ParamsVectors *params_vec_;
 };
 
 class StringParam : public Param {
@@ -194,10 +274,14 @@ class StringParam : public Param {
               ParamsVectors *vec) : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->string_params);
+    params_vec_ = vec;
     vec->string_params.push_back(this);
+    vec->InvalidateIndex();
+  }
+  ~StringParam() {
+    ParamUtils::RemoveParam<StringParam>(this, &params_vec_->string_params);
+    params_vec_->InvalidateIndex();
   }
-  ~StringParam() { ParamUtils::RemoveParam<StringParam>(this, params_vec_); }
   operator STRING &() { return value_; }
   const char *string() const { return value_.string(); }
   const char *c_str() const { return value_.string(); }
@@ -208,12 +292,13 @@ class StringParam : public Param {
   void ResetToDefault() {
     value_ = default_;
   }
+  bool is_default() const { return value_ == default_; }
 
  private:
   STRING value_;
   STRING default_;
-  // Pointer to the vector that contains this param (not owened by this class).
-  GenericVector<StringParam *> *params_vec_;
+  // Pointer to the vectors that contain this param (not owened by this class).
+  ParamsVectors *params_vec_;
 };
 
 class DoubleParam : public Param {
@@ -222,22 +307,27 @@ class DoubleParam : public Param {
               bool init, ParamsVectors *vec) : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->double_params);
+    params_vec_ = vec;
     vec->double_params.push_back(this);
+    vec->InvalidateIndex();
+  }
+  ~DoubleParam() {
+    ParamUtils::RemoveParam<DoubleParam>(this, &params_vec_->double_params);
+    params_vec_->InvalidateIndex();
   }
-  ~DoubleParam() { ParamUtils::RemoveParam<DoubleParam>(this, params_vec_); }
   operator double() const { return value_; }
   void operator=(double value) { value_ = value; }
   void set_value(double value) { value_ = value; }
   void ResetToDefault() {
     value_ = default_;
   }
+  bool is_default() const { return value_ == default_; }
 
  private:
   double value_;
   double default_;
-  // Pointer to the vector that contains this param (not owned by this class).
-  GenericVector<DoubleParam *> *params_vec_;
+  // Pointer to the vectors that contain this param (not owned by this class).
+  ParamsVectors *params_vec_;
 };
 
 }  // namespace tesseract
@@ -18,6 +18,7 @@
  **********************************************************************/
 
 #include "serialis.h"
+#include <stdint.h>
 #include <stdio.h>
 #include "genericvector.h"
 
@@ -26,6 +27,8 @@ namespace tesseract {
 TFile::TFile()
     : offset_(0),
       data_(NULL),
+      view_(NULL),
+      view_size_(0),
       data_is_owned_(false),
       is_writing_(false),
       swap_(false) {}
@@ -41,6 +44,7 @@ bool TFile::Open(const STRING& filename, FileReader reader) {
     data_is_owned_ = true;
   }
   offset_ = 0;
+  view_ = NULL;
   is_writing_ = false;
   swap_ = false;
   if (reader == NULL)
@@ -51,6 +55,7 @@ bool TFile::Open(const STRING& filename, FileReader reader) {
 
 bool TFile::Open(const char* data, int size) {
   offset_ = 0;
+  view_ = NULL;
   if (!data_is_owned_) {
     data_ = new GenericVector<char>;
     data_is_owned_ = true;
@@ -73,6 +78,7 @@ bool TFile::Open(FILE* fp, inT64 end_offset) {
       return false;
   }
   int size = end_offset - current_pos;
+  view_ = NULL;
   is_writing_ = false;
   swap_ = false;
   if (!data_is_owned_) {
@@ -83,25 +89,74 @@ bool TFile::Open(FILE* fp, inT64 end_offset) {
   return static_cast<int>(fread(&(*data_)[0], 1, size, fp)) == size;
 }
 
+bool TFile::OpenView(const char* data, int size) {
+  offset_ = 0;
+  view_ = data;
+  view_size_ = size;
+  is_writing_ = false;
+  swap_ = false;
+  return true;
+}
+
+const char* TFile::ReadData() const {
+  if (view_ != NULL) return view_;
+  return data_->empty() ? NULL : &(*data_)[0];
+}
+
+int TFile::ReadSize() const {
+  return view_ != NULL ? view_size_ : data_->size();
+}
+
 char* TFile::FGets(char* buffer, int buffer_size) {
   ASSERT_HOST(!is_writing_);
+  const char* data = ReadData();
+  int data_size = ReadSize();
   int size = 0;
-  while (size + 1 < buffer_size && offset_ < data_->size()) {
-    buffer[size++] = (*data_)[offset_++];
-    if ((*data_)[offset_ - 1] == '\n') break;
+  while (size + 1 < buffer_size && offset_ < data_size) {
+    buffer[size++] = data[offset_++];
+    if (data[offset_ - 1] == '\n') break;
   }
   if (size < buffer_size) buffer[size] = '\0';
   return size > 0 ? buffer : NULL;
 }
 
-int TFile::FReadEndian(void* buffer, int size, int count) {
-  int num_read = FRead(buffer, size, count);
-  if (swap_) {
-    char* char_buffer = static_cast<char*>(buffer);
-    for (int i = 0; i < num_read; ++i, char_buffer += size) {
-      ReverseN(char_buffer, size);
+// Reverses the bytes of each of the count items of size bytes in buffer.
+// The common sizes are swapped as whole words, in loops that the compiler
+// turns into byte shuffles, instead of one byte at a time.
+static void ReverseItems(char* buffer, int size, int count) {
+  if (size == 2) {
+    for (int i = 0; i < count; ++i, buffer += 2) {
+      uint16_t v;
+      memcpy(&v, buffer, sizeof(v));
+      v = static_cast<uint16_t>((v >> 8) | (v << 8));
+      memcpy(buffer, &v, sizeof(v));
     }
+  } else if (size == 4) {
+    for (int i = 0; i < count; ++i, buffer += 4) {
+      uint32_t v;
+      memcpy(&v, buffer, sizeof(v));
+      v = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+      memcpy(buffer, &v, sizeof(v));
+    }
+  } else if (size == 8) {
+    for (int i = 0; i < count; ++i, buffer += 8) {
+      uint64_t v;
+      memcpy(&v, buffer, sizeof(v));
+      v = ((v >> 8) & 0x00ff00ff00ff00ffULL) |
+          ((v & 0x00ff00ff00ff00ffULL) << 8);
+      v = ((v >> 16) & 0x0000ffff0000ffffULL) |
+          ((v & 0x0000ffff0000ffffULL) << 16);
+      v = (v >> 32) | (v << 32);
+      memcpy(buffer, &v, sizeof(v));
+    }
+  } else if (size > 1) {
+    for (int i = 0; i < count; ++i, buffer += size) ReverseN(buffer, size);
   }
+}
+
+int TFile::FReadEndian(void* buffer, int size, int count) {
+  int num_read = FRead(buffer, size, count);
+  if (swap_) ReverseItems(static_cast<char*>(buffer), size, num_read);
   return num_read;
 }
 
@@ -109,21 +164,36 @@ int TFile::FRead(void* buffer, int size, int count) {
   ASSERT_HOST(!is_writing_);
   int required_size = size * count;
   if (required_size <= 0) return 0;
-  if (data_->size() - offset_ < required_size)
-    required_size = data_->size() - offset_;
+  if (ReadSize() - offset_ < required_size)
+    required_size = ReadSize() - offset_;
   if (required_size > 0 && buffer != NULL)
-    memcpy(buffer, &(*data_)[offset_], required_size);
+    memcpy(buffer, ReadData() + offset_, required_size);
   offset_ += required_size;
   return required_size / size;
 }
 
+const char* TFile::ReadView(int size, int count) {
+  ASSERT_HOST(!is_writing_);
+  if (view_ == NULL || swap_ || size <= 0 || count <= 0) return NULL;
+  if ((view_size_ - offset_) / size < count) return NULL;
+  const char* result = view_ + offset_;
+  if (reinterpret_cast<uintptr_t>(result) & (size - 1)) return NULL;
+  offset_ += size * count;
+  return result;
+}
+
 void TFile::Rewind() {
   ASSERT_HOST(!is_writing_);
   offset_ = 0;
 }
 
+int TFile::Tell() const {
+  return is_writing_ ? data_->size() : offset_;
+}
+
 void TFile::OpenWrite(GenericVector<char>* data) {
   offset_ = 0;
+  view_ = NULL;
   if (data != NULL) {
     if (data_is_owned_) delete data_;
     data_ = data;
@@ -61,6 +61,10 @@ class TFile {
   bool Open(const char* data, int size);
   // From an open file and an end offset.
   bool Open(FILE* fp, inT64 end_offset);
+  // From an existing memory buffer without copying it. The buffer must stay
+  // valid and unchanged while the TFile, or anything holding a pointer
+  // obtained from ReadView, is in use.
+  bool OpenView(const char* data, int size);
   // Sets the value of the swap flag, so that FReadEndian does the right thing.
   void set_swap(bool value) { swap_ = value; }
 
@@ -75,9 +79,17 @@ class TFile {
   int FReadEndian(void* buffer, int size, int count);
   // Replicates fread, returning the number of items read.
   int FRead(void* buffer, int size, int count);
+  // Returns a pointer to the next count items of the given size and skips
+  // over them, but only if the TFile is a view (see OpenView), no byte
+  // swapping is needed, all the items are available and the data is aligned
+  // to size, which must be a power of 2. Otherwise returns NULL without
+  // moving, so the caller can fall back to FReadEndian.
+  const char* ReadView(int size, int count);
   // Resets the TFile as if it has been Opened, but nothing read.
   // Only allowed while reading!
   void Rewind();
+  // Returns the number of bytes read or written so far.
+  int Tell() const;
 
   // Open for writing. Either supply a non-NULL data with OpenWrite before
   // calling FWrite, (no close required), or supply a NULL data to OpenWrite
@@ -90,10 +102,19 @@ class TFile {
   int FWrite(const void* buffer, int size, int count);
 
  private:
+  // Returns the bytes being read, whether owned or a view.
+  const char* ReadData() const;
+  // Returns the number of bytes being read.
+  int ReadSize() const;
+
   // The number of bytes used so far.
   int offset_;
   // The buffered data from the file.
   GenericVector<char>* data_;
+  // External memory being read instead of data_ after OpenView, else NULL.
+  const char* view_;
+  // Size of view_ in bytes.
+  int view_size_;
   // True if the data_ pointer is owned by *this.
   bool data_is_owned_;
   // True if the TFile is open for writing.
@@ -40,8 +40,8 @@ const int kMaxDoubleSize = 16;
  * including total capacity and how much used (strlen with '\0').
  *
  * The implementation hides this header at the start of the data
- * buffer and appends the string on the end to keep sizeof(STRING)
- * unchanged from earlier versions so serialization is not affected.
+ * buffer and appends the string on the end. Short strings keep the
+ * header and the string inside the STRING instead.
  *
  * The collection of MACROS provide different implementations depending
  * on whether the string keeps track of its strlen or not so that this
@@ -52,7 +52,12 @@ const int kMaxDoubleSize = 16;
 const int kMinCapacity = 16;
 
 char* STRING::AllocData(int used, int capacity) {
-  data_ = (STRING_HEADER *)alloc_string(capacity + sizeof(STRING_HEADER));
+  if (capacity <= kInlineCapacity) {
+    data_ = NULL;
+    capacity = kInlineCapacity;
+  } else {
+    data_ = (STRING_HEADER *)alloc_string(capacity + sizeof(STRING_HEADER));
+  }
 
   // header is the metadata for this memory block
   STRING_HEADER* header = GetHeader();
@@ -62,7 +67,7 @@ char* STRING::AllocData(int used, int capacity) {
 }
 
 void STRING::DiscardData() {
-  free_string((char *)data_);
+  if (data_ != NULL) free_string((char *)data_);
 }
 
 // This is a private method; ensure FixHeader is called (or used_ is well defined)
@@ -70,7 +75,7 @@ void STRING::DiscardData() {
 char* STRING::ensure_cstr(inT32 min_capacity) {
   STRING_HEADER* orig_header = GetHeader();
   if (min_capacity <= orig_header->capacity_)
-    return ((char *)this->data_) + sizeof(STRING_HEADER);
+    return GetCStr();
 
   // if we are going to grow bigger, than double our existing
   // size, but if that still is not big enough then keep the
@@ -90,7 +95,7 @@ char* STRING::ensure_cstr(inT32 min_capacity) {
   data_ = new_header;
 
   assert(InvariantOk());
-  return ((char *)data_) + sizeof(STRING_HEADER);
+  return GetCStr();
 }
 
 // This is const, but is modifying a mutable field
@@ -116,6 +121,11 @@ STRING::STRING(const STRING& str) {
   assert(InvariantOk());
 }
 
+STRING::STRING(STRING&& str) : data_(str.data_), inline_(str.inline_) {
+  // Empty STRINGs contain just the "\0".
+  memcpy(str.AllocData(1, kMinCapacity), "", 1);
+}
+
 STRING::STRING(const char* cstr) {
   if (cstr == NULL) {
     // Empty STRINGs contain just the "\0".
@@ -355,6 +365,15 @@ STRING& STRING::operator=(const STRING& str) {
   return *this;
 }
 
+STRING& STRING::operator=(STRING&& str) {
+  if (&str == this) return *this;
+  DiscardData();
+  data_ = str.data_;
+  inline_ = str.inline_;
+  memcpy(str.AllocData(1, kMinCapacity), "", 1);
+  return *this;
+}
+
 STRING & STRING::operator+=(const STRING& str) {
   FixHeader();
   str.FixHeader();
@@ -47,6 +47,8 @@ class TESS_API STRING
   public:
     STRING();
     STRING(const STRING &string);
+    // Takes the buffer of string, leaving it empty.
+    STRING(STRING &&string);
     STRING(const char *string);
     STRING(const char *data, int length);
     ~STRING ();
@@ -98,6 +100,7 @@ class TESS_API STRING
 
     STRING & operator= (const char *string);
     STRING & operator= (const STRING & string);
+    STRING & operator= (STRING && string);
 
     STRING operator+ (const STRING & string) const;
     STRING operator+ (const char ch) const;
@@ -139,25 +142,37 @@ class TESS_API STRING
       mutable int used_;
     } STRING_HEADER;
 
-    // To preserve the behavior of the old serialization, we only have space
-    // for one pointer in this structure. So we are embedding a data structure
-    // at the start of the storage that will hold additional state variables,
-    // then storing the actual string contents immediately after.
+    // Strings of up to kInlineCapacity bytes, including the '\0', are kept
+    // in inline_, with data_ NULL, so that the many short strings, such as
+    // unichars, don't cost an allocation each. Longer ones are kept in an
+    // allocated block that holds the header followed by the string. As
+    // nothing points into the STRING itself, it can still be moved with
+    // memcpy, as qsort does.
+    static const int kInlineCapacity = 16;
+    struct STRING_INLINE {
+      STRING_HEADER header;
+      char chars[kInlineCapacity];
+    };
     STRING_HEADER* data_;
+    STRING_INLINE inline_;
 
     // returns the header part of the storage
     inline STRING_HEADER* GetHeader() {
-      return data_;
+      return data_ != NULL ? data_ : &inline_.header;
     }
     inline const STRING_HEADER* GetHeader() const {
-      return data_;
+      return data_ != NULL ? data_ : &inline_.header;
     }
 
     // returns the string data part of storage
-    inline char* GetCStr() { return ((char*)data_) + sizeof(STRING_HEADER); }
+    inline char* GetCStr() {
+      return data_ != NULL ? reinterpret_cast<char*>(data_ + 1)
+                           : inline_.chars;
+    }
 
     inline const char* GetCStr() const {
-      return ((const char *)data_) + sizeof(STRING_HEADER);
+      return data_ != NULL ? reinterpret_cast<const char*>(data_ + 1)
+                           : inline_.chars;
     }
     inline bool InvariantOk() const {
 #if STRING_IS_PROTECTED
@@ -24,15 +24,178 @@
 #include "tessdatamanager.h"
 
 #include <stdio.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
+#include "ccutil.h"
 #include "helpers.h"
 #include "serialis.h"
 #include "strngs.h"
 #include "tprintf.h"
 #include "params.h"
 
+BOOL_VAR(tessdata_mmap, false,
+         "Map traineddata files read-only and share them between instances"
+         " instead of reading a private copy");
+BOOL_VAR(tessdata_lazy_load, true,
+         "Read each component of a traineddata file when it is first used"
+         " instead of reading the whole file on init");
+
 namespace tesseract {
 
+#ifndef _WIN32
+// A read-only mapping of a traineddata file. Mappings are never unmapped,
+// as structures built from them may point into the mapped memory.
+struct MappedTessdataFile {
+  STRING name;
+  dev_t device;
+  ino_t inode;
+  time_t mtime;
+  const char *data;
+  int size;
+};
+
+static CCUtilMutex mapped_files_mutex;
+// Allocated on first use, and deliberately never deleted.
+static GenericVector<MappedTessdataFile> *mapped_files = nullptr;
+
+// Gets a mapping of the given file, reusing an existing mapping of the same
+// unchanged file. Returns false on failure.
+static bool GetMappedFile(const char *filename, const char **data,
+                          int *size) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > INT32_MAX) {
+    close(fd);
+    return false;
+  }
+  *data = nullptr;
+  mapped_files_mutex.Lock();
+  if (mapped_files == nullptr)
+    mapped_files = new GenericVector<MappedTessdataFile>;
+  for (int i = 0; i < mapped_files->size(); ++i) {
+    const MappedTessdataFile &file = (*mapped_files)[i];
+    if (file.device == st.st_dev && file.inode == st.st_ino &&
+        file.mtime == st.st_mtime && file.size == st.st_size &&
+        file.name == filename) {
+      *data = file.data;
+      *size = file.size;
+      break;
+    }
+  }
+  if (*data == nullptr) {
+    void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping != MAP_FAILED) {
+      MappedTessdataFile file;
+      file.name = filename;
+      file.device = st.st_dev;
+      file.inode = st.st_ino;
+      file.mtime = st.st_mtime;
+      file.data = static_cast<const char *>(mapping);
+      file.size = st.st_size;
+      mapped_files->push_back(file);
+      *data = file.data;
+      *size = file.size;
+    }
+  }
+  mapped_files_mutex.Unlock();
+  close(fd);
+  return *data != nullptr;
+}
+#endif  // _WIN32
+
+// Size of the header of the aligned layout, before the table of entries.
+static const int kAlignedHeaderSize =
+    kTessdataAlignedMagicSize + 4 * sizeof(inT32);
+// Largest table of contents of either layout.
+static const int kMaxEntryTableSize =
+    kAlignedHeaderSize + kMaxNumTessdataEntries * 2 * sizeof(inT64);
+
+// As ReadEntryTable, for the aligned layout, after the magic.
+static bool ReadAlignedEntryTable(TFile *fp, inT64 size, bool *swap,
+                                  inT64 offsets[TESSDATA_NUM_ENTRIES],
+                                  inT64 sizes[TESSDATA_NUM_ENTRIES]) {
+  inT32 header[4];
+  if (fp->FRead(header, sizeof(header[0]), 4) != 4) return false;
+  *swap = header[0] != kTessdataAlignedVersion;
+  fp->set_swap(*swap);
+  if (*swap) {
+    for (int i = 0; i < 4; ++i) ReverseN(&header[i], sizeof(header[i]));
+  }
+  if (header[0] != kTessdataAlignedVersion) {
+    tprintf("Unsupported traineddata layout version\n");
+    return false;
+  }
+  inT32 num_entries = header[1];
+  if (num_entries > kMaxNumTessdataEntries || num_entries < 0) return false;
+  GenericVector<inT64> entry_table;
+  entry_table.resize_no_init(2 * num_entries);
+  if (num_entries > 0 &&
+      fp->FReadEndian(&entry_table[0], sizeof(entry_table[0]),
+                      2 * num_entries) != 2 * num_entries)
+    return false;
+  for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    offsets[i] = -1;
+    sizes[i] = 0;
+    if (i >= num_entries || entry_table[2 * i] < 0) continue;
+    inT64 offset = entry_table[2 * i];
+    inT64 entry_size = entry_table[2 * i + 1];
+    if (offset > size || entry_size < 0 || entry_size > size - offset)
+      return false;
+    offsets[i] = offset;
+    sizes[i] = entry_size;
+  }
+  return true;
+}
+
+// Reads the offset table at the start of a traineddata file of the given
+// size from fp, and sets the offset and size of each component, with an
+// offset of -1 for the missing ones, and whether the file is in the aligned
+// layout. Returns false if the table is invalid.
+static bool ReadEntryTable(TFile *fp, inT64 size, bool *swap, bool *aligned,
+                           inT64 offsets[TESSDATA_NUM_ENTRIES],
+                           inT64 sizes[TESSDATA_NUM_ENTRIES]) {
+  char magic[kTessdataAlignedMagicSize];
+  *aligned = fp->FRead(magic, 1, kTessdataAlignedMagicSize) ==
+                 kTessdataAlignedMagicSize &&
+             memcmp(magic, kTessdataAlignedMagic,
+                    kTessdataAlignedMagicSize) == 0;
+  if (*aligned) return ReadAlignedEntryTable(fp, size, swap, offsets, sizes);
+  fp->Rewind();
+  inT32 num_entries = TESSDATA_NUM_ENTRIES;
+  if (fp->FRead(&num_entries, sizeof(num_entries), 1) != 1) return false;
+  *swap = num_entries > kMaxNumTessdataEntries || num_entries < 0;
+  fp->set_swap(*swap);
+  if (*swap) ReverseN(&num_entries, sizeof(num_entries));
+  if (num_entries > kMaxNumTessdataEntries || num_entries < 0) return false;
+  GenericVector<inT64> offset_table;
+  offset_table.resize_no_init(num_entries);
+  if (num_entries > 0 &&
+      fp->FReadEndian(&offset_table[0], sizeof(offset_table[0]),
+                      num_entries) != num_entries)
+    return false;
+  for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    offsets[i] = -1;
+    sizes[i] = 0;
+    if (i >= num_entries || offset_table[i] < 0) continue;
+    inT64 entry_size = size - offset_table[i];
+    int j = i + 1;
+    while (j < num_entries && offset_table[j] == -1) ++j;
+    if (j < num_entries) entry_size = offset_table[j] - offset_table[i];
+    if (offset_table[i] > size || entry_size < 0 ||
+        entry_size > size - offset_table[i])
+      return false;
+    offsets[i] = offset_table[i];
+    sizes[i] = entry_size;
+  }
+  return true;
+}
+
 // Lazily loads from the the given filename. Won't actually read the file
 // until it needs it.
 void TessdataManager::LoadFileLater(const char *data_file_name) {
@@ -41,6 +204,11 @@ void TessdataManager::LoadFileLater(const char *data_file_name) {
 }
 
 bool TessdataManager::Init(const char *data_file_name) {
+  if (reader_ == nullptr && tessdata_mmap && MapFile(data_file_name))
+    return true;
+  if (reader_ == nullptr && tessdata_lazy_load &&
+      ReadDirectory(data_file_name))
+    return true;
   GenericVector<char> data;
   if (reader_ == nullptr) {
     if (!LoadDataFromFile(data_file_name, &data)) return false;
@@ -50,35 +218,106 @@ bool TessdataManager::Init(const char *data_file_name) {
   return LoadMemBuffer(data_file_name, &data[0], data.size());
 }
 
+bool TessdataManager::MapFile(const char *data_file_name) {
+#ifndef _WIN32
+  const char *data;
+  int size;
+  if (!GetMappedFile(data_file_name, &data, &size)) return false;
+  return LoadBuffer(data_file_name, data, size, true);
+#else
+  return false;
+#endif
+}
+
+// Reads only the table of contents of the given file, leaving the components
+// to be read on first use.
+bool TessdataManager::ReadDirectory(const char *data_file_name) {
+  FILE *fp = fopen(data_file_name, "rb");
+  if (fp == nullptr) return false;
+  // Only the offset table is read, the components are read by LoadEntry.
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  GenericVector<char> header;
+  // Trying to open a directory on Linux sets size to LONG_MAX.
+  if (size > 0 && size < INT32_MAX) {
+    header.resize_no_init(MIN(size, kMaxEntryTableSize));
+    size_t header_size = header.size();
+    if (fread(&header[0], 1, header_size, fp) != header_size)
+      header.clear();
+  }
+  fclose(fp);
+  if (header.empty()) return false;
+  TFile table;
+  table.OpenView(&header[0], header.size());
+  bool swap, aligned;
+  inT64 offsets[TESSDATA_NUM_ENTRIES];
+  inT64 sizes[TESSDATA_NUM_ENTRIES];
+  if (!ReadEntryTable(&table, size, &swap, &aligned, offsets, sizes))
+    return false;
+  Clear();
+  data_file_name_ = data_file_name;
+  swap_ = swap;
+  is_aligned_ = aligned;
+  for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    lazy_offsets_[i] = offsets[i];
+    lazy_sizes_[i] = sizes[i];
+  }
+  is_loaded_ = true;
+  if (EntrySize(TESSDATA_VERSION) == 0 ||
+      EntryData(TESSDATA_VERSION) == nullptr) {
+    SetVersionString("Pre-4.0.0");
+  }
+  return true;
+}
+
+// Reads the given component from the file, clearing it on failure.
+void TessdataManager::LoadEntry(int type) const {
+  size_t size = lazy_sizes_[type];
+  lazy_sizes_[type] = 0;
+  FILE *fp = fopen(data_file_name_.string(), "rb");
+  bool ok = fp != nullptr && fseek(fp, lazy_offsets_[type], SEEK_SET) == 0;
+  if (ok) {
+    entries_[type].resize_no_init(size);
+    ok = fread(&entries_[type][0], 1, size, fp) == size;
+  }
+  if (fp != nullptr) fclose(fp);
+  if (!ok) {
+    tprintf("Error reading %s from %s\n", kTessdataFileSuffixes[type],
+            data_file_name_.string());
+    entries_[type].clear();
+  }
+}
+
 // Loads from the given memory buffer as if a file.
 bool TessdataManager::LoadMemBuffer(const char *name, const char *data,
                                     int size) {
+  return LoadBuffer(name, data, size, false);
+}
+
+// Loads the components from data, copying them or making them views.
+bool TessdataManager::LoadBuffer(const char *name, const char *data, int size,
+                                 bool map) {
   Clear();
   data_file_name_ = name;
   TFile fp;
-  fp.Open(data, size);
-  inT32 num_entries = TESSDATA_NUM_ENTRIES;
-  if (fp.FRead(&num_entries, sizeof(num_entries), 1) != 1) return false;
-  swap_ = num_entries > kMaxNumTessdataEntries || num_entries < 0;
-  fp.set_swap(swap_);
-  if (swap_) ReverseN(&num_entries, sizeof(num_entries));
-  if (num_entries > kMaxNumTessdataEntries || num_entries < 0) return false;
-  GenericVector<inT64> offset_table;
-  offset_table.resize_no_init(num_entries);
-  if (fp.FReadEndian(&offset_table[0], sizeof(offset_table[0]), num_entries) !=
-      num_entries)
+  fp.OpenView(data, size);
+  inT64 offsets[TESSDATA_NUM_ENTRIES];
+  inT64 sizes[TESSDATA_NUM_ENTRIES];
+  if (!ReadEntryTable(&fp, size, &swap_, &is_aligned_, offsets, sizes))
     return false;
-  for (int i = 0; i < num_entries && i < TESSDATA_NUM_ENTRIES; ++i) {
-    if (offset_table[i] >= 0) {
-      inT64 entry_size = size - offset_table[i];
-      int j = i + 1;
-      while (j < num_entries && offset_table[j] == -1) ++j;
-      if (j < num_entries) entry_size = offset_table[j] - offset_table[i];
-      entries_[i].resize_no_init(entry_size);
-      if (fp.FRead(&entries_[i][0], 1, entry_size) != entry_size) return false;
+  for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    if (sizes[i] == 0) continue;
+    if (map) {
+      mapped_entries_[i] = data + offsets[i];
+      mapped_sizes_[i] = sizes[i];
+    } else {
+      entries_[i].resize_no_init(sizes[i]);
+      memcpy(&entries_[i][0], data + offsets[i], sizes[i]);
     }
   }
-  if (entries_[TESSDATA_VERSION].empty()) {
+  is_mapped_ = map;
+  if (EntrySize(TESSDATA_VERSION) == 0) {
     SetVersionString("Pre-4.0.0");
   }
   is_loaded_ = true;
@@ -89,6 +328,8 @@ bool TessdataManager::LoadMemBuffer(const char *name, const char *data,
 void TessdataManager::OverwriteEntry(TessdataType type, const char *data,
                                      int size) {
   is_loaded_ = true;
+  mapped_sizes_[type] = 0;
+  lazy_sizes_[type] = 0;
   entries_[type].resize_no_init(size);
   memcpy(&entries_[type][0], data, size);
 }
@@ -108,47 +349,81 @@ bool TessdataManager::SaveFile(const STRING &filename,
 // Serializes to the given vector.
 void TessdataManager::Serialize(GenericVector<char> *data) const {
   ASSERT_HOST(is_loaded_);
+  // Read the components still in the file, so that their sizes are final.
+  for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) EntryData(i);
   // Compute the offset_table and total size.
   inT64 offset_table[TESSDATA_NUM_ENTRIES];
-  inT64 offset = sizeof(inT32) + sizeof(offset_table);
-  for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
-    if (entries_[i].empty()) {
-      offset_table[i] = -1;
-    } else {
-      offset_table[i] = offset;
-      offset += entries_[i].size();
-    }
-  }
-  data->init_to_size(offset, 0);
+  data->init_to_size(ComputeOffsets(offset_table), 0);
   inT32 num_entries = TESSDATA_NUM_ENTRIES;
   TFile fp;
   fp.OpenWrite(data);
-  fp.FWrite(&num_entries, sizeof(num_entries), 1);
-  fp.FWrite(offset_table, sizeof(offset_table), 1);
+  if (is_aligned_) {
+    fp.FWrite(kTessdataAlignedMagic, 1, kTessdataAlignedMagicSize);
+    inT32 header[4] = {kTessdataAlignedVersion, num_entries,
+                       kTessdataPageAlignment, 0};
+    fp.FWrite(header, sizeof(header[0]), 4);
+    for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+      inT64 entry[2] = {offset_table[i], EntrySize(i)};
+      fp.FWrite(entry, sizeof(entry[0]), 2);
+    }
+  } else {
+    fp.FWrite(&num_entries, sizeof(num_entries), 1);
+    fp.FWrite(offset_table, sizeof(offset_table), 1);
+  }
   for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
-    if (!entries_[i].empty()) {
-      fp.FWrite(&entries_[i][0], entries_[i].size(), 1);
+    if (EntrySize(i) > 0) {
+      const char kZero = 0;
+      while (fp.Tell() < offset_table[i]) fp.FWrite(&kZero, 1, 1);
+      fp.FWrite(EntryData(i), EntrySize(i), 1);
     }
   }
 }
 
+// Computes the offset of each component in the file Serialize writes.
+inT64 TessdataManager::ComputeOffsets(
+    inT64 offsets[TESSDATA_NUM_ENTRIES]) const {
+  inT64 offset = is_aligned_
+                     ? kAlignedHeaderSize +
+                           TESSDATA_NUM_ENTRIES * 2 * sizeof(inT64)
+                     : sizeof(inT32) + TESSDATA_NUM_ENTRIES * sizeof(inT64);
+  for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    if (EntrySize(i) == 0) {
+      offsets[i] = -1;
+      continue;
+    }
+    if (is_aligned_) {
+      // Large components get whole pages, so that they map cleanly.
+      int alignment = EntrySize(i) >= kTessdataPageAlignment
+                          ? kTessdataPageAlignment
+                          : kTessdataCacheLineAlignment;
+      offset = (offset + alignment - 1) / alignment * alignment;
+    }
+    offsets[i] = offset;
+    offset += EntrySize(i);
+  }
+  return offset;
+}
+
 // Resets to the initial state, keeping the reader.
 void TessdataManager::Clear() {
   for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
     entries_[i].clear();
   }
+  ClearMappedEntries();
   is_loaded_ = false;
 }
 
 // Prints a directory of contents.
 void TessdataManager::Directory() const {
   tprintf("Version string:%s\n", VersionString().c_str());
-  int offset = TESSDATA_NUM_ENTRIES * sizeof(inT64);
+  if (is_aligned_)
+    tprintf("Aligned layout version %d\n", kTessdataAlignedVersion);
+  inT64 offsets[TESSDATA_NUM_ENTRIES];
+  ComputeOffsets(offsets);
   for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
-    if (!entries_[i].empty()) {
+    if (EntrySize(i) > 0) {
       tprintf("%d:%s:size=%d, offset=%d\n", i, kTessdataFileSuffixes[i],
-              entries_[i].size(), offset);
-      offset += entries_[i].size();
+              EntrySize(i), static_cast<int>(offsets[i]));
     }
   }
 }
@@ -165,20 +440,26 @@ bool TessdataManager::GetComponent(TessdataType type, TFile *fp) {
 // loaded.
 bool TessdataManager::GetComponent(TessdataType type, TFile *fp) const {
   ASSERT_HOST(is_loaded_);
-  if (entries_[type].empty()) return false;
-  fp->Open(&entries_[type][0], entries_[type].size());
+  if (EntrySize(type) == 0) return false;
+  const char *data = EntryData(type);
+  if (data == nullptr) return false;
+  if (is_mapped_ && mapped_sizes_[type] > 0)
+    fp->OpenView(data, EntrySize(type));
+  else
+    fp->Open(data, EntrySize(type));
   fp->set_swap(swap_);
   return true;
 }
 
 // Returns the current version string.
 string TessdataManager::VersionString() const {
-  return string(&entries_[TESSDATA_VERSION][0],
-                entries_[TESSDATA_VERSION].size());
+  return string(EntryData(TESSDATA_VERSION), EntrySize(TESSDATA_VERSION));
 }
 
 // Sets the version string to the given v_str.
 void TessdataManager::SetVersionString(const string &v_str) {
+  mapped_sizes_[TESSDATA_VERSION] = 0;
+  lazy_sizes_[TESSDATA_VERSION] = 0;
   entries_[TESSDATA_VERSION].resize_no_init(v_str.size());
   memcpy(&entries_[TESSDATA_VERSION][0], v_str.data(), v_str.size());
 }
@@ -222,6 +503,8 @@ bool TessdataManager::OverwriteComponents(
   for (int i = 0; i < num_new_components; ++i) {
     TessdataType type;
     if (TessdataTypeFromFileName(component_filenames[i], &type)) {
+      mapped_sizes_[type] = 0;
+      lazy_sizes_[type] = 0;
       if (!LoadDataFromFile(component_filenames[i], &entries_[type])) {
         tprintf("Failed to read component file:%s\n", component_filenames[i]);
         return false;
@@ -237,8 +520,14 @@ bool TessdataManager::ExtractToFile(const char *filename) {
   TessdataType type = TESSDATA_NUM_ENTRIES;
   ASSERT_HOST(
       tesseract::TessdataManager::TessdataTypeFromFileName(filename, &type));
-  if (entries_[type].empty()) return false;
-  return SaveDataToFile(entries_[type], filename);
+  if (EntrySize(type) == 0) return false;
+  // Reads the component if it has not been read yet.
+  if (EntryData(type) == nullptr) return false;
+  if (mapped_sizes_[type] == 0) return SaveDataToFile(entries_[type], filename);
+  GenericVector<char> data;
+  data.resize_no_init(EntrySize(type));
+  memcpy(&data[0], EntryData(type), EntrySize(type));
+  return SaveDataToFile(data, filename);
 }
 
 bool TessdataManager::TessdataTypeFromFileSuffix(const char *suffix,
@@ -127,14 +127,33 @@ static const char *const kTessdataFileSuffixes[] = {
  */
 static const int kMaxNumTessdataEntries = 1000;
 
+/**
+ * Start of a traineddata file in the aligned layout, in which each component
+ * starts on a page boundary, or a cache line boundary for the small ones, so
+ * that a mapped file can be used in place, and the table after the header
+ * gives the offset and size of each component. Older versions read the
+ * start as an invalid number of entries and reject the file cleanly.
+ * The header is the magic, then inT32 version, number of entries, page
+ * alignment and zero, then an inT64 offset (-1 if absent) and size for each
+ * entry.
+ */
+static const char kTessdataAlignedMagic[] = "TDALIGN\n";
+static const int kTessdataAlignedMagicSize = sizeof(kTessdataAlignedMagic) - 1;
+static const int kTessdataAlignedVersion = 2;
+static const int kTessdataPageAlignment = 4096;
+static const int kTessdataCacheLineAlignment = 64;
+
 
 class TessdataManager {
  public:
-  TessdataManager() : reader_(nullptr), is_loaded_(false), swap_(false) {
+  TessdataManager()
+      : reader_(nullptr), is_loaded_(false), swap_(false), is_aligned_(false) {
+    ClearMappedEntries();
     SetVersionString(TESSERACT_VERSION_STR);
   }
   explicit TessdataManager(FileReader reader)
-      : reader_(reader), is_loaded_(false), swap_(false) {
+      : reader_(reader), is_loaded_(false), swap_(false), is_aligned_(false) {
+    ClearMappedEntries();
     SetVersionString(TESSERACT_VERSION_STR);
   }
   ~TessdataManager() {}
@@ -147,9 +166,36 @@ class TessdataManager {
   void LoadFileLater(const char *data_file_name);
   /**
    * Opens and reads the given data file right now.
+   * If tessdata_mmap is set and there is no custom reader, the file is
+   * mapped read-only (see MapFile) instead of being read. Otherwise, if
+   * tessdata_lazy_load is set and there is no custom reader, only its table
+   * of contents is read (see ReadDirectory).
    * @return true on success.
    */
   bool Init(const char *data_file_name);
+  /**
+   * Reads the table of contents of the given data file, leaving each
+   * component to be read from the file the first time it is used, so that
+   * the components an engine mode or the dawg settings do not need are
+   * never read. Returns false if the file can't be read.
+   */
+  bool ReadDirectory(const char *data_file_name);
+  /**
+   * Maps the given data file read-only and makes the components views into
+   * the mapping, without copying them. The mapping is shared by every
+   * TessdataManager in the process that maps the same file, and by the
+   * page cache with other processes, and is never unmapped, so structures
+   * built from the components may keep pointers into it (see
+   * TFile::ReadView). Returns false if the file can't be mapped.
+   */
+  bool MapFile(const char *data_file_name);
+  // Returns true if the components are views of a mapped file.
+  bool is_mapped() const { return is_mapped_; }
+  // Returns true if the file was read from, and will be saved in, the aligned
+  // layout (see kTessdataAlignedMagic).
+  bool is_aligned() const { return is_aligned_; }
+  // Sets the layout to save in.
+  void set_aligned(bool value) { is_aligned_ = value; }
   // Loads from the given memory buffer as if a file, remembering name as some
   // arbitrary source id for caching.
   bool LoadMemBuffer(const char *name, const char *data, int size);
@@ -168,13 +214,13 @@ class TessdataManager {
 
   // Returns true if the component requested is present.
   bool IsComponentAvailable(TessdataType type) const {
-    return !entries_[type].empty();
+    return EntrySize(type) > 0;
   }
   // Opens the given TFile pointer to the given component type.
   // Returns false in case of failure.
   bool GetComponent(TessdataType type, TFile *fp);
-  // As non-const version except it can't load the component if not already
-  // loaded.
+  // As non-const version except it can't load the file if not already
+  // loaded. It still reads a component that is waiting in the file.
   bool GetComponent(TessdataType type, TFile *fp) const;
 
   // Returns the current version string.
@@ -184,12 +230,12 @@ class TessdataManager {
 
   // Returns true if the base Tesseract components are present.
   bool IsBaseAvailable() const {
-    return !entries_[TESSDATA_UNICHARSET].empty() &&
-           !entries_[TESSDATA_INTTEMP].empty();
+    return EntrySize(TESSDATA_UNICHARSET) > 0 &&
+           EntrySize(TESSDATA_INTTEMP) > 0;
   }
 
   // Returns true if the LSTM components are present.
-  bool IsLSTMAvailable() const { return !entries_[TESSDATA_LSTM].empty(); }
+  bool IsLSTMAvailable() const { return EntrySize(TESSDATA_LSTM) > 0; }
 
   // Return the name of the underlying data file.
   const STRING &GetDataFileName() const { return data_file_name_; }
@@ -240,6 +286,39 @@ class TessdataManager {
                                        TessdataType *type);
 
  private:
+  // Loads the components from data, copying them into entries_, or making
+  // them views into data if map is true.
+  bool LoadBuffer(const char *name, const char *data, int size, bool map);
+  // Computes the offset of each component in the file Serialize writes,
+  // with -1 for the missing ones, and returns the size of the file.
+  inT64 ComputeOffsets(inT64 offsets[TESSDATA_NUM_ENTRIES]) const;
+  // Reads the given component, which ReadDirectory left in the file, into
+  // entries_. On failure, the component is left empty.
+  void LoadEntry(int type) const;
+  // Returns the bytes of the given component, owned or mapped, reading it
+  // from the file first if needed.
+  const char *EntryData(int type) const {
+    if (lazy_sizes_[type] > 0) LoadEntry(type);
+    return mapped_sizes_[type] > 0 ? mapped_entries_[type]
+                                   : (entries_[type].empty()
+                                          ? nullptr : &entries_[type][0]);
+  }
+  // Returns the size in bytes of the given component, owned or mapped.
+  int EntrySize(int type) const {
+    if (mapped_sizes_[type] > 0) return mapped_sizes_[type];
+    return lazy_sizes_[type] > 0 ? lazy_sizes_[type] : entries_[type].size();
+  }
+  // Forgets all the mapped views and the components still in the file.
+  void ClearMappedEntries() {
+    is_mapped_ = false;
+    for (int i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+      mapped_entries_[i] = nullptr;
+      mapped_sizes_[i] = 0;
+      lazy_offsets_[i] = -1;
+      lazy_sizes_[i] = 0;
+    }
+  }
+
   // Name of file it came from.
   STRING data_file_name_;
   // Function to load the file when we need it.
@@ -248,8 +327,21 @@ class TessdataManager {
   bool is_loaded_;
   // True if the bytes need swapping.
   bool swap_;
-  // Contents of each element of the traineddata file.
-  GenericVector<char> entries_[TESSDATA_NUM_ENTRIES];
+  // True if the file is in the aligned layout.
+  bool is_aligned_;
+  // True if the components come from a mapped file.
+  bool is_mapped_;
+  // Contents of each element of the traineddata file. Mutable, as components
+  // left in the file by ReadDirectory are read on first use.
+  mutable GenericVector<char> entries_[TESSDATA_NUM_ENTRIES];
+  // Views into a mapped file, used instead of entries_ where the size is
+  // non-zero.
+  const char *mapped_entries_[TESSDATA_NUM_ENTRIES];
+  int mapped_sizes_[TESSDATA_NUM_ENTRIES];
+  // Position in the file of the components not read yet, used instead of
+  // entries_ where the size is non-zero.
+  inT64 lazy_offsets_[TESSDATA_NUM_ENTRIES];
+  mutable int lazy_sizes_[TESSDATA_NUM_ENTRIES];
 };
 
 }  // namespace tesseract
@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////
+// File:        textwriter.cpp
+// Description: Output of text through a fixed size buffer.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "textwriter.h"
+
+#include <string.h>
+#include "strngs.h"
+
+namespace tesseract {
+
+// Room for any int or %.8g double, as in STRING.
+const int kMaxNumberSize = 24;
+
+TextWriter::TextWriter(int buffer_size)
+  : buffer_(new char[buffer_size]), size_(buffer_size), used_(0),
+    ok_(true) {
+}
+
+TextWriter::~TextWriter() {
+  delete [] buffer_;
+}
+
+// Like those of STRING, NULL and '\0' add nothing.
+TextWriter& TextWriter::operator+=(const char* str) {
+  if (str != NULL) Append(str, strlen(str));
+  return *this;
+}
+
+TextWriter& TextWriter::operator+=(char ch) {
+  if (ch == '\0') return *this;
+  if (used_ == size_) Flush();
+  buffer_[used_++] = ch;
+  return *this;
+}
+
+void TextWriter::Append(const char* data, int len) {
+  if (used_ + len > size_) {
+    Flush();
+    // What would not fit in the buffer anyway goes straight out.
+    if (len >= size_) {
+      if (!WriteData(data, len)) ok_ = false;
+      return;
+    }
+  }
+  memcpy(buffer_ + used_, data, len);
+  used_ += len;
+}
+
+void TextWriter::add_str_int(const char* str, int number) {
+  if (str != NULL) *this += str;
+  char num_buffer[kMaxNumberSize];
+  int len = snprintf(num_buffer, kMaxNumberSize, "%d", number);
+  Append(num_buffer, len);
+}
+
+void TextWriter::add_str_double(const char* str, double number) {
+  if (str != NULL) *this += str;
+  char num_buffer[kMaxNumberSize];
+  int len = snprintf(num_buffer, kMaxNumberSize, "%.8g", number);
+  Append(num_buffer, len);
+}
+
+bool TextWriter::Flush() {
+  if (used_ > 0 && !WriteData(buffer_, used_)) ok_ = false;
+  used_ = 0;
+  return ok_;
+}
+
+StringTextWriter::StringTextWriter(STRING* str) : str_(str) {
+}
+
+StringTextWriter::~StringTextWriter() {
+  Flush();
+}
+
+bool StringTextWriter::WriteData(const char* data, int len) {
+  *str_ += STRING(data, len);
+  return true;
+}
+
+FileTextWriter::FileTextWriter(FILE* fp) : fp_(fp) {
+}
+
+FileTextWriter::~FileTextWriter() {
+  Flush();
+}
+
+bool FileTextWriter::WriteData(const char* data, int len) {
+  return fwrite(data, 1, len, fp_) == static_cast<size_t>(len);
+}
+
+}  // namespace tesseract.
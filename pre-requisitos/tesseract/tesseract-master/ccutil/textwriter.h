@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////
+// File:        textwriter.h
+// Description: Output of text through a fixed size buffer.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_TEXTWRITER_H_
+#define TESSERACT_CCUTIL_TEXTWRITER_H_
+
+#include <stdio.h>
+#include "platform.h"
+
+class STRING;
+
+namespace tesseract {
+
+// Collects small pieces of text in a buffer of a fixed size and passes them
+// on to WriteData in chunks, so that a large document is produced piece by
+// piece without ever being held whole in memory. The appending methods
+// mirror those of STRING, so code that builds text can target either.
+class TESS_API TextWriter {
+ public:
+  static const int kDefaultBufferSize = 16384;
+
+  explicit TextWriter(int buffer_size = kDefaultBufferSize);
+  // Derived classes must Flush in their own destructor, as WriteData is
+  // no longer theirs to call here.
+  virtual ~TextWriter();
+
+  TextWriter& operator+=(const char* str);
+  TextWriter& operator+=(char ch);
+  void Append(const char* data, int len);
+  // Appends str, if not NULL, then number as a %d or a %.8g.
+  void add_str_int(const char* str, int number);
+  void add_str_double(const char* str, double number);
+
+  // Writes out all the buffered text. Returns false if any write so far
+  // has failed.
+  bool Flush();
+  bool ok() const { return ok_; }
+
+ protected:
+  // Writes len bytes of data to the destination, returning false on error.
+  virtual bool WriteData(const char* data, int len) = 0;
+
+ private:
+  char* buffer_;
+  int size_;
+  int used_;
+  bool ok_;
+};
+
+// Appends to a STRING.
+class TESS_API StringTextWriter : public TextWriter {
+ public:
+  explicit StringTextWriter(STRING* str);
+  virtual ~StringTextWriter();
+
+ protected:
+  virtual bool WriteData(const char* data, int len);
+
+ private:
+  STRING* str_;
+};
+
+// Writes to a FILE, which stays open and owned by the caller.
+class TESS_API FileTextWriter : public TextWriter {
+ public:
+  explicit FileTextWriter(FILE* fp);
+  virtual ~FileTextWriter();
+
+ protected:
+  virtual bool WriteData(const char* data, int len);
+
+ private:
+  FILE* fp_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCUTIL_TEXTWRITER_H_
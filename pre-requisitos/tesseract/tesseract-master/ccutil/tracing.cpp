@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////
+// File:        tracing.cpp
+// Description: Timeline of the work of each thread, for Chrome and
+//              Perfetto.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "tracing.h"
+
+#include <stdio.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace tesseract {
+
+// Spans kept by each thread, the oldest being overwritten past them.
+const int kTraceBufferSize = 1 << 15;
+
+// A complete span (phase 'X'), or the beginning ('B') or end ('E') of one.
+struct TraceEvent {
+  const char* name;
+  int64_t start_ns;
+  int64_t end_ns;
+  char phase;
+};
+
+// The ring buffer of a thread. Only its thread writes events and count,
+// which is stored after the event, so WriteJSON sees whole events.
+struct ThreadTrace {
+  int tid;
+  std::atomic<bool> in_use;
+  std::atomic<uint64_t> count;
+  TraceEvent events[kTraceBufferSize];
+};
+
+// The buffers of all the threads that ever recorded a span. The buffer of a
+// thread that ended is given to the next new thread, so thread pools that
+// come and go with each document don't pile up buffers.
+static std::mutex traces_mutex;
+static std::vector<ThreadTrace*> traces;
+static int64_t start_ns = 0;
+
+// Frees the buffer of its thread for reuse when the thread ends.
+struct ThreadTraceSlot {
+  ThreadTrace* trace = nullptr;
+  ~ThreadTraceSlot() {
+    if (trace != nullptr) trace->in_use.store(false);
+  }
+};
+static thread_local ThreadTraceSlot thread_trace;
+
+static ThreadTrace* GetThreadTrace() {
+  if (thread_trace.trace != nullptr) return thread_trace.trace;
+  std::lock_guard<std::mutex> lock(traces_mutex);
+  for (ThreadTrace* trace : traces) {
+    if (!trace->in_use.load()) {
+      trace->in_use.store(true);
+      thread_trace.trace = trace;
+      return trace;
+    }
+  }
+  ThreadTrace* trace = new ThreadTrace;
+  trace->tid = traces.size() + 1;
+  trace->in_use.store(true);
+  trace->count.store(0);
+  traces.push_back(trace);
+  thread_trace.trace = trace;
+  return trace;
+}
+
+static void AddEvent(const char* name, int64_t start, int64_t end,
+                     char phase) {
+  ThreadTrace* trace = GetThreadTrace();
+  uint64_t count = trace->count.load(std::memory_order_relaxed);
+  TraceEvent* event = &trace->events[count % kTraceBufferSize];
+  event->name = name;
+  event->start_ns = start;
+  event->end_ns = end;
+  event->phase = phase;
+  trace->count.store(count + 1, std::memory_order_release);
+}
+
+std::atomic<bool> TraceRecorder::enabled_(false);
+
+void TraceRecorder::Start() {
+  std::lock_guard<std::mutex> lock(traces_mutex);
+  for (ThreadTrace* trace : traces) trace->count.store(0);
+  start_ns = NowNanoseconds();
+  enabled_.store(true);
+}
+
+void TraceRecorder::Stop() {
+  enabled_.store(false);
+}
+
+void TraceRecorder::AddSpan(const char* name, int64_t start, int64_t end) {
+  AddEvent(name, start, end, 'X');
+}
+
+void TraceRecorder::Begin(const char* name) {
+  if (!enabled()) return;
+  int64_t now = NowNanoseconds();
+  AddEvent(name, now, now, 'B');
+}
+
+void TraceRecorder::End(const char* name) {
+  if (!enabled()) return;
+  int64_t now = NowNanoseconds();
+  AddEvent(name, now, now, 'E');
+}
+
+int64_t TraceRecorder::NowNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Writes the name as a JSON string.
+static void WriteName(const char* name, FILE* fp) {
+  fputc('"', fp);
+  for (const char* c = name; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') fputc('\\', fp);
+    if (static_cast<unsigned char>(*c) >= 0x20) fputc(*c, fp);
+  }
+  fputc('"', fp);
+}
+
+bool TraceRecorder::WriteJSON(const char* filename) {
+  FILE* fp = fopen(filename, "w");
+  if (fp == nullptr) return false;
+  std::lock_guard<std::mutex> lock(traces_mutex);
+  fprintf(fp, "{\"traceEvents\":[\n");
+  bool first = true;
+  for (const ThreadTrace* trace : traces) {
+    uint64_t count = trace->count.load(std::memory_order_acquire);
+    if (count == 0) continue;
+    fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+            first ? "" : ",\n", trace->tid, trace->tid);
+    first = false;
+    uint64_t begin = count > kTraceBufferSize ? count - kTraceBufferSize : 0;
+    for (uint64_t i = begin; i < count; ++i) {
+      const TraceEvent& event = trace->events[i % kTraceBufferSize];
+      fprintf(fp, ",\n{\"name\":");
+      WriteName(event.name, fp);
+      // Times are in microseconds from Start.
+      fprintf(fp, ",\"ph\":\"%c\",\"ts\":%.3f,", event.phase,
+              (event.start_ns - start_ns) / 1000.0);
+      if (event.phase == 'X')
+        fprintf(fp, "\"dur\":%.3f,", (event.end_ns - event.start_ns) / 1000.0);
+      fprintf(fp, "\"pid\":1,\"tid\":%d}", trace->tid);
+    }
+  }
+  fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  return fclose(fp) == 0;
+}
+
+}  // namespace tesseract.
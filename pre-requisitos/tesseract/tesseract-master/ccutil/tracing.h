@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////
+// File:        tracing.h
+// Description: Timeline of the work of each thread, for Chrome and
+//              Perfetto.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_TRACING_H_
+#define TESSERACT_CCUTIL_TRACING_H_
+
+#include <stdint.h>
+#include <atomic>
+#include "platform.h"
+
+namespace tesseract {
+
+// Records the spans of work of every thread while it is started, and
+// writes them as a JSON trace that chrome://tracing and ui.perfetto.dev
+// load, so the timelines show how busy each thread was and where it waited.
+//
+// Each thread writes its spans to a ring buffer of its own, without locks,
+// keeping the last kTraceBufferSize of them. Start and WriteJSON must be
+// called while no traced work runs, as they touch the buffers of all the
+// threads. When tracing is stopped a span costs one relaxed atomic load,
+// and building with TRACING_DISABLED removes the spans altogether.
+class TESS_API TraceRecorder {
+ public:
+  // Drops any recorded spans and starts recording.
+  static void Start();
+  static void Stop();
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Writes the spans recorded since Start as a JSON trace. Returns false if
+  // the file can't be written.
+  static bool WriteJSON(const char* filename);
+
+  // Records a span of the calling thread, with times from NowNanoseconds.
+  // name must outlive the recorder, as only the pointer is kept.
+  static void AddSpan(const char* name, int64_t start_ns, int64_t end_ns);
+  // Record the beginning and end of a span separately, for libraries that
+  // report them through callbacks. Begin and End of a span must be called
+  // on the same thread, with spans nested.
+  static void Begin(const char* name);
+  static void End(const char* name);
+
+  // Returns the time in nanoseconds of the monotonic clock of the spans.
+  static int64_t NowNanoseconds();
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+// Records the span from its construction to its destruction, if tracing
+// was on at its construction.
+class TESS_API TraceSpan {
+ public:
+  explicit TraceSpan(const char* name)
+    : name_(TraceRecorder::enabled() ? name : NULL),
+      start_(name_ != NULL ? TraceRecorder::NowNanoseconds() : 0) {}
+  ~TraceSpan() {
+    if (name_ != NULL)
+      TraceRecorder::AddSpan(name_, start_, TraceRecorder::NowNanoseconds());
+  }
+
+ private:
+  const char* name_;
+  int64_t start_;
+};
+
+}  // namespace tesseract.
+
+// Traces the rest of the enclosing scope as a span named by the string
+// literal name.
+#ifdef TRACING_DISABLED
+#define TESS_TRACE_SPAN(name)
+#else
+#define TESS_TRACE_SPAN_CONCAT(a, b) a##b
+#define TESS_TRACE_SPAN_VAR(line) TESS_TRACE_SPAN_CONCAT(trace_span_, line)
+#define TESS_TRACE_SPAN(name) \
+  tesseract::TraceSpan TESS_TRACE_SPAN_VAR(__LINE__)(name)
+#endif  // TRACING_DISABLED
+
+#endif  // TESSERACT_CCUTIL_TRACING_H_
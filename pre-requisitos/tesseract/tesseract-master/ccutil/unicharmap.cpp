@@ -18,10 +18,175 @@
 ///////////////////////////////////////////////////////////////////////
 
 #include <assert.h>
+#include <string.h>
+#include "genericvector.h"
 #include "unichar.h"
 #include "host.h"
 #include "unicharmap.h"
 
+#ifdef HASHED_UNICHARMAP
+
+// Unichars that are a single byte, or the UTF-8 of a code point below
+// kNumTwoByteCodes, have their id directly in an array. The others, a
+// minority in all but CJK and Indic scripts, are kept in a hash table with
+// linear probing, whose slots hold the bytes of their unichar inline.
+const int kNumTwoByteCodes = 0x800;
+// The table is doubled when this fraction of its slots would be used.
+const double kMaxLoadFactor = 0.5;
+const int kMinTableSize = 64;
+
+struct UNICHARMAP::UNICHARMAP_TABLE {
+  struct Slot {
+    uinT32 hash;
+    UNICHAR_ID id;  // INVALID_UNICHAR_ID for an empty slot.
+    uinT8 length;
+    char repr[UNICHAR_LEN];
+  };
+
+  UNICHARMAP_TABLE() : num_used(0), max_length(0) {
+    for (int i = 0; i < 256; ++i) byte_ids[i] = INVALID_UNICHAR_ID;
+    for (int i = 0; i < kNumTwoByteCodes; ++i)
+      two_byte_ids[i] = INVALID_UNICHAR_ID;
+  }
+
+  // FNV-1a hash of the length bytes of repr.
+  static uinT32 Hash(const char* repr, int length) {
+    uinT32 hash = 2166136261u;
+    for (int i = 0; i < length; ++i) {
+      hash ^= static_cast<unsigned char>(repr[i]);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  // Returns the entry of the directly indexed arrays for the length bytes
+  // of repr, or NULL if they go in the hash table.
+  UNICHAR_ID* DirectId(const char* repr, int length) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(repr);
+    if (length == 1) return &byte_ids[bytes[0]];
+    if (length == 2 && bytes[0] >= 0xc2 && bytes[0] <= 0xdf &&
+        (bytes[1] & 0xc0) == 0x80) {
+      return &two_byte_ids[((bytes[0] & 0x1f) << 6) | (bytes[1] & 0x3f)];
+    }
+    return NULL;
+  }
+
+  // Returns the slot of the length bytes of repr, or the empty slot where
+  // they would go.
+  Slot* FindSlot(const char* repr, int length, uinT32 hash) {
+    int mask = slots.size() - 1;
+    for (int i = hash & mask;; i = (i + 1) & mask) {
+      Slot* slot = &slots[i];
+      if (slot->id == INVALID_UNICHAR_ID ||
+          (slot->hash == hash && slot->length == length &&
+           memcmp(slot->repr, repr, length) == 0)) {
+        return slot;
+      }
+    }
+  }
+
+  UNICHAR_ID Find(const char* repr, int length) {
+    UNICHAR_ID* direct = DirectId(repr, length);
+    if (direct != NULL) return *direct;
+    if (length > max_length) return INVALID_UNICHAR_ID;
+    return FindSlot(repr, length, Hash(repr, length))->id;
+  }
+
+  void Insert(const char* repr, int length, UNICHAR_ID id) {
+    UNICHAR_ID* direct = DirectId(repr, length);
+    if (direct != NULL) {
+      *direct = id;
+      return;
+    }
+    if (num_used + 1 > slots.size() * kMaxLoadFactor) {
+      Rehash(slots.empty() ? kMinTableSize : slots.size() * 2);
+    }
+    uinT32 hash = Hash(repr, length);
+    Slot* slot = FindSlot(repr, length, hash);
+    if (slot->id == INVALID_UNICHAR_ID) {
+      slot->hash = hash;
+      slot->length = length;
+      memcpy(slot->repr, repr, length);
+      ++num_used;
+      if (length > max_length) max_length = length;
+    }
+    slot->id = id;
+  }
+
+  void Rehash(int size) {
+    GenericVector<Slot> old_slots(slots);
+    Slot empty_slot;
+    empty_slot.id = INVALID_UNICHAR_ID;
+    slots.init_to_size(size, empty_slot);
+    for (int i = 0; i < old_slots.size(); ++i) {
+      const Slot& old_slot = old_slots[i];
+      if (old_slot.id != INVALID_UNICHAR_ID)
+        *FindSlot(old_slot.repr, old_slot.length, old_slot.hash) = old_slot;
+    }
+  }
+
+  UNICHAR_ID byte_ids[256];
+  UNICHAR_ID two_byte_ids[kNumTwoByteCodes];
+  GenericVector<Slot> slots;  // Size is a power of 2, or 0.
+  int num_used;
+  int max_length;  // Of the unichars in slots.
+};
+
+// Returns the number of bytes of unichar_repr before length or a '\0'.
+static int UnicharLength(const char* unichar_repr, int length) {
+  int i = 0;
+  while (i < length && unichar_repr[i] != '\0') ++i;
+  return i;
+}
+
+UNICHARMAP::UNICHARMAP() :
+table(NULL) {
+}
+
+UNICHARMAP::~UNICHARMAP() {
+  delete table;
+}
+
+UNICHAR_ID UNICHARMAP::unichar_to_id(const char* const unichar_repr,
+                                     int length) const {
+  assert(*unichar_repr != '\0');
+  assert(length > 0 && length <= UNICHAR_LEN);
+  if (table == NULL) return INVALID_UNICHAR_ID;
+  return table->Find(unichar_repr, UnicharLength(unichar_repr, length));
+}
+
+void UNICHARMAP::insert(const char* const unichar_repr, UNICHAR_ID id) {
+  int length = strlen(unichar_repr);
+  if (length == 0) return;
+  assert(length <= UNICHAR_LEN);
+  if (table == NULL) table = new UNICHARMAP_TABLE;
+  table->Insert(unichar_repr, length, id);
+}
+
+bool UNICHARMAP::contains(const char* const unichar_repr,
+                          int length) const {
+  if (unichar_repr == NULL || *unichar_repr == '\0') return false;
+  if (length <= 0 || length > UNICHAR_LEN) return false;
+  if (table == NULL) return false;
+  return table->Find(unichar_repr, UnicharLength(unichar_repr, length)) >= 0;
+}
+
+int UNICHARMAP::minmatch(const char* const unichar_repr) const {
+  if (table == NULL) return 0;
+  for (int length = 1;
+       length <= UNICHAR_LEN && unichar_repr[length - 1] != '\0'; ++length) {
+    if (table->Find(unichar_repr, length) >= 0) return length;
+  }
+  return 0;
+}
+
+void UNICHARMAP::clear() {
+  delete table;
+  table = NULL;
+}
+
+#else  // HASHED_UNICHARMAP
+
 UNICHARMAP::UNICHARMAP() :
 nodes(0) {
 }
@@ -134,3 +299,5 @@ UNICHARMAP::UNICHARMAP_NODE::~UNICHARMAP_NODE() {
     delete[] children;
   }
 }
+
+#endif  // HASHED_UNICHARMAP
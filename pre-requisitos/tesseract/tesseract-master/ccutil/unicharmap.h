@@ -56,6 +56,16 @@ class UNICHARMAP {
 
  private:
 
+#ifdef HASHED_UNICHARMAP
+  // With HASHED_UNICHARMAP defined at build time, the UNICHARMAP is a table
+  // indexed directly by the byte or code point of one byte unichars and two
+  // byte UTF-8 ones, up to U+07FF, completed by an open addressing hash
+  // table for the others. See unicharmap.cpp. The class keeps the size of
+  // the tree version.
+  struct UNICHARMAP_TABLE;
+
+  UNICHARMAP_TABLE* table;
+#else
   // The UNICHARMAP is represented as a tree whose nodes are of type
   // UNICHARMAP_NODE.
   struct UNICHARMAP_NODE {
@@ -68,6 +78,7 @@ class UNICHARMAP {
   };
 
   UNICHARMAP_NODE* nodes;
+#endif  // HASHED_UNICHARMAP
 };
 
 #endif  // TESSERACT_CCUTIL_UNICHARMAP_H_
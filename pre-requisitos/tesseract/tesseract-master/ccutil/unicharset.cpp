@@ -203,8 +203,25 @@ void UNICHARSET::reserve(int unichars_number) {
   }
 }
 
+// Returns true if the first length bytes of utf8_str, or up to its '\0',
+// are ASCII, which CleanupString leaves as they are.
+static bool IsAsciiString(const char* utf8_str, int length) {
+  for (int i = 0; i < length && utf8_str[i] != '\0'; ++i) {
+    if (static_cast<unsigned char>(utf8_str[i]) >= 0x80) return false;
+  }
+  return true;
+}
+
 UNICHAR_ID
 UNICHARSET::unichar_to_id(const char* const unichar_repr) const {
+  // Most lookups are of ASCII, which need no copy to be cleaned up.
+  int length = strlen(unichar_repr);
+  if (length > 0 && length <= UNICHAR_LEN &&
+      (old_style_included_ || IsAsciiString(unichar_repr, length))) {
+    return ids.contains(unichar_repr, length)
+               ? ids.unichar_to_id(unichar_repr, length)
+               : INVALID_UNICHAR_ID;
+  }
   string cleaned =
       old_style_included_ ? unichar_repr : CleanupString(unichar_repr);
   return ids.contains(cleaned.data(), cleaned.size())
@@ -215,6 +232,11 @@ UNICHARSET::unichar_to_id(const char* const unichar_repr) const {
 UNICHAR_ID UNICHARSET::unichar_to_id(const char* const unichar_repr,
                                      int length) const {
   assert(length > 0 && length <= UNICHAR_LEN);
+  if (old_style_included_ || IsAsciiString(unichar_repr, length)) {
+    return ids.contains(unichar_repr, length)
+               ? ids.unichar_to_id(unichar_repr, length)
+               : INVALID_UNICHAR_ID;
+  }
   string cleaned(unichar_repr, length);
   if (!old_style_included_) cleaned = CleanupString(unichar_repr, length);
   return ids.contains(cleaned.data(), cleaned.size())
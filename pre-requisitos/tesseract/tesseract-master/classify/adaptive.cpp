@@ -229,6 +229,7 @@ TEMP_CONFIG NewTempConfig(int MaxProtoId, int FontinfoId) {
   Config->ProtoVectorSize = WordsInVectorOfSize (NumProtos);
   zero_all_bits (Config->Protos, Config->ProtoVectorSize);
   Config->FontinfoId = FontinfoId;
+  Config->LastUsed = 0;
 
   return (Config);
 
@@ -418,6 +419,7 @@ PERM_CONFIG ReadPermConfig(TFile *fp) {
 TEMP_CONFIG ReadTempConfig(TFile *fp) {
   TEMP_CONFIG Config = (TEMP_CONFIG)malloc(sizeof(TEMP_CONFIG_STRUCT));
   fp->FRead(Config, sizeof(TEMP_CONFIG_STRUCT), 1);
+  Config->LastUsed = 0;
 
   Config->Protos = NewBitVector (Config->ProtoVectorSize * BITSINLONG);
   fp->FRead(Config->Protos, sizeof(uinT32), Config->ProtoVectorSize);
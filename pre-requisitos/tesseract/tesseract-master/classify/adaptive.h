@@ -43,6 +43,7 @@ typedef struct
   PROTO_ID MaxProtoId;
   BIT_VECTOR Protos;
   int FontinfoId;  // font information inferred from pre-trained templates
+  int LastUsed;    // Classify adaptation count when last adapted to
 } TEMP_CONFIG_STRUCT;
 typedef TEMP_CONFIG_STRUCT *TEMP_CONFIG;
 
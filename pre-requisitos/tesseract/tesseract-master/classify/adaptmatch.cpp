@@ -481,6 +481,13 @@ void Classify::EndAdaptiveClassifier() {
     BackupAdaptedTemplates = NULL;
   }
 
+  if (shared_data_ != NULL) {
+    GlobalClassifierCache()->Free(shared_data_);
+    shared_data_ = NULL;
+    PreTrainedTemplates = NULL;
+    NormProtos = NULL;
+    shape_table_ = NULL;
+  }
   if (PreTrainedTemplates != NULL) {
     free_int_templates(PreTrainedTemplates);
     PreTrainedTemplates = NULL;
@@ -534,23 +541,28 @@ void Classify::InitAdaptiveClassifier(TessdataManager* mgr) {
   // adaptive only.
   if (language_data_path_prefix.length() > 0 && mgr != nullptr) {
     TFile fp;
-    ASSERT_HOST(mgr->GetComponent(TESSDATA_INTTEMP, &fp));
-    PreTrainedTemplates = ReadIntTemplates(&fp);
-
-    if (mgr->GetComponent(TESSDATA_SHAPE_TABLE, &fp)) {
-      shape_table_ = new ShapeTable(unicharset);
-      if (!shape_table_->DeSerialize(&fp)) {
-        tprintf("Error loading shape table!\n");
-        delete shape_table_;
-        shape_table_ = NULL;
+    if (mgr->GetDataFileName().length() > 0) {
+      UseSharedClassifierData(mgr);
+    } else {
+      ASSERT_HOST(mgr->GetComponent(TESSDATA_INTTEMP, &fp));
+      PreTrainedTemplates = ReadIntTemplates(&fp);
+
+      if (mgr->GetComponent(TESSDATA_SHAPE_TABLE, &fp)) {
+        shape_table_ = new ShapeTable(unicharset);
+        if (!shape_table_->DeSerialize(&fp)) {
+          tprintf("Error loading shape table!\n");
+          delete shape_table_;
+          shape_table_ = NULL;
+        }
       }
+
+      ASSERT_HOST(mgr->GetComponent(TESSDATA_NORMPROTO, &fp));
+      NormProtos = ReadNormProtos(&fp);
     }
 
     ASSERT_HOST(mgr->GetComponent(TESSDATA_PFFMTABLE, &fp));
     ReadNewCutoffs(&fp, CharNormCutoffs);
 
-    ASSERT_HOST(mgr->GetComponent(TESSDATA_NORMPROTO, &fp));
-    NormProtos = ReadNormProtos(&fp);
     static_classifier_ = new TessClassifier(false, this);
   }
 
@@ -596,6 +608,89 @@ void Classify::InitAdaptiveClassifier(TessdataManager* mgr) {
   }
 }                                /* InitAdaptiveClassifier */
 
+// The pre-trained data of the static classifier. None of it changes during
+// recognition, so it is loaded once for each traineddata file and shared by
+// all the Classify instances that use the file, like the dawgs are.
+struct SharedClassifierData {
+  SharedClassifierData()
+    : templates(NULL), shape_table(NULL), norm_protos(NULL) {}
+  ~SharedClassifierData() {
+    if (templates != NULL) free_int_templates(templates);
+    delete shape_table;
+    if (norm_protos != NULL) FreeNormProtos(norm_protos);
+  }
+
+  INT_TEMPLATES templates;
+  // The shape table keeps a pointer to its unicharset, which must live as
+  // long as it does, whichever instance goes first.
+  UNICHARSET unicharset;
+  ShapeTable* shape_table;
+  NORM_PROTOS* norm_protos;
+};
+
+// Loads the SharedClassifierData for ObjectCache, and records whether it did,
+// as the instance that loads it reads its font tables at the same time.
+struct SharedClassifierLoader {
+  SharedClassifierLoader(Classify* classify, TessdataManager* mgr)
+    : classify_(classify), mgr_(mgr), loaded_(false) {}
+
+  SharedClassifierData* Load() {
+    loaded_ = true;
+    return classify_->LoadSharedClassifierData(mgr_);
+  }
+
+  Classify* classify_;
+  TessdataManager* mgr_;
+  bool loaded_;
+};
+
+ObjectCache<SharedClassifierData>* Classify::GlobalClassifierCache() {
+  // As Dict::GlobalDawgCache, outlives every instance.
+  static ObjectCache<SharedClassifierData> cache;
+  return &cache;
+}
+
+SharedClassifierData* Classify::LoadSharedClassifierData(
+    TessdataManager* mgr) {
+  SharedClassifierData* data = new SharedClassifierData;
+  TFile fp;
+  ASSERT_HOST(mgr->GetComponent(TESSDATA_INTTEMP, &fp));
+  data->templates = ReadIntTemplates(&fp);
+
+  if (mgr->GetComponent(TESSDATA_SHAPE_TABLE, &fp)) {
+    data->unicharset.CopyFrom(unicharset);
+    data->shape_table = new ShapeTable(data->unicharset);
+    if (!data->shape_table->DeSerialize(&fp)) {
+      tprintf("Error loading shape table!\n");
+      delete data->shape_table;
+      data->shape_table = NULL;
+    }
+  }
+
+  ASSERT_HOST(mgr->GetComponent(TESSDATA_NORMPROTO, &fp));
+  data->norm_protos = ReadNormProtos(&fp);
+  return data;
+}
+
+void Classify::UseSharedClassifierData(TessdataManager* mgr) {
+  STRING data_id = mgr->GetDataFileName();
+  data_id += kTessdataFileSuffixes[TESSDATA_INTTEMP];
+  SharedClassifierLoader loader(this, mgr);
+  shared_data_ = GlobalClassifierCache()->Get(
+      data_id, NewTessCallback(&loader, &SharedClassifierLoader::Load));
+  ASSERT_HOST(shared_data_ != NULL);
+  if (!loader.loaded_) {
+    // The font tables are read with the templates, and belong to each
+    // instance, so read them again and drop the copy of the templates.
+    TFile fp;
+    ASSERT_HOST(mgr->GetComponent(TESSDATA_INTTEMP, &fp));
+    free_int_templates(ReadIntTemplates(&fp));
+  }
+  PreTrainedTemplates = shared_data_->templates;
+  shape_table_ = shared_data_->shape_table;
+  NormProtos = shared_data_->norm_protos;
+}
+
 void Classify::ResetAdaptiveClassifierInternal() {
   if (classify_learning_debug_level > 0) {
     tprintf("Resetting adaptive classifier (NumAdaptationsFailed=%d)\n",
@@ -723,6 +818,7 @@ void Classify::InitAdaptedClass(TBLOB *Blob,
   }
 
   Config = NewTempConfig(NumFeatures - 1, FontinfoId);
+  Config->LastUsed = ++NumConfigAdaptations;
   TempConfigFor(Class, 0) = Config;
 
   /* this is a kludge to construct cutoffs for adapted templates */
@@ -925,6 +1021,7 @@ void Classify::AdaptToChar(TBLOB* Blob, CLASS_ID ClassId, int FontinfoId,
 
       TempConfig = TempConfigFor(Class, int_result.config);
       IncreaseConfidence(TempConfig);
+      TempConfig->LastUsed = ++NumConfigAdaptations;
       if (TempConfig->NumTimesSeen > Class->MaxNumTimesSeen) {
         Class->MaxNumTimesSeen = TempConfig->NumTimesSeen;
       }
@@ -1572,8 +1669,8 @@ void Classify::DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results) {
   INT_FX_RESULT_STRUCT fx_info;
   GenericVector<INT_FEATURE_STRUCT> bl_features;
   TrainingSample* sample =
-      BlobToTrainingSample(*Blob, classify_nonlinear_norm, &fx_info,
-                           &bl_features);
+      feature_cache_.BlobToTrainingSample(*Blob, classify_nonlinear_norm,
+                                          &fx_info, &bl_features);
   if (sample == NULL) return;
 
   if (AdaptedTemplates->NumPermClasses < matcher_permanent_classes_min ||
@@ -1802,6 +1899,7 @@ int Classify::MakeNewTemporaryConfig(ADAPT_TEMPLATES Templates,
   IClass = ClassForClassId(Templates->Templates, ClassId);
   Class = Templates->Class[ClassId];
 
+  if (classify_adapt_max_configs > 0) PruneAdaptedConfigs(Templates, ClassId);
   if (IClass->NumConfigs >= MAX_NUM_CONFIGS) {
     ++NumAdaptationsFailed;
     if (classify_learning_debug_level >= 1)
@@ -1839,6 +1937,7 @@ int Classify::MakeNewTemporaryConfig(ADAPT_TEMPLATES Templates,
   ConfigId = AddIntConfig(IClass);
   ConvertConfig(TempProtoMask, ConfigId, IClass);
   Config = NewTempConfig(MaxProtoId, FontinfoId);
+  Config->LastUsed = ++NumConfigAdaptations;
   TempConfigFor(Class, ConfigId) = Config;
   copy_all_bits(TempProtoMask, Config->Protos, Config->ProtoVectorSize);
 
@@ -1948,6 +2047,73 @@ PROTO_ID Classify::MakeNewTempProtos(FEATURE_SET Features,
   return IClass->NumProtos - 1;
 }                              /* MakeNewTempProtos */
 
+// The temporary configs are the candidates, as the permanent ones are the
+// reliable result of several adaptations. With no temporary config to
+// remove, MakeNewTemporaryConfig fails, as it would without a limit.
+void Classify::PruneAdaptedConfigs(ADAPT_TEMPLATES Templates,
+                                   CLASS_ID ClassId) {
+  INT_CLASS IClass = ClassForClassId(Templates->Templates, ClassId);
+  bool class_full = IClass->NumConfigs >= MAX_NUM_CONFIGS;
+  int num_configs = 0;
+  CLASS_ID oldest_class = NO_CLASS;
+  int oldest_config = -1;
+  int oldest_use = 0;
+  for (int c = 0; c < Templates->Templates->NumClasses; ++c) {
+    INT_CLASS int_class = ClassForClassId(Templates->Templates, c);
+    ADAPT_CLASS adapt_class = Templates->Class[c];
+    if (int_class == NULL || adapt_class == NULL) continue;
+    num_configs += int_class->NumConfigs;
+    if (class_full && c != ClassId) continue;
+    for (int cfg = 0; cfg < int_class->NumConfigs; ++cfg) {
+      if (ConfigIsPermanent(adapt_class, cfg)) continue;
+      TEMP_CONFIG config = TempConfigFor(adapt_class, cfg);
+      if (oldest_config < 0 || config->LastUsed < oldest_use) {
+        oldest_class = c;
+        oldest_config = cfg;
+        oldest_use = config->LastUsed;
+      }
+    }
+  }
+  if (!class_full && num_configs < classify_adapt_max_configs) return;
+  if (oldest_config < 0) return;
+  if (classify_learning_debug_level >= 1) {
+    cprintf("Pruning temp config %d of class %s, last adapted at %d.\n",
+            oldest_config, unicharset.id_to_unichar(oldest_class),
+            oldest_use);
+  }
+  RemoveTempConfig(Templates, oldest_class, oldest_config);
+}
+
+// The configs of a class are numbered without gaps, so the last one gets
+// the number of the one removed, in the config bits of the protos too.
+void Classify::RemoveTempConfig(ADAPT_TEMPLATES Templates, CLASS_ID ClassId,
+                                int ConfigId) {
+  INT_CLASS IClass = ClassForClassId(Templates->Templates, ClassId);
+  ADAPT_CLASS Class = Templates->Class[ClassId];
+  ASSERT_HOST(!ConfigIsPermanent(Class, ConfigId));
+  FreeTempConfig(TempConfigFor(Class, ConfigId));
+  int last = IClass->NumConfigs - 1;
+  for (int p = 0; p < IClass->NumProtos; ++p) {
+    INT_PROTO proto = ProtoForProtoId(IClass, p);
+    reset_bit(proto->Configs, ConfigId);
+    if (last != ConfigId && test_bit(proto->Configs, last)) {
+      SET_BIT(proto->Configs, ConfigId);
+      reset_bit(proto->Configs, last);
+    }
+  }
+  if (last != ConfigId) {
+    Class->Config[ConfigId] = Class->Config[last];
+    IClass->ConfigLengths[ConfigId] = IClass->ConfigLengths[last];
+    if (ConfigIsPermanent(Class, last)) {
+      MakeConfigPermanent(Class, ConfigId);
+      reset_bit(Class->PermConfigs, last);
+    }
+  }
+  TempConfigFor(Class, last) = NULL;
+  IClass->ConfigLengths[last] = 0;
+  IClass->NumConfigs = last;
+}
+
 /*---------------------------------------------------------------------------*/
 /**
  *
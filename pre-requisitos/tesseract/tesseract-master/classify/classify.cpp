@@ -124,6 +124,10 @@ Classify::Classify()
       INT_MEMBER(classify_adapt_feature_threshold, 230,
                  "Threshold for good features during adaptive 0-255",
                  this->params()),
+      INT_MEMBER(classify_adapt_max_configs, 0,
+                 "Max configs in the adapted templates, above which the least"
+                 " recently adapted temporary ones are pruned (0 = no limit)",
+                 this->params()),
       BOOL_MEMBER(disable_character_fragments, TRUE,
                   "Do not include character fragments in the"
                   " results of the classifier",
@@ -178,8 +182,10 @@ Classify::Classify()
   AllConfigsOff = NULL;
   TempProtoMask = NULL;
   NormProtos = NULL;
+  shared_data_ = NULL;
 
   NumAdaptationsFailed = 0;
+  NumConfigAdaptations = 0;
 
   learn_debug_win_ = NULL;
   learn_fragmented_word_debug_win_ = NULL;
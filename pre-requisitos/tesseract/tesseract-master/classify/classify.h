@@ -29,6 +29,7 @@
 #include "intfx.h"
 #include "intmatcher.h"
 #include "normalis.h"
+#include "object_cache.h"
 #include "ratngs.h"
 #include "ocrfeatures.h"
 #include "unicity_table.h"
@@ -47,6 +48,7 @@ namespace tesseract {
 class ShapeClassifier;
 struct ShapeRating;
 class ShapeTable;
+struct SharedClassifierData;
 struct UnicharRating;
 
 // How segmented is a blob. In this enum, character refers to a classifiable
@@ -107,6 +109,13 @@ class Classify : public CCStruct {
   void PrintAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates);
   void WriteAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates);
   ADAPT_TEMPLATES ReadAdaptedTemplates(TFile* File);
+  // Points PreTrainedTemplates, NormProtos and shape_table_ at those of the
+  // traineddata of mgr that all the instances of the process share, loading
+  // them if no other instance did.
+  void UseSharedClassifierData(TessdataManager* mgr);
+  // Loads the data for UseSharedClassifierData.
+  SharedClassifierData* LoadSharedClassifierData(TessdataManager* mgr);
+  static ObjectCache<SharedClassifierData>* GlobalClassifierCache();
   /* normmatch.cpp ************************************************************/
   FLOAT32 ComputeNormMatch(CLASS_ID ClassId,
                            const FEATURE_STRUCT& feature, BOOL8 DebugMatch);
@@ -211,6 +220,15 @@ class Classify : public CCStruct {
                      CLASS_ID ClassId,
                      int ConfigId,
                      TBLOB *Blob);
+  // Makes room for a new config of ClassId in Templates when
+  // classify_adapt_max_configs is set, by removing the temporary config
+  // adapted to least recently, from ClassId if it has no room left, or else
+  // from any class once the templates hold classify_adapt_max_configs.
+  void PruneAdaptedConfigs(ADAPT_TEMPLATES Templates, CLASS_ID ClassId);
+  // Removes the temporary config ConfigId from class ClassId of Templates,
+  // moving the last config of the class into its place.
+  void RemoveTempConfig(ADAPT_TEMPLATES Templates, CLASS_ID ClassId,
+                        int ConfigId);
   void PrintAdaptiveMatchResults(const ADAPT_RESULTS& results);
   void RemoveExtraPuncs(ADAPT_RESULTS *Results);
   void RemoveBadMatches(ADAPT_RESULTS *Results);
@@ -444,6 +462,9 @@ class Classify : public CCStruct {
             "Threshold for good protos during adaptive 0-255");
   INT_VAR_H(classify_adapt_feature_threshold, 230,
             "Threshold for good features during adaptive 0-255");
+  INT_VAR_H(classify_adapt_max_configs, 0,
+            "Max configs in the adapted templates, above which the least"
+            " recently adapted temporary ones are pruned (0 = no limit)");
   BOOL_VAR_H(disable_character_fragments, TRUE,
              "Do not include character fragments in the"
              " results of the classifier");
@@ -483,6 +504,9 @@ class Classify : public CCStruct {
   bool EnableLearning;
   /* normmatch.cpp */
   NORM_PROTOS *NormProtos;
+  // If not NULL, PreTrainedTemplates, NormProtos and shape_table_ belong to
+  // it, shared with the other instances that loaded the same traineddata.
+  SharedClassifierData* shared_data_;
   /* font detection ***********************************************************/
   UnicityTable<FontInfo> fontinfo_table_;
   // Without shape training, each class_id, config pair represents a single
@@ -509,6 +533,8 @@ class Classify : public CCStruct {
   // mean an index to the shape_table_ and the choices returned are *all* the
   // shape_table_ entries at that index.
   ShapeTable* shape_table_;
+  // Features of the blobs classified recently by DoAdaptiveMatch.
+  BlobFeatureCache feature_cache_;
 
  private:
   Dict dict_;
@@ -517,6 +543,9 @@ class Classify : public CCStruct {
 
   /* variables used to hold performance statistics */
   int NumAdaptationsFailed;
+  // Number of adaptations to temporary configs so far, which orders them
+  // by their last use for PruneAdaptedConfigs.
+  int NumConfigAdaptations;
 
   // Training data gathered here for all the images in a document.
   STRING tr_file_data_;
@@ -78,18 +78,17 @@ namespace tesseract {
 // TODO(rays) Make BlobToTrainingSample a member of Classify now that
 // the FlexFx and FeatureDescription code have been removed and LearnBlob
 // is now a member of Classify.
-TrainingSample* BlobToTrainingSample(
-    const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
-    GenericVector<INT_FEATURE_STRUCT>* bl_features) {
-  GenericVector<INT_FEATURE_STRUCT> cn_features;
-  Classify::ExtractFeatures(blob, nonlinear_norm, bl_features,
-                            &cn_features, fx_info, NULL);
+// Makes the TrainingSample of BlobToTrainingSample from the extracted
+// features.
+static TrainingSample* FeaturesToTrainingSample(
+    const TBLOB& blob, const INT_FX_RESULT_STRUCT& fx_info,
+    const GenericVector<INT_FEATURE_STRUCT>& cn_features) {
   // TODO(rays) Use blob->PreciseBoundingBox() instead.
   TBOX box = blob.bounding_box();
   TrainingSample* sample = NULL;
-  int num_features = fx_info->NumCN;
+  int num_features = fx_info.NumCN;
   if (num_features > 0) {
-    sample = TrainingSample::CopyFromFeatures(*fx_info, box, &cn_features[0],
+    sample = TrainingSample::CopyFromFeatures(fx_info, box, &cn_features[0],
                                               num_features);
   }
   if (sample != NULL) {
@@ -108,6 +107,113 @@ TrainingSample* BlobToTrainingSample(
   return sample;
 }
 
+TrainingSample* BlobToTrainingSample(
+    const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
+    GenericVector<INT_FEATURE_STRUCT>* bl_features) {
+  GenericVector<INT_FEATURE_STRUCT> cn_features;
+  Classify::ExtractFeatures(blob, nonlinear_norm, bl_features,
+                            &cn_features, fx_info, NULL);
+  return FeaturesToTrainingSample(blob, *fx_info, cn_features);
+}
+
+// Number of blobs kept by a BlobFeatureCache, enough for the blobs of a
+// dense page, at a few hundred bytes each.
+const int kBlobFeatureCacheSize = 8192;
+
+struct BlobFeatureCache::Entry {
+  Entry() : used(false), key(0) {}
+
+  bool used;
+  uinT64 key;
+  INT_FX_RESULT_STRUCT fx_info;
+  GenericVector<INT_FEATURE_STRUCT> bl_features;
+  GenericVector<INT_FEATURE_STRUCT> cn_features;
+};
+
+// Adds value to the FNV-1a hash.
+static void HashValue(uinT64 value, uinT64* hash) {
+  for (int i = 0; i < 8; ++i) {
+    *hash ^= (value >> (i * 8)) & 0xff;
+    *hash *= 0x100000001b3ULL;
+  }
+}
+
+static void HashPoint(const FCOORD& pt, uinT64* hash) {
+  float coords[2] = {pt.x(), pt.y()};
+  uinT32 bits[2];
+  memcpy(bits, coords, sizeof(bits));
+  HashValue((static_cast<uinT64>(bits[0]) << 32) | bits[1], hash);
+}
+
+// Returns the hash of everything ExtractFeatures reads from the blob.
+static uinT64 BlobFeatureKey(const TBLOB& blob, bool nonlinear_norm) {
+  uinT64 hash = 0xcbf29ce484222325ULL;
+  HashValue(nonlinear_norm, &hash);
+  for (TESSLINE* ol = blob.outlines; ol != NULL; ol = ol->next) {
+    const EDGEPT* pt = ol->loop;
+    if (pt == NULL) continue;
+    do {
+      HashValue((static_cast<uinT64>(static_cast<uinT16>(pt->pos.x)) << 48) |
+                (static_cast<uinT64>(static_cast<uinT16>(pt->pos.y)) << 32) |
+                pt->IsHidden(), &hash);
+      const C_OUTLINE* outline = pt->src_outline;
+      if (outline != NULL) {
+        // The steps are identified by their outline, which a later one may
+        // reuse the memory of, so its start and length are added as well.
+        HashValue(reinterpret_cast<uintptr_t>(outline), &hash);
+        HashValue((static_cast<uinT64>(static_cast<uinT16>(
+                      outline->start_pos().x())) << 48) |
+                  (static_cast<uinT64>(static_cast<uinT16>(
+                      outline->start_pos().y())) << 32) |
+                  static_cast<uinT32>(outline->pathlength()), &hash);
+        HashValue((static_cast<uinT64>(pt->start_step) << 32) |
+                  static_cast<uinT32>(pt->step_count), &hash);
+      }
+      pt = pt->next;
+    } while (pt != ol->loop);
+  }
+  // Three points fix the affine mapping of the denorm to the image.
+  const FCOORD probes[] = {FCOORD(0.0f, 0.0f), FCOORD(256.0f, 0.0f),
+                           FCOORD(0.0f, 256.0f)};
+  for (int i = 0; i < 3; ++i) {
+    FCOORD original;
+    blob.denorm().DenormTransform(NULL, probes[i], &original);
+    HashPoint(original, &hash);
+  }
+  return hash;
+}
+
+BlobFeatureCache::BlobFeatureCache() : entries_(NULL) {}
+
+BlobFeatureCache::~BlobFeatureCache() {
+  Clear();
+}
+
+TrainingSample* BlobFeatureCache::BlobToTrainingSample(
+    const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
+    GenericVector<INT_FEATURE_STRUCT>* bl_features) {
+  if (entries_ == NULL)
+    entries_ = new Entry[kBlobFeatureCacheSize];
+  uinT64 key = BlobFeatureKey(blob, nonlinear_norm);
+  Entry* entry = &entries_[key % kBlobFeatureCacheSize];
+  if (!entry->used || entry->key != key) {
+    entry->used = true;
+    entry->key = key;
+    entry->bl_features.truncate(0);
+    entry->cn_features.truncate(0);
+    Classify::ExtractFeatures(blob, nonlinear_norm, &entry->bl_features,
+                              &entry->cn_features, &entry->fx_info, NULL);
+  }
+  *fx_info = entry->fx_info;
+  *bl_features = entry->bl_features;
+  return FeaturesToTrainingSample(blob, *fx_info, entry->cn_features);
+}
+
+void BlobFeatureCache::Clear() {
+  delete [] entries_;
+  entries_ = NULL;
+}
+
 // Computes the DENORMS for bl(baseline) and cn(character) normalization
 // during feature extraction. The input denorm describes the current state
 // of the blob, which is usually a baseline-normalized word.
@@ -63,6 +63,31 @@ namespace tesseract {
   TrainingSample* BlobToTrainingSample(
       const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
       GenericVector<INT_FEATURE_STRUCT>* bl_features);
+
+  // Keeps the features of the blobs classified recently, so that classifying
+  // an identical blob again, as pass 2 does for every word that pass 1 didn't
+  // get right, doesn't walk its outline steps again. A blob is identified by
+  // a hash of its polygon, the outline steps it came from and the mapping of
+  // its denorm to the image, so that the features of a hit are those that
+  // extraction would give. The table is direct mapped, so a new blob simply
+  // replaces the one in its slot.
+  class BlobFeatureCache {
+   public:
+    BlobFeatureCache();
+    ~BlobFeatureCache();
+
+    // As the global BlobToTrainingSample, but from the cache if possible.
+    TrainingSample* BlobToTrainingSample(
+        const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
+        GenericVector<INT_FEATURE_STRUCT>* bl_features);
+    // Frees all the kept features.
+    void Clear();
+
+   private:
+    struct Entry;
+
+    Entry* entries_;  // Allocated on first use.
+  };
 }
 
 // Deprecated! Prefer tesseract::Classify::ExtractFeatures instead.
@@ -36,8 +36,13 @@
 #include "helpers.h"
 #include "classify.h"
 #include "shapetable.h"
+#include "intmatcheravx2.h"
+#include "intmatchersse.h"
+#include "simddetect.h"
 #include <math.h>
 
+using tesseract::ProtoDistancesAVX2;
+using tesseract::ProtoDistancesSSE;
 using tesseract::ScoredFont;
 using tesseract::UnicharRating;
 
@@ -49,6 +54,8 @@ using tesseract::UnicharRating;
 // 8 bit evidence value in the secondary matcher. (See IntMatcher::Init).
 const float IntegerMatcher::kSEExponentialMultiplier = 0.0;
 const float IntegerMatcher::kSimilarityCenter = 0.0075;
+// Protos in the widest register of the SIMD distance kernels.
+const int kMaxProtoLanes = 8;
 
 #define offset_table_entries                                                   \
   255, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4, 0, 1, 0, 2, 0, 1, 0, 3, \
@@ -141,6 +148,10 @@ class ClassPruner {
                      int num_features, const INT_FEATURE_STRUCT* features) {
     num_features_ = num_features;
     int num_pruners = int_templates->NumClassPruners;
+    if (SIMDDetect::IsAVX2Available() || SIMDDetect::IsSSEAvailable()) {
+      ComputeScoresSIMD(int_templates, num_features, features);
+      return;
+    }
     for (int f = 0; f < num_features; ++f) {
       const INT_FEATURE_STRUCT* feature = &features[f];
       // Quantize the feature to NUM_CP_BUCKETS*NUM_CP_BUCKETS*NUM_CP_BUCKETS.
@@ -203,6 +214,36 @@ class ClassPruner {
     }
   }
 
+  /// Computes the same scores as ComputeScores, with all the classes of a
+  /// pruner summed at once in SIMD registers over all the features.
+  void ComputeScoresSIMD(const INT_TEMPLATES_STRUCT* int_templates,
+                         int num_features, const INT_FEATURE_STRUCT* features) {
+    static_assert(WERDS_PER_CP_VECTOR == 2 && NUM_BITS_PER_CLASS == 2,
+                  "The SIMD class pruner needs 32 classes of 2 bits");
+    if (num_features == 0 || int_templates->NumClassPruners == 0) return;
+    // Index in each pruner of the weights of each quantized feature.
+    GenericVector<int> offsets;
+    offsets.reserve(num_features);
+    for (int f = 0; f < num_features; ++f) {
+      const INT_FEATURE_STRUCT* feature = &features[f];
+      int x = feature->X * NUM_CP_BUCKETS >> 8;
+      int y = feature->Y * NUM_CP_BUCKETS >> 8;
+      int theta = feature->Theta * NUM_CP_BUCKETS >> 8;
+      offsets.push_back(((x * NUM_CP_BUCKETS + y) * NUM_CP_BUCKETS + theta) *
+                        WERDS_PER_CP_VECTOR);
+    }
+    GenericVector<const uint32_t*> pruners;
+    for (int p = 0; p < int_templates->NumClassPruners; ++p)
+      pruners.push_back(&int_templates->ClassPruners[p]->p[0][0][0][0]);
+    if (SIMDDetect::IsAVX2Available()) {
+      ClassPrunerCountsAVX2(&pruners[0], pruners.size(), &offsets[0],
+                            num_features, class_count_);
+    } else {
+      ClassPrunerCountsSSE(&pruners[0], pruners.size(), &offsets[0],
+                           num_features, class_count_);
+    }
+  }
+
   /// Adjusts the scores according to the number of expected features. Used
   /// in lieu of a constant bias, this penalizes classes that expect more
   /// features than there are present. Thus an actual c will score higher for c
@@ -800,6 +841,13 @@ int IntegerMatcher::UpdateTablesForFeature(
   inT32 M3;
   inT32 A3;
   uinT32 A4;
+  // The protos that pass the pruning, their A, B, C and Angle bytes, and their
+  // distances to the feature. The SIMD kernels round the count up to a whole
+  // register.
+  int proto_ids[MAX_NUM_PROTOS];
+  uinT32 packed_protos[MAX_NUM_PROTOS + kMaxProtoLanes];
+  uinT32 distances[MAX_NUM_PROTOS + kMaxProtoLanes];
+  int num_protos = 0;
 
   tables->ClearFeatureEvidence(ClassTemplate);
 
@@ -834,69 +882,98 @@ int IntegerMatcher::UpdateTablesForFeature(
           proto_offset = offset_table[proto_byte] + proto_word_offset;
           proto_byte = next_table[proto_byte];
           Proto = &(ProtoSet->Protos[ProtoNum + proto_offset]);
-          ConfigWord = Proto->Configs[0];
-          A3 = (((Proto->A * (Feature->X - 128)) << 1)
-            - (Proto->B * (Feature->Y - 128)) + (Proto->C << 9));
-          M3 =
-            (((inT8) (Feature->Theta - Proto->Angle)) * kIntThetaFudge) << 1;
-
-          if (A3 < 0)
-            A3 = ~A3;
-          if (M3 < 0)
-            M3 = ~M3;
-          A3 >>= mult_trunc_shift_bits_;
-          M3 >>= mult_trunc_shift_bits_;
-          if (static_cast<uint32_t>(A3) > evidence_mult_mask_)
-            A3 = evidence_mult_mask_;
-          if (static_cast<uint32_t>(M3) > evidence_mult_mask_)
-            M3 = evidence_mult_mask_;
-
-          A4 = (A3 * A3) + (M3 * M3);
-          A4 >>= table_trunc_shift_bits_;
-          if (A4 > evidence_table_mask_)
-            Evidence = 0;
-          else
-            Evidence = similarity_evidence_table_[A4];
-
-          if (PrintFeatureMatchesOn (Debug))
-            IMDebugConfiguration (FeatureNum,
-              ActualProtoNum + proto_offset,
-              Evidence, ConfigMask, ConfigWord);
-
-          ConfigWord &= *ConfigMask;
-
-          UINT8Pointer = tables->feature_evidence_ - 8;
-          config_byte = 0;
-          while (ConfigWord != 0 || config_byte != 0) {
-            while (config_byte == 0) {
-              config_byte = ConfigWord & 0xff;
-              ConfigWord >>= 8;
-              UINT8Pointer += 8;
-            }
-            config_offset = offset_table[config_byte];
-            config_byte = next_table[config_byte];
-            if (Evidence > UINT8Pointer[config_offset])
-              UINT8Pointer[config_offset] = Evidence;
-          }
-
-          UINT8Pointer =
-            &(tables->proto_evidence_[ActualProtoNum + proto_offset][0]);
-          for (ProtoIndex =
-            ClassTemplate->ProtoLengths[ActualProtoNum + proto_offset];
-          ProtoIndex > 0; ProtoIndex--, UINT8Pointer++) {
-            if (Evidence > *UINT8Pointer) {
-              Temp = *UINT8Pointer;
-              *UINT8Pointer = Evidence;
-              Evidence = Temp;
-            }
-            else if (Evidence == 0)
-              break;
-          }
+          proto_ids[num_protos] = ActualProtoNum + proto_offset;
+          memcpy(&packed_protos[num_protos], Proto, sizeof(packed_protos[0]));
+          ++num_protos;
         }
       }
     }
   }
 
+  /* Compute the distance of the feature to all the unpruned protos */
+  if (num_protos > 0 &&
+      (SIMDDetect::IsAVX2Available() || SIMDDetect::IsSSEAvailable())) {
+    memset(&packed_protos[num_protos], 0,
+           kMaxProtoLanes * sizeof(packed_protos[0]));
+    if (SIMDDetect::IsAVX2Available()) {
+      ProtoDistancesAVX2(packed_protos, num_protos, Feature->X, Feature->Y,
+                         Feature->Theta, kIntThetaFudge, mult_trunc_shift_bits_,
+                         evidence_mult_mask_, table_trunc_shift_bits_,
+                         evidence_table_mask_, distances);
+    } else {
+      ProtoDistancesSSE(packed_protos, num_protos, Feature->X, Feature->Y,
+                        Feature->Theta, kIntThetaFudge, mult_trunc_shift_bits_,
+                        evidence_mult_mask_, table_trunc_shift_bits_,
+                        evidence_table_mask_, distances);
+    }
+  } else {
+    for (int p = 0; p < num_protos; ++p) {
+      Proto = &(ClassTemplate->ProtoSets[proto_ids[p] / PROTOS_PER_PROTO_SET]
+                    ->Protos[proto_ids[p] % PROTOS_PER_PROTO_SET]);
+      A3 = (((Proto->A * (Feature->X - 128)) << 1)
+        - (Proto->B * (Feature->Y - 128)) + (Proto->C << 9));
+      M3 =
+        (((inT8) (Feature->Theta - Proto->Angle)) * kIntThetaFudge) << 1;
+
+      if (A3 < 0)
+        A3 = ~A3;
+      if (M3 < 0)
+        M3 = ~M3;
+      A3 >>= mult_trunc_shift_bits_;
+      M3 >>= mult_trunc_shift_bits_;
+      if (static_cast<uint32_t>(A3) > evidence_mult_mask_)
+        A3 = evidence_mult_mask_;
+      if (static_cast<uint32_t>(M3) > evidence_mult_mask_)
+        M3 = evidence_mult_mask_;
+
+      A4 = (A3 * A3) + (M3 * M3);
+      A4 >>= table_trunc_shift_bits_;
+      distances[p] = A4;
+    }
+  }
+
+  for (int p = 0; p < num_protos; ++p) {
+    Proto = &(ClassTemplate->ProtoSets[proto_ids[p] / PROTOS_PER_PROTO_SET]
+                  ->Protos[proto_ids[p] % PROTOS_PER_PROTO_SET]);
+    ConfigWord = Proto->Configs[0];
+    if (distances[p] > evidence_table_mask_)
+      Evidence = 0;
+    else
+      Evidence = similarity_evidence_table_[distances[p]];
+
+    if (PrintFeatureMatchesOn (Debug))
+      IMDebugConfiguration (FeatureNum, proto_ids[p],
+        Evidence, ConfigMask, ConfigWord);
+
+    ConfigWord &= *ConfigMask;
+
+    UINT8Pointer = tables->feature_evidence_ - 8;
+    config_byte = 0;
+    while (ConfigWord != 0 || config_byte != 0) {
+      while (config_byte == 0) {
+        config_byte = ConfigWord & 0xff;
+        ConfigWord >>= 8;
+        UINT8Pointer += 8;
+      }
+      config_offset = offset_table[config_byte];
+      config_byte = next_table[config_byte];
+      if (Evidence > UINT8Pointer[config_offset])
+        UINT8Pointer[config_offset] = Evidence;
+    }
+
+    UINT8Pointer = &(tables->proto_evidence_[proto_ids[p]][0]);
+    for (ProtoIndex = ClassTemplate->ProtoLengths[proto_ids[p]];
+    ProtoIndex > 0; ProtoIndex--, UINT8Pointer++) {
+      if (Evidence > *UINT8Pointer) {
+        Temp = *UINT8Pointer;
+        *UINT8Pointer = Evidence;
+        Evidence = Temp;
+      }
+      else if (Evidence == 0)
+        break;
+    }
+  }
+
   if (PrintFeatureMatchesOn(Debug)) {
     IMDebugConfigurationSum(FeatureNum, tables->feature_evidence_,
                             ClassTemplate->NumConfigs);
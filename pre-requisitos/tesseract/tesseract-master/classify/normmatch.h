@@ -34,4 +34,11 @@ extern double_VAR_H(classify_norm_adj_midpoint, 32.0,
                     "Norm adjust midpoint ...");
 extern double_VAR_H(classify_norm_adj_curl, 2.0, "Norm adjust curl ...");
 
+struct NORM_PROTOS;
+
+/**----------------------------------------------------------------------------
+          Public Function Prototypes
+----------------------------------------------------------------------------**/
+void FreeNormProtos(NORM_PROTOS *norm_protos);
+
 #endif
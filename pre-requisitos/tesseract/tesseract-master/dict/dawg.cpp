@@ -38,6 +38,10 @@
 #include "helpers.h"
 #include "strngs.h"
 #include "tesscallback.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "tprintf.h"
 
 /*----------------------------------------------------------------------
@@ -190,7 +194,14 @@ void Dawg::init(int unicharset_size) {
          F u n c t i o n s   f o r   S q u i s h e d    D a w g
 ----------------------------------------------------------------------*/
 
-SquishedDawg::~SquishedDawg() { delete[] edges_; }
+// Label of the empty edges in the label index.
+const uinT16 kNoLabel = MAX_UINT16;
+// The number of labels that indexed_edge_char_of compares at a time.
+const int kLabelLanes = 8;
+
+SquishedDawg::~SquishedDawg() {
+  if (!edges_are_mapped_) delete[] edges_;
+}
 
 EDGE_REF SquishedDawg::edge_char_of(NODE_REF node,
                                     UNICHAR_ID unichar_id,
@@ -212,6 +223,8 @@ EDGE_REF SquishedDawg::edge_char_of(NODE_REF node,
         end = edge - 1;
       }
     }
+  } else if (!labels_.empty()) {
+    return indexed_edge_char_of(node, unichar_id, word_end);
   } else {  // linear search
     if (edge != NO_EDGE && edge_occupied(edge)) {
       do {
@@ -224,6 +237,60 @@ EDGE_REF SquishedDawg::edge_char_of(NODE_REF node,
   return (NO_EDGE);  // not found
 }
 
+void SquishedDawg::BuildLabelIndex() {
+  labels_.init_to_size(num_edges_ + kLabelLanes, kNoLabel);
+  run_lengths_.init_to_size(num_edges_, 0);
+  int run_length = 0;
+  for (EDGE_REF edge = num_edges_ - 1; edge >= 0; --edge) {
+    // Like the linear search, a node runs on over empty edges until an edge
+    // marked as its last.
+    if (last_edge(edge)) run_length = 0;
+    UNICHAR_ID unichar_id =
+        edge_occupied(edge) ? unichar_id_from_edge_rec(edges_[edge]) : 0;
+    if (++run_length > MAX_UINT16 || unichar_id >= kNoLabel) {
+      labels_.clear();
+      run_lengths_.clear();
+      return;
+    }
+    run_lengths_[edge] = run_length;
+    if (edge_occupied(edge)) labels_[edge] = unichar_id;
+  }
+  if (debug_level_) {
+    tprintf("Built label index of dawg %d of %s with %d edges\n", type_,
+            lang_.string(), num_edges_);
+  }
+}
+
+EDGE_REF SquishedDawg::indexed_edge_char_of(NODE_REF node,
+                                            UNICHAR_ID unichar_id,
+                                            bool word_end) const {
+  if (node == NO_EDGE || labels_[node] == kNoLabel) return NO_EDGE;
+  if (unichar_id < 0 || unichar_id >= kNoLabel) return NO_EDGE;
+  const uinT16* labels = &labels_[0];
+  EDGE_REF end = node + run_lengths_[node];
+  EDGE_REF edge = node;
+#ifdef __SSE2__
+  __m128i letter = _mm_set1_epi16(static_cast<short>(unichar_id));
+  for (; edge < end; edge += kLabelLanes) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(labels + edge));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(block, letter)) == 0) continue;
+    for (int i = 0; i < kLabelLanes && edge + i < end; ++i) {
+      if (labels[edge + i] == unichar_id &&
+          (!word_end || end_of_word_from_edge_rec(edges_[edge + i])))
+        return edge + i;
+    }
+  }
+#else
+  for (; edge < end; ++edge) {
+    if (labels[edge] == unichar_id &&
+        (!word_end || end_of_word_from_edge_rec(edges_[edge])))
+      return edge;
+  }
+#endif  // __SSE2__
+  return NO_EDGE;
+}
+
 inT32 SquishedDawg::num_forward_edges(NODE_REF node) const {
   EDGE_REF   edge = node;
   inT32        num  = 0;
@@ -327,10 +394,18 @@ bool SquishedDawg::read_squished_dawg(TFile *file) {
   ASSERT_HOST(num_edges_ > 0);  // DAWG should not be empty
   Dawg::init(unicharset_size);
 
-  edges_ = new EDGE_RECORD[num_edges_];
-  if (file->FReadEndian(&edges_[0], sizeof(edges_[0]), num_edges_) !=
-      num_edges_)
-    return false;
+  // Use the edges in place if they are in a read-only mapping of the
+  // traineddata (see TessdataManager::MapFile), else take a private copy.
+  const char *view = file->ReadView(sizeof(EDGE_RECORD), num_edges_);
+  if (view != nullptr) {
+    edges_ = reinterpret_cast<EDGE_ARRAY>(const_cast<char *>(view));
+    edges_are_mapped_ = true;
+  } else {
+    edges_ = new EDGE_RECORD[num_edges_];
+    if (file->FReadEndian(&edges_[0], sizeof(edges_[0]), num_edges_) !=
+        num_edges_)
+      return false;
+  }
   if (debug_level_ > 2) {
     tprintf("type: %d lang: %s perm: %d unicharset_size: %d num_edges: %d\n",
             type_, lang_.string(), perm_, unicharset_size_, num_edges_);
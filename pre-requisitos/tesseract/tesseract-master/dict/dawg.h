@@ -33,6 +33,7 @@
 
 #include <memory>
 #include "elst.h"
+#include "genericvector.h"
 #include "params.h"
 #include "ratngs.h"
 #include "tesscallback.h"
@@ -414,10 +415,12 @@ class SquishedDawg : public Dawg {
  public:
   SquishedDawg(DawgType type, const STRING &lang, PermuterType perm,
                int debug_level)
-      : Dawg(type, lang, perm, debug_level) {}
+      : Dawg(type, lang, perm, debug_level), edges_(nullptr),
+        edges_are_mapped_(false) {}
   SquishedDawg(const char *filename, DawgType type, const STRING &lang,
                PermuterType perm, int debug_level)
-      : Dawg(type, lang, perm, debug_level) {
+      : Dawg(type, lang, perm, debug_level), edges_(nullptr),
+        edges_are_mapped_(false) {
     TFile file;
     ASSERT_HOST(file.Open(filename, nullptr));
     ASSERT_HOST(read_squished_dawg(&file));
@@ -428,6 +431,7 @@ class SquishedDawg : public Dawg {
                int debug_level)
       : Dawg(type, lang, perm, debug_level),
         edges_(edges),
+        edges_are_mapped_(false),
         num_edges_(num_edges) {
     init(unicharset_size);
     num_forward_edges_in_node0 = num_forward_edges(0);
@@ -444,6 +448,11 @@ class SquishedDawg : public Dawg {
 
   int NumEdges() { return num_edges_; }
 
+  /// Builds a copy of the letters of the edges, in an array of its own that
+  /// can be searched many letters at a time, and uses it in edge_char_of.
+  /// Does nothing if the letters do not fit in 16 bits.
+  void BuildLabelIndex();
+
   /// Returns the edge that corresponds to the letter out of this node.
   EDGE_REF edge_char_of(NODE_REF node, UNICHAR_ID unichar_id,
                         bool word_end) const;
@@ -541,6 +550,10 @@ class SquishedDawg : public Dawg {
   /// Counts and returns the number of forward edges in this node.
   inT32 num_forward_edges(NODE_REF node) const;
 
+  /// Same as the linear search of edge_char_of, using the label index.
+  EDGE_REF indexed_edge_char_of(NODE_REF node, UNICHAR_ID unichar_id,
+                                bool word_end) const;
+
   /// Reads SquishedDawg from a file.
   bool read_squished_dawg(TFile *file);
 
@@ -558,8 +571,17 @@ class SquishedDawg : public Dawg {
 
   // Member variables.
   EDGE_ARRAY edges_;
+  // True if edges_ points into a read-only mapped file and must be neither
+  // modified nor deleted.
+  bool edges_are_mapped_;
   inT32 num_edges_;
   int num_forward_edges_in_node0;
+  // Label index made by BuildLabelIndex, empty if not in use. The letter of
+  // each edge, or kNoLabel for empty edges, padded at the end so that whole
+  // blocks of labels can be loaded up to the last edge.
+  GenericVector<uinT16> labels_;
+  // Number of edges from each edge to the last edge of its node.
+  GenericVector<uinT16> run_lengths_;
 };
 
 }  // namespace tesseract
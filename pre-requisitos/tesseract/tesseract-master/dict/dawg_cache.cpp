@@ -28,11 +28,13 @@ namespace tesseract {
 
 struct DawgLoader {
   DawgLoader(const STRING &lang, TessdataType tessdata_dawg_type,
-             int dawg_debug_level, TessdataManager *data_file)
+             int dawg_debug_level, bool label_index,
+             TessdataManager *data_file)
       : lang_(lang),
         data_file_(data_file),
         tessdata_dawg_type_(tessdata_dawg_type),
-        dawg_debug_level_(dawg_debug_level) {}
+        dawg_debug_level_(dawg_debug_level),
+        label_index_(label_index) {}
 
   Dawg *Load();
 
@@ -40,14 +42,17 @@ struct DawgLoader {
   TessdataManager *data_file_;
   TessdataType tessdata_dawg_type_;
   int dawg_debug_level_;
+  bool label_index_;
 };
 
 Dawg *DawgCache::GetSquishedDawg(const STRING &lang,
                                  TessdataType tessdata_dawg_type,
-                                 int debug_level, TessdataManager *data_file) {
+                                 int debug_level, bool label_index,
+                                 TessdataManager *data_file) {
   STRING data_id = data_file->GetDataFileName();
   data_id += kTessdataFileSuffixes[tessdata_dawg_type];
-  DawgLoader loader(lang, tessdata_dawg_type, debug_level, data_file);
+  DawgLoader loader(lang, tessdata_dawg_type, debug_level, label_index,
+                    data_file);
   return dawgs_.Get(data_id, NewTessCallback(&loader, &DawgLoader::Load));
 }
 
@@ -89,7 +94,10 @@ Dawg *DawgLoader::Load() {
   }
   SquishedDawg *retval =
       new SquishedDawg(dawg_type, lang_, perm_type, dawg_debug_level_);
-  if (retval->Load(&fp)) return retval;
+  if (retval->Load(&fp)) {
+    if (label_index_) retval->BuildLabelIndex();
+    return retval;
+  }
   delete retval;
   return nullptr;
 }
@@ -29,8 +29,12 @@ namespace tesseract {
 
 class DawgCache {
  public:
+  // If label_index, the dawg gets a label index (see
+  // SquishedDawg::BuildLabelIndex) when it is loaded. A dawg that is already
+  // in the cache is returned as it is.
   Dawg *GetSquishedDawg(const STRING &lang, TessdataType tessdata_dawg_type,
-                        int debug_level, TessdataManager *data_file);
+                        int debug_level, bool label_index,
+                        TessdataManager *data_file);
 
   // If we manage the given dawg, decrement its count,
   // and possibly delete it if the count reaches zero.
@@ -65,6 +65,10 @@ Dict::Dict(CCUtil *ccutil)
                        "Load dawg with special word "
                        "bigrams.",
                        getCCUtil()->params()),
+      BOOL_INIT_MEMBER(dawg_label_index, false,
+                       "Keep the letters of the dawgs in an array of their"
+                       " own, searched many at a time",
+                       getCCUtil()->params()),
       double_MEMBER(xheight_penalty_subscripts, 0.125,
                     "Score penalty (0.1 = 10%) added if there are subscripts "
                     "or superscripts in a word, but it is otherwise OK.",
@@ -224,34 +228,40 @@ void Dict::SetupForLoad(DawgCache *dawg_cache) {
 void Dict::Load(const STRING &lang, TessdataManager *data_file) {
   // Load dawgs_.
   if (load_punc_dawg) {
-    punc_dawg_ = dawg_cache_->GetSquishedDawg(lang, TESSDATA_PUNC_DAWG,
-                                              dawg_debug_level, data_file);
+    punc_dawg_ = dawg_cache_->GetSquishedDawg(
+        lang, TESSDATA_PUNC_DAWG, dawg_debug_level, dawg_label_index,
+        data_file);
     if (punc_dawg_) dawgs_ += punc_dawg_;
   }
   if (load_system_dawg) {
     Dawg *system_dawg = dawg_cache_->GetSquishedDawg(
-        lang, TESSDATA_SYSTEM_DAWG, dawg_debug_level, data_file);
+        lang, TESSDATA_SYSTEM_DAWG, dawg_debug_level, dawg_label_index,
+        data_file);
     if (system_dawg) dawgs_ += system_dawg;
   }
   if (load_number_dawg) {
     Dawg *number_dawg = dawg_cache_->GetSquishedDawg(
-        lang, TESSDATA_NUMBER_DAWG, dawg_debug_level, data_file);
+        lang, TESSDATA_NUMBER_DAWG, dawg_debug_level, dawg_label_index,
+        data_file);
     if (number_dawg) dawgs_ += number_dawg;
   }
   if (load_bigram_dawg) {
-    bigram_dawg_ = dawg_cache_->GetSquishedDawg(lang, TESSDATA_BIGRAM_DAWG,
-                                                dawg_debug_level, data_file);
+    bigram_dawg_ = dawg_cache_->GetSquishedDawg(
+        lang, TESSDATA_BIGRAM_DAWG, dawg_debug_level, dawg_label_index,
+        data_file);
     // The bigram_dawg_ is NOT used like the other dawgs! DO NOT add to the
     // dawgs_!!
   }
   if (load_freq_dawg) {
-    freq_dawg_ = dawg_cache_->GetSquishedDawg(lang, TESSDATA_FREQ_DAWG,
-                                              dawg_debug_level, data_file);
+    freq_dawg_ = dawg_cache_->GetSquishedDawg(
+        lang, TESSDATA_FREQ_DAWG, dawg_debug_level, dawg_label_index,
+        data_file);
     if (freq_dawg_) dawgs_ += freq_dawg_;
   }
   if (load_unambig_dawg) {
-    unambig_dawg_ = dawg_cache_->GetSquishedDawg(lang, TESSDATA_UNAMBIG_DAWG,
-                                                 dawg_debug_level, data_file);
+    unambig_dawg_ = dawg_cache_->GetSquishedDawg(
+        lang, TESSDATA_UNAMBIG_DAWG, dawg_debug_level, dawg_label_index,
+        data_file);
     if (unambig_dawg_) dawgs_ += unambig_dawg_;
   }
 
@@ -307,18 +317,21 @@ void Dict::Load(const STRING &lang, TessdataManager *data_file) {
 void Dict::LoadLSTM(const STRING &lang, TessdataManager *data_file) {
   // Load dawgs_.
   if (load_punc_dawg) {
-    punc_dawg_ = dawg_cache_->GetSquishedDawg(lang, TESSDATA_LSTM_PUNC_DAWG,
-                                              dawg_debug_level, data_file);
+    punc_dawg_ = dawg_cache_->GetSquishedDawg(
+        lang, TESSDATA_LSTM_PUNC_DAWG, dawg_debug_level, dawg_label_index,
+        data_file);
     if (punc_dawg_) dawgs_ += punc_dawg_;
   }
   if (load_system_dawg) {
     Dawg *system_dawg = dawg_cache_->GetSquishedDawg(
-        lang, TESSDATA_LSTM_SYSTEM_DAWG, dawg_debug_level, data_file);
+        lang, TESSDATA_LSTM_SYSTEM_DAWG, dawg_debug_level, dawg_label_index,
+        data_file);
     if (system_dawg) dawgs_ += system_dawg;
   }
   if (load_number_dawg) {
     Dawg *number_dawg = dawg_cache_->GetSquishedDawg(
-        lang, TESSDATA_LSTM_NUMBER_DAWG, dawg_debug_level, data_file);
+        lang, TESSDATA_LSTM_NUMBER_DAWG, dawg_debug_level, dawg_label_index,
+        data_file);
     if (number_dawg) dawgs_ += number_dawg;
   }
 }
@@ -569,6 +569,9 @@ class Dict {
   BOOL_VAR_H(load_number_dawg, true, "Load dawg with number patterns.");
   BOOL_VAR_H(load_bigram_dawg, true,
              "Load dawg with special word bigrams.");
+  BOOL_VAR_H(dawg_label_index, false,
+             "Keep the letters of the dawgs in an array of their own,"
+             " searched many at a time");
   double_VAR_H(xheight_penalty_subscripts, 0.125,
                "Score penalty (0.1 = 10%) added if there are subscripts "
                "or superscripts in a word, but it is otherwise OK.");
@@ -26,8 +26,11 @@
 
 #include "functions.h"
 #include "networkscratch.h"
+#include "opthreads.h"
 
-// Number of threads to use for parallel calculation of Forward and Backward.
+// Default number of threads to use for parallel calculation of Forward and
+// Backward, unless the calling thread has set a lower IntraOpThreads limit.
+// The per-thread buffers are arrays of this size.
 #ifdef _OPENMP
 const int kNumThreads = 4;
 #else
@@ -100,6 +103,11 @@ void FullyConnected::ConvertToInt() {
   weights_.ConvertToInt();
 }
 
+// Sets whether the int weights are also serialized pre-shaped.
+void FullyConnected::SetSerializeShaped(bool value) {
+  weights_.set_serialize_shaped(value);
+}
+
 // Provides debug output on the weights.
 void FullyConnected::DebugWeights() {
   weights_.Debug2D(name_.string());
@@ -128,16 +136,16 @@ void FullyConnected::Forward(bool debug, const NetworkIO& input,
   else
     output->Resize(input, no_);
   SetupForward(input, input_transpose);
-  GenericVector<NetworkScratch::FloatVec> temp_lines;
-  temp_lines.init_to_size(kNumThreads, NetworkScratch::FloatVec());
-  GenericVector<NetworkScratch::FloatVec> curr_input;
-  curr_input.init_to_size(kNumThreads, NetworkScratch::FloatVec());
-  for (int i = 0; i < kNumThreads; ++i) {
+  int num_threads = IntraOpThreads(kNumThreads);
+  if (num_threads > kNumThreads) num_threads = kNumThreads;
+  NetworkScratch::FloatVec temp_lines[kNumThreads];
+  NetworkScratch::FloatVec curr_input[kNumThreads];
+  for (int i = 0; i < num_threads; ++i) {
     temp_lines[i].Init(no_, scratch);
     curr_input[i].Init(ni_, scratch);
   }
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(kNumThreads)
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
   for (int t = 0; t < width; ++t) {
     // Thread-local pointer to temporary storage.
     int thread_id = omp_get_thread_num();
@@ -221,19 +229,19 @@ bool FullyConnected::Backward(bool debug, const NetworkIO& fwd_deltas,
                               NetworkIO* back_deltas) {
   if (debug) DisplayBackward(fwd_deltas);
   back_deltas->Resize(fwd_deltas, ni_);
-  GenericVector<NetworkScratch::FloatVec> errors;
-  errors.init_to_size(kNumThreads, NetworkScratch::FloatVec());
-  for (int i = 0; i < kNumThreads; ++i) errors[i].Init(no_, scratch);
-  GenericVector<NetworkScratch::FloatVec> temp_backprops;
+  int num_threads = IntraOpThreads(kNumThreads);
+  if (num_threads > kNumThreads) num_threads = kNumThreads;
+  NetworkScratch::FloatVec errors[kNumThreads];
+  for (int i = 0; i < num_threads; ++i) errors[i].Init(no_, scratch);
+  NetworkScratch::FloatVec temp_backprops[kNumThreads];
   if (needs_to_backprop_) {
-    temp_backprops.init_to_size(kNumThreads, NetworkScratch::FloatVec());
-    for (int i = 0; i < kNumThreads; ++i) temp_backprops[i].Init(ni_, scratch);
+    for (int i = 0; i < num_threads; ++i) temp_backprops[i].Init(ni_, scratch);
   }
   int width = fwd_deltas.Width();
   NetworkScratch::GradientStore errors_t;
   errors_t.Init(no_, width, scratch);
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(kNumThreads)
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
   for (int t = 0; t < width; ++t) {
     int thread_id = omp_get_thread_num();
 #else
@@ -308,4 +316,25 @@ void FullyConnected::CountAlternators(const Network& other, double* same,
   weights_.CountAlternators(fc->weights_, same, changed);
 }
 
+// Adds the weight deltas of other, which must have the same structure, to
+// the deltas of *this.
+void FullyConnected::AddDeltas(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const FullyConnected* fc = static_cast<const FullyConnected*>(&other);
+  weights_.AddDeltas(fc->weights_);
+}
+
+// Zeroes the weight deltas, leaving the momentum intact.
+void FullyConnected::ZeroDeltas() {
+  weights_.ZeroDeltas();
+}
+
+// Copies the weights of other, which must have the same structure, into
+// *this.
+void FullyConnected::CopyWeights(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const FullyConnected* fc = static_cast<const FullyConnected*>(&other);
+  weights_.CopyWeights(fc->weights_);
+}
+
 }  // namespace tesseract.
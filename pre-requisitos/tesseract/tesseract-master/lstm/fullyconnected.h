@@ -74,6 +74,8 @@ class FullyConnected : public Network {
 
   // Converts a float network to an int network.
   virtual void ConvertToInt();
+  // Sets whether the int weights are also serialized pre-shaped.
+  virtual void SetSerializeShaped(bool value);
 
   // Provides debug output on the weights.
   virtual void DebugWeights();
@@ -113,6 +115,14 @@ class FullyConnected : public Network {
   // *changed.
   virtual void CountAlternators(const Network& other, double* same,
                                 double* changed) const;
+  // Adds the weight deltas of other, which must have the same structure, to
+  // the deltas of *this.
+  void AddDeltas(const Network& other) override;
+  // Zeroes the weight deltas, leaving the momentum intact.
+  void ZeroDeltas() override;
+  // Copies the weights of other, which must have the same structure, into
+  // *this.
+  void CopyWeights(const Network& other) override;
 
  protected:
   // Weight arrays of size [no, ni + 1].
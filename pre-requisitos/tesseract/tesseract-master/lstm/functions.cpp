@@ -23,4 +23,15 @@ namespace tesseract {
 double TanhTable[kTableSize];
 double LogisticTable[kTableSize];
 
+// Fills the tables, so that Tanh and Logistic never have to write to them,
+// even from the parallel gate sections of LSTM::Forward.
+static bool InitTables() {
+  for (int i = 0; i < kTableSize; ++i) {
+    TanhTable[i] = tanh(i / kScaleFactor);
+    LogisticTable[i] = 1.0 / (1.0 + exp(-i / kScaleFactor));
+  }
+  return true;
+}
+static bool tables_initialized = InitTables();
+
 }  // namespace tesseract.
@@ -42,41 +42,28 @@ extern double TanhTable[];
 extern double LogisticTable[];
 
 // Non-linearity (sigmoid) functions with cache tables and clipping.
+// The tables are filled at startup, so the functions only read them, and
+// the sign is handled by selects instead of recursion, which leaves loops
+// over them free of branches on the data for the compiler to vectorize.
 inline double Tanh(double x) {
-  if (x < 0.0) return -Tanh(-x);
-  if (x >= (kTableSize - 1) / kScaleFactor) return 1.0;
-  x *= kScaleFactor;
-  int index = static_cast<int>(floor(x));
-  if (TanhTable[index] == 0.0 && index > 0) {
-    // Generate the entry.
-    TanhTable[index] = tanh(index / kScaleFactor);
-  }
-  if (index == kTableSize - 1) return TanhTable[kTableSize - 1];
-  if (TanhTable[index + 1] == 0.0) {
-    // Generate the entry.
-    TanhTable[index + 1] = tanh((index + 1) / kScaleFactor);
-  }
-  double offset = x - index;
-  return TanhTable[index] * (1.0 - offset) + TanhTable[index + 1] * offset;
+  double abs_x = fabs(x);
+  if (abs_x >= (kTableSize - 1) / kScaleFactor) return x < 0.0 ? -1.0 : 1.0;
+  abs_x *= kScaleFactor;
+  int index = static_cast<int>(abs_x);
+  double offset = abs_x - index;
+  double y = TanhTable[index] * (1.0 - offset) + TanhTable[index + 1] * offset;
+  return x < 0.0 ? -y : y;
 }
 
 inline double Logistic(double x) {
-  if (x < 0.0) return 1.0 - Logistic(-x);
-  if (x >= (kTableSize - 1) / kScaleFactor) return 1.0;
-  x *= kScaleFactor;
-  int index = static_cast<int>(floor(x));
-  if (LogisticTable[index] == 0.0) {
-    // Generate the entry.
-    LogisticTable[index] = 1.0 / (1.0 + exp(-index / kScaleFactor));
-  }
-  if (index == kTableSize - 1) return LogisticTable[kTableSize - 1];
-  if (LogisticTable[index + 1] == 0.0) {
-    // Generate the entry.
-    LogisticTable[index + 1] = 1.0 / (1.0 + exp(-(index + 1) / kScaleFactor));
-  }
-  double offset = x - index;
-  return LogisticTable[index] * (1.0 - offset) +
-         LogisticTable[index + 1] * offset;
+  double abs_x = fabs(x);
+  if (abs_x >= (kTableSize - 1) / kScaleFactor) return x < 0.0 ? 0.0 : 1.0;
+  abs_x *= kScaleFactor;
+  int index = static_cast<int>(abs_x);
+  double offset = abs_x - index;
+  double y = LogisticTable[index] * (1.0 - offset) +
+             LogisticTable[index + 1] * offset;
+  return x < 0.0 ? 1.0 - y : y;
 }
 
 // Non-linearity (sigmoid) functions and their derivatives.
@@ -205,6 +192,22 @@ inline void MultiplyAccumulate(int n, const double* u, const double* v,
   }
 }
 
+// Updates the n-vectors state and output of a 1-D LSTM cell in one pass from
+// its gates, as the sequence MultiplyVectorsInPlace(forget, state),
+// MultiplyAccumulate(cell, input, state), ClipVector(state) and
+// FuncMultiply<HFunc>(state, out_gate, output) would, with the same results.
+inline void UpdateLSTMState(int n, const double* cell, const double* input,
+                            const double* forget, const double* out_gate,
+                            double clip, double* state, double* output) {
+  for (int i = 0; i < n; ++i) {
+    double s = state[i] * forget[i];
+    s += cell[i] * input[i];
+    s = ClipToRange(s, -clip, clip);
+    state[i] = s;
+    output[i] = Tanh(s) * out_gate[i];
+  }
+}
+
 // Sums the given 5 n-vectors putting the result into sum.
 inline void SumVectors(int n, const double* v1, const double* v2,
                        const double* v3, const double* v4, const double* v5,
@@ -25,9 +25,6 @@
 
 namespace tesseract {
 
-// Max height for variable height inputs before scaling anyway.
-const int kMaxInputHeight = 48;
-
 Input::Input(const STRING& name, int ni, int no)
     : Network(NT_INPUT, name, ni, no), cached_x_scale_(1) {}
 Input::Input(const STRING& name, const StaticShape& shape)
@@ -107,15 +104,9 @@ Pix* Input::PrepareLSTMInputs(const ImageData& image_data,
   return pix;
 }
 
-// Converts the given pix to a NetworkIO of height and depth appropriate to the
-// given StaticShape:
-// If depth == 3, convert to 24 bit color, otherwise normalized grey.
-// Scale to target height, if the shape's height is > 1, or its depth if the
-// height == 1. If height == 0 then no scaling.
-// NOTE: It isn't safe for multiple threads to call this on the same pix.
-/* static */
-void Input::PreparePixInput(const StaticShape& shape, const Pix* pix,
-                            TRand* randomizer, NetworkIO* input) {
+// Returns a clone or converted copy of pix, of the depth and height
+// appropriate to the given StaticShape, as described for PreparePixInput.
+static Pix* NormalizePixForShape(const StaticShape& shape, const Pix* pix) {
   bool color = shape.depth() == 3;
   Pix* var_pix = const_cast<Pix*>(pix);
   int depth = pixGetDepth(var_pix);
@@ -146,8 +137,37 @@ void Input::PreparePixInput(const StaticShape& shape, const Pix* pix,
     pixDestroy(&normed_pix);
     normed_pix = scaled_pix;
   }
+  return normed_pix;
+}
+
+// Converts the given pix to a NetworkIO of height and depth appropriate to the
+// given StaticShape:
+// If depth == 3, convert to 24 bit color, otherwise normalized grey.
+// Scale to target height, if the shape's height is > 1, or its depth if the
+// height == 1. If height == 0 then no scaling.
+// NOTE: It isn't safe for multiple threads to call this on the same pix.
+/* static */
+void Input::PreparePixInput(const StaticShape& shape, const Pix* pix,
+                            TRand* randomizer, NetworkIO* input) {
+  Pix* normed_pix = NormalizePixForShape(shape, pix);
   input->FromPix(shape, normed_pix, randomizer);
   pixDestroy(&normed_pix);
 }
 
+// As PreparePixInput, but converts the pixes to a single NetworkIO, with
+// one batch index for each.
+/* static */
+void Input::PreparePixBatch(const StaticShape& shape,
+                            const std::vector<const Pix*>& pixes,
+                            TRand* randomizer, NetworkIO* input) {
+  std::vector<const Pix*> normed_pixes;
+  for (auto pix : pixes)
+    normed_pixes.push_back(NormalizePixForShape(shape, pix));
+  input->FromPixes(shape, normed_pixes, randomizer);
+  for (auto pix : normed_pixes) {
+    Pix* var_pix = const_cast<Pix*>(pix);
+    pixDestroy(&var_pix);
+  }
+}
+
 }  // namespace tesseract.
@@ -25,6 +25,9 @@ class ScrollView;
 
 namespace tesseract {
 
+// Max height for variable height inputs before scaling anyway.
+const int kMaxInputHeight = 48;
+
 class Input : public Network {
  public:
   Input(const STRING& name, int ni, int no);
@@ -91,6 +94,11 @@ class Input : public Network {
   // NOTE: It isn't safe for multiple threads to call this on the same pix.
   static void PreparePixInput(const StaticShape& shape, const Pix* pix,
                               TRand* randomizer, NetworkIO* input);
+  // As PreparePixInput, but converts the pixes to a single NetworkIO, with
+  // one batch index for each.
+  static void PreparePixBatch(const StaticShape& shape,
+                              const std::vector<const Pix*>& pixes,
+                              TRand* randomizer, NetworkIO* input);
 
  private:
   // Input shape determines how images are dealt with.
@@ -27,6 +27,7 @@
 #include "fullyconnected.h"
 #include "functions.h"
 #include "networkscratch.h"
+#include "opthreads.h"
 #include "tprintf.h"
 
 // Macros for openmp code if it is available, otherwise empty macros.
@@ -161,6 +162,17 @@ void LSTM::ConvertToInt() {
   }
 }
 
+// Sets whether the int weights are also serialized pre-shaped.
+void LSTM::SetSerializeShaped(bool value) {
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    gate_weights_[w].set_serialize_shaped(value);
+  }
+  if (softmax_ != NULL) {
+    softmax_->SetSerializeShaped(value);
+  }
+}
+
 // Sets up the network for training using the given weight_range.
 void LSTM::DebugWeights() {
   for (int w = 0; w < WT_COUNT; ++w) {
@@ -230,6 +242,11 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
   else
     output->Resize(input, no_);
   ResizeForward(input);
+#ifdef _OPENMP
+  // The gates are run as sections, so more threads than gates cannot help.
+  int num_threads = IntraOpThreads(GFS);
+  if (num_threads > GFS) num_threads = GFS;
+#endif
   // Temporary storage of forward computation for each gate.
   NetworkScratch::FloatVec temp_lines[WT_COUNT];
   for (int i = 0; i < WT_COUNT; ++i) temp_lines[i].Init(ns_, scratch);
@@ -243,10 +260,12 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
   // for the other dimension, used only when working in true 2D mode. The width
   // is enough to hold an entire strip of the major direction.
   int buf_width = Is2D() ? input_map_.Size(FD_WIDTH) : 1;
-  GenericVector<NetworkScratch::FloatVec> states, outputs;
+  // Sized on construction, so that nothing is allocated unless 2D.
+  GenericVector<NetworkScratch::FloatVec> states(Is2D() ? buf_width : 0,
+                                                 NetworkScratch::FloatVec());
+  GenericVector<NetworkScratch::FloatVec> outputs(Is2D() ? buf_width : 0,
+                                                  NetworkScratch::FloatVec());
   if (Is2D()) {
-    states.init_to_size(buf_width, NetworkScratch::FloatVec());
-    outputs.init_to_size(buf_width, NetworkScratch::FloatVec());
     for (int i = 0; i < buf_width; ++i) {
       states[i].Init(ns_, scratch);
       ZeroVector<double>(ns_, states[i]);
@@ -290,7 +309,7 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
       source_.WriteTimeStepPart(t, ni_ + nf_ + ns_, ns_, outputs[mod_t]);
     if (!source_.int_mode()) source_.ReadTimeStep(t, curr_input);
     // Matrix multiply the inputs with the source.
-    PARALLEL_IF_OPENMP(GFS)
+    PARALLEL_IF_OPENMP(num_threads)
     // It looks inefficient to create the threads on each t iteration, but the
     // alternative of putting the parallel outside the t loop, a single around
     // the t-loop and then tasks in place of the sections is a *lot* slower.
@@ -335,9 +354,9 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
     FuncInplace<FFunc>(ns_, temp_lines[GO]);
     END_PARALLEL_IF_OPENMP
 
-    // Apply forget gate to state.
-    MultiplyVectorsInPlace(ns_, temp_lines[GF1], curr_state);
     if (Is2D()) {
+      // Apply forget gate to state.
+      MultiplyVectorsInPlace(ns_, temp_lines[GF1], curr_state);
       // Max-pool the forget gates (in 2-d) instead of blindly adding.
       inT8* which_fg_col = which_fg_[t];
       memset(which_fg_col, 1, ns_ * sizeof(which_fg_col[0]));
@@ -350,10 +369,15 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
           }
         }
       }
+      MultiplyAccumulate(ns_, temp_lines[CI], temp_lines[GI], curr_state);
+      // Clip curr_state to a sane range.
+      ClipVector<double>(ns_, -kStateClip, kStateClip, curr_state);
+      FuncMultiply<HFunc>(curr_state, temp_lines[GO], ns_, curr_output);
+    } else {
+      // Forget, input, clip and output in a single pass over the state.
+      UpdateLSTMState(ns_, temp_lines[CI], temp_lines[GI], temp_lines[GF1],
+                      temp_lines[GO], kStateClip, curr_state, curr_output);
     }
-    MultiplyAccumulate(ns_, temp_lines[CI], temp_lines[GI], curr_state);
-    // Clip curr_state to a sane range.
-    ClipVector<double>(ns_, -kStateClip, kStateClip, curr_state);
     if (IsTraining()) {
       // Save the gate node values.
       node_values_[CI].WriteTimeStep(t, temp_lines[CI]);
@@ -362,7 +386,6 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
       node_values_[GO].WriteTimeStep(t, temp_lines[GO]);
       if (Is2D()) node_values_[GFS].WriteTimeStep(t, temp_lines[GFS]);
     }
-    FuncMultiply<HFunc>(curr_state, temp_lines[GO], ns_, curr_output);
     if (IsTraining()) state_.WriteTimeStep(t, curr_state);
     if (softmax_ != NULL) {
       if (input.int_mode()) {
@@ -414,6 +437,11 @@ bool LSTM::Backward(bool debug, const NetworkIO& fwd_deltas,
                     NetworkIO* back_deltas) {
   if (debug) DisplayBackward(fwd_deltas);
   back_deltas->ResizeToMap(fwd_deltas.int_mode(), input_map_, ni_);
+#ifdef _OPENMP
+  // The gates are run as sections, so more threads than gates cannot help.
+  int num_threads = IntraOpThreads(GFS);
+  if (num_threads > GFS) num_threads = GFS;
+#endif
   // ======Scratch space.======
   // Output errors from deltas with recurrence from sourceerr.
   NetworkScratch::FloatVec outputerr;
@@ -545,7 +573,7 @@ bool LSTM::Backward(bool debug, const NetworkIO& fwd_deltas,
     }
 #endif
     // Matrix multiply to get the source errors.
-    PARALLEL_IF_OPENMP(GFS)
+    PARALLEL_IF_OPENMP(num_threads)
 
     // Cell inputs.
     node_values_[CI].FuncMultiply3<GPrime>(t, node_values_[GI], t,
@@ -621,7 +649,7 @@ bool LSTM::Backward(bool debug, const NetworkIO& fwd_deltas,
   state_t.Init(ns_, width, scratch);
   state_.Transpose(state_t.get());
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(GFS) if (!Is2D())
+#pragma omp parallel for num_threads(num_threads) if (!Is2D())
 #endif
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
@@ -668,6 +696,39 @@ void LSTM::CountAlternators(const Network& other, double* same,
   }
 }
 
+// Adds the weight deltas of other, which must have the same structure, to
+// the deltas of *this.
+void LSTM::AddDeltas(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const LSTM* lstm = static_cast<const LSTM*>(&other);
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    gate_weights_[w].AddDeltas(lstm->gate_weights_[w]);
+  }
+  if (softmax_ != NULL) softmax_->AddDeltas(*lstm->softmax_);
+}
+
+// Zeroes the weight deltas, leaving the momentum intact.
+void LSTM::ZeroDeltas() {
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    gate_weights_[w].ZeroDeltas();
+  }
+  if (softmax_ != NULL) softmax_->ZeroDeltas();
+}
+
+// Copies the weights of other, which must have the same structure, into
+// *this.
+void LSTM::CopyWeights(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const LSTM* lstm = static_cast<const LSTM*>(&other);
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    gate_weights_[w].CopyWeights(lstm->gate_weights_[w]);
+  }
+  if (softmax_ != NULL) softmax_->CopyWeights(*lstm->softmax_);
+}
+
 // Prints the weights for debug purposes.
 void LSTM::PrintW() {
   tprintf("Weight state:%s\n", name_.string());
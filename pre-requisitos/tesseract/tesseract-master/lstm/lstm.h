@@ -82,6 +82,8 @@ class LSTM : public Network {
 
   // Converts a float network to an int network.
   virtual void ConvertToInt();
+  // Sets whether the int weights are also serialized pre-shaped.
+  virtual void SetSerializeShaped(bool value);
 
   // Provides debug output on the weights.
   virtual void DebugWeights();
@@ -111,6 +113,14 @@ class LSTM : public Network {
   // *changed.
   virtual void CountAlternators(const Network& other, double* same,
                                 double* changed) const;
+  // Adds the weight deltas of other, which must have the same structure, to
+  // the deltas of *this.
+  void AddDeltas(const Network& other) override;
+  // Zeroes the weight deltas, leaving the momentum intact.
+  void ZeroDeltas() override;
+  // Copies the weights of other, which must have the same structure, into
+  // *this.
+  void CopyWeights(const Network& other) override;
   // Prints the weights for debug purposes.
   void PrintW();
   // Prints the weight deltas for debug purposes.
@@ -32,6 +32,7 @@
 #include "input.h"
 #include "lstm.h"
 #include "normalis.h"
+#include "pageprofile.h"
 #include "pageres.h"
 #include "ratngs.h"
 #include "recodebeam.h"
@@ -39,6 +40,7 @@
 #include "shapetable.h"
 #include "statistc.h"
 #include "tprintf.h"
+#include "tracing.h"
 
 namespace tesseract {
 
@@ -60,6 +62,9 @@ LSTMRecognizer::LSTMRecognizer()
       adam_beta_(0.0f),
       dict_(NULL),
       search_(NULL),
+      fast_beam_search_(false),
+      use_dict_(true),
+      profile_(NULL),
       debug_win_(NULL) {}
 
 LSTMRecognizer::~LSTMRecognizer() {
@@ -184,26 +189,133 @@ void LSTMRecognizer::RecognizeLine(const ImageData& image_data, bool invert,
                                    bool debug, double worst_dict_cert,
                                    const TBOX& line_box,
                                    PointerVector<WERD_RES>* words) {
-  NetworkIO outputs;
+  TESS_TRACE_SPAN("LSTMRecognizer::RecognizeLine");
   float scale_factor;
-  NetworkIO inputs;
   if (!RecognizeLine(image_data, invert, debug, false, false, &scale_factor,
-                     &inputs, &outputs))
+                     &line_inputs_, &line_outputs_))
     return;
   if (search_ == NULL) {
     search_ =
         new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_);
+    search_->set_fast(fast_beam_search_);
+    search_->set_use_dict(use_dict_);
   }
-  search_->Decode(outputs, kDictRatio, kCertOffset, worst_dict_cert, NULL);
+  ProfileTimer timer(profile_, PROFILE_BEAM_SEARCH);
+  search_->Decode(line_outputs_, kDictRatio, kCertOffset, worst_dict_cert, NULL);
   search_->ExtractBestPathAsWords(line_box, scale_factor, debug,
                                   &GetUnicharset(), words);
 }
 
+// As RecognizeLine, but recognizes several line images with a single pass
+// through the network, packing them into one NetworkIO along the batch
+// dimension. line_boxes and words index with image_data, and the words of
+// a line that cannot be recognized are left untouched. Lines that need
+// inverting are run again together in a second pass.
+void LSTMRecognizer::RecognizeLines(
+    const GenericVector<const ImageData*>& image_data, bool invert,
+    bool debug, double worst_dict_cert, const GenericVector<TBOX>& line_boxes,
+    const GenericVector<PointerVector<WERD_RES>*>& words) {
+  TESS_TRACE_SPAN("LSTMRecognizer::RecognizeLines");
+  int min_width = network_->XScaleFactor();
+  // The lines that can be recognized, their images, and the reduction factor
+  // from image to coords of each.
+  GenericVector<int> lines;
+  std::vector<const Pix*> pixes;
+  GenericVector<float> scale_factors;
+  for (int i = 0; i < image_data.size(); ++i) {
+    SetRandomSeed();
+    float scale_factor;
+    Pix* pix = Input::PrepareLSTMInputs(*image_data[i], network_, min_width,
+                                        &randomizer_, &scale_factor);
+    if (pix == NULL) {
+      tprintf("Line cannot be recognized!!\n");
+      continue;
+    }
+    lines.push_back(i);
+    pixes.push_back(pix);
+    scale_factors.push_back(min_width / scale_factor);
+  }
+  if (lines.empty()) return;
+  line_inputs_.set_int_mode(IsIntMode());
+  SetRandomSeed();
+  Input::PreparePixBatch(network_->InputShape(), pixes, &randomizer_,
+                         &line_inputs_);
+  network_->Forward(debug, line_inputs_, NULL, &scratch_space_,
+                    &line_outputs_);
+  // The per-line outputs only grow in number, and each keeps its buffer.
+  while (batch_outputs_.size() < lines.size())
+    batch_outputs_.push_back(new NetworkIO);
+  for (int b = 0; b < lines.size(); ++b) {
+    batch_outputs_[b]->CopyBatchFrom(line_outputs_, b);
+  }
+  // Check for auto inversion, gathering the lines to try inverted.
+  GenericVector<int> inv_lines;
+  std::vector<const Pix*> inv_pixes;
+  GenericVector<float> pos_mins, pos_means, pos_sds;
+  for (int b = 0; invert && b < lines.size(); ++b) {
+    float pos_min, pos_mean, pos_sd;
+    OutputStats(*batch_outputs_[b], &pos_min, &pos_mean, &pos_sd);
+    if (pos_min < 0.5) {
+      Pix* pix = const_cast<Pix*>(pixes[b]);
+      pixInvert(pix, pix);
+      inv_lines.push_back(b);
+      inv_pixes.push_back(pix);
+      pos_mins.push_back(pos_min);
+      pos_means.push_back(pos_mean);
+      pos_sds.push_back(pos_sd);
+    }
+  }
+  if (!inv_lines.empty()) {
+    // Run again inverted and see if it is any better.
+    inv_inputs_.set_int_mode(IsIntMode());
+    SetRandomSeed();
+    Input::PreparePixBatch(network_->InputShape(), inv_pixes, &randomizer_,
+                           &inv_inputs_);
+    network_->Forward(debug, inv_inputs_, NULL, &scratch_space_,
+                      &inv_outputs_);
+    // The batch input is no longer needed, so it holds each inverted line.
+    NetworkIO& inv_line = line_inputs_;
+    for (int j = 0; j < inv_lines.size(); ++j) {
+      inv_line.CopyBatchFrom(inv_outputs_, j);
+      float inv_min, inv_mean, inv_sd;
+      OutputStats(inv_line, &inv_min, &inv_mean, &inv_sd);
+      if (inv_min > pos_mins[j] && inv_mean > pos_means[j] &&
+          inv_sd < pos_sds[j]) {
+        // Inverted did better. Use inverted data.
+        if (debug) {
+          tprintf("Inverting image: old min=%g, mean=%g, sd=%g, inv %g,%g,%g\n",
+                  pos_mins[j], pos_means[j], pos_sds[j], inv_min, inv_mean,
+                  inv_sd);
+        }
+        *batch_outputs_[inv_lines[j]] = inv_line;
+      }
+    }
+  }
+  for (int b = 0; b < lines.size(); ++b) {
+    Pix* pix = const_cast<Pix*>(pixes[b]);
+    pixDestroy(&pix);
+  }
+  if (search_ == NULL) {
+    search_ =
+        new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_);
+    search_->set_fast(fast_beam_search_);
+    search_->set_use_dict(use_dict_);
+  }
+  ProfileTimer timer(profile_, PROFILE_BEAM_SEARCH);
+  for (int b = 0; b < lines.size(); ++b) {
+    search_->Decode(*batch_outputs_[b], kDictRatio, kCertOffset, worst_dict_cert,
+                    NULL);
+    search_->ExtractBestPathAsWords(line_boxes[lines[b]], scale_factors[b],
+                                    debug, &GetUnicharset(), words[lines[b]]);
+  }
+}
+
 // Helper computes min and mean best results in the output.
 void LSTMRecognizer::OutputStats(const NetworkIO& outputs, float* min_output,
                                  float* mean_output, float* sd) {
   const int kOutputScale = MAX_INT8;
-  STATS stats(0, kOutputScale + 1);
+  STATS& stats = output_stats_;
+  stats.set_range(0, kOutputScale + 1);
   for (int t = 0; t < outputs.Width(); ++t) {
     int best_label = outputs.BestLabel(t, NULL);
     if (best_label != null_char_) {
@@ -259,7 +371,8 @@ bool LSTMRecognizer::RecognizeLine(const ImageData& image_data, bool invert,
   OutputStats(*outputs, &pos_min, &pos_mean, &pos_sd);
   if (invert && pos_min < 0.5) {
     // Run again inverted and see if it is any better.
-    NetworkIO inv_inputs, inv_outputs;
+    NetworkIO& inv_inputs = inv_inputs_;
+    NetworkIO& inv_outputs = inv_outputs_;
     inv_inputs.set_int_mode(IsIntMode());
     SetRandomSeed();
     pixInvert(pix, pix);
@@ -439,6 +552,8 @@ void LSTMRecognizer::LabelsViaReEncode(const NetworkIO& output,
   if (search_ == NULL) {
     search_ =
         new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_);
+    search_->set_fast(fast_beam_search_);
+    search_->set_use_dict(use_dict_);
   }
   search_->Decode(output, 1.0, 0.0, RecodeBeamSearch::kMinCertainty, NULL);
   search_->ExtractBestPathAsLabels(labels, xcoords);
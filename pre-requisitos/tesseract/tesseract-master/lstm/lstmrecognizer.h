@@ -27,6 +27,7 @@
 #include "networkscratch.h"
 #include "recodebeam.h"
 #include "series.h"
+#include "statistc.h"
 #include "strngs.h"
 #include "unicharcompress.h"
 
@@ -41,6 +42,7 @@ namespace tesseract {
 
 class Dict;
 class ImageData;
+class PageProfile;
 
 // Enum indicating training mode control flags.
 enum TrainingFlags {
@@ -75,6 +77,19 @@ class LSTMRecognizer {
   }
   bool SimpleTextOutput() const { return OutputLossType() == LT_SOFTMAX; }
   bool IsIntMode() const { return (training_flags_ & TF_INT_MODE) != 0; }
+  // Selects the fast variant of the beam search. See
+  // RecodeBeamSearch::set_fast.
+  void SetFastBeamSearch(bool fast) {
+    fast_beam_search_ = fast;
+    if (search_ != NULL) search_->set_fast(fast);
+  }
+  // Turns the dictionary of the beam search off, or back on.
+  void SetUseDict(bool use) {
+    use_dict_ = use;
+    if (search_ != NULL) search_->set_use_dict(use);
+  }
+  // Sets the profile, not owned, that gets the time of the beam search.
+  void set_profile(PageProfile* profile) { profile_ = profile; }
   // True if recoder_ is active to re-encode text to a smaller space.
   bool IsRecoding() const {
     return (training_flags_ & TF_COMPRESS_UNICHARSET) != 0;
@@ -134,6 +149,11 @@ class LSTMRecognizer {
       training_flags_ |= TF_INT_MODE;
     }
   }
+  // Makes an int network also serialize its weights in the layout of the
+  // SIMD multiplier of this machine, so that they load without reshaping.
+  void SetSerializeShaped(bool value) {
+    if (IsIntMode()) network_->SetSerializeShaped(value);
+  }
 
   // Provides access to the UNICHARSET that this classifier works with.
   const UNICHARSET& GetUnicharset() const { return ccutil_.unicharset; }
@@ -185,6 +205,15 @@ class LSTMRecognizer {
   void RecognizeLine(const ImageData& image_data, bool invert, bool debug,
                      double worst_dict_cert, const TBOX& line_box,
                      PointerVector<WERD_RES>* words);
+  // As RecognizeLine, but recognizes several line images with a single pass
+  // through the network, packing them into one NetworkIO along the batch
+  // dimension. line_boxes and words index with image_data, and the words of
+  // a line that cannot be recognized are left untouched. Lines that need
+  // inverting are run again together in a second pass.
+  void RecognizeLines(const GenericVector<const ImageData*>& image_data,
+                      bool invert, bool debug, double worst_dict_cert,
+                      const GenericVector<TBOX>& line_boxes,
+                      const GenericVector<PointerVector<WERD_RES>*>& words);
 
   // Helper computes min and mean best results in the output.
   void OutputStats(const NetworkIO& outputs,
@@ -301,6 +330,23 @@ class LSTMRecognizer {
   Dict* dict_;
   // Beam search held between uses to optimize memory allocation/use.
   RecodeBeamSearch* search_;
+  // True if search_ uses its fast variant.
+  bool fast_beam_search_;
+  // True if search_ uses dict_.
+  bool use_dict_;
+  // Profile of the current page, not owned. May be NULL.
+  PageProfile* profile_;
+  // Network inputs and outputs held between lines for the same reason, so
+  // that once they have grown to the longest line, recognizing a line does
+  // not allocate them again.
+  NetworkIO line_inputs_;
+  NetworkIO line_outputs_;
+  NetworkIO inv_inputs_;
+  NetworkIO inv_outputs_;
+  // Outputs of each line of a batch in RecognizeLines.
+  PointerVector<NetworkIO> batch_outputs_;
+  // Histogram of the best outputs in OutputStats.
+  STATS output_stats_;
 
   // == Debugging parameters.==
   // Recognition debug display window.
@@ -23,6 +23,7 @@
 
 #include "lstmtrainer.h"
 #include <string>
+#include <vector>
 
 #include "allheaders.h"
 #include "boxread.h"
@@ -299,9 +300,13 @@ void LSTMTrainer::DebugNetwork() {
 // loaded.
 bool LSTMTrainer::LoadAllTrainingData(const GenericVector<STRING>& filenames,
                                       CachingStrategy cache_strategy,
-                                      bool randomly_rotate) {
+                                      bool randomly_rotate, bool shuffle) {
   randomly_rotate_ = randomly_rotate;
   training_data_.Clear();
+  // Scaling every image anew for each sample is much of the cost of a
+  // training iteration, so the images are scaled once, as they are loaded.
+  training_data_.SetPreScale(network_->NumInputs(), kMaxInputHeight);
+  training_data_.set_shuffle(shuffle);
   return training_data_.LoadDocuments(filenames, cache_strategy, file_reader_);
 }
 
@@ -823,6 +828,103 @@ Trainability LSTMTrainer::TrainOnLine(const ImageData* trainingdata,
   return trainable;
 }
 
+// Makes num_replicas copies of the network for TrainOnLines to run samples
+// on in parallel, or none if num_replicas < 2. Call once the network is
+// set up. Returns false if the copies could not be made.
+bool LSTMTrainer::InitReplicas(int num_replicas) {
+  replicas_.clear();
+  if (num_replicas < 2) return true;
+  GenericVector<char> trainer_data;
+  if (!SaveTrainingDump(LIGHT, this, &trainer_data)) return false;
+  for (int i = 0; i < num_replicas; ++i) {
+    LSTMTrainer* replica = new LSTMTrainer;
+    replicas_.push_back(replica);
+    if (!ReadTrainingDump(trainer_data, replica)) {
+      tprintf("Failed to make replica %d of the network\n", i);
+      replicas_.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+// Data-parallel TrainOnLine: runs the next num_replicas() samples of
+// samples_trainer forward and backward at the same time, each on its own
+// replica with the current weights of *this, then sums the deltas of the
+// samples that would have been backpropagated into the network of *this
+// and makes a single update of it.
+void LSTMTrainer::TrainOnLines(LSTMTrainer* samples_trainer) {
+  int num_replicas = replicas_.size();
+  if (num_replicas == 0) {
+    TrainOnLine(samples_trainer, false);
+    return;
+  }
+  // The pages are fetched here as the document cache is not thread-safe.
+  GenericVector<const ImageData*> images;
+  for (int i = 0; i < num_replicas; ++i) {
+    images.push_back(samples_trainer->training_data_.GetPageBySerial(
+        sample_iteration() + i));
+  }
+  GenericVector<Trainability> trainable;
+  trainable.init_to_size(num_replicas, UNENCODABLE);
+  std::vector<NetworkIO> fwd_outputs(num_replicas), targets(num_replicas);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_replicas)
+#endif
+  for (int i = 0; i < num_replicas; ++i) {
+    if (images[i] == NULL) continue;
+    LSTMTrainer* replica = replicas_[i];
+    replica->network_->CopyWeights(*network_);
+    // The sample iteration seeds the randomizer, so a sample is distorted the
+    // same way as it would be by *this.
+    replica->SetIteration(sample_iteration() + i);
+    replica->training_iteration_ = training_iteration_;
+    replica->randomly_rotate_ = randomly_rotate_;
+    trainable[i] =
+        replica->PrepareForBackward(images[i], &fwd_outputs[i], &targets[i]);
+  }
+  // Accounts for the samples in order, as TrainOnLine would have, to decide
+  // which of them to backpropagate.
+  GenericVector<int> backprop;
+  for (int i = 0; i < num_replicas; ++i) {
+    if (images[i] == NULL || trainable[i] == UNENCODABLE ||
+        trainable[i] == NOT_BOXED) {
+      ++sample_iteration_;
+      continue;
+    }
+    const LSTMTrainer* replica = replicas_[i];
+    for (int type = ET_RMS; type < ET_SKIP_RATIO; ++type) {
+      ErrorTypes error_type = static_cast<ErrorTypes>(type);
+      UpdateErrorBuffer(replica->NewSingleError(error_type), error_type);
+    }
+    UpdateErrorBuffer(sample_iteration_ - prev_sample_iteration_,
+                      ET_SKIP_RATIO);
+    ++sample_iteration_;
+    if (network_->IsTraining() &&
+        (trainable[i] != PERFECT ||
+         training_iteration() >
+             last_perfect_training_iteration_ + perfect_delay_)) {
+      backprop.push_back(i);
+    }
+    RollErrorBuffers();
+  }
+  int num_backprop = backprop.size();
+  if (num_backprop == 0) return;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_backprop)
+#endif
+  for (int b = 0; b < num_backprop; ++b) {
+    LSTMTrainer* replica = replicas_[backprop[b]];
+    NetworkIO bp_deltas;
+    replica->network_->Backward(false, targets[backprop[b]],
+                                &replica->scratch_space_, &bp_deltas);
+  }
+  network_->ZeroDeltas();
+  for (int b = 0; b < num_backprop; ++b)
+    network_->AddDeltas(*replicas_[backprop[b]]->network_);
+  network_->Update(learning_rate_, momentum_, adam_beta_, training_iteration_);
+}
+
 // Prepares the ground truth, runs forward, and prepares the targets.
 // Returns a Trainability enum to indicate the suitability of the sample.
 Trainability LSTMTrainer::PrepareForBackward(const ImageData* trainingdata,
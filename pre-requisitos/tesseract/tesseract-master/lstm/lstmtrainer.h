@@ -180,10 +180,12 @@ class LSTMTrainer : public LSTMRecognizer {
 
   // Loads a set of lstmf files that were created using the lstm.train config to
   // tesseract into memory ready for training. Returns false if nothing was
-  // loaded.
+  // loaded. The network must be set up first, as the images are scaled to its
+  // input height as they are loaded. With shuffle, the pages of each file are
+  // used in a different order in each epoch (CS_SEQUENTIAL only).
   bool LoadAllTrainingData(const GenericVector<STRING>& filenames,
                            CachingStrategy cache_strategy,
-                           bool randomly_rotate);
+                           bool randomly_rotate, bool shuffle);
 
   // Keeps track of best and locally worst error rate, using internally computed
   // values. See MaintainCheckpointsSpecific for more detail.
@@ -272,6 +274,20 @@ class LSTMTrainer : public LSTMRecognizer {
   }
   Trainability TrainOnLine(const ImageData* trainingdata, bool batch);
 
+  // Makes num_replicas copies of the network for TrainOnLines to run samples
+  // on in parallel, or none if num_replicas < 2. Call once the network is
+  // set up. Returns false if the copies could not be made.
+  bool InitReplicas(int num_replicas);
+  int num_replicas() const { return replicas_.size(); }
+  // Data-parallel TrainOnLine: runs the next num_replicas() samples of
+  // samples_trainer forward and backward at the same time, each on its own
+  // replica with the current weights of *this, then sums the deltas of the
+  // samples that would have been backpropagated into the network of *this
+  // and makes a single update of it. The error accounting is the same as
+  // that of running TrainOnLine on each sample in turn. Without replicas,
+  // just runs TrainOnLine.
+  void TrainOnLines(LSTMTrainer* samples_trainer);
+
   // Prepares the ground truth, runs forward, and prepares the targets.
   // Returns a Trainability enum to indicate the suitability of the sample.
   Trainability PrepareForBackward(const ImageData* trainingdata,
@@ -423,6 +439,9 @@ class LSTMTrainer : public LSTMRecognizer {
   // when we can commit to c++11.
   CheckPointReader checkpoint_reader_;
   CheckPointWriter checkpoint_writer_;
+  // Copies of the network that TrainOnLines runs samples on. They only ever
+  // hold the weights of *this during a batch, so they are not serialized.
+  PointerVector<LSTMTrainer> replicas_;
 
   // ===Serialized data to ensure that a restart produces the same results.===
   // These members are only serialized when serialize_amount != LIGHT.
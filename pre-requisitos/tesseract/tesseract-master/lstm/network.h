@@ -189,6 +189,9 @@ class Network {
 
   // Converts a float network to an int network.
   virtual void ConvertToInt() {}
+  // Sets whether the int weights are also serialized in the layout of the
+  // SIMD multiplier of this machine (see WeightMatrix::set_serialize_shaped).
+  virtual void SetSerializeShaped(bool value) {}
 
   // Provides a pointer to a TRand for any networks that care to use it.
   // Note that randomizer is a borrowed pointer that should outlive the network
@@ -235,6 +238,14 @@ class Network {
   // *changed.
   virtual void CountAlternators(const Network& other, double* same,
                                 double* changed) const {}
+  // Adds the weight deltas of other, which must have the same structure, to
+  // the deltas of *this, for a batch of samples run on copies of the network.
+  virtual void AddDeltas(const Network& other) {}
+  // Zeroes the weight deltas, leaving the momentum intact.
+  virtual void ZeroDeltas() {}
+  // Copies the weights of other, which must have the same structure, into
+  // *this, leaving the deltas and momentum as they are.
+  virtual void CopyWeights(const Network& other) {}
 
   // Reads from the given file. Returns NULL in case of error.
   // Determines the type of the serialized class and calls its DeSerialize
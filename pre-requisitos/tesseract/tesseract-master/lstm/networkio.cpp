@@ -37,7 +37,7 @@ IntSimdMatrix* NetworkIO::multiplier_ = nullptr;
 
 // Resizes to a specific size as a 2-d temp buffer. No batches, no y-dim.
 void NetworkIO::Resize2d(bool int_mode, int width, int num_features) {
-  stride_map_ = StrideMap();
+  stride_map_.Clear();
   int_mode_ = int_mode;
   if (int_mode_) {
     i_.ResizeNoInit(width, num_features, GetPadding(num_features));
@@ -66,16 +66,17 @@ void NetworkIO::ResizeToMap(bool int_mode, const StrideMap& stride_map,
 // Shrinks image size by x_scale,y_scale, and use given number of features.
 void NetworkIO::ResizeScaled(const NetworkIO& src,
                              int x_scale, int y_scale, int num_features) {
-  StrideMap stride_map = src.stride_map_;
-  stride_map.ScaleXY(x_scale, y_scale);
-  ResizeToMap(src.int_mode_, stride_map, num_features);
+  // The map is built in place, so that its vectors are reused.
+  stride_map_ = src.stride_map_;
+  stride_map_.ScaleXY(x_scale, y_scale);
+  ResizeToMap(src.int_mode_, stride_map_, num_features);
 }
 
 // Resizes to just 1 x-coord, whatever the input.
 void NetworkIO::ResizeXTo1(const NetworkIO& src, int num_features) {
-  StrideMap stride_map = src.stride_map_;
-  stride_map.ReduceWidthTo1();
-  ResizeToMap(src.int_mode_, stride_map, num_features);
+  stride_map_ = src.stride_map_;
+  stride_map_.ReduceWidthTo1();
+  ResizeToMap(src.int_mode_, stride_map_, num_features);
 }
 
 // Initialize all the array to zero.
@@ -134,7 +135,10 @@ void NetworkIO::ZeroInvalidElements() {
 static void ComputeBlackWhite(Pix* pix, float* black, float* white) {
   int width = pixGetWidth(pix);
   int height = pixGetHeight(pix);
-  STATS mins(0, 256), maxes(0, 256);
+  // The histograms are kept from call to call, as this runs for every line.
+  static thread_local STATS mins(0, 256), maxes(0, 256);
+  mins.clear();
+  maxes.clear();
   if (width >= 3) {
     int y = height / 2;
     l_uint32* line = pixGetData(pix) + pixGetWpl(pix) * y;
@@ -165,8 +169,7 @@ static void ComputeBlackWhite(Pix* pix, float* black, float* white) {
 // with noise to match.
 void NetworkIO::FromPix(const StaticShape& shape, const Pix* pix,
                         TRand* randomizer) {
-  std::vector<const Pix*> pixes(1, pix);
-  FromPixes(shape, pixes, randomizer);
+  FromPixes(shape, &pix, 1, randomizer);
 }
 
 // Sets up the array from the given set of images, using the currently set
@@ -175,21 +178,26 @@ void NetworkIO::FromPix(const StaticShape& shape, const Pix* pix,
 void NetworkIO::FromPixes(const StaticShape& shape,
                           const std::vector<const Pix*>& pixes,
                           TRand* randomizer) {
+  FromPixes(shape, pixes.empty() ? NULL : &pixes[0], pixes.size(), randomizer);
+}
+
+// As FromPixes above, but for an array of num_pixes images.
+void NetworkIO::FromPixes(const StaticShape& shape, const Pix* const* pixes,
+                          int num_pixes, TRand* randomizer) {
   int target_height = shape.height();
   int target_width = shape.width();
-  std::vector<std::pair<int, int>> h_w_pairs;
-  for (auto pix : pixes) {
-    Pix* var_pix = const_cast<Pix*>(pix);
+  stride_map_.Clear();
+  for (int b = 0; b < num_pixes; ++b) {
+    Pix* var_pix = const_cast<Pix*>(pixes[b]);
     int width = pixGetWidth(var_pix);
     if (target_width != 0) width = target_width;
     int height = pixGetHeight(var_pix);
     if (target_height != 0) height = target_height;
-    h_w_pairs.emplace_back(height, width);
+    stride_map_.AddImage(height, width);
   }
-  stride_map_.SetStride(h_w_pairs);
   ResizeToMap(int_mode(), stride_map_, shape.depth());
   // Iterate over the images again to copy the data.
-  for (size_t b = 0; b < pixes.size(); ++b) {
+  for (int b = 0; b < num_pixes; ++b) {
     Pix* pix = const_cast<Pix*>(pixes[b]);
     float black = 0.0f, white = 255.0f;
     if (shape.depth() != 3) ComputeBlackWhite(pix, &black, &white);
@@ -394,6 +402,22 @@ void NetworkIO::CopyTimeStepFrom(int dest_t, const NetworkIO& src, int src_t) {
   }
 }
 
+// Resizes to hold just the image at the given batch index of src, and
+// copies it.
+void NetworkIO::CopyBatchFrom(const NetworkIO& src, int batch) {
+  StrideMap::Index src_index(src.stride_map_, batch, 0, 0);
+  stride_map_.Clear();
+  stride_map_.AddImage(src_index.MaxIndexOfDim(FD_HEIGHT) + 1,
+                       src_index.MaxIndexOfDim(FD_WIDTH) + 1);
+  ResizeToMap(src.int_mode_, stride_map_, src.NumFeatures());
+  // Both indices walk y then x over the same image.
+  StrideMap::Index dest_index(stride_map_);
+  do {
+    CopyTimeStepFrom(dest_index.t(), src, src_index.t());
+    src_index.Increment();
+  } while (dest_index.Increment());
+}
+
 // Copies a part of single time step from src.
 void NetworkIO::CopyTimeStepGeneral(int dest_t, int dest_offset,
                                     int num_features, const NetworkIO& src,
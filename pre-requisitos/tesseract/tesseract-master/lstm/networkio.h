@@ -75,6 +75,9 @@ class NetworkIO {
   // truncated or padded with noise to match.
   void FromPixes(const StaticShape& shape, const std::vector<const Pix*>& pixes,
                  TRand* randomizer);
+  // As FromPixes above, but for an array of num_pixes images.
+  void FromPixes(const StaticShape& shape, const Pix* const* pixes,
+                 int num_pixes, TRand* randomizer);
   // Copies the given pix to *this at the given batch index, stretching and
   // clipping the pixel values so that [black, black + 2*contrast] maps to the
   // dynamic range of *this, ie [-1,1] for a float and (-127,127) for int.
@@ -141,6 +144,9 @@ class NetworkIO {
 
   // Copies a single time step from src.
   void CopyTimeStepFrom(int dest_t, const NetworkIO& src, int src_t);
+  // Resizes to hold just the image at the given batch index of src, and
+  // copies it.
+  void CopyBatchFrom(const NetworkIO& src, int batch);
   // Copies a part of single time step from src.
   void CopyTimeStepGeneral(int dest_t, int dest_offset, int num_features,
                            const NetworkIO& src, int src_t, int src_offset);
@@ -24,6 +24,7 @@
 
 #include "functions.h"  // For conditional undef of _OPENMP.
 #include "networkscratch.h"
+#include "opthreads.h"
 
 namespace tesseract {
 
@@ -68,7 +69,9 @@ void Parallel::Forward(bool debug, const NetworkIO& input,
       results[i].Resize(input, stack_[i]->NumOutputs(), scratch);
     }
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(stack_size)
+    int num_threads = IntraOpThreads(stack_size);
+    if (num_threads > stack_size) num_threads = stack_size;
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
 #endif
     for (int i = 0; i < stack_size; ++i) {
       stack_[i]->Forward(debug, input, NULL, scratch, results[i]);
@@ -135,7 +138,9 @@ bool Parallel::Backward(bool debug, const NetworkIO& fwd_deltas,
       feature_offset += num_features;
     }
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(stack_size)
+    int num_threads = IntraOpThreads(stack_size);
+    if (num_threads > stack_size) num_threads = stack_size;
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
 #endif
     for (int i = 0; i < stack_size; ++i) {
       stack_[i]->Backward(debug, *in_deltas[i], scratch,
@@ -73,6 +73,12 @@ void Plumbing::ConvertToInt() {
     stack_[i]->ConvertToInt();
 }
 
+// Sets whether the int weights are also serialized pre-shaped.
+void Plumbing::SetSerializeShaped(bool value) {
+  for (int i = 0; i < stack_.size(); ++i)
+    stack_[i]->SetSerializeShaped(value);
+}
+
 // Provides a pointer to a TRand for any networks that care to use it.
 // Note that randomizer is a borrowed pointer that should outlive the network
 // and should not be deleted by any of the networks.
@@ -243,5 +249,36 @@ void Plumbing::CountAlternators(const Network& other, double* same,
     stack_[i]->CountAlternators(*plumbing->stack_[i], same, changed);
 }
 
+// Adds the weight deltas of other, which must have the same structure, to
+// the deltas of *this.
+void Plumbing::AddDeltas(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const Plumbing* plumbing = static_cast<const Plumbing*>(&other);
+  ASSERT_HOST(plumbing->stack_.size() == stack_.size());
+  for (int i = 0; i < stack_.size(); ++i) {
+    if (stack_[i]->IsTraining())
+      stack_[i]->AddDeltas(*plumbing->stack_[i]);
+  }
+}
+
+// Zeroes the weight deltas, leaving the momentum intact.
+void Plumbing::ZeroDeltas() {
+  for (int i = 0; i < stack_.size(); ++i) {
+    if (stack_[i]->IsTraining()) stack_[i]->ZeroDeltas();
+  }
+}
+
+// Copies the weights of other, which must have the same structure, into
+// *this. Layers that are not training keep their weights.
+void Plumbing::CopyWeights(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const Plumbing* plumbing = static_cast<const Plumbing*>(&other);
+  ASSERT_HOST(plumbing->stack_.size() == stack_.size());
+  for (int i = 0; i < stack_.size(); ++i) {
+    if (stack_[i]->IsTraining())
+      stack_[i]->CopyWeights(*plumbing->stack_[i]);
+  }
+}
+
 }  // namespace tesseract.
 
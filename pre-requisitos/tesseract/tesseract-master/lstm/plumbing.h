@@ -63,6 +63,8 @@ class Plumbing : public Network {
 
   // Converts a float network to an int network.
   virtual void ConvertToInt();
+  // Sets whether the int weights are also serialized pre-shaped.
+  virtual void SetSerializeShaped(bool value);
 
   // Provides a pointer to a TRand for any networks that care to use it.
   // Note that randomizer is a borrowed pointer that should outlive the network
@@ -130,6 +132,14 @@ class Plumbing : public Network {
   // *changed.
   virtual void CountAlternators(const Network& other, double* same,
                                 double* changed) const;
+  // Adds the weight deltas of other, which must have the same structure, to
+  // the deltas of *this.
+  void AddDeltas(const Network& other) override;
+  // Zeroes the weight deltas, leaving the momentum intact.
+  void ZeroDeltas() override;
+  // Copies the weights of other, which must have the same structure, into
+  // *this.
+  void CopyWeights(const Network& other) override;
 
  protected:
   // The networks.
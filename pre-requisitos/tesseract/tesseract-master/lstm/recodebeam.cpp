@@ -21,6 +21,7 @@
 #include "recodebeam.h"
 #include "networkio.h"
 #include "pageres.h"
+#include "tracing.h"
 #include "unicharcompress.h"
 
 namespace tesseract {
@@ -35,6 +36,8 @@ const float RecodeBeamSearch::kMinCertainty = -20.0f;
 const int RecodeBeamSearch::kBeamWidths[RecodedCharID::kMaxCodeLen + 1] = {
     5, 10, 16, 16, 16, 16, 16, 16, 16, 16,
 };
+// Enough for the best few dictionary contexts to try each of the top-n codes.
+const int RecodeBeamSearch::kMaxFastDawgProbes = 32;
 
 const char* kNodeContNames[] = {"Anything", "OnlyDup", "NoDup"};
 
@@ -65,21 +68,38 @@ RecodeBeamSearch::RecodeBeamSearch(const UnicharCompress& recoder,
       beam_size_(0),
       top_code_(-1),
       second_code_(-1),
+      fast_(false),
+      dawg_probes_(0),
       dict_(dict),
+      lang_dict_(dict),
       space_delimited_(true),
       is_simple_text_(simple_text),
       null_char_(null_char) {
   if (dict_ != NULL && !dict_->IsSpaceDelimitedLang()) space_delimited_ = false;
+  // The codes that may follow an empty prefix, for the fast variant.
+  RecodedCharID empty_prefix;
+  is_single_code_.init_to_size(recoder_.code_range(), false);
+  is_first_code_.init_to_size(recoder_.code_range(), false);
+  const GenericVector<int>* codes = recoder_.GetFinalCodes(empty_prefix);
+  for (int i = 0; codes != NULL && i < codes->size(); ++i)
+    is_single_code_[(*codes)[i]] = true;
+  codes = recoder_.GetNextCodes(empty_prefix);
+  for (int i = 0; codes != NULL && i < codes->size(); ++i)
+    is_first_code_[(*codes)[i]] = true;
 }
 
 // Decodes the set of network outputs, storing the lattice internally.
 void RecodeBeamSearch::Decode(const NetworkIO& output, double dict_ratio,
                               double cert_offset, double worst_dict_cert,
                               const UNICHARSET* charset) {
+  TESS_TRACE_SPAN("RecodeBeamSearch::Decode");
   beam_size_ = 0;
   int width = output.Width();
   for (int t = 0; t < width; ++t) {
-    ComputeTopN(output.f(t), output.NumFeatures(), kBeamWidths[0]);
+    if (fast_)
+      ComputeTopNFast(output.f(t), output.NumFeatures(), kBeamWidths[0]);
+    else
+      ComputeTopN(output.f(t), output.NumFeatures(), kBeamWidths[0]);
     DecodeStep(output.f(t), t, dict_ratio, cert_offset, worst_dict_cert,
                charset);
   }
@@ -88,10 +108,14 @@ void RecodeBeamSearch::Decode(const GENERIC_2D_ARRAY<float>& output,
                               double dict_ratio, double cert_offset,
                               double worst_dict_cert,
                               const UNICHARSET* charset) {
+  TESS_TRACE_SPAN("RecodeBeamSearch::Decode");
   beam_size_ = 0;
   int width = output.dim1();
   for (int t = 0; t < width; ++t) {
-    ComputeTopN(output[t], output.dim2(), kBeamWidths[0]);
+    if (fast_)
+      ComputeTopNFast(output[t], output.dim2(), kBeamWidths[0]);
+    else
+      ComputeTopN(output[t], output.dim2(), kBeamWidths[0]);
     DecodeStep(output[t], t, dict_ratio, cert_offset, worst_dict_cert, charset);
   }
 }
@@ -373,6 +397,66 @@ void RecodeBeamSearch::ComputeTopN(const float* outputs, int num_outputs,
   top_n_flags_[null_char_] = TN_TOP2;
 }
 
+// As ComputeTopN, for the fast variant. Also fills the fast_final_codes_
+// and fast_next_codes_ lists.
+void RecodeBeamSearch::ComputeTopNFast(const float* outputs, int num_outputs,
+                                       int top_n) {
+  // Only the flags set at the previous timestep need resetting.
+  if (top_n_flags_.size() != num_outputs) {
+    top_n_flags_.init_to_size(num_outputs, TN_ALSO_RAN);
+  } else {
+    for (int i = 0; i < top_codes_.size(); ++i)
+      top_n_flags_[top_codes_[i]] = TN_ALSO_RAN;
+    top_n_flags_[null_char_] = TN_ALSO_RAN;
+  }
+  // Partial selection: each output that beats the worst of the best so far
+  // is inserted in the short sorted list, instead of going through a heap.
+  top_codes_.truncate(0);
+  top_outputs_.truncate(0);
+  for (int i = 0; i < num_outputs; ++i) {
+    int size = top_codes_.size();
+    if (size == top_n && outputs[i] <= top_outputs_[size - 1]) continue;
+    if (size < top_n) {
+      top_codes_.push_back(i);
+      top_outputs_.push_back(outputs[i]);
+    } else {
+      --size;
+    }
+    while (size > 0 && outputs[i] > top_outputs_[size - 1]) {
+      top_codes_[size] = top_codes_[size - 1];
+      top_outputs_[size] = top_outputs_[size - 1];
+      --size;
+    }
+    top_codes_[size] = i;
+    top_outputs_[size] = outputs[i];
+  }
+  top_code_ = top_codes_.size() > 0 ? top_codes_[0] : -1;
+  second_code_ = top_codes_.size() > 1 ? top_codes_[1] : -1;
+  for (int i = 0; i < top_codes_.size(); ++i)
+    top_n_flags_[top_codes_[i]] = i < 2 ? TN_TOP2 : TN_TOPN;
+  top_n_flags_[null_char_] = TN_TOP2;
+  for (int tn = 0; tn < TN_ALSO_RAN; ++tn) {
+    fast_final_codes_[tn].truncate(0);
+    fast_next_codes_[tn].truncate(0);
+  }
+  bool null_in_top = false;
+  for (int i = 0; i <= top_codes_.size(); ++i) {
+    int code;
+    if (i < top_codes_.size()) {
+      code = top_codes_[i];
+      if (code == null_char_) null_in_top = true;
+    } else if (!null_in_top) {
+      code = null_char_;
+    } else {
+      break;
+    }
+    if (code >= is_single_code_.size()) continue;
+    int tn = top_n_flags_[code];
+    if (is_single_code_[code]) fast_final_codes_[tn].push_back(code);
+    if (is_first_code_[code]) fast_next_codes_[tn].push_back(code);
+  }
+}
+
 // Adds the computation for the current time-step to the beam. Call at each
 // time-step in sequence from left to right. outputs is the activation vector
 // for the current timestep.
@@ -384,6 +468,7 @@ void RecodeBeamSearch::DecodeStep(const float* outputs, int t,
   RecodeBeam* step = beam_[t];
   beam_size_ = t + 1;
   step->Clear();
+  dawg_probes_ = 0;
   if (t == 0) {
     // The first step can only use singles and initials.
     ContinueContext(nullptr, BeamIndex(false, NC_ANYTHING, 0), outputs, TN_TOP2,
@@ -500,7 +585,12 @@ void RecodeBeamSearch::ContinueContext(const RecodeNode* prev, int index,
                               NC_ANYTHING, prev, step);
     }
   }
-  const GenericVector<int>* final_codes = recoder_.GetFinalCodes(prefix);
+  // In the fast variant, a context with an empty prefix is extended only with
+  // the top-n codes of the timestep, as the others fail the flag test.
+  bool top_n_lists = fast_ && length == 0 && top_n_flag != TN_ALSO_RAN;
+  const GenericVector<int>* final_codes =
+      top_n_lists ? &fast_final_codes_[top_n_flag]
+                  : recoder_.GetFinalCodes(prefix);
   if (final_codes != NULL) {
     for (int i = 0; i < final_codes->size(); ++i) {
       int code = (*final_codes)[i];
@@ -528,7 +618,9 @@ void RecodeBeamSearch::ContinueContext(const RecodeNode* prev, int index,
       }
     }
   }
-  const GenericVector<int>* next_codes = recoder_.GetNextCodes(prefix);
+  const GenericVector<int>* next_codes =
+      top_n_lists ? &fast_next_codes_[top_n_flag]
+                  : recoder_.GetNextCodes(prefix);
   if (next_codes != NULL) {
     for (int i = 0; i < next_codes->size(); ++i) {
       int code = (*next_codes)[i];
@@ -642,6 +734,7 @@ void RecodeBeamSearch::ContinueDawg(int code, int unichar_id, float cert,
              dict_->getUnicharset().IsSpaceDelimited(unichar_id)) {
     return;  // Can't break words between space delimited chars.
   }
+  if (fast_ && ++dawg_probes_ > kMaxFastDawgProbes) return;
   DawgPositionVector initial_dawgs;
   DawgPositionVector* updated_dawgs = new DawgPositionVector;
   DawgArgs dawg_args(&initial_dawgs, updated_dawgs, NO_PERM);
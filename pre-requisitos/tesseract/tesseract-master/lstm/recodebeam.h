@@ -130,6 +130,13 @@ struct RecodeNode {
     src.dawgs = NULL;
     return *this;
   }
+  // The same moves, for the containers that move their elements.
+  RecodeNode(RecodeNode&& src) : dawgs(NULL) {
+    *this = src;
+  }
+  RecodeNode& operator=(RecodeNode&& src) {
+    return *this = src;
+  }
   ~RecodeNode() { delete dawgs; }
   // Prints details of the node.
   void Print(int null_char, const UNICHARSET& unicharset, int depth) const;
@@ -179,6 +186,16 @@ class RecodeBeamSearch {
   RecodeBeamSearch(const UnicharCompress& recoder, int null_char,
                    bool simple_text, Dict* dict);
 
+  // Selects the fast variant of Decode, which finds the top-n outputs of each
+  // timestep by partial selection, extends single code contexts only with the
+  // top-n codes instead of scanning every code, and caps the dictionary
+  // probes made at each timestep. It may lose a dictionary path that the
+  // exhaustive search would find, so results can differ slightly.
+  void set_fast(bool fast) { fast_ = fast; }
+  // Turns the dictionary of the search off, or back on, for the next Decode.
+  // Without it only the top choice beams are searched.
+  void set_use_dict(bool use) { dict_ = use ? lang_dict_ : nullptr; }
+
   // Decodes the set of network outputs, storing the lattice internally.
   // If charset is not null, it enables detailed debugging of the beam search.
   void Decode(const NetworkIO& output, double dict_ratio, double cert_offset,
@@ -285,6 +302,9 @@ class RecodeBeamSearch {
   // Fills top_n_flags_ with bools that are true iff the corresponding output
   // is one of the top_n.
   void ComputeTopN(const float* outputs, int num_outputs, int top_n);
+  // As ComputeTopN, for the fast variant. Also fills the fast_final_codes_
+  // and fast_next_codes_ lists.
+  void ComputeTopNFast(const float* outputs, int num_outputs, int top_n);
 
   // Adds the computation for the current time-step to the beam. Call at each
   // time-step in sequence from left to right. outputs is the activation vector
@@ -360,6 +380,8 @@ class RecodeBeamSearch {
                         const GenericVector<int>& xcoords) const;
 
   static const int kBeamWidths[RecodedCharID::kMaxCodeLen + 1];
+  // Largest number of dictionary probes per timestep in the fast variant.
+  static const int kMaxFastDawgProbes;
 
   // The encoder/decoder that we will be using.
   const UnicharCompress& recoder_;
@@ -375,8 +397,26 @@ class RecodeBeamSearch {
   int second_code_;
   // Heap used to compute the top_n_flags_.
   GenericHeap<TopPair> top_heap_;
-  // Borrowed pointer to the dictionary to use in the search.
+  // True if Decode uses the fast variant.
+  bool fast_;
+  // For the fast variant, the top-n codes of the current timestep, best
+  // first, and their outputs.
+  GenericVector<int> top_codes_;
+  GenericVector<float> top_outputs_;
+  // For the fast variant, the top-n codes of the current timestep that are
+  // single codes or the first of several, by TopNState (only TN_TOP2 and
+  // TN_TOPN). They stand in for the lists of the recoder for an empty prefix.
+  GenericVector<int> fast_final_codes_[TN_ALSO_RAN];
+  GenericVector<int> fast_next_codes_[TN_ALSO_RAN];
+  // Indexed by code, true if it is a single code, or the first of several.
+  GenericVector<bool> is_single_code_;
+  GenericVector<bool> is_first_code_;
+  // Number of dictionary probes made at the current timestep.
+  int dawg_probes_;
+  // Borrowed pointer to the dictionary to use in the search, lang_dict_ or
+  // NULL if it is turned off.
   Dict* dict_;
+  Dict* lang_dict_;
   // True if the language is space-delimited, which is true for most languages
   // except chi*, jpn, tha.
   bool space_delimited_;
@@ -122,21 +122,30 @@ void StrideMap::Index::SetTFromIndices() {
   }
 }
 
+// Resets to the empty map of a default StrideMap, keeping the space
+// allocated for the image sizes.
+void StrideMap::Clear() {
+  memset(shape_, 0, sizeof(shape_));
+  memset(t_increments_, 0, sizeof(t_increments_));
+  heights_.clear();
+  widths_.clear();
+}
+
 // Sets up the stride for the given array of height, width pairs.
 void StrideMap::SetStride(const std::vector<std::pair<int, int>>& h_w_pairs) {
-  int max_height = 0;
-  int max_width = 0;
+  Clear();
   for (const std::pair<int, int>& hw : h_w_pairs) {
-    int height = hw.first;
-    int width = hw.second;
-    heights_.push_back(height);
-    widths_.push_back(width);
-    if (height > max_height) max_height = height;
-    if (width > max_width) max_width = width;
+    AddImage(hw.first, hw.second);
   }
+}
+
+// Adds an image of the given height and width to the end of the batch.
+void StrideMap::AddImage(int height, int width) {
+  heights_.push_back(height);
+  widths_.push_back(width);
   shape_[FD_BATCH] = heights_.size();
-  shape_[FD_HEIGHT] = max_height;
-  shape_[FD_WIDTH] = max_width;
+  if (height > shape_[FD_HEIGHT]) shape_[FD_HEIGHT] = height;
+  if (width > shape_[FD_WIDTH]) shape_[FD_WIDTH] = width;
   ComputeTIncrements();
 }
 
@@ -104,8 +104,13 @@ class StrideMap {
   }
   // Default copy constructor and operator= are OK to use here!
 
+  // Resets to the empty map of a default StrideMap, keeping the space
+  // allocated for the image sizes.
+  void Clear();
   // Sets up the stride for the given array of height, width pairs.
   void SetStride(const std::vector<std::pair<int, int>>& h_w_pairs);
+  // Adds an image of the given height and width to the end of the batch.
+  void AddImage(int height, int width);
   // Scales width and height dimensions by the given factors.
   void ScaleXY(int x_factor, int y_factor);
   // Reduces width to 1, across the batch, whatever the input size.
@@ -21,6 +21,7 @@
 #include "dotproductavx.h"
 #include "dotproductsse.h"
 #include "intsimdmatrix.h"
+#include "opthreads.h"
 #include "simddetect.h"
 #include "statistc.h"
 #include "tprintf.h"
@@ -131,6 +132,9 @@ void WeightMatrix::InitBackward() {
 const int kInt8Flag = 1;
 // Flag on mode to indicate that this weightmatrix uses adam.
 const int kAdamFlag = 4;
+// Flag on mode to indicate that the int weights are followed by a copy
+// shaped for the multiplier of the machine that wrote them.
+const int kShapedFlag = 8;
 // Flag on mode to indicate that this weightmatrix uses double. Set
 // independently of kInt8Flag as even in int mode the scales can
 // be float or double.
@@ -140,12 +144,15 @@ const int kDoubleFlag = 128;
 bool WeightMatrix::Serialize(bool training, TFile* fp) const {
   // For backward compatibility, add kDoubleFlag to mode to indicate the doubles
   // format, without errs, so we can detect and read old format weight matrices.
-  uinT8 mode =
-      (int_mode_ ? kInt8Flag : 0) | (use_adam_ ? kAdamFlag : 0) | kDoubleFlag;
+  bool shaped = int_mode_ && serialize_shaped_ && multiplier_ != nullptr &&
+                multiplier_->IsShaped();
+  uinT8 mode = (int_mode_ ? kInt8Flag : 0) | (use_adam_ ? kAdamFlag : 0) |
+               (shaped ? kShapedFlag : 0) | kDoubleFlag;
   if (fp->FWrite(&mode, sizeof(mode), 1) != 1) return false;
   if (int_mode_) {
     if (!wi_.Serialize(fp)) return false;
     if (!scales_.Serialize(fp)) return false;
+    if (shaped && !multiplier_->SerializeShaped(wi_, fp)) return false;
   } else {
     if (!wf_.Serialize(fp)) return false;
     if (training && !updates_.Serialize(fp)) return false;
@@ -161,12 +168,18 @@ bool WeightMatrix::DeSerialize(bool training, TFile* fp) {
   if (fp->FRead(&mode, sizeof(mode), 1) != 1) return false;
   int_mode_ = (mode & kInt8Flag) != 0;
   use_adam_ = (mode & kAdamFlag) != 0;
+  serialize_shaped_ = (mode & kShapedFlag) != 0;
   if ((mode & kDoubleFlag) == 0) return DeSerializeOld(training, fp);
   if (int_mode_) {
-    if (!wi_.DeSerialize(fp)) return false;
+    // Int weights are never trained, so they can stay in a mapped model.
+    if (!wi_.DeSerializeInPlace(fp)) return false;
     if (!scales_.DeSerialize(fp)) return false;
     multiplier_.reset(IntSimdMatrix::GetFastestMultiplier());
-    if (multiplier_ != nullptr) multiplier_->Init(wi_);
+    if (serialize_shaped_) {
+      if (!multiplier_->DeSerializeShaped(wi_, fp)) return false;
+    } else {
+      multiplier_->Init(wi_);
+    }
   } else {
     if (!wf_.DeSerialize(fp)) return false;
     if (training) {
@@ -256,7 +269,8 @@ void WeightMatrix::SumOuterTransposed(const TransposedArray& u,
   // v is missing the last element in dim1.
   ASSERT_HOST(v.dim1() == num_inputs);
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(4) if (in_parallel)
+  int num_threads = in_parallel ? IntraOpThreads(4) : 1;
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
 #endif
   for (int i = 0; i < num_outputs; ++i) {
     double* dwi = dw_[i];
@@ -303,6 +317,16 @@ void WeightMatrix::AddDeltas(const WeightMatrix& other) {
   dw_ += other.dw_;
 }
 
+// Copies the weights of other, which must be of the same size, into *this,
+// leaving the deltas and updates as they are.
+void WeightMatrix::CopyWeights(const WeightMatrix& other) {
+  ASSERT_HOST(!int_mode_ && !other.int_mode_);
+  ASSERT_HOST(wf_.dim1() == other.wf_.dim1());
+  ASSERT_HOST(wf_.dim2() == other.wf_.dim2());
+  wf_ = other.wf_;
+  wf_t_ = other.wf_t_;
+}
+
 // Sums the products of weight updates in *this and other, splitting into
 // positive (same direction) in *same and negative (different direction) in
 // *changed.
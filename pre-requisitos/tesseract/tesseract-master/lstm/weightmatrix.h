@@ -64,7 +64,8 @@ class TransposedArray : public GENERIC_2D_ARRAY<double> {
 // backward steps with the matrix and updates to the weights.
 class WeightMatrix {
  public:
-  WeightMatrix() : int_mode_(false), use_adam_(false) {}
+  WeightMatrix()
+      : int_mode_(false), use_adam_(false), serialize_shaped_(false) {}
   // Sets up the network for training. Initializes weights using weights of
   // scale `range` picked according to the random number generator `randomizer`.
   // Note the order is outputs, inputs, as this is the order of indices to
@@ -94,6 +95,11 @@ class WeightMatrix {
     return multiplier_->RoundInputs(size);
   }
 
+  // Makes Serialize also write int weights in the layout of the multiplier
+  // in use, so that a machine with the same multiplier can use them without
+  // reshaping them, and in place from a mapped model.
+  void set_serialize_shaped(bool value) { serialize_shaped_ = value; }
+
   // Accessors.
   bool is_int_mode() const {
     return int_mode_;
@@ -143,6 +149,11 @@ class WeightMatrix {
               int num_samples);
   // Adds the dw_ in other to the dw_ is *this.
   void AddDeltas(const WeightMatrix& other);
+  // Zeroes the dw_, leaving the updates_ and thus the momentum intact.
+  void ZeroDeltas() { dw_.Clear(); }
+  // Copies the weights of other, which must be of the same size, into *this,
+  // leaving the deltas and updates as they are.
+  void CopyWeights(const WeightMatrix& other);
   // Sums the products of weight updates in *this and other, splitting into
   // positive (same direction) in *same and negative (different direction) in
   // *changed.
@@ -179,6 +190,8 @@ class WeightMatrix {
   bool int_mode_;
   // True if we are running adam in this weight matrix.
   bool use_adam_;
+  // True if the weights in the layout of multiplier_ are serialized too.
+  bool serialize_shaped_;
   // If we are using wi_, then scales_ is a factor to restore the row product
   // with a vector to the correct range.
   GenericVector<double> scales_;
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////
+// File:        bandedmorph.cpp
+// Description: Brick morphology of binary images in parallel bands.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "bandedmorph.h"
+
+#include <atomic>
+#include "allheaders.h"
+#include "opthreads.h"
+
+namespace tesseract {
+
+// Number of bands an image is cut into by default.
+const int kNumBands = 4;
+// Bands are at least this many times as long as the overlap they need.
+const int kMinBandsPerOverlap = 4;
+// Vertical bands start at multiples of this many pixels, so no two of them
+// write to the same word of the result.
+const int kBandColumnAlignment = 32;
+
+// Returns true if leptonica has a linear DWA Sel of the given size, as made
+// by selaAddBasic. A size of 1 needs no Sel at all.
+static bool HasDwaSel(int size) {
+  static const int kDwaSizes[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+                                  14, 15, 20, 21, 25, 30, 31, 35, 40, 41, 45,
+                                  50, 51};
+  for (size_t i = 0; i < sizeof(kDwaSizes) / sizeof(kDwaSizes[0]); ++i) {
+    if (kDwaSizes[i] == size) return true;
+  }
+  return false;
+}
+
+// Runs op on the whole of pixs. The DWA closing adds a border, unlike
+// pixCloseBrick, so it is made of the DWA dilation and erosion instead.
+static Pix* BrickMorph(BrickOp op, Pix* pixs, int hsize, int vsize) {
+  if (HasDwaSel(hsize) && HasDwaSel(vsize)) {
+    switch (op) {
+      case BRICK_DILATE:
+        return pixDilateBrickDwa(NULL, pixs, hsize, vsize);
+      case BRICK_ERODE:
+        return pixErodeBrickDwa(NULL, pixs, hsize, vsize);
+      case BRICK_OPEN:
+        return pixOpenBrickDwa(NULL, pixs, hsize, vsize);
+      case BRICK_CLOSE: {
+        Pix* pixd = pixDilateBrickDwa(NULL, pixs, hsize, vsize);
+        pixErodeBrickDwa(pixd, pixd, hsize, vsize);
+        return pixd;
+      }
+    }
+  }
+  switch (op) {
+    case BRICK_DILATE:
+      return pixDilateBrick(NULL, pixs, hsize, vsize);
+    case BRICK_ERODE:
+      return pixErodeBrick(NULL, pixs, hsize, vsize);
+    case BRICK_OPEN:
+      return pixOpenBrick(NULL, pixs, hsize, vsize);
+    case BRICK_CLOSE:
+      return pixCloseBrick(NULL, pixs, hsize, vsize);
+  }
+  return NULL;
+}
+
+Pix* BandedBrickMorph(BrickOp op, Pix* pixs, int hsize, int vsize) {
+  int width = pixGetWidth(pixs);
+  int height = pixGetHeight(pixs);
+  // A pixel of the result only depends on the source pixels within a brick
+  // size of it across the bands, even after the two passes of an opening
+  // or closing, so each band is run with that much overlap and the overlap
+  // is dropped from its result.
+  bool row_bands = vsize <= hsize;
+  int overlap = row_bands ? vsize : hsize;
+  int length = row_bands ? height : width;
+  int num_bands = IntraOpThreads(kNumBands);
+  int max_bands = length / (kMinBandsPerOverlap * (overlap + 1));
+  if (num_bands > max_bands) num_bands = max_bands;
+  if (num_bands < 2) return BrickMorph(op, pixs, hsize, vsize);
+
+  int band_length = (length + num_bands - 1) / num_bands;
+  if (!row_bands) {
+    band_length = (band_length + kBandColumnAlignment - 1) /
+                  kBandColumnAlignment * kBandColumnAlignment;
+  }
+  Pix* pixd = pixCreateTemplate(pixs);
+  std::atomic<bool> ok(true);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_bands)
+#endif  // _OPENMP
+  for (int b = 0; b < num_bands; ++b) {
+    int start = b * band_length;
+    int end = start + band_length < length ? start + band_length : length;
+    if (start >= end) continue;
+    int src_start = start > overlap ? start - overlap : 0;
+    int src_end = end + overlap < length ? end + overlap : length;
+    Box* box = row_bands
+        ? boxCreate(0, src_start, width, src_end - src_start)
+        : boxCreate(src_start, 0, src_end - src_start, height);
+    Pix* band = pixClipRectangle(pixs, box, NULL);
+    boxDestroy(&box);
+    Pix* result = band != NULL ? BrickMorph(op, band, hsize, vsize) : NULL;
+    if (result == NULL) {
+      ok = false;
+    } else if (row_bands) {
+      pixRasterop(pixd, 0, start, width, end - start, PIX_SRC, result, 0,
+                  start - src_start);
+    } else {
+      pixRasterop(pixd, start, 0, end - start, height, PIX_SRC, result,
+                  start - src_start, 0);
+    }
+    pixDestroy(&result);
+    pixDestroy(&band);
+  }
+  if (!ok) {
+    pixDestroy(&pixd);
+    return BrickMorph(op, pixs, hsize, vsize);
+  }
+  return pixd;
+}
+
+}  // namespace tesseract.
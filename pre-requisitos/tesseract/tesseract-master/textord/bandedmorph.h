@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////
+// File:        bandedmorph.h
+// Description: Brick morphology of binary images in parallel bands.
+//
+// (C) Copyright 2017, Agencia Nacional de Telecomunicacoes
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_TEXTORD_BANDEDMORPH_H_
+#define TESSERACT_TEXTORD_BANDEDMORPH_H_
+
+struct Pix;
+
+namespace tesseract {
+
+// The brick operations of leptonica that BandedBrickMorph can run.
+enum BrickOp {
+  BRICK_DILATE,  // pixDilateBrick
+  BRICK_ERODE,   // pixErodeBrick
+  BRICK_OPEN,    // pixOpenBrick
+  BRICK_CLOSE,   // pixCloseBrick
+};
+
+// Returns a new image, pixel for pixel the one that the leptonica function
+// of op gives for the 1 bpp pixs and a brick of hsize x vsize. The image
+// is cut into overlapping bands across the shorter side of the brick, which
+// are processed on up to IntraOpThreads threads, and bricks of the sizes
+// that have DWA code are run with it, where it is faster.
+Pix* BandedBrickMorph(BrickOp op, Pix* pixs, int hsize, int vsize);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_TEXTORD_BANDEDMORPH_H_
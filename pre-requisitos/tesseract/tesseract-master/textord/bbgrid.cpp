@@ -22,8 +22,17 @@
 #include "helpers.h"
 #include "ocrblock.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace tesseract {
 
+#ifdef __SSE2__
+// The number of boxes that PackedBoxes::FirstOverlap tests at a time.
+const int kPackedLanes = 8;
+#endif
+
 ///////////////////////////////////////////////////////////////////////
 // BBGrid IMPLEMENTATION.
 ///////////////////////////////////////////////////////////////////////
@@ -208,6 +217,64 @@ Pix* IntGrid::ThresholdToPix(int threshold) const {
   return pix;
 }
 
+void PackedBoxes::clear() {
+  left_.truncate(0);
+  bottom_.truncate(0);
+  right_.truncate(0);
+  top_.truncate(0);
+}
+
+void PackedBoxes::push_back(const TBOX& box) {
+  left_.push_back(box.left());
+  bottom_.push_back(box.bottom());
+  right_.push_back(box.right());
+  top_.push_back(box.top());
+}
+
+// Returns the index of the first of the boxes in [start, end) that
+// overlaps rect, as TBOX::overlap does, or end if none of them do.
+int PackedBoxes::FirstOverlap(const TBOX& rect, int start, int end) const {
+  int i = start;
+#ifdef __SSE2__
+  if (end - i >= kPackedLanes) {
+    __m128i rect_left = _mm_set1_epi16(rect.left());
+    __m128i rect_bottom = _mm_set1_epi16(rect.bottom());
+    __m128i rect_right = _mm_set1_epi16(rect.right());
+    __m128i rect_top = _mm_set1_epi16(rect.top());
+    for (; i + kPackedLanes <= end; i += kPackedLanes) {
+      __m128i left =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(&left_[i]));
+      __m128i bottom =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(&bottom_[i]));
+      __m128i right =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(&right_[i]));
+      __m128i top =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(&top_[i]));
+      __m128i miss = _mm_or_si128(
+          _mm_or_si128(_mm_cmpgt_epi16(left, rect_right),
+                       _mm_cmpgt_epi16(rect_left, right)),
+          _mm_or_si128(_mm_cmpgt_epi16(bottom, rect_top),
+                       _mm_cmpgt_epi16(rect_bottom, top)));
+      // Two mask bits for each box, clear where it overlaps.
+      int hits = ~_mm_movemask_epi8(miss) & 0xffff;
+      if (hits != 0) {
+        while ((hits & 1) == 0) {
+          hits >>= 2;
+          ++i;
+        }
+        return i;
+      }
+    }
+  }
+#endif  // __SSE2__
+  for (; i < end; ++i) {
+    if (left_[i] <= rect.right() && right_[i] >= rect.left() &&
+        bottom_[i] <= rect.top() && top_[i] >= rect.bottom())
+      return i;
+  }
+  return end;
+}
+
 // Make a Pix of the correct scaled size for the TraceOutline functions.
 Pix* GridReducedPix(const TBOX& box, int gridsize,
                     ICOORD bleft, int* left, int* bottom) {
@@ -25,6 +25,7 @@
 
 #include "clst.h"
 #include "coutln.h"
+#include "genericvector.h"
 #include "rect.h"
 #include "scrollview.h"
 
@@ -142,6 +143,24 @@ class IntGrid : public GridBase {
   int* grid_;  // 2-d array of ints.
 };
 
+// The bounding boxes of the elements of a packed BBGrid, with each
+// coordinate in an array of its own, so several boxes can be tested at once.
+class PackedBoxes {
+ public:
+  void clear();
+  void push_back(const TBOX& box);
+
+  // Returns the index of the first of the boxes in [start, end) that
+  // overlaps rect, as TBOX::overlap does, or end if none of them do.
+  int FirstOverlap(const TBOX& rect, int start, int end) const;
+
+ private:
+  GenericVector<inT16> left_;
+  GenericVector<inT16> bottom_;
+  GenericVector<inT16> right_;
+  GenericVector<inT16> top_;
+};
+
 // The BBGrid class holds C_LISTs of template classes BBC (bounding box class)
 // in a grid for fast neighbour access.
 // The BBC class must have a member const TBOX& bounding_box() const.
@@ -197,6 +216,18 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class BBGrid
   // If a GridSearch is operating, call GridSearch::RemoveBBox() instead.
   void RemoveBBox(BBC* bbox);
 
+  // Makes a contiguous copy of all the cells, with the bounding boxes of
+  // their elements, which all GridSearches scan instead of the lists until
+  // the grid next changes. Use before searching a lot in a grid that will not
+  // change for a while. The bounding boxes of the elements must not change
+  // while the copy is in use.
+  void PackCells();
+  // Drops the packed copy, as must be done before changing any of the
+  // bounding boxes of the elements without removing them from the grid.
+  void UnpackCells() {
+    packed_id_ = 0;
+  }
+
   // Returns true if the given rectangle has no overlapping elements.
   bool RectangleEmpty(const TBOX& rect);
 
@@ -222,6 +253,16 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class BBGrid
   BBC_CLIST* grid_;  // 2-d array of CLISTS of BBC elements.
 
  private:
+  // Nonzero while the packed copy below matches grid_, and different for
+  // each copy made.
+  int packed_id_;
+  // The number of packed copies made so far.
+  int pack_count_;
+  // Index in packed_data_ of the first element of each cell, and the total.
+  GenericVector<int> packed_starts_;
+  // The elements of all the cells, one cell after another.
+  GenericVector<BBC*> packed_data_;
+  PackedBoxes packed_boxes_;
 };
 
 // Hash functor for generic pointers.
@@ -237,7 +278,7 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class GridSearch {
  public:
   GridSearch(BBGrid<BBC, BBC_CLIST, BBC_C_IT>* grid)
       : grid_(grid), unique_mode_(false),
-        previous_return_(NULL), next_return_(NULL) {
+        previous_return_(NULL), next_return_(NULL), packed_id_(0) {
   }
 
   // Get the grid x, y coords of the most recently returned BBC.
@@ -344,6 +385,17 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class GridSearch {
   // Factored out function to set the iterator to the current x_, y_
   // grid coords and mark the cycle pt.
   void SetIterator();
+  // Returns true if the current cell has no more elements to return.
+  bool CellDone();
+  // Moves past the elements of the packed cell that do not overlap rect_,
+  // returning false if none of the rest of the cell does.
+  bool FindPackedOverlap();
+  // Moves the search from the packed copy back to the same place in the list
+  // of the current cell, as the grid is about to change or has changed.
+  void LeavePackedCell();
+  // Moves the iterator to just past previous_return_, or, if it has gone,
+  // to next_return_, in the list of the current cell.
+  void RepositionInCell();
 
  private:
   // The grid we are searching.
@@ -364,6 +416,15 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class GridSearch {
   BBC* next_return_;  // Current value of it_.data() used for repositioning.
   // An iterator over the list at (x_, y_) in the grid_.
   BBC_C_IT it_;
+  // The packed_id_ of the copy of the grid the search is using instead of
+  // it_, or 0 if it is using it_.
+  int packed_id_;
+  // The cell being searched in the packed copy, the index of its next
+  // element, and the start and end of its elements.
+  int pack_cell_;
+  int pack_index_;
+  int pack_start_;
+  int pack_end_;
   // Set of unique returned elements used when unique_mode_ is true.
   std::unordered_set<BBC*, PtrHash<BBC> > returns_;
 };
@@ -426,13 +487,14 @@ int SortByBoxBottom(const void* void1, const void* void2) {
 // BBGrid IMPLEMENTATION.
 ///////////////////////////////////////////////////////////////////////
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
-BBGrid<BBC, BBC_CLIST, BBC_C_IT>::BBGrid() : grid_(NULL) {
+BBGrid<BBC, BBC_CLIST, BBC_C_IT>::BBGrid()
+    : grid_(NULL), packed_id_(0), pack_count_(0) {
 }
 
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBGrid<BBC, BBC_CLIST, BBC_C_IT>::BBGrid(
   int gridsize, const ICOORD& bleft, const ICOORD& tright)
-    : grid_(NULL) {
+    : grid_(NULL), packed_id_(0), pack_count_(0) {
   Init(gridsize, bleft, tright);
 }
 
@@ -452,11 +514,13 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Init(int gridsize,
   if (grid_ != NULL)
     delete [] grid_;
   grid_ = new BBC_CLIST[gridbuckets_];
+  packed_id_ = 0;
 }
 
 // Clear all lists, but leave the array of lists present.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Clear() {
+  packed_id_ = 0;
   for (int i = 0; i < gridbuckets_; ++i) {
     grid_[i].shallow_clear();
   }
@@ -476,6 +540,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::ClearGridData(
   while ((bb = search.NextFullSearch()) != NULL) {
     it.add_after_then_move(bb);
   }
+  packed_id_ = 0;
   for (it.mark_cycle_pt(); !it.cycled_list(); it.forward()) {
     free_method(it.data());
   }
@@ -497,6 +562,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertBBox(bool h_spread, bool v_spread,
     end_x = start_x;
   if (!v_spread)
     end_y = start_y;
+  packed_id_ = 0;
   int grid_index = start_y * gridwidth_;
   for (int y = start_y; y <= end_y; ++y, grid_index += gridwidth_) {
     for (int x = start_x; x <= end_x; ++x) {
@@ -519,6 +585,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertPixPtBBox(int left, int bottom,
                                                        Pix* pix, BBC* bbox) {
   int width = pixGetWidth(pix);
   int height = pixGetHeight(pix);
+  packed_id_ = 0;
   for (int y = 0; y < height; ++y) {
     l_uint32* data = pixGetData(pix) + y * pixGetWpl(pix);
     for (int x = 0; x < width; ++x) {
@@ -539,6 +606,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::RemoveBBox(BBC* bbox) {
   int start_x, start_y, end_x, end_y;
   GridCoords(box.left(), box.bottom(), &start_x, &start_y);
   GridCoords(box.right(), box.top(), &end_x, &end_y);
+  packed_id_ = 0;
   int grid_index = start_y * gridwidth_;
   for (int y = start_y; y <= end_y; ++y, grid_index += gridwidth_) {
     for (int x = start_x; x <= end_x; ++x) {
@@ -551,6 +619,25 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::RemoveBBox(BBC* bbox) {
   }
 }
 
+// Makes a contiguous copy of all the cells, which all GridSearches scan
+// instead of the lists until the grid next changes.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::PackCells() {
+  packed_starts_.truncate(0);
+  packed_data_.truncate(0);
+  packed_boxes_.clear();
+  for (int i = 0; i < gridbuckets_; ++i) {
+    packed_starts_.push_back(packed_data_.size());
+    BBC_C_IT it(&grid_[i]);
+    for (it.mark_cycle_pt(); !it.cycled_list(); it.forward()) {
+      packed_data_.push_back(it.data());
+      packed_boxes_.push_back(it.data()->bounding_box());
+    }
+  }
+  packed_starts_.push_back(packed_data_.size());
+  packed_id_ = ++pack_count_;
+}
+
 // Returns true if the given rectangle has no overlapping elements.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 bool BBGrid<BBC, BBC_CLIST, BBC_C_IT>::RectangleEmpty(const TBOX& rect) {
@@ -680,7 +767,7 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextFullSearch() {
   int x;
   int y;
   do {
-    while (it_.cycled_list()) {
+    while (CellDone()) {
       ++x_;
       if (x_ >= grid_->gridwidth_) {
         --y_;
@@ -716,7 +803,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartRadSearch(int x, int y,
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRadSearch() {
   do {
-    while (it_.cycled_list()) {
+    while (CellDone()) {
       ++rad_index_;
       if (rad_index_ >= radius_) {
         ++rad_dir_;
@@ -764,7 +851,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartSideSearch(int x,
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextSideSearch(bool right_to_left) {
   do {
-    while (it_.cycled_list()) {
+    while (CellDone()) {
       ++rad_index_;
       if (rad_index_ > radius_) {
         if (right_to_left)
@@ -806,7 +893,7 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextVerticalSearch(
     bool top_to_bottom) {
   do {
-    while (it_.cycled_list()) {
+    while (CellDone()) {
       ++rad_index_;
       if (rad_index_ > radius_) {
         if (top_to_bottom)
@@ -845,7 +932,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartRectSearch(const TBOX& rect) {
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRectSearch() {
   do {
-    while (it_.cycled_list()) {
+    while (CellDone() || (packed_id_ != 0 && !FindPackedOverlap())) {
       ++x_;
       if (x_ > max_radius_) {
         --y_;
@@ -869,6 +956,7 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRectSearch() {
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::RemoveBBox() {
   if (previous_return_ != NULL) {
+    if (packed_id_ != 0) LeavePackedCell();
     // Remove all instances of previous_return_ from the list, so the iterator
     // remains valid after removal from the rest of the grid cells.
     // if previous_return_ is not on the list, then it has been removed already.
@@ -897,6 +985,18 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::RepositionIterator() {
   // Something was deleted, so we have little choice but to clear the
   // returns list.
   returns_.clear();
+  if (packed_id_ != 0) {
+    // If the copy is still in use, nothing has changed.
+    if (grid_->packed_id_ != packed_id_) LeavePackedCell();
+    return;
+  }
+  RepositionInCell();
+}
+
+// Moves the iterator to just past previous_return_, or, if it has gone,
+// to next_return_, in the list of the current cell.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::RepositionInCell() {
   // Reset the iterator back to one past the previous return.
   // If the previous_return_ is no longer in the list, then
   // next_return_ serves as a backup.
@@ -928,13 +1028,24 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonStart(int x, int y) {
   y_ = y_origin_;
   SetIterator();
   previous_return_ = NULL;
-  next_return_ = it_.empty() ? NULL : it_.data();
+  if (packed_id_ != 0) {
+    next_return_ = pack_index_ < pack_end_
+                 ? grid_->packed_data_[pack_index_] : NULL;
+  } else {
+    next_return_ = it_.empty() ? NULL : it_.data();
+  }
   returns_.clear();
 }
 
 // Factored out helper to complete a next search.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonNext() {
+  if (packed_id_ != 0) {
+    previous_return_ = grid_->packed_data_[pack_index_++];
+    next_return_ = pack_index_ < pack_end_
+                 ? grid_->packed_data_[pack_index_] : NULL;
+    return previous_return_;
+  }
   previous_return_ = it_.data();
   it_.forward();
   next_return_ = it_.cycled_list() ? NULL : it_.data();
@@ -953,8 +1064,55 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonEnd() {
 // grid coords and mark the cycle pt.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::SetIterator() {
-  it_= &(grid_->grid_[y_ * grid_->gridwidth_ + x_]);
+  int cell = y_ * grid_->gridwidth_ + x_;
+  packed_id_ = grid_->packed_id_;
+  if (packed_id_ != 0) {
+    pack_cell_ = cell;
+    pack_start_ = grid_->packed_starts_[cell];
+    pack_index_ = pack_start_;
+    pack_end_ = grid_->packed_starts_[cell + 1];
+  } else {
+    it_= &(grid_->grid_[cell]);
+    it_.mark_cycle_pt();
+  }
+}
+
+// Returns true if the current cell has no more elements to return.
+// A search that finds the packed copy gone carries on in the lists.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+bool GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CellDone() {
+  if (packed_id_ != 0 && grid_->packed_id_ != packed_id_)
+    LeavePackedCell();
+  return packed_id_ != 0 ? pack_index_ >= pack_end_ : it_.cycled_list();
+}
+
+// Moves past the elements of the packed cell that do not overlap rect_,
+// returning false if none of the rest of the cell does.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+bool GridSearch<BBC, BBC_CLIST, BBC_C_IT>::FindPackedOverlap() {
+  pack_index_ = grid_->packed_boxes_.FirstOverlap(rect_, pack_index_,
+                                                  pack_end_);
+  return pack_index_ < pack_end_;
+}
+
+// Moves the search from the packed copy back to the same place in the list
+// of the current cell, as the grid is about to change or has changed.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::LeavePackedCell() {
+  packed_id_ = 0;
+  it_= &(grid_->grid_[pack_cell_]);
   it_.mark_cycle_pt();
+  if (pack_index_ == pack_start_) {
+    // Nothing has been returned from this cell yet.
+    next_return_ = it_.empty() ? NULL : it_.data();
+  } else if (pack_index_ >= pack_end_) {
+    // Everything has been returned from this cell.
+    while (!it_.cycled_list())
+      it_.forward();
+    next_return_ = NULL;
+  } else {
+    RepositionInCell();
+  }
 }
 
 }  // namespace tesseract.
@@ -27,6 +27,8 @@
 #include "config_auto.h"
 #endif
 
+#include <time.h>
+
 #include "colfind.h"
 
 #include "ccnontextdetect.h"
@@ -82,7 +84,8 @@ ColumnFinder::ColumnFinder(int gridsize,
                            int vertical_x, int vertical_y)
   : TabFind(gridsize, bleft, tright, vlines, vertical_x, vertical_y,
             resolution),
-    cjk_script_(cjk_script),
+    cjk_script_(cjk_script), fast_single_column_(false),
+    single_column_page_(false), single_column_check_secs_(0.0),
     min_gutter_width_(static_cast<int>(kMinGutterWidthGrid * gridsize)),
     mean_column_gap_(tright.x() - bleft.x()),
     tabfind_aligned_gap_fraction_(aligned_gap_fraction),
@@ -312,6 +315,17 @@ int ColumnFinder::FindBlocks(PageSegMode pageseg_mode, Pix* scaled_color,
                                    input_block, this, pixa_debug, &part_grid_,
                                    &big_parts_);
   }
+  if (fast_single_column_ && PSM_COL_FIND_ENABLED(pageseg_mode) &&
+      !PSM_SPARSE(pageseg_mode) && rotation_.x() == 1.0f) {
+    // The textline projection is cheap to test, and on a single column page
+    // it saves finding the tab stops and tables.
+    clock_t start_t = clock();
+    single_column_page_ = projection_.IsSingleColumn(gridsize());
+    if (single_column_page_)
+      pageseg_mode = PSM_SINGLE_COLUMN;
+    single_column_check_secs_ =
+        static_cast<double>(clock() - start_t) / CLOCKS_PER_SEC;
+  }
   part_grid_.ReTypeBlobs(&image_bblobs_);
   TidyBlobs(input_block);
   Reset();
@@ -417,7 +431,7 @@ int ColumnFinder::FindBlocks(PageSegMode pageseg_mode, Pix* scaled_color,
     if (equation_detect_) {
       equation_detect_->FindEquationParts(&part_grid_, best_columns_);
     }
-    if (textord_tabfind_find_tables) {
+    if (textord_tabfind_find_tables && !single_column_page_) {
       TableFinder table_finder;
       table_finder.Init(gridsize(), bleft(), tright());
       table_finder.set_resolution(resolution_);
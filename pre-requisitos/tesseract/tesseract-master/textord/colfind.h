@@ -77,6 +77,19 @@ class ColumnFinder : public TabFind {
   void set_cjk_script(bool is_cjk) {
     cjk_script_ = is_cjk;
   }
+  // If fast, FindBlocks skips finding tab stops and tables on pages that look
+  // like a single column of text, as if the mode was PSM_SINGLE_COLUMN.
+  void set_fast_single_column(bool fast) {
+    fast_single_column_ = fast;
+  }
+  // Returns true if FindBlocks took the fast path for a single column page.
+  bool single_column_page() const {
+    return single_column_page_;
+  }
+  // Returns the processor time FindBlocks spent deciding on the fast path.
+  double single_column_check_secs() const {
+    return single_column_check_secs_;
+  }
 
   // ======================================================================
   // The main function of ColumnFinder is broken into pieces to facilitate
@@ -301,6 +314,11 @@ class ColumnFinder : public TabFind {
   // If true then the page language is cjk, so it is safe to perform
   // FixBrokenCJK.
   bool cjk_script_;
+  // Set by set_fast_single_column.
+  bool fast_single_column_;
+  // True if the page looked like a single column in the fast path check.
+  bool single_column_page_;
+  double single_column_check_secs_;
   // The minimum gutter width to apply for finding columns.
   // Modified when vertical text is detected to prevent detection of
   // vertical text lines as columns.
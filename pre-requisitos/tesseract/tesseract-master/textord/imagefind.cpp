@@ -58,6 +58,21 @@ const int kMinColorDifference = 16;
 // will fatten out too much and have to be clipped to text.
 const int kNoisePadding = 4;
 
+// Returns true if pixr, a binary page at 2x reduction, has the dense regions
+// that pixGenerateHalftoneMask seeds its mask from: whatever survives a
+// further 8x rank cascade reduction and an opening. Without them the mask is
+// empty, so on pages of text the far more costly closing and seed fill of the
+// whole page can be skipped, with the same result.
+static bool HasHalftoneSeed(Pix* pixr) {
+  Pix* pixseed = pixReduceRankBinaryCascade(pixr, 4, 4, 3, 0);
+  if (pixseed == NULL) return true;
+  pixOpenBrick(pixseed, pixseed, 5, 5);
+  l_int32 empty = 1;
+  pixZero(pixseed, &empty);
+  pixDestroy(&pixseed);
+  return !empty;
+}
+
 // Finds image regions within the BINARY source pix (page image) and returns
 // the image regions as a mask image.
 // The returned pix may be NULL, meaning no images found.
@@ -84,11 +99,16 @@ Pix* ImageFind::FindImages(Pix* pix, DebugPixa* pixa_debug) {
     pixDestroy(&pixr);
     return pixCreate(pixGetWidth(pix), pixGetHeight(pix), 1);
   }
-  // Get the halftone mask.
-  l_int32 ht_found = 0;
   Pixa* pixadb = (textord_tabfind_show_images && pixa_debug != nullptr)
                      ? pixaCreate(0)
                      : nullptr;
+  // Most pages have no images, which the seed alone shows.
+  if (pixadb == nullptr && !HasHalftoneSeed(pixr)) {
+    pixDestroy(&pixr);
+    return pixCreate(pixGetWidth(pix), pixGetHeight(pix), 1);
+  }
+  // Get the halftone mask.
+  l_int32 ht_found = 0;
   Pix* pixht2 = pixGenerateHalftoneMask(pixr, NULL, &ht_found, pixadb);
   if (pixadb) {
     Pix* pixdb = pixaDisplayTiledInColumns(pixadb, 3, 1.0, 20, 2);
@@ -27,6 +27,7 @@
 #endif
 
 #include "linefind.h"
+#include "bandedmorph.h"
 #include "alignedblob.h"
 #include "tabvector.h"
 #include "blobbox.h"
@@ -603,13 +604,14 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
   // Close up small holes, making it less likely that false alarms are found
   // in thickened text (as it will become more solid) and also smoothing over
   // some line breaks and nicks in the edges of the lines.
-  pix_closed = pixCloseBrick(NULL, src_pix, closing_brick, closing_brick);
+  pix_closed = BandedBrickMorph(BRICK_CLOSE, src_pix, closing_brick,
+                                closing_brick);
   if (pixa_display != NULL)
     pixaAddPix(pixa_display, pix_closed, L_CLONE);
   // Open up with a big box to detect solid areas, which can then be subtracted.
   // This is very generous and will leave in even quite wide lines.
-  Pix* pix_solid = pixOpenBrick(NULL, pix_closed, max_line_width,
-                                max_line_width);
+  Pix* pix_solid = BandedBrickMorph(BRICK_OPEN, pix_closed, max_line_width,
+                                    max_line_width);
   if (pixa_display != NULL)
     pixaAddPix(pixa_display, pix_solid, L_CLONE);
   pix_hollow = pixSubtract(NULL, pix_closed, pix_solid);
@@ -620,8 +622,8 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
   // 1 inch/kMinLineLengthFraction in length.
   if (pixa_display != NULL)
     pixaAddPix(pixa_display, pix_hollow, L_CLONE);
-  *pix_vline = pixOpenBrick(NULL, pix_hollow, 1, min_line_length);
-  *pix_hline = pixOpenBrick(NULL, pix_hollow, min_line_length, 1);
+  *pix_vline = BandedBrickMorph(BRICK_OPEN, pix_hollow, 1, min_line_length);
+  *pix_hline = BandedBrickMorph(BRICK_OPEN, pix_hollow, min_line_length, 1);
 
   pixDestroy(&pix_hollow);
 #ifdef USE_OPENCL
@@ -658,7 +660,8 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
       // and vice versa.
       extra_non_hlines = pixSubtract(NULL, *pix_vline, *pix_intersections);
     }
-    *pix_non_vline = pixErodeBrick(NULL, pix_nonlines, kMaxLineResidue, 1);
+    *pix_non_vline =
+        BandedBrickMorph(BRICK_ERODE, pix_nonlines, kMaxLineResidue, 1);
     pixSeedfillBinary(*pix_non_vline, *pix_non_vline, pix_nonlines, 8);
     if (!h_empty) {
       // Candidate hlines are not vlines.
@@ -683,7 +686,8 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
       return;
     }
   } else {
-    *pix_non_hline = pixErodeBrick(NULL, pix_nonlines, 1, kMaxLineResidue);
+    *pix_non_hline =
+        BandedBrickMorph(BRICK_ERODE, pix_nonlines, 1, kMaxLineResidue);
     pixSeedfillBinary(*pix_non_hline, *pix_non_hline, pix_nonlines, 8);
     if (extra_non_hlines != NULL) {
       pixOr(*pix_non_hline, *pix_non_hline, extra_non_hlines);
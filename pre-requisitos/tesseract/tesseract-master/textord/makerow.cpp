@@ -29,6 +29,7 @@
 #include          "blkocc.h"
 #include          "sortflts.h"
 #include          "oldbasel.h"
+#include          "opthreads.h"
 #include          "textord.h"
 #include          "tordmain.h"
 #include          "underlin.h"
@@ -105,6 +106,8 @@ BOOL_VAR(textord_debug_blob, FALSE, "Print test blob information");
 #define MAX_HEIGHT_MODES  12
 
 const int kMinLeaderCount = 5;
+// Number of threads of the per-block passes of the layout by default.
+const int kNumBlockThreads = 4;
 
 // Factored-out helper to build a single row from a list of blobs.
 // Returns the mean blob size.
@@ -201,24 +204,49 @@ float make_single_row(ICOORD page_tr, bool allow_sub_blobs,
 float make_rows(ICOORD page_tr, TO_BLOCK_LIST *port_blocks) {
   float port_m;                  // global skew
   float port_err;                // global noise
-  TO_BLOCK_IT block_it;          // iterator
-
-  block_it.set_to_list(port_blocks);
-  for (block_it.mark_cycle_pt(); !block_it.cycled_list();
-       block_it.forward())
-  make_initial_textrows(page_tr, block_it.data(), FCOORD(1.0f, 0.0f),
-      !(BOOL8) textord_test_landscape);
+  GenericVector<TO_BLOCK*> blocks;
+  // The blocks only share the page skew, which is found in between.
+  GatherBlocks(port_blocks, &blocks);
+#ifdef _OPENMP
+  int num_threads = BlockPassThreads(blocks, textord_show_initial_rows);
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1) \
+    schedule(dynamic)
+#endif
+  for (int b = 0; b < blocks.size(); ++b) {
+    make_initial_textrows(page_tr, blocks[b], FCOORD(1.0f, 0.0f),
+                          !(BOOL8) textord_test_landscape);
+  }
                                  // compute globally
   compute_page_skew(port_blocks, port_m, port_err);
-  block_it.set_to_list(port_blocks);
-  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
-    cleanup_rows_making(page_tr, block_it.data(), port_m, FCOORD(1.0f, 0.0f),
-                 block_it.data()->block->bounding_box().left(),
-                 !(BOOL8)textord_test_landscape);
+  GatherBlocks(port_blocks, &blocks);
+#ifdef _OPENMP
+  num_threads = BlockPassThreads(
+      blocks, textord_show_parallel_rows || textord_show_expanded_rows ||
+              textord_show_final_rows || textord_show_final_blobs);
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1) \
+    schedule(dynamic)
+#endif
+  for (int b = 0; b < blocks.size(); ++b) {
+    cleanup_rows_making(page_tr, blocks[b], port_m, FCOORD(1.0f, 0.0f),
+                        blocks[b]->block->bounding_box().left(),
+                        !(BOOL8)textord_test_landscape);
   }
   return port_m;                 // global skew
 }
 
+void GatherBlocks(TO_BLOCK_LIST *block_list, GenericVector<TO_BLOCK*> *blocks) {
+  blocks->truncate(0);
+  TO_BLOCK_IT block_it(block_list);
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward())
+    blocks->push_back(block_it.data());
+}
+
+int BlockPassThreads(const GenericVector<TO_BLOCK*> &blocks, bool serial) {
+  if (serial) return 1;
+  int num_threads = tesseract::IntraOpThreads(kNumBlockThreads);
+  return MIN(num_threads, blocks.size());
+}
+
 /**
  * @name make_initial_textrows
  *
@@ -24,6 +24,7 @@
 #include          "ocrblock.h"
 #include          "blobs.h"
 #include          "blobbox.h"
+#include          "genericvector.h"
 #include          "statistc.h"
 
 enum OVERLAP_STATE
@@ -137,6 +138,12 @@ float make_single_row(ICOORD page_tr, bool allow_sub_blobs, TO_BLOCK* block,
                       TO_BLOCK_LIST* blocks);
 float make_rows(ICOORD page_tr,              // top right
                 TO_BLOCK_LIST *port_blocks);
+// Gathers the blocks of block_list, in order, for a pass that works on each
+// block alone.
+void GatherBlocks(TO_BLOCK_LIST *block_list, GenericVector<TO_BLOCK*> *blocks);
+// Returns the number of threads to run a pass over blocks on. That is 1 if
+// serial, which the caller sets when the pass draws or debugs.
+int BlockPassThreads(const GenericVector<TO_BLOCK*> &blocks, bool serial);
 void make_initial_textrows(ICOORD page_tr,
                            TO_BLOCK *block,  // block to do
                            FCOORD rotation,  // for drawing
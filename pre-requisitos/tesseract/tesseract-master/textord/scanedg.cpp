@@ -29,6 +29,44 @@
 // Flips between WHITE_PIX and BLACK_PIX.
 #define FLIP_COLOUR(pix)  (1-(pix))
 
+// Returns the index of the first (leftmost) set pixel of a non-zero word.
+static inline int first_pixel(uinT32 word) {
+#if defined(__GNUC__)
+  return __builtin_clz(word);
+#else
+  int index = 0;
+  while ((word & 0x80000000u) == 0) {
+    word <<= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
+
+// Returns the colour of pixel x of a packed line.
+static inline int line_pixel(const uinT32* line, int x) {
+  return (line[x >> 5] >> (31 - (x & 31))) & 1;
+}
+
+// Sets the pixels [start, end) of the packed line of the given width to
+// colour.
+static void set_pixels(uinT32* line, int width, int start, int end,
+                       uinT8 colour) {
+  if (start < 0) start = 0;
+  if (end > width) end = width;
+  for (int x = start; x < end;) {
+    int bit = x & 31;
+    int count = MIN(32 - bit, end - x);
+    uinT32 mask =
+        count == 32 ? ~0u : ((1u << count) - 1) << (32 - bit - count);
+    if (colour == WHITE_PIX)
+      line[x >> 5] |= mask;
+    else
+      line[x >> 5] &= ~mask;
+    x += count;
+  }
+}
+
 /**********************************************************************
  * block_edges
  *
@@ -54,28 +92,46 @@ void block_edges(Pix *t_pix,           // thresholded image
   for (int x = block_width; x >= 0; x--)
     ptrline[x] = NULL;           //  no lines in progress
 
-  uinT8* bwline = new uinT8[width];
+  // The current and previous lines, packed 32 pixels to a word like the
+  // image, but starting at bleft.x() and with WHITE_PIX as 1.
+  int line_wpl = block_width / 32 + 1;
+  uinT32* bwline = new uinT32[line_wpl];
+  uinT32* prevbwline = new uinT32[line_wpl];
 
   uinT8 margin = WHITE_PIX;
+  // Above the top line, everything is margin.
+  set_pixels(prevbwline, line_wpl * 32, 0, line_wpl * 32, margin);
 
+  int shift = bleft.x() & 31;
   for (int y = tright.y() - 1; y >= bleft.y() - 1; y--) {
     if (y >= bleft.y() && y < tright.y()) {
       // Get the binary pixels from the image.
-      l_uint32* line = pixGetData(t_pix) + wpl * (height - 1 - y);
-      for (int x = 0; x < block_width; ++x) {
-        bwline[x] = GET_DATA_BIT(line, x + bleft.x()) ^ 1;
+      const uinT32* line = pixGetData(t_pix) + wpl * (height - 1 - y) +
+                             (bleft.x() >> 5);
+      int src_words = wpl - (bleft.x() >> 5);
+      for (int i = 0; i < line_wpl; ++i) {
+        uinT32 word = i < src_words ? line[i] << shift : 0;
+        if (shift > 0 && i + 1 < src_words)
+          word |= line[i + 1] >> (32 - shift);
+        bwline[i] = ~word;
       }
+      // Anything past the block is margin too.
+      set_pixels(bwline, line_wpl * 32, block_width, line_wpl * 32, margin);
       make_margins(block, &line_it, bwline, margin, bleft.x(), tright.x(), y);
     } else {
-      memset(bwline, margin, block_width * sizeof(bwline[0]));
+      set_pixels(bwline, line_wpl * 32, 0, line_wpl * 32, margin);
     }
     line_edges(bleft.x(), y, block_width,
-               margin, bwline, ptrline, &free_cracks, outline_it);
+               margin, bwline, prevbwline, ptrline, &free_cracks, outline_it);
+    uinT32* tmp = prevbwline;
+    prevbwline = bwline;
+    bwline = tmp;
   }
 
   free_crackedges(free_cracks);  // really free them
   delete[] ptrline;
   delete[] bwline;
+  delete[] prevbwline;
 }
 
 
@@ -88,7 +144,7 @@ void block_edges(Pix *t_pix,           // thresholded image
 void make_margins(                         //get a line
                   PDBLK *block,            //block in image
                   BLOCK_LINE_IT *line_it,  //for old style
-                  uinT8 *pixels,           //pixels to strip
+                  uinT32 *pixels,        //packed pixels to strip
                   uinT8 margin,            //white-out pixel
                   inT16 left,              //block edges
                   inT16 right,
@@ -99,6 +155,7 @@ void make_margins(                         //get a line
   inT32 start;                   //of segment
   inT16 xext;                    //of segment
   int xindex;                    //index to pixel
+  int width = right - left;
 
   if (block->poly_block () != NULL) {
     lines = new PB_LINE_IT (block->poly_block ());
@@ -109,29 +166,30 @@ void make_margins(                         //get a line
       seg_it.mark_cycle_pt ();
       start = seg_it.data ()->x ();
       xext = seg_it.data ()->y ();
-      for (xindex = left; xindex < right; xindex++) {
+      // Keep each segment and set the gaps between them to margin, a run at
+      // a time.
+      for (xindex = left; xindex < right;) {
         if (xindex >= start && !seg_it.cycled_list ()) {
-          xindex = start + xext - 1;
+          xindex = start + xext;
           seg_it.forward ();
           start = seg_it.data ()->x ();
           xext = seg_it.data ()->y ();
+        } else {
+          int end = seg_it.cycled_list() ? right : MIN(start, right);
+          set_pixels(pixels, width, xindex - left, end - left, margin);
+          xindex = end;
         }
-        else
-          pixels[xindex - left] = margin;
       }
     }
     else {
-      for (xindex = left; xindex < right; xindex++)
-        pixels[xindex - left] = margin;
+      set_pixels(pixels, width, 0, width, margin);
     }
     delete lines;
   }
   else {
     start = line_it->get_line (y, xext);
-    for (xindex = left; xindex < start; xindex++)
-      pixels[xindex - left] = margin;
-    for (xindex = start + xext; xindex < right; xindex++)
-      pixels[xindex - left] = margin;
+    set_pixels(pixels, width, 0, start - left, margin);
+    set_pixels(pixels, width, start + xext - left, width, margin);
   }
 }
 
@@ -140,70 +198,98 @@ void make_margins(                         //get a line
  *
  * Scan a line for edges and update the edges in progress.
  * When edges close into loops, send them for approximation.
+ * Pixels that have the colour of the pixels above and to the left, with
+ * no edge above, change nothing, so they are skipped a word at a time.
  **********************************************************************/
 
 void line_edges(inT16 x,                         // coord of line start
                 inT16 y,                         // coord of line
                 inT16 xext,                      // width of line
                 uinT8 uppercolour,               // start of prev line
-                uinT8 * bwpos,                   // thresholded line
+                const uinT32* bwline,          // packed thresholded line
+                const uinT32* prevbwline,      // the line above
                 CRACKEDGE ** prevline,           // edges in progress
                 CRACKEDGE **free_cracks,
                 C_OUTLINE_IT* outline_it) {
   CrackPos pos = {free_cracks, x, y };
-  int xmax;                      // max x coord
   int colour;                    // of current pixel
   int prevcolour;                // of previous pixel
   CRACKEDGE *current;            // current h edge
   CRACKEDGE *newcurrent;         // new h edge
 
-  xmax = x + xext;               // max allowable coord
   prevcolour = uppercolour;      // forced plain margin
   current = NULL;                // nothing yet
-
-                                 // do each pixel
-  for (; pos.x < xmax; pos.x++, prevline++) {
-    colour = *bwpos++;           // current pixel
-    if (*prevline != NULL) {
+  // The pixels left of the line are margin.
+  uinT32 left_bit = uppercolour;
+  uinT32 left_upper_bit = uppercolour;
+  int num_words = (xext + 31) / 32;
+  for (int w = 0; w < num_words; ++w) {
+    uinT32 pixels = bwline[w];
+    uinT32 upper_pixels = prevbwline[w];
+    // Flag the pixels that differ from the pixel above or to their left, or
+    // whose pixel above differs from its left neighbour (an edge above).
+    uinT32 changes = (pixels ^ upper_pixels) |
+                       (pixels ^ ((pixels >> 1) | (left_bit << 31))) |
+                       (upper_pixels ^
+                        ((upper_pixels >> 1) | (left_upper_bit << 31)));
+    left_bit = pixels & 1;
+    left_upper_bit = upper_pixels & 1;
+    int word_end = MIN(32, xext - w * 32);
+    if (word_end < 32) changes &= ~0u << (32 - word_end);
+    int bit = 0;
+    while (changes != 0) {
+      int next = first_pixel(changes);
+      // There is no edge at a skipped pixel.
+      if (next > bit) current = NULL;
+      int i = w * 32 + next;
+      pos.x = x + i;
+      colour = line_pixel(bwline, i);
+      if (prevline[i] != NULL) {
                                  // changed above
                                  // change colour
-      uppercolour = FLIP_COLOUR(uppercolour);
-      if (colour == prevcolour) {
-        if (colour == uppercolour) {
+        uppercolour = FLIP_COLOUR(uppercolour);
+        if (colour == prevcolour) {
+          if (colour == uppercolour) {
                                  // finish a line
-          join_edges(current, *prevline, free_cracks, outline_it);
-          current = NULL;        // no edge now
-        } else {
+            join_edges(current, prevline[i], free_cracks, outline_it);
+            current = NULL;      // no edge now
+          } else {
                                  // new horiz edge
-          current = h_edge(uppercolour - colour, *prevline, &pos);
+            current = h_edge(uppercolour - colour, prevline[i], &pos);
+          }
+          prevline[i] = NULL;    // no change this time
+        } else {
+          if (colour == uppercolour)
+            prevline[i] = v_edge(colour - prevcolour, prevline[i], &pos);
+                                 // 8 vs 4 connection
+          else if (colour == WHITE_PIX) {
+            join_edges(current, prevline[i], free_cracks, outline_it);
+            current = h_edge(uppercolour - colour, NULL, &pos);
+            prevline[i] = v_edge(colour - prevcolour, current, &pos);
+          } else {
+            newcurrent = h_edge(uppercolour - colour, prevline[i], &pos);
+            prevline[i] = v_edge(colour - prevcolour, current, &pos);
+            current = newcurrent;  // right going h edge
+          }
+          prevcolour = colour;   // remember new colour
         }
-        *prevline = NULL;        // no change this time
       } else {
-        if (colour == uppercolour)
-          *prevline = v_edge(colour - prevcolour, *prevline, &pos);
-                                 // 8 vs 4 connection
-        else if (colour == WHITE_PIX) {
-          join_edges(current, *prevline, free_cracks, outline_it);
-          current = h_edge(uppercolour - colour, NULL, &pos);
-          *prevline = v_edge(colour - prevcolour, current, &pos);
-        } else {
-          newcurrent = h_edge(uppercolour - colour, *prevline, &pos);
-          *prevline = v_edge(colour - prevcolour, current, &pos);
-          current = newcurrent;  // right going h edge
+        if (colour != prevcolour) {
+          prevline[i] = current = v_edge(colour - prevcolour, current, &pos);
+          prevcolour = colour;
         }
-        prevcolour = colour;     // remember new colour
-      }
-    } else {
-      if (colour != prevcolour) {
-        *prevline = current = v_edge(colour - prevcolour, current, &pos);
-        prevcolour = colour;
+        if (colour != uppercolour)
+          current = h_edge(uppercolour - colour, current, &pos);
+        else
+          current = NULL;        // no edge now
       }
-      if (colour != uppercolour)
-        current = h_edge(uppercolour - colour, current, &pos);
-      else
-        current = NULL;          // no edge now
+      changes &= ~(0x80000000u >> next);
+      bit = next + 1;
     }
+    if (bit < word_end) current = NULL;
   }
+  pos.x = x + xext;
+  prevline += xext;
   if (current != NULL) {
                                  // out of block
     if (*prevline != NULL) {     // got one to join to?
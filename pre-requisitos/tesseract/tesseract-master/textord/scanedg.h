@@ -40,7 +40,7 @@ void block_edges(Pix *t_image,         // thresholded image
                  C_OUTLINE_IT* outline_it);
 void make_margins(PDBLK *block,            // block in image
                   BLOCK_LINE_IT *line_it,  // for old style
-                  uinT8 *pixels,           // pixels to strip
+                  uinT32 *pixels,        // packed pixels to strip
                   uinT8 margin,            // white-out pixel
                   inT16 left,              // block edges
                   inT16 right,
@@ -49,7 +49,8 @@ void line_edges(inT16 x,                     // coord of line start
                 inT16 y,                     // coord of line
                 inT16 xext,                  // width of line
                 uinT8 uppercolour,           // start of prev line
-                uinT8 * bwpos,               // thresholded line
+                const uinT32* bwline,      // packed thresholded line
+                const uinT32* prevbwline,  // the line above
                 CRACKEDGE ** prevline,       // edges in progress
                 CRACKEDGE **free_cracks,
                 C_OUTLINE_IT* outline_it);
@@ -802,6 +802,8 @@ void StrokeWidth::AccumulateOverlaps(const BLOBNBOX* not_this, bool debug,
 // so display_if_debugging is true on the final call to display the results.
 void StrokeWidth::FindTextlineFlowDirection(PageSegMode pageseg_mode,
                                             bool display_if_debugging) {
+  // Only the neighbours and types of the blobs change from here on.
+  PackCells();
   BlobGridSearch gsearch(this);
   BLOBNBOX* bbox;
   // For every bbox in the grid, set its neighbours.
@@ -850,6 +852,7 @@ void StrokeWidth::FindTextlineFlowDirection(PageSegMode pageseg_mode,
       textord_tabfind_show_strokewidths > 1) {
     widths_win_ = DisplayGoodBlobs("ImprovedStrokewidths", 800, 0);
   }
+  UnpackCells();
 }
 
 // Sets the neighbours and good_stroke_neighbours members of the blob by
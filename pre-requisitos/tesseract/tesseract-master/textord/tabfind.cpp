@@ -524,9 +524,12 @@ ScrollView* TabFind::FindInitialTabVectors(BLOBNBOX_LIST* image_blobs,
   if (image_blobs != NULL)
     InsertBlobsToGrid(true, false, image_blobs, this);
   InsertBlobsToGrid(true, false, &block->blobs, this);
+  // Finding the tabs only searches the grid.
+  PackCells();
   ScrollView* initial_win = FindTabBoxes(min_gutter_width,
                                          tabfind_aligned_gap_fraction);
   FindAllTabVectors(min_gutter_width);
+  UnpackCells();
 
   TabVector::MergeSimilarTabVectors(vertical_skew_, &vectors_, this);
   SortVectors();
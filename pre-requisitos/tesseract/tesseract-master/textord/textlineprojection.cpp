@@ -39,6 +39,9 @@ const int kParaPerpDistRatio = 4;
 const int kMinLineSpacingFactor = 4;
 // Maximum tab-stop overrun for horizontal padding, in projection pixels.
 const int kMaxTabStopOverrun = 6;
+// Max fraction of the textline rows of the most covered x of the projection
+// that an x may be covered by and still be part of a gap between columns.
+const double kMaxColumnGapCoverage = 0.1;
 
 namespace tesseract {
 
@@ -148,6 +151,47 @@ void TextlineProjection::DisplayProjection() const {
 #endif  // GRAPHICS_DISABLED
 }
 
+// Returns true if the textlines in the projection form a single column,
+// ie there is no vertical strip, at least min_gap image pixels wide and
+// between the leftmost and rightmost text, that is mostly free of text.
+// As the textlines are smeared up to the tab stops, the gaps between
+// columns stay clear in the projection, but the gaps between words do not.
+bool TextlineProjection::IsSingleColumn(int min_gap) const {
+  if (pix_ == NULL) return false;
+  int width = pixGetWidth(pix_);
+  int height = pixGetHeight(pix_);
+  int wpl = pixGetWpl(pix_);
+  uinT32* data = pixGetData(pix_);
+  // The number of rows in which each x is covered by a textline.
+  GenericVector<int> coverage;
+  coverage.init_to_size(width, 0);
+  for (int y = 0; y < height; ++y, data += wpl) {
+    for (int x = 0; x < width; ++x) {
+      if (GET_DATA_BYTE(data, x) > 0)
+        ++coverage[x];
+    }
+  }
+  int max_coverage = 0;
+  for (int x = 0; x < width; ++x)
+    max_coverage = MAX(max_coverage, coverage[x]);
+  if (max_coverage == 0) return false;
+  int gap_coverage = static_cast<int>(max_coverage * kMaxColumnGapCoverage);
+  int left = 0;
+  while (left < width && coverage[left] <= gap_coverage) ++left;
+  int right = width - 1;
+  while (right > left && coverage[right] <= gap_coverage) --right;
+  int min_gap_width = MAX(min_gap / scale_factor_, 1);
+  int gap_width = 0;
+  for (int x = left; x <= right; ++x) {
+    if (coverage[x] > gap_coverage) {
+      gap_width = 0;
+    } else if (++gap_width >= min_gap_width) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Compute the distance of the box from the partition using curved projection
 // space. As DistanceOfBoxFromBox, except that the direction is taken from
 // the ColPartition and the median bounds of the ColPartition are used as
@@ -60,6 +60,12 @@ class TextlineProjection {
   // Create a window and display the projection in it.
   void DisplayProjection() const;
 
+  // Returns true if the textlines in the projection form a single column,
+  // ie there is no vertical strip, at least min_gap image pixels wide and
+  // between the leftmost and rightmost text, that is mostly free of text.
+  // The projection must have been built without rotation.
+  bool IsSingleColumn(int min_gap) const;
+
   // Compute the distance of the box from the partition using curved projection
   // space. As DistanceOfBoxFromBox, except that the direction is taken from
   // the ColPartition and the median bounds of the ColPartition are used as
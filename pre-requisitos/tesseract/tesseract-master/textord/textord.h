@@ -155,6 +155,8 @@ class Textord {
                       int degree,       // required approximation
                       QSPLINE *spline);  // starting spline
   // tospace.cpp ///////////////////////////////////////////
+  // Sets the spacing of the rows of one block, numbered from 1.
+  void block_to_spacing(TO_BLOCK *block, int block_index);
   //DEBUG USE ONLY
   void block_spacing_stats(TO_BLOCK *block,
                            GAPMAP *gapmap,
@@ -106,9 +106,6 @@ void make_words(tesseract::Textord *textord,
                 float gradient,                // page skew
                 BLOCK_LIST *blocks,            // block list
                 TO_BLOCK_LIST *port_blocks) {  // output list
-  TO_BLOCK_IT block_it;          // iterator
-  TO_BLOCK *block;               // current block
-
   if (textord->use_cjk_fp_model()) {
     compute_fixed_pitch_cjk(page_tr, port_blocks);
   } else {
@@ -116,11 +113,17 @@ void make_words(tesseract::Textord *textord,
                         !(BOOL8) textord_test_landscape);
   }
   textord->to_spacing(page_tr, port_blocks);
-  block_it.set_to_list(port_blocks);
-  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
-    block = block_it.data();
-    make_real_words(textord, block, FCOORD(1.0f, 0.0f));
-  }
+  GenericVector<TO_BLOCK*> to_blocks;
+  GatherBlocks(port_blocks, &to_blocks);
+#ifdef _OPENMP
+  int num_threads = BlockPassThreads(
+      to_blocks, textord_show_page_cuts || textord_show_initial_words ||
+                 textord->tosp_debug_level > 0);
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1) \
+    schedule(dynamic)
+#endif
+  for (int b = 0; b < to_blocks.size(); ++b)
+    make_real_words(textord, to_blocks[b], FCOORD(1.0f, 0.0f));
 }
 
 
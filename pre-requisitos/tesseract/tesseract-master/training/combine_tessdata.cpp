@@ -64,6 +64,15 @@
 // This will create  /home/$USER/temp/eng.* files with individual tessdata
 // components from tessdata/eng.traineddata.
 //
+// Specify option -a to rewrite a traineddata file in the aligned layout,
+// for use in place with tessdata_mmap, with the int LSTM weights also stored
+// in the layout of the SIMD multiplier of this machine:
+//
+// combine_tessdata -a tessdata/eng.traineddata
+//
+// Files in the aligned layout can't be read by older versions. Overwriting
+// their components with -o keeps the layout.
+//
 int main(int argc, char **argv) {
   int i;
   tesseract::TessdataManager tm;
@@ -151,6 +160,32 @@ int main(int argc, char **argv) {
       tprintf("Failed to write modified traineddata:%s!\n", argv[2]);
       exit(1);
     }
+  } else if (argc == 3 && strcmp(argv[1], "-a") == 0) {
+    if (!tm.Init(argv[2])) {
+      tprintf("Failed to read %s\n", argv[2]);
+      exit(1);
+    }
+    tesseract::TFile fp;
+    if (tm.GetComponent(tesseract::TESSDATA_LSTM, &fp)) {
+      tesseract::LSTMRecognizer recognizer;
+      if (!recognizer.DeSerialize(&tm, &fp)) {
+        tprintf("Failed to deserialize LSTM in %s!\n", argv[2]);
+        exit(1);
+      }
+      if (recognizer.IsIntMode()) {
+        recognizer.SetSerializeShaped(true);
+        GenericVector<char> lstm_data;
+        fp.OpenWrite(&lstm_data);
+        ASSERT_HOST(recognizer.Serialize(&tm, &fp));
+        tm.OverwriteEntry(tesseract::TESSDATA_LSTM, &lstm_data[0],
+                          lstm_data.size());
+      }
+    }
+    tm.set_aligned(true);
+    if (!tm.SaveFile(argv[2], nullptr)) {
+      tprintf("Failed to write modified traineddata:%s!\n", argv[2]);
+      exit(1);
+    }
   } else if (argc == 3 && strcmp(argv[1], "-d") == 0) {
     // Initialize TessdataManager with the data in the given traineddata file.
     tm.Init(argv[2]);
@@ -177,6 +212,10 @@ int main(int argc, char **argv) {
         "Usage for compacting LSTM component to int:\n"
         "  %s -c traineddata_file\n",
         argv[0]);
+    printf(
+        "Usage for rewriting in the aligned layout for mapping:\n"
+        "  %s -a traineddata_file\n",
+        argv[0]);
     return 1;
   }
   tm.Directory();
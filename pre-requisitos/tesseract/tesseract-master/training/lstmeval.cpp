@@ -34,6 +34,9 @@ STRING_PARAM_FLAG(eval_listfile, "",
 INT_PARAM_FLAG(max_image_MB, 2000, "Max memory to use for images.");
 INT_PARAM_FLAG(verbosity, 1,
                "Amount of diagnosting information to output (0-2).");
+INT_PARAM_FLAG(num_threads, 1,
+               "Number of threads to evaluate on, each with its own copy of"
+               " the model.");
 
 int main(int argc, char **argv) {
   ParseArguments(&argc, &argv);
@@ -72,6 +75,7 @@ int main(int argc, char **argv) {
     tprintf("Failed to load eval data from: %s\n", FLAGS_eval_listfile.c_str());
     return 1;
   }
+  tester.set_num_threads(FLAGS_num_threads);
   double errs = 0.0;
   STRING result =
       tester.RunEvalSync(0, &errs, mgr,
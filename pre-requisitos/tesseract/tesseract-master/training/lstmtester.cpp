@@ -21,8 +21,20 @@
 
 namespace tesseract {
 
+// Result of the evaluation of a single page.
+struct PageEvaluation {
+  PageEvaluation() : result(UNENCODABLE), char_error(0.0), word_error(0.0) {}
+
+  Trainability result;
+  double char_error;
+  double word_error;
+  // Recognized text, only if it is to be output.
+  STRING ocr_text;
+};
+
 LSTMTester::LSTMTester(inT64 max_memory)
-    : test_data_(max_memory), total_pages_(0), async_running_(false) {}
+    : test_data_(max_memory), total_pages_(0), num_threads_(1),
+      async_running_(false) {}
 
 // Loads a set of lstmf files that were created using the lstm.train config to
 // tesseract into memory ready for testing. Returns false if nothing was
@@ -82,34 +94,65 @@ STRING LSTMTester::RunEvalAsync(int iteration, const double* training_errors,
 STRING LSTMTester::RunEvalSync(int iteration, const double* training_errors,
                                const TessdataManager& model_mgr,
                                int training_stage, int verbosity) {
-  LSTMTrainer trainer;
-  trainer.InitCharSet(model_mgr);
-  TFile fp;
-  if (!model_mgr.GetComponent(TESSDATA_LSTM, &fp) ||
-      !trainer.DeSerialize(&model_mgr, &fp)) {
-    return "Deserialize failed";
+  int num_threads = num_threads_;
+  PointerVector<LSTMTrainer> trainers;
+  for (int t = 0; t < num_threads; ++t) {
+    LSTMTrainer* trainer = new LSTMTrainer;
+    trainers.push_back(trainer);
+    trainer->InitCharSet(model_mgr);
+    TFile fp;
+    if (!model_mgr.GetComponent(TESSDATA_LSTM, &fp) ||
+        !trainer->DeSerialize(&model_mgr, &fp)) {
+      return "Deserialize failed";
+    }
   }
   int eval_iteration = 0;
   double char_error = 0.0;
   double word_error = 0.0;
   int error_count = 0;
+  GenericVector<const ImageData*> pages;
+  GenericVector<PageEvaluation> evaluations;
   while (error_count < total_pages_) {
-    const ImageData* trainingdata = test_data_.GetPageBySerial(eval_iteration);
-    trainer.SetIteration(++eval_iteration);
-    NetworkIO fwd_outputs, targets;
-    Trainability result =
-        trainer.PrepareForBackward(trainingdata, &fwd_outputs, &targets);
-    if (result != UNENCODABLE) {
-      char_error += trainer.NewSingleError(tesseract::ET_CHAR_ERROR);
-      word_error += trainer.NewSingleError(tesseract::ET_WORD_RECERR);
-      ++error_count;
-      if (verbosity > 1 || (verbosity > 0 && result != PERFECT)) {
-        tprintf("Truth:%s\n", trainingdata->transcription().string());
+    // The pages are fetched here, as the DocumentCache is not thread-safe,
+    // and each is evaluated on its own copy of the model. The randomizer is
+    // seeded by the page serial, so the results match those of a single
+    // thread.
+    pages.truncate(0);
+    for (int t = 0; t < num_threads; ++t)
+      pages.push_back(test_data_.GetPageBySerial(eval_iteration + t));
+    evaluations.init_to_size(num_threads, PageEvaluation());
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+#endif
+    for (int t = 0; t < num_threads; ++t) {
+      LSTMTrainer* trainer = trainers[t];
+      PageEvaluation* evaluation = &evaluations[t];
+      trainer->SetIteration(eval_iteration + t + 1);
+      NetworkIO fwd_outputs, targets;
+      evaluation->result =
+          trainer->PrepareForBackward(pages[t], &fwd_outputs, &targets);
+      if (evaluation->result == UNENCODABLE) continue;
+      evaluation->char_error = trainer->NewSingleError(ET_CHAR_ERROR);
+      evaluation->word_error = trainer->NewSingleError(ET_WORD_RECERR);
+      if (verbosity > 1 || (verbosity > 0 && evaluation->result != PERFECT)) {
         GenericVector<int> ocr_labels;
         GenericVector<int> xcoords;
-        trainer.LabelsFromOutputs(fwd_outputs, &ocr_labels, &xcoords);
-        STRING ocr_text = trainer.DecodeLabels(ocr_labels);
-        tprintf("OCR  :%s\n", ocr_text.string());
+        trainer->LabelsFromOutputs(fwd_outputs, &ocr_labels, &xcoords);
+        evaluation->ocr_text = trainer->DecodeLabels(ocr_labels);
+      }
+    }
+    // Merges the results in page order, up to the page that completes the
+    // count, as the pages after it would not have been evaluated.
+    for (int t = 0; t < num_threads && error_count < total_pages_; ++t) {
+      ++eval_iteration;
+      const PageEvaluation& evaluation = evaluations[t];
+      if (evaluation.result == UNENCODABLE) continue;
+      char_error += evaluation.char_error;
+      word_error += evaluation.word_error;
+      ++error_count;
+      if (verbosity > 1 || (verbosity > 0 && evaluation.result != PERFECT)) {
+        tprintf("Truth:%s\n", pages[t]->transcription().string());
+        tprintf("OCR  :%s\n", evaluation.ocr_text.string());
       }
     }
   }
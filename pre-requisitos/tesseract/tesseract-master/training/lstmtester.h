@@ -41,6 +41,13 @@ class LSTMTester {
   // loaded.
   bool LoadAllEvalData(const GenericVector<STRING>& filenames);
 
+  // Sets the number of threads that an evaluation runs on, each with its own
+  // copy of the model. The default of 1 evaluates on the calling thread, or,
+  // for RunEvalAsync, on the single background thread. The threads make up
+  // an OpenMP team of their own, so a background evaluation takes exactly
+  // this many threads, whatever the trainer is using.
+  void set_num_threads(int num_threads) { num_threads_ = MAX(num_threads, 1); }
+
   // Runs an evaluation asynchronously on the stored eval data and returns a
   // string describing the results of the previous test. Args match TestCallback
   // declared in lstmtrainer.h:
@@ -78,6 +85,8 @@ class LSTMTester {
   // The data to test with.
   DocumentCache test_data_;
   int total_pages_;
+  // Number of threads to evaluate on.
+  int num_threads_;
   // Flag that indicates an asynchronous test is currently running.
   // Protected by running_mutex_.
   bool async_running_;
@@ -50,6 +50,9 @@ BOOL_PARAM_FLAG(convert_to_int, false,
                 "Convert the recognition model to an integer model.");
 BOOL_PARAM_FLAG(sequential_training, false,
                 "Use the training files sequentially instead of round-robin.");
+BOOL_PARAM_FLAG(shuffle_pages, false,
+                "With sequential_training, use the pages of each training file"
+                " in a different order in each epoch.");
 INT_PARAM_FLAG(append_index, -1, "Index in continue_from Network at which to"
                " attach the new network defined by net_spec");
 BOOL_PARAM_FLAG(debug_network, false,
@@ -62,6 +65,13 @@ STRING_PARAM_FLAG(old_traineddata, "",
                   " character set that is to be replaced");
 BOOL_PARAM_FLAG(randomly_rotate, false,
                 "Train OSD and randomly turn training samples upside-down");
+INT_PARAM_FLAG(eval_threads, 1,
+               "Number of threads, each with its own copy of the model, for"
+               " the evaluations that run in the background");
+INT_PARAM_FLAG(parallel_samples, 0,
+               "If > 1, train on this many samples at a time, each on its own"
+               " thread and copy of the network, with a single update of the"
+               " summed deltas");
 
 // Number of training images to train between calls to MaintainCheckpoints.
 const int kNumPagesPerBatch = 100;
@@ -173,7 +183,8 @@ int main(int argc, char **argv) {
                                    FLAGS_sequential_training
                                        ? tesseract::CS_SEQUENTIAL
                                        : tesseract::CS_ROUND_ROBIN,
-                                   FLAGS_randomly_rotate)) {
+                                   FLAGS_randomly_rotate,
+                                   FLAGS_shuffle_pages)) {
     tprintf("Load of images failed!!\n");
     return 1;
   }
@@ -181,6 +192,7 @@ int main(int argc, char **argv) {
   tesseract::LSTMTester tester(static_cast<inT64>(FLAGS_max_image_MB) *
                                1048576);
   tesseract::TestCallback tester_callback = nullptr;
+  tester.set_num_threads(FLAGS_eval_threads);
   if (!FLAGS_eval_listfile.empty()) {
     if (!tester.LoadAllEvalData(FLAGS_eval_listfile.c_str())) {
       tprintf("Failed to load eval data from: %s\n",
@@ -190,13 +202,17 @@ int main(int argc, char **argv) {
     tester_callback =
         NewPermanentTessCallback(&tester, &tesseract::LSTMTester::RunEvalAsync);
   }
+  if (!trainer.InitReplicas(FLAGS_parallel_samples)) {
+    tprintf("Failed to set up %d parallel samples\n", FLAGS_parallel_samples);
+    return 1;
+  }
   do {
     // Train a few.
     int iteration = trainer.training_iteration();
     for (int target_iteration = iteration + kNumPagesPerBatch;
          iteration < target_iteration;
          iteration = trainer.training_iteration()) {
-      trainer.TrainOnLine(&trainer, false);
+      trainer.TrainOnLines(&trainer);
     }
     STRING log_str;
     trainer.MaintainCheckpoints(tester_callback, &log_str);
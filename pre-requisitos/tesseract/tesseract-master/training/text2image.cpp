@@ -44,8 +44,10 @@
 #include "errcode.h"
 #include "fileio.h"
 #include "helpers.h"
+#include "ligature_table.h"
 #include "normstrngs.h"
 #include "stringrenderer.h"
+#include "svutil.h"
 #include "tlog.h"
 #include "unicharset.h"
 #include "util.h"
@@ -167,6 +169,10 @@ INT_PARAM_FLAG(glyph_resized_size, 0,
 INT_PARAM_FLAG(glyph_num_border_pixels_to_pad, 0,
                "Final_size=glyph_resized_size+2*glyph_num_border_pixels_to_pad");
 
+INT_PARAM_FLAG(threads, 1,
+               "Number of threads to render the text on, each with a renderer"
+               " of its own that takes a share of whole lines of the text.");
+
 namespace tesseract {
 
 struct SpacingProperties {
@@ -412,6 +418,224 @@ using tesseract::SpanUTF8NotWhitespace;
 using tesseract::SpanUTF8Whitespace;
 using tesseract::StringRenderer;
 
+// Sets up render with the layout and writing mode given by the flags.
+// Returns false if the writing mode is not recognized.
+static bool SetupRenderer(StringRenderer* render) {
+  render->set_add_ligatures(FLAGS_ligatures);
+  render->set_leading(FLAGS_leading);
+  render->set_resolution(FLAGS_resolution);
+  render->set_char_spacing(FLAGS_char_spacing * FLAGS_ptsize);
+  render->set_h_margin(FLAGS_margin);
+  render->set_v_margin(FLAGS_margin);
+  render->set_output_word_boxes(FLAGS_output_word_boxes);
+  render->set_box_padding(FLAGS_box_padding);
+  render->set_strip_unrenderable_words(FLAGS_strip_unrenderable_words);
+  render->set_underline_start_prob(FLAGS_underline_start_prob);
+  render->set_underline_continuation_prob(FLAGS_underline_continuation_prob);
+
+  // Set text rendering orientation and their forms.
+  if (FLAGS_writing_mode == "horizontal") {
+    // Render regular horizontal text (default).
+    render->set_vertical_text(false);
+    render->set_gravity_hint_strong(false);
+    render->set_render_fullwidth_latin(false);
+  } else if (FLAGS_writing_mode == "vertical") {
+    // Render vertical text. Glyph orientation is selected by Pango.
+    render->set_vertical_text(true);
+    render->set_gravity_hint_strong(false);
+    render->set_render_fullwidth_latin(false);
+  } else if (FLAGS_writing_mode == "vertical-upright") {
+    // Render vertical text. Glyph orientation is set to be upright.
+    // Also Basic Latin characters are converted to their fullwidth forms
+    // on rendering, since fullwidth Latin characters are well designed to fit
+    // vertical text lines, while .box files store halfwidth Basic Latin
+    // unichars.
+    render->set_vertical_text(true);
+    render->set_gravity_hint_strong(true);
+    render->set_render_fullwidth_latin(true);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Degrades the page image pix, which it takes over, as the flags ask,
+// rotating the boxes of the page along with it, and returns it binarized.
+// The rotations of the pages of pass 0 are kept in page_rotation for pass 1
+// to mirror.
+static Pix* FinishPage(Pix* pix, int pass, int page_num,
+                       tesseract::TRand* randomizer,
+                       std::vector<float>* page_rotation,
+                       StringRenderer* render) {
+  float rotation = 0;
+  if (pass == 1) {
+    // Pass 2, do mirror rotation.
+    rotation = -1 * (*page_rotation)[page_num];
+  }
+  if (FLAGS_degrade_image) {
+    pix = DegradeImage(pix, FLAGS_exposure, randomizer,
+                       FLAGS_rotate_image ? &rotation : nullptr);
+  }
+  render->RotatePageBoxes(rotation);
+
+  if (pass == 0) {
+    // Pass 1, rotate randomly and store the rotation..
+    page_rotation->push_back(rotation);
+  }
+
+  Pix* gray_pix = pixConvertTo8(pix, false);
+  pixDestroy(&pix);
+  Pix* binary = pixThresholdToBinary(gray_pix, 128);
+  pixDestroy(&gray_pix);
+  return binary;
+}
+
+// A share of the text, rendered on a thread of its own, and the pages and
+// boxes it came to.
+struct RenderJob {
+  string font_desc;
+  const char* text;
+  int length;
+  int seed;
+  // The pages of each pass, as G4 tiff in memory, or nullptr where the
+  // renderer gave no image.
+  std::vector<l_uint8*> pages[2];
+  std::vector<size_t> page_sizes[2];
+  // The boxes of all the pages, numbered in the order they were rendered.
+  string boxes;
+  SVSemaphore* done;
+};
+
+// Thread function rendering the share of a RenderJob.
+static void* RenderShare(void* arg) {
+  RenderJob* job = static_cast<RenderJob*>(arg);
+  // Made on this thread, the renderer gets a pango font map, and so a font
+  // cache, of its own instead of sharing those of the main thread.
+  StringRenderer render(job->font_desc, FLAGS_xsize, FLAGS_ysize);
+  SetupRenderer(&render);
+  tesseract::TRand randomizer;
+  randomizer.set_seed(job->seed);
+  std::vector<float> page_rotation;
+  int num_pass = FLAGS_bidirectional_rotation ? 2 : 1;
+  for (int pass = 0; pass < num_pass; ++pass) {
+    int page_num = 0;
+    for (int offset = 0;
+         offset < job->length &&
+         (FLAGS_max_pages == 0 || page_num < FLAGS_max_pages);
+         ++page_num) {
+      Pix* pix = nullptr;
+      int page_length = render.RenderToImage(job->text + offset,
+                                             job->length - offset, &pix);
+      if (page_length == 0) break;
+      offset += page_length;
+      l_uint8* data = nullptr;
+      size_t size = 0;
+      if (pix != nullptr) {
+        Pix* binary = FinishPage(pix, pass, page_num, &randomizer,
+                                 &page_rotation, &render);
+        pixWriteMemTiff(&data, &size, binary, IFF_TIFF_G4);
+        pixDestroy(&binary);
+      }
+      job->pages[pass].push_back(data);
+      job->page_sizes[pass].push_back(size);
+    }
+  }
+  job->boxes = render.GetBoxesStr();
+  job->done->Signal();
+  return nullptr;
+}
+
+// Renders text on FLAGS_threads threads at once, splitting it into as many
+// shares of whole lines, and writes the pages and boxes of all in the order
+// of the text: the pages of pass 0 of each share in turn, then those of
+// pass 1. Each share starts on a page of its own, so the pages are not
+// quite those a single renderer would make.
+static void RenderInParallel(const string& font_desc, const string& text) {
+  // The ligature table is made on first use, so make it before the threads
+  // get to it.
+  if (FLAGS_ligatures) tesseract::LigatureTable::Get();
+  const int num_threads = FLAGS_threads;
+  std::vector<RenderJob> jobs(num_threads);
+  SVSemaphore done;
+  int num_jobs = 0;
+  size_t start = 0;
+  while (num_jobs < num_threads && start < text.length()) {
+    size_t end = text.length();
+    if (num_jobs + 1 < num_threads) {
+      end = text.find('\n', std::max(start, text.length() * (num_jobs + 1) /
+                                                 num_threads));
+      end = end == string::npos ? text.length() : end + 1;
+    }
+    RenderJob* job = &jobs[num_jobs];
+    job->font_desc = font_desc;
+    job->text = text.c_str() + start;
+    job->length = end - start;
+    job->seed = kRandomSeed + num_jobs;
+    job->done = &done;
+    SVSync::StartThread(RenderShare, job);
+    ++num_jobs;
+    start = end;
+  }
+  for (int j = 0; j < num_jobs; ++j) done.Wait();
+
+  // Number the pages of the jobs in the order of the output, dropping those
+  // past FLAGS_max_pages in either pass.
+  std::vector<std::vector<int> > page_numbers(num_jobs);
+  int im = 0;
+  char tiff_name[1024];
+  snprintf(tiff_name, 1024, "%s.tif", FLAGS_outputbase.c_str());
+  for (int pass = 0; pass < 2; ++pass) {
+    int page_num = 0;
+    for (int j = 0; j < num_jobs; ++j) {
+      RenderJob* job = &jobs[j];
+      for (size_t p = 0; p < job->pages[pass].size(); ++p) {
+        if (FLAGS_max_pages > 0 && page_num >= FLAGS_max_pages) {
+          page_numbers[j].push_back(-1);
+        } else {
+          page_numbers[j].push_back(im);
+          Pix* binary = job->pages[pass][p] == nullptr
+                            ? nullptr
+                            : pixReadMemTiff(job->pages[pass][p],
+                                             job->page_sizes[pass][p], 0);
+          if (binary != nullptr) {
+            pixWriteTiff(tiff_name, binary, IFF_TIFF_G4, im == 0 ? "w" : "a");
+            tprintf("Rendered page %d to file %s\n", im, tiff_name);
+            pixDestroy(&binary);
+          }
+          ++im;
+          ++page_num;
+        }
+        lept_free(job->pages[pass][p]);
+      }
+    }
+  }
+
+  // Renumber the boxes to the pages of the output.
+  std::vector<string> page_boxes(im);
+  for (int j = 0; j < num_jobs; ++j) {
+    const string& boxes = jobs[j].boxes;
+    for (size_t line = 0; line < boxes.length();) {
+      size_t end = boxes.find('\n', line);
+      end = end == string::npos ? boxes.length() : end + 1;
+      size_t page_start = boxes.rfind(' ', end - 1) + 1;
+      int page = atoi(boxes.c_str() + page_start);
+      if (page >= 0 && page < static_cast<int>(page_numbers[j].size()) &&
+          page_numbers[j][page] >= 0) {
+        string* output = &page_boxes[page_numbers[j][page]];
+        output->append(boxes, line, page_start - line);
+        output->append(std::to_string(page_numbers[j][page]));
+        output->append("\n");
+      }
+      line = end;
+    }
+  }
+  string all_boxes;
+  for (int i = 0; i < im; ++i) all_boxes += page_boxes[i];
+  string box_name = FLAGS_outputbase.c_str();
+  box_name += ".box";
+  File::WriteStringToFileOrDie(all_boxes, box_name);
+}
+
 int Main() {
   if (FLAGS_list_available_fonts) {
     const std::vector<string>& all_fonts = FontUtils::ListAvailableFonts();
@@ -456,39 +680,7 @@ int Main() {
   snprintf(font_desc_name, 1024, "%s %d", FLAGS_font.c_str(),
            static_cast<int>(FLAGS_ptsize));
   StringRenderer render(font_desc_name, FLAGS_xsize, FLAGS_ysize);
-  render.set_add_ligatures(FLAGS_ligatures);
-  render.set_leading(FLAGS_leading);
-  render.set_resolution(FLAGS_resolution);
-  render.set_char_spacing(FLAGS_char_spacing * FLAGS_ptsize);
-  render.set_h_margin(FLAGS_margin);
-  render.set_v_margin(FLAGS_margin);
-  render.set_output_word_boxes(FLAGS_output_word_boxes);
-  render.set_box_padding(FLAGS_box_padding);
-  render.set_strip_unrenderable_words(FLAGS_strip_unrenderable_words);
-  render.set_underline_start_prob(FLAGS_underline_start_prob);
-  render.set_underline_continuation_prob(FLAGS_underline_continuation_prob);
-
-  // Set text rendering orientation and their forms.
-  if (FLAGS_writing_mode == "horizontal") {
-    // Render regular horizontal text (default).
-    render.set_vertical_text(false);
-    render.set_gravity_hint_strong(false);
-    render.set_render_fullwidth_latin(false);
-  } else if (FLAGS_writing_mode == "vertical") {
-    // Render vertical text. Glyph orientation is selected by Pango.
-    render.set_vertical_text(true);
-    render.set_gravity_hint_strong(false);
-    render.set_render_fullwidth_latin(false);
-  } else if (FLAGS_writing_mode == "vertical-upright") {
-    // Render vertical text. Glyph orientation is set to be upright.
-    // Also Basic Latin characters are converted to their fullwidth forms
-    // on rendering, since fullwidth Latin characters are well designed to fit
-    // vertical text lines, while .box files store halfwidth Basic Latin
-    // unichars.
-    render.set_vertical_text(true);
-    render.set_gravity_hint_strong(true);
-    render.set_render_fullwidth_latin(true);
-  } else {
+  if (!SetupRenderer(&render)) {
     tprintf("Invalid writing mode: %s\n", FLAGS_writing_mode.c_str());
     exit(1);
   }
@@ -568,6 +760,12 @@ int Main() {
     return 0;
   }
 
+  if (FLAGS_threads > 1 && !FLAGS_find_fonts &&
+      !FLAGS_output_individual_glyph_images) {
+    RenderInParallel(font_desc_name, src_utf8);
+    return 0;
+  }
+
   int im = 0;
   std::vector<float> page_rotation;
   const char* to_render_utf8 = src_utf8.c_str();
@@ -598,26 +796,8 @@ int Main() {
                                        strlen(to_render_utf8 + offset), &pix);
       }
       if (pix != nullptr) {
-        float rotation = 0;
-        if (pass == 1) {
-          // Pass 2, do mirror rotation.
-          rotation = -1 * page_rotation[page_num];
-        }
-        if (FLAGS_degrade_image) {
-          pix = DegradeImage(pix, FLAGS_exposure, &randomizer,
-                             FLAGS_rotate_image ? &rotation : nullptr);
-        }
-        render.RotatePageBoxes(rotation);
-
-        if (pass == 0) {
-          // Pass 1, rotate randomly and store the rotation..
-          page_rotation.push_back(rotation);
-        }
-
-        Pix* gray_pix = pixConvertTo8(pix, false);
-        pixDestroy(&pix);
-        Pix* binary = pixThresholdToBinary(gray_pix, 128);
-        pixDestroy(&gray_pix);
+        Pix* binary = FinishPage(pix, pass, page_num, &randomizer,
+                                 &page_rotation, &render);
         char tiff_name[1024];
         if (FLAGS_find_fonts) {
           if (FLAGS_render_per_font) {
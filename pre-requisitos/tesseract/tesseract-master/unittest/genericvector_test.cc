@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////
+// File:        genericvector_test.cc
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <utility>
+#include "genericvector.h"
+#include "include_gunit.h"
+
+namespace {
+
+// Counts how often it is copied and moved, to check that GenericVector
+// moves its elements where it can.
+class Counted {
+ public:
+  Counted() : value_(0) {}
+  explicit Counted(int value) : value_(value) {}
+  Counted(const Counted& other) : value_(other.value_) { ++copies_; }
+  Counted(Counted&& other) : value_(other.value_) {
+    other.value_ = -1;
+    ++moves_;
+  }
+  Counted& operator=(const Counted& other) {
+    value_ = other.value_;
+    ++copies_;
+    return *this;
+  }
+  Counted& operator=(Counted&& other) {
+    value_ = other.value_;
+    other.value_ = -1;
+    ++moves_;
+    return *this;
+  }
+
+  int value() const { return value_; }
+
+  static void ResetCounts() { copies_ = moves_ = 0; }
+  static int copies() { return copies_; }
+  static int moves() { return moves_; }
+
+ private:
+  int value_;
+  static int copies_;
+  static int moves_;
+};
+
+int Counted::copies_ = 0;
+int Counted::moves_ = 0;
+
+// Tests that an empty vector holds no array, and that it grows from the
+// default size by doubling.
+TEST(GenericVectorTest, Growth) {
+  GenericVector<int> v;
+  EXPECT_TRUE(v.empty());
+  EXPECT_EQ(0, v.size_reserved());
+  v.push_back(0);
+  EXPECT_EQ(4, v.size_reserved());
+  for (int i = 1; i < 100; ++i) {
+    v.push_back(i);
+    EXPECT_EQ(i + 1, v.size());
+    EXPECT_GE(v.size_reserved(), v.size());
+  }
+  EXPECT_EQ(128, v.size_reserved());
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(i, v[i]);
+  v.reserve(1000);
+  EXPECT_EQ(1000, v.size_reserved());
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(i, v[i]);
+  GenericVector<int> sized(10, 7);
+  EXPECT_EQ(10, sized.size());
+  for (int i = 0; i < 10; ++i) EXPECT_EQ(7, sized[i]);
+}
+
+// Tests that pushing and growing move the elements instead of copying them.
+TEST(GenericVectorTest, GrowthMoves) {
+  GenericVector<Counted> v;
+  Counted::ResetCounts();
+  for (int i = 0; i < 100; ++i) v.push_back(Counted(i));
+  EXPECT_EQ(0, Counted::copies());
+  EXPECT_GT(Counted::moves(), 0);
+  ASSERT_EQ(100, v.size());
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(i, v[i].value());
+  Counted::ResetCounts();
+  v.reserve(500);
+  EXPECT_EQ(0, Counted::copies());
+  EXPECT_EQ(100, Counted::moves());
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(i, v[i].value());
+}
+
+// Tests that a moved vector takes the array of the source, which is left
+// empty and usable, and that a copy is independent.
+TEST(GenericVectorTest, Move) {
+  GenericVector<int> v1;
+  for (int i = 0; i < 10; ++i) v1.push_back(i);
+  const int* array = &v1[0];
+  GenericVector<int> v2(std::move(v1));
+  EXPECT_EQ(10, v2.size());
+  EXPECT_EQ(array, &v2[0]);
+  EXPECT_EQ(0, v1.size());
+  EXPECT_EQ(0, v1.size_reserved());
+  v1.push_back(42);
+  EXPECT_EQ(1, v1.size());
+  EXPECT_EQ(42, v1[0]);
+
+  GenericVector<int> v3;
+  v3.push_back(-1);
+  v3 = std::move(v2);
+  EXPECT_EQ(10, v3.size());
+  EXPECT_EQ(array, &v3[0]);
+  EXPECT_EQ(0, v2.size());
+  GenericVector<int>& v4 = v3;
+  v3 = std::move(v4);
+  EXPECT_EQ(10, v3.size());
+  for (int i = 0; i < 10; ++i) EXPECT_EQ(i, v3[i]);
+
+  GenericVector<int> v5(v3);
+  v5[0] = 100;
+  EXPECT_EQ(0, v3[0]);
+  EXPECT_EQ(10, v5.size());
+}
+
+// Tests sorting in ascending order, with and without a comparator.
+TEST(GenericVectorTest, Sort) {
+  GenericVector<int> v;
+  for (int i = 0; i < 1000; ++i) v.push_back((i * 7919) % 1009);
+  v.sort();
+  for (int i = 1; i < v.size(); ++i) EXPECT_LE(v[i - 1], v[i]);
+  EXPECT_TRUE(v.bool_binary_search(7919 % 1009));
+  GenericVector<int> reversed;
+  for (int i = v.size() - 1; i >= 0; --i) reversed.push_back(v[i]);
+  reversed.sort(&tesseract::sort_cmp<int>);
+  for (int i = 0; i < v.size(); ++i) EXPECT_EQ(v[i], reversed[i]);
+  GenericVector<int> empty;
+  empty.sort();
+  EXPECT_TRUE(empty.empty());
+}
+
+}  // namespace
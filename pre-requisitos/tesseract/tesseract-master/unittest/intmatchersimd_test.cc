@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intmatchersimd_test.cc
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "helpers.h"
+#include "include_gunit.h"
+#include "intmatcheravx2.h"
+#include "intmatchersse.h"
+#include "simddetect.h"
+#include "tprintf.h"
+
+namespace tesseract {
+namespace {
+
+// Words in a class pruner: 24x24x24 buckets of 2 words.
+const int kPrunerWords = 24 * 24 * 24 * 2;
+// Parameters of IntegerMatcher::Init.
+const int kThetaFudge = 128;
+const int kMultShift = 0;
+const int kMultMask = (1 << 14) - 1;
+const int kTableShift = 18;
+const int kTableMask = 511;
+
+typedef void (*PrunerFunction)(const uint32_t* const*, int, const int*, int,
+                               int*);
+typedef void (*DistanceFunction)(const uint32_t*, int, int, int, int, int, int,
+                                 int, int, int, uint32_t*);
+
+class IntMatcherSimdTest : public ::testing::Test {
+ protected:
+  uint32_t RandomWord() {
+    return static_cast<uint32_t>(random_.IntRand()) ^
+           (static_cast<uint32_t>(random_.IntRand()) << 16);
+  }
+  // The distance computed by IntegerMatcher::UpdateTablesForFeature, clipped
+  // to kTableMask + 1 as the kernels do.
+  static uint32_t BaseDistance(uint32_t packed, int x, int y, int theta) {
+    int8_t a = static_cast<int8_t>(packed & 0xff);
+    int b = (packed >> 8) & 0xff;
+    int8_t c = static_cast<int8_t>((packed >> 16) & 0xff);
+    int angle = packed >> 24;
+    int32_t a3 = ((a * (x - 128)) << 1) - (b * (y - 128)) + (c << 9);
+    int32_t m3 = (static_cast<int8_t>(theta - angle) * kThetaFudge) << 1;
+    if (a3 < 0) a3 = ~a3;
+    if (m3 < 0) m3 = ~m3;
+    a3 >>= kMultShift;
+    m3 >>= kMultShift;
+    if (a3 > kMultMask) a3 = kMultMask;
+    if (m3 > kMultMask) m3 = kMultMask;
+    uint32_t a4 = (a3 * a3 + m3 * m3) >> kTableShift;
+    return a4 > kTableMask ? kTableMask + 1 : a4;
+  }
+  // Compares the class pruner counts of function with the scalar sums.
+  void ExpectEqualCounts(PrunerFunction function) {
+    const int kNumPruners = 4;
+    std::vector<std::vector<uint32_t> > pruners(kNumPruners);
+    std::vector<const uint32_t*> pruner_ptrs;
+    for (int p = 0; p < kNumPruners; ++p) {
+      for (int i = 0; i < kPrunerWords; ++i)
+        pruners[p].push_back(RandomWord());
+      pruner_ptrs.push_back(pruners[p].data());
+    }
+    for (int num_features = 1; num_features < 100; ++num_features) {
+      std::vector<int> offsets;
+      for (int f = 0; f < num_features; ++f)
+        offsets.push_back(random_.IntRand() % (kPrunerWords / 2) * 2);
+      std::vector<int> base_counts(kNumPruners * 32, 0);
+      for (int f = 0; f < num_features; ++f) {
+        for (int c = 0; c < kNumPruners * 32; ++c) {
+          uint32_t word = pruners[c / 32][offsets[f] + c % 32 / 16];
+          base_counts[c] += (word >> (2 * (c % 16))) & 3;
+        }
+      }
+      std::vector<int> test_counts(kNumPruners * 32, 0);
+      function(pruner_ptrs.data(), kNumPruners, offsets.data(), num_features,
+               test_counts.data());
+      for (int c = 0; c < kNumPruners * 32; ++c)
+        EXPECT_EQ(base_counts[c], test_counts[c]) << "c=" << c;
+    }
+  }
+  // Compares the proto distances of function with BaseDistance.
+  void ExpectEqualDistances(DistanceFunction function) {
+    for (int n = 1; n < 70; ++n) {
+      std::vector<uint32_t> protos(n + 8, 0);
+      for (int i = 0; i < n; ++i) protos[i] = RandomWord();
+      int x = random_.IntRand() & 0xff;
+      int y = random_.IntRand() & 0xff;
+      int theta = random_.IntRand() & 0xff;
+      std::vector<uint32_t> distances(n + 8);
+      function(protos.data(), n, x, y, theta, kThetaFudge, kMultShift,
+               kMultMask, kTableShift, kTableMask, distances.data());
+      for (int i = 0; i < n; ++i) {
+        EXPECT_EQ(BaseDistance(protos[i], x, y, theta), distances[i])
+            << "i=" << i;
+      }
+    }
+  }
+
+  TRand random_;
+};
+
+// Tests that the SSE implementation gets the same result as the scalar code.
+TEST_F(IntMatcherSimdTest, SSE) {
+  if (SIMDDetect::IsSSEAvailable()) {
+    tprintf("SSE found! Continuing...");
+  } else {
+    tprintf("No SSE found! Not Tested!");
+    return;
+  }
+  ExpectEqualCounts(ClassPrunerCountsSSE);
+  ExpectEqualDistances(ProtoDistancesSSE);
+}
+
+// Tests that the AVX2 implementation gets the same result as the scalar code.
+TEST_F(IntMatcherSimdTest, AVX2) {
+  if (SIMDDetect::IsAVX2Available()) {
+    tprintf("AVX2 found! Continuing...");
+  } else {
+    tprintf("No AVX2 found! Not Tested!");
+    return;
+  }
+  ExpectEqualCounts(ClassPrunerCountsAVX2);
+  ExpectEqualDistances(ProtoDistancesAVX2);
+}
+
+}  // namespace
+}  // namespace tesseract
@@ -19,6 +19,7 @@
 #include "genericvector.h"
 #include "include_gunit.h"
 #include "intsimdmatrixavx2.h"
+#include "intsimdmatrixavx512.h"
 #include "intsimdmatrixsse.h"
 #include "simddetect.h"
 #include "tprintf.h"
@@ -101,5 +102,18 @@ TEST_F(IntSimdMatrixTest, AVX2) {
   ExpectEqualResults(matrix.get());
 }
 
+// Tests that the AVX-512 implementation, with VNNI if the cpu has it, gets the
+// same result as the vanilla.
+TEST_F(IntSimdMatrixTest, AVX512) {
+  if (SIMDDetect::IsAVX512BWAvailable()) {
+    tprintf("AVX512BW found! Continuing...");
+  } else {
+    tprintf("No AVX512BW found! Not Tested!");
+    return;
+  }
+  std::unique_ptr<IntSimdMatrix> matrix(new IntSimdMatrixAVX512());
+  ExpectEqualResults(matrix.get());
+}
+
 }  // namespace
 }  // namespace tesseract
@@ -0,0 +1,465 @@
+///////////////////////////////////////////////////////////////////////
+// File:        kernel_benchmark.cc
+// Description: Timings of the SIMD and LSTM kernels of Tesseract.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+// Runs each kernel repeatedly for at least --min_time seconds and prints the
+// time per call and the bytes it reads per second, for every instruction set
+// level the cpu has, so that the paths can be compared on a given machine:
+//
+//   kernel_benchmark [--min_time=seconds] [filter]
+//
+// Only the benchmarks whose name contains filter are run.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "allheaders.h"
+#include "dotproductavx.h"
+#include "dotproductsse.h"
+#include "genericvector.h"
+#include "helpers.h"
+#include "intmatcheravx2.h"
+#include "intmatchersse.h"
+#include "intsimdmatrix.h"
+#include "intsimdmatrixavx2.h"
+#include "intsimdmatrixavx512.h"
+#include "intsimdmatrixsse.h"
+#include "lstm.h"
+#include "networkio.h"
+#include "networkscratch.h"
+#include "otsuthr.h"
+#include "recodebeam.h"
+#include "simddetect.h"
+#include "thresholdavx2.h"
+#include "thresholder.h"
+#include "thresholdsse.h"
+#include "unicharcompress.h"
+#include "unicharset.h"
+#include "weightmatrix.h"
+
+namespace tesseract {
+namespace {
+
+// Seconds each benchmark runs for at least.
+double min_time = 0.5;
+// Substring of the names of the benchmarks to run.
+const char* filter = "";
+
+// Runs function until it took min_time, and prints the mean time of a call,
+// and bytes_per_call over that time if given.
+void Run(const std::string& name, double bytes_per_call,
+         const std::function<void()>& function) {
+  if (strstr(name.c_str(), filter) == nullptr) return;
+  typedef std::chrono::steady_clock Clock;
+  function();  // Warms up the caches and any lazy initialization.
+  long iterations = 1;
+  double seconds = 0.0;
+  while (true) {
+    Clock::time_point start = Clock::now();
+    for (long i = 0; i < iterations; ++i) function();
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (seconds >= min_time) break;
+    // Aims past min_time, so that the last round is the one measured.
+    long next = seconds > 0.0
+        ? static_cast<long>(iterations * 1.4 * min_time / seconds) : 0;
+    iterations = next > iterations * 10 ? iterations * 10
+                                        : (next > iterations ? next
+                                                             : iterations * 2);
+  }
+  double ns = seconds * 1e9 / iterations;
+  if (bytes_per_call > 0.0) {
+    printf("%-48s %14.1f ns/op %9.2f GB/s %10ld calls\n", name.c_str(), ns,
+           bytes_per_call / ns, iterations);
+  } else {
+    printf("%-48s %14.1f ns/op %15s %10ld calls\n", name.c_str(), ns, "",
+           iterations);
+  }
+  fflush(stdout);
+}
+
+// The instruction set levels of the IntSimdMatrix implementations.
+struct IsaMatrix {
+  const char* isa;
+  bool available;
+  std::function<IntSimdMatrix*()> make;
+};
+
+std::vector<IsaMatrix> IntSimdMatrices() {
+  std::vector<IsaMatrix> matrices;
+  matrices.push_back({"base", true, [] { return new IntSimdMatrix; }});
+  matrices.push_back({"sse", SIMDDetect::IsSSEAvailable(),
+                      [] { return new IntSimdMatrixSSE; }});
+  matrices.push_back({"avx2", SIMDDetect::IsAVX2Available(),
+                      [] { return new IntSimdMatrixAVX2; }});
+  matrices.push_back({SIMDDetect::IsAVX512VNNIAvailable() ? "avx512vnni"
+                                                          : "avx512bw",
+                      SIMDDetect::IsAVX512BWAvailable(),
+                      [] { return new IntSimdMatrixAVX512; }});
+  return matrices;
+}
+
+// Output x input sizes of the gate matrices of typical LSTM layers.
+const int kMatrixShapes[][2] = {{16, 33}, {96, 129}, {192, 257}, {384, 513}};
+
+void BenchmarkIntSimdMatrix(TRand* random) {
+  for (const auto& shape : kMatrixShapes) {
+    int no = shape[0], ni = shape[1];
+    GENERIC_2D_ARRAY<int8_t> w(no, ni + 1, 0);
+    for (int i = 0; i < no; ++i) {
+      for (int j = 0; j <= ni; ++j)
+        w(i, j) = static_cast<int8_t>(random->SignedRand(MAX_INT8));
+    }
+    GenericVector<double> scales(no, 1.0);
+    std::vector<double> v(no);
+    for (const IsaMatrix& isa : IntSimdMatrices()) {
+      if (!isa.available) continue;
+      std::unique_ptr<IntSimdMatrix> matrix(isa.make());
+      matrix->Init(w);
+      std::vector<int8_t> u(matrix->RoundInputs(ni), 0);
+      for (int i = 0; i < ni; ++i)
+        u[i] = static_cast<int8_t>(random->SignedRand(MAX_INT8));
+      char name[64];
+      snprintf(name, sizeof(name), "IntSimdMatrix/%s/%dx%d", isa.isa, no, ni);
+      Run(name, static_cast<double>(no) * (ni + 1) + u.size(), [&] {
+        matrix->MatrixDotVector(w, scales, u.data(), v.data());
+      });
+    }
+  }
+}
+
+void BenchmarkDotProduct(TRand* random) {
+  for (int n : {64, 256, 1024, 4096}) {
+    std::vector<double> u(n), v(n);
+    for (int i = 0; i < n; ++i) {
+      u[i] = random->SignedRand(1.0);
+      v[i] = random->SignedRand(1.0);
+    }
+    volatile double sink = 0.0;
+    double bytes = 2.0 * n * sizeof(double);
+    char name[64];
+    snprintf(name, sizeof(name), "DotProduct/base/%d", n);
+    Run(name, bytes, [&] {
+      double total = 0.0;
+      for (int i = 0; i < n; ++i) total += u[i] * v[i];
+      sink = total;
+    });
+    if (SIMDDetect::IsSSEAvailable()) {
+      snprintf(name, sizeof(name), "DotProduct/sse/%d", n);
+      Run(name, bytes, [&] { sink = DotProductSSE(u.data(), v.data(), n); });
+    }
+    if (SIMDDetect::IsAVXAvailable()) {
+      snprintf(name, sizeof(name), "DotProduct/avx/%d", n);
+      Run(name, bytes, [&] { sink = DotProductAVX(u.data(), v.data(), n); });
+    }
+    std::vector<int8_t> iu(n), iv(n);
+    for (int i = 0; i < n; ++i) {
+      iu[i] = static_cast<int8_t>(random->SignedRand(MAX_INT8));
+      iv[i] = static_cast<int8_t>(random->SignedRand(MAX_INT8));
+    }
+    volatile int32_t int_sink = 0;
+    if (SIMDDetect::IsSSEAvailable()) {
+      snprintf(name, sizeof(name), "IntDotProduct/sse/%d", n);
+      Run(name, 2.0 * n, [&] {
+        int_sink = IntDotProductSSE(iu.data(), iv.data(), n);
+      });
+    }
+    (void)sink;
+    (void)int_sink;
+  }
+}
+
+// WeightMatrix::MatrixDotVector with float weights and with int8 weights,
+// which take the best IntSimdMatrix of the cpu.
+void BenchmarkWeightMatrix(TRand* random) {
+  for (const auto& shape : kMatrixShapes) {
+    int no = shape[0], ni = shape[1];
+    WeightMatrix float_weights;
+    float_weights.InitWeightsFloat(no, ni, false, 0.1f, random);
+    WeightMatrix int_weights;
+    int_weights.InitWeightsFloat(no, ni, false, 0.1f, random);
+    int_weights.ConvertToInt();
+    std::vector<double> u(ni), v(no);
+    for (int i = 0; i < ni; ++i) u[i] = random->SignedRand(1.0);
+    std::vector<int8_t> iu(int_weights.RoundInputs(ni), 0);
+    for (int i = 0; i < ni; ++i)
+      iu[i] = static_cast<int8_t>(random->SignedRand(MAX_INT8));
+    char name[64];
+    snprintf(name, sizeof(name), "WeightMatrix/float/%dx%d", no, ni);
+    Run(name, (static_cast<double>(no) * (ni + 1) + ni) * sizeof(double),
+        [&] { float_weights.MatrixDotVector(u.data(), v.data()); });
+    snprintf(name, sizeof(name), "WeightMatrix/int8/%dx%d", no, ni);
+    Run(name, static_cast<double>(no) * (ni + 1) + iu.size(),
+        [&] { int_weights.MatrixDotVector(iu.data(), v.data()); });
+  }
+}
+
+// LSTM::Forward over a line of width timesteps, as a layer of the usual
+// recognition networks.
+void BenchmarkLSTM(TRand* random) {
+  const int kLineWidth = 200;
+  const int kShapes[][2] = {{16, 48}, {48, 96}, {96, 192}};
+  for (const auto& shape : kShapes) {
+    int ni = shape[0], ns = shape[1];
+    for (bool int_mode : {false, true}) {
+      LSTM lstm("lstm", ni, ns, ns, false, NT_LSTM);
+      lstm.InitWeights(0.1f, random);
+      if (int_mode) lstm.ConvertToInt();
+      lstm.SetEnableTraining(TS_DISABLED);
+      NetworkIO input;
+      input.Resize2d(int_mode, kLineWidth, ni);
+      for (int t = 0; t < kLineWidth; ++t) input.Randomize(t, 0, ni, random);
+      NetworkScratch scratch;
+      NetworkIO output;
+      // Each timestep reads the weights of the 4 gates over ni + ns inputs.
+      double bytes = 4.0 * ns * (ni + ns + 1) * kLineWidth *
+                     (int_mode ? 1 : sizeof(double));
+      char name[64];
+      snprintf(name, sizeof(name), "LSTM::Forward/%s/%dx%d/w%d",
+               int_mode ? "int8" : "float", ni, ns, kLineWidth);
+      Run(name, bytes, [&] {
+        lstm.Forward(false, input, nullptr, &scratch, &output);
+      });
+    }
+  }
+}
+
+// RecodeBeamSearch::Decode of softmax outputs over a character set of the
+// size of a latin script model.
+void BenchmarkBeamSearch(TRand* random) {
+  const int kNumChars = 110;
+  const int kLineWidth = 300;
+  UNICHARSET unicharset;
+  for (int c = 0; unicharset.size() < kNumChars; ++c) {
+    // Skips the C1 controls and the no-break space between ascii and latin1.
+    int unicode = c < 94 ? 0x21 + c : 0xa1 + c - 94;
+    char* utf8 = UNICHAR(unicode).utf8_str();
+    unicharset.unichar_insert(utf8);
+    delete[] utf8;
+  }
+  UnicharCompress recoder;
+  recoder.SetupPassThrough(unicharset);
+  int null_char = unicharset.has_special_codes() ? UNICHAR_BROKEN
+                                                 : unicharset.size();
+  int num_codes = recoder.code_range();
+  NetworkIO output;
+  output.Resize2d(false, kLineWidth, num_codes);
+  // Mostly the null char, with a few likely characters at each timestep.
+  for (int t = 0; t < kLineWidth; ++t) {
+    float* probs = output.f(t);
+    float total = 0.0f;
+    for (int c = 0; c < num_codes; ++c) {
+      probs[c] = 0.001f * random->UnsignedRand(1.0);
+      if (c == null_char) probs[c] += t % 3 == 0 ? 0.2f : 5.0f;
+      if (random->IntRand() % 40 == 0) probs[c] += random->UnsignedRand(2.0);
+      total += probs[c];
+    }
+    for (int c = 0; c < num_codes; ++c) probs[c] /= total;
+  }
+  for (bool fast : {false, true}) {
+    RecodeBeamSearch search(recoder, null_char, false, nullptr);
+    search.set_fast(fast);
+    char name[64];
+    snprintf(name, sizeof(name), "RecodeBeamSearch::Decode/%s/w%d",
+             fast ? "fast" : "full", kLineWidth);
+    Run(name, static_cast<double>(kLineWidth) * num_codes * sizeof(float),
+        [&] { search.Decode(output, 1.0, 0.0, -25.0, nullptr); });
+  }
+}
+
+// The two kernels of IntegerMatcher::Match: the class pruner counts and the
+// feature to proto distances, at the scalar level and each SIMD level.
+void BenchmarkIntegerMatcher(TRand* random) {
+  const int kPrunerWords = 24 * 24 * 24 * 2;
+  const int kNumPruners = 4;
+  const int kNumFeatures = 60;
+  std::vector<std::vector<uint32_t> > pruners(kNumPruners);
+  std::vector<const uint32_t*> pruner_ptrs;
+  for (int p = 0; p < kNumPruners; ++p) {
+    for (int i = 0; i < kPrunerWords; ++i)
+      pruners[p].push_back(random->IntRand() ^ (random->IntRand() << 16));
+    pruner_ptrs.push_back(pruners[p].data());
+  }
+  std::vector<int> offsets;
+  for (int f = 0; f < kNumFeatures; ++f)
+    offsets.push_back(random->IntRand() % (kPrunerWords / 2) * 2);
+  std::vector<int> counts(kNumPruners * 32);
+  double pruner_bytes = 2.0 * sizeof(uint32_t) * kNumPruners * kNumFeatures;
+  Run("ClassPrunerCounts/base", pruner_bytes, [&] {
+    for (int f = 0; f < kNumFeatures; ++f) {
+      for (int c = 0; c < kNumPruners * 32; ++c) {
+        uint32_t word = pruners[c / 32][offsets[f] + c % 32 / 16];
+        counts[c] += (word >> (2 * (c % 16))) & 3;
+      }
+    }
+  });
+  if (SIMDDetect::IsSSEAvailable()) {
+    Run("ClassPrunerCounts/sse", pruner_bytes, [&] {
+      ClassPrunerCountsSSE(pruner_ptrs.data(), kNumPruners, offsets.data(),
+                           kNumFeatures, counts.data());
+    });
+  }
+  if (SIMDDetect::IsAVX2Available()) {
+    Run("ClassPrunerCounts/avx2", pruner_bytes, [&] {
+      ClassPrunerCountsAVX2(pruner_ptrs.data(), kNumPruners, offsets.data(),
+                            kNumFeatures, counts.data());
+    });
+  }
+
+  // Parameters of IntegerMatcher::Init.
+  const int kThetaFudge = 128, kMultShift = 0, kMultMask = (1 << 14) - 1;
+  const int kTableShift = 18, kTableMask = 511;
+  const int kNumProtos = 64;
+  std::vector<uint32_t> protos(kNumProtos + 8, 0);
+  for (int i = 0; i < kNumProtos; ++i)
+    protos[i] = random->IntRand() ^ (random->IntRand() << 16);
+  std::vector<uint32_t> distances(kNumProtos + 8);
+  int x = 100, y = 140, theta = 30;
+  double proto_bytes = 2.0 * sizeof(uint32_t) * kNumProtos;
+  Run("ProtoDistances/base", proto_bytes, [&] {
+    for (int i = 0; i < kNumProtos; ++i) {
+      uint32_t packed = protos[i];
+      int8_t a = static_cast<int8_t>(packed & 0xff);
+      int b = (packed >> 8) & 0xff;
+      int8_t c = static_cast<int8_t>((packed >> 16) & 0xff);
+      int angle = packed >> 24;
+      int32_t a3 = ((a * (x - 128)) << 1) - (b * (y - 128)) + (c << 9);
+      int32_t m3 = (static_cast<int8_t>(theta - angle) * kThetaFudge) << 1;
+      if (a3 < 0) a3 = ~a3;
+      if (m3 < 0) m3 = ~m3;
+      a3 >>= kMultShift;
+      m3 >>= kMultShift;
+      if (a3 > kMultMask) a3 = kMultMask;
+      if (m3 > kMultMask) m3 = kMultMask;
+      uint32_t a4 = (a3 * a3 + m3 * m3) >> kTableShift;
+      distances[i] = a4 > kTableMask ? kTableMask + 1 : a4;
+    }
+  });
+  if (SIMDDetect::IsSSEAvailable()) {
+    Run("ProtoDistances/sse", proto_bytes, [&] {
+      ProtoDistancesSSE(protos.data(), kNumProtos, x, y, theta, kThetaFudge,
+                        kMultShift, kMultMask, kTableShift, kTableMask,
+                        distances.data());
+    });
+  }
+  if (SIMDDetect::IsAVX2Available()) {
+    Run("ProtoDistances/avx2", proto_bytes, [&] {
+      ProtoDistancesAVX2(protos.data(), kNumProtos, x, y, theta, kThetaFudge,
+                         kMultShift, kMultMask, kTableShift, kTableMask,
+                         distances.data());
+    });
+  }
+}
+
+// Makes a page sized grey image of dark strokes on a light background.
+Pix* MakePage(int width, int height, TRand* random) {
+  Pix* pix = pixCreate(width, height, 8);
+  pixSetAllArbitrary(pix, 225);
+  for (int line = 40; line + 30 < height; line += 50) {
+    for (int x = 30; x + 20 < width; x += 22) {
+      if (random->IntRand() % 8 == 0) continue;  // A space.
+      Box* box = boxCreate(x, line, 4 + random->IntRand() % 14,
+                           12 + random->IntRand() % 16);
+      pixSetInRectArbitrary(pix, box, 20 + random->IntRand() % 60);
+      boxDestroy(&box);
+    }
+  }
+  return pix;
+}
+
+// Otsu thresholding of a 300 dpi A4 page, the row kernels at each level,
+// and the connected components of the result.
+void BenchmarkThresholding(TRand* random) {
+  const int kWidth = 2480, kHeight = 3508;
+  Pix* grey = MakePage(kWidth, kHeight, random);
+  double page_bytes = static_cast<double>(kWidth) * kHeight;
+  Run("OtsuThreshold/histogram/a4", page_bytes, [&] {
+    int* thresholds = nullptr;
+    int* hi_values = nullptr;
+    OtsuThreshold(grey, 0, 0, kWidth, kHeight, &thresholds, &hi_values);
+    delete[] thresholds;
+    delete[] hi_values;
+  });
+  Pix* binary = nullptr;
+  Run("ImageThresholder::ThresholdToPix/a4", page_bytes, [&] {
+    ImageThresholder thresholder;
+    thresholder.SetImage(grey);
+    pixDestroy(&binary);
+    thresholder.ThresholdToPix(PSM_AUTO, &binary);
+  });
+
+  int threshold = 128, hi_value = 0;
+  int num_words = kWidth / 32;
+  std::vector<uint32_t> row(num_words);
+  if (SIMDDetect::IsSSEAvailable()) {
+    Run("ThresholdRow/sse/a4", page_bytes, [&] {
+      const uint32_t* line = pixGetData(grey);
+      for (int y = 0; y < kHeight; ++y, line += pixGetWpl(grey))
+        ThresholdRowSSE(line, 1, num_words, &threshold, &hi_value, row.data());
+    });
+  }
+  if (SIMDDetect::IsAVX2Available()) {
+    Run("ThresholdRow/avx2/a4", page_bytes, [&] {
+      const uint32_t* line = pixGetData(grey);
+      for (int y = 0; y < kHeight; ++y, line += pixGetWpl(grey))
+        ThresholdRowAVX2(line, 1, num_words, &threshold, &hi_value,
+                         row.data());
+    });
+  }
+
+  if (binary != nullptr) {
+    Run("pixConnCompBB/8/a4", page_bytes / 8, [&] {
+      Boxa* boxes = pixConnCompBB(binary, 8);
+      boxaDestroy(&boxes);
+    });
+  }
+  pixDestroy(&binary);
+  pixDestroy(&grey);
+}
+
+}  // namespace
+}  // namespace tesseract
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], "--min_time=", 11) == 0) {
+      tesseract::min_time = atof(argv[i] + 11);
+    } else if (argv[i][0] == '-') {
+      fprintf(stderr, "Usage: %s [--min_time=seconds] [filter]\n", argv[0]);
+      return 1;
+    } else {
+      tesseract::filter = argv[i];
+    }
+  }
+  printf("cpu: sse %d avx %d avx2 %d avx512bw %d avx512vnni %d\n",
+         SIMDDetect::IsSSEAvailable(),
+         SIMDDetect::IsAVXAvailable(),
+         SIMDDetect::IsAVX2Available(),
+         SIMDDetect::IsAVX512BWAvailable(),
+         SIMDDetect::IsAVX512VNNIAvailable());
+  tesseract::TRand random;
+  tesseract::BenchmarkIntSimdMatrix(&random);
+  tesseract::BenchmarkDotProduct(&random);
+  tesseract::BenchmarkWeightMatrix(&random);
+  tesseract::BenchmarkLSTM(&random);
+  tesseract::BenchmarkBeamSearch(&random);
+  tesseract::BenchmarkIntegerMatcher(&random);
+  tesseract::BenchmarkThresholding(&random);
+  return 0;
+}
@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////
+// File:        strngs_test.cc
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include "genericvector.h"
+#include "include_gunit.h"
+#include "serialis.h"
+#include "strngs.h"
+
+namespace {
+
+// Lengths around the 15 characters that fit in the STRING itself.
+const int kLengths[] = {0, 1, 14, 15, 16, 17, 100};
+
+// Returns a string of length characters that differs for each length.
+std::string MakeChars(int length) {
+  std::string s;
+  for (int i = 0; i < length; ++i)
+    s += static_cast<char>('a' + (i + length) % 26);
+  return s;
+}
+
+// Compares STRINGs through their characters, for GenericVector::sort.
+int CompareStrings(const void* s1, const void* s2) {
+  return strcmp(static_cast<const STRING*>(s1)->string(),
+                static_cast<const STRING*>(s2)->string());
+}
+
+// Tests that STRINGs of every length hold their characters, whether they
+// are kept in the object or allocated.
+TEST(StrngsTest, Construct) {
+  for (int length : kLengths) {
+    std::string chars = MakeChars(length);
+    STRING s1(chars.c_str());
+    STRING s2(chars.c_str(), length);
+    EXPECT_EQ(length, s1.length());
+    EXPECT_STREQ(chars.c_str(), s1.string());
+    EXPECT_EQ(length, s2.length());
+    EXPECT_STREQ(chars.c_str(), s2.string());
+    EXPECT_TRUE(s1 == s2);
+  }
+  STRING empty;
+  EXPECT_EQ(0, empty.length());
+  EXPECT_STREQ("", empty.string());
+  STRING null_string(static_cast<const char*>(NULL));
+  EXPECT_EQ(0, null_string.length());
+}
+
+// Tests appending one character at a time across the inline capacity.
+TEST(StrngsTest, Append) {
+  STRING s;
+  std::string expected;
+  for (int i = 0; i < 40; ++i) {
+    char ch = static_cast<char>('A' + i % 26);
+    s += ch;
+    expected += ch;
+    ASSERT_EQ(i + 1, s.length());
+    ASSERT_STREQ(expected.c_str(), s.string());
+  }
+  STRING short_string("short");
+  STRING long_string = short_string + " and then some more";
+  EXPECT_STREQ("short and then some more", long_string.string());
+  EXPECT_STREQ("short", short_string.string());
+  long_string.truncate_at(3);
+  EXPECT_STREQ("sho", long_string.string());
+  long_string += " again";
+  EXPECT_STREQ("sho again", long_string.string());
+}
+
+// Tests that copies, short and long, don't share their characters.
+TEST(StrngsTest, Copy) {
+  for (int length : kLengths) {
+    std::string chars = MakeChars(length);
+    STRING s1(chars.c_str());
+    STRING s2(s1);
+    STRING s3;
+    s3 = s1;
+    s2 += "x";
+    s3 += "y";
+    EXPECT_STREQ(chars.c_str(), s1.string());
+    EXPECT_STREQ((chars + "x").c_str(), s2.string());
+    EXPECT_STREQ((chars + "y").c_str(), s3.string());
+  }
+}
+
+// Tests that a move takes the characters and leaves an empty, usable
+// STRING behind.
+TEST(StrngsTest, Move) {
+  for (int length : kLengths) {
+    std::string chars = MakeChars(length);
+    STRING s1(chars.c_str());
+    STRING s2(std::move(s1));
+    EXPECT_STREQ(chars.c_str(), s2.string());
+    EXPECT_EQ(0, s1.length());
+    EXPECT_STREQ("", s1.string());
+    s1 += "reused after the move";
+    EXPECT_STREQ("reused after the move", s1.string());
+    for (int other_length : kLengths) {
+      STRING s3(MakeChars(other_length).c_str());
+      s3 = std::move(s2);
+      EXPECT_STREQ(chars.c_str(), s3.string());
+      EXPECT_EQ(0, s2.length());
+      s2 = std::move(s3);
+    }
+    STRING& s4 = s2;
+    s2 = std::move(s4);
+    EXPECT_STREQ(chars.c_str(), s2.string());
+  }
+}
+
+// Tests that sorting, which moves STRINGs with memcpy through qsort, keeps
+// short and long ones intact.
+TEST(StrngsTest, Sort) {
+  GenericVector<STRING> strings;
+  std::vector<std::string> expected;
+  for (int i = 0; i < 50; ++i) {
+    std::string chars =
+        static_cast<char>('z' - i % 26) + MakeChars(i * 7 % 31);
+    strings.push_back(STRING(chars.c_str()));
+    expected.push_back(chars);
+  }
+  strings.sort(&CompareStrings);
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(static_cast<int>(expected.size()), strings.size());
+  for (int i = 0; i < strings.size(); ++i) {
+    EXPECT_STREQ(expected[i].c_str(), strings[i].string());
+    EXPECT_EQ(static_cast<int>(expected[i].size()), strings[i].length());
+  }
+}
+
+// Tests that the serialized format is the length followed by the
+// characters, and that reading grows a short STRING as needed.
+TEST(StrngsTest, Serialize) {
+  for (int length : kLengths) {
+    std::string chars = MakeChars(length);
+    STRING s1(chars.c_str());
+    GenericVector<char> data;
+    tesseract::TFile fpw;
+    fpw.OpenWrite(&data);
+    EXPECT_TRUE(s1.Serialize(&fpw));
+    ASSERT_EQ(static_cast<int>(sizeof(inT32)) + length, data.size());
+    inT32 serialized_length;
+    memcpy(&serialized_length, &data[0], sizeof(serialized_length));
+    EXPECT_EQ(length, serialized_length);
+
+    tesseract::TFile fpr;
+    ASSERT_TRUE(fpr.Open(&data[0], data.size()));
+    STRING s2("old");
+    EXPECT_TRUE(s2.DeSerialize(&fpr));
+    EXPECT_STREQ(chars.c_str(), s2.string());
+    EXPECT_EQ(length, s2.length());
+  }
+}
+
+}  // namespace
@@ -166,6 +166,18 @@ static SEAM* CheckSeam(int debug_level, inT32 blob_number, TWERD* word,
  * it was successful.
  */
 namespace tesseract {
+BlobGeometry::BlobGeometry(TBLOB* blob)
+  : box(blob->bounding_box()), num_points(0) {
+  for (TESSLINE* outline = blob->outlines; outline != NULL;
+       outline = outline->next) {
+    EDGEPT* edgept = outline->loop;
+    do {
+      ++num_points;
+      edgept = edgept->next;
+    } while (edgept != outline->loop);
+  }
+}
+
 SEAM *Wordrec::attempt_blob_chop(TWERD *word, TBLOB *blob, inT32 blob_number,
                                  bool italic_blob,
                                  const GenericVector<SEAM*>& seams) {
@@ -182,8 +194,14 @@ SEAM *Wordrec::attempt_blob_chop(TWERD *word, TBLOB *blob, inT32 blob_number,
       seam = new SEAM(0.0f, location);
     }
   }
-  if (seam == NULL)
-    seam = pick_good_seam(blob);
+  if (seam == NULL) {
+    BlobGeometry geometry(blob);
+    if (!seamless_blobs_.contains(geometry)) {
+      seam = pick_good_seam(blob);
+      if (seam == NULL)
+        seamless_blobs_.push_back(geometry);
+    }
+  }
   if (chop_debug) {
     if (seam != NULL)
       seam->Print("Good seam picked=");
@@ -374,6 +392,7 @@ SEAM* Wordrec::chop_one_blob(const GenericVector<TBOX>& boxes,
                              const GenericVector<BLOB_CHOICE*>& blob_choices,
                              WERD_RES* word_res,
                              int* blob_number) {
+  seamless_blobs_.clear();
   if (prioritize_division) {
     return chop_overlapping_blob(boxes, true, word_res, blob_number);
   } else {
@@ -460,6 +479,7 @@ void Wordrec::improve_by_chopping(float rating_cert_scale,
                                   LMPainPoints* pain_points,
                                   GenericVector<SegSearchPending>* pending) {
   int blob_number;
+  seamless_blobs_.clear();
   do {  // improvement loop.
     // Make a simple vector of BLOB_CHOICEs to make it easy to pick which
     // one to chop.
@@ -34,6 +34,20 @@ class WERD_RES;
 
 namespace tesseract {
 
+// The bounding box and number of edge points of a blob, which tell apart the
+// blobs of a word while it is being chopped.
+struct BlobGeometry {
+  BlobGeometry() : num_points(0) {}
+  explicit BlobGeometry(TBLOB* blob);
+
+  bool operator==(const BlobGeometry& other) const {
+    return num_points == other.num_points && box == other.box;
+  }
+
+  TBOX box;
+  int num_points;
+};
+
 // A class for storing which nodes are to be processed by the segmentation
 // search. There is a single SegSearchPending for each column in the ratings
 // matrix, and it indicates whether the segsearch should combine all
@@ -412,6 +426,10 @@ class Wordrec : public Classify {
   WERD_CHOICE *prev_word_best_choice_;
   // Sums of blame reasons computed by the blamer.
   GenericVector<int> blame_reasons_;
+  // The blobs of the word being chopped for which pick_good_seam found no
+  // seam. Nothing changes a blob that isn't chopped, so improve_by_chopping
+  // doesn't search them again after every chop elsewhere in the word.
+  GenericVector<BlobGeometry> seamless_blobs_;
   // Function used to fill char choice lattices.
   void (Wordrec::*fill_lattice_)(const MATRIX &ratings,
                                  const WERD_CHOICE_LIST &best_choices,